@@ -14,21 +14,66 @@
 //
 #include "koladata/adoption_utils.h"
 
+#include <cstddef>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
 #include "koladata/extract_utils.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata {
 
+namespace {
+
+// Identifies the slices that can be extracted together: the ones with the same
+// DataBag and schema.
+using SliceGroupKey = std::pair<const DataBag*, internal::DataItem>;
+
+struct SliceGroupKeyHash {
+  size_t operator()(const SliceGroupKey& key) const {
+    return absl::HashOf(key.first, internal::DataItem::Hash()(key.second));
+  }
+};
+
+// Returns a flat DataSlice with the items of all `slices`, which must have the
+// same DataBag and schema. Returns the slice itself if there is only one.
+absl::StatusOr<DataSlice> ConcatSliceGroup(
+    absl::Span<const DataSlice* const> slices) {
+  DCHECK(!slices.empty());
+  if (slices.size() == 1) {
+    return *slices[0];
+  }
+  std::vector<internal::DataItem> items;
+  for (const DataSlice* slice : slices) {
+    slice->VisitImpl([&]<class T>(const T& impl) {
+      if constexpr (std::is_same_v<T, internal::DataItem>) {
+        items.push_back(impl);
+      } else {
+        items.insert(items.end(), impl.begin(), impl.end());
+      }
+    });
+  }
+  size_t size = items.size();
+  return DataSlice::Create(internal::DataSliceImpl::Create(items),
+                           DataSlice::JaggedShape::FlatFromSize(size),
+                           slices[0]->GetSchemaImpl(), slices[0]->GetDb());
+}
+
+}  // namespace
+
 absl::Status AdoptionQueue::AdoptInto(DataBag& db) const {
   absl::flat_hash_set<const DataBag*> visited_bags{&db};
   for (const DataBagPtr& other_db : bags_to_merge_) {
@@ -40,10 +85,25 @@ absl::Status AdoptionQueue::AdoptInto(DataBag& db) const {
                                     /*allow_data_conflicts=*/false,
                                     /*allow_schema_conflicts=*/false));
   }
+  // Slices with the same DataBag and schema are extracted together, so that
+  // adopting many items from a few DataBags takes a few extractions rather
+  // than one per item.
+  absl::flat_hash_map<SliceGroupKey, size_t, SliceGroupKeyHash> group_ids;
+  std::vector<std::vector<const DataSlice*>> groups;
   for (const DataSlice& slice : slices_to_merge_) {
     if (visited_bags.contains(slice.GetDb().get())) {
       continue;
     }
+    auto [it, inserted] = group_ids.emplace(
+        SliceGroupKey(slice.GetDb().get(), slice.GetSchemaImpl()),
+        groups.size());
+    if (inserted) {
+      groups.emplace_back();
+    }
+    groups[it->second].push_back(&slice);
+  }
+  for (const auto& group : groups) {
+    ASSIGN_OR_RETURN(DataSlice slice, ConcatSliceGroup(group));
     ASSIGN_OR_RETURN(DataSlice extracted_slice,
                      extract_utils_internal::Extract(slice));
     const auto& extracted_db = extracted_slice.GetDb();
@@ -96,17 +156,56 @@ absl::StatusOr<absl::Nullable<DataBagPtr>> AdoptionQueue::GetCommonOrMergedDb()
   }
 }
 
-absl::Nonnull<DataBagPtr> AdoptionQueue::GetDbWithFallbacks() const {
-  // Collect unique DataBags from all Add calls.
+namespace {
+
+// Returns true if `db` and all its transitive fallbacks are immutable.
+bool IsDeeplyImmutable(const DataBag& db) {
+  if (db.IsMutable()) {
+    return false;
+  }
+  for (const DataBagPtr& fallback : db.GetFallbacks()) {
+    if (!IsDeeplyImmutable(*fallback)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
+absl::StatusOr<absl::Nullable<DataBagPtr>>
+AdoptionQueue::GetCommonOrFallbackDb(size_t max_fallbacks) const {
+  std::vector<DataBagPtr> dbs = GetUniqueDbs();
+  if (dbs.empty()) {
+    return nullptr;
+  }
+  if (dbs.size() == 1) {
+    return std::move(dbs[0]);
+  }
+  size_t fallback_count = 0;
+  for (const DataBagPtr& db : dbs) {
+    if (!IsDeeplyImmutable(*db)) {
+      return GetCommonOrMergedDb();
+    }
+    FlattenFallbackFinder fb_finder(*db);
+    fallback_count += 1 + fb_finder.GetFlattenFallbacks().size();
+    if (fallback_count > max_fallbacks) {
+      return GetCommonOrMergedDb();
+    }
+  }
+  return DataBag::ImmutableEmptyWithFallbacks(dbs);
+}
+
+std::vector<DataBagPtr> AdoptionQueue::GetUniqueDbs() const {
   absl::flat_hash_set<const DataBag*> visited_bags;
-  std::vector<DataBagPtr> fallbacks;
-  fallbacks.reserve(slices_to_merge_.size() + bags_to_merge_.size());
+  std::vector<DataBagPtr> dbs;
+  dbs.reserve(slices_to_merge_.size() + bags_to_merge_.size());
   for (const DataBagPtr& bag : bags_to_merge_) {
     if (visited_bags.contains(bag.get())) {
       continue;
     }
     visited_bags.insert(bag.get());
-    fallbacks.push_back(bag);
+    dbs.push_back(bag);
   }
   for (const DataSlice& slice : slices_to_merge_) {
     const DataBagPtr& bag = slice.GetDb();
@@ -114,10 +213,13 @@ absl::Nonnull<DataBagPtr> AdoptionQueue::GetDbWithFallbacks() const {
       continue;
     }
     visited_bags.insert(bag.get());
-    fallbacks.push_back(bag);
+    dbs.push_back(bag);
   }
+  return dbs;
+}
 
-  return DataBag::ImmutableEmptyWithFallbacks(fallbacks);
+absl::Nonnull<DataBagPtr> AdoptionQueue::GetDbWithFallbacks() const {
+  return DataBag::ImmutableEmptyWithFallbacks(GetUniqueDbs());
 }
 
 }  // namespace koladata
@@ -15,6 +15,7 @@
 #ifndef KOLADATA_ADOPTION_UTILS_H_
 #define KOLADATA_ADOPTION_UTILS_H_
 
+#include <cstddef>
 #include <utility>
 #include <vector>
 
@@ -65,6 +66,22 @@ class AdoptionQueue {
   //    an error if this causes a merge conflict.
   absl::StatusOr<absl::Nullable<DataBagPtr>> GetCommonOrMergedDb() const;
 
+  // Default `max_fallbacks` of GetCommonOrFallbackDb.
+  static constexpr size_t kDefaultMaxFallbacks = 16;
+
+  // Same as GetCommonOrMergedDb, except that if all tracked DataBags (and
+  // their fallbacks) are immutable, the result references them as fallbacks
+  // instead of copying their triples, which takes O(1) in their size. Merges
+  // as GetCommonOrMergedDb if this results in more than `max_fallbacks`
+  // flattened fallbacks, which would slow down lookups.
+  //
+  // Unlike merging, using fallbacks does not report conflicts (the DataBags
+  // added first take precedence), and the result contains all the triples of
+  // the tracked slices' DataBags rather than only the reachable ones. Callers
+  // opt in when that is acceptable.
+  absl::StatusOr<absl::Nullable<DataBagPtr>> GetCommonOrFallbackDb(
+      size_t max_fallbacks = kDefaultMaxFallbacks) const;
+
   // Returns a new empty immutable DataBag with all tracked DataBags and tracked
   // slices' DataBags as fallbacks. The fallback order is unspecified but
   // deterministic. This is useful for cheaply and reliably getting a complete
@@ -73,6 +90,10 @@ class AdoptionQueue {
   absl::Nonnull<DataBagPtr> GetDbWithFallbacks() const;
 
  private:
+  // Returns the distinct tracked DataBags, including the slices' ones, in a
+  // deterministic order.
+  std::vector<DataBagPtr> GetUniqueDbs() const;
+
   std::vector<DataSlice> slices_to_merge_;
   std::vector<DataBagPtr> bags_to_merge_;
 };
@@ -15,6 +15,7 @@
 #include "koladata/adoption_utils.h"
 
 #include <optional>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -22,6 +23,7 @@
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
 #include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/testing/matchers.h"
@@ -32,6 +34,8 @@ namespace koladata {
 namespace {
 
 using ::absl_testing::IsOkAndHolds;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
 using ::testing::UnorderedElementsAre;
 
 TEST(AdoptionQueueTest, Empty) {
@@ -178,6 +182,57 @@ TEST(AdoptionQueueTest, WithFallbacks) {
               IsOkAndHolds(internal::DataItem(3.0f)));
 }
 
+TEST(AdoptionQueueTest, GetCommonOrFallbackDb) {
+  internal::DataItem obj(internal::AllocateSingleObject());
+  auto mutable_db1 = DataBag::Empty();
+  auto mutable_db2 = DataBag::Empty();
+  ASSERT_OK(mutable_db1->GetMutableImpl()->get().SetAttr(
+      obj, "a", internal::DataItem(1)));
+  ASSERT_OK(mutable_db2->GetMutableImpl()->get().SetAttr(
+      obj, "b", internal::DataItem(2)));
+  ASSERT_OK_AND_ASSIGN(DataBagPtr db1, mutable_db1->Fork(/*immutable=*/true));
+  ASSERT_OK_AND_ASSIGN(DataBagPtr db2, mutable_db2->Fork(/*immutable=*/true));
+  {
+    AdoptionQueue q;
+    EXPECT_THAT(q.GetCommonOrFallbackDb(), IsOkAndHolds(nullptr));
+    q.Add(db1);
+    q.Add(db1);
+    EXPECT_THAT(q.GetCommonOrFallbackDb(), IsOkAndHolds(db1));
+  }
+  {
+    // Immutable DataBags are referenced as fallbacks.
+    AdoptionQueue q;
+    q.Add(db1);
+    q.Add(db2);
+    ASSERT_OK_AND_ASSIGN(DataBagPtr db, q.GetCommonOrFallbackDb());
+    EXPECT_FALSE(db->IsMutable());
+    EXPECT_THAT(db->GetFallbacks(), ElementsAre(db1, db2));
+  }
+  {
+    // Beyond the budget, the DataBags are merged.
+    AdoptionQueue q;
+    q.Add(db1);
+    q.Add(db2);
+    ASSERT_OK_AND_ASSIGN(DataBagPtr db,
+                         q.GetCommonOrFallbackDb(/*max_fallbacks=*/1));
+    EXPECT_THAT(db->GetFallbacks(), IsEmpty());
+    EXPECT_THAT(db->GetImpl().GetAttr(obj, "a"),
+                IsOkAndHolds(internal::DataItem(1)));
+    EXPECT_THAT(db->GetImpl().GetAttr(obj, "b"),
+                IsOkAndHolds(internal::DataItem(2)));
+  }
+  {
+    // Mutable DataBags are merged.
+    AdoptionQueue q;
+    q.Add(db1);
+    q.Add(mutable_db2);
+    ASSERT_OK_AND_ASSIGN(DataBagPtr db, q.GetCommonOrFallbackDb());
+    EXPECT_THAT(db->GetFallbacks(), IsEmpty());
+    EXPECT_THAT(db->GetImpl().GetAttr(obj, "b"),
+                IsOkAndHolds(internal::DataItem(2)));
+  }
+}
+
 TEST(AdoptionQueueTest, TestDbVector) {
   auto db1 = DataBag::Empty();
   DataBagPtr db2;
@@ -243,5 +298,59 @@ TEST(AdoptionQueueTest, Extraction) {
               IsOkAndHolds(internal::DataItem()));  // Not extracted.
 }
 
+TEST(AdoptionQueueTest, ExtractionOfManySlices) {
+  // Slices with the same DataBag and schema are extracted together.
+  auto db1 = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      DataSlice schema_a,
+      CreateEntitySchema(db1, {"a"}, {test::Schema(schema::kInt32)}));
+  ASSERT_OK_AND_ASSIGN(
+      DataSlice schema_b,
+      CreateEntitySchema(db1, {"b"}, {test::Schema(schema::kInt32)}));
+  auto& db1_impl = db1->GetMutableImpl()->get();
+  std::vector<internal::DataItem> objs;
+  for (int i = 0; i < 10; ++i) {
+    internal::DataItem obj(internal::AllocateSingleObject());
+    ASSERT_OK(db1_impl.SetAttr(obj, "a", internal::DataItem(i)));
+    ASSERT_OK(db1_impl.SetAttr(obj, "b", internal::DataItem(-i)));
+    objs.push_back(obj);
+  }
+
+  AdoptionQueue adoption_queue;
+  // Items 0-7 with schema_a, as items and as a slice.
+  for (int i = 0; i < 6; ++i) {
+    ASSERT_OK_AND_ASSIGN(DataSlice item,
+                         DataSlice::Create(objs[i], schema_a.item(), db1));
+    adoption_queue.Add(item);
+  }
+  ASSERT_OK_AND_ASSIGN(
+      DataSlice slice,
+      DataSlice::Create(internal::DataSliceImpl::Create({objs[6], objs[7]}),
+                        DataSlice::JaggedShape::FlatFromSize(2),
+                        schema_a.item(), db1));
+  adoption_queue.Add(slice);
+  // Item 8 with schema_b.
+  ASSERT_OK_AND_ASSIGN(DataSlice item_b,
+                       DataSlice::Create(objs[8], schema_b.item(), db1));
+  adoption_queue.Add(item_b);
+  // Another DataBag, so that the result is a merged one.
+  adoption_queue.Add(DataBag::Empty());
+
+  ASSERT_OK_AND_ASSIGN(DataBagPtr db2, adoption_queue.GetCommonOrMergedDb());
+  ASSERT_NE(db2, db1);
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_THAT(db2->GetImpl().GetAttr(objs[i], "a"),
+                IsOkAndHolds(internal::DataItem(i)));
+    EXPECT_THAT(db2->GetImpl().GetAttr(objs[i], "b"),
+                IsOkAndHolds(internal::DataItem()));  // Not extracted.
+  }
+  EXPECT_THAT(db2->GetImpl().GetAttr(objs[8], "a"),
+              IsOkAndHolds(internal::DataItem()));  // Not extracted.
+  EXPECT_THAT(db2->GetImpl().GetAttr(objs[8], "b"),
+              IsOkAndHolds(internal::DataItem(-8)));
+  EXPECT_THAT(db2->GetImpl().GetAttr(objs[9], "a"),
+              IsOkAndHolds(internal::DataItem()));  // Not extracted.
+}
+
 }  // namespace
 }  // namespace koladata
@@ -98,6 +98,13 @@ absl::StatusOr<arolla::TypedRef> DataSliceToArollaRef(const DataSlice& ds) {
         "only DataSlices with primitive values of the same type can be "
         "converted to Arolla value, got: MIXED");
   }
+  if (ds.GetShape().rank() != 0) {
+    // Memoized on the underlying DataSliceImpl, so converting the same slice
+    // for several operators doesn't repeat the work.
+    if (auto ref = ds.slice().typed_values(); ref.has_value()) {
+      return *ref;
+    }
+  }
   std::optional<arolla::TypedRef> result;
   ds.VisitImpl([&]<class T>(const T& impl) {
     auto to_ref = [&](const auto& val) {
@@ -197,6 +197,54 @@ BENCHMARK(BM_SetGetAttrItem<ObjectCreator>);
 BENCHMARK(BM_SetGetAttrOneDimSingle<ObjectCreator>);
 BENCHMARK(BM_SetGetAttrMultiDim<ObjectCreator>);
 
+// Reads an attribute through a chain of fallbacks, each of them setting the
+// attribute for a part of the objects. With a mutable fallback
+// (state.range(1) == 0) there is no merged view of the fallbacks and each
+// fallback is probed on every lookup.
+void BM_GetAttrWithFallbacks(benchmark::State& state) {
+  int64_t fallback_count = state.range(0);
+  bool all_immutable = state.range(1) != 0;
+  constexpr int64_t kSize = 10000;
+  auto base_db = DataBag::Empty();
+  auto o = *EntityCreator::Shaped(
+      base_db, DataSlice::JaggedShape::FlatFromSize(kSize), {"a"},
+      {*DataSlice::Create(internal::DataSliceImpl::Create(
+                              arolla::CreateConstDenseArray<int>(kSize, 0)),
+                          DataSlice::JaggedShape::FlatFromSize(kSize),
+                          internal::DataItem(schema::kInt32))});
+  std::vector<DataBagPtr> fallbacks;
+  for (int64_t i = 1; i <= fallback_count; ++i) {
+    auto db = *base_db->Fork();
+    arolla::DenseArrayBuilder<int> bldr(kSize);
+    for (int64_t j = i; j < kSize; j += fallback_count + 1) {
+      bldr.Set(j, i);
+    }
+    CHECK_OK(o.WithDb(db).SetAttr(
+        "a", *DataSlice::Create(
+                 internal::DataSliceImpl::Create(std::move(bldr).Build()),
+                 DataSlice::JaggedShape::FlatFromSize(kSize),
+                 internal::DataItem(schema::kInt32))));
+    fallbacks.push_back(all_immutable ? *db->Fork(/*immutable=*/true) : db);
+  }
+  fallbacks.push_back(all_immutable ? *base_db->Fork(/*immutable=*/true)
+                                    : base_db);
+  auto o_with_fallbacks =
+      o.WithDb(DataBag::ImmutableEmptyWithFallbacks(fallbacks));
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(o_with_fallbacks);
+    auto ds = o_with_fallbacks.GetAttr("a");
+    benchmark::DoNotOptimize(ds);
+  }
+}
+
+BENCHMARK(BM_GetAttrWithFallbacks)
+    ->ArgPair(1, 0)
+    ->ArgPair(1, 1)
+    ->ArgPair(4, 0)
+    ->ArgPair(4, 1)
+    ->ArgPair(8, 0)
+    ->ArgPair(8, 1);
+
 void BM_ExplodeLists(benchmark::State& state) {
   int64_t first_dim = state.range(0);
   int64_t second_dim = state.range(1);
@@ -0,0 +1,50 @@
+"""Build macros generating C++ code for Koda entities."""
+
+def koda_cc_accessors(name, spec, deps = [], **kwargs):
+    """Generates typed C++ accessors for the entities described in `spec`.
+
+    Creates a cc_library `name` with header `<name>.h`. For every entity of the
+    spec, the header defines a class with a nested `Batch` class resolving all
+    attributes of a DataSlice of entities at once. See
+    //py/koladata/codemaker:cc_accessors.py for the format of the spec.
+
+    Example:
+        koda_cc_accessors(
+            name = "person_accessors",
+            spec = "person.json",
+        )
+
+    Args:
+        name: The target name.
+        spec: JSON file with the entity schemas.
+        deps: Additional dependencies of the generated library.
+        **kwargs: Additional arguments for the cc_library.
+    """
+    header = name + ".h"
+    header_guard = (native.package_name() + "/" + header).upper()
+    for c in "/.-":
+        header_guard = header_guard.replace(c, "_")
+    native.genrule(
+        name = name + "_gen",
+        srcs = [spec],
+        outs = [header],
+        cmd = ("$(location //py/koladata/codemaker:cc_accessors_main) " +
+               "--spec=$(location {}) --output=$@ --header_guard={}_").format(
+            spec,
+            header_guard,
+        ),
+        tools = ["//py/koladata/codemaker:cc_accessors_main"],
+    )
+    native.cc_library(
+        name = name,
+        hdrs = [header],
+        deps = deps + [
+            "//koladata:data_slice",
+            "//koladata/internal:object_id",
+            "@com_google_absl//absl/status:statusor",
+            "@com_google_absl//absl/strings:string_view",
+            "@com_google_arolla//arolla/util",
+            "@com_google_arolla//arolla/util:status_backport",
+        ],
+        **kwargs
+    )
@@ -0,0 +1,63 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/codemaker/person_accessors.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_slice.h"
+#include "koladata/object_factories.h"
+#include "koladata/test_utils.h"
+#include "arolla/util/text.h"
+
+namespace koladata::codemaker::testing {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+
+TEST(PersonAccessorsTest, Batch) {
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      auto companies,
+      EntityCreator::FromAttrs(db, {"revenue"},
+                               {test::DataSlice<double>({1.5, 2.5})}));
+  ASSERT_OK_AND_ASSIGN(
+      auto people,
+      EntityCreator::FromAttrs(
+          db, {"age", "name", "employer"},
+          {test::DataSlice<int32_t>({30, std::nullopt}),
+           test::DataSlice<arolla::Text>({"a", "b"}), companies}));
+  ASSERT_OK_AND_ASSIGN(auto batch, Person::Batch::Create(people));
+  EXPECT_EQ(batch.size(), 2);
+  EXPECT_EQ(batch.age()[0], 30);
+  EXPECT_FALSE(batch.age().present(1));
+  EXPECT_EQ(batch.name()[1], "b");
+  EXPECT_TRUE(batch.employer().IsFull());
+
+  ASSERT_OK_AND_ASSIGN(auto company_batch, Company::Batch::Create(companies));
+  EXPECT_EQ(company_batch.revenue()[1], 2.5);
+
+  EXPECT_THAT(Company::Batch::Create(people),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace koladata::codemaker::testing
@@ -14,19 +14,30 @@
 //
 #include "koladata/data_bag.h"
 
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/base/call_once.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "koladata/data_bag_repr.h"
 #include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dense_source.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/internal/stable_fingerprint.h"
 #include "arolla/qtype/simple_qtype.h"
 #include "arolla/qtype/typed_value.h"
 #include "arolla/util/fingerprint.h"
@@ -127,6 +138,18 @@ absl::StatusOr<internal::DataBagImplPtr> MergeFallbacksToForkedImpl(
 
 }  // namespace
 
+absl::StatusOr<DataBagPtr> DataBag::FreezeOptimized(
+    const internal::OptimizeOptions& options) const {
+  internal::DataBagImplPtr merged_impl;
+  if (!fallbacks_.empty()) {
+    ASSIGN_OR_RETURN(merged_impl, MergeFallbacksToForkedImpl(*this));
+  }
+  const internal::DataBagImpl& impl =
+      merged_impl != nullptr ? *merged_impl : *impl_;
+  ASSIGN_OR_RETURN(auto optimized_impl, impl.CreateOptimized(options));
+  return std::move(*FromImpl(std::move(optimized_impl))).ToImmutable();
+}
+
 absl::StatusOr<DataBagPtr> DataBag::MergeFallbacks() {
   ASSIGN_OR_RETURN(auto impl_fork, MergeFallbacksToForkedImpl(*this));
   // Make sure that modifications to the new DataBag don't affect the original.
@@ -154,15 +177,20 @@ absl::Status DataBag::MergeInplace(const DataBagPtr& other_db, bool overwrite,
   return db_impl.MergeInplace(*other_db_impl, merge_options);
 }
 
-void FlattenFallbackFinder::CollectFlattenFallbacks(
-    const DataBag& bag, const std::vector<DataBagPtr>& fallbacks) {
+namespace {
+
+// Calls `fn` for all the fallbacks of `bag` in pre order using Depth First
+// Search. Duplicates are skipped.
+template <class Fn>
+void VisitFlattenFallbacks(const DataBag& bag,
+                           const std::vector<DataBagPtr>& fallbacks, Fn fn) {
   absl::flat_hash_set<const DataBag*> seen_db;
   seen_db.reserve(fallbacks.size() + 1);
   seen_db.insert(&bag);
 
   auto add_fallback = [&](const DataBag* fallback) {
     if (seen_db.insert(fallback).second) {
-      fallback_holder_.push_back(&fallback->GetImpl());
+      fn(*fallback);
       return true;
     }
     return false;
@@ -185,6 +213,245 @@ void FlattenFallbackFinder::CollectFlattenFallbacks(
       }
     }
   }
+}
+
+}  // namespace
+
+const DataBag::FlattenFallbacksCache* DataBag::GetFlattenFallbacksCache()
+    const {
+  absl::call_once(flatten_fallbacks_once_, [this] {
+    if (is_mutable_) {
+      return;
+    }
+    auto cache = std::make_unique<FlattenFallbacksCache>();
+    bool all_immutable = true;
+    VisitFlattenFallbacks(*this, fallbacks_, [&](const DataBag& fallback) {
+      if (fallback.IsMutable()) {
+        all_immutable = false;
+        return;
+      }
+      const internal::DataBagImpl& impl = fallback.GetImpl();
+      if (impl.IsEmpty()) {
+        return;
+      }
+      cache->impl_holders.push_back(
+          internal::DataBagImplConstPtr::NewRef(&impl));
+      cache->impls.push_back(&impl);
+    });
+    if (all_immutable) {
+      flatten_fallbacks_cache_ = std::move(cache);
+    }
+  });
+  return flatten_fallbacks_cache_.get();
+}
+
+std::optional<internal::DataItem> DataBag::AttrSchemaCache::Lookup(
+    internal::ObjectId schema, absl::string_view attr_name) const {
+  absl::ReaderMutexLock lock(&mutex_);
+  auto schema_it = entries_.find(schema);
+  if (schema_it == entries_.end()) {
+    return std::nullopt;
+  }
+  auto attr_it = schema_it->second.find(attr_name);
+  if (attr_it == schema_it->second.end()) {
+    return std::nullopt;
+  }
+  return attr_it->second;
+}
+
+void DataBag::AttrSchemaCache::Insert(internal::ObjectId schema,
+                                      absl::string_view attr_name,
+                                      const internal::DataItem& attr_schema) {
+  absl::MutexLock lock(&mutex_);
+  if (size_ >= kMaxSize) {
+    return;
+  }
+  if (entries_[schema].try_emplace(attr_name, attr_schema).second) {
+    ++size_;
+  }
+}
+
+DataBag::AttrSchemaCache* DataBag::GetAttrSchemaCache() const {
+  absl::call_once(attr_schema_cache_once_, [this] {
+    if (GetFlattenFallbacksCache() != nullptr) {
+      attr_schema_cache_ = std::make_unique<AttrSchemaCache>();
+    }
+  });
+  return attr_schema_cache_.get();
+}
+
+namespace {
+
+// Returns the values of `attr` for all the objects of `alloc`, looked up in
+// `impl` and `fallbacks`, as a single DenseSource. See
+// DataBag::GetMergedAttrSource.
+absl::StatusOr<std::shared_ptr<const internal::DenseSource>>
+CreateMergedAttrSource(const internal::DataBagImpl& impl,
+                       internal::DataBagImpl::FallbackSpan fallbacks,
+                       internal::AllocationId alloc, absl::string_view attr) {
+  internal::DataBagImpl::ConstDenseSourceArray dense_sources;
+  internal::DataBagImpl::ConstSparseSourceArray sparse_sources;
+  impl.GetAttributeDataSources(alloc, attr, dense_sources, sparse_sources);
+  for (const internal::DataBagImpl* fallback : fallbacks) {
+    fallback->GetAttributeDataSources(alloc, attr, dense_sources,
+                                      sparse_sources);
+  }
+  if (dense_sources.empty()) {
+    // Sparse attributes are cheap to probe and expensive to densify.
+    return nullptr;
+  }
+  if (dense_sources.size() == 1 && sparse_sources.empty() &&
+      dense_sources[0]->size() == alloc.Capacity()) {
+    // Already a single source. It is owned by one of the DataBagImpls, which
+    // are kept alive by the FlattenFallbacksCache of the DataBag.
+    return std::shared_ptr<const internal::DenseSource>(
+        std::shared_ptr<const void>(), dense_sources[0]);
+  }
+  ASSIGN_OR_RETURN(
+      internal::DataSliceImpl values,
+      impl.GetAttr(
+          internal::DataSliceImpl::ObjectsFromAllocation(alloc,
+                                                         alloc.Capacity()),
+          attr, fallbacks));
+  if (values.is_empty_and_unknown()) {
+    return nullptr;
+  }
+  return internal::DenseSource::CreateReadonly(alloc, values);
+}
+
+}  // namespace
+
+absl::StatusOr<const internal::DenseSource*> DataBag::GetMergedAttrSource(
+    internal::AllocationId alloc, absl::string_view attr) const {
+  if (alloc.IsSmall() || alloc.Capacity() > kMaxMergedAllocCapacity) {
+    return nullptr;
+  }
+  const FlattenFallbacksCache* fallbacks_cache = GetFlattenFallbacksCache();
+  if (fallbacks_cache == nullptr || fallbacks_cache->impls.empty()) {
+    return nullptr;
+  }
+  {
+    absl::ReaderMutexLock lock(&merged_attr_sources_mutex_);
+    if (auto alloc_it = merged_attr_sources_.find(alloc);
+        alloc_it != merged_attr_sources_.end()) {
+      if (auto attr_it = alloc_it->second.find(attr);
+          attr_it != alloc_it->second.end()) {
+        return attr_it->second.get();
+      }
+    }
+    if (merged_attr_objects_ >= kMaxMergedObjects) {
+      return nullptr;
+    }
+  }
+  // Built outside of the lock, a concurrent call may build the same source.
+  ASSIGN_OR_RETURN(auto source,
+                   CreateMergedAttrSource(*impl_, fallbacks_cache->impls,
+                                          alloc, attr));
+  absl::MutexLock lock(&merged_attr_sources_mutex_);
+  auto [it, inserted] =
+      merged_attr_sources_[alloc].try_emplace(attr, std::move(source));
+  if (inserted && it->second != nullptr) {
+    merged_attr_objects_ += alloc.Capacity();
+  }
+  return it->second.get();
+}
+
+namespace {
+
+void CombineSliceContent(const internal::DataSliceImpl& slice,
+                         internal::StableFingerprintHasher& hasher) {
+  hasher.Combine(slice.size());
+  for (const internal::DataItem& item : slice) {
+    hasher.Combine(item.StableFingerprint());
+  }
+}
+
+// ExtractContent returns the attributes, lists and dicts ordered by their ids
+// and the dict keys sorted, so the content is combined in a canonical order.
+absl::Status CombineImplContent(const internal::DataBagImpl& impl,
+                                internal::StableFingerprintHasher& hasher) {
+  ASSIGN_OR_RETURN(internal::DataBagContent content, impl.ExtractContent());
+  hasher.Combine(content.attrs.size());
+  for (const auto& [attr_name, attr] : content.attrs) {
+    hasher.Combine(attr_name, attr.allocs.size(), attr.items.size());
+    for (const auto& alloc : attr.allocs) {
+      hasher.Combine(alloc.alloc_id);
+      CombineSliceContent(alloc.values, hasher);
+    }
+    for (const auto& item : attr.items) {
+      hasher.Combine(item.object_id, item.value.StableFingerprint());
+    }
+  }
+  hasher.Combine(content.lists.size());
+  for (const auto& list : content.lists) {
+    hasher.Combine(list.alloc_id);
+    CombineSliceContent(list.values, hasher);
+    list.lists_to_values_edge.edge_values().ForEach(
+        [&](int64_t, bool present, int64_t split_point) {
+          hasher.Combine(present, split_point);
+        });
+  }
+  hasher.Combine(content.dicts.size());
+  for (const auto& dict : content.dicts) {
+    hasher.Combine(dict.dict_id, dict.keys.size());
+    for (size_t i = 0; i < dict.keys.size(); ++i) {
+      hasher.Combine(dict.keys[i].StableFingerprint(),
+                     dict.values[i].StableFingerprint());
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<arolla::Fingerprint> DataBag::ContentFingerprint() const {
+  absl::call_once(content_fingerprint_once_, [this] {
+    content_fingerprint_ = [&]() -> absl::StatusOr<arolla::Fingerprint> {
+      const FlattenFallbacksCache* flatten_fallbacks =
+          GetFlattenFallbacksCache();
+      if (flatten_fallbacks == nullptr) {
+        return absl::InvalidArgumentError(
+            "content fingerprint is only supported for immutable DataBags "
+            "with immutable fallbacks");
+      }
+      // Like the flattened fallbacks, the DataBag itself is skipped if it is
+      // empty, so wrapping DataBags as fallbacks does not change the
+      // fingerprint.
+      std::vector<const internal::DataBagImpl*> impls;
+      impls.reserve(flatten_fallbacks->impls.size() + 1);
+      if (!GetImpl().IsEmpty()) {
+        impls.push_back(&GetImpl());
+      }
+      impls.insert(impls.end(), flatten_fallbacks->impls.begin(),
+                   flatten_fallbacks->impls.end());
+      internal::StableFingerprintHasher hasher("koladata.DataBag.content");
+      hasher.Combine(impls.size());
+      for (const internal::DataBagImpl* impl : impls) {
+        RETURN_IF_ERROR(CombineImplContent(*impl, hasher));
+      }
+      return std::move(hasher).Finish();
+    }();
+  });
+  return content_fingerprint_;
+}
+
+internal::DataBagMemoryUsage DataBag::EstimateMemoryUsage() const {
+  internal::DataBagMemoryUsage res = impl_->EstimateMemoryUsage();
+  FlattenFallbackFinder fallback_finder(*this);
+  for (const internal::DataBagImpl* fallback :
+       fallback_finder.GetFlattenFallbacks()) {
+    for (const auto& [key, usage] : fallback->EstimateMemoryUsage().entries) {
+      res.entries[key].shared += usage.total();
+    }
+  }
+  return res;
+}
+
+void FlattenFallbackFinder::CollectFlattenFallbacks(
+    const DataBag& bag, const std::vector<DataBagPtr>& fallbacks) {
+  VisitFlattenFallbacks(bag, fallbacks, [&](const DataBag& fallback) {
+    fallback_holder_.push_back(&fallback.GetImpl());
+  });
   fallback_span_ = absl::MakeConstSpan(fallback_holder_);
 }
 
@@ -197,6 +464,16 @@ std::string GetBagIdRepr(const DataBagPtr& db) {
   return absl::StrCat("$", absl::string_view(fp_hex).substr(fp_hex.size() - 4));
 }
 
+bool IsDeeplyImmutable(const DataBagPtr& db) {
+  if (db == nullptr) {
+    return true;
+  }
+  if (db->IsMutable()) {
+    return false;
+  }
+  return absl::c_all_of(db->GetFallbacks(), IsDeeplyImmutable);
+}
+
 }  // namespace koladata
 
 namespace arolla {
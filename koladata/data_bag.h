@@ -17,16 +17,27 @@
 
 #include <atomic>
 #include <functional>
+#include <cstddef>
+#include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/call_once.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/dense_source.h"
+#include "koladata/internal/object_id.h"
 #include "arolla/qtype/simple_qtype.h"
 #include "arolla/util/fingerprint.h"
 #include "arolla/util/repr.h"
@@ -91,6 +102,12 @@ class DataBag {
     return new_db;
   }
 
+  // Returns a new immutable DataBag with the same content (fallbacks
+  // included) stored in the layout that is the fastest to read. See
+  // DataBagImpl::CreateOptimized.
+  absl::StatusOr<DataBagPtr> FreezeOptimized(
+      const internal::OptimizeOptions& options = {}) const;
+
   // Returns fallbacks in priority order.
   const std::vector<DataBagPtr>& GetFallbacks() const { return fallbacks_; }
 
@@ -123,6 +140,61 @@ class DataBag {
   // Fingerprint of the DataBag (randomized).
   arolla::Fingerprint fingerprint() const { return fingerprint_; }
 
+  // Fingerprint of the content of the DataBag and its fallbacks. Unlike
+  // fingerprint(), it is the same for DataBags built the same way, so it can
+  // be used as a key of caches that outlive the DataBag (e.g. for results of
+  // evaluation or serialization). Only supported if the DataBag and all its
+  // fallbacks are immutable. Computed on the first call in O(size).
+  absl::StatusOr<arolla::Fingerprint> ContentFingerprint() const;
+
+  // Returns the estimated memory usage of the DataBag, see
+  // internal::DataBagImpl::EstimateMemoryUsage. All the data of the fallbacks
+  // is reported as shared.
+  internal::DataBagMemoryUsage EstimateMemoryUsage() const;
+
+  // Attribute schemas of entity schemas, as returned by
+  // GetSchemaAttrAllowMissing (a missing DataItem for a missing attribute).
+  // Thread-safe.
+  class AttrSchemaCache {
+   public:
+    std::optional<internal::DataItem> Lookup(internal::ObjectId schema,
+                                             absl::string_view attr_name) const;
+    // Does nothing once the cache holds kMaxSize entries.
+    void Insert(internal::ObjectId schema, absl::string_view attr_name,
+                const internal::DataItem& attr_schema);
+
+    static constexpr size_t kMaxSize = 1 << 16;
+
+   private:
+    mutable absl::Mutex mutex_;
+    absl::flat_hash_map<internal::ObjectId,
+                        absl::flat_hash_map<std::string, internal::DataItem>>
+        entries_ ABSL_GUARDED_BY(mutex_);
+    size_t size_ ABSL_GUARDED_BY(mutex_) = 0;
+  };
+
+  // Returns the attribute schema cache of this DataBag, or nullptr if this
+  // DataBag or any of its fallbacks is mutable. The schemas of such DataBags
+  // can not change, so the cache is never invalidated.
+  AttrSchemaCache* GetAttrSchemaCache() const;
+
+  // Returns a DenseSource with the values of `attr` for the objects of
+  // `alloc`, merged over this DataBag and all its fallbacks, so that a lookup
+  // touches a single source instead of probing every fallback. The source is
+  // built on the first call for each (alloc, attr) and is owned by this
+  // DataBag.
+  //
+  // Returns nullptr if there is no merged view: if this DataBag or any of its
+  // fallbacks is mutable, if there are no non-empty fallbacks, if `alloc` is
+  // small or bigger than kMaxMergedAllocCapacity, if none of the DataBags
+  // stores `attr` of `alloc` densely, or once kMaxMergedObjects objects are
+  // cached. Thread-safe.
+  absl::StatusOr<const internal::DenseSource*> GetMergedAttrSource(
+      internal::AllocationId alloc, absl::string_view attr) const;
+
+  static constexpr int64_t kMaxMergedAllocCapacity = 1 << 20;
+  static constexpr int64_t kMaxMergedObjects = 1 << 24;
+
  private:
   explicit DataBag(bool is_mutable)
       : impl_(internal::DataBagImpl::CreateEmptyDatabag()),
@@ -141,6 +213,39 @@ class DataBag {
 
   // Used to implement lazy forking for immutable DataBags.
   std::atomic<bool> forked_ = false;
+
+  // Flattened fallbacks of an immutable DataBag (see FlattenFallbackFinder).
+  // Holds references to the DataBagImpls, so that the cache stays valid even
+  // if one of the DataBags replaces its impl_ (e.g. in MergeFallbacks).
+  struct FlattenFallbacksCache {
+    std::vector<internal::DataBagImplConstPtr> impl_holders;
+    std::vector<const internal::DataBagImpl*> impls;
+  };
+  friend class FlattenFallbackFinder;
+
+  // Returns the cached flattened fallbacks, computing them on the first call.
+  // Returns nullptr if the result can not be cached, i.e. if this DataBag or
+  // any of the (transitive) fallbacks is mutable.
+  const FlattenFallbacksCache* GetFlattenFallbacksCache() const;
+
+  mutable absl::once_flag flatten_fallbacks_once_;
+  mutable std::unique_ptr<const FlattenFallbacksCache> flatten_fallbacks_cache_;
+
+  mutable absl::once_flag content_fingerprint_once_;
+  mutable absl::StatusOr<arolla::Fingerprint> content_fingerprint_;
+
+  mutable absl::once_flag attr_schema_cache_once_;
+  mutable std::unique_ptr<AttrSchemaCache> attr_schema_cache_;
+
+  // See GetMergedAttrSource. nullptr values are cached as well.
+  mutable absl::Mutex merged_attr_sources_mutex_;
+  mutable absl::flat_hash_map<
+      internal::AllocationId,
+      absl::flat_hash_map<std::string,
+                          std::shared_ptr<const internal::DenseSource>>>
+      merged_attr_sources_ ABSL_GUARDED_BY(merged_attr_sources_mutex_);
+  mutable int64_t merged_attr_objects_
+      ABSL_GUARDED_BY(merged_attr_sources_mutex_) = 0;
 };
 
 class FlattenFallbackFinder {
@@ -149,11 +254,23 @@ class FlattenFallbackFinder {
   FlattenFallbackFinder() = default;
 
   // Constructs fallback list from the provided databag.
+  //
+  // For immutable DataBags with only immutable fallbacks, the list is computed
+  // once per DataBag and reused by all the subsequent FlattenFallbackFinders.
+  // Empty DataBagImpls are excluded from the cached list, since they can not
+  // contribute to lookups. The FlattenFallbackFinder must not outlive `bag`.
   explicit FlattenFallbackFinder(const DataBag& bag) {
     const auto& fallbacks = bag.GetFallbacks();
     if (fallbacks.empty()) {
       return;
     }
+    if (!bag.IsMutable()) {
+      if (const auto* cache = bag.GetFlattenFallbacksCache();
+          cache != nullptr) {
+        fallback_span_ = cache->impls;
+        return;
+      }
+    }
     CollectFlattenFallbacks(bag, fallbacks);
   }
 
@@ -175,6 +292,10 @@ class FlattenFallbackFinder {
 // Returns the string representation of the DataBag.
 std::string GetBagIdRepr(const DataBagPtr& db);
 
+// Returns true if `db` is nullptr or if `db` and all its (transitive)
+// fallbacks are immutable, i.e. the data visible through `db` never changes.
+bool IsDeeplyImmutable(const DataBagPtr& db);
+
 }  // namespace koladata
 
 namespace arolla {
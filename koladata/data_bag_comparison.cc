@@ -0,0 +1,202 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/data_bag_comparison.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "koladata/data_bag.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata {
+namespace {
+
+using ContentKey = DataBagComparison::ContentKey;
+using ::koladata::internal::DataBagContent;
+
+// The parts of both contents with the same key. Missing parts are nullptr or
+// empty.
+struct ContentPart {
+  const internal::DataSliceImpl* alloc_values[2] = {nullptr, nullptr};
+  std::vector<const DataBagContent::AttrItemContent*> items[2];
+  const DataBagContent::ListsContent* lists[2] = {nullptr, nullptr};
+  std::vector<const DataBagContent::DictContent*> dicts[2];
+};
+
+bool IsEmpty(const internal::DataSliceImpl* values) {
+  return values == nullptr || values->present_count() == 0;
+}
+
+bool AllocValuesEqual(const internal::DataSliceImpl* a,
+                      const internal::DataSliceImpl* b) {
+  if (a == nullptr || b == nullptr) {
+    // The missing values do not form triples.
+    return IsEmpty(a) && IsEmpty(b);
+  }
+  return a->IsEquivalentTo(*b);
+}
+
+bool ItemsEqual(absl::Span<const DataBagContent::AttrItemContent* const> a,
+                absl::Span<const DataBagContent::AttrItemContent* const> b) {
+  return std::equal(a.begin(), a.end(), b.begin(), b.end(),
+                    [](const auto* lhs, const auto* rhs) {
+                      return lhs->object_id == rhs->object_id &&
+                             lhs->value == rhs->value;
+                    });
+}
+
+bool ListsEqual(const DataBagContent::ListsContent* a,
+                const DataBagContent::ListsContent* b) {
+  if (a == nullptr || b == nullptr) {
+    return a == b;
+  }
+  return a->lists_to_values_edge.IsEquivalentTo(b->lists_to_values_edge) &&
+         a->values.IsEquivalentTo(b->values);
+}
+
+bool DictsEqual(absl::Span<const DataBagContent::DictContent* const> a,
+                absl::Span<const DataBagContent::DictContent* const> b) {
+  // The empty dicts do not form triples.
+  auto next = [](auto& it, auto end) {
+    while (it != end && (*it)->keys.empty()) {
+      ++it;
+    }
+  };
+  auto a_it = a.begin();
+  auto b_it = b.begin();
+  for (;; ++a_it, ++b_it) {
+    next(a_it, a.end());
+    next(b_it, b.end());
+    if (a_it == a.end() || b_it == b.end()) {
+      return a_it == a.end() && b_it == b.end();
+    }
+    if ((*a_it)->dict_id != (*b_it)->dict_id ||
+        (*a_it)->keys != (*b_it)->keys || (*a_it)->values != (*b_it)->values) {
+      return false;
+    }
+  }
+}
+
+bool PartsEqual(const ContentKey& key, const ContentPart& part) {
+  switch (key.kind) {
+    case ContentKey::Kind::kAttr:
+      return AllocValuesEqual(part.alloc_values[0], part.alloc_values[1]) &&
+             ItemsEqual(part.items[0], part.items[1]);
+    case ContentKey::Kind::kLists:
+      return ListsEqual(part.lists[0], part.lists[1]);
+    case ContentKey::Kind::kDicts:
+      return DictsEqual(part.dicts[0], part.dicts[1]);
+  }
+  return false;
+}
+
+void AddContentParts(const DataBagContent& content, int side,
+                     absl::btree_map<ContentKey, ContentPart>& parts) {
+  for (const auto& [attr_name, attr] : content.attrs) {
+    for (const auto& alloc : attr.allocs) {
+      parts[{ContentKey::Kind::kAttr, alloc.alloc_id, attr_name}]
+          .alloc_values[side] = &alloc.values;
+    }
+    for (const auto& item : attr.items) {
+      parts[{ContentKey::Kind::kAttr, internal::AllocationId(item.object_id),
+             attr_name}]
+          .items[side]
+          .push_back(&item);
+    }
+  }
+  for (const auto& lists : content.lists) {
+    parts[{ContentKey::Kind::kLists, lists.alloc_id, ""}].lists[side] = &lists;
+  }
+  for (const auto& dict : content.dicts) {
+    parts[{ContentKey::Kind::kDicts, internal::AllocationId(dict.dict_id), ""}]
+        .dicts[side]
+        .push_back(&dict);
+  }
+}
+
+}  // namespace
+
+bool DataBagComparison::ExactlyEqual(const DataBagPtr a, const DataBagPtr b,
+                                     internal::Executor* executor) {
+  auto diff = DiffContent(a->GetImpl(), b->GetImpl(), executor);
+  if (!diff.value().empty()) {
+    return false;
+  }
+  FlattenFallbackFinder a_fb_finder(*a);
+  FlattenFallbackFinder b_fb_finder(*b);
+  const auto& a_fallbacks = a_fb_finder.GetFlattenFallbacks();
+  const auto& b_fallbacks = b_fb_finder.GetFlattenFallbacks();
+  if (a_fallbacks.size() != b_fallbacks.size()) {
+    return false;
+  }
+  for (int i = 0; i < a_fallbacks.size(); ++i) {
+    diff = DiffContent(*a_fallbacks[i], *b_fallbacks[i], executor);
+    if (!diff.value().empty()) {
+      return false;
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<std::vector<ContentKey>> DataBagComparison::DiffContent(
+    const internal::DataBagImpl& a, const internal::DataBagImpl& b,
+    internal::Executor* executor) {
+  if (&a == &b) {
+    return std::vector<ContentKey>();
+  }
+  const internal::DataBagImpl* impls[2] = {&a, &b};
+  DataBagContent contents[2];
+  RETURN_IF_ERROR(
+      internal::ParallelFor(executor, 2, [&](int64_t side) -> absl::Status {
+        ASSIGN_OR_RETURN(contents[side], impls[side]->ExtractContent());
+        return absl::OkStatus();
+      }));
+  absl::btree_map<ContentKey, ContentPart> parts;
+  for (int side = 0; side < 2; ++side) {
+    AddContentParts(contents[side], side, parts);
+  }
+
+  std::vector<std::pair<const ContentKey*, const ContentPart*>> part_list;
+  part_list.reserve(parts.size());
+  for (const auto& [key, part] : parts) {
+    part_list.emplace_back(&key, &part);
+  }
+  std::vector<char> differs(part_list.size(), false);
+  RETURN_IF_ERROR(internal::ParallelFor(
+      executor, part_list.size(), [&](int64_t i) -> absl::Status {
+        differs[i] = !PartsEqual(*part_list[i].first, *part_list[i].second);
+        return absl::OkStatus();
+      }));
+  std::vector<ContentKey> res;
+  for (int64_t i = 0; i < part_list.size(); ++i) {
+    if (differs[i]) {
+      res.push_back(*part_list[i].first);
+    }
+  }
+  return res;
+}
+
+}  // namespace koladata
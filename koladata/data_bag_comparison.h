@@ -15,35 +15,55 @@
 #ifndef KOLADATA_DATA_BAG_COMPARISON_H_
 #define KOLADATA_DATA_BAG_COMPARISON_H_
 
-#include "koladata/data_bag.h"
-#include "koladata/internal/triples.h"
+#include <string>
+#include <tuple>
+#include <vector>
 
+#include "absl/status/statusor.h"
+#include "koladata/data_bag.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
 
 namespace koladata {
 
 class DataBagComparison {
  public:
-  static bool ExactlyEqual(const DataBagPtr a, const DataBagPtr b) {
-    using Triples = internal::debug::Triples;
-    if (Triples(a->GetImpl().ExtractContent().value()) !=
-        Triples(b->GetImpl().ExtractContent().value())) {
-      return false;
-    }
-    FlattenFallbackFinder a_fb_finder(*a);
-    FlattenFallbackFinder b_fb_finder(*b);
-    const auto& a_fallbacks = a_fb_finder.GetFlattenFallbacks();
-    const auto& b_fallbacks = b_fb_finder.GetFlattenFallbacks();
-    if (a_fallbacks.size() != b_fallbacks.size()) {
-      return false;
-    }
-    for (int i = 0; i < a_fallbacks.size(); ++i) {
-      if (Triples(a_fallbacks[i]->ExtractContent().value()) !=
-          Triples(b_fallbacks[i]->ExtractContent().value())) {
-        return false;
-      }
+  // A part of the DataBag content that is compared independently of the
+  // others: the values of an attribute for the objects of an allocation, or
+  // the lists or dicts of an allocation.
+  struct ContentKey {
+    enum class Kind { kAttr, kLists, kDicts };
+
+    Kind kind;
+    internal::AllocationId alloc;
+    // Empty unless kind == kAttr.
+    std::string attr;
+
+    friend bool operator==(const ContentKey& lhs,
+                           const ContentKey& rhs) = default;
+    friend bool operator<(const ContentKey& lhs, const ContentKey& rhs) {
+      return std::tie(lhs.kind, lhs.alloc, lhs.attr) <
+             std::tie(rhs.kind, rhs.alloc, rhs.attr);
     }
-    return true;
-  }
+  };
+
+  // Returns true if `a` and `b`, and their flattened fallbacks in order, have
+  // the same triples. When `executor` is not null, the parts of the content
+  // are compared concurrently.
+  static bool ExactlyEqual(const DataBagPtr a, const DataBagPtr b,
+                           internal::Executor* executor = nullptr);
+
+  // Returns the sorted keys of the parts of the content that have different
+  // triples in `a` and `b`. The fallbacks are not considered.
+  //
+  // The values are compared with DataSliceImpl::IsEquivalentTo first, which
+  // returns immediately for the parts still sharing their buffers (e.g. the
+  // attributes not modified since a fork). When `executor` is not null, the
+  // parts are compared concurrently.
+  static absl::StatusOr<std::vector<ContentKey>> DiffContent(
+      const internal::DataBagImpl& a, const internal::DataBagImpl& b,
+      internal::Executor* executor = nullptr);
 };
 
 }  // namespace koladata
@@ -14,15 +14,27 @@
 //
 #include "koladata/data_bag_comparison.h"
 
+#include <vector>
+
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
 #include "koladata/data_bag.h"
-#include "koladata/internal/data_slice.h"
 #include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
 
 namespace koladata {
 namespace {
 
+using ::absl_testing::IsOkAndHolds;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+using ContentKey = DataBagComparison::ContentKey;
+
 TEST(DataBagComparisonTest, ExactlyEqual_NoFallbacks) {
   auto ds1 = internal::DataSliceImpl::AllocateEmptyObjects(3);
   auto ds2 = internal::DataSliceImpl::AllocateEmptyObjects(3);
@@ -67,6 +79,46 @@ TEST(DataBagComparisonTest, ExactlyEqual_Fallbacks) {
   EXPECT_FALSE(DataBagComparison::ExactlyEqual(db_ff212, db_ff122));
 }
 
+TEST(DataBagComparisonTest, DiffContent) {
+  auto ds1 = internal::DataSliceImpl::AllocateEmptyObjects(3);
+  auto ds2 = internal::DataSliceImpl::AllocateEmptyObjects(3);
+  internal::AllocationId alloc1 = ds1.allocation_ids().ids()[0];
+  internal::AllocationId alloc2 = ds2.allocation_ids().ids()[0];
+  internal::AllocationId lists_alloc = internal::AllocateLists(3);
+  auto lists = internal::DataSliceImpl::ObjectsFromAllocation(lists_alloc, 3);
+
+  auto db1 = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(internal::DataBagImpl& db1_impl, db1->GetMutableImpl());
+  ASSERT_OK(db1_impl.SetAttr(ds1, "a", ds2));
+  ASSERT_OK(db1_impl.SetAttr(ds1, "b", ds2));
+  ASSERT_OK(db1_impl.SetAttr(ds2, "a", ds1));
+  ASSERT_OK(db1_impl.AppendToList(lists, ds1));
+  ASSERT_OK_AND_ASSIGN(auto db2, db1->Fork());
+  ASSERT_OK_AND_ASSIGN(internal::DataBagImpl& db2_impl, db2->GetMutableImpl());
+
+  internal::ThreadPoolExecutor executor(4);
+  for (internal::Executor* e :
+       std::vector<internal::Executor*>{nullptr, &executor}) {
+    EXPECT_THAT(DataBagComparison::DiffContent(db1_impl, db2_impl, e),
+                IsOkAndHolds(IsEmpty()));
+  }
+  EXPECT_TRUE(DataBagComparison::ExactlyEqual(db1, db2, &executor));
+
+  ASSERT_OK(db2_impl.SetAttr(ds1[1], "b", internal::DataItem(57)));
+  ASSERT_OK(db2_impl.SetAttr(ds2, "c", ds2));
+  ASSERT_OK(db2_impl.AppendToList(lists[0], internal::DataItem(1)));
+  for (internal::Executor* e :
+       std::vector<internal::Executor*>{nullptr, &executor}) {
+    EXPECT_THAT(
+        DataBagComparison::DiffContent(db1_impl, db2_impl, e),
+        IsOkAndHolds(ElementsAre(
+            ContentKey{ContentKey::Kind::kAttr, alloc1, "b"},
+            ContentKey{ContentKey::Kind::kAttr, alloc2, "c"},
+            ContentKey{ContentKey::Kind::kLists, lists_alloc, ""})));
+  }
+  EXPECT_FALSE(DataBagComparison::ExactlyEqual(db1, db2, &executor));
+}
+
 
 }  // namespace
 }  // namespace koladata
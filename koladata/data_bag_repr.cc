@@ -65,6 +65,30 @@ constexpr absl::string_view kSchemaNameReplacement = "<object schemas>";
 struct DataBagFormatOption {
   int indentation = 0;
   std::optional<int> fallback_index;
+  int64_t triple_limit = -1;
+};
+
+// Number of triples that can still be printed.
+class TripleBudget {
+ public:
+  explicit TripleBudget(int64_t limit) : remaining_(limit) {}
+
+  // Returns true if one more triple can be printed. Otherwise marks the output
+  // as truncated.
+  bool Take() {
+    if (remaining_ == 0) {
+      truncated_ = true;
+      return false;
+    }
+    --remaining_;
+    return true;
+  }
+
+  bool truncated() const { return truncated_; }
+
+ private:
+  int64_t remaining_;
+  bool truncated_ = false;
 };
 
 // Builds the schema attr triples into a map.
@@ -149,6 +173,139 @@ bool IsInternalAttribute(const internal::DataItem& item) {
          attr == schema::kDictValuesSchemaAttr;
 }
 
+void AppendAttrLine(absl::string_view line_indent, const ObjectId& object,
+                    absl::string_view attr, const DataItem& value,
+                    std::string& res) {
+  absl::StrAppend(
+      &res, line_indent,
+      absl::StrFormat("%s.%s => %s\n", ObjectIdStr(object), attr,
+                      internal::DataItemRepr(value, {.strip_quotes = true})));
+}
+
+void AppendDictLine(absl::string_view line_indent, const ObjectId& dict,
+                    const DataItem& key, const DataItem& value,
+                    std::string& res) {
+  absl::StrAppend(&res, line_indent,
+                  absl::StrFormat("%s[%s] => %s\n", ObjectIdStr(dict),
+                                  internal::DataItemRepr(key),
+                                  internal::DataItemRepr(value)));
+}
+
+absl::Status AppendSchemaLine(
+    absl::string_view line_indent, const ObjectId& schema, const DataItem& key,
+    const DataItem& value,
+    const absl::flat_hash_map<ObjectId, AttrMap>& schema_triple_map,
+    std::string& res) {
+  ASSIGN_OR_RETURN(std::string value_str,
+                   SchemaToStr(value, schema_triple_map));
+  absl::StrAppend(
+      &res, line_indent,
+      absl::StrFormat("%s.%s => %s\n", ObjectIdStr(schema),
+                      internal::DataItemRepr(key, {.strip_quotes = true}),
+                      value_str));
+  return absl::OkStatus();
+}
+
+// Appends the data triples of `content` in the storage order, stopping as soon
+// as `budget` is spent. Returns false if the output was truncated.
+bool AppendDataTriples(const DataBagContent& content,
+                       absl::string_view line_indent, TripleBudget& budget,
+                       std::string& res) {
+  for (const auto& [attr_name, attr_content] : content.attrs) {
+    for (const DataBagContent::AttrAllocContent& ac : attr_content.allocs) {
+      for (int64_t i = 0; i < ac.values.size(); ++i) {
+        DataItem value = ac.values[i];
+        if (!value.has_value()) {
+          continue;
+        }
+        if (!budget.Take()) {
+          return false;
+        }
+        AppendAttrLine(line_indent, ac.alloc_id.ObjectByOffset(i), attr_name,
+                       value, res);
+      }
+    }
+    for (const DataBagContent::AttrItemContent& ic : attr_content.items) {
+      if (!budget.Take()) {
+        return false;
+      }
+      AppendAttrLine(line_indent, ic.object_id, attr_name, ic.value, res);
+    }
+  }
+  for (const DataBagContent::ListsContent& lc : content.lists) {
+    absl::Span<const int64_t> split_points =
+        lc.lists_to_values_edge.edge_values().values.span();
+    for (int64_t i = 0; i < lc.lists_to_values_edge.parent_size(); ++i) {
+      // An empty list takes one triple from the budget as well.
+      if (!budget.Take()) {
+        return false;
+      }
+      std::vector<std::string> items;
+      for (int64_t j = split_points[i]; j < split_points[i + 1]; ++j) {
+        if (j > split_points[i] && !budget.Take()) {
+          items.emplace_back("...");
+          break;
+        }
+        items.push_back(internal::DataItemRepr(lc.values[j]));
+      }
+      absl::StrAppend(
+          &res, line_indent,
+          absl::StrFormat("%s[:] => [%s]\n",
+                          ObjectIdStr(lc.alloc_id.ObjectByOffset(i)),
+                          absl::StrJoin(items, ", ")));
+      if (budget.truncated()) {
+        return false;
+      }
+    }
+  }
+  for (const DataBagContent::DictContent& dc : content.dicts) {
+    if (!dc.dict_id.IsDict()) {
+      continue;
+    }
+    for (int64_t i = 0; i < dc.keys.size(); ++i) {
+      if (!budget.Take()) {
+        return false;
+      }
+      AppendDictLine(line_indent, dc.dict_id, dc.keys[i], dc.values[i], res);
+    }
+  }
+  return true;
+}
+
+// Appends the schema triples of `content` in the storage order, stopping as
+// soon as `budget` is spent.
+absl::Status AppendSchemaTriples(const DataBagContent& content,
+                                 absl::string_view line_indent,
+                                 TripleBudget& budget, std::string& res) {
+  // Nested schemas can be anywhere in the bag, so all of them are indexed.
+  absl::flat_hash_map<ObjectId, AttrMap> schema_triple_map;
+  for (const DataBagContent::DictContent& dc : content.dicts) {
+    if (!dc.dict_id.IsSchema()) {
+      continue;
+    }
+    AttrMap& attr_map = schema_triple_map[dc.dict_id];
+    for (int64_t i = 0; i < dc.keys.size(); ++i) {
+      attr_map.emplace(dc.keys[i], dc.values[i]);
+    }
+  }
+  for (const DataBagContent::DictContent& dc : content.dicts) {
+    if (!dc.dict_id.IsSchema()) {
+      continue;
+    }
+    for (int64_t i = 0; i < dc.keys.size(); ++i) {
+      if (IsInternalAttribute(dc.keys[i])) {
+        continue;
+      }
+      if (!budget.Take()) {
+        return absl::OkStatus();
+      }
+      RETURN_IF_ERROR(AppendSchemaLine(line_indent, dc.dict_id, dc.keys[i],
+                                       dc.values[i], schema_triple_map, res));
+    }
+  }
+  return absl::OkStatus();
+}
+
 absl::StatusOr<std::string> DataBagToStrInternal(
     const DataBagPtr& db, absl::flat_hash_set<const DataBag*>& seen_db,
     const DataBagFormatOption& format_opt) {
@@ -166,46 +323,49 @@ absl::StatusOr<std::string> DataBagToStrInternal(
                          "DataBag:\n")
           : absl::StrCat(line_indent, "DataBag ", GetBagIdRepr(db), ":\n");
   ASSIGN_OR_RETURN(DataBagContent content, db->GetImpl().ExtractContent());
-  Triples main_triples(content);
-  for (const AttrTriple& attr : main_triples.attributes()) {
-    absl::StrAppend(
-        &res, line_indent,
-        absl::StrFormat(
-            "%s.%s => %s\n", ObjectIdStr(attr.object), attr.attribute,
-            internal::DataItemRepr(attr.value, {.strip_quotes = true})));
-  }
-  for (const auto& [list_id, values] : main_triples.lists()) {
-    absl::StrAppend(
-        &res, line_indent,
-        absl::StrFormat(
-            "%s[:] => [%s]\n", ObjectIdStr(list_id),
-            absl::StrJoin(values.begin(), values.end(), ", ",
-                          [](std::string* out, const internal::DataItem& item) {
-                            out->append(internal::DataItemRepr(item));
-                          })));
-  }
-  for (const DictItemTriple& dict : main_triples.dicts()) {
-    if (dict.object.IsDict()) {
+  if (format_opt.triple_limit >= 0) {
+    TripleBudget data_budget(format_opt.triple_limit);
+    if (!AppendDataTriples(content, line_indent, data_budget, res)) {
+      absl::StrAppend(&res, line_indent, "...\n");
+    }
+    absl::StrAppend(&res, "\n", line_indent, "SchemaBag:\n");
+    TripleBudget schema_budget(format_opt.triple_limit);
+    RETURN_IF_ERROR(
+        AppendSchemaTriples(content, line_indent, schema_budget, res));
+    if (schema_budget.truncated()) {
+      absl::StrAppend(&res, line_indent, "...\n");
+    }
+  } else {
+    Triples main_triples(content);
+    for (const AttrTriple& attr : main_triples.attributes()) {
+      AppendAttrLine(line_indent, attr.object, attr.attribute, attr.value,
+                     res);
+    }
+    for (const auto& [list_id, values] : main_triples.lists()) {
       absl::StrAppend(
           &res, line_indent,
-          absl::StrFormat("%s[%s] => %s\n", ObjectIdStr(dict.object),
-                          internal::DataItemRepr(dict.key),
-                          internal::DataItemRepr(dict.value)));
+          absl::StrFormat(
+              "%s[:] => [%s]\n", ObjectIdStr(list_id),
+              absl::StrJoin(
+                  values.begin(), values.end(), ", ",
+                  [](std::string* out, const internal::DataItem& item) {
+                    out->append(internal::DataItemRepr(item));
+                  })));
     }
-  }
-  absl::StrAppend(&res, "\n", line_indent, "SchemaBag:\n");
-
-  absl::flat_hash_map<ObjectId, AttrMap> schema_triple_map =
-      BuildSchemaAttrMap(main_triples.dicts());
-  for (const DictItemTriple& dict : main_triples.dicts()) {
-    if (dict.object.IsSchema() && !IsInternalAttribute(dict.key)) {
-      ASSIGN_OR_RETURN(std::string value_str,
-                       SchemaToStr(dict.value, schema_triple_map));
-      absl::StrAppend(&res, line_indent,
-                      absl::StrFormat("%s.%s => %s\n", ObjectIdStr(dict.object),
-                                      internal::DataItemRepr(
-                                          dict.key, {.strip_quotes = true}),
-                                      value_str));
+    for (const DictItemTriple& dict : main_triples.dicts()) {
+      if (dict.object.IsDict()) {
+        AppendDictLine(line_indent, dict.object, dict.key, dict.value, res);
+      }
+    }
+    absl::StrAppend(&res, "\n", line_indent, "SchemaBag:\n");
+
+    absl::flat_hash_map<ObjectId, AttrMap> schema_triple_map =
+        BuildSchemaAttrMap(main_triples.dicts());
+    for (const DictItemTriple& dict : main_triples.dicts()) {
+      if (dict.object.IsSchema() && !IsInternalAttribute(dict.key)) {
+        RETURN_IF_ERROR(AppendSchemaLine(line_indent, dict.object, dict.key,
+                                         dict.value, schema_triple_map, res));
+      }
     }
   }
   const std::vector<DataBagPtr>& fallbacks = db->GetFallbacks();
@@ -219,7 +379,9 @@ absl::StatusOr<std::string> DataBagToStrInternal(
         std::string content,
         DataBagToStrInternal(
             fallbacks.at(i), seen_db,
-            {.indentation = format_opt.indentation + 1, .fallback_index = i}));
+            {.indentation = format_opt.indentation + 1,
+             .fallback_index = i,
+             .triple_limit = format_opt.triple_limit}));
     absl::StrAppend(&res, sep, content);
     sep = "\n";
   }
@@ -238,10 +400,13 @@ void UpdateCountMap(const typename Map::key_type& val, Map& count_dict) {
 
 }  // namespace
 
-absl::StatusOr<std::string> DataBagToStr(const DataBagPtr& db) {
+absl::StatusOr<std::string> DataBagToStr(const DataBagPtr& db,
+                                         const DataBagReprOption& option) {
   absl::flat_hash_set<const DataBag*> seen_db;
   ASSIGN_OR_RETURN(std::string res,
-                   DataBagToStrInternal(db, seen_db, {.indentation = 0}));
+                   DataBagToStrInternal(db, seen_db,
+                                        {.indentation = 0,
+                                         .triple_limit = option.triple_limit}));
   return res;
 }
 
@@ -23,8 +23,18 @@
 
 namespace koladata {
 
+struct DataBagReprOption {
+  // The maximum number of triples to show for the data and for the schemas of
+  // each DataBag, counting each list item as a triple. When set, the triples
+  // are printed in the storage order instead of being sorted, so that only the
+  // printed ones are visited, and the rest is replaced by "...". Negative
+  // means no limit.
+  int64_t triple_limit = -1;
+};
+
 // Returns the string representation of DataBag.
-absl::StatusOr<std::string> DataBagToStr(const DataBagPtr& db);
+absl::StatusOr<std::string> DataBagToStr(
+    const DataBagPtr& db, const DataBagReprOption& option = {});
 
 // Returns the stats string about the triples and attributes in the DataBag.
 //
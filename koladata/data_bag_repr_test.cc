@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <optional>
 #include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -395,5 +396,44 @@ TEST(DataBagReprTest, TestDataBagStatistics_List) {
               R"regex(DataBag \$[0-9a-f]{4} with 3 values in 1 attrs, plus 1 schema values and 0 fallbacks\. Top attrs:(.|\n)*)regex"),
           MatchesRegex(R"regex((.|\n)*<list items>: 3 values(.|\n)*)regex"))));
 }
+
+TEST(DataBagReprTest, TestDataBagStringRepresentation_TripleLimit) {
+  DataBagPtr bag = DataBag::Empty();
+  ASSERT_OK(EntityCreator::FromAttrs(
+      bag, {"a", "b", "c"}, std::vector<DataSlice>(3, test::DataItem(1))));
+
+  EXPECT_THAT(DataBagToStr(bag, {.triple_limit = 2}),
+              IsOkAndHolds(MatchesRegex(R"regex(DataBag \$[0-9a-f]{4}:
+\$[0-9a-f]{32}:0\.a => 1
+\$[0-9a-f]{32}:0\.b => 1
+\.\.\.
+
+SchemaBag:
+(\$[0-9a-f]{32}:0\.[abc] => INT32
+){2}\.\.\.
+)regex")));
+  EXPECT_THAT(DataBagToStr(bag, {.triple_limit = 3}),
+              IsOkAndHolds(MatchesRegex(R"regex(DataBag \$[0-9a-f]{4}:
+(\$[0-9a-f]{32}:0\.[abc] => 1
+){3}
+SchemaBag:
+(\$[0-9a-f]{32}:0\.[abc] => INT32
+){3})regex")));
+}
+
+TEST(DataBagReprTest, TestDataBagStringRepresentation_TripleLimitInList) {
+  DataBagPtr bag = DataBag::Empty();
+  ASSERT_OK(CreateListShaped(bag, DataSlice::JaggedShape::Empty(),
+                             test::DataSlice<int>({1, 2, 3, 4, 5, 6})));
+
+  EXPECT_THAT(DataBagToStr(bag, {.triple_limit = 3}),
+              IsOkAndHolds(MatchesRegex(R"regex(DataBag \$[0-9a-f]{4}:
+\$[0-9a-f]{32}:0\[:\] => \[1, 2, 3, \.\.\.\]
+\.\.\.
+
+SchemaBag:
+(.|\n)*)regex")));
+}
+
 }  // namespace
 }  // namespace koladata
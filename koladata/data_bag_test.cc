@@ -14,6 +14,7 @@
 //
 #include "koladata/data_bag.h"
 
+#include <optional>
 #include <string>
 #include <utility>
 
@@ -22,6 +23,8 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "koladata/internal/data_bag.h"
+#include "koladata/internal/dense_source.h"
+#include "koladata/internal/object_id.h"
 #include "koladata/object_factories.h"
 #include "koladata/test_utils.h"
 #include "koladata/testing/matchers.h"
@@ -33,9 +36,11 @@ namespace {
 using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
 using ::koladata::testing::IsEquivalentTo;
+using ::testing::AllOf;
 using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 using ::testing::MatchesRegex;
+using ::testing::Ne;
 
 TEST(DataBagTest, Fallbacks) {
   auto db = DataBag::Empty();
@@ -131,6 +136,108 @@ TEST(DataBagTest, CollectFlattenFallbacks) {
   }
 }
 
+TEST(DataBagTest, CollectFlattenFallbacksCached) {
+  auto db = DataBag::Empty();
+  ASSERT_OK(EntityCreator::FromAttrs(db, {std::string("a")},
+                                     {test::DataItem(1)}));
+  auto db_fb = DataBag::Empty();
+  ASSERT_OK(EntityCreator::FromAttrs(db_fb, {std::string("a")},
+                                     {test::DataItem(2)}));
+  auto frozen_db = DataBag::Empty();
+  ASSERT_OK(EntityCreator::FromAttrs(frozen_db, {std::string("a")},
+                                     {test::DataItem(3)}));
+  frozen_db = std::move(*frozen_db).ToImmutable();
+  auto frozen_db_fb = DataBag::Empty();
+  ASSERT_OK(EntityCreator::FromAttrs(frozen_db_fb, {std::string("a")},
+                                     {test::DataItem(4)}));
+  frozen_db_fb = std::move(*frozen_db_fb).ToImmutable();
+
+  {  // Mutable fallback: not cached, empty bags are kept.
+    auto empty_fb = DataBag::ImmutableEmptyWithFallbacks({db_fb});
+    auto new_db = DataBag::ImmutableEmptyWithFallbacks({db, empty_fb});
+    FlattenFallbackFinder fbf(*new_db);
+    EXPECT_THAT(fbf.GetFlattenFallbacks(),
+                ElementsAre(&db->GetImpl(), &empty_fb->GetImpl(),
+                            &db_fb->GetImpl()));
+  }
+  {  // All immutable: cached, empty bags are skipped.
+    auto empty_fb = DataBag::ImmutableEmptyWithFallbacks({frozen_db_fb});
+    auto new_db =
+        DataBag::ImmutableEmptyWithFallbacks({frozen_db, empty_fb});
+    FlattenFallbackFinder fbf(*new_db);
+    EXPECT_THAT(fbf.GetFlattenFallbacks(),
+                ElementsAre(&frozen_db->GetImpl(), &frozen_db_fb->GetImpl()));
+    FlattenFallbackFinder fbf2(*new_db);
+    EXPECT_EQ(fbf2.GetFlattenFallbacks().data(),
+              fbf.GetFlattenFallbacks().data());
+  }
+}
+
+TEST(DataBagTest, GetMergedAttrSource) {
+  auto db1 = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      auto ds1, EntityCreator::FromAttrs(
+                    db1, {std::string("a")},
+                    {test::DataSlice<int>({1, std::nullopt, 3}, db1)}));
+  ASSERT_OK_AND_ASSIGN(auto db2, db1->Fork());
+  ASSERT_OK(
+      ds1.WithDb(db2).SetAttr("a", test::DataSlice<int>({10, 20, 30}, db2)));
+  ASSERT_OK_AND_ASSIGN(auto frozen_db1, db1->Fork(/*immutable=*/true));
+  ASSERT_OK_AND_ASSIGN(auto frozen_db2, db2->Fork(/*immutable=*/true));
+  ASSERT_EQ(ds1.slice().allocation_ids().size(), 1);
+  internal::AllocationId alloc = ds1.slice().allocation_ids().ids()[0];
+
+  auto db = DataBag::ImmutableEmptyWithFallbacks({frozen_db1, frozen_db2});
+  ASSERT_OK_AND_ASSIGN(const internal::DenseSource* source,
+                       db->GetMergedAttrSource(alloc, "a"));
+  ASSERT_NE(source, nullptr);
+  EXPECT_THAT(db->GetMergedAttrSource(alloc, "a"), IsOkAndHolds(source));
+  EXPECT_THAT(db->GetMergedAttrSource(alloc, "b"), IsOkAndHolds(nullptr));
+  EXPECT_THAT(ds1.WithDb(db).GetAttr("a"),
+              IsOkAndHolds(IsEquivalentTo(
+                  test::DataSlice<int>({1, 20, 3}, db))));
+  EXPECT_THAT(ds1.WithDb(db).GetAttr("b"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("the attribute 'b' is missing")));
+
+  // No merged view with a mutable fallback, same result.
+  auto mutable_fb_db = DataBag::ImmutableEmptyWithFallbacks({frozen_db1, db2});
+  EXPECT_THAT(mutable_fb_db->GetMergedAttrSource(alloc, "a"),
+              IsOkAndHolds(nullptr));
+  EXPECT_THAT(ds1.WithDb(mutable_fb_db).GetAttr("a"),
+              IsOkAndHolds(IsEquivalentTo(
+                  test::DataSlice<int>({1, 20, 3}, mutable_fb_db))));
+}
+
+TEST(DataBagTest, ContentFingerprint) {
+  auto db = DataBag::Empty();
+  ASSERT_OK(EntityCreator::FromAttrs(db, {std::string("a")},
+                                     {test::DataItem(1)}));
+  EXPECT_THAT(db->ContentFingerprint(),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("only supported for immutable DataBags")));
+  ASSERT_OK_AND_ASSIGN(auto frozen_db1, db->Fork(/*immutable=*/true));
+  ASSERT_OK_AND_ASSIGN(auto frozen_db2, db->Fork(/*immutable=*/true));
+  EXPECT_NE(frozen_db1->fingerprint(), frozen_db2->fingerprint());
+  ASSERT_OK_AND_ASSIGN(auto fingerprint, frozen_db1->ContentFingerprint());
+  EXPECT_THAT(frozen_db2->ContentFingerprint(), IsOkAndHolds(fingerprint));
+  EXPECT_THAT(
+      DataBag::ImmutableEmptyWithFallbacks({frozen_db1})->ContentFingerprint(),
+      IsOkAndHolds(fingerprint));
+  EXPECT_THAT(DataBag::ImmutableEmptyWithFallbacks({db})->ContentFingerprint(),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+
+  ASSERT_OK(EntityCreator::FromAttrs(db, {std::string("a")},
+                                     {test::DataItem(2)}));
+  ASSERT_OK_AND_ASSIGN(auto frozen_db3, db->Fork(/*immutable=*/true));
+  ASSERT_OK_AND_ASSIGN(auto other_fingerprint,
+                       frozen_db3->ContentFingerprint());
+  EXPECT_NE(other_fingerprint, fingerprint);
+  EXPECT_THAT(DataBag::ImmutableEmptyWithFallbacks({frozen_db1, frozen_db3})
+                  ->ContentFingerprint(),
+              IsOkAndHolds(AllOf(Ne(fingerprint), Ne(other_fingerprint))));
+}
+
 TEST(DataBagTest, MergeInplace) {
   auto db_1 = DataBag::Empty();
   auto db_2 = DataBag::Empty();
@@ -23,8 +23,10 @@
 #include <type_traits>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/functional/overload.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
@@ -41,9 +43,11 @@
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/dense_source.h"
 #include "koladata/internal/dtype.h"
 #include "koladata/internal/error.pb.h"
 #include "koladata/internal/error_utils.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/missing_value.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/op_utils/expand.h"
@@ -51,8 +55,10 @@
 #include "koladata/internal/op_utils/presence_and.h"
 #include "koladata/internal/op_utils/presence_or.h"
 #include "koladata/internal/schema_utils.h"
+#include "koladata/internal/trusted_mode.h"
 #include "koladata/repr_utils.h"
 #include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
 #include "arolla/memory/optional_value.h"
 #include "arolla/qtype/qtype.h"
 #include "arolla/qtype/qtype_traits.h"
@@ -254,12 +260,22 @@ absl::StatusOr<DataSlice::AttrNamesSet> GetAttrsFromDataSlice(
     // Empty set.
     return DataSlice::AttrNamesSet();
   }
+  // Objects usually share a few schemas, so the attributes are fetched and
+  // intersected only once per distinct schema. Neighbouring objects often have
+  // the same schema, which is checked before the hash set.
+  absl::flat_hash_set<internal::ObjectId> seen_schemas;
+  std::optional<internal::ObjectId> last_schema;
   RETURN_IF_ERROR(
       schemas->VisitValues([&]<class T>(const arolla::DenseArray<T>& array) {
         absl::Status status = absl::OkStatus();
         if constexpr (std::is_same_v<T, internal::ObjectId>) {
           array.ForEachPresent([&](int64_t id, T schema_item) {
-            if (!status.ok() || (result && result->empty())) {
+            if (!status.ok() || (result && result->empty()) ||
+                last_schema == schema_item) {
+              return;
+            }
+            last_schema = schema_item;
+            if (!seen_schemas.insert(schema_item).second) {
               return;
             }
             auto attrs_or = GetAttrsFromSchemaItem(
@@ -350,6 +366,38 @@ absl::StatusOr<internal::DataItem> GetResultSchema(
   return UnwrapIfNoFollowSchema(res_schema);
 }
 
+// Same as GetResultSchema, but for entity schemas of DataBags that have an
+// AttrSchemaCache (i.e. that are immutable), the result is cached per
+// (schema, attr_name) pair, so that repeated lookups are a hash probe.
+template <typename ImplT>
+absl::StatusOr<internal::DataItem> GetResultSchemaWithCache(
+    const DataBag& db, const ImplT& impl, const internal::DataItem& schema,
+    absl::string_view attr_name, internal::DataBagImpl::FallbackSpan fallbacks,
+    bool allow_missing) {
+  DataBag::AttrSchemaCache* cache =
+      schema.holds_value<internal::ObjectId>() ? db.GetAttrSchemaCache()
+                                               : nullptr;
+  if (cache == nullptr) {
+    return GetResultSchema(db.GetImpl(), impl, schema, attr_name, fallbacks,
+                           allow_missing);
+  }
+  const internal::ObjectId schema_id = schema.value<internal::ObjectId>();
+  std::optional<internal::DataItem> res_schema =
+      cache->Lookup(schema_id, attr_name);
+  if (!res_schema.has_value()) {
+    ASSIGN_OR_RETURN(res_schema,
+                     GetResultSchema(db.GetImpl(), impl, schema, attr_name,
+                                     fallbacks, /*allow_missing=*/true));
+    cache->Insert(schema_id, attr_name, *res_schema);
+  }
+  if (!res_schema->has_value() && !allow_missing) {
+    // Produces the error for the missing attribute.
+    return GetResultSchema(db.GetImpl(), impl, schema, attr_name, fallbacks,
+                           /*allow_missing=*/false);
+  }
+  return *std::move(res_schema);
+}
+
 // Calls DataBagImpl::GetAttr on the specific implementation (DataSliceImpl or
 // DataItem). Returns DataSliceImpl / DataItem data and fills `res_schema` with
 // schema of the resulting DataSlice as side output.
@@ -383,9 +431,37 @@ absl::StatusOr<ImplT> GetAttrImpl(const std::shared_ptr<DataBag>& db,
   if (attr_name == schema::kSchemaAttr) {
     res_schema = internal::DataItem(schema::kSchema);
   } else {
-    ASSIGN_OR_RETURN(
-        res_schema, GetResultSchema(db_impl, impl, schema, attr_name, fallbacks,
-                                    allow_missing_schema));
+    ASSIGN_OR_RETURN(res_schema,
+                     GetResultSchemaWithCache(*db, impl, schema, attr_name,
+                                              fallbacks, allow_missing_schema));
+  }
+  if (!fallbacks.empty() && !db->IsMutable()) {
+    // Objects from a single allocation can be looked up in the merged view of
+    // the fallbacks, if there is one.
+    std::optional<internal::AllocationId> alloc;
+    if constexpr (std::is_same_v<ImplT, internal::DataItem>) {
+      if (impl.template holds_value<internal::ObjectId>()) {
+        alloc =
+            internal::AllocationId(impl.template value<internal::ObjectId>());
+      }
+    } else {
+      if (impl.dtype() == arolla::GetQType<internal::ObjectId>() &&
+          impl.allocation_ids().size() == 1 &&
+          !impl.allocation_ids().contains_small_allocation_id()) {
+        alloc = impl.allocation_ids().ids()[0];
+      }
+    }
+    if (alloc.has_value()) {
+      ASSIGN_OR_RETURN(const internal::DenseSource* source,
+                       db->GetMergedAttrSource(*alloc, attr_name));
+      if (source != nullptr) {
+        if constexpr (std::is_same_v<ImplT, internal::DataItem>) {
+          return source->Get(impl.template value<internal::ObjectId>());
+        } else {
+          return source->Get(impl.template values<internal::ObjectId>());
+        }
+      }
+    }
   }
   return db_impl.GetAttr(impl, attr_name, fallbacks);
 }
@@ -476,6 +552,15 @@ class RhsHandler {
       const internal::DataItem& lhs_schema, DataBagImplT& db_impl,
       internal::DataBagImpl::FallbackSpan fallbacks,
       bool update_schema = false) {
+    if (internal::IsTrustedMode() &&
+        lhs_schema.holds_value<internal::ObjectId>()) {
+      if (lhs_schema.value<internal::ObjectId>().IsImplicitSchema() ||
+          update_schema) {
+        return SetImplicitSchemaAttr(lhs_schema, db_impl);
+      }
+      DCHECK_OK(VerifyTrustedSchema(lhs_schema, db_impl, fallbacks));
+      return absl::OkStatus();
+    }
     ASSIGN_OR_RETURN(
         auto attr_stored_schema,
         db_impl.GetSchemaAttrAllowMissing(lhs_schema, attr_name_, fallbacks));
@@ -510,6 +595,33 @@ class RhsHandler {
   absl::Status ProcessSchemaObjectAttr(
       const internal::DataSliceImpl& lhs_schema, DataBagImplT& db_impl,
       internal::DataBagImpl::FallbackSpan fallbacks) {
+    if (internal::IsTrustedMode() &&
+        lhs_schema.dtype() == arolla::GetQType<internal::ObjectId>()) {
+      const auto& schema_ids = lhs_schema.values<internal::ObjectId>();
+      // Only the IMPLICIT schemas are updated: EXPLICIT ones keep their
+      // stored schema (e.g. ANY, which VerifyTrustedSchema accepts).
+      arolla::DenseArrayBuilder<internal::ObjectId> implicit_bldr(
+          schema_ids.size());
+      int64_t implicit_count = 0;
+      schema_ids.ForEachPresent([&](int64_t id, internal::ObjectId schema_id) {
+        if (schema_id.IsImplicitSchema()) {
+          implicit_bldr.Set(id, schema_id);
+          ++implicit_count;
+        }
+      });
+      DCHECK_OK(VerifyTrustedSchema(lhs_schema, db_impl, fallbacks));
+      if (implicit_count == 0) {
+        return absl::OkStatus();
+      }
+      if (implicit_count == schema_ids.PresentCount()) {
+        return SetImplicitSchemaAttr(lhs_schema, db_impl);
+      }
+      return SetImplicitSchemaAttr(
+          internal::DataSliceImpl::CreateObjectsDataSlice(
+              std::move(implicit_bldr).Build(),
+              lhs_schema.allocation_ids()),
+          db_impl);
+    }
     ASSIGN_OR_RETURN(
         auto attr_stored_schemas,
         db_impl.GetSchemaAttrAllowMissing(lhs_schema, attr_name_, fallbacks));
@@ -546,7 +658,7 @@ class RhsHandler {
           if (cast_to.has_value() && *cast_to != attr_stored_schema) {
             // NOTE: If cast_to and attr_stored_schema are different, but
             // compatible, we are still returning an error.
-            status = internal::WithErrorPayload(
+            status = internal::WithLazyErrorPayload(
                 absl::InvalidArgumentError(absl::StrFormat(
                     "Assignment would require to cast values to two different "
                     "types: %v and %v",
@@ -575,6 +687,57 @@ class RhsHandler {
     return absl::OkStatus();
   }
 
+  // Trusted mode replacement for the lookup of the stored schemas: sets the
+  // `attr_name_` attribute of `lhs_schema` to the schema of `rhs_`.
+  template <typename SchemaT>
+  absl::Status SetImplicitSchemaAttr(const SchemaT& lhs_schema,
+                                     DataBagImplT& db_impl) {
+    if constexpr (is_readonly) {
+      return absl::InternalError(
+          "cannot deal with implicit schemas on readonly databag");
+    } else {
+      return db_impl.SetSchemaAttr(lhs_schema, attr_name_,
+                                   rhs_.GetSchemaImpl());
+    }
+  }
+
+  // Returns an error if `rhs_` would have to be cast to the stored schema of
+  // `attr_name_` of an EXPLICIT schema in `lhs_schema`, which trusted mode
+  // assumes never happens. Only used in debug builds.
+  template <typename SchemaT>
+  absl::Status VerifyTrustedSchema(
+      const SchemaT& lhs_schema, const DataBagImplT& db_impl,
+      internal::DataBagImpl::FallbackSpan fallbacks) const {
+    ASSIGN_OR_RETURN(
+        auto attr_stored_schemas,
+        db_impl.GetSchemaAttrAllowMissing(lhs_schema, attr_name_, fallbacks));
+    auto verify = [&](internal::ObjectId schema_id,
+                      const internal::DataItem& attr_stored_schema) {
+      if (schema_id.IsImplicitSchema() ||
+          attr_stored_schema == rhs_.GetSchemaImpl() ||
+          attr_stored_schema == schema::kAny) {
+        return absl::OkStatus();
+      }
+      return absl::FailedPreconditionError(absl::StrFormat(
+          "trusted mode: the values assigned to '%s' have schema %v, but %v "
+          "is stored",
+          attr_name_, rhs_.GetSchemaImpl(), attr_stored_schema));
+    };
+    if constexpr (std::is_same_v<SchemaT, internal::DataItem>) {
+      return verify(lhs_schema.template value<internal::ObjectId>(),
+                    attr_stored_schemas);
+    } else {
+      absl::Status status = absl::OkStatus();
+      lhs_schema.template values<internal::ObjectId>().ForEachPresent(
+          [&](int64_t id, internal::ObjectId schema_id) {
+            if (status.ok()) {
+              status = verify(schema_id, attr_stored_schemas[id]);
+            }
+          });
+      return status;
+    }
+  }
+
   // NOTE: Explicit Entity -> Object casting is allowed to simplify the
   // lives for new users not familiar with the intricacies of entities vs
   // objects. All other casts are implicit-only following the rules in
@@ -638,21 +801,29 @@ class RhsHandler {
             dict_attr, attr_stored_schema, rhs_.GetSchemaImpl()));
         break;
     }
-    return WithErrorPayload(status,
-                            MakeIncompatibleSchemaError(attr_stored_schema));
+    return internal::WithLazyErrorPayload(
+        status, MakeIncompatibleSchemaError(attr_stored_schema));
   }
 
-  absl::StatusOr<internal::Error> MakeIncompatibleSchemaError(
+  // Returns the incompatible_schema payload function for
+  // WithLazyErrorPayload. It owns copies of its inputs, as it may be called
+  // long after the RhsHandler is gone.
+  internal::ErrorPayloadFn MakeIncompatibleSchemaError(
       const internal::DataItem& attr_stored_schema) const {
-    internal::Error error;
-    internal::IncompatibleSchema* incompatible_schema =
-        error.mutable_incompatible_schema();
-    incompatible_schema->set_attr(attr_name_);
-    ASSIGN_OR_RETURN(*incompatible_schema->mutable_expected_schema(),
-                     internal::EncodeDataItem(attr_stored_schema));
-    ASSIGN_OR_RETURN(*incompatible_schema->mutable_assigned_schema(),
-                     internal::EncodeDataItem(rhs_.GetSchemaImpl()));
-    return error;
+    return [attr_name = std::string(attr_name_),
+            expected_schema = attr_stored_schema,
+            assigned_schema =
+                rhs_.GetSchemaImpl()]() -> absl::StatusOr<internal::Error> {
+      internal::Error error;
+      internal::IncompatibleSchema* incompatible_schema =
+          error.mutable_incompatible_schema();
+      incompatible_schema->set_attr(attr_name);
+      ASSIGN_OR_RETURN(*incompatible_schema->mutable_expected_schema(),
+                       internal::EncodeDataItem(expected_schema));
+      ASSIGN_OR_RETURN(*incompatible_schema->mutable_assigned_schema(),
+                       internal::EncodeDataItem(assigned_schema));
+      return error;
+    };
   }
 
   RhsHandlerErrorContext error_context_;
@@ -803,6 +974,11 @@ absl::StatusOr<DataSlice> DataSlice::Create(
 
 absl::StatusOr<DataSlice> DataSlice::Reshape(
     DataSlice::JaggedShape shape) const {
+  // Keeping the current shape lets later comparisons with shapes derived from
+  // it skip the element-wise checks of the edges.
+  if (ShapesAreEquivalent(shape, GetShape())) {
+    return *this;
+  }
   return VisitImpl([&](const auto& impl) {
     return DataSlice::Create(impl, std::move(shape), GetSchemaImpl(), GetDb());
   });
@@ -969,19 +1145,58 @@ absl::StatusOr<DataSlice> DataSlice::ForkDb() const {
                    std::move(forked_db));
 }
 
-absl::StatusOr<DataSlice> DataSlice::Freeze() const {
-  ASSIGN_OR_RETURN(auto frozen_db, GetDb()->Fork(/*immutable=*/true));
+absl::StatusOr<DataSlice> DataSlice::Freeze(bool optimize) const {
+  DataBagPtr frozen_db;
+  if (optimize) {
+    ASSIGN_OR_RETURN(frozen_db, GetDb()->FreezeOptimized());
+  } else {
+    ASSIGN_OR_RETURN(frozen_db, GetDb()->Fork(/*immutable=*/true));
+  }
   return DataSlice(internal_->impl, GetShape(), GetSchemaImpl(),
                    std::move(frozen_db));
 }
 
+bool EdgesShareValues(const DataSlice::JaggedShape::Edge& a,
+                      const DataSlice::JaggedShape::Edge& b) {
+  const arolla::DenseArray<int64_t>& values_a = a.edge_values();
+  const arolla::DenseArray<int64_t>& values_b = b.edge_values();
+  return a.edge_type() == b.edge_type() &&
+         a.parent_size() == b.parent_size() &&
+         values_a.size() == values_b.size() &&
+         values_a.values.span().data() == values_b.values.span().data() &&
+         values_a.bitmap.span().data() == values_b.bitmap.span().data() &&
+         values_a.bitmap_bit_offset == values_b.bitmap_bit_offset;
+}
+
+bool ShapesAreEquivalent(const DataSlice::JaggedShape& a,
+                         const DataSlice::JaggedShape& b) {
+  return a.rank() == b.rank() && ShapeIsBroadcastableTo(a, b);
+}
+
+bool ShapeIsBroadcastableTo(const DataSlice::JaggedShape& from,
+                            const DataSlice::JaggedShape& to) {
+  if (from.rank() > to.rank()) {
+    return false;
+  }
+  for (size_t i = 0; i < from.rank(); ++i) {
+    const DataSlice::JaggedShape::Edge& edge_from = from.edges()[i];
+    const DataSlice::JaggedShape::Edge& edge_to = to.edges()[i];
+    if (!EdgesShareValues(edge_from, edge_to) &&
+        !edge_from.IsEquivalentTo(edge_to)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 bool DataSlice::IsEquivalentTo(const DataSlice& other) const {
   if (this == &other || internal_ == other.internal_) {
     return true;
   }
-  if (GetDb() != other.GetDb() ||
-      !GetShape().IsEquivalentTo(other.GetShape()) ||
-      GetSchemaImpl() != other.GetSchemaImpl() ||
+  // The cheap checks go first, so that the values are only compared if
+  // everything else matches.
+  if (GetDb() != other.GetDb() || GetSchemaImpl() != other.GetSchemaImpl() ||
+      !ShapesAreEquivalent(GetShape(), other.GetShape()) ||
       !VisitImpl([&]<class T>(const T& impl) {
         return impl.IsEquivalentTo(other.impl<T>());
       })) {
@@ -1028,6 +1243,73 @@ absl::StatusOr<DataSlice> DataSlice::GetAttr(
   });
 }
 
+absl::StatusOr<std::vector<DataSlice>> DataSlice::GetAttrs(
+    absl::Span<const absl::string_view> attr_names) const {
+  return VisitImpl(
+      [&]<class T>(const T& impl) -> absl::StatusOr<std::vector<DataSlice>> {
+        const auto& db = GetDb();
+        const auto& schema = GetSchemaImpl();
+        if (db == nullptr) {
+          return AssembleErrorMessage(
+              absl::InvalidArgumentError(
+                  "cannot fetch attributes without a DataBag"),
+              {.ds = *this});
+        }
+        if (schema.is_primitive_schema()) {
+          return AssembleErrorMessage(
+              absl::InvalidArgumentError(
+                  "getting attributes from primitive values is not supported"),
+              {.ds = *this});
+        }
+        if (schema == schema::kSchema) {
+          // Schema attributes are stored in dicts, there is nothing to batch.
+          std::vector<DataSlice> results;
+          results.reserve(attr_names.size());
+          for (absl::string_view attr_name : attr_names) {
+            ASSIGN_OR_RETURN(results.emplace_back(), GetAttr(attr_name));
+          }
+          return results;
+        }
+        const auto& db_impl = db->GetImpl();
+        FlattenFallbackFinder fb_finder(*db);
+        auto fallbacks = fb_finder.GetFlattenFallbacks();
+        std::vector<internal::DataItem> res_schemas;
+        res_schemas.reserve(attr_names.size());
+        for (absl::string_view attr_name : attr_names) {
+          if (attr_name == schema::kSchemaAttr) {
+            res_schemas.emplace_back(schema::kSchema);
+            continue;
+          }
+          ASSIGN_OR_RETURN(
+              res_schemas.emplace_back(),
+              GetResultSchemaWithCache(*db, impl, schema, attr_name, fallbacks,
+                                       /*allow_missing=*/false),
+              AssembleErrorMessage(_, {.ds = *this}));
+          RETURN_IF_ERROR(AssertIsSliceSchema(res_schemas.back()));
+        }
+        std::vector<T> values;
+        if constexpr (std::is_same_v<T, internal::DataSliceImpl>) {
+          ASSIGN_OR_RETURN(values,
+                           db_impl.GetAttrs(impl, attr_names, fallbacks),
+                           AssembleErrorMessage(_, {.ds = *this}));
+        } else {
+          values.reserve(attr_names.size());
+          for (absl::string_view attr_name : attr_names) {
+            ASSIGN_OR_RETURN(values.emplace_back(),
+                             db_impl.GetAttr(impl, attr_name, fallbacks),
+                             AssembleErrorMessage(_, {.ds = *this}));
+          }
+        }
+        std::vector<DataSlice> results;
+        results.reserve(attr_names.size());
+        for (size_t i = 0; i < attr_names.size(); ++i) {
+          results.push_back(DataSlice(std::move(values[i]), GetShape(),
+                                      std::move(res_schemas[i]), db));
+        }
+        return results;
+      });
+}
+
 absl::StatusOr<DataSlice> DataSlice::GetAttrWithDefault(
     absl::string_view attr_name, const DataSlice& default_value) const {
   ASSIGN_OR_RETURN(auto expanded_default,
@@ -1518,7 +1800,7 @@ absl::Status DataSlice::AppendToList(const DataSlice& values) const {
         "cannot append items to list without a DataBag");
   }
   const JaggedShape& shape = MaxRankShape(GetShape(), values.GetShape());
-  if (!GetShape().IsBroadcastableTo(shape)) {
+  if (!ShapeIsBroadcastableTo(GetShape(), shape)) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "Lists DataSlice with shape=%s is not compatible with values shape=%s",
         arolla::Repr(GetShape()), arolla::Repr(shape)));
@@ -1618,7 +1900,7 @@ absl::Status DataSlice::ReplaceInList(int64_t start,
         "foo[1:3] = bar[:]",
         rank, values_rank, rank + 1));
   }
-  if (!GetShape().IsBroadcastableTo(values.GetShape())) {
+  if (!ShapeIsBroadcastableTo(GetShape(), values.GetShape())) {
     return BroadcastToShape(*this, values.GetShape()).status();
   }
 
@@ -1667,8 +1949,10 @@ absl::Status DataSlice::RemoveInList(const DataSlice& indices) const {
     }
     return db_mutable_impl.RemoveInList(expanded_this.item(), range);
   } else {
+    std::shared_ptr<internal::Executor> executor = internal::CurrentExecutor();
     return db_mutable_impl.RemoveInList(
-        expanded_this.slice(), expanded_indices.slice().values<int64_t>());
+        expanded_this.slice(), expanded_indices.slice().values<int64_t>(),
+        {.executor = executor.get()});
   }
 }
 
@@ -22,6 +22,7 @@
 #include <type_traits>
 #include <utility>
 #include <variant>
+#include <vector>
 
 #include "absl/base/nullability.h"
 #include "absl/base/optimization.h"
@@ -213,8 +214,10 @@ class DataSlice {
   absl::StatusOr<DataSlice> ForkDb() const;
 
   // Returns a new DataSlice with frozen copy of a DataBag. Mutations are NOT
-  // allowed on the returned value.
-  absl::StatusOr<DataSlice> Freeze() const;
+  // allowed on the returned value. If `optimize` is true, the DataBag is
+  // converted into the layout that is the fastest to read (see
+  // DataBag::FreezeOptimized), which takes time proportional to its size.
+  absl::StatusOr<DataSlice> Freeze(bool optimize = false) const;
 
   // Returns true iff `other` represents the same DataSlice with same data
   // contents as well as members (db, schema, shape).
@@ -229,6 +232,12 @@ class DataSlice {
   // missing or invalid attribute requests.
   absl::StatusOr<DataSlice> GetAttr(absl::string_view attr_name) const;
 
+  // Returns the attributes `attr_names` of this Object, in the same order.
+  // Equivalent to calling GetAttr for every name, but the DataBag fallbacks
+  // are resolved once and the objects are validated once.
+  absl::StatusOr<std::vector<DataSlice>> GetAttrs(
+      absl::Span<const absl::string_view> attr_names) const;
+
   // Returns a new DataSlice with a reference to the same DataBag. Missing
   // values are filled with `default_value`. This also allows fetching an
   // attribute that does not exist. Returns an error in case of missing DataBag.
@@ -505,6 +514,23 @@ class DataSlice {
   arolla::RefcountPtr<Internal> internal_;
 };
 
+// Returns true if the edges share their edge values, in which case they are
+// equivalent without comparing the values. This is the case for the edges of
+// shapes derived from each other, e.g. by broadcasting or by passing the shape
+// of one slice to another.
+bool EdgesShareValues(const DataSlice::JaggedShape::Edge& a,
+                      const DataSlice::JaggedShape::Edge& b);
+
+// Same as `a.IsEquivalentTo(b)`, but the edges sharing their values are not
+// compared element-wise.
+bool ShapesAreEquivalent(const DataSlice::JaggedShape& a,
+                         const DataSlice::JaggedShape& b);
+
+// Same as `from.IsBroadcastableTo(to)`, but the edges sharing their values are
+// not compared element-wise.
+bool ShapeIsBroadcastableTo(const DataSlice::JaggedShape& from,
+                            const DataSlice::JaggedShape& to);
+
 namespace internal_broadcast {
 
 absl::StatusOr<DataSlice> BroadcastToShapeSlow(const DataSlice& slice,
@@ -516,7 +542,7 @@ absl::StatusOr<DataSlice> BroadcastToShapeSlow(const DataSlice& slice,
 // error is returned.
 inline absl::StatusOr<DataSlice> BroadcastToShape(
     DataSlice slice, DataSlice::JaggedShape shape) {
-  if (ABSL_PREDICT_FALSE(!slice.GetShape().IsBroadcastableTo(shape))) {
+  if (ABSL_PREDICT_FALSE(!ShapeIsBroadcastableTo(slice.GetShape(), shape))) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "DataSlice with shape=%s cannot be expanded to shape=%s",
         arolla::Repr(slice.GetShape()), arolla::Repr(shape)));
@@ -41,7 +41,6 @@
 #include "koladata/internal/schema_utils.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/edge.h"
-#include "arolla/memory/optional_value.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata {
@@ -90,89 +89,69 @@ std::string PrettyFormatStr(const std::vector<std::string>& parts,
   return absl::StrCat(joined_parts, suffix);
 }
 
-// Returns the string representation of the element in each edge group.
-absl::StatusOr<std::vector<std::string>> StringifyGroup(
-    const arolla::DenseArrayEdge& edge, const std::vector<std::string>& parts,
-    int64_t item_limit) {
-  std::vector<std::string> result;
-  result.reserve(edge.child_size());
-  const arolla::DenseArray<int64_t>& edge_values = edge.edge_values();
-  if (!edge_values.IsFull()) {
-    return absl::InternalError("Edge contains missing value.");
-  }
-  for (int64_t i = 0; i < edge_values.size() - 1; ++i) {
-    arolla::OptionalValue<int64_t> start = edge_values[i];
-    arolla::OptionalValue<int64_t> end = edge_values[i + 1];
-    std::vector<std::string> elements;
-    elements.reserve(end.value - start.value);
-    size_t item_count = 0;
-    for (int64_t offset = start.value; offset < end.value; ++offset) {
-      if (item_count >= item_limit) {
-        elements.emplace_back(kEllipsis);
-        break;
-      }
-      elements.emplace_back(parts[offset]);
-      ++item_count;
-    }
-    result.emplace_back(
-        PrettyFormatStr(elements, {.prefix = "[", .suffix = "]"}));
-  }
-  return result;
-}
-
 // Returns the string representation for the DataSlice. It requires the
 // DataSlice contains only DataItem.
 absl::StatusOr<std::string> DataItemToStr(const DataSlice& ds,
                                           const ReprOption& option);
 
-absl::StatusOr<std::vector<std::string>> StringifyByDimension(
-    const DataSlice& slice, int64_t dimension, const ReprOption& option) {
-  const internal::DataSliceImpl& slice_impl = slice.slice();
+// Returns the string representation of an item of a multi-dimensional
+// DataSlice with the given schema.
+std::string SliceItemToStr(const DataItem& item, const DataItem& schema) {
+  if (item.holds_value<ObjectId>()) {
+    absl::string_view item_prefix = "";
+    if (item.is_dict()) {
+      item_prefix = "Dict:";
+    } else if (item.is_list()) {
+      item_prefix = "List:";
+    } else if (schema == schema::kObject) {
+      item_prefix = "Obj:";
+    } else if (!item.is_schema()) {
+      item_prefix = "Entity:";
+    }
+    return absl::StrCat(item_prefix, DataItemRepr(item));
+  }
+  bool obj_or_any_schema = schema == schema::kObject || schema == schema::kAny;
+  return DataItemRepr(item, {.show_dtype = obj_or_any_schema});
+}
+
+// Returns the string representation of the `group`-th group of the
+// `dimension`-th edge of the slice shape. Only the first `item_limit` elements
+// of each group are visited, so the cost is bounded by the size of the output
+// rather than by the size of the slice.
+std::string StringifyGroup(const DataSlice& slice, size_t dimension,
+                           int64_t group, const ReprOption& option) {
   const absl::Span<const arolla::DenseArrayEdge> edges =
       slice.GetShape().edges();
-  const arolla::DenseArrayEdge& edge = edges[dimension];
-  const DataItem& schema = slice.GetSchemaImpl();
-  if (dimension == edges.size() - 1) {
-    // Turns each items in slice into a string.
-    std::vector<std::string> parts;
-    parts.reserve(slice.size());
-    bool obj_or_any_schema =
-        schema == schema::kObject || schema == schema::kAny;
-    for (const DataItem& item : slice_impl) {
-      if (item.holds_value<ObjectId>()) {
-        absl::string_view item_prefix = "";
-        if (item.is_dict()) {
-          item_prefix = "Dict:";
-        } else if (item.is_list()) {
-          item_prefix = "List:";
-        } else if (slice.GetSchemaImpl() == schema::kObject) {
-          item_prefix = "Obj:";
-        } else if (!item.is_schema()) {
-          item_prefix = "Entity:";
-        }
-        parts.push_back(absl::StrCat(item_prefix, DataItemRepr(item)));
-      } else {
-        parts.push_back(DataItemRepr(item, {.show_dtype = obj_or_any_schema}));
-      }
+  absl::Span<const int64_t> split_points =
+      edges[dimension].edge_values().values.span();
+  int64_t begin = split_points[group];
+  int64_t end = split_points[group + 1];
+  bool is_last_dimension = dimension + 1 == edges.size();
+  std::vector<std::string> elements;
+  elements.reserve(std::min<int64_t>(end - begin, option.item_limit) + 1);
+  for (int64_t offset = begin; offset < end; ++offset) {
+    if (elements.size() >= option.item_limit) {
+      elements.emplace_back(kEllipsis);
+      break;
     }
-    return StringifyGroup(edge, parts, option.item_limit);
+    elements.push_back(
+        is_last_dimension
+            ? SliceItemToStr(slice.slice()[offset], slice.GetSchemaImpl())
+            : StringifyGroup(slice, dimension + 1, offset, option));
   }
-  ASSIGN_OR_RETURN(std::vector<std::string> parts,
-                   StringifyByDimension(slice, dimension + 1,
-                                        {.depth = option.depth - 1,
-                                         .item_limit = option.item_limit}));
-  return StringifyGroup(edge, parts, option.item_limit);
+  return PrettyFormatStr(elements, {.prefix = "[", .suffix = "]"});
 }
 
 // Returns the string for python __str__ and part of __repr__.
 // The DataSlice must have at least 1 dimension.
-// TODO: do truncation when ds is too large.
 absl::StatusOr<std::string> DataSliceImplToStr(
     const DataSlice& ds, const ReprOption& option = ReprOption{}) {
-  ASSIGN_OR_RETURN(std::vector<std::string> parts,
-                   StringifyByDimension(ds, 0, option));
-  return PrettyFormatStr(
-      parts, {.prefix = "", .suffix = "", .enable_multiline = false});
+  for (const arolla::DenseArrayEdge& edge : ds.GetShape().edges()) {
+    if (!edge.edge_values().IsFull()) {
+      return absl::InternalError("Edge contains missing value.");
+    }
+  }
+  return StringifyGroup(ds, 0, 0, option);
 }
 
 // Returns the string representation of list schema. `schema` must be schema
@@ -219,7 +198,9 @@ absl::StatusOr<std::string> DictSchemaStr(const DataSlice& schema,
 // Returns the string representation of list item.
 absl::StatusOr<std::string> ListToStr(const DataSlice& ds,
                                       const ReprOption& option) {
-  ASSIGN_OR_RETURN(const DataSlice list, ds.ExplodeList(0, std::nullopt));
+  // One item more than the limit is enough to know whether to add an ellipsis.
+  ASSIGN_OR_RETURN(const DataSlice list,
+                   ds.ExplodeList(0, option.item_limit + 1));
 
   auto stringfy_list_items =
       [&option, &list](const internal::DataSliceImpl& list_impl)
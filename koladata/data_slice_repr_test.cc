@@ -836,5 +836,26 @@ TEST(DataSliceReprTest, ObjEntityExceedReprItemLimit) {
               IsOkAndHolds(StrEq("Entity(a=1, b=1, c=1, d=1, e=1, ...)")));
 }
 
+TEST(DataSliceReprTest, LargeSliceExceedReprItemLimit) {
+  std::vector<int64_t> values(1000000);
+  for (int64_t i = 0; i < values.size(); ++i) {
+    values[i] = i;
+  }
+  ASSERT_OK_AND_ASSIGN(DenseArrayEdge edge1, EdgeFromSplitPoints({0, 2}));
+  ASSERT_OK_AND_ASSIGN(DenseArrayEdge edge2,
+                       EdgeFromSplitPoints({0, 500000, 1000000}));
+  ASSERT_OK_AND_ASSIGN(
+      auto ds_shape,
+      JaggedDenseArrayShape::FromEdges({std::move(edge1), std::move(edge2)}));
+  ASSERT_OK_AND_ASSIGN(
+      DataSlice ds,
+      DataSlice::CreateWithSchemaFromData(
+          internal::DataSliceImpl::Create(arolla::CreateFullDenseArray(values)),
+          std::move(ds_shape)));
+
+  EXPECT_THAT(DataSliceToStr(ds, {.item_limit = 3}),
+              IsOkAndHolds("[[0, 1, 2, ...], [500000, 500001, 500002, ...]]"));
+}
+
 }  // namespace
 }  // namespace koladata
@@ -41,6 +41,7 @@
 #include "koladata/internal/missing_value.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/schema_utils.h"
+#include "koladata/internal/trusted_mode.h"
 #include "koladata/internal/testing/matchers.h"
 #include "koladata/object_factories.h"
 #include "koladata/test_utils.h"
@@ -80,6 +81,7 @@ using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
 using ::testing::Eq;
 using ::testing::HasSubstr;
+using ::testing::IsEmpty;
 using ::testing::MatchesRegex;
 using ::testing::Property;
 
@@ -368,6 +370,54 @@ TEST(DataSliceTest, Freeze) {
                        HasSubstr("DataBag is immutable")));
 }
 
+TEST(DataSliceTest, FreezeOptimized) {
+  auto db = DataBag::Empty();
+  auto ds_a = test::DataSlice<int>({1, 2});
+  ASSERT_OK_AND_ASSIGN(auto ds, EntityCreator::FromAttrs(db, {"a"}, {ds_a}));
+  auto ds_with_fallback =
+      ds.WithDb(DataBag::ImmutableEmptyWithFallbacks({db}));
+
+  ASSERT_OK_AND_ASSIGN(auto frozen_ds,
+                       ds_with_fallback.Freeze(/*optimize=*/true));
+  EXPECT_FALSE(frozen_ds.GetDb()->IsMutable());
+  EXPECT_THAT(frozen_ds.GetDb()->GetFallbacks(), IsEmpty());
+  EXPECT_EQ(frozen_ds.GetDb()->GetImpl().fork_depth(), 0);
+  EXPECT_THAT(frozen_ds.GetAttr("a"),
+              IsOkAndHolds(IsEquivalentTo(ds_a.WithDb(frozen_ds.GetDb()))));
+  EXPECT_THAT(frozen_ds.SetAttr("a", ds_a),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("DataBag is immutable")));
+}
+
+TEST(DataSliceTest, GetAttrSchemaCache) {
+  auto db = DataBag::Empty();
+  auto ds_a = test::DataSlice<int>({1, 2});
+  ASSERT_OK_AND_ASSIGN(auto ds, EntityCreator::FromAttrs(db, {"a"}, {ds_a}));
+  EXPECT_EQ(db->GetAttrSchemaCache(), nullptr);
+  EXPECT_EQ(DataBag::ImmutableEmptyWithFallbacks({db})->GetAttrSchemaCache(),
+            nullptr);
+
+  ASSERT_OK_AND_ASSIGN(auto frozen_ds, ds.Freeze());
+  auto* cache = frozen_ds.GetDb()->GetAttrSchemaCache();
+  ASSERT_NE(cache, nullptr);
+  ObjectId schema_id = frozen_ds.GetSchemaImpl().value<ObjectId>();
+  EXPECT_EQ(cache->Lookup(schema_id, "a"), std::nullopt);
+  // The second iteration is served from the cache.
+  for (int i = 0; i < 2; ++i) {
+    EXPECT_THAT(frozen_ds.GetAttr("a"),
+                IsOkAndHolds(AllOf(
+                    Property(&DataSlice::slice, ElementsAre(1, 2)),
+                    Property(&DataSlice::GetSchemaImpl, schema::kInt32))));
+    EXPECT_THAT(frozen_ds.GetAttr("b"),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("the attribute 'b' is missing")));
+    EXPECT_THAT(frozen_ds.GetAttrWithDefault("b", test::DataItem(0)),
+                IsOkAndHolds(Property(&DataSlice::slice, ElementsAre(0, 0))));
+  }
+  EXPECT_EQ(cache->Lookup(schema_id, "a"), DataItem(schema::kInt32));
+  EXPECT_EQ(cache->Lookup(schema_id, "b"), DataItem());
+}
+
 TEST(DataSliceTest, ForkErrors) {
   auto db = DataBag::Empty();
   auto ds_a = test::DataSlice<int>({1, 2});
@@ -959,6 +1009,25 @@ TEST(DataSliceTest, GetAttrNames_Object_AttrsAtIntersection) {
   EXPECT_THAT(ds.GetAttrNames(), IsOkAndHolds(ElementsAre("a", "b")));
 }
 
+TEST(DataSliceTest, GetAttrNames_Object_RepeatedSchemas) {
+  auto db = DataBag::Empty();
+  auto a = test::DataItem(1);
+  auto b = test::DataItem("a");
+  auto c = test::DataItem(3.14);
+  ASSERT_OK_AND_ASSIGN(
+      auto object_1,
+      ObjectCreator::FromAttrs(db, {"a", "b", "c"}, {a, b, c}));
+  ASSERT_OK_AND_ASSIGN(
+      auto object_2,
+      ObjectCreator::FromAttrs(db, {"a", "c", "d"}, {a, b, c}));
+  ObjectId id_1 = object_1.item().value<ObjectId>();
+  ObjectId id_2 = object_2.item().value<ObjectId>();
+  auto ds = test::DataSlice<ObjectId>(
+                {id_1, id_1, std::nullopt, id_2, id_1, id_2, id_2})
+                .WithDb(db);
+  EXPECT_THAT(ds.GetAttrNames(), IsOkAndHolds(ElementsAre("a", "c")));
+}
+
 TEST(DataSliceTest, GetAttrNames_Object_EmptyIntersection) {
   auto db = DataBag::Empty();
   auto a = test::DataItem(1);
@@ -1963,6 +2032,59 @@ TEST(DataSliceTest, SetAttrWithUpdateSchema_ObjectsWithExplicitSchema) {
   EXPECT_THAT(ds_a_get.slice(), ElementsAre(12, 42, 97));
 }
 
+TEST(DataSliceTest, SetAttr_TrustedMode) {
+  auto db = DataBag::Empty();
+  auto ds_primitive = test::DataSlice<int>({1, 2, 3});
+  ASSERT_OK_AND_ASSIGN(auto entity,
+                       EntityCreator::FromAttrs(db, {"a"}, {ds_primitive}));
+  ASSERT_OK_AND_ASSIGN(auto object,
+                       ObjectCreator::FromAttrs(db, {"a"}, {ds_primitive}));
+  auto ds_int64_primitive = test::DataSlice<int64_t>({12, 42, 97});
+
+  internal::ScopedTrustedMode trusted_mode;
+  // Explicit schemas: values with the stored schema are assigned as is.
+  ASSERT_OK(entity.SetAttr("a", test::DataSlice<int>({4, 5, 6})));
+  ASSERT_OK_AND_ASSIGN(auto entity_a, entity.GetAttr("a"));
+  EXPECT_EQ(entity_a.GetSchemaImpl(), schema::kInt32);
+  EXPECT_THAT(entity_a.slice(), ElementsAre(4, 5, 6));
+  ASSERT_OK(entity.SetAttrWithUpdateSchema("a", ds_int64_primitive));
+  ASSERT_OK_AND_ASSIGN(entity_a, entity.GetAttr("a"));
+  EXPECT_EQ(entity_a.GetSchemaImpl(), schema::kInt64);
+  EXPECT_THAT(entity_a.slice(), ElementsAre(12, 42, 97));
+
+  // Implicit schemas are still updated.
+  ASSERT_OK(object.SetAttr("a", ds_int64_primitive));
+  ASSERT_OK_AND_ASSIGN(auto object_a, object.GetAttr("a"));
+  EXPECT_EQ(object_a.GetSchemaImpl(), schema::kInt64);
+  EXPECT_THAT(object_a.slice(), ElementsAre(12, 42, 97));
+}
+
+TEST(DataSliceTest, SetAttr_TrustedMode_MixedSchemas) {
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      auto entity,
+      EntityCreator::FromAttrs(db, {"a"}, {test::DataItem(1, schema::kAny)}));
+  ASSERT_OK_AND_ASSIGN(entity, entity.EmbedSchema());
+  ASSERT_OK_AND_ASSIGN(
+      auto object, ObjectCreator::FromAttrs(db, {"a"}, {test::DataItem(1)}));
+  ASSERT_OK_AND_ASSIGN(
+      auto objects,
+      DataSlice::Create(
+          internal::DataSliceImpl::Create({entity.item(), object.item()}),
+          DataSlice::JaggedShape::FlatFromSize(2),
+          internal::DataItem(schema::kObject), db));
+
+  internal::ScopedTrustedMode trusted_mode;
+  ASSERT_OK(objects.SetAttr("a", test::DataSlice<int64_t>({7, 8})));
+  ASSERT_OK_AND_ASSIGN(auto schemas, objects.GetAttr("__schema__"));
+  // The attribute of the EXPLICIT schema keeps ANY, only the IMPLICIT one is
+  // updated.
+  EXPECT_THAT(db->GetImpl().GetSchemaAttr(schemas.slice()[0], "a"),
+              IsOkAndHolds(schema::kAny));
+  EXPECT_THAT(db->GetImpl().GetSchemaAttr(schemas.slice()[1], "a"),
+              IsOkAndHolds(schema::kInt64));
+}
+
 TEST(DataSliceTest, SetMultipleAttrs_Entity) {
   auto db = DataBag::Empty();
   auto ds_a = test::DataItem(1);
@@ -2166,6 +2288,44 @@ TEST(DataSliceTest, SetGetObjectAttributesWithFallback) {
   EXPECT_EQ(ds_a_get.dtype(), GetQType<ObjectId>());
 }
 
+TEST(DataSliceTest, GetAttrs) {
+  auto ds_a = test::DataSlice<int>({1, std::nullopt, 3});
+  auto ds_b = test::AllocateDataSlice(3, schema::kAny);
+
+  auto db = DataBag::Empty();
+  auto shape = DataSlice::JaggedShape::FlatFromSize(3);
+  ASSERT_OK_AND_ASSIGN(auto ds, EntityCreator::Shaped(db, shape, {}, {}));
+  ASSERT_OK(ds.GetSchema().SetAttr("a", test::Schema(schema::kInt32)));
+  ASSERT_OK(ds.SetAttr("a", ds_a));
+  db = DataBag::ImmutableEmptyWithFallbacks({db});
+  ds = ds.WithDb(db);
+  ASSERT_OK(ds.GetSchema().SetAttr("b", test::Schema(schema::kAny)));
+  ASSERT_OK(ds.SetAttr("b", ds_b));
+
+  std::vector<absl::string_view> attr_names = {"b", "a", "b"};
+  ASSERT_OK_AND_ASSIGN(auto results, ds.GetAttrs(attr_names));
+  ASSERT_EQ(results.size(), attr_names.size());
+  for (size_t i = 0; i < attr_names.size(); ++i) {
+    ASSERT_OK_AND_ASSIGN(auto expected, ds.GetAttr(attr_names[i]));
+    EXPECT_THAT(results[i], IsEquivalentTo(expected)) << attr_names[i];
+  }
+  EXPECT_EQ(results[1].GetSchemaImpl(), schema::kInt32);
+
+  // DataItem.
+  auto item = test::DataItem(ds.slice()[0], ds.GetSchemaImpl(), db);
+  ASSERT_OK_AND_ASSIGN(results, item.GetAttrs(attr_names));
+  ASSERT_EQ(results.size(), attr_names.size());
+  EXPECT_THAT(results[1], IsEquivalentTo(test::DataItem(1, db)));
+
+  EXPECT_THAT(ds.GetAttrs({"a", "c"}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("the attribute 'c' is missing")));
+  EXPECT_THAT(
+      test::DataSlice<int>({1}, schema::kInt32, db).GetAttrs(attr_names),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               "getting attributes from primitive values is not supported"));
+}
+
 TEST(DataSliceTest, SetGetObjectAttributesWithOtherDbWithFallback) {
   auto ds_a = test::AllocateDataSlice(3, schema::kItemId);
   auto ds_b = test::AllocateDataSlice(3, schema::kItemId);
@@ -4249,6 +4409,46 @@ TEST(DataSliceTest, SchemaSlice) {
   EXPECT_EQ(new_attr_schema.item(), schema::kFloat64);
 }
 
+TEST(DataSliceTest, ShapesAreEquivalent) {
+  auto edge_1 = CreateEdge({0, 2});
+  auto edge_2 = CreateEdge({0, 1, 3});
+  ASSERT_OK_AND_ASSIGN(auto shape,
+                       DataSlice::JaggedShape::FromEdges({edge_1, edge_2}));
+  // Shapes built from the same edges share the values.
+  ASSERT_OK_AND_ASSIGN(auto same_edges,
+                       DataSlice::JaggedShape::FromEdges({edge_1, edge_2}));
+  EXPECT_TRUE(EdgesShareValues(shape.edges()[1], same_edges.edges()[1]));
+  EXPECT_TRUE(ShapesAreEquivalent(shape, same_edges));
+  // Equal edges with different values are compared element-wise.
+  ASSERT_OK_AND_ASSIGN(
+      auto equal_edges,
+      DataSlice::JaggedShape::FromEdges({edge_1, CreateEdge({0, 1, 3})}));
+  EXPECT_FALSE(EdgesShareValues(shape.edges()[1], equal_edges.edges()[1]));
+  EXPECT_TRUE(ShapesAreEquivalent(shape, equal_edges));
+  ASSERT_OK_AND_ASSIGN(
+      auto other_edges,
+      DataSlice::JaggedShape::FromEdges({edge_1, CreateEdge({0, 2, 3})}));
+  EXPECT_FALSE(ShapesAreEquivalent(shape, other_edges));
+  EXPECT_FALSE(ShapesAreEquivalent(shape, shape.RemoveDims(1)));
+
+  EXPECT_TRUE(ShapeIsBroadcastableTo(shape.RemoveDims(1), shape));
+  EXPECT_TRUE(ShapeIsBroadcastableTo(shape.RemoveDims(1), equal_edges));
+  EXPECT_TRUE(ShapeIsBroadcastableTo(DataSlice::JaggedShape::Empty(), shape));
+  EXPECT_FALSE(ShapeIsBroadcastableTo(shape, shape.RemoveDims(1)));
+  EXPECT_FALSE(ShapeIsBroadcastableTo(
+      DataSlice::JaggedShape::FlatFromSize(3), shape));
+}
+
+TEST(DataSliceTest, Reshape_EquivalentShape) {
+  auto ds = test::DataSlice<int>({1, 2, 3});
+  ASSERT_OK_AND_ASSIGN(auto new_ds,
+                       ds.Reshape(DataSlice::JaggedShape::FlatFromSize(3)));
+  // The original shape is kept.
+  EXPECT_TRUE(
+      EdgesShareValues(new_ds.GetShape().edges()[0], ds.GetShape().edges()[0]));
+  EXPECT_THAT(new_ds.slice(), ElementsAre(1, 2, 3));
+}
+
 TEST(DataSliceTest, Reshape) {
   {
     // DataSliceImpl -> DataSliceImpl.
@@ -15,48 +15,61 @@
 #include "koladata/expr/expr_eval.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
 #include "absl/base/no_destructor.h"
 #include "absl/base/nullability.h"
-#include "absl/base/thread_annotations.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
-#include "absl/synchronization/mutex.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
 #include "absl/types/span.h"
+#include "koladata/data_slice.h"
+#include "koladata/data_slice_qtype.h"
 #include "koladata/expr/expr_operators.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/cancellation.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/sharded_lru_cache.h"
+#include "koladata/internal/trace.h"
 #include "arolla/expr/expr.h"
 #include "arolla/expr/expr_node.h"
+#include "arolla/expr/expr_operator.h"
 #include "arolla/expr/expr_visitor.h"
+#include "arolla/expr/quote.h"
 #include "arolla/expr/registered_expr_operator.h"
+#include "arolla/expr/visitors/substitution.h"
 #include "arolla/io/typed_refs_input_loader.h"
 #include "arolla/qtype/qtype.h"
 #include "arolla/qtype/typed_ref.h"
 #include "arolla/qtype/typed_value.h"
+#include "arolla/qtype/unspecified_qtype.h"
 #include "arolla/serving/expr_compiler.h"
 #include "arolla/util/fast_dynamic_downcast_final.h"
 #include "arolla/util/fingerprint.h"
-#include "arolla/util/lru_cache.h"
 #include "arolla/util/text.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata::expr {
 namespace {
 
-// We use the same size for expr transformations and compilation caches
-// since in most cases we have 1:1 correspondence between them.
-static constexpr int64_t kCacheSize = 4096;
-
 // Information about an expression for fetching inputs for evaluation.
 struct ExprInfo {
   std::vector<std::string> leaf_keys;
@@ -76,29 +89,27 @@ using TransformedExprPtr = std::shared_ptr<const TransformedExpr>;
 // LRU cache for koda-specific expr transformations and information.
 // This class is thread-safe.
 class ExprTransformationCache {
-  using Impl = arolla::LruCache<arolla::Fingerprint, TransformedExprPtr>;
+  using Impl =
+      internal::ShardedLruCache<arolla::Fingerprint, TransformedExprPtr>;
 
  public:
   absl::Nullable<TransformedExprPtr> LookupOrNull(
-      const arolla::Fingerprint& fingerprint) ABSL_LOCKS_EXCLUDED(mutex_) {
-    absl::MutexLock lock(&mutex_);
-    if (auto* res = cache_.LookupOrNull(fingerprint)) {
-      return *res;
-    }
-    return nullptr;
+      const arolla::Fingerprint& fingerprint) {
+    return cache_.LookupOrNull(fingerprint);
   }
 
   absl::Nonnull<TransformedExprPtr> Put(const arolla::Fingerprint& fingerprint,
-                                        TransformedExprPtr value)
-      ABSL_LOCKS_EXCLUDED(mutex_) {
-    absl::MutexLock lock(&mutex_);
-    return *cache_.Put(fingerprint, std::move(value));
+                                        TransformedExprPtr value) {
+    return cache_.Put(fingerprint, std::move(value));
   }
 
-  void Clear() ABSL_LOCKS_EXCLUDED(mutex_) {
-    absl::MutexLock lock(&mutex_);
-    cache_.Clear();
-  }
+  void Clear() { cache_.Clear(); }
+
+  void SetCapacity(int64_t capacity) { cache_.SetCapacity(capacity); }
+
+  internal::LruCacheStats GetStats() { return cache_.GetStats(); }
+
+  void ResetStats() { cache_.ResetStats(); }
 
   static ExprTransformationCache& Instance() {
     static absl::NoDestructor<ExprTransformationCache> instance;
@@ -106,21 +117,538 @@ class ExprTransformationCache {
   }
 
  private:
-  ExprTransformationCache() : cache_(kCacheSize) {}
+  // We use the same default size for expr transformations and compilation
+  // caches since in most cases we have 1:1 correspondence between them.
+  ExprTransformationCache() : cache_(kDefaultEvalCacheCapacity) {}
   friend class absl::NoDestructor<ExprTransformationCache>;
 
-  Impl cache_ ABSL_GUARDED_BY(mutex_);
-  absl::Mutex mutex_;
+  Impl cache_;
+};
+
+constexpr absl::string_view kCoalesceOpName = "kde.logical.coalesce";
+constexpr absl::string_view kMultiCoalesceOpName =
+    "kde.logical._multi_coalesce";
+
+// Returns true if `decayed_op` is kde.logical.coalesce or
+// kde.logical._multi_coalesce.
+bool IsCoalesceOperator(const arolla::expr::ExprOperatorPtr& decayed_op) {
+  return decayed_op != nullptr &&
+         (decayed_op->display_name() == kCoalesceOpName ||
+          decayed_op->display_name() == kMultiCoalesceOpName);
+}
+
+// Rewrites a chain of coalesce operators rooted at `node` (e.g. `x | y | z`)
+// into a single kde.logical._multi_coalesce, which is evaluated in one pass.
+// The dependencies of `node` are expected to be already rewritten.
+absl::StatusOr<arolla::expr::ExprNodePtr> FlattenCoalesceChain(
+    arolla::expr::ExprNodePtr node) {
+  std::vector<arolla::expr::ExprNodePtr> args;
+  bool is_chain = false;
+  for (const auto& dep : node->node_deps()) {
+    ASSIGN_OR_RETURN(auto decayed_dep_op,
+                     arolla::expr::DecayRegisteredOperator(dep->op()));
+    if (IsCoalesceOperator(decayed_dep_op)) {
+      is_chain = true;
+      args.insert(args.end(), dep->node_deps().begin(),
+                  dep->node_deps().end());
+    } else {
+      args.push_back(dep);
+    }
+  }
+  if (!is_chain) {
+    return node;
+  }
+  auto multi_coalesce_op = arolla::expr::LookupOperator(kMultiCoalesceOpName);
+  if (!multi_coalesce_op.ok()) {
+    // The operator is not registered, e.g. in a C++-only environment.
+    return node;
+  }
+  return arolla::expr::MakeOpNode(*std::move(multi_coalesce_op),
+                                  std::move(args));
+}
+
+constexpr absl::string_view kFusedPointwiseOpName =
+    "kde.math._fused_pointwise";
+
+struct FusablePointwiseOp {
+  absl::string_view name;
+  bool is_comparison;
+};
+
+// Pointwise operators that are fused into kde.math._fused_pointwise.
+//
+// NOTE: Must be kept in sync with the fusable operators in
+// koladata/operators/math.cc.
+constexpr std::array kFusablePointwiseOps = {
+    FusablePointwiseOp{"kde.core.add", false},
+    FusablePointwiseOp{"kde.math.subtract", false},
+    FusablePointwiseOp{"kde.math.multiply", false},
+    FusablePointwiseOp{"kde.math.divide", false},
+    FusablePointwiseOp{"kde.math.floordiv", false},
+    FusablePointwiseOp{"kde.math.mod", false},
+    FusablePointwiseOp{"kde.math.pow", false},
+    FusablePointwiseOp{"kde.math.maximum", false},
+    FusablePointwiseOp{"kde.math.minimum", false},
+    FusablePointwiseOp{"kde.math.abs", false},
+    FusablePointwiseOp{"kde.math.ceil", false},
+    FusablePointwiseOp{"kde.math.floor", false},
+    FusablePointwiseOp{"kde.math.round", false},
+    FusablePointwiseOp{"kde.math.exp", false},
+    FusablePointwiseOp{"kde.math.log", false},
+    FusablePointwiseOp{"kde.comparison.less", true},
+    FusablePointwiseOp{"kde.comparison.less_equal", true},
+    FusablePointwiseOp{"kde.comparison.greater", true},
+    FusablePointwiseOp{"kde.comparison.greater_equal", true},
+};
+
+// Returns the fusable pointwise operator matching `decayed_op`, or nullptr.
+const FusablePointwiseOp* GetFusablePointwiseOp(
+    const arolla::expr::ExprOperatorPtr& decayed_op) {
+  if (decayed_op == nullptr) {
+    return nullptr;
+  }
+  for (const FusablePointwiseOp& op : kFusablePointwiseOps) {
+    if (op.name == decayed_op->display_name()) {
+      return &op;
+    }
+  }
+  return nullptr;
+}
+
+// A chain of pointwise operators rewritten into kde.math._fused_pointwise.
+struct FusedPointwiseChain {
+  // The fused expression over placeholders `P.x0`, `P.x1`, ...
+  arolla::expr::ExprNodePtr expr;
+  // The arguments the placeholders refer to.
+  std::vector<arolla::expr::ExprNodePtr> args;
+  // Whether the root of `expr` is a comparison. Comparisons return MASKs, so
+  // they are never fused into the arithmetic operators that use them.
+  bool is_comparison;
+};
+
+using FusedPointwiseChains =
+    absl::flat_hash_map<arolla::Fingerprint, FusedPointwiseChain>;
+
+// Rewrites a chain of fusable pointwise operators rooted at `node` (e.g.
+// `(x * 2 + y) > z`) into a single kde.math._fused_pointwise, which is
+// evaluated in one pass. The dependencies of `node` are expected to be already
+// rewritten, and the chains created so far are recorded in `chains`.
+absl::StatusOr<arolla::expr::ExprNodePtr> FusePointwiseChain(
+    arolla::expr::ExprNodePtr node, const FusablePointwiseOp& node_op,
+    FusedPointwiseChains& chains) {
+  FusedPointwiseChain chain{.is_comparison = node_op.is_comparison};
+  absl::flat_hash_map<arolla::Fingerprint, arolla::expr::ExprNodePtr>
+      placeholders;
+  auto add_arg = [&](const arolla::expr::ExprNodePtr& arg) {
+    auto [it, inserted] = placeholders.emplace(arg->fingerprint(), nullptr);
+    if (inserted) {
+      it->second =
+          arolla::expr::Placeholder(absl::StrCat("x", chain.args.size()));
+      chain.args.push_back(arg);
+    }
+    return it->second;
+  };
+  bool is_chain = false;
+  std::vector<arolla::expr::ExprNodePtr> deps;
+  deps.reserve(node->node_deps().size());
+  for (const auto& dep : node->node_deps()) {
+    if (auto it = chains.find(dep->fingerprint());
+        it != chains.end() && !it->second.is_comparison) {
+      const FusedPointwiseChain& dep_chain = it->second;
+      absl::flat_hash_map<std::string, arolla::expr::ExprNodePtr> subs;
+      for (size_t i = 0; i < dep_chain.args.size(); ++i) {
+        subs.emplace(absl::StrCat("x", i), add_arg(dep_chain.args[i]));
+      }
+      ASSIGN_OR_RETURN(
+          auto inlined_dep,
+          arolla::expr::SubstitutePlaceholders(dep_chain.expr, subs));
+      deps.push_back(std::move(inlined_dep));
+      is_chain = true;
+      continue;
+    }
+    if (dep->is_op()) {
+      ASSIGN_OR_RETURN(auto decayed_dep_op,
+                       arolla::expr::DecayRegisteredOperator(dep->op()));
+      if (const FusablePointwiseOp* dep_op =
+              GetFusablePointwiseOp(decayed_dep_op);
+          dep_op != nullptr && !dep_op->is_comparison) {
+        std::vector<arolla::expr::ExprNodePtr> dep_deps;
+        dep_deps.reserve(dep->node_deps().size());
+        for (const auto& dep_dep : dep->node_deps()) {
+          dep_deps.push_back(add_arg(dep_dep));
+        }
+        ASSIGN_OR_RETURN(
+            auto inlined_dep,
+            arolla::expr::MakeOpNode(dep->op(), std::move(dep_deps)));
+        deps.push_back(std::move(inlined_dep));
+        is_chain = true;
+        continue;
+      }
+    }
+    deps.push_back(add_arg(dep));
+  }
+  if (!is_chain) {
+    return node;
+  }
+  auto fused_op = arolla::expr::LookupOperator(kFusedPointwiseOpName);
+  if (!fused_op.ok()) {
+    // The operator is not registered, e.g. in a C++-only environment.
+    return node;
+  }
+  ASSIGN_OR_RETURN(chain.expr,
+                   arolla::expr::MakeOpNode(node->op(), std::move(deps)));
+  ASSIGN_OR_RETURN(auto fn, DataSlice::Create(
+                                internal::DataItem(
+                                    arolla::expr::ExprQuote(chain.expr)),
+                                internal::DataItem(schema::kExpr)));
+  std::vector<arolla::expr::ExprNodePtr> fused_args;
+  fused_args.reserve(chain.args.size() + 1);
+  fused_args.push_back(arolla::expr::Literal(std::move(fn)));
+  fused_args.insert(fused_args.end(), chain.args.begin(), chain.args.end());
+  ASSIGN_OR_RETURN(auto fused_node,
+                   arolla::expr::MakeOpNode(*std::move(fused_op),
+                                            std::move(fused_args)));
+  chains.emplace(fused_node->fingerprint(), std::move(chain));
+  return fused_node;
+}
+
+constexpr absl::string_view kCondOpName = "kde.logical.cond";
+constexpr absl::string_view kLazyCondOpName = "kde.logical._lazy_cond";
+
+// Pointwise operators, in addition to kFusablePointwiseOps, that
+// kde.logical._lazy_cond may evaluate only on the items selected by the
+// condition.
+constexpr std::array kLazyPointwiseOps = {
+    absl::string_view("kde.comparison.equal"),
+    absl::string_view("kde.comparison.not_equal"),
+    absl::string_view("kde.logical.apply_mask"),
+    absl::string_view("kde.logical.coalesce"),
+    absl::string_view("kde.logical.cond"),
+    absl::string_view("kde.logical.has"),
+    absl::string_view("kde.logical.has_not"),
+    kLazyCondOpName,
+};
+
+// Branches of kde.logical.cond with fewer pointwise operators are evaluated
+// eagerly: selecting their inputs would cost about as much as it saves.
+constexpr int64_t kMinLazyBranchOps = 2;
+
+bool IsLazyPointwiseOperator(const arolla::expr::ExprOperatorPtr& decayed_op) {
+  if (decayed_op == nullptr) {
+    return false;
+  }
+  return GetFusablePointwiseOp(decayed_op) != nullptr ||
+         std::find(kLazyPointwiseOps.begin(), kLazyPointwiseOps.end(),
+                   decayed_op->display_name()) != kLazyPointwiseOps.end();
+}
+
+// Builds the branches of kde.logical._lazy_cond: expressions over inputs
+// `I.x0`, `I.x1`, ... in which the maximal sub-expressions that are not
+// pointwise are replaced by inputs. The replaced sub-expressions are the
+// arguments of kde.logical._lazy_cond and are evaluated eagerly.
+class LazyCondBuilder {
+ public:
+  // Returns the number of distinct pointwise operators evaluated lazily if
+  // `branch` is made lazy.
+  absl::StatusOr<int64_t> CountLazyOps(
+      const arolla::expr::ExprNodePtr& branch) {
+    absl::flat_hash_set<arolla::Fingerprint> visited;
+    return CountLazyOps(branch, visited);
+  }
+
+  absl::StatusOr<arolla::expr::ExprNodePtr> LazyBranch(
+      const arolla::expr::ExprNodePtr& node) {
+    if (auto it = lazy_nodes_.find(node->fingerprint());
+        it != lazy_nodes_.end()) {
+      return it->second;
+    }
+    arolla::expr::ExprNodePtr result;
+    if (node->is_literal()) {
+      result = node;
+    } else {
+      ASSIGN_OR_RETURN(bool is_pointwise, IsLazyPointwiseNode(node));
+      if (is_pointwise) {
+        std::vector<arolla::expr::ExprNodePtr> deps;
+        deps.reserve(node->node_deps().size());
+        for (const auto& dep : node->node_deps()) {
+          ASSIGN_OR_RETURN(deps.emplace_back(), LazyBranch(dep));
+        }
+        ASSIGN_OR_RETURN(result,
+                         arolla::expr::MakeOpNode(node->op(), std::move(deps)));
+      } else {
+        ASSIGN_OR_RETURN(result, Arg(node));
+      }
+    }
+    lazy_nodes_.emplace(node->fingerprint(), result);
+    return result;
+  }
+
+  // Returns the input referring to the argument `node`.
+  absl::StatusOr<arolla::expr::ExprNodePtr> Arg(
+      const arolla::expr::ExprNodePtr& node) {
+    if (auto it = inputs_.find(node->fingerprint()); it != inputs_.end()) {
+      return it->second;
+    }
+    ASSIGN_OR_RETURN(
+        auto input,
+        arolla::expr::CallOp(
+            "koda_internal.input",
+            {arolla::expr::Literal(arolla::Text("I")),
+             arolla::expr::Literal(
+                 arolla::Text(absl::StrCat("x", args_.size())))}));
+    args_.push_back(node);
+    inputs_.emplace(node->fingerprint(), input);
+    return input;
+  }
+
+  std::vector<arolla::expr::ExprNodePtr>& args() { return args_; }
+
+ private:
+  static absl::StatusOr<bool> IsLazyPointwiseNode(
+      const arolla::expr::ExprNodePtr& node) {
+    if (!node->is_op()) {
+      return false;
+    }
+    ASSIGN_OR_RETURN(auto decayed_op,
+                     arolla::expr::DecayRegisteredOperator(node->op()));
+    return IsLazyPointwiseOperator(decayed_op);
+  }
+
+  static absl::StatusOr<int64_t> CountLazyOps(
+      const arolla::expr::ExprNodePtr& node,
+      absl::flat_hash_set<arolla::Fingerprint>& visited) {
+    if (!visited.insert(node->fingerprint()).second) {
+      return 0;
+    }
+    ASSIGN_OR_RETURN(bool is_pointwise, IsLazyPointwiseNode(node));
+    if (!is_pointwise) {
+      return 0;
+    }
+    int64_t count = 1;
+    for (const auto& dep : node->node_deps()) {
+      ASSIGN_OR_RETURN(int64_t dep_count, CountLazyOps(dep, visited));
+      count += dep_count;
+    }
+    return count;
+  }
+
+  absl::flat_hash_map<arolla::Fingerprint, arolla::expr::ExprNodePtr>
+      lazy_nodes_;
+  absl::flat_hash_map<arolla::Fingerprint, arolla::expr::ExprNodePtr> inputs_;
+  std::vector<arolla::expr::ExprNodePtr> args_;
+};
+
+absl::StatusOr<DataSlice> QuoteExpr(arolla::expr::ExprNodePtr expr) {
+  return DataSlice::Create(
+      internal::DataItem(arolla::expr::ExprQuote(std::move(expr))),
+      internal::DataItem(schema::kExpr));
+}
+
+// Rewrites `kde.logical.cond(condition, yes, no)` into
+// `kde.logical._lazy_cond(yes', no', condition, *args)` if `yes` or `no` has
+// enough pointwise operators. kde.logical._lazy_cond evaluates these operators
+// only on the items selected by the condition (or its negation). Note that the
+// rewrite changes the semantics: errors the lazy operators raise only for the
+// items that are not selected are dropped, see koladata/functor/lazy_cond.h.
+absl::StatusOr<arolla::expr::ExprNodePtr> MakeLazyCond(
+    arolla::expr::ExprNodePtr node) {
+  if (node->node_deps().size() != 3) {
+    return node;
+  }
+  const auto& condition = node->node_deps()[0];
+  const auto& yes = node->node_deps()[1];
+  const auto& no = node->node_deps()[2];
+  LazyCondBuilder builder;
+  ASSIGN_OR_RETURN(int64_t yes_ops, builder.CountLazyOps(yes));
+  ASSIGN_OR_RETURN(int64_t no_ops, builder.CountLazyOps(no));
+  if (yes_ops < kMinLazyBranchOps && no_ops < kMinLazyBranchOps) {
+    return node;
+  }
+  auto lazy_cond_op = arolla::expr::LookupOperator(kLazyCondOpName);
+  if (!lazy_cond_op.ok()) {
+    // The operator is not registered, e.g. in a C++-only environment.
+    return node;
+  }
+  ASSIGN_OR_RETURN(auto yes_expr, yes_ops >= kMinLazyBranchOps
+                                      ? builder.LazyBranch(yes)
+                                      : builder.Arg(yes));
+  ASSIGN_OR_RETURN(auto no_expr, no_ops >= kMinLazyBranchOps
+                                     ? builder.LazyBranch(no)
+                                     : builder.Arg(no));
+  ASSIGN_OR_RETURN(auto yes_quote, QuoteExpr(std::move(yes_expr)));
+  ASSIGN_OR_RETURN(auto no_quote, QuoteExpr(std::move(no_expr)));
+  std::vector<arolla::expr::ExprNodePtr> deps;
+  deps.reserve(builder.args().size() + 3);
+  deps.push_back(arolla::expr::Literal(std::move(yes_quote)));
+  deps.push_back(arolla::expr::Literal(std::move(no_quote)));
+  deps.push_back(condition);
+  deps.insert(deps.end(), builder.args().begin(), builder.args().end());
+  return arolla::expr::MakeOpNode(*std::move(lazy_cond_op), std::move(deps));
+}
+
+// Rewrites kde.logical.cond operators with expensive branches into
+// kde.logical._lazy_cond, see MakeLazyCond. Done before the inputs are replaced
+// with leaves, since the lazy branches are evaluated as separate expressions.
+absl::StatusOr<arolla::expr::ExprNodePtr> MakeCondsLazy(
+    const arolla::expr::ExprNodePtr& expr) {
+  return arolla::expr::Transform(
+      expr,
+      [](arolla::expr::ExprNodePtr node)
+          -> absl::StatusOr<arolla::expr::ExprNodePtr> {
+        if (!node->is_op()) {
+          return node;
+        }
+        ASSIGN_OR_RETURN(auto decayed_op,
+                         arolla::expr::DecayRegisteredOperator(node->op()));
+        if (decayed_op == nullptr ||
+            decayed_op->display_name() != kCondOpName) {
+          return node;
+        }
+        return MakeLazyCond(std::move(node));
+      });
+}
+
+constexpr absl::string_view kGetAttrOpName = "kde.core.get_attr";
+constexpr absl::string_view kGetAttrImplOpName = "kde.core._get_attr";
+constexpr absl::string_view kGetAttrsOpName = "kde.core._get_attrs";
+
+// An attribute read without a default and with a literal attribute name.
+struct AttrRead {
+  arolla::expr::ExprNodePtr obj;
+  arolla::expr::ExprNodePtr attr_name;
+  absl::string_view attr_name_str;
 };
 
-// Replaces all `I.x` and `V.x` inputs with leaves.
+// Returns the attribute read done by `node`, if it can be fused with the other
+// reads of the same object.
+absl::StatusOr<std::optional<AttrRead>> GetFusableAttrRead(
+    const arolla::expr::ExprNodePtr& node) {
+  if (!node->is_op()) {
+    return std::nullopt;
+  }
+  ASSIGN_OR_RETURN(auto decayed_op,
+                   arolla::expr::DecayRegisteredOperator(node->op()));
+  if (decayed_op == nullptr) {
+    return std::nullopt;
+  }
+  const auto& deps = node->node_deps();
+  if (decayed_op->display_name() == kGetAttrOpName) {
+    if (deps.size() != 3 ||
+        deps[2]->qtype() != arolla::GetUnspecifiedQType()) {
+      return std::nullopt;
+    }
+  } else if (decayed_op->display_name() != kGetAttrImplOpName ||
+             deps.size() != 2) {
+    return std::nullopt;
+  }
+  // Covers both Arolla literals and koda_internal.literal.
+  const auto& attr_name = deps[1]->qvalue();
+  if (!attr_name.has_value() ||
+      attr_name->GetType() != arolla::GetQType<DataSlice>()) {
+    return std::nullopt;
+  }
+  const auto& attr_name_ds = attr_name->UnsafeAs<DataSlice>();
+  if (attr_name_ds.GetShape().rank() != 0 ||
+      !attr_name_ds.item().holds_value<arolla::Text>()) {
+    return std::nullopt;
+  }
+  return AttrRead{
+      .obj = deps[0],
+      .attr_name = deps[1],
+      .attr_name_str = attr_name_ds.item().value<arolla::Text>().view()};
+}
+
+// Rewrites the reads of several attributes of the same object (e.g. `I.x.a`
+// and `I.x.b`) into a single kde.core._get_attrs, so that the DataBag
+// fallbacks are resolved and the objects validated once for all of them.
+absl::StatusOr<arolla::expr::ExprNodePtr> FuseGetAttrs(
+    const arolla::expr::ExprNodePtr& expr) {
+  // The attribute names read from each object, by the object fingerprint in
+  // the original expression.
+  struct ObjAttrs {
+    std::vector<arolla::expr::ExprNodePtr> attr_names;
+    absl::flat_hash_map<absl::string_view, int64_t> index;
+    arolla::expr::ExprNodePtr fused;
+  };
+  absl::flat_hash_map<arolla::Fingerprint, ObjAttrs> reads;
+  arolla::expr::PostOrder post_order(expr);
+  std::vector<std::optional<AttrRead>> node_reads(post_order.nodes_size());
+  bool has_fusable_reads = false;
+  for (size_t i = 0; i < post_order.nodes_size(); ++i) {
+    ASSIGN_OR_RETURN(node_reads[i], GetFusableAttrRead(post_order.node(i)));
+    if (!node_reads[i].has_value()) {
+      continue;
+    }
+    ObjAttrs& obj_attrs = reads[node_reads[i]->obj->fingerprint()];
+    if (obj_attrs.index
+            .emplace(node_reads[i]->attr_name_str, obj_attrs.attr_names.size())
+            .second) {
+      obj_attrs.attr_names.push_back(node_reads[i]->attr_name);
+      has_fusable_reads |= obj_attrs.attr_names.size() > 1;
+    }
+  }
+  if (!has_fusable_reads) {
+    return expr;
+  }
+  auto get_attrs_op = arolla::expr::LookupOperator(kGetAttrsOpName);
+  if (!get_attrs_op.ok()) {
+    // The operator is not registered, e.g. in a C++-only environment.
+    return expr;
+  }
+  std::vector<arolla::expr::ExprNodePtr> new_nodes(post_order.nodes_size());
+  for (size_t i = 0; i < post_order.nodes_size(); ++i) {
+    const auto& dep_indices = post_order.dep_indices(i);
+    if (node_reads[i].has_value()) {
+      ObjAttrs& obj_attrs = reads[node_reads[i]->obj->fingerprint()];
+      if (obj_attrs.attr_names.size() > 1) {
+        if (obj_attrs.fused == nullptr) {
+          std::vector<arolla::expr::ExprNodePtr> deps;
+          deps.reserve(obj_attrs.attr_names.size() + 1);
+          deps.push_back(new_nodes[dep_indices[0]]);
+          deps.insert(deps.end(), obj_attrs.attr_names.begin(),
+                      obj_attrs.attr_names.end());
+          ASSIGN_OR_RETURN(
+              obj_attrs.fused,
+              arolla::expr::MakeOpNode(*get_attrs_op, std::move(deps)));
+        }
+        ASSIGN_OR_RETURN(
+            new_nodes[i],
+            arolla::expr::CallOp(
+                "core.get_nth",
+                {obj_attrs.fused,
+                 arolla::expr::Literal<int64_t>(
+                     obj_attrs.index.at(node_reads[i]->attr_name_str))}));
+        continue;
+      }
+    }
+    std::vector<arolla::expr::ExprNodePtr> deps;
+    deps.reserve(dep_indices.size());
+    for (auto dep_index : dep_indices) {
+      deps.push_back(new_nodes[dep_index]);
+    }
+    ASSIGN_OR_RETURN(new_nodes[i], arolla::expr::WithNewDependencies(
+                                       post_order.node(i), std::move(deps)));
+  }
+  return new_nodes.back();
+}
+
+// Replaces all `I.x` and `V.x` inputs with leaves, flattens chains of
+// coalesce operators and fuses chains of pointwise operators.
 absl::StatusOr<TransformedExpr> ReplaceInputsWithLeaves(
     const arolla::expr::ExprNodePtr& expr) {
   TransformedExpr res;
-  auto transform_expr = [&res](arolla::expr::ExprNodePtr node)
+  FusedPointwiseChains fused_chains;
+  auto transform_expr = [&res, &fused_chains](arolla::expr::ExprNodePtr node)
       -> absl::StatusOr<arolla::expr::ExprNodePtr> {
     ASSIGN_OR_RETURN(auto decayed_op,
                      arolla::expr::DecayRegisteredOperator(node->op()));
+    if (IsCoalesceOperator(decayed_op)) {
+      return FlattenCoalesceChain(std::move(node));
+    }
+    if (const FusablePointwiseOp* op = GetFusablePointwiseOp(decayed_op);
+        op != nullptr) {
+      return FusePointwiseChain(std::move(node), *op, fused_chains);
+    }
     if (arolla::fast_dynamic_downcast_final<const InputOperator*>(
             decayed_op.get()) == nullptr) {
       return node;
@@ -152,7 +680,15 @@ absl::StatusOr<TransformedExpr> ReplaceInputsWithLeaves(
 // Transforms the provided Koda expression into an expression that is compatible
 // with the Arolla C++ API. In particular, this function replaces all `I.x` and
 // `V.x` inputs with leaves. Includes information about the expression for
-// fetching inputs for evaluation.
+// fetching inputs for evaluation. Chains of `|` are rewritten into a single
+// N-ary coalesce, chains of arithmetic and comparison operators into a
+// single fused pointwise operator, and kde.logical.cond with expensive
+// branches into kde.logical._lazy_cond. Reads of several attributes of the
+// same object are fused into kde.core._get_attrs.
+//
+// NOTE: No separate common-subexpression pass is needed here: Transform and
+// the Arolla compiler identify nodes by fingerprint, so repeated
+// sub-expressions (e.g. `I.x.a` used twice) are evaluated once.
 absl::StatusOr<TransformedExprPtr> TransformExprForEval(
     const arolla::expr::ExprNodePtr& expr) {
   if (auto result =
@@ -173,7 +709,9 @@ absl::StatusOr<TransformedExprPtr> TransformExprForEval(
                         "the provided expression has leaves: [%s]",
                         absl::StrJoin(leaves, ", ")));
   }
-  ASSIGN_OR_RETURN(auto transformed_expr, ReplaceInputsWithLeaves(expr));
+  ASSIGN_OR_RETURN(auto lazy_expr, MakeCondsLazy(expr));
+  ASSIGN_OR_RETURN(auto fused_expr, FuseGetAttrs(lazy_expr));
+  ASSIGN_OR_RETURN(auto transformed_expr, ReplaceInputsWithLeaves(fused_expr));
   return ExprTransformationCache::Instance().Put(
       expr->fingerprint(),
       std::make_shared<TransformedExpr>(std::move(transformed_expr)));
@@ -188,29 +726,37 @@ using Compiler = arolla::ExprCompiler<absl::Span<const arolla::TypedRef>,
 // LRU cache for Arolla expr compilation.
 // This class is thread-safe.
 class CompilationCache {
-  using Impl = arolla::LruCache<arolla::Fingerprint, CompiledExpr>;
+  using Impl = internal::ShardedLruCache<arolla::Fingerprint, CompiledExpr>;
 
  public:
-  CompiledExpr LookupOrNull(const arolla::Fingerprint& fingerprint)
-      ABSL_LOCKS_EXCLUDED(mutex_) {
-    absl::MutexLock lock(&mutex_);
-    if (auto* res = cache_.LookupOrNull(fingerprint)) {
-      // This copies std::function, which is fine since it is more or less a
-      // shared_ptr.
-      return *res;
-    }
-    return {};
+  CompiledExpr LookupOrNull(const arolla::Fingerprint& fingerprint) {
+    // This copies std::function, which is fine since it is more or less a
+    // shared_ptr.
+    return cache_.LookupOrNull(fingerprint);
+  }
+
+  CompiledExpr Put(const arolla::Fingerprint& fingerprint, CompiledExpr value) {
+    return cache_.Put(fingerprint, std::move(value));
+  }
+
+  void Clear() { cache_.Clear(); }
+
+  void SetCapacity(int64_t capacity) { cache_.SetCapacity(capacity); }
+
+  internal::LruCacheStats GetStats() { return cache_.GetStats(); }
+
+  void ResetStats() {
+    cache_.ResetStats();
+    compilation_time_us_.store(0, std::memory_order_relaxed);
   }
 
-  CompiledExpr Put(const arolla::Fingerprint& fingerprint, CompiledExpr value)
-      ABSL_LOCKS_EXCLUDED(mutex_) {
-    absl::MutexLock lock(&mutex_);
-    return *cache_.Put(fingerprint, std::move(value));
+  void AddCompilationTime(absl::Duration duration) {
+    compilation_time_us_.fetch_add(absl::ToInt64Microseconds(duration),
+                                   std::memory_order_relaxed);
   }
 
-  void Clear() ABSL_LOCKS_EXCLUDED(mutex_) {
-    absl::MutexLock lock(&mutex_);
-    cache_.Clear();
+  int64_t compilation_time_us() const {
+    return compilation_time_us_.load(std::memory_order_relaxed);
   }
 
   static CompilationCache& Instance() {
@@ -219,13 +765,38 @@ class CompilationCache {
   }
 
  private:
-  CompilationCache() : cache_(kCacheSize) {}
+  CompilationCache() : cache_(kDefaultEvalCacheCapacity) {}
   friend class absl::NoDestructor<CompilationCache>;
 
-  Impl cache_ ABSL_GUARDED_BY(mutex_);
-  absl::Mutex mutex_;
+  Impl cache_;
+  std::atomic<int64_t> compilation_time_us_ = 0;
 };
 
+absl::StatusOr<CompiledExpr> CompileUncached(
+    const arolla::expr::ExprNodePtr& expr,
+    absl::Span<const std::string> leaf_keys,
+    absl::Span<const arolla::TypedRef> leaf_values) {
+  internal::TraceSpan span("compile", "kd.eval");
+  std::vector<std::pair<std::string, arolla::QTypePtr>> args(
+      leaf_values.size());
+  for (int64_t i = 0; i < leaf_values.size(); ++i) {
+    args[i] = {leaf_keys[i], leaf_values[i].GetType()};
+  }
+  absl::Time start = absl::Now();
+  ASSIGN_OR_RETURN(
+      CompiledExpr fn,
+      Compiler()
+          // Most of our expressions are small and don't contain any literals.
+          // In such cases the always clone thread safety policy is faster.
+          // Since every call gets a fresh frame, no inputs or intermediate
+          // values are kept alive after the call.
+          .SetAlwaysCloneThreadSafetyPolicy()
+          .SetInputLoader(arolla::CreateTypedRefsInputLoader(args))
+          .Compile(expr));
+  CompilationCache::Instance().AddCompilationTime(absl::Now() - start);
+  return fn;
+}
+
 absl::StatusOr<CompiledExpr> Compile(
     const arolla::expr::ExprNodePtr& expr,
     absl::Span<const std::string> leaf_keys,
@@ -245,19 +816,7 @@ absl::StatusOr<CompiledExpr> Compile(
   arolla::Fingerprint key = std::move(hasher).Finish();
   CompiledExpr fn = CompilationCache::Instance().LookupOrNull(key);
   if (!fn) {
-    std::vector<std::pair<std::string, arolla::QTypePtr>> args(
-        leaf_values.size());
-    for (int64_t i = 0; i < leaf_values.size(); ++i) {
-      args[i] = {leaf_keys[i], leaf_values[i].GetType()};
-    }
-    ASSIGN_OR_RETURN(
-        fn,
-        Compiler()
-            // Most of our expressions are small and don't contain any literals.
-            // In such cases the always clone thread safety policy is faster.
-            .SetAlwaysCloneThreadSafetyPolicy()
-            .SetInputLoader(arolla::CreateTypedRefsInputLoader(args))
-            .Compile(expr));
+    ASSIGN_OR_RETURN(fn, CompileUncached(expr, leaf_keys, leaf_values));
     fn = CompilationCache::Instance().Put(key, std::move(fn));
   }
   return fn;
@@ -269,6 +828,11 @@ absl::StatusOr<arolla::TypedValue> EvalExprWithCompilationCache(
     const arolla::expr::ExprNodePtr& expr,
     absl::Span<const std::pair<std::string, arolla::TypedRef>> inputs,
     absl::Span<const std::pair<std::string, arolla::TypedRef>> variables) {
+  internal::TraceSpan span("eval", "kd.eval");
+  if (span.active() && expr->is_op()) {
+    span.AddArg("root_op", std::string(expr->op()->display_name()));
+  }
+  RETURN_IF_ERROR(internal::CheckCancellation());
   ASSIGN_OR_RETURN(auto transformed_expr, TransformExprForEval(expr));
   const auto& expr_info = transformed_expr->info;
 
@@ -321,6 +885,115 @@ absl::StatusOr<arolla::TypedValue> EvalExprWithCompilationCache(
   return compiled_expr(input_qvalues);
 }
 
+absl::Status PrecompileExprWithCompilationCache(
+    const arolla::expr::ExprNodePtr& expr,
+    absl::Span<const std::pair<std::string, arolla::QTypePtr>> input_qtypes) {
+  ASSIGN_OR_RETURN(auto transformed_expr, TransformExprForEval(expr));
+  const auto& expr_info = transformed_expr->info;
+  if (!expr_info.variable_leaf_index.empty()) {
+    return absl::InvalidArgumentError(
+        "only expressions without variables can be precompiled");
+  }
+  // Compilation only looks at the qtypes of the values, so default
+  // constructed values stand in for the actual inputs.
+  std::vector<std::optional<arolla::TypedValue>> input_values(
+      expr_info.leaf_keys.size());
+  for (const auto& [input_name, input_qtype] : input_qtypes) {
+    auto it = expr_info.input_leaf_index.find(input_name);
+    if (it == expr_info.input_leaf_index.end()) {
+      continue;
+    }
+    input_values[it->second] =
+        arolla::TypedValue::UnsafeFromTypeDefaultConstructed(input_qtype);
+  }
+  std::vector<arolla::TypedRef> input_qvalues;
+  input_qvalues.reserve(input_values.size());
+  std::vector<absl::string_view> missing_leaf_keys;
+  for (int64_t i = 0; i < input_values.size(); ++i) {
+    if (!input_values[i].has_value()) {
+      missing_leaf_keys.push_back(expr_info.leaf_keys[i]);
+      continue;
+    }
+    input_qvalues.push_back(input_values[i]->AsRef());
+  }
+  if (!missing_leaf_keys.empty()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("kd.eval() has missing inputs for: [%s]",
+                        absl::StrJoin(missing_leaf_keys, ", ")));
+  }
+  return Compile(transformed_expr->expr, expr_info.leaf_keys, input_qvalues)
+      .status();
+}
+
+void EvalExprAsync(
+    arolla::expr::ExprNodePtr expr,
+    std::vector<std::pair<std::string, arolla::TypedValue>> inputs,
+    internal::Executor* executor,
+    std::shared_ptr<const internal::CancellationToken> cancellation,
+    absl::AnyInvocable<void(absl::StatusOr<arolla::TypedValue>) &&> done) {
+  auto task = [expr = std::move(expr), inputs = std::move(inputs),
+               cancellation = std::move(cancellation),
+               done = std::move(done)]() mutable {
+    internal::ScopedCancellationToken scope(cancellation.get());
+    std::vector<std::pair<std::string, arolla::TypedRef>> input_refs;
+    input_refs.reserve(inputs.size());
+    for (const auto& [name, value] : inputs) {
+      input_refs.emplace_back(name, value.AsRef());
+    }
+    std::move(done)(EvalExprWithCompilationCache(expr, input_refs, {}));
+  };
+  if (executor == nullptr) {
+    std::move(task)();
+  } else {
+    executor->Schedule(std::move(task));
+  }
+}
+
+absl::StatusOr<CompiledOp> CompileOpWithCompilationCache(
+    const arolla::expr::ExprOperatorPtr& op,
+    absl::Span<const arolla::TypedRef> args) {
+  arolla::FingerprintHasher hasher("koladata.eval_op");
+  hasher.Combine(op->fingerprint());
+  for (const auto& arg : args) {
+    hasher.Combine(arg.GetType());
+  }
+  arolla::Fingerprint key = std::move(hasher).Finish();
+  CompiledExpr fn = CompilationCache::Instance().LookupOrNull(key);
+  if (!fn) {
+    std::vector<std::string> leaf_keys;
+    std::vector<arolla::expr::ExprNodePtr> leaves;
+    leaf_keys.reserve(args.size());
+    leaves.reserve(args.size());
+    for (int64_t i = 0; i < args.size(); ++i) {
+      leaf_keys.push_back(absl::StrCat("_", i));
+      leaves.push_back(arolla::expr::Leaf(leaf_keys.back()));
+    }
+    ASSIGN_OR_RETURN(auto expr,
+                     arolla::expr::MakeOpNode(op, std::move(leaves)));
+    ASSIGN_OR_RETURN(fn, CompileUncached(expr, leaf_keys, args));
+    fn = CompilationCache::Instance().Put(key, std::move(fn));
+  }
+  return fn;
+}
+
+absl::StatusOr<arolla::TypedValue> EvalCompiledOp(
+    const arolla::expr::ExprOperatorPtr& op, const CompiledOp& compiled_op,
+    absl::Span<const arolla::TypedRef> args) {
+  internal::TraceSpan span("eval", "kd.eval");
+  if (span.active()) {
+    span.AddArg("root_op", std::string(op->display_name()));
+  }
+  return compiled_op(args);
+}
+
+absl::StatusOr<arolla::TypedValue> EvalOpWithCompilationCache(
+    const arolla::expr::ExprOperatorPtr& op,
+    absl::Span<const arolla::TypedRef> args) {
+  ASSIGN_OR_RETURN(CompiledOp compiled_op,
+                   CompileOpWithCompilationCache(op, args));
+  return EvalCompiledOp(op, compiled_op, args);
+}
+
 absl::StatusOr<std::vector<std::string>> GetExprVariables(
     const arolla::expr::ExprNodePtr& expr) {
   ASSIGN_OR_RETURN(auto transformed_expr, TransformExprForEval(expr));
@@ -354,4 +1027,30 @@ void ClearCompilationCache() {
   CompilationCache::Instance().Clear();
 }
 
+EvalCacheStats GetEvalCacheStats() {
+  return {
+      .transformation_cache = ExprTransformationCache::Instance().GetStats(),
+      .compilation_cache = CompilationCache::Instance().GetStats(),
+      .compilation_time_us = CompilationCache::Instance().compilation_time_us(),
+  };
+}
+
+void ResetEvalCacheStats() {
+  ExprTransformationCache::Instance().ResetStats();
+  CompilationCache::Instance().ResetStats();
+}
+
+absl::Status SetEvalCacheCapacity(int64_t transformation_cache_capacity,
+                                  int64_t compilation_cache_capacity) {
+  if (transformation_cache_capacity <= 0 || compilation_cache_capacity <= 0) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "eval cache capacity must be positive, got %d and %d",
+        transformation_cache_capacity, compilation_cache_capacity));
+  }
+  ExprTransformationCache::Instance().SetCapacity(
+      transformation_cache_capacity);
+  CompilationCache::Instance().SetCapacity(compilation_cache_capacity);
+  return absl::OkStatus();
+}
+
 }  // namespace koladata::expr
@@ -15,13 +15,23 @@
 #ifndef KOLADATA_EXPR_EXPR_EVAL_H_
 #define KOLADATA_EXPR_EXPR_EVAL_H_
 
+#include <cstdint>
+#include <functional>
+#include <memory>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
+#include "koladata/internal/cancellation.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/sharded_lru_cache.h"
 #include "arolla/expr/expr_node.h"
+#include "arolla/expr/expr_operator.h"
+#include "arolla/qtype/qtype.h"
 #include "arolla/qtype/typed_ref.h"
 #include "arolla/qtype/typed_value.h"
 
@@ -36,6 +46,56 @@ absl::StatusOr<arolla::TypedValue> EvalExprWithCompilationCache(
     absl::Span<const std::pair<std::string, arolla::TypedRef>> inputs,
     absl::Span<const std::pair<std::string, arolla::TypedRef>> variables);
 
+// Compiles `expr` for the inputs of the given qtypes and stores the result in
+// the cache used by EvalExprWithCompilationCache, so that the first evaluation
+// with inputs of these qtypes does not pay for the compilation. The expression
+// must refer only to inputs (I.x), not to variables. Inputs not used by the
+// expression are ignored.
+absl::Status PrecompileExprWithCompilationCache(
+    const arolla::expr::ExprNodePtr& expr,
+    absl::Span<const std::pair<std::string, arolla::QTypePtr>> input_qtypes);
+
+// Schedules EvalExprWithCompilationCache(expr, inputs, {}) on `executor` and
+// passes the result to `done`, which is called on the executor thread. When
+// `executor` is nullptr, the expression is evaluated and `done` is called on
+// the calling thread before returning.
+//
+// When `cancellation` is not null, it is checked before the evaluation starts
+// and before every nested expression evaluation (e.g. for the variables of the
+// called functors). Once it is cancelled, `done` receives a CancelledError.
+void EvalExprAsync(
+    arolla::expr::ExprNodePtr expr,
+    std::vector<std::pair<std::string, arolla::TypedValue>> inputs,
+    internal::Executor* executor,
+    std::shared_ptr<const internal::CancellationToken> cancellation,
+    absl::AnyInvocable<void(absl::StatusOr<arolla::TypedValue>) &&> done);
+
+// `op` compiled for the qtypes of its positional arguments, see
+// CompileOpWithCompilationCache.
+using CompiledOp = std::function<absl::StatusOr<arolla::TypedValue>(
+    absl::Span<const arolla::TypedRef>)>;
+
+// Returns `op` compiled for positional arguments with the qtypes of `args`.
+// Unlike EvalExprWithCompilationCache, no expression is built on a cache hit:
+// the compiled operator is looked up by the operator fingerprint and the
+// argument qtypes. Only the qtypes of `args` are used. Fails if the arguments
+// can not be bound to the operator, in which case nothing was evaluated.
+absl::StatusOr<CompiledOp> CompileOpWithCompilationCache(
+    const arolla::expr::ExprOperatorPtr& op,
+    absl::Span<const arolla::TypedRef> args);
+
+// Evaluates `compiled_op`, returned by CompileOpWithCompilationCache(op, ...),
+// on `args`.
+absl::StatusOr<arolla::TypedValue> EvalCompiledOp(
+    const arolla::expr::ExprOperatorPtr& op, const CompiledOp& compiled_op,
+    absl::Span<const arolla::TypedRef> args);
+
+// Evaluates `op` on positional `args`, same as CompileOpWithCompilationCache
+// followed by EvalCompiledOp.
+absl::StatusOr<arolla::TypedValue> EvalOpWithCompilationCache(
+    const arolla::expr::ExprOperatorPtr& op,
+    absl::Span<const arolla::TypedRef> args);
+
 // Retrieves the list of variables used in the given expression.
 // This reuses the same cache as EvalExprWithCompilationCache, so it is cheap
 // to call this method before/after evaluating the expression.
@@ -51,6 +111,29 @@ absl::StatusOr<std::vector<std::string>> GetExprInputs(
 // Clears the expr transformation and compilation caches.
 void ClearCompilationCache();
 
+// Default capacity of the expr transformation and compilation caches.
+constexpr int64_t kDefaultEvalCacheCapacity = 4096;
+
+// Usage statistics of the expr transformation and compilation caches.
+struct EvalCacheStats {
+  internal::LruCacheStats transformation_cache;
+  internal::LruCacheStats compilation_cache;
+  // Cumulative time spent compiling expressions on compilation cache misses.
+  int64_t compilation_time_us = 0;
+};
+
+// Returns the usage statistics accumulated since the start of the process or
+// the last call to ResetEvalCacheStats.
+EvalCacheStats GetEvalCacheStats();
+
+// Resets the counters returned by GetEvalCacheStats.
+void ResetEvalCacheStats();
+
+// Sets the maximum number of entries in the expr transformation and
+// compilation caches. Both caches are cleared.
+absl::Status SetEvalCacheCapacity(int64_t transformation_cache_capacity,
+                                  int64_t compilation_cache_capacity);
+
 }  // namespace koladata::expr
 
 #endif  // KOLADATA_EXPR_EXPR_EVAL_H_
@@ -18,12 +18,15 @@
 #include "koladata/expr/expr_eval.h"
 
 #include <cstdint>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "arolla/expr/expr.h"
+#include "arolla/qtype/qtype_traits.h"
 #include "arolla/qtype/typed_value.h"
 #include "arolla/util/text.h"
 
@@ -34,6 +37,7 @@ namespace {
 using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
 using ::testing::ElementsAre;
+using ::testing::HasSubstr;
 
 TEST(ExprEvalTest, Basic) {
   ASSERT_OK_AND_ASSIGN(
@@ -131,6 +135,39 @@ TEST(ExprEvalTest, UnknownContainer) {
                "unknown input container: [Z]"));
 }
 
+TEST(ExprEvalTest, RepeatedEvaluationOnManyThreads) {
+  ASSERT_OK_AND_ASSIGN(
+      auto expr,
+      arolla::expr::CallOp("math.add",
+                           {arolla::expr::CallOp(
+                                "koda_internal.input",
+                                {arolla::expr::Literal(arolla::Text("I")),
+                                 arolla::expr::Literal(arolla::Text("foo"))}),
+                            arolla::expr::Literal(1)}));
+  std::vector<std::thread> threads;
+  std::vector<int> failures(4);
+  for (int t = 0; t < failures.size(); ++t) {
+    threads.emplace_back([&, t] {
+      for (int i = 0; i < 100; ++i) {
+        if (i == 50 && t == 0) {
+          ClearCompilationCache();
+        }
+        auto foo_value = arolla::TypedValue::FromValue(t * 1000 + i);
+        auto result = EvalExprWithCompilationCache(
+            expr, {{"foo", foo_value.AsRef()}}, {});
+        if (!result.ok() ||
+            result->As<int32_t>().value() != t * 1000 + i + 1) {
+          ++failures[t];
+        }
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_THAT(failures, ElementsAre(0, 0, 0, 0));
+}
+
 TEST(GetExprVariablesTest, Basic) {
   ASSERT_OK_AND_ASSIGN(
       auto expr,
@@ -173,6 +210,82 @@ TEST(GetExprInputsTest, Basic) {
   EXPECT_THAT(GetExprInputs(expr), IsOkAndHolds(ElementsAre("bar", "foo")));
 }
 
+TEST(EvalCacheStatsTest, HitsAndMisses) {
+  ClearCompilationCache();
+  ResetEvalCacheStats();
+  ASSERT_OK_AND_ASSIGN(
+      auto expr,
+      arolla::expr::CallOp("math.add",
+                           {arolla::expr::CallOp(
+                                "koda_internal.input",
+                                {arolla::expr::Literal(arolla::Text("I")),
+                                 arolla::expr::Literal(arolla::Text("foo"))}),
+                            arolla::expr::Literal(1)}));
+  auto foo_value = arolla::TypedValue::FromValue(1);
+  for (int i = 0; i < 3; ++i) {
+    ASSERT_OK_AND_ASSIGN(
+        auto result,
+        EvalExprWithCompilationCache(expr, {{"foo", foo_value.AsRef()}}, {}));
+    EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds(2));
+  }
+  EvalCacheStats stats = GetEvalCacheStats();
+  EXPECT_EQ(stats.transformation_cache.capacity, kDefaultEvalCacheCapacity);
+  EXPECT_EQ(stats.transformation_cache.size, 1);
+  EXPECT_EQ(stats.transformation_cache.misses, 1);
+  EXPECT_EQ(stats.transformation_cache.hits, 2);
+  EXPECT_EQ(stats.compilation_cache.size, 1);
+  EXPECT_EQ(stats.compilation_cache.misses, 1);
+  EXPECT_EQ(stats.compilation_cache.hits, 2);
+  EXPECT_GE(stats.compilation_time_us, 0);
+
+  ResetEvalCacheStats();
+  stats = GetEvalCacheStats();
+  EXPECT_EQ(stats.compilation_cache.hits, 0);
+  EXPECT_EQ(stats.compilation_cache.misses, 0);
+  EXPECT_EQ(stats.compilation_time_us, 0);
+}
+
+TEST(EvalCacheStatsTest, Precompile) {
+  ClearCompilationCache();
+  ResetEvalCacheStats();
+  ASSERT_OK_AND_ASSIGN(
+      auto expr,
+      arolla::expr::CallOp("math.add",
+                           {arolla::expr::CallOp(
+                                "koda_internal.input",
+                                {arolla::expr::Literal(arolla::Text("I")),
+                                 arolla::expr::Literal(arolla::Text("foo"))}),
+                            arolla::expr::Literal(1)}));
+  ASSERT_OK(PrecompileExprWithCompilationCache(
+      expr, {{"foo", arolla::GetQType<int32_t>()},
+             {"bar", arolla::GetQType<float>()}}));
+  auto foo_value = arolla::TypedValue::FromValue(1);
+  ASSERT_OK_AND_ASSIGN(
+      auto result,
+      EvalExprWithCompilationCache(expr, {{"foo", foo_value.AsRef()}}, {}));
+  EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds(2));
+  EvalCacheStats stats = GetEvalCacheStats();
+  EXPECT_EQ(stats.compilation_cache.misses, 1);
+  EXPECT_EQ(stats.compilation_cache.hits, 1);
+
+  EXPECT_THAT(PrecompileExprWithCompilationCache(expr, {}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "kd.eval() has missing inputs for: [I.foo]"));
+}
+
+TEST(EvalCacheStatsTest, SetCapacity) {
+  EXPECT_THAT(SetEvalCacheCapacity(0, 10),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("must be positive")));
+  ASSERT_OK(SetEvalCacheCapacity(64, 32));
+  EvalCacheStats stats = GetEvalCacheStats();
+  EXPECT_EQ(stats.transformation_cache.capacity, 64);
+  EXPECT_EQ(stats.transformation_cache.size, 0);
+  EXPECT_EQ(stats.compilation_cache.capacity, 32);
+  ASSERT_OK(SetEvalCacheCapacity(kDefaultEvalCacheCapacity,
+                                 kDefaultEvalCacheCapacity));
+}
+
 }  // namespace
 
 }  // namespace koladata::expr
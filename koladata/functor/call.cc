@@ -14,28 +14,60 @@
 //
 #include "koladata/functor/call.h"
 
+#include <algorithm>
+#include <array>
+#include <cstddef>
 #include <cstdint>
+#include <memory>
+#include <optional>
 #include <stack>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
+#include "absl/base/no_destructor.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/container/inlined_vector.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/match.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
+#include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
 #include "koladata/data_slice_qtype.h"
 #include "koladata/expr/expr_eval.h"
+#include "koladata/expr/expr_operators.h"
 #include "koladata/functor/functor.h"
 #include "koladata/functor/signature.h"
 #include "koladata/functor/signature_storage.h"
+#include "koladata/internal/cancellation.h"
 #include "koladata/internal/data_item.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/sharded_lru_cache.h"
+#include "koladata/internal/trace.h"
+#include "koladata/operators/core.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/expr/expr_node.h"
+#include "arolla/expr/expr_visitor.h"
+#include "arolla/expr/lambda_expr_operator.h"
 #include "arolla/expr/quote.h"
+#include "arolla/expr/registered_expr_operator.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/memory/optional_value.h"
+#include "arolla/qtype/qtype.h"
+#include "arolla/qtype/tuple_qtype.h"
 #include "arolla/qtype/typed_ref.h"
 #include "arolla/qtype/typed_value.h"
+#include "arolla/util/fast_dynamic_downcast_final.h"
+#include "arolla/util/fingerprint.h"
+#include "arolla/util/text.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata::functor {
@@ -103,26 +135,269 @@ absl::StatusOr<std::vector<std::string>> GetVariableEvaluationOrder(
   return res;
 }
 
-}  // namespace
+// Returns the expression of the variable `variable_name` with all the
+// references to the other variables replaced by `variable_exprs`. Non-expr
+// variables are returned as literals.
+absl::StatusOr<arolla::expr::ExprNodePtr> InlineVariable(
+    const DataSlice& functor, absl::string_view variable_name,
+    const absl::flat_hash_map<std::string, arolla::expr::ExprNodePtr>&
+        variable_exprs) {
+  ASSIGN_OR_RETURN(auto variable, functor.GetAttr(variable_name));
+  if (!variable.item().holds_value<arolla::expr::ExprQuote>()) {
+    return arolla::expr::ExprNode::MakeLiteralNode(
+        arolla::TypedValue::FromValue(std::move(variable)));
+  }
+  ASSIGN_OR_RETURN(auto expr,
+                   variable.item().value<arolla::expr::ExprQuote>().expr());
+  auto substitute = [&](arolla::expr::ExprNodePtr node)
+      -> absl::StatusOr<arolla::expr::ExprNodePtr> {
+    if (!node->is_op()) {
+      return node;
+    }
+    ASSIGN_OR_RETURN(auto decayed_op,
+                     arolla::expr::DecayRegisteredOperator(node->op()));
+    if (arolla::fast_dynamic_downcast_final<const expr::InputOperator*>(
+            decayed_op.get()) == nullptr) {
+      return node;
+    }
+    const auto& deps = node->node_deps();
+    if (deps[0]->qvalue()->UnsafeAs<arolla::Text>().view() != "V") {
+      return node;
+    }
+    auto name = deps[1]->qvalue()->UnsafeAs<arolla::Text>().view();
+    auto it = variable_exprs.find(name);
+    if (it == variable_exprs.end()) {
+      // Not reachable, since the variables are processed in topological order.
+      return absl::InternalError(absl::StrFormat(
+          "variable [%s] is used before it is computed", name));
+    }
+    return it->second;
+  };
+  return arolla::expr::Transform(expr, substitute);
+}
 
-absl::StatusOr<arolla::TypedValue> CallFunctorWithCompilationCache(
-    const DataSlice& functor, absl::Span<const arolla::TypedRef> args,
-    absl::Span<const std::pair<std::string, arolla::TypedRef>> kwargs) {
-  if (!IsFunctor(functor).value_or(false)) {
-    return absl::InvalidArgumentError(
-        "the first argument of kd.call must be a functor");
+// Evaluates the variables in `variable_evaluation_order` level by level, with
+// the variables of each level evaluated concurrently using `executor`.
+absl::StatusOr<arolla::TypedValue> EvaluateVariablesInParallel(
+    const DataSlice& functor,
+    absl::Span<const std::string> variable_evaluation_order,
+    absl::Span<const std::pair<std::string, arolla::TypedRef>> inputs,
+    internal::Executor* executor) {
+  struct Variable {
+    std::optional<arolla::expr::ExprNodePtr> expr;
+    std::vector<int64_t> dependencies;
+    std::optional<arolla::TypedValue> value;
+  };
+  const int64_t size = variable_evaluation_order.size();
+  absl::flat_hash_map<absl::string_view, int64_t> variable_index;
+  variable_index.reserve(size);
+  std::vector<Variable> variables(size);
+  std::vector<std::vector<int64_t>> levels;
+  std::vector<int64_t> variable_level(size, -1);
+  for (int64_t i = 0; i < size; ++i) {
+    const std::string& variable_name = variable_evaluation_order[i];
+    variable_index.emplace(variable_name, i);
+    ASSIGN_OR_RETURN(auto variable, functor.GetAttr(variable_name));
+    if (!variable.item().holds_value<arolla::expr::ExprQuote>()) {
+      variables[i].value = arolla::TypedValue::FromValue(std::move(variable));
+      continue;
+    }
+    ASSIGN_OR_RETURN(variables[i].expr,
+                     variable.item().value<arolla::expr::ExprQuote>().expr());
+    ASSIGN_OR_RETURN(auto dependency_names,
+                     expr::GetExprVariables(*variables[i].expr));
+    int64_t level = 0;
+    for (const auto& dependency_name : dependency_names) {
+      // The dependencies precede the variable in the evaluation order.
+      int64_t dependency = variable_index.at(dependency_name);
+      variables[i].dependencies.push_back(dependency);
+      level = std::max(level, variable_level[dependency] + 1);
+    }
+    variable_level[i] = level;
+    if (level >= levels.size()) {
+      levels.resize(level + 1);
+    }
+    levels[level].push_back(i);
+  }
+  for (const auto& level : levels) {
+    RETURN_IF_ERROR(internal::ParallelFor(
+        executor, level.size(), [&](int64_t j) -> absl::Status {
+          Variable& variable = variables[level[j]];
+          std::vector<std::pair<std::string, arolla::TypedRef>> dependencies;
+          dependencies.reserve(variable.dependencies.size());
+          for (int64_t dependency : variable.dependencies) {
+            dependencies.emplace_back(variable_evaluation_order[dependency],
+                                      variables[dependency].value->AsRef());
+          }
+          ASSIGN_OR_RETURN(variable.value,
+                           expr::EvalExprWithCompilationCache(
+                               *variable.expr, inputs, dependencies));
+          return absl::OkStatus();
+        }));
+  }
+  return *std::move(variables.back().value);
+}
+
+constexpr size_t kFunctorResultCacheCapacity = 1024;
+
+using FunctorResultCache =
+    internal::ShardedLruCache<arolla::Fingerprint,
+                              std::shared_ptr<const arolla::TypedValue>>;
+
+FunctorResultCache& GetFunctorResultCache() {
+  static absl::NoDestructor<FunctorResultCache> cache(
+      kFunctorResultCacheCapacity);
+  return *cache;
+}
+
+// Operators whose results may differ between calls with the same inputs.
+// Nested functor calls and Python functions are not analyzed.
+constexpr std::array<absl::string_view, 4> kNonDeterministicOpPrefixes = {
+    "kde.allocation.", "kde.functor.", "kde.py.", "kde.random."};
+constexpr std::array<absl::string_view, 4> kNonDeterministicOpNames = {
+    "kde.core._clone", "kde.core._deep_clone", "kde.core._shallow_clone",
+    "kde.schema._new_schema"};
+
+bool IsNonDeterministicOpName(absl::string_view name) {
+  for (absl::string_view prefix : kNonDeterministicOpPrefixes) {
+    if (absl::StartsWith(name, prefix)) {
+      return true;
+    }
   }
+  return absl::c_linear_search(kNonDeterministicOpNames, name);
+}
+
+// Returns true if `expr` does not use non-deterministic operators, including
+// in the bodies of the lambda operators it uses.
+bool IsDeterministicExpr(const arolla::expr::ExprNodePtr& expr) {
+  std::vector<arolla::expr::ExprNodePtr> stack = {expr};
+  absl::flat_hash_set<arolla::Fingerprint> visited;
+  while (!stack.empty()) {
+    arolla::expr::ExprNodePtr node = std::move(stack.back());
+    stack.pop_back();
+    if (!visited.insert(node->fingerprint()).second) {
+      continue;
+    }
+    stack.insert(stack.end(), node->node_deps().begin(),
+                 node->node_deps().end());
+    if (!node->is_op()) {
+      continue;
+    }
+    if (IsNonDeterministicOpName(node->op()->display_name())) {
+      return false;
+    }
+    auto decayed_op = arolla::expr::DecayRegisteredOperator(node->op());
+    if (!decayed_op.ok() ||
+        IsNonDeterministicOpName((*decayed_op)->display_name())) {
+      return false;
+    }
+    if (const auto* lambda_op = arolla::fast_dynamic_downcast_final<
+            const arolla::expr::LambdaOperator*>(decayed_op->get())) {
+      stack.push_back(lambda_op->lambda_body());
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<bool> IsDeterministicFunctor(
+    const DataSlice& functor,
+    absl::Span<const std::string> variable_evaluation_order) {
+  for (const auto& variable_name : variable_evaluation_order) {
+    ASSIGN_OR_RETURN(auto variable, functor.GetAttr(variable_name));
+    if (!variable.item().holds_value<arolla::expr::ExprQuote>()) {
+      continue;
+    }
+    ASSIGN_OR_RETURN(auto expr,
+                     variable.item().value<arolla::expr::ExprQuote>().expr());
+    if (!IsDeterministicExpr(expr)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+constexpr size_t kSignatureCacheCapacity = 1024;
+
+using SignatureCache =
+    internal::ShardedLruCache<arolla::Fingerprint,
+                              std::shared_ptr<const Signature>>;
+
+SignatureCache& GetSignatureCache() {
+  static absl::NoDestructor<SignatureCache> cache(kSignatureCacheCapacity);
+  return *cache;
+}
+
+// Returns the C++ signature of `functor`. Converting the Koda signature reads
+// every parameter from the DataBag, so the signatures from deeply immutable
+// DataBags, which can not change, are converted once and cached by the
+// fingerprint of the signature item.
+absl::StatusOr<std::shared_ptr<const Signature>> GetFunctorSignature(
+    const DataSlice& functor) {
   ASSIGN_OR_RETURN(auto signature_item, functor.GetAttr(kSignatureAttrName));
+  std::optional<arolla::Fingerprint> key;
+  if (IsDeeplyImmutable(signature_item.GetDb())) {
+    arolla::FingerprintHasher hasher("koladata.functor.signature");
+    hasher.Combine(signature_item);
+    key = std::move(hasher).Finish();
+    if (auto signature = GetSignatureCache().LookupOrNull(*key);
+        signature != nullptr) {
+      return signature;
+    }
+  }
   ASSIGN_OR_RETURN(auto signature, KodaSignatureToCppSignature(signature_item));
-  ASSIGN_OR_RETURN(auto bound_arguments,
-                   BindArguments(signature, args, kwargs));
-  ASSIGN_OR_RETURN(auto variable_evaluation_order,
-                   GetVariableEvaluationOrder(functor));
-  if (variable_evaluation_order.empty() ||
-      variable_evaluation_order.back() != kReturnsAttrName) {
-    return absl::InternalError(
-        "variable evaluation order does not end with returns");
+  auto res = std::make_shared<const Signature>(std::move(signature));
+  if (key.has_value()) {
+    return GetSignatureCache().Put(*key, std::move(res));
+  }
+  return res;
+}
+
+// Returns true if `value` can not change after it is memoized, i.e. it does
+// not refer to mutable DataBags.
+bool IsImmutableValue(arolla::TypedRef value) {
+  if (value.GetType() == arolla::GetQType<DataSlice>()) {
+    return IsDeeplyImmutable(value.UnsafeAs<DataSlice>().GetDb());
+  }
+  if (value.GetType() == arolla::GetQType<DataBagPtr>()) {
+    return IsDeeplyImmutable(value.UnsafeAs<DataBagPtr>());
+  }
+  for (int64_t i = 0; i < value.GetFieldCount(); ++i) {
+    if (!IsImmutableValue(value.GetField(i))) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns the key of the memoized result of the call, or nullopt if the
+// functor does not opt into the memoization or the call can not be memoized.
+absl::StatusOr<std::optional<arolla::Fingerprint>> GetMemoizationKey(
+    const DataSlice& functor,
+    absl::Span<const arolla::TypedValue> bound_arguments) {
+  static absl::NoDestructor<DataSlice> missing{*DataSlice::Create(
+      internal::DataItem(arolla::kMissing), internal::DataItem(schema::kMask))};
+  ASSIGN_OR_RETURN(auto memoize,
+                   functor.GetAttrWithDefault(kMemoizeAttrName, *missing));
+  if (!memoize.item().holds_value<bool>() || !memoize.item().value<bool>() ||
+      !IsDeeplyImmutable(functor.GetDb())) {
+    return std::nullopt;
+  }
+  arolla::FingerprintHasher hasher("koladata.functor.memoized_result");
+  hasher.Combine(functor);
+  for (const auto& argument : bound_arguments) {
+    if (!IsImmutableValue(argument.AsRef())) {
+      return std::nullopt;
+    }
+    hasher.Combine(argument.GetFingerprint());
   }
+  return std::move(hasher).Finish();
+}
+
+absl::StatusOr<arolla::TypedValue> EvaluateFunctor(
+    const DataSlice& functor, const Signature& signature,
+    absl::Span<const arolla::TypedValue> bound_arguments,
+    absl::Span<const std::string> variable_evaluation_order,
+    internal::Executor* executor) {
   std::vector<arolla::TypedValue> computed_variable_holder;
   std::vector<std::pair<std::string, arolla::TypedRef>> inputs;
   std::vector<std::pair<std::string, arolla::TypedRef>> variables;
@@ -131,6 +406,10 @@ absl::StatusOr<arolla::TypedValue> CallFunctorWithCompilationCache(
   for (int64_t i = 0; i < parameters.size(); ++i) {
     inputs.emplace_back(parameters[i].name, bound_arguments[i].AsRef());
   }
+  if (executor != nullptr) {
+    return EvaluateVariablesInParallel(functor, variable_evaluation_order,
+                                       inputs, executor);
+  }
   computed_variable_holder.reserve(variable_evaluation_order.size());
   variables.reserve(variable_evaluation_order.size());
   for (const auto& variable_name : variable_evaluation_order) {
@@ -154,4 +433,458 @@ absl::StatusOr<arolla::TypedValue> CallFunctorWithCompilationCache(
   return computed_variable_holder.back();
 }
 
+}  // namespace
+
+FunctorPlan::FunctorPlan(Signature signature, arolla::expr::ExprNodePtr expr)
+    : signature_(std::move(signature)), expr_(std::move(expr)) {}
+
+absl::StatusOr<FunctorPlan> FunctorPlan::Create(const DataSlice& functor) {
+  if (!IsFunctor(functor).value_or(false)) {
+    return absl::InvalidArgumentError(
+        "the first argument of kd.call must be a functor");
+  }
+  ASSIGN_OR_RETURN(auto signature, GetFunctorSignature(functor));
+  ASSIGN_OR_RETURN(auto variable_evaluation_order,
+                   GetVariableEvaluationOrder(functor));
+  if (variable_evaluation_order.empty() ||
+      variable_evaluation_order.back() != kReturnsAttrName) {
+    return absl::InternalError(
+        "variable evaluation order does not end with returns");
+  }
+  absl::flat_hash_map<std::string, arolla::expr::ExprNodePtr> variable_exprs;
+  variable_exprs.reserve(variable_evaluation_order.size());
+  for (const auto& variable_name : variable_evaluation_order) {
+    ASSIGN_OR_RETURN(auto variable_expr,
+                     InlineVariable(functor, variable_name, variable_exprs));
+    variable_exprs.emplace(variable_name, std::move(variable_expr));
+  }
+  return FunctorPlan(*signature,
+                     std::move(variable_exprs[kReturnsAttrName]));
+}
+
+absl::StatusOr<arolla::TypedValue> FunctorPlan::Call(
+    absl::Span<const arolla::TypedRef> args,
+    absl::Span<const std::pair<std::string, arolla::TypedRef>> kwargs) const {
+  ASSIGN_OR_RETURN(auto bound_arguments,
+                   BindArguments(signature_, args, kwargs));
+  std::vector<arolla::TypedRef> bound_refs;
+  bound_refs.reserve(bound_arguments.size());
+  for (const auto& value : bound_arguments) {
+    bound_refs.push_back(value.AsRef());
+  }
+  return CallWithBoundArguments(bound_refs);
+}
+
+absl::StatusOr<arolla::TypedValue> FunctorPlan::CallWithBoundArguments(
+    absl::Span<const arolla::TypedRef> bound_arguments) const {
+  const auto& parameters = signature_.parameters();
+  if (bound_arguments.size() != parameters.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected %d bound arguments, got %d", parameters.size(),
+        bound_arguments.size()));
+  }
+  absl::InlinedVector<std::pair<std::string, arolla::TypedRef>, 8> inputs;
+  inputs.reserve(parameters.size());
+  for (int64_t i = 0; i < parameters.size(); ++i) {
+    inputs.emplace_back(parameters[i].name, bound_arguments[i]);
+  }
+  return expr::EvalExprWithCompilationCache(expr_, inputs, {});
+}
+
+absl::Status FunctorPlan::Precompile(
+    absl::Span<const arolla::QTypePtr> parameter_qtypes) const {
+  const auto& parameters = signature_.parameters();
+  if (parameter_qtypes.size() != parameters.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected %d parameter qtypes, got %d", parameters.size(),
+        parameter_qtypes.size()));
+  }
+  std::vector<std::pair<std::string, arolla::QTypePtr>> input_qtypes;
+  input_qtypes.reserve(parameters.size());
+  for (int64_t i = 0; i < parameters.size(); ++i) {
+    input_qtypes.emplace_back(parameters[i].name, parameter_qtypes[i]);
+  }
+  return expr::PrecompileExprWithCompilationCache(expr_, input_qtypes);
+}
+
+bool FunctorPlan::IsIdentityBinding(size_t num_args) const {
+  const auto& parameters = signature_.parameters();
+  if (num_args != parameters.size()) {
+    return false;
+  }
+  for (const auto& parameter : parameters) {
+    if (parameter.kind != Signature::Parameter::Kind::kPositionalOnly &&
+        parameter.kind != Signature::Parameter::Kind::kPositionalOrKeyword) {
+      return false;
+    }
+  }
+  return true;
+}
+
+absl::StatusOr<std::vector<arolla::TypedValue>> FunctorPlan::CallBatch(
+    absl::Span<const std::vector<arolla::TypedRef>> args_batch,
+    internal::Executor* executor) const {
+  constexpr int64_t kMinChunkSize = 16;
+  const int64_t batch_size = args_batch.size();
+  const auto& parameters = signature_.parameters();
+  std::vector<std::optional<arolla::TypedValue>> results(batch_size);
+  int64_t num_chunks =
+      internal::ParallelChunkCount(executor, batch_size, kMinChunkSize);
+  RETURN_IF_ERROR(internal::ParallelFor(
+      executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+        int64_t begin = batch_size * chunk / num_chunks;
+        int64_t end = batch_size * (chunk + 1) / num_chunks;
+        // The input names are set once per chunk and only the values are
+        // replaced for each call.
+        std::vector<std::pair<std::string, arolla::TypedRef>> inputs;
+        inputs.reserve(parameters.size());
+        for (const auto& parameter : parameters) {
+          inputs.emplace_back(parameter.name,
+                              arolla::TypedRef::UnsafeFromRawPointer(
+                                  arolla::GetNothingQType(), nullptr));
+        }
+        for (int64_t i = begin; i < end; ++i) {
+          absl::Span<const arolla::TypedRef> args = args_batch[i];
+          std::vector<arolla::TypedValue> bound_arguments;
+          if (IsIdentityBinding(args.size())) {
+            for (int64_t j = 0; j < args.size(); ++j) {
+              inputs[j].second = args[j];
+            }
+          } else {
+            ASSIGN_OR_RETURN(bound_arguments,
+                             BindArguments(signature_, args, {}));
+            for (int64_t j = 0; j < bound_arguments.size(); ++j) {
+              inputs[j].second = bound_arguments[j].AsRef();
+            }
+          }
+          ASSIGN_OR_RETURN(
+              results[i], expr::EvalExprWithCompilationCache(expr_, inputs, {}));
+        }
+        return absl::OkStatus();
+      }));
+  std::vector<arolla::TypedValue> res;
+  res.reserve(batch_size);
+  for (auto& result : results) {
+    res.push_back(*std::move(result));
+  }
+  return res;
+}
+
+namespace {
+
+// Returns the rows [begin, end) of `impl`. The arrays are sliced without
+// copying the values.
+internal::DataSliceImpl SliceImpl(const internal::DataSliceImpl& impl,
+                                  int64_t begin, int64_t end) {
+  if (impl.is_empty_and_unknown()) {
+    return internal::DataSliceImpl::CreateEmptyAndUnknownType(end - begin);
+  }
+  internal::DataSliceImpl::Builder bldr(end - begin);
+  impl.VisitValues([&]<class T>(const arolla::DenseArray<T>& values) {
+    bldr.AddArray(values.Slice(begin, end - begin));
+  });
+  // A superset of the allocations of the rows.
+  bldr.GetMutableAllocationIds().Insert(impl.allocation_ids());
+  return std::move(bldr).Build();
+}
+
+// Returns the rows [begin, end) of the first dimension of `ds`, which must
+// have rank >= 1, with everything nested in them.
+absl::StatusOr<DataSlice> SliceFirstDimension(const DataSlice& ds,
+                                              int64_t begin, int64_t end) {
+  const auto& edges = ds.GetShape().edges();
+  std::vector<arolla::DenseArrayEdge> chunk_edges;
+  chunk_edges.reserve(edges.size());
+  ASSIGN_OR_RETURN(auto first_edge,
+                   arolla::DenseArrayEdge::FromUniformGroups(1, end - begin));
+  chunk_edges.push_back(std::move(first_edge));
+  for (size_t i = 1; i < edges.size(); ++i) {
+    absl::Span<const int64_t> split_points =
+        edges[i].edge_values().values.span();
+    arolla::Buffer<int64_t>::Builder chunk_split_points(end - begin + 1);
+    for (int64_t j = begin; j <= end; ++j) {
+      chunk_split_points.Set(j - begin, split_points[j] - split_points[begin]);
+    }
+    chunk_edges.push_back(arolla::DenseArrayEdge::UnsafeFromSplitPoints(
+        arolla::DenseArray<int64_t>{std::move(chunk_split_points).Build()}));
+    const int64_t child_begin = split_points[begin];
+    const int64_t child_end = split_points[end];
+    begin = child_begin;
+    end = child_end;
+  }
+  ASSIGN_OR_RETURN(auto shape,
+                   DataSlice::JaggedShape::FromEdges(std::move(chunk_edges)));
+  return DataSlice::Create(SliceImpl(ds.slice(), begin, end), std::move(shape),
+                           ds.GetSchemaImpl(), ds.GetDb());
+}
+
+}  // namespace
+
+absl::StatusOr<arolla::TypedValue> FunctorPlan::CallChunked(
+    absl::Span<const arolla::TypedRef> bound_arguments,
+    const ChunkedCallOptions& options) const {
+  if (options.chunk_size <= 0) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "chunk_size must be positive, got %d", options.chunk_size));
+  }
+  std::optional<int64_t> rows;
+  std::vector<bool> is_chunked(bound_arguments.size(), false);
+  for (int64_t i = 0; i < bound_arguments.size(); ++i) {
+    if (bound_arguments[i].GetType() != arolla::GetQType<DataSlice>()) {
+      continue;
+    }
+    const auto& shape = bound_arguments[i].UnsafeAs<DataSlice>().GetShape();
+    if (shape.rank() == 0) {
+      continue;
+    }
+    const int64_t arg_rows = shape.edges().front().child_size();
+    if (rows.has_value() && *rows != arg_rows) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "chunked arguments must have the same first dimension, got %d and "
+          "%d",
+          *rows, arg_rows));
+    }
+    rows = arg_rows;
+    is_chunked[i] = true;
+  }
+  if (!rows.has_value() || *rows <= options.chunk_size) {
+    return CallWithBoundArguments(bound_arguments);
+  }
+
+  const int64_t num_chunks =
+      (*rows + options.chunk_size - 1) / options.chunk_size;
+  std::vector<std::optional<DataSlice>> results(num_chunks);
+  RETURN_IF_ERROR(internal::ParallelFor(
+      options.executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+        const int64_t begin = chunk * options.chunk_size;
+        const int64_t end = std::min(*rows, begin + options.chunk_size);
+        std::vector<arolla::TypedValue> chunk_values;
+        chunk_values.reserve(bound_arguments.size());
+        absl::InlinedVector<arolla::TypedRef, 8> chunk_args(
+            bound_arguments.begin(), bound_arguments.end());
+        for (int64_t i = 0; i < bound_arguments.size(); ++i) {
+          if (!is_chunked[i]) {
+            continue;
+          }
+          ASSIGN_OR_RETURN(
+              auto arg, SliceFirstDimension(
+                            bound_arguments[i].UnsafeAs<DataSlice>(), begin,
+                            end));
+          chunk_values.push_back(arolla::TypedValue::FromValue(std::move(arg)));
+          chunk_args[i] = chunk_values.back().AsRef();
+        }
+        ASSIGN_OR_RETURN(auto result, CallWithBoundArguments(chunk_args));
+        if (result.GetType() != arolla::GetQType<DataSlice>()) {
+          return absl::InvalidArgumentError(absl::StrFormat(
+              "chunked evaluation requires the functor to return a DataSlice, "
+              "got %s",
+              result.GetType()->name()));
+        }
+        const DataSlice& result_slice = result.UnsafeAs<DataSlice>();
+        const auto& result_shape = result_slice.GetShape();
+        if (result_shape.rank() == 0 ||
+            result_shape.edges().front().child_size() != end - begin) {
+          return absl::InvalidArgumentError(
+              "chunked evaluation requires the functor to return a row per "
+              "row of the first dimension of the arguments");
+        }
+        results[chunk] = result_slice;
+        return absl::OkStatus();
+      }));
+
+  // The chunks are concatenated along the first dimension.
+  ASSIGN_OR_RETURN(auto stack,
+                   DataSlice::Create(internal::DataItem(false),
+                                     internal::DataItem(schema::kBool)));
+  ASSIGN_OR_RETURN(auto ndim,
+                   DataSlice::Create(internal::DataItem(static_cast<int64_t>(
+                                         results[0]->GetShape().rank())),
+                                     internal::DataItem(schema::kInt64)));
+  std::vector<const DataSlice*> concat_args = {&stack, &ndim};
+  concat_args.reserve(num_chunks + 2);
+  for (const auto& result : results) {
+    concat_args.push_back(&*result);
+  }
+  ASSIGN_OR_RETURN(auto result, ops::ConcatOrStack(concat_args));
+  return arolla::TypedValue::FromValue(std::move(result));
+}
+
+namespace {
+
+constexpr size_t kFunctorPlanCacheCapacity = 1024;
+
+using FunctorPlanCache =
+    internal::ShardedLruCache<arolla::Fingerprint,
+                              std::shared_ptr<const FunctorPlan>>;
+
+FunctorPlanCache& GetFunctorPlanCache() {
+  static absl::NoDestructor<FunctorPlanCache> cache(kFunctorPlanCacheCapacity);
+  return *cache;
+}
+
+// Returns the plan of `functor`, which must be in a deeply immutable DataBag.
+// The plans are cached by the fingerprint of the functor.
+absl::StatusOr<std::shared_ptr<const FunctorPlan>> GetCachedFunctorPlan(
+    const DataSlice& functor) {
+  arolla::FingerprintHasher hasher("koladata.functor.plan");
+  hasher.Combine(functor);
+  arolla::Fingerprint key = std::move(hasher).Finish();
+  if (auto plan = GetFunctorPlanCache().LookupOrNull(key); plan != nullptr) {
+    return plan;
+  }
+  ASSIGN_OR_RETURN(auto plan, FunctorPlan::Create(functor));
+  return GetFunctorPlanCache().Put(
+      key, std::make_shared<const FunctorPlan>(std::move(plan)));
+}
+
+}  // namespace
+
+absl::StatusOr<arolla::TypedValue> CallFunctorWithCompilationCache(
+    const DataSlice& functor, absl::Span<const arolla::TypedRef> args,
+    absl::Span<const std::pair<std::string, arolla::TypedRef>> kwargs,
+    internal::Executor* executor) {
+  internal::TraceSpan span("functor", "kd.call");
+  span.AddArg("arg_count", static_cast<int64_t>(args.size() + kwargs.size()));
+  if (!IsFunctor(functor).value_or(false)) {
+    return absl::InvalidArgumentError(
+        "the first argument of kd.call must be a functor");
+  }
+  ASSIGN_OR_RETURN(auto signature, GetFunctorSignature(functor));
+  ASSIGN_OR_RETURN(auto bound_arguments,
+                   BindArguments(*signature, args, kwargs));
+  ASSIGN_OR_RETURN(auto memoization_key,
+                   GetMemoizationKey(functor, bound_arguments));
+  if (memoization_key.has_value()) {
+    if (auto result = GetFunctorResultCache().LookupOrNull(*memoization_key);
+        result != nullptr) {
+      span.AddArg("result_cache", std::string("hit"));
+      return *result;
+    }
+  }
+  // Functors that can not change are evaluated as a single inlined
+  // expression. The parallel evaluation works per variable, and memoization
+  // needs the variables to check that the functor is deterministic.
+  if (executor == nullptr && !memoization_key.has_value() &&
+      IsDeeplyImmutable(functor.GetDb())) {
+    ASSIGN_OR_RETURN(auto plan, GetCachedFunctorPlan(functor));
+    absl::InlinedVector<arolla::TypedRef, 8> bound_refs;
+    bound_refs.reserve(bound_arguments.size());
+    for (const auto& value : bound_arguments) {
+      bound_refs.push_back(value.AsRef());
+    }
+    return plan->CallWithBoundArguments(bound_refs);
+  }
+  ASSIGN_OR_RETURN(auto variable_evaluation_order,
+                   GetVariableEvaluationOrder(functor));
+  if (variable_evaluation_order.empty() ||
+      variable_evaluation_order.back() != kReturnsAttrName) {
+    return absl::InternalError(
+        "variable evaluation order does not end with returns");
+  }
+  ASSIGN_OR_RETURN(auto result,
+                   EvaluateFunctor(functor, *signature, bound_arguments,
+                                   variable_evaluation_order, executor));
+  if (memoization_key.has_value() && IsImmutableValue(result.AsRef())) {
+    ASSIGN_OR_RETURN(
+        bool is_deterministic,
+        IsDeterministicFunctor(functor, variable_evaluation_order));
+    if (is_deterministic) {
+      GetFunctorResultCache().Put(
+          *memoization_key, std::make_shared<const arolla::TypedValue>(result));
+    }
+  }
+  return result;
+}
+
+absl::Status PrecompileFunctor(const DataSlice& functor) {
+  std::shared_ptr<const FunctorPlan> plan;
+  if (IsDeeplyImmutable(functor.GetDb())) {
+    ASSIGN_OR_RETURN(plan, GetCachedFunctorPlan(functor));
+  } else {
+    ASSIGN_OR_RETURN(auto uncached_plan, FunctorPlan::Create(functor));
+    plan = std::make_shared<const FunctorPlan>(std::move(uncached_plan));
+  }
+  std::vector<arolla::QTypePtr> parameter_qtypes;
+  parameter_qtypes.reserve(plan->signature().parameters().size());
+  for (const auto& parameter : plan->signature().parameters()) {
+    switch (parameter.kind) {
+      case Signature::Parameter::Kind::kVarPositional:
+        parameter_qtypes.push_back(arolla::MakeTupleQType({}));
+        break;
+      case Signature::Parameter::Kind::kVarKeyword: {
+        ASSIGN_OR_RETURN(auto empty_kwargs_qtype,
+                         arolla::MakeNamedTupleQType(
+                             absl::Span<const std::string>(),
+                             arolla::MakeTupleQType({})));
+        parameter_qtypes.push_back(empty_kwargs_qtype);
+        break;
+      }
+      default:
+        parameter_qtypes.push_back(arolla::GetQType<DataSlice>());
+    }
+  }
+  return plan->Precompile(parameter_qtypes);
+}
+
+absl::StatusOr<arolla::TypedValue> CallFunctorChunked(
+    const DataSlice& functor, absl::Span<const arolla::TypedRef> args,
+    absl::Span<const std::pair<std::string, arolla::TypedRef>> kwargs,
+    const ChunkedCallOptions& options) {
+  internal::TraceSpan span("functor", "kd.call_chunked");
+  std::shared_ptr<const FunctorPlan> plan;
+  if (IsDeeplyImmutable(functor.GetDb())) {
+    ASSIGN_OR_RETURN(plan, GetCachedFunctorPlan(functor));
+  } else {
+    ASSIGN_OR_RETURN(auto uncached_plan, FunctorPlan::Create(functor));
+    plan = std::make_shared<const FunctorPlan>(std::move(uncached_plan));
+  }
+  ASSIGN_OR_RETURN(auto bound_arguments,
+                   BindArguments(plan->signature(), args, kwargs));
+  absl::InlinedVector<arolla::TypedRef, 8> bound_refs;
+  bound_refs.reserve(bound_arguments.size());
+  for (const auto& value : bound_arguments) {
+    bound_refs.push_back(value.AsRef());
+  }
+  return plan->CallChunked(bound_refs, options);
+}
+
+void CallFunctorAsync(
+    DataSlice functor, std::vector<arolla::TypedValue> args,
+    std::vector<std::pair<std::string, arolla::TypedValue>> kwargs,
+    internal::Executor* executor,
+    std::shared_ptr<const internal::CancellationToken> cancellation,
+    absl::AnyInvocable<void(absl::StatusOr<arolla::TypedValue>) &&> done) {
+  auto task = [functor = std::move(functor), args = std::move(args),
+               kwargs = std::move(kwargs),
+               cancellation = std::move(cancellation),
+               done = std::move(done)]() mutable {
+    internal::ScopedCancellationToken cancellation_scope(cancellation.get());
+    std::move(done)([&]() -> absl::StatusOr<arolla::TypedValue> {
+      RETURN_IF_ERROR(internal::CheckCancellation());
+      std::vector<arolla::TypedRef> arg_refs;
+      arg_refs.reserve(args.size());
+      for (const auto& arg : args) {
+        arg_refs.push_back(arg.AsRef());
+      }
+      std::vector<std::pair<std::string, arolla::TypedRef>> kwarg_refs;
+      kwarg_refs.reserve(kwargs.size());
+      for (const auto& [name, value] : kwargs) {
+        kwarg_refs.emplace_back(name, value.AsRef());
+      }
+      return CallFunctorWithCompilationCache(functor, arg_refs, kwarg_refs);
+    }());
+  };
+  if (executor == nullptr) {
+    std::move(task)();
+  } else {
+    executor->Schedule(std::move(task));
+  }
+}
+
+void ClearFunctorResultCache() { GetFunctorResultCache().Clear(); }
+
+internal::LruCacheStats GetFunctorResultCacheStats() {
+  return GetFunctorResultCache().GetStats();
+}
+
 }  // namespace koladata::functor
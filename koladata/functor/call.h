@@ -15,12 +15,23 @@
 #ifndef KOLADATA_FUNCTOR_CALL_H_
 #define KOLADATA_FUNCTOR_CALL_H_
 
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/functional/any_invocable.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "koladata/data_slice.h"
+#include "koladata/functor/signature.h"
+#include "koladata/internal/cancellation.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/sharded_lru_cache.h"
+#include "arolla/expr/expr_node.h"
+#include "arolla/qtype/qtype.h"
 #include "arolla/qtype/typed_ref.h"
 #include "arolla/qtype/typed_value.h"
 
@@ -35,9 +46,142 @@ namespace koladata::functor {
 // via V.foo, in which case the variable expression will be evaluated before
 // evaluating the expression that refers to it. In case of a cycle in variables,
 // an error will be returned.
+//
+// When `executor` is not null, the variables that do not depend on each other
+// are evaluated concurrently: the variables are grouped into levels by the
+// length of their longest dependency chain, and each level is evaluated in
+// parallel once the previous one is done. If a variable fails, the variables
+// not yet started are skipped and the error is returned. The result is the
+// same as for the sequential evaluation.
+//
+// When the functor has a `__memoize__` attribute set to true, the results are
+// memoized in a process-wide LRU cache keyed by the fingerprints of the
+// functor and of the bound arguments. A result is only memoized if the
+// functor, the arguments and the result have no mutable DataBags (including
+// the fallbacks), and if the functor does not use non-deterministic operators
+// (allocation, cloning, random, Python and nested functor calls).
 absl::StatusOr<arolla::TypedValue> CallFunctorWithCompilationCache(
     const DataSlice& functor, absl::Span<const arolla::TypedRef> args,
-    absl::Span<const std::pair<std::string, arolla::TypedRef>> kwargs);
+    absl::Span<const std::pair<std::string, arolla::TypedRef>> kwargs,
+    internal::Executor* executor = nullptr);
+
+// Schedules CallFunctorWithCompilationCache(functor, args, kwargs) on
+// `executor` and passes the result to `done`, which is called on the executor
+// thread. The variables of the functor are evaluated sequentially on that
+// thread. When `executor` is nullptr, the functor is called and `done` is
+// called on the calling thread before returning.
+//
+// When `cancellation` is not null, it is checked before the call and before
+// the evaluation of every variable, including those of the nested functor
+// calls. Once it is cancelled, `done` receives a CancelledError.
+void CallFunctorAsync(
+    DataSlice functor, std::vector<arolla::TypedValue> args,
+    std::vector<std::pair<std::string, arolla::TypedValue>> kwargs,
+    internal::Executor* executor,
+    std::shared_ptr<const internal::CancellationToken> cancellation,
+    absl::AnyInvocable<void(absl::StatusOr<arolla::TypedValue>) &&> done);
+
+// Clears the cache of the memoized functor results.
+void ClearFunctorResultCache();
+
+// Returns the usage statistics of the cache of the memoized functor results.
+internal::LruCacheStats GetFunctorResultCacheStats();
+
+// Options of the chunked evaluation of functors, see FunctorPlan::CallChunked.
+struct ChunkedCallOptions {
+  // Number of rows of the first dimension evaluated at once. Small enough for
+  // the intermediate values of pointwise functors to stay in the L2 cache.
+  int64_t chunk_size = 1 << 14;
+  // When not null, the chunks are evaluated concurrently.
+  internal::Executor* executor = nullptr;
+};
+
+// A functor prepared for repeated calls. The signature is parsed and the
+// variables are inlined into the returns expression in evaluation order once,
+// on creation, so that each call evaluates a single expression with a single
+// compilation cache lookup instead of one per variable.
+//
+// A variable referenced several times is inlined as a shared sub-expression,
+// so it is still evaluated once per call.
+class FunctorPlan {
+ public:
+  static absl::StatusOr<FunctorPlan> Create(const DataSlice& functor);
+
+  const Signature& signature() const { return signature_; }
+
+  // The returns expression with all the variables inlined. Refers only to the
+  // inputs (I.foo) named after the signature parameters.
+  const arolla::expr::ExprNodePtr& expr() const { return expr_; }
+
+  // Same as CallFunctorWithCompilationCache on the functor the plan was
+  // created from.
+  absl::StatusOr<arolla::TypedValue> Call(
+      absl::Span<const arolla::TypedRef> args,
+      absl::Span<const std::pair<std::string, arolla::TypedRef>> kwargs) const;
+
+  // Calls the plan with the values of the signature parameters, in the order
+  // of signature().parameters(), as returned by BindArguments. Skips the
+  // argument binding.
+  absl::StatusOr<arolla::TypedValue> CallWithBoundArguments(
+      absl::Span<const arolla::TypedRef> bound_arguments) const;
+
+  // Compiles the plan for the signature parameters of the given qtypes, in
+  // the order of signature().parameters(), so that the first call with
+  // arguments of these qtypes does not pay for the compilation. Calls with
+  // other qtypes are compiled on first use as usual.
+  absl::Status Precompile(
+      absl::Span<const arolla::QTypePtr> parameter_qtypes) const;
+
+  // Calls the plan once per element of `args_batch`, each holding the
+  // positional arguments of one call. Returns the results in the same order.
+  // When `executor` is not null, the batch is split into contiguous chunks
+  // processed concurrently. Returns the error of the first failed call.
+  absl::StatusOr<std::vector<arolla::TypedValue>> CallBatch(
+      absl::Span<const std::vector<arolla::TypedRef>> args_batch,
+      internal::Executor* executor = nullptr) const;
+
+  // Same as CallWithBoundArguments, but splits the DataSlice arguments of
+  // rank >= 1 into chunks of `options.chunk_size` rows along their first
+  // dimension, evaluates the plan on each chunk and concatenates the results.
+  // The intermediate values are then never larger than a chunk, instead of
+  // being materialized for the whole input.
+  //
+  // Only valid for functors that process the rows of the first dimension
+  // independently, e.g. pointwise operations and aggregations over the inner
+  // dimensions; aggregations over the whole input can be applied to the
+  // result. The chunked arguments must have the same first dimension, and the
+  // result of every chunk must be a DataSlice with a row per input row.
+  // Other arguments (e.g. DataItems) are passed to every chunk as is. Inputs
+  // that fit in a single chunk are evaluated with a single call.
+  absl::StatusOr<arolla::TypedValue> CallChunked(
+      absl::Span<const arolla::TypedRef> bound_arguments,
+      const ChunkedCallOptions& options) const;
+
+ private:
+  FunctorPlan(Signature signature, arolla::expr::ExprNodePtr expr);
+
+  // Returns true if positional arguments can be used as the bound arguments
+  // as is.
+  bool IsIdentityBinding(size_t num_args) const;
+
+  Signature signature_;
+  arolla::expr::ExprNodePtr expr_;
+};
+
+// Compiles `functor` for calls where every positional and keyword argument is
+// a DataSlice and no variadic arguments are passed. When the functor is in a
+// deeply immutable DataBag, CallFunctorWithCompilationCache evaluates it
+// through a cached FunctorPlan, so such calls skip both the per-variable
+// evaluation and the compilation. Otherwise only the compilation of the
+// inlined expression is cached, which the calls do not use.
+absl::Status PrecompileFunctor(const DataSlice& functor);
+
+// Calls `functor` through FunctorPlan::CallChunked, see its requirements. The
+// plan is cached when the functor is in a deeply immutable DataBag.
+absl::StatusOr<arolla::TypedValue> CallFunctorChunked(
+    const DataSlice& functor, absl::Span<const arolla::TypedRef> args,
+    absl::Span<const std::pair<std::string, arolla::TypedRef>> kwargs,
+    const ChunkedCallOptions& options = {});
 
 }  // namespace koladata::functor
 
@@ -17,6 +17,9 @@
 #include "koladata/functor/call.h"
 
 #include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -25,14 +28,22 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
+#include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
+#include "koladata/expr/expr_eval.h"
 #include "koladata/functor/functor.h"
 #include "koladata/functor/signature.h"
 #include "koladata/functor/signature_storage.h"
+#include "koladata/internal/cancellation.h"
 #include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/testing/matchers.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
 #include "arolla/expr/expr.h"
 #include "arolla/expr/expr_node.h"
 #include "arolla/expr/quote.h"
@@ -48,6 +59,9 @@ namespace {
 using ::absl_testing::IsOkAndHolds;
 using ::absl_testing::StatusIs;
 using ::koladata::testing::IsEquivalentTo;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
 
 absl::StatusOr<arolla::expr::ExprNodePtr> CreateInput(absl::string_view name) {
   return arolla::expr::CallOp("koda_internal.input",
@@ -131,6 +145,65 @@ TEST(CallTest, VariableRhombus) {
                   },
                   {{"c", inputs[1].AsRef()}, {"b", inputs[2].AsRef()}}));
   EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds(2 * ((4 + 5) + (4 + 3))));
+
+  internal::ThreadPoolExecutor executor(4);
+  ASSERT_OK_AND_ASSIGN(
+      result, CallFunctorWithCompilationCache(
+                  fn,
+                  {
+                      inputs[0].AsRef(),
+                  },
+                  {{"c", inputs[1].AsRef()}, {"b", inputs[2].AsRef()}},
+                  &executor));
+  EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds(2 * ((4 + 5) + (4 + 3))));
+}
+
+TEST(CallTest, ParallelVariables) {
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({}));
+  ASSERT_OK_AND_ASSIGN(auto koda_signature,
+                       CppSignatureToKodaSignature(signature));
+  constexpr int kNumVariables = 20;
+  std::vector<std::pair<std::string, DataSlice>> variables;
+  arolla::expr::ExprNodePtr sum = arolla::expr::Literal(0);
+  for (int i = 0; i < kNumVariables; ++i) {
+    std::string name = absl::StrCat("v", i);
+    ASSERT_OK_AND_ASSIGN(
+        auto var_expr,
+        WrapExpr(arolla::expr::CallOp(
+            "math.multiply",
+            {arolla::expr::Literal(i), arolla::expr::Literal(i)})));
+    variables.emplace_back(name, var_expr);
+    ASSERT_OK_AND_ASSIGN(auto variable, CreateVariable(name));
+    ASSERT_OK_AND_ASSIGN(sum,
+                         arolla::expr::CallOp("math.add", {sum, variable}));
+  }
+  ASSERT_OK_AND_ASSIGN(auto returns_expr, WrapExpr(sum));
+  ASSERT_OK_AND_ASSIGN(auto fn,
+                       CreateFunctor(returns_expr, koda_signature, variables));
+  internal::ThreadPoolExecutor executor(4);
+  int expected = 0;
+  for (int i = 0; i < kNumVariables; ++i) {
+    expected += i * i;
+  }
+  ASSERT_OK_AND_ASSIGN(auto result,
+                       CallFunctorWithCompilationCache(fn, {}, {}));
+  EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds(expected));
+  ASSERT_OK_AND_ASSIGN(result,
+                       CallFunctorWithCompilationCache(fn, {}, {}, &executor));
+  EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds(expected));
+
+  // An error in one of the variables is propagated.
+  ASSERT_OK_AND_ASSIGN(
+      auto bad_expr,
+      WrapExpr(arolla::expr::CallOp(
+          "math.floordiv",
+          {arolla::expr::Literal(1), arolla::expr::Literal(0)})));
+  variables[7].second = bad_expr;
+  ASSERT_OK_AND_ASSIGN(fn,
+                       CreateFunctor(returns_expr, koda_signature, variables));
+  EXPECT_THAT(CallFunctorWithCompilationCache(fn, {}, {}, &executor),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("division by zero")));
 }
 
 TEST(CallTest, VariableCycle) {
@@ -201,6 +274,154 @@ TEST(CallTest, DataSliceVariable) {
               IsOkAndHolds(IsEquivalentTo(var_a.WithDb(fn.GetDb()))));
 }
 
+TEST(CallTest, Memoization) {
+  Signature::Parameter p1 = {
+      .name = "a",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({p1}));
+  ASSERT_OK_AND_ASSIGN(auto koda_signature,
+                       CppSignatureToKodaSignature(signature));
+  ASSERT_OK_AND_ASSIGN(auto returns_expr, WrapExpr(CreateInput("a")));
+  ASSERT_OK_AND_ASSIGN(auto memoize,
+                       DataSlice::Create(internal::DataItem(true),
+                                         internal::DataItem(schema::kBool)));
+  ASSERT_OK_AND_ASSIGN(
+      auto fn, CreateFunctor(returns_expr, koda_signature,
+                             {{std::string(kMemoizeAttrName), memoize}}));
+  ASSERT_OK_AND_ASSIGN(auto frozen_fn, fn.Freeze());
+  ClearFunctorResultCache();
+  auto stats = GetFunctorResultCacheStats();
+
+  auto input = arolla::TypedValue::FromValue(2);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(
+        auto result,
+        CallFunctorWithCompilationCache(frozen_fn, {input.AsRef()}, {}));
+    EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds(2));
+  }
+  auto new_stats = GetFunctorResultCacheStats();
+  EXPECT_EQ(new_stats.hits - stats.hits, 1);
+  EXPECT_EQ(new_stats.misses - stats.misses, 1);
+  EXPECT_EQ(new_stats.size, 1);
+
+  // A functor with a mutable DataBag is not memoized.
+  stats = new_stats;
+  ASSERT_OK_AND_ASSIGN(
+      auto result, CallFunctorWithCompilationCache(fn, {input.AsRef()}, {}));
+  EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds(2));
+  new_stats = GetFunctorResultCacheStats();
+  EXPECT_EQ(new_stats.hits, stats.hits);
+  EXPECT_EQ(new_stats.misses, stats.misses);
+
+  // Neither are the calls with mutable arguments.
+  ASSERT_OK_AND_ASSIGN(auto mutable_input,
+                       DataSlice::Create(internal::DataItem(2),
+                                         internal::DataItem(schema::kInt32),
+                                         DataBag::Empty()));
+  ASSERT_OK_AND_ASSIGN(
+      result, CallFunctorWithCompilationCache(
+                  frozen_fn, {arolla::TypedRef::FromValue(mutable_input)}, {}));
+  EXPECT_THAT(result.As<DataSlice>(),
+              IsOkAndHolds(IsEquivalentTo(mutable_input)));
+  new_stats = GetFunctorResultCacheStats();
+  EXPECT_EQ(new_stats.hits, stats.hits);
+  EXPECT_EQ(new_stats.misses, stats.misses);
+}
+
+TEST(CallTest, PrecompiledFrozenFunctor) {
+  Signature::Parameter p1 = {
+      .name = "a",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({p1}));
+  ASSERT_OK_AND_ASSIGN(auto koda_signature,
+                       CppSignatureToKodaSignature(signature));
+  ASSERT_OK_AND_ASSIGN(auto returns_expr, WrapExpr(CreateVariable("b")));
+  ASSERT_OK_AND_ASSIGN(auto var_b_expr, WrapExpr(CreateInput("a")));
+  ASSERT_OK_AND_ASSIGN(auto fn, CreateFunctor(returns_expr, koda_signature,
+                                              {{"b", var_b_expr}}));
+  ASSERT_OK_AND_ASSIGN(auto frozen_fn, fn.Freeze());
+  expr::ClearCompilationCache();
+  ASSERT_OK(PrecompileFunctor(frozen_fn));
+  auto stats = expr::GetEvalCacheStats();
+
+  ASSERT_OK_AND_ASSIGN(auto input,
+                       DataSlice::Create(internal::DataItem(43),
+                                         internal::DataItem(schema::kInt32)));
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(
+        auto result,
+        CallFunctorWithCompilationCache(
+            frozen_fn, {arolla::TypedRef::FromValue(input)}, {}));
+    EXPECT_THAT(result.As<DataSlice>(), IsOkAndHolds(IsEquivalentTo(input)));
+  }
+  auto new_stats = expr::GetEvalCacheStats();
+  EXPECT_EQ(new_stats.compilation_cache.misses,
+            stats.compilation_cache.misses);
+  EXPECT_EQ(new_stats.compilation_cache.hits - stats.compilation_cache.hits,
+            2);
+
+  // Other qtypes are compiled on the first call.
+  auto int_input = arolla::TypedValue::FromValue(2);
+  ASSERT_OK_AND_ASSIGN(
+      auto result,
+      CallFunctorWithCompilationCache(frozen_fn, {int_input.AsRef()}, {}));
+  EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds(2));
+  EXPECT_EQ(expr::GetEvalCacheStats().compilation_cache.misses,
+            stats.compilation_cache.misses + 1);
+}
+
+TEST(CallTest, Async) {
+  Signature::Parameter p1 = {
+      .name = "a",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({p1}));
+  ASSERT_OK_AND_ASSIGN(auto koda_signature,
+                       CppSignatureToKodaSignature(signature));
+  ASSERT_OK_AND_ASSIGN(auto returns_expr,
+                       WrapExpr(arolla::expr::CallOp(
+                           "math.add", {CreateVariable("b"),
+                                        arolla::expr::Literal(1)})));
+  ASSERT_OK_AND_ASSIGN(
+      auto var_b_expr,
+      WrapExpr(arolla::expr::CallOp(
+          "math.multiply", {CreateInput("a"), arolla::expr::Literal(2)})));
+  ASSERT_OK_AND_ASSIGN(auto fn, CreateFunctor(returns_expr, koda_signature,
+                                              {{"b", var_b_expr}}));
+
+  std::optional<absl::StatusOr<arolla::TypedValue>> result;
+  std::optional<absl::StatusOr<arolla::TypedValue>> cancelled_result;
+  std::optional<absl::StatusOr<arolla::TypedValue>> inline_result;
+  auto cancellation = std::make_shared<internal::CancellationToken>();
+  cancellation->Cancel();
+  {
+    internal::ThreadPoolExecutor executor(2);
+    CallFunctorAsync(
+        fn, {arolla::TypedValue::FromValue(3)}, {}, &executor, nullptr,
+        [&](absl::StatusOr<arolla::TypedValue> r) { result = std::move(r); });
+    CallFunctorAsync(fn, {}, {{"a", arolla::TypedValue::FromValue(3)}},
+                     &executor, cancellation,
+                     [&](absl::StatusOr<arolla::TypedValue> r) {
+                       cancelled_result = std::move(r);
+                     });
+    // The destructor waits for the scheduled calls.
+  }
+  CallFunctorAsync(fn, {arolla::TypedValue::FromValue(4)}, {}, nullptr,
+                   nullptr, [&](absl::StatusOr<arolla::TypedValue> r) {
+                     inline_result = std::move(r);
+                   });
+  ASSERT_TRUE(result.has_value());
+  ASSERT_OK_AND_ASSIGN(auto value, *result);
+  EXPECT_THAT(value.As<int32_t>(), IsOkAndHolds(7));
+  ASSERT_TRUE(cancelled_result.has_value());
+  EXPECT_THAT(*cancelled_result, StatusIs(absl::StatusCode::kCancelled));
+  ASSERT_TRUE(inline_result.has_value());
+  ASSERT_OK_AND_ASSIGN(value, *inline_result);
+  EXPECT_THAT(value.As<int32_t>(), IsOkAndHolds(9));
+}
+
 TEST(CallTest, EvalError) {
   Signature::Parameter p1 = {
       .name = "a",
@@ -236,6 +457,216 @@ TEST(CallTest, EvalError) {
                "expression"));
 }
 
+TEST(FunctorPlanTest, VariableRhombus) {
+  Signature::Parameter p1 = {
+      .name = "a",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  Signature::Parameter p2 = {
+      .name = "b",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({p1, p2}));
+  ASSERT_OK_AND_ASSIGN(auto koda_signature,
+                       CppSignatureToKodaSignature(signature));
+  ASSERT_OK_AND_ASSIGN(
+      auto returns_expr,
+      WrapExpr(arolla::expr::CallOp(
+          "math.multiply", {CreateVariable("c"), CreateVariable("d")})));
+  ASSERT_OK_AND_ASSIGN(
+      auto var_c_expr,
+      WrapExpr(arolla::expr::CallOp(
+          "math.add", {CreateVariable("e"), arolla::expr::Literal(5)})));
+  ASSERT_OK_AND_ASSIGN(
+      auto var_d_expr,
+      WrapExpr(arolla::expr::CallOp("math.add",
+                                    {CreateVariable("e"), CreateInput("b")})));
+  ASSERT_OK_AND_ASSIGN(auto var_e_expr, WrapExpr(CreateInput("a")));
+  ASSERT_OK_AND_ASSIGN(auto fn, CreateFunctor(returns_expr, koda_signature,
+                                              {{"c", var_c_expr},
+                                               {"d", var_d_expr},
+                                               {"e", var_e_expr}}));
+  ASSERT_OK_AND_ASSIGN(auto plan, FunctorPlan::Create(fn));
+  EXPECT_THAT(expr::GetExprVariables(plan.expr()), IsOkAndHolds(IsEmpty()));
+  EXPECT_THAT(expr::GetExprInputs(plan.expr()),
+              IsOkAndHolds(ElementsAre("a", "b")));
+
+  auto a = arolla::TypedValue::FromValue(2);
+  auto b = arolla::TypedValue::FromValue(3);
+  for (int i = 0; i < 2; ++i) {
+    ASSERT_OK_AND_ASSIGN(auto result, plan.Call({a.AsRef(), b.AsRef()}, {}));
+    EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds((2 + 5) * (2 + 3)));
+    ASSERT_OK_AND_ASSIGN(result, plan.Call({b.AsRef()}, {{"b", a.AsRef()}}));
+    EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds((3 + 5) * (3 + 2)));
+    ASSERT_OK_AND_ASSIGN(result,
+                         plan.CallWithBoundArguments({a.AsRef(), b.AsRef()}));
+    EXPECT_THAT(result.As<int32_t>(), IsOkAndHolds((2 + 5) * (2 + 3)));
+  }
+  EXPECT_THAT(plan.CallWithBoundArguments({a.AsRef()}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "expected 2 bound arguments, got 1"));
+}
+
+TEST(FunctorPlanTest, CallBatch) {
+  Signature::Parameter p1 = {
+      .name = "a",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  Signature::Parameter p2 = {
+      .name = "b",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({p1, p2}));
+  ASSERT_OK_AND_ASSIGN(auto koda_signature,
+                       CppSignatureToKodaSignature(signature));
+  ASSERT_OK_AND_ASSIGN(
+      auto returns_expr,
+      WrapExpr(arolla::expr::CallOp("math.multiply",
+                                    {CreateInput("a"), CreateInput("b")})));
+  ASSERT_OK_AND_ASSIGN(auto fn,
+                       CreateFunctor(returns_expr, koda_signature, {}));
+  ASSERT_OK_AND_ASSIGN(auto plan, FunctorPlan::Create(fn));
+
+  constexpr int kBatchSize = 100;
+  std::vector<arolla::TypedValue> values;
+  for (int i = 0; i < kBatchSize; ++i) {
+    values.push_back(arolla::TypedValue::FromValue(i));
+  }
+  std::vector<std::vector<arolla::TypedRef>> args_batch;
+  for (int i = 0; i < kBatchSize; ++i) {
+    args_batch.push_back({values[i].AsRef(), values[i % 3].AsRef()});
+  }
+  internal::ThreadPoolExecutor executor(4);
+  for (internal::Executor* e : {static_cast<internal::Executor*>(nullptr),
+                                static_cast<internal::Executor*>(&executor)}) {
+    ASSERT_OK_AND_ASSIGN(auto results, plan.CallBatch(args_batch, e));
+    ASSERT_EQ(results.size(), kBatchSize);
+    for (int i = 0; i < kBatchSize; ++i) {
+      EXPECT_THAT(results[i].As<int32_t>(), IsOkAndHolds(i * (i % 3)));
+    }
+  }
+
+  args_batch[57].pop_back();
+  EXPECT_THAT(plan.CallBatch(args_batch, &executor),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("no value provided for")));
+}
+
+TEST(FunctorPlanTest, CallChunked) {
+  Signature::Parameter p1 = {
+      .name = "a",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  Signature::Parameter p2 = {
+      .name = "b",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({p1, p2}));
+  ASSERT_OK_AND_ASSIGN(auto koda_signature,
+                       CppSignatureToKodaSignature(signature));
+  ASSERT_OK_AND_ASSIGN(auto returns_a, WrapExpr(CreateInput("a")));
+  ASSERT_OK_AND_ASSIGN(auto fn_a, CreateFunctor(returns_a, koda_signature, {}));
+  ASSERT_OK_AND_ASSIGN(auto returns_b, WrapExpr(CreateInput("b")));
+  ASSERT_OK_AND_ASSIGN(auto fn_b, CreateFunctor(returns_b, koda_signature, {}));
+
+  ASSERT_OK_AND_ASSIGN(
+      auto edge, arolla::DenseArrayEdge::FromSplitPoints(
+                     arolla::CreateDenseArray<int64_t>({0, 2, 2, 5, 6, 9})));
+  ASSERT_OK_AND_ASSIGN(auto shape, DataSlice::JaggedShape::FlatFromSize(5)
+                                       .AddDims({std::move(edge)}));
+  ASSERT_OK_AND_ASSIGN(
+      auto a, DataSlice::CreateWithSchemaFromData(
+                  internal::DataSliceImpl::Create(
+                      arolla::CreateDenseArray<int>(
+                          {1, 2, std::nullopt, 4, 5, 6, 7, std::nullopt, 9})),
+                  std::move(shape)));
+  ASSERT_OK_AND_ASSIGN(
+      auto b, DataSlice::Create(
+                  internal::DataSliceImpl::Create(
+                      {internal::DataItem(1), internal::DataItem(),
+                       internal::DataItem(arolla::Text("x")),
+                       internal::DataItem(2.5f), internal::DataItem(3)}),
+                  DataSlice::JaggedShape::FlatFromSize(5),
+                  internal::DataItem(schema::kObject)));
+  auto a_value = arolla::TypedValue::FromValue(a);
+  auto b_value = arolla::TypedValue::FromValue(b);
+
+  internal::ThreadPoolExecutor executor(4);
+  for (internal::Executor* e : {static_cast<internal::Executor*>(nullptr),
+                                static_cast<internal::Executor*>(&executor)}) {
+    for (int64_t chunk_size : {1, 2, 5, 100}) {
+      ChunkedCallOptions options{.chunk_size = chunk_size, .executor = e};
+      ASSERT_OK_AND_ASSIGN(auto plan_a, FunctorPlan::Create(fn_a));
+      ASSERT_OK_AND_ASSIGN(
+          auto result,
+          plan_a.CallChunked({a_value.AsRef(), b_value.AsRef()}, options));
+      EXPECT_THAT(result.As<DataSlice>(), IsOkAndHolds(IsEquivalentTo(a)))
+          << chunk_size;
+      ASSERT_OK_AND_ASSIGN(
+          result, CallFunctorChunked(fn_b, {a_value.AsRef(), b_value.AsRef()},
+                                     {}, options));
+      EXPECT_THAT(result.As<DataSlice>(), IsOkAndHolds(IsEquivalentTo(b)))
+          << chunk_size;
+    }
+  }
+
+  ChunkedCallOptions options{.chunk_size = 2};
+  auto item_value = arolla::TypedValue::FromValue(
+      *DataSlice::Create(internal::DataItem(1),
+                         internal::DataItem(schema::kInt32)));
+  EXPECT_THAT(
+      CallFunctorChunked(fn_b, {a_value.AsRef(), item_value.AsRef()}, {},
+                         options),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("to return a row per row of the first dimension")));
+  auto short_value = arolla::TypedValue::FromValue(
+      *DataSlice::CreateWithSchemaFromData(
+          internal::DataSliceImpl::Create(arolla::CreateDenseArray<int>({1})),
+          DataSlice::JaggedShape::FlatFromSize(1)));
+  EXPECT_THAT(
+      CallFunctorChunked(fn_a, {a_value.AsRef(), short_value.AsRef()}, {},
+                         options),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               "chunked arguments must have the same first dimension, got 5 "
+               "and 1"));
+}
+
+TEST(FunctorPlanTest, DataSliceVariable) {
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({}));
+  ASSERT_OK_AND_ASSIGN(auto koda_signature,
+                       CppSignatureToKodaSignature(signature));
+  ASSERT_OK_AND_ASSIGN(auto returns_expr, WrapExpr(CreateVariable("a")));
+  ASSERT_OK_AND_ASSIGN(auto var_a,
+                       DataSlice::Create(internal::DataItem(57),
+                                         internal::DataItem(schema::kInt32)));
+  ASSERT_OK_AND_ASSIGN(
+      auto fn, CreateFunctor(returns_expr, koda_signature, {{"a", var_a}}));
+  ASSERT_OK_AND_ASSIGN(auto plan, FunctorPlan::Create(fn));
+  ASSERT_OK_AND_ASSIGN(auto result, plan.Call({}, {}));
+  EXPECT_THAT(result.As<DataSlice>(),
+              IsOkAndHolds(IsEquivalentTo(var_a.WithDb(fn.GetDb()))));
+}
+
+TEST(FunctorPlanTest, Errors) {
+  ASSERT_OK_AND_ASSIGN(auto not_functor,
+                       DataSlice::Create(internal::DataItem(57),
+                                         internal::DataItem(schema::kInt32)));
+  EXPECT_THAT(FunctorPlan::Create(not_functor),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "the first argument of kd.call must be a functor"));
+
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({}));
+  ASSERT_OK_AND_ASSIGN(auto koda_signature,
+                       CppSignatureToKodaSignature(signature));
+  ASSERT_OK_AND_ASSIGN(auto returns_expr, WrapExpr(CreateVariable("a")));
+  ASSERT_OK_AND_ASSIGN(auto var_a_expr, WrapExpr(CreateVariable("a")));
+  ASSERT_OK_AND_ASSIGN(auto fn, CreateFunctor(returns_expr, koda_signature,
+                                              {{"a", var_a_expr}}));
+  EXPECT_THAT(FunctorPlan::Create(fn),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "variable [a] has a dependency cycle"));
+}
+
 }  // namespace
 
 }  // namespace koladata::functor
@@ -32,6 +32,10 @@ constexpr absl::string_view kReturnsAttrName = "returns";
 // The attribute name used to store the signature in a functor.
 constexpr absl::string_view kSignatureAttrName = "__signature__";
 
+// The attribute name used to opt a functor into the memoization of its
+// results (see CallFunctorWithCompilationCache).
+constexpr absl::string_view kMemoizeAttrName = "__memoize__";
+
 // Creates a functor with the given returns expression, signature,
 // and variables.
 // returns must contain a DataItem holding a quoted Expr.
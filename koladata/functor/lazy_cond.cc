@@ -0,0 +1,196 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/functor/lazy_cond.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/algorithm/container.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/data_slice.h"
+#include "koladata/data_slice_qtype.h"
+#include "koladata/expr/expr_eval.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/op_utils/selection_vector.h"
+#include "koladata/operators/core.h"
+#include "koladata/operators/logical.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/expr/expr_node.h"
+#include "arolla/expr/quote.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/qtype/typed_ref.h"
+#include "arolla/util/repr.h"
+#include "arolla/util/unit.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::functor {
+namespace {
+
+absl::StatusOr<arolla::expr::ExprNodePtr> GetBranchExpr(
+    const DataSlice& branch, absl::string_view name) {
+  if (branch.GetShape().rank() != 0 ||
+      !branch.item().holds_value<arolla::expr::ExprQuote>()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "`%s` argument of _lazy_cond must be a quoted expression", name));
+  }
+  return branch.item().value<arolla::expr::ExprQuote>().expr();
+}
+
+absl::StatusOr<DataSlice> EvalBranch(const arolla::expr::ExprNodePtr& expr,
+                                     absl::Span<const DataSlice> args) {
+  std::vector<std::pair<std::string, arolla::TypedRef>> inputs;
+  inputs.reserve(args.size());
+  for (int64_t i = 0; i < args.size(); ++i) {
+    inputs.emplace_back(absl::StrCat("x", i),
+                        arolla::TypedRef::FromValue(args[i]));
+  }
+  ASSIGN_OR_RETURN(auto result,
+                   expr::EvalExprWithCompilationCache(expr, inputs, {}));
+  ASSIGN_OR_RETURN(auto result_ds, result.As<DataSlice>());
+  return result_ds.get();
+}
+
+// Returns the index of the parent row for each child row of `edge`.
+arolla::DenseArray<int64_t> BroadcastIndices(
+    const arolla::DenseArrayEdge& edge) {
+  if (edge.edge_type() == arolla::DenseArrayEdge::MAPPING) {
+    return edge.edge_values();
+  }
+  absl::Span<const int64_t> splits = edge.edge_values().values.span();
+  arolla::Buffer<int64_t>::Builder indices_bldr(edge.child_size());
+  absl::Span<int64_t> indices = indices_bldr.GetMutableSpan();
+  for (int64_t i = 0; i + 1 < splits.size(); ++i) {
+    std::fill(indices.begin() + splits[i], indices.begin() + splits[i + 1], i);
+  }
+  return arolla::DenseArray<int64_t>{std::move(indices_bldr).Build()};
+}
+
+// Evaluates the branch `expr` only on the items of `args` selected by `mask`.
+// The result is missing for the other items. Returns std::nullopt if `args`
+// can't be aligned with `mask`, in which case the branch should be evaluated on
+// all the items.
+absl::StatusOr<std::optional<DataSlice>> EvalBranchOnSelected(
+    const arolla::expr::ExprNodePtr& expr, absl::Span<const DataSlice> args,
+    const DataSlice& mask) {
+  const DataSlice::JaggedShape& shape = mask.GetShape();
+  if (shape.rank() == 0 || mask.GetSchemaImpl() != schema::kMask) {
+    return std::nullopt;
+  }
+  if (absl::c_all_of(args, [](const DataSlice& arg) {
+        return arg.GetShape().rank() == 0;
+      })) {
+    // The branch is evaluated on scalars, selecting doesn't save anything.
+    return std::nullopt;
+  }
+  ASSIGN_OR_RETURN(auto selected_mask,
+                   ops::Select(mask, mask, /*expand_filter=*/false));
+  const DataSlice::JaggedShape& selected_shape = selected_mask.GetShape();
+  const arolla::DenseArray<arolla::Unit> mask_array =
+      mask.present_count() == 0
+          ? arolla::CreateEmptyDenseArray<arolla::Unit>(mask.size())
+          : mask.slice().values<arolla::Unit>();
+  std::vector<DataSlice> selected_args;
+  selected_args.reserve(args.size());
+  for (const DataSlice& arg : args) {
+    if (arg.GetShape().rank() == 0) {
+      selected_args.push_back(arg);
+      continue;
+    }
+    if (!ShapeIsBroadcastableTo(arg.GetShape(), shape)) {
+      return std::nullopt;
+    }
+    // The broadcasting and the selection are composed on the row indices, so
+    // that the values are gathered once and the broadcast arg is not built.
+    internal::SelectionVector rows =
+        arg.GetShape().rank() == shape.rank()
+            ? internal::SelectionVector(arg.slice())
+            : internal::SelectionVector(
+                  arg.slice(),
+                  BroadcastIndices(arg.GetShape().GetBroadcastEdge(shape)));
+    ASSIGN_OR_RETURN(rows, rows.Select(mask_array));
+    ASSIGN_OR_RETURN(selected_args.emplace_back(),
+                     DataSlice::Create(rows.Materialize(), selected_shape,
+                                       arg.GetSchemaImpl(), arg.GetDb()));
+  }
+  ASSIGN_OR_RETURN(auto result, EvalBranch(expr, selected_args));
+  if (result.GetShape().rank() == 0) {
+    // The branch ignores the selected args, the caller broadcasts the result.
+    return result;
+  }
+  if (!ShapesAreEquivalent(result.GetShape(), selected_shape)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "the branches of _lazy_cond must be pointwise, got a result of shape "
+        "%s for inputs of shape %s",
+        arolla::Repr(result.GetShape()), arolla::Repr(selected_shape)));
+  }
+  ASSIGN_OR_RETURN(auto scattered, ops::ReverseSelect(result, mask));
+  return scattered;
+}
+
+// Evaluates the branch `expr` once, on the items selected by `mask` if
+// possible.
+absl::StatusOr<DataSlice> EvalLazyBranch(
+    const arolla::expr::ExprNodePtr& expr, absl::Span<const DataSlice> args,
+    const DataSlice& mask) {
+  if (mask.GetShape().rank() > 0 && mask.present_count() == mask.size()) {
+    // All the items are selected, so there is nothing to gather.
+    return EvalBranch(expr, args);
+  }
+  ASSIGN_OR_RETURN(auto result, EvalBranchOnSelected(expr, args, mask));
+  if (result.has_value()) {
+    return *std::move(result);
+  }
+  return EvalBranch(expr, args);
+}
+
+}  // namespace
+
+absl::StatusOr<DataSlice> LazyCond(absl::Span<const DataSlice* const> args) {
+  if (args.size() < 3) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "_lazy_cond expected at least 3 arguments, but got %d", args.size()));
+  }
+  ASSIGN_OR_RETURN(auto yes_expr, GetBranchExpr(*args[0], "yes"));
+  ASSIGN_OR_RETURN(auto no_expr, GetBranchExpr(*args[1], "no"));
+  const DataSlice& condition = *args[2];
+  std::vector<DataSlice> branch_args;
+  branch_args.reserve(args.size() - 3);
+  for (const DataSlice* arg : args.subspan(3)) {
+    branch_args.push_back(*arg);
+  }
+  // The same operators as in kde.logical.cond:
+  //   (yes & condition) | (no & ~condition)
+  ASSIGN_OR_RETURN(auto has_condition, ops::Has(condition));
+  ASSIGN_OR_RETURN(auto not_condition, ops::HasNot(has_condition));
+  ASSIGN_OR_RETURN(auto yes, EvalLazyBranch(yes_expr, branch_args, condition));
+  ASSIGN_OR_RETURN(auto no,
+                   EvalLazyBranch(no_expr, branch_args, not_condition));
+  ASSIGN_OR_RETURN(auto masked_yes, ops::ApplyMask(yes, condition));
+  ASSIGN_OR_RETURN(auto masked_no, ops::ApplyMask(no, not_condition));
+  return ops::Coalesce(masked_yes, masked_no);
+}
+
+}  // namespace koladata::functor
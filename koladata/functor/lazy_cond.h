@@ -0,0 +1,45 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_FUNCTOR_LAZY_COND_H_
+#define KOLADATA_FUNCTOR_LAZY_COND_H_
+
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "koladata/data_slice.h"
+
+namespace koladata::functor {
+
+// kde.logical._lazy_cond(yes, no, condition, *args).
+//
+// Same as kde.logical.cond(condition, yes(*args), no(*args)), where `yes` and
+// `no` are quoted pointwise expressions over inputs `I.x0`, `I.x1`, ...
+// referring to `args`. The expressions are created by kd.eval() from
+// kde.logical.cond with expensive branches.
+//
+// Each branch is evaluated once, only on the selected items of `args` (all the
+// items for `yes` if the condition is present everywhere); when nothing is
+// selected for it, the branch is evaluated on empty inputs, which only
+// determines the schema of its result. Branches whose `args` are all scalars
+// or can't be aligned with the condition are evaluated on all the items.
+//
+// So for the items on which both branches succeed, the result is the same as
+// for kde.logical.cond. But unlike kde.logical.cond, whose branches are
+// evaluated on all the items before it is called, errors that a branch raises
+// only for the items that are not selected for it are not raised.
+absl::StatusOr<DataSlice> LazyCond(absl::Span<const DataSlice* const> args);
+
+}  // namespace koladata::functor
+
+#endif  // KOLADATA_FUNCTOR_LAZY_COND_H_
@@ -0,0 +1,213 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// This file contains only basic tests, the kd.eval rewrite creating
+// kde.logical._lazy_cond is tested in Python.
+
+#include "koladata/functor/lazy_cond.h"
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/data_slice.h"
+#include "koladata/data_slice_qtype.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/test_utils.h"
+#include "koladata/testing/matchers.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/expr/basic_expr_operator.h"
+#include "arolla/expr/expr.h"
+#include "arolla/expr/expr_node.h"
+#include "arolla/expr/expr_operator.h"
+#include "arolla/expr/expr_operator_signature.h"
+#include "arolla/expr/quote.h"
+#include "arolla/memory/optional_value.h"
+#include "arolla/qtype/qtype.h"
+#include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/fingerprint.h"
+#include "arolla/util/text.h"
+#include "arolla/util/unit.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::functor {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::koladata::testing::IsEquivalentTo;
+using ::testing::HasSubstr;
+using DataSliceEdge = ::koladata::DataSlice::JaggedShape::Edge;
+
+constexpr auto kPresent = arolla::kUnit;
+constexpr auto kMissing = std::nullopt;
+
+// Exposes a Koda QExpr operator on two DataSlices, since the expression
+// operators are defined in Python.
+class BinaryDataSliceOperator final
+    : public arolla::expr::BackendExprOperatorTag,
+      public arolla::expr::BasicExprOperator {
+ public:
+  explicit BinaryDataSliceOperator(absl::string_view name)
+      : BasicExprOperator(
+            name, arolla::expr::ExprOperatorSignature{{"x"}, {"y"}}, "",
+            arolla::FingerprintHasher(
+                "::koladata::functor::BinaryDataSliceOperator")
+                .Combine(name)
+                .Finish()) {}
+
+  absl::StatusOr<arolla::QTypePtr> GetOutputQType(
+      absl::Span<const arolla::QTypePtr> input_qtypes) const final {
+    return arolla::GetQType<DataSlice>();
+  }
+};
+
+absl::StatusOr<arolla::expr::ExprNodePtr> CreateInput(absl::string_view name) {
+  return arolla::expr::CallOp("koda_internal.input",
+                              {arolla::expr::Literal(arolla::Text("I")),
+                               arolla::expr::Literal(arolla::Text(name))});
+}
+
+absl::StatusOr<DataSlice> Quote(
+    absl::StatusOr<arolla::expr::ExprNodePtr> expr_or_error) {
+  ASSIGN_OR_RETURN(auto expr, expr_or_error);
+  return DataSlice::Create(
+      internal::DataItem(arolla::expr::ExprQuote(std::move(expr))),
+      internal::DataItem(schema::kExpr));
+}
+
+absl::StatusOr<arolla::expr::ExprNodePtr> Binary(
+    absl::string_view op_name, absl::StatusOr<arolla::expr::ExprNodePtr> x,
+    absl::StatusOr<arolla::expr::ExprNodePtr> y) {
+  return arolla::expr::CallOp(
+      std::make_shared<BinaryDataSliceOperator>(op_name), {x, y});
+}
+
+// kde.logical._lazy_cond(I.x0 // I.x1, I.x0 - I.x1, condition, x, y).
+absl::StatusOr<DataSlice> FloorDivOrSubtract(const DataSlice& condition,
+                                             const DataSlice& x,
+                                             const DataSlice& y) {
+  ASSIGN_OR_RETURN(auto yes, Quote(Binary("kde.math.floordiv",
+                                          CreateInput("x0"),
+                                          CreateInput("x1"))));
+  ASSIGN_OR_RETURN(auto no, Quote(Binary("kde.math.subtract",
+                                         CreateInput("x0"),
+                                         CreateInput("x1"))));
+  return LazyCond({&yes, &no, &condition, &x, &y});
+}
+
+TEST(LazyCondTest, SparseSelection) {
+  auto condition = test::DataSlice<arolla::Unit>(
+      {kPresent, kMissing, kMissing, kMissing}, schema::kMask);
+  auto x = test::DataSlice<int>({7, 8, 9, 10});
+  // The zeros are not selected for the floordiv branch.
+  auto y = test::DataSlice<int>({2, 0, 0, 3});
+  EXPECT_THAT(FloorDivOrSubtract(condition, x, y),
+              IsOkAndHolds(IsEquivalentTo(test::DataSlice<int>({3, 8, 9, 7}))));
+
+  y = test::DataSlice<int>({0, 1, 1, 1});
+  EXPECT_THAT(FloorDivOrSubtract(condition, x, y),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("division by zero")));
+}
+
+TEST(LazyCondTest, DenseSelection) {
+  auto condition = test::DataSlice<arolla::Unit>(
+      {kPresent, kPresent, kPresent, kMissing}, schema::kMask);
+  auto x = test::DataSlice<int>({7, 8, 9, 10});
+  // Same as for the sparse selection.
+  auto y = test::DataSlice<int>({2, 4, 3, 0});
+  EXPECT_THAT(
+      FloorDivOrSubtract(condition, x, y),
+      IsOkAndHolds(IsEquivalentTo(test::DataSlice<int>({3, 2, 3, 10}))));
+
+  y = test::DataSlice<int>({2, 0, 3, 1});
+  EXPECT_THAT(FloorDivOrSubtract(condition, x, y),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("division by zero")));
+}
+
+TEST(LazyCondTest, BroadcastArgs) {
+  ASSERT_OK_AND_ASSIGN(
+      auto shape,
+      DataSlice::JaggedShape::FromEdges(
+          {*DataSliceEdge::FromSplitPoints(
+               arolla::CreateFullDenseArray(std::vector<int64_t>{0, 2})),
+           *DataSliceEdge::FromSplitPoints(
+               arolla::CreateFullDenseArray(std::vector<int64_t>{0, 2, 5}))}));
+  auto condition = test::DataSlice<arolla::Unit>(
+      {kPresent, kMissing, kMissing, kMissing, kMissing}, shape,
+      schema::kMask);
+  auto x = test::DataSlice<int>({7, 8, 9, 10, 11}, shape);
+  // The zero is broadcast to the items that are not selected for the floordiv
+  // branch.
+  auto y = test::DataSlice<int>({2, 0});
+  EXPECT_THAT(FloorDivOrSubtract(condition, x, y),
+              IsOkAndHolds(IsEquivalentTo(
+                  test::DataSlice<int>({3, 6, 9, 10, 11}, shape))));
+}
+
+TEST(LazyCondTest, EmptySelection) {
+  auto condition = test::DataSlice<arolla::Unit>(
+      {kMissing, kMissing, kMissing}, schema::kMask);
+  auto x = test::DataSlice<int>({7, 8, 9});
+  auto y = test::DataSlice<int>({0, 0, 0});
+  EXPECT_THAT(FloorDivOrSubtract(condition, x, y),
+              IsOkAndHolds(IsEquivalentTo(test::DataSlice<int>({7, 8, 9}))));
+}
+
+TEST(LazyCondTest, ScalarArgs) {
+  auto condition = test::DataSlice<arolla::Unit>(
+      {kPresent, kMissing, kMissing, kMissing}, schema::kMask);
+  auto x = test::DataItem(7);
+  EXPECT_THAT(FloorDivOrSubtract(condition, x, test::DataItem(2)),
+              IsOkAndHolds(IsEquivalentTo(test::DataSlice<int>({3, 5, 5, 5}))));
+
+  // Branches on scalars only are evaluated eagerly, even if nothing is
+  // selected for them.
+  auto no_items = test::DataSlice<arolla::Unit>({kMissing, kMissing},
+                                                schema::kMask);
+  EXPECT_THAT(FloorDivOrSubtract(no_items, x, test::DataItem(0)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("division by zero")));
+
+  // A scalar arg is used for all the selected items.
+  EXPECT_THAT(
+      FloorDivOrSubtract(condition, test::DataSlice<int>({7, 8, 9, 10}),
+                         test::DataItem(0)),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("division by zero")));
+}
+
+TEST(LazyCondTest, NotQuotedBranch) {
+  auto condition = test::DataSlice<arolla::Unit>({kPresent}, schema::kMask);
+  auto x = test::DataItem(1);
+  EXPECT_THAT(LazyCond({&x, &x, &condition}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("`yes` argument of _lazy_cond must be a "
+                                 "quoted expression")));
+}
+
+}  // namespace
+}  // namespace koladata::functor
@@ -15,6 +15,8 @@
 #include <memory>
 
 #include "koladata/functor/call_operator.h"
+#include "koladata/functor/lazy_cond.h"
+#include "arolla/qexpr/operator_factory.h"
 #include "arolla/qexpr/optools.h"
 
 namespace koladata::functor {
@@ -24,6 +26,8 @@ namespace {
 
 // go/keep-sorted start ignore_prefixes=OPERATOR,OPERATOR_FAMILY
 OPERATOR_FAMILY("kde.functor.call", std::make_unique<CallOperatorFamily>());
+OPERATOR_FAMILY("kde.logical._lazy_cond",
+                arolla::MakeVariadicInputOperatorFamily(LazyCond));
 // go/keep-sorted end
 
 }  // namespace
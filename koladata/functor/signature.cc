@@ -102,12 +102,59 @@ Signature::Signature(absl::Span<const Parameter> parameters)
         parameter.kind == Signature::Parameter::Kind::kPositionalOrKeyword) {
       keyword_parameter_index_[parameter.name] = i;
     }
+    if ((parameter.kind == Signature::Parameter::Kind::kPositionalOnly ||
+         parameter.kind == Signature::Parameter::Kind::kPositionalOrKeyword) &&
+        positional_parameter_count_ == i) {
+      ++positional_parameter_count_;
+    }
   }
 }
 
+namespace {
+
+// Binds a call without keyword arguments that does not have more positional
+// arguments than positional parameters. Such calls are the most common ones,
+// and here only need the arguments to be copied and the remaining parameters
+// to be filled in with their defaults.
+absl::StatusOr<std::vector<arolla::TypedValue>> BindPositionalArguments(
+    const Signature& signature, absl::Span<const arolla::TypedRef> args) {
+  const auto& parameters = signature.parameters();
+  std::vector<arolla::TypedValue> bound_arguments;
+  bound_arguments.reserve(parameters.size());
+  for (const auto& arg : args) {
+    bound_arguments.emplace_back(arg);
+  }
+  for (size_t i = args.size(); i < parameters.size(); ++i) {
+    const auto& parameter = parameters[i];
+    if (parameter.kind == Signature::Parameter::Kind::kVarPositional) {
+      bound_arguments.push_back(
+          arolla::MakeTuple(absl::Span<const arolla::TypedRef>()));
+    } else if (parameter.kind == Signature::Parameter::Kind::kVarKeyword) {
+      ASSIGN_OR_RETURN(
+          auto empty_kwargs,
+          arolla::MakeNamedTuple(absl::Span<const std::string>(),
+                                 absl::Span<const arolla::TypedRef>()));
+      bound_arguments.push_back(std::move(empty_kwargs));
+    } else if (parameter.default_value.has_value()) {
+      bound_arguments.push_back(
+          arolla::TypedValue::FromValue(*parameter.default_value));
+    } else {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("no value provided for %v parameter [%s]",
+                          parameter.kind, parameter.name));
+    }
+  }
+  return bound_arguments;
+}
+
+}  // namespace
+
 absl::StatusOr<std::vector<arolla::TypedValue>> BindArguments(
     const Signature& signature, absl::Span<const arolla::TypedRef> args,
     absl::Span<const std::pair<std::string, arolla::TypedRef>> kwargs) {
+  if (kwargs.empty() && args.size() <= signature.positional_parameter_count()) {
+    return BindPositionalArguments(signature, args);
+  }
   const auto& parameters = signature.parameters();
   const auto& keyword_parameter_index = signature.keyword_parameter_index();
   std::vector<arolla::TypedValue> bound_arguments(
@@ -73,6 +73,12 @@ class Signature {
       const {
     return keyword_parameter_index_;
   }
+  // The number of leading positional-only and positional-or-keyword
+  // parameters, i.e. the maximum number of positional arguments that are not
+  // collected into a variadic positional parameter.
+  size_t positional_parameter_count() const {
+    return positional_parameter_count_;
+  }
 
   Signature(const Signature& other) = default;
   Signature& operator=(const Signature& other) = default;
@@ -84,6 +90,7 @@ class Signature {
 
   std::vector<Parameter> parameters_;
   absl::flat_hash_map<std::string, size_t> keyword_parameter_index_;
+  size_t positional_parameter_count_ = 0;
 };
 
 // Binds arguments in a given function call to a signature. This method
@@ -81,6 +81,25 @@ TEST(SignatureTest, Basic) {
               UnorderedElementsAre(Pair("b", 1), Pair("d", 3)));
 }
 
+TEST(SignatureTest, PositionalParameterCount) {
+  Signature::Parameter p1 = {
+      .name = "a",
+      .kind = Signature::Parameter::Kind::kPositionalOnly,
+  };
+  Signature::Parameter p2 = {
+      .name = "b",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  Signature::Parameter p3 = {
+      .name = "c",
+      .kind = Signature::Parameter::Kind::kKeywordOnly,
+  };
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({p1, p2, p3}));
+  EXPECT_EQ(signature.positional_parameter_count(), 2);
+  ASSERT_OK_AND_ASSIGN(auto empty_signature, Signature::Create({}));
+  EXPECT_EQ(empty_signature.positional_parameter_count(), 0);
+}
+
 TEST(SignatureTest, DuplicateName) {
   Signature::Parameter p1 = {
       .name = "a",
@@ -414,6 +433,39 @@ TEST(BindArgumentsTest, TooFewPositionalOkWithDefaultValue) {
               IsOkAndHolds(IsEquivalentTo(p1.default_value.value())));
 }
 
+TEST(BindArgumentsTest, AllPositionalWithVariadicAndKeywordOnly) {
+  Signature::Parameter p1 = {
+      .name = "a",
+      .kind = Signature::Parameter::Kind::kPositionalOrKeyword,
+  };
+  Signature::Parameter p2 = {
+      .name = "b",
+      .kind = Signature::Parameter::Kind::kVarPositional,
+  };
+  Signature::Parameter p3 = {
+      .name = "c",
+      .kind = Signature::Parameter::Kind::kKeywordOnly,
+      .default_value = test::DataItem(57),
+  };
+  Signature::Parameter p4 = {
+      .name = "d",
+      .kind = Signature::Parameter::Kind::kVarKeyword,
+  };
+  ASSERT_OK_AND_ASSIGN(auto signature, Signature::Create({p1, p2, p3, p4}));
+  auto input_slice = test::DataItem(43);
+  ASSERT_OK_AND_ASSIGN(
+      auto bound_arguments,
+      BindArguments(signature, {arolla::TypedRef::FromValue(input_slice)},
+                    {}));
+  ASSERT_EQ(bound_arguments.size(), 4);
+  EXPECT_THAT(bound_arguments[0].As<DataSlice>(),
+              IsOkAndHolds(IsEquivalentTo(input_slice)));
+  EXPECT_EQ(bound_arguments[1].GetFieldCount(), 0);
+  EXPECT_THAT(bound_arguments[2].As<DataSlice>(),
+              IsOkAndHolds(IsEquivalentTo(p3.default_value.value())));
+  EXPECT_EQ(bound_arguments[3].GetFieldCount(), 0);
+}
+
 TEST(BindArgumentsTest, TooManyPositional) {
   Signature::Parameter p1 = {
       .name = "foo",
@@ -0,0 +1,152 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/access_profile.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <string>
+#include <tuple>
+
+#include "absl/base/attributes.h"
+#include "absl/base/no_destructor.h"
+#include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "koladata/internal/object_id.h"
+
+namespace koladata::internal {
+namespace {
+
+// Reads of at least this average batch size are considered large.
+constexpr double kLargeReadBatch = 1024;
+
+ABSL_CONST_INIT std::atomic<int64_t> sample_rate = 0;
+
+struct ProfileState {
+  absl::Mutex mutex;
+  absl::flat_hash_map<AllocationId,
+                      absl::flat_hash_map<std::string, AttrAccessStats>>
+      stats ABSL_GUARDED_BY(mutex);
+};
+
+ProfileState& GetProfileState() {
+  static absl::NoDestructor<ProfileState> state;
+  return *state;
+}
+
+}  // namespace
+
+void SetAccessProfilingSampleRate(int64_t rate) {
+  sample_rate.store(std::max<int64_t>(rate, 0), std::memory_order_relaxed);
+}
+
+int64_t AccessProfilingSampleRate() {
+  return sample_rate.load(std::memory_order_relaxed);
+}
+
+bool ShouldSampleAccess() {
+  const int64_t rate = sample_rate.load(std::memory_order_relaxed);
+  if (ABSL_PREDICT_TRUE(rate == 0)) {
+    return false;
+  }
+  thread_local int64_t countdown = 0;
+  if (--countdown > 0) {
+    return false;
+  }
+  countdown = rate;
+  return true;
+}
+
+void RecordAttrAccess(AllocationId alloc, absl::string_view attr, bool write,
+                      int64_t batch_size, int64_t fork_depth) {
+  ProfileState& state = GetProfileState();
+  absl::MutexLock lock(&state.mutex);
+  AttrAccessStats& stats = state.stats[alloc][attr];
+  if (write) {
+    ++stats.writes;
+    stats.write_batch_elements += batch_size;
+  } else {
+    ++stats.reads;
+    stats.read_batch_elements += batch_size;
+  }
+  stats.max_fork_depth = std::max(stats.max_fork_depth, fork_depth);
+}
+
+AccessProfile GetAccessProfile() {
+  AccessProfile profile;
+  {
+    ProfileState& state = GetProfileState();
+    absl::MutexLock lock(&state.mutex);
+    for (const auto& [alloc, attrs] : state.stats) {
+      for (const auto& [attr, stats] : attrs) {
+        profile.push_back({.alloc = alloc, .attr = attr, .stats = stats});
+      }
+    }
+  }
+  std::sort(profile.begin(), profile.end(),
+            [](const AttrAccessProfile& a, const AttrAccessProfile& b) {
+              return std::tie(a.alloc, a.attr) < std::tie(b.alloc, b.attr);
+            });
+  return profile;
+}
+
+void ResetAccessProfile() {
+  ProfileState& state = GetProfileState();
+  absl::MutexLock lock(&state.mutex);
+  state.stats.clear();
+}
+
+absl::string_view StorageLayoutName(StorageLayout layout) {
+  switch (layout) {
+    case StorageLayout::kSparse:
+      return "sparse";
+    case StorageLayout::kDense:
+      return "dense";
+    case StorageLayout::kDictEncoded:
+      return "dict_encoded";
+    case StorageLayout::kConstant:
+      return "constant";
+  }
+  ABSL_UNREACHABLE();
+}
+
+StorageLayout RecommendStorageLayout(const AttrAccessStats& access,
+                                     const AttrContentStats& content,
+                                     double sparse_to_dense_ratio,
+                                     double max_distinct_text_ratio) {
+  if (content.present == 0) {
+    return StorageLayout::kSparse;
+  }
+  if (content.distinct == 1 && content.present == content.prefix_size) {
+    return StorageLayout::kConstant;
+  }
+  if (access.reads >= 4 * access.writes &&
+      access.average_read_batch() >= kLargeReadBatch) {
+    sparse_to_dense_ratio /= 4;
+  }
+  if (content.fill_ratio() < sparse_to_dense_ratio) {
+    return StorageLayout::kSparse;
+  }
+  if (content.is_text &&
+      content.distinct <= max_distinct_text_ratio * content.present) {
+    return StorageLayout::kDictEncoded;
+  }
+  return StorageLayout::kDense;
+}
+
+}  // namespace koladata::internal
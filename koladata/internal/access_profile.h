@@ -0,0 +1,124 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_ACCESS_PROFILE_H_
+#define KOLADATA_INTERNAL_ACCESS_PROFILE_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "koladata/internal/object_id.h"
+
+namespace koladata::internal {
+
+// Sampled accesses to the attribute of a big allocation, recorded by all
+// DataBagImpls while enabled by SetAccessProfilingSampleRate. The counts cover
+// about 1/rate of the calls.
+struct AttrAccessStats {
+  int64_t reads = 0;
+  int64_t writes = 0;
+  // Sums of the sizes of the batches of the sampled calls. A batch can span
+  // several allocations, so it is an upper bound of the accessed objects.
+  int64_t read_batch_elements = 0;
+  int64_t write_batch_elements = 0;
+  // Maximum fork_depth() of the DataBagImpls accessed.
+  int64_t max_fork_depth = 0;
+
+  double average_read_batch() const {
+    return reads == 0 ? 0 : static_cast<double>(read_batch_elements) / reads;
+  }
+
+  friend bool operator==(const AttrAccessStats&,
+                         const AttrAccessStats&) = default;
+};
+
+struct AttrAccessProfile {
+  AllocationId alloc;
+  std::string attr;
+  AttrAccessStats stats;
+};
+
+// Access profile ordered by allocation and attribute.
+using AccessProfile = std::vector<AttrAccessProfile>;
+
+// Records every `rate`-th call of the instrumented DataBagImpl operations
+// (counted per thread). 0 (the default) disables profiling; the cost of the
+// disabled profiler is a relaxed atomic load per operation.
+void SetAccessProfilingSampleRate(int64_t rate);
+int64_t AccessProfilingSampleRate();
+
+// Returns true if the current call is to be recorded.
+bool ShouldSampleAccess();
+
+// Records a sampled access to the attribute `attr` of `alloc`.
+void RecordAttrAccess(AllocationId alloc, absl::string_view attr, bool write,
+                      int64_t batch_size, int64_t fork_depth);
+
+// Returns the accesses recorded since the start of the process or the last
+// call to ResetAccessProfile.
+AccessProfile GetAccessProfile();
+void ResetAccessProfile();
+
+// Representation of an attribute source of a big allocation.
+enum class StorageLayout {
+  // Hash map of the present objects (SparseSource).
+  kSparse,
+  // Array of values indexed by the object offset (DenseSource).
+  kDense,
+  // Dense, with every distinct text stored once.
+  kDictEncoded,
+  // A single value of all objects of a prefix of the allocation.
+  kConstant,
+};
+
+absl::string_view StorageLayoutName(StorageLayout layout);
+
+// Content of an attribute source.
+struct AttrContentStats {
+  int64_t capacity = 0;
+  int64_t present = 0;
+  // Number of objects up to the last present one.
+  int64_t prefix_size = 0;
+  // Approximate number of distinct present values.
+  int64_t distinct = 0;
+  bool is_text = false;
+
+  double fill_ratio() const {
+    return capacity == 0 ? 0 : static_cast<double>(present) / capacity;
+  }
+};
+
+// Returns the best layout of an attribute source with `content`, accessed as
+// described by `access`. The thresholds have the meaning of the
+// OptimizeOptions fields with the same names. Sources that are mostly read in
+// large batches are recommended dense at a lower fill ratio than
+// `sparse_to_dense_ratio`, as batch lookups in dense sources don't hash.
+StorageLayout RecommendStorageLayout(const AttrAccessStats& access,
+                                     const AttrContentStats& content,
+                                     double sparse_to_dense_ratio,
+                                     double max_distinct_text_ratio);
+
+struct StorageLayoutRecommendation {
+  AllocationId alloc;
+  std::string attr;
+  AttrAccessStats access;
+  AttrContentStats content;
+  StorageLayout layout;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_ACCESS_PROFILE_H_
@@ -0,0 +1,115 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/access_profile.h"
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "koladata/internal/object_id.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::IsEmpty;
+
+TEST(AccessProfileTest, Sampling) {
+  EXPECT_EQ(AccessProfilingSampleRate(), 0);
+  EXPECT_FALSE(ShouldSampleAccess());
+
+  SetAccessProfilingSampleRate(3);
+  int sampled = 0;
+  for (int i = 0; i < 30; ++i) {
+    sampled += ShouldSampleAccess();
+  }
+  EXPECT_EQ(sampled, 10);
+  SetAccessProfilingSampleRate(0);
+  EXPECT_FALSE(ShouldSampleAccess());
+}
+
+TEST(AccessProfileTest, Record) {
+  ResetAccessProfile();
+  AllocationId alloc_1 = Allocate(1000);
+  AllocationId alloc_2 = Allocate(1000);
+  RecordAttrAccess(alloc_1, "a", /*write=*/false, 100, /*fork_depth=*/2);
+  RecordAttrAccess(alloc_1, "a", /*write=*/false, 300, /*fork_depth=*/1);
+  RecordAttrAccess(alloc_1, "a", /*write=*/true, 5, /*fork_depth=*/0);
+  RecordAttrAccess(alloc_2, "b", /*write=*/true, 1, /*fork_depth=*/0);
+
+  AccessProfile profile = GetAccessProfile();
+  ASSERT_EQ(profile.size(), 2);
+  const AttrAccessProfile& a = profile[alloc_1 < alloc_2 ? 0 : 1];
+  EXPECT_EQ(a.alloc, alloc_1);
+  EXPECT_EQ(a.attr, "a");
+  EXPECT_EQ(a.stats, (AttrAccessStats{.reads = 2,
+                                      .writes = 1,
+                                      .read_batch_elements = 400,
+                                      .write_batch_elements = 5,
+                                      .max_fork_depth = 2}));
+  EXPECT_EQ(a.stats.average_read_batch(), 200);
+
+  ResetAccessProfile();
+  EXPECT_THAT(GetAccessProfile(), IsEmpty());
+}
+
+TEST(AccessProfileTest, RecommendStorageLayout) {
+  constexpr double kRatio = 1.0 / 16;
+  constexpr double kTextRatio = 0.5;
+  const AttrAccessStats writes{.writes = 10, .write_batch_elements = 10};
+  const AttrAccessStats batch_reads{.reads = 10,
+                                    .read_batch_elements = 100000};
+  auto recommend = [&](const AttrAccessStats& access,
+                       const AttrContentStats& content) {
+    return RecommendStorageLayout(access, content, kRatio, kTextRatio);
+  };
+
+  EXPECT_EQ(recommend(writes, {.capacity = 1024}), StorageLayout::kSparse);
+  EXPECT_EQ(recommend(writes, {.capacity = 1024,
+                               .present = 100,
+                               .prefix_size = 100,
+                               .distinct = 1}),
+            StorageLayout::kConstant);
+  // A gap in the prefix.
+  EXPECT_EQ(recommend(writes, {.capacity = 1024,
+                               .present = 99,
+                               .prefix_size = 100,
+                               .distinct = 1}),
+            StorageLayout::kDense);
+  EXPECT_EQ(recommend(writes, {.capacity = 1024,
+                               .present = 32,
+                               .prefix_size = 1000,
+                               .distinct = 32}),
+            StorageLayout::kSparse);
+  // Large batch reads use dense sources at a lower fill ratio.
+  EXPECT_EQ(recommend(batch_reads, {.capacity = 1024,
+                                    .present = 32,
+                                    .prefix_size = 1000,
+                                    .distinct = 32}),
+            StorageLayout::kDense);
+  EXPECT_EQ(recommend(writes, {.capacity = 1024,
+                               .present = 500,
+                               .prefix_size = 1000,
+                               .distinct = 5,
+                               .is_text = true}),
+            StorageLayout::kDictEncoded);
+  EXPECT_EQ(recommend(writes, {.capacity = 1024,
+                               .present = 500,
+                               .prefix_size = 1000,
+                               .distinct = 400,
+                               .is_text = true}),
+            StorageLayout::kDense);
+  EXPECT_EQ(StorageLayoutName(StorageLayout::kDictEncoded), "dict_encoded");
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -14,14 +14,18 @@
 //
 #include "koladata/internal/benchmark_helpers.h"
 
+#include <sys/resource.h>
+
 #include <cstdint>
 #include <functional>
 #include <utility>
 
+#include "absl/strings/str_cat.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/object_id.h"
 #include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
 
 namespace koladata::internal {
 
@@ -56,4 +60,67 @@ DataSliceImpl RemoveItemsIf(
   return std::move(builder).Build();
 }
 
+arolla::DenseArray<int64_t> CanonicalInt64Array(int64_t size,
+                                                int64_t distinct_count,
+                                                double missing_ratio,
+                                                uint64_t seed) {
+  CanonicalRandom random(seed);
+  arolla::DenseArrayBuilder<int64_t> builder(size);
+  for (int64_t i = 0; i < size; ++i) {
+    bool missing = random.Bernoulli(missing_ratio);
+    int64_t value = random.Uniform(distinct_count);
+    if (!missing) {
+      builder.Set(i, value);
+    }
+  }
+  return std::move(builder).Build();
+}
+
+DataSliceImpl CanonicalInt64Slice(int64_t size, int64_t distinct_count,
+                                  double missing_ratio, uint64_t seed) {
+  return DataSliceImpl::Create(
+      CanonicalInt64Array(size, distinct_count, missing_ratio, seed));
+}
+
+DataSliceImpl CanonicalTextSlice(int64_t size, int64_t distinct_count,
+                                 double missing_ratio, uint64_t seed) {
+  arolla::DenseArray<int64_t> keys =
+      CanonicalInt64Array(size, distinct_count, missing_ratio, seed);
+  arolla::DenseArrayBuilder<arolla::Text> builder(size);
+  keys.ForEachPresent([&](int64_t id, int64_t key) {
+    builder.Set(id, absl::StrCat("v", key));
+  });
+  return DataSliceImpl::Create(std::move(builder).Build());
+}
+
+DataSliceImpl CanonicalMixedSlice(int64_t size, int64_t distinct_count,
+                                  double missing_ratio, uint64_t seed) {
+  arolla::DenseArray<int64_t> keys =
+      CanonicalInt64Array(size, distinct_count, missing_ratio, seed);
+  DataSliceImpl::Builder builder(size);
+  keys.ForEachPresent([&](int64_t id, int64_t key) {
+    switch (id % 3) {
+      case 0:
+        builder.Insert(id, DataItem(static_cast<int32_t>(key)));
+        break;
+      case 1:
+        builder.Insert(id, DataItem(static_cast<float>(key)));
+        break;
+      default:
+        builder.Insert(id, DataItem(arolla::Text(absl::StrCat("v", key))));
+        break;
+    }
+  });
+  return std::move(builder).Build();
+}
+
+double PeakRssMegabytes() {
+  struct rusage usage;
+  if (getrusage(RUSAGE_SELF, &usage) != 0) {
+    return 0;
+  }
+  // ru_maxrss is in kilobytes on Linux.
+  return usage.ru_maxrss / 1024.0;
+}
+
 }  // namespace koladata::internal
@@ -20,6 +20,7 @@
 
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "arolla/dense_array/dense_array.h"
 
 namespace koladata::internal {
 
@@ -57,6 +58,59 @@ DataSliceImpl FilterSingleAllocDataSlice(const DataSliceImpl& ds,
 DataSliceImpl RemoveItemsIf(const DataSliceImpl& ds,
                             std::function<bool(const DataItem&)> remove_fn);
 
+// Seed of the canonical benchmark datasets below.
+constexpr uint64_t kCanonicalBenchmarkSeed = 42;
+
+// Pseudo-random generator of the canonical benchmark datasets (splitmix64).
+// Unlike the standard and absl distributions, its output is pinned: the
+// datasets are the same in every version and on every platform, so that the
+// results of the benchmark suite runs are comparable.
+class CanonicalRandom {
+ public:
+  explicit CanonicalRandom(uint64_t seed) : state_(seed) {}
+
+  uint64_t Next() {
+    uint64_t z = (state_ += 0x9E3779B97F4A7C15ull);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+    return z ^ (z >> 31);
+  }
+
+  // Returns a value in [0, bound). `bound` must be positive.
+  uint64_t Uniform(uint64_t bound) { return Next() % bound; }
+
+  // Returns true with probability `p`.
+  bool Bernoulli(double p) { return (Next() >> 11) * 0x1.0p-53 < p; }
+
+ private:
+  uint64_t state_;
+};
+
+// Canonical datasets of the benchmark suite. About `missing_ratio` of the
+// items are missing, and the present ones take `distinct_count` distinct
+// values. Every item consumes the same number of random values regardless of
+// its presence, so changing `missing_ratio` keeps the values of the items
+// that stay present.
+arolla::DenseArray<int64_t> CanonicalInt64Array(
+    int64_t size, int64_t distinct_count, double missing_ratio,
+    uint64_t seed = kCanonicalBenchmarkSeed);
+DataSliceImpl CanonicalInt64Slice(int64_t size, int64_t distinct_count,
+                                  double missing_ratio,
+                                  uint64_t seed = kCanonicalBenchmarkSeed);
+// The texts are "v<k>" for k in [0, distinct_count).
+DataSliceImpl CanonicalTextSlice(int64_t size, int64_t distinct_count,
+                                 double missing_ratio,
+                                 uint64_t seed = kCanonicalBenchmarkSeed);
+// The items with index i are INT32, FLOAT32 or TEXT for i % 3 = 0, 1 or 2.
+DataSliceImpl CanonicalMixedSlice(int64_t size, int64_t distinct_count,
+                                  double missing_ratio,
+                                  uint64_t seed = kCanonicalBenchmarkSeed);
+
+// Returns the peak resident memory of the process in megabytes, or 0 if it is
+// not available. The value never decreases, so it covers all the benchmarks
+// run so far in the process.
+double PeakRssMegabytes();
+
 }  // namespace koladata::internal
 
 #endif  // KOLADATA_INTERNAL_BENCHMARK_HELPERS_H_
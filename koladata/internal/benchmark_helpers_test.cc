@@ -0,0 +1,63 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/benchmark_helpers.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::_;
+using ::testing::ElementsAre;
+
+// The canonical datasets must never change, otherwise the benchmark suite
+// results of different versions are not comparable.
+TEST(BenchmarkHelpersTest, CanonicalRandomIsPinned) {
+  CanonicalRandom random(kCanonicalBenchmarkSeed);
+  EXPECT_EQ(random.Next(), 0xBDD732262FEB6E95ull);
+}
+
+TEST(BenchmarkHelpersTest, CanonicalInt64Array) {
+  constexpr auto kMissing = std::nullopt;
+  EXPECT_THAT(CanonicalInt64Array(10, 100, 0.25),
+              ElementsAre(91, 64, kMissing, kMissing, 74, kMissing, 95, 30,
+                          kMissing, kMissing));
+  // The present values stay the same with a different missing ratio.
+  EXPECT_THAT(CanonicalInt64Array(4, 100, 0),
+              ElementsAre(91, 64, _, _));
+  EXPECT_EQ(CanonicalInt64Array(1000, 100, 1).PresentCount(), 0);
+}
+
+TEST(BenchmarkHelpersTest, CanonicalSlices) {
+  EXPECT_THAT(CanonicalInt64Slice(3, 100, 0.25),
+              ElementsAre(DataItem(int64_t{91}), DataItem(int64_t{64}),
+                          DataItem()));
+  EXPECT_THAT(CanonicalTextSlice(3, 100, 0.25),
+              ElementsAre(DataItem(arolla::Text("v91")),
+                          DataItem(arolla::Text("v64")), DataItem()));
+  EXPECT_THAT(CanonicalMixedSlice(5, 100, 0.25),
+              ElementsAre(DataItem(int32_t{91}), DataItem(float{64}),
+                          DataItem(), DataItem(), DataItem(float{74})));
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_BLOOM_FILTER_H_
+#define KOLADATA_INTERNAL_BLOOM_FILTER_H_
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "absl/numeric/bits.h"
+
+namespace koladata::internal {
+
+// Bloom filter over precomputed 64-bit hashes (e.g. the hashes used by the
+// hash map that it guards). Used to skip the hash map lookups in the layers of
+// a fork chain that certainly don't contain the key.
+//
+// The filter doesn't track its elements, so the owner calls Rebuild and
+// re-inserts all elements once NeedsRebuild returns true. The number of bits
+// is doubled on every rebuild, so the amortized cost of an insertion is O(1).
+class HashBloomFilter {
+ public:
+  // Number of bits per element after a rebuild. Two probes per hash give
+  // a false positive rate below 5% until the next rebuild.
+  static constexpr size_t kBitsPerElement = 16;
+
+  // Returns false if no element with `hash` was inserted.
+  bool MayContain(size_t hash) const {
+    return !words_.empty() && TestBit(hash) && TestBit(hash >> 32);
+  }
+
+  void Insert(size_t hash) {
+    SetBit(hash);
+    SetBit(hash >> 32);
+  }
+
+  // Returns true if the filter has to be rebuilt to hold `size` elements.
+  bool NeedsRebuild(size_t size) const {
+    return size * kBitsPerElement / 2 > words_.size() * 64;
+  }
+
+  // Clears the filter and resizes it for `size` elements. All elements must
+  // be inserted again.
+  void Rebuild(size_t size) {
+    size_t words = absl::bit_ceil(
+        std::max<size_t>(kMinWords, size * kBitsPerElement / 64 + 1));
+    words_.assign(words, 0);
+    mask_ = words * 64 - 1;
+  }
+
+  int64_t EstimateMemoryUsage() const {
+    return words_.capacity() * sizeof(uint64_t);
+  }
+
+ private:
+  static constexpr size_t kMinWords = 4;
+
+  bool TestBit(size_t hash) const {
+    size_t bit = hash & mask_;
+    return (words_[bit / 64] >> (bit % 64)) & 1;
+  }
+
+  void SetBit(size_t hash) {
+    size_t bit = hash & mask_;
+    words_[bit / 64] |= uint64_t{1} << (bit % 64);
+  }
+
+  std::vector<uint64_t> words_;
+  size_t mask_ = 0;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_BLOOM_FILTER_H_
@@ -0,0 +1,58 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/bloom_filter.h"
+
+#include <cstddef>
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "absl/hash/hash.h"
+
+namespace koladata::internal {
+namespace {
+
+TEST(HashBloomFilterTest, Empty) {
+  HashBloomFilter filter;
+  EXPECT_FALSE(filter.MayContain(absl::HashOf(1)));
+  EXPECT_TRUE(filter.NeedsRebuild(1));
+  EXPECT_EQ(filter.EstimateMemoryUsage(), 0);
+}
+
+TEST(HashBloomFilterTest, InsertAndRebuild) {
+  constexpr int64_t kSize = 10000;
+  HashBloomFilter filter;
+  for (int64_t i = 0; i < kSize; ++i) {
+    if (filter.NeedsRebuild(i + 1)) {
+      filter.Rebuild(i + 1);
+      for (int64_t j = 0; j < i; ++j) {
+        filter.Insert(absl::HashOf(j));
+      }
+    }
+    filter.Insert(absl::HashOf(i));
+    ASSERT_FALSE(filter.NeedsRebuild(i + 1));
+  }
+  for (int64_t i = 0; i < kSize; ++i) {
+    EXPECT_TRUE(filter.MayContain(absl::HashOf(i)));
+  }
+  int64_t false_positives = 0;
+  for (int64_t i = kSize; i < 2 * kSize; ++i) {
+    false_positives += filter.MayContain(absl::HashOf(i));
+  }
+  EXPECT_LT(false_positives, kSize / 10);
+  EXPECT_GT(filter.EstimateMemoryUsage(), 0);
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -0,0 +1,64 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/cancellation.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/time/clock.h"
+
+namespace koladata::internal {
+namespace {
+
+thread_local absl::Nullable<const CancellationToken*> current_token = nullptr;
+
+}  // namespace
+
+ScopedCancellationToken::ScopedCancellationToken(
+    absl::Nullable<const CancellationToken*> token)
+    : previous_token_(current_token) {
+  current_token = token;
+}
+
+ScopedCancellationToken::~ScopedCancellationToken() {
+  current_token = previous_token_;
+}
+
+absl::Nullable<const CancellationToken*> CurrentCancellationToken() {
+  return current_token;
+}
+
+absl::Status CancellationToken::Check() const {
+  if (IsCancelled()) {
+    return absl::CancelledError("the computation was cancelled");
+  }
+  int64_t deadline_ns = deadline_ns_.load(std::memory_order_relaxed);
+  if (deadline_ns != kNoDeadline &&
+      absl::GetCurrentTimeNanos() >= deadline_ns) {
+    return absl::DeadlineExceededError("the computation exceeded its deadline");
+  }
+  return absl::OkStatus();
+}
+
+absl::Status CheckCancellation() {
+  if (current_token == nullptr) {
+    return absl::OkStatus();
+  }
+  return current_token->Check();
+}
+
+}  // namespace koladata::internal
@@ -0,0 +1,90 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_CANCELLATION_H_
+#define KOLADATA_INTERNAL_CANCELLATION_H_
+
+#include <atomic>
+#include <cstdint>
+#include <limits>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/time/time.h"
+
+namespace koladata::internal {
+
+// A flag and an optional deadline for cooperative cancellation of a
+// computation. The computation checks the token at safe points (e.g. between
+// the evaluation of functor variables or between the chunks of long loops) and
+// stops with a CancelledError once the token is cancelled, or with a
+// DeadlineExceededError once the deadline has passed. Thread-safe.
+class CancellationToken {
+ public:
+  CancellationToken() = default;
+  explicit CancellationToken(absl::Time deadline) { SetDeadline(deadline); }
+
+  void Cancel() { cancelled_.store(true, std::memory_order_relaxed); }
+
+  bool IsCancelled() const {
+    return cancelled_.load(std::memory_order_relaxed);
+  }
+
+  void SetDeadline(absl::Time deadline) {
+    deadline_ns_.store(deadline == absl::InfiniteFuture()
+                           ? kNoDeadline
+                           : absl::ToUnixNanos(deadline),
+                       std::memory_order_relaxed);
+  }
+
+  // Returns the status the computation should stop with, or OK.
+  absl::Status Check() const;
+
+ private:
+  static constexpr int64_t kNoDeadline = std::numeric_limits<int64_t>::max();
+
+  std::atomic<bool> cancelled_ = false;
+  std::atomic<int64_t> deadline_ns_ = kNoDeadline;
+};
+
+// The number of items processed between two cancellation checks in the loops
+// over individual items. A check may read the clock, so it is not done for
+// every item.
+constexpr int64_t kCancellationCheckInterval = 1 << 12;
+
+// Makes `token` the cancellation token of the current thread for the lifetime
+// of the object. The previous token is restored on destruction.
+class ScopedCancellationToken {
+ public:
+  explicit ScopedCancellationToken(
+      absl::Nullable<const CancellationToken*> token);
+  ScopedCancellationToken(const ScopedCancellationToken&) = delete;
+  ScopedCancellationToken& operator=(const ScopedCancellationToken&) = delete;
+  ~ScopedCancellationToken();
+
+ private:
+  absl::Nullable<const CancellationToken*> previous_token_;
+};
+
+// Returns the cancellation token of the current thread, or nullptr.
+absl::Nullable<const CancellationToken*> CurrentCancellationToken();
+
+// Returns a CancelledError if the cancellation token of the current thread is
+// cancelled, a DeadlineExceededError if its deadline has passed, and OK
+// otherwise (including when there is no token).
+absl::Status CheckCancellation();
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_CANCELLATION_H_
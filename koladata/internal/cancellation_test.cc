@@ -0,0 +1,104 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/cancellation.h"
+
+#include <atomic>
+#include <cstdint>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "koladata/internal/executor.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::StatusIs;
+
+TEST(CancellationTest, NoToken) {
+  EXPECT_EQ(CurrentCancellationToken(), nullptr);
+  ASSERT_OK(CheckCancellation());
+}
+
+TEST(CancellationTest, ScopedToken) {
+  CancellationToken token;
+  {
+    ScopedCancellationToken scope(&token);
+    EXPECT_EQ(CurrentCancellationToken(), &token);
+    ASSERT_OK(CheckCancellation());
+    token.Cancel();
+    EXPECT_TRUE(token.IsCancelled());
+    EXPECT_THAT(CheckCancellation(),
+                StatusIs(absl::StatusCode::kCancelled,
+                         "the computation was cancelled"));
+    {
+      ScopedCancellationToken inner_scope(nullptr);
+      ASSERT_OK(CheckCancellation());
+    }
+    EXPECT_EQ(CurrentCancellationToken(), &token);
+  }
+  EXPECT_EQ(CurrentCancellationToken(), nullptr);
+  ASSERT_OK(CheckCancellation());
+}
+
+TEST(CancellationTest, Deadline) {
+  CancellationToken token(absl::Now() + absl::Hours(1));
+  ScopedCancellationToken scope(&token);
+  ASSERT_OK(CheckCancellation());
+  token.SetDeadline(absl::InfinitePast());
+  EXPECT_THAT(CheckCancellation(),
+              StatusIs(absl::StatusCode::kDeadlineExceeded,
+                       "the computation exceeded its deadline"));
+  token.SetDeadline(absl::InfiniteFuture());
+  ASSERT_OK(CheckCancellation());
+  token.Cancel();
+  EXPECT_THAT(CheckCancellation(), StatusIs(absl::StatusCode::kCancelled));
+}
+
+TEST(CancellationTest, ParallelFor) {
+  ThreadPoolExecutor executor(2);
+  CancellationToken token;
+  ScopedCancellationToken scope(&token);
+  std::atomic<int> count = 0;
+  ASSERT_OK(ParallelFor(&executor, 8, [&](int64_t) {
+    // The token is propagated to the executor threads.
+    EXPECT_EQ(CurrentCancellationToken(), &token);
+    count.fetch_add(1);
+    return absl::OkStatus();
+  }));
+  EXPECT_EQ(count.load(), 8);
+
+  token.Cancel();
+  count = 0;
+  EXPECT_THAT(ParallelFor(&executor, 8,
+                          [&](int64_t) {
+                            count.fetch_add(1);
+                            return absl::OkStatus();
+                          }),
+              StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_THAT(ParallelFor(nullptr, 8,
+                          [&](int64_t) {
+                            count.fetch_add(1);
+                            return absl::OkStatus();
+                          }),
+              StatusIs(absl::StatusCode::kCancelled));
+  EXPECT_EQ(count.load(), 0);
+}
+
+}  // namespace
+}  // namespace koladata::internal
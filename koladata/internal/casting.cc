@@ -60,6 +60,32 @@ absl::Status AssertDbImpl(internal::DataBagImpl* db_impl) {
   return absl::OkStatus();
 }
 
+// If `slice` is a prefix of a single big allocation that has no `__schema__`
+// values in `db_impl` yet, stores `schema` as `__schema__` of the entire
+// allocation. It is kept in a constant source, so no per-object values are
+// created. Returns false if the fast path is not applicable.
+absl::StatusOr<bool> TrySetSchemaForEntireAllocation(
+    internal::DataBagImpl& db_impl, const internal::DataSliceImpl& slice,
+    const internal::DataItem& schema) {
+  if (!slice.is_allocation_prefix() || slice.allocation_ids().size() != 1) {
+    return false;
+  }
+  internal::AllocationId alloc_id = *slice.allocation_ids().begin();
+  if (alloc_id.IsSmall()) {
+    return false;
+  }
+  internal::DataBagImpl::ConstDenseSourceArray dense_sources;
+  internal::DataBagImpl::ConstSparseSourceArray sparse_sources;
+  db_impl.GetAttributeDataSources(alloc_id, schema::kSchemaAttr, dense_sources,
+                                  sparse_sources);
+  if (!dense_sources.empty() || !sparse_sources.empty()) {
+    return false;
+  }
+  RETURN_IF_ERROR(db_impl.SetAttrForEntireAllocation(
+      alloc_id, schema::kSchemaAttr, slice.size(), schema));
+  return true;
+}
+
 }  // namespace
 
 absl::StatusOr<internal::DataItem> ToNone::operator()(
@@ -188,26 +214,35 @@ absl::Status ToObject::operator()(
     return absl::OkStatus();
   }
   if (entity_schema_.has_value()) {
-    auto val_schema_slice =
-        internal::DataSliceImpl::Create(slice.size(), entity_schema_);
     RETURN_IF_ERROR(AssertDbImpl(db_impl_));
     bool set_attr = !validate_schema_;
     if (validate_schema_) {
       ASSIGN_OR_RETURN(auto schema_attr,
                        db_impl_->GetAttr(slice, schema::kSchemaAttr));
-      ASSIGN_OR_RETURN(auto equal,
-                       internal::EqualOp()(schema_attr, val_schema_slice));
-      if (equal.present_count() != schema_attr.present_count()) {
-        return absl::InvalidArgumentError(absl::StrFormat(
-            "existing schemas %v differ from the provided schema %v",
-            schema_attr, entity_schema_));
+      if (schema_attr.present_count() > 0) {
+        auto val_schema_slice =
+            internal::DataSliceImpl::Create(slice.size(), entity_schema_);
+        ASSIGN_OR_RETURN(auto equal,
+                         internal::EqualOp()(schema_attr, val_schema_slice));
+        if (equal.present_count() != schema_attr.present_count()) {
+          return absl::InvalidArgumentError(absl::StrFormat(
+              "existing schemas %v differ from the provided schema %v",
+              schema_attr, entity_schema_));
+        }
       }
       set_attr = schema_attr.present_count() < slice.present_count();
     }
     if (set_attr) {
-      // Also validates that there are no primitive values if !validate_schema_.
-      RETURN_IF_ERROR(
-          db_impl_->SetAttr(slice, schema::kSchemaAttr, val_schema_slice));
+      ASSIGN_OR_RETURN(
+          bool set_for_allocation,
+          TrySetSchemaForEntireAllocation(*db_impl_, slice, entity_schema_));
+      if (!set_for_allocation) {
+        // Also validates that there are no primitive values if
+        // !validate_schema_.
+        RETURN_IF_ERROR(db_impl_->SetAttr(
+            slice, schema::kSchemaAttr,
+            internal::DataSliceImpl::Create(slice.size(), entity_schema_)));
+      }
     }
   } else if (validate_schema_ /*&& !schema_.has_value()*/) {
     RETURN_IF_ERROR(slice.VisitValues(
@@ -16,6 +16,8 @@
 #define KOLADATA_INTERNAL_CASTING_H_
 
 #include <cstdint>
+#include <cstring>
+#include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
@@ -25,6 +27,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/span.h"
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
@@ -32,6 +35,8 @@
 #include "koladata/internal/object_id.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/expr/quote.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/memory/strings_buffer.h"
 #include "arolla/qexpr/operators/core/cast_operator.h"
 #include "arolla/qexpr/operators/strings/strings.h"
 #include "arolla/qtype/qtype.h"
@@ -89,6 +94,78 @@ struct ToSelf {
   }
 };
 
+// Formats the present integers of `values` into a single characters buffer,
+// the same way as arolla::AsTextOp.
+template <typename T>
+arolla::DenseArray<arolla::Text> IntegersToText(
+    const arolla::DenseArray<T>& values) {
+  arolla::Buffer<arolla::StringsBuffer::Offsets>::Builder offsets_bldr(
+      values.size());
+  absl::Span<arolla::StringsBuffer::Offsets> offsets =
+      offsets_bldr.GetMutableSpan();
+  int64_t total_size = 0;
+  for (int64_t i = 0; i < values.size(); ++i) {
+    offsets[i].start = total_size;
+    if (values.present(i)) {
+      total_size += absl::AlphaNum(values.values[i]).size();
+    }
+    offsets[i].end = total_size;
+  }
+  arolla::Buffer<char>::Builder chars_bldr(total_size);
+  char* chars = chars_bldr.GetMutableSpan().data();
+  values.ForEachPresent([&](int64_t id, T value) {
+    absl::AlphaNum piece(value);
+    std::memcpy(chars + offsets[id].start, piece.data(), piece.size());
+  });
+  return arolla::DenseArray<arolla::Text>{
+      arolla::StringsBuffer(std::move(offsets_bldr).Build(),
+                            std::move(chars_bldr).Build()),
+      values.bitmap, values.bitmap_bit_offset};
+}
+
+// Casts `values` to DST with `cast_op`, sharing the presence bitmap of
+// `values` instead of rebuilding it. Total numeric casts are applied to all
+// the values, missing ones included, in a branch-free loop that the compiler
+// vectorizes. Returns std::nullopt if there is no such fast path for T.
+template <typename DST, typename CastOp, typename T>
+std::optional<absl::StatusOr<arolla::DenseArray<DST>>> FastCast(
+    const CastOp& cast_op, const arolla::DenseArray<T>& values) {
+  if constexpr (std::is_arithmetic_v<DST> && std::is_arithmetic_v<T> &&
+                !std::is_same_v<T, bool>) {
+    typename arolla::Buffer<DST>::Builder bldr(values.size());
+    absl::Span<DST> out = bldr.GetMutableSpan();
+    absl::Span<const T> in = values.values.span();
+    if constexpr (std::is_same_v<decltype(cast_op(T())), DST>) {
+      for (int64_t i = 0; i < in.size(); ++i) {
+        out[i] = cast_op(in[i]);
+      }
+    } else {
+      absl::Status status = absl::OkStatus();
+      values.ForEachPresent([&](int64_t id, T v) {
+        if (!status.ok()) {
+          return;
+        }
+        auto res = cast_op(v);
+        if (!res.ok()) {
+          status = res.status();
+          return;
+        }
+        out[id] = *res;
+      });
+      if (!status.ok()) {
+        return status;
+      }
+    }
+    return arolla::DenseArray<DST>{std::move(bldr).Build(), values.bitmap,
+                                   values.bitmap_bit_offset};
+  } else if constexpr (std::is_same_v<DST, arolla::Text> &&
+                       (std::is_same_v<T, int> || std::is_same_v<T, int64_t>)) {
+    return IntegersToText(values);
+  } else {
+    return std::nullopt;
+  }
+}
+
 // Casts the given item/slice to the provided type DST ("self") with potential
 // data conversion using `CastOp`. The provided data is expected to be
 // empty-and-unknown or hold (potentially mixed) values of the types listed in
@@ -124,6 +201,23 @@ struct ToDST {
         slice.dtype() == arolla::GetQType<DST>()) {
       return slice;
     }
+    if (slice.is_single_dtype()) {
+      std::optional<absl::StatusOr<internal::DataSliceImpl>> result;
+      slice.VisitValues([&]<class T>(const arolla::DenseArray<T>& values) {
+        if constexpr (arolla::meta::contains_v<SRCs, T>) {
+          if (auto res = FastCast<DST>(CastOp(), values)) {
+            if (res->ok()) {
+              result = internal::DataSliceImpl::Create(**std::move(res));
+            } else {
+              result = std::move(*res).status();
+            }
+          }
+        }
+      });
+      if (result.has_value()) {
+        return *std::move(result);
+      }
+    }
     arolla::DenseArrayBuilder<DST> bldr(slice.size());
     RETURN_IF_ERROR(
         slice.VisitValues([&]<class T>(const arolla::DenseArray<T>& values) {
@@ -16,6 +16,7 @@
 
 #include <cstdint>
 #include <limits>
+#include <optional>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -45,6 +46,7 @@ using ::koladata::internal::DataItem;
 using ::koladata::internal::DataSliceImpl;
 using ::koladata::internal::testing::DataBagEqual;
 using ::koladata::internal::testing::IsEquivalentTo;
+using ::testing::ElementsAre;
 using ::testing::HasSubstr;
 
 TEST(CastingTest, ToInt32_DataItem) {
@@ -272,6 +274,32 @@ TEST(CastingTest, ToFloat64_DataSlice) {
                        "cannot cast MASK to FLOAT64"));
 }
 
+TEST(CastingTest, SingleDTypeFastPaths) {
+  // The presence of the result is shared with the input, including sliced
+  // inputs.
+  auto ints = arolla::CreateDenseArray<int64_t>(
+                  {7, -12, std::nullopt, int64_t{1} << 40, std::nullopt})
+                  .Slice(1, 4);
+  ASSERT_OK_AND_ASSIGN(auto floats,
+                       schema::ToFloat64()(DataSliceImpl::Create(ints)));
+  EXPECT_THAT(floats, ElementsAre(DataItem(-12.0), DataItem(),
+                                  DataItem(1099511627776.0), DataItem()));
+  EXPECT_EQ(floats.values<double>().bitmap.begin(), ints.bitmap.begin());
+  EXPECT_THAT(schema::ToText()(DataSliceImpl::Create(ints)),
+              IsOkAndHolds(ElementsAre(DataItem(arolla::Text("-12")),
+                                       DataItem(),
+                                       DataItem(arolla::Text("1099511627776")),
+                                       DataItem())));
+  // Missing values are not cast.
+  EXPECT_THAT(schema::ToInt32()(DataSliceImpl::Create(
+                  arolla::CreateDenseArray<float>({1.5f, std::nullopt}))),
+              IsOkAndHolds(ElementsAre(DataItem(1), DataItem())));
+  EXPECT_THAT(
+      schema::ToInt32()(DataSliceImpl::Create(arolla::CreateDenseArray<float>(
+          {1.5f, std::numeric_limits<float>::quiet_NaN()}))),
+      StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("to int32")));
+}
+
 TEST(CastingTest, ToNone_DataItem) {
   auto to_none = schema::ToNone();
   EXPECT_THAT(to_none(DataItem()), IsOkAndHolds(IsEquivalentTo(DataItem())));
@@ -1011,5 +1039,41 @@ TEST(CastingTest, ToObject_DataSlice) {
   }
 }
 
+TEST(CastingTest, ToObject_DataSlice_EntireAllocation) {
+  constexpr int64_t kSize = 1000;
+  DataItem entity_schema(internal::AllocateExplicitSchema());
+  auto objects = DataSliceImpl::AllocateEmptyObjects(kSize);
+  auto db_impl = internal::DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK_AND_ASSIGN(
+      auto to_object,
+      schema::ToObject::Make(entity_schema, /*validate_schema=*/true,
+                             &*db_impl));
+  ASSERT_OK(to_object(objects));
+  auto expected_schemas = DataSliceImpl::Create(kSize, entity_schema);
+  EXPECT_THAT(db_impl->GetAttr(objects, schema::kSchemaAttr),
+              IsOkAndHolds(IsEquivalentTo(expected_schemas)));
+  // Embedding the same schema again passes the validation.
+  ASSERT_OK(to_object(objects));
+
+  DataItem schema2(internal::AllocateExplicitSchema());
+  ASSERT_OK_AND_ASSIGN(
+      to_object,
+      schema::ToObject::Make(schema2, /*validate_schema=*/true, &*db_impl));
+  EXPECT_THAT(to_object(objects),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("existing schemas")));
+
+  // Overwriting the schema of one object keeps the others.
+  ASSERT_OK_AND_ASSIGN(
+      to_object,
+      schema::ToObject::Make(schema2, /*validate_schema=*/false, &*db_impl));
+  ASSERT_OK(to_object(DataSliceImpl::Create({objects[1]})));
+  ASSERT_OK_AND_ASSIGN(auto schemas,
+                       db_impl->GetAttr(objects, schema::kSchemaAttr));
+  EXPECT_EQ(schemas[0], entity_schema);
+  EXPECT_EQ(schemas[1], schema2);
+  EXPECT_EQ(schemas[kSize - 1], entity_schema);
+}
+
 }  // namespace
 }  // namespace koladata::schema
@@ -15,14 +15,19 @@
 #include "koladata/internal/data_bag.h"
 
 #include <algorithm>
+#include <array>
+#include <atomic>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <functional>
 #include <memory>
+#include <numeric>
 #include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <variant>
 #include <vector>
 
 #include "absl/base/attributes.h"
@@ -32,6 +37,7 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
@@ -40,7 +46,9 @@
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
+#include "koladata/internal/access_profile.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_list.h"
 #include "koladata/internal/data_slice.h"
@@ -50,19 +58,27 @@
 #include "koladata/internal/dtype.h"
 #include "koladata/internal/error.pb.h"
 #include "koladata/internal/error_utils.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/memory_usage.h"
 #include "koladata/internal/object_id.h"
+#include "koladata/internal/op_utils/approx_count_distinct.h"
 #include "koladata/internal/op_utils/has.h"
 #include "koladata/internal/op_utils/presence_or.h"
 #include "koladata/internal/schema_utils.h"
 #include "koladata/internal/sparse_source.h"
+#include "koladata/internal/types.h"
 #include "koladata/internal/uuid_object.h"
+#include "arolla/dense_array/bitmap.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/edge.h"
 #include "arolla/dense_array/ops/dense_ops.h"
 #include "arolla/memory/buffer.h"
 #include "arolla/memory/optional_value.h"
+#include "arolla/memory/strings_buffer.h"
 #include "arolla/qtype/qtype.h"
 #include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/fingerprint.h"
+#include "arolla/util/meta.h"
 #include "arolla/util/refcount_ptr.h"
 #include "arolla/util/text.h"
 #include "arolla/util/unit.h"
@@ -74,8 +90,58 @@ namespace koladata::internal {
 namespace {
 
 constexpr size_t kSparseSourceSparsityCoef = 64;
+std::atomic<int64_t> max_fork_depth = DataBagImpl::kDefaultMaxForkDepth;
+std::atomic<double> sparse_source_promotion_ratio =
+    DataBagImpl::kDefaultSparseSourcePromotionRatio;
 ABSL_CONST_INIT const DataList kEmptyList;
 
+// Atomic counterpart of DataBagStats. Relaxed atomics are enough since the
+// counters are independent.
+struct AtomicDataBagStats {
+  struct OpStats {
+    std::atomic<int64_t> calls = 0;
+    std::atomic<int64_t> elements = 0;
+
+    void Add(int64_t element_count) {
+      calls.fetch_add(1, std::memory_order_relaxed);
+      elements.fetch_add(element_count, std::memory_order_relaxed);
+    }
+
+    DataBagStats::OpStats Load() const {
+      return {.calls = calls.load(std::memory_order_relaxed),
+              .elements = elements.load(std::memory_order_relaxed)};
+    }
+
+    void Reset() {
+      calls.store(0, std::memory_order_relaxed);
+      elements.store(0, std::memory_order_relaxed);
+    }
+  };
+
+  OpStats get_attr;
+  OpStats set_attr;
+  OpStats get_from_dict;
+  OpStats explode_list;
+  OpStats merge_inplace;
+  std::atomic<int64_t> fallback_lookups = 0;
+  std::atomic<int64_t> parent_chain_steps = 0;
+  std::atomic<int64_t> dense_source_reads = 0;
+  std::atomic<int64_t> sparse_source_reads = 0;
+  std::atomic<int64_t> dense_source_writes = 0;
+  std::atomic<int64_t> sparse_source_writes = 0;
+};
+
+ABSL_CONST_INIT std::atomic<bool> stats_enabled = false;
+ABSL_CONST_INIT AtomicDataBagStats global_stats;
+
+bool IsStatsEnabled() {
+  return ABSL_PREDICT_FALSE(stats_enabled.load(std::memory_order_relaxed));
+}
+
+void AddStat(std::atomic<int64_t>& counter, int64_t value) {
+  counter.fetch_add(value, std::memory_order_relaxed);
+}
+
 absl::StatusOr<ObjectId> ItemToListObjectId(const DataItem& list) {
   if (list.holds_value<ObjectId>()) {
     if (ObjectId list_id = list.value<ObjectId>(); list_id.IsList()) {
@@ -136,9 +202,9 @@ std::shared_ptr<SparseSource> MergeToMutableSparseSource(
   sources.remove_suffix(1);
   for (auto source_it = sources.rbegin(); source_it != sources.rend();
        ++source_it) {
-    for (const auto& [key, item] : (*source_it)->GetAll()) {
+    (*source_it)->ForEach([&](ObjectId key, const DataItem& item) {
       result->Set(key, item);
-    }
+    });
   }
   return result;
 }
@@ -159,13 +225,11 @@ absl::Status ProcessSparseSources(
   }
   if (sources.size() > 2) {
     absl::flat_hash_set<ObjectId> seen_ids;
-    for (const auto& [key, _] : sources[0]->GetAll()) {
-      seen_ids.insert(key);
-    }
+    sources[0]->ForEach(
+        [&](ObjectId key, const DataItem&) { seen_ids.insert(key); });
     for (int64_t i = 2; i < sources.size(); ++i) {
-      for (const auto& [key, _] : sources[i - 1]->GetAll()) {
-        seen_ids.insert(key);
-      }
+      sources[i - 1]->ForEach(
+          [&](ObjectId key, const DataItem&) { seen_ids.insert(key); });
       RETURN_IF_ERROR(process_source(sources[i], [&seen_ids](ObjectId id) {
         return seen_ids.contains(id);
       }));
@@ -183,24 +247,24 @@ absl::Status MergeToMutableDenseSourceOnlySparse(
   DCHECK(result.IsMutable());
   auto process_source = [&](const SparseSource* source,
                             auto skip_obj_fn) -> absl::Status {
-    for (const auto& [key, item] : source->GetAll()) {
-      if (!item.has_value() || skip_obj_fn(key)) {
-        continue;
-      }
-      if (options.data_conflict_policy == MergeOptions::kOverwrite) {
-        RETURN_IF_ERROR(result.Set(key, item));
-        continue;
-      }
-      if (auto this_result = result.Get(key); !this_result.has_value()) {
-        RETURN_IF_ERROR(result.Set(key, item));
-      } else if (options.data_conflict_policy ==
-                     MergeOptions::kRaiseOnConflict &&
-                 this_result != item) {
-        return absl::FailedPreconditionError(
-            absl::StrCat("conflict ", key, ": ", this_result, " vs ", item));
-      }
-    }
-    return absl::OkStatus();
+    return source->ForEach(
+        [&](ObjectId key, const DataItem& item) -> absl::Status {
+          if (!item.has_value() || skip_obj_fn(key)) {
+            return absl::OkStatus();
+          }
+          if (options.data_conflict_policy == MergeOptions::kOverwrite) {
+            return result.Set(key, item);
+          }
+          if (auto this_result = result.Get(key); !this_result.has_value()) {
+            RETURN_IF_ERROR(result.Set(key, item));
+          } else if (options.data_conflict_policy ==
+                         MergeOptions::kRaiseOnConflict &&
+                     this_result != item) {
+            return absl::FailedPreconditionError(absl::StrCat(
+                "conflict ", key, ": ", this_result, " vs ", item));
+          }
+          return absl::OkStatus();
+        });
   };
   return ProcessSparseSources(process_source, sources);
 }
@@ -213,25 +277,26 @@ absl::Status MergeToMutableSparseSourceOnlySparse(
     MergeOptions options) {
   auto process_source = [&](const SparseSource* source,
                             auto skip_obj_fn) -> absl::Status {
-    for (const auto& [key, item] : source->GetAll()) {
-      if (!item.has_value() || skip_obj_fn(key)) {
-        continue;
-      }
-      if (options.data_conflict_policy == MergeOptions::kOverwrite) {
-        result.Set(key, item);
-        continue;
-      }
-      if (std::optional<DataItem> this_result = result.Get(key);
-          !this_result.has_value() || !this_result->has_value()) {
-        result.Set(key, item);
-      } else if (options.data_conflict_policy ==
-                     MergeOptions::kRaiseOnConflict &&
-                 *this_result != item) {
-        return absl::FailedPreconditionError(
-            absl::StrCat("conflict ", key, ": ", *this_result, " vs ", item));
-      }
-    }
-    return absl::OkStatus();
+    return source->ForEach(
+        [&](ObjectId key, const DataItem& item) -> absl::Status {
+          if (!item.has_value() || skip_obj_fn(key)) {
+            return absl::OkStatus();
+          }
+          if (options.data_conflict_policy == MergeOptions::kOverwrite) {
+            result.Set(key, item);
+            return absl::OkStatus();
+          }
+          if (std::optional<DataItem> this_result = result.Get(key);
+              !this_result.has_value() || !this_result->has_value()) {
+            result.Set(key, item);
+          } else if (options.data_conflict_policy ==
+                         MergeOptions::kRaiseOnConflict &&
+                     *this_result != item) {
+            return absl::FailedPreconditionError(absl::StrCat(
+                "conflict ", key, ": ", *this_result, " vs ", item));
+          }
+          return absl::OkStatus();
+        });
   };
   return ProcessSparseSources(process_source, sources);
 }
@@ -245,6 +310,7 @@ absl::Status MergeToMutableDenseSource(
     absl::Span<const SparseSource* const> sparse_sources,
     MergeOptions options) {
   DCHECK(result.IsMutable());
+  RETURN_IF_ERROR(dense_source.Load());
   int64_t size = std::min<int64_t>(result.size(), dense_source.size());
   if (sparse_sources.empty()) {
     DCHECK_EQ(dense_source.allocation_id(), alloc);
@@ -319,27 +385,354 @@ MergeOptions ReverseMergeOptions(const MergeOptions& options) {
   return DataBagImplPtr::Make(PrivateConstructorTag{});
 }
 
+int64_t DataBagImpl::MaxForkDepth() {
+  return max_fork_depth.load(std::memory_order_relaxed);
+}
+
+void DataBagImpl::SetMaxForkDepth(int64_t value) {
+  max_fork_depth.store(value, std::memory_order_relaxed);
+}
+
+double DataBagImpl::SparseSourcePromotionRatio() {
+  return sparse_source_promotion_ratio.load(std::memory_order_relaxed);
+}
+
+void DataBagImpl::SetSparseSourcePromotionRatio(double ratio) {
+  sparse_source_promotion_ratio.store(ratio, std::memory_order_relaxed);
+}
+
+void DataBagImpl::SetStatsEnabled(bool enabled) {
+  stats_enabled.store(enabled, std::memory_order_relaxed);
+}
+
+bool DataBagImpl::StatsEnabled() { return IsStatsEnabled(); }
+
+DataBagStats DataBagImpl::GetStats() {
+  auto load = [](const std::atomic<int64_t>& counter) {
+    return counter.load(std::memory_order_relaxed);
+  };
+  return DataBagStats{
+      .get_attr = global_stats.get_attr.Load(),
+      .set_attr = global_stats.set_attr.Load(),
+      .get_from_dict = global_stats.get_from_dict.Load(),
+      .explode_list = global_stats.explode_list.Load(),
+      .merge_inplace = global_stats.merge_inplace.Load(),
+      .fallback_lookups = load(global_stats.fallback_lookups),
+      .parent_chain_steps = load(global_stats.parent_chain_steps),
+      .dense_source_reads = load(global_stats.dense_source_reads),
+      .sparse_source_reads = load(global_stats.sparse_source_reads),
+      .dense_source_writes = load(global_stats.dense_source_writes),
+      .sparse_source_writes = load(global_stats.sparse_source_writes),
+  };
+}
+
+void DataBagImpl::ResetStats() {
+  for (auto* op :
+       {&global_stats.get_attr, &global_stats.set_attr,
+        &global_stats.get_from_dict, &global_stats.explode_list,
+        &global_stats.merge_inplace}) {
+    op->Reset();
+  }
+  for (auto* counter :
+       {&global_stats.fallback_lookups, &global_stats.parent_chain_steps,
+        &global_stats.dense_source_reads, &global_stats.sparse_source_reads,
+        &global_stats.dense_source_writes,
+        &global_stats.sparse_source_writes}) {
+    counter->store(0, std::memory_order_relaxed);
+  }
+}
+
 DataBagImplPtr DataBagImpl::PartiallyPersistentFork() const {
+  if (IsLayerEmpty()) {
+    auto res_db = DataBagImpl::CreateEmptyDatabag();
+    res_db->parent_data_bag_ = parent_data_bag_;
+    res_db->fork_depth_ = fork_depth_;
+    return res_db;
+  }
+  if (int64_t max_depth = MaxForkDepth();
+      max_depth > 0 && fork_depth_ + 1 > max_depth) {
+    absl::StatusOr<DataBagImplPtr> res_db = CreateSquashedFork();
+    if (res_db.ok()) {
+      return *std::move(res_db);
+    }
+    LOG(ERROR) << "failed to squash DataBagImpl fork chain: "
+               << res_db.status();
+  }
   auto res_db = DataBagImpl::CreateEmptyDatabag();
-  res_db->parent_data_bag_ = sources_.empty() && small_alloc_sources_.empty() &&
-                                     lists_.empty() && dicts_.empty()
-                                 ? parent_data_bag_
-                                 : DataBagImplConstPtr::NewRef(this);
+  res_db->parent_data_bag_ = DataBagImplConstPtr::NewRef(this);
+  res_db->fork_depth_ = fork_depth_ + 1;
   return res_db;
 }
 
+absl::StatusOr<DataBagImplPtr> DataBagImpl::CreateSquashedFork() const {
+  auto res_db = DataBagImpl::CreateEmptyDatabag();
+  // Attributes of big allocations. The DataBagImpls of the chain are not
+  // modified anymore, so the collections that hold all the values of their
+  // key in a dense source share it. Only the keys with sparse values, which
+  // can be spread over several layers, are merged.
+  absl::flat_hash_map<AllocationId, absl::flat_hash_set<absl::string_view>>
+      used_keys;
+  for (const DataBagImpl* db = this; db != nullptr;
+       db = db->parent_data_bag_.get()) {
+    for (const auto& [alloc, alloc_sources] : db->sources_) {
+      absl::flat_hash_set<absl::string_view>& used_attrs = used_keys[alloc];
+      for (const auto& [attr, collection] : alloc_sources) {
+        if (!used_attrs.insert(attr).second) {
+          continue;
+        }
+        SourceCollection& res_collection =
+            res_db->GetOrCreateSourceCollection(alloc, attr);
+        if (!collection.lookup_parent &&
+            collection.mutable_sparse_source == nullptr) {
+          if (collection.mutable_dense_source != nullptr) {
+            res_collection.const_dense_source = collection.mutable_dense_source;
+          } else {
+            res_collection.const_dense_source = collection.const_dense_source;
+          }
+          continue;
+        }
+        RETURN_IF_ERROR(res_db->MergeBigAllocSourceInplace(
+            *this, *db, alloc, attr, collection, res_collection,
+            MergeOptions()));
+      }
+    }
+  }
+  // Small allocation attributes, lists and dicts. None of them are in
+  // `res_db` yet, so the lists and the dicts share the pages of the chain.
+  std::shared_ptr<const DataBagIndex> res_index = res_db->GetIndexSnapshot();
+  std::vector<MergeTask> tasks;
+  res_db->CollectSmallAllocMergeTasks(*this, MergeOptions(), tasks);
+  res_db->CollectListsMergeTasks(*this, MergeOptions(), *res_index, tasks);
+  res_db->CollectDictsMergeTasks(*this, MergeOptions(), *res_index, tasks);
+  for (MergeTask& task : tasks) {
+    RETURN_IF_ERROR(std::move(task)());
+  }
+  return res_db;
+}
+
+namespace {
+
+// Returns `values` with each distinct text stored only once in the characters
+// buffer (repeated items reference the same characters), or std::nullopt if
+// there are more than `max_distinct_ratio` distinct values among the present
+// ones.
+std::optional<arolla::DenseArray<arolla::Text>> DeduplicateTexts(
+    const arolla::DenseArray<arolla::Text>& values, double max_distinct_ratio) {
+  using Offsets = arolla::StringsBuffer::Offsets;
+  const int64_t max_distinct =
+      static_cast<int64_t>(max_distinct_ratio * values.PresentCount());
+  if (max_distinct == 0) {
+    return std::nullopt;
+  }
+  absl::flat_hash_map<absl::string_view, Offsets> offsets_by_value;
+  arolla::Buffer<Offsets>::Builder offsets_bldr(values.size());
+  absl::Span<Offsets> offsets = offsets_bldr.GetMutableSpan();
+  std::string characters;
+  bool too_many_distinct = false;
+  values.ForEach([&](int64_t id, bool present, absl::string_view value) {
+    if (too_many_distinct) {
+      return;
+    }
+    if (!present) {
+      offsets[id] = {0, 0};
+      return;
+    }
+    auto [it, inserted] = offsets_by_value.try_emplace(value);
+    if (inserted) {
+      if (offsets_by_value.size() > max_distinct) {
+        too_many_distinct = true;
+        return;
+      }
+      it->second = {static_cast<int64_t>(characters.size()),
+                    static_cast<int64_t>(characters.size() + value.size())};
+      characters.append(value);
+    }
+    offsets[id] = it->second;
+  });
+  if (too_many_distinct) {
+    return std::nullopt;
+  }
+  arolla::Buffer<char>::Builder characters_bldr(characters.size());
+  std::copy(characters.begin(), characters.end(),
+            characters_bldr.GetMutableSpan().begin());
+  return arolla::DenseArray<arolla::Text>{
+      arolla::StringsBuffer(std::move(offsets_bldr).Build(),
+                            std::move(characters_bldr).Build()),
+      values.bitmap, values.bitmap_bit_offset};
+}
+
+AttrContentStats ComputeAttrContentStats(AllocationId alloc,
+                                         const DataSliceImpl& values) {
+  AttrContentStats content{
+      .capacity = static_cast<int64_t>(alloc.Capacity()),
+      .is_text = values.dtype() == arolla::GetQType<arolla::Text>()};
+  HyperLogLog sketch(kDefaultHyperLogLogPrecision);
+  DataItem::Hash hash;
+  for (int64_t i = 0; i < values.size(); ++i) {
+    DataItem item = values[i];
+    if (item.has_value()) {
+      ++content.present;
+      content.prefix_size = i + 1;
+      sketch.Add(hash(item));
+    }
+  }
+  content.distinct = std::llround(sketch.Estimate());
+  return content;
+}
+
+using AccessProfileIndex =
+    absl::flat_hash_map<AllocationId,
+                        absl::flat_hash_map<std::string, AttrAccessStats>>;
+
+AccessProfileIndex IndexAccessProfile(const AccessProfile& profile) {
+  AccessProfileIndex index;
+  for (const AttrAccessProfile& entry : profile) {
+    index[entry.alloc][entry.attr] = entry.stats;
+  }
+  return index;
+}
+
+const AttrAccessStats* FindAttrAccess(const AccessProfileIndex& index,
+                                      AllocationId alloc,
+                                      absl::string_view attr) {
+  auto alloc_it = index.find(alloc);
+  if (alloc_it == index.end()) {
+    return nullptr;
+  }
+  auto attr_it = alloc_it->second.find(attr);
+  return attr_it == alloc_it->second.end() ? nullptr : &attr_it->second;
+}
+
+}  // namespace
+
+absl::StatusOr<DataBagImplPtr> DataBagImpl::CreateOptimized(
+    const OptimizeOptions& options) const {
+  // Merging into an empty DataBagImpl copies the data of all the parents.
+  auto res = DataBagImpl::CreateEmptyDatabag();
+  RETURN_IF_ERROR(res->MergeInplace(*this));
+  AccessProfileIndex profile;
+  if (options.use_access_profile) {
+    profile = IndexAccessProfile(GetAccessProfile());
+  }
+  for (auto& [alloc, alloc_sources] : res->sources_) {
+    for (auto& [attr, collection] : alloc_sources) {
+      const AttrAccessStats* access = FindAttrAccess(profile, alloc, attr);
+      std::optional<DataSliceImpl> values;
+      if (const SparseSource* sparse = collection.mutable_sparse_source.get();
+          sparse != nullptr) {
+        if (access == nullptr &&
+            sparse->size() < options.sparse_to_dense_ratio * alloc.Capacity()) {
+          continue;
+        }
+        values = sparse->Get(
+            DataSliceImpl::ObjectsFromAllocation(alloc, alloc.Capacity())
+                .values<ObjectId>());
+      } else if (const DenseSource* dense =
+                     collection.mutable_dense_source.get();
+                 dense != nullptr) {
+        // Copies the values, so the memory reserved for future
+        // modifications is released.
+        values = dense->GetPrefix(dense->size());
+        if (!values.has_value()) {
+          values = dense->Get(
+              DataSliceImpl::ObjectsFromAllocation(alloc, dense->size())
+                  .values<ObjectId>());
+        }
+      } else {
+        // Readonly sources can be memory mapped or not loaded yet, so they
+        // are kept as is.
+        continue;
+      }
+      if (values->is_empty_and_unknown()) {
+        continue;
+      }
+      double max_distinct_text_ratio = options.max_distinct_text_ratio;
+      bool dict_encode = true;
+      if (access != nullptr) {
+        const AttrContentStats content =
+            ComputeAttrContentStats(alloc, *values);
+        const StorageLayout layout = RecommendStorageLayout(
+            *access, content, options.sparse_to_dense_ratio,
+            options.max_distinct_text_ratio);
+        if (layout == StorageLayout::kSparse &&
+            collection.mutable_sparse_source != nullptr) {
+          continue;
+        }
+        if (layout == StorageLayout::kConstant) {
+          ASSIGN_OR_RETURN(collection.const_dense_source,
+                           DenseSource::CreateConstant(
+                               alloc, content.prefix_size, (*values)[0]));
+          collection.mutable_dense_source = nullptr;
+          collection.mutable_sparse_source = nullptr;
+          continue;
+        }
+        max_distinct_text_ratio =
+            layout == StorageLayout::kDictEncoded ? 1.0 : 0.0;
+        dict_encode = layout == StorageLayout::kDictEncoded;
+      }
+      if (values->dtype() == arolla::GetQType<arolla::Text>()) {
+        if (auto texts = DeduplicateTexts(values->values<arolla::Text>(),
+                                          max_distinct_text_ratio)) {
+          values = DataSliceImpl::Create(*std::move(texts));
+        }
+      }
+      ASSIGN_OR_RETURN(
+          collection.const_dense_source,
+          dict_encode ? DenseSource::CreateDictEncodedReadonly(alloc, *values)
+                      : DenseSource::CreateReadonly(alloc, *values));
+      collection.mutable_dense_source = nullptr;
+      collection.mutable_sparse_source = nullptr;
+    }
+  }
+  if (options.build_index) {
+    res->GetIndexSnapshot();
+  }
+  return res;
+}
+
+absl::StatusOr<std::vector<StorageLayoutRecommendation>>
+DataBagImpl::RecommendStorageLayouts(const AccessProfile& profile,
+                                     const OptimizeOptions& options) const {
+  std::vector<StorageLayoutRecommendation> result;
+  for (const AttrAccessProfile& entry : profile) {
+    if (entry.alloc.IsSmall()) {
+      continue;
+    }
+    ConstDenseSourceArray dense_sources;
+    ConstSparseSourceArray sparse_sources;
+    const int64_t size = GetAttributeDataSources(entry.alloc, entry.attr,
+                                                 dense_sources, sparse_sources);
+    if (dense_sources.empty() && sparse_sources.empty()) {
+      continue;
+    }
+    ASSIGN_OR_RETURN(
+        DataSliceImpl values,
+        GetAttributeFromSources(
+            DataSliceImpl::ObjectsFromAllocation(entry.alloc, size),
+            dense_sources, sparse_sources));
+    StorageLayoutRecommendation& recommendation = result.emplace_back();
+    recommendation.alloc = entry.alloc;
+    recommendation.attr = entry.attr;
+    recommendation.access = entry.stats;
+    recommendation.content = ComputeAttrContentStats(entry.alloc, values);
+    recommendation.layout = RecommendStorageLayout(
+        entry.stats, recommendation.content, options.sparse_to_dense_ratio,
+        options.max_distinct_text_ratio);
+  }
+  return result;
+}
+
 // *******  Const interface
 
-DataItem DataBagImpl::LookupAttrInDataSourcesMap(ObjectId object_id,
-                                                 absl::string_view attr) const {
+absl::StatusOr<DataItem> DataBagImpl::LookupAttrInDataSourcesMap(
+    ObjectId object_id, const PreHashedAttr& attr) const {
   const DataBagImpl* cur_data_bag = this;
   AllocationId alloc_id(object_id);
-  SourceKeyView search_key{alloc_id, attr};
-  size_t search_hash = absl::HashOf(search_key);
   while (cur_data_bag != nullptr) {
-    if (auto it = cur_data_bag->sources_.find(search_key, search_hash);
-        it != cur_data_bag->sources_.end()) {
-      const SourceCollection& collection = it->second;
+    if (const SourceCollection* it =
+            cur_data_bag->FindSourceCollection(alloc_id, attr);
+        it != nullptr) {
+      const SourceCollection& collection = *it;
       // mutable source overrides const source if both present.
       if (auto* s = collection.mutable_sparse_source.get(); s != nullptr) {
         std::optional<DataItem> res = s->Get(object_id);
@@ -352,6 +745,7 @@ DataItem DataBagImpl::LookupAttrInDataSourcesMap(ObjectId object_id,
         return s->Get(object_id);
       }
       if (auto* s = collection.const_dense_source.get(); s != nullptr) {
+        RETURN_IF_ERROR(s->Load());
         return s->Get(object_id);
       }
       cur_data_bag = collection.lookup_parent
@@ -365,11 +759,15 @@ DataItem DataBagImpl::LookupAttrInDataSourcesMap(ObjectId object_id,
 }
 
 SparseSource& DataBagImpl::GetMutableSmallAllocSource(absl::string_view attr) {
-  return small_alloc_sources_[attr];
+  auto [it, inserted] = small_alloc_sources_.try_emplace(attr);
+  if (inserted) {
+    index_.AddSmallAllocAttr(attr);
+  }
+  return it->second;
 }
 
 absl::StatusOr<DataSliceImpl> DataBagImpl::GetAttrFromSources(
-    const DataSliceImpl& objects, absl::string_view attr) const {
+    const DataSliceImpl& objects, const PreHashedAttr& attr) const {
   ConstDenseSourceArray dense_sources;
   ConstSparseSourceArray sparse_sources;
   if (objects.allocation_ids().contains_small_allocation_id()) {
@@ -381,12 +779,22 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::GetAttrFromSources(
   for (AllocationId alloc_id : objects.allocation_ids()) {
     GetAttributeDataSources(alloc_id, attr, dense_sources, sparse_sources);
   }
+  if (IsStatsEnabled()) {
+    AddStat(global_stats.dense_source_reads, dense_sources.size());
+    AddStat(global_stats.sparse_source_reads, sparse_sources.size());
+  }
+  if (ShouldSampleAccess()) {
+    for (AllocationId alloc_id : objects.allocation_ids()) {
+      RecordAttrAccess(alloc_id, attr.name, /*write=*/false, objects.size(),
+                       fork_depth_);
+    }
+  }
   return GetAttributeFromSources(objects, dense_sources, sparse_sources);
 }
 
-absl::StatusOr<DataSliceImpl> DataBagImpl::GetAttr(
-    const DataSliceImpl& objects, absl::string_view attr,
-    FallbackSpan fallbacks) const {
+absl::StatusOr<DataSliceImpl> DataBagImpl::GetAttrImpl(
+    const DataSliceImpl& objects, const PreHashedAttr& attr,
+    FallbackSpan fallbacks, bool& looked_up_fallbacks) const {
   if (objects.is_empty_and_unknown()) {
     return DataSliceImpl::CreateEmptyAndUnknownType(objects.size());
   }
@@ -395,29 +803,259 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::GetAttr(
         "getting attributes of primitives is not allowed");
   }
   ASSIGN_OR_RETURN(auto result, GetAttrFromSources(objects, attr));
-  if (fallbacks.empty()) {
-    return result;
+  const size_t present_count = objects.present_count();
+  for (const DataBagImpl* fallback : fallbacks) {
+    if (result.present_count() == present_count) {
+      break;
+    }
+    looked_up_fallbacks = true;
+    ASSIGN_OR_RETURN(auto fb_result,
+                     fallback->GetAttrFromSources(objects, attr));
+    if (result.is_empty_and_unknown()) {
+      result = std::move(fb_result);
+    } else {
+      ASSIGN_OR_RETURN(result, PresenceOrOp{}(result, fb_result));
+    }
   }
+  return result;
+}
 
-  if (result.is_empty_and_unknown()) {
-    return fallbacks[0]->GetAttr(objects, attr, fallbacks.subspan(1));
-  }
+namespace {
 
-  auto presence_result = PresenceDenseArray(result);
-  if (presence_result.PresentCount() == objects.present_count()) {
-    return result;
+// Records one batch GetAttr call of `size` objects.
+void RecordGetAttr(int64_t size, bool looked_up_fallbacks) {
+  if (IsStatsEnabled()) {
+    global_stats.get_attr.Add(size);
+    if (looked_up_fallbacks) {
+      AddStat(global_stats.fallback_lookups, 1);
+    }
   }
+}
 
-  for (const DataBagImpl* fallback : fallbacks) {
-    ASSIGN_OR_RETURN(auto fb_result,
-                     fallback->GetAttrFromSources(objects, attr));
-    ASSIGN_OR_RETURN(result, PresenceOrOp{}(result, fb_result));
+}  // namespace
+
+absl::StatusOr<DataSliceImpl> DataBagImpl::GetAttr(
+    const DataSliceImpl& objects, absl::string_view attr,
+    FallbackSpan fallbacks) const {
+  bool looked_up_fallbacks = false;
+  ASSIGN_OR_RETURN(auto result, GetAttrImpl(objects, PreHashedAttr(attr),
+                                            fallbacks, looked_up_fallbacks));
+  if (objects.dtype() == arolla::GetQType<ObjectId>()) {
+    RecordGetAttr(objects.size(), looked_up_fallbacks);
   }
   return result;
 }
 
+namespace {
+
+// Concatenates the results of looking up consecutive ranges of `size` objects.
+DataSliceImpl ConcatChunks(absl::Span<const DataSliceImpl> chunk_results,
+                           int64_t size) {
+  DataSliceImpl::Builder bldr(size);
+  int64_t offset = 0;
+  for (const DataSliceImpl& chunk_result : chunk_results) {
+    chunk_result.VisitValues([&]<class T>(const arolla::DenseArray<T>& values) {
+      auto& array_bldr = bldr.GetArrayBuilder<T>();
+      values.ForEachPresent([&](int64_t id, arolla::view_type_t<T> value) {
+        array_bldr.Set(offset + id, value);
+      });
+    });
+    bldr.GetMutableAllocationIds().Insert(chunk_result.allocation_ids());
+    offset += chunk_result.size();
+  }
+  return std::move(bldr).Build();
+}
+
+}  // namespace
+
+absl::StatusOr<DataSliceImpl> DataBagImpl::GetAttr(
+    const DataSliceImpl& objects, absl::string_view attr,
+    FallbackSpan fallbacks, const ParallelOptions& options) const {
+  const int64_t size = objects.size();
+  const int64_t max_chunks =
+      ParallelChunkCount(options.executor, size, options.min_chunk_size);
+  if (max_chunks <= 1 || objects.dtype() != arolla::GetQType<ObjectId>()) {
+    return GetAttr(objects, attr, fallbacks);
+  }
+  const ObjectIdArray& objs = objects.values<ObjectId>();
+  // Chunk boundaries are aligned to the bitmap words, so that the chunks can
+  // set the presence bits of the result concurrently.
+  constexpr int64_t kWordBits = arolla::bitmap::kWordBitCount;
+  const int64_t chunk_size =
+      ((size + max_chunks - 1) / max_chunks + kWordBits - 1) / kWordBits *
+      kWordBits;
+  const int64_t num_chunks = (size + chunk_size - 1) / chunk_size;
+  const PreHashedAttr hashed_attr(attr);
+
+  // Presized result arrays of the fixed size types, indexed by ScalarTypeId.
+  // Each chunk writes its values directly into its range of the arrays. Text
+  // and Bytes builders append to a shared characters buffer, so such chunk
+  // results are kept and copied sequentially at the end.
+  std::array<ArrayBuilderVariant, std::variant_size_v<ScalarVariant>>
+      array_bldrs;
+  std::vector<DataSliceImpl> string_chunk_results(num_chunks);
+  AllocationIdSet allocation_ids;
+  absl::Mutex mutex;
+  // Not std::vector<bool>, since the chunks write it concurrently.
+  std::vector<char> chunk_looked_up_fallbacks(num_chunks, false);
+  RETURN_IF_ERROR(ParallelFor(
+      options.executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+        int64_t offset = chunk * chunk_size;
+        int64_t chunk_len = std::min(chunk_size, size - offset);
+        // AllocationIdSet of the whole slice is a superset for the chunk,
+        // which is fine for the lookup.
+        auto chunk_objects = DataSliceImpl::CreateObjectsDataSlice(
+            objs.Slice(offset, chunk_len), objects.allocation_ids());
+        bool looked_up_fallbacks = false;
+        ASSIGN_OR_RETURN(DataSliceImpl chunk_result,
+                         GetAttrImpl(chunk_objects, hashed_attr, fallbacks,
+                                     looked_up_fallbacks));
+        chunk_looked_up_fallbacks[chunk] = looked_up_fallbacks;
+        bool has_strings = false;
+        chunk_result.VisitValues(
+            [&]<class T>(const arolla::DenseArray<T>& values) {
+              if constexpr (std::is_same_v<T, arolla::Text> ||
+                            std::is_same_v<T, arolla::Bytes>) {
+                has_strings = true;
+              } else {
+                arolla::DenseArrayBuilder<T>* array_bldr;
+                {
+                  absl::MutexLock lock(&mutex);
+                  auto& slot = array_bldrs[ScalarTypeId<T>()];
+                  if (std::holds_alternative<std::monostate>(slot)) {
+                    slot.emplace<arolla::DenseArrayBuilder<T>>(size);
+                  }
+                  array_bldr = &std::get<arolla::DenseArrayBuilder<T>>(slot);
+                }
+                values.ForEachPresent(
+                    [&](int64_t id, arolla::view_type_t<T> value) {
+                      array_bldr->Set(offset + id, value);
+                    });
+              }
+            });
+        absl::MutexLock lock(&mutex);
+        allocation_ids.Insert(chunk_result.allocation_ids());
+        if (has_strings) {
+          string_chunk_results[chunk] = std::move(chunk_result);
+        }
+        return absl::OkStatus();
+      }));
+  RecordGetAttr(size, std::find(chunk_looked_up_fallbacks.begin(),
+                                chunk_looked_up_fallbacks.end(),
+                                true) != chunk_looked_up_fallbacks.end());
+
+  DataSliceImpl::Builder bldr(size);
+  for (int64_t chunk = 0; chunk < num_chunks; ++chunk) {
+    string_chunk_results[chunk].VisitValues(
+        [&]<class T>(const arolla::DenseArray<T>& values) {
+          if constexpr (std::is_same_v<T, arolla::Text> ||
+                        std::is_same_v<T, arolla::Bytes>) {
+            auto& array_bldr = bldr.GetArrayBuilder<T>();
+            values.ForEachPresent(
+                [&](int64_t id, arolla::view_type_t<T> value) {
+                  array_bldr.Set(chunk * chunk_size + id, value);
+                });
+          }
+        });
+  }
+  for (ArrayBuilderVariant& array_bldr : array_bldrs) {
+    std::visit(
+        [&]<class B>(B& b) {
+          if constexpr (!std::is_same_v<B, std::monostate>) {
+            bldr.AddArray(std::move(b).Build());
+          }
+        },
+        array_bldr);
+  }
+  bldr.GetMutableAllocationIds().Insert(allocation_ids);
+  return std::move(bldr).Build();
+}
+
+absl::StatusOr<DataSliceImpl> DataBagImpl::GetAttrPath(
+    const DataSliceImpl& objects, absl::Span<const absl::string_view> attrs,
+    FallbackSpan fallbacks) const {
+  const int64_t size = objects.size();
+  if (attrs.size() <= 1 || size <= kGetAttrPathChunkSize ||
+      objects.dtype() != arolla::GetQType<ObjectId>()) {
+    DataSliceImpl slice = objects;
+    for (absl::string_view attr : attrs) {
+      ASSIGN_OR_RETURN(slice, GetAttr(slice, attr, fallbacks));
+    }
+    return slice;
+  }
+  std::vector<PreHashedAttr> hashed_attrs(attrs.begin(), attrs.end());
+  std::vector<char> looked_up_fallbacks(attrs.size(), false);
+  auto get_path = [&](DataSliceImpl slice) -> absl::StatusOr<DataSliceImpl> {
+    for (size_t i = 0; i < hashed_attrs.size(); ++i) {
+      bool attr_looked_up_fallbacks = false;
+      ASSIGN_OR_RETURN(slice, GetAttrImpl(slice, hashed_attrs[i], fallbacks,
+                                          attr_looked_up_fallbacks));
+      looked_up_fallbacks[i] |= attr_looked_up_fallbacks;
+    }
+    return slice;
+  };
+  const ObjectIdArray& objs = objects.values<ObjectId>();
+  std::vector<DataSliceImpl> chunk_results;
+  chunk_results.reserve((size + kGetAttrPathChunkSize - 1) /
+                        kGetAttrPathChunkSize);
+  for (int64_t offset = 0; offset < size; offset += kGetAttrPathChunkSize) {
+    auto chunk_objects = DataSliceImpl::CreateObjectsDataSlice(
+        objs.Slice(offset, std::min(kGetAttrPathChunkSize, size - offset)),
+        objects.allocation_ids());
+    ASSIGN_OR_RETURN(auto chunk_result, get_path(std::move(chunk_objects)));
+    chunk_results.push_back(std::move(chunk_result));
+  }
+  for (char attr_looked_up_fallbacks : looked_up_fallbacks) {
+    RecordGetAttr(size, attr_looked_up_fallbacks);
+  }
+  return ConcatChunks(chunk_results, size);
+}
+
+absl::StatusOr<std::vector<DataSliceImpl>> DataBagImpl::GetAttrs(
+    const DataSliceImpl& objects, absl::Span<const absl::string_view> attrs,
+    FallbackSpan fallbacks) const {
+  std::vector<DataSliceImpl> results;
+  results.reserve(attrs.size());
+  if (objects.is_empty_and_unknown()) {
+    results.resize(attrs.size(),
+                   DataSliceImpl::CreateEmptyAndUnknownType(objects.size()));
+    return results;
+  }
+  if (objects.dtype() != arolla::GetQType<ObjectId>()) {
+    return absl::FailedPreconditionError(
+        "getting attributes of primitives is not allowed");
+  }
+  const size_t present_count = objects.present_count();
+  const bool stats_enabled = IsStatsEnabled();
+  for (absl::string_view attr_name : attrs) {
+    if (stats_enabled) {
+      global_stats.get_attr.Add(objects.size());
+    }
+    const PreHashedAttr attr(attr_name);
+    ASSIGN_OR_RETURN(auto result, GetAttrFromSources(objects, attr));
+    if (stats_enabled && !fallbacks.empty() &&
+        result.present_count() != present_count) {
+      AddStat(global_stats.fallback_lookups, 1);
+    }
+    for (const DataBagImpl* fallback : fallbacks) {
+      if (result.present_count() == present_count) {
+        break;
+      }
+      ASSIGN_OR_RETURN(auto fb_result,
+                       fallback->GetAttrFromSources(objects, attr));
+      if (result.is_empty_and_unknown()) {
+        result = std::move(fb_result);
+      } else {
+        ASSIGN_OR_RETURN(result, PresenceOrOp{}(result, fb_result));
+      }
+    }
+    results.push_back(std::move(result));
+  }
+  return results;
+}
+
 absl::StatusOr<DataItem> DataBagImpl::GetAttr(const DataItem& object,
-                                              absl::string_view attr,
+                                              const PreHashedAttr& attr,
                                               FallbackSpan fallbacks) const {
   if (!object.holds_value<ObjectId>()) {
     if (object.has_value()) {
@@ -427,6 +1065,10 @@ absl::StatusOr<DataItem> DataBagImpl::GetAttr(const DataItem& object,
       return DataItem();
     }
   }
+  const bool stats_enabled = IsStatsEnabled();
+  if (stats_enabled) {
+    global_stats.get_attr.Add(1);
+  }
   ObjectId object_id = object.value<ObjectId>();
   AllocationId alloc_id(object_id);
   if (alloc_id.IsSmall()) {
@@ -434,6 +1076,9 @@ absl::StatusOr<DataItem> DataBagImpl::GetAttr(const DataItem& object,
     if (result.has_value() || fallbacks.empty()) {
       return result;
     }
+    if (stats_enabled) {
+      AddStat(global_stats.fallback_lookups, 1);
+    }
     for (const DataBagImpl* fallback : fallbacks) {
       if (auto item = fallback->LookupAttrInDataItemMap(object_id, attr);
           item.has_value()) {
@@ -443,34 +1088,58 @@ absl::StatusOr<DataItem> DataBagImpl::GetAttr(const DataItem& object,
     return DataItem();
   }
 
-  auto result = LookupAttrInDataSourcesMap(object_id, attr);
+  if (ShouldSampleAccess()) {
+    RecordAttrAccess(alloc_id, attr.name, /*write=*/false, /*batch_size=*/1,
+                     fork_depth_);
+  }
+  ASSIGN_OR_RETURN(DataItem result,
+                   LookupAttrInDataSourcesMap(object_id, attr));
   if (result.has_value() || fallbacks.empty()) {
     return result;
   }
+  if (stats_enabled) {
+    AddStat(global_stats.fallback_lookups, 1);
+  }
   for (const DataBagImpl* fallback : fallbacks) {
-    if (auto item = fallback->LookupAttrInDataSourcesMap(object_id, attr);
-        item.has_value()) {
+    ASSIGN_OR_RETURN(DataItem item,
+                     fallback->LookupAttrInDataSourcesMap(object_id, attr));
+    if (item.has_value()) {
       return item;
     }
   }
   return DataItem();
 }
 
+namespace {
+
+// Returns an InvalidArgumentError with a missing_object_schema payload, which
+// is only created if the error is rendered.
+absl::Status MissingObjectSchemaError(std::string message,
+                                      DataItem missing_schema_item) {
+  return internal::WithLazyErrorPayload(
+      absl::InvalidArgumentError(std::move(message)),
+      [missing_schema_item =
+           std::move(missing_schema_item)]() -> absl::StatusOr<Error> {
+        Error error;
+        ASSIGN_OR_RETURN(*error.mutable_missing_object_schema()
+                              ->mutable_missing_schema_item(),
+                         EncodeDataItem(missing_schema_item));
+        return error;
+      });
+}
+
+}  // namespace
+
 absl::StatusOr<DataItem> DataBagImpl::GetObjSchemaAttr(
     const DataItem& item, FallbackSpan fallbacks) const {
-  ASSIGN_OR_RETURN(auto schema, GetAttr(item, schema::kSchemaAttr, fallbacks));
+  static const PreHashedAttr kHashedSchemaAttr(schema::kSchemaAttr);
+  ASSIGN_OR_RETURN(auto schema, GetAttr(item, kHashedSchemaAttr, fallbacks));
   if (schema.has_value() || !item.has_value()) {
     return schema;
   }
 
-  internal::Error error;
-  ASSIGN_OR_RETURN(
-      *error.mutable_missing_object_schema()->mutable_missing_schema_item(),
-      internal::EncodeDataItem(item));
-  return internal::WithErrorPayload(
-      absl::InvalidArgumentError(
-          absl::StrFormat("object %v is missing __schema__ attribute", item)),
-      error);
+  return MissingObjectSchemaError(
+      absl::StrFormat("object %v is missing __schema__ attribute", item), item);
 }
 
 absl::StatusOr<DataSliceImpl> DataBagImpl::GetObjSchemaAttr(
@@ -490,22 +1159,16 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::GetObjSchemaAttr(
         }
       },
       slice.AsDataItemDenseArray(), schema.AsDataItemDenseArray()));
-  internal::Error error;
-  ASSIGN_OR_RETURN(
-      *error.mutable_missing_object_schema()->mutable_missing_schema_item(),
-      internal::EncodeDataItem(item_missing_schema));
-
-  return internal::WithErrorPayload(
-      absl::InvalidArgumentError(
-          absl::StrFormat("object %v is missing __schema__ attribute", slice)),
-      error);
+  return MissingObjectSchemaError(
+      absl::StrFormat("object %v is missing __schema__ attribute", slice),
+      std::move(item_missing_schema));
 }
 
 void DataBagImpl::GetSmallAllocDataSources(
-    absl::string_view attr, ConstSparseSourceArray& res_sources) const {
+    const PreHashedAttr& attr, ConstSparseSourceArray& res_sources) const {
   for (const DataBagImpl* db = this; db != nullptr;
        db = db->parent_data_bag_.get()) {
-    if (auto it = db->small_alloc_sources_.find(attr);
+    if (auto it = db->small_alloc_sources_.find(attr.name, attr.hash);
         it != db->small_alloc_sources_.end()) {
       res_sources.push_back(&it->second);
     }
@@ -513,7 +1176,7 @@ void DataBagImpl::GetSmallAllocDataSources(
 }
 
 int64_t DataBagImpl::GetAttributeDataSources(
-    AllocationId alloc, absl::string_view attr,
+    AllocationId alloc, const PreHashedAttr& attr,
     ConstDenseSourceArray& dense_sources,
     ConstSparseSourceArray& sparse_sources) const {
   int64_t size = alloc.Capacity();
@@ -522,12 +1185,13 @@ int64_t DataBagImpl::GetAttributeDataSources(
     return size;
   }
   const DataBagImpl* cur_data_bag = this;
-  SourceKeyView search_key{alloc, attr};
-  size_t search_hash = absl::HashOf(search_key);
+  int64_t chain_steps = 0;
   while (cur_data_bag != nullptr) {
-    if (auto it = cur_data_bag->sources_.find(search_key, search_hash);
-        it != cur_data_bag->sources_.end()) {
-      const SourceCollection& collection = it->second;
+    ++chain_steps;
+    if (const SourceCollection* it =
+            cur_data_bag->FindSourceCollection(alloc, attr);
+        it != nullptr) {
+      const SourceCollection& collection = *it;
       cur_data_bag = collection.lookup_parent
                          ? cur_data_bag->parent_data_bag_.get()
                          : nullptr;
@@ -552,22 +1216,50 @@ int64_t DataBagImpl::GetAttributeDataSources(
       cur_data_bag = cur_data_bag->parent_data_bag_.get();
     }
   }
+  if (IsStatsEnabled()) {
+    AddStat(global_stats.parent_chain_steps, chain_steps);
+  }
   return size;
 }
 
 // *******  Mutable interface
 
+bool DataBagImpl::HasCheapMutableDenseCopy(const SourceCollection& collection,
+                                           AllocationId alloc_id,
+                                           absl::string_view attr) const {
+  if (collection.const_dense_source) {
+    return collection.const_dense_source->HasCheapMutableCopy();
+  }
+  if (!collection.lookup_parent) {
+    return false;
+  }
+  ConstDenseSourceArray dense_sources;
+  ConstSparseSourceArray sparse_sources;
+  parent_data_bag_->GetAttributeDataSources(alloc_id, attr, dense_sources,
+                                            sparse_sources);
+  return dense_sources.size() == 1 &&
+         dense_sources.front()->HasCheapMutableCopy();
+}
+
 absl::Status DataBagImpl::GetOrCreateMutableSourceInCollection(
     SourceCollection& collection, AllocationId alloc_id, absl::string_view attr,
     const arolla::QType* qtype, size_t update_size) {
   if (!collection.mutable_dense_source) {
-    if (update_size <= alloc_id.Capacity() / kSparseSourceSparsityCoef) {
-      if (!collection.mutable_sparse_source) {
+    if (!collection.mutable_sparse_source) {
+      if (update_size <= alloc_id.Capacity() / kSparseSourceSparsityCoef &&
+          !HasCheapMutableDenseCopy(collection, alloc_id, attr)) {
         collection.mutable_sparse_source =
             std::make_shared<SparseSource>(alloc_id);
+        return absl::OkStatus();
       }
+    } else if (update_size <= alloc_id.Capacity() / kSparseSourceSparsityCoef &&
+               collection.mutable_sparse_source->size() + update_size <=
+                   SparseSourcePromotionRatio() * alloc_id.Capacity()) {
       return absl::OkStatus();
     }
+    // Either the update is big or the sparse source became too dense. Many
+    // small updates accumulated in a SparseSource are slower and take more
+    // memory than a DenseSource, so we merge everything into a dense one.
     RETURN_IF_ERROR(CreateMutableDenseSource(collection, alloc_id, attr, qtype,
                                              alloc_id.Capacity()));
   }
@@ -660,19 +1352,125 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::CreateObjectsFromFields(
     }
     return objects;
   }
+  AllocSources& alloc_sources = sources_[alloc_id];
+  alloc_sources.reserve(attr_names.size());
   for (int i = 0; i < attr_names.size(); ++i) {
     std::shared_ptr<DenseSource> source = nullptr;
     if (!slices[i].get().is_empty_and_unknown()) {
       ASSIGN_OR_RETURN(
           source, DenseSource::CreateReadonly(alloc_id, slices[i]));
     }
-    sources_.emplace(SourceKey{alloc_id, std::string(attr_names[i])},
+    if (alloc_sources
+            .emplace(attr_names[i],
                      SourceCollection{.const_dense_source = std::move(source),
-                                      .lookup_parent = false});
+                                      .lookup_parent = false})
+            .second) {
+      index_.AddAttr(attr_names[i], alloc_id);
+    }
   }
   return objects;
 }
 
+absl::Status DataBagImpl::SetAttrForEntireAllocation(
+    AllocationId alloc_id, absl::string_view attr,
+    const DataSliceImpl& values) {
+  if (values.size() > alloc_id.Capacity()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("values don't fit into the allocation: ", values.size(),
+                     " > ", alloc_id.Capacity()));
+  }
+  if (alloc_id.IsSmall()) {
+    // Small allocations share a single SparseSource, so the values are set
+    // object by object.
+    RETURN_IF_ERROR(SetAttr(
+        DataSliceImpl::ObjectsFromAllocation(alloc_id, alloc_id.Capacity()),
+        attr, DataSliceImpl::CreateEmptyAndUnknownType(alloc_id.Capacity())));
+    return SetAttr(
+        DataSliceImpl::ObjectsFromAllocation(alloc_id, values.size()), attr,
+        values);
+  }
+  std::shared_ptr<DenseSource> source = nullptr;
+  if (!values.is_empty_and_unknown()) {
+    ASSIGN_OR_RETURN(source, DenseSource::CreateReadonly(alloc_id, values));
+  }
+  if (sources_[alloc_id]
+          .insert_or_assign(
+              attr, SourceCollection{.const_dense_source = std::move(source),
+                                     .lookup_parent = false})
+          .second) {
+    index_.AddAttr(attr, alloc_id);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status DataBagImpl::SetAttrForEntireAllocation(AllocationId alloc_id,
+                                                     absl::string_view attr,
+                                                     int64_t size,
+                                                     const DataItem& value) {
+  if (alloc_id.IsSmall() || !value.has_value()) {
+    return SetAttrForEntireAllocation(
+        alloc_id, attr,
+        value.has_value() ? DataSliceImpl::Create(size, value)
+                          : DataSliceImpl::CreateEmptyAndUnknownType(size));
+  }
+  if (size > alloc_id.Capacity()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("values don't fit into the allocation: ", size, " > ",
+                     alloc_id.Capacity()));
+  }
+  ASSIGN_OR_RETURN(std::shared_ptr<DenseSource> source,
+                   DenseSource::CreateConstant(alloc_id, size, value));
+  if (sources_[alloc_id]
+          .insert_or_assign(
+              attr, SourceCollection{.const_dense_source = std::move(source),
+                                     .lookup_parent = false})
+          .second) {
+    index_.AddAttr(attr, alloc_id);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status DataBagImpl::SetAttrForEntireAllocationLazily(
+    AllocationId alloc_id, absl::string_view attr,
+    DenseSource::Loader loader) {
+  if (alloc_id.IsSmall()) {
+    ASSIGN_OR_RETURN(DataSliceImpl values, std::move(loader)());
+    return SetAttrForEntireAllocation(alloc_id, attr, values);
+  }
+  SourceCollection collection{
+      .const_dense_source =
+          DenseSource::CreateLazy(alloc_id, std::move(loader)),
+      .lookup_parent = false};
+  if (sources_[alloc_id].insert_or_assign(attr, std::move(collection)).second) {
+    index_.AddAttr(attr, alloc_id);
+  }
+  return absl::OkStatus();
+}
+
+absl::Status DataBagImpl::MoveToSpillPool(SpillPool& pool) {
+  for (auto& [alloc, alloc_sources] : sources_) {
+    for (auto& [_, collection] : alloc_sources) {
+      const DenseSource* source = collection.mutable_dense_source != nullptr
+                                      ? collection.mutable_dense_source.get()
+                                      : collection.const_dense_source.get();
+      if (source == nullptr || source->EstimateMemoryUsage() == 0 ||
+          pool.Manages(*source)) {
+        continue;
+      }
+      std::optional<DataSliceImpl> values = source->GetPrefix(source->size());
+      if (!values.has_value()) {
+        values = source->Get(
+            DataSliceImpl::ObjectsFromAllocation(alloc, source->size())
+                .values<ObjectId>());
+      }
+      ASSIGN_OR_RETURN(collection.const_dense_source,
+                       pool.CreateSource(alloc, *values));
+      collection.mutable_dense_source = nullptr;
+    }
+  }
+  return absl::OkStatus();
+}
+
 absl::StatusOr<DataItem> DataBagImpl::CreateObjectsFromFields(
     absl::Span<const absl::string_view> attr_names,
     absl::Span<const std::reference_wrapper<const DataItem>> items) {
@@ -720,26 +1518,24 @@ absl::Status DataBagImpl::CreateMutableDenseSource(
   }
 
   if (!sparse_sources.empty()) {
-    std::unique_ptr<absl::flat_hash_map<ObjectId, DataItem>> mutable_data;
-    const absl::flat_hash_map<ObjectId, DataItem>* data = nullptr;
-    if (sparse_sources.size() == 1) {
-      data = &sparse_sources.front()->GetAll();
-    } else {
-      mutable_data = std::make_unique<absl::flat_hash_map<ObjectId, DataItem>>(
-          sparse_sources.front()->GetAll());
-      for (int i = 1; i < sparse_sources.size(); ++i) {
-        for (const auto& [obj, data_item] : sparse_sources[i]->GetAll()) {
-          mutable_data->try_emplace(obj, data_item);
+    // Sources are ordered by priority, so we keep the first value for each
+    // object.
+    absl::flat_hash_set<ObjectId> seen_objs;
+    std::vector<std::pair<ObjectId, const DataItem*>> data;
+    data.reserve(sparse_sources.front()->size());
+    for (const SparseSource* source : sparse_sources) {
+      source->ForEach([&](ObjectId obj, const DataItem& data_item) {
+        if (sparse_sources.size() == 1 || seen_objs.insert(obj).second) {
+          data.emplace_back(obj, &data_item);
         }
-      }
-      data = mutable_data.get();
+      });
     }
-    arolla::Buffer<ObjectId>::Builder objs_bldr(data->size());
+    arolla::Buffer<ObjectId>::Builder objs_bldr(data.size());
     int64_t offset = 0;
-    DataSliceImpl::Builder slice_bldr(data->size());
-    for (const auto& [obj, data_item] : *data) {
+    DataSliceImpl::Builder slice_bldr(data.size());
+    for (const auto& [obj, data_item] : data) {
       objs_bldr.Set(offset, obj);
-      slice_bldr.Insert(offset, data_item);
+      slice_bldr.Insert(offset, *data_item);
       offset++;
     }
     RETURN_IF_ERROR(collection.mutable_dense_source->Set(
@@ -753,9 +1549,11 @@ absl::Status DataBagImpl::CreateMutableDenseSource(
 
 DataBagImpl::SourceCollection& DataBagImpl::GetOrCreateSourceCollection(
     AllocationId alloc_id, absl::string_view attr) {
-  auto [it, _] = sources_.emplace(
-      SourceKeyView{alloc_id, attr},
-      SourceCollection{.lookup_parent = parent_data_bag_ != nullptr});
+  auto [it, inserted] = sources_[alloc_id].try_emplace(
+      attr, SourceCollection{.lookup_parent = parent_data_bag_ != nullptr});
+  if (inserted) {
+    index_.AddAttr(attr, alloc_id);
+  }
   return it->second;
 }
 
@@ -773,12 +1571,27 @@ absl::Status DataBagImpl::SetAttr(const DataSliceImpl& objects,
       !objects.allocation_ids().contains_small_allocation_id()) {
     return absl::OkStatus();
   }
+  const bool stats_enabled = IsStatsEnabled();
+  if (stats_enabled) {
+    global_stats.set_attr.Add(objects.size());
+  }
+  const bool sample_access = ShouldSampleAccess();
   for (AllocationId alloc_id : objects.allocation_ids()) {
+    if (sample_access) {
+      RecordAttrAccess(alloc_id, attr, /*write=*/true, objects.size(),
+                       fork_depth_);
+    }
     SourceCollection& collection = GetOrCreateSourceCollection(alloc_id, attr);
     const arolla::QType* qtype =
         values.dtype() == arolla::GetNothingQType() ? nullptr : values.dtype();
     RETURN_IF_ERROR(GetOrCreateMutableSourceInCollection(
         collection, alloc_id, attr, qtype, /*update_size=*/objects.size()));
+    if (stats_enabled) {
+      AddStat(collection.mutable_dense_source
+                  ? global_stats.dense_source_writes
+                  : global_stats.sparse_source_writes,
+              1);
+    }
     if (collection.mutable_dense_source) {
       RETURN_IF_ERROR(collection.mutable_dense_source->Set(
           objects.values<ObjectId>(), values));
@@ -788,6 +1601,9 @@ absl::Status DataBagImpl::SetAttr(const DataSliceImpl& objects,
         objects.values<ObjectId>(), values));
   }
   if (objects.allocation_ids().contains_small_allocation_id()) {
+    if (stats_enabled) {
+      AddStat(global_stats.sparse_source_writes, 1);
+    }
     auto& source = GetMutableSmallAllocSource(attr);
     return source.Set(objects.values<ObjectId>(), values);
   }
@@ -805,16 +1621,32 @@ absl::Status DataBagImpl::SetAttr(const DataItem& object,
     }
   }
   ObjectId object_id = object.value<ObjectId>();
+  const bool stats_enabled = IsStatsEnabled();
+  if (stats_enabled) {
+    global_stats.set_attr.Add(1);
+  }
   if (object_id.IsSmallAlloc()) {
+    if (stats_enabled) {
+      AddStat(global_stats.sparse_source_writes, 1);
+    }
     auto& source = GetMutableSmallAllocSource(attr);
     source.Set(object_id, value);
     return absl::OkStatus();
   }
   AllocationId alloc_id(object_id);
+  if (ShouldSampleAccess()) {
+    RecordAttrAccess(alloc_id, attr, /*write=*/true, /*batch_size=*/1,
+                     fork_depth_);
+  }
   SourceCollection& collection = GetOrCreateSourceCollection(alloc_id, attr);
   const arolla::QType* qtype = value.has_value() ? value.dtype() : nullptr;
   RETURN_IF_ERROR(GetOrCreateMutableSourceInCollection(
       collection, alloc_id, attr, qtype, /*update_size=*/1));
+  if (stats_enabled) {
+    AddStat(collection.mutable_dense_source ? global_stats.dense_source_writes
+                                            : global_stats.sparse_source_writes,
+            1);
+  }
   if (collection.mutable_dense_source) {
     return collection.mutable_dense_source->Set(object_id, value);
   }
@@ -841,6 +1673,23 @@ class DataBagImpl::ReadOnlyListGetter {
     return lists_vec_ ? (*lists_vec_)->Get(list_id.Offset()) : kEmptyList;
   }
 
+  // Equivalent to operator()(list_id).size(), but reads the cached sizes of
+  // the DataListVector instead of the list itself.
+  int64_t size(ObjectId list_id) {
+    AllocationId alloc_id(list_id);
+    if (alloc_id != current_alloc_) {
+      if (ABSL_PREDICT_FALSE(!alloc_id.IsListsAlloc())) {
+        status_ = absl::FailedPreconditionError("lists expected");
+        return 0;
+      }
+      lists_vec_ = bag_->GetConstListsOrNull(alloc_id);
+      sizes_ = lists_vec_ ? (*lists_vec_)->sizes()
+                          : absl::Span<const int64_t>();
+      current_alloc_ = alloc_id;
+    }
+    return lists_vec_ ? sizes_[list_id.Offset()] : 0;
+  }
+
   const absl::Status& status() { return status_; }
 
  private:
@@ -848,6 +1697,7 @@ class DataBagImpl::ReadOnlyListGetter {
   absl::Status status_ = absl::OkStatus();
   std::optional<AllocationId> current_alloc_;
   const std::shared_ptr<DataListVector>* lists_vec_ = nullptr;
+  absl::Span<const int64_t> sizes_;
 };
 
 class DataBagImpl::MutableListGetter {
@@ -955,6 +1805,7 @@ DataListVector& DataBagImpl::GetOrCreateMutableLists(AllocationId alloc_id) {
   DCHECK(alloc_id.IsListsAlloc());
   auto [it, inserted] = lists_.try_emplace(alloc_id);
   if (inserted) {
+    index_.AddLists(alloc_id);
     const std::shared_ptr<DataListVector>* parent_lists = nullptr;
     if (parent_data_bag_ != nullptr) {
       parent_lists = parent_data_bag_->GetConstListsOrNull(alloc_id);
@@ -984,9 +1835,8 @@ absl::StatusOr<arolla::DenseArray<int64_t>> DataBagImpl::GetListSize(
   arolla::DenseArray<int64_t> res;
 
   if (fallbacks.empty()) {
-    auto op = arolla::CreateDenseOp([&](ObjectId list_id) -> int64_t {
-      return list_getter(list_id).size();
-    });
+    auto op = arolla::CreateDenseOp(
+        [&](ObjectId list_id) -> int64_t { return list_getter.size(list_id); });
     res = op(lists.values<ObjectId>());
   } else {
     std::vector<ReadOnlyListGetter> fallback_list_getters =
@@ -1003,6 +1853,71 @@ absl::StatusOr<arolla::DenseArray<int64_t>> DataBagImpl::GetListSize(
   return res;
 }
 
+namespace {
+
+// Replaces negative `positions` with positions counted from the end of the
+// lists, and the ones out of range with -1. The loop has no branches, so it is
+// vectorized by the compiler.
+void NormalizeListPositions(absl::Span<const int64_t> list_sizes,
+                            absl::Span<int64_t> positions) {
+  DCHECK_EQ(list_sizes.size(), positions.size());
+  for (int64_t i = 0; i < positions.size(); ++i) {
+    const int64_t pos = positions[i] + (positions[i] < 0 ? list_sizes[i] : 0);
+    positions[i] = pos >= 0 && pos < list_sizes[i] ? pos : -1;
+  }
+}
+
+// Returns the values at `positions` (-1 for missing) of `lists` if all the
+// lists store values of a single type. Then the values are gathered into a
+// typed array without creating a DataItem per element. Returns nullopt
+// otherwise.
+std::optional<DataSliceImpl> GetFromSingleTypeLists(
+    absl::Span<const DataList* const> lists,
+    absl::Span<const int64_t> positions) {
+  arolla::QTypePtr dtype = nullptr;
+  for (int64_t i = 0; i < lists.size(); ++i) {
+    if (positions[i] < 0) {
+      continue;
+    }
+    arolla::QTypePtr list_dtype = lists[i]->values_dtype();
+    if (list_dtype == nullptr ||
+        (dtype != nullptr && list_dtype != arolla::GetNothingQType() &&
+         list_dtype != dtype)) {
+      return std::nullopt;
+    }
+    if (list_dtype != arolla::GetNothingQType()) {
+      dtype = list_dtype;
+    }
+  }
+  if (dtype == nullptr) {
+    // All the values are missing.
+    return DataSliceImpl::CreateEmptyAndUnknownType(lists.size());
+  }
+  std::optional<DataSliceImpl> res;
+  arolla::meta::foreach_type(supported_types_list(), [&](auto tpe) {
+    using T = typename decltype(tpe)::type;
+    if (arolla::GetQType<T>() != dtype) {
+      return;
+    }
+    arolla::DenseArrayBuilder<T> bldr(lists.size());
+    for (int64_t i = 0; i < lists.size(); ++i) {
+      if (positions[i] >= 0) {
+        lists[i]->AddItemToDenseArray(bldr, i, positions[i]);
+      }
+    }
+    arolla::DenseArray<T> values = std::move(bldr).Build();
+    if (values.PresentCount() == 0) {
+      // Same as the result of DataSliceImpl::Builder.
+      res = DataSliceImpl::CreateEmptyAndUnknownType(lists.size());
+    } else {
+      res = DataSliceImpl::Create(std::move(values));
+    }
+  });
+  return res;
+}
+
+}  // namespace
+
 absl::StatusOr<DataSliceImpl> DataBagImpl::GetFromLists(
     const DataSliceImpl& lists, const arolla::DenseArray<int64_t>& indices,
     FallbackSpan fallbacks) const {
@@ -1013,39 +1928,39 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::GetFromLists(
     return absl::FailedPreconditionError("lists expected");
   }
 
+  // The lists are resolved for the whole slice first (the getters cache the
+  // lists of the last allocation), so the positions can be normalized in a
+  // single pass and the values gathered by type afterwards.
+  const int64_t size = lists.size();
+  std::vector<const DataList*> list_ptrs(size, &kEmptyList);
+  std::vector<int64_t> list_sizes(size, 0);
+  std::vector<int64_t> positions(size, 0);
   ReadOnlyListGetter list_getter(this);
-  DataSliceImpl::Builder bldr(lists.size());
+  std::vector<ReadOnlyListGetter> fallback_list_getters =
+      DataBagImpl::CreateFallbackListGetters(fallbacks);
+  RETURN_IF_ERROR(arolla::DenseArraysForEachPresent(
+      [&](int64_t offset, ObjectId list_id, int64_t pos) {
+        const DataList& list = GetFirstPresentList(
+            list_id, list_getter, absl::MakeSpan(fallback_list_getters));
+        list_ptrs[offset] = &list;
+        list_sizes[offset] = list.size();
+        positions[offset] = pos;
+      },
+      lists.values<ObjectId>(), indices));
+  RETURN_IF_ERROR(list_getter.status());
 
-  auto set_from_list = [&](int64_t offset, const DataList& list, int64_t pos) {
-    if (pos < 0) {
-      pos += list.size();
-    }
-    if (pos >= 0 && pos < list.size()) {
-      bldr.Insert(offset, list.Get(pos));
+  // Note: we don't return an error if a position is out of range.
+  NormalizeListPositions(list_sizes, absl::MakeSpan(positions));
+  if (std::optional<DataSliceImpl> res =
+          GetFromSingleTypeLists(list_ptrs, positions)) {
+    return *std::move(res);
+  }
+  DataSliceImpl::Builder bldr(size);
+  for (int64_t i = 0; i < size; ++i) {
+    if (positions[i] >= 0) {
+      bldr.Insert(i, list_ptrs[i]->Get(positions[i]));
     }
-    // Note: we don't return an error if `pos` is out of range.
-  };
-
-  if (fallbacks.empty()) {
-    RETURN_IF_ERROR(arolla::DenseArraysForEachPresent(
-        [&](int64_t offset, ObjectId list_id, int64_t pos) {
-          const DataList& list = list_getter(list_id);
-          set_from_list(offset, list, pos);
-        },
-        lists.values<ObjectId>(), indices));
-  } else {
-    std::vector<ReadOnlyListGetter> fallback_list_getters =
-        DataBagImpl::CreateFallbackListGetters(fallbacks);
-    RETURN_IF_ERROR(arolla::DenseArraysForEachPresent(
-        [&](int64_t offset, ObjectId list_id, int64_t pos) {
-          const DataList& list = GetFirstPresentList(
-              list_id, list_getter, absl::MakeSpan(fallback_list_getters));
-          set_from_list(offset, list, pos);
-        },
-        lists.values<ObjectId>(), indices));
   }
-
-  RETURN_IF_ERROR(list_getter.status());
   return std::move(bldr).Build();
 }
 
@@ -1081,6 +1996,76 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::PopFromLists(
   return std::move(bldr).Build();
 }
 
+namespace {
+
+// Returns the concatenation of `range` of every list if all the lists store
+// values of a single type. Then the values are copied into a typed array
+// without a dispatch per element, or (if there is only one non-empty list
+// sharing buffers with the array it was created from) not copied at all.
+// Returns nullopt otherwise.
+std::optional<DataSliceImpl> ExplodeSingleTypeLists(
+    absl::Span<const DataList* const> lists,
+    const arolla::Buffer<int64_t>& split_points, DataBagImpl::ListRange range,
+    int64_t size) {
+  arolla::QTypePtr dtype = nullptr;
+  const DataList* single_list = nullptr;
+  for (const DataList* list : lists) {
+    if (list == nullptr) {
+      continue;
+    }
+    auto [from, to] = range.Calculate(list->size());
+    if (from >= to) {
+      continue;
+    }
+    arolla::QTypePtr list_dtype = list->values_dtype();
+    if (list_dtype == nullptr ||
+        (dtype != nullptr && list_dtype != arolla::GetNothingQType() &&
+         list_dtype != dtype)) {
+      return std::nullopt;
+    }
+    if (list_dtype != arolla::GetNothingQType()) {
+      single_list = dtype == nullptr && to - from == size ? list : nullptr;
+      dtype = list_dtype;
+    }
+  }
+  if (dtype == nullptr) {
+    return std::nullopt;
+  }
+  if (single_list != nullptr) {
+    auto [from, to] = range.Calculate(single_list->size());
+    if (std::optional<DataSliceImpl> shared =
+            single_list->GetSharedSlice(from, to)) {
+      return shared;
+    }
+  }
+  std::optional<DataSliceImpl> res;
+  arolla::meta::foreach_type(supported_types_list(), [&](auto tpe) {
+    using T = typename decltype(tpe)::type;
+    if (arolla::GetQType<T>() != dtype) {
+      return;
+    }
+    arolla::DenseArrayBuilder<T> bldr(size);
+    for (int64_t i = 0; i < lists.size(); ++i) {
+      if (const DataList* list = lists[i]; list != nullptr) {
+        auto [from, to] = range.Calculate(list->size());
+        if (from < to) {
+          list->AddToDenseArray(bldr, split_points[i], from, to);
+        }
+      }
+    }
+    arolla::DenseArray<T> values = std::move(bldr).Build();
+    if (values.PresentCount() == 0) {
+      // Same as the result of DataSliceImpl::Builder.
+      res = DataSliceImpl::CreateEmptyAndUnknownType(size);
+    } else {
+      res = DataSliceImpl::Create(std::move(values));
+    }
+  });
+  return res;
+}
+
+}  // namespace
+
 absl::StatusOr<std::pair<DataSliceImpl, arolla::DenseArrayEdge>>
 DataBagImpl::ExplodeLists(const DataSliceImpl& lists, ListRange range,
                           FallbackSpan fallbacks) const {
@@ -1133,6 +2118,12 @@ DataBagImpl::ExplodeLists(const DataSliceImpl& lists, ListRange range,
   RETURN_IF_ERROR(list_getter.status());
 
   arolla::Buffer<int64_t> split_points = std::move(split_points_bldr).Build();
+  ASSIGN_OR_RETURN(auto edge,
+                   arolla::DenseArrayEdge::FromSplitPoints({split_points}));
+  if (std::optional<DataSliceImpl> values =
+          ExplodeSingleTypeLists(list_ptrs, split_points, range, cum_size)) {
+    return std::make_pair(*std::move(values), std::move(edge));
+  }
   DataSliceImpl::Builder slice_bldr(cum_size);
   for (int64_t i = 0; i < lists.size(); ++i) {
     if (const DataList* list = list_ptrs[i]; list != nullptr) {
@@ -1142,9 +2133,6 @@ DataBagImpl::ExplodeLists(const DataSliceImpl& lists, ListRange range,
       }
     }
   }
-
-  ASSIGN_OR_RETURN(auto edge, arolla::DenseArrayEdge::FromSplitPoints(
-                                  {std::move(split_points)}));
   return std::make_pair(std::move(slice_bldr).Build(), std::move(edge));
 }
 
@@ -1163,6 +2151,29 @@ absl::Status DataBagImpl::ExtendLists(
 
   MutableListGetter list_getter(this);
 
+  if (ABSL_PREDICT_TRUE(values.is_single_dtype())) {
+    // Every list is resized once and the values are copied in a single pass
+    // without a per-element dispatch. Lists that were empty share the buffers
+    // of `values` (see DataList::SetN).
+    values.VisitValues([&]<typename T>(const arolla::DenseArray<T>& arr) {
+      lists.values<ObjectId>().ForEachPresent([&](int64_t i, ObjectId list_id) {
+        DataList* list = list_getter(list_id);
+        if (ABSL_PREDICT_FALSE(list == nullptr)) {
+          return;
+        }
+        int64_t src_pos = split_points[i];
+        int64_t new_values_count = split_points[i + 1] - src_pos;
+        if (new_values_count == 0) {
+          return;
+        }
+        int64_t dst_pos = list->size();
+        list->Resize(dst_pos + new_values_count);
+        list->SetN(dst_pos, arr.Slice(src_pos, new_values_count));
+      });
+    });
+    return list_getter.status();
+  }
+
   lists.values<ObjectId>().ForEachPresent([&](int64_t i, ObjectId list_id) {
     DataList* list = list_getter(list_id);
     if (ABSL_PREDICT_FALSE(list == nullptr)) {
@@ -1218,13 +2229,14 @@ absl::Status DataBagImpl::ReplaceInLists(
 
   if (ABSL_PREDICT_TRUE(values.is_single_dtype())) {
     values.VisitValues([&]<typename T>(const arolla::DenseArray<T>& arr) {
-      auto arr_unowned = arr.MakeUnowned();
       lists.values<ObjectId>().ForEachPresent([&](int64_t i, ObjectId list_id) {
         find_and_process_list(
             i, list_id,
             [&](DataList& list, int64_t dst_pos, int64_t src_pos,
                 int64_t count) {
-              list.SetN(dst_pos, arr_unowned.Slice(src_pos, count));
+              // Slices of an owned array share its buffers, so new lists
+              // don't copy the values (see DataList::SetN).
+              list.SetN(dst_pos, arr.Slice(src_pos, count));
             });
       });
     });
@@ -1316,8 +2328,61 @@ absl::Status DataBagImpl::SetInLists(const DataSliceImpl& lists,
   return list_getter.status();
 }
 
+namespace {
+
+// Converts indices removed one after another from a list of size `size` (so
+// each index refers to the list with the previous ones already removed) to
+// the sorted positions in the original list. Out of range indices are
+// skipped. Uses a Fenwick tree over the remaining elements, so it takes
+// O(size + indices.size() * log(size)) instead of shifting the list per index.
+std::vector<int64_t> SequentialRemovalsToPositions(
+    int64_t size, absl::Span<const int64_t> indices) {
+  // tree[i] is the number of remaining elements in (i - lowbit(i), i].
+  std::vector<int64_t> tree(size + 1);
+  for (int64_t i = 1; i <= size; ++i) {
+    tree[i] = i & -i;
+  }
+  int64_t top_bit = 1;
+  while (top_bit * 2 <= size) {
+    top_bit *= 2;
+  }
+  std::vector<int64_t> positions;
+  positions.reserve(indices.size());
+  for (int64_t index : indices) {
+    const int64_t remaining = size - positions.size();
+    if (index < 0) {
+      index += remaining;
+    }
+    if (index < 0 || index >= remaining) {
+      continue;
+    }
+    // Finds the (index + 1)-th remaining element.
+    int64_t pos = 0;
+    for (int64_t bit = top_bit; bit > 0; bit /= 2) {
+      if (pos + bit <= size && tree[pos + bit] <= index) {
+        pos += bit;
+        index -= tree[pos];
+      }
+    }
+    positions.push_back(pos);
+    for (int64_t i = pos + 1; i <= size; i += i & -i) {
+      --tree[i];
+    }
+  }
+  std::sort(positions.begin(), positions.end());
+  return positions;
+}
+
+}  // namespace
+
 absl::Status DataBagImpl::RemoveInList(
     const DataSliceImpl& lists, const arolla::DenseArray<int64_t>& indices) {
+  return RemoveInList(lists, indices, ParallelOptions());
+}
+
+absl::Status DataBagImpl::RemoveInList(
+    const DataSliceImpl& lists, const arolla::DenseArray<int64_t>& indices,
+    const ParallelOptions& options) {
   if (lists.size() != indices.size()) {
     return absl::FailedPreconditionError("lists.size() != indices.size()");
   }
@@ -1328,22 +2393,67 @@ absl::Status DataBagImpl::RemoveInList(
     return absl::FailedPreconditionError("lists expected");
   }
 
+  // The indices are grouped by list in the order of `lists`, so that each
+  // list is compacted once no matter how many elements are removed from it.
   MutableListGetter list_getter(this);
+  absl::flat_hash_map<DataList*, int64_t> list_to_group;
+  std::vector<DataList*> group_lists;
+  std::vector<std::vector<int64_t>> group_indices;
   RETURN_IF_ERROR(arolla::DenseArraysForEachPresent(
       [&](int64_t offset, ObjectId list_id, int64_t pos) {
         DataList* list = list_getter(list_id);
         if (ABSL_PREDICT_FALSE(list == nullptr)) {
           return;
         }
-        if (pos < 0) {
-          pos += list->size();
-        }
-        if (pos >= 0 && pos < list->size()) {
-          list->Remove(pos, 1);
+        auto [it, inserted] =
+            list_to_group.try_emplace(list, group_lists.size());
+        if (inserted) {
+          group_lists.push_back(list);
+          group_indices.emplace_back();
         }
+        group_indices[it->second].push_back(pos);
       },
       lists.values<ObjectId>(), indices));
 
+  auto process_group = [&](int64_t group) {
+    DataList& list = *group_lists[group];
+    absl::Span<const int64_t> list_indices = group_indices[group];
+    if (list_indices.size() == 1) {
+      int64_t pos = list_indices[0];
+      if (pos < 0) {
+        pos += list.size();
+      }
+      if (pos >= 0 && pos < list.size()) {
+        list.Remove(pos, 1);
+      }
+      return;
+    }
+    list.RemoveSorted(
+        SequentialRemovalsToPositions(list.size(), list_indices));
+  };
+  const int64_t group_count = group_lists.size();
+  const int64_t num_chunks = ParallelChunkCount(
+      options.executor, indices.size(), options.min_chunk_size);
+  if (num_chunks <= 1) {
+    for (int64_t group = 0; group < group_count; ++group) {
+      process_group(group);
+    }
+  } else {
+    // The lists are distinct, so they can be compacted concurrently.
+    const int64_t groups_per_chunk =
+        (group_count + num_chunks - 1) / num_chunks;
+    RETURN_IF_ERROR(ParallelFor(
+        options.executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+          const int64_t end =
+              std::min(group_count, (chunk + 1) * groups_per_chunk);
+          for (int64_t group = chunk * groups_per_chunk; group < end;
+               ++group) {
+            process_group(group);
+          }
+          return absl::OkStatus();
+        }));
+  }
+
   // Note: in case of error the operation is still applied to the lists where it
   // was possible.
   return list_getter.status();
@@ -1477,9 +2587,15 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::ExplodeList(
   ASSIGN_OR_RETURN(ObjectId list_id, ItemToListObjectId(list));
   const DataList& dlist = GetFirstPresentList(list_id, fallbacks);
   auto [from, to] = range.Calculate(dlist.size());
+  if (IsStatsEnabled()) {
+    global_stats.explode_list.Add(std::max<int64_t>(to - from, 0));
+  }
   if (to <= from) {
     return DataSliceImpl();
   }
+  if (std::optional<DataSliceImpl> shared = dlist.GetSharedSlice(from, to)) {
+    return *std::move(shared);
+  }
   DataSliceImpl::Builder bldr(to - from);
   dlist.AddToDataSlice(bldr, 0, from, to);
   return std::move(bldr).Build();
@@ -1526,6 +2642,12 @@ absl::Status DataBagImpl::ExtendList(const DataItem& list,
                         .GetMutable(list_id.Offset());
   size_t offset = dlist.size();
   dlist.Resize(offset + values.size());
+  if (values.is_single_dtype()) {
+    values.VisitValues([&]<typename T>(const arolla::DenseArray<T>& arr) {
+      dlist.SetN(offset, arr);
+    });
+    return absl::OkStatus();
+  }
   values.VisitValues([&](const auto& vec) {
     vec.ForEachPresent([&](int64_t id, auto v) {
       dlist.Set(offset + id,
@@ -1615,6 +2737,7 @@ DictVector& DataBagImpl::GetOrCreateMutableDicts(AllocationId alloc_id) {
   DCHECK(alloc_id.IsDictsAlloc() || alloc_id.IsSchemasAlloc());
   auto [it, inserted] = dicts_.try_emplace(alloc_id);
   if (inserted) {
+    index_.AddDicts(alloc_id);
     const std::shared_ptr<DictVector>* parent_dicts = nullptr;
     if (parent_data_bag_ != nullptr) {
       parent_dicts = parent_data_bag_->GetConstDictsOrNull(alloc_id);
@@ -1670,7 +2793,8 @@ class DataBagImpl::ReadOnlyDictGetter {
       dicts_vec_ = bag_->GetConstDictsOrNull(alloc_id);
       current_alloc_ = alloc_id;
     }
-    return dicts_vec_ ? (**dicts_vec_)[dict_id.Offset()] : empty_dict_;
+    return dicts_vec_ ? std::as_const(**dicts_vec_)[dict_id.Offset()]
+                      : empty_dict_;
   }
 
   const absl::Status& status() { return status_; }
@@ -1715,6 +2839,63 @@ class DataBagImpl::MutableDictGetter {
   DictVector* dicts_vec_ = nullptr;
 };
 
+namespace {
+
+// Looks up (dict, key) pairs in batches and inserts the results into `bldr`.
+// Within a batch the dicts are resolved grouped by allocation, so that
+// `DictGetter` fetches each DictVector once. Then hashes of all keys are
+// computed and the buckets are prefetched before any of them is probed, so
+// that the cache misses of independent lookups overlap.
+template <typename DictGetter, typename KeyT>
+class BatchedDictLookup {
+ public:
+  static constexpr int kBatchSize = 64;
+
+  BatchedDictLookup(DictGetter& dict_getter, DataSliceImpl::Builder& bldr)
+      : dict_getter_(dict_getter), bldr_(bldr) {}
+
+  void Add(int64_t offset, ObjectId dict_id, const KeyT& key) {
+    offsets_[size_] = offset;
+    dict_ids_[size_] = dict_id;
+    keys_[size_] = key;
+    if (++size_ == kBatchSize) {
+      Flush();
+    }
+  }
+
+  void Flush() {
+    std::array<int, kBatchSize> order;
+    std::iota(order.begin(), order.begin() + size_, 0);
+    auto alloc_less = [&](int a, int b) {
+      return AllocationId(dict_ids_[a]) < AllocationId(dict_ids_[b]);
+    };
+    if (!std::is_sorted(order.begin(), order.begin() + size_, alloc_less)) {
+      std::stable_sort(order.begin(), order.begin() + size_, alloc_less);
+    }
+    for (int i : absl::MakeConstSpan(order.data(), size_)) {
+      dicts_[i] = &dict_getter_(dict_ids_[i]);
+      hashes_[i] = DataItem::Hash()(keys_[i]);
+      dicts_[i]->Prefetch(keys_[i]);
+    }
+    for (int i = 0; i < size_; ++i) {
+      bldr_.Insert(offsets_[i], dicts_[i]->Get(keys_[i], hashes_[i]));
+    }
+    size_ = 0;
+  }
+
+ private:
+  DictGetter& dict_getter_;
+  DataSliceImpl::Builder& bldr_;
+  int size_ = 0;
+  std::array<int64_t, kBatchSize> offsets_;
+  std::array<ObjectId, kBatchSize> dict_ids_;
+  std::array<KeyT, kBatchSize> keys_;
+  std::array<const Dict*, kBatchSize> dicts_;
+  std::array<size_t, kBatchSize> hashes_;
+};
+
+}  // namespace
+
 template <bool kReturnValues>
 absl::StatusOr<std::pair<DataSliceImpl, arolla::DenseArrayEdge>>
 DataBagImpl::GetDictKeysOrValues(const DataSliceImpl& dicts,
@@ -1735,7 +2916,11 @@ DataBagImpl::GetDictKeysOrValues(const DataSliceImpl& dicts,
   for (const DataBagImpl* fallback : fallbacks) {
     dict_fallback_getters.emplace_back(fallback);
   }
-  std::vector<std::vector<DataItem>> results(dicts.size());
+  // The common dicts without parents and fallbacks are written directly into
+  // the builder in the second pass. The entries of the other dicts are merged
+  // only once, in the first pass.
+  std::vector<const Dict*> single_storage_dicts(dicts.size(), nullptr);
+  std::vector<std::vector<DataItem>> merged_results;
   std::vector<int64_t> split_points{0};
   split_points.reserve(dicts.size() + 1);
 
@@ -1748,7 +2933,6 @@ DataBagImpl::GetDictKeysOrValues(const DataSliceImpl& dicts,
           split_points.push_back(split_points.back());
           return;
         }
-        std::vector<DataItem>& res_vec = results[offset];
         const Dict& dict = dict_getter(dict_id);
         if (!fallbacks.empty()) {
           fallback_dicts.clear();
@@ -1760,20 +2944,34 @@ DataBagImpl::GetDictKeysOrValues(const DataSliceImpl& dicts,
             }
           }
         }
-        if constexpr (kReturnValues) {
-          res_vec = dict.GetValues(fallback_dicts);
-        } else {
-          res_vec = dict.GetKeys(fallback_dicts);
+        if (fallback_dicts.empty() && dict.HasSingleStorage()) {
+          single_storage_dicts[offset] = &dict;
+          split_points.push_back(split_points.back() +
+                                 dict.GetSizeNoFallbacks());
+          return;
         }
+        std::vector<DataItem> res_vec = kReturnValues
+                                            ? dict.GetValues(fallback_dicts)
+                                            : dict.GetKeys(fallback_dicts);
         split_points.push_back(split_points.back() + res_vec.size());
+        if (!res_vec.empty()) {
+          merged_results.push_back(std::move(res_vec));
+        }
       });
   RETURN_IF_ERROR(dict_getter.status());
 
   DataSliceImpl::Builder bldr(split_points.back());
-  for (int64_t i = 0; i < results.size(); ++i) {
-    const auto& res_vec = results[i];
-    for (int64_t j = 0; j < res_vec.size(); ++j) {
-      bldr.Insert(split_points[i] + j, res_vec[j]);
+  auto merged_it = merged_results.begin();
+  for (int64_t i = 0; i + 1 < split_points.size(); ++i) {
+    int64_t id = split_points[i];
+    if (const Dict* dict = single_storage_dicts[i]; dict != nullptr) {
+      dict->ForEach([&](const DataItem& key, const DataItem& value) {
+        bldr.Insert(id++, kReturnValues ? value : key);
+      });
+    } else if (id != split_points[i + 1]) {
+      for (const DataItem& item : *merged_it++) {
+        bldr.Insert(id++, item);
+      }
     }
   }
 
@@ -1854,23 +3052,28 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::GetFromDictNoFallback(
                         dicts.size(), keys.size()));
   }
 
-  ReadOnlyDictGetter<AllocCheckFn> dict_getter(this);
+  using DictGetter = ReadOnlyDictGetter<AllocCheckFn>;
+  DictGetter dict_getter(this);
   DataSliceImpl::Builder bldr(dicts.size());
 
   if (keys.is_mixed_dtype()) {
+    BatchedDictLookup<DictGetter, DataItem> lookup(dict_getter, bldr);
     dicts.ForEachPresent([&](int64_t offset, ObjectId dict_id) {
-      bldr.Insert(offset, dict_getter(dict_id).Get(keys[offset]));
+      lookup.Add(offset, dict_id, keys[offset]);
     });
+    lookup.Flush();
   } else {
     absl::Status status = absl::OkStatus();
     keys.VisitValues([&](const auto& vec) {
       using T = typename std::decay_t<decltype(vec)>::base_type;
+      BatchedDictLookup<DictGetter, DataItem::View<T>> lookup(dict_getter,
+                                                              bldr);
       status = arolla::DenseArraysForEachPresent(
           [&](int64_t offset, ObjectId dict_id, arolla::view_type_t<T> key) {
-            bldr.Insert(offset,
-                        dict_getter(dict_id).Get(DataItem::View<T>{key}));
+            lookup.Add(offset, dict_id, DataItem::View<T>{key});
           },
           dicts, vec);
+      lookup.Flush();
     });
     RETURN_IF_ERROR(status);
   }
@@ -1887,8 +3090,11 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::GetFromDictNoFallback(
 
   keys.VisitValue([&](const auto& val) {
     using T = typename std::decay_t<decltype(val)>;
+    DataItem::View<T> key{val};
+    // The key is the same for all the dicts, so it is hashed only once.
+    size_t key_hash = DataItem::Hash()(key);
     dicts.ForEachPresent([&](int64_t offset, ObjectId dict_id) {
-      bldr.Insert(offset, dict_getter(dict_id).Get(DataItem::View<T>{val}));
+      bldr.Insert(offset, dict_getter(dict_id).Get(key, key_hash));
     });
   });
 
@@ -1901,11 +3107,18 @@ inline absl::StatusOr<DataSliceImpl> DataBagImpl::GetFromDictImpl(
     const DataSliceImpl& dicts, const DataSliceImplT& keys,
     FallbackSpan fallbacks) const {
   const auto& dict_objects = dicts.values<ObjectId>();
+  const bool stats_enabled = IsStatsEnabled();
+  if (stats_enabled) {
+    global_stats.get_from_dict.Add(dicts.size());
+  }
   ASSIGN_OR_RETURN(auto result,
                    GetFromDictNoFallback<AllocCheckFn>(dict_objects, keys));
   if (fallbacks.empty()) {
     return result;
   }
+  if (stats_enabled) {
+    AddStat(global_stats.fallback_lookups, 1);
+  }
 
   for (const DataBagImpl* fallback : fallbacks) {
     // TODO: avoid requesting already known objects.
@@ -1930,6 +3143,80 @@ absl::StatusOr<DataSliceImpl> DataBagImpl::GetFromDict(
   return GetFromDictImpl<DictsAllocCheckFn>(dicts, keys, fallbacks);
 }
 
+namespace {
+
+// Returns the type of `keys` that can't be used as a dict key, or nullptr.
+const arolla::QType* GetUnsupportedDictKeyType(const DataSliceImpl& keys) {
+  const arolla::QType* unsupported_key_type = nullptr;
+  keys.VisitValues([&]<typename T>(const arolla::DenseArray<T>&) {
+    if (Dict::IsUnsupportedKeyType<T>()) {
+      unsupported_key_type = arolla::GetQType<T>();
+    }
+  });
+  return unsupported_key_type;
+}
+
+// Splits the positions of the present `dict_ids` into `num_parts` partitions.
+// All dicts of a DictVector page belong to the same partition, so that the
+// partitions can be modified concurrently. The positions in each partition
+// are in increasing order.
+std::vector<std::vector<int64_t>> PartitionDictsByPage(
+    const ObjectIdArray& dict_ids, int64_t num_parts) {
+  std::vector<std::vector<int64_t>> parts(num_parts);
+  for (auto& part : parts) {
+    part.reserve(dict_ids.size() / num_parts);
+  }
+  dict_ids.ForEachPresent([&](int64_t id, ObjectId dict_id) {
+    size_t part = absl::HashOf(AllocationId(dict_id),
+                               dict_id.Offset() / DictVector::kPageSize) %
+                  num_parts;
+    parts[part].push_back(id);
+  });
+  return parts;
+}
+
+// Returns the dict for `dict_id` from the prepared `dict_vectors`. The
+// allocation is expected to be present.
+class PreparedDictGetter {
+ public:
+  explicit PreparedDictGetter(
+      const absl::flat_hash_map<AllocationId, DictVector*>& dict_vectors)
+      : dict_vectors_(dict_vectors) {}
+
+  Dict& operator()(ObjectId dict_id) {
+    AllocationId alloc_id(dict_id);
+    if (alloc_id != current_alloc_) {
+      dicts_vec_ = dict_vectors_.at(alloc_id);
+      current_alloc_ = alloc_id;
+    }
+    return (*dicts_vec_)[dict_id.Offset()];
+  }
+
+ private:
+  const absl::flat_hash_map<AllocationId, DictVector*>& dict_vectors_;
+  std::optional<AllocationId> current_alloc_;
+  DictVector* dicts_vec_ = nullptr;
+};
+
+}  // namespace
+
+bool DataBagImpl::GetMutableDictVectors(
+    const DataSliceImpl& dicts,
+    absl::flat_hash_map<AllocationId, DictVector*>& dict_vectors) {
+  if (dicts.allocation_ids().contains_small_allocation_id()) {
+    return false;
+  }
+  for (AllocationId alloc_id : dicts.allocation_ids()) {
+    if (!alloc_id.IsDictsAlloc()) {
+      return false;
+    }
+  }
+  for (AllocationId alloc_id : dicts.allocation_ids()) {
+    dict_vectors[alloc_id] = &GetOrCreateMutableDicts(alloc_id);
+  }
+  return true;
+}
+
 absl::Status DataBagImpl::SetInDict(const DataSliceImpl& dicts,
                                     const DataSliceImpl& keys,
                                     const DataSliceImpl& values) {
@@ -1944,13 +3231,8 @@ absl::Status DataBagImpl::SetInDict(const DataSliceImpl& dicts,
   if (dicts.dtype() != arolla::GetQType<ObjectId>()) {
     return absl::FailedPreconditionError("dicts expected");
   }
-  const arolla::QType* unsupported_key_type = nullptr;
-  keys.VisitValues([&]<typename T>(const arolla::DenseArray<T>&) {
-    if (Dict::IsUnsupportedKeyType<T>()) {
-      unsupported_key_type = arolla::GetQType<T>();
-    }
-  });
-  if (unsupported_key_type) {
+  if (const arolla::QType* unsupported_key_type =
+          GetUnsupportedDictKeyType(keys)) {
     return absl::InvalidArgumentError(
         absl::StrCat("invalid key type: ", unsupported_key_type->name()));
   }
@@ -2029,6 +3311,79 @@ absl::Status DataBagImpl::ClearDict(const DataSliceImpl& dicts) {
   return dict_getter.status();
 }
 
+absl::Status DataBagImpl::SetInDict(const DataSliceImpl& dicts,
+                                    const DataSliceImpl& keys,
+                                    const DataSliceImpl& values,
+                                    const ParallelOptions& options) {
+  const int64_t num_parts = ParallelChunkCount(options.executor, dicts.size(),
+                                               options.min_chunk_size);
+  absl::flat_hash_map<AllocationId, DictVector*> dict_vectors;
+  // Errors are reported by the sequential version.
+  if (num_parts <= 1 || dicts.size() != keys.size() ||
+      dicts.size() != values.size() ||
+      dicts.dtype() != arolla::GetQType<ObjectId>() ||
+      GetUnsupportedDictKeyType(keys) != nullptr ||
+      !GetMutableDictVectors(dicts, dict_vectors)) {
+    return SetInDict(dicts, keys, values);
+  }
+  const ObjectIdArray& dict_ids = dicts.values<ObjectId>();
+  std::vector<std::vector<int64_t>> parts =
+      PartitionDictsByPage(dict_ids, num_parts);
+  return ParallelFor(
+      options.executor, num_parts, [&](int64_t part) -> absl::Status {
+        PreparedDictGetter dict_getter(dict_vectors);
+        absl::Span<const int64_t> ids = parts[part];
+        if (!keys.is_single_dtype() || !values.is_single_dtype()) {
+          for (int64_t id : ids) {
+            if (DataItem key = keys[id]; key.has_value()) {
+              dict_getter(dict_ids.values[id]).Set(key, values[id]);
+            }
+          }
+          return absl::OkStatus();
+        }
+        values.VisitValues([&](const auto& values_vec) {
+          using ValueT = typename std::decay_t<decltype(values_vec)>::base_type;
+          keys.VisitValues([&](const auto& keys_vec) {
+            using KeyT = typename std::decay_t<decltype(keys_vec)>::base_type;
+            for (int64_t id : ids) {
+              auto key = keys_vec[id];
+              if (!key.present) {
+                continue;
+              }
+              auto value = values_vec[id];
+              dict_getter(dict_ids.values[id])
+                  .Set(DataItem::View<KeyT>{key.value},
+                       value.present ? DataItem(ValueT(value.value))
+                                     : DataItem());
+            }
+          });
+        });
+        return absl::OkStatus();
+      });
+}
+
+absl::Status DataBagImpl::ClearDict(const DataSliceImpl& dicts,
+                                    const ParallelOptions& options) {
+  const int64_t num_parts = ParallelChunkCount(options.executor, dicts.size(),
+                                               options.min_chunk_size);
+  absl::flat_hash_map<AllocationId, DictVector*> dict_vectors;
+  if (num_parts <= 1 || dicts.dtype() != arolla::GetQType<ObjectId>() ||
+      !GetMutableDictVectors(dicts, dict_vectors)) {
+    return ClearDict(dicts);
+  }
+  const ObjectIdArray& dict_ids = dicts.values<ObjectId>();
+  std::vector<std::vector<int64_t>> parts =
+      PartitionDictsByPage(dict_ids, num_parts);
+  return ParallelFor(
+      options.executor, num_parts, [&](int64_t part) -> absl::Status {
+        PreparedDictGetter dict_getter(dict_vectors);
+        for (int64_t id : parts[part]) {
+          dict_getter(dict_ids.values[id]).Clear();
+        }
+        return absl::OkStatus();
+      });
+}
+
 template <bool kReturnValues>
 std::vector<DataItem> DataBagImpl::GetDictKeysOrValuesAsVector(
     ObjectId dict_id, FallbackSpan fallbacks) const {
@@ -2044,7 +3399,7 @@ std::vector<DataItem> DataBagImpl::GetDictKeysOrValuesAsVector(
     return {};
   }
 
-  const Dict& dict = (**main_dicts)[dict_id.Offset()];
+  const Dict& dict = std::as_const(**main_dicts)[dict_id.Offset()];
   if (fallbacks.empty()) {
     if constexpr (kReturnValues) {
       return dict.GetValues();
@@ -2058,7 +3413,8 @@ std::vector<DataItem> DataBagImpl::GetDictKeysOrValuesAsVector(
     const std::shared_ptr<DictVector>* fb_dicts =
         fallback->GetConstDictsOrNull(alloc_id);
     if (fb_dicts != nullptr) {
-      fallback_dicts.push_back(&(**fb_dicts)[dict_id.Offset()]);
+      fallback_dicts.push_back(
+          &std::as_const(**fb_dicts)[dict_id.Offset()]);
     }
   }
   if constexpr (kReturnValues) {
@@ -2106,7 +3462,9 @@ absl::StatusOr<DataItem> DataBagImpl::GetDictSize(
   if (fallbacks.empty()) {
     const std::shared_ptr<DictVector>* dicts =
         GetConstDictsOrNull(AllocationId(dict_id));
-    size = dicts ? (**dicts)[dict_id.Offset()].GetSizeNoFallbacks() : 0;
+    size = dicts ? std::as_const(**dicts)[dict_id.Offset()]
+                       .GetSizeNoFallbacks()
+                 : 0;
   } else {
     size =
         GetDictKeysOrValuesAsVector</*kReturnValues=*/false>(dict_id, fallbacks)
@@ -2120,7 +3478,7 @@ ABSL_ATTRIBUTE_ALWAYS_INLINE DataItem
 DataBagImpl::GetFromDictObject(ObjectId dict_id, const Key& key) const {
   AllocationId alloc_id(dict_id);
   if (const auto* dicts = GetConstDictsOrNull(alloc_id); dicts != nullptr) {
-    return (**dicts)[dict_id.Offset()].Get(key);
+    return std::as_const(**dicts)[dict_id.Offset()].Get(key);
   }
   return DataItem();
 }
@@ -2138,7 +3496,7 @@ DataBagImpl::GetFromDictObjectWithFallbacks(ObjectId dict_id, const Key& key,
   int64_t offset = dict_id.Offset();
   if (const auto* dicts = GetConstDictsOrNull(alloc_id, alloc_hash);
       dicts != nullptr) {
-    DataItem res = (**dicts)[offset].Get(key, key_hash);
+    DataItem res = std::as_const(**dicts)[offset].Get(key, key_hash);
     if (res.has_value() || fallbacks.empty()) {
       return res;
     }
@@ -2146,7 +3504,7 @@ DataBagImpl::GetFromDictObjectWithFallbacks(ObjectId dict_id, const Key& key,
   for (const DataBagImpl* fallback : fallbacks) {
     if (const auto* dicts = fallback->GetConstDictsOrNull(alloc_id, alloc_hash);
         dicts != nullptr) {
-      DataItem res = (**dicts)[offset].Get(key, key_hash);
+      DataItem res = std::as_const(**dicts)[offset].Get(key, key_hash);
       if (res.has_value()) {
         return res;
       }
@@ -2565,6 +3923,7 @@ absl::Status DataBagImpl::OverwriteSchemaFieldsForEntireAllocation(
   }
   dicts_.emplace(schema_alloc_id,
                  std::make_shared<DictVector>(size, std::move(common_dict)));
+  index_.AddDicts(schema_alloc_id);
   return absl::OkStatus();
 }
 
@@ -2583,21 +3942,80 @@ absl::StatusOr<DataItem> DataBagImpl::CreateUuSchemaFromFields(
     absl::Span<const absl::string_view> attr_names,
     absl::Span<const std::reference_wrapper<const DataItem>> items) {
   DCHECK_EQ(attr_names.size(), items.size());
-  auto schema_id = internal::CreateSchemaUuidFromFields(
-      seed, attr_names, items);
-  RETURN_IF_ERROR(
-      SetSchemaFields(DataItem(schema_id), attr_names, items));
-  return DataItem(schema_id);
+  for (const auto& item : items) {
+    RETURN_IF_ERROR(VerifyIsSchema(item.get()));
+  }
+  arolla::FingerprintHasher hasher("::koladata::internal::UuSchemaFromFields");
+  hasher.Combine(seed, attr_names.size());
+  for (int i = 0; i < attr_names.size(); ++i) {
+    hasher.Combine(attr_names[i]);
+    items[i].get().ArollaFingerprint(&hasher);
+  }
+  const arolla::Fingerprint key = std::move(hasher).Finish();
+  DataItem schema_id;
+  if (auto it = uu_schema_cache_.find(key); it != uu_schema_cache_.end()) {
+    schema_id = DataItem(it->second);
+  } else {
+    schema_id = internal::CreateSchemaUuidFromFields(seed, attr_names, items);
+    // Bounds the memory for DataBags creating many distinct schemas.
+    constexpr size_t kMaxUuSchemaCacheSize = 1024;
+    if (uu_schema_cache_.size() >= kMaxUuSchemaCacheSize) {
+      uu_schema_cache_.clear();
+    }
+    uu_schema_cache_.emplace(key, schema_id.value<ObjectId>());
+  }
+  // Reading the fields is cheaper than writing them, which can copy the dict
+  // of the schema from the parent DataBag.
+  const ObjectId schema_obj = schema_id.value<ObjectId>();
+  for (int i = 0; i < attr_names.size(); ++i) {
+    if (!GetFromDictObjectWithFallbacks(
+             schema_obj, DataItem::View<arolla::Text>(attr_names[i]), {})
+             .IsEquivalentTo(items[i].get())) {
+      RETURN_IF_ERROR(SetSchemaFields(schema_id, attr_names, items));
+      break;
+    }
+  }
+  return schema_id;
 }
 
 // ********* Merging
 
-absl::Status DataBagImpl::MergeSmallAllocInplace(const DataBagImpl& other,
-                                                 MergeOptions options) {
+namespace {
+
+// Returns true if `other_item` of the small alloc object `obj_id` has to be
+// written by the merge, i.e. if the value is missing in `this_sources` or is
+// to be overwritten. Returns an error on conflict.
+absl::StatusOr<bool> ShouldMergeSmallAllocItem(
+    absl::string_view attr_name, ObjectId obj_id, const DataItem& other_item,
+    absl::Span<const SparseSource* const> this_sources, MergeOptions options) {
+  DataItem this_value;
+  if (options.data_conflict_policy != MergeOptions::kOverwrite) {
+    this_value = GetAttributeFromSources(obj_id, {}, this_sources);
+  }
+  if (!this_value.has_value()) {
+    return true;
+  }
+  if (options.data_conflict_policy == MergeOptions::kRaiseOnConflict &&
+      this_value != other_item) {
+    return absl::FailedPreconditionError(
+        absl::StrCat("conflicting values for ", attr_name, " for ", obj_id,
+                     ": ", this_value, " vs ", other_item));
+  }
+  return false;
+}
+
+}  // namespace
+
+absl::Status DataBagImpl::MergeSmallAllocInplace(
+    const DataBagImpl& other, MergeOptions options,
+    const absl::flat_hash_set<std::string>& skipped_attrs) {
   for (const DataBagImpl* other_db = &other; other_db != nullptr;
        other_db = other_db->parent_data_bag_.get()) {
     for (const auto& [attr_name, other_source_top] :
          other_db->small_alloc_sources_) {
+      if (skipped_attrs.contains(attr_name)) {
+        continue;
+      }
       ConstSparseSourceArray other_sources;
       // NOTE we are taking sources from the top level DataBagImpl.
       other.GetSmallAllocDataSources(attr_name, other_sources);
@@ -2612,29 +4030,23 @@ absl::Status DataBagImpl::MergeSmallAllocInplace(const DataBagImpl& other,
       if (this_sources.empty() && other_sources.size() == 1) {
         // Copy entire source
         small_alloc_sources_.emplace(attr_name, other_source_top);
+        index_.AddSmallAllocAttr(attr_name);
         continue;
       }
       SparseSource* this_mutable_source = nullptr;
       auto process_other_source = [&](const SparseSource* other_source,
                                       auto skip_object_id) -> absl::Status {
-        for (const auto& [obj_id, other_item] : other_source->GetAll()) {
+        return other_source->ForEach([&](ObjectId obj_id,
+                                         const DataItem& other_item)
+                                         -> absl::Status {
           if (!other_item.has_value() || skip_object_id(obj_id)) {
-            continue;
+            return absl::OkStatus();
           }
-          DataItem this_value;
-          if (options.data_conflict_policy != MergeOptions::kOverwrite) {
-            this_value =
-                  GetAttributeFromSources(obj_id, {}, this_sources);
-          }
-          if (this_value.has_value()) {
-            if (options.data_conflict_policy ==
-                    MergeOptions::kRaiseOnConflict &&
-                this_value != other_item) {
-              return absl::FailedPreconditionError(
-                  absl::StrCat("conflicting values for ", attr_name, " for ",
-                               obj_id, ": ", this_value, " vs ", other_item));
-            }
-          } else {
+          ASSIGN_OR_RETURN(bool should_merge,
+                           ShouldMergeSmallAllocItem(attr_name, obj_id,
+                                                     other_item, this_sources,
+                                                     options));
+          if (should_merge) {
             if (this_mutable_source == nullptr) {
               this_mutable_source = &GetMutableSmallAllocSource(attr_name);
               // NOTE it is fine that this_sources doesn't contain newly created
@@ -2642,8 +4054,8 @@ absl::Status DataBagImpl::MergeSmallAllocInplace(const DataBagImpl& other,
             }
             this_mutable_source->Set(obj_id, other_item);
           }
-        }
-        return absl::OkStatus();
+          return absl::OkStatus();
+        });
       };
       RETURN_IF_ERROR(
           ProcessSparseSources(process_other_source, other_sources));
@@ -2652,115 +4064,314 @@ absl::Status DataBagImpl::MergeSmallAllocInplace(const DataBagImpl& other,
   return absl::OkStatus();
 }
 
-absl::Status DataBagImpl::MergeBigAllocInplace(const DataBagImpl& other,
-                                               MergeOptions options) {
-  absl::flat_hash_set<SourceKey> used_keys;
+void DataBagImpl::CollectSmallAllocMergeTasks(const DataBagImpl& other,
+                                              MergeOptions options,
+                                              std::vector<MergeTask>& tasks) {
+  // The buckets of a partitioned SparseSource are split between this many
+  // tasks. Doesn't depend on the executor, so that conflicts are reported the
+  // same way by the sequential and the parallel merge.
+  constexpr size_t kTasksPerSource = 16;
+  constexpr size_t kBucketsPerTask =
+      SparseSource::kSmallAllocBucketCount / kTasksPerSource;
+  auto skipped_attrs = std::make_shared<absl::flat_hash_set<std::string>>();
+  std::vector<MergeTask> bucket_tasks;
   for (const DataBagImpl* other_db = &other; other_db != nullptr;
        other_db = other_db->parent_data_bag_.get()) {
-    for (const auto& [source_key, other_source_collection] :
-         other_db->sources_) {
-      if (!used_keys.insert(source_key).second) {
+    for (const auto& [attr_name, other_source_top] :
+         other_db->small_alloc_sources_) {
+      // Attributes with several layers in `other` and attributes of this
+      // DataBagImpl (if `other` is its fork) are left to the single task.
+      if (other_db == this || !other_source_top.is_partitioned() ||
+          skipped_attrs->contains(attr_name)) {
         continue;
       }
-      const auto& [alloc, attr_name] = source_key;
-      ConstDenseSourceArray other_dense_sources;
-      ConstSparseSourceArray other_sparse_sources;
-      // NOTE we are taking sources from the top level DataBagImpl.
-      other.GetAttributeDataSources(alloc, attr_name, other_dense_sources,
-                                    other_sparse_sources);
-
-      ConstDenseSourceArray this_dense_sources;
-      ConstSparseSourceArray this_sparse_sources;
-      GetAttributeDataSources(alloc, attr_name, this_dense_sources,
-                              this_sparse_sources);
-
-      SourceCollection& this_collection =
-          GetOrCreateSourceCollection(alloc, attr_name);
-
-      if (this_dense_sources.empty() && this_sparse_sources.empty()) {
-        this_collection.lookup_parent = false;
-        if (!other_dense_sources.empty()) {
-          DCHECK_EQ(other_dense_sources.size(), 1);
-          SourceCollection other_source_collection_copy =
-              other_source_collection;
-          if (other_source_collection_copy.mutable_dense_source != nullptr) {
-            other_source_collection_copy.const_dense_source =
-                other_source_collection_copy.mutable_dense_source;
-            other_source_collection_copy.mutable_dense_source = nullptr;
-          }
-          DCHECK(other_source_collection_copy.const_dense_source != nullptr);
-          // Merge sparse and dense sources into single mutable dense source.
-          // This is necessary to avoid references into data from a different
-          // data bag.
-          RETURN_IF_ERROR(other_db->CreateMutableDenseSource(
-              other_source_collection_copy, alloc, attr_name,
-              // QType is not needed if dense source is present
-              nullptr, alloc.Capacity()));
-          this_collection = other_source_collection_copy;
-          continue;
-        }
-        this_collection.mutable_sparse_source =
-            MergeToMutableSparseSource(other_sparse_sources);
-        DCHECK(!this_collection.lookup_parent);
+      ConstSparseSourceArray other_sources;
+      other.GetSmallAllocDataSources(attr_name, other_sources);
+      if (other_sources.size() != 1 || other_sources[0] != &other_source_top) {
         continue;
       }
+      skipped_attrs->insert(attr_name);
+      // Created and partitioned in advance, so that the tasks only modify the
+      // buckets they own.
+      SparseSource& this_source = GetMutableSmallAllocSource(attr_name);
+      this_source.Partition();
+      ConstSparseSourceArray this_sources;
+      GetSmallAllocDataSources(attr_name, this_sources);
+      for (size_t begin = 0; begin < SparseSource::kSmallAllocBucketCount;
+           begin += kBucketsPerTask) {
+        bucket_tasks.push_back([attr_name = attr_name,
+                                &other_source = other_source_top,
+                                &this_source, this_sources, begin,
+                                options]() {
+          return other_source.ForEachInBuckets(
+              begin, begin + kBucketsPerTask,
+              [&](ObjectId obj_id, const DataItem& other_item)
+                  -> absl::Status {
+                if (!other_item.has_value()) {
+                  return absl::OkStatus();
+                }
+                ASSIGN_OR_RETURN(bool should_merge,
+                                 ShouldMergeSmallAllocItem(
+                                     attr_name, obj_id, other_item,
+                                     this_sources, options));
+                if (should_merge) {
+                  this_source.Set(obj_id, other_item);
+                }
+                return absl::OkStatus();
+              });
+        });
+      }
+    }
+  }
+  tasks.push_back([this, &other, options, skipped_attrs]() {
+    return MergeSmallAllocInplace(other, options, *skipped_attrs);
+  });
+  for (MergeTask& task : bucket_tasks) {
+    tasks.push_back(std::move(task));
+  }
+}
 
-      if (!this_dense_sources.empty()) {
-        if (this_collection.mutable_dense_source == nullptr) {
-          RETURN_IF_ERROR(CreateMutableDenseSource(
-              this_collection, alloc, attr_name,
-              // QType is not needed if dense source is present
-              nullptr, this_dense_sources.front()->size()));
-        }
-        DCHECK(this_collection.mutable_dense_source != nullptr);
-        DCHECK(this_collection.mutable_sparse_source == nullptr);
-        DCHECK(!this_collection.lookup_parent);
-        if (other_dense_sources.empty()) {
-          RETURN_IF_ERROR(MergeToMutableDenseSourceOnlySparse(
-              *this_collection.mutable_dense_source, other_sparse_sources,
-              options));
-          continue;
+absl::Status DataBagImpl::MergeBigAllocSourceInplace(
+    const DataBagImpl& other, const DataBagImpl& other_db, AllocationId alloc,
+    absl::string_view attr_name,
+    const SourceCollection& other_source_collection,
+    SourceCollection& this_collection, MergeOptions options) {
+  ConstDenseSourceArray other_dense_sources;
+  ConstSparseSourceArray other_sparse_sources;
+  // NOTE we are taking sources from the top level DataBagImpl.
+  other.GetAttributeDataSources(alloc, attr_name, other_dense_sources,
+                                other_sparse_sources);
+
+  ConstDenseSourceArray this_dense_sources;
+  ConstSparseSourceArray this_sparse_sources;
+  GetAttributeDataSources(alloc, attr_name, this_dense_sources,
+                          this_sparse_sources);
+
+  if (this_dense_sources.empty() && this_sparse_sources.empty()) {
+    this_collection.lookup_parent = false;
+    if (!other_dense_sources.empty()) {
+      DCHECK_EQ(other_dense_sources.size(), 1);
+      SourceCollection other_source_collection_copy = other_source_collection;
+      if (other_source_collection_copy.mutable_dense_source != nullptr) {
+        other_source_collection_copy.const_dense_source =
+            other_source_collection_copy.mutable_dense_source;
+        other_source_collection_copy.mutable_dense_source = nullptr;
+      }
+      DCHECK(other_source_collection_copy.const_dense_source != nullptr);
+      // Merge sparse and dense sources into single mutable dense source.
+      // This is necessary to avoid references into data from a different
+      // data bag.
+      RETURN_IF_ERROR(other_db.CreateMutableDenseSource(
+          other_source_collection_copy, alloc, attr_name,
+          // QType is not needed if dense source is present
+          nullptr, alloc.Capacity()));
+      this_collection = other_source_collection_copy;
+      return absl::OkStatus();
+    }
+    this_collection.mutable_sparse_source =
+        MergeToMutableSparseSource(other_sparse_sources);
+    DCHECK(!this_collection.lookup_parent);
+    return absl::OkStatus();
+  }
+
+  if (!this_dense_sources.empty()) {
+    if (this_collection.mutable_dense_source == nullptr) {
+      RETURN_IF_ERROR(CreateMutableDenseSource(
+          this_collection, alloc, attr_name,
+          // QType is not needed if dense source is present
+          nullptr, this_dense_sources.front()->size()));
+    }
+    DCHECK(this_collection.mutable_dense_source != nullptr);
+    DCHECK(this_collection.mutable_sparse_source == nullptr);
+    DCHECK(!this_collection.lookup_parent);
+    if (other_dense_sources.empty()) {
+      return MergeToMutableDenseSourceOnlySparse(
+          *this_collection.mutable_dense_source, other_sparse_sources,
+          options);
+    }
+    DCHECK_EQ(other_dense_sources.size(), 1);
+    return MergeToMutableDenseSource(*this_collection.mutable_dense_source,
+                                     alloc, *other_dense_sources.front(),
+                                     other_sparse_sources, options);
+  }
+
+  if (!other_dense_sources.empty()) {
+    // This sparse, other dense
+    SourceCollection other_source_collection_copy = other_source_collection;
+    if (other_source_collection_copy.mutable_dense_source == nullptr) {
+      RETURN_IF_ERROR(other_db.CreateMutableDenseSource(
+          other_source_collection_copy, alloc, attr_name,
+          // QType is not needed if dense source is present
+          nullptr, other_dense_sources.front()->size()));
+    }
+    RETURN_IF_ERROR(MergeToMutableDenseSourceOnlySparse(
+        *other_source_collection_copy.mutable_dense_source,
+        this_sparse_sources, ReverseMergeOptions(options)));
+    this_collection = other_source_collection_copy;
+    return absl::OkStatus();
+  }
+
+  // Both this and other sparse
+  DCHECK(this_collection.mutable_dense_source == nullptr);
+  DCHECK(this_collection.const_dense_source == nullptr);
+  DCHECK(other_dense_sources.empty());
+  this_collection.mutable_sparse_source =
+      MergeToMutableSparseSource(this_sparse_sources);
+  this_collection.lookup_parent = false;
+  return MergeToMutableSparseSourceOnlySparse(
+      *this_collection.mutable_sparse_source, other_sparse_sources, options);
+}
+
+namespace {
+
+bool IndexHasAlloc(absl::Span<const AllocationId> sorted_allocs,
+                   AllocationId alloc) {
+  return std::binary_search(sorted_allocs.begin(), sorted_allocs.end(), alloc);
+}
+
+bool IndexHasAttr(const DataBagIndex& index, AllocationId alloc,
+                  absl::string_view attr) {
+  auto it = index.attrs.find(attr);
+  return it != index.attrs.end() &&
+         IndexHasAlloc(it->second.allocations, alloc);
+}
+
+}  // namespace
+
+void DataBagImpl::CollectBigAllocMergeTasks(const DataBagImpl& other,
+                                            MergeOptions options,
+                                            const DataBagIndex& this_index,
+                                            std::vector<MergeTask>& tasks) {
+  struct Item {
+    AllocationId alloc;
+    std::string attr;
+    const DataBagImpl* other_db;
+    // The key is missing in this DataBagImpl and the collection of `other`
+    // holds all its data immutably, so the collection is adopted as is.
+    bool adopt;
+  };
+  std::vector<Item> items;
+  absl::flat_hash_map<AllocationId, absl::flat_hash_set<absl::string_view>>
+      used_keys;
+  for (const DataBagImpl* other_db = &other; other_db != nullptr;
+       other_db = other_db->parent_data_bag_.get()) {
+    for (const auto& [alloc, alloc_sources] : other_db->sources_) {
+      absl::flat_hash_set<absl::string_view>& used_attrs = used_keys[alloc];
+      for (const auto& [attr, collection] : alloc_sources) {
+        if (used_attrs.insert(attr).second) {
+          bool adopt = collection.mutable_dense_source == nullptr &&
+                       collection.mutable_sparse_source == nullptr &&
+                       !collection.lookup_parent &&
+                       !IndexHasAttr(this_index, alloc, attr);
+          items.push_back({alloc, attr, other_db, adopt});
         }
-        DCHECK_EQ(other_dense_sources.size(), 1);
-        RETURN_IF_ERROR(MergeToMutableDenseSource(
-            *this_collection.mutable_dense_source, alloc,
-            *other_dense_sources.front(), other_sparse_sources, options));
-        continue;
       }
+    }
+  }
+  // All the insertions into `sources_` are done before taking references to
+  // the collections, since rehashing invalidates them. Note that `other_db`
+  // can be `this` if `other` is a fork of this DataBagImpl.
+  for (const Item& item : items) {
+    GetOrCreateSourceCollection(item.alloc, item.attr);
+  }
+  for (const Item& item : items) {
+    const SourceCollection& other_collection =
+        *item.other_db->FindSourceCollection(item.alloc,
+                                             PreHashedAttr(item.attr));
+    SourceCollection& this_collection =
+        GetOrCreateSourceCollection(item.alloc, item.attr);
+    if (item.adopt) {
+      // Sharing the const source is safe, since neither DataBagImpl modifies
+      // it in place.
+      this_collection = other_collection;
+      continue;
+    }
+    // Each task reads and writes only the collections of its own
+    // (alloc, attr).
+    tasks.push_back([this, &other, other_db = item.other_db, alloc = item.alloc,
+                     attr = item.attr, &other_collection, &this_collection,
+                     options]() {
+      return MergeBigAllocSourceInplace(other, *other_db, alloc, attr,
+                                        other_collection, this_collection,
+                                        options);
+    });
+  }
+}
 
-      if (!other_dense_sources.empty()) {
-        // This sparse, other dense
-        SourceCollection other_source_collection_copy = other_source_collection;
-        if (other_source_collection_copy.mutable_dense_source == nullptr) {
-          RETURN_IF_ERROR(other_db->CreateMutableDenseSource(
-              other_source_collection_copy, alloc, attr_name,
-              // QType is not needed if dense source is present
-              nullptr, other_dense_sources.front()->size()));
+namespace {
+
+absl::Status MergeListVectorInplace(AllocationId alloc_id,
+                                    const DataListVector& other_lists,
+                                    DataListVector& this_lists,
+                                    MergeOptions options) {
+  for (size_t i = 0; i < other_lists.size(); ++i) {
+    const auto& other_list = other_lists.Get(i);
+    if (other_list.empty()) {
+      continue;
+    }
+    auto& this_list = this_lists.GetMutable(i);
+    if (options.data_conflict_policy == MergeOptions::kOverwrite ||
+        this_list.empty()) {
+      this_list = other_list;
+      continue;
+    }
+    if (options.data_conflict_policy == MergeOptions::kRaiseOnConflict) {
+      if (this_list.size() != other_list.size()) {
+        return absl::FailedPreconditionError(
+            absl::StrCat("conflicting list sizes for ", alloc_id, ": ",
+                         this_list.size(), " vs ", other_list.size()));
+      }
+      for (size_t j = 0; j < other_list.size(); ++j) {
+        if (this_list[j] != other_list[j]) {
+          return absl::FailedPreconditionError(absl::StrCat(
+              "conflicting list values for ", alloc_id, "at index ", j, ": ",
+              this_list[j], " vs ", other_list[j]));
         }
-        RETURN_IF_ERROR(MergeToMutableDenseSourceOnlySparse(
-            *other_source_collection_copy.mutable_dense_source,
-            this_sparse_sources, ReverseMergeOptions(options)));
-        this_collection = other_source_collection_copy;
-        continue;
       }
+    }
+  }
+  return absl::OkStatus();
+}
 
-      // Both this and other sparse
-      DCHECK(this_collection.mutable_dense_source == nullptr);
-      DCHECK(this_collection.const_dense_source == nullptr);
-      DCHECK(other_dense_sources.empty());
-      this_collection.mutable_sparse_source =
-          MergeToMutableSparseSource(this_sparse_sources);
-      this_collection.lookup_parent = false;
-      RETURN_IF_ERROR(MergeToMutableSparseSourceOnlySparse(
-          *this_collection.mutable_sparse_source, other_sparse_sources,
-          options));
+absl::Status MergeDictVectorInplace(
+    AllocationId alloc_id, const DictVector& other_dicts,
+    DictVector& this_dicts,
+    MergeOptions::ConflictHandlingOption conflict_policy) {
+  for (size_t i = 0; i < other_dicts.size(); ++i) {
+    const auto& other_dict = other_dicts[i];
+    std::vector<DataItem> keys = other_dict.GetKeys();
+    if (keys.empty()) {
+      // Avoid copying shared pages of `this_dicts`.
+      continue;
+    }
+    auto& this_dict = this_dicts[i];
+    for (const DataItem& key : keys) {
+      if (conflict_policy == MergeOptions::kOverwrite) {
+        this_dict.Set(key, other_dict.Get(key));
+        continue;
+      }
+      const DataItem& other_value = other_dict.Get(key);
+      if (!other_value.has_value()) {
+        continue;
+      }
+      const DataItem& this_value = this_dict.GetOrAssign(key, other_value);
+      if (conflict_policy == MergeOptions::kRaiseOnConflict &&
+          this_value != other_value) {
+        return absl::FailedPreconditionError(absl::StrCat(
+            "conflicting dict values for ", alloc_id.ObjectByOffset(i),
+            " key", key, ": ", this_value, " vs ", other_value));
+      }
     }
   }
   return absl::OkStatus();
 }
 
-absl::Status DataBagImpl::MergeListsInplace(const DataBagImpl& other,
-                                            MergeOptions options) {
+}  // namespace
+
+void DataBagImpl::CollectListsMergeTasks(const DataBagImpl& other,
+                                         MergeOptions options,
+                                         const DataBagIndex& this_index,
+                                         std::vector<MergeTask>& tasks) {
   absl::flat_hash_set<AllocationId> used_keys;
   for (const DataBagImpl* other_db = &other; other_db != nullptr;
        other_db = other_db->parent_data_bag_.get()) {
@@ -2768,40 +4379,29 @@ absl::Status DataBagImpl::MergeListsInplace(const DataBagImpl& other,
       if (!used_keys.insert(alloc_id).second) {
         continue;
       }
-      auto& this_lists = GetOrCreateMutableLists(alloc_id);
-      for (size_t i = 0; i < other_lists->size(); ++i) {
-        const auto& other_list = other_lists->Get(i);
-        if (other_list.empty()) {
-          continue;
-        }
-        auto& this_list = this_lists.GetMutable(i);
-        if (options.data_conflict_policy == MergeOptions::kOverwrite ||
-            this_list.empty()) {
-          this_list = other_list;
-          continue;
-        }
-        if (options.data_conflict_policy == MergeOptions::kRaiseOnConflict) {
-          if (this_list.size() != other_list.size()) {
-            return absl::FailedPreconditionError(
-                absl::StrCat("conflicting list sizes for ", alloc_id, ": ",
-                             this_list.size(), " vs ", other_list.size()));
-          }
-          for (size_t j = 0; j < other_list.size(); ++j) {
-            if (this_list[j] != other_list[j]) {
-              return absl::FailedPreconditionError(absl::StrCat(
-                  "conflicting list values for ", alloc_id, "at index ", j,
-                  ": ", this_list[j], " vs ", other_list[j]));
-            }
-          }
-        }
+      if (!IndexHasAlloc(this_index.lists, alloc_id)) {
+        // The top vector of `other` holds all its lists of the allocation.
+        // Its pages are copied on write by both vectors.
+        lists_.emplace(alloc_id, std::make_shared<DataListVector>(other_lists));
+        index_.AddLists(alloc_id);
+        continue;
       }
+      // DataListVectors are held by shared_ptr, so the references stay valid
+      // when `lists_` is modified.
+      DataListVector& this_lists = GetOrCreateMutableLists(alloc_id);
+      tasks.push_back([alloc_id = alloc_id, other_lists = other_lists.get(),
+                       &this_lists, options]() {
+        return MergeListVectorInplace(alloc_id, *other_lists, this_lists,
+                                      options);
+      });
     }
   }
-  return absl::OkStatus();
 }
 
-absl::Status DataBagImpl::MergeDictsInplace(const DataBagImpl& other,
-                                            MergeOptions options) {
+void DataBagImpl::CollectDictsMergeTasks(const DataBagImpl& other,
+                                         MergeOptions options,
+                                         const DataBagIndex& this_index,
+                                         std::vector<MergeTask>& tasks) {
   absl::flat_hash_set<AllocationId> used_keys;
   for (const DataBagImpl* other_db = &other; other_db != nullptr;
        other_db = other_db->parent_data_bag_.get()) {
@@ -2809,56 +4409,62 @@ absl::Status DataBagImpl::MergeDictsInplace(const DataBagImpl& other,
       if (!used_keys.insert(alloc_id).second) {
         continue;
       }
-      const auto& conflict_policy = alloc_id.IsExplicitSchemasAlloc()
-                                        ? options.schema_conflict_policy
-                                        : options.data_conflict_policy;
-      auto& this_dicts = GetOrCreateMutableDicts(alloc_id);
-      for (size_t i = 0; i < other_dicts->size(); ++i) {
-        const auto& other_dict = (*other_dicts)[i];
-        auto& this_dict = this_dicts[i];
-        for (const DataItem& key : other_dict.GetKeys()) {
-          if (conflict_policy == MergeOptions::kOverwrite) {
-            this_dict.Set(key, other_dict.Get(key));
-            continue;
-          }
-          const DataItem& other_value = other_dict.Get(key);
-          if (!other_value.has_value()) {
-            continue;
-          }
-          const DataItem& this_value = this_dict.GetOrAssign(key, other_value);
-          if (conflict_policy == MergeOptions::kRaiseOnConflict &&
-              this_value != other_value) {
-            return absl::FailedPreconditionError(absl::StrCat(
-                "conflicting dict values for ", alloc_id.ObjectByOffset(i),
-                " key", key, ": ", this_value, " vs ", other_value));
-          }
-        }
+      if (!IndexHasAlloc(this_index.dicts, alloc_id)) {
+        // Same as for the lists above.
+        dicts_.emplace(alloc_id, std::make_shared<DictVector>(other_dicts));
+        index_.AddDicts(alloc_id);
+        continue;
       }
+      auto conflict_policy = alloc_id.IsExplicitSchemasAlloc()
+                                 ? options.schema_conflict_policy
+                                 : options.data_conflict_policy;
+      DictVector& this_dicts = GetOrCreateMutableDicts(alloc_id);
+      tasks.push_back([alloc_id = alloc_id, other_dicts = other_dicts.get(),
+                       &this_dicts, conflict_policy]() {
+        return MergeDictVectorInplace(alloc_id, *other_dicts, this_dicts,
+                                      conflict_policy);
+      });
     }
   }
-  return absl::OkStatus();
 }
 
 // Merge additional attributes and objects from `other`.
 // Returns non-ok Status on conflict.
 absl::Status DataBagImpl::MergeInplace(const DataBagImpl& other,
                                        MergeOptions options) {
+  return MergeInplace(other, options, ParallelOptions());
+}
+
+absl::Status DataBagImpl::MergeInplace(
+    const DataBagImpl& other, MergeOptions options,
+    const ParallelOptions& parallel_options) {
   if (this == &other) {
     return absl::OkStatus();
   }
+  // The tasks are independent and ordered the same way as the sequential
+  // merge processes the data, so ParallelFor reporting the error with the
+  // smallest index keeps the conflict errors deterministic.
+  std::vector<MergeTask> tasks;
+  // Taken before the merge inserts any keys. Only the keys of `other` present
+  // in the index need value-level conflict checks.
+  std::shared_ptr<const DataBagIndex> this_index = GetIndexSnapshot();
   // sources_
-  RETURN_IF_ERROR(MergeBigAllocInplace(other, options));
+  CollectBigAllocMergeTasks(other, options, *this_index, tasks);
   // small_alloc_sources_
-  RETURN_IF_ERROR(MergeSmallAllocInplace(other, options));
+  CollectSmallAllocMergeTasks(other, options, tasks);
   // lists_
-  RETURN_IF_ERROR(MergeListsInplace(other, options));
+  CollectListsMergeTasks(other, options, *this_index, tasks);
   // dicts_
-  RETURN_IF_ERROR(MergeDictsInplace(other, options));
-  return absl::OkStatus();
+  CollectDictsMergeTasks(other, options, *this_index, tasks);
+  if (IsStatsEnabled()) {
+    global_stats.merge_inplace.Add(tasks.size());
+  }
+  return ParallelFor(parallel_options.executor, tasks.size(),
+                     [&](int64_t i) { return std::move(tasks[i])(); });
 }
 
-// TODO: Consider removing this destructor once databag
-// automatically squashes long chains.
+// NOTE: PartiallyPersistentFork bounds the length of the chains by
+// MaxForkDepth(), but the limit can be disabled, so we still avoid recursion.
 DataBagImpl::~DataBagImpl() noexcept {
   // The first destructed DataBag will perform clean up.
   thread_local bool is_cleanup_ongoing = false;
@@ -2886,38 +4492,154 @@ DataBagImpl::~DataBagImpl() noexcept {
   }
 }
 
-DataBagIndex DataBagImpl::CreateIndex() const {
-  DataBagIndex index;
-  absl::flat_hash_set<AllocationId> lists_set;
-  absl::flat_hash_set<AllocationId> dicts_set;
-  absl::flat_hash_map<std::string, absl::flat_hash_set<AllocationId>> attrs_map;
+DataBagIndex DataBagProjection::Apply(const DataBagIndex& index) const {
+  DataBagIndex res;
+  for (const auto& [attr_name, attr_index] : index.attrs) {
+    if (KeepsAttr(attr_name)) {
+      res.attrs.emplace(attr_name, attr_index);
+    }
+  }
+  if (lists) {
+    res.lists = index.lists;
+  }
+  for (AllocationId alloc : index.dicts) {
+    if (KeepsDict(alloc)) {
+      res.dicts.push_back(alloc);
+    }
+  }
+  return res;
+}
+
+void DataBagImpl::IncrementalIndex::AddAttr(absl::string_view attr,
+                                           AllocationId alloc) {
+  absl::MutexLock lock(&mutex_);
+  index_.attrs[attr].allocations.push_back(alloc);
+  snapshot_ = nullptr;
+  snapshot_with_parents_ = nullptr;
+}
+
+void DataBagImpl::IncrementalIndex::AddSmallAllocAttr(absl::string_view attr) {
+  absl::MutexLock lock(&mutex_);
+  index_.attrs[attr].with_small_allocs = true;
+  snapshot_ = nullptr;
+  snapshot_with_parents_ = nullptr;
+}
+
+void DataBagImpl::IncrementalIndex::AddLists(AllocationId alloc) {
+  DCHECK(alloc.IsListsAlloc());
+  absl::MutexLock lock(&mutex_);
+  index_.lists.push_back(alloc);
+  snapshot_ = nullptr;
+  snapshot_with_parents_ = nullptr;
+}
+
+void DataBagImpl::IncrementalIndex::AddDicts(AllocationId alloc) {
+  DCHECK(alloc.IsDictsAlloc() || alloc.IsSchemasAlloc());
+  absl::MutexLock lock(&mutex_);
+  index_.dicts.push_back(alloc);
+  snapshot_ = nullptr;
+  snapshot_with_parents_ = nullptr;
+}
+
+namespace {
+
+void SortAndRemoveDuplicates(std::vector<AllocationId>& allocs) {
+  std::sort(allocs.begin(), allocs.end());
+  allocs.erase(std::unique(allocs.begin(), allocs.end()), allocs.end());
+}
+
+}  // namespace
+
+std::shared_ptr<const DataBagIndex> DataBagImpl::IncrementalIndex::Snapshot(
+    const DataBagImpl* parent) {
+  absl::MutexLock lock(&mutex_);
+  if (snapshot_ == nullptr) {
+    // Each key is added once, so sorting is enough.
+    for (auto& [_, attr_index] : index_.attrs) {
+      std::sort(attr_index.allocations.begin(), attr_index.allocations.end());
+    }
+    std::sort(index_.lists.begin(), index_.lists.end());
+    std::sort(index_.dicts.begin(), index_.dicts.end());
+    snapshot_ = std::make_shared<const DataBagIndex>(index_);
+  }
+  if (parent == nullptr) {
+    return snapshot_;
+  }
+  if (snapshot_with_parents_ == nullptr) {
+    // The parents are not modified during the lifetime of the fork, so the
+    // merged index stays valid until this DataBagImpl is modified.
+    DataBagIndex merged = *snapshot_;
+    for (const DataBagImpl* db = parent; db != nullptr;
+         db = db->parent_data_bag_.get()) {
+      std::shared_ptr<const DataBagIndex> db_index =
+          db->GetIndexSnapshot(/*include_parents=*/false);
+      for (const auto& [attr_name, attr_index] : db_index->attrs) {
+        DataBagIndex::AttrIndex& merged_attr = merged.attrs[attr_name];
+        merged_attr.with_small_allocs |= attr_index.with_small_allocs;
+        merged_attr.allocations.insert(merged_attr.allocations.end(),
+                                       attr_index.allocations.begin(),
+                                       attr_index.allocations.end());
+      }
+      merged.lists.insert(merged.lists.end(), db_index->lists.begin(),
+                          db_index->lists.end());
+      merged.dicts.insert(merged.dicts.end(), db_index->dicts.begin(),
+                          db_index->dicts.end());
+    }
+    for (auto& [_, attr_index] : merged.attrs) {
+      SortAndRemoveDuplicates(attr_index.allocations);
+    }
+    SortAndRemoveDuplicates(merged.lists);
+    SortAndRemoveDuplicates(merged.dicts);
+    snapshot_with_parents_ =
+        std::make_shared<const DataBagIndex>(std::move(merged));
+  }
+  return snapshot_with_parents_;
+}
+
+std::shared_ptr<const DataBagIndex> DataBagImpl::GetIndexSnapshot(
+    bool include_parents) const {
+  return index_.Snapshot(include_parents ? parent_data_bag_.get() : nullptr);
+}
+
+DataBagMemoryUsage DataBagImpl::EstimateMemoryUsage() const {
+  using StorageKind = DataBagMemoryUsage::StorageKind;
+  DataBagMemoryUsage res;
+  // Sources and vectors can be shared between collections and DataBagImpls.
+  absl::flat_hash_set<const void*> visited;
   for (const DataBagImpl* cur_db = this; cur_db != nullptr;
        cur_db = cur_db->parent_data_bag_.get()) {
-    for (const auto& [alloc_id, _] : cur_db->lists_) {
-      DCHECK(alloc_id.IsListsAlloc());
-      lists_set.insert(alloc_id);
+    bool shared = cur_db != this;
+    auto add = [&](absl::string_view attr, StorageKind kind, int64_t bytes) {
+      MemoryUsage& usage = res.entries[{std::string(attr), kind}];
+      (shared ? usage.shared : usage.owned) += bytes;
+    };
+    auto add_once = [&](absl::string_view attr, StorageKind kind,
+                        const auto& ptr) {
+      if (ptr != nullptr && visited.insert(ptr.get()).second) {
+        add(attr, kind, ptr->EstimateMemoryUsage());
+      }
+    };
+    for (const auto& [_, alloc_sources] : cur_db->sources_) {
+      for (const auto& [attr, collection] : alloc_sources) {
+        add_once(attr, StorageKind::kDenseSource,
+                 collection.const_dense_source);
+        add_once(attr, StorageKind::kDenseSource,
+                 collection.mutable_dense_source);
+        add_once(attr, StorageKind::kSparseSource,
+                 collection.mutable_sparse_source);
+      }
     }
-    for (const auto& [alloc_id, dicts] : cur_db->dicts_) {
-      DCHECK(alloc_id.IsDictsAlloc() || alloc_id.IsSchemasAlloc());
-      dicts_set.insert(alloc_id);
+    for (const auto& [attr_name, source] : cur_db->small_alloc_sources_) {
+      add(attr_name, StorageKind::kSparseSource, source.EstimateMemoryUsage());
     }
-    for (const auto& [skey, _] : cur_db->sources_) {
-      attrs_map[skey.attr].insert(skey.alloc);
+    for (const auto& [_, lists] : cur_db->lists_) {
+      add_once("", StorageKind::kLists, lists);
     }
-    for (const auto& [attr_name, source] : cur_db->small_alloc_sources_) {
-      index.attrs[attr_name].with_small_allocs = true;
+    for (const auto& [_, dicts] : cur_db->dicts_) {
+      add_once("", StorageKind::kDicts, dicts);
     }
   }
-  for (const auto& [attr_name, allocs] : attrs_map) {
-    std::vector<AllocationId>& vec = index.attrs[attr_name].allocations;
-    vec.assign(allocs.begin(), allocs.end());
-    std::sort(vec.begin(), vec.end());
-  }
-  index.lists.assign(lists_set.begin(), lists_set.end());
-  std::sort(index.lists.begin(), index.lists.end());
-  index.dicts.assign(dicts_set.begin(), dicts_set.end());
-  std::sort(index.dicts.begin(), index.dicts.end());
-  return index;
+  return res;
 }
 
 absl::StatusOr<DataBagContent::ListsContent> DataBagImpl::ListVectorToContent(
@@ -2967,12 +4689,12 @@ DataBagImpl::ExtractSmallAllocAttrContent(absl::string_view attr_name) const {
   GetSmallAllocDataSources(attr_name, sources);
   absl::flat_hash_set<ObjectId> visited_ids;
   for (const SparseSource* source : sources) {
-    for (const auto& [obj, value] : source->GetAll()) {
+    source->ForEach([&](ObjectId obj, const DataItem& value) {
       if (bool inserted = visited_ids.insert(obj).second;
           inserted && value.has_value()) {
         res.push_back({obj, value});
       }
-    }
+    });
   }
   std::sort(res.begin(), res.end(),
             [](const DataBagContent::AttrItemContent& lhs,
@@ -3030,8 +4752,8 @@ absl::StatusOr<DataBagContent> DataBagImpl::ExtractContent(
             DataBagImpl::GetConstDictsOrNull(alloc);
         dict_vector != nullptr) {
       for (size_t i = 0; i < (**dict_vector).size(); ++i) {
-        AddDictToContent(alloc.ObjectByOffset(i), (**dict_vector)[i],
-                         content.dicts);
+        AddDictToContent(alloc.ObjectByOffset(i),
+                         std::as_const(**dict_vector)[i], content.dicts);
       }
     }
   }
@@ -28,25 +28,35 @@
 
 #include "absl/base/attributes.h"
 #include "absl/base/optimization.h"
+#include "absl/base/thread_annotations.h"
 #include "absl/container/btree_map.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/container/node_hash_map.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/hash/hash.h"
 #include "absl/log/log.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
+#include "koladata/internal/access_profile.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_list.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dense_source.h"
 #include "koladata/internal/dict.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/memory_usage.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/sparse_source.h"
+#include "koladata/internal/spill_pool.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/edge.h"
 #include "arolla/qtype/qtype.h"
+#include "arolla/util/fingerprint.h"
 #include "arolla/util/refcount_ptr.h"
 
 namespace koladata::internal {
@@ -65,6 +75,22 @@ struct MergeOptions {
   friend bool operator==(const MergeOptions&, const MergeOptions&) = default;
 };
 
+// Options for DataBagImpl::CreateOptimized.
+struct OptimizeOptions {
+  // Sparse attribute sources with at least this fraction of the allocation
+  // capacity present are converted into dense ones.
+  double sparse_to_dense_ratio = 1.0 / 16;
+  // Text attributes with at most this fraction of distinct values among the
+  // present ones are stored with each distinct value kept only once.
+  double max_distinct_text_ratio = 0.5;
+  // Build the index (see GetIndexSnapshot) in advance.
+  bool build_index = true;
+  // Choose the layouts of the attribute sources recorded in GetAccessProfile()
+  // with RecommendStorageLayout instead of the thresholds above. Sources that
+  // were not accessed while profiling use the thresholds.
+  bool use_access_profile = false;
+};
+
 struct DataBagIndex {
   struct AttrIndex {
     std::vector<AllocationId> allocations;
@@ -75,6 +101,25 @@ struct DataBagIndex {
   std::vector<AllocationId> dicts;
 };
 
+// Subset of the content of a DataBag to extract or decode: the attributes
+// with the given names and, optionally, the lists, the dicts and the schemas.
+struct DataBagProjection {
+  absl::flat_hash_set<std::string> attrs;
+  bool lists = false;
+  bool dicts = false;
+  // Explicit and implicit schemas (which are stored as dicts).
+  bool schemas = true;
+
+  bool KeepsAttr(absl::string_view attr) const { return attrs.contains(attr); }
+  // `alloc` must be a dicts or a schemas allocation.
+  bool KeepsDict(AllocationId alloc) const {
+    return alloc.IsSchemasAlloc() ? schemas : dicts;
+  }
+
+  // Returns the subset of `index` kept by the projection.
+  DataBagIndex Apply(const DataBagIndex& index) const;
+};
+
 struct DataBagContent {
   struct AttrAllocContent {
     AllocationId alloc_id;
@@ -103,12 +148,74 @@ struct DataBagContent {
   std::vector<DictContent> dicts;
 };
 
+// Estimated memory usage of a DataBagImpl per attribute and kind of storage.
+// Lists and dicts are reported with an empty attribute name.
+struct DataBagMemoryUsage {
+  enum class StorageKind {
+    kDenseSource,
+    kSparseSource,
+    kLists,
+    kDicts,
+  };
+  absl::btree_map<std::pair<std::string, StorageKind>, MemoryUsage> entries;
+
+  MemoryUsage Total() const {
+    MemoryUsage total;
+    for (const auto& [_, usage] : entries) {
+      total += usage;
+    }
+    return total;
+  }
+};
+
+// Counters of DataBagImpl operations accumulated by all DataBagImpls while
+// enabled by DataBagImpl::SetStatsEnabled.
+struct DataBagStats {
+  struct OpStats {
+    int64_t calls = 0;
+    // Number of objects, dicts or list items processed by the calls.
+    int64_t elements = 0;
+  };
+  // GetAttr, GetAttrs and GetAttrPath (one call per attribute). Fallbacks,
+  // parents and parallel chunks of a call are not counted separately.
+  OpStats get_attr;
+  OpStats set_attr;
+  OpStats get_from_dict;
+  OpStats explode_list;
+  // Elements are the number of merge tasks (roughly one per attribute
+  // source, lists or dicts allocation).
+  OpStats merge_inplace;
+
+  // Number of GetAttr and GetFromDict calls that looked up fallbacks.
+  int64_t fallback_lookups = 0;
+  // Number of DataBagImpls visited in the parent chains while collecting the
+  // attribute sources of big allocations.
+  int64_t parent_chain_steps = 0;
+  // Number of attribute sources used by batch GetAttr.
+  int64_t dense_source_reads = 0;
+  int64_t sparse_source_reads = 0;
+  // Number of attribute sources modified by SetAttr.
+  int64_t dense_source_writes = 0;
+  int64_t sparse_source_writes = 0;
+};
+
 // Returns merge options that would achieve the same result, but when
 // the DataBags are merged in the reverse order.
 MergeOptions ReverseMergeOptions(const MergeOptions& options);
 
 class DataBagImpl;
 
+// Attribute name together with its precomputed hash. Lookups by PreHashedAttr
+// do not rehash the name for every allocation, fallback and parent DataBagImpl.
+// The name is not owned and must outlive the PreHashedAttr.
+struct PreHashedAttr {
+  explicit PreHashedAttr(absl::string_view name)
+      : name(name), hash(absl::HashOf(name)) {}
+
+  absl::string_view name;
+  size_t hash;
+};
+
 using DataBagImplPtr = arolla::RefcountPtr<DataBagImpl>;
 using DataBagImplConstPtr = arolla::RefcountPtr<const DataBagImpl>;
 
@@ -127,8 +234,75 @@ class DataBagImpl : public arolla::RefcountedBase {
   // https://en.wikipedia.org/wiki/Persistent_data_structure
   // Original/parent DataBagImpl is not expected to be modified during the
   // lifetime of the fork.
+  //
+  // If the chain of parents would become longer than MaxForkDepth(), the
+  // chain is squashed into a fresh DataBagImpl without parents, so that the
+  // cost of lookups stays bounded. Only the small allocation attributes, the
+  // lists and the dicts are merged; the dense attribute sources of big
+  // allocations are shared with the chain.
   DataBagImplPtr PartiallyPersistentFork() const;
 
+  // Default value for MaxForkDepth().
+  static constexpr int64_t kDefaultMaxForkDepth = 128;
+
+  // Returns the maximum length of the chain of parents created by
+  // PartiallyPersistentFork. Zero or negative means unlimited.
+  static int64_t MaxForkDepth();
+
+  // Sets the maximum length of the chain of parents created by
+  // PartiallyPersistentFork. Affects only forks created after the call.
+  // Zero or negative means unlimited.
+  static void SetMaxForkDepth(int64_t max_fork_depth);
+
+  // Returns the length of the chain of parents.
+  int64_t fork_depth() const { return fork_depth_; }
+
+  // Returns a DataBagImpl with the same content in the layout that is the
+  // fastest to read: without parents, with dense attribute sources instead of
+  // sparse ones where they are dense enough, with repeated text values
+  // stored once and with the index built. Takes time proportional to the size
+  // of the data, so it is meant to be called once before the DataBagImpl is
+  // published for reading. The result is not expected to be modified.
+  absl::StatusOr<DataBagImplPtr> CreateOptimized(
+      const OptimizeOptions& options = {}) const;
+
+  // Returns the recommended layouts of the attribute sources in `profile`
+  // (see access_profile.h) that have values in this DataBagImpl or its
+  // parents. Reads all the values of the sources, so it is relatively slow.
+  // The reads are not recorded in the access profile.
+  absl::StatusOr<std::vector<StorageLayoutRecommendation>>
+  RecommendStorageLayouts(const AccessProfile& profile,
+                          const OptimizeOptions& options = {}) const;
+
+  // Default value for SparseSourcePromotionRatio().
+  static constexpr double kDefaultSparseSourcePromotionRatio = 1.0 / 16;
+
+  // Returns the fraction of the allocation capacity after which a mutable
+  // sparse attribute source is converted into a dense one. Values > 1 disable
+  // the promotion.
+  static double SparseSourcePromotionRatio();
+
+  // Sets the fraction of the allocation capacity after which a mutable sparse
+  // attribute source is converted into a dense one.
+  static void SetSparseSourcePromotionRatio(double ratio);
+
+  // Enables or disables collecting DataBagStats. Disabled by default; the
+  // cost of the disabled counters is a relaxed atomic load per operation.
+  static void SetStatsEnabled(bool enabled);
+  static bool StatsEnabled();
+
+  // Returns the counters accumulated since the start of the process or the
+  // last call to ResetStats. The counters are updated independently, so a
+  // snapshot taken during concurrent operations is not necessarily
+  // consistent.
+  static DataBagStats GetStats();
+
+  // Resets the counters returned by GetStats.
+  static void ResetStats();
+
+  // Returns true if neither this DataBagImpl nor its parents contain any data.
+  bool IsEmpty() const { return parent_data_bag_ == nullptr && IsLayerEmpty(); }
+
   // *******  Const interface
 
   using ConstDenseSourceArray = absl::InlinedVector<const DenseSource*, 1>;
@@ -145,6 +319,60 @@ class DataBagImpl : public arolla::RefcountedBase {
   absl::StatusOr<DataItem> GetAttr(
       const DataItem& object,
       absl::string_view attr,
+      FallbackSpan fallbacks = {}) const {
+    return GetAttr(object, PreHashedAttr(attr), fallbacks);
+  }
+
+  // Same as above, but reuses the hash of `attr`. Useful for the hot lookups
+  // of a fixed attribute, e.g. __schema__.
+  absl::StatusOr<DataItem> GetAttr(
+      const DataItem& object,
+      const PreHashedAttr& attr,
+      FallbackSpan fallbacks = {}) const;
+
+  // Options for the parallel batch operations (GetAttr, SetInDict,
+  // ClearDict).
+  struct ParallelOptions {
+    // Executor to run the chunks on. nullptr means sequential execution.
+    Executor* executor = nullptr;
+    // `objects` are not split into chunks smaller than this.
+    int64_t min_chunk_size = 1 << 16;
+  };
+
+  // Same as GetAttr above, but splits `objects` into contiguous ranges and
+  // looks them up concurrently using `options.executor`. Each range writes its
+  // values directly into the presized result arrays, only Text and Bytes
+  // values are copied sequentially. Falls back to the sequential version for
+  // small inputs.
+  //
+  // The DataBagImpl and `fallbacks` must not be modified during the call.
+  absl::StatusOr<DataSliceImpl> GetAttr(
+      const DataSliceImpl& objects,
+      absl::string_view attr,
+      FallbackSpan fallbacks,
+      const ParallelOptions& options) const;
+
+  // Returns the values of several attributes of `objects`, in the order of
+  // `attrs`. Equivalent to calling GetAttr for every attribute, but the
+  // validation of `objects` is done once, and the fallbacks are only visited
+  // while some of the objects still miss the attribute.
+  absl::StatusOr<std::vector<DataSliceImpl>> GetAttrs(
+      const DataSliceImpl& objects,
+      absl::Span<const absl::string_view> attrs,
+      FallbackSpan fallbacks = {}) const;
+
+  // Number of objects that GetAttrPath follows through all the attributes at
+  // once.
+  static constexpr int64_t kGetAttrPathChunkSize = 1 << 12;
+
+  // Returns `objects.attrs[0].attrs[1]...`. Equivalent to chaining GetAttr
+  // calls, but large inputs are processed in chunks of kGetAttrPathChunkSize
+  // objects that go through all the attributes before the next chunk starts,
+  // so the intermediate ObjectIds are still in cache when they are looked up.
+  // Returns `objects` if `attrs` is empty.
+  absl::StatusOr<DataSliceImpl> GetAttrPath(
+      const DataSliceImpl& objects,
+      absl::Span<const absl::string_view> attrs,
       FallbackSpan fallbacks = {}) const;
 
   // Gets __schema__ attribute for objects and returns an Error if DataSlice has
@@ -163,15 +391,34 @@ class DataBagImpl : public arolla::RefcountedBase {
   // Returns size of the alloc (can be less then alloc.Capacity() e.g. if
   // an initial dense source for this allocation was created from a pre-existing
   // DenseArray).
-  int64_t GetAttributeDataSources(AllocationId alloc, absl::string_view attr,
+  int64_t GetAttributeDataSources(
+      AllocationId alloc, absl::string_view attr,
+      ConstDenseSourceArray& dense_sources,
+      ConstSparseSourceArray& sparse_sources) const {
+    return GetAttributeDataSources(alloc, PreHashedAttr(attr), dense_sources,
+                                   sparse_sources);
+  }
+  int64_t GetAttributeDataSources(AllocationId alloc,
+                                  const PreHashedAttr& attr,
                                   ConstDenseSourceArray& dense_sources,
                                   ConstSparseSourceArray& sparse_sources) const;
 
   // Returns information about all AllocationId stored in
-  // the DataBag. The function is relatively slow (i.e. not O(1) ) as it
-  // iterates over all internal data structures. Returned index is sorted by
-  // allocation id and has no duplicates.
-  DataBagIndex CreateIndex() const;
+  // the DataBag. Returned index is sorted by allocation id and has no
+  // duplicates. The index is maintained on modification, so the function is
+  // O(index size) rather than a scan of all internal data structures.
+  // If `include_parents` is false, only the allocations modified in this
+  // DataBagImpl (i.e. after PartiallyPersistentFork) are returned. Note that
+  // ExtractContent for such index still returns the merged content of the
+  // allocations, including the data from parents.
+  DataBagIndex CreateIndex(bool include_parents = true) const {
+    return *GetIndexSnapshot(include_parents);
+  }
+
+  // Same as CreateIndex, but returns an immutable snapshot that is shared by
+  // all the calls until the DataBagImpl is modified.
+  std::shared_ptr<const DataBagIndex> GetIndexSnapshot(
+      bool include_parents = true) const;
 
   // Returns content of the DataBag including data from parents. The content
   // is filtered by the allocation ids present in DataBagIndex.
@@ -189,6 +436,18 @@ class DataBagImpl : public arolla::RefcountedBase {
   absl::StatusOr<DataBagContent> ExtractContent() const {
     return ExtractContent(CreateIndex());
   }
+  // Returns the part of the content of the DataBag kept by `projection`.
+  absl::StatusOr<DataBagContent> ExtractContent(
+      const DataBagProjection& projection) const {
+    return ExtractContent(projection.Apply(*GetIndexSnapshot()));
+  }
+
+  // Returns the estimated memory usage of the DataBagImpl, see MemoryUsage.
+  // The data of this DataBagImpl is reported as owned and the data of its
+  // parents (see PartiallyPersistentFork) as shared. Data structures
+  // referenced several times are counted once. The function iterates over all
+  // internal data structures, so it is relatively slow.
+  DataBagMemoryUsage EstimateMemoryUsage() const;
 
   // *******  Mutable interface
 
@@ -216,6 +475,38 @@ class DataBagImpl : public arolla::RefcountedBase {
   absl::Status SetAttr(const DataItem& object, absl::string_view attr,
                        DataItem value);
 
+  // Sets `values` as the attribute `attr` of objects
+  // `alloc_id.ObjectByOffset(i)` for i in [0, values.size()). All previous
+  // values of the attribute for the allocation are discarded. Similarly to
+  // CreateObjectsFromFields, objects with offsets >= values.size() are expected
+  // to be unused. For big allocations `values` are wrapped into a readonly
+  // DenseSource without copying.
+  absl::Status SetAttrForEntireAllocation(AllocationId alloc_id,
+                                          absl::string_view attr,
+                                          const DataSliceImpl& values);
+
+  // Same as above, but sets the same `value` for the objects with offsets in
+  // [0, size). For big allocations the value is stored once, in a constant
+  // DenseSource, so it takes O(1) memory until one of the objects is modified.
+  absl::Status SetAttrForEntireAllocation(AllocationId alloc_id,
+                                          absl::string_view attr, int64_t size,
+                                          const DataItem& value);
+
+  // Same as above, but the values are produced by `loader` on the first access
+  // to the attribute of the allocation (see DenseSource::CreateLazy). Small
+  // allocations are loaded immediately.
+  absl::Status SetAttrForEntireAllocationLazily(AllocationId alloc_id,
+                                                absl::string_view attr,
+                                                DenseSource::Loader loader);
+
+  // Moves the values of the DenseSources of this DataBagImpl (not of its
+  // parents) under `pool`, so that the rarely used ones can be evicted from
+  // memory. The sources become readonly, so the first modification of an
+  // attribute of an allocation copies its values back. Sources that take no
+  // memory (e.g. constant or not yet loaded lazy sources) are kept as is.
+  // Lists and dicts are not affected.
+  absl::Status MoveToSpillPool(SpillPool& pool);
+
   // Updates DataBagImpl by setting attribute to present for specified objects.
   // Returns a slice of unique ObjectIds that had an attribute missing before.
   absl::StatusOr<DataSliceImpl>
@@ -334,10 +625,20 @@ class DataBagImpl : public arolla::RefcountedBase {
   absl::Status RemoveInList(const DataSliceImpl& lists, ListRange range);
 
   // Remove given indices. Size of `lists` must be equal to the size of
-  // `indices`.
+  // `indices`. If a list occurs several times in `lists`, its indices are
+  // removed one after another in the order of `lists`, each one relative to the
+  // list with the previous ones already removed. Each list is still compacted
+  // only once, so removing k elements from a list of size n takes
+  // O(n + k * log(n)) rather than O(n * k).
   absl::Status RemoveInList(const DataSliceImpl& lists,
                             const arolla::DenseArray<int64_t>& indices);
 
+  // Same as above, but compacts different lists concurrently using
+  // `options.executor`.
+  absl::Status RemoveInList(const DataSliceImpl& lists,
+                            const arolla::DenseArray<int64_t>& indices,
+                            const ParallelOptions& options);
+
   // ******* Single list functions
 
   // Returns int64_t DataItem with a size of the list.
@@ -416,6 +717,17 @@ class DataBagImpl : public arolla::RefcountedBase {
   // Clear given dicts.
   absl::Status ClearDict(const DataSliceImpl& dicts);
 
+  // Same as above, but partitions the dicts by DictVector page and processes
+  // the partitions concurrently using `options.executor`. Updates of the same
+  // dict are applied in the order of `dicts`, so the result is the same as of
+  // the sequential version. Falls back to the sequential version for small
+  // inputs and for dicts that are not in big dict allocations.
+  absl::Status SetInDict(const DataSliceImpl& dicts, const DataSliceImpl& keys,
+                         const DataSliceImpl& values,
+                         const ParallelOptions& options);
+  absl::Status ClearDict(const DataSliceImpl& dicts,
+                         const ParallelOptions& options);
+
   // ******* Single dict functions
 
   // Equivalent to functions above, but for a single dict.
@@ -525,7 +837,9 @@ class DataBagImpl : public arolla::RefcountedBase {
 
   // Returns an explicit UuSchema DataItem with attributes from `attr_names` set
   // to schemas in `items` in the same order. In case some of the `items` are
-  // not valid schemas, appropriate error is returned.
+  // not valid schemas, appropriate error is returned. The fields are not
+  // written again if the DataBag already has them, so creating the same schema
+  // repeatedly (e.g. a list schema per list) doesn't modify the DataBag.
   absl::StatusOr<DataItem> CreateUuSchemaFromFields(
       absl::string_view seed, absl::Span<const absl::string_view> attr_names,
       absl::Span<const std::reference_wrapper<const DataItem>> items);
@@ -578,6 +892,13 @@ class DataBagImpl : public arolla::RefcountedBase {
   absl::Status MergeInplace(const DataBagImpl& other,
                             MergeOptions options = MergeOptions());
 
+  // Same as above, but merges independent parts (attributes of each
+  // allocation, list and dict allocations) concurrently using
+  // `parallel_options.executor`. On conflict returns the same error as the
+  // sequential version. `other` must not be modified during the call.
+  absl::Status MergeInplace(const DataBagImpl& other, MergeOptions options,
+                            const ParallelOptions& parallel_options);
+
   // Assigns this DataBagImpl to a DataBag. This should called every time a
   // DataBag is created from this DataBagImpl to make sure DataBagImpl is never
   // reused.
@@ -596,11 +917,11 @@ class DataBagImpl : public arolla::RefcountedBase {
   // Search attribute value for the given object in small_alloc_sources_
   // including parents.
   ABSL_ATTRIBUTE_ALWAYS_INLINE DataItem
-  LookupAttrInDataItemMap(ObjectId object_id, absl::string_view attr) const {
-    size_t attr_hash = absl::HashOf(attr);
+  LookupAttrInDataItemMap(ObjectId object_id,
+                          const PreHashedAttr& attr) const {
     for (const DataBagImpl* db = this; db != nullptr;
          db = db->parent_data_bag_.get()) {
-      if (auto attr_it = db->small_alloc_sources_.find(attr, attr_hash);
+      if (auto attr_it = db->small_alloc_sources_.find(attr.name, attr.hash);
           attr_it != db->small_alloc_sources_.end()) {
         const auto& obj2item = attr_it->second;
         if (auto item = obj2item.Get(object_id); item.has_value()) {
@@ -612,13 +933,21 @@ class DataBagImpl : public arolla::RefcountedBase {
   }
 
   // Search attribute value for the given object in sources_
-  // including parents.
-  DataItem LookupAttrInDataSourcesMap(ObjectId object_id,
-                                      absl::string_view attr) const;
+  // including parents. Returns the loading errors of lazy sources.
+  absl::StatusOr<DataItem> LookupAttrInDataSourcesMap(
+      ObjectId object_id, const PreHashedAttr& attr) const;
 
   // Lower level utility for batch GetAttr without fallbacks support.
   absl::StatusOr<DataSliceImpl> GetAttrFromSources(
-    const DataSliceImpl& objects, absl::string_view attr) const;
+    const DataSliceImpl& objects, const PreHashedAttr& attr) const;
+
+  // Batch GetAttr without updating the get_attr and fallback_lookups stats,
+  // so that the public entry points count one call however they split the
+  // work. Sets `looked_up_fallbacks` if any of `fallbacks` was looked up.
+  absl::StatusOr<DataSliceImpl> GetAttrImpl(const DataSliceImpl& objects,
+                                            const PreHashedAttr& attr,
+                                            FallbackSpan fallbacks,
+                                            bool& looked_up_fallbacks) const;
 
   template <bool kReturnValues>
   absl::StatusOr<std::pair<DataSliceImpl, arolla::DenseArrayEdge>>
@@ -663,77 +992,93 @@ class DataBagImpl : public arolla::RefcountedBase {
   SparseSource& GetMutableSmallAllocSource(absl::string_view attr);
 
   // Add small alloc data sources for the given attribute into `res_sources`.
-  void GetSmallAllocDataSources(absl::string_view attr,
+  void GetSmallAllocDataSources(const PreHashedAttr& attr,
                                 ConstSparseSourceArray& res_sources) const;
+  void GetSmallAllocDataSources(absl::string_view attr,
+                                ConstSparseSourceArray& res_sources) const {
+    GetSmallAllocDataSources(PreHashedAttr(attr), res_sources);
+  }
 
   std::vector<DataBagContent::AttrItemContent> ExtractSmallAllocAttrContent(
       absl::string_view attr_name) const;
   absl::StatusOr<DataBagContent::AttrContent> ExtractAttrContent(
       absl::string_view attr_name, const DataBagIndex::AttrIndex& index) const;
 
+  // Returns true if this DataBagImpl has no data of its own. Its parents can
+  // still have some.
+  bool IsLayerEmpty() const {
+    return sources_.empty() && small_alloc_sources_.empty() && lists_.empty() &&
+           dicts_.empty();
+  }
+
+  // Returns a DataBagImpl without parents with the content of this one and
+  // its parents, see PartiallyPersistentFork.
+  absl::StatusOr<DataBagImplPtr> CreateSquashedFork() const;
+
   // *** Merging helpers
-  absl::Status MergeSmallAllocInplace(const DataBagImpl& other,
-                                      MergeOptions options);
-  absl::Status MergeBigAllocInplace(const DataBagImpl& other,
-                                    MergeOptions options);
-  absl::Status MergeListsInplace(const DataBagImpl& other,
-                                 MergeOptions options);
-  absl::Status MergeDictsInplace(const DataBagImpl& other,
-                                 MergeOptions options);
+  using MergeTask = absl::AnyInvocable<absl::Status() &&>;
+
+  // Merges the small alloc attributes of `other`, except for
+  // `skipped_attrs`.
+  absl::Status MergeSmallAllocInplace(
+      const DataBagImpl& other, MergeOptions options,
+      const absl::flat_hash_set<std::string>& skipped_attrs);
+
+  // Appends to `tasks` the tasks merging the small alloc attributes of `other`.
+  // The large partitioned SparseSources are merged by several tasks, each
+  // covering a range of their buckets, and the rest by a single task.
+  void CollectSmallAllocMergeTasks(const DataBagImpl& other,
+                                   MergeOptions options,
+                                   std::vector<MergeTask>& tasks);
+
+  // Append to `tasks` the tasks merging the corresponding data from `other`.
+  // Tasks can run concurrently, but must be run before any other modification
+  // of this DataBagImpl.
+  //
+  // `this_index` is the index of this DataBagImpl (with its parents) before
+  // the merge. The keys of `other` missing in it can't conflict, so their
+  // immutable data (const dense sources and copy-on-write pages of lists and
+  // dicts) is shared instead of being merged value by value.
+  void CollectBigAllocMergeTasks(const DataBagImpl& other,
+                                 MergeOptions options,
+                                 const DataBagIndex& this_index,
+                                 std::vector<MergeTask>& tasks);
+  void CollectListsMergeTasks(const DataBagImpl& other, MergeOptions options,
+                              const DataBagIndex& this_index,
+                              std::vector<MergeTask>& tasks);
+  void CollectDictsMergeTasks(const DataBagImpl& other, MergeOptions options,
+                              const DataBagIndex& this_index,
+                              std::vector<MergeTask>& tasks);
 
   DataBagImplConstPtr parent_data_bag_ = nullptr;
+  // Number of DataBagImpls in the parent_data_bag_ chain.
+  int64_t fork_depth_ = 0;
   bool is_assigned_ = false;
 
-  struct SourceKey {
-    AllocationId alloc;
-    std::string attr;
-
-    friend bool operator==(const SourceKey& lhs, const SourceKey& rhs) {
-      return lhs.alloc == rhs.alloc && lhs.attr == rhs.attr;
-    }
-
-    template <typename H>
-    friend H AbslHashValue(H h, const SourceKey& k) {
-      return H::combine(std::move(h), k.alloc, k.attr);
-    }
-  };
-
-  struct SourceKeyView {
-    AllocationId alloc;
-    absl::string_view attr;
-
-    explicit operator SourceKey() const {
-      return SourceKey{alloc, std::string(attr)};
-    }
-
-    friend bool operator==(const SourceKeyView& lhs, const SourceKeyView& rhs) {
-      return lhs.alloc == rhs.alloc && lhs.attr == rhs.attr;
-    }
-
-    template <typename H>
-    friend H AbslHashValue(H h, const SourceKeyView& k) {
-      return H::combine(std::move(h), k.alloc, k.attr);
-    }
-  };
+  // Index of the keys of sources_, small_alloc_sources_, lists_ and dicts_ of
+  // a single DataBagImpl, updated whenever a new key is inserted. Thread-safe,
+  // since MergeInplace inserts keys from parallel tasks.
+  class IncrementalIndex {
+   public:
+    void AddAttr(absl::string_view attr, AllocationId alloc);
+    void AddSmallAllocAttr(absl::string_view attr);
+    void AddLists(AllocationId alloc);
+    void AddDicts(AllocationId alloc);
 
-  struct SourceKeyHashAndEq {
-    using is_transparent = void;  // go/totw/144
+    // Returns the sorted index of this DataBagImpl only, or merged with the
+    // indices of `parent` and its parents if it is not nullptr.
+    std::shared_ptr<const DataBagIndex> Snapshot(const DataBagImpl* parent);
 
-    // equality
-    bool operator()(const SourceKey& a, const SourceKey& b) const {
-      return a == b;
-    }
-    bool operator()(const SourceKeyView& a, const SourceKeyView& b) const {
-      return a == b;
-    }
-    bool operator()(const SourceKey& a, const SourceKeyView& b) const {
-      return a.alloc == b.alloc && a.attr == b.attr;
-    }
-
-    // hash
-    size_t operator()(const SourceKey& a) const { return absl::HashOf(a); }
-    size_t operator()(const SourceKeyView& a) const { return absl::HashOf(a); }
+   private:
+    absl::Mutex mutex_;
+    // Not sorted, but without duplicates.
+    DataBagIndex index_ ABSL_GUARDED_BY(mutex_);
+    // Reset on every modification.
+    std::shared_ptr<const DataBagIndex> snapshot_ ABSL_GUARDED_BY(mutex_);
+    std::shared_ptr<const DataBagIndex> snapshot_with_parents_
+        ABSL_GUARDED_BY(mutex_);
   };
+  mutable IncrementalIndex index_;
 
   struct SourceCollection {
     // Mutable data source that can be modified in place.
@@ -749,6 +1094,21 @@ class DataBagImpl : public arolla::RefcountedBase {
     bool lookup_parent = true;
   };
 
+  // Attribute name -> SourceCollection of a single big allocation.
+  using AllocSources = absl::flat_hash_map<std::string, SourceCollection>;
+
+  // Returns the collection of (alloc, attr) in this DataBagImpl, without
+  // looking into the parents, or nullptr if there is none.
+  const SourceCollection* FindSourceCollection(
+      AllocationId alloc, const PreHashedAttr& attr) const {
+    auto alloc_it = sources_.find(alloc);
+    if (alloc_it == sources_.end()) {
+      return nullptr;
+    }
+    auto it = alloc_it->second.find(attr.name, attr.hash);
+    return it == alloc_it->second.end() ? nullptr : &it->second;
+  }
+
   SourceCollection& GetOrCreateSourceCollection(AllocationId alloc_id,
                                                 absl::string_view attr);
 
@@ -758,6 +1118,15 @@ class DataBagImpl : public arolla::RefcountedBase {
                                         const arolla::QType* qtype,
                                         int64_t size) const;
 
+  // Merges `other` data of a single (alloc, attr) into `this_collection`.
+  // `other_source_collection` is the top collection for the key in `other_db`
+  // from the `other` parents chain.
+  absl::Status MergeBigAllocSourceInplace(
+      const DataBagImpl& other, const DataBagImpl& other_db,
+      AllocationId alloc, absl::string_view attr_name,
+      const SourceCollection& other_source_collection,
+      SourceCollection& this_collection, MergeOptions options);
+
   class ReadOnlyListGetter;
   class MutableListGetter;
 
@@ -787,11 +1156,20 @@ class DataBagImpl : public arolla::RefcountedBase {
 
   // Create (if not yet created) a mutable source in the given `collection`.
   // Modified collection will have either mutable_dense_source or
-  // mutable_sparse_source.
+  // mutable_sparse_source. The existing mutable_sparse_source is promoted to
+  // mutable_dense_source if after the update it could contain more than
+  // SparseSourcePromotionRatio() * alloc_id.Capacity() values.
   absl::Status GetOrCreateMutableSourceInCollection(
       SourceCollection& collection, AllocationId alloc_id,
       absl::string_view attr, const arolla::QType* qtype, size_t update_size);
 
+  // Returns true if the DenseSource that `collection` would be based on (its
+  // const_dense_source or the one from the parents) has a cheap mutable copy.
+  // Small updates then use the copy instead of a SparseSource overlay.
+  bool HasCheapMutableDenseCopy(const SourceCollection& collection,
+                                AllocationId alloc_id,
+                                absl::string_view attr) const;
+
   // Replaces `range` with `new_values_count` values (uninitialized).
   // Returns index of the first affected value.
   int64_t RemoveAndReserveInList(DataList& list, ListRange range,
@@ -829,21 +1207,36 @@ class DataBagImpl : public arolla::RefcountedBase {
   // parent_data_bag_ as a parent if available.
   DictVector& GetOrCreateMutableDicts(AllocationId alloc_id);
 
+  // Creates (if not yet created) the DictVectors for all allocations of
+  // `dicts`, so that they can be modified concurrently. Returns false if some
+  // of the dicts are not in big dict allocations.
+  bool GetMutableDictVectors(
+      const DataSliceImpl& dicts,
+      absl::flat_hash_map<AllocationId, DictVector*>& dict_vectors);
+
   // Like GetOrCreateMutableDicts, but also selects a Dict for `object_id`.
   Dict& GetOrCreateMutableDict(ObjectId object_id);
 
   void AddDictToContent(ObjectId dict_id, const Dict& dict,
                         std::vector<DataBagContent::DictContent>& res) const;
 
-  absl::flat_hash_map<SourceKey, SourceCollection, SourceKeyHashAndEq,
-                      SourceKeyHashAndEq>
-      sources_;
+  // Sources of big allocations, grouped by allocation, so that the attributes
+  // of a single allocation can be iterated without scanning the whole map.
+  absl::flat_hash_map<AllocationId, AllocSources> sources_;
   // Map `attribute -> SparseSource`. Each data source contains all small alloc
-  // objects for given attribute.
-  absl::flat_hash_map<std::string, SparseSource> small_alloc_sources_;
+  // objects for given attribute. node_hash_map keeps the SparseSources in
+  // place when other attributes are added, which the concurrent merge tasks
+  // rely on.
+  absl::node_hash_map<std::string, SparseSource> small_alloc_sources_;
 
   absl::flat_hash_map<AllocationId, std::shared_ptr<DataListVector>> lists_;
   absl::flat_hash_map<AllocationId, std::shared_ptr<DictVector>> dicts_;
+
+  // Ids of the schemas created by CreateUuSchemaFromFields, keyed by the
+  // fingerprint of its arguments in the order given. Lets repeated creation of
+  // the same list, dict or uu schema skip sorting and stable fingerprinting of
+  // the fields. The ids are deterministic, so the entries never get stale.
+  absl::flat_hash_map<arolla::Fingerprint, ObjectId> uu_schema_cache_;
 };
 
 }  // namespace koladata::internal
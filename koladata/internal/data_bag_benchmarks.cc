@@ -14,13 +14,17 @@
 //
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "benchmark/benchmark.h"
+#include "absl/base/no_destructor.h"
 #include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "koladata/internal/benchmark_helpers.h"
@@ -28,6 +32,7 @@
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/schema_utils.h"
 #include "koladata/internal/uuid_object.h"
@@ -281,6 +286,48 @@ BENCHMARK(BM_Int32AttributeDataBagSingleSource<BatchAccess>)
 BENCHMARK(BM_Int32AttributeDataBagSingleSource<PointwiseAccess>)
     ->Apply(kPointwiseBenchmarkPrimitiveBatchPairsFn);
 
+// Batch GetAttr of state.range(0) objects split into chunks looked up by
+// state.range(1) threads (0 means the sequential GetAttr). Half of the values
+// come from a fallback.
+void BM_ParallelGetAttr(benchmark::State& state) {
+  int64_t size = state.range(0);
+  int64_t num_threads = state.range(1);
+  auto ds = DataSliceImpl::AllocateEmptyObjects(size);
+  arolla::DenseArrayBuilder<int32_t> bldr(size);
+  for (int64_t i = 0; i < size; i += 2) {
+    bldr.Set(i, 57);
+  }
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  CHECK_OK(
+      db->SetAttr(ds, "a", DataSliceImpl::Create(std::move(bldr).Build())));
+  auto fb_db = DataBagImpl::CreateEmptyDatabag();
+  CHECK_OK(fb_db->SetAttr(ds, "a",
+                          DataSliceImpl::Create(arolla::CreateFullDenseArray(
+                              std::vector<int32_t>(size, 75)))));
+  std::vector<const DataBagImpl*> fallbacks = {fb_db.get()};
+
+  std::unique_ptr<ThreadPoolExecutor> executor;
+  if (num_threads > 0) {
+    executor = std::make_unique<ThreadPoolExecutor>(num_threads);
+  }
+  DataBagImpl::ParallelOptions options{.executor = executor.get(),
+                                       .min_chunk_size = 1 << 14};
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(ds);
+    DataSliceImpl ds_a_get = db->GetAttr(ds, "a", fallbacks, options).value();
+    benchmark::DoNotOptimize(ds_a_get);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK(BM_ParallelGetAttr)
+    ->ArgPair(1 << 20, 0)
+    ->ArgPair(1 << 20, 1)
+    ->ArgPair(1 << 20, 2)
+    ->ArgPair(1 << 20, 4)
+    ->ArgPair(1 << 20, 8)
+    ->UseRealTime();
+
 void BM_ObjAttributeDataBagSetToEmpty(benchmark::State& state) {
   int64_t batch_size = state.range(0);
   int64_t skip_size = state.range(1);
@@ -525,6 +572,33 @@ void BM_AppendToListsMixedType(benchmark::State& state) {
   BM_AppendToListsImpl(state, true);
 }
 
+// Builds `state.range(0)` lists of 20 items from a flat slice.
+void BM_ExtendListsFromFlatSlice(benchmark::State& state) {
+  constexpr int64_t kListSize = 20;
+  int64_t list_count = state.range(0);
+  std::vector<int64_t> split_points(list_count + 1);
+  for (int64_t i = 0; i <= list_count; ++i) {
+    split_points[i] = i * kListSize;
+  }
+  auto edge = arolla::DenseArrayEdge::FromSplitPoints(
+                  arolla::CreateFullDenseArray(split_points))
+                  .value();
+  DataSliceImpl values = DataSliceImpl::Create(
+      arolla::CreateConstDenseArray<int32_t>(list_count * kListSize, 57));
+  for (auto _ : state) {
+    state.PauseTiming();
+    auto db = DataBagImpl::CreateEmptyDatabag();
+    DataSliceImpl lists = DataSliceImpl::ObjectsFromAllocation(
+        AllocateLists(list_count), list_count);
+    state.ResumeTiming();
+    CHECK_OK(db->ExtendLists(lists, values, edge));
+    benchmark::DoNotOptimize(db);
+  }
+  state.SetItemsProcessed(state.iterations() * list_count * kListSize);
+}
+
+BENCHMARK(BM_ExtendListsFromFlatSlice)->Range(10, 1000000);
+
 BENCHMARK(BM_AppendToListSingleType);
 BENCHMARK(BM_AppendToListMixedType);
 
@@ -952,5 +1026,225 @@ BENCHMARK(BM_SetSchemaFields<SetFn>)
     ->ArgPair(100000, 7)
     ->ArgPair(10000, 1000);
 
+// A DataBag that is only read after the construction, shared by all the
+// threads of a benchmark.
+struct SharedReadOnlyDataBag {
+  static constexpr int64_t kSize = 10000;
+
+  SharedReadOnlyDataBag()
+      : objects(DataSliceImpl::AllocateEmptyObjects(kSize)),
+        db(DataBagImpl::CreateEmptyDatabag()) {
+    CHECK_OK(db->SetAttr(objects, "a",
+                         DataSliceImpl::AllocateEmptyObjects(kSize)));
+    items.assign(objects.begin(), objects.end());
+  }
+
+  DataSliceImpl objects;
+  std::vector<DataItem> items;
+  DataBagImplPtr db;
+};
+
+template <typename Access>
+void BM_GetAttrFromSharedDataBagInThreads(benchmark::State& state) {
+  static const absl::NoDestructor<SharedReadOnlyDataBag> shared;
+  const DataBagImpl& db = *shared->db;
+  while (state.KeepRunningBatch(SharedReadOnlyDataBag::kSize)) {
+    if constexpr (std::is_same_v<Access, BatchAccess>) {
+      DataSliceImpl ds_a_get = db.GetAttr(shared->objects, "a").value();
+      benchmark::DoNotOptimize(ds_a_get);
+    } else {
+      for (const DataItem& item : shared->items) {
+        auto get_attr = db.GetAttr(item, "a");
+        benchmark::DoNotOptimize(get_attr);
+      }
+    }
+  }
+}
+
+BENCHMARK(BM_GetAttrFromSharedDataBagInThreads<BatchAccess>)
+    ->ThreadRange(1, 32);
+BENCHMARK(BM_GetAttrFromSharedDataBagInThreads<PointwiseAccess>)
+    ->ThreadRange(1, 32);
+
+// Accessors for the benchmarks below, which run the same scenarios for
+// attributes, lists and dicts. Init stores a value for a container that was
+// never set before, Update overwrites it.
+struct AttrAccess {
+  static DataSliceImpl Allocate(int64_t size) {
+    return DataSliceImpl::AllocateEmptyObjects(size);
+  }
+  static absl::Status Init(DataBagImpl& db, const DataItem& obj, int value) {
+    return db.SetAttr(obj, "a", DataItem(value));
+  }
+  static absl::Status Update(DataBagImpl& db, const DataItem& obj, int value) {
+    return db.SetAttr(obj, "a", DataItem(value));
+  }
+  static absl::StatusOr<DataSliceImpl> Get(
+      const DataBagImpl& db, const DataSliceImpl& objs,
+      DataBagImpl::FallbackSpan fallbacks) {
+    return db.GetAttr(objs, "a", fallbacks);
+  }
+  static absl::StatusOr<DataItem> Get(const DataBagImpl& db,
+                                      const DataItem& obj,
+                                      DataBagImpl::FallbackSpan fallbacks) {
+    return db.GetAttr(obj, "a", fallbacks);
+  }
+};
+
+struct ListAccess {
+  static DataSliceImpl Allocate(int64_t size) {
+    return DataSliceImpl::ObjectsFromAllocation(AllocateLists(size), size);
+  }
+  static absl::Status Init(DataBagImpl& db, const DataItem& list, int value) {
+    return db.AppendToList(list, DataItem(value));
+  }
+  static absl::Status Update(DataBagImpl& db, const DataItem& list,
+                             int value) {
+    return db.SetInList(list, 0, DataItem(value));
+  }
+  static absl::StatusOr<DataSliceImpl> Get(
+      const DataBagImpl& db, const DataSliceImpl& lists,
+      DataBagImpl::FallbackSpan fallbacks) {
+    return db.GetFromLists(
+        lists, arolla::CreateConstDenseArray<int64_t>(lists.size(), 0),
+        fallbacks);
+  }
+  static absl::StatusOr<DataItem> Get(const DataBagImpl& db,
+                                      const DataItem& list,
+                                      DataBagImpl::FallbackSpan fallbacks) {
+    return db.GetFromList(list, 0, fallbacks);
+  }
+};
+
+struct DictAccess {
+  static DataSliceImpl Allocate(int64_t size) {
+    return DataSliceImpl::ObjectsFromAllocation(AllocateDicts(size), size);
+  }
+  static absl::Status Init(DataBagImpl& db, const DataItem& dict, int value) {
+    return db.SetInDict(dict, DataItem(1), DataItem(value));
+  }
+  static absl::Status Update(DataBagImpl& db, const DataItem& dict,
+                             int value) {
+    return db.SetInDict(dict, DataItem(1), DataItem(value));
+  }
+  static absl::StatusOr<DataSliceImpl> Get(
+      const DataBagImpl& db, const DataSliceImpl& dicts,
+      DataBagImpl::FallbackSpan fallbacks) {
+    return db.GetFromDict(
+        dicts,
+        DataSliceImpl::Create(arolla::CreateConstDenseArray<int>(
+            dicts.size(), 1)),
+        fallbacks);
+  }
+  static absl::StatusOr<DataItem> Get(const DataBagImpl& db,
+                                      const DataItem& dict,
+                                      DataBagImpl::FallbackSpan fallbacks) {
+    return db.GetFromDict(dict, DataItem(1), fallbacks);
+  }
+};
+
+constexpr int64_t kContainerCount = 1000;
+
+template <typename Container, typename Access>
+void RunContainerAccess(benchmark::State& state, const DataBagImpl& db,
+                        const DataSliceImpl& objs,
+                        DataBagImpl::FallbackSpan fallbacks) {
+  std::vector<DataItem> items(objs.begin(), objs.end());
+  while (state.KeepRunningBatch(objs.size())) {
+    if constexpr (std::is_same_v<Access, BatchAccess>) {
+      benchmark::DoNotOptimize(objs);
+      auto res = Container::Get(db, objs, fallbacks).value();
+      benchmark::DoNotOptimize(res);
+    } else {
+      benchmark::DoNotOptimize(items);
+      for (const DataItem& item : items) {
+        auto res = Container::Get(db, item, fallbacks);
+        benchmark::DoNotOptimize(res);
+      }
+    }
+  }
+}
+
+// Reads all containers through a chain of `state.range(0)` forks. Every fork
+// updates a single container, so the reads of most containers walk the whole
+// chain. `state.range(1)` is MaxForkDepth() (0 means unlimited).
+template <typename Container, typename Access>
+void BM_AccessThroughForkChain(benchmark::State& state) {
+  int64_t depth = state.range(0);
+  int64_t old_max_fork_depth = DataBagImpl::MaxForkDepth();
+  DataBagImpl::SetMaxForkDepth(state.range(1));
+
+  auto objs = Container::Allocate(kContainerCount);
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  for (int64_t i = 0; i < kContainerCount; ++i) {
+    CHECK_OK(Container::Init(*db, objs[i], i));
+  }
+  for (int64_t level = 0; level < depth; ++level) {
+    db = db->PartiallyPersistentFork();
+    CHECK_OK(Container::Update(*db, objs[level % kContainerCount], -level));
+  }
+  DataBagImpl::SetMaxForkDepth(old_max_fork_depth);
+
+  RunContainerAccess<Container, Access>(state, *db, objs, {});
+}
+
+void ForkChainArgs(benchmark::internal::Benchmark* b) {
+  for (int64_t depth : {1, 10, 100, 1000}) {
+    for (int64_t max_fork_depth :
+         {int64_t{0}, DataBagImpl::kDefaultMaxForkDepth}) {
+      b->ArgPair(depth, max_fork_depth);
+    }
+  }
+}
+
+BENCHMARK(BM_AccessThroughForkChain<AttrAccess, BatchAccess>)
+    ->Apply(ForkChainArgs);
+BENCHMARK(BM_AccessThroughForkChain<AttrAccess, PointwiseAccess>)
+    ->Apply(ForkChainArgs);
+BENCHMARK(BM_AccessThroughForkChain<ListAccess, BatchAccess>)
+    ->Apply(ForkChainArgs);
+BENCHMARK(BM_AccessThroughForkChain<ListAccess, PointwiseAccess>)
+    ->Apply(ForkChainArgs);
+BENCHMARK(BM_AccessThroughForkChain<DictAccess, BatchAccess>)
+    ->Apply(ForkChainArgs);
+BENCHMARK(BM_AccessThroughForkChain<DictAccess, PointwiseAccess>)
+    ->Apply(ForkChainArgs);
+
+// Reads all containers from an empty DataBag with `state.range(0)` fallbacks.
+// The containers are distributed round-robin between the fallbacks.
+template <typename Container, typename Access>
+void BM_AccessWithFallbacks(benchmark::State& state) {
+  int64_t fallback_count = state.range(0);
+
+  auto objs = Container::Allocate(kContainerCount);
+  std::vector<DataBagImplPtr> fallback_dbs(fallback_count);
+  for (auto& fallback_db : fallback_dbs) {
+    fallback_db = DataBagImpl::CreateEmptyDatabag();
+  }
+  for (int64_t i = 0; i < kContainerCount; ++i) {
+    CHECK_OK(Container::Init(*fallback_dbs[i % fallback_count], objs[i], i));
+  }
+  std::vector<const DataBagImpl*> fallbacks;
+  for (const auto& fallback_db : fallback_dbs) {
+    fallbacks.push_back(fallback_db.get());
+  }
+  auto db = DataBagImpl::CreateEmptyDatabag();
+
+  RunContainerAccess<Container, Access>(state, *db, objs, fallbacks);
+}
+
+BENCHMARK(BM_AccessWithFallbacks<AttrAccess, BatchAccess>)
+    ->Arg(1)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK(BM_AccessWithFallbacks<AttrAccess, PointwiseAccess>)
+    ->Arg(1)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK(BM_AccessWithFallbacks<ListAccess, BatchAccess>)
+    ->Arg(1)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK(BM_AccessWithFallbacks<ListAccess, PointwiseAccess>)
+    ->Arg(1)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK(BM_AccessWithFallbacks<DictAccess, BatchAccess>)
+    ->Arg(1)->Arg(2)->Arg(8)->Arg(32);
+BENCHMARK(BM_AccessWithFallbacks<DictAccess, PointwiseAccess>)
+    ->Arg(1)->Arg(2)->Arg(8)->Arg(32);
+
 }  // namespace
 }  // namespace koladata::internal
@@ -17,6 +17,7 @@
 #include <initializer_list>
 #include <optional>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -26,6 +27,7 @@
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/op_utils/expand.h"
 #include "arolla/dense_array/dense_array.h"
@@ -183,6 +185,119 @@ TEST(DataBagTest, Dicts) {
               IsOkAndHolds(DataItem()));
 }
 
+TEST(DataBagTest, GetFromDictInterleavedAllocs) {
+  // Lookups span several batches and alternate between allocations. Some of
+  // the dicts are large enough to be stored in a hash map.
+  constexpr int64_t kSize = 300;
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  std::array<AllocationId, 3> allocs = {AllocateDicts(kSize),
+                                        AllocateDicts(kSize),
+                                        AllocateDicts(kSize)};
+  arolla::DenseArrayBuilder<ObjectId> dicts_bldr(kSize);
+  arolla::DenseArrayBuilder<int64_t> int_keys_bldr(kSize);
+  arolla::DenseArrayBuilder<arolla::Text> text_keys_bldr(kSize);
+  std::vector<DataItem> expected(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    ObjectId dict = allocs[i % 3].ObjectByOffset(i);
+    for (int64_t k = 0; k < i % 20; ++k) {
+      ASSERT_OK(db->SetInDict(DataItem(dict), DataItem(k), DataItem(i * k)));
+    }
+    ASSERT_OK(
+        db->SetInDict(DataItem(dict), DataItem(arolla::Text("a")), DataItem(i)));
+    if (i % 7 != 0) {
+      dicts_bldr.Set(i, dict);
+    }
+    if (i % 2 == 0) {
+      int_keys_bldr.Set(i, i % 5);
+      if (i % 7 != 0 && i % 5 < i % 20) {
+        expected[i] = DataItem(i * (i % 5));
+      }
+    } else {
+      text_keys_bldr.Set(i, arolla::Text("a"));
+      if (i % 7 != 0) {
+        expected[i] = DataItem(i);
+      }
+    }
+  }
+  auto dicts = DataSliceImpl::Create(std::move(dicts_bldr).Build());
+  auto keys = DataSliceImpl::Create(std::move(int_keys_bldr).Build(),
+                                    std::move(text_keys_bldr).Build());
+  ASSERT_TRUE(keys.is_mixed_dtype());
+  EXPECT_THAT(db->GetFromDict(dicts, keys),
+              IsOkAndHolds(ElementsAreArray(expected)));
+
+  std::vector<DataItem> expected_a(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    if (i % 7 != 0) {
+      expected_a[i] = DataItem(i);
+    }
+  }
+  EXPECT_THAT(db->GetFromDict(dicts, DataSliceImpl::Create(
+                                         kSize, DataItem(arolla::Text("a")))),
+              IsOkAndHolds(ElementsAreArray(expected_a)));
+}
+
+TEST(DataBagTest, ParallelSetInDictAndClearDict) {
+  // The dicts span several DictVector pages, and every dict is updated many
+  // times, so the order of the updates matters.
+  constexpr int64_t kDictCount = 3000;
+  constexpr int64_t kSize = 20000;
+  AllocationId alloc = AllocateDicts(kDictCount);
+  arolla::DenseArrayBuilder<ObjectId> dicts_bldr(kSize);
+  arolla::DenseArrayBuilder<int64_t> int_keys_bldr(kSize);
+  std::vector<DataItem> mixed_keys(kSize);
+  arolla::DenseArrayBuilder<int64_t> values_bldr(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    if (i % 13 != 0) {
+      dicts_bldr.Set(i, alloc.ObjectByOffset(i * 7 % kDictCount));
+    }
+    int_keys_bldr.Set(i, i % 5);
+    mixed_keys[i] = i % 3 == 0 ? DataItem(arolla::Text("a")) : DataItem(i % 5);
+    if (i % 11 != 0) {
+      values_bldr.Set(i, i);
+    }
+  }
+  auto dicts = DataSliceImpl::Create(std::move(dicts_bldr).Build());
+  auto int_keys = DataSliceImpl::Create(std::move(int_keys_bldr).Build());
+  auto values = DataSliceImpl::Create(std::move(values_bldr).Build());
+  auto all_dicts = DataSliceImpl::ObjectsFromAllocation(alloc, kDictCount);
+  auto cleared_dicts = DataSliceImpl::ObjectsFromAllocation(alloc, 1500);
+
+  ThreadPoolExecutor executor(3);
+  DataBagImpl::ParallelOptions options{.executor = &executor,
+                                       .min_chunk_size = 100};
+  for (const DataSliceImpl& keys :
+       {int_keys, DataSliceImpl::Create(mixed_keys)}) {
+    auto expected_db = DataBagImpl::CreateEmptyDatabag();
+    ASSERT_OK(expected_db->SetInDict(dicts, keys, values));
+    auto db = DataBagImpl::CreateEmptyDatabag();
+    ASSERT_OK(db->SetInDict(dicts, keys, values, options));
+    for (const DataItem& key : {DataItem(int64_t{0}), DataItem(int64_t{3}),
+                                DataItem(arolla::Text("a"))}) {
+      auto lookup_keys = DataSliceImpl::Create(kDictCount, key);
+      ASSERT_OK_AND_ASSIGN(auto expected,
+                           expected_db->GetFromDict(all_dicts, lookup_keys));
+      EXPECT_THAT(db->GetFromDict(all_dicts, lookup_keys),
+                  IsOkAndHolds(ElementsAreArray(expected)));
+    }
+
+    ASSERT_OK(expected_db->ClearDict(cleared_dicts));
+    ASSERT_OK(db->ClearDict(cleared_dicts, options));
+    ASSERT_OK_AND_ASSIGN(auto expected_sizes,
+                         expected_db->GetDictSize(all_dicts));
+    EXPECT_THAT(db->GetDictSize(all_dicts),
+                IsOkAndHolds(ElementsAreArray(expected_sizes)));
+  }
+
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  EXPECT_THAT(
+      db->SetInDict(dicts, DataSliceImpl::Create(5, DataItem(1)), values,
+                    options),
+      StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(db->ClearDict(values, options),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
 TEST(DataBagTest, EmptyAndUnknownDicts) {
   auto db = DataBagImpl::CreateEmptyDatabag();
   auto empty = DataSliceImpl::CreateEmptyAndUnknownType(3);
@@ -18,6 +18,7 @@
 #include <numeric>
 #include <optional>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "gmock/gmock.h"
@@ -27,10 +28,12 @@
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/edge.h"
 #include "arolla/dense_array/qtype/types.h"
+#include "arolla/memory/optional_value.h"
 #include "arolla/qtype/base_types.h"
 #include "arolla/util/text.h"
 
@@ -145,6 +148,78 @@ TEST(DataBagTest, RemoveInLists) {
               IsOkAndHolds(ElementsAre(std::nullopt, 8)));
 }
 
+TEST(DataBagTest, RemoveInListsByIndices) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  AllocationId alloc_id = AllocateLists(2);
+  DataItem list0(alloc_id.ObjectByOffset(0));
+  DataItem list1(alloc_id.ObjectByOffset(1));
+  ASSERT_OK(db->ExtendList(list0, DataSliceImpl::Create(
+                                      arolla::CreateDenseArray<int>(
+                                          {0, 1, 2, 3, 4, 5}))));
+  ASSERT_OK(db->ExtendList(list1, DataSliceImpl::Create(
+                                      arolla::CreateDenseArray<int>({6, 7}))));
+
+  // The indices of the same list are removed one after another.
+  DataSliceImpl lists = DataSliceImpl::Create(
+      arolla::CreateDenseArray<ObjectId>(
+          {list0.value<ObjectId>(), list1.value<ObjectId>(),
+           list0.value<ObjectId>(), list0.value<ObjectId>(),
+           list0.value<ObjectId>(), std::nullopt}));
+  ASSERT_OK(db->RemoveInList(
+      lists, arolla::CreateDenseArray<int64_t>({0, -1, 0, 10, -1, 0})));
+  EXPECT_THAT(db->ExplodeList(list0), IsOkAndHolds(ElementsAre(2, 3, 4)));
+  EXPECT_THAT(db->ExplodeList(list1), IsOkAndHolds(ElementsAre(6)));
+}
+
+TEST(DataBagTest, RemoveInListsByIndicesParallel) {
+  constexpr int64_t kListCount = 100;
+  constexpr int64_t kListSize = 50;
+  AllocationId alloc_id = AllocateLists(kListCount);
+  DataSliceImpl all_lists =
+      DataSliceImpl::ObjectsFromAllocation(alloc_id, kListCount);
+  arolla::DenseArrayBuilder<ObjectId> lists_bldr(kListCount * 5);
+  arolla::DenseArrayBuilder<int64_t> indices_bldr(kListCount * 5);
+  std::vector<std::vector<int>> expected(kListCount);
+  for (int64_t i = 0; i < kListCount; ++i) {
+    expected[i].resize(kListSize);
+    std::iota(expected[i].begin(), expected[i].end(), 0);
+  }
+  for (int64_t i = 0; i < kListCount * 5; ++i) {
+    const int64_t list = (i * 7) % kListCount;
+    const int64_t index = (i * 13) % (kListSize + 10) - 5;
+    lists_bldr.Set(i, alloc_id.ObjectByOffset(list));
+    indices_bldr.Set(i, index);
+    std::vector<int>& values = expected[list];
+    const int64_t pos = index < 0 ? index + values.size() : index;
+    if (pos >= 0 && pos < values.size()) {
+      values.erase(values.begin() + pos);
+    }
+  }
+  auto lists = DataSliceImpl::Create(std::move(lists_bldr).Build());
+  auto indices = std::move(indices_bldr).Build();
+
+  ThreadPoolExecutor executor(3);
+  for (DataBagImpl::ParallelOptions options :
+       {DataBagImpl::ParallelOptions(),
+        DataBagImpl::ParallelOptions{.executor = &executor,
+                                     .min_chunk_size = 10}}) {
+    auto db = DataBagImpl::CreateEmptyDatabag();
+    for (int64_t i = 0; i < kListCount; ++i) {
+      std::vector<int> values(kListSize);
+      std::iota(values.begin(), values.end(), 0);
+      ASSERT_OK(db->ExtendList(
+          all_lists[i],
+          DataSliceImpl::Create(arolla::CreateFullDenseArray<int>(values))));
+    }
+    ASSERT_OK(db->RemoveInList(lists, indices, options));
+    for (int64_t i = 0; i < kListCount; ++i) {
+      EXPECT_THAT(db->ExplodeList(all_lists[i]),
+                  IsOkAndHolds(ElementsAreArray(expected[i])))
+          << i;
+    }
+  }
+}
+
 TEST(DataBagTest, SetAndGetInLists) {
   auto db = DataBagImpl::CreateEmptyDatabag();
   AllocationId alloc_id = AllocateLists(3);
@@ -218,6 +293,86 @@ TEST(DataBagTest, ExplodeLists) {
   }
 }
 
+TEST(DataBagTest, ExplodeSingleTypeLists) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  AllocationId alloc_id = AllocateLists(3);
+  DataSliceImpl lists = DataSliceImpl::ObjectsFromAllocation(alloc_id, 3);
+  auto values = arolla::CreateDenseArray<int>({1, 2, std::nullopt, 4, 5});
+  ASSERT_OK_AND_ASSIGN(auto edge,
+                       arolla::DenseArrayEdge::FromSplitPoints(
+                           arolla::CreateDenseArray<int64_t>({0, 2, 2, 5})));
+  ASSERT_OK(db->ExtendLists(lists, DataSliceImpl::Create(values), edge));
+
+  {
+    ASSERT_OK_AND_ASSIGN((auto [res, res_edge]), db->ExplodeLists(lists));
+    ASSERT_EQ(res.dtype(), arolla::GetQType<int>());
+    EXPECT_THAT(res, ElementsAre(1, 2, std::nullopt, 4, 5));
+    EXPECT_THAT(res_edge.edge_values(), ElementsAre(0, 2, 2, 5));
+  }
+  {  // A single list is returned without copying.
+    auto last_list = DataSliceImpl::Create(
+        arolla::CreateDenseArray<ObjectId>({alloc_id.ObjectByOffset(2)}));
+    ASSERT_OK_AND_ASSIGN(
+        (auto [res, res_edge]),
+        db->ExplodeLists(last_list, DataBagImpl::ListRange(1)));
+    EXPECT_THAT(res, ElementsAre(4, 5));
+    EXPECT_EQ(res.values<int>().values.span().data(),
+              values.values.span().data() + 3);
+  }
+  {  // Mixed types.
+    ASSERT_OK(db->AppendToList(lists[1], DataItem(arolla::Text("a"))));
+    ASSERT_OK_AND_ASSIGN((auto [res, res_edge]), db->ExplodeLists(lists));
+    EXPECT_THAT(res,
+                ElementsAre(1, 2, arolla::Text("a"), std::nullopt, 4, 5));
+    EXPECT_THAT(res_edge.edge_values(), ElementsAre(0, 2, 3, 6));
+  }
+}
+
+TEST(DataBagTest, GetFromSingleTypeLists) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  AllocationId alloc_id = AllocateLists(4);
+  DataSliceImpl lists = DataSliceImpl::ObjectsFromAllocation(alloc_id, 4);
+  auto values = arolla::CreateDenseArray<int>({1, 2, std::nullopt, 4, 5});
+  ASSERT_OK_AND_ASSIGN(auto edge,
+                       arolla::DenseArrayEdge::FromSplitPoints(
+                           arolla::CreateDenseArray<int64_t>({0, 2, 2, 5, 5})));
+  ASSERT_OK(db->ExtendLists(lists, DataSliceImpl::Create(values), edge));
+
+  {
+    ASSERT_OK_AND_ASSIGN(
+        auto res, db->GetFromLists(lists, arolla::CreateDenseArray<int64_t>(
+                                              {-1, 0, -3, 0})));
+    ASSERT_EQ(res.dtype(), arolla::GetQType<int>());
+    EXPECT_THAT(res, ElementsAre(2, std::nullopt, std::nullopt, std::nullopt));
+  }
+  {  // Out of range and missing indices.
+    ASSERT_OK_AND_ASSIGN(
+        auto res,
+        db->GetFromLists(lists, arolla::CreateDenseArray<int64_t>(
+                                    {2, std::nullopt, -4, std::nullopt})));
+    EXPECT_TRUE(res.is_empty_and_unknown());
+    EXPECT_EQ(res.size(), 4);
+  }
+  {  // Values of a fallback list of another type.
+    auto fb_db = DataBagImpl::CreateEmptyDatabag();
+    ASSERT_OK(fb_db->AppendToList(lists[1], DataItem(arolla::Text("a"))));
+    ASSERT_OK_AND_ASSIGN(
+        auto res,
+        db->GetFromLists(lists,
+                         arolla::CreateDenseArray<int64_t>({1, 0, 1, -1}),
+                         {fb_db.get()}));
+    EXPECT_THAT(res, ElementsAre(2, arolla::Text("a"), 4, std::nullopt));
+  }
+  {  // Mixed types in a single list.
+    ASSERT_OK(db->AppendToList(lists[2], DataItem(arolla::Text("b"))));
+    ASSERT_OK_AND_ASSIGN(
+        auto res, db->GetFromLists(lists, arolla::CreateDenseArray<int64_t>(
+                                              {0, 0, -1, 0})));
+    EXPECT_THAT(res, ElementsAre(1, std::nullopt, arolla::Text("b"),
+                                 std::nullopt));
+  }
+}
+
 TEST(DataBagTest, ExtendAndReplaceInLists) {
   auto db = DataBagImpl::CreateEmptyDatabag();
   AllocationId alloc_id = AllocateLists(3);
@@ -338,6 +493,52 @@ TEST(DataBagTest, ExtendAndReplaceInLists) {
               IsOkAndHolds(ElementsAre(9, 10, std::nullopt, std::nullopt)));
 }
 
+TEST(DataBagTest, ExtendListsFromFlatSlice) {
+  constexpr int64_t kListCount = 100;
+  constexpr int64_t kListSize = 3;
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  AllocationId alloc_id = AllocateLists(kListCount);
+  DataSliceImpl lists =
+      DataSliceImpl::ObjectsFromAllocation(alloc_id, kListCount);
+  std::vector<int64_t> split_points(kListCount + 1);
+  std::iota(split_points.begin(), split_points.end(), 0);
+  for (int64_t& split_point : split_points) {
+    split_point *= kListSize;
+  }
+  ASSERT_OK_AND_ASSIGN(auto edge,
+                       arolla::DenseArrayEdge::FromSplitPoints(
+                           arolla::CreateFullDenseArray(split_points)));
+  std::vector<int64_t> ints(kListCount * kListSize);
+  std::iota(ints.begin(), ints.end(), 0);
+  ASSERT_OK(db->ExtendLists(
+      lists, DataSliceImpl::Create(arolla::CreateFullDenseArray(ints)), edge));
+
+  // Mixed types.
+  std::vector<arolla::OptionalValue<int64_t>> mixed_ints(kListCount *
+                                                         kListSize);
+  std::vector<arolla::OptionalValue<arolla::Text>> mixed_texts(kListCount *
+                                                               kListSize);
+  for (int64_t i = 0; i < mixed_ints.size(); ++i) {
+    if (i % 2 == 0) {
+      mixed_ints[i] = i;
+    } else {
+      mixed_texts[i] = arolla::Text("x");
+    }
+  }
+  ASSERT_OK(db->ExtendLists(
+      lists,
+      DataSliceImpl::Create(arolla::CreateDenseArray<int64_t>(mixed_ints),
+                            arolla::CreateDenseArray<arolla::Text>(
+                                mixed_texts)),
+      edge));
+
+  EXPECT_THAT(db->ExplodeList(lists[0]),
+              IsOkAndHolds(ElementsAre(0, 1, 2, 0, arolla::Text("x"), 2)));
+  EXPECT_THAT(db->ExplodeList(lists[kListCount - 1]),
+              IsOkAndHolds(ElementsAre(297, 298, 299, arolla::Text("x"),
+                                       int64_t{298}, arolla::Text("x"))));
+}
+
 TEST(DataBagTest, ReplaceInListsEmptyAndUnknown) {
   auto db = DataBagImpl::CreateEmptyDatabag();
   AllocationId alloc_id = AllocateLists(3);
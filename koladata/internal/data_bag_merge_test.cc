@@ -35,9 +35,12 @@
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/schema_utils.h"
+#include "koladata/internal/sparse_source.h"
 #include "koladata/internal/uuid_object.h"
+#include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/qtype/types.h"
 #include "arolla/qtype/base_types.h"
 #include "arolla/util/bytes.h"
@@ -1113,5 +1116,166 @@ TEST(DataBagTest, MergeImplicitSchemas) {
   }
 }
 
+
+TEST(DataBagTest, ParallelMergeInplace) {
+  constexpr int64_t kAllocCount = 16;
+  constexpr int64_t kSize = 100;
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto db2 = DataBagImpl::CreateEmptyDatabag();
+  std::vector<DataSliceImpl> objs;
+  std::vector<ObjectId> lists;
+  std::vector<ObjectId> dicts;
+  for (int64_t i = 0; i < kAllocCount; ++i) {
+    objs.push_back(DataSliceImpl::AllocateEmptyObjects(kSize));
+    ASSERT_OK(db->SetAttr(objs.back(), "a",
+                          DataSliceImpl::Create(kSize, DataItem(int{1}))));
+    ASSERT_OK(db2->SetAttr(objs.back(), "b",
+                           DataSliceImpl::Create(kSize, DataItem(i))));
+    ASSERT_OK(db2->SetAttr(objs.back()[i], "a", DataItem(int{1})));
+    lists.push_back(AllocateLists(kSize).ObjectByOffset(i));
+    ASSERT_OK(db->AppendToList(DataItem(lists.back()), DataItem(i)));
+    ASSERT_OK(db2->AppendToList(DataItem(lists.back()), DataItem(i)));
+    dicts.push_back(AllocateDicts(kSize).ObjectByOffset(i));
+    ASSERT_OK(db->SetInDict(DataItem(dicts.back()), DataItem(i), DataItem(i)));
+    ASSERT_OK(
+        db2->SetInDict(DataItem(dicts.back()), DataItem(i + 1), DataItem(i)));
+  }
+
+  ThreadPoolExecutor executor(4);
+  DataBagImpl::ParallelOptions parallel_options{.executor = &executor};
+  for (MergeOptions options :
+       {MergeOptions(),
+        MergeOptions{.data_conflict_policy = MergeOptions::kOverwrite},
+        MergeOptions{.data_conflict_policy = MergeOptions::kKeepOriginal}}) {
+    auto expected = db->PartiallyPersistentFork();
+    ASSERT_OK(expected->MergeInplace(*db2, options));
+    auto res = db->PartiallyPersistentFork();
+    ASSERT_OK(res->MergeInplace(*db2, options, parallel_options));
+    for (int64_t i = 0; i < kAllocCount; ++i) {
+      for (absl::string_view attr : {"a", "b"}) {
+        ASSERT_OK_AND_ASSIGN(DataSliceImpl expected_values,
+                             expected->GetAttr(objs[i], attr));
+        EXPECT_THAT(res->GetAttr(objs[i], attr),
+                    IsOkAndHolds(ElementsAreArray(expected_values)));
+      }
+      ASSERT_OK_AND_ASSIGN(DataSliceImpl expected_list,
+                           expected->ExplodeList(DataItem(lists[i])));
+      EXPECT_THAT(res->ExplodeList(DataItem(lists[i])),
+                  IsOkAndHolds(ElementsAreArray(expected_list)));
+      for (int64_t key : {i, i + 1}) {
+        ASSERT_OK_AND_ASSIGN(
+            DataItem expected_value,
+            expected->GetFromDict(DataItem(dicts[i]), DataItem(key)));
+        EXPECT_THAT(res->GetFromDict(DataItem(dicts[i]), DataItem(key)),
+                    IsOkAndHolds(expected_value));
+      }
+    }
+  }
+
+  // Conflicts in several allocations: the same error as in the sequential
+  // merge is reported.
+  for (int64_t i = 0; i < kAllocCount; ++i) {
+    ASSERT_OK(db2->SetAttr(objs[i][0], "a", DataItem(int{2})));
+  }
+  absl::Status expected_status =
+      db->PartiallyPersistentFork()->MergeInplace(*db2, MergeOptions());
+  ASSERT_THAT(expected_status, StatusIs(absl::StatusCode::kFailedPrecondition,
+                                        HasSubstr("conflict")));
+  for (int attempt = 0; attempt < 10; ++attempt) {
+    EXPECT_EQ(db->PartiallyPersistentFork()->MergeInplace(
+                  *db2, MergeOptions(), parallel_options),
+              expected_status);
+  }
+}
+
+TEST(DataBagTest, ParallelMergeInplacePartitionedSmallAllocs) {
+  // Enough small alloc objects for the SparseSource of "a" to be partitioned
+  // and merged by several tasks.
+  constexpr int64_t kSize = SparseSource::kSmallAllocPartitionThreshold + 10;
+  std::vector<ObjectId> objs(kSize);
+  AllocateSingleObjects(absl::MakeSpan(objs));
+  auto objs_slice =
+      DataSliceImpl::Create(arolla::CreateFullDenseArray<ObjectId>(objs));
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto db2 = DataBagImpl::CreateEmptyDatabag();
+  for (int64_t i = 0; i < kSize; ++i) {
+    ASSERT_OK(db2->SetAttr(DataItem(objs[i]), "a", DataItem(i)));
+    if (i % 3 == 0) {
+      ASSERT_OK(db->SetAttr(DataItem(objs[i]), "a", DataItem(i)));
+    }
+  }
+
+  ThreadPoolExecutor executor(4);
+  DataBagImpl::ParallelOptions parallel_options{.executor = &executor};
+  for (MergeOptions options :
+       {MergeOptions(),
+        MergeOptions{.data_conflict_policy = MergeOptions::kOverwrite},
+        MergeOptions{.data_conflict_policy = MergeOptions::kKeepOriginal}}) {
+    auto expected = db->PartiallyPersistentFork();
+    ASSERT_OK(expected->MergeInplace(*db2, options));
+    auto res = db->PartiallyPersistentFork();
+    ASSERT_OK(res->MergeInplace(*db2, options, parallel_options));
+    ASSERT_OK_AND_ASSIGN(DataSliceImpl expected_values,
+                         expected->GetAttr(objs_slice, "a"));
+    EXPECT_THAT(res->GetAttr(objs_slice, "a"),
+                IsOkAndHolds(ElementsAreArray(expected_values)));
+  }
+
+  ASSERT_OK(db->SetAttr(DataItem(objs[3]), "a", DataItem(-1)));
+  absl::Status expected_status =
+      db->PartiallyPersistentFork()->MergeInplace(*db2, MergeOptions());
+  ASSERT_THAT(expected_status, StatusIs(absl::StatusCode::kFailedPrecondition,
+                                        HasSubstr("conflict")));
+  EXPECT_EQ(db->PartiallyPersistentFork()->MergeInplace(*db2, MergeOptions(),
+                                                        parallel_options),
+            expected_status);
+}
+
+TEST(DataBagTest, MergeInplaceDisjointKeys) {
+  constexpr int64_t kSize = 100;
+  AllocationId alloc = Allocate(kSize);
+  auto objs = DataSliceImpl::ObjectsFromAllocation(alloc, kSize);
+  DataItem list(AllocateLists(kSize).ObjectByOffset(0));
+  DataItem dict(AllocateDicts(kSize).ObjectByOffset(0));
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(objs, "a", DataSliceImpl::Create(kSize, DataItem(1))));
+  auto db2 = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db2->SetAttrForEntireAllocation(
+      alloc, "b", DataSliceImpl::Create(kSize, DataItem(2))));
+  ASSERT_OK(db2->AppendToList(list, DataItem(3)));
+  ASSERT_OK(db2->SetInDict(dict, DataItem(4), DataItem(5)));
+
+  auto res = db->PartiallyPersistentFork();
+  ASSERT_OK(res->MergeInplace(*db2, MergeOptions()));
+  // The data of the disjoint keys is shared, but modifying either DataBagImpl
+  // doesn't affect the other one.
+  ASSERT_OK(db2->SetAttr(objs[0], "b", DataItem(-2)));
+  ASSERT_OK(db2->AppendToList(list, DataItem(-3)));
+  ASSERT_OK(db2->SetInDict(dict, DataItem(4), DataItem(-5)));
+  ASSERT_OK(res->SetAttr(objs[1], "b", DataItem(20)));
+  ASSERT_OK(res->AppendToList(list, DataItem(30)));
+  ASSERT_OK(res->SetInDict(dict, DataItem(40), DataItem(50)));
+
+  EXPECT_THAT(res->GetAttr(objs[0], "a"), IsOkAndHolds(DataItem(1)));
+  EXPECT_THAT(res->GetAttr(objs[0], "b"), IsOkAndHolds(DataItem(2)));
+  EXPECT_THAT(res->GetAttr(objs[1], "b"), IsOkAndHolds(DataItem(20)));
+  EXPECT_THAT(res->ExplodeList(list),
+              IsOkAndHolds(ElementsAreArray({DataItem(3), DataItem(30)})));
+  EXPECT_THAT(res->GetFromDict(dict, DataItem(4)), IsOkAndHolds(DataItem(5)));
+  EXPECT_THAT(res->GetFromDict(dict, DataItem(40)), IsOkAndHolds(DataItem(50)));
+
+  EXPECT_THAT(db2->GetAttr(objs[0], "b"), IsOkAndHolds(DataItem(-2)));
+  EXPECT_THAT(db2->GetAttr(objs[1], "b"), IsOkAndHolds(DataItem(2)));
+  EXPECT_THAT(db2->ExplodeList(list),
+              IsOkAndHolds(ElementsAreArray({DataItem(3), DataItem(-3)})));
+  EXPECT_THAT(db2->GetFromDict(dict, DataItem(4)), IsOkAndHolds(DataItem(-5)));
+  EXPECT_THAT(db2->GetFromDict(dict, DataItem(40)), IsOkAndHolds(DataItem()));
+
+  // Overlapping keys are still checked for conflicts.
+  EXPECT_THAT(res->MergeInplace(*db2, MergeOptions()),
+              StatusIs(absl::StatusCode::kFailedPrecondition,
+                       HasSubstr("conflict")));
+}
+
 }  // namespace
 }  // namespace koladata::internal
@@ -558,6 +558,36 @@ TEST(DataBagTest, CreateUuSchemaFromFields) {
                                  " schemas, got: 42")));
 }
 
+TEST(DataBagTest, CreateUuSchemaFromFieldsRepeated) {
+  auto db = internal::DataBagImpl::CreateEmptyDatabag();
+  std::vector<absl::string_view> attrs{"a", "b"};
+  auto int_s = GetIntSchema();
+  auto float_s = GetFloatSchema();
+  std::vector<std::reference_wrapper<const DataItem>> items{std::cref(int_s),
+                                                            std::cref(float_s)};
+  ASSERT_OK_AND_ASSIGN(auto schema,
+                       db->CreateUuSchemaFromFields("", attrs, items));
+  ASSERT_OK_AND_ASSIGN(auto same_schema,
+                       db->CreateUuSchemaFromFields("", attrs, items));
+  EXPECT_THAT(same_schema, IsEquivalentTo(schema));
+
+  // The fields modified in between are written again.
+  ASSERT_OK(db->DelSchemaAttr(schema, "a"));
+  ASSERT_OK(db->SetSchemaAttr(schema, "b", int_s));
+  ASSERT_OK_AND_ASSIGN(same_schema,
+                       db->CreateUuSchemaFromFields("", attrs, items));
+  EXPECT_THAT(same_schema, IsEquivalentTo(schema));
+  EXPECT_THAT(db->GetSchemaAttr(schema, "a"), IsOkAndHolds(int_s));
+  EXPECT_THAT(db->GetSchemaAttr(schema, "b"), IsOkAndHolds(float_s));
+
+  // A fork sees the fields of the parent.
+  auto fork = db->PartiallyPersistentFork();
+  ASSERT_OK_AND_ASSIGN(auto fork_schema,
+                       fork->CreateUuSchemaFromFields("", attrs, items));
+  EXPECT_THAT(fork_schema, IsEquivalentTo(schema));
+  EXPECT_THAT(fork->GetSchemaAttr(schema, "b"), IsOkAndHolds(float_s));
+}
+
 TEST(DataBagTest, OverwriteSchemaFields) {
   auto db = internal::DataBagImpl::CreateEmptyDatabag();
 
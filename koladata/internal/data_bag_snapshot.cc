@@ -0,0 +1,52 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/data_bag_snapshot.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "absl/synchronization/mutex.h"
+#include "koladata/internal/data_bag.h"
+
+namespace koladata::internal {
+
+DataBagSnapshotPublisher::DataBagSnapshotPublisher(DataBagImplPtr db)
+    : current_(db->PartiallyPersistentFork()),
+      snapshot_(DataBagImplConstPtr::NewRef(db.get())) {}
+
+void DataBagSnapshotPublisher::Publish() {
+  DataBagImplConstPtr snapshot = DataBagImplConstPtr::NewRef(current_.get());
+  // Forked before the swap, so the possible squash of the chain doesn't
+  // happen under the lock.
+  current_ = snapshot->PartiallyPersistentFork();
+  {
+    absl::MutexLock lock(&mutex_);
+    std::swap(snapshot_, snapshot);
+    ++version_;
+  }
+  // The previous snapshot is released outside of the lock.
+}
+
+DataBagImplConstPtr DataBagSnapshotPublisher::Snapshot() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return snapshot_;
+}
+
+int64_t DataBagSnapshotPublisher::version() const {
+  absl::ReaderMutexLock lock(&mutex_);
+  return version_;
+}
+
+}  // namespace koladata::internal
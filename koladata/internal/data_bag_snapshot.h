@@ -0,0 +1,77 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_DATA_BAG_SNAPSHOT_H_
+#define KOLADATA_INTERNAL_DATA_BAG_SNAPSHOT_H_
+
+#include <cstdint>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/synchronization/mutex.h"
+#include "koladata/internal/data_bag.h"
+
+namespace koladata::internal {
+
+// Lets a single writer thread modify a DataBagImpl while any number of reader
+// threads read consistent snapshots of it.
+//
+// The writer modifies mutable_bag() and calls Publish() to make the changes
+// visible. Publish() freezes the bag and continues writing into its
+// PartiallyPersistentFork, so a published snapshot is never modified again
+// and can be read concurrently without locks. Publishing is O(1), except
+// that every DataBagImpl::MaxForkDepth() publishes the chain of snapshots is
+// squashed on the writer thread. A snapshot is destroyed when neither the
+// readers nor the newer snapshots (through the parent chain) reference it.
+//
+// Readers never wait for the writer: Snapshot() only takes a reference to the
+// latest published DataBagImpl.
+class DataBagSnapshotPublisher {
+ public:
+  // Publishes `db` as the initial snapshot. `db` must not be modified
+  // afterwards.
+  explicit DataBagSnapshotPublisher(
+      DataBagImplPtr db = DataBagImpl::CreateEmptyDatabag());
+
+  DataBagSnapshotPublisher(const DataBagSnapshotPublisher&) = delete;
+  DataBagSnapshotPublisher& operator=(const DataBagSnapshotPublisher&) =
+      delete;
+
+  // Returns the bag with the unpublished changes. Must be used only by the
+  // writer thread.
+  DataBagImpl& mutable_bag() { return *current_; }
+
+  // Makes the changes done in mutable_bag() visible to the readers. Must be
+  // called only by the writer thread. The reference previously returned by
+  // mutable_bag() must not be used afterwards.
+  void Publish();
+
+  // Returns the latest published snapshot. Thread-safe.
+  DataBagImplConstPtr Snapshot() const;
+
+  // Returns the number of Publish() calls so far. Thread-safe.
+  int64_t version() const;
+
+ private:
+  // Accessed only by the writer thread.
+  DataBagImplPtr current_;
+
+  // Held only to copy or swap the pointer.
+  mutable absl::Mutex mutex_;
+  DataBagImplConstPtr snapshot_ ABSL_GUARDED_BY(mutex_);
+  int64_t version_ ABSL_GUARDED_BY(mutex_) = 0;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_DATA_BAG_SNAPSHOT_H_
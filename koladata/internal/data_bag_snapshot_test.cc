@@ -0,0 +1,143 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/data_bag_snapshot.h"
+
+#include <atomic>
+#include <cstdint>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+
+TEST(DataBagSnapshotPublisherTest, Basic) {
+  ObjectId obj = AllocateSingleObject();
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(DataItem(obj), "a", DataItem(1)));
+  DataBagSnapshotPublisher publisher(db);
+  EXPECT_EQ(publisher.version(), 0);
+
+  DataBagImplConstPtr snapshot0 = publisher.Snapshot();
+  EXPECT_EQ(snapshot0.get(), db.get());
+
+  ASSERT_OK(publisher.mutable_bag().SetAttr(DataItem(obj), "a", DataItem(2)));
+  // Not published yet.
+  EXPECT_THAT(publisher.Snapshot()->GetAttr(DataItem(obj), "a"),
+              IsOkAndHolds(DataItem(1)));
+
+  publisher.Publish();
+  EXPECT_EQ(publisher.version(), 1);
+  DataBagImplConstPtr snapshot1 = publisher.Snapshot();
+  EXPECT_THAT(snapshot1->GetAttr(DataItem(obj), "a"),
+              IsOkAndHolds(DataItem(2)));
+
+  ASSERT_OK(publisher.mutable_bag().SetAttr(DataItem(obj), "a", DataItem(3)));
+  publisher.Publish();
+  EXPECT_THAT(publisher.Snapshot()->GetAttr(DataItem(obj), "a"),
+              IsOkAndHolds(DataItem(3)));
+  // The older snapshots are not affected.
+  EXPECT_THAT(snapshot0->GetAttr(DataItem(obj), "a"),
+              IsOkAndHolds(DataItem(1)));
+  EXPECT_THAT(snapshot1->GetAttr(DataItem(obj), "a"),
+              IsOkAndHolds(DataItem(2)));
+}
+
+TEST(DataBagSnapshotPublisherTest, ForkDepthIsBounded) {
+  const int64_t old_max_depth = DataBagImpl::MaxForkDepth();
+  DataBagImpl::SetMaxForkDepth(4);
+  ObjectId obj = AllocateSingleObject();
+  DataBagSnapshotPublisher publisher;
+  for (int i = 0; i < 20; ++i) {
+    ASSERT_OK(publisher.mutable_bag().SetAttr(DataItem(obj), "a", DataItem(i)));
+    publisher.Publish();
+    EXPECT_LE(publisher.Snapshot()->fork_depth(), 4);
+    EXPECT_THAT(publisher.Snapshot()->GetAttr(DataItem(obj), "a"),
+                IsOkAndHolds(DataItem(i)));
+  }
+  DataBagImpl::SetMaxForkDepth(old_max_depth);
+}
+
+TEST(DataBagSnapshotPublisherTest, ConcurrentReaders) {
+  constexpr int64_t kSize = 100;
+  constexpr int kUpdates = 200;
+  AllocationId alloc = Allocate(kSize);
+  arolla::DenseArrayBuilder<ObjectId> objects_bldr(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    objects_bldr.Set(i, alloc.ObjectByOffset(i));
+  }
+  auto objects = DataSliceImpl::Create(std::move(objects_bldr).Build());
+  auto values = [&](int value) {
+    return DataSliceImpl::Create(
+        arolla::CreateConstDenseArray<int>(kSize, value));
+  };
+
+  DataBagSnapshotPublisher publisher;
+  ASSERT_OK(publisher.mutable_bag().SetAttr(objects, "a", values(0)));
+  ASSERT_OK(publisher.mutable_bag().SetAttr(objects, "b", values(0)));
+  publisher.Publish();
+
+  std::atomic<bool> done = false;
+  std::atomic<int64_t> failures = 0;
+  std::vector<std::thread> readers;
+  for (int t = 0; t < 4; ++t) {
+    readers.emplace_back([&] {
+      int64_t last_version = 0;
+      while (!done.load()) {
+        int64_t version = publisher.version();
+        DataBagImplConstPtr snapshot = publisher.Snapshot();
+        if (version < last_version) {
+          ++failures;
+        }
+        last_version = version;
+        // Both attributes are updated together, so a snapshot must always
+        // have equal values.
+        auto a = snapshot->GetAttr(objects, "a");
+        auto b = snapshot->GetAttr(objects, "b");
+        if (!a.ok() || !b.ok() || !a->IsEquivalentTo(*b) ||
+            a->present_count() != kSize) {
+          ++failures;
+        }
+      }
+    });
+  }
+  for (int i = 1; i <= kUpdates; ++i) {
+    ASSERT_OK(publisher.mutable_bag().SetAttr(objects, "a", values(i)));
+    ASSERT_OK(publisher.mutable_bag().SetAttr(objects, "b", values(i)));
+    publisher.Publish();
+  }
+  done = true;
+  for (auto& reader : readers) {
+    reader.join();
+  }
+  EXPECT_EQ(failures.load(), 0);
+  EXPECT_EQ(publisher.version(), kUpdates + 1);
+  EXPECT_THAT(publisher.Snapshot()->GetAttr(DataItem(alloc.ObjectByOffset(0)),
+                                            "a"),
+              IsOkAndHolds(DataItem(kUpdates)));
+}
+
+}  // namespace
+}  // namespace koladata::internal
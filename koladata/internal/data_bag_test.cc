@@ -27,11 +27,16 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/cleanup/cleanup.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "koladata/internal/access_profile.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/testing/matchers.h"
 #include "koladata/internal/uuid_object.h"
@@ -113,6 +118,434 @@ TEST(DataBagTest, DeepChainOfForks) {
   }
 }
 
+TEST(DataBagTest, ForkDepthIsBounded) {
+  constexpr int64_t kMaxForkDepth = 5;
+  int64_t old_max_fork_depth = DataBagImpl::MaxForkDepth();
+  DataBagImpl::SetMaxForkDepth(kMaxForkDepth);
+  absl::Cleanup restore = [&] {
+    DataBagImpl::SetMaxForkDepth(old_max_fork_depth);
+  };
+
+  auto obj = DataItem(AllocateSingleObject());
+  auto list = DataItem(AllocateSingleList());
+  auto dict = DataItem(AllocateSingleDict());
+  auto ds = DataSliceImpl::AllocateEmptyObjects(3);
+
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  for (int i = 0; i < 3 * kMaxForkDepth; ++i) {
+    ASSERT_OK(db->SetAttr(obj, absl::StrCat("a", i), DataItem(i)));
+    ASSERT_OK(db->AppendToList(list, DataItem(i)));
+    ASSERT_OK(db->SetInDict(dict, DataItem(i), DataItem(-i)));
+    ASSERT_OK(db->SetAttr(DataItem(ds.values<ObjectId>()[i % 3].value),
+                          "b", DataItem(i)));
+    db = db->PartiallyPersistentFork();
+    EXPECT_LE(db->fork_depth(), kMaxForkDepth);
+  }
+  for (int i = 0; i < 3 * kMaxForkDepth; ++i) {
+    EXPECT_THAT(db->GetAttr(obj, absl::StrCat("a", i)),
+                IsOkAndHolds(DataItem(i)));
+    EXPECT_THAT(db->GetFromDict(dict, DataItem(i)),
+                IsOkAndHolds(DataItem(-i)));
+  }
+  EXPECT_THAT(db->GetListSize(list), IsOkAndHolds(DataItem(3 * kMaxForkDepth)));
+  EXPECT_THAT(db->GetAttr(ds, "b"),
+              IsOkAndHolds(ElementsAre(DataItem(12), DataItem(13),
+                                       DataItem(14))));
+
+  // Attributes of big allocations: a dense source shared with the squashed
+  // chain and sparse values spread over several layers.
+  constexpr int64_t kBigSize = 1000;
+  AllocationId big_alloc = Allocate(kBigSize);
+  auto big_objs = DataSliceImpl::ObjectsFromAllocation(big_alloc, kBigSize);
+  ASSERT_OK(db->SetAttrForEntireAllocation(
+      big_alloc, "dense", DataSliceImpl::Create(kBigSize, DataItem(7))));
+  auto first_layer = db;
+  for (int i = 0; i < 3 * kMaxForkDepth; ++i) {
+    db = db->PartiallyPersistentFork();
+    ASSERT_OK(db->SetAttr(big_objs[i], "sparse", DataItem(i)));
+    EXPECT_LE(db->fork_depth(), kMaxForkDepth);
+  }
+  ASSERT_OK(db->SetAttr(big_objs[0], "dense", DataItem(-7)));
+  EXPECT_THAT(db->GetAttr(big_objs[0], "dense"), IsOkAndHolds(DataItem(-7)));
+  EXPECT_THAT(db->GetAttr(big_objs[1], "dense"), IsOkAndHolds(DataItem(7)));
+  EXPECT_THAT(first_layer->GetAttr(big_objs[0], "dense"),
+              IsOkAndHolds(DataItem(7)));
+  for (int i = 0; i < 3 * kMaxForkDepth; ++i) {
+    EXPECT_THAT(db->GetAttr(big_objs[i], "sparse"), IsOkAndHolds(DataItem(i)));
+  }
+  EXPECT_THAT(db->GetAttr(big_objs[3 * kMaxForkDepth], "sparse"),
+              IsOkAndHolds(DataItem()));
+
+  DataBagImpl::SetMaxForkDepth(0);
+  for (int i = 0; i < 3 * kMaxForkDepth; ++i) {
+    ASSERT_OK(db->SetAttr(obj, "a", DataItem(i)));
+    db = db->PartiallyPersistentFork();
+  }
+  EXPECT_GT(db->fork_depth(), kMaxForkDepth);
+}
+
+TEST(DataBagTest, ParallelGetAttr) {
+  constexpr int64_t kAllocSize = 100;
+  AllocationId alloc_a = Allocate(kAllocSize);
+  AllocationId alloc_b = Allocate(kAllocSize);
+  std::vector<DataItem> objects;
+  std::vector<DataItem> values;
+  for (int64_t i = 0; i < kAllocSize; ++i) {
+    objects.push_back(DataItem(alloc_a.ObjectByOffset(i)));
+    values.push_back(i % 3 == 0 ? DataItem() : DataItem(static_cast<int>(i)));
+    objects.push_back(DataItem(alloc_b.ObjectByOffset(i)));
+    values.push_back(DataItem(arolla::Text("b")));
+  }
+  objects.push_back(DataItem());
+  values.push_back(DataItem());
+  objects.push_back(DataItem(AllocateSingleObject()));
+  values.push_back(DataItem(1.5f));
+  auto ds = DataSliceImpl::Create(objects);
+  auto ds_values = DataSliceImpl::Create(values);
+
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(ds, "a", ds_values));
+  auto fb_db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(fb_db->SetAttr(
+      ds, "a",
+      DataSliceImpl::Create(arolla::CreateConstDenseArray<int64_t>(ds.size(),
+                                                                   57))));
+
+  ThreadPoolExecutor executor(3);
+  DataBagImpl::ParallelOptions options{.executor = &executor,
+                                       .min_chunk_size = 7};
+  std::vector<const DataBagImpl*> fb_bags = {fb_db.get()};
+  for (DataBagImpl::FallbackSpan fallbacks :
+       {DataBagImpl::FallbackSpan{}, DataBagImpl::FallbackSpan(fb_bags)}) {
+    ASSERT_OK_AND_ASSIGN(auto expected, db->GetAttr(ds, "a", fallbacks));
+    EXPECT_THAT(db->GetAttr(ds, "a", fallbacks, options),
+                IsOkAndHolds(IsEquivalentTo(expected)));
+  }
+
+  // Chunks that span several bitmap words and end in the middle of one.
+  {
+    constexpr int64_t kSize = 1000;
+    auto big_ds = DataSliceImpl::AllocateEmptyObjects(kSize);
+    arolla::DenseArrayBuilder<int64_t> bldr(kSize);
+    for (int64_t i = 0; i < kSize; i += 3) {
+      bldr.Set(i, i);
+    }
+    ASSERT_OK(db->SetAttr(big_ds, "b",
+                          DataSliceImpl::Create(std::move(bldr).Build())));
+    ASSERT_OK(fb_db->SetAttr(big_ds, "b",
+                             DataSliceImpl::Create(
+                                 arolla::CreateConstDenseArray<float>(
+                                     kSize, 0.5f))));
+    DataBagImpl::ParallelOptions big_options{.executor = &executor,
+                                             .min_chunk_size = 100};
+    ASSERT_OK_AND_ASSIGN(auto expected,
+                         db->GetAttr(big_ds, "b", fb_bags));
+    EXPECT_THAT(db->GetAttr(big_ds, "b", fb_bags, big_options),
+                IsOkAndHolds(IsEquivalentTo(expected)));
+  }
+
+  // No executor.
+  EXPECT_THAT(db->GetAttr(ds, "a", {}, DataBagImpl::ParallelOptions{}),
+              IsOkAndHolds(IsEquivalentTo(ds_values)));
+  EXPECT_THAT(db->GetAttr(ds_values, "a", {}, options),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(DataBagTest, GetAttrs) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto db_f1 = DataBagImpl::CreateEmptyDatabag();
+  auto db_f2 = DataBagImpl::CreateEmptyDatabag();
+  auto ds = DataSliceImpl::AllocateEmptyObjects(4);
+  ASSERT_OK(db->SetAttr(
+      ds, "a",
+      DataSliceImpl::Create(
+          arolla::CreateDenseArray<int>({1, std::nullopt, 3, std::nullopt}))));
+  ASSERT_OK(db_f1->SetAttr(
+      ds, "a",
+      DataSliceImpl::Create(
+          arolla::CreateDenseArray<int>({5, 6, std::nullopt, std::nullopt}))));
+  ASSERT_OK(db_f2->SetAttr(
+      ds, "a",
+      DataSliceImpl::Create(arolla::CreateDenseArray<int>({7, 7, 7, 7}))));
+  ASSERT_OK(db_f1->SetAttr(
+      ds, "b",
+      DataSliceImpl::Create(arolla::CreateDenseArray<arolla::Text>(
+          {arolla::Text("x"), std::nullopt, std::nullopt,
+           arolla::Text("y")}))));
+  std::vector<absl::string_view> attrs = {"a", "b", "c", "a"};
+  ASSERT_OK_AND_ASSIGN(auto results,
+                       db->GetAttrs(ds, attrs, {db_f1.get(), db_f2.get()}));
+  ASSERT_EQ(results.size(), attrs.size());
+  for (size_t i = 0; i < attrs.size(); ++i) {
+    EXPECT_THAT(results[i],
+                IsEquivalentTo(*db->GetAttr(ds, attrs[i],
+                                            {db_f1.get(), db_f2.get()})))
+        << attrs[i];
+  }
+  EXPECT_THAT(results[0].values<int>(), ElementsAre(1, 6, 3, 7));
+
+  EXPECT_THAT(db->GetAttrs(DataSliceImpl::CreateEmptyAndUnknownType(3), attrs),
+              IsOkAndHolds(ElementsAre(
+                  IsEquivalentTo(DataSliceImpl::CreateEmptyAndUnknownType(3)),
+                  IsEquivalentTo(DataSliceImpl::CreateEmptyAndUnknownType(3)),
+                  IsEquivalentTo(DataSliceImpl::CreateEmptyAndUnknownType(3)),
+                  IsEquivalentTo(
+                      DataSliceImpl::CreateEmptyAndUnknownType(3)))));
+  EXPECT_THAT(
+      db->GetAttrs(DataSliceImpl::Create(arolla::CreateDenseArray<int>({1})),
+                   attrs),
+      StatusIs(absl::StatusCode::kFailedPrecondition,
+               HasSubstr("getting attributes of primitives is not allowed")));
+}
+
+TEST(DataBagTest, GetAttrPath) {
+  constexpr int64_t kSize = 3 * DataBagImpl::kGetAttrPathChunkSize + 5;
+  auto ds_a = DataSliceImpl::AllocateEmptyObjects(kSize);
+  auto ds_b = DataSliceImpl::AllocateEmptyObjects(kSize);
+  std::vector<DataItem> next;
+  std::vector<DataItem> values;
+  std::vector<DataItem> fb_values;
+  for (int64_t i = 0; i < kSize; ++i) {
+    next.push_back(i % 5 == 0 ? DataItem() : ds_b[(i * 7919) % kSize]);
+    values.push_back(i % 3 == 0 ? DataItem() : DataItem(static_cast<int>(i)));
+    fb_values.push_back(DataItem(-1));
+  }
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(ds_a, "next", DataSliceImpl::Create(next)));
+  ASSERT_OK(db->SetAttr(ds_b, "value", DataSliceImpl::Create(values)));
+  auto fb_db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(fb_db->SetAttr(ds_b, "value", DataSliceImpl::Create(fb_values)));
+
+  std::vector<const DataBagImpl*> fb_bags = {fb_db.get()};
+  std::vector<absl::string_view> path = {"next", "value"};
+  for (DataBagImpl::FallbackSpan fallbacks :
+       {DataBagImpl::FallbackSpan{}, DataBagImpl::FallbackSpan(fb_bags)}) {
+    ASSERT_OK_AND_ASSIGN(auto next_ds, db->GetAttr(ds_a, "next", fallbacks));
+    ASSERT_OK_AND_ASSIGN(auto expected,
+                         db->GetAttr(next_ds, "value", fallbacks));
+    EXPECT_THAT(db->GetAttrPath(ds_a, path, fallbacks),
+                IsOkAndHolds(IsEquivalentTo(expected)));
+  }
+
+  EXPECT_THAT(db->GetAttrPath(ds_a, {}), IsOkAndHolds(IsEquivalentTo(ds_a)));
+  EXPECT_THAT(db->GetAttrPath(ds_a, {"missing", "value"}),
+              IsOkAndHolds(IsEquivalentTo(
+                  DataSliceImpl::CreateEmptyAndUnknownType(kSize))));
+  EXPECT_THAT(
+      db->GetAttrPath(ds_a, {"next", "value", "next"}),
+      StatusIs(absl::StatusCode::kFailedPrecondition,
+               HasSubstr("getting attributes of primitives is not allowed")));
+}
+
+TEST(DataBagTest, GetAttrPreHashed) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto db_f = DataBagImpl::CreateEmptyDatabag();
+  auto small_obj = DataItem(AllocateSingleObject());
+  auto ds = DataSliceImpl::AllocateEmptyObjects(3);
+  auto big_obj = ds[1];
+  ASSERT_OK(db->SetAttr(small_obj, "a", DataItem(1)));
+  ASSERT_OK(db->SetAttr(big_obj, "a", DataItem(2)));
+  ASSERT_OK(db_f->SetAttr(small_obj, "b", DataItem(3)));
+  ASSERT_OK(db_f->SetAttr(big_obj, "b", DataItem(4)));
+  auto fork = db->PartiallyPersistentFork();
+  ASSERT_OK(fork->SetAttr(big_obj, "c", DataItem(5)));
+
+  for (absl::string_view attr : {"a", "b", "c", "d"}) {
+    const PreHashedAttr hashed_attr(attr);
+    for (const DataItem& obj : {small_obj, big_obj, DataItem()}) {
+      EXPECT_THAT(fork->GetAttr(obj, hashed_attr, {db_f.get()}),
+                  IsOkAndHolds(*fork->GetAttr(obj, attr, {db_f.get()})))
+          << attr << " " << obj;
+    }
+  }
+  EXPECT_THAT(fork->GetAttr(big_obj, PreHashedAttr("a")),
+              IsOkAndHolds(DataItem(2)));
+  EXPECT_THAT(fork->GetAttr(small_obj, PreHashedAttr("b"), {db_f.get()}),
+              IsOkAndHolds(DataItem(3)));
+  EXPECT_THAT(fork->GetAttr(big_obj, PreHashedAttr("c")),
+              IsOkAndHolds(DataItem(5)));
+  EXPECT_THAT(fork->GetAttr(DataItem(1), PreHashedAttr("a")),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(DataBagTest, EstimateMemoryUsage) {
+  using StorageKind = DataBagMemoryUsage::StorageKind;
+  constexpr int64_t kSize = 1000;
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  EXPECT_TRUE(db->EstimateMemoryUsage().entries.empty());
+
+  auto objs = DataSliceImpl::AllocateEmptyObjects(kSize);
+  ASSERT_OK(db->SetAttr(objs, "a",
+                        DataSliceImpl::Create(
+                            arolla::CreateConstDenseArray<int64_t>(kSize, 1))));
+  auto small_obj = DataItem(AllocateSingleObject());
+  ASSERT_OK(db->SetAttr(small_obj, "b", DataItem(arolla::Text("abc"))));
+  auto list = DataItem(AllocateSingleList());
+  ASSERT_OK(db->AppendToList(list, DataItem(1)));
+  auto dict = DataItem(AllocateSingleDict());
+  ASSERT_OK(db->SetInDict(dict, DataItem(1), DataItem(2)));
+
+  DataBagMemoryUsage usage = db->EstimateMemoryUsage();
+  MemoryUsage a_usage = usage.entries[{"a", StorageKind::kDenseSource}];
+  EXPECT_GE(a_usage.owned, kSize * sizeof(int64_t));
+  EXPECT_EQ(a_usage.shared, 0);
+  EXPECT_GT((usage.entries[{"b", StorageKind::kSparseSource}].owned), 0);
+  EXPECT_GT((usage.entries[{"", StorageKind::kLists}].owned), 0);
+  EXPECT_GT((usage.entries[{"", StorageKind::kDicts}].owned), 0);
+  EXPECT_EQ(usage.entries.size(), 4);
+
+  auto fork = db->PartiallyPersistentFork();
+  DataBagMemoryUsage fork_usage = fork->EstimateMemoryUsage();
+  EXPECT_EQ(fork_usage.Total().owned, 0);
+  EXPECT_EQ(fork_usage.Total().shared, usage.Total().owned);
+
+  // A single update is stored in a SparseSource of the fork.
+  ASSERT_OK(fork->SetAttr(objs[0], "a", DataItem(int64_t{2})));
+  fork_usage = fork->EstimateMemoryUsage();
+  EXPECT_EQ((fork_usage.entries[{"a", StorageKind::kDenseSource}]),
+            (MemoryUsage{.owned = 0, .shared = a_usage.owned}));
+  EXPECT_GT((fork_usage.entries[{"a", StorageKind::kSparseSource}].owned), 0);
+}
+
+TEST(DataBagTest, ForkUpdatesShareDensePages) {
+  using StorageKind = DataBagMemoryUsage::StorageKind;
+  constexpr int64_t kSize = 100000;
+  AllocationId alloc = Allocate(kSize);
+  auto objs = DataSliceImpl::ObjectsFromAllocation(alloc, kSize);
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttrForEntireAllocation(
+      alloc, "a",
+      DataSliceImpl::Create(
+          arolla::CreateConstDenseArray<int64_t>(kSize, 1))));
+
+  auto fork = db->PartiallyPersistentFork();
+  ASSERT_OK(fork->SetAttr(objs[0], "a", DataItem(int64_t{2})));
+  auto fork2 = fork->PartiallyPersistentFork();
+  ASSERT_OK(fork2->SetAttr(objs[kSize - 1], "a", DataItem(int64_t{3})));
+
+  // The updates are stored in dense sources that share the unmodified pages
+  // with the parents, without SparseSource overlays.
+  for (const auto& bag : {fork, fork2}) {
+    DataBagMemoryUsage usage = bag->EstimateMemoryUsage();
+    EXPECT_EQ(usage.entries.count({"a", StorageKind::kSparseSource}), 0);
+    EXPECT_LT((usage.entries[{"a", StorageKind::kDenseSource}].owned),
+              kSize * sizeof(int64_t) / 10);
+  }
+
+  EXPECT_THAT(db->GetAttr(objs[0], "a"), IsOkAndHolds(DataItem(int64_t{1})));
+  EXPECT_THAT(fork->GetAttr(objs[0], "a"), IsOkAndHolds(DataItem(int64_t{2})));
+  EXPECT_THAT(fork->GetAttr(objs[kSize - 1], "a"),
+              IsOkAndHolds(DataItem(int64_t{1})));
+  EXPECT_THAT(fork2->GetAttr(objs[0], "a"), IsOkAndHolds(DataItem(int64_t{2})));
+  EXPECT_THAT(fork2->GetAttr(objs[kSize - 1], "a"),
+              IsOkAndHolds(DataItem(int64_t{3})));
+  ASSERT_OK_AND_ASSIGN(auto fork_values, fork->GetAttr(objs, "a"));
+  EXPECT_EQ(fork_values.present_count(), kSize);
+}
+
+TEST(DataBagTest, Stats) {
+  DataBagImpl::ResetStats();
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto ds = DataSliceImpl::AllocateEmptyObjects(3);
+  ASSERT_OK(db->SetAttr(
+      ds, "a", DataSliceImpl::Create(arolla::CreateDenseArray<int>({1, 2, 3}))));
+  // Not collected while disabled.
+  EXPECT_EQ(DataBagImpl::GetStats().set_attr.calls, 0);
+
+  DataBagImpl::SetStatsEnabled(true);
+  EXPECT_TRUE(DataBagImpl::StatsEnabled());
+  auto fork = db->PartiallyPersistentFork();
+  ASSERT_OK(fork->SetAttr(ds[0], "b", DataItem(1)));
+  auto db_f = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(fork->GetAttr(ds, "a").status());
+  ASSERT_OK(fork->GetAttr(ds, "b", {db_f.get()}).status());
+  auto list = DataItem(AllocateSingleList());
+  ASSERT_OK(fork->ExtendList(list, DataSliceImpl::Create(
+                                       arolla::CreateDenseArray<int>({4, 5}))));
+  ASSERT_OK(fork->ExplodeList(list).status());
+
+  DataBagStats stats = DataBagImpl::GetStats();
+  EXPECT_EQ(stats.set_attr.calls, 1);
+  EXPECT_EQ(stats.set_attr.elements, 1);
+  // The allocation is too small for a sparse source.
+  EXPECT_EQ(stats.dense_source_writes, 1);
+  EXPECT_EQ(stats.sparse_source_writes, 0);
+  EXPECT_EQ(stats.get_attr.calls, 2);
+  EXPECT_EQ(stats.get_attr.elements, 6);
+  // "b" is missing for 2 of the objects, so the fallback is looked up.
+  EXPECT_EQ(stats.fallback_lookups, 1);
+  EXPECT_EQ(stats.dense_source_reads, 2);
+  EXPECT_EQ(stats.sparse_source_reads, 0);
+  // The parent is visited when "b" is created in the fork (1 step), "a" is
+  // found in the parent of the fork (2), "b" in the fork (1) and the fallback
+  // is visited without finding "b" (1).
+  EXPECT_EQ(stats.parent_chain_steps, 5);
+  EXPECT_EQ(stats.explode_list.calls, 1);
+  EXPECT_EQ(stats.explode_list.elements, 2);
+  EXPECT_EQ(stats.merge_inplace.calls, 0);
+
+  ASSERT_OK(db_f->MergeInplace(*fork, MergeOptions()));
+  DataBagImpl::SetStatsEnabled(false);
+  ASSERT_OK(db_f->MergeInplace(*fork, MergeOptions()));
+  stats = DataBagImpl::GetStats();
+  EXPECT_EQ(stats.merge_inplace.calls, 1);
+  EXPECT_GT(stats.merge_inplace.elements, 0);
+
+  DataBagImpl::ResetStats();
+  EXPECT_EQ(DataBagImpl::GetStats().get_attr.calls, 0);
+}
+
+TEST(DataBagTest, StatsGetAttrCountedOnce) {
+  constexpr int64_t kSize = 3 * DataBagImpl::kGetAttrPathChunkSize + 5;
+  auto ds = DataSliceImpl::AllocateEmptyObjects(kSize);
+  auto values =
+      DataSliceImpl::Create(arolla::CreateConstDenseArray<int>(kSize, 7));
+  // A chain of forks with the attribute set only in the root.
+  auto root = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(root->SetAttr(ds, "a", values));
+  ASSERT_OK(root->SetAttr(ds, "self", ds));
+  DataBagImplPtr fork = root;
+  for (int i = 0; i < 3; ++i) {
+    fork = fork->PartiallyPersistentFork();
+    // Forks of empty layers are collapsed.
+    ASSERT_OK(fork->SetAttr(ds[0], "b", DataItem(i)));
+  }
+  // Three fallbacks, the attribute is only in the last one.
+  auto empty_fb1 = DataBagImpl::CreateEmptyDatabag();
+  auto empty_fb2 = DataBagImpl::CreateEmptyDatabag();
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  std::vector<const DataBagImpl*> fallbacks = {empty_fb1.get(),
+                                               empty_fb2.get(), fork.get()};
+
+  DataBagImpl::ResetStats();
+  DataBagImpl::SetStatsEnabled(true);
+  EXPECT_THAT(db->GetAttr(ds, "a", fallbacks),
+              IsOkAndHolds(IsEquivalentTo(values)));
+  DataBagStats stats = DataBagImpl::GetStats();
+  EXPECT_EQ(stats.get_attr.calls, 1);
+  EXPECT_EQ(stats.get_attr.elements, kSize);
+  EXPECT_EQ(stats.fallback_lookups, 1);
+
+  DataBagImpl::ResetStats();
+  EXPECT_THAT(db->GetAttrPath(ds, {"self", "self", "a"}, fallbacks),
+              IsOkAndHolds(IsEquivalentTo(values)));
+  stats = DataBagImpl::GetStats();
+  EXPECT_EQ(stats.get_attr.calls, 3);
+  EXPECT_EQ(stats.get_attr.elements, 3 * kSize);
+  EXPECT_EQ(stats.fallback_lookups, 3);
+
+  DataBagImpl::ResetStats();
+  EXPECT_THAT(fork->GetAttr(ds, "a", fallbacks),
+              IsOkAndHolds(IsEquivalentTo(values)));
+  stats = DataBagImpl::GetStats();
+  EXPECT_EQ(stats.get_attr.calls, 1);
+  EXPECT_EQ(stats.fallback_lookups, 0);
+  // The root is found after visiting all the forks.
+  EXPECT_EQ(stats.parent_chain_steps, 4);
+  DataBagImpl::SetStatsEnabled(false);
+  DataBagImpl::ResetStats();
+}
+
 TEST(DataBagTest, SetGet) {
   constexpr int64_t kSize = 13;
   auto db = DataBagImpl::CreateEmptyDatabag();
@@ -544,6 +977,44 @@ TEST(DataBagTest, SingleSparseSourceToDense) {
   }
 }
 
+TEST(DataBagTest, SparseSourcePromotion) {
+  AllocationId alloc = Allocate(1024);
+  const int64_t kMaxSparseSize =
+      DataBagImpl::SparseSourcePromotionRatio() * alloc.Capacity();
+  auto parent_db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(parent_db->SetAttr(DataItem(alloc.ObjectByOffset(1000)), "a",
+                               DataItem(-1)));
+  auto db = parent_db->PartiallyPersistentFork();
+  auto get_source_counts = [&]() {
+    DataBagImpl::ConstDenseSourceArray dense_sources;
+    DataBagImpl::ConstSparseSourceArray sparse_sources;
+    db->GetAttributeDataSources(alloc, "a", dense_sources, sparse_sources);
+    return std::vector<size_t>{dense_sources.size(), sparse_sources.size()};
+  };
+
+  for (int64_t i = 0; i < kMaxSparseSize; ++i) {
+    ASSERT_OK(db->SetAttr(DataItem(alloc.ObjectByOffset(i)), "a",
+                          DataItem(static_cast<int>(i))));
+  }
+  EXPECT_EQ(get_source_counts(), std::make_pair(size_t{0}, size_t{2}));
+
+  // The next update exceeds the limit and promotes the sparse sources
+  // (including the one from the parent) into a dense source.
+  ASSERT_OK(db->SetAttr(DataItem(alloc.ObjectByOffset(0)), "a", DataItem()));
+  ASSERT_OK(db->SetAttr(DataItem(alloc.ObjectByOffset(kMaxSparseSize)), "a",
+                        DataItem(static_cast<int>(kMaxSparseSize))));
+  EXPECT_EQ(get_source_counts(), std::make_pair(size_t{1}, size_t{0}));
+
+  EXPECT_THAT(db->GetAttr(DataItem(alloc.ObjectByOffset(0)), "a"),
+              IsOkAndHolds(DataItem()));
+  for (int64_t i = 1; i <= kMaxSparseSize; ++i) {
+    EXPECT_THAT(db->GetAttr(DataItem(alloc.ObjectByOffset(i)), "a"),
+                IsOkAndHolds(DataItem(static_cast<int>(i))));
+  }
+  EXPECT_THAT(db->GetAttr(DataItem(alloc.ObjectByOffset(1000)), "a"),
+              IsOkAndHolds(DataItem(-1)));
+}
+
 TEST(DataBagTest, SparseSource) {
   constexpr size_t kAllocSize = 10000;
   auto db = DataBagImpl::CreateEmptyDatabag();
@@ -909,6 +1380,73 @@ TEST(DataBagTest, CreateObjectDataItemGet) {
   }
 }
 
+TEST(DataBagTest, SetAttrForEntireAllocation) {
+  constexpr int64_t kSize = 10;
+  AllocationId alloc = Allocate(kSize);
+  auto objs = DataSliceImpl::ObjectsFromAllocation(alloc, kSize);
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(objs, "a", DataSliceImpl::Create(kSize, DataItem(1))));
+  db = db->PartiallyPersistentFork();
+
+  auto values = arolla::CreateDenseArray<int>(
+      {5, std::nullopt, 7, 8, 9, 10, 11, 12, 13, std::nullopt});
+  ASSERT_OK(db->SetAttrForEntireAllocation(alloc, "a",
+                                           DataSliceImpl::Create(values)));
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl ds_a, db->GetAttr(objs, "a"));
+  EXPECT_THAT(ds_a.values<int>(), ElementsAreArray(values));
+  // The values are not copied.
+  EXPECT_EQ(ds_a.values<int>().values.span().data(),
+            values.values.span().data());
+
+  EXPECT_THAT(db->SetAttrForEntireAllocation(
+                  Allocate(2), "a", DataSliceImpl::Create(kSize, DataItem(1))),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("don't fit into the allocation")));
+
+  ObjectId small_obj = AllocateSingleObject();
+  ASSERT_OK(db->SetAttr(DataItem(small_obj), "a", DataItem(1)));
+  ASSERT_OK(db->SetAttrForEntireAllocation(
+      AllocationId(small_obj), "a", DataSliceImpl::Create(1, DataItem(2))));
+  EXPECT_THAT(db->GetAttr(DataItem(small_obj), "a"),
+              IsOkAndHolds(DataItem(2)));
+}
+
+TEST(DataBagTest, SetAttrForEntireAllocationConstant) {
+  constexpr int64_t kSize = 10;
+  AllocationId alloc = Allocate(kSize);
+  auto objs = DataSliceImpl::ObjectsFromAllocation(alloc, kSize);
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(objs, "a", DataSliceImpl::Create(kSize, DataItem(1))));
+  ASSERT_OK(db->SetAttrForEntireAllocation(alloc, "a", kSize, DataItem(5)));
+  EXPECT_THAT(db->GetAttr(objs, "a"),
+              IsOkAndHolds(ElementsAreArray(std::vector(kSize, DataItem(5)))));
+  EXPECT_THAT(db->GetAttr(objs[3], "a"), IsOkAndHolds(DataItem(5)));
+
+  // Modification of a single object materializes the values.
+  auto fork = db->PartiallyPersistentFork();
+  ASSERT_OK(fork->SetAttr(objs[3], "a", DataItem(arolla::Text("x"))));
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl ds_a, fork->GetAttr(objs, "a"));
+  EXPECT_EQ(ds_a[3], DataItem(arolla::Text("x")));
+  EXPECT_EQ(ds_a[4], DataItem(5));
+  EXPECT_THAT(db->GetAttr(objs[3], "a"), IsOkAndHolds(DataItem(5)));
+
+  // A missing value removes the attribute.
+  ASSERT_OK(db->SetAttrForEntireAllocation(alloc, "a", kSize, DataItem()));
+  ASSERT_OK_AND_ASSIGN(ds_a, db->GetAttr(objs, "a"));
+  EXPECT_EQ(ds_a.present_count(), 0);
+
+  EXPECT_THAT(db->SetAttrForEntireAllocation(Allocate(2), "a", kSize,
+                                             DataItem(1)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("don't fit into the allocation")));
+
+  ObjectId small_obj = AllocateSingleObject();
+  ASSERT_OK(db->SetAttrForEntireAllocation(AllocationId(small_obj), "a", 1,
+                                           DataItem(2)));
+  EXPECT_THAT(db->GetAttr(DataItem(small_obj), "a"),
+              IsOkAndHolds(DataItem(2)));
+}
+
 TEST(DataBagTest, CreateObjectsGet) {
   for (int64_t size : {1, 2, 13, 1079}) {
     auto db = DataBagImpl::CreateEmptyDatabag();
@@ -1313,6 +1851,166 @@ TEST(DataBagTest, DataBagIndex) {
   }
 }
 
+TEST(DataBagTest, DataBagIndexWithoutParents) {
+  auto ds1 = DataSliceImpl::AllocateEmptyObjects(15);
+  auto ds2 = DataSliceImpl::AllocateEmptyObjects(15);
+  auto list = DataItem(AllocateSingleList());
+
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(ds1, "a", ds2));
+  ASSERT_OK(db->AppendToList(list, DataItem(1)));
+  auto fork = db->PartiallyPersistentFork();
+  ASSERT_OK(fork->SetAttr(ds2, "b", ds1));
+
+  DataBagIndex index = fork->CreateIndex(/*include_parents=*/false);
+  EXPECT_TRUE(index.lists.empty());
+  EXPECT_EQ(index.attrs.size(), 1);
+  EXPECT_THAT(index.attrs["b"].allocations,
+              ElementsAreArray(ds2.allocation_ids().ids()));
+
+  index = fork->CreateIndex();
+  EXPECT_THAT(index.lists, ElementsAre(AllocationId(list.value<ObjectId>())));
+  EXPECT_EQ(index.attrs.size(), 2);
+}
+
+TEST(DataBagTest, DataBagIndexSnapshot) {
+  auto ds1 = DataSliceImpl::AllocateEmptyObjects(15);
+  auto ds2 = DataSliceImpl::AllocateEmptyObjects(15);
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(ds1, "a", ds2));
+  auto fork = db->PartiallyPersistentFork();
+  ASSERT_OK(fork->SetAttr(ds1, "a", ds1));
+
+  auto snapshot = fork->GetIndexSnapshot();
+  EXPECT_EQ(fork->GetIndexSnapshot(), snapshot);
+  EXPECT_THAT(snapshot->attrs.at("a").allocations,
+              ElementsAreArray(ds1.allocation_ids().ids()));
+
+  // Overwriting existing keys doesn't change the index.
+  ASSERT_OK(fork->SetAttr(ds1, "a", ds2));
+  EXPECT_EQ(fork->GetIndexSnapshot(), snapshot);
+
+  ASSERT_OK(fork->SetAttr(ds2, "a", ds1));
+  auto new_snapshot = fork->GetIndexSnapshot();
+  EXPECT_NE(new_snapshot, snapshot);
+  EXPECT_EQ(new_snapshot->attrs.size(), 1);
+  EXPECT_EQ(new_snapshot->attrs.at("a").allocations.size(), 2);
+  // The old snapshot is immutable.
+  EXPECT_EQ(snapshot->attrs.at("a").allocations.size(), 1);
+}
+
+TEST(DataBagTest, CreateOptimized) {
+  constexpr int64_t kSize = 100;
+  auto ds = DataSliceImpl::AllocateEmptyObjects(kSize);
+  AllocationId alloc = ds.allocation_ids().ids()[0];
+  arolla::DenseArrayBuilder<arolla::Text> texts_bldr(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    texts_bldr.Set(i, i % 2 == 0 ? "even" : "odd");
+  }
+  auto ds_text = DataSliceImpl::Create(std::move(texts_bldr).Build());
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(ds, "text", ds_text));
+  auto fork = db->PartiallyPersistentFork();
+  for (int i = 0; i < 10; ++i) {
+    ASSERT_OK(fork->SetAttr(DataItem(alloc.ObjectByOffset(i)), "x",
+                            DataItem(i)));
+  }
+
+  ASSERT_OK_AND_ASSIGN(auto optimized, fork->CreateOptimized());
+  EXPECT_EQ(optimized->fork_depth(), 0);
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl text, optimized->GetAttr(ds, "text"));
+  EXPECT_THAT(text.values<arolla::Text>(),
+              ElementsAreArray(ds_text.values<arolla::Text>()));
+  // Each distinct value is stored once.
+  EXPECT_EQ(text.values<arolla::Text>().values.characters().size(), 7);
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl x, optimized->GetAttr(ds, "x"));
+  EXPECT_EQ(x.present_count(), 10);
+  EXPECT_EQ(x[7], DataItem(7));
+  EXPECT_THAT(optimized->GetIndexSnapshot()->attrs.at("x").allocations,
+              ElementsAre(alloc));
+
+  // The result is independent from the original.
+  ASSERT_OK(fork->SetAttr(DataItem(alloc.ObjectByOffset(0)), "x",
+                          DataItem(-1)));
+  EXPECT_THAT(optimized->GetAttr(DataItem(alloc.ObjectByOffset(0)), "x"),
+              IsOkAndHolds(DataItem(0)));
+
+  // Too many distinct values to deduplicate.
+  ASSERT_OK_AND_ASSIGN(
+      auto not_deduplicated,
+      fork->CreateOptimized({.max_distinct_text_ratio = 0.01}));
+  ASSERT_OK_AND_ASSIGN(text, not_deduplicated->GetAttr(ds, "text"));
+  EXPECT_THAT(text.values<arolla::Text>(),
+              ElementsAreArray(ds_text.values<arolla::Text>()));
+  EXPECT_GT(text.values<arolla::Text>().values.characters().size(), 7);
+}
+
+TEST(DataBagTest, CreateOptimizedWithAccessProfile) {
+  constexpr int64_t kSize = 2000;
+  auto ds = DataSliceImpl::AllocateEmptyObjects(kSize);
+  AllocationId alloc = ds.allocation_ids().ids()[0];
+  // Objects [0, 50, ..., 950] and [1000, 1050, ..., 1950], small enough
+  // updates to be stored in a sparse source.
+  auto few_objects = [&](int64_t begin) {
+    arolla::DenseArrayBuilder<ObjectId> bldr(20);
+    for (int64_t i = 0; i < 20; ++i) {
+      bldr.Set(i, alloc.ObjectByOffset(begin + i * 50));
+    }
+    return DataSliceImpl::CreateObjectsDataSlice(std::move(bldr).Build(),
+                                                 AllocationIdSet(alloc));
+  };
+
+  SetAccessProfilingSampleRate(1);
+  absl::Cleanup cleanup = [] {
+    SetAccessProfilingSampleRate(0);
+    ResetAccessProfile();
+  };
+  ResetAccessProfile();
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(ds, "c", DataSliceImpl::Create(kSize, DataItem(7))));
+  for (int64_t begin : {0, 1000}) {
+    ASSERT_OK(db->SetAttr(few_objects(begin), "s",
+                          DataSliceImpl::Create(20, DataItem(1.5f))));
+  }
+  // Read-mostly in large batches.
+  for (int i = 0; i < 8; ++i) {
+    ASSERT_OK(db->GetAttr(ds, "s"));
+  }
+  AccessProfile profile = GetAccessProfile();
+  ASSERT_EQ(profile.size(), 2);
+
+  ASSERT_OK_AND_ASSIGN(auto recommendations,
+                       db->RecommendStorageLayouts(profile));
+  ASSERT_EQ(recommendations.size(), 2);
+  EXPECT_EQ(recommendations[0].attr, "c");
+  EXPECT_EQ(recommendations[0].layout, StorageLayout::kConstant);
+  EXPECT_EQ(recommendations[0].content.present, kSize);
+  EXPECT_EQ(recommendations[1].attr, "s");
+  EXPECT_EQ(recommendations[1].layout, StorageLayout::kDense);
+  EXPECT_EQ(recommendations[1].access.reads, 8);
+  EXPECT_EQ(recommendations[1].access.writes, 2);
+  EXPECT_EQ(recommendations[1].content.present, 40);
+
+  auto source_counts = [&](const DataBagImpl& db, absl::string_view attr) {
+    DataBagImpl::ConstDenseSourceArray dense_sources;
+    DataBagImpl::ConstSparseSourceArray sparse_sources;
+    db.GetAttributeDataSources(alloc, attr, dense_sources, sparse_sources);
+    return std::vector<size_t>{dense_sources.size(), sparse_sources.size()};
+  };
+  ASSERT_OK_AND_ASSIGN(auto optimized, db->CreateOptimized());
+  EXPECT_THAT(source_counts(*optimized, "s"), ElementsAre(0, 1));
+  ASSERT_OK_AND_ASSIGN(optimized,
+                       db->CreateOptimized({.use_access_profile = true}));
+  EXPECT_THAT(source_counts(*optimized, "s"), ElementsAre(1, 0));
+  EXPECT_THAT(source_counts(*optimized, "c"), ElementsAre(1, 0));
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl c, optimized->GetAttr(ds, "c"));
+  EXPECT_EQ(c.present_count(), kSize);
+  EXPECT_EQ(c[kSize - 1], DataItem(7));
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl s, optimized->GetAttr(ds, "s"));
+  EXPECT_EQ(s.present_count(), 40);
+  EXPECT_EQ(s[50], DataItem(1.5f));
+}
+
 // NOTE(b/343432263): msan regression test to ensure that the DataBagImpl
 // destructor does not cause use-of-uninitialized-value issues.
 using DataBagMsanTest = ::testing::TestWithParam<DataBagImplPtr>;
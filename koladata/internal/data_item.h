@@ -294,6 +294,9 @@ class DataItem {
   }
 
  private:
+  // Text and Bytes are held by value, so that short strings stay inline in
+  // std::string. value<T>() returns `const T&`, so a more compact encoding of
+  // the strings would need to materialize them elsewhere anyway.
   ScalarVariant data_;
 };
 
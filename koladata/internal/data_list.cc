@@ -14,6 +14,8 @@
 //
 #include "koladata/internal/data_list.h"
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
@@ -23,10 +25,19 @@
 #include <vector>
 
 #include "absl/log/check.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/memory_usage.h"
 #include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/qtype/qtype.h"
+#include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/bytes.h"
 #include "arolla/util/meta.h"
+#include "arolla/util/text.h"
 
 namespace koladata::internal {
 
@@ -48,6 +59,10 @@ DataList::DataList(DataSliceImpl data_slice, int64_t from, int64_t to) {
   } else {
     data_slice.VisitValues([&](const auto& array) {
       using T = std::decay_t<decltype(array)>::base_type;
+      if (array.is_owned()) {
+        data_ = array.Slice(from, size_);
+        return;
+      }
       std::vector<std::optional<T>> data(size_);
       for (int64_t i = 0; i < size_; ++i) {
         auto v = array[from + i];
@@ -60,6 +75,23 @@ DataList::DataList(DataSliceImpl data_slice, int64_t from, int64_t to) {
   }
 }
 
+arolla::QTypePtr DataList::values_dtype() const {
+  return std::visit(
+      []<typename T>(const T&) -> arolla::QTypePtr {
+        if constexpr (std::is_same_v<T, AllMissing>) {
+          return arolla::GetNothingQType();
+        } else if constexpr (std::is_same_v<T, std::vector<DataItem>>) {
+          return nullptr;
+        } else if constexpr (arolla::meta::is_wrapped_with_v<arolla::DenseArray,
+                                                             T>) {
+          return arolla::GetQType<typename T::base_type>();
+        } else {
+          return arolla::GetQType<typename T::value_type::value_type>();
+        }
+      },
+      data_);
+}
+
 void DataList::AddToDataSlice(DataSliceImpl::Builder& bldr, int64_t offset,
                               int64_t from, int64_t to) const {
   if (to == -1) {
@@ -69,13 +101,24 @@ void DataList::AddToDataSlice(DataSliceImpl::Builder& bldr, int64_t offset,
   DCHECK(0 <= offset && offset + (to - from) <= bldr.size());
   std::visit(
       [&](const auto& vec) {
-        if constexpr (std::is_same_v<decltype(vec),
-                                     const std::vector<DataItem>&>) {
+        using VecT = std::decay_t<decltype(vec)>;
+        if constexpr (std::is_same_v<VecT, std::vector<DataItem>>) {
           for (int64_t i = from; i < to; ++i, ++offset) {
             bldr.Insert(offset, vec[i]);
           }
-        } else if constexpr (!std::is_same_v<decltype(vec),
-                                             const AllMissing&>) {
+        } else if constexpr (arolla::meta::is_wrapped_with_v<arolla::DenseArray,
+                                                             VecT>) {
+          using T = typename VecT::base_type;
+          auto& arr_bldr = bldr.GetArrayBuilder<T>();
+          for (int64_t i = from; i < to; ++i, ++offset) {
+            if (auto v = vec[i]; v.present) {
+              arr_bldr.Set(offset, v.value);
+              if constexpr (std::is_same_v<T, ObjectId>) {
+                bldr.GetMutableAllocationIds().Insert(AllocationId(v.value));
+              }
+            }
+          }
+        } else if constexpr (kIsVectorStorage<VecT>) {
           using T = arolla::meta::strip_template_t<
               std::optional, typename std::decay_t<decltype(vec)>::value_type>;
           auto& arr_bldr = bldr.GetArrayBuilder<T>();
@@ -99,7 +142,11 @@ DataItem DataList::Get(int64_t index) const {
   DataItem res;
   std::visit(
       [&]<typename T>(const T& vec) {
-        if constexpr (!std::is_same_v<T, AllMissing>) {
+        if constexpr (arolla::meta::is_wrapped_with_v<arolla::DenseArray, T>) {
+          if (auto v = vec[index]; v.present) {
+            res = DataItem(typename T::base_type(v.value));
+          }
+        } else if constexpr (!std::is_same_v<T, AllMissing>) {
           res = DataItem(vec[index]);
         }
       },
@@ -107,10 +154,25 @@ DataItem DataList::Get(int64_t index) const {
   return res;
 }
 
+std::optional<DataSliceImpl> DataList::GetSharedSlice(int64_t from,
+                                                     int64_t to) const {
+  DCHECK(0 <= from && from <= to && to <= size_);
+  std::optional<DataSliceImpl> res;
+  std::visit(
+      [&]<typename T>(const T& array) {
+        if constexpr (arolla::meta::is_wrapped_with_v<arolla::DenseArray, T>) {
+          res = DataSliceImpl::Create(array.Slice(from, to - from));
+        }
+      },
+      data_);
+  return res;
+}
+
 void DataList::SetToMissing(int64_t index) {
   DCHECK(0 <= index && index < size_);
+  MaterializeSharedArray();
   std::visit([&]<typename T>(T& vec) {
-    if constexpr (!std::is_same_v<T, AllMissing>) {
+    if constexpr (kIsVectorStorage<T>) {
       auto& v = vec[index];
       v = typename std::decay_t<decltype(v)>();
     }
@@ -119,9 +181,10 @@ void DataList::SetToMissing(int64_t index) {
 
 void DataList::SetMissingRange(int64_t index_from, int64_t index_to) {
   DCHECK(0 <= index_from && index_from <= index_to && index_to <= size_);
+  MaterializeSharedArray();
   std::visit(
       [&]<typename T>(T& vec) {
-        if constexpr (!std::is_same_v<T, AllMissing>) {
+        if constexpr (kIsVectorStorage<T>) {
           for (int64_t index = index_from; index < index_to; ++index) {
             auto& v = vec[index];
             v = typename std::decay_t<decltype(v)>();
@@ -133,9 +196,10 @@ void DataList::SetMissingRange(int64_t index_from, int64_t index_to) {
 
 void DataList::Remove(int64_t from, int64_t count) {
   DCHECK(0 <= from && count > 0 && from + count <= size_);
+  MaterializeSharedArray();
   std::visit(
       [&]<typename T>(T& vec) {
-        if constexpr (!std::is_same_v<T, AllMissing>) {
+        if constexpr (kIsVectorStorage<T>) {
           vec.erase(vec.begin() + from, vec.begin() + from + count);
         }
       },
@@ -143,11 +207,38 @@ void DataList::Remove(int64_t from, int64_t count) {
   size_ -= count;
 }
 
+void DataList::RemoveSorted(absl::Span<const int64_t> positions) {
+  if (positions.empty()) {
+    return;
+  }
+  DCHECK(std::is_sorted(positions.begin(), positions.end()));
+  DCHECK(0 <= positions.front() && positions.back() < size_);
+  MaterializeSharedArray();
+  std::visit(
+      [&]<typename T>(T& vec) {
+        if constexpr (kIsVectorStorage<T>) {
+          // Moves the elements between consecutive removed positions left.
+          int64_t dst = positions[0];
+          for (size_t i = 0; i < positions.size(); ++i) {
+            const int64_t src_end =
+                i + 1 < positions.size() ? positions[i + 1] : size_;
+            for (int64_t src = positions[i] + 1; src < src_end; ++src) {
+              vec[dst++] = std::move(vec[src]);
+            }
+          }
+          vec.resize(dst);
+        }
+      },
+      data_);
+  size_ -= positions.size();
+}
+
 void DataList::InsertMissing(int64_t from, int64_t count) {
   DCHECK(0 <= from && count > 0 && from <= size_);
+  MaterializeSharedArray();
   std::visit(
       [&]<typename T>(T& vec) {
-        if constexpr (!std::is_same_v<T, AllMissing>) {
+        if constexpr (kIsVectorStorage<T>) {
           vec.resize(size_ + count);
           for (int64_t i = size_ - 1; i >= from; --i) {
             vec[i + count] = vec[i];
@@ -163,9 +254,10 @@ void DataList::InsertMissing(int64_t from, int64_t count) {
 }
 
 void DataList::Resize(size_t size) {
+  MaterializeSharedArray();
   std::visit(
       [&]<typename T>(T& vec) {
-        if constexpr (!std::is_same_v<T, AllMissing>) {
+        if constexpr (kIsVectorStorage<T>) {
           vec.resize(size);
         }
       },
@@ -173,11 +265,27 @@ void DataList::Resize(size_t size) {
   size_ = size;
 }
 
+void DataList::MaterializeSharedArray() {
+  std::visit(
+      [&]<typename T>(const T& array) {
+        if constexpr (arolla::meta::is_wrapped_with_v<arolla::DenseArray, T>) {
+          using ValueT = typename T::base_type;
+          std::vector<std::optional<ValueT>> data(size_);
+          array.ForEachPresent([&](int64_t i, auto v) { data[i] = ValueT(v); });
+          // `array` is destroyed by the assignment, so it must be the last
+          // statement.
+          data_ = std::move(data);
+        }
+      },
+      data_);
+}
+
 void DataList::ConvertToDataItems() {
+  MaterializeSharedArray();
   std::vector<DataItem> new_data(size_);
   std::visit(
       [&]<typename T>(const T& vec) {
-        if constexpr (!std::is_same_v<T, AllMissing>) {
+        if constexpr (kIsVectorStorage<T>) {
           for (size_t i = 0; i < size_; ++i) {
             new_data[i] = DataItem(vec[i]);
           }
@@ -187,4 +295,47 @@ void DataList::ConvertToDataItems() {
   data_ = std::move(new_data);
 }
 
+int64_t DataList::EstimateMemoryUsage() const {
+  return std::visit(
+      [&]<typename T>(const T& data) -> int64_t {
+        if constexpr (std::is_same_v<T, AllMissing>) {
+          return 0;
+        } else if constexpr (kIsVectorStorage<T>) {
+          using ValueT = typename T::value_type;
+          int64_t bytes = data.capacity() * sizeof(ValueT);
+          if constexpr (std::is_same_v<ValueT, DataItem>) {
+            for (const DataItem& item : data) {
+              bytes += EstimateDataItemHeapBytes(item);
+            }
+          } else if constexpr (
+              std::is_same_v<ValueT, std::optional<arolla::Text>> ||
+              std::is_same_v<ValueT, std::optional<arolla::Bytes>>) {
+            for (const ValueT& value : data) {
+              if (value.has_value()) {
+                bytes += absl::string_view(*value).size();
+              }
+            }
+          }
+          return bytes;
+        } else {
+          return EstimateDenseArrayBytes(data);
+        }
+      },
+      data_);
+}
+
+absl::Span<const int64_t> DataListVector::sizes() const {
+  if (!sizes_valid_.load(std::memory_order_acquire)) {
+    absl::MutexLock lock(&sizes_mutex_);
+    if (!sizes_valid_.load(std::memory_order_relaxed)) {
+      sizes_.resize(size_);
+      for (size_t i = 0; i < size_; ++i) {
+        sizes_[i] = Get(i).size();
+      }
+      sizes_valid_.store(true, std::memory_order_release);
+    }
+  }
+  return sizes_;
+}
+
 }  // namespace koladata::internal
@@ -15,6 +15,8 @@
 #ifndef KOLADATA_INTERNAL_DATA_LIST_H_
 #define KOLADATA_INTERNAL_DATA_LIST_H_
 
+#include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -25,19 +27,24 @@
 #include <vector>
 
 #include "absl/log/check.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/memory_usage.h"
 #include "koladata/internal/missing_value.h"
 #include "koladata/internal/object_id.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/expr/quote.h"
 #include "arolla/memory/optional_value.h"
+#include "arolla/qtype/qtype.h"
 #include "arolla/util/bytes.h"
 #include "arolla/util/iterator.h"
 #include "arolla/util/meta.h"
 #include "arolla/util/text.h"
 #include "arolla/util/unit.h"
+#include "arolla/util/view_types.h"
 
 namespace koladata::internal {
 
@@ -66,6 +73,10 @@ class DataList {
     DCHECK_LE(from, to);
     DCHECK_LE(to, array.size());
     size_ = to - from;
+    if (array.is_owned()) {
+      data_ = array.Slice(from, size_);
+      return;
+    }
     std::vector<std::optional<T>> data(size_);
     for (int64_t i = 0; i < size_; ++i) {
       auto v = array[from + i];
@@ -79,17 +90,77 @@ class DataList {
   size_t size() const { return size_; }
   bool empty() const { return size() == 0; }
 
+  // Returns the estimated number of bytes used by the elements of the list,
+  // see MemoryUsage. sizeof(DataList) is not included.
+  int64_t EstimateMemoryUsage() const;
+
   // Adds value from this list (sliced from `from` to `to`, full list
   // by default) to the data slice builder starting from `offset`.
   // I.e. the value `list[from + i]` will go to `bldr[offset + i]`.
   void AddToDataSlice(DataSliceImpl::Builder& bldr, int64_t offset,
                       int64_t from = 0, int64_t to = -1) const;
 
+  // Returns the type of the values if the list stores values of a single
+  // type, arolla::GetNothingQType() if all the values are missing, or nullptr
+  // if the types are mixed.
+  arolla::QTypePtr values_dtype() const;
+
+  // Same as AddToDataSlice, but adds the values to a typed builder without a
+  // dispatch per element. `T` must be the type returned by values_dtype().
+  template <typename T>
+  void AddToDenseArray(arolla::DenseArrayBuilder<T>& bldr, int64_t offset,
+                       int64_t from, int64_t to) const {
+    DCHECK(0 <= from && from <= to && to <= size_);
+    if (const auto* vec = std::get_if<std::vector<std::optional<T>>>(&data_)) {
+      for (int64_t i = from; i < to; ++i, ++offset) {
+        if (const std::optional<T>& v = (*vec)[i]; v.has_value()) {
+          bldr.Set(offset, *v);
+        }
+      }
+    } else if (const auto* arr = std::get_if<arolla::DenseArray<T>>(&data_)) {
+      arr->Slice(from, to - from)
+          .ForEachPresent([&](int64_t i, arolla::view_type_t<T> v) {
+            bldr.Set(offset + i, v);
+          });
+    } else {
+      DCHECK(std::holds_alternative<AllMissing>(data_));
+    }
+  }
+
+  // Same as AddToDenseArray(bldr, offset, index, index + 1), but doesn't slice
+  // the shared array, which is cheaper for a single element.
+  template <typename T>
+  void AddItemToDenseArray(arolla::DenseArrayBuilder<T>& bldr, int64_t offset,
+                           int64_t index) const {
+    DCHECK(0 <= index && index < size_);
+    if (const auto* vec = std::get_if<std::vector<std::optional<T>>>(&data_)) {
+      if (const std::optional<T>& v = (*vec)[index]; v.has_value()) {
+        bldr.Set(offset, *v);
+      }
+    } else if (const auto* arr = std::get_if<arolla::DenseArray<T>>(&data_)) {
+      if (auto v = (*arr)[index]; v.present) {
+        bldr.Set(offset, v.value);
+      }
+    } else {
+      DCHECK(std::holds_alternative<AllMissing>(data_));
+    }
+  }
+
   DataItem Get(int64_t index) const;
 
+  // Returns values in range [from, to) without copying if the list shares
+  // buffers with the array it was created from. Returns nullopt otherwise.
+  std::optional<DataSliceImpl> GetSharedSlice(int64_t from, int64_t to) const;
+
   // Removes `count` elements starting from index `from`.
   void Remove(int64_t from, int64_t count);
 
+  // Removes the elements at `positions`, which must be sorted, distinct and
+  // in [0, size()). Unlike calling Remove per position, the remaining elements
+  // are moved in a single pass, so the cost doesn't depend on the number of
+  // removed elements.
+  void RemoveSorted(absl::Span<const int64_t> positions);
+
   // Inserts `count` empty elements starting from index `from`.
   void InsertMissing(int64_t from, int64_t count);
 
@@ -128,8 +199,14 @@ class DataList {
   }
 
   // Set to given values `data.size()` items starting from `start_index`.
+  // If the whole list is replaced by an owned array, the list shares its
+  // buffers instead of copying the values.
   template <typename T>
   void SetN(int64_t start_index, const arolla::DenseArray<T>& data) {
+    if (start_index == 0 && data.size() == size_ && data.is_owned()) {
+      data_ = data;
+      return;
+    }
     ApplyDataItemOrT<T>([&](auto& vec) {
       auto* dst = vec.data() + start_index;
       using VT = std::decay_t<decltype(*dst)>;
@@ -199,6 +276,19 @@ class DataList {
   }
 
  private:
+  // True for the alternatives of `data_` that are std::vector.
+  template <typename T>
+  static constexpr bool kIsVectorStorage =
+      !std::is_same_v<T, AllMissing> &&
+      !arolla::meta::is_wrapped_with_v<arolla::DenseArray, T>;
+
+  bool HoldsSharedArray() const {
+    return data_.index() >= kFirstSharedArrayIndex;
+  }
+
+  // Converts shared array storage to std::vector before modification.
+  void MaterializeSharedArray();
+
   void ConvertToDataItems();
 
   // Calls either `fn(vector<optional<T>>&)` (if the list contains only values
@@ -211,6 +301,9 @@ class DataList {
         std::optional,
         arolla::meta::strip_template_t<arolla::OptionalValue, T>>;
     using OptT = std::optional<BaseT>;
+    if (HoldsSharedArray()) {
+      MaterializeSharedArray();
+    }
     if constexpr (!std::is_same_v<T, DataItem>) {
       if (size_ == 0 || std::holds_alternative<AllMissing>(data_)) {
         std::vector<OptT> data(size_);
@@ -247,45 +340,79 @@ class DataList {
                std::vector<std::optional<arolla::Bytes>>,            //
                std::vector<std::optional<arolla::expr::ExprQuote>>,  //
                std::vector<std::optional<schema::DType>>,            //
-               std::vector<DataItem>>
+               std::vector<DataItem>,                                //
+               // Immutable values sharing buffers with the array the list was
+               // created from. So all lists of an allocation created by a
+               // single ExtendLists are stored as slices of one values buffer
+               // and one presence bitmap (like in CSR format), without an
+               // allocation per list or per string, and are released as a
+               // whole. Converted to std::vector on the first modification.
+               arolla::DenseArray<ObjectId>,                         //
+               arolla::DenseArray<int32_t>,                          //
+               arolla::DenseArray<int64_t>,                          //
+               arolla::DenseArray<float>,                            //
+               arolla::DenseArray<double>,                           //
+               arolla::DenseArray<bool>,                             //
+               arolla::DenseArray<arolla::Unit>,                     //
+               arolla::DenseArray<arolla::Text>,                     //
+               arolla::DenseArray<arolla::Bytes>,                    //
+               arolla::DenseArray<arolla::expr::ExprQuote>,          //
+               arolla::DenseArray<schema::DType>>
       data_;
+  // Index of arolla::DenseArray<ObjectId> in `data_`.
+  static constexpr size_t kFirstSharedArrayIndex = 13;
+  static_assert(
+      std::is_same_v<
+          std::variant_alternative_t<kFirstSharedArrayIndex, decltype(data_)>,
+          arolla::DenseArray<ObjectId>>);
 };
 
 // Vector of DataLists. Can be created from shared_ptr to another DataListVector
 // and copies content lazily.
+//
+// The lists are stored in pages of kPageSize lists. A vector created from a
+// parent shares all the pages with it, and a page is copied on the first
+// modification of any list in it. The copy points to the lists of the original
+// page, so only the modified list itself is copied. As a result a small update
+// in a fork costs O(kPageSize) rather than O(size()).
 class DataListVector {
  public:
-  explicit DataListVector(size_t size) : data_(size) {
-    for (ListAndPtr& lp : data_) {
-      lp.ptr_ = &lp.list_;
+  static constexpr size_t kPageSize = 1024;
+
+  explicit DataListVector(size_t size) : size_(size) {
+    pages_.reserve((size + kPageSize - 1) / kPageSize);
+    for (size_t offset = 0; offset < size; offset += kPageSize) {
+      pages_.push_back(
+          std::make_shared<Page>(std::min(kPageSize, size - offset)));
     }
   }
 
   explicit DataListVector(std::shared_ptr<const DataListVector> parent)
-      : data_(parent->size()), parent_(std::move(parent)) {
-    for (size_t i = 0; i < data_.size(); ++i) {
-      ListAndPtr& lp = data_[i];
-      const DataList& parent_list = parent_->Get(i);
-      // raw pointer is safe since `parent_` holds ownership of `parent_list`.
-      lp.ptr_ = parent_list.empty() ? &lp.list_ : &parent_list;
-    }
-  }
+      : pages_(parent->pages_), size_(parent->size_) {}
 
   DataListVector(const DataListVector&) = delete;
   DataListVector(DataListVector&&) = delete;
   void operator=(const DataListVector&) = delete;
   void operator=(DataListVector&&) = delete;
 
-  size_t size() const { return data_.size(); }
+  size_t size() const { return size_; }
 
   const DataList& Get(size_t index) const {
     DCHECK_LT(index, size());
-    return *data_[index].ptr_;
+    return *pages_[index / kPageSize]->lists[index % kPageSize].ptr_;
   }
 
   DataList& GetMutable(size_t index) {
     DCHECK_LT(index, size());
-    ListAndPtr& lp = data_[index];
+    // The list can be modified through the returned reference.
+    sizes_valid_.store(false, std::memory_order_relaxed);
+    std::shared_ptr<Page>& page = pages_[index / kPageSize];
+    if (page.use_count() > 1) {
+      // The page is shared with another vector (or with a page copied from
+      // it), so it must not be modified.
+      page = std::make_shared<Page>(std::shared_ptr<const Page>(page));
+    }
+    ListAndPtr& lp = page->lists[index % kPageSize];
     if (!lp.IsMutable()) {
       lp.list_ = *lp.ptr_;
       lp.ptr_ = &lp.list_;
@@ -293,18 +420,74 @@ class DataListVector {
     return lp.list_;
   }
 
+  // Returns the sizes of all the lists. The sizes are cached until the next
+  // GetMutable call, so repeated batch size queries are a gather over a
+  // contiguous array rather than a pointer chase per list. Thread-safe (as
+  // other const methods).
+  absl::Span<const int64_t> sizes() const;
+
+  // Returns the estimated number of bytes owned by the vector, see
+  // MemoryUsage. Pages shared with other vectors (e.g. with the parent or with
+  // forks) and lists that belong to the pages they were copied from are not
+  // included.
+  int64_t EstimateMemoryUsage() const {
+    int64_t bytes = pages_.capacity() * sizeof(std::shared_ptr<Page>) +
+                    sizes_.capacity() * sizeof(int64_t);
+    for (const auto& page : pages_) {
+      if (page.use_count() > 1) {
+        continue;
+      }
+      bytes += sizeof(Page) + page->lists.capacity() * sizeof(ListAndPtr);
+      for (const ListAndPtr& lp : page->lists) {
+        if (lp.IsMutable()) {
+          bytes += lp.list_.EstimateMemoryUsage();
+        }
+      }
+    }
+    return bytes;
+  }
+
  private:
   struct ListAndPtr {
-    // ptr_ links either to list_ (mutable) or to a list owned by parent_
-    // (immutable since we are not allowed to change parent).
+    // ptr_ links either to list_ (mutable) or to a list owned by the source
+    // page (immutable since the source page is shared).
     bool IsMutable() const { return ptr_ == &list_; }
 
     DataList list_;
     const DataList* ptr_;
   };
 
-  std::vector<ListAndPtr> data_;
-  std::shared_ptr<const DataListVector> parent_;
+  struct Page {
+    explicit Page(size_t size) : lists(size) {
+      for (ListAndPtr& lp : lists) {
+        lp.ptr_ = &lp.list_;
+      }
+    }
+
+    explicit Page(std::shared_ptr<const Page> src)
+        : lists(src->lists.size()), source(std::move(src)) {
+      for (size_t i = 0; i < lists.size(); ++i) {
+        ListAndPtr& lp = lists[i];
+        const DataList& source_list = *source->lists[i].ptr_;
+        // raw pointer is safe since `source` (transitively) holds ownership
+        // of `source_list`.
+        lp.ptr_ = source_list.empty() ? &lp.list_ : &source_list;
+      }
+    }
+
+    Page(const Page&) = delete;
+    void operator=(const Page&) = delete;
+
+    std::vector<ListAndPtr> lists;
+    std::shared_ptr<const Page> source;
+  };
+
+  std::vector<std::shared_ptr<Page>> pages_;
+  size_t size_;
+
+  mutable absl::Mutex sizes_mutex_;
+  mutable std::vector<int64_t> sizes_;
+  mutable std::atomic<bool> sizes_valid_ = false;
 };
 
 }  // namespace koladata::internal
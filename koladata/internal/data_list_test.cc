@@ -14,6 +14,7 @@
 //
 #include "koladata/internal/data_list.h"
 
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <utility>
@@ -26,8 +27,10 @@
 #include "koladata/internal/missing_value.h"
 #include "koladata/internal/object_id.h"
 #include "arolla/dense_array/dense_array.h"
+#include "arolla/qtype/qtype.h"
 #include "arolla/qtype/qtype_traits.h"
 #include "arolla/util/bytes.h"
+#include "arolla/util/text.h"
 
 namespace koladata::internal {
 namespace {
@@ -174,6 +177,77 @@ TEST(DataListTest, SetN) {
                                 DataItem(), DataItem(3.0), DataItem(4.0)));
 }
 
+TEST(DataListTest, SharedStrings) {
+  using arolla::Text;
+  auto values = arolla::CreateDenseArray<Text>(
+      {Text("a"), std::nullopt, Text("bc"), Text("d")});
+  {
+    DataList list(values, 1, 4);
+    EXPECT_THAT(list, ElementsAre(DataItem(), DataItem(Text("bc")),
+                                  DataItem(Text("d"))));
+    DataSliceImpl::Builder bldr(4);
+    list.AddToDataSlice(bldr, 1);
+    EXPECT_THAT(std::move(bldr).Build(),
+                ElementsAre(DataItem(), DataItem(), DataItem(Text("bc")),
+                            DataItem(Text("d"))));
+
+    // Modifications convert the shared storage.
+    list.Insert(0, Text("x"));
+    EXPECT_THAT(list, ElementsAre(DataItem(Text("x")), DataItem(),
+                                  DataItem(Text("bc")), DataItem(Text("d"))));
+    list.Set(1, DataItem(5));
+    EXPECT_THAT(list, ElementsAre(DataItem(Text("x")), DataItem(5),
+                                  DataItem(Text("bc")), DataItem(Text("d"))));
+  }
+  {
+    DataList list;
+    list.Resize(4);
+    list.SetN(0, values);
+    DataList copy = list;
+    list.Remove(0, 2);
+    EXPECT_THAT(list, ElementsAre(DataItem(Text("bc")), DataItem(Text("d"))));
+    EXPECT_THAT(copy, ElementsAre(DataItem(Text("a")), DataItem(),
+                                  DataItem(Text("bc")), DataItem(Text("d"))));
+    list.SetToMissing(0);
+    list.Resize(3);
+    EXPECT_THAT(list, ElementsAre(DataItem(), DataItem(Text("d")), DataItem()));
+  }
+}
+
+TEST(DataListTest, SharedArray) {
+  auto values = arolla::CreateDenseArray<int64_t>({1, std::nullopt, 3, 4});
+  DataList list(values, 1, 4);
+  EXPECT_THAT(list, ElementsAre(DataItem(), DataItem(int64_t{3}),
+                                DataItem(int64_t{4})));
+  std::optional<DataSliceImpl> shared = list.GetSharedSlice(1, 3);
+  ASSERT_TRUE(shared.has_value());
+  EXPECT_THAT(*shared, ElementsAre(DataItem(int64_t{3}), DataItem(int64_t{4})));
+  // Zero-copy.
+  EXPECT_EQ(shared->values<int64_t>().values.span().data(),
+            values.values.span().data() + 2);
+
+  list.Set(0, int64_t{7});
+  EXPECT_FALSE(list.GetSharedSlice(0, 3).has_value());
+  EXPECT_THAT(list, ElementsAre(DataItem(int64_t{7}), DataItem(int64_t{3}),
+                                DataItem(int64_t{4})));
+}
+
+TEST(DataListTest, RemoveSorted) {
+  DataList list(std::vector<std::optional<int>>{0, 1, 2, std::nullopt, 4, 5});
+  list.RemoveSorted({});
+  EXPECT_EQ(list.size(), 6);
+  list.RemoveSorted({0, 2, 3, 5});
+  EXPECT_THAT(list, ElementsAre(DataItem(1), DataItem(4)));
+  list.Insert(2, arolla::Text("a"));
+  list.RemoveSorted({1});
+  EXPECT_THAT(list, ElementsAre(DataItem(1), DataItem(arolla::Text("a"))));
+
+  // Shared arrays are materialized first.
+  DataList shared(arolla::CreateDenseArray<int64_t>({1, 2, 3}));
+  shared.RemoveSorted({0, 1, 2});
+  EXPECT_TRUE(shared.empty());
+}
+
 TEST(DataListTest, AllMissing) {
   {
     DataList list;
@@ -247,6 +321,32 @@ TEST(DataListTest, AddToDataSlice) {
   }
 }
 
+TEST(DataListTest, AddToDenseArray) {
+  EXPECT_EQ(DataList().values_dtype(), arolla::GetNothingQType());
+  {  // shared array
+    DataList list(arolla::CreateDenseArray<int>({5, 4, std::nullopt, 2, 1}));
+    ASSERT_EQ(list.values_dtype(), arolla::GetQType<int>());
+    arolla::DenseArrayBuilder<int> bldr(5);
+    list.AddToDenseArray(bldr, 2, 1, 4);
+    EXPECT_THAT(std::move(bldr).Build(),
+                ElementsAre(std::nullopt, std::nullopt, 4, std::nullopt, 2));
+  }
+  {  // vector
+    DataList list(std::vector<std::optional<arolla::Text>>{
+        arolla::Text("a"), std::nullopt, arolla::Text("b")});
+    ASSERT_EQ(list.values_dtype(), arolla::GetQType<arolla::Text>());
+    arolla::DenseArrayBuilder<arolla::Text> bldr(3);
+    list.AddToDenseArray(bldr, 0, 0, 3);
+    EXPECT_THAT(std::move(bldr).Build(),
+                ElementsAre("a", std::nullopt, "b"));
+  }
+  {  // mixed types
+    DataList list(arolla::CreateDenseArray<int>({5, 4}));
+    list.Set(1, 3.5f);
+    EXPECT_EQ(list.values_dtype(), nullptr);
+  }
+}
+
 TEST(DataListTest, DataListVector) {
   auto vec = std::make_shared<DataListVector>(3);
   ASSERT_EQ(vec->size(), 3);
@@ -272,5 +372,51 @@ TEST(DataListTest, DataListVector) {
   EXPECT_THAT(derived_vec->Get(2), ElementsAre(DataItem(9), DataItem(7)));
 }
 
+TEST(DataListTest, DataListVectorPages) {
+  constexpr size_t kSize = DataListVector::kPageSize * 3 + 5;
+  auto vec = std::make_shared<DataListVector>(kSize);
+  for (size_t i = 0; i < kSize; ++i) {
+    vec->GetMutable(i).Insert(0, static_cast<int>(i));
+  }
+  int64_t vec_usage = vec->EstimateMemoryUsage();
+
+  auto derived_vec = std::make_shared<DataListVector>(vec);
+  EXPECT_EQ(derived_vec->size(), kSize);
+
+  derived_vec->GetMutable(kSize - 1).Insert(0, -1);
+  // Only the last (short) page is copied.
+  EXPECT_LT(derived_vec->EstimateMemoryUsage(), vec_usage / 100);
+  EXPECT_THAT(vec->Get(kSize - 1), ElementsAre(DataItem(int{kSize - 1})));
+  EXPECT_THAT(derived_vec->Get(kSize - 1),
+              ElementsAre(DataItem(-1), DataItem(int{kSize - 1})));
+  for (size_t i = 0; i + 1 < kSize; ++i) {
+    ASSERT_EQ(&vec->Get(i), &derived_vec->Get(i));
+  }
+
+  // Modifying the parent after the fork doesn't affect the derived vector.
+  vec->GetMutable(0).Insert(0, -2);
+  EXPECT_THAT(vec->Get(0), ElementsAre(DataItem(-2), DataItem(0)));
+  EXPECT_THAT(derived_vec->Get(0), ElementsAre(DataItem(0)));
+}
+
+TEST(DataListTest, DataListVectorSizes) {
+  auto vec = std::make_shared<DataListVector>(3);
+  EXPECT_THAT(vec->sizes(), ElementsAre(0, 0, 0));
+
+  vec->GetMutable(1).Resize(4);
+  EXPECT_THAT(vec->sizes(), ElementsAre(0, 4, 0));
+
+  DataList& list = vec->GetMutable(2);
+  list.Insert(0, 7);
+  list.Insert(0, 8);
+  EXPECT_THAT(vec->sizes(), ElementsAre(0, 4, 2));
+
+  auto derived_vec = std::make_shared<DataListVector>(vec);
+  EXPECT_THAT(derived_vec->sizes(), ElementsAre(0, 4, 2));
+  derived_vec->GetMutable(0).Insert(0, 5);
+  EXPECT_THAT(derived_vec->sizes(), ElementsAre(1, 4, 2));
+  EXPECT_THAT(vec->sizes(), ElementsAre(0, 4, 2));
+}
+
 }  // namespace
 }  // namespace koladata::internal
@@ -15,16 +15,17 @@
 #include "koladata/internal/data_slice.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstring>
+#include <memory>
 #include <optional>
 #include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
-#include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -46,6 +47,7 @@
 #include "arolla/util/fingerprint.h"
 #include "arolla/util/meta.h"
 #include "arolla/util/repr.h"
+#include "arolla/util/unit.h"
 #include "arolla/util/view_types.h"
 
 namespace koladata::internal {
@@ -81,6 +83,7 @@ DataSliceImpl DataSliceImpl::ObjectsFromAllocation(AllocationId alloc_id,
     values_builder.Set(i, alloc_id.ObjectByOffset(i));
   }
   impl.values.emplace_back(ObjectIdArray{std::move(values_builder).Build()});
+  impl.is_allocation_prefix = true;
   return result;
 }
 
@@ -230,6 +233,22 @@ bool DataSliceImpl::ContainsOnlyDicts() const {
 
 DataItem DataSliceImpl::operator[](int64_t offset) const {
   DCHECK_LT(offset, internal_->size);
+  if (internal_->values.size() > 1) {
+    if (const std::vector<uint8_t>* indices =
+            internal_->row_value_indices.load(std::memory_order_acquire);
+        indices != nullptr) {
+      uint8_t index = (*indices)[offset];
+      if (index == kMissingRow) {
+        return DataItem();
+      }
+      return std::visit(
+          [offset](const auto& array) {
+            using T = typename std::decay_t<decltype(array)>::base_type;
+            return DataItem(T(array.values[offset]));
+          },
+          internal_->values[index]);
+    }
+  }
   DataItem result;
   for (const auto& value : internal_->values) {
     std::visit(
@@ -308,6 +327,99 @@ void DataSliceImpl::ArollaFingerprint(arolla::FingerprintHasher* hasher) const {
   }
 }
 
+arolla::QTypePtr DataSliceImpl::InitTypedValues() const {
+  // Concurrent calls compute the same values, so they can race safely.
+  const void* ptr = nullptr;
+  arolla::QTypePtr qtype = arolla::GetNothingQType();
+  if (internal_->values.size() == 1) {
+    std::visit(
+        [&](const auto& array) {
+          using T = typename std::decay_t<decltype(array)>::base_type;
+          if constexpr (!std::is_same_v<T, ObjectId>) {
+            ptr = &array;
+            qtype = arolla::GetDenseArrayQType<T>();
+          }
+        },
+        internal_->values[0]);
+  }
+  internal_->typed_values_ptr.store(ptr, std::memory_order_relaxed);
+  internal_->typed_values_qtype.store(qtype, std::memory_order_release);
+  return qtype;
+}
+
+const std::vector<uint8_t>& DataSliceImpl::InitRowValueIndices() const {
+  static_assert(std::variant_size_v<Variant> < kMissingRow);
+  auto indices =
+      std::make_unique<std::vector<uint8_t>>(internal_->size, kMissingRow);
+  for (size_t i = 0; i < internal_->values.size(); ++i) {
+    std::visit(
+        [&](const auto& array) {
+          array.ForEachPresent(
+              [&](int64_t id, const auto&) { (*indices)[id] = i; });
+        },
+        internal_->values[i]);
+  }
+  // Concurrent calls compute the same indices, the first published one wins.
+  const std::vector<uint8_t>* published = nullptr;
+  if (internal_->row_value_indices.compare_exchange_strong(
+          published, indices.get(), std::memory_order_acq_rel,
+          std::memory_order_acquire)) {
+    return *indices.release();
+  }
+  return *published;
+}
+
+arolla::DenseArray<arolla::Unit> DataSliceImpl::SingleDTypePresence() const {
+  if (internal_->values.empty()) {
+    return arolla::CreateEmptyDenseArray<arolla::Unit>(internal_->size);
+  }
+  return std::visit(
+      [](const auto& array) {
+        return arolla::DenseArray<arolla::Unit>{
+            arolla::VoidBuffer(array.size()), array.bitmap,
+            array.bitmap_bit_offset};
+      },
+      internal_->values[0]);
+}
+
+const arolla::DenseArray<arolla::Unit>& DataSliceImpl::InitPresence() const {
+  using ::arolla::bitmap::Word;
+  const int64_t size = internal_->size;
+  const int64_t bitmap_size = arolla::bitmap::BitmapSize(size);
+  // The arrays have disjoint presence, so the union is a word-wise OR.
+  arolla::Buffer<Word>::Builder bitmap_bldr(bitmap_size);
+  absl::Span<Word> bitmap = bitmap_bldr.GetMutableSpan();
+  std::fill(bitmap.begin(), bitmap.end(), 0);
+  bool all_present = false;
+  for (const Variant& values : internal_->values) {
+    std::visit(
+        [&](const auto& array) {
+          if (array.bitmap.empty()) {
+            all_present = true;
+            return;
+          }
+          for (int64_t i = 0; i < bitmap_size; ++i) {
+            bitmap[i] |= arolla::bitmap::GetWordWithOffset(
+                array.bitmap, i, array.bitmap_bit_offset);
+          }
+        },
+        values);
+  }
+  auto presence = std::make_unique<arolla::DenseArray<arolla::Unit>>(
+      arolla::DenseArray<arolla::Unit>{
+          arolla::VoidBuffer(size),
+          all_present ? arolla::Buffer<Word>()
+                      : std::move(bitmap_bldr).Build()});
+  // Concurrent calls compute the same presence, the first published one wins.
+  const arolla::DenseArray<arolla::Unit>* published = nullptr;
+  if (internal_->presence.compare_exchange_strong(
+          published, presence.get(), std::memory_order_acq_rel,
+          std::memory_order_acquire)) {
+    return *presence.release();
+  }
+  return *published;
+}
+
 void DataSliceImpl::RemoveEmptyValues() {
   auto end = std::remove_if(
       internal_->values.begin(), internal_->values.end(),
@@ -333,14 +445,34 @@ void DataSliceImpl::Builder::ChangeCurrentType(int8_t type_id) {
     current_type_id_ = type_id;
     return;
   }
-  if (bldrs_.empty()) {
-    bldrs_.reserve(2);
-    bldrs_.emplace(current_type_id_, std::move(first_bldr_));
+  if (bldrs_ == nullptr) {
+    bldrs_ = std::make_unique<decltype(bldrs_)::element_type>();
+    (*bldrs_)[current_type_id_] = std::move(first_bldr_);
   }
-  current_bldr_ = &bldrs_[type_id];
+  current_bldr_ = &(*bldrs_)[type_id];
   current_type_id_ = type_id;
 }
 
+namespace {
+
+// Inserts the allocations of all present `objects` into `allocation_ids`.
+// Neighboring objects usually belong to the same allocation, so the set is
+// only updated when the allocation changes.
+void InsertAllocationIds(const arolla::DenseArray<ObjectId>& objects,
+                         AllocationIdSet& allocation_ids) {
+  std::optional<AllocationId> last_alloc;
+  objects.ForEachPresent([&](int64_t, ObjectId object) {
+    if (object.IsSmallAlloc()) {
+      allocation_ids.InsertSmallAllocationId();
+    } else if (AllocationId alloc(object); alloc != last_alloc) {
+      allocation_ids.Insert(alloc);
+      last_alloc = alloc;
+    }
+  });
+}
+
+}  // namespace
+
 DataSliceImpl DataSliceImpl::Builder::Build() && {
   auto& impl = *slice_.internal_;
 #ifndef NDEBUG
@@ -366,7 +498,8 @@ DataSliceImpl DataSliceImpl::Builder::Build() && {
           DCHECK_EQ((used_type_ids_mask >> type_id) & 1U, 0);
           used_type_ids_mask |= (1U << type_id);
           DCHECK_NE(type_id, current_type_id_);
-          DCHECK(!bldrs_.contains(type_id));
+          DCHECK(bldrs_ == nullptr ||
+                 std::holds_alternative<std::monostate>((*bldrs_)[type_id]));
           DCHECK(!check_duplicated_ids(array));
         },
         var);
@@ -377,22 +510,28 @@ DataSliceImpl DataSliceImpl::Builder::Build() && {
                                  std::monostate>) {
       DCHECK(false);
     } else {
-#ifndef NDEBUG
+      using T = typename decltype(bldr)::base_type;
       auto array = std::move(bldr).Build();
+#ifndef NDEBUG
       DCHECK(!check_duplicated_ids(array));
-      impl.values.emplace_back(std::move(array));
-#else
-      impl.values.emplace_back(std::move(bldr).Build());
 #endif  // NDEBUG
-      impl.dtype = arolla::GetQType<typename decltype(bldr)::base_type>();
+      if constexpr (std::is_same_v<T, ObjectId>) {
+        if (has_inserted_object_ids_) {
+          InsertAllocationIds(array, impl.allocation_ids);
+        }
+      }
+      impl.values.emplace_back(std::move(array));
+      impl.dtype = arolla::GetQType<T>();
     }
   };
   if (current_type_id_ != ScalarTypeId<MissingValue>()) {
     DCHECK(!std::holds_alternative<std::monostate>(*current_bldr_));
     std::visit(visitor, std::move(*current_bldr_));
-    if (!bldrs_.empty()) {
-      for (auto& [type_id, bldr] : bldrs_) {
-        if (type_id != current_type_id_) {
+    if (bldrs_ != nullptr) {
+      for (int8_t type_id = 0; type_id < bldrs_->size(); ++type_id) {
+        ArrayBuilderVariant& bldr = (*bldrs_)[type_id];
+        if (type_id != current_type_id_ &&
+            !std::holds_alternative<std::monostate>(bldr)) {
           std::visit(visitor, std::move(bldr));
         }
       }
@@ -402,8 +541,86 @@ DataSliceImpl DataSliceImpl::Builder::Build() && {
   return std::move(slice_);
 }
 
+namespace {
+
+// Returns true if `a` and `b` have the same size and are backed by the same
+// bitmap and values.
+template <typename T>
+bool SharesBuffers(const arolla::DenseArray<T>& a,
+                   const arolla::DenseArray<T>& b) {
+  if (a.size() != b.size() || a.bitmap_bit_offset != b.bitmap_bit_offset ||
+      a.bitmap.size() != b.bitmap.size() ||
+      a.bitmap.span().data() != b.bitmap.span().data()) {
+    return false;
+  }
+  if constexpr (std::is_same_v<T, arolla::Unit>) {
+    return true;
+  } else if constexpr (std::is_same_v<T, arolla::Text> ||
+                       std::is_same_v<T, arolla::Bytes>) {
+    return false;
+  } else {
+    return a.values.span().data() == b.values.span().data();
+  }
+}
+
+// Same as arolla::ArraysAreEquivalent, but compares presence a word at a
+// time, exits on the first mismatch, and compares the fully present words of
+// integral values with memcmp.
+template <typename T>
+bool DenseArraysAreEquivalent(const arolla::DenseArray<T>& a,
+                              const arolla::DenseArray<T>& b) {
+  using ::arolla::bitmap::kWordBitCount;
+  using ::arolla::bitmap::Word;
+  if (a.size() != b.size()) {
+    return false;
+  }
+  if (SharesBuffers(a, b)) {
+    return true;
+  }
+  const int64_t size = a.size();
+  for (int64_t word_begin = 0; word_begin < size;
+       word_begin += kWordBitCount) {
+    const int64_t count = std::min<int64_t>(kWordBitCount, size - word_begin);
+    const Word mask = count == kWordBitCount ? arolla::bitmap::kFullWord
+                                             : (Word{1} << count) - 1;
+    const Word presence =
+        arolla::bitmap::GetWordWithOffset(
+            a.bitmap, word_begin / kWordBitCount, a.bitmap_bit_offset) &
+        mask;
+    if (presence != (arolla::bitmap::GetWordWithOffset(
+                         b.bitmap, word_begin / kWordBitCount,
+                         b.bitmap_bit_offset) &
+                     mask)) {
+      return false;
+    }
+    if constexpr (std::is_same_v<T, arolla::Unit>) {
+      continue;
+    } else {
+      if constexpr (std::is_integral_v<T>) {
+        if (presence == mask) {
+          if (std::memcmp(a.values.span().data() + word_begin,
+                          b.values.span().data() + word_begin,
+                          count * sizeof(T)) != 0) {
+            return false;
+          }
+          continue;
+        }
+      }
+      for (int64_t i = 0; i < count; ++i) {
+        if ((presence >> i) & 1 &&
+            !(a.values[word_begin + i] == b.values[word_begin + i])) {
+          return false;
+        }
+      }
+    }
+  }
+  return true;
+}
+
+}  // namespace
+
 bool DataSliceImpl::IsEquivalentTo(const DataSliceImpl& other) const {
-  if (this == &other) {
+  if (this == &other || internal_.get() == other.internal_.get()) {
     return true;
   }
   if (size() != other.size()) {
@@ -414,7 +631,7 @@ bool DataSliceImpl::IsEquivalentTo(const DataSliceImpl& other) const {
     return std::visit(
         [&](const auto& arr) {
           using ArrT = std::decay_t<decltype(arr)>;
-          return arolla::ArraysAreEquivalent(
+          return DenseArraysAreEquivalent(
               arr, std::get<ArrT>(other.internal_->values[0]));
         },
         internal_->values[0]);
@@ -16,16 +16,19 @@
 #define KOLADATA_INTERNAL_DATA_SLICE_H_
 
 #include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <string>
 #include <type_traits>
 #include <utility>
 #include <variant>
 #include <vector>
 
-#include "absl/container/flat_hash_map.h"
+#include "absl/base/optimization.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/log/check.h"
@@ -119,6 +122,12 @@ class DataSliceImpl {
   // Returns true on all empty slices without known type.
   bool is_empty_and_unknown() const { return internal_->values.empty(); }
 
+  // Returns true if the slice is known to be exactly
+  // `[alloc.ObjectByOffset(0), ..., alloc.ObjectByOffset(size() - 1)]` for
+  // some `alloc`. Only slices created by `ObjectsFromAllocation` are marked, so
+  // `false` means "unknown".
+  bool is_allocation_prefix() const { return internal_->is_allocation_prefix; }
+
   // Returns QType of the content of the DataSliceImpl if all elements has the
   // same type or `GetNothingQType` otherwise. I.e. dtype() == NOTHING, when
   // either is_mixed_dtype() or is_empty_and_unknown() is true.
@@ -139,6 +148,26 @@ class DataSliceImpl {
     return std::get<arolla::DenseArray<T>>(internal_->values[0]);
   }
 
+  // Returns a reference to the underlying DenseArray if is_single_dtype() and
+  // the values are primitives, or std::nullopt otherwise. The reference is
+  // valid as long as this DataSliceImpl (or a copy of it) is alive.
+  //
+  // The result is memoized in the shared internal state, so repeated calls on
+  // the same slice (or its copies) neither dispatch on the type of the values
+  // nor copy them.
+  std::optional<arolla::TypedRef> typed_values() const {
+    arolla::QTypePtr qtype =
+        internal_->typed_values_qtype.load(std::memory_order_acquire);
+    if (ABSL_PREDICT_FALSE(qtype == nullptr)) {
+      qtype = InitTypedValues();
+    }
+    if (qtype == arolla::GetNothingQType()) {
+      return std::nullopt;
+    }
+    return arolla::TypedRef::UnsafeFromRawPointer(
+        qtype, internal_->typed_values_ptr.load(std::memory_order_relaxed));
+  }
+
   // Call `visitor` on each internal DenseArray of values. Each item is a
   // variant with a value of DenseArray of some of supported scalar types
   // (INT32, FLOAT32, TEXT, etc.). All DenseArrays have the same size, with
@@ -172,6 +201,35 @@ class DataSliceImpl {
   // Returns DataItem with given offset.
   DataItem operator[](int64_t offset) const;
 
+  // Value of row_value_indices() for missing items.
+  static constexpr uint8_t kMissingRow = 0xFF;
+
+  // Returns the index in VisitValues order of the DenseArray holding each
+  // item, or kMissingRow for missing items. Computed on the first call and
+  // memoized in the shared internal state. Intended for mixed slices, where it
+  // makes operator[] O(1) instead of O(number of dtypes). operator[] uses it
+  // once it is computed, and begin() computes it for mixed slices.
+  absl::Span<const uint8_t> row_value_indices() const {
+    const std::vector<uint8_t>* indices =
+        internal_->row_value_indices.load(std::memory_order_acquire);
+    return ABSL_PREDICT_TRUE(indices != nullptr) ? *indices
+                                                 : InitRowValueIndices();
+  }
+
+  // Returns the presence of the items as a DenseArray<Unit>. For single-dtype
+  // slices it shares the bitmap of the values. For mixed slices the bitmaps are
+  // united word by word on the first call and memoized in the shared internal
+  // state, so repeated kd.has() on the same slice is free.
+  arolla::DenseArray<arolla::Unit> presence() const {
+    if (internal_->values.size() <= 1) {
+      return SingleDTypePresence();
+    }
+    const arolla::DenseArray<arolla::Unit>* presence =
+        internal_->presence.load(std::memory_order_acquire);
+    return ABSL_PREDICT_TRUE(presence != nullptr) ? *presence
+                                                  : InitPresence();
+  }
+
   // Returns a DenseArray of DataItems for DataSlice's items.
   // Missing items in the DataSlice are converted to missings in the DenseArray
   // rather than empty DataItems.
@@ -182,6 +240,9 @@ class DataSliceImpl {
   using size_type = int64_t;
   using difference_type = int64_t;
   arolla::ConstArrayIterator<DataSliceImpl> begin() const {
+    if (internal_->values.size() > 1) {
+      row_value_indices();
+    }
     return arolla::ConstArrayIterator<DataSliceImpl>(this, 0);
   }
   arolla::ConstArrayIterator<DataSliceImpl> end() const {
@@ -260,8 +321,43 @@ class DataSliceImpl {
     // element at index `i` in one of the underlying DenseArrays. If no such
     // element is present, the DataSliceImpl element is considered missing.
     absl::InlinedVector<Variant, 1> values;
+
+    // See `is_allocation_prefix()`.
+    bool is_allocation_prefix = false;
+
+    // Memoized by `typed_values()`. `typed_values_qtype` is null until it is
+    // first computed, and NOTHING if there is no typed DenseArray view.
+    // `typed_values_ptr` is published before `typed_values_qtype`.
+    mutable std::atomic<const void*> typed_values_ptr = nullptr;
+    mutable std::atomic<arolla::QTypePtr> typed_values_qtype = nullptr;
+
+    // Memoized by `row_value_indices()`. Owned by Internal.
+    mutable std::atomic<const std::vector<uint8_t>*> row_value_indices =
+        nullptr;
+
+    // Memoized by `presence()` for mixed slices. Owned by Internal.
+    mutable std::atomic<const arolla::DenseArray<arolla::Unit>*> presence =
+        nullptr;
+
+    ~Internal() {
+      delete row_value_indices.load(std::memory_order_relaxed);
+      delete presence.load(std::memory_order_relaxed);
+    }
   };
 
+  // Computes and memoizes the result of `row_value_indices()`.
+  const std::vector<uint8_t>& InitRowValueIndices() const;
+
+  // Returns the result of `presence()` for slices with at most one dtype.
+  arolla::DenseArray<arolla::Unit> SingleDTypePresence() const;
+
+  // Computes and memoizes the result of `presence()` for mixed slices.
+  const arolla::DenseArray<arolla::Unit>& InitPresence() const;
+
+  // Computes and memoizes the result of `typed_values()`. Returns the QType of
+  // the typed DenseArray view, or NOTHING if there is none.
+  arolla::QTypePtr InitTypedValues() const;
+
   // Removes all values with all non present items.
   // Sets dtype to dtype of single value or GetNothingQType otherwise.
   void RemoveEmptyValues();
@@ -295,6 +391,9 @@ class DataSliceImpl::Builder {
     return std::get<arolla::DenseArrayBuilder<T>>(*current_bldr_);
   }
 
+  // Allocations of the ObjectIds set directly via GetArrayBuilder or added via
+  // AddArray must be inserted by the caller. The allocations of the ObjectIds
+  // inserted via Insert are computed in Build.
   AllocationIdSet& GetMutableAllocationIds() {
     return slice_.internal_->allocation_ids;
   }
@@ -315,12 +414,12 @@ class DataSliceImpl::Builder {
       if constexpr (arolla::meta::is_wrapped_with_v<DataItem::View, T>) {
         GetArrayBuilder<typename T::value_type>().Set(id, value.view);
         if constexpr (std::is_same_v<typename T::value_type, ObjectId>) {
-          GetMutableAllocationIds().Insert(AllocationId(value.view));
+          has_inserted_object_ids_ = true;
         }
       } else if constexpr (!std::is_same_v<T, MissingValue>) {
         GetArrayBuilder<T>().Set(id, value);
         if constexpr (std::is_same_v<T, ObjectId>) {
-          GetMutableAllocationIds().Insert(AllocationId(value));
+          has_inserted_object_ids_ = true;
         }
       }
     }
@@ -342,7 +441,15 @@ class DataSliceImpl::Builder {
   ArrayBuilderVariant first_bldr_;
   ArrayBuilderVariant* current_bldr_ = &first_bldr_;
   int8_t current_type_id_ = ScalarTypeId<MissingValue>();
-  absl::flat_hash_map<int8_t, ArrayBuilderVariant> bldrs_;
+  // Builders indexed by ScalarTypeId. Allocated when the second type is used,
+  // before that the only builder is `first_bldr_`.
+  std::unique_ptr<
+      std::array<ArrayBuilderVariant, std::variant_size_v<ScalarVariant>>>
+      bldrs_;
+  // True if Insert was called with an ObjectId. Inserting the allocations of
+  // all ObjectIds in one pass in Build is much cheaper than a set operation per
+  // inserted element.
+  bool has_inserted_object_ids_ = false;
 #ifndef NDEBUG
   // Used to check that all ids in Insert are unique.
   absl::flat_hash_set<int64_t> inserted_ids_;
@@ -34,6 +34,7 @@
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/memory/buffer.h"
 #include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/status_macros_backport.h"
 
 namespace koladata::internal {
 
@@ -88,13 +89,28 @@ absl::StatusOr<DataSliceImpl> GetAttributeFromSources(
     return absl::FailedPreconditionError(
         "Getting attribute from primitive (or mixed) values is not supported");
   }
+  for (const DenseSource* source : dense_sources) {
+    // Reports the loading errors of lazy sources.
+    RETURN_IF_ERROR(source->Load());
+  }
   const ObjectIdArray& objs = slice.values<ObjectId>();
   if (sparse_sources.empty()) {
     if (dense_sources.size() == 1) {
+      const DenseSource& source = *dense_sources.front();
+      // Column scan over objects created together: the result is a prefix of
+      // the source's values, so we can share buffers instead of gathering.
+      if (slice.is_allocation_prefix() &&
+          slice.allocation_ids().size() == 1 &&
+          slice.allocation_ids().ids()[0] == source.allocation_id()) {
+        if (std::optional<DataSliceImpl> res = source.GetPrefix(slice.size());
+            res.has_value()) {
+          return *std::move(res);
+        }
+      }
       bool check_alloc_id =
           slice.allocation_ids().contains_small_allocation_id() ||
           slice.allocation_ids().ids().size() > 1;
-      return dense_sources.front()->Get(objs, check_alloc_id);
+      return source.Get(objs, check_alloc_id);
     } else if (dense_sources.empty()) {
       return DataSliceImpl::CreateEmptyAndUnknownType(slice.size());
     }
@@ -33,7 +33,8 @@ using SparseSourceSpan = absl::Span<const SparseSource* const>;
 // source with lower index will override values of sources with higher indices.
 // Values from `sparse_sources` override `dense_sources`.
 // All `dense_sources` must correspond to different allocation ids, so the order
-// of dense sources is not important.
+// of dense sources is not important. Returns the loading errors of lazy
+// `dense_sources` (see DenseSource::Load).
 absl::StatusOr<DataSliceImpl> GetAttributeFromSources(
     const DataSliceImpl& slice, DenseSourceSpan dense_sources,
     SparseSourceSpan sparse_sources);
@@ -109,6 +109,51 @@ TEST(DataSliceAccessorsTest,
                           ds_a.values<ObjectId>()[5]));
 }
 
+TEST(DataSliceAccessorsTest, GetAttributeFromSources_AllocationPrefix) {
+  constexpr int64_t kSize = 10;
+  AllocationId alloc = Allocate(kSize);
+  auto values = arolla::CreateDenseArray<int>(
+      {1, std::nullopt, 3, 4, 5, 6, std::nullopt, 8, 9, 10});
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const DenseSource> source,
+      DenseSource::CreateReadonly(alloc, DataSliceImpl::Create(values)));
+
+  auto ds = DataSliceImpl::ObjectsFromAllocation(alloc, kSize);
+  EXPECT_TRUE(ds.is_allocation_prefix());
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl ds_a_get,
+                       GetAttributeFromSources(ds, {source.get()}, {}));
+  EXPECT_THAT(ds_a_get.values<int>(), ElementsAreArray(values));
+  // The buffer of the immutable source is shared.
+  EXPECT_EQ(ds_a_get.values<int>().values.span().data(),
+            values.values.span().data());
+
+  auto ds_prefix = DataSliceImpl::ObjectsFromAllocation(alloc, 3);
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl ds_prefix_get,
+                       GetAttributeFromSources(ds_prefix, {source.get()}, {}));
+  EXPECT_THAT(ds_prefix_get.values<int>(), ElementsAre(1, std::nullopt, 3));
+
+  // Filtering loses the flag, the regular path is used.
+  auto ds_f = DataSliceImpl::CreateObjectsDataSlice(
+      arolla::CreateFullDenseArray<ObjectId>(
+          {alloc.ObjectByOffset(0), alloc.ObjectByOffset(2)}),
+      AllocationIdSet(alloc));
+  EXPECT_FALSE(ds_f.is_allocation_prefix());
+  EXPECT_THAT(GetAttributeFromSources(ds_f, {source.get()}, {}),
+              ::absl_testing::IsOkAndHolds(ElementsAre(1, 3)));
+
+  // Results from a mutable source are not affected by later modifications.
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<DenseSource> mutable_source,
+      DenseSource::CreateMutable(alloc, kSize, arolla::GetQType<int>()));
+  ASSERT_OK(mutable_source->Set(ds.values<ObjectId>(),
+                                DataSliceImpl::Create(values)));
+  ASSERT_OK_AND_ASSIGN(
+      DataSliceImpl ds_mutable_get,
+      GetAttributeFromSources(ds, {mutable_source.get()}, {}));
+  ASSERT_OK(mutable_source->Set(alloc.ObjectByOffset(0), DataItem(7)));
+  EXPECT_THAT(ds_mutable_get.values<int>(), ElementsAreArray(values));
+}
+
 TEST(DataSliceAccessorsTest, GetAttributeFromSources_SingleSourcePrimitives) {
   constexpr int64_t kSize = 4;
   auto ds = DataSliceImpl::AllocateEmptyObjects(kSize);
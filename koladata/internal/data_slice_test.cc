@@ -41,6 +41,7 @@
 #include "arolla/util/bytes.h"
 #include "arolla/util/fingerprint.h"
 #include "arolla/util/meta.h"
+#include "arolla/util/text.h"
 
 namespace koladata::internal {
 namespace {
@@ -151,6 +152,32 @@ TEST(DataSliceImpl, Create) {
   EXPECT_THAT(ds.values<int64_t>(), ElementsAre(57, 75, 19));
 }
 
+TEST(DataSliceImpl, TypedValues) {
+  DataSliceImpl ds =
+      DataSliceImpl::Create(arolla::CreateFullDenseArray<int64_t>({57, 75}));
+  std::optional<arolla::TypedRef> ref = ds.typed_values();
+  ASSERT_TRUE(ref.has_value());
+  EXPECT_EQ(ref->GetType(), arolla::GetDenseArrayQType<int64_t>());
+  EXPECT_EQ(ref->GetRawPointer(), &ds.values<int64_t>());
+  EXPECT_THAT(ref->UnsafeAs<arolla::DenseArray<int64_t>>(),
+              ElementsAre(57, 75));
+  // The view is memoized and shared by the copies.
+  DataSliceImpl ds_copy = ds;
+  std::optional<arolla::TypedRef> copy_ref = ds_copy.typed_values();
+  ASSERT_TRUE(copy_ref.has_value());
+  EXPECT_EQ(copy_ref->GetRawPointer(), ref->GetRawPointer());
+
+  EXPECT_FALSE(
+      DataSliceImpl::CreateEmptyAndUnknownType(2).typed_values().has_value());
+  EXPECT_FALSE(
+      DataSliceImpl::AllocateEmptyObjects(2).typed_values().has_value());
+  EXPECT_FALSE(
+      DataSliceImpl::Create(CreateDenseArray<int>({1, std::nullopt}),
+                            CreateDenseArray<float>({std::nullopt, 2.f}))
+          .typed_values()
+          .has_value());
+}
+
 TEST(DataSliceImpl, CreateFromDataItemSpan) {
   {
     auto array = std::vector<DataItem>{};
@@ -625,6 +652,55 @@ TEST(DataSliceImpl, IsEquivalentTo) {
   EXPECT_FALSE(empty_and_unknown.IsEquivalentTo(mix_float_int));
 }
 
+TEST(DataSliceImpl, IsEquivalentToLarge) {
+  // Spans several bitmap words, with a partial last word.
+  constexpr int64_t kSize = 200;
+  arolla::DenseArrayBuilder<int64_t> full_bldr(kSize + 1);
+  arolla::DenseArrayBuilder<int64_t> sparse_bldr(kSize + 1);
+  arolla::DenseArrayBuilder<arolla::Text> text_bldr(kSize);
+  for (int64_t i = 0; i < kSize + 1; ++i) {
+    full_bldr.Set(i, i);
+    if (i % 3 != 0) {
+      sparse_bldr.Set(i, i);
+    }
+  }
+  for (int64_t i = 0; i < kSize; ++i) {
+    text_bldr.Set(i, arolla::Text(absl::StrCat(i)));
+  }
+  auto full = std::move(full_bldr).Build();
+  auto sparse = std::move(sparse_bldr).Build();
+  auto text = std::move(text_bldr).Build();
+
+  auto ds = DataSliceImpl::Create(full.Slice(0, kSize));
+  EXPECT_TRUE(ds.IsEquivalentTo(DataSliceImpl::Create(full.Slice(0, kSize))));
+  std::vector<int64_t> copy(full.values.span().begin(),
+                            full.values.span().begin() + kSize);
+  EXPECT_TRUE(ds.IsEquivalentTo(
+      DataSliceImpl::Create(arolla::CreateFullDenseArray(copy))));
+  EXPECT_FALSE(ds.IsEquivalentTo(DataSliceImpl::Create(full.Slice(1, kSize))));
+
+  // The values of the missing items are ignored, and the bitmaps with
+  // different offsets are compared by words.
+  auto sparse_ds = DataSliceImpl::Create(sparse.Slice(0, kSize));
+  EXPECT_FALSE(sparse_ds.IsEquivalentTo(ds));
+  EXPECT_FALSE(sparse_ds.IsEquivalentTo(
+      DataSliceImpl::Create(sparse.Slice(1, kSize))));
+  arolla::DenseArrayBuilder<int64_t> shifted_bldr(kSize + 1);
+  for (int64_t i = 0; i < kSize; ++i) {
+    if (i % 3 != 0) {
+      shifted_bldr.Set(i + 1, i);
+    }
+  }
+  auto shifted = std::move(shifted_bldr).Build().Slice(1, kSize);
+  EXPECT_TRUE(sparse_ds.IsEquivalentTo(DataSliceImpl::Create(shifted)));
+
+  auto text_ds = DataSliceImpl::Create(text);
+  EXPECT_TRUE(text_ds.IsEquivalentTo(DataSliceImpl::Create(text)));
+  auto other_text = arolla::CreateConstDenseArray<arolla::Text>(
+      kSize, arolla::Text("0"));
+  EXPECT_FALSE(text_ds.IsEquivalentTo(DataSliceImpl::Create(other_text)));
+}
+
 TEST(DataSliceImpl, Constructors) {
   {
     // Empty DataSliceImpl.
@@ -949,6 +1025,79 @@ TEST(DataSliceImpl, BuilderExprQuoteView) {
   EXPECT_THAT(ds, ElementsAre(DataItem(expr_quote), DataItem(expr_quote)));
 }
 
+TEST(DataSliceImpl, BuilderAllocationIds) {
+  AllocationId alloc1 = Allocate(10);
+  AllocationId alloc2 = Allocate(10);
+  AllocationId alloc3 = Allocate(10);
+  ObjectId small_obj = AllocateSingleObject();
+  DataSliceImpl::Builder bldr(8);
+  for (int64_t i = 0; i < 3; ++i) {
+    bldr.Insert(i, alloc1.ObjectByOffset(i));
+  }
+  bldr.Insert(3, DataItem(alloc2.ObjectByOffset(0)));
+  bldr.Insert(4, alloc1.ObjectByOffset(5));
+  bldr.Insert(5, DataItem(small_obj));
+  bldr.Insert(6, 57);
+  // Allocations of the ObjectIds set directly are provided by the caller.
+  bldr.GetArrayBuilder<ObjectId>().Set(7, alloc3.ObjectByOffset(1));
+  bldr.GetMutableAllocationIds().Insert(alloc3);
+  DataSliceImpl ds = std::move(bldr).Build();
+  AllocationIdSet expected({alloc1, alloc2, alloc3});
+  expected.InsertSmallAllocationId();
+  EXPECT_EQ(ds.allocation_ids(), expected);
+}
+
+TEST(DataSliceImpl, BuilderAlternatingTypes) {
+  constexpr int64_t kSize = 1000;
+  DataSliceImpl::Builder bldr(kSize);
+  std::vector<DataItem> expected(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    switch (i % 4) {
+      case 0:
+        expected[i] = DataItem(static_cast<int>(i));
+        break;
+      case 1:
+        expected[i] = DataItem(0.5f * i);
+        break;
+      case 2:
+        expected[i] = DataItem(arolla::Text(absl::StrCat(i)));
+        break;
+      default:
+        continue;
+    }
+    bldr.Insert(i, expected[i]);
+  }
+  DataSliceImpl ds = std::move(bldr).Build();
+  EXPECT_TRUE(ds.is_mixed_dtype());
+  EXPECT_THAT(ds, ElementsAreArray(expected));
+}
+
+TEST(DataSliceImpl, RowValueIndices) {
+  auto ds = DataSliceImpl::Create(
+      CreateDenseArray<int>({1, std::nullopt, std::nullopt, 4}),
+      CreateDenseArray<float>(
+          {std::nullopt, 2.5f, std::nullopt, std::nullopt}));
+  // Before and after the indices are computed.
+  EXPECT_EQ(ds[1], DataItem(2.5f));
+  std::vector<int> array_dtypes;
+  ds.VisitValues([&](const auto& array) {
+    array_dtypes.push_back(
+        std::is_same_v<typename std::decay_t<decltype(array)>::base_type, int>);
+  });
+  ASSERT_EQ(array_dtypes.size(), 2);
+  uint8_t int_index = array_dtypes[0] ? 0 : 1;
+  EXPECT_THAT(ds.row_value_indices(),
+              ElementsAre(int_index, 1 - int_index, DataSliceImpl::kMissingRow,
+                          int_index));
+  EXPECT_EQ(ds[0], DataItem(1));
+  EXPECT_EQ(ds[1], DataItem(2.5f));
+  EXPECT_EQ(ds[2], DataItem());
+  EXPECT_THAT(ds, ElementsAre(1, 2.5f, DataItem(), 4));
+  EXPECT_THAT(DataSliceImpl::Create(CreateDenseArray<int>({1, std::nullopt}))
+                  .row_value_indices(),
+              ElementsAre(0, DataSliceImpl::kMissingRow));
+}
+
 TEST(DataSliceImpl, MixedBuilder) {
   {
     // Mixed types, ObjectIds and missing values.
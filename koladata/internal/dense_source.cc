@@ -15,6 +15,7 @@
 #include "koladata/internal/dense_source.h"
 
 #include <algorithm>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <cstdlib>
@@ -28,9 +29,12 @@
 #include <vector>
 
 #include "absl/base/attributes.h"
+#include "absl/base/call_once.h"
 #include "absl/base/dynamic_annotations.h"
 #include "absl/base/nullability.h"
 #include "absl/base/optimization.h"
+#include "absl/base/prefetch.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/inlined_vector.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
@@ -42,6 +46,8 @@
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/large_buffer.h"
+#include "koladata/internal/memory_usage.h"
 #include "koladata/internal/missing_value.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/types.h"
@@ -71,9 +77,16 @@ using ::arolla::Unit;
 using ::arolla::bitmap::AlmostFullBuilder;
 using ::arolla::bitmap::Word;
 
+// Sources larger than this don't fit in the cache, so rows are prefetched
+// before they are gathered by batch lookups.
+constexpr size_t kPrefetchMinSourceBytes = 1 << 20;
+
 template <class T>
 class SimpleValueArray;
 
+template <class T>
+class PagedValueArray;
+
 class MaskValueArray;
 
 template <class T>
@@ -82,6 +95,9 @@ class ImmutableStringArray;
 template <class T>
 class MutableStringArray;
 
+template <class T>
+class DictEncodedStringArray;
+
 ABSL_ATTRIBUTE_NOINLINE void UpdateMergeConflictStatusWithDataItem(
     absl::Status& status, const DataItem& value, const DataItem& other_value) {
   if (!status.ok()) {
@@ -123,9 +139,14 @@ class SimpleValueArray {
 
   explicit SimpleValueArray(DenseArray<T> data) : data_(std::move(data)) {}
   explicit SimpleValueArray(size_t size)
-      : mutable_presence_(static_cast<Word*>(
-            calloc(arolla::bitmap::BitmapSize(size), sizeof(Word)))),
-        mutable_values_(new T[size]),
+      : presence_buffer_(AllocateLargeBuffer(
+            arolla::bitmap::BitmapSize(size) * sizeof(Word), /*zeroed=*/true)),
+        values_buffer_(kRawValues ? AllocateLargeBuffer(size * sizeof(T),
+                                                        /*zeroed=*/false)
+                                  : LargeBufferPtr()),
+        mutable_presence_(static_cast<Word*>(presence_buffer_.get())),
+        mutable_values_(kRawValues ? static_cast<T*>(values_buffer_.get())
+                                   : new T[size]),
         data_({Buffer<T>(nullptr, absl::Span<T>(mutable_values_, size)),
                Buffer<Word>(nullptr, absl::Span<Word>(
                                          mutable_presence_,
@@ -135,7 +156,9 @@ class SimpleValueArray {
 
   SimpleValueArray(const SimpleValueArray&) = delete;
   SimpleValueArray(SimpleValueArray&& other)
-      : mutable_presence_(other.mutable_presence_),
+      : presence_buffer_(std::move(other.presence_buffer_)),
+        values_buffer_(std::move(other.values_buffer_)),
+        mutable_presence_(other.mutable_presence_),
         mutable_values_(other.mutable_values_),
         data_(std::move(other.data_)) {
     other.mutable_values_ = nullptr;
@@ -143,9 +166,8 @@ class SimpleValueArray {
   }
 
   ~SimpleValueArray() {
-    if (IsMutable()) {
+    if constexpr (!kRawValues) {
       delete[] mutable_values_;
-      free(mutable_presence_);
     }
   }
 
@@ -156,30 +178,66 @@ class SimpleValueArray {
     return data_[offset];
   }
 
+  // Processes `objects` one bitmap word at a time. The inner loop has no
+  // unpredictable branches: values are gathered unconditionally (from offset 0
+  // for missing objects) and the presence word is accumulated with bit
+  // operations, which allows the compiler to unroll and vectorize it.
   template <bool CheckAllocId>
   DenseArray<T> Get(const ObjectIdArray& objects,
                     AllocationId obj_allocation_id) const {
-    AlmostFullBuilder bitmap_builder(objects.size());
-    typename Buffer<T>::Builder values_builder(objects.size());
+    const int64_t size = objects.size();
+    if (data_.size() == 0) {
+      return arolla::CreateEmptyDenseArray<T>(size);
+    }
+    const int64_t bitmap_size = arolla::bitmap::BitmapSize(size);
+    typename Buffer<T>::Builder values_builder(size);
+    Buffer<Word>::Builder bitmap_builder(bitmap_size);
+    T* out_values = values_builder.GetMutableSpan().data();
+    Word* out_bitmap = bitmap_builder.GetMutableSpan().data();
     const T* values = data_.values.span().data();
-
-    objects.ForEach([&](int64_t id, bool present, ObjectId obj) {
-      bool res_present = false;
-      int64_t offset = obj.Offset();
-      if constexpr (CheckAllocId) {
-        if (present && obj_allocation_id.Contains(obj)) {
-          res_present = data_.present(offset);
-          values_builder.Set(id, values[offset]);
+    const ObjectId* objs = objects.values.span().data();
+    const int64_t max_offset = data_.size() - 1;
+    const bool prefetch = data_.size() * sizeof(T) >= kPrefetchMinSourceBytes;
+
+    bool all_present = true;
+    for (int64_t word_id = 0; word_id < bitmap_size; ++word_id) {
+      const int64_t begin = word_id * arolla::bitmap::kWordBitCount;
+      const int64_t count =
+          std::min<int64_t>(arolla::bitmap::kWordBitCount, size - begin);
+      if (prefetch) {
+        // Rows of the next word are fetched while this one is gathered.
+        // Offsets of missing objects are arbitrary, so they are clamped.
+        const int64_t next_end =
+            std::min<int64_t>(size, begin + 2 * arolla::bitmap::kWordBitCount);
+        for (int64_t i = begin + count; i < next_end; ++i) {
+          absl::PrefetchToLocalCache(
+              values + std::min<int64_t>(objs[i].Offset(), max_offset));
         }
-      } else if (present) {
-        DCHECK(obj_allocation_id.Contains(obj));
-        res_present = data_.present(offset);
-        values_builder.Set(id, values[offset]);
       }
-      if (!res_present) {
-        bitmap_builder.AddMissed(id);
+      const Word objs_presence = arolla::bitmap::GetWordWithOffset(
+          objects.bitmap, word_id, objects.bitmap_bit_offset);
+      Word res_presence = 0;
+      for (int64_t i = 0; i < count; ++i) {
+        const ObjectId& obj = objs[begin + i];
+        bool valid = (objs_presence >> i) & 1;
+        if constexpr (CheckAllocId) {
+          valid = valid && obj_allocation_id.Contains(obj);
+        } else {
+          DCHECK(!valid || obj_allocation_id.Contains(obj));
+        }
+        int64_t offset = valid ? obj.Offset() : 0;
+        out_values[begin + i] = values[offset];
+        valid &= data_.present(offset);
+        res_presence |= static_cast<Word>(valid) << i;
       }
-    });
+      out_bitmap[word_id] = res_presence;
+      all_present &= count == arolla::bitmap::kWordBitCount
+                         ? res_presence == arolla::bitmap::kFullWord
+                         : res_presence == (Word{1} << count) - 1;
+    }
+    if (all_present) {
+      return DenseArray<T>{std::move(values_builder).Build()};
+    }
     return DenseArray<T>{std::move(values_builder).Build(),
                          std::move(bitmap_builder).Build()};
   }
@@ -259,6 +317,10 @@ class SimpleValueArray {
     }
   }
 
+  int64_t EstimateMemoryUsage() const {
+    return EstimateDenseArrayBytes(data_);
+  }
+
  private:
   // Updates presence bitmap of the array with new values computed from `vals`.
   void UpdatePresenceOr(const DenseArray<T>& vals) {
@@ -274,11 +336,171 @@ class SimpleValueArray {
     }
   }
 
+  // Values of trivial types are allocated as raw memory, so that the buffers
+  // of large allocations follow the huge page policy (see large_buffer.h).
+  static constexpr bool kRawValues =
+      std::is_trivially_default_constructible_v<T> &&
+      std::is_trivially_destructible_v<T>;
+
+  // Owners of the buffers of mutable arrays.
+  LargeBufferPtr presence_buffer_;
+  LargeBufferPtr values_buffer_;
   Word* mutable_presence_ = nullptr;
   T* mutable_values_ = nullptr;
   DenseArray<T> data_;
 };
 
+// Mutable ValueArray with the same value types as SimpleValueArray. Values
+// are stored in pages of kPageSize elements that are shared between copies
+// and copied on the first write, so CreateMutableCopy takes
+// O(size() / kPageSize) and a few writes to a copy cost O(kPageSize) each.
+// Pages created from an immutable SimpleValueArray are zero-copy slices of
+// its DenseArray.
+template <typename T>
+class PagedValueArray {
+ public:
+  using base_type = T;
+  static constexpr int64_t kPageSize = 4096;
+  static_assert(kPageSize % arolla::bitmap::kWordBitCount == 0);
+
+  explicit PagedValueArray(const SimpleValueArray<T>& src)
+      : size_(src.size()) {
+    const DenseArray<T>& data = src.GetAll();
+    pages_.reserve((size_ + kPageSize - 1) / kPageSize);
+    for (int64_t offset = 0; offset < size_; offset += kPageSize) {
+      SimpleValueArray<T> page(
+          data.Slice(offset, std::min(kPageSize, size_ - offset)));
+      // Buffers of a mutable array are not owned, so they can't be shared.
+      pages_.push_back(std::make_shared<SimpleValueArray<T>>(
+          src.IsMutable() ? page.CreateMutableCopy() : std::move(page)));
+    }
+  }
+
+  PagedValueArray(const PagedValueArray&) = delete;
+  PagedValueArray(PagedValueArray&&) = default;
+
+  size_t size() const { return size_; }
+  bool IsMutable() const { return true; }
+
+  arolla::OptionalValue<T> Get(int64_t offset) const {
+    return pages_[offset / kPageSize]->Get(offset % kPageSize);
+  }
+
+  template <bool CheckAllocId>
+  DenseArray<T> Get(const ObjectIdArray& objects,
+                    AllocationId obj_allocation_id) const {
+    arolla::DenseArrayBuilder<T> bldr(objects.size());
+    objects.ForEachPresent([&](int64_t id, ObjectId obj) {
+      if constexpr (CheckAllocId) {
+        if (!obj_allocation_id.Contains(obj)) {
+          return;
+        }
+      } else {
+        DCHECK(obj_allocation_id.Contains(obj));
+      }
+      if (auto v = Get(obj.Offset()); v.present) {
+        bldr.Set(id, v.value);
+      }
+    });
+    return std::move(bldr).Build();
+  }
+
+  // Unlike SimpleValueArray::GetAll, copies the values.
+  DenseArray<T> GetAll() const {
+    arolla::DenseArrayBuilder<T> bldr(size_);
+    int64_t offset = 0;
+    for (const auto& page : pages_) {
+      page->GetAll().ForEachPresent([&](int64_t i, arolla::view_type_t<T> v) {
+        bldr.Set(offset + i, v);
+      });
+      offset += kPageSize;
+    }
+    return std::move(bldr).Build();
+  }
+
+  void Set(size_t offset, T value) {
+    MutablePage(offset / kPageSize).Set(offset % kPageSize, value);
+  }
+
+  void Unset(size_t offset) {
+    MutablePage(offset / kPageSize).Unset(offset % kPageSize);
+  }
+
+  void MergeOverwrite(const DenseArray<T>& vals) {
+    ForEachPageSlice(vals, [](SimpleValueArray<T>& page,
+                              const DenseArray<T>& slice) {
+      page.MergeOverwrite(slice);
+    });
+  }
+
+  void MergeKeepOriginal(const DenseArray<T>& vals) {
+    ForEachPageSlice(vals, [](SimpleValueArray<T>& page,
+                              const DenseArray<T>& slice) {
+      page.MergeKeepOriginal(slice);
+    });
+  }
+
+  absl::Status MergeRaiseOnConflict(const DenseArray<T>& vals) {
+    absl::Status status = absl::OkStatus();
+    ForEachPageSlice(vals, [&](SimpleValueArray<T>& page,
+                               const DenseArray<T>& slice) {
+      status.Update(page.MergeRaiseOnConflict(slice));
+    });
+    return status;
+  }
+
+  PagedValueArray<T> CreateMutableCopy() const {
+    return PagedValueArray<T>(size_, pages_);
+  }
+
+  // Converts to SimpleValueArray to be stored in MultitypeDenseSource.
+  SimpleValueArray<T> ToSimpleValueArray() const {
+    return SimpleValueArray<T>(GetAll()).CreateMutableCopy();
+  }
+
+  // Pages shared with other copies are not included.
+  int64_t EstimateMemoryUsage() const {
+    int64_t bytes = pages_.capacity() * sizeof(pages_[0]);
+    for (const auto& page : pages_) {
+      if (page.use_count() == 1) {
+        bytes += page->EstimateMemoryUsage();
+      }
+    }
+    return bytes;
+  }
+
+ private:
+  PagedValueArray(int64_t size,
+                  std::vector<std::shared_ptr<SimpleValueArray<T>>> pages)
+      : size_(size), pages_(std::move(pages)) {}
+
+  SimpleValueArray<T>& MutablePage(int64_t page_id) {
+    auto& page = pages_[page_id];
+    if (!page->IsMutable() || page.use_count() > 1) {
+      page = std::make_shared<SimpleValueArray<T>>(page->CreateMutableCopy());
+    }
+    return *page;
+  }
+
+  // Calls `fn(page, slice)` with mutable pages and the corresponding slices
+  // of `vals`. Pages without present values in `vals` are skipped, so they
+  // stay shared.
+  template <class Fn>
+  void ForEachPageSlice(const DenseArray<T>& vals, Fn fn) {
+    DCHECK_LE(vals.size(), size_);
+    for (int64_t offset = 0; offset < vals.size(); offset += kPageSize) {
+      DenseArray<T> slice =
+          vals.Slice(offset, std::min(kPageSize, vals.size() - offset));
+      if (slice.PresentCount() > 0) {
+        fn(MutablePage(offset / kPageSize), slice);
+      }
+    }
+  }
+
+  int64_t size_;
+  std::vector<std::shared_ptr<SimpleValueArray<T>>> pages_;
+};
+
 // ValueArray for Unit values.
 class MaskValueArray {
  public:
@@ -286,8 +508,9 @@ class MaskValueArray {
 
   explicit MaskValueArray(DenseArray<Unit> data) : data_(std::move(data)) {}
   explicit MaskValueArray(size_t size)
-      : mutable_presence_(static_cast<Word*>(
-            calloc(arolla::bitmap::BitmapSize(size), sizeof(Word)))),
+      : presence_buffer_(AllocateLargeBuffer(
+            arolla::bitmap::BitmapSize(size) * sizeof(Word), /*zeroed=*/true)),
+        mutable_presence_(static_cast<Word*>(presence_buffer_.get())),
         data_({Buffer<Unit>(size),
                Buffer<Word>(nullptr, absl::Span<Word>(
                                          mutable_presence_,
@@ -295,17 +518,12 @@ class MaskValueArray {
 
   MaskValueArray(const MaskValueArray&) = delete;
   MaskValueArray(MaskValueArray&& other)
-      : mutable_presence_(other.mutable_presence_),
+      : presence_buffer_(std::move(other.presence_buffer_)),
+        mutable_presence_(other.mutable_presence_),
         data_(std::move(other.data_)) {
     other.mutable_presence_ = nullptr;
   }
 
-  ~MaskValueArray() {
-    if (IsMutable()) {
-      free(mutable_presence_);
-    }
-  }
-
   size_t size() const { return data_.size(); }
   bool IsMutable() const { return mutable_presence_ != nullptr; }
 
@@ -313,27 +531,42 @@ class MaskValueArray {
     return data_[offset];
   }
 
+  // Same approach as in SimpleValueArray::Get, but only presence is gathered.
   template <bool CheckAllocId>
   DenseArray<Unit> Get(const ObjectIdArray& objects,
                        AllocationId obj_allocation_id) const {
-    AlmostFullBuilder bitmap_builder(objects.size());
-    objects.ForEach([&](int64_t id, bool present, ObjectId obj) {
-      int64_t offset = obj.Offset();
-      if constexpr (CheckAllocId) {
-        if (!present || !obj_allocation_id.Contains(obj) ||
-            !data_.present(offset)) {
-          bitmap_builder.AddMissed(id);
-        }
-      } else {
-        DCHECK(!present || obj_allocation_id.Contains(obj));
-        if (!present || !data_.present(offset)) {
-          bitmap_builder.AddMissed(id);
+    const int64_t size = objects.size();
+    if (data_.size() == 0) {
+      return arolla::CreateEmptyDenseArray<Unit>(size);
+    }
+    const int64_t bitmap_size = arolla::bitmap::BitmapSize(size);
+    Buffer<Word>::Builder bitmap_builder(bitmap_size);
+    Word* out_bitmap = bitmap_builder.GetMutableSpan().data();
+    const ObjectId* objs = objects.values.span().data();
+    for (int64_t word_id = 0; word_id < bitmap_size; ++word_id) {
+      const int64_t begin = word_id * arolla::bitmap::kWordBitCount;
+      const int64_t count =
+          std::min<int64_t>(arolla::bitmap::kWordBitCount, size - begin);
+      const Word objs_presence = arolla::bitmap::GetWordWithOffset(
+          objects.bitmap, word_id, objects.bitmap_bit_offset);
+      Word res_presence = 0;
+      for (int64_t i = 0; i < count; ++i) {
+        const ObjectId& obj = objs[begin + i];
+        bool valid = (objs_presence >> i) & 1;
+        if constexpr (CheckAllocId) {
+          valid = valid && obj_allocation_id.Contains(obj);
+        } else {
+          DCHECK(!valid || obj_allocation_id.Contains(obj));
         }
+        int64_t offset = valid ? obj.Offset() : 0;
+        valid &= data_.present(offset);
+        res_presence |= static_cast<Word>(valid) << i;
       }
-    });
+      out_bitmap[word_id] = res_presence;
+    }
     return DenseArray<Unit>{
-      std::move(typename Buffer<Unit>::Builder(objects.size())).Build(),
-      std::move(bitmap_builder).Build()};
+        std::move(typename Buffer<Unit>::Builder(size)).Build(),
+        std::move(bitmap_builder).Build()};
   }
 
   const DenseArray<Unit>& GetAll() const { return data_; }
@@ -394,7 +627,12 @@ class MaskValueArray {
     }
   }
 
+  int64_t EstimateMemoryUsage() const {
+    return EstimateDenseArrayBytes(data_);
+  }
+
  private:
+  LargeBufferPtr presence_buffer_;
   Word* mutable_presence_ = nullptr;
   DenseArray<Unit> data_;
 };
@@ -516,6 +754,16 @@ class MutableStringArray {
     }
   }
 
+  int64_t EstimateMemoryUsage() const {
+    int64_t bytes = data_.capacity() * sizeof(data_[0]);
+    for (const auto& value : data_) {
+      if (value.has_value()) {
+        bytes += value->capacity();
+      }
+    }
+    return bytes;
+  }
+
  private:
   std::vector<std::optional<std::string>> data_;
 };
@@ -592,10 +840,172 @@ class ImmutableStringArray {
     return res;
   }
 
+  int64_t EstimateMemoryUsage() const {
+    return EstimateDenseArrayBytes(data_);
+  }
+
  private:
   DenseArray<T> data_;
 };
 
+// Immutable string array stored as codes into a pool of unique values. Used
+// by CreateReadonly for low cardinality attributes (e.g. enum-like strings),
+// so that each value takes only 4 bytes rather than offsets and characters.
+template <typename T>
+class DictEncodedStringArray {
+ public:
+  using base_type = T;
+
+  static_assert(std::is_same_v<absl::string_view, arolla::view_type_t<T>>);
+
+  // Minimal array size for which dictionary encoding is considered.
+  static constexpr int64_t kMinSize = 64;
+  // Dictionary encoding is used only if the number of unique values is at most
+  // `1 / kMinRepetitionRatio` of the array size.
+  static constexpr int64_t kMinRepetitionRatio = 8;
+  // Cardinality is checked on a prefix of this size first in order to quickly
+  // reject arrays with mostly unique values.
+  static constexpr int64_t kSampleSize = 1024;
+
+  // Returns nullopt if `data` has too many unique values.
+  static std::optional<DictEncodedStringArray> Create(
+      const DenseArray<T>& data) {
+    const int64_t size = data.size();
+    if (size < kMinSize) {
+      return std::nullopt;
+    }
+    const size_t max_pool_size = size / kMinRepetitionRatio;
+    absl::flat_hash_map<absl::string_view, int32_t> pool_index;
+    auto add_to_pool = [&](int64_t i) {
+      return pool_index.emplace(data.values[i], pool_index.size());
+    };
+    // The sample is checked before allocating the codes, so that arrays with
+    // mostly unique values are rejected cheaply.
+    const int64_t sample_size = std::min(size, kSampleSize);
+    for (int64_t i = 0; i < sample_size; ++i) {
+      if (data.present(i)) {
+        add_to_pool(i);
+      }
+    }
+    if (pool_index.size() * kMinRepetitionRatio > sample_size ||
+        pool_index.size() > max_pool_size) {
+      return std::nullopt;
+    }
+    Buffer<int32_t>::Builder codes_bldr(size);
+    absl::Span<int32_t> codes = codes_bldr.GetMutableSpan();
+    for (int64_t i = 0; i < size; ++i) {
+      if (!data.present(i)) {
+        codes[i] = 0;
+        continue;
+      }
+      auto [it, inserted] = add_to_pool(i);
+      if (inserted && pool_index.size() > max_pool_size) {
+        return std::nullopt;
+      }
+      codes[i] = it->second;
+    }
+    arolla::StringsBuffer::Builder pool_bldr(pool_index.size());
+    for (const auto& [value, code] : pool_index) {
+      pool_bldr.Set(code, value);
+    }
+    return DictEncodedStringArray(
+        DenseArray<int32_t>{std::move(codes_bldr).Build(), data.bitmap,
+                            data.bitmap_bit_offset},
+        DenseArray<T>{std::move(pool_bldr).Build()});
+  }
+
+  size_t size() const { return codes_.size(); }
+  bool IsMutable() const { return false; }
+
+  // Codes of the values: `pool()[codes()[i]]` is the i-th value.
+  const DenseArray<int32_t>& codes() const { return codes_; }
+  // Unique values, all present.
+  const DenseArray<T>& pool() const { return pool_; }
+
+  arolla::OptionalValue<absl::string_view> Get(int64_t offset) const {
+    if (!codes_.present(offset)) {
+      return std::nullopt;
+    }
+    return pool_.values[codes_.values[offset]];
+  }
+
+  template <bool CheckAllocId>
+  DenseArray<T> Get(const ObjectIdArray& objects,
+                    AllocationId obj_allocation_id) const {
+    AlmostFullBuilder bitmap_builder(objects.size());
+    arolla::StringsBuffer::ReshuffleBuilder values_builder(
+        objects.size(), pool_.values, std::nullopt);
+
+    objects.ForEach([&](int64_t id, bool present, ObjectId obj) {
+      bool res_present = false;
+      if constexpr (CheckAllocId) {
+        present = present && obj_allocation_id.Contains(obj);
+      } else {
+        DCHECK(!present || obj_allocation_id.Contains(obj));
+      }
+      if (present) {
+        int64_t offset = obj.Offset();
+        res_present = codes_.present(offset);
+        if (res_present) {
+          values_builder.CopyValue(id, codes_.values[offset]);
+        }
+      }
+      if (!res_present) {
+        bitmap_builder.AddMissed(id);
+      }
+    });
+    return DenseArray<T>{std::move(values_builder).Build(),
+                         std::move(bitmap_builder).Build()};
+  }
+
+  // The result shares characters with the pool.
+  DenseArray<T> GetAll() const {
+    arolla::StringsBuffer::ReshuffleBuilder values_builder(
+        codes_.size(), pool_.values, std::nullopt);
+    codes_.ForEachPresent([&](int64_t offset, int32_t code) {
+      values_builder.CopyValue(offset, code);
+    });
+    return DenseArray<T>{std::move(values_builder).Build(), codes_.bitmap,
+                         codes_.bitmap_bit_offset};
+  }
+
+  void Set(size_t offset, absl::string_view value) {
+    LOG(FATAL) << "DictEncodedStringArray::Set is not allowed";
+  }
+  void Unset(size_t offset) {
+    LOG(FATAL) << "DictEncodedStringArray::Unset is not allowed";
+  }
+  void MergeOverwrite(const DenseArray<T>& vals) {
+    LOG(FATAL) << "DictEncodedStringArray::MergeOverwrite is not allowed";
+  }
+  void MergeKeepOriginal(const DenseArray<T>& vals) {
+    LOG(FATAL) << "DictEncodedStringArray::MergeKeepOriginal is not allowed";
+  }
+  absl::Status MergeRaiseOnConflict(const DenseArray<T>& vals) {
+    return absl::FailedPreconditionError(
+        "DictEncodedStringArray::MergeRaiseOnConflict is not allowed");
+  }
+
+  MutableStringArray<T> CreateMutableCopy() const {
+    MutableStringArray<T> res(codes_.size());
+    codes_.ForEachPresent([&](int64_t offset, int32_t code) {
+      res.Set(offset, pool_.values[code]);
+    });
+    return res;
+  }
+
+  int64_t EstimateMemoryUsage() const {
+    return EstimateDenseArrayBytes(codes_) + EstimateDenseArrayBytes(pool_);
+  }
+
+ private:
+  DictEncodedStringArray(DenseArray<int32_t> codes, DenseArray<T> pool)
+      : codes_(std::move(codes)), pool_(std::move(pool)) {}
+
+  DenseArray<int32_t> codes_;
+  DenseArray<T> pool_;
+};
+
 // It is batch version of ValueArray::Set. Implemented as a free function
 // because it is common for all ValueArray implementations.
 // `objects` and `values` must have the same size.
@@ -735,6 +1145,24 @@ class MultitypeDenseSource : public DenseSource {
     }
   }
 
+  std::optional<DataSliceImpl> GetPrefix(int64_t size) const final {
+    if (size > size_) {
+      return std::nullopt;
+    }
+    DataSliceImpl::Builder bldr(size);
+    bldr.GetMutableAllocationIds().Insert(attr_allocation_ids_);
+    for (const ValueArrayVariant& var : values_) {
+      std::visit(
+          [&](const auto& value_array) {
+            auto array = value_array.GetAll().Slice(0, size);
+            bldr.AddArray(value_array.IsMutable() ? array.MakeOwned()
+                                                  : std::move(array));
+          },
+          var);
+    }
+    return std::move(bldr).Build();
+  }
+
   DataSliceImpl GetAll() const final {
     DataSliceImpl::Builder bldr(size_);
     bldr.GetMutableAllocationIds().Insert(attr_allocation_ids_);
@@ -947,6 +1375,16 @@ class MultitypeDenseSource : public DenseSource {
     return res;
   }
 
+  int64_t EstimateMemoryUsage() const final {
+    int64_t bytes = 0;
+    for (const ValueArrayVariant& vals : values_) {
+      std::visit(
+          [&](const auto& val_arr) { bytes += val_arr.EstimateMemoryUsage(); },
+          vals);
+    }
+    return bytes;
+  }
+
  private:
   friend class MultitypeDenseSource</*can_be_mutable=*/false>;
 
@@ -1088,6 +1526,27 @@ class TypedDenseSource final : public DenseSource {
     });
   }
 
+  std::optional<DataSliceImpl> GetPrefix(int64_t size) const final {
+    if (multitype_) {
+      return multitype_->GetPrefix(size);
+    }
+    if (size > this->size()) {
+      return std::nullopt;
+    }
+    // Buffers of mutable arrays are not owned and can change later, so they
+    // are copied. For immutable arrays it is a zero-copy slice.
+    DenseArray<T> res = values_.GetAll().Slice(0, size);
+    if (values_.IsMutable()) {
+      res = res.MakeOwned();
+    }
+    if constexpr (std::is_same_v<T, ObjectId>) {
+      return DataSliceImpl::CreateWithAllocIds(attr_allocation_ids_,
+                                               std::move(res));
+    } else {
+      return DataSliceImpl::Create(std::move(res));
+    }
+  }
+
   DataSliceImpl GetAll() const final {
     if (multitype_) {
       return multitype_->GetAll();
@@ -1218,13 +1677,40 @@ class TypedDenseSource final : public DenseSource {
 
   std::shared_ptr<DenseSource> CreateMutableCopy() const final;
 
+  bool HasCheapMutableCopy() const final {
+    if (multitype_) {
+      return false;
+    }
+    if constexpr (std::is_same_v<ValueArray, PagedValueArray<T>>) {
+      return true;
+    } else if constexpr (std::is_same_v<ValueArray, SimpleValueArray<T>>) {
+      return !values_.IsMutable();
+    } else {
+      return false;
+    }
+  }
+
+  int64_t EstimateMemoryUsage() const final {
+    if (multitype_) {
+      return multitype_->EstimateMemoryUsage();
+    }
+    return values_.EstimateMemoryUsage();
+  }
+
  private:
   template <class OtherT, class OtherValueArray>
   friend class TypedDenseSource;
 
   void CreateMultitype() {
-    if constexpr (std::is_same_v<ValueArray,
-                                 decltype(values_.CreateMutableCopy())>) {
+    if constexpr (std::is_same_v<ValueArray, PagedValueArray<T>>) {
+      multitype_ =
+          std::make_unique<MultitypeDenseSource</*can_be_mutable=*/true>>(
+              obj_allocation_id_, size());
+      multitype_->attr_allocation_ids_ = std::move(attr_allocation_ids_);
+      multitype_->values_.emplace_back(values_.ToSimpleValueArray());
+    } else if constexpr (std::is_same_v<
+                             ValueArray,
+                             decltype(values_.CreateMutableCopy())>) {
       multitype_ =
           std::make_unique<MultitypeDenseSource</*can_be_mutable=*/true>>(
               obj_allocation_id_, size());
@@ -1244,6 +1730,10 @@ std::shared_ptr<DenseSource>
 TypedDenseSource<T, ValueArray>::CreateMutableCopy() const {
   if (multitype_) {
     return multitype_->CreateMutableCopy();
+  } else if constexpr (std::is_same_v<ValueArray, SimpleValueArray<T>>) {
+    return std::make_shared<TypedDenseSource<T, PagedValueArray<T>>>(
+        obj_allocation_id_, attr_allocation_ids_,
+        PagedValueArray<T>(values_));
   } else {
     using can_be_mutableValueArray = decltype(values_.CreateMutableCopy());
     return std::make_shared<TypedDenseSource<T, can_be_mutableValueArray>>(
@@ -1251,8 +1741,285 @@ TypedDenseSource<T, ValueArray>::CreateMutableCopy() const {
   }
 }
 
+// Readonly DenseSource with the same value for all objects. Takes O(1)
+// memory; the values are only materialized when they are returned as an array
+// or when a mutable copy is created (e.g. on the first Set).
+template <class T>
+class ConstantDenseSource final : public DenseSource {
+ public:
+  ConstantDenseSource(AllocationId obj_allocation_id, int64_t size, T value)
+      : obj_allocation_id_(obj_allocation_id),
+        size_(size),
+        value_(std::move(value)) {
+    DCHECK_LE(size, obj_allocation_id_.Capacity());
+    if constexpr (std::is_same_v<T, ObjectId>) {
+      attr_allocation_ids_.Insert(AllocationId(value_));
+    }
+  }
+
+  AllocationId allocation_id() const final { return obj_allocation_id_; }
+  int64_t size() const final { return size_; }
+
+  DataItem Get(ObjectId object) const final {
+    DCHECK(obj_allocation_id_.Contains(object));
+    return DataItem(value_);
+  }
+
+  DataSliceImpl Get(const ObjectIdArray& objects,
+                    bool check_alloc_id) const final {
+    if (!check_alloc_id) {
+      // The values are broadcasted to the presence of `objects`.
+      return CreateSlice(DenseArray<T>{
+          arolla::CreateConstDenseArray<T>(objects.size(), value_).values,
+          objects.bitmap, objects.bitmap_bit_offset});
+    }
+    arolla::DenseArrayBuilder<T> bldr(objects.size());
+    objects.ForEachPresent([&](int64_t i, ObjectId id) {
+      if (obj_allocation_id_.Contains(id)) {
+        bldr.Set(i, value_);
+      }
+    });
+    return CreateSlice(std::move(bldr).Build());
+  }
+
+  void Get(const ObjectIdArray& objects,
+           DataSliceImpl::Builder& slice_bldr) const final {
+    if constexpr (std::is_same_v<T, ObjectId>) {
+      slice_bldr.GetMutableAllocationIds().Insert(attr_allocation_ids_);
+    }
+    auto& bldr = slice_bldr.GetArrayBuilder<T>();
+    objects.ForEachPresent([&](int64_t i, ObjectId id) {
+      if (obj_allocation_id_.Contains(id)) {
+        bldr.Set(i, value_);
+      }
+    });
+  }
+
+  std::optional<DataSliceImpl> GetPrefix(int64_t size) const final {
+    if (size > size_) {
+      return std::nullopt;
+    }
+    return CreateSlice(arolla::CreateConstDenseArray<T>(size, value_));
+  }
+
+  DataSliceImpl GetAll() const final {
+    return CreateSlice(arolla::CreateConstDenseArray<T>(size_, value_));
+  }
+
+  bool IsMutable() const final { return false; }
+
+  absl::Status Set(ObjectId object, const DataItem& value) final {
+    return absl::FailedPreconditionError(
+        "SetAttr is not allowed for an immutable DenseSource.");
+  }
+
+  absl::Status Set(const ObjectIdArray& objects,
+                   const DataSliceImpl& values) final {
+    return absl::FailedPreconditionError(
+        "SetAttr is not allowed for an immutable DenseSource.");
+  }
+
+  absl::Status SetUnitAndUpdateMissingObjects(
+      const ObjectIdArray& objects,
+      std::vector<ObjectId>& missing_objects) final {
+    return absl::FailedPreconditionError(
+        "SetUnitAndUpdateMissingObjects is not allowed for an immutable "
+        "DenseSource.");
+  }
+
+  absl::Status SetAllSkipMissing(const DataSliceImpl& values,
+                                 ConflictHandlingOption option) final {
+    return absl::FailedPreconditionError(
+        "SetAttr is not allowed for an immutable DenseSource.");
+  }
+
+  std::shared_ptr<DenseSource> CreateMutableCopy() const final {
+    auto res = std::make_shared<
+        TypedDenseSource<T, ValueArray<T, /*can_be_mutable=*/true>>>(
+        obj_allocation_id_, size_);
+    absl::Status status =
+        res->SetAllSkipMissing(GetAll(), ConflictHandlingOption::kOverwrite);
+    DCHECK_OK(status);
+    return res;
+  }
+
+  int64_t EstimateMemoryUsage() const final {
+    if constexpr (std::is_same_v<T, arolla::Text> ||
+                  std::is_same_v<T, arolla::Bytes>) {
+      return sizeof(T) + arolla::view_type_t<T>(value_).size();
+    } else {
+      return sizeof(T);
+    }
+  }
+
+ private:
+  DataSliceImpl CreateSlice(DenseArray<T> values) const {
+    if constexpr (std::is_same_v<T, ObjectId>) {
+      return DataSliceImpl::CreateWithAllocIds(attr_allocation_ids_,
+                                               std::move(values));
+    } else {
+      return DataSliceImpl::Create(std::move(values));
+    }
+  }
+
+  AllocationId obj_allocation_id_;
+  int64_t size_;
+  T value_;
+  AllocationIdSet attr_allocation_ids_;
+};
+
+// Readonly DenseSource that calls the loader on the first access and then
+// forwards all the calls to a readonly DenseSource with the loaded values.
+class LazyDenseSource final : public DenseSource {
+ public:
+  LazyDenseSource(AllocationId alloc, Loader loader)
+      : alloc_(alloc), loader_(std::move(loader)) {}
+
+  AllocationId allocation_id() const final { return alloc_; }
+  int64_t size() const final { return Loaded().size(); }
+
+  DataItem Get(ObjectId object) const final { return Loaded().Get(object); }
+
+  DataSliceImpl Get(const ObjectIdArray& objects,
+                    bool check_alloc_id) const final {
+    return Loaded().Get(objects, check_alloc_id);
+  }
+
+  void Get(const ObjectIdArray& objects,
+           DataSliceImpl::Builder& bldr) const final {
+    Loaded().Get(objects, bldr);
+  }
+
+  std::optional<DataSliceImpl> GetPrefix(int64_t size) const final {
+    return Loaded().GetPrefix(size);
+  }
+
+  DataSliceImpl GetAll() const final {
+    const DenseSource& source = Loaded();
+    // The loaded source is readonly, so its prefix shares the buffers.
+    if (std::optional<DataSliceImpl> values = source.GetPrefix(source.size());
+        values.has_value()) {
+      return *std::move(values);
+    }
+    return DataSliceImpl::CreateEmptyAndUnknownType(source.size());
+  }
+
+  bool IsMutable() const final { return false; }
+
+  absl::Status Set(ObjectId object, const DataItem& value) final {
+    return absl::FailedPreconditionError(
+        "SetAttr is not allowed for an immutable DenseSource.");
+  }
+
+  absl::Status Set(const ObjectIdArray& objects,
+                   const DataSliceImpl& values) final {
+    return absl::FailedPreconditionError(
+        "SetAttr is not allowed for an immutable DenseSource.");
+  }
+
+  absl::Status SetUnitAndUpdateMissingObjects(
+      const ObjectIdArray& objects,
+      std::vector<ObjectId>& missing_objects) final {
+    return absl::FailedPreconditionError(
+        "SetUnitAndUpdateMissingObjects is not allowed for an immutable "
+        "DenseSource.");
+  }
+
+  absl::Status SetAllSkipMissing(const DataSliceImpl& values,
+                                 ConflictHandlingOption option) final {
+    return absl::FailedPreconditionError(
+        "SetAttr is not allowed for an immutable DenseSource.");
+  }
+
+  std::shared_ptr<DenseSource> CreateMutableCopy() const final {
+    return Loaded().CreateMutableCopy();
+  }
+
+  bool HasCheapMutableCopy() const final {
+    return Loaded().HasCheapMutableCopy();
+  }
+
+  // Doesn't trigger the loading: the values that are not loaded yet take no
+  // memory.
+  int64_t EstimateMemoryUsage() const final {
+    return is_loaded_.load(std::memory_order_acquire)
+               ? source_->EstimateMemoryUsage()
+               : 0;
+  }
+
+  absl::Status Load() const final {
+    Loaded();
+    return status_;
+  }
+
+ private:
+  const DenseSource& Loaded() const {
+    absl::call_once(once_, [this] { LoadOnce(); });
+    return *source_;
+  }
+
+  void LoadOnce() const {
+    absl::StatusOr<DataSliceImpl> values = std::move(loader_)();
+    // Releases the encoded data held by the loader.
+    loader_ = nullptr;
+    absl::StatusOr<std::shared_ptr<DenseSource>> source = CreateSource(values);
+    if (!source.ok()) {
+      status_ = std::move(source).status();
+      // Only the status-returning readers (see Load) see the error.
+      source = DenseSource::CreateMutable(alloc_, 0);
+    }
+    source_ = *std::move(source);
+    is_loaded_.store(true, std::memory_order_release);
+  }
+
+  absl::StatusOr<std::shared_ptr<DenseSource>> CreateSource(
+      const absl::StatusOr<DataSliceImpl>& values) const {
+    if (!values.ok()) {
+      return values.status();
+    }
+    if (values->size() > alloc_.Capacity()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("loaded values don't fit into the allocation: ",
+                       values->size(), " > ", alloc_.Capacity()));
+    }
+    if (values->is_empty_and_unknown()) {
+      return DenseSource::CreateMutable(alloc_, values->size());
+    }
+    return DenseSource::CreateReadonly(alloc_, *values);
+  }
+
+  AllocationId alloc_;
+  mutable absl::once_flag once_;
+  mutable Loader loader_;
+  // Holds the only copy of the loaded values.
+  mutable std::shared_ptr<const DenseSource> source_;
+  mutable absl::Status status_;
+  mutable std::atomic<bool> is_loaded_ = false;
+};
+
 }  // namespace
 
+absl::StatusOr<std::shared_ptr<DenseSource>> DenseSource::CreateConstant(
+    AllocationId alloc, int64_t size, const DataItem& value) {
+  if (size > alloc.Capacity()) {
+    return absl::FailedPreconditionError(absl::StrCat(
+        "data slice exceed capacity: ", size, " > ", alloc.Capacity()));
+  }
+  if (!value.has_value()) {
+    return absl::FailedPreconditionError(
+        "Missing values should be handled at a higher-level: "
+        "DataBagImpl::SourceCollection");
+  }
+  return value.VisitValue(
+      [&]<class T>(const T& v) -> absl::StatusOr<std::shared_ptr<DenseSource>> {
+        if constexpr (std::is_same_v<T, MissingValue>) {
+          ABSL_UNREACHABLE();
+        } else {
+          return std::make_shared<ConstantDenseSource<T>>(alloc, size, v);
+        }
+      });
+}
+
 absl::StatusOr<std::shared_ptr<DenseSource>> DenseSource::CreateReadonly(
     AllocationId alloc, const DataSliceImpl& data) {
   if (data.size() > alloc.Capacity()) {
@@ -1281,6 +2048,29 @@ absl::StatusOr<std::shared_ptr<DenseSource>> DenseSource::CreateReadonly(
   return res;
 }
 
+absl::StatusOr<std::shared_ptr<DenseSource>>
+DenseSource::CreateDictEncodedReadonly(AllocationId alloc,
+                                       const DataSliceImpl& data) {
+  if (data.size() <= alloc.Capacity() && !data.is_mixed_dtype()) {
+    std::shared_ptr<DenseSource> res = nullptr;
+    data.VisitValues([&](const auto& array) {
+      using T = typename std::decay_t<decltype(array)>::base_type;
+      if constexpr (std::is_same_v<arolla::view_type_t<T>,
+                                   absl::string_view>) {
+        if (auto encoded = DictEncodedStringArray<T>::Create(array)) {
+          res =
+              std::make_shared<TypedDenseSource<T, DictEncodedStringArray<T>>>(
+                  alloc, data.allocation_ids(), *std::move(encoded));
+        }
+      }
+    });
+    if (res) {
+      return res;
+    }
+  }
+  return CreateReadonly(alloc, data);
+}
+
 absl::StatusOr<std::shared_ptr<DenseSource>> DenseSource::CreateMutable(
     AllocationId alloc, int64_t size,
     absl::Nullable<const arolla::QType*> main_type) {
@@ -1303,4 +2093,9 @@ absl::StatusOr<std::shared_ptr<DenseSource>> DenseSource::CreateMutable(
   return res;
 }
 
+std::shared_ptr<DenseSource> DenseSource::CreateLazy(AllocationId alloc,
+                                                    Loader loader) {
+  return std::make_shared<LazyDenseSource>(alloc, std::move(loader));
+}
+
 }  // namespace koladata::internal
@@ -17,9 +17,11 @@
 
 #include <cstdint>
 #include <memory>
+#include <optional>
 #include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/functional/any_invocable.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -61,6 +63,13 @@ class DenseSource {
   virtual void Get(const ObjectIdArray& objects,
                    DataSliceImpl::Builder& bldr) const = 0;
 
+  // Returns values of objects `allocation_id().ObjectByOffset(i)` for i in
+  // [0, size), i.e. the result of `Get` for a slice with
+  // `is_allocation_prefix()`. Immutable sources return a view sharing buffers
+  // with the DenseSource, so no per-element gather is needed. Returns
+  // std::nullopt if the fast path is not applicable (e.g. size > size()).
+  virtual std::optional<DataSliceImpl> GetPrefix(int64_t size) const = 0;
+
   // Returns true if DenseSource allow mutation.
   // Returns false in the following cases (not exhaustive):
   //   * Shares data with other immutable data structures.
@@ -100,15 +109,53 @@ class DenseSource {
 
   virtual std::shared_ptr<DenseSource> CreateMutableCopy() const = 0;
 
+  // Returns true if CreateMutableCopy doesn't copy the values: the copy
+  // shares pages with this source and copies a page only on the first write
+  // to it. Such a copy is cheaper than a SparseSource overlay for small
+  // updates.
+  virtual bool HasCheapMutableCopy() const { return false; }
+
+  // Returns the estimated number of bytes used by the values of the
+  // DenseSource, see MemoryUsage.
+  virtual int64_t EstimateMemoryUsage() const = 0;
+
+  // Makes sure the values are available and returns an error if they can not
+  // be loaded, see CreateLazy. Always OK for the other sources.
+  virtual absl::Status Load() const { return absl::OkStatus(); }
+
   static absl::StatusOr<std::shared_ptr<DenseSource>> CreateReadonly(
       AllocationId alloc, const DataSliceImpl& data);
 
+  // Same as CreateReadonly, but Text and Bytes values with few distinct values
+  // are stored dictionary encoded: each distinct value once plus an int32 code
+  // per object. Unlike CreateReadonly it copies the values, so it is meant for
+  // the sources built by DataBagImpl::CreateOptimized.
+  static absl::StatusOr<std::shared_ptr<DenseSource>>
+  CreateDictEncodedReadonly(AllocationId alloc, const DataSliceImpl& data);
+
+  // Returns a readonly DenseSource with `value` for all objects with offsets
+  // in [0, size). Takes O(1) memory. `value` must be present.
+  static absl::StatusOr<std::shared_ptr<DenseSource>> CreateConstant(
+      AllocationId alloc, int64_t size, const DataItem& value);
+
   // `main_type` is optional. When specified the DataSource will work faster if
   // there are no values of other types (and slower if there are).
   static absl::StatusOr<std::shared_ptr<DenseSource>> CreateMutable(
       AllocationId alloc, int64_t size,
       absl::Nullable<const arolla::QType*> main_type = nullptr);
 
+  // Produces the values of objects `alloc.ObjectByOffset(i)` for i in
+  // [0, values.size()).
+  using Loader = absl::AnyInvocable<absl::StatusOr<DataSliceImpl>() &&>;
+
+  // Returns a readonly DenseSource whose values are produced by `loader` on
+  // the first access (including size()), e.g. decoded from a serialized chunk.
+  // Thread-safe. A failure of `loader` is returned by Load(), which the
+  // status-returning readers (e.g. GetAttributeFromSources) call before
+  // reading; the other accessors see no values in this case.
+  static std::shared_ptr<DenseSource> CreateLazy(AllocationId alloc,
+                                                 Loader loader);
+
  private:
   // It is private because it can return internal data of a mutable
   // DenseSource. The returned DataSliceImpl is not guaranteed to be immutable.
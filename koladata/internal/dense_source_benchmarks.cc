@@ -128,6 +128,11 @@ BENCHMARK(BM_AttributeAccess<int32_t, BatchAccess>)
 BENCHMARK(BM_AttributeAccess<int32_t, PointwiseAccess>)
     ->Apply(kPointwiseBenchmarkPrimitiveBatchPairsFn);
 
+BENCHMARK(BM_AttributeAccess<int64_t, BatchAccess>)
+    ->Apply(kBenchmarkPrimitiveBatchPairsFn);
+BENCHMARK(BM_AttributeAccess<double, BatchAccess>)
+    ->Apply(kBenchmarkPrimitiveBatchPairsFn);
+
 BENCHMARK(BM_AttributeAccess<arolla::Bytes, BatchAccess>)
     ->Apply(kBenchmarkPrimitiveBatchPairsFn);
 BENCHMARK(BM_AttributeAccess<arolla::Bytes, PointwiseAccess>)
@@ -14,9 +14,11 @@
 //
 #include "koladata/internal/dense_source.h"
 
+#include <cstddef>
 #include <cstdint>
 #include <memory>
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -24,11 +26,13 @@
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/large_buffer.h"
 #include "koladata/internal/object_id.h"
 #include "arolla/dense_array/bitmap.h"
 #include "arolla/dense_array/dense_array.h"
@@ -53,6 +57,7 @@ using ::arolla::DenseArray;
 using ::arolla::Unit;
 using ::arolla::bitmap::Word;
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::HasSubstr;
 
 TEST(DenseSourceTest, ObjectAttrSimple) {
@@ -189,6 +194,78 @@ TEST(DenseSourceTest, PrimitiveAttrSimple) {
               ElementsAre(3, std::nullopt, 9, 3));
 }
 
+TEST(DenseSourceTest, MutableWithHugePageBuffers) {
+  size_t previous_threshold = SetHugePageBufferThreshold(kHugePageSize);
+  constexpr int64_t kSize = 1 << 20;
+  AllocationId alloc = Allocate(kSize);
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<DenseSource> ds,
+                       DenseSource::CreateMutable(alloc, kSize));
+  ASSERT_OK(ds->Set(alloc.ObjectByOffset(5), DataItem(int64_t{7})));
+  ASSERT_OK(ds->Set(alloc.ObjectByOffset(kSize - 1), DataItem(int64_t{9})));
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(5)), DataItem(int64_t{7}));
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(kSize - 1)), DataItem(int64_t{9}));
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(6)), DataItem());
+  SetHugePageBufferThreshold(previous_threshold);
+}
+
+TEST(DenseSourceTest, BatchGetAcrossBitmapWords) {
+  constexpr int64_t kSize = 100;
+  AllocationId alloc = Allocate(kSize);
+  AllocationId other_alloc = Allocate(kSize);
+  arolla::DenseArrayBuilder<int64_t> attr_bldr(kSize);
+  arolla::DenseArrayBuilder<Unit> mask_bldr(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    if (i % 7 != 0) {
+      attr_bldr.Set(i, i * 10);
+      mask_bldr.Set(i, arolla::kUnit);
+    }
+  }
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<DenseSource> ds,
+      DenseSource::CreateMutable(alloc, kSize, arolla::GetQType<int64_t>()));
+  ASSERT_OK(ds->Set(DataSliceImpl::ObjectsFromAllocation(alloc, kSize)
+                        .values<ObjectId>(),
+                    DataSliceImpl::Create(std::move(attr_bldr).Build())));
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const DenseSource> mask_ds,
+      DenseSource::CreateReadonly(
+          alloc, DataSliceImpl::Create(std::move(mask_bldr).Build())));
+
+  // Objects in reverse order with some missing and some from another alloc.
+  std::vector<arolla::OptionalValue<ObjectId>> objs_vec;
+  std::vector<arolla::OptionalValue<int64_t>> expected;
+  std::vector<arolla::OptionalValue<Unit>> expected_mask;
+  for (int64_t i = kSize - 1; i >= 0; --i) {
+    if (i % 5 == 0) {
+      objs_vec.push_back(std::nullopt);
+    } else if (i % 11 == 0) {
+      objs_vec.push_back(other_alloc.ObjectByOffset(i));
+    } else {
+      objs_vec.push_back(alloc.ObjectByOffset(i));
+    }
+    bool present = i % 5 != 0 && i % 11 != 0 && i % 7 != 0;
+    expected.push_back(present ? arolla::OptionalValue<int64_t>(i * 10)
+                               : std::nullopt);
+    expected_mask.push_back(present ? arolla::OptionalValue<Unit>(arolla::kUnit)
+                                    : std::nullopt);
+  }
+  auto objs = arolla::CreateDenseArray<ObjectId>(objs_vec);
+  EXPECT_THAT(ds->Get(objs).values<int64_t>(), ElementsAreArray(expected));
+  EXPECT_THAT(mask_ds->Get(objs).values<Unit>(),
+              ElementsAreArray(expected_mask));
+  // Sliced array has non-zero bitmap_bit_offset.
+  auto sliced_objs = objs.Slice(3, kSize - 3);
+  EXPECT_THAT(ds->Get(sliced_objs).values<int64_t>(),
+              ElementsAreArray(expected.begin() + 3, expected.end()));
+
+  // All present: no bitmap in the result.
+  auto all_objs =
+      DataSliceImpl::ObjectsFromAllocation(alloc, 6).values<ObjectId>();
+  auto res = ds->Get(all_objs.Slice(1, 5), /*check_alloc_id=*/false);
+  EXPECT_THAT(res.values<int64_t>(), ElementsAre(10, 20, 30, 40, 50));
+  EXPECT_TRUE(res.values<int64_t>().bitmap.empty());
+}
+
 TEST(DenseSourceTest, ImmutableUnitAttr) {
   AllocationId alloc = Allocate(300);
   arolla::DenseArray<Unit> attr_value = arolla::CreateDenseArray<Unit>(
@@ -234,6 +311,158 @@ TEST(DenseSourceTest, ImmutableBytesAttr) {
               ElementsAre("3", std::nullopt, "9", "3"));
 }
 
+TEST(DenseSourceTest, ImmutableLowCardinalityTextAttr) {
+  using Text = arolla::Text;
+  constexpr int64_t kSize = 1000;
+  AllocationId alloc = Allocate(kSize);
+  std::vector<arolla::OptionalValue<Text>> values(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    if (i % 7 != 0) {
+      values[i] = Text(absl::StrCat("country_", i % 3));
+    }
+  }
+  auto attr_value = arolla::CreateDenseArray<Text>(values);
+  {
+    // Not encoded by default: the values are shared with the input.
+    ASSERT_OK_AND_ASSIGN(
+        std::shared_ptr<const DenseSource> ds,
+        DenseSource::CreateReadonly(alloc, DataSliceImpl::Create(attr_value)));
+    std::optional<DataSliceImpl> all = ds->GetPrefix(kSize);
+    ASSERT_TRUE(all.has_value());
+    EXPECT_EQ(all->values<Text>().values.characters().begin(),
+              attr_value.values.characters().begin());
+  }
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const DenseSource> ds,
+                       DenseSource::CreateDictEncodedReadonly(
+                           alloc, DataSliceImpl::Create(attr_value)));
+  EXPECT_FALSE(ds->IsMutable());
+
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(0)), DataItem());
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(1)), DataItem(Text("country_1")));
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(5)), DataItem(Text("country_2")));
+
+  auto objs = arolla::CreateDenseArray<ObjectId>(
+      std::vector<arolla::OptionalValue<ObjectId>>{
+          alloc.ObjectByOffset(3), std::nullopt, alloc.ObjectByOffset(7),
+          AllocateSingleObject()});
+  EXPECT_THAT(ds->Get(objs, /*check_alloc_id=*/true).values<Text>(),
+              ElementsAre("country_0", std::nullopt, std::nullopt,
+                          std::nullopt));
+
+  std::optional<DataSliceImpl> all = ds->GetPrefix(kSize);
+  ASSERT_TRUE(all.has_value());
+  EXPECT_THAT(all->values<Text>(), ElementsAreArray(attr_value));
+  // Unique values are stored only once.
+  EXPECT_LT(all->values<Text>().values.characters().size(), 100);
+
+  std::shared_ptr<DenseSource> mutable_copy = ds->CreateMutableCopy();
+  ASSERT_OK(mutable_copy->Set(alloc.ObjectByOffset(0), DataItem(Text("x"))));
+  EXPECT_EQ(mutable_copy->Get(alloc.ObjectByOffset(0)), DataItem(Text("x")));
+  EXPECT_EQ(mutable_copy->Get(alloc.ObjectByOffset(1)),
+            DataItem(Text("country_1")));
+}
+
+TEST(DenseSourceTest, DictEncodedReadonlyHighCardinality) {
+  using Text = arolla::Text;
+  constexpr int64_t kSize = 2000;
+  AllocationId alloc = Allocate(kSize);
+  std::vector<arolla::OptionalValue<Text>> values(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    values[i] = Text(absl::StrCat("id_", i));
+  }
+  auto attr_value = arolla::CreateDenseArray<Text>(values);
+  // Too many distinct values: the values are kept as is.
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<const DenseSource> ds,
+                       DenseSource::CreateDictEncodedReadonly(
+                           alloc, DataSliceImpl::Create(attr_value)));
+  std::optional<DataSliceImpl> all = ds->GetPrefix(kSize);
+  ASSERT_TRUE(all.has_value());
+  EXPECT_EQ(all->values<Text>().values.characters().begin(),
+            attr_value.values.characters().begin());
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(1234)), DataItem(Text("id_1234")));
+}
+
+TEST(DenseSourceTest, ConstantAttr) {
+  using Text = arolla::Text;
+  constexpr int64_t kSize = 100;
+  AllocationId alloc = Allocate(kSize);
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const DenseSource> ds,
+      DenseSource::CreateConstant(alloc, kSize, DataItem(Text("abc"))));
+  EXPECT_FALSE(ds->IsMutable());
+  EXPECT_EQ(ds->size(), kSize);
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(57)), DataItem(Text("abc")));
+
+  auto objs = arolla::CreateDenseArray<ObjectId>(
+      std::vector<arolla::OptionalValue<ObjectId>>{
+          alloc.ObjectByOffset(3), std::nullopt, alloc.ObjectByOffset(7),
+          AllocateSingleObject()});
+  EXPECT_THAT(ds->Get(objs, /*check_alloc_id=*/true).values<Text>(),
+              ElementsAre("abc", std::nullopt, "abc", std::nullopt));
+  EXPECT_THAT(ds->Get(objs.Slice(0, 3), /*check_alloc_id=*/false)
+                  .values<Text>(),
+              ElementsAre("abc", std::nullopt, "abc"));
+  DataSliceImpl::Builder bldr(objs.size());
+  ds->Get(objs, bldr);
+  EXPECT_THAT(std::move(bldr).Build().values<Text>(),
+              ElementsAre("abc", std::nullopt, "abc", std::nullopt));
+  std::optional<DataSliceImpl> prefix = ds->GetPrefix(3);
+  ASSERT_TRUE(prefix.has_value());
+  EXPECT_THAT(prefix->values<Text>(), ElementsAre("abc", "abc", "abc"));
+  EXPECT_EQ(ds->GetPrefix(kSize + 1), std::nullopt);
+
+  EXPECT_THAT(std::const_pointer_cast<DenseSource>(ds)->Set(
+                  alloc.ObjectByOffset(0), DataItem(1)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  std::shared_ptr<DenseSource> mutable_copy = ds->CreateMutableCopy();
+  ASSERT_OK(mutable_copy->Set(alloc.ObjectByOffset(0), DataItem(Text("x"))));
+  EXPECT_EQ(mutable_copy->Get(alloc.ObjectByOffset(0)), DataItem(Text("x")));
+  EXPECT_EQ(mutable_copy->Get(alloc.ObjectByOffset(99)),
+            DataItem(Text("abc")));
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(0)), DataItem(Text("abc")));
+
+  AllocationId attr_alloc = Allocate(5);
+  ASSERT_OK_AND_ASSIGN(
+      ds, DenseSource::CreateConstant(
+              alloc, kSize, DataItem(attr_alloc.ObjectByOffset(1))));
+  DataSliceImpl obj_values = ds->Get(objs, /*check_alloc_id=*/true);
+  EXPECT_THAT(obj_values.values<ObjectId>(),
+              ElementsAre(attr_alloc.ObjectByOffset(1), std::nullopt,
+                          attr_alloc.ObjectByOffset(1), std::nullopt));
+  EXPECT_EQ(obj_values.allocation_ids(), AllocationIdSet(attr_alloc));
+
+  EXPECT_THAT(DenseSource::CreateConstant(alloc, kSize, DataItem()),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+  EXPECT_THAT(DenseSource::CreateConstant(alloc, alloc.Capacity() + 1,
+                                          DataItem(1)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+}
+
+TEST(DenseSourceTest, LazyAttr) {
+  AllocationId alloc = Allocate(3);
+  int loads = 0;
+  std::shared_ptr<DenseSource> ds =
+      DenseSource::CreateLazy(alloc, [&]() -> absl::StatusOr<DataSliceImpl> {
+        ++loads;
+        return DataSliceImpl::Create(arolla::CreateDenseArray<int>({1, 2, 3}));
+      });
+  EXPECT_EQ(ds->EstimateMemoryUsage(), 0);
+  EXPECT_EQ(loads, 0);
+  EXPECT_OK(ds->Load());
+  EXPECT_EQ(ds->size(), 3);
+  EXPECT_EQ(ds->Get(alloc.ObjectByOffset(1)), DataItem(2));
+  EXPECT_GT(ds->EstimateMemoryUsage(), 0);
+  EXPECT_EQ(loads, 1);
+
+  ds = DenseSource::CreateLazy(alloc, []() -> absl::StatusOr<DataSliceImpl> {
+    return absl::InvalidArgumentError("corrupted chunk");
+  });
+  EXPECT_THAT(ds->Load(), StatusIs(absl::StatusCode::kInvalidArgument,
+                                   "corrupted chunk"));
+  // The error is returned again by the next loads.
+  EXPECT_THAT(ds->Load(), StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
 TEST(DenseSourceTest, MutableTextAttr) {
   using Text = arolla::Text;
   using OT = arolla::OptionalValue<Text>;
@@ -517,6 +746,74 @@ TEST(DenseSourceTest, MutableCopyOfImmutableWithBitmapBitOffsetUnit) {
   EXPECT_EQ(source_copy->Get(alloc.ObjectByOffset(2)), DataItem());
 }
 
+TEST(DenseSourceTest, MutableCopySharesPages) {
+  constexpr int64_t kSize = 10000;
+  std::vector<arolla::OptionalValue<int64_t>> values(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    if (i % 3 != 0) {
+      values[i] = i;
+    }
+  }
+  AllocationId alloc = Allocate(kSize);
+  ASSERT_OK_AND_ASSIGN(
+      std::shared_ptr<const DenseSource> source,
+      DenseSource::CreateReadonly(
+          alloc,
+          DataSliceImpl::Create(arolla::CreateDenseArray<int64_t>(values))));
+  EXPECT_TRUE(source->HasCheapMutableCopy());
+
+  std::shared_ptr<DenseSource> copy = source->CreateMutableCopy();
+  EXPECT_TRUE(copy->IsMutable());
+  EXPECT_TRUE(copy->HasCheapMutableCopy());
+  // All pages are shared with `source`.
+  EXPECT_LT(copy->EstimateMemoryUsage(), 100);
+  ASSERT_OK(copy->Set(alloc.ObjectByOffset(1), DataItem(int64_t{-1})));
+  ASSERT_OK(copy->Set(alloc.ObjectByOffset(2), DataItem()));
+  // Only the first page is copied.
+  EXPECT_LT(copy->EstimateMemoryUsage(), kSize * sizeof(int64_t) / 2);
+
+  std::shared_ptr<DenseSource> copy2 = copy->CreateMutableCopy();
+  ASSERT_OK(copy2->Set(alloc.ObjectByOffset(kSize - 2),
+                       DataItem(int64_t{-2})));
+  ASSERT_OK(copy->Set(alloc.ObjectByOffset(4), DataItem(int64_t{-3})));
+
+  auto objs = arolla::CreateDenseArray<ObjectId>(
+      {alloc.ObjectByOffset(0), alloc.ObjectByOffset(1),
+       alloc.ObjectByOffset(2), alloc.ObjectByOffset(4),
+       alloc.ObjectByOffset(kSize - 2), std::nullopt,
+       AllocateSingleObject()});
+  EXPECT_THAT(source->Get(objs).values<int64_t>(),
+              ElementsAre(std::nullopt, 1, 2, 4, kSize - 2, std::nullopt,
+                          std::nullopt));
+  EXPECT_THAT(copy->Get(objs).values<int64_t>(),
+              ElementsAre(std::nullopt, -1, std::nullopt, -3, kSize - 2,
+                          std::nullopt, std::nullopt));
+  EXPECT_THAT(copy2->Get(objs).values<int64_t>(),
+              ElementsAre(std::nullopt, -1, std::nullopt, 4, -2, std::nullopt,
+                          std::nullopt));
+  EXPECT_EQ(copy2->Get(alloc.ObjectByOffset(kSize - 2)),
+            DataItem(int64_t{-2}));
+  std::optional<DataSliceImpl> prefix = copy2->GetPrefix(5);
+  ASSERT_TRUE(prefix.has_value());
+  EXPECT_THAT(prefix->values<int64_t>(),
+              ElementsAre(std::nullopt, -1, std::nullopt, std::nullopt, 4));
+
+  ASSERT_OK(
+      copy2->Merge(*source, DenseSource::ConflictHandlingOption::kOverwrite));
+  EXPECT_THAT(copy2->Get(objs).values<int64_t>(),
+              ElementsAre(std::nullopt, 1, 2, 4, kSize - 2, std::nullopt,
+                          std::nullopt));
+
+  // A value of another type converts the copy to a multitype source.
+  ASSERT_OK(copy->Set(alloc.ObjectByOffset(0), DataItem(1.5f)));
+  EXPECT_FALSE(copy->HasCheapMutableCopy());
+  EXPECT_EQ(copy->Get(alloc.ObjectByOffset(0)), DataItem(1.5f));
+  EXPECT_EQ(copy->Get(alloc.ObjectByOffset(1)), DataItem(int64_t{-1}));
+  EXPECT_EQ(copy->Get(alloc.ObjectByOffset(kSize - 2)),
+            DataItem(int64_t{kSize - 2}));
+  EXPECT_EQ(source->Get(alloc.ObjectByOffset(1)), DataItem(int64_t{1}));
+}
+
 TEST(DenseSourceTest, MutableCopyOfImmutableWithMixedTypes) {
   AllocationId alloc = Allocate(7);
   DataSliceImpl::Builder bldr(alloc.Capacity());
@@ -654,6 +951,32 @@ TEST(DenseSourceTest, SetUnitAttrAndReturnMissingObjectsInternal) {
   EXPECT_THAT(missing_objects, ElementsAre(a3, a1));
 }
 
+TEST(DenseSourceTest, EstimateMemoryUsage) {
+  using Text = arolla::Text;
+  constexpr int64_t kSize = 1000;
+  AllocationId alloc = Allocate(kSize);
+  ASSERT_OK_AND_ASSIGN(
+      auto ds,
+      DenseSource::CreateMutable(alloc, kSize, arolla::GetQType<int64_t>()));
+  int64_t int_usage = ds->EstimateMemoryUsage();
+  EXPECT_GE(int_usage, kSize * sizeof(int64_t));
+  // A value of another type adds an array.
+  ASSERT_OK(ds->Set(alloc.ObjectByOffset(0), DataItem(1.5f)));
+  EXPECT_GE(ds->EstimateMemoryUsage(), int_usage + kSize * sizeof(float));
+
+  ASSERT_OK_AND_ASSIGN(
+      auto text_ds,
+      DenseSource::CreateMutable(alloc, kSize, arolla::GetQType<Text>()));
+  int64_t text_usage = text_ds->EstimateMemoryUsage();
+  ASSERT_OK(text_ds->Set(alloc.ObjectByOffset(0),
+                         DataItem(Text(std::string(100, 'x')))));
+  EXPECT_GE(text_ds->EstimateMemoryUsage(), text_usage + 100);
+
+  ASSERT_OK_AND_ASSIGN(
+      auto const_ds, DenseSource::CreateConstant(alloc, kSize, DataItem(1)));
+  EXPECT_LT(const_ds->EstimateMemoryUsage(), kSize);
+}
+
 TEST(DenseSourceTest, Merge) {
   auto gen_data = [&]<typename T>(T value, int size, int step, int offset) {
     arolla::DenseArrayBuilder<T> bldr(size);
@@ -18,19 +18,18 @@
 #include <vector>
 
 #include "absl/base/no_destructor.h"
-#include "absl/base/attributes.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
 #include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 
 namespace koladata::internal {
 
-template <bool kReturnValues>
-ABSL_ATTRIBUTE_NOINLINE void Dict::CollectKeysOrValuesFromParentAndFallbacks(
+void Dict::ForEachInParentAndFallbacks(
     absl::Span<const Dict* const> fallbacks,
-    std::vector<DataItem>& keys_or_values) const {
+    absl::FunctionRef<void(const DataItem&, const DataItem&)> fn) const {
   const auto* orig_data = &data_;
-  InternalMap empty_data;
+  Storage empty_data;
   absl::flat_hash_set<DataItem, DataItem::Hash, DataItem::Eq> used_keys;
   absl::flat_hash_set<DataItem, DataItem::Hash, DataItem::Eq> removed_keys;
   for (const Dict* dict = parent_; true; dict = dict->parent_) {
@@ -40,11 +39,11 @@ ABSL_ATTRIBUTE_NOINLINE void Dict::CollectKeysOrValuesFromParentAndFallbacks(
       }
       // transfer non removed keys from original data to used_keys,
       // so that fallback not adding it.
-      for (const auto& [key, value] : *orig_data) {
+      orig_data->ForEach([&](const DataItem& key, const DataItem& value) {
         if (value.has_value()) {
           used_keys.insert(key);
         }
-      }
+      });
       orig_data = &empty_data;
       // removed keys are relevant only withing one dict chain
       removed_keys.clear();
@@ -52,13 +51,13 @@ ABSL_ATTRIBUTE_NOINLINE void Dict::CollectKeysOrValuesFromParentAndFallbacks(
       dict = fallbacks.front();
       fallbacks.remove_prefix(1);
     }
-    for (const auto& [key, value] : dict->data_) {
+    dict->data_.ForEach([&](const DataItem& key, const DataItem& value) {
       if (value.has_value()) {
         size_t hash = DataItem::Hash()(key);
-        if (orig_data->find(key, hash) == orig_data->end() &&
+        if (orig_data->Find(key, hash) == nullptr &&
             used_keys.find(key, hash) == used_keys.end() &&
             removed_keys.find(key, hash) == removed_keys.end()) {
-          keys_or_values.push_back(kReturnValues ? value : key);
+          fn(key, value);
           if (dict->parent_ != nullptr || !fallbacks.empty()) {
             used_keys.insert(key);
           }
@@ -66,53 +65,28 @@ ABSL_ATTRIBUTE_NOINLINE void Dict::CollectKeysOrValuesFromParentAndFallbacks(
       } else if (dict->parent_ != nullptr) {
         removed_keys.insert(key);
       }
-    }
+    });
   }
 }
 
 std::vector<DataItem> Dict::GetKeys(
     absl::Span<const Dict* const> fallbacks) const {
-  auto* dict = FindFirstNonEmpty();
-  if (dict == nullptr) {
-    if (fallbacks.empty()) {
-      return {};
-    }
-    return fallbacks[0]->GetKeys(fallbacks.subspan(1));
-  }
+  const Dict* dict = FindFirstNonEmpty();
   std::vector<DataItem> keys;
-  keys.reserve(dict->data_.size());
-  for (const auto& [key, value] : dict->data_) {
-    if (value.has_value()) {
-      keys.push_back(key);
-    }
-  }
-  if (dict->parent_ != nullptr || !fallbacks.empty()) {
-    dict->CollectKeysOrValuesFromParentAndFallbacks</*kReturnValues=*/false>(
-        fallbacks, keys);
-  }
+  keys.reserve(dict == nullptr ? 0 : dict->data_.size());
+  ForEach([&](const DataItem& key, const DataItem&) { keys.push_back(key); },
+          fallbacks);
   return keys;
 };
 
 std::vector<DataItem> Dict::GetValues(
     absl::Span<const Dict* const> fallbacks) const {
-  auto* dict = FindFirstNonEmpty();
-  if (dict == nullptr) {
-    if (fallbacks.empty()) {
-      return {};
-    }
-    return fallbacks[0]->GetValues(fallbacks.subspan(1));
-  }
+  const Dict* dict = FindFirstNonEmpty();
   std::vector<DataItem> values;
-  values.reserve(dict->data_.size());
-  for (const auto& [key, value] : dict->data_) {
-    if (value.has_value()) {
-      values.push_back(value);
-    }
-  }
-  if (dict->parent_ != nullptr || !fallbacks.empty()) {
-    dict->CollectKeysOrValuesFromParentAndFallbacks</*kReturnValues=*/true>(
-        fallbacks, values);
-  }
+  values.reserve(dict == nullptr ? 0 : dict->data_.size());
+  ForEach(
+      [&](const DataItem&, const DataItem& value) { values.push_back(value); },
+      fallbacks);
   return values;
 };
 
@@ -15,6 +15,7 @@
 #ifndef KOLADATA_INTERNAL_DICT_H_
 #define KOLADATA_INTERNAL_DICT_H_
 
+#include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <memory>
@@ -23,10 +24,13 @@
 
 #include "absl/base/no_destructor.h"
 #include "absl/base/optimization.h"
+#include "absl/base/prefetch.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
+#include "koladata/internal/memory_usage.h"
 #include "koladata/internal/missing_value.h"
 #include "arolla/expr/quote.h"
 #include "arolla/util/meta.h"
@@ -70,7 +74,7 @@ class Dict {
     DCHECK(!IsUnsupportedKeyType<KeyT>());
     if constexpr (!IsUnsupportedKeyType<KeyT>()) {
       if (parent_ == nullptr && !value.has_value()) {
-        data_.erase(key);
+        data_.Erase(key);
       } else {
         data_[key] = std::move(value);
       }
@@ -88,13 +92,21 @@ class Dict {
   const DataItem& Get(const T& key, size_t key_hash) const {
     DCHECK_EQ(key_hash, DataItem::Hash()(key));
     for (const Dict* dict = this; dict != nullptr; dict = dict->parent_) {
-      if (auto it = dict->data_.find(key, key_hash); it != dict->data_.end()) {
-        return it->second;
+      if (const DataItem* value = dict->data_.Find(key, key_hash);
+          value != nullptr) {
+        return *value;
       }
     }
     return *empty_item_;
   }
 
+  // Prefetches the memory that Get(key) is going to touch first. Used by batch
+  // lookups to overlap the cache misses of independent keys.
+  template <typename T>
+  void Prefetch(const T& key) const {
+    data_.Prefetch(key);
+  }
+
   // Returns the reference to existing non empty element.
   // Otherwise assign new value and return it.
   // `T` is either DataItem, or one of the types that can be stored in DataItem.
@@ -113,19 +125,19 @@ class Dict {
       return *empty_item_;
     }
     if (parent_ == nullptr) {
-      auto [it, _] = data_.try_emplace(key, std::forward<ValueT>(value));
-      if (ABSL_PREDICT_FALSE(!it->second.has_value())) {
-        data_.erase(it);
+      auto [res, _] = data_.TryEmplace(key, std::forward<ValueT>(value));
+      if (ABSL_PREDICT_FALSE(!res->has_value())) {
+        data_.Erase(key);
         return *empty_item_;
       }
-      return it->second;
+      return *res;
     }
     auto key_hash = DataItem::Hash()(key);
-    if (auto it = data_.find(key, key_hash); it != data_.end()) {
-      if (!it->second.has_value()) {
-        it->second = std::forward<ValueT>(value);
+    if (DataItem* res = data_.FindMutable(key, key_hash); res != nullptr) {
+      if (!res->has_value()) {
+        *res = std::forward<ValueT>(value);
       }
-      return it->second;
+      return *res;
     }
 
     const DataItem& parent_value = parent_->Get(key, key_hash);
@@ -133,8 +145,7 @@ class Dict {
       return parent_value;
     }
 
-    auto [it, _] = data_.emplace(key, std::forward<ValueT>(value));
-    return it->second;
+    return *data_.TryEmplace(key, std::forward<ValueT>(value)).first;
   }
 
   // While the order of keys is arbitrary, it is the same as GetValues().
@@ -147,6 +158,35 @@ class Dict {
   std::vector<DataItem> GetValues(
       absl::Span<const Dict* const> fallbacks = {}) const;
 
+  // Calls `fn(key, value)` for all entries, in the same order as GetKeys()
+  // and GetValues(). All entries from fallback dictionaries are merged into
+  // the result. Unlike GetKeys() and GetValues() it doesn't copy the entries.
+  template <typename Fn>
+  void ForEach(Fn&& fn, absl::Span<const Dict* const> fallbacks = {}) const {
+    auto* dict = FindFirstNonEmpty();
+    if (dict == nullptr) {
+      if (!fallbacks.empty()) {
+        fallbacks[0]->ForEach(fn, fallbacks.subspan(1));
+      }
+      return;
+    }
+    dict->data_.ForEach([&](const DataItem& key, const DataItem& value) {
+      if (value.has_value()) {
+        fn(key, value);
+      }
+    });
+    if (dict->parent_ != nullptr || !fallbacks.empty()) {
+      dict->ForEachInParentAndFallbacks(fallbacks, fn);
+    }
+  }
+
+  // Returns true if all the entries are stored in a single dict of the parent
+  // chain. In this case GetSizeNoFallbacks() is O(1).
+  bool HasSingleStorage() const {
+    auto* dict = FindFirstNonEmpty();
+    return dict == nullptr || dict->parent_ == nullptr;
+  }
+
   size_t GetSizeNoFallbacks() const {
     auto* dict = FindFirstNonEmpty();
     if (dict == nullptr) {
@@ -155,14 +195,167 @@ class Dict {
     if (dict->parent_ == nullptr) {
       return dict->data_.size();
     }
-    return dict->GetKeys().size();
+    size_t size = 0;
+    dict->ForEach([&](const DataItem&, const DataItem&) { ++size; });
+    return size;
   }
 
+  // Returns the estimated number of bytes used by the entries stored in this
+  // dict, see MemoryUsage. Entries of the parent dicts and sizeof(Dict) are
+  // not included.
+  int64_t EstimateMemoryUsage() const { return data_.EstimateMemoryUsage(); }
+
  private:
   friend class DictVector;
   using InternalMap =
       absl::flat_hash_map<DataItem, DataItem, DataItem::Hash, DataItem::Eq>;
 
+  // Key-value storage of a single dict. Small dicts are stored as a vector of
+  // pairs with linear search: unlike a hash map it has no control bytes and no
+  // empty slots, so it takes several times less memory for dicts with a few
+  // entries. It is converted to InternalMap when the size exceeds
+  // kMaxSmallSize.
+  //
+  // The small storage keeps a 64-bit Bloom filter of the key hashes, so that a
+  // lookup of a missing key (e.g. in the parents of a derived dict) usually
+  // skips the linear search.
+  class Storage {
+   public:
+    static constexpr size_t kMaxSmallSize = 8;
+
+    bool empty() const { return small_.empty() && map_.empty(); }
+    size_t size() const { return map_.empty() ? small_.size() : map_.size(); }
+
+    void clear() {
+      small_ = {};
+      small_hashes_ = 0;
+      map_.clear();
+    }
+
+    // `key_hash` must be computed via DataItem::Hash()(key).
+    template <typename T>
+    const DataItem* Find(const T& key, size_t key_hash) const {
+      if (map_.empty()) {
+        if ((small_hashes_ & HashBit(key_hash)) == 0) {
+          return nullptr;
+        }
+        for (const auto& [k, v] : small_) {
+          if (DataItem::Eq()(k, key)) {
+            return &v;
+          }
+        }
+        return nullptr;
+      }
+      auto it = map_.find(key, key_hash);
+      return it == map_.end() ? nullptr : &it->second;
+    }
+
+    template <typename T>
+    void Prefetch(const T& key) const {
+      if (map_.empty()) {
+        absl::PrefetchToLocalCache(small_.data());
+      } else {
+        map_.prefetch(key);
+      }
+    }
+
+    template <typename T>
+    DataItem* FindMutable(const T& key, size_t key_hash) {
+      return const_cast<DataItem*>(std::as_const(*this).Find(key, key_hash));
+    }
+
+    // Inserts `value` if `key` is not present. Returns pointer to the value
+    // for the `key` and whether the insertion took place.
+    template <typename T, typename ValueT>
+    std::pair<DataItem*, bool> TryEmplace(const T& key, ValueT&& value) {
+      if (map_.empty()) {
+        for (auto& [k, v] : small_) {
+          if (DataItem::Eq()(k, key)) {
+            return {&v, false};
+          }
+        }
+        if (small_.size() < kMaxSmallSize) {
+          small_hashes_ |= HashBit(DataItem::Hash()(key));
+          small_.emplace_back(DataItem(key),
+                              DataItem(std::forward<ValueT>(value)));
+          return {&small_.back().second, true};
+        }
+        MoveToMap();
+      }
+      auto [it, inserted] = map_.try_emplace(key, std::forward<ValueT>(value));
+      return {&it->second, inserted};
+    }
+
+    template <typename T>
+    DataItem& operator[](const T& key) {
+      return *TryEmplace(key, DataItem()).first;
+    }
+
+    template <typename T>
+    void Erase(const T& key) {
+      if (!map_.empty()) {
+        map_.erase(key);
+        return;
+      }
+      for (auto it = small_.begin(); it != small_.end(); ++it) {
+        if (DataItem::Eq()(it->first, key)) {
+          if (it + 1 != small_.end()) {
+            *it = std::move(small_.back());
+          }
+          small_.pop_back();
+          return;
+        }
+      }
+    }
+
+    // Calls `fn(key, value)` for all entries.
+    template <typename Fn>
+    void ForEach(Fn&& fn) const {
+      if (map_.empty()) {
+        for (const auto& [k, v] : small_) {
+          fn(k, v);
+        }
+      } else {
+        for (const auto& [k, v] : map_) {
+          fn(k, v);
+        }
+      }
+    }
+
+    int64_t EstimateMemoryUsage() const {
+      // flat_hash_map stores one control byte per slot in addition to the
+      // slot.
+      int64_t bytes =
+          small_.capacity() * sizeof(small_[0]) +
+          map_.capacity() * (sizeof(InternalMap::value_type) + 1);
+      ForEach([&](const DataItem& k, const DataItem& v) {
+        bytes += EstimateDataItemHeapBytes(k) + EstimateDataItemHeapBytes(v);
+      });
+      return bytes;
+    }
+
+   private:
+    static uint64_t HashBit(size_t key_hash) {
+      return uint64_t{1} << (key_hash >> 58);
+    }
+
+    void MoveToMap() {
+      map_.reserve(small_.size() + 1);
+      for (auto& [k, v] : small_) {
+        map_.emplace(std::move(k), std::move(v));
+      }
+      small_ = {};
+      small_hashes_ = 0;
+    }
+
+    // Used if `map_` is empty.
+    std::vector<std::pair<DataItem, DataItem>> small_;
+    // Bit HashBit(hash) is set for the keys of `small_`. Removed keys are not
+    // cleared.
+    uint64_t small_hashes_ = 0;
+    InternalMap map_;
+  };
+
   const Dict* FindFirstNonEmpty() const {
     auto* dict = this;
     while (dict != nullptr && dict->data_.empty()) {
@@ -171,19 +364,15 @@ class Dict {
     return dict;
   }
 
-  // Add extra keys from parents and fallbacks.
-  // Keys from the main dict are not added.
-  // void CollectKeysFromParentAndFallbacks(
-  //     absl::Span<const Dict* const> fallbacks,
-  //     std::vector<DataItem>& keys) const;
-  // Add keys or values from this dict, its parents and fallbacks.
-  template <bool kReturnValues>
-  void CollectKeysOrValuesFromParentAndFallbacks(
+  // Calls `fn(key, value)` for the entries of the parents and fallbacks that
+  // are not overridden (or removed) in this dict. The entries of this dict are
+  // not visited.
+  void ForEachInParentAndFallbacks(
       absl::Span<const Dict* const> fallbacks,
-      std::vector<DataItem>& keys_or_values) const;
+      absl::FunctionRef<void(const DataItem&, const DataItem&)> fn) const;
 
   // If parent is nullptr we do not store missing values.
-  InternalMap data_;
+  Storage data_;
 
   // It can be set only by DictVector, and DictVector holds shared_ptr
   // to parent. So it is safe to use raw pointer if the DictVector still exists.
@@ -194,45 +383,100 @@ class Dict {
 
 // Vector of dictionaries. Can be created from shared_ptr to another DictVector
 // and in this case will store only the diffs between dicts.
+//
+// The dicts are stored in pages of kPageSize dicts. A vector created from a
+// parent shares all the pages with it, and a shared page is replaced on the
+// first non-const access by a page of empty dicts linked to the original ones.
+// As a result a small update in a fork costs O(kPageSize) rather than
+// O(size()).
 class DictVector {
  public:
-  explicit DictVector(size_t size) : data_(size) {}
+  static constexpr size_t kPageSize = 1024;
+
+  explicit DictVector(size_t size) : DictVector(size, nullptr, nullptr) {}
 
   // Non copyable to avoid confusion with constructor from shared_ptr.
   DictVector(const DictVector&) = delete;
   DictVector& operator=(const DictVector&) = delete;
 
   explicit DictVector(std::shared_ptr<const DictVector> parent)
-      : data_(parent->size()) {
-    for (size_t i = 0; i < data_.size(); ++i) {
-      const Dict& parent_dict = parent->data_[i];
-      data_[i].parent_ =
-          parent_dict.data_.empty() ? parent_dict.parent_ : &parent_dict;
+      : pages_(parent->pages_), size_(parent->size_) {}
+
+  explicit DictVector(size_t size, std::shared_ptr<const Dict> parent_dict)
+      : DictVector(size,
+                   parent_dict->data_.empty() ? parent_dict->parent_
+                                              : parent_dict.get(),
+                   parent_dict) {}
+
+  size_t size() const {
+    return size_;
+  }
+
+  Dict& operator[](int64_t index) {
+    std::shared_ptr<Page>& page = pages_[index / kPageSize];
+    if (page.use_count() > 1) {
+      page = CopyPage(page);
     }
-    parent_ = std::move(parent);
+    return page->dicts[index % kPageSize];
+  }
+  const Dict& operator[](int64_t index) const {
+    return pages_[index / kPageSize]->dicts[index % kPageSize];
   }
 
-  explicit DictVector(size_t size, std::shared_ptr<const Dict> parent_dict)
-      : data_(size) {
-    const Dict* parent_dict_ptr =
-        parent_dict->data_.empty() ? parent_dict->parent_ : parent_dict.get();
-    for (size_t i = 0; i < data_.size(); ++i) {
-      data_[i].parent_ = parent_dict_ptr;
+  // Returns the estimated number of bytes owned by the vector, see
+  // MemoryUsage. Pages shared with other vectors (e.g. with the parent or with
+  // forks) and the entries of the parent dicts are not included.
+  int64_t EstimateMemoryUsage() const {
+    int64_t bytes = pages_.capacity() * sizeof(std::shared_ptr<Page>);
+    for (const auto& page : pages_) {
+      if (page.use_count() > 1) {
+        continue;
+      }
+      bytes += sizeof(Page) + page->dicts.capacity() * sizeof(Dict);
+      for (const Dict& dict : page->dicts) {
+        bytes += dict.EstimateMemoryUsage();
+      }
     }
-    parent_ = std::move(parent_dict);
+    return bytes;
   }
 
-  size_t size() const {
-    return data_.size();
+ private:
+  struct Page {
+    std::vector<Dict> dicts;
+    // All parent links are stored inside of the Dict. We only hold ownership
+    // of either the page the dicts are linked to or of the common parent dict.
+    std::shared_ptr<const void> source;
+  };
+
+  DictVector(size_t size, const Dict* parent_dict,
+             std::shared_ptr<const void> source)
+      : size_(size) {
+    pages_.reserve((size + kPageSize - 1) / kPageSize);
+    for (size_t offset = 0; offset < size; offset += kPageSize) {
+      auto page = std::make_shared<Page>();
+      page->dicts.resize(std::min(kPageSize, size - offset));
+      for (Dict& dict : page->dicts) {
+        dict.parent_ = parent_dict;
+      }
+      page->source = source;
+      pages_.push_back(std::move(page));
+    }
   }
 
-  Dict& operator[](int64_t index) { return data_[index]; }
-  const Dict& operator[](int64_t index) const { return data_[index]; }
+  static std::shared_ptr<Page> CopyPage(std::shared_ptr<const Page> src) {
+    auto page = std::make_shared<Page>();
+    page->dicts.resize(src->dicts.size());
+    for (size_t i = 0; i < page->dicts.size(); ++i) {
+      const Dict& src_dict = src->dicts[i];
+      page->dicts[i].parent_ =
+          src_dict.data_.empty() ? src_dict.parent_ : &src_dict;
+    }
+    page->source = std::move(src);
+    return page;
+  }
 
- private:
-  std::vector<Dict> data_;
-  // All parent links are stored inside of the Dict. We only hold ownership.
-  std::shared_ptr<const void> parent_;
+  std::vector<std::shared_ptr<Page>> pages_;
+  size_t size_;
 };
 
 }  // namespace koladata::internal
@@ -17,6 +17,7 @@
 #include <cstdint>
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -124,6 +125,50 @@ TEST(DictTest, Dict) {
   EXPECT_EQ((*dicts)[0].GetOrAssign(DataItem(13), DataItem(9.f)), 9.f);
 }
 
+TEST(DictTest, GrowAndShrink) {
+  DictVector dicts(1);
+  Dict& dict = dicts[0];
+  for (int64_t i = 0; i < 20; ++i) {
+    dict.Set(DataItem(i), DataItem(static_cast<float>(i)));
+    EXPECT_EQ(dict.GetSizeNoFallbacks(), i + 1);
+    for (int64_t j = 0; j <= i; ++j) {
+      EXPECT_EQ(dict.Get(DataItem(j)), DataItem(static_cast<float>(j)));
+    }
+    AssertKVsAreAligned(dict);
+  }
+  EXPECT_EQ(dict.Get(DataItem(int64_t{20})), DataItem());
+  for (int64_t i = 0; i < 20; ++i) {
+    dict.Set(DataItem(i), DataItem());
+    EXPECT_EQ(dict.GetSizeNoFallbacks(), 19 - i);
+    EXPECT_EQ(dict.Get(DataItem(i)), DataItem());
+  }
+  EXPECT_THAT(dict.GetKeys(), ::testing::IsEmpty());
+
+  dict.Set(arolla::Text("a"), DataItem(1));
+  dict.Set(arolla::Text("b"), DataItem(2));
+  dict.Set(arolla::Text("a"), DataItem());
+  EXPECT_THAT(dict.GetKeys(), UnorderedElementsAre(DataItem(arolla::Text("b"))));
+  EXPECT_EQ(dict.GetOrAssign(arolla::Text("b"), DataItem(3)), DataItem(2));
+  EXPECT_EQ(dict.GetOrAssign(arolla::Text("c"), DataItem(3)), DataItem(3));
+  AssertKVsAreAligned(dict);
+}
+
+TEST(DictTest, SmallDictMissingKeys) {
+  DictVector dicts(1);
+  auto& dict = dicts[0];
+  for (int i = 0; i < 8; i += 2) {
+    dict.Set(i, DataItem(i));
+  }
+  dict.Set(2, DataItem());
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(dict.Get(i), i % 2 == 0 && i != 2 ? DataItem(i) : DataItem())
+        << i;
+  }
+  dict.Set(2, DataItem(5));
+  EXPECT_EQ(dict.Get(2), DataItem(5));
+  EXPECT_EQ(dict.GetSizeNoFallbacks(), 4);
+}
+
 TEST(DictTest, OverrideWithEmptyNoParent) {
   std::shared_ptr<DictVector> dicts = std::make_shared<DictVector>(1);
   auto& dict = (*dicts)[0];
@@ -244,6 +289,31 @@ TEST(DictTest, DerivedDictExtra) {
   EXPECT_EQ(derived_dict2.Get(2), DataItem());
 }
 
+TEST(DictTest, DerivedDictVectorPages) {
+  constexpr int64_t kSize = DictVector::kPageSize * 3 + 5;
+  auto dicts = std::make_shared<DictVector>(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    (*dicts)[i].Set(DataItem(1), DataItem(i));
+  }
+
+  DictVector derived_dicts(dicts);
+  EXPECT_EQ(derived_dicts.size(), kSize);
+  derived_dicts[kSize - 1].Set(DataItem(2), DataItem(int64_t{-1}));
+  // Only the last (short) page is copied.
+  const DictVector& const_derived_dicts = derived_dicts;
+  for (int64_t i = 0; i < kSize - 1; ++i) {
+    ASSERT_EQ(&const_derived_dicts[i], &std::as_const(*dicts)[i]);
+  }
+  EXPECT_EQ(derived_dicts[kSize - 1].Get(1), DataItem(kSize - 1));
+  EXPECT_EQ(derived_dicts[kSize - 1].Get(2), DataItem(int64_t{-1}));
+  EXPECT_EQ((*dicts)[kSize - 1].Get(2), DataItem());
+
+  // Modifying the parent after the fork doesn't affect the derived vector.
+  (*dicts)[0].Set(DataItem(1), DataItem(int64_t{-2}));
+  EXPECT_EQ((*dicts)[0].Get(1), DataItem(int64_t{-2}));
+  EXPECT_EQ(derived_dicts[0].Get(1), DataItem(int64_t{0}));
+}
+
 TEST(DictTest, DerivedDictSingle) {
   std::shared_ptr<Dict> parent_dict = std::make_shared<Dict>();
   parent_dict->Set(arolla::Text("a"), DataItem(7.f));
@@ -331,6 +401,44 @@ TEST(DictTest, GetKeysAndValuesWithFallback) {
   AssertKVsAreAligned(derived_dict);
 }
 
+TEST(DictTest, ForEach) {
+  std::shared_ptr<DictVector> dicts = std::make_shared<DictVector>(2);
+  auto& dict = (*dicts)[0];
+  dict.Set(arolla::Text("a"), DataItem(7.f));
+  dict.Set(1, DataItem(8));
+  dict.Set(3, DataItem(4));
+  EXPECT_TRUE(dict.HasSingleStorage());
+  EXPECT_TRUE((*dicts)[1].HasSingleStorage());
+
+  DictVector derived_dicts(dicts);
+  auto& derived_dict = derived_dicts[0];
+  EXPECT_TRUE(derived_dict.HasSingleStorage());
+  derived_dict.Set(1, DataItem(9));
+  derived_dict.Set(2, DataItem(10));
+  derived_dict.Set(3, DataItem());
+  EXPECT_FALSE(derived_dict.HasSingleStorage());
+
+  std::shared_ptr<DictVector> fb_dicts = std::make_shared<DictVector>(1);
+  auto& fb_dict = (*fb_dicts)[0];
+  fb_dict.Set(arolla::Text("b"), DataItem(7.f));
+  fb_dict.Set(1, DataItem(2));
+
+  for (std::vector<const Dict*> fallbacks :
+       {std::vector<const Dict*>{}, std::vector<const Dict*>{&fb_dict}}) {
+    std::vector<DataItem> keys;
+    std::vector<DataItem> values;
+    derived_dict.ForEach(
+        [&](const DataItem& key, const DataItem& value) {
+          keys.push_back(key);
+          values.push_back(value);
+        },
+        fallbacks);
+    EXPECT_EQ(keys, derived_dict.GetKeys(fallbacks));
+    EXPECT_EQ(values, derived_dict.GetValues(fallbacks));
+  }
+  EXPECT_EQ(derived_dict.GetSizeNoFallbacks(), 3);
+}
+
 TEST(DictTest, GetKeysWithFallbackEmptyMain) {
   std::shared_ptr<DictVector> dicts = std::make_shared<DictVector>(1);
   auto& dict = (*dicts)[0];
@@ -14,12 +14,16 @@
 //
 #include "koladata/internal/error_utils.h"
 
+#include <cstring>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
 
+#include "absl/base/call_once.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
+#include "absl/strings/cord.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "koladata/internal/data_item.h"
@@ -35,24 +39,117 @@ namespace koladata::internal {
 using arolla::TypedValue;
 using arolla::serialization_base::ContainerProto;
 
+namespace {
+
+constexpr absl::string_view kLazyErrorUrl = "koladata.internal.LazyError";
+
+// State of a lazy Error payload. It is owned by the payload Cord itself (as
+// the releaser of its external memory), so it lives exactly as long as some
+// copy of the status refers to it.
+class LazyErrorPayload {
+ public:
+  LazyErrorPayload(std::string message, ErrorPayloadFn error_fn)
+      : message_(std::move(message)), error_fn_(std::move(error_fn)) {
+    tag_[0] = tag_;
+    tag_[1] = this;
+  }
+
+  LazyErrorPayload(const LazyErrorPayload&) = delete;
+  LazyErrorPayload& operator=(const LazyErrorPayload&) = delete;
+
+  // Returns a Cord owning `payload`.
+  static absl::Cord ToCord(std::unique_ptr<LazyErrorPayload> payload) {
+    absl::string_view tag(reinterpret_cast<const char*>(payload->tag_),
+                          sizeof(payload->tag_));
+    return absl::MakeCordFromExternal(
+        tag, [payload = std::move(payload)](absl::string_view) {});
+  }
+
+  // Returns the payload owned by `cord`, or nullptr if `cord` is not a Cord
+  // returned by ToCord. The Cord refers to the memory of the payload, which
+  // starts with its own address. If the bytes were copied into another Cord
+  // (which doesn't keep the payload alive), the addresses don't match.
+  static const LazyErrorPayload* FromCord(const absl::Cord& cord) {
+    std::optional<absl::string_view> flat = cord.TryFlat();
+    const void* tag[2];
+    if (!flat.has_value() || flat->size() != sizeof(tag)) {
+      return nullptr;
+    }
+    std::memcpy(tag, flat->data(), sizeof(tag));
+    if (tag[0] != flat->data()) {
+      return nullptr;
+    }
+    return static_cast<const LazyErrorPayload*>(tag[1]);
+  }
+
+  const Error& Get() const {
+    absl::call_once(once_, [this] {
+      absl::StatusOr<Error> error = std::move(error_fn_)();
+      error_fn_ = nullptr;
+      if (error.ok()) {
+        error_ = *std::move(error);
+      } else {
+        error_.set_error_message(absl::StrCat(
+            message_,
+            "; Error when creating KodaError: ", error.status().message()));
+      }
+    });
+    return error_;
+  }
+
+ private:
+  // {tag_, this}, the content of the Cord.
+  const void* tag_[2];
+  mutable absl::once_flag once_;
+  std::string message_;
+  mutable ErrorPayloadFn error_fn_;
+  mutable Error error_;
+};
+
+}  // namespace
+
 std::optional<Error> GetErrorPayload(const absl::Status& status) {
-  auto error_payload = status.GetPayload(kErrorUrl);
-  if (!error_payload) {
-    return std::nullopt;
+  if (auto error_payload = status.GetPayload(kErrorUrl)) {
+    Error error;
+    error.ParsePartialFromCord(*error_payload);
+    return error;
   }
-  Error error;
-  error.ParsePartialFromCord(*error_payload);
-  return error;
+  // The copy of the payload keeps the LazyErrorPayload alive.
+  if (std::optional<absl::Cord> lazy_payload =
+          status.GetPayload(kLazyErrorUrl)) {
+    if (const auto* payload = LazyErrorPayload::FromCord(*lazy_payload)) {
+      return payload->Get();
+    }
+  }
+  return std::nullopt;
+}
+
+bool HasErrorPayload(const absl::Status& status) {
+  return status.GetPayload(kErrorUrl).has_value() ||
+         status.GetPayload(kLazyErrorUrl).has_value();
 }
 
 absl::Status WithErrorPayload(absl::Status status, const Error& error) {
   if (status.ok()) {
     return status;
   }
+  status.ErasePayload(kLazyErrorUrl);
   status.SetPayload(kErrorUrl, error.SerializePartialAsCord());
   return status;
 }
 
+absl::Status WithLazyErrorPayload(absl::Status status,
+                                  ErrorPayloadFn error_fn) {
+  if (status.ok()) {
+    return status;
+  }
+  status.ErasePayload(kErrorUrl);
+  status.SetPayload(kLazyErrorUrl,
+                    LazyErrorPayload::ToCord(std::make_unique<LazyErrorPayload>(
+                        std::string(status.message()), std::move(error_fn))));
+  return status;
+}
+
 absl::Status WithErrorPayload(absl::Status status,
                               absl::StatusOr<Error> error) {
   if (!error.ok()) {
@@ -17,6 +17,7 @@
 
 #include <optional>
 
+#include "absl/functional/any_invocable.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -29,9 +30,14 @@ namespace koladata::internal {
 
 constexpr absl::string_view kErrorUrl = "koladata.internal.Error";
 
-// Gets the Error proto payload from status.
+// Gets the Error proto payload from status. A lazy payload (see
+// WithLazyErrorPayload) is created by the first call.
 std::optional<Error> GetErrorPayload(const absl::Status& status);
 
+// Returns true if the `status` has an Error payload, without creating a lazy
+// one.
+bool HasErrorPayload(const absl::Status& status);
+
 // Sets the `error` in the payload of the `status` if not ok. Otherwise, returns
 // the `status`.
 absl::Status WithErrorPayload(absl::Status status, const Error& error);
@@ -40,6 +46,19 @@ absl::Status WithErrorPayload(absl::Status status, const Error& error);
 // ok, the error message of `error` will be appended to the `status`.
 absl::Status WithErrorPayload(absl::Status status, absl::StatusOr<Error> error);
 
+// Produces the Error payload of a status on demand.
+using ErrorPayloadFn = absl::AnyInvocable<absl::StatusOr<Error>() &&>;
+
+// Like WithErrorPayload, but `error_fn` is only called (at most once, shared by
+// the copies of the returned status) when the payload is requested by
+// GetErrorPayload, e.g. to render the error. Many errors are handled by the
+// caller (e.g. a fallback is tried) and never rendered, so the payload, which
+// often requires encoding DataItems, is not worth building upfront.
+//
+// If `error_fn` fails, the payload is an Error with the message of `status`
+// annotated with the failure.
+absl::Status WithLazyErrorPayload(absl::Status status, ErrorPayloadFn error_fn);
+
 // Creates the no common schema error proto from the given schema id and dtype.
 absl::StatusOr<Error> CreateNoCommonSchemaError(
     const DataItem& common_schema, const DataItem& conflicting_schema);
@@ -15,6 +15,7 @@
 #include "koladata/internal/error_utils.h"
 
 #include <optional>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -22,6 +23,8 @@
 #include "gtest/gtest.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/cord.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/dtype.h"
 #include "koladata/internal/error.pb.h"
@@ -110,6 +113,94 @@ TEST(ErrorUtilsTest, WithErrorPayloadHandleError) {
                HasSubstr("; Error when creating KodaError")));
 }
 
+TEST(ErrorUtilsTest, LazyPayload) {
+  int calls = 0;
+  absl::Status status = WithLazyErrorPayload(
+      absl::InvalidArgumentError("Test error"),
+      [&calls]() -> absl::StatusOr<Error> {
+        ++calls;
+        Error error;
+        error.set_error_message("test error message");
+        return error;
+      });
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kInvalidArgument,
+                               "Test error"));
+  EXPECT_TRUE(HasErrorPayload(status));
+  EXPECT_EQ(calls, 0);
+
+  // Copies of the status share the payload, which is created once.
+  absl::Status status_copy = status;
+  EXPECT_THAT(
+      GetErrorPayload(status_copy),
+      Optional(EqualsProto(R"pb(error_message: "test error message")pb")));
+  EXPECT_THAT(
+      GetErrorPayload(status),
+      Optional(EqualsProto(R"pb(error_message: "test error message")pb")));
+  EXPECT_EQ(calls, 1);
+
+  // An eager payload replaces the lazy one.
+  Error error;
+  error.set_error_message("eager");
+  status = WithErrorPayload(status, error);
+  EXPECT_THAT(GetErrorPayload(status),
+              Optional(EqualsProto(R"pb(error_message: "eager")pb")));
+  status = WithLazyErrorPayload(status, [] { return Error(); });
+  EXPECT_THAT(GetErrorPayload(status), Optional(EqualsProto("")));
+}
+
+TEST(ErrorUtilsTest, LazyPayloadBytesCopied) {
+  absl::Status status = WithLazyErrorPayload(
+      absl::InvalidArgumentError("Test error"), []() -> absl::StatusOr<Error> {
+        Error error;
+        error.set_error_message("test error message");
+        return error;
+      });
+  std::optional<absl::Cord> payload =
+      status.GetPayload("koladata.internal.LazyError");
+  ASSERT_TRUE(payload.has_value());
+  // A payload re-created from the bytes doesn't own the lazy state.
+  absl::Status copied = absl::InvalidArgumentError("Test error");
+  copied.SetPayload("koladata.internal.LazyError",
+                    absl::Cord(std::string(*payload)));
+  EXPECT_TRUE(HasErrorPayload(copied));
+  EXPECT_EQ(GetErrorPayload(copied), std::nullopt);
+  EXPECT_THAT(
+      GetErrorPayload(status),
+      Optional(EqualsProto(R"pb(error_message: "test error message")pb")));
+}
+
+TEST(ErrorUtilsTest, LazyPayloadOkStatus) {
+  bool called = false;
+  absl::Status status =
+      WithLazyErrorPayload(absl::OkStatus(), [&]() -> absl::StatusOr<Error> {
+        called = true;
+        return Error();
+      });
+  EXPECT_OK(status);
+  EXPECT_FALSE(HasErrorPayload(status));
+  EXPECT_EQ(GetErrorPayload(status), std::nullopt);
+  EXPECT_FALSE(called);
+}
+
+TEST(ErrorUtilsTest, LazyPayloadHandleError) {
+  absl::Status status = WithLazyErrorPayload(
+      absl::UnimplementedError("Test error"), []() -> absl::StatusOr<Error> {
+        return absl::InternalError("Create error proto error");
+      });
+  EXPECT_THAT(status, StatusIs(absl::StatusCode::kUnimplemented, "Test error"));
+  std::optional<Error> payload = GetErrorPayload(status);
+  ASSERT_TRUE(payload.has_value());
+  EXPECT_EQ(payload->error_message(),
+            "Test error; Error when creating KodaError: Create error proto "
+            "error");
+}
+
+TEST(ErrorUtilsTest, NoPayload) {
+  absl::Status status = absl::InternalError("Test error");
+  EXPECT_FALSE(HasErrorPayload(status));
+  EXPECT_EQ(GetErrorPayload(status), std::nullopt);
+}
+
 TEST(ErrorUtilsTest, Annotate) {
   absl::Status status = absl::UnimplementedError("Test error");
   absl::Status annotated_status = Annotate(status, "Extra error message");
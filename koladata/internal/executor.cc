@@ -0,0 +1,251 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/executor.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/base/no_destructor.h"
+#include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+#include "koladata/internal/cancellation.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::internal {
+
+ThreadPoolExecutor::ThreadPoolExecutor(size_t num_threads) {
+  DCHECK_GT(num_threads, 0);
+  threads_.reserve(num_threads);
+  for (size_t i = 0; i < num_threads; ++i) {
+    threads_.emplace_back([this] { WorkerLoop(); });
+  }
+}
+
+ThreadPoolExecutor::~ThreadPoolExecutor() {
+  {
+    absl::MutexLock lock(&mutex_);
+    stopping_ = true;
+  }
+  for (std::thread& thread : threads_) {
+    thread.join();
+  }
+}
+
+void ThreadPoolExecutor::Schedule(absl::AnyInvocable<void() &&> task) {
+  absl::MutexLock lock(&mutex_);
+  queue_.push_back(std::move(task));
+}
+
+void ThreadPoolExecutor::WorkerLoop() {
+  while (true) {
+    absl::AnyInvocable<void() &&> task;
+    {
+      absl::MutexLock lock(&mutex_);
+      mutex_.Await(absl::Condition(
+          +[](ThreadPoolExecutor* self) ABSL_EXCLUSIVE_LOCKS_REQUIRED(
+               self->mutex_) { return self->stopping_ || !self->queue_.empty(); },
+          this));
+      if (queue_.empty()) {
+        return;  // stopping_ is set and all tasks are processed.
+      }
+      // LIFO order is fine here: all the tasks originate from ParallelFor and
+      // are equivalent.
+      task = std::move(queue_.back());
+      queue_.pop_back();
+    }
+    std::move(task)();
+  }
+}
+
+namespace {
+
+// State shared between the caller of ParallelFor and the helper tasks.
+// Helpers may start after ParallelFor returned, so the state is refcounted and
+// helpers must not touch `fn` unless they claimed an index < n.
+struct ParallelForState {
+  explicit ParallelForState(int64_t n) : n(n) {}
+
+  const int64_t n;
+  std::atomic<int64_t> next_index = 0;
+  std::atomic<bool> failed = false;
+
+  absl::Mutex mutex;
+  int64_t completed ABSL_GUARDED_BY(mutex) = 0;
+  int64_t error_index ABSL_GUARDED_BY(mutex) =
+      std::numeric_limits<int64_t>::max();
+  absl::Status status ABSL_GUARDED_BY(mutex);
+};
+
+void RunParallelForLoop(ParallelForState& state,
+                        absl::FunctionRef<absl::Status(int64_t)> fn) {
+  int64_t i;
+  while ((i = state.next_index.fetch_add(1, std::memory_order_relaxed)) <
+         state.n) {
+    absl::Status status;
+    if (!state.failed.load(std::memory_order_relaxed)) {
+      status = CheckCancellation();
+      if (status.ok()) {
+        status = fn(i);
+      }
+    }
+    absl::MutexLock lock(&state.mutex);
+    if (!status.ok()) {
+      state.failed.store(true, std::memory_order_relaxed);
+      if (i < state.error_index) {
+        state.error_index = i;
+        state.status = std::move(status);
+      }
+    }
+    ++state.completed;
+  }
+}
+
+}  // namespace
+
+absl::Status ParallelFor(Executor* executor, int64_t n,
+                         absl::FunctionRef<absl::Status(int64_t)> fn) {
+  if (n <= 0) {
+    return absl::OkStatus();
+  }
+  if (executor == nullptr || n == 1 || executor->parallelism() == 0) {
+    for (int64_t i = 0; i < n; ++i) {
+      RETURN_IF_ERROR(CheckCancellation());
+      RETURN_IF_ERROR(fn(i));
+    }
+    return absl::OkStatus();
+  }
+  auto state = std::make_shared<ParallelForState>(n);
+  int64_t num_helpers =
+      std::min<int64_t>(n - 1, static_cast<int64_t>(executor->parallelism()));
+  // The helpers check the cancellation token of the caller. The token is only
+  // used by the helpers that claim an index, i.e. before ParallelFor returns.
+  const CancellationToken* cancellation = CurrentCancellationToken();
+  for (int64_t i = 0; i < num_helpers; ++i) {
+    executor->Schedule([state, fn, cancellation] {
+      ScopedCancellationToken cancellation_scope(cancellation);
+      RunParallelForLoop(*state, fn);
+    });
+  }
+  // The calling thread participates, so that the progress is guaranteed even
+  // if all the executor threads are busy (e.g. nested ParallelFor calls).
+  RunParallelForLoop(*state, fn);
+
+  absl::MutexLock lock(&state->mutex);
+  state->mutex.Await(absl::Condition(
+      +[](ParallelForState* s) ABSL_EXCLUSIVE_LOCKS_REQUIRED(s->mutex) {
+        return s->completed == s->n;
+      },
+      state.get()));
+  return std::move(state->status);
+}
+
+namespace {
+
+struct DefaultExecutorState {
+  absl::Mutex mutex;
+  size_t num_threads ABSL_GUARDED_BY(mutex) = 0;
+  std::shared_ptr<Executor> executor ABSL_GUARDED_BY(mutex);
+};
+
+DefaultExecutorState& GetDefaultExecutorState() {
+  static absl::NoDestructor<DefaultExecutorState> state;
+  return *state;
+}
+
+std::atomic<int64_t> min_parallel_chunk_size = 1;
+
+thread_local const ScopedExecutor* current_scoped_executor = nullptr;
+
+}  // namespace
+
+int64_t ParallelChunkCount(const Executor* executor, int64_t size,
+                           int64_t min_chunk_size) {
+  if (executor == nullptr || size <= 0) {
+    return 1;
+  }
+  min_chunk_size = std::max<int64_t>(
+      {min_chunk_size, min_parallel_chunk_size.load(std::memory_order_relaxed),
+       1});
+  int64_t max_chunks = std::max<int64_t>(size / min_chunk_size, 1);
+  // The calling thread participates in ParallelFor, hence `+ 1`.
+  return std::min<int64_t>(
+      max_chunks, static_cast<int64_t>(executor->parallelism()) + 1);
+}
+
+void SetDefaultExecutorThreads(size_t num_threads) {
+  std::shared_ptr<Executor> previous;
+  {
+    DefaultExecutorState& state = GetDefaultExecutorState();
+    absl::MutexLock lock(&state.mutex);
+    if (state.num_threads == num_threads) {
+      return;
+    }
+    state.num_threads = num_threads;
+    previous = std::move(state.executor);
+    if (num_threads > 0) {
+      state.executor = std::make_shared<ThreadPoolExecutor>(num_threads);
+    }
+  }
+  // `previous` is released outside of the lock: if it is not in use, the
+  // destructor joins its threads.
+}
+
+size_t GetDefaultExecutorThreads() {
+  DefaultExecutorState& state = GetDefaultExecutorState();
+  absl::MutexLock lock(&state.mutex);
+  return state.num_threads;
+}
+
+void SetMinParallelChunkSize(int64_t min_chunk_size) {
+  min_parallel_chunk_size.store(std::max<int64_t>(min_chunk_size, 1),
+                                std::memory_order_relaxed);
+}
+
+int64_t GetMinParallelChunkSize() {
+  return min_parallel_chunk_size.load(std::memory_order_relaxed);
+}
+
+ScopedExecutor::ScopedExecutor(absl::Nullable<Executor*> executor)
+    : previous_(current_scoped_executor), executor_(executor) {
+  current_scoped_executor = this;
+}
+
+ScopedExecutor::~ScopedExecutor() { current_scoped_executor = previous_; }
+
+absl::Nullable<std::shared_ptr<Executor>> CurrentExecutor() {
+  if (current_scoped_executor != nullptr) {
+    // The scoped executor is owned by the caller, so the aliasing constructor
+    // is used to return a non-owning pointer.
+    return std::shared_ptr<Executor>(std::shared_ptr<void>(),
+                                     current_scoped_executor->executor());
+  }
+  DefaultExecutorState& state = GetDefaultExecutorState();
+  absl::MutexLock lock(&state.mutex);
+  return state.executor;
+}
+
+}  // namespace koladata::internal
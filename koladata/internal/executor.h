@@ -0,0 +1,138 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_EXECUTOR_H_
+#define KOLADATA_INTERNAL_EXECUTOR_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/base/thread_annotations.h"
+#include "absl/functional/any_invocable.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/synchronization/mutex.h"
+
+namespace koladata::internal {
+
+// Interface for running independent tasks concurrently. Parallel code paths in
+// koladata take an `Executor*`; nullptr means "run inline on the calling
+// thread". The code paths that are not given an executor explicitly (e.g.
+// operators) use CurrentExecutor().
+class Executor {
+ public:
+  virtual ~Executor() = default;
+
+  // Schedules `task` to be run eventually. The call must not block on the
+  // completion of the task.
+  virtual void Schedule(absl::AnyInvocable<void() &&> task) = 0;
+
+  // Returns the number of tasks that can make progress concurrently. Used as a
+  // hint for splitting work into chunks.
+  virtual size_t parallelism() const = 0;
+};
+
+// Simple fixed-size thread pool. Destructor waits for all scheduled tasks.
+class ThreadPoolExecutor final : public Executor {
+ public:
+  explicit ThreadPoolExecutor(size_t num_threads);
+  ThreadPoolExecutor(const ThreadPoolExecutor&) = delete;
+  ThreadPoolExecutor& operator=(const ThreadPoolExecutor&) = delete;
+  ~ThreadPoolExecutor() override;
+
+  void Schedule(absl::AnyInvocable<void() &&> task) override;
+  size_t parallelism() const override { return threads_.size(); }
+
+ private:
+  void WorkerLoop();
+
+  absl::Mutex mutex_;
+  std::vector<absl::AnyInvocable<void() &&>> queue_ ABSL_GUARDED_BY(mutex_);
+  bool stopping_ ABSL_GUARDED_BY(mutex_) = false;
+  std::vector<std::thread> threads_;
+};
+
+// Calls `fn(i)` for every i in [0, n) using `executor` and blocks until all the
+// calls are finished. The calling thread participates in the processing. If
+// `executor` is nullptr or n <= 1, everything is done on the calling thread.
+// Returns the error of the task with the smallest index if any fails. Once an
+// error is observed, not yet started tasks are skipped. The cancellation token
+// of the calling thread (see cancellation.h) is checked before each task and
+// is installed on the executor threads for the duration of the tasks.
+absl::Status ParallelFor(Executor* executor, int64_t n,
+                         absl::FunctionRef<absl::Status(int64_t)> fn);
+
+// Returns the number of chunks to split `size` elements into, so that each
+// chunk has at least `min_chunk_size` elements (except for a single chunk) and
+// there are not more than `executor->parallelism()` chunks. Returns 1 if
+// executor is nullptr. `min_chunk_size` is raised to GetMinParallelChunkSize()
+// if the latter is larger.
+int64_t ParallelChunkCount(const Executor* executor, int64_t size,
+                           int64_t min_chunk_size);
+
+// Sets the number of threads of the process-wide executor returned by
+// CurrentExecutor() when no ScopedExecutor is active. 0 (the default) means
+// that the work is done serially on the calling thread. The previous executor
+// is destroyed once the calls that are using it are finished.
+void SetDefaultExecutorThreads(size_t num_threads);
+
+// Returns the number of threads of the process-wide executor.
+size_t GetDefaultExecutorThreads();
+
+// Sets the process-wide lower bound of the chunk sizes used by
+// ParallelChunkCount, i.e. inputs smaller than `min_chunk_size` are always
+// processed inline. The per-path thresholds still apply if they are larger.
+void SetMinParallelChunkSize(int64_t min_chunk_size);
+
+// Returns the value set by SetMinParallelChunkSize (1 by default).
+int64_t GetMinParallelChunkSize();
+
+// While alive, CurrentExecutor() returns `executor` on the current thread
+// instead of the process-wide executor. nullptr forces the serial evaluation,
+// e.g. for reproducible benchmarks or debugging. The executor must outlive the
+// scope.
+//
+// Example:
+//   ThreadPoolExecutor executor(4);
+//   ScopedExecutor scoped_executor(&executor);
+//   ASSIGN_OR_RETURN(auto groups, ops::GroupByIndices(slices));
+class ScopedExecutor {
+ public:
+  explicit ScopedExecutor(absl::Nullable<Executor*> executor);
+  ~ScopedExecutor();
+
+  ScopedExecutor(const ScopedExecutor&) = delete;
+  ScopedExecutor& operator=(const ScopedExecutor&) = delete;
+
+  absl::Nullable<Executor*> executor() const { return executor_; }
+
+ private:
+  const ScopedExecutor* previous_;
+  absl::Nullable<Executor*> executor_;
+};
+
+// Returns the executor for the parallel code paths that are not given one
+// explicitly: the innermost ScopedExecutor of the current thread or the
+// process-wide executor. Returns nullptr in the serial mode. The returned
+// pointer keeps the process-wide executor alive, so it must be held for the
+// duration of the call.
+absl::Nullable<std::shared_ptr<Executor>> CurrentExecutor();
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_EXECUTOR_H_
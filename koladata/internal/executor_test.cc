@@ -0,0 +1,153 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/executor.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::Each;
+using ::testing::Eq;
+
+TEST(ExecutorTest, ParallelForWithoutExecutor) {
+  std::vector<int> visited(10);
+  ASSERT_OK(ParallelFor(nullptr, visited.size(), [&](int64_t i) {
+    ++visited[i];
+    return absl::OkStatus();
+  }));
+  EXPECT_THAT(visited, Each(Eq(1)));
+}
+
+TEST(ExecutorTest, ParallelForWithThreadPool) {
+  ThreadPoolExecutor executor(4);
+  EXPECT_EQ(executor.parallelism(), 4);
+  std::vector<std::atomic<int>> visited(1000);
+  ASSERT_OK(ParallelFor(&executor, visited.size(), [&](int64_t i) {
+    visited[i].fetch_add(1);
+    return absl::OkStatus();
+  }));
+  for (const auto& v : visited) {
+    EXPECT_EQ(v.load(), 1);
+  }
+}
+
+TEST(ExecutorTest, ParallelForNested) {
+  ThreadPoolExecutor executor(2);
+  std::atomic<int> count = 0;
+  ASSERT_OK(ParallelFor(&executor, 8, [&](int64_t) {
+    return ParallelFor(&executor, 8, [&](int64_t) {
+      count.fetch_add(1);
+      return absl::OkStatus();
+    });
+  }));
+  EXPECT_EQ(count.load(), 64);
+}
+
+TEST(ExecutorTest, ParallelForError) {
+  ThreadPoolExecutor executor(4);
+  EXPECT_THAT(ParallelFor(&executor, 100,
+                          [&](int64_t i) {
+                            if (i == 17) {
+                              return absl::InvalidArgumentError("fail");
+                            }
+                            return absl::OkStatus();
+                          }),
+              StatusIs(absl::StatusCode::kInvalidArgument, "fail"));
+  EXPECT_THAT(ParallelFor(nullptr, 100,
+                          [&](int64_t i) {
+                            if (i >= 3) {
+                              return absl::InvalidArgumentError("fail");
+                            }
+                            return absl::OkStatus();
+                          }),
+              StatusIs(absl::StatusCode::kInvalidArgument, "fail"));
+}
+
+TEST(ExecutorTest, ParallelChunkCount) {
+  ThreadPoolExecutor executor(3);
+  EXPECT_EQ(ParallelChunkCount(nullptr, 1000000, 10), 1);
+  EXPECT_EQ(ParallelChunkCount(&executor, 0, 10), 1);
+  EXPECT_EQ(ParallelChunkCount(&executor, 15, 10), 1);
+  EXPECT_EQ(ParallelChunkCount(&executor, 25, 10), 2);
+  EXPECT_EQ(ParallelChunkCount(&executor, 1000000, 10), 4);
+}
+
+TEST(ExecutorTest, MinParallelChunkSize) {
+  ThreadPoolExecutor executor(3);
+  EXPECT_EQ(GetMinParallelChunkSize(), 1);
+  SetMinParallelChunkSize(100);
+  EXPECT_EQ(ParallelChunkCount(&executor, 150, 10), 1);
+  EXPECT_EQ(ParallelChunkCount(&executor, 250, 10), 2);
+  EXPECT_EQ(ParallelChunkCount(&executor, 250, 200), 1);
+  SetMinParallelChunkSize(0);
+  EXPECT_EQ(GetMinParallelChunkSize(), 1);
+  EXPECT_EQ(ParallelChunkCount(&executor, 25, 10), 2);
+}
+
+TEST(ExecutorTest, DefaultExecutor) {
+  EXPECT_EQ(GetDefaultExecutorThreads(), 0);
+  EXPECT_EQ(CurrentExecutor(), nullptr);
+
+  SetDefaultExecutorThreads(2);
+  EXPECT_EQ(GetDefaultExecutorThreads(), 2);
+  std::shared_ptr<Executor> executor = CurrentExecutor();
+  ASSERT_NE(executor, nullptr);
+  EXPECT_EQ(executor->parallelism(), 2);
+  EXPECT_EQ(CurrentExecutor(), executor);
+
+  // The executor in use stays alive after reconfiguration.
+  SetDefaultExecutorThreads(3);
+  EXPECT_EQ(CurrentExecutor()->parallelism(), 3);
+  std::vector<int> visited(10);
+  ASSERT_OK(ParallelFor(executor.get(), visited.size(), [&](int64_t i) {
+    ++visited[i];
+    return absl::OkStatus();
+  }));
+  EXPECT_THAT(visited, Each(Eq(1)));
+  executor.reset();
+
+  SetDefaultExecutorThreads(0);
+  EXPECT_EQ(CurrentExecutor(), nullptr);
+}
+
+TEST(ExecutorTest, ScopedExecutor) {
+  SetDefaultExecutorThreads(2);
+  std::shared_ptr<Executor> default_executor = CurrentExecutor();
+  ThreadPoolExecutor executor(3);
+  {
+    ScopedExecutor scoped_executor(&executor);
+    EXPECT_EQ(CurrentExecutor().get(), &executor);
+    {
+      ScopedExecutor serial(nullptr);
+      EXPECT_EQ(CurrentExecutor(), nullptr);
+    }
+    EXPECT_EQ(CurrentExecutor().get(), &executor);
+  }
+  EXPECT_EQ(CurrentExecutor(), default_executor);
+  SetDefaultExecutorThreads(0);
+}
+
+}  // namespace
+}  // namespace koladata::internal
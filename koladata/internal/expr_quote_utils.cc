@@ -14,12 +14,16 @@
 //
 #include "koladata/internal/expr_quote_utils.h"
 
+#include <memory>
 #include <string>
 
+#include "absl/base/no_destructor.h"
 #include "absl/strings/string_view.h"
+#include "koladata/internal/sharded_lru_cache.h"
 #include "arolla/expr/expr_debug_string.h"
 #include "arolla/expr/quote.h"
 #include "arolla/serialization/encode.h"
+#include "arolla/util/fingerprint.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata::internal {
@@ -29,17 +33,37 @@ namespace {
 constexpr absl::string_view kUnsupportedExprQuote = "<unsupported ExprQuote>";
 constexpr absl::string_view kUninitializedExprQuote = "<uninitialized ExprQuote>";
 
-}  // namespace
-
-std::string StableFingerprint(const arolla::expr::ExprQuote& expr_quote) {
-  ASSIGN_OR_RETURN(auto expr, expr_quote.expr(),
-                   std::string(kUninitializedExprQuote));
+std::string EncodeExpr(const arolla::expr::ExprNodePtr& expr) {
   ASSIGN_OR_RETURN(auto container_proto,
                    arolla::serialization::Encode({}, {expr}),
                    std::string(kUnsupportedExprQuote));
   return container_proto.SerializeAsString();
 }
 
+}  // namespace
+
+std::string StableFingerprint(const arolla::expr::ExprQuote& expr_quote) {
+  return *CachedStableFingerprint(expr_quote);
+}
+
+std::shared_ptr<const std::string> CachedStableFingerprint(
+    const arolla::expr::ExprQuote& expr_quote) {
+  using Cache = ShardedLruCache<arolla::Fingerprint,
+                                std::shared_ptr<const std::string>>;
+  static absl::NoDestructor<Cache> cache(/*capacity=*/1024);
+  static absl::NoDestructor<std::shared_ptr<const std::string>> uninitialized(
+      std::make_shared<const std::string>(kUninitializedExprQuote));
+  if (!expr_quote.has_expr()) {
+    return *uninitialized;
+  }
+  const arolla::expr::ExprNodePtr& expr = *expr_quote;
+  if (auto result = cache->LookupOrNull(expr->fingerprint())) {
+    return result;
+  }
+  return cache->Put(expr->fingerprint(),
+                    std::make_shared<const std::string>(EncodeExpr(expr)));
+}
+
 std::string ExprQuoteDebugString(const arolla::expr::ExprQuote& expr_quote) {
   if (!expr_quote.has_expr()) {
     return std::string(kUninitializedExprQuote);
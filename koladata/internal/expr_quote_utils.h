@@ -15,14 +15,24 @@
 #ifndef KOLADATA_INTERNAL_EXPR_QUOTE_UTILS_H_
 #define KOLADATA_INTERNAL_EXPR_QUOTE_UTILS_H_
 
+#include <memory>
 #include <string>
 
 #include "arolla/expr/quote.h"
 
 namespace koladata::internal {
 
+// Returns a string identifying the expr of `expr_quote` that is stable across
+// processes (its serialization).
 std::string StableFingerprint(const arolla::expr::ExprQuote& expr_quote);
 
+// Same as StableFingerprint, but without copying. The results for recently
+// used exprs are cached by the (in-process) fingerprint of the expr, so that
+// repeatedly hashing the same (possibly large) functor expr doesn't serialize
+// it each time.
+std::shared_ptr<const std::string> CachedStableFingerprint(
+    const arolla::expr::ExprQuote& expr_quote);
+
 std::string ExprQuoteDebugString(const arolla::expr::ExprQuote& expr_quote);
 
 }  // namespace koladata::internal
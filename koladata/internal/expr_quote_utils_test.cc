@@ -46,6 +46,36 @@ TEST(ExprQuoteUtils, StableFingerprint) {
             StableFingerprint(arolla::expr::ExprQuote(expr_2)));
 }
 
+TEST(ExprQuoteUtils, CachedStableFingerprint) {
+  ASSERT_OK_AND_ASSIGN(
+      auto expr_1,
+      arolla::expr::CallOp("math.add",
+                           {arolla::expr::Leaf("x"),
+                            arolla::expr::Literal(0)}));
+  // Equal to expr_1, but a different node.
+  ASSERT_OK_AND_ASSIGN(
+      auto expr_1_copy,
+      arolla::expr::CallOp("math.add",
+                           {arolla::expr::Leaf("x"),
+                            arolla::expr::Literal(0)}));
+  ASSERT_OK_AND_ASSIGN(
+      auto expr_2,
+      arolla::expr::CallOp("math.add",
+                           {arolla::expr::Leaf("y"),
+                            arolla::expr::Literal(0)}));
+
+  auto fingerprint_1 =
+      CachedStableFingerprint(arolla::expr::ExprQuote(expr_1));
+  EXPECT_EQ(*fingerprint_1,
+            StableFingerprint(arolla::expr::ExprQuote(expr_1)));
+  EXPECT_EQ(CachedStableFingerprint(arolla::expr::ExprQuote(expr_1_copy)),
+            fingerprint_1);
+  EXPECT_NE(*CachedStableFingerprint(arolla::expr::ExprQuote(expr_2)),
+            *fingerprint_1);
+  EXPECT_EQ(*CachedStableFingerprint(arolla::expr::ExprQuote()),
+            "<uninitialized ExprQuote>");
+}
+
 TEST(ExprQuoteUtils, StableFingerprint_MissingExpr_Error) {
   EXPECT_EQ(StableFingerprint(arolla::expr::ExprQuote(nullptr)),
             "<uninitialized ExprQuote>");
@@ -0,0 +1,98 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/large_buffer.h"
+
+#include <sys/mman.h>
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+
+#include "absl/log/check.h"
+
+namespace koladata::internal {
+namespace {
+
+std::atomic<size_t> huge_page_buffer_threshold = 0;
+
+size_t RoundUp(size_t size, size_t alignment) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+// Maps `size` bytes (a multiple of kHugePageSize) aligned to kHugePageSize.
+// Returns nullptr on failure.
+void* MapHugePages(size_t size) {
+  // Over-map by a huge page and unmap the unaligned head and tail.
+  const size_t mapped_size = size + kHugePageSize;
+  void* addr = mmap(nullptr, mapped_size, PROT_READ | PROT_WRITE,
+                    MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (addr == MAP_FAILED) {
+    return nullptr;
+  }
+  const uintptr_t begin = reinterpret_cast<uintptr_t>(addr);
+  const uintptr_t aligned_begin = RoundUp(begin, kHugePageSize);
+  if (aligned_begin > begin) {
+    munmap(addr, aligned_begin - begin);
+  }
+  const uintptr_t tail = aligned_begin + size;
+  if (begin + mapped_size > tail) {
+    munmap(reinterpret_cast<void*>(tail), begin + mapped_size - tail);
+  }
+  void* result = reinterpret_cast<void*>(aligned_begin);
+#ifdef MADV_HUGEPAGE
+  // Only a hint: fails e.g. if transparent huge pages are disabled.
+  madvise(result, size, MADV_HUGEPAGE);
+#endif  // MADV_HUGEPAGE
+  return result;
+}
+
+}  // namespace
+
+size_t SetHugePageBufferThreshold(size_t threshold) {
+  return huge_page_buffer_threshold.exchange(threshold,
+                                             std::memory_order_relaxed);
+}
+
+size_t GetHugePageBufferThreshold() {
+  return huge_page_buffer_threshold.load(std::memory_order_relaxed);
+}
+
+void LargeBufferDeleter::operator()(void* ptr) const {
+  if (is_mapped()) {
+    munmap(ptr, mapped_size_);
+  } else {
+    free(ptr);
+  }
+}
+
+LargeBufferPtr AllocateLargeBuffer(size_t size, bool zeroed) {
+  const size_t threshold = GetHugePageBufferThreshold();
+  if (threshold > 0 && size >= threshold) {
+    const size_t mapped_size = RoundUp(size, kHugePageSize);
+    if (void* ptr = MapHugePages(mapped_size); ptr != nullptr) {
+      return LargeBufferPtr(ptr, LargeBufferDeleter(mapped_size));
+    }
+    // Falls back to malloc, e.g. if the mapping count limit is reached.
+  }
+  // At least 1 byte, so that nullptr is not returned for empty buffers.
+  void* ptr = zeroed ? calloc(std::max<size_t>(size, 1), 1)
+                     : malloc(std::max<size_t>(size, 1));
+  CHECK(ptr != nullptr) << "failed to allocate " << size << " bytes";
+  return LargeBufferPtr(ptr, LargeBufferDeleter());
+}
+
+}  // namespace koladata::internal
@@ -0,0 +1,65 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_LARGE_BUFFER_H_
+#define KOLADATA_INTERNAL_LARGE_BUFFER_H_
+
+#include <cstddef>
+#include <memory>
+
+namespace koladata::internal {
+
+// Size of the transparent huge pages on x86-64 and most aarch64 kernels.
+constexpr size_t kHugePageSize = size_t{2} << 20;
+
+// Sets the size in bytes starting from which the buffers of mutable dense
+// sources are mapped separately, aligned to huge pages and advised to be
+// backed by transparent huge pages (madvise(MADV_HUGEPAGE)). That reduces TLB
+// misses of the scans over large attributes. 0 (the default) disables it.
+//
+// The mapped pages are not touched on allocation, so they are placed on the
+// NUMA node of the thread that first writes them (the kernel's default
+// first-touch policy), e.g. the worker filling a partition of the
+// allocation. Returns the previous threshold.
+size_t SetHugePageBufferThreshold(size_t threshold);
+
+// Returns the current threshold, see SetHugePageBufferThreshold.
+size_t GetHugePageBufferThreshold();
+
+// Releases the buffers returned by AllocateLargeBuffer.
+class LargeBufferDeleter {
+ public:
+  LargeBufferDeleter() = default;
+  explicit LargeBufferDeleter(size_t mapped_size) : mapped_size_(mapped_size) {}
+
+  void operator()(void* ptr) const;
+
+  // Returns true if the buffer is mapped separately with huge pages.
+  bool is_mapped() const { return mapped_size_ != 0; }
+
+ private:
+  size_t mapped_size_ = 0;
+};
+
+using LargeBufferPtr = std::unique_ptr<void, LargeBufferDeleter>;
+
+// Allocates a buffer of `size` bytes aligned for any scalar type, following
+// the policy set by SetHugePageBufferThreshold. The buffer is filled with
+// zeros if `zeroed` is true, and uninitialized otherwise (mapped buffers are
+// always zeroed). Never returns nullptr for size > 0.
+LargeBufferPtr AllocateLargeBuffer(size_t size, bool zeroed);
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_LARGE_BUFFER_H_
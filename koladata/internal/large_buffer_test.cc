@@ -0,0 +1,74 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/large_buffer.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#include "gtest/gtest.h"
+
+namespace koladata::internal {
+namespace {
+
+class ScopedHugePageBufferThreshold {
+ public:
+  explicit ScopedHugePageBufferThreshold(size_t threshold)
+      : previous_(SetHugePageBufferThreshold(threshold)) {}
+  ~ScopedHugePageBufferThreshold() { SetHugePageBufferThreshold(previous_); }
+
+ private:
+  size_t previous_;
+};
+
+bool IsZeroed(const void* ptr, size_t size) {
+  const char* bytes = static_cast<const char*>(ptr);
+  for (size_t i = 0; i < size; ++i) {
+    if (bytes[i] != 0) {
+      return false;
+    }
+  }
+  return true;
+}
+
+TEST(LargeBufferTest, Disabled) {
+  EXPECT_EQ(GetHugePageBufferThreshold(), 0);
+  LargeBufferPtr buffer = AllocateLargeBuffer(3 * kHugePageSize,
+                                              /*zeroed=*/true);
+  ASSERT_NE(buffer, nullptr);
+  EXPECT_FALSE(buffer.get_deleter().is_mapped());
+  EXPECT_TRUE(IsZeroed(buffer.get(), 3 * kHugePageSize));
+  EXPECT_NE(AllocateLargeBuffer(0, /*zeroed=*/false), nullptr);
+}
+
+TEST(LargeBufferTest, HugePages) {
+  ScopedHugePageBufferThreshold threshold(kHugePageSize);
+  EXPECT_EQ(GetHugePageBufferThreshold(), kHugePageSize);
+
+  LargeBufferPtr small = AllocateLargeBuffer(100, /*zeroed=*/true);
+  EXPECT_FALSE(small.get_deleter().is_mapped());
+  EXPECT_TRUE(IsZeroed(small.get(), 100));
+
+  const size_t size = kHugePageSize + 17;
+  LargeBufferPtr large = AllocateLargeBuffer(size, /*zeroed=*/false);
+  ASSERT_NE(large, nullptr);
+  EXPECT_TRUE(large.get_deleter().is_mapped());
+  EXPECT_EQ(reinterpret_cast<uintptr_t>(large.get()) % kHugePageSize, 0);
+  EXPECT_TRUE(IsZeroed(large.get(), size));
+  std::memset(large.get(), 1, size);
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_MEMORY_USAGE_H_
+#define KOLADATA_INTERNAL_MEMORY_USAGE_H_
+
+#include <cstdint>
+#include <type_traits>
+
+#include "koladata/internal/data_item.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/strings_buffer.h"
+#include "arolla/util/bytes.h"
+#include "arolla/util/text.h"
+#include "arolla/util/unit.h"
+
+namespace koladata::internal {
+
+// Estimated number of bytes used by a data structure. `owned` bytes belong to
+// the structure itself, `shared` bytes are referenced from other structures
+// (e.g. from a parent DataBag) and freeing the structure would not release
+// them.
+//
+// All the numbers are estimates: buffers shared between several arrays are
+// counted for each of them, and allocator overhead is ignored.
+struct MemoryUsage {
+  int64_t owned = 0;
+  int64_t shared = 0;
+
+  int64_t total() const { return owned + shared; }
+
+  MemoryUsage& operator+=(const MemoryUsage& other) {
+    owned += other.owned;
+    shared += other.shared;
+    return *this;
+  }
+
+  friend bool operator==(const MemoryUsage& a, const MemoryUsage& b) {
+    return a.owned == b.owned && a.shared == b.shared;
+  }
+};
+
+// Returns the number of bytes of the buffers referenced by `array`.
+template <class T>
+int64_t EstimateDenseArrayBytes(const arolla::DenseArray<T>& array) {
+  int64_t bytes = array.bitmap.size() * sizeof(arolla::bitmap::Word);
+  if constexpr (std::is_same_v<T, arolla::Text> ||
+                std::is_same_v<T, arolla::Bytes>) {
+    // The characters buffer can be shared by many slices, so only the
+    // characters of the referenced strings are counted.
+    bytes += array.values.size() * sizeof(arolla::StringsBuffer::Offsets);
+    for (int64_t i = 0; i < array.values.size(); ++i) {
+      bytes += array.values[i].size();
+    }
+  } else if constexpr (!std::is_same_v<T, arolla::Unit>) {
+    bytes += array.values.size() * sizeof(T);
+  }
+  return bytes;
+}
+
+// Returns the number of bytes allocated on the heap by `item`, i.e. the
+// characters of Text and Bytes values. sizeof(DataItem) is not included.
+inline int64_t EstimateDataItemHeapBytes(const DataItem& item) {
+  if (item.holds_value<arolla::Text>()) {
+    return item.value<arolla::Text>().view().size();
+  }
+  if (item.holds_value<arolla::Bytes>()) {
+    return item.value<arolla::Bytes>().size();
+  }
+  return 0;
+}
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_MEMORY_USAGE_H_
@@ -23,6 +23,7 @@
 #include <ostream>
 #include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/base/optimization.h"
 #include "absl/log/check.h"
@@ -30,6 +31,7 @@
 #include "absl/random/random.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_join.h"
+#include "absl/types/span.h"
 #include "arolla/qtype/simple_qtype.h"
 
 namespace koladata::internal {
@@ -141,45 +143,89 @@ AllocationId Allocate(size_t size) {
   return AllocationId(id);
 }
 
-ObjectId AllocateSingleObject() {
-  ObjectId id;
-  // Fill metadata_ and offset_bits_ as 0s.
-  std::memset(&id, 0, sizeof(uint64_t));
+namespace {
 
-  // We allocate 2**kIdBitCount ids consequently.
-  // After that we grab the next thread_id using atomic operation.
-  constexpr uint64_t kIdBitCount = 24;
+// We allocate 2**kIdBitCount single object ids consequently in each thread.
+// After that we grab the next thread_id using atomic operation.
+constexpr uint64_t kIdBitCount = 24;
 
+std::pair<uint64_t, uint64_t> NextSingleObjectThreadId() {
   static std::atomic_uint64_t global_thread_id_ = 0;
-  constexpr auto compute_thead_id_fn = []() {
-    uint64_t id = global_thread_id_.fetch_add(1, std::memory_order_relaxed);
-
-    return std::make_pair(
-        // kIdBitCount highest bits are added to allocator_id_
-        // as lowest bits.
-        id >> (64 - kIdBitCount),
-        // (64-kIdBitCount) lowest bits are added to id_ as highest bits.
-        id << kIdBitCount);
-  };
+  uint64_t id = global_thread_id_.fetch_add(1, std::memory_order_relaxed);
+  return std::make_pair(
+      // kIdBitCount highest bits are added to allocator_id_
+      // as lowest bits.
+      id >> (64 - kIdBitCount),
+      // (64-kIdBitCount) lowest bits are added to id_ as highest bits.
+      id << kIdBitCount);
+}
+
+// Thread local state of single object allocation.
+struct SingleObjectThreadState {
+  std::pair<uint64_t, uint64_t> thread_id = NextSingleObjectThreadId();
+  uint64_t allocation_id = 0;
+};
 
-  thread_local std::pair<uint64_t, uint64_t> thread_id_ = compute_thead_id_fn();
-  thread_local uint64_t allocation_id_ = 0;
+SingleObjectThreadState& GetSingleObjectThreadState() {
+  thread_local SingleObjectThreadState state;
+  return state;
+}
+
+}  // namespace
 
-  id.allocator_id_ = AllocatorId() + thread_id_.first;
+ObjectId AllocateSingleObject() {
+  ObjectId id;
+  // Fill metadata_ and offset_bits_ as 0s.
+  std::memset(&id, 0, sizeof(uint64_t));
+
+  SingleObjectThreadState& state = GetSingleObjectThreadState();
+  id.allocator_id_ = AllocatorId() + state.thread_id.first;
   // id_ has the following bit structure:
   // `|thread_id|allocation_id_in_this_thread|`
   // allocation_id_in_this_thread has `kIdBitCount` bits
   // thread_id fills the rest of the bits
-  id.id_ = allocation_id_ | thread_id_.second;
-  ++allocation_id_;
-  if (ABSL_PREDICT_FALSE(allocation_id_ == (1ull << kIdBitCount))) {
-    allocation_id_ = 0;
-    thread_id_ = compute_thead_id_fn();
+  id.id_ = state.allocation_id | state.thread_id.second;
+  ++state.allocation_id;
+  if (ABSL_PREDICT_FALSE(state.allocation_id == (1ull << kIdBitCount))) {
+    state.allocation_id = 0;
+    state.thread_id = NextSingleObjectThreadId();
   }
 
   return id;
 }
 
+void AllocateSingleObjects(absl::Span<ObjectId> ids) {
+  SingleObjectThreadState& state = GetSingleObjectThreadState();
+  const uint64_t allocator_id = AllocatorId();
+  size_t i = 0;
+  while (i < ids.size()) {
+    // Ids are taken from the current thread_id block in one go.
+    size_t block_size = std::min<uint64_t>(
+        ids.size() - i, (1ull << kIdBitCount) - state.allocation_id);
+    for (size_t j = 0; j < block_size; ++j) {
+      ObjectId& id = ids[i + j];
+      std::memset(&id, 0, sizeof(uint64_t));
+      id.allocator_id_ = allocator_id + state.thread_id.first;
+      id.id_ = (state.allocation_id + j) | state.thread_id.second;
+    }
+    i += block_size;
+    state.allocation_id += block_size;
+    if (state.allocation_id == (1ull << kIdBitCount)) {
+      state.allocation_id = 0;
+      state.thread_id = NextSingleObjectThreadId();
+    }
+  }
+}
+
+std::vector<AllocationId> AllocateMany(absl::Span<const size_t> sizes) {
+  std::vector<AllocationId> res;
+  res.reserve(sizes.size());
+  for (size_t size : sizes) {
+    res.push_back(Allocate(size));
+  }
+  return res;
+}
+
 void AllocationIdSet::Insert(const AllocationIdSet& new_ids) {
   contains_small_allocation_id_ |= new_ids.contains_small_allocation_id_;
   if (ids_.empty()) {
@@ -24,6 +24,7 @@
 #include <string>
 #include <tuple>
 #include <utility>
+#include <vector>
 
 #include "absl/base/optimization.h"
 #include "absl/container/inlined_vector.h"
@@ -211,6 +212,7 @@ class ObjectId {
   friend struct AllocationId;
   friend AllocationId Allocate(size_t size);
   friend ObjectId AllocateSingleObject();
+  friend void AllocateSingleObjects(absl::Span<ObjectId> ids);
   template <int64_t uuid_flag>
   friend ObjectId CreateUuidWithMainObject(ObjectId, arolla::Fingerprint);
   friend ObjectId CreateUuidObjectWithMetadata(arolla::Fingerprint, int64_t);
@@ -352,9 +354,18 @@ class AllocationId {
 // Returns newly allocated ObjectId.
 ObjectId AllocateSingleObject();
 
+// Fills `ids` with newly allocated ObjectIds. Equivalent to calling
+// AllocateSingleObject for each of them, but reserves the ids from the thread
+// local pool in one go.
+void AllocateSingleObjects(absl::Span<ObjectId> ids);
+
 // Returns new allocation id for the size objects.
 AllocationId Allocate(size_t size);
 
+// Returns new allocation ids for each of `sizes`. Equivalent to calling
+// Allocate for each of them.
+std::vector<AllocationId> AllocateMany(absl::Span<const size_t> sizes);
+
 // Returns ObjectId of a newly created empty list.
 inline ObjectId AllocateSingleList() {
   ObjectId res = AllocateSingleObject();
@@ -46,7 +46,7 @@ void BM_AllocateSingleObject(benchmark::State& state) {
   }
 }
 
-BENCHMARK(BM_AllocateSingleObject);
+BENCHMARK(BM_AllocateSingleObject)->ThreadRange(1, 32);
 
 void BM_Allocate2PowerNObjects(benchmark::State& state) {
   int64_t n = (1ull << state.range(0));
@@ -57,7 +57,12 @@ void BM_Allocate2PowerNObjects(benchmark::State& state) {
   }
 }
 
-BENCHMARK(BM_Allocate2PowerNObjects)->Arg(0)->Arg(1)->Arg(8)->Arg(40);
+BENCHMARK(BM_Allocate2PowerNObjects)
+    ->Arg(0)
+    ->Arg(1)
+    ->Arg(8)
+    ->Arg(40)
+    ->ThreadRange(1, 32);
 
 void BM_AccessDenseArrayByOffset(benchmark::State& state) {
   int batch_size = state.range(0);
@@ -32,6 +32,7 @@
 #include "absl/random/random.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/span.h"
 #include "koladata/internal/stable_fingerprint.h"
 #include "arolla/qtype/qtype_traits.h"
 #include "arolla/qtype/typed_value.h"
@@ -63,6 +64,38 @@ TEST(ObjectIdTest, AllocateSingleObjectStress) {
   }
 }
 
+TEST(ObjectIdTest, AllocateSingleObjects) {
+  ObjectId id = AllocateSingleObject();
+  std::vector<ObjectId> ids(1000);
+  for (int64_t i = 0; i != 100; ++i) {
+    AllocateSingleObjects(absl::MakeSpan(ids).subspan(0, i * 10));
+    for (int64_t j = 0; j != i * 10; ++j) {
+      ASSERT_TRUE(ids[j].IsSmallAlloc());
+      ASSERT_LT(id, ids[j]) << i << " " << j;
+      id = ids[j];
+    }
+    ObjectId new_id = AllocateSingleObject();
+    ASSERT_LT(id, new_id);
+    id = new_id;
+  }
+}
+
+TEST(ObjectIdTest, AllocateMany) {
+  std::vector<size_t> sizes = {0, 1, 5, 1024, 5, 1};
+  std::vector<AllocationId> allocs = AllocateMany(sizes);
+  ASSERT_EQ(allocs.size(), sizes.size());
+  std::set<AllocationId> unique_allocs(allocs.begin(), allocs.end());
+  EXPECT_EQ(unique_allocs.size(), allocs.size());
+  for (int64_t i = 0; i < sizes.size(); ++i) {
+    EXPECT_GE(allocs[i].Capacity(), sizes[i]) << i;
+    for (int64_t j = 0; j < allocs.size(); ++j) {
+      EXPECT_EQ(allocs[j].Contains(allocs[i].ObjectByOffset(0)), i == j)
+          << i << " " << j;
+    }
+  }
+  EXPECT_THAT(AllocateMany({}), IsEmpty());
+}
+
 TEST(ObjectIdTest, AllocationIdSmallSize) {
   size_t expected_capacity = 1;
   for (size_t size = 0; size <= 257; ++size) {
@@ -0,0 +1,211 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_APPROX_COUNT_DISTINCT_H_
+#define KOLADATA_INTERNAL_OP_UTILS_APPROX_COUNT_DISTINCT_H_
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+
+namespace koladata::internal {
+
+constexpr int kMinHyperLogLogPrecision = 4;
+constexpr int kMaxHyperLogLogPrecision = 18;
+// 2^14 registers, i.e. 16KiB per sketch and ~0.8% standard error.
+constexpr int kDefaultHyperLogLogPrecision = 14;
+
+// Inputs are not split into chunks smaller than this.
+constexpr int64_t kMinApproxCountDistinctChunkSize = 1 << 14;
+
+// HyperLogLog sketch (Flajolet et al.) of a set of 64 bit hashes with
+// 2^precision registers. The relative standard error of the estimate is about
+// 1.04 / sqrt(2^precision). Sketches with the same precision can be merged, so
+// the sketches of disjoint parts of the input (chunks, shards) give the same
+// estimate as a single sketch of the whole input.
+class HyperLogLog {
+ public:
+  explicit HyperLogLog(int precision)
+      : precision_(precision), registers_(size_t{1} << precision, 0) {
+    DCHECK_GE(precision, kMinHyperLogLogPrecision);
+    DCHECK_LE(precision, kMaxHyperLogLogPrecision);
+  }
+
+  int precision() const { return precision_; }
+
+  // Raw registers, e.g. for serialization.
+  absl::Span<const uint8_t> registers() const { return registers_; }
+
+  void Add(uint64_t hash) {
+    const uint64_t index = hash >> (64 - precision_);
+    const uint64_t rest = hash << precision_;
+    const uint8_t rank = static_cast<uint8_t>(
+        std::min(std::countl_zero(rest), 64 - precision_) + 1);
+    registers_[index] = std::max(registers_[index], rank);
+  }
+
+  // Merges `other` into this sketch. The precisions must be equal.
+  void Merge(const HyperLogLog& other) {
+    DCHECK_EQ(precision_, other.precision_);
+    for (size_t i = 0; i < registers_.size(); ++i) {
+      registers_[i] = std::max(registers_[i], other.registers_[i]);
+    }
+  }
+
+  void Clear() { std::fill(registers_.begin(), registers_.end(), 0); }
+
+  // Returns the estimated number of distinct hashes added to the sketch. Small
+  // cardinalities use linear counting over the empty registers.
+  double Estimate() const {
+    const double m = registers_.size();
+    double sum = 0;
+    int64_t zeros = 0;
+    for (uint8_t rank : registers_) {
+      sum += std::ldexp(1.0, -rank);
+      zeros += rank == 0;
+    }
+    const double alpha = m == 16   ? 0.673
+                         : m == 32 ? 0.697
+                         : m == 64 ? 0.709
+                                   : 0.7213 / (1 + 1.079 / m);
+    const double estimate = alpha * m * m / sum;
+    if (estimate <= 2.5 * m && zeros > 0) {
+      return m * std::log(m / zeros);
+    }
+    return estimate;
+  }
+
+ private:
+  int precision_;
+  std::vector<uint8_t> registers_;
+};
+
+// Returns the approximate number of distinct hashes in each group of the split
+// points `split_points`. `get_hash(row)` returns std::optional<uint64_t>,
+// std::nullopt for missing rows. Groups of at most 2^precision / 4 rows are
+// counted exactly (up to hash collisions), so that many small groups don't pay
+// for clearing and scanning a sketch each.
+//
+// Groups are processed concurrently using `executor`. Large groups are split
+// into chunks with a sketch each, which are merged afterwards; the result does
+// not depend on the number of chunks.
+template <typename GetHashFn>
+arolla::DenseArray<int64_t> SegmentedApproxCountDistinct(
+    absl::Span<const int64_t> split_points, int precision,
+    const GetHashFn& get_hash, Executor* executor) {
+  const int64_t group_count = split_points.size() - 1;
+  const int64_t size = split_points.back();
+  const int64_t max_exact_group_size = (int64_t{1} << precision) / 4;
+  arolla::Buffer<int64_t>::Builder result_bldr(group_count);
+  absl::Span<int64_t> result = result_bldr.GetMutableSpan();
+
+  auto add_rows = [&](int64_t begin, int64_t end, HyperLogLog& sketch) {
+    for (int64_t row = begin; row < end; ++row) {
+      if (std::optional<uint64_t> hash = get_hash(row); hash.has_value()) {
+        sketch.Add(*hash);
+      }
+    }
+  };
+  // Large groups are split into chunks later, other groups are processed
+  // whole by a single chunk.
+  auto is_large = [&](int64_t group) {
+    return ParallelChunkCount(executor,
+                              split_points[group + 1] - split_points[group],
+                              kMinApproxCountDistinctChunkSize) > 1;
+  };
+
+  const int64_t num_chunks =
+      ParallelChunkCount(executor, size, kMinApproxCountDistinctChunkSize);
+  const int64_t chunk_size = (size + num_chunks - 1) / num_chunks;
+  std::vector<int64_t> chunk_groups(num_chunks + 1, group_count);
+  chunk_groups[0] = 0;
+  for (int64_t chunk = 1; chunk < num_chunks; ++chunk) {
+    chunk_groups[chunk] =
+        std::lower_bound(split_points.begin(), split_points.end() - 1,
+                         chunk * chunk_size) -
+        split_points.begin();
+  }
+  // The chunks never fail.
+  ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+    std::optional<HyperLogLog> sketch;
+    std::vector<uint64_t> hashes;
+    for (int64_t group = chunk_groups[chunk]; group < chunk_groups[chunk + 1];
+         ++group) {
+      const int64_t begin = split_points[group];
+      const int64_t end = split_points[group + 1];
+      if (end - begin <= max_exact_group_size) {
+        hashes.clear();
+        for (int64_t row = begin; row < end; ++row) {
+          if (std::optional<uint64_t> hash = get_hash(row); hash.has_value()) {
+            hashes.push_back(*hash);
+          }
+        }
+        std::sort(hashes.begin(), hashes.end());
+        result[group] =
+            std::unique(hashes.begin(), hashes.end()) - hashes.begin();
+      } else if (!is_large(group)) {
+        if (sketch.has_value()) {
+          sketch->Clear();
+        } else {
+          sketch.emplace(precision);
+        }
+        add_rows(begin, end, *sketch);
+        result[group] = std::llround(sketch->Estimate());
+      }
+    }
+    return absl::OkStatus();
+  }).IgnoreError();
+
+  for (int64_t group = 0; group < group_count; ++group) {
+    if (split_points[group + 1] - split_points[group] <=
+            max_exact_group_size ||
+        !is_large(group)) {
+      continue;
+    }
+    const int64_t begin = split_points[group];
+    const int64_t group_size = split_points[group + 1] - begin;
+    const int64_t group_chunks = ParallelChunkCount(
+        executor, group_size, kMinApproxCountDistinctChunkSize);
+    const int64_t group_chunk_size =
+        (group_size + group_chunks - 1) / group_chunks;
+    std::vector<HyperLogLog> sketches(group_chunks, HyperLogLog(precision));
+    ParallelFor(executor, group_chunks, [&](int64_t chunk) -> absl::Status {
+      const int64_t chunk_begin = begin + chunk * group_chunk_size;
+      add_rows(chunk_begin,
+               std::min(begin + group_size, chunk_begin + group_chunk_size),
+               sketches[chunk]);
+      return absl::OkStatus();
+    }).IgnoreError();
+    for (int64_t chunk = 1; chunk < group_chunks; ++chunk) {
+      sketches[0].Merge(sketches[chunk]);
+    }
+    result[group] = std::llround(sketches[0].Estimate());
+  }
+  return arolla::DenseArray<int64_t>{std::move(result_bldr).Build()};
+}
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_APPROX_COUNT_DISTINCT_H_
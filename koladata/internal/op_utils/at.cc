@@ -26,13 +26,13 @@
 #include "absl/status/statusor.h"
 #include "absl/types/span.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/op_utils/gather.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/edge.h"
 #include "arolla/dense_array/ops/multi_edge_util.h"
 #include "arolla/memory/optional_value.h"
 #include "arolla/memory/raw_buffer_factory.h"
-#include "arolla/qexpr/eval_context.h"
-#include "arolla/qexpr/operators/dense_array/array_ops.h"
 #include "arolla/util/meta.h"
 #include "arolla/util/view_types.h"
 #include "arolla/util/status_macros_backport.h"
@@ -82,7 +82,8 @@ absl::StatusOr<arolla::DenseArray<T>> SelectWithOffsets(
 absl::StatusOr<DataSliceImpl> AtOp(
     const DataSliceImpl& ds, const arolla::DenseArray<int64_t>& indices,
     const arolla::DenseArrayEdge& ds_to_common,
-    const std::optional<arolla::DenseArrayEdge>& indices_to_common) {
+    const std::optional<arolla::DenseArrayEdge>& indices_to_common,
+    Executor* executor) {
   if (ds.is_empty_and_unknown()) {
     return DataSliceImpl::CreateEmptyAndUnknownType(indices.size());
   }
@@ -105,10 +106,7 @@ absl::StatusOr<DataSliceImpl> AtOp(
                                                    *indices_to_common));
       builder.AddArray(res);
     } else {
-      // NOTE: out-of-bound errors are reported to the EvaluationContext and
-      // ignored here.
-      arolla::EvaluationContext ctx;
-      builder.AddArray(arolla::DenseArrayAtOp()(&ctx, array, indices));
+      builder.AddArray(ParallelGather(array, indices, executor));
     }
     return absl::OkStatus();
   }));
@@ -23,6 +23,7 @@
 #include "absl/log/check.h"
 #include "absl/status/statusor.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/edge.h"
 
@@ -34,10 +35,14 @@ namespace koladata::internal {
 // supported. If ds_to_common is scalar, indices_to_common is not used and can
 // be std::nullopt. Otherwise, indices_to_common must be provided and have the
 // same parent size as ds_to_common.
+//
+// If `executor` is provided and ds_to_common is scalar, large `indices` are
+// split into ranges that are gathered concurrently.
 absl::StatusOr<DataSliceImpl> AtOp(
     const DataSliceImpl& ds, const arolla::DenseArray<int64_t>& indices,
     const arolla::DenseArrayEdge& ds_to_common,
-    const std::optional<arolla::DenseArrayEdge>& indices_to_common);
+    const std::optional<arolla::DenseArrayEdge>& indices_to_common,
+    Executor* executor = nullptr);
 }  // namespace koladata::internal
 
 #endif  // KOLADATA_INTERNAL_OP_UTILS_AT_H_
@@ -14,24 +14,30 @@
 //
 #include "koladata/internal/op_utils/deep_clone.h"
 
+#include <array>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
-#include <string_view>
+#include <string>
 #include <utility>
+#include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/op_utils/traverser.h"
 #include "koladata/internal/schema_utils.h"
 #include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
 #include "arolla/util/text.h"
 #include "arolla/util/status_macros_backport.h"
 
@@ -47,10 +53,10 @@ class DeepCloneVisitor : AbstractVisitor {
   absl::Status Previsit(const DataItem& item, const DataItem& schema) override {
     if (schema.holds_value<ObjectId>()) {
       // Entity schema.
-      return PrevisitObject(item);
+      return PrevisitObject(item, schema);
     } else if (schema.holds_value<schema::DType>()) {
       if (schema == schema::kObject) {
-        return PrevisitObject(item);
+        return PrevisitObject(item, schema);
       } else if (schema == schema::kAny) {
         return absl::InternalError(absl::StrFormat(
             "deep_clone does not support %v schema; encountered for object %v",
@@ -68,6 +74,8 @@ class DeepCloneVisitor : AbstractVisitor {
     if (!item.holds_value<ObjectId>()) {
       return item;
     }
+    // All the items are previsited before the first GetValue call.
+    AllocateClones();
     auto item_it = object_tracker_.find(item);
     if (item_it == object_tracker_.end()) {
       return absl::InvalidArgumentError(
@@ -84,7 +92,9 @@ class DeepCloneVisitor : AbstractVisitor {
     if (is_object_schema) {
       RETURN_IF_ERROR(SetSchemaAttr(new_list, schema));
     }
-    RETURN_IF_ERROR(new_databag_->ExtendList(new_list, items));
+    new_lists_.push_back(std::move(new_list));
+    list_items_.insert(list_items_.end(), items.begin(), items.end());
+    list_split_points_.push_back(list_items_.size());
     return absl::OkStatus();
   }
 
@@ -97,8 +107,9 @@ class DeepCloneVisitor : AbstractVisitor {
     if (is_object_schema) {
       RETURN_IF_ERROR(SetSchemaAttr(new_dict, schema));
     }
-    RETURN_IF_ERROR(new_databag_->SetInDict(
-        DataSliceImpl::Create(keys.size(), new_dict), keys, values));
+    new_dicts_.insert(new_dicts_.end(), keys.size(), new_dict);
+    dict_keys_.insert(dict_keys_.end(), keys.begin(), keys.end());
+    dict_values_.insert(dict_values_.end(), values.begin(), values.end());
     return absl::OkStatus();
   }
 
@@ -115,14 +126,8 @@ class DeepCloneVisitor : AbstractVisitor {
     DCHECK(attr_names.IsAllPresent());
     for (size_t i = 0; i < attr_names.size(); ++i) {
       if (attr_values.present(i)) {
-        auto attr_name = attr_names[i].value;
-        const DataItem& value = attr_values[i].value;
-        if (schema == schema::kSchema) {
-          RETURN_IF_ERROR(
-              new_databag_->SetSchemaAttr(new_object, attr_name, value));
-        } else {
-          RETURN_IF_ERROR(new_databag_->SetAttr(new_object, attr_name, value));
-        }
+        AddAttr(new_object, attr_names[i].value, attr_values[i].value,
+                /*is_schema_attr=*/schema == schema::kSchema);
       }
     }
     return absl::OkStatus();
@@ -141,43 +146,177 @@ class DeepCloneVisitor : AbstractVisitor {
     return absl::OkStatus();
   }
 
- private:
-  absl::Status PrevisitObject(const DataItem& item) {
-    if (item.holds_value<ObjectId>() && !object_tracker_.contains(item)) {
-      DataItem new_item;
-      // TODO: Keep ids inside allocations and use mapping between
-      // old and new AllocationIds.
-      if (item.is_list()) {
-        new_item = DataItem(AllocateSingleList());
-      } else if (item.is_dict()) {
-        new_item = DataItem(AllocateSingleDict());
+  // Writes the attributes, list items and dict entries collected by the Visit*
+  // calls to the new DataBag. The attributes are set with one batch call per
+  // allocation and attribute; the batches are prepared concurrently using
+  // `executor`.
+  absl::Status Finish(Executor* executor) {
+    std::vector<std::pair<absl::string_view, AttrBatch*>> batches;
+    for (auto& [alloc, alloc_batches] : attr_batches_) {
+      for (auto& [attr_name, batch] : alloc_batches) {
+        batches.emplace_back(attr_name, &batch);
+      }
+    }
+    std::vector<std::pair<DataSliceImpl, DataSliceImpl>> slices(
+        batches.size());
+    RETURN_IF_ERROR(ParallelFor(executor, batches.size(), [&](int64_t i) {
+      AttrBatch& batch = *batches[i].second;
+      slices[i] = {DataSliceImpl::Create(batch.objects),
+                   DataSliceImpl::Create(batch.values)};
+      std::vector<DataItem>().swap(batch.objects);
+      std::vector<DataItem>().swap(batch.values);
+      return absl::OkStatus();
+    }));
+    for (size_t i = 0; i < batches.size(); ++i) {
+      const auto& [objects, values] = slices[i];
+      if (batches[i].second->is_schema_attr) {
+        RETURN_IF_ERROR(
+            new_databag_->SetSchemaAttr(objects, batches[i].first, values));
       } else {
-        new_item = DataItem(AllocateSingleObject());
+        RETURN_IF_ERROR(
+            new_databag_->SetAttr(objects, batches[i].first, values));
       }
-      object_tracker_[item] = std::move(new_item);
     }
+    attr_batches_.clear();
+    if (!new_lists_.empty()) {
+      ASSIGN_OR_RETURN(
+          auto edge, arolla::DenseArrayEdge::FromSplitPoints(
+                         arolla::CreateFullDenseArray(list_split_points_)));
+      RETURN_IF_ERROR(new_databag_->ExtendLists(
+          DataSliceImpl::Create(new_lists_),
+          DataSliceImpl::Create(list_items_), edge));
+    }
+    if (!new_dicts_.empty()) {
+      RETURN_IF_ERROR(new_databag_->SetInDict(
+          DataSliceImpl::Create(new_dicts_), DataSliceImpl::Create(dict_keys_),
+          DataSliceImpl::Create(dict_values_), {.executor = executor}));
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  enum class CloneKind { kObject, kList, kDict, kSchema };
+
+  // Previsited items that are cloned into one allocation.
+  struct CloneGroup {
+    CloneKind kind;
+    std::vector<DataItem> items;
+  };
+
+  // Values of one attribute of the clones in one allocation.
+  struct AttrBatch {
+    bool is_schema_attr = false;
+    std::vector<DataItem> objects;
+    std::vector<DataItem> values;
+  };
+
+  absl::Status PrevisitObject(const DataItem& item, const DataItem& schema) {
+    if (!item.holds_value<ObjectId>()) {
+      return absl::OkStatus();
+    }
+    CloneKind kind = item.is_list()   ? CloneKind::kList
+                     : item.is_dict() ? CloneKind::kDict
+                                      : CloneKind::kObject;
+    AddToCloneGroup(item, schema, kind);
     return absl::OkStatus();
   }
 
   absl::Status PrevisitSchema(const DataItem& schema) {
-    if (schema.holds_value<ObjectId>() && !object_tracker_.contains(schema)) {
-      auto new_schema = DataItem(AllocateExplicitSchema());
-      object_tracker_[schema] = std::move(new_schema);
+    if (schema.holds_value<ObjectId>()) {
+      AddToCloneGroup(schema, DataItem(schema::kSchema), CloneKind::kSchema);
     }
     return absl::OkStatus();
   }
 
+  // Items with the same schema and kind are cloned into one allocation, so
+  // that their attributes are stored (and later read) together.
+  void AddToCloneGroup(const DataItem& item, const DataItem& schema,
+                       CloneKind kind) {
+    DCHECK(!clones_allocated_);
+    if (!object_tracker_.try_emplace(item).second) {
+      return;
+    }
+    auto& group_index = clone_group_index_[static_cast<int>(kind)];
+    auto [it, inserted] = group_index.try_emplace(schema, clone_groups_.size());
+    if (inserted) {
+      clone_groups_.push_back({.kind = kind, .items = {}});
+    }
+    clone_groups_[it->second].items.push_back(item);
+  }
+
+  void AllocateClones() {
+    if (clones_allocated_) {
+      return;
+    }
+    clones_allocated_ = true;
+    for (CloneGroup& group : clone_groups_) {
+      size_t size = group.items.size();
+      AllocationId alloc;
+      switch (group.kind) {
+        case CloneKind::kObject:
+          alloc = Allocate(size);
+          break;
+        case CloneKind::kList:
+          alloc = AllocateLists(size);
+          break;
+        case CloneKind::kDict:
+          alloc = AllocateDicts(size);
+          break;
+        case CloneKind::kSchema:
+          alloc = AllocateExplicitSchemas(size);
+          break;
+      }
+      for (size_t i = 0; i < size; ++i) {
+        object_tracker_[group.items[i]] = DataItem(alloc.ObjectByOffset(i));
+      }
+    }
+    clone_groups_.clear();
+    clone_groups_.shrink_to_fit();
+    for (auto& group_index : clone_group_index_) {
+      group_index.clear();
+    }
+  }
+
+  void AddAttr(const DataItem& object, absl::string_view attr_name,
+               const DataItem& value, bool is_schema_attr) {
+    AllocationId alloc(object.value<ObjectId>());
+    auto& alloc_batches = attr_batches_[alloc];
+    auto it = alloc_batches.find(attr_name);
+    if (it == alloc_batches.end()) {
+      it = alloc_batches
+               .emplace(std::string(attr_name),
+                        AttrBatch{.is_schema_attr = is_schema_attr})
+               .first;
+    }
+    it->second.objects.push_back(object);
+    it->second.values.push_back(value);
+  }
+
   absl::Status SetSchemaAttr(const DataItem& item, const DataItem& schema) {
     ASSIGN_OR_RETURN(auto explicit_schema_value,
                      GetValue(schema, DataItem(schema::kSchema)));
-    RETURN_IF_ERROR(new_databag_->SetAttr(item, schema::kSchemaAttr,
-                                          std::move(explicit_schema_value)));
+    AddAttr(item, schema::kSchemaAttr, explicit_schema_value,
+            /*is_schema_attr=*/false);
     return absl::OkStatus();
   }
 
  private:
   DataBagImplPtr new_databag_;
   absl::flat_hash_map<DataItem, DataItem, DataItem::Hash> object_tracker_;
+  // Filled by Previsit and consumed by AllocateClones.
+  std::vector<CloneGroup> clone_groups_;
+  std::array<absl::flat_hash_map<DataItem, size_t, DataItem::Hash>, 4>
+      clone_group_index_;
+  bool clones_allocated_ = false;
+  // Filled by Visit* and written to `new_databag_` by Finish.
+  absl::flat_hash_map<AllocationId, absl::flat_hash_map<std::string, AttrBatch>>
+      attr_batches_;
+  std::vector<DataItem> new_lists_;
+  std::vector<DataItem> list_items_;
+  std::vector<int64_t> list_split_points_ = {0};
+  std::vector<DataItem> new_dicts_;
+  std::vector<DataItem> dict_keys_;
+  std::vector<DataItem> dict_values_;
 };
 
 };  // namespace
@@ -187,8 +326,10 @@ absl::StatusOr<std::pair<DataSliceImpl, DataItem>> DeepCloneOp::operator()(
     DataBagImpl::FallbackSpan fallbacks) const {
   auto visitor =
       std::make_shared<DeepCloneVisitor>(DataBagImplPtr::NewRef(new_databag_));
-  auto traverse_op = Traverser<DeepCloneVisitor>(databag, fallbacks, visitor);
+  auto traverse_op = Traverser<DeepCloneVisitor>(databag, fallbacks, visitor,
+                                                 executor_);
   RETURN_IF_ERROR(traverse_op.TraverseSlice(ds, schema));
+  RETURN_IF_ERROR(visitor->Finish(executor_));
   ASSIGN_OR_RETURN(auto result_schema, visitor->DeepCloneVisitor::GetValue(
                                            schema, DataItem(schema::kSchema)));
   DataSliceImpl::Builder result_items(ds.size());
@@ -20,6 +20,7 @@
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
 
 namespace koladata::internal {
 
@@ -32,9 +33,17 @@ namespace koladata::internal {
 // exactly one clone made per input object.
 //
 // Returns a pair of (new DataSlice, new schema).
+//
+// The clones of the objects with the same schema (and of the lists, dicts and
+// schemas) are allocated together, and their attributes are written with one
+// batch call per allocation and attribute.
+//
+// If `executor` is provided, the reachable objects are discovered and the
+// batches are prepared concurrently using it.
 class DeepCloneOp {
  public:
-  explicit DeepCloneOp(DataBagImpl* new_databag) : new_databag_(new_databag) {}
+  explicit DeepCloneOp(DataBagImpl* new_databag, Executor* executor = nullptr)
+      : new_databag_(new_databag), executor_(executor) {}
 
   absl::StatusOr<std::pair<DataSliceImpl, DataItem>> operator()(
       const DataSliceImpl& ds, const DataItem& schema,
@@ -47,6 +56,7 @@ class DeepCloneOp {
 
  private:
   DataBagImpl* new_databag_;
+  Executor* executor_;
 };
 
 }  // namespace koladata::internal
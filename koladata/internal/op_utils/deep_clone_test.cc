@@ -23,11 +23,13 @@
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/log/check.h"
+#include "absl/status/status_matchers.h"
 #include "absl/types/span.h"
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/schema_utils.h"
 #include "koladata/internal/testing/matchers.h"
@@ -40,7 +42,9 @@ namespace koladata::internal {
 namespace {
 
 using ::arolla::CreateDenseArray;
+using ::absl_testing::IsOkAndHolds;
 using ::koladata::internal::testing::DataBagEqual;
+using ::koladata::internal::testing::IsEquivalentTo;
 
 using TriplesT = std::vector<
     std::pair<DataItem, std::vector<std::pair<std::string_view, DataItem>>>>;
@@ -226,6 +230,97 @@ TEST_P(DeepCloneTest, DeepEntitySlice) {
   EXPECT_THAT(result_db, DataBagEqual(expected_db));
 }
 
+TEST_P(DeepCloneTest, DeepEntitySliceWithExecutor) {
+  constexpr int64_t kSize = 100;
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto ds = DataSliceImpl::AllocateEmptyObjects(kSize);
+  auto xs = DataSliceImpl::AllocateEmptyObjects(kSize);
+  auto ys = DataSliceImpl::AllocateEmptyObjects(kSize);
+  auto schema_a = AllocateSchema();
+  auto schema_x = AllocateSchema();
+  auto schema_y = AllocateSchema();
+  SetSchemaTriples(*db, {{schema_a, {{"x", schema_x}, {"y", schema_y}}},
+                         {schema_x, {{"v", DataItem(schema::kInt64)}}},
+                         {schema_y, {{"v", DataItem(schema::kInt64)},
+                                     {"x", schema_x}}}});
+  arolla::DenseArrayBuilder<int64_t> values_bldr(kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    values_bldr.Set(i, i);
+  }
+  auto values = DataSliceImpl::Create(std::move(values_bldr).Build());
+  ASSERT_OK(db->SetAttr(ds, "x", xs));
+  ASSERT_OK(db->SetAttr(ds, "y", ys));
+  ASSERT_OK(db->SetAttr(xs, "v", values));
+  ASSERT_OK(db->SetAttr(ys, "v", values));
+  ASSERT_OK(db->SetAttr(ys, "x", xs));
+
+  ThreadPoolExecutor executor(4);
+  auto result_db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK_AND_ASSIGN(
+      (auto [result_slice, result_schema]),
+      DeepCloneOp(result_db.get(), &executor)(ds, schema_a, *GetMainDb(db),
+                                              {GetFallbackDb(db).get()}));
+
+  EXPECT_NE(result_schema, schema_a);
+  ASSERT_OK_AND_ASSIGN(auto result_xs, result_db->GetAttr(result_slice, "x"));
+  ASSERT_OK_AND_ASSIGN(auto result_ys, result_db->GetAttr(result_slice, "y"));
+  ASSERT_OK_AND_ASSIGN(auto result_ys_xs, result_db->GetAttr(result_ys, "x"));
+  EXPECT_THAT(result_ys_xs, IsEquivalentTo(result_xs));
+  for (int64_t i = 0; i < kSize; ++i) {
+    EXPECT_NE(result_slice[i], ds[i]);
+    EXPECT_NE(result_xs[i], xs[i]);
+    EXPECT_NE(result_ys[i], ys[i]);
+  }
+  EXPECT_THAT(result_db->GetAttr(result_xs, "v"),
+              IsOkAndHolds(IsEquivalentTo(values)));
+  EXPECT_THAT(result_db->GetAttr(result_ys, "v"),
+              IsOkAndHolds(IsEquivalentTo(values)));
+}
+
+TEST_P(DeepCloneTest, ClonesWithSameSchemaShareAllocation) {
+  constexpr int64_t kSize = 10;
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  // Objects from different allocations.
+  std::vector<DataItem> items;
+  for (int64_t i = 0; i < kSize; ++i) {
+    items.push_back(DataItem(AllocateSingleObject()));
+  }
+  auto ds = DataSliceImpl::Create(items);
+  auto dicts =
+      DataSliceImpl::ObjectsFromAllocation(AllocateDicts(kSize), kSize);
+  auto schema_a = AllocateSchema();
+  auto dict_schema = AllocateSchema();
+  SetSchemaTriples(*db, {{schema_a, {{"d", dict_schema}}},
+                         {dict_schema,
+                          {{schema::kDictKeysSchemaAttr,
+                            DataItem(schema::kInt64)},
+                           {schema::kDictValuesSchemaAttr,
+                            DataItem(schema::kInt64)}}}});
+  ASSERT_OK(db->SetAttr(ds, "d", dicts));
+  auto keys = DataSliceImpl::Create(
+      arolla::CreateConstDenseArray<int64_t>(kSize, 1));
+  ASSERT_OK(db->SetInDict(dicts, keys, keys));
+
+  ThreadPoolExecutor executor(4);
+  auto result_db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK_AND_ASSIGN(
+      (auto [result_slice, result_schema]),
+      DeepCloneOp(result_db.get(), &executor)(ds, schema_a, *GetMainDb(db),
+                                              {GetFallbackDb(db).get()}));
+  ASSERT_OK_AND_ASSIGN(auto result_dicts,
+                       result_db->GetAttr(result_slice, "d"));
+  AllocationId alloc(result_slice[0].value<ObjectId>());
+  AllocationId dicts_alloc(result_dicts[0].value<ObjectId>());
+  EXPECT_TRUE(dicts_alloc.IsDictsAlloc());
+  for (int64_t i = 0; i < kSize; ++i) {
+    EXPECT_EQ(AllocationId(result_slice[i].value<ObjectId>()), alloc);
+    EXPECT_EQ(AllocationId(result_dicts[i].value<ObjectId>()), dicts_alloc);
+    EXPECT_NE(result_dicts[i], dicts[i]);
+  }
+  EXPECT_THAT(result_db->GetFromDict(result_dicts, keys),
+              IsOkAndHolds(IsEquivalentTo(keys)));
+}
+
 TEST_P(DeepCloneTest, ShallowListsSlice) {
   auto db = DataBagImpl::CreateEmptyDatabag();
   auto lists = DataSliceImpl::ObjectsFromAllocation(AllocateLists(3), 3);
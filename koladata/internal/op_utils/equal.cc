@@ -14,19 +14,72 @@
 //
 #include "koladata/internal/op_utils/equal.h"
 
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "arolla/dense_array/bitmap.h"
 #include "arolla/dense_array/dense_array.h"
-#include "arolla/dense_array/ops/dense_ops.h"
-#include "arolla/qexpr/eval_context.h"
-#include "arolla/qexpr/operators/dense_array/logic_ops.h"
+#include "arolla/memory/buffer.h"
 #include "arolla/util/unit.h"
 #include "arolla/util/view_types.h"
-#include "arolla/util/status_macros_backport.h"
 
 namespace koladata::internal {
+namespace {
+
+using ::arolla::bitmap::Word;
+
+// Sets the bits of `bitmap` for the rows where both `l_array` and `r_array`
+// are present and equal. The bits of the other rows are left unchanged.
+template <typename LhsT, typename RhsT>
+void OrEqualBits(const arolla::DenseArray<LhsT>& l_array,
+                 const arolla::DenseArray<RhsT>& r_array,
+                 absl::Span<Word> bitmap) {
+  constexpr int64_t kWordBitCount = arolla::bitmap::kWordBitCount;
+  const int64_t size = l_array.size();
+  for (int64_t word_id = 0; word_id < bitmap.size(); ++word_id) {
+    const Word presence =
+        arolla::bitmap::GetWordWithOffset(l_array.bitmap, word_id,
+                                          l_array.bitmap_bit_offset) &
+        arolla::bitmap::GetWordWithOffset(r_array.bitmap, word_id,
+                                          r_array.bitmap_bit_offset);
+    if (presence == 0) {
+      continue;
+    }
+    const int64_t begin = word_id * kWordBitCount;
+    const int64_t count = std::min(kWordBitCount, size - begin);
+    Word equal = 0;
+    if constexpr (std::is_same_v<LhsT, arolla::Unit>) {
+      equal = arolla::bitmap::kFullWord;
+    } else if constexpr (std::is_arithmetic_v<LhsT> &&
+                         std::is_arithmetic_v<RhsT>) {
+      // Compares the whole word without branching on presence, so that the
+      // loop is vectorized. Values of missing rows are masked out below.
+      const LhsT* l = l_array.values.span().data() + begin;
+      const RhsT* r = r_array.values.span().data() + begin;
+      for (int64_t i = 0; i < count; ++i) {
+        equal |= static_cast<Word>(l[i] == r[i]) << i;
+      }
+    } else {
+      for (int64_t i = 0; i < count; ++i) {
+        if ((presence >> i) & 1) {
+          equal |= static_cast<Word>(l_array.values[begin + i] ==
+                                     r_array.values[begin + i])
+                   << i;
+        }
+      }
+    }
+    bitmap[word_id] |= presence & equal;
+  }
+}
+
+}  // namespace
 
 DataItem EqualOp::operator()(const DataItem& lhs, const DataItem& rhs) const {
   if (!lhs.has_value() || !rhs.has_value()) {
@@ -50,36 +103,26 @@ absl::StatusOr<DataSliceImpl> EqualOp::operator()(
     return absl::InvalidArgumentError(
         "equal requires input slices to have the same size");
   }
-  auto result = arolla::CreateEmptyDenseArray<arolla::Unit>(lhs.size());
+  const int64_t size = lhs.size();
   if (rhs.is_empty_and_unknown() || lhs.is_empty_and_unknown()) {
-    return DataSliceImpl::Create(result);
+    return DataSliceImpl::Create(
+        arolla::CreateEmptyDenseArray<arolla::Unit>(size));
   }
-  arolla::EvaluationContext ctx;
-  RETURN_IF_ERROR(lhs.VisitValues(
-      [&]<typename LhsArrayT>(const LhsArrayT& l_array) -> absl::Status {
-        using LhsValT = typename LhsArrayT::base_type;
-        using LhsViewValT = arolla::view_type_t<LhsValT>;
-        return rhs.VisitValues([&]<typename RhsArrayT>(
-                                   const RhsArrayT& r_array) -> absl::Status {
-          using RhsValT = typename RhsArrayT::base_type;
-          using RhsViewValT = arolla::view_type_t<RhsValT>;
-          if constexpr (Comparable<LhsValT, RhsValT>()) {
-            auto op =
-                arolla::CreateDenseOp<arolla::DenseOpFlags::kNoSizeValidation |
-                                      arolla::DenseOpFlags::kRunOnMissing>(
-                    MaskEqualOp<LhsViewValT, RhsViewValT>());
-            auto sub_res = op(l_array, r_array);
-            if (result.PresentCount() == 0) {
-              result = std::move(sub_res);
-            } else {
-              ASSIGN_OR_RETURN(result, arolla::DenseArrayPresenceOrOp()(
-                                           &ctx, result, sub_res));
-            }
+  // The arrays of a DataSliceImpl have disjoint presence, so every pair of
+  // comparable arrays ORs its bits directly into the single output bitmap.
+  arolla::Buffer<Word>::Builder bitmap_bldr(arolla::bitmap::BitmapSize(size));
+  absl::Span<Word> bitmap = bitmap_bldr.GetMutableSpan();
+  std::fill(bitmap.begin(), bitmap.end(), Word{0});
+  lhs.VisitValues([&]<typename LhsT>(const arolla::DenseArray<LhsT>& l_array) {
+    rhs.VisitValues(
+        [&]<typename RhsT>(const arolla::DenseArray<RhsT>& r_array) {
+          if constexpr (Comparable<LhsT, RhsT>()) {
+            OrEqualBits(l_array, r_array, bitmap);
           }
-          return absl::OkStatus();
         });
-      }));
-  return DataSliceImpl::Create(result);
+  });
+  return DataSliceImpl::Create(arolla::DenseArray<arolla::Unit>{
+      arolla::VoidBuffer(size), std::move(bitmap_bldr).Build()});
 }
 
 }  // namespace koladata::internal
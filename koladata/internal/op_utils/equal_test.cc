@@ -18,6 +18,7 @@
 #include <cstdint>
 #include <initializer_list>
 #include <optional>
+#include <utility>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -136,6 +137,29 @@ TEST(PresenceOrTest, DataSliceMixedPrimitiveValues) {
   }
 }
 
+TEST(EqualTest, DataSliceMultipleWords) {
+  constexpr int64_t kSize = 100;
+  arolla::DenseArrayBuilder<int> l_bldr(kSize + 3);
+  arolla::DenseArrayBuilder<int64_t> r_bldr(kSize + 3);
+  for (int64_t i = 0; i < kSize + 3; ++i) {
+    if (i % 7 != 0) {
+      l_bldr.Set(i, i);
+    }
+    r_bldr.Set(i, i % 3 == 0 ? i : -1);
+  }
+  // Slicing gives a non-zero bitmap bit offset.
+  auto lds = DataSliceImpl::Create(std::move(l_bldr).Build().Slice(3, kSize));
+  auto rds = DataSliceImpl::Create(std::move(r_bldr).Build().Slice(3, kSize));
+
+  ASSERT_OK_AND_ASSIGN(auto res, EqualOp()(lds, rds));
+  ASSERT_EQ(res.size(), kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    const int64_t id = i + 3;
+    EXPECT_EQ(res.values<Unit>()[i].present, id % 7 != 0 && id % 3 == 0)
+        << i;
+  }
+}
+
 TEST(EqualTest, DataSliceObjectId) {
   {
     auto obj_id = Allocate(kLargeAllocSize).ObjectByOffset(1909);
@@ -15,25 +15,107 @@
 #ifndef KOLADATA_INTERNAL_OP_UTILS_EXPAND_H_
 #define KOLADATA_INTERNAL_OP_UTILS_EXPAND_H_
 
+#include <algorithm>
+#include <cstdint>
+#include <optional>
 #include <type_traits>
 #include <utility>
 
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/missing_value.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/types.h"
+#include "arolla/dense_array/bitmap.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/edge.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/memory/strings_buffer.h"
 #include "arolla/qexpr/eval_context.h"
 #include "arolla/qexpr/operators/dense_array/edge_ops.h"
+#include "arolla/util/bytes.h"
+#include "arolla/util/text.h"
+#include "arolla/util/unit.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata::internal {
 
+namespace expand_impl {
+
+// Sets the bits [begin, end) of `bitmap`.
+inline void SetBitRange(absl::Span<arolla::bitmap::Word> bitmap, int64_t begin,
+                        int64_t end) {
+  constexpr int64_t kWordBitCount = arolla::bitmap::kWordBitCount;
+  for (; begin < end && begin % kWordBitCount != 0; ++begin) {
+    bitmap[begin / kWordBitCount] |= arolla::bitmap::Word{1}
+                                     << (begin % kWordBitCount);
+  }
+  for (; begin + kWordBitCount <= end; begin += kWordBitCount) {
+    bitmap[begin / kWordBitCount] = arolla::bitmap::kFullWord;
+  }
+  for (; begin < end; ++begin) {
+    bitmap[begin / kWordBitCount] |= arolla::bitmap::Word{1}
+                                     << (begin % kWordBitCount);
+  }
+}
+
+// Same as arolla::DenseArrayExpandOp over a split points edge, but fills the
+// result group by group. The presence is set word by word, trivially copyable
+// values with std::fill, and the expanded strings share the characters of
+// `array`, so that only their offsets are replicated. Returns std::nullopt for
+// the types that need the generic arolla implementation.
+template <typename T>
+std::optional<arolla::DenseArray<T>> ExpandOverSplitPoints(
+    const arolla::DenseArray<T>& array, const arolla::DenseArrayEdge& edge) {
+  constexpr bool kIsString = std::is_same_v<T, arolla::Text> ||
+                             std::is_same_v<T, arolla::Bytes>;
+  if constexpr (!kIsString && !std::is_trivially_copyable_v<T>) {
+    return std::nullopt;
+  } else {
+    DCHECK_EQ(edge.edge_type(), arolla::DenseArrayEdge::SPLIT_POINTS);
+    absl::Span<const int64_t> splits = edge.edge_values().values.span();
+    const int64_t child_size = edge.child_size();
+    arolla::DenseArray<T> res;
+    if (!array.IsFull()) {
+      arolla::Buffer<arolla::bitmap::Word>::Builder bitmap_bldr(
+          arolla::bitmap::BitmapSize(child_size));
+      absl::Span<arolla::bitmap::Word> bitmap = bitmap_bldr.GetMutableSpan();
+      std::fill(bitmap.begin(), bitmap.end(), 0);
+      array.ForEachPresent([&](int64_t i, const auto&) {
+        SetBitRange(bitmap, splits[i], splits[i + 1]);
+      });
+      res.bitmap = std::move(bitmap_bldr).Build();
+    }
+    if constexpr (std::is_same_v<T, arolla::Unit>) {
+      res.values = arolla::VoidBuffer(child_size);
+    } else if constexpr (kIsString) {
+      arolla::StringsBuffer::ReshuffleBuilder values_bldr(
+          child_size, array.values, std::nullopt);
+      array.ForEachPresent([&](int64_t i, const auto&) {
+        for (int64_t j = splits[i]; j < splits[i + 1]; ++j) {
+          values_bldr.CopyValue(j, i);
+        }
+      });
+      res.values = std::move(values_bldr).Build();
+    } else {
+      typename arolla::Buffer<T>::Builder values_bldr(child_size);
+      absl::Span<T> values = values_bldr.GetMutableSpan();
+      for (int64_t i = 0; i + 1 < splits.size(); ++i) {
+        std::fill(values.begin() + splits[i], values.begin() + splits[i + 1],
+                  array.present(i) ? array.values[i] : T());
+      }
+      res.values = std::move(values_bldr).Build();
+    }
+    return res;
+  }
+}
+
+}  // namespace expand_impl
+
 // Expands DataSliceImpl / DataItem over an Edge to a DataSliceImpl.
 struct ExpandOp {
   absl::StatusOr<DataSliceImpl> operator()(const DataSliceImpl& ds,
@@ -43,6 +125,13 @@ struct ExpandOp {
     DataSliceImpl::Builder bldr(edge.child_size());
     bldr.GetMutableAllocationIds().Insert(ds.allocation_ids());
     RETURN_IF_ERROR(ds.VisitValues([&](const auto& array) -> absl::Status {
+      if (edge.edge_type() == arolla::DenseArrayEdge::SPLIT_POINTS) {
+        if (auto expanded_array =
+                expand_impl::ExpandOverSplitPoints(array, edge)) {
+          bldr.AddArray(*std::move(expanded_array));
+          return absl::OkStatus();
+        }
+      }
       ASSIGN_OR_RETURN(auto expanded_array,
                        arolla::DenseArrayExpandOp()(&ctx, array, edge));
       bldr.AddArray(std::move(expanded_array));
@@ -187,6 +187,38 @@ TEST(ExpandTest, DataItemPrimitiveValue) {
               ElementsAre(Text("abc"), Text("abc"), Text("abc")));
 }
 
+TEST(ExpandTest, DataSliceMultipleWords) {
+  // Groups that start and end in the middle of bitmap words and span several
+  // words.
+  std::vector<int64_t> split_points = {0, 5, 5, 40, 41, 100, 170};
+  auto edge = *arolla::DenseArrayEdge::FromSplitPoints(
+      arolla::CreateFullDenseArray(split_points));
+  auto values = CreateDenseArray<Text>({Text("a"), Text("b"), std::nullopt,
+                                        Text("c"), std::nullopt, Text("d")});
+  ASSERT_OK_AND_ASSIGN(auto res, ExpandOp()(DataSliceImpl::Create(values),
+                                            edge));
+  ASSERT_EQ(res.size(), 170);
+  for (int64_t g = 0; g + 1 < split_points.size(); ++g) {
+    for (int64_t i = split_points[g]; i < split_points[g + 1]; ++i) {
+      EXPECT_EQ(res[i], values[g].present ? DataItem(Text(values[g].value))
+                                          : DataItem())
+          << i;
+    }
+  }
+  // The expanded strings share the characters with the input.
+  EXPECT_EQ(res.values<Text>().values.characters().begin(),
+            values.values.characters().begin());
+
+  auto ints = CreateDenseArray<int>({1, 2, std::nullopt, 3, 4, std::nullopt});
+  ASSERT_OK_AND_ASSIGN(res, ExpandOp()(DataSliceImpl::Create(ints), edge));
+  for (int64_t g = 0; g + 1 < split_points.size(); ++g) {
+    for (int64_t i = split_points[g]; i < split_points[g + 1]; ++i) {
+      EXPECT_EQ(res[i], ints[g].present ? DataItem(ints[g].value) : DataItem())
+          << i;
+    }
+  }
+}
+
 TEST(ExpandTest, DataItemObjectId) {
   {
     // Non-empty.
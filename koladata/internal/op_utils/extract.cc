@@ -20,12 +20,15 @@
 #include <string_view>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "koladata/internal/cancellation.h"
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
@@ -33,6 +36,7 @@
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/schema_utils.h"
 #include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
 #include "arolla/qexpr/eval_context.h"
 #include "arolla/qexpr/operators/dense_array/edge_ops.h"
 #include "arolla/qtype/qtype_traits.h"
@@ -70,14 +74,17 @@ class CopyingProcessor {
       const DataBagImpl& databag, DataBagImpl::FallbackSpan fallbacks,
       absl::Nullable<const DataBagImpl*> schema_databag,
       DataBagImpl::FallbackSpan schema_fallbacks,
-      const DataBagImplPtr& new_databag, bool is_shallow_clone = false)
+      const DataBagImplPtr& new_databag, bool is_shallow_clone = false,
+      DataBagImplPtr objects_tracker = nullptr)
       : queued_slices_(),
         databag_(databag),
         fallbacks_(std::move(fallbacks)),
         schema_databag_(schema_databag),
         schema_fallbacks_(std::move(schema_fallbacks)),
         new_databag_(new_databag),
-        objects_tracker_(DataBagImpl::CreateEmptyDatabag()),
+        objects_tracker_(objects_tracker != nullptr
+                             ? std::move(objects_tracker)
+                             : DataBagImpl::CreateEmptyDatabag()),
         is_shallow_clone_(is_shallow_clone) {}
 
   absl::Status ExtractSlice(QueuedSlice slice) {
@@ -85,6 +92,8 @@ class CopyingProcessor {
     return ProcessQueue();
   }
 
+  const DataBagImplPtr& objects_tracker() const { return objects_tracker_; }
+
   absl::Status SetMappingToInitialIds(const DataSliceImpl& new_ids,
                                       const DataSliceImpl& old_ids) {
     return objects_tracker_->SetAttr(FilterToObjects(new_ids), kMappingAttrName,
@@ -217,11 +226,41 @@ class CopyingProcessor {
     }
     ASSIGN_OR_RETURN(auto attr_ds,
                      databag_.GetAttr(old_ds, attr_name, fallbacks_));
-    RETURN_IF_ERROR(new_databag_->SetAttr(ds, attr_name, attr_ds));
+    ASSIGN_OR_RETURN(bool is_allocation_copied,
+                     TrySetAttrForEntireAllocation(ds, attr_name, attr_ds));
+    if (!is_allocation_copied) {
+      RETURN_IF_ERROR(new_databag_->SetAttr(ds, attr_name, attr_ds));
+    }
     RETURN_IF_ERROR(Visit({attr_ds, attr_schema, slice.schema_source}));
     return absl::OkStatus();
   }
 
+  // If `ds` is a prefix of a single big allocation, for which `new_databag_`
+  // has no values of `attr_name` yet, stores `attr_ds` as the attribute of the
+  // entire allocation. That shares the buffers instead of copying the values
+  // object by object. Returns false if the fast path is not applicable.
+  absl::StatusOr<bool> TrySetAttrForEntireAllocation(
+      const DataSliceImpl& ds, std::string_view attr_name,
+      const DataSliceImpl& attr_ds) {
+    if (!ds.is_allocation_prefix() || ds.allocation_ids().size() != 1) {
+      return false;
+    }
+    AllocationId alloc_id = *ds.allocation_ids().begin();
+    if (alloc_id.IsSmall()) {
+      return false;
+    }
+    DataBagImpl::ConstDenseSourceArray dense_sources;
+    DataBagImpl::ConstSparseSourceArray sparse_sources;
+    new_databag_->GetAttributeDataSources(alloc_id, attr_name, dense_sources,
+                                          sparse_sources);
+    if (!dense_sources.empty() || !sparse_sources.empty()) {
+      return false;
+    }
+    RETURN_IF_ERROR(
+        new_databag_->SetAttrForEntireAllocation(alloc_id, attr_name, attr_ds));
+    return true;
+  }
+
   absl::Status ProcessDictKeysAndValues(const QueuedSlice& slice,
                                         const DataItem& keys_schema,
                                         const DataItem& values_schema) {
@@ -477,6 +516,11 @@ class CopyingProcessor {
                      databag_.GetAttr(old_ds, schema::kSchemaAttr, fallbacks_));
     RETURN_IF_ERROR(
         new_databag_->SetAttr(ds.slice, schema::kSchemaAttr, slice_schemas));
+    // Objects with the same entity schema are processed together as a single
+    // slice.
+    absl::flat_hash_map<DataItem, size_t, DataItem::Hash> group_index;
+    std::vector<std::pair<DataItem, std::vector<ObjectId>>> entity_groups;
+    std::vector<DataItem> schema_items;
     for (size_t idx = 0; idx < ds.slice.size(); ++idx) {
       const DataItem& item = ds.slice[idx];
       const DataItem& schema = slice_schemas[idx];
@@ -485,25 +529,41 @@ class CopyingProcessor {
             "object %v is expected to have a schema in %s attribute, got %v",
             old_ds[idx], schema::kSchemaAttr, schema));
       }
-      auto item_slice =
-          QueuedSlice{.slice = DataSliceImpl::Create(1, item),
-                      .schema = schema,
-                      .schema_source = SchemaSource::kDataDatabag};
       if (schema.holds_value<ObjectId>()) {
-        // TODO: group items with the same schema into slices.
-        RETURN_IF_ERROR(ProcessEntitySlice(item_slice));
+        auto [it, inserted] =
+            group_index.try_emplace(schema, entity_groups.size());
+        if (inserted) {
+          entity_groups.emplace_back(schema, std::vector<ObjectId>());
+        }
+        entity_groups[it->second].second.push_back(item.value<ObjectId>());
       } else if (schema == schema::kSchema) {
-        RETURN_IF_ERROR(ProcessSchemaSlice(item_slice));
+        schema_items.push_back(item);
       } else {
         return absl::InternalError("unsupported schema type");
       }
     }
+    for (auto& [schema, objects] : entity_groups) {
+      auto group_slice = QueuedSlice{
+          .slice = DataSliceImpl::Create(arolla::DenseArray<ObjectId>{
+              arolla::Buffer<ObjectId>::Create(std::move(objects))}),
+          .schema = schema,
+          .schema_source = SchemaSource::kDataDatabag};
+      RETURN_IF_ERROR(ProcessEntitySlice(group_slice));
+    }
+    if (!schema_items.empty()) {
+      auto schemas_slice =
+          QueuedSlice{.slice = DataSliceImpl::Create(schema_items),
+                      .schema = DataItem(schema::kSchema),
+                      .schema_source = SchemaSource::kDataDatabag};
+      RETURN_IF_ERROR(ProcessSchemaSlice(schemas_slice));
+    }
     return absl::OkStatus();
   }
 
   absl::Status ProcessQueue() {
     // TODO: support implicit schemas.
     while (!queued_slices_.empty()) {
+      RETURN_IF_ERROR(CheckCancellation());
       QueuedSlice slice = std::move(queued_slices_.front());
       queued_slices_.pop();
       if (slice.schema.holds_value<ObjectId>()) {
@@ -632,6 +692,32 @@ absl::Status ExtractOp::operator()(
                  std::move(schema_fallbacks));
 }
 
+ExtractState::ExtractState()
+    : databag_(DataBagImpl::CreateEmptyDatabag()),
+      objects_tracker_(DataBagImpl::CreateEmptyDatabag()) {}
+
+absl::StatusOr<ExtractState> IncrementalExtractOp::operator()(
+    ExtractState state, const DataSliceImpl& ds, const DataItem& schema,
+    const DataBagImpl& databag, DataBagImpl::FallbackSpan fallbacks,
+    absl::Nullable<const DataBagImpl*> schema_databag,
+    DataBagImpl::FallbackSpan schema_fallbacks) const {
+  SchemaSource schema_source = schema_databag == nullptr
+                                   ? SchemaSource::kDataDatabag
+                                   : SchemaSource::kSchemaDatabag;
+  auto slice = QueuedSlice{
+      .slice = ds, .schema = schema, .schema_source = schema_source};
+  // The previous result is shared with the new one and stays unchanged.
+  DataBagImplPtr new_databag = state.databag_->PartiallyPersistentFork();
+  auto processor = CopyingProcessor(
+      databag, std::move(fallbacks), schema_databag,
+      std::move(schema_fallbacks), new_databag,
+      /*is_shallow_clone=*/false, std::move(state.objects_tracker_));
+  RETURN_IF_ERROR(processor.ExtractSlice(slice));
+  state.databag_ = std::move(new_databag);
+  state.objects_tracker_ = processor.objects_tracker();
+  return state;
+}
+
 absl::StatusOr<std::pair<DataSliceImpl, DataItem>> ShallowCloneOp::operator()(
     const DataSliceImpl& ds, const DataItem& schema, const DataBagImpl& databag,
     DataBagImpl::FallbackSpan fallbacks,
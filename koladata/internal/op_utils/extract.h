@@ -47,6 +47,45 @@ class ExtractOp {
   DataBagImpl* new_databag_;
 };
 
+// Result of an incremental extraction: the extracted DataBag together with the
+// index of already visited objects and schemas. Move-only, because extending
+// the state updates the index.
+class ExtractState {
+ public:
+  // Creates a state with nothing extracted.
+  ExtractState();
+
+  ExtractState(ExtractState&&) = default;
+  ExtractState& operator=(ExtractState&&) = default;
+
+  // Returns the DataBag with everything extracted so far. It must not be
+  // modified.
+  const DataBagImplPtr& databag() const { return databag_; }
+
+ private:
+  friend class IncrementalExtractOp;
+
+  DataBagImplPtr databag_;
+  DataBagImplPtr objects_tracker_;
+};
+
+// Extends a previous extraction with the objects reachable from `ds`, so that
+// the result is the same as extracting all the slices at once. Only the
+// objects that were not reached by the previous calls are traversed and
+// copied. The result DataBag is a PartiallyPersistentFork of the previous
+// one, so the previous DataBag is shared and stays valid and unchanged.
+//
+// `databag`, `fallbacks` and the schema DataBags must not change between the
+// calls that extend the same state.
+class IncrementalExtractOp {
+ public:
+  absl::StatusOr<ExtractState> operator()(
+      ExtractState state, const DataSliceImpl& ds, const DataItem& schema,
+      const DataBagImpl& databag, DataBagImpl::FallbackSpan fallbacks,
+      absl::Nullable<const DataBagImpl*> schema_databag,
+      DataBagImpl::FallbackSpan schema_fallbacks) const;
+};
+
 // Creates a slice with a shallow copy of the given slice and nothing else. The
 // objects themselves get new ItemIds and their top-level attributes are copied
 // by reference.
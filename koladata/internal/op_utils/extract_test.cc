@@ -26,6 +26,7 @@
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
 #include "absl/types/span.h"
+#include "koladata/internal/cancellation.h"
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
@@ -612,6 +613,111 @@ TEST_P(ExtractTest, DataSliceEntity) {
   EXPECT_THAT(result_db, DataBagEqual(*expected_db));
 }
 
+TEST_P(ExtractTest, Cancelled) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto obj_ids = DataSliceImpl::AllocateEmptyObjects(3);
+  auto int_dtype = DataItem(schema::kInt32);
+  auto schema = AllocateSchema();
+  SetSchemaTriples(*db, {{schema, {{"x", int_dtype}}}});
+  SetDataTriples(*db, {{obj_ids[0], {{"x", DataItem(1)}}}});
+
+  CancellationToken cancellation;
+  cancellation.Cancel();
+  ScopedCancellationToken cancellation_scope(&cancellation);
+  auto result_db = DataBagImpl::CreateEmptyDatabag();
+  EXPECT_THAT(ExtractOp(result_db.get())(obj_ids, schema, *GetMainDb(db),
+                                         {GetFallbackDb(db).get()}, nullptr,
+                                         {}),
+              StatusIs(absl::StatusCode::kCancelled));
+}
+
+TEST_P(ExtractTest, DataSliceEntireAllocation) {
+  constexpr int64_t kSize = 1000;
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto obj_ids = DataSliceImpl::AllocateEmptyObjects(kSize);
+  auto schema = AllocateSchema();
+  arolla::DenseArrayBuilder<int32_t> values_bldr(kSize);
+  for (int64_t i = 0; i < kSize; i += 2) {
+    values_bldr.Set(i, i);
+  }
+  auto values = DataSliceImpl::Create(std::move(values_bldr).Build());
+  ASSERT_OK(db->SetSchemaAttr(schema, "x", DataItem(schema::kInt32)));
+  ASSERT_OK(db->SetSchemaAttr(schema, "self", schema));
+  ASSERT_OK(db->SetAttr(obj_ids, "x", values));
+  ASSERT_OK(db->SetAttr(obj_ids, "self", obj_ids));
+
+  auto expected_db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(expected_db->SetSchemaAttr(schema, "x", DataItem(schema::kInt32)));
+  ASSERT_OK(expected_db->SetSchemaAttr(schema, "self", schema));
+  ASSERT_OK(expected_db->SetAttr(obj_ids, "x", values));
+  ASSERT_OK(expected_db->SetAttr(obj_ids, "self", obj_ids));
+
+  {
+    auto result_db = DataBagImpl::CreateEmptyDatabag();
+    ASSERT_OK(ExtractOp(result_db.get())(obj_ids, schema, *GetMainDb(db),
+                                         {GetFallbackDb(db).get()}, nullptr,
+                                         {}));
+    EXPECT_THAT(result_db, DataBagEqual(*expected_db));
+  }
+  {
+    // `result_db` already has values for a part of the allocation.
+    auto result_db = DataBagImpl::CreateEmptyDatabag();
+    ASSERT_OK(ExtractOp(result_db.get())(obj_ids[3], schema, *GetMainDb(db),
+                                         {GetFallbackDb(db).get()}, nullptr,
+                                         {}));
+    ASSERT_OK(ExtractOp(result_db.get())(obj_ids, schema, *GetMainDb(db),
+                                         {GetFallbackDb(db).get()}, nullptr,
+                                         {}));
+    EXPECT_THAT(result_db, DataBagEqual(*expected_db));
+  }
+}
+
+TEST_P(ExtractTest, Incremental) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto obj_ids = DataSliceImpl::AllocateEmptyObjects(4);
+  auto a0 = obj_ids[0];
+  auto a1 = obj_ids[1];
+  auto a2 = obj_ids[2];
+  auto a3 = obj_ids[3];
+  auto int_dtype = DataItem(schema::kInt32);
+  auto schema = AllocateSchema();
+
+  TriplesT schema_triples = {{schema, {{"x", int_dtype}, {"next", schema}}}};
+  TriplesT data_triples = {{a0, {{"x", DataItem(1)}, {"next", a1}}},
+                           {a1, {{"x", DataItem(2)}}},
+                           {a2, {{"x", DataItem(3)}, {"next", a1}}},
+                           {a3, {{"x", DataItem(4)}}}};
+  SetSchemaTriples(*db, schema_triples);
+  SetDataTriples(*db, data_triples);
+  SetSchemaTriples(*db, GenNoiseSchemaTriples());
+  SetDataTriples(*db, GenNoiseDataTriples());
+
+  ASSERT_OK_AND_ASSIGN(
+      ExtractState state,
+      IncrementalExtractOp()(ExtractState(), DataSliceImpl::Create(1, a0),
+                             schema, *GetMainDb(db), {GetFallbackDb(db).get()},
+                             nullptr, {}));
+  DataBagImplPtr first_result = state.databag();
+  auto expected_first_db = DataBagImpl::CreateEmptyDatabag();
+  SetSchemaTriples(*expected_first_db, schema_triples);
+  SetDataTriples(*expected_first_db, {data_triples[0], data_triples[1]});
+  EXPECT_THAT(first_result, DataBagEqual(*expected_first_db));
+
+  ASSERT_OK_AND_ASSIGN(
+      state,
+      IncrementalExtractOp()(
+          std::move(state),
+          DataSliceImpl::Create(CreateDenseArray<DataItem>({a2, a1})), schema,
+          *GetMainDb(db), {GetFallbackDb(db).get()}, nullptr, {}));
+  auto expected_db = DataBagImpl::CreateEmptyDatabag();
+  SetSchemaTriples(*expected_db, schema_triples);
+  SetDataTriples(*expected_db, {data_triples[0], data_triples[1],
+                                data_triples[2]});
+  EXPECT_THAT(state.databag(), DataBagEqual(*expected_db));
+  // The previous result is not changed.
+  EXPECT_THAT(first_result, DataBagEqual(*expected_first_db));
+}
+
 TEST_P(ExtractTest, DataSliceObjectIds) {
   auto db = DataBagImpl::CreateEmptyDatabag();
   auto obj_ids = DataSliceImpl::AllocateEmptyObjects(3);
@@ -0,0 +1,172 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_GATHER_H_
+#define KOLADATA_INTERNAL_OP_UTILS_GATHER_H_
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/qexpr/eval_context.h"
+#include "arolla/qexpr/operators/dense_array/array_ops.h"
+#include "arolla/util/unit.h"
+
+namespace koladata::internal {
+
+// Inputs are not split into chunks smaller than this.
+constexpr int64_t kMinGatherChunkSize = 1 << 16;
+
+namespace gather_impl {
+
+// Returns the size of each chunk when splitting `size` elements into
+// `num_chunks` chunks. Chunks are aligned to bitmap words, so that different
+// chunks never write to the same word.
+inline int64_t WordAlignedChunkSize(int64_t size, int64_t num_chunks) {
+  constexpr int64_t kWordBitCount = arolla::bitmap::kWordBitCount;
+  const int64_t chunk_size = (size + num_chunks - 1) / num_chunks;
+  return (chunk_size + kWordBitCount - 1) / kWordBitCount * kWordBitCount;
+}
+
+}  // namespace gather_impl
+
+// Returns the values of `values` at `indices`. Missing and out-of-range
+// indices (including negative ones) result in missing values. Same as
+// arolla's DenseArrayAtOp, but large inputs of trivially copyable types are
+// split into word-aligned ranges of `indices` that are gathered concurrently
+// using `executor`. The result does not depend on the number of chunks.
+template <typename T>
+arolla::DenseArray<T> ParallelGather(const arolla::DenseArray<T>& values,
+                                     const arolla::DenseArray<int64_t>& indices,
+                                     Executor* executor) {
+  using ::arolla::bitmap::Word;
+  constexpr int64_t kWordBitCount = arolla::bitmap::kWordBitCount;
+  const int64_t size = indices.size();
+  const int64_t num_chunks =
+      ParallelChunkCount(executor, size, kMinGatherChunkSize);
+  if constexpr (std::is_trivially_copyable_v<T> &&
+                !std::is_same_v<T, arolla::Unit>) {
+    if (num_chunks > 1) {
+      const int64_t chunk_size =
+          gather_impl::WordAlignedChunkSize(size, num_chunks);
+      absl::Span<const T> values_span = values.values.span();
+      absl::Span<const int64_t> indices_span = indices.values.span();
+      typename arolla::Buffer<T>::Builder values_bldr(size);
+      absl::Span<T> result_values = values_bldr.GetMutableSpan();
+      arolla::Buffer<Word>::Builder bitmap_bldr(
+          arolla::bitmap::BitmapSize(size));
+      absl::Span<Word> result_bitmap = bitmap_bldr.GetMutableSpan();
+      // The chunks never fail.
+      ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+        const int64_t begin = chunk * chunk_size;
+        const int64_t end = std::min(size, begin + chunk_size);
+        for (int64_t word_begin = begin; word_begin < end;
+             word_begin += kWordBitCount) {
+          const int64_t word_end = std::min(end, word_begin + kWordBitCount);
+          Word word = 0;
+          for (int64_t i = word_begin; i < word_end; ++i) {
+            const int64_t index = indices_span[i];
+            if (indices.present(i) && index >= 0 && index < values.size() &&
+                values.present(index)) {
+              result_values[i] = values_span[index];
+              word |= Word{1} << (i - word_begin);
+            }
+          }
+          result_bitmap[word_begin / kWordBitCount] = word;
+        }
+        return absl::OkStatus();
+      }).IgnoreError();
+      return arolla::DenseArray<T>{std::move(values_bldr).Build(),
+                                   std::move(bitmap_bldr).Build()};
+    }
+  }
+  // NOTE: out-of-bound errors are reported to the EvaluationContext and
+  // ignored here.
+  arolla::EvaluationContext ctx;
+  return arolla::DenseArrayAtOp()(&ctx, values, indices);
+}
+
+// Returns the indices of the present elements of `mask`. Large masks are split
+// into word-aligned ranges: the present elements of all ranges are counted
+// concurrently, a prefix sum over the counts gives the output offset of each
+// range and then the ranges are filled concurrently using `executor`.
+inline arolla::DenseArray<int64_t> ParallelPresentIndices(
+    const arolla::DenseArray<arolla::Unit>& mask, Executor* executor) {
+  using ::arolla::bitmap::Word;
+  constexpr int64_t kWordBitCount = arolla::bitmap::kWordBitCount;
+  const int64_t size = mask.size();
+  const int64_t num_chunks =
+      ParallelChunkCount(executor, size, kMinGatherChunkSize);
+  if (num_chunks <= 1) {
+    arolla::EvaluationContext ctx;
+    return arolla::DenseArrayPresentIndicesOp()(&ctx, mask);
+  }
+  const int64_t chunk_size =
+      gather_impl::WordAlignedChunkSize(size, num_chunks);
+  // Returns the presence word starting at `word_begin`, with the bits beyond
+  // `size` cleared.
+  auto get_word = [&](int64_t word_begin) {
+    Word word = arolla::bitmap::GetWordWithOffset(
+        mask.bitmap, word_begin / kWordBitCount, mask.bitmap_bit_offset);
+    if (const int64_t count = size - word_begin; count < kWordBitCount) {
+      word &= (Word{1} << count) - 1;
+    }
+    return word;
+  };
+  std::vector<int64_t> offsets(num_chunks + 1, 0);
+  ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+    const int64_t begin = chunk * chunk_size;
+    const int64_t end = std::min(size, begin + chunk_size);
+    int64_t count = 0;
+    for (int64_t word_begin = begin; word_begin < end;
+         word_begin += kWordBitCount) {
+      count += std::popcount(get_word(word_begin));
+    }
+    offsets[chunk + 1] = count;
+    return absl::OkStatus();
+  }).IgnoreError();
+  for (int64_t chunk = 0; chunk < num_chunks; ++chunk) {
+    offsets[chunk + 1] += offsets[chunk];
+  }
+  arolla::Buffer<int64_t>::Builder indices_bldr(offsets.back());
+  absl::Span<int64_t> indices = indices_bldr.GetMutableSpan();
+  ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+    const int64_t begin = chunk * chunk_size;
+    const int64_t end = std::min(size, begin + chunk_size);
+    int64_t offset = offsets[chunk];
+    for (int64_t word_begin = begin; word_begin < end;
+         word_begin += kWordBitCount) {
+      for (Word word = get_word(word_begin); word != 0; word &= word - 1) {
+        indices[offset++] = word_begin + std::countr_zero(word);
+      }
+    }
+    DCHECK_EQ(offset, offsets[chunk + 1]);
+    return absl::OkStatus();
+  }).IgnoreError();
+  return arolla::DenseArray<int64_t>{std::move(indices_bldr).Build()};
+}
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_GATHER_H_
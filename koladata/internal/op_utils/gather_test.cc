@@ -0,0 +1,99 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/gather.h"
+
+#include <cstdint>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/qexpr/eval_context.h"
+#include "arolla/qexpr/operators/dense_array/array_ops.h"
+#include "arolla/util/text.h"
+#include "arolla/util/unit.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::ElementsAreArray;
+
+constexpr int64_t kSize = 5 * kMinGatherChunkSize + 17;
+
+template <typename T>
+arolla::DenseArray<T> SequentialGather(
+    const arolla::DenseArray<T>& values,
+    const arolla::DenseArray<int64_t>& indices) {
+  arolla::EvaluationContext ctx;
+  return arolla::DenseArrayAtOp()(&ctx, values, indices);
+}
+
+TEST(GatherTest, ParallelGather) {
+  ThreadPoolExecutor executor(4);
+  arolla::DenseArrayBuilder<int> values_bldr(kSize);
+  arolla::DenseArrayBuilder<int64_t> indices_bldr(kSize + 3);
+  for (int64_t i = 0; i < kSize; ++i) {
+    if (i % 5 != 0) {
+      values_bldr.Set(i, i);
+    }
+  }
+  for (int64_t i = 0; i < kSize + 3; ++i) {
+    if (i % 7 != 0) {
+      // Includes negative and out-of-range indices.
+      indices_bldr.Set(i, (i * 7919) % (kSize + 20) - 10);
+    }
+  }
+  auto values = std::move(values_bldr).Build();
+  // Slicing gives a non-zero bitmap bit offset.
+  auto indices = std::move(indices_bldr).Build().Slice(3, kSize);
+
+  EXPECT_THAT(ParallelGather(values, indices, &executor),
+              ElementsAreArray(SequentialGather(values, indices)));
+  EXPECT_THAT(ParallelGather(values, indices, nullptr),
+              ElementsAreArray(SequentialGather(values, indices)));
+
+  // Non-trivially copyable types are gathered on the calling thread.
+  auto texts = arolla::CreateConstDenseArray<arolla::Text>(
+      kSize, arolla::Text("abc"));
+  EXPECT_THAT(ParallelGather(texts, indices, &executor),
+              ElementsAreArray(SequentialGather(texts, indices)));
+}
+
+TEST(GatherTest, ParallelPresentIndices) {
+  ThreadPoolExecutor executor(4);
+  arolla::DenseArrayBuilder<arolla::Unit> mask_bldr(kSize + 5);
+  for (int64_t i = 0; i < kSize + 5; ++i) {
+    if (i % 3 == 0 || (i > kSize / 2 && i < kSize / 2 + 1000)) {
+      mask_bldr.Set(i, arolla::kUnit);
+    }
+  }
+  auto mask = std::move(mask_bldr).Build().Slice(5, kSize);
+  arolla::EvaluationContext ctx;
+  auto expected = arolla::DenseArrayPresentIndicesOp()(&ctx, mask);
+
+  EXPECT_THAT(ParallelPresentIndices(mask, &executor),
+              ElementsAreArray(expected));
+  EXPECT_THAT(ParallelPresentIndices(
+                  arolla::CreateConstDenseArray<arolla::Unit>(kSize,
+                                                              arolla::kUnit),
+                  &executor),
+              ElementsAreArray(arolla::DenseArrayPresentIndicesOp()(
+                  &ctx, arolla::CreateConstDenseArray<arolla::Unit>(
+                            kSize, arolla::kUnit))));
+}
+
+}  // namespace
+}  // namespace koladata::internal
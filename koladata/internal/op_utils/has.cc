@@ -14,35 +14,43 @@
 //
 #include "koladata/internal/op_utils/has.h"
 
-#include <optional>
+#include <cstdint>
 #include <utility>
 
-#include "absl/log/check.h"
-#include "absl/status/status.h"
+#include "absl/types/span.h"
 #include "koladata/internal/data_slice.h"
+#include "arolla/dense_array/bitmap.h"
 #include "arolla/dense_array/dense_array.h"
-#include "arolla/qexpr/eval_context.h"
-#include "arolla/qexpr/operators/dense_array/logic_ops.h"
+#include "arolla/memory/buffer.h"
 #include "arolla/util/unit.h"
-#include "arolla/util/status_macros_backport.h"
 
-arolla::DenseArray<arolla::Unit> koladata::internal::PresenceDenseArray(
+namespace koladata::internal {
+
+arolla::DenseArray<arolla::Unit> PresenceDenseArray(const DataSliceImpl& ds) {
+  return ds.presence();
+}
+
+arolla::DenseArray<arolla::Unit> PresenceNotDenseArray(
     const DataSliceImpl& ds) {
-  if (ds.is_empty_and_unknown()) {
-    return arolla::CreateEmptyDenseArray<arolla::Unit>(ds.size());
+  using ::arolla::bitmap::Word;
+  const arolla::DenseArray<arolla::Unit> presence = ds.presence();
+  const int64_t size = presence.size();
+  if (presence.bitmap.empty()) {
+    return arolla::CreateEmptyDenseArray<arolla::Unit>(size);
   }
-
-  arolla::EvaluationContext ctx;
-  std::optional<arolla::DenseArray<arolla::Unit>> result = std::nullopt;
-  CHECK_OK(ds.VisitValues([&](const auto& array) -> absl::Status {
-    auto array_presence = arolla::DenseArrayHasOp()(array);
-    if (!result.has_value()) {
-      result = std::move(array_presence);
-    } else {
-      ASSIGN_OR_RETURN(result, arolla::DenseArrayPresenceOrOp()(
-                                   &ctx, array_presence, *result));
-    }
-    return absl::OkStatus();
-  }));
-  return *result;
+  const int64_t bitmap_size = arolla::bitmap::BitmapSize(size);
+  arolla::Buffer<Word>::Builder bitmap_bldr(bitmap_size);
+  absl::Span<Word> bitmap = bitmap_bldr.GetMutableSpan();
+  for (int64_t i = 0; i < bitmap_size; ++i) {
+    bitmap[i] = ~arolla::bitmap::GetWordWithOffset(presence.bitmap, i,
+                                                   presence.bitmap_bit_offset);
+  }
+  // Keeps the bits past the end cleared.
+  if (const int64_t tail = size % arolla::bitmap::kWordBitCount; tail != 0) {
+    bitmap.back() &= (Word{1} << tail) - 1;
+  }
+  return arolla::DenseArray<arolla::Unit>{arolla::VoidBuffer(size),
+                                          std::move(bitmap_bldr).Build()};
 }
+
+}  // namespace koladata::internal
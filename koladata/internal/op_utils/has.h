@@ -24,9 +24,15 @@
 
 namespace koladata::internal {
 
-// Returns the presence data as DenseArray.
+// Returns the presence data as DenseArray. Shares the bitmap of single-dtype
+// slices and is memoized for mixed ones (see DataSliceImpl::presence()).
 arolla::DenseArray<arolla::Unit> PresenceDenseArray(const DataSliceImpl& ds);
 
+// Returns the negated presence data as DenseArray, computed word by word from
+// the presence bitmap.
+arolla::DenseArray<arolla::Unit> PresenceNotDenseArray(
+    const DataSliceImpl& ds);
+
 // Returns the presence data. If all missing returns an empty DataSlice.
 struct HasOp {
   absl::StatusOr<DataSliceImpl> operator()(
@@ -42,6 +48,21 @@ struct HasOp {
   }
 };
 
+// Returns present for the missing items and missing for the present ones.
+struct HasNotOp {
+  absl::StatusOr<DataSliceImpl> operator()(
+      const DataSliceImpl& ds) const {
+    return DataSliceImpl::Create(PresenceNotDenseArray(ds));
+  }
+
+  absl::StatusOr<DataItem> operator()(const DataItem& item) const {
+    if (item.has_value()) {
+      return DataItem();
+    }
+    return DataItem(arolla::Unit());
+  }
+};
+
 }  // namespace koladata::internal
 
 #endif  // KOLADATA_INTERNAL_OP_UTILS_HAS_H_
@@ -14,8 +14,11 @@
 //
 #include "koladata/internal/op_utils/has.h"
 
+#include <cstdint>
 #include <initializer_list>
 #include <optional>
+#include <utility>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -96,6 +99,28 @@ TEST(HasTest, DataSliceMixedPrimitiveValues) {
               ElementsAre(kPresent, kMissing, kPresent, kPresent));
 }
 
+TEST(HasTest, DataSliceMixedPresenceIsMemoized) {
+  // More than a bitmap word.
+  DataSliceImpl::Builder bldr(70);
+  for (int64_t i = 0; i < 70; i += 3) {
+    bldr.Insert(i, DataItem(static_cast<int>(i)));
+  }
+  for (int64_t i = 1; i < 70; i += 3) {
+    bldr.Insert(i, DataItem(Text("a")));
+  }
+  auto ds = std::move(bldr).Build();
+  ASSERT_TRUE(ds.is_mixed_dtype());
+
+  auto presence = PresenceDenseArray(ds);
+  ASSERT_EQ(presence.size(), 70);
+  for (int64_t i = 0; i < 70; ++i) {
+    EXPECT_EQ(presence.present(i), i % 3 != 2) << i;
+  }
+  // The second call returns the memoized bitmap.
+  EXPECT_EQ(PresenceDenseArray(ds).bitmap.span().data(),
+            presence.bitmap.span().data());
+}
+
 TEST(HasTest, DataSliceObjectId) {
   {
     // ObjectId.
@@ -165,5 +190,46 @@ TEST(HasTest, DataItemObjectId) {
   }
 }
 
+TEST(HasNotTest, DataSlice) {
+  {
+    auto ds = DataSliceImpl::Create(CreateDenseArray<int>({1, std::nullopt}));
+    ASSERT_OK_AND_ASSIGN(auto res, HasNotOp()(ds));
+    EXPECT_THAT(res.values<Unit>(), ElementsAre(kMissing, kPresent));
+  }
+  {
+    // Full.
+    auto ds = DataSliceImpl::Create(CreateDenseArray<Unit>({Unit(), Unit()}));
+    ASSERT_OK_AND_ASSIGN(auto res, HasNotOp()(ds));
+    EXPECT_TRUE(res.is_empty_and_unknown());
+    EXPECT_EQ(res.size(), 2);
+  }
+  {
+    // Empty.
+    auto ds = DataSliceImpl::CreateEmptyAndUnknownType(3);
+    ASSERT_OK_AND_ASSIGN(auto res, HasNotOp()(ds));
+    EXPECT_THAT(res.values<Unit>(), ElementsAre(kPresent, kPresent, kPresent));
+  }
+  {
+    // A sliced bitmap spanning several words.
+    std::vector<arolla::OptionalValue<Unit>> units(150);
+    for (int64_t i = 0; i < 150; i += 7) {
+      units[i] = Unit();
+    }
+    auto mask = CreateDenseArray<Unit>(units).Slice(5, 140);
+    auto ds = DataSliceImpl::Create(mask);
+    ASSERT_OK_AND_ASSIGN(auto res, HasNotOp()(ds));
+    ASSERT_EQ(res.size(), 140);
+    const auto& res_values = res.values<Unit>();
+    for (int64_t i = 0; i < 140; ++i) {
+      EXPECT_EQ(res_values.present(i), (i + 5) % 7 != 0) << i;
+    }
+  }
+}
+
+TEST(HasNotTest, DataItem) {
+  EXPECT_EQ(*HasNotOp()(DataItem()), DataItem(Unit()));
+  EXPECT_EQ(*HasNotOp()(DataItem(1)), DataItem());
+}
+
 }  // namespace
 }  // namespace koladata::internal
@@ -0,0 +1,335 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/hash_join.h"
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/util/bytes.h"
+#include "arolla/util/text.h"
+#include "arolla/util/view_types.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::internal {
+namespace {
+
+// Multimap from the keys of a side of the join to the sorted positions holding
+// them. The rows are radix partitioned by the top bits of the key hashes and
+// every partition has its own table, so the tables are built concurrently.
+template <typename Key, typename Hash, typename Eq>
+class PartitionedMultiMap {
+ public:
+  // `get_key(i)` returns std::optional<Key>, std::nullopt for missing keys.
+  template <typename GetKey>
+  absl::Status Build(int64_t size, const GetKey& get_key,
+                     Executor* executor) {
+    const int64_t num_chunks =
+        ParallelChunkCount(executor, size, kMinHashJoinChunkSize);
+    // A few partitions per chunk even out the partitions of different sizes.
+    partition_bits_ =
+        num_chunks > 1 ? std::bit_width(static_cast<uint64_t>(num_chunks)) + 1
+                       : 0;
+    const int64_t num_partitions = int64_t{1} << partition_bits_;
+    const int64_t chunk_size = (size + num_chunks - 1) / num_chunks;
+    std::vector<uint32_t> row_partitions(size);
+    RETURN_IF_ERROR(
+        ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+          const int64_t end = std::min(size, (chunk + 1) * chunk_size);
+          for (int64_t i = chunk * chunk_size; i < end; ++i) {
+            std::optional<Key> key = get_key(i);
+            row_partitions[i] =
+                key.has_value() ? Partition(*key) : kNoPartition;
+          }
+          return absl::OkStatus();
+        }));
+    // Counting sort of the rows by partition keeps the rows sorted within
+    // each partition.
+    std::vector<int64_t> offsets(num_partitions + 1, 0);
+    for (uint32_t partition : row_partitions) {
+      if (partition != kNoPartition) {
+        ++offsets[partition + 1];
+      }
+    }
+    for (int64_t p = 0; p < num_partitions; ++p) {
+      offsets[p + 1] += offsets[p];
+    }
+    std::vector<int64_t> partition_rows(offsets.back());
+    {
+      std::vector<int64_t> next(offsets.begin(), offsets.end() - 1);
+      for (int64_t i = 0; i < size; ++i) {
+        if (row_partitions[i] != kNoPartition) {
+          partition_rows[next[row_partitions[i]]++] = i;
+        }
+      }
+    }
+    positions_.resize(offsets.back());
+    tables_.resize(num_partitions);
+    return ParallelFor(
+        executor, num_partitions, [&](int64_t p) -> absl::Status {
+          Table& table = tables_[p];
+          absl::Span<const int64_t> rows =
+              absl::MakeConstSpan(partition_rows)
+                  .subspan(offsets[p], offsets[p + 1] - offsets[p]);
+          // Counts the rows of every key, assigns consecutive ranges of
+          // `positions_` to the keys and fills them in the row order.
+          for (int64_t row : rows) {
+            ++table[*get_key(row)].second;
+          }
+          int64_t offset = offsets[p];
+          for (auto& [key, range] : table) {
+            const int64_t count = range.second;
+            range = {offset, offset};
+            offset += count;
+          }
+          for (int64_t row : rows) {
+            positions_[table.find(*get_key(row))->second.second++] = row;
+          }
+          return absl::OkStatus();
+        });
+  }
+
+  // Returns the sorted positions of `key`.
+  absl::Span<const int64_t> Find(const Key& key) const {
+    const Table& table = tables_[Partition(key)];
+    auto it = table.find(key);
+    if (it == table.end()) {
+      return {};
+    }
+    auto [begin, end] = it->second;
+    return absl::MakeConstSpan(positions_).subspan(begin, end - begin);
+  }
+
+ private:
+  static constexpr uint32_t kNoPartition = std::numeric_limits<uint32_t>::max();
+
+  using Table = absl::flat_hash_map<Key, std::pair<int64_t, int64_t>, Hash, Eq>;
+
+  uint32_t Partition(const Key& key) const {
+    if (partition_bits_ == 0) {
+      return 0;
+    }
+    // The tables use the low bits of the hash, so the partitions use the
+    // (mixed) high ones.
+    const uint64_t hash =
+        static_cast<uint64_t>(Hash()(key)) * 0x9E3779B97F4A7C15ull;
+    return static_cast<uint32_t>(hash >> (64 - partition_bits_));
+  }
+
+  int partition_bits_ = 0;
+  std::vector<int64_t> positions_;
+  std::vector<Table> tables_;
+};
+
+// Returns the positions `values` of a join result with the given split points,
+// where `is_present(group)` tells whether the group has matches. Groups
+// without matches have a single missing position.
+template <typename IsPresent>
+arolla::DenseArray<int64_t> WithMissingGroups(
+    arolla::Buffer<int64_t> values, absl::Span<const int64_t> split_points,
+    const IsPresent& is_present) {
+  using ::arolla::bitmap::Word;
+  const int64_t size = values.size();
+  arolla::Buffer<Word>::Builder bitmap_bldr(arolla::bitmap::BitmapSize(size));
+  absl::Span<Word> bitmap = bitmap_bldr.GetMutableSpan();
+  std::fill(bitmap.begin(), bitmap.end(), ~Word{0});
+  for (int64_t group = 0; group + 1 < split_points.size(); ++group) {
+    if (!is_present(group)) {
+      const int64_t i = split_points[group];
+      bitmap[arolla::bitmap::GetWordIndex(i)] &=
+          ~(Word{1} << arolla::bitmap::GetBitIndex(i));
+    }
+  }
+  return {std::move(values), std::move(bitmap_bldr).Build()};
+}
+
+template <typename Key, typename Hash, typename Eq, typename GetLeftKey,
+          typename GetRightKey>
+absl::StatusOr<HashJoinResult> HashJoinImpl(int64_t left_size,
+                                            const GetLeftKey& get_left_key,
+                                            int64_t right_size,
+                                            const GetRightKey& get_right_key,
+                                            JoinType join_type,
+                                            Executor* executor) {
+  const bool keep_unmatched = join_type == JoinType::kLeft;
+  arolla::Buffer<int64_t>::Builder split_points_bldr(left_size + 1);
+  absl::Span<int64_t> split_points = split_points_bldr.GetMutableSpan();
+  split_points[0] = 0;
+  std::vector<int64_t> match_counts(left_size, 0);
+  auto make_result = [&](arolla::Buffer<int64_t> values) {
+    arolla::Buffer<int64_t> split_points_buffer =
+        std::move(split_points_bldr).Build();
+    arolla::DenseArray<int64_t> right_positions =
+        keep_unmatched
+            ? WithMissingGroups(
+                  std::move(values), split_points_buffer.span(),
+                  [&](int64_t i) { return match_counts[i] > 0; })
+            : arolla::DenseArray<int64_t>{std::move(values)};
+    return HashJoinResult{.right_positions = std::move(right_positions),
+                          .split_points = std::move(split_points_buffer)};
+  };
+
+  if (right_size <= left_size) {
+    // Build on the right side, probe with the left one: the matches of every
+    // left item are already sorted.
+    PartitionedMultiMap<Key, Hash, Eq> index;
+    RETURN_IF_ERROR(index.Build(right_size, get_right_key, executor));
+    std::vector<absl::Span<const int64_t>> matches(left_size);
+    const int64_t num_chunks =
+        ParallelChunkCount(executor, left_size, kMinHashJoinChunkSize);
+    const int64_t chunk_size = (left_size + num_chunks - 1) / num_chunks;
+    RETURN_IF_ERROR(
+        ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+          const int64_t end = std::min(left_size, (chunk + 1) * chunk_size);
+          for (int64_t i = chunk * chunk_size; i < end; ++i) {
+            if (std::optional<Key> key = get_left_key(i); key.has_value()) {
+              matches[i] = index.Find(*key);
+            }
+          }
+          return absl::OkStatus();
+        }));
+    for (int64_t i = 0; i < left_size; ++i) {
+      match_counts[i] = matches[i].size();
+      split_points[i + 1] =
+          split_points[i] +
+          std::max<int64_t>(match_counts[i], keep_unmatched ? 1 : 0);
+    }
+    arolla::Buffer<int64_t>::Builder values_bldr(split_points[left_size]);
+    absl::Span<int64_t> result = values_bldr.GetMutableSpan();
+    RETURN_IF_ERROR(
+        ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+          const int64_t end = std::min(left_size, (chunk + 1) * chunk_size);
+          for (int64_t i = chunk * chunk_size; i < end; ++i) {
+            if (matches[i].empty() && keep_unmatched) {
+              result[split_points[i]] = 0;
+            }
+            std::copy(matches[i].begin(), matches[i].end(),
+                      result.begin() + split_points[i]);
+          }
+          return absl::OkStatus();
+        }));
+    return make_result(std::move(values_bldr).Build());
+  }
+
+  // Build on the (smaller) left side, probe with the right one. The matches
+  // are then regrouped by the left items with a counting sort over the right
+  // items in order, which keeps them sorted within the groups.
+  PartitionedMultiMap<Key, Hash, Eq> index;
+  RETURN_IF_ERROR(index.Build(left_size, get_left_key, executor));
+  std::vector<absl::Span<const int64_t>> matches(right_size);
+  const int64_t num_chunks =
+      ParallelChunkCount(executor, right_size, kMinHashJoinChunkSize);
+  const int64_t chunk_size = (right_size + num_chunks - 1) / num_chunks;
+  RETURN_IF_ERROR(
+      ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+        const int64_t end = std::min(right_size, (chunk + 1) * chunk_size);
+        for (int64_t j = chunk * chunk_size; j < end; ++j) {
+          if (std::optional<Key> key = get_right_key(j); key.has_value()) {
+            matches[j] = index.Find(*key);
+          }
+        }
+        return absl::OkStatus();
+      }));
+  for (const absl::Span<const int64_t>& left_rows : matches) {
+    for (int64_t i : left_rows) {
+      ++match_counts[i];
+    }
+  }
+  for (int64_t i = 0; i < left_size; ++i) {
+    split_points[i + 1] =
+        split_points[i] +
+        std::max<int64_t>(match_counts[i], keep_unmatched ? 1 : 0);
+  }
+  arolla::Buffer<int64_t>::Builder values_bldr(split_points[left_size]);
+  absl::Span<int64_t> result = values_bldr.GetMutableSpan();
+  std::fill(result.begin(), result.end(), 0);
+  std::vector<int64_t> next(split_points.begin(), split_points.end() - 1);
+  for (int64_t j = 0; j < right_size; ++j) {
+    for (int64_t i : matches[j]) {
+      result[next[i]++] = j;
+    }
+  }
+  return make_result(std::move(values_bldr).Build());
+}
+
+template <typename T>
+constexpr bool kIsTypedJoinKey =
+    std::is_same_v<T, int> || std::is_same_v<T, int64_t> ||
+    std::is_same_v<T, arolla::Text> || std::is_same_v<T, arolla::Bytes> ||
+    std::is_same_v<T, ObjectId>;
+
+}  // namespace
+
+absl::StatusOr<HashJoinResult> HashJoin(const DataSliceImpl& left,
+                                        const DataSliceImpl& right,
+                                        JoinType join_type,
+                                        Executor* executor) {
+  if (left.is_single_dtype() && right.is_single_dtype() &&
+      left.dtype() == right.dtype()) {
+    std::optional<absl::StatusOr<HashJoinResult>> result;
+    left.VisitValues([&]<typename T>(const arolla::DenseArray<T>& left_values) {
+      if constexpr (kIsTypedJoinKey<T>) {
+        using Key = arolla::view_type_t<T>;
+        const arolla::DenseArray<T>& right_values = right.values<T>();
+        auto key_getter = [](const arolla::DenseArray<T>& values) {
+          return [&values](int64_t i) -> std::optional<Key> {
+            if (!values.present(i)) {
+              return std::nullopt;
+            }
+            return values.values[i];
+          };
+        };
+        result = HashJoinImpl<Key, absl::Hash<Key>, std::equal_to<Key>>(
+            left.size(), key_getter(left_values), right.size(),
+            key_getter(right_values), join_type, executor);
+      }
+    });
+    if (result.has_value()) {
+      return *std::move(result);
+    }
+  }
+  auto key_getter = [](const DataSliceImpl& items) {
+    return [&items](int64_t i) -> std::optional<DataItem> {
+      DataItem item = items[i];
+      if (!item.has_value()) {
+        return std::nullopt;
+      }
+      return item;
+    };
+  };
+  return HashJoinImpl<DataItem, DataItem::Hash, DataItem::Eq>(
+      left.size(), key_getter(left), right.size(), key_getter(right),
+      join_type, executor);
+}
+
+}  // namespace koladata::internal
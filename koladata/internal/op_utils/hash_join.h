@@ -0,0 +1,66 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_HASH_JOIN_H_
+#define KOLADATA_INTERNAL_OP_UTILS_HASH_JOIN_H_
+
+#include <cstdint>
+
+#include "absl/status/statusor.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+
+namespace koladata::internal {
+
+// Inputs are not split into chunks smaller than this.
+constexpr int64_t kMinHashJoinChunkSize = 1 << 14;
+
+enum class JoinType {
+  // Items of `left` without matches are dropped.
+  kInner,
+  // Items of `left` without matches are joined with a missing position.
+  kLeft,
+};
+
+// Result of HashJoin.
+struct HashJoinResult {
+  // Positions in `right` of the items equal to each item of `left`, grouped by
+  // the items of `left` and sorted within the groups. For a left join, the
+  // items of `left` without matches get a single missing position.
+  arolla::DenseArray<int64_t> right_positions;
+  // Split points of the groups of `right_positions`, `left.size() + 1` values.
+  arolla::Buffer<int64_t> split_points;
+};
+
+// Joins the items of `left` and `right` by equality. Items are compared as
+// DataItems, so values of different types never match; missing items never
+// match.
+//
+// A hash multimap is built on the smaller side and probed with the other one.
+// If both sides have the same single dtype, the table is keyed by the values
+// directly instead of DataItems. The table is radix partitioned by the key
+// hashes, so that the partitions are built concurrently using `executor`, and
+// the probes are split into chunks that also run concurrently. The result does
+// not depend on the number of chunks. Fails only if the evaluation is
+// cancelled.
+absl::StatusOr<HashJoinResult> HashJoin(const DataSliceImpl& left,
+                                        const DataSliceImpl& right,
+                                        JoinType join_type,
+                                        Executor* executor);
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_HASH_JOIN_H_
@@ -0,0 +1,171 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/hash_join.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+std::vector<std::optional<int64_t>> Positions(const HashJoinResult& result) {
+  std::vector<std::optional<int64_t>> positions;
+  for (int64_t i = 0; i < result.right_positions.size(); ++i) {
+    if (result.right_positions.present(i)) {
+      positions.push_back(result.right_positions.values[i]);
+    } else {
+      positions.push_back(std::nullopt);
+    }
+  }
+  return positions;
+}
+
+TEST(HashJoinTest, InnerJoin) {
+  auto left = DataSliceImpl::Create(
+      arolla::CreateDenseArray<int64_t>({3, 1, std::nullopt, 2, 5}));
+  auto right = DataSliceImpl::Create(
+      arolla::CreateDenseArray<int64_t>({1, 2, 1, std::nullopt, 3, 1}));
+  ASSERT_OK_AND_ASSIGN(auto result,
+                       HashJoin(left, right, JoinType::kInner, nullptr));
+  EXPECT_THAT(Positions(result), ElementsAre(4, 0, 2, 5, 1));
+  EXPECT_THAT(result.split_points.span(), ElementsAre(0, 1, 4, 4, 5, 5));
+}
+
+TEST(HashJoinTest, LeftJoin) {
+  auto left = DataSliceImpl::Create(
+      arolla::CreateDenseArray<int64_t>({3, 1, std::nullopt, 2, 5}));
+  auto right = DataSliceImpl::Create(
+      arolla::CreateDenseArray<int64_t>({1, 2, 1, std::nullopt, 3, 1}));
+  ASSERT_OK_AND_ASSIGN(auto result,
+                       HashJoin(left, right, JoinType::kLeft, nullptr));
+  EXPECT_THAT(Positions(result),
+              ElementsAre(4, 0, 2, 5, std::nullopt, 1, std::nullopt));
+  EXPECT_THAT(result.split_points.span(), ElementsAre(0, 1, 4, 5, 6, 7));
+}
+
+TEST(HashJoinTest, SmallerLeft) {
+  // The table is built on the left side.
+  auto left = DataSliceImpl::Create(
+      arolla::CreateDenseArray<arolla::Text>({"b", "a", "b"}));
+  auto right = DataSliceImpl::Create(arolla::CreateDenseArray<arolla::Text>(
+      {"a", "c", "b", "a", "b", "d", "e"}));
+  ASSERT_OK_AND_ASSIGN(auto result,
+                       HashJoin(left, right, JoinType::kInner, nullptr));
+  EXPECT_THAT(Positions(result), ElementsAre(2, 4, 0, 3, 2, 4));
+  EXPECT_THAT(result.split_points.span(), ElementsAre(0, 2, 4, 6));
+
+  auto left_missing = DataSliceImpl::Create(
+      arolla::CreateDenseArray<arolla::Text>({"x", "a"}));
+  ASSERT_OK_AND_ASSIGN(result,
+                       HashJoin(left_missing, right, JoinType::kLeft, nullptr));
+  EXPECT_THAT(Positions(result), ElementsAre(std::nullopt, 0, 3));
+  EXPECT_THAT(result.split_points.span(), ElementsAre(0, 1, 3));
+}
+
+TEST(HashJoinTest, MixedTypes) {
+  auto left = DataSliceImpl::Create(
+      {DataItem(1), DataItem(arolla::Text("a")), DataItem(int64_t{1}),
+       DataItem()});
+  auto right = DataSliceImpl::Create(
+      arolla::CreateDenseArray<int>({1, std::nullopt, 1}));
+  ASSERT_OK_AND_ASSIGN(auto result,
+                       HashJoin(left, right, JoinType::kLeft, nullptr));
+  EXPECT_THAT(Positions(result),
+              ElementsAre(0, 2, std::nullopt, std::nullopt, std::nullopt));
+  EXPECT_THAT(result.split_points.span(), ElementsAre(0, 2, 3, 4, 5));
+
+  // Different dtypes on both sides don't match.
+  auto right_int64 = DataSliceImpl::Create(
+      arolla::CreateDenseArray<int64_t>({1, 1}));
+  auto left_int32 = DataSliceImpl::Create(arolla::CreateDenseArray<int>({1}));
+  ASSERT_OK_AND_ASSIGN(
+      result, HashJoin(left_int32, right_int64, JoinType::kInner, nullptr));
+  EXPECT_THAT(Positions(result), ElementsAre());
+}
+
+TEST(HashJoinTest, Empty) {
+  auto empty = DataSliceImpl::CreateEmptyAndUnknownType(0);
+  auto right = DataSliceImpl::Create(arolla::CreateDenseArray<int>({1, 2}));
+  ASSERT_OK_AND_ASSIGN(auto result,
+                       HashJoin(empty, right, JoinType::kLeft, nullptr));
+  EXPECT_THAT(Positions(result), ElementsAre());
+  EXPECT_THAT(result.split_points.span(), ElementsAre(0));
+
+  auto left = DataSliceImpl::Create(arolla::CreateDenseArray<int>({1, 2}));
+  ASSERT_OK_AND_ASSIGN(result,
+                       HashJoin(left, empty, JoinType::kLeft, nullptr));
+  EXPECT_THAT(Positions(result), ElementsAre(std::nullopt, std::nullopt));
+  EXPECT_THAT(result.split_points.span(), ElementsAre(0, 1, 2));
+}
+
+TEST(HashJoinTest, ParallelMatchesSequential) {
+  constexpr int64_t kLeftSize = 10 * kMinHashJoinChunkSize + 7;
+  constexpr int64_t kRightSize = 3 * kMinHashJoinChunkSize + 5;
+  std::vector<int64_t> left_values(kLeftSize);
+  std::vector<int64_t> right_values(kRightSize);
+  for (int64_t i = 0; i < kLeftSize; ++i) {
+    left_values[i] = (i * 7919) % 50000;
+  }
+  for (int64_t i = 0; i < kRightSize; ++i) {
+    right_values[i] = (i * 104729) % 30000;
+  }
+  auto left = DataSliceImpl::Create(
+      arolla::CreateFullDenseArray<int64_t>(left_values));
+  auto right = DataSliceImpl::Create(
+      arolla::CreateFullDenseArray<int64_t>(right_values));
+  ThreadPoolExecutor executor(4);
+  for (JoinType join_type : {JoinType::kInner, JoinType::kLeft}) {
+    // Both the left and the right side as the build side.
+    for (bool swap : {false, true}) {
+      const DataSliceImpl& a = swap ? right : left;
+      const DataSliceImpl& b = swap ? left : right;
+      ASSERT_OK_AND_ASSIGN(auto sequential,
+                           HashJoin(a, b, join_type, nullptr));
+      ASSERT_OK_AND_ASSIGN(auto parallel,
+                           HashJoin(a, b, join_type, &executor));
+      EXPECT_THAT(parallel.split_points.span(),
+                  ElementsAreArray(sequential.split_points.span()));
+      EXPECT_THAT(Positions(parallel), ElementsAreArray(Positions(sequential)));
+    }
+  }
+  ASSERT_OK_AND_ASSIGN(auto result,
+                       HashJoin(left, right, JoinType::kInner, &executor));
+  for (int64_t i = 0; i < kLeftSize; ++i) {
+    for (int64_t j = result.split_points[i]; j < result.split_points[i + 1];
+         ++j) {
+      const auto& positions = result.right_positions.values;
+      ASSERT_EQ(right_values[positions[j]], left_values[i]);
+      if (j > result.split_points[i]) {
+        ASSERT_LT(positions[j - 1], positions[j]);
+      }
+    }
+  }
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -0,0 +1,200 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_INVERSE_MAPPING_H_
+#define KOLADATA_INTERNAL_OP_UTILS_INVERSE_MAPPING_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/types/span.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::internal {
+
+namespace inverse_mapping_impl {
+
+// Outputs of one bucket of the blocked scatter are contiguous and fit in the
+// L2 cache.
+constexpr int kBucketBits = 15;
+
+// Smaller inputs are scattered directly.
+constexpr int64_t kMinBlockedScatterSize = int64_t{1} << 20;
+
+// Concurrent tasks of the blocked scatter get at least this number of rows.
+constexpr int64_t kMinChunkSize = int64_t{1} << 16;
+
+// A position of the result together with its value.
+struct ScatterEntry {
+  int64_t dest;
+  int64_t value;
+};
+
+inline absl::Status DuplicateElementError() {
+  return absl::InvalidArgumentError(
+      "invalid permutation, some elements appear more than once");
+}
+
+// Calls `fn(dest, value)` for every present row `i` in [begin, end), where
+// `dest` is the position of the result the row is mapped to and `value` is the
+// position of the row within its group. Stops and returns an error if a value
+// is out of the range of its group, or if `fn` returns false.
+template <typename T, typename Fn>
+absl::Status ForEachDestination(const arolla::DenseArray<T>& x,
+                                absl::Span<const int64_t> split_points,
+                                int64_t begin, int64_t end, Fn&& fn) {
+  if (begin >= end) {
+    return absl::OkStatus();
+  }
+  size_t group = std::upper_bound(split_points.begin(), split_points.end(),
+                                  begin) -
+                 split_points.begin() - 1;
+  for (int64_t i = begin; i < end; ++i) {
+    while (i >= split_points[group + 1]) {
+      ++group;
+    }
+    if (!x.present(i)) {
+      continue;
+    }
+    int64_t group_begin = split_points[group];
+    int64_t group_size = split_points[group + 1] - group_begin;
+    int64_t element = x.values[i];
+    if (element < 0 || element >= group_size) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "invalid permutation, element %d is not a valid element of a "
+          "permutation of size %d",
+          element, group_size));
+    }
+    if (!fn(group_begin + element, i - group_begin)) {
+      return DuplicateElementError();
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace inverse_mapping_impl
+
+// Returns the inverse permutations of `x` within the groups of `split_points`:
+// for each present `x[i]` of a group starting at `split_points[g]`,
+// `result[split_points[g] + x[i]] == i - split_points[g]`. The positions that
+// no row is mapped to are missing. Returns an error if a value is out of the
+// range of its group or appears twice within a group.
+//
+// Random writes to a large result thrash the cache, so the rows of inputs with
+// at least `min_blocked_size` rows are first bucketed by destination (one
+// bucket per 2^kBucketBits positions of the result), and then the buckets are
+// scattered one by one. Both steps run concurrently using `executor` if
+// provided.
+template <typename T>
+absl::StatusOr<arolla::DenseArray<T>> SegmentedInverseMapping(
+    const arolla::DenseArray<T>& x, absl::Span<const int64_t> split_points,
+    Executor* executor,
+    int64_t min_blocked_size = inverse_mapping_impl::kMinBlockedScatterSize) {
+  using inverse_mapping_impl::kBucketBits;
+  using inverse_mapping_impl::ScatterEntry;
+  static_assert(std::is_integral_v<T> && std::is_signed_v<T>);
+  DCHECK(!split_points.empty());
+  DCHECK_EQ(split_points.back(), x.size());
+  constexpr T kMissing = -1;
+  const int64_t size = x.size();
+  typename arolla::Buffer<T>::Builder values_bldr(size);
+  absl::Span<T> out = values_bldr.GetMutableSpan();
+  std::fill(out.begin(), out.end(), kMissing);
+
+  if (size < min_blocked_size) {
+    RETURN_IF_ERROR(inverse_mapping_impl::ForEachDestination(
+        x, split_points, 0, size, [&](int64_t dest, int64_t value) {
+          if (out[dest] != kMissing) {
+            return false;
+          }
+          out[dest] = value;
+          return true;
+        }));
+  } else {
+    const int64_t num_buckets = ((size - 1) >> kBucketBits) + 1;
+    const int64_t num_chunks = ParallelChunkCount(
+        executor, size, inverse_mapping_impl::kMinChunkSize);
+    auto chunk_begin = [&](int64_t chunk) { return size * chunk / num_chunks; };
+    // offsets[chunk * num_buckets + bucket] is the position of the next entry
+    // of the chunk in the bucket. Entries are ordered by bucket and then by
+    // chunk, so every task writes to its own ranges.
+    std::vector<int64_t> offsets(num_chunks * num_buckets, 0);
+    RETURN_IF_ERROR(ParallelFor(executor, num_chunks, [&](int64_t chunk) {
+      int64_t* counts = offsets.data() + chunk * num_buckets;
+      return inverse_mapping_impl::ForEachDestination(
+          x, split_points, chunk_begin(chunk), chunk_begin(chunk + 1),
+          [&](int64_t dest, int64_t) {
+            ++counts[dest >> kBucketBits];
+            return true;
+          });
+    }));
+    std::vector<int64_t> bucket_begins(num_buckets + 1);
+    int64_t total = 0;
+    for (int64_t bucket = 0; bucket < num_buckets; ++bucket) {
+      bucket_begins[bucket] = total;
+      for (int64_t chunk = 0; chunk < num_chunks; ++chunk) {
+        int64_t& offset = offsets[chunk * num_buckets + bucket];
+        int64_t count = offset;
+        offset = total;
+        total += count;
+      }
+    }
+    bucket_begins[num_buckets] = total;
+    std::vector<ScatterEntry> entries(total);
+    RETURN_IF_ERROR(ParallelFor(executor, num_chunks, [&](int64_t chunk) {
+      int64_t* chunk_offsets = offsets.data() + chunk * num_buckets;
+      return inverse_mapping_impl::ForEachDestination(
+          x, split_points, chunk_begin(chunk), chunk_begin(chunk + 1),
+          [&](int64_t dest, int64_t value) {
+            entries[chunk_offsets[dest >> kBucketBits]++] = {dest, value};
+            return true;
+          });
+    }));
+    RETURN_IF_ERROR(ParallelFor(executor, num_buckets, [&](int64_t bucket) {
+      for (int64_t i = bucket_begins[bucket]; i < bucket_begins[bucket + 1];
+           ++i) {
+        const ScatterEntry& entry = entries[i];
+        if (out[entry.dest] != kMissing) {
+          return inverse_mapping_impl::DuplicateElementError();
+        }
+        out[entry.dest] = entry.value;
+      }
+      return absl::OkStatus();
+    }));
+  }
+
+  arolla::bitmap::AlmostFullBuilder bitmap_bldr(size);
+  for (int64_t i = 0; i < size; ++i) {
+    if (out[i] == kMissing) {
+      bitmap_bldr.AddMissed(i);
+    }
+  }
+  return arolla::DenseArray<T>{std::move(values_bldr).Build(),
+                               std::move(bitmap_bldr).Build()};
+}
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_INVERSE_MAPPING_H_
@@ -0,0 +1,81 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <random>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/log/check.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/op_utils/inverse_mapping.h"
+#include "arolla/dense_array/dense_array.h"
+
+namespace koladata::internal {
+namespace {
+
+constexpr auto kBenchmarkFn = [](auto* b) {
+  b->Arg(1000)->Arg(1000000)->Arg(100000000)->Unit(benchmark::kMillisecond);
+};
+
+// A random permutation of `size` elements as a single group.
+arolla::DenseArray<int64_t> RandomPermutation(int64_t size) {
+  std::vector<int64_t> perm(size);
+  std::iota(perm.begin(), perm.end(), 0);
+  std::shuffle(perm.begin(), perm.end(), std::mt19937_64(42));
+  return arolla::CreateFullDenseArray(std::move(perm));
+}
+
+// `blocked` == false is the direct scatter used before the blocked one.
+template <bool blocked>
+void BM_InverseMapping(benchmark::State& state) {
+  int64_t size = state.range(0);
+  auto x = RandomPermutation(size);
+  std::vector<int64_t> split_points = {0, size};
+  int64_t min_blocked_size =
+      blocked ? 0 : std::numeric_limits<int64_t>::max();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(x);
+    auto res = SegmentedInverseMapping(x, split_points, /*executor=*/nullptr,
+                                       min_blocked_size);
+    CHECK_OK(res);
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+void BM_InverseMappingParallel(benchmark::State& state) {
+  int64_t size = state.range(0);
+  auto x = RandomPermutation(size);
+  std::vector<int64_t> split_points = {0, size};
+  ThreadPoolExecutor executor(8);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(x);
+    auto res = SegmentedInverseMapping(x, split_points, &executor,
+                                       /*min_blocked_size=*/0);
+    CHECK_OK(res);
+    benchmark::DoNotOptimize(res);
+  }
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+BENCHMARK(BM_InverseMapping<false>)->Apply(kBenchmarkFn);
+BENCHMARK(BM_InverseMapping<true>)->Apply(kBenchmarkFn);
+BENCHMARK(BM_InverseMappingParallel)->Apply(kBenchmarkFn)->UseRealTime();
+
+}  // namespace
+}  // namespace koladata::internal
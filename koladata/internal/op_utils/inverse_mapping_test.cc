@@ -0,0 +1,110 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/inverse_mapping.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <numeric>
+#include <optional>
+#include <random>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::arolla::CreateDenseArray;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+using ::testing::HasSubstr;
+
+TEST(InverseMappingTest, Groups) {
+  auto x = CreateDenseArray<int>({1, 2, 0, 1, std::nullopt});
+  std::vector<int64_t> split_points = {0, 3, 3, 5};
+  EXPECT_THAT(SegmentedInverseMapping(x, split_points, nullptr),
+              IsOkAndHolds(ElementsAre(2, 0, 1, std::nullopt, 0)));
+}
+
+TEST(InverseMappingTest, InvalidPermutation) {
+  std::vector<int64_t> split_points = {0, 3};
+  EXPECT_THAT(SegmentedInverseMapping(CreateDenseArray<int64_t>({1, 3, 0}),
+                                      split_points, nullptr),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("invalid permutation, element 3")));
+  EXPECT_THAT(SegmentedInverseMapping(CreateDenseArray<int64_t>({1, -1, 0}),
+                                      split_points, nullptr),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("invalid permutation, element -1")));
+  EXPECT_THAT(SegmentedInverseMapping(CreateDenseArray<int64_t>({1, 1, 0}),
+                                      split_points, nullptr),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("invalid permutation")));
+  ThreadPoolExecutor executor(4);
+  EXPECT_THAT(SegmentedInverseMapping(CreateDenseArray<int64_t>({1, 1, 0}),
+                                      split_points, &executor,
+                                      /*min_blocked_size=*/1),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("invalid permutation")));
+}
+
+TEST(InverseMappingTest, BlockedScatter) {
+  // Groups of different sizes, including one spanning several buckets.
+  constexpr int64_t kSize = 5 << inverse_mapping_impl::kBucketBits;
+  std::vector<int64_t> split_points = {0, 3, 1000, 1000,
+                                       3 << inverse_mapping_impl::kBucketBits,
+                                       kSize};
+  std::mt19937 gen(17);
+  arolla::DenseArrayBuilder<int64_t> x_bldr(kSize);
+  for (size_t g = 0; g + 1 < split_points.size(); ++g) {
+    std::vector<int64_t> perm(split_points[g + 1] - split_points[g]);
+    std::iota(perm.begin(), perm.end(), 0);
+    std::shuffle(perm.begin(), perm.end(), gen);
+    for (int64_t i = 0; i < perm.size(); ++i) {
+      if ((split_points[g] + i) % 7 != 0) {
+        x_bldr.Set(split_points[g] + i, perm[i]);
+      }
+    }
+  }
+  auto x = std::move(x_bldr).Build();
+  ASSERT_OK_AND_ASSIGN(auto expected,
+                       SegmentedInverseMapping(x, split_points, nullptr));
+  ThreadPoolExecutor executor(4);
+  for (Executor* e : {static_cast<Executor*>(nullptr),
+                      static_cast<Executor*>(&executor)}) {
+    ASSERT_OK_AND_ASSIGN(auto inverse,
+                         SegmentedInverseMapping(x, split_points, e,
+                                                 /*min_blocked_size=*/1));
+    EXPECT_THAT(inverse, ElementsAreArray(expected));
+  }
+  for (int64_t i = 0; i < kSize; ++i) {
+    if (!x.present(i)) {
+      continue;
+    }
+    int64_t group_begin =
+        *(std::upper_bound(split_points.begin(), split_points.end(), i) - 1);
+    EXPECT_EQ(expected.values[group_begin + x.values[i]], i - group_begin);
+  }
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -15,23 +15,98 @@
 #ifndef KOLADATA_INTERNAL_OP_UTILS_ITEMID_H_
 #define KOLADATA_INTERNAL_OP_UTILS_ITEMID_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <utility>
 
+#include "absl/log/check.h"
 #include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/types/span.h"
 #include "koladata/data_slice_qtype.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/object_id.h"
 #include "arolla/dense_array/dense_array.h"
-#include "arolla/dense_array/ops/dense_ops.h"
+#include "arolla/memory/buffer.h"
 #include "arolla/qtype/qtype_traits.h"
 
 namespace koladata::internal {
 
+// Bulk extractors of ObjectId fields. Each one is a single loop over the
+// values of `ids` without a per-row presence check (the presence is taken from
+// `ids`), which the compiler can vectorize.
+
+// Returns the `last` (<= 64) trailing bits of each of `ids`.
+inline arolla::DenseArray<int64_t> ObjectIdTrailingBits(
+    const arolla::DenseArray<ObjectId>& ids, int64_t last) {
+  DCHECK(last >= 0 && last <= 64);
+  const uint64_t mask = last == 64 ? ~uint64_t{0} : (uint64_t{1} << last) - 1;
+  absl::Span<const ObjectId> values = ids.values.span();
+  arolla::Buffer<int64_t>::Builder bldr(values.size());
+  absl::Span<int64_t> out = bldr.GetMutableSpan();
+  for (size_t i = 0; i < values.size(); ++i) {
+    out[i] = static_cast<int64_t>(values[i].InternalLow64() & mask);
+  }
+  return {std::move(bldr).Build(), ids.bitmap, ids.bitmap_bit_offset};
+}
+
+// Returns the offset of each of `ids` within its allocation.
+inline arolla::DenseArray<int64_t> ObjectIdOffsets(
+    const arolla::DenseArray<ObjectId>& ids) {
+  absl::Span<const ObjectId> values = ids.values.span();
+  arolla::Buffer<int64_t>::Builder bldr(values.size());
+  absl::Span<int64_t> out = bldr.GetMutableSpan();
+  for (size_t i = 0; i < values.size(); ++i) {
+    out[i] = values[i].Offset();
+  }
+  return {std::move(bldr).Build(), ids.bitmap, ids.bitmap_bit_offset};
+}
+
+// Returns the first ObjectId of the allocation of each of `ids`, i.e. `ids`
+// with the offsets cleared. Ids of the same allocation get equal results.
+inline arolla::DenseArray<ObjectId> ObjectIdAllocations(
+    const arolla::DenseArray<ObjectId>& ids) {
+  absl::Span<const ObjectId> values = ids.values.span();
+  arolla::Buffer<ObjectId>::Builder bldr(values.size());
+  absl::Span<ObjectId> out = bldr.GetMutableSpan();
+  for (size_t i = 0; i < values.size(); ++i) {
+    out[i] = ObjectId::UnsafeCreateFromInternalHighLow(
+        values[i].InternalHigh64(),
+        values[i].InternalLow64() - values[i].Offset());
+  }
+  return {std::move(bldr).Build(), ids.bitmap, ids.bitmap_bit_offset};
+}
+
+// Returns a 64-bit hash of all the bits of `id`. Unlike absl::Hash, the result
+// doesn't depend on the process, so it can be used to partition ids between
+// shards.
+inline int64_t StableObjectIdHash(ObjectId id) {
+  // Mixes the halves and finalizes with the MurmurHash3 64-bit finalizer.
+  uint64_t h =
+      (id.InternalHigh64() * 0x9e3779b97f4a7c15ull) ^ id.InternalLow64();
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdull;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ull;
+  h ^= h >> 33;
+  return static_cast<int64_t>(h);
+}
+
+// Returns StableObjectIdHash of each of `ids`.
+inline arolla::DenseArray<int64_t> ObjectIdHashes(
+    const arolla::DenseArray<ObjectId>& ids) {
+  absl::Span<const ObjectId> values = ids.values.span();
+  arolla::Buffer<int64_t>::Builder bldr(values.size());
+  absl::Span<int64_t> out = bldr.GetMutableSpan();
+  for (size_t i = 0; i < values.size(); ++i) {
+    out[i] = StableObjectIdHash(values[i]);
+  }
+  return {std::move(bldr).Build(), ids.bitmap, ids.bitmap_bit_offset};
+}
+
 // Returns the `last` trailing bits of the item ids in the `ds` as an integer.
 struct ItemIdBits {
   absl::StatusOr<DataItem> operator()(const DataItem& ds, int64_t last) const {
@@ -61,10 +136,8 @@ struct ItemIdBits {
     if (ds.dtype() != arolla::GetQType<internal::ObjectId>()) {
       return absl::InvalidArgumentError("cannot use itemid_bits on primitives");
     }
-    auto op = arolla::CreateDenseOp(
-        [&](ObjectId id) { return GetTrailingBits(id, last); });
-    arolla::DenseArray<int64_t> res = op(ds.values<internal::ObjectId>());
-    return DataSliceImpl::Create(std::move(res));
+    return DataSliceImpl::Create(
+        ObjectIdTrailingBits(ds.values<internal::ObjectId>(), last));
   }
 
  private:
@@ -74,6 +147,30 @@ struct ItemIdBits {
   }
 };
 
+// Returns StableObjectIdHash of the item ids in the `ds`.
+struct ItemIdHash {
+  absl::StatusOr<DataItem> operator()(const DataItem& ds) const {
+    if (!ds.has_value()) {
+      return DataItem();
+    }
+    if (ds.dtype() != arolla::GetQType<internal::ObjectId>()) {
+      return absl::InvalidArgumentError("cannot use itemid_hash on primitives");
+    }
+    return DataItem(StableObjectIdHash(ds.value<ObjectId>()));
+  }
+
+  absl::StatusOr<DataSliceImpl> operator()(const DataSliceImpl& ds) const {
+    if (ds.is_empty_and_unknown()) {
+      return DataSliceImpl::CreateEmptyAndUnknownType(ds.size());
+    }
+    if (ds.dtype() != arolla::GetQType<internal::ObjectId>()) {
+      return absl::InvalidArgumentError("cannot use itemid_hash on primitives");
+    }
+    return DataSliceImpl::Create(
+        ObjectIdHashes(ds.values<internal::ObjectId>()));
+  }
+};
+
 }  // namespace koladata::internal
 
 #endif  // KOLADATA_INTERNAL_OP_UTILS_ITEMID_H_
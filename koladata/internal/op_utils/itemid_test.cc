@@ -15,6 +15,7 @@
 #include "koladata/internal/op_utils/itemid.h"
 
 #include <cstdint>
+#include <optional>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -122,5 +123,48 @@ TEST(ItemIdBits, TestDataSliceImplBits) {
                   static_cast<int64_t>(obj_id_2.ToRawInt128() & 1023))));
 }
 
+TEST(ItemIdBits, TestAllBits) {
+  ObjectId id = AllocateSingleObject();
+  DataSliceImpl slice = DataSliceImpl::Create(CreateDenseArray<ObjectId>({id}));
+  EXPECT_THAT(ItemIdBits()(slice, 64),
+              IsOkAndHolds(ElementsAre(
+                  static_cast<int64_t>(id.InternalLow64()))));
+  EXPECT_THAT(ItemIdBits()(slice, 0), IsOkAndHolds(ElementsAre(0)));
+}
+
+TEST(ObjectIdFields, OffsetsAndAllocations) {
+  AllocationId alloc = Allocate(100);
+  auto ids = CreateDenseArray<ObjectId>(
+      {alloc.ObjectByOffset(0), alloc.ObjectByOffset(57), std::nullopt,
+       alloc.ObjectByOffset(99)});
+  EXPECT_THAT(ObjectIdOffsets(ids), ElementsAre(0, 57, std::nullopt, 99));
+  ObjectId first = alloc.ObjectByOffset(0);
+  EXPECT_THAT(ObjectIdAllocations(ids),
+              ElementsAre(first, first, std::nullopt, first));
+}
+
+TEST(ItemIdHash, DataItem) {
+  ObjectId id = AllocateSingleObject();
+  EXPECT_THAT(ItemIdHash()(DataItem(id)),
+              IsOkAndHolds(DataItem(StableObjectIdHash(id))));
+  EXPECT_THAT(ItemIdHash()(DataItem()), IsOkAndHolds(DataItem()));
+  EXPECT_THAT(
+      ItemIdHash()(DataItem(1)),
+      StatusIs(absl::StatusCode::kInvalidArgument, HasSubstr("on primitives")));
+}
+
+TEST(ItemIdHash, DataSliceImpl) {
+  AllocationId alloc = Allocate(1000);
+  ObjectId id_1 = alloc.ObjectByOffset(1);
+  ObjectId id_2 = alloc.ObjectByOffset(2);
+  DataSliceImpl slice = DataSliceImpl::Create(
+      CreateDenseArray<ObjectId>({id_1, std::nullopt, id_2}));
+  EXPECT_THAT(ItemIdHash()(slice),
+              IsOkAndHolds(ElementsAre(StableObjectIdHash(id_1), std::nullopt,
+                                       StableObjectIdHash(id_2))));
+  EXPECT_THAT(ItemIdHash()(DataSliceImpl::CreateEmptyAndUnknownType(2)),
+              IsOkAndHolds(ElementsAre(std::nullopt, std::nullopt)));
+}
+
 }  // namespace
 }  // namespace koladata::internal
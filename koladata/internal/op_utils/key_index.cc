@@ -0,0 +1,179 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/key_index.h"
+
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <variant>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dict.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/text.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::internal {
+namespace {
+
+absl::Status VerifyEdge(const arolla::DenseArrayEdge& edge, int64_t size,
+                        absl::string_view name) {
+  if (edge.edge_type() != arolla::DenseArrayEdge::SPLIT_POINTS) {
+    return absl::InvalidArgumentError(
+        absl::StrCat(name, " edge must be a split points edge"));
+  }
+  if (edge.child_size() != size) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("%s edge child size must be %d, got %d", name, size,
+                        edge.child_size()));
+  }
+  return absl::OkStatus();
+}
+
+// Calls `fn(group, i)` for all children `i` of a split points edge.
+template <typename Fn>
+void ForEachInGroups(const arolla::DenseArrayEdge& edge, Fn&& fn) {
+  absl::Span<const int64_t> splits = edge.edge_values().values.span();
+  for (int64_t group = 0; group + 1 < splits.size(); ++group) {
+    for (int64_t i = splits[group]; i < splits[group + 1]; ++i) {
+      fn(group, i);
+    }
+  }
+}
+
+}  // namespace
+
+template <typename Table, typename T, typename ToKey>
+void KeyIndex::Insert(Table& table, const arolla::DenseArray<T>& values,
+                      const arolla::DenseArrayEdge& keys_to_group,
+                      const ToKey& to_key) {
+  ForEachInGroups(keys_to_group, [&](int64_t group, int64_t i) {
+    if (!values.present(i)) {
+      return;
+    }
+    bool inserted = table.emplace(to_key(group, values.values[i]), i).second;
+    has_duplicates_ |= !inserted;
+  });
+}
+
+absl::StatusOr<KeyIndex> KeyIndex::Create(
+    const DataSliceImpl& keys, const arolla::DenseArrayEdge& keys_to_group) {
+  RETURN_IF_ERROR(VerifyEdge(keys_to_group, keys.size(), "keys"));
+  const arolla::QType* unsupported_key_type = nullptr;
+  keys.VisitValues([&]<typename T>(const arolla::DenseArray<T>&) {
+    if (Dict::IsUnsupportedKeyType<T>()) {
+      unsupported_key_type = arolla::GetQType<T>();
+    }
+  });
+  if (unsupported_key_type) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("invalid key type: ", unsupported_key_type->name()));
+  }
+
+  KeyIndex index(keys, keys_to_group.parent_size());
+  if (keys.present_count() == 0) {
+    return index;
+  }
+  if (!keys.is_mixed_dtype() && keys.dtype() == arolla::GetQType<int64_t>()) {
+    auto& table = index.table_.emplace<Int64Table>();
+    table.reserve(keys.present_count());
+    index.Insert(table, index.keys_.values<int64_t>(), keys_to_group,
+                 [](int64_t group, int64_t value) {
+                   return std::pair<int64_t, int64_t>(group, value);
+                 });
+  } else if (!keys.is_mixed_dtype() &&
+             keys.dtype() == arolla::GetQType<arolla::Text>()) {
+    auto& table = index.table_.emplace<TextTable>();
+    table.reserve(keys.present_count());
+    index.Insert(table, index.keys_.values<arolla::Text>(), keys_to_group,
+                 [](int64_t group, absl::string_view value) {
+                   return std::pair<int64_t, absl::string_view>(group, value);
+                 });
+  } else {
+    auto& table = index.table_.emplace<GenericTable>();
+    table.reserve(keys.present_count());
+    // The arrays have disjoint presence and values of different types never
+    // match, so inserting them one by one gives the same result as inserting
+    // the keys in order.
+    index.keys_.VisitValues([&]<typename T>(const arolla::DenseArray<T>& arr) {
+      index.Insert(table, arr, keys_to_group,
+                   [](int64_t group, arolla::view_type_t<T> value) {
+                     return std::pair<int64_t, DataItem>(
+                         group, DataItem(DataItem::View<T>{value}));
+                   });
+    });
+  }
+  return index;
+}
+
+absl::StatusOr<arolla::DenseArray<int64_t>> KeyIndex::Find(
+    const DataSliceImpl& query,
+    const arolla::DenseArrayEdge& query_to_group) const {
+  RETURN_IF_ERROR(VerifyEdge(query_to_group, query.size(), "query"));
+  if (query_to_group.parent_size() != group_count_) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "query must have the same number of groups as the index: %d vs %d",
+        query_to_group.parent_size(), group_count_));
+  }
+  arolla::DenseArrayBuilder<int64_t> builder(query.size());
+  auto find = [&](const auto& table, const auto& values, const auto& to_key) {
+    ForEachInGroups(query_to_group, [&](int64_t group, int64_t i) {
+      if (!values.present(i)) {
+        return;
+      }
+      if (auto it = table.find(to_key(group, values.values[i]));
+          it != table.end()) {
+        builder.Set(i, it->second);
+      }
+    });
+  };
+  query.VisitValues([&]<typename T>(const arolla::DenseArray<T>& values) {
+    std::visit(
+        [&]<typename Table>(const Table& table) {
+          if constexpr (std::is_same_v<Table, Int64Table>) {
+            if constexpr (std::is_same_v<T, int64_t>) {
+              find(table, values, [](int64_t group, int64_t value) {
+                return std::pair<int64_t, int64_t>(group, value);
+              });
+            }
+          } else if constexpr (std::is_same_v<Table, TextTable>) {
+            if constexpr (std::is_same_v<T, arolla::Text>) {
+              find(table, values, [](int64_t group, absl::string_view value) {
+                return std::pair<int64_t, absl::string_view>(group, value);
+              });
+            }
+          } else if constexpr (std::is_same_v<Table, GenericTable>) {
+            find(table, values,
+                 [](int64_t group, arolla::view_type_t<T> value) {
+                   return std::pair<int64_t, DataItem>(
+                       group, DataItem(DataItem::View<T>{value}));
+                 });
+          }
+        },
+        table_);
+  });
+  return std::move(builder).Build();
+}
+
+}  // namespace koladata::internal
@@ -0,0 +1,102 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_KEY_INDEX_H_
+#define KOLADATA_INTERNAL_OP_UTILS_KEY_INDEX_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <variant>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/hash/hash.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+
+namespace koladata::internal {
+
+// Hash index over the items of `keys`, grouped by the split points edge
+// `keys_to_group`. It maps (group, key) to the position of the key in `keys`.
+// The index is built once and can then be used to look up many different
+// slices, e.g. to translate them or to use `keys` as dict keys.
+//
+// Keys are compared as DataItems, so that values of different types never
+// match. INT64 and TEXT keys use specialized tables; other and mixed types use
+// a generic table of DataItems. As for dicts, FLOAT32, FLOAT64 and EXPR keys
+// are not supported.
+class KeyIndex {
+ public:
+  // Builds the index. If the same key is present more than once within a
+  // group, the first position is used and has_duplicates() returns true.
+  static absl::StatusOr<KeyIndex> Create(
+      const DataSliceImpl& keys, const arolla::DenseArrayEdge& keys_to_group);
+
+  int64_t group_count() const { return group_count_; }
+  int64_t key_count() const { return keys_.size(); }
+  bool has_duplicates() const { return has_duplicates_; }
+
+  // Returns the positions in `keys` of the items of `query` within the same
+  // group, or missing for the items that are not in the index.
+  // `query_to_group` must be a split points edge with the same parent size as
+  // `keys_to_group`.
+  absl::StatusOr<arolla::DenseArray<int64_t>> Find(
+      const DataSliceImpl& query,
+      const arolla::DenseArrayEdge& query_to_group) const;
+
+ private:
+  struct GenericHash {
+    size_t operator()(const std::pair<int64_t, DataItem>& p) const {
+      return absl::HashOf(p.first, DataItem::Hash()(p.second));
+    }
+  };
+  struct GenericEq {
+    bool operator()(const std::pair<int64_t, DataItem>& a,
+                    const std::pair<int64_t, DataItem>& b) const {
+      return a.first == b.first && DataItem::Eq()(a.second, b.second);
+    }
+  };
+
+  using Int64Table = absl::flat_hash_map<std::pair<int64_t, int64_t>, int64_t>;
+  // The string views point to the text buffers of `keys_`.
+  using TextTable =
+      absl::flat_hash_map<std::pair<int64_t, absl::string_view>, int64_t>;
+  using GenericTable =
+      absl::flat_hash_map<std::pair<int64_t, DataItem>, int64_t, GenericHash,
+                          GenericEq>;
+
+  KeyIndex(DataSliceImpl keys, int64_t group_count)
+      : keys_(std::move(keys)), group_count_(group_count) {}
+
+  // Inserts the keys of `values` into `table`, converting them to table keys
+  // with `to_key(group, value)`.
+  template <typename Table, typename T, typename ToKey>
+  void Insert(Table& table, const arolla::DenseArray<T>& values,
+              const arolla::DenseArrayEdge& keys_to_group,
+              const ToKey& to_key);
+
+  DataSliceImpl keys_;
+  int64_t group_count_;
+  bool has_duplicates_ = false;
+  // std::monostate if there are no present keys.
+  std::variant<std::monostate, Int64Table, TextTable, GenericTable> table_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_KEY_INDEX_H_
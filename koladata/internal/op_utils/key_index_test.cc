@@ -0,0 +1,126 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/key_index.h"
+
+#include <cstdint>
+#include <initializer_list>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::arolla::CreateDenseArray;
+using ::arolla::Text;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+arolla::DenseArrayEdge CreateEdge(std::initializer_list<int64_t> split_points) {
+  return *arolla::DenseArrayEdge::FromSplitPoints(
+      arolla::CreateFullDenseArray(std::vector<int64_t>(split_points)));
+}
+
+TEST(KeyIndexTest, Int64) {
+  auto keys = DataSliceImpl::Create(
+      CreateDenseArray<int64_t>({1, 2, std::nullopt, 2, 5}));
+  ASSERT_OK_AND_ASSIGN(auto index,
+                       KeyIndex::Create(keys, CreateEdge({0, 2, 5})));
+  EXPECT_EQ(index.group_count(), 2);
+  EXPECT_EQ(index.key_count(), 5);
+  EXPECT_FALSE(index.has_duplicates());
+
+  auto query = DataSliceImpl::Create(
+      CreateDenseArray<int64_t>({2, 1, 5, std::nullopt, 1, 2}));
+  ASSERT_OK_AND_ASSIGN(auto res, index.Find(query, CreateEdge({0, 3, 6})));
+  EXPECT_THAT(res, ElementsAre(1, 0, std::nullopt, std::nullopt,
+                               std::nullopt, 3));
+
+  // Values of other types never match.
+  auto int32_query = DataSliceImpl::Create(CreateDenseArray<int>({1, 2}));
+  ASSERT_OK_AND_ASSIGN(res, index.Find(int32_query, CreateEdge({0, 2, 2})));
+  EXPECT_THAT(res, ElementsAre(std::nullopt, std::nullopt));
+}
+
+TEST(KeyIndexTest, Text) {
+  auto keys = DataSliceImpl::Create(
+      CreateDenseArray<Text>({Text("a"), Text("b"), Text("c")}));
+  ASSERT_OK_AND_ASSIGN(auto index, KeyIndex::Create(keys, CreateEdge({0, 3})));
+  // The index stays valid after the original slice is gone.
+  keys = DataSliceImpl();
+  auto query = DataSliceImpl::Create(
+      CreateDenseArray<Text>({Text("c"), Text("d"), std::nullopt, Text("a")}));
+  ASSERT_OK_AND_ASSIGN(auto res, index.Find(query, CreateEdge({0, 4})));
+  EXPECT_THAT(res, ElementsAre(2, std::nullopt, std::nullopt, 0));
+}
+
+TEST(KeyIndexTest, Mixed) {
+  DataSliceImpl::Builder bldr(4);
+  bldr.Insert(0, DataItem(1));
+  bldr.Insert(1, DataItem(Text("a")));
+  bldr.Insert(2, DataItem(int64_t{1}));
+  bldr.Insert(3, DataItem(Text("a")));
+  DataSliceImpl keys = std::move(bldr).Build();
+  ASSERT_OK_AND_ASSIGN(auto index, KeyIndex::Create(keys, CreateEdge({0, 4})));
+  EXPECT_TRUE(index.has_duplicates());
+
+  DataSliceImpl::Builder query_bldr(4);
+  query_bldr.Insert(0, DataItem(int64_t{1}));
+  query_bldr.Insert(1, DataItem(Text("a")));
+  query_bldr.Insert(2, DataItem(1));
+  query_bldr.Insert(3, DataItem(Text("b")));
+  ASSERT_OK_AND_ASSIGN(
+      auto res, index.Find(std::move(query_bldr).Build(), CreateEdge({0, 4})));
+  EXPECT_THAT(res, ElementsAre(2, 1, 0, std::nullopt));
+}
+
+TEST(KeyIndexTest, Empty) {
+  ASSERT_OK_AND_ASSIGN(
+      auto index, KeyIndex::Create(DataSliceImpl::CreateEmptyAndUnknownType(2),
+                                   CreateEdge({0, 2})));
+  auto query = DataSliceImpl::Create(CreateDenseArray<int>({1, 2}));
+  ASSERT_OK_AND_ASSIGN(auto res, index.Find(query, CreateEdge({0, 2})));
+  EXPECT_THAT(res, ElementsAre(std::nullopt, std::nullopt));
+}
+
+TEST(KeyIndexTest, Errors) {
+  EXPECT_THAT(
+      KeyIndex::Create(DataSliceImpl::Create(CreateDenseArray<float>({1.5})),
+                       CreateEdge({0, 1})),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               "invalid key type: FLOAT32"));
+  auto keys = DataSliceImpl::Create(CreateDenseArray<int>({1, 2}));
+  EXPECT_THAT(KeyIndex::Create(keys, CreateEdge({0, 3})),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("child size must be 2")));
+  ASSERT_OK_AND_ASSIGN(auto index, KeyIndex::Create(keys, CreateEdge({0, 2})));
+  EXPECT_THAT(index.Find(keys, CreateEdge({0, 1, 2})),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("same number of groups")));
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -0,0 +1,146 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_PHILOX_H_
+#define KOLADATA_INTERNAL_OP_UTILS_PHILOX_H_
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/util/unit.h"
+
+namespace koladata::internal {
+
+// Masks are not split into chunks smaller than this.
+constexpr int64_t kMinRandomChunkSize = 1 << 16;
+
+// Philox4x32-10 counter-based random number generator (Salmon et al.,
+// "Parallel random numbers: as easy as 1, 2, 3"). Maps a 128 bit counter and a
+// 64 bit key to 128 random bits, so the random bits of each element can be
+// computed independently from (seed, element counter) in any order. The loop
+// has no data dependencies between counters, which lets the compiler evaluate
+// several counters in SIMD lanes.
+inline std::array<uint32_t, 4> Philox4x32(std::array<uint32_t, 4> counter,
+                                          std::array<uint32_t, 2> key) {
+  constexpr uint32_t kMul0 = 0xD2511F53;
+  constexpr uint32_t kMul1 = 0xCD9E8D57;
+  constexpr uint32_t kWeyl0 = 0x9E3779B9;
+  constexpr uint32_t kWeyl1 = 0xBB67AE85;
+  for (int round = 0; round < 10; ++round) {
+    if (round > 0) {
+      key[0] += kWeyl0;
+      key[1] += kWeyl1;
+    }
+    const uint64_t product0 = uint64_t{kMul0} * counter[0];
+    const uint64_t product1 = uint64_t{kMul1} * counter[2];
+    counter = {static_cast<uint32_t>(product1 >> 32) ^ counter[1] ^ key[0],
+               static_cast<uint32_t>(product1),
+               static_cast<uint32_t>(product0 >> 32) ^ counter[3] ^ key[1],
+               static_cast<uint32_t>(product0)};
+  }
+  return counter;
+}
+
+// Returns 64 random bits for `counter` and `seed`.
+inline uint64_t PhiloxRandom64(absl::uint128 counter, uint64_t seed) {
+  const uint64_t low = absl::Uint128Low64(counter);
+  const uint64_t high = absl::Uint128High64(counter);
+  const std::array<uint32_t, 4> bits = Philox4x32(
+      {static_cast<uint32_t>(low), static_cast<uint32_t>(low >> 32),
+       static_cast<uint32_t>(high), static_cast<uint32_t>(high >> 32)},
+      {static_cast<uint32_t>(seed), static_cast<uint32_t>(seed >> 32)});
+  return (uint64_t{bits[1]} << 32) | bits[0];
+}
+
+// Returns the threshold such that PhiloxRandom64(...) < threshold with
+// probability `ratio`. std::nullopt means that all the elements are sampled.
+inline std::optional<uint64_t> SampleThreshold(double ratio) {
+  if (!(ratio > 0)) {  // Also handles NaN.
+    return 0;
+  }
+  if (ratio >= 1) {
+    return std::nullopt;
+  }
+  // 0x1p64 * ratio < 2^64 for any double ratio < 1.
+  return static_cast<uint64_t>(0x1p64 * ratio);
+}
+
+// Returns a mask of `size` elements where the element `i` is present iff
+// PhiloxRandom64(*get_counter(i), seed) is below the threshold of `ratio`.
+// `get_counter(i)` returns std::optional<absl::uint128>, std::nullopt meaning
+// that the element is never sampled. The result depends only on `seed` and the
+// counters, not on the number of chunks the mask is split into when evaluated
+// concurrently using `executor`.
+template <typename GetCounterFn>
+arolla::DenseArray<arolla::Unit> ParallelSampleMask(int64_t size, double ratio,
+                                                    uint64_t seed,
+                                                    GetCounterFn get_counter,
+                                                    Executor* executor) {
+  using ::arolla::bitmap::Word;
+  constexpr int64_t kWordBitCount = arolla::bitmap::kWordBitCount;
+  const std::optional<uint64_t> threshold = SampleThreshold(ratio);
+  if (threshold == 0) {
+    return arolla::CreateEmptyDenseArray<arolla::Unit>(size);
+  }
+  const int64_t num_words = arolla::bitmap::BitmapSize(size);
+  arolla::Buffer<Word>::Builder bitmap_bldr(num_words);
+  absl::Span<Word> bitmap = bitmap_bldr.GetMutableSpan();
+  auto fill_words = [&](int64_t word_begin, int64_t word_end) {
+    for (int64_t w = word_begin; w < word_end; ++w) {
+      const int64_t begin = w * kWordBitCount;
+      const int64_t end = std::min(size, begin + kWordBitCount);
+      Word word = 0;
+      for (int64_t i = begin; i < end; ++i) {
+        const std::optional<absl::uint128> counter = get_counter(i);
+        const bool sampled =
+            counter.has_value() &&
+            (!threshold.has_value() ||
+             PhiloxRandom64(*counter, seed) < *threshold);
+        word |= Word{sampled} << (i - begin);
+      }
+      bitmap[w] = word;
+    }
+  };
+  const int64_t num_chunks =
+      ParallelChunkCount(executor, size, kMinRandomChunkSize);
+  if (num_chunks <= 1) {
+    fill_words(0, num_words);
+  } else {
+    // Chunks consist of whole words, so that different chunks never write to
+    // the same word.
+    const int64_t chunk_words = (num_words + num_chunks - 1) / num_chunks;
+    // The chunks never fail.
+    ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+      const int64_t word_begin = chunk * chunk_words;
+      fill_words(word_begin, std::min(num_words, word_begin + chunk_words));
+      return absl::OkStatus();
+    }).IgnoreError();
+  }
+  return arolla::DenseArray<arolla::Unit>{
+      arolla::VoidBuffer(size), std::move(bitmap_bldr).Build()};
+}
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_PHILOX_H_
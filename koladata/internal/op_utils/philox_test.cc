@@ -0,0 +1,105 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/philox.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/numeric/int128.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/unit.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::ElementsAre;
+
+constexpr int64_t kSize = 5 * kMinRandomChunkSize + 17;
+
+// Known answers from the Random123 library.
+TEST(PhiloxTest, Philox4x32) {
+  EXPECT_THAT(Philox4x32({0, 0, 0, 0}, {0, 0}),
+              ElementsAre(0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8));
+  EXPECT_THAT(Philox4x32({0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+                         {0xffffffff, 0xffffffff}),
+              ElementsAre(0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd));
+  EXPECT_THAT(Philox4x32({0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                         {0xa4093822, 0x299f31d0}),
+              ElementsAre(0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1));
+}
+
+TEST(PhiloxTest, SampleThreshold) {
+  EXPECT_EQ(SampleThreshold(0.0), 0);
+  EXPECT_EQ(SampleThreshold(-1.0), 0);
+  EXPECT_EQ(SampleThreshold(0.5), uint64_t{1} << 63);
+  EXPECT_EQ(SampleThreshold(1.0), std::nullopt);
+}
+
+TEST(PhiloxTest, ParallelSampleMask) {
+  auto index_counter = [](int64_t i) -> std::optional<absl::uint128> {
+    return absl::uint128(i);
+  };
+  auto sequential =
+      ParallelSampleMask(kSize, 0.1, 123, index_counter, nullptr);
+  ThreadPoolExecutor executor(4);
+  auto parallel = ParallelSampleMask(kSize, 0.1, 123, index_counter, &executor);
+  ASSERT_EQ(parallel.size(), kSize);
+  EXPECT_EQ(parallel.PresentCount(), sequential.PresentCount());
+  for (int64_t i = 0; i < kSize; ++i) {
+    ASSERT_EQ(parallel.present(i), sequential.present(i)) << i;
+    ASSERT_EQ(parallel.present(i),
+              PhiloxRandom64(absl::uint128(i), 123) < *SampleThreshold(0.1))
+        << i;
+  }
+  // About 10% of the elements are sampled.
+  EXPECT_NEAR(parallel.PresentCount(), kSize / 10, kSize / 100);
+
+  auto other_seed =
+      ParallelSampleMask(kSize, 0.1, 124, index_counter, &executor);
+  int64_t same = 0;
+  for (int64_t i = 0; i < kSize; ++i) {
+    same += other_seed.present(i) && parallel.present(i);
+  }
+  EXPECT_LT(same, kSize / 50);
+}
+
+TEST(PhiloxTest, ParallelSampleMaskEdgeCases) {
+  auto index_counter = [](int64_t i) -> std::optional<absl::uint128> {
+    return absl::uint128(i);
+  };
+  auto odd_counter = [](int64_t i) -> std::optional<absl::uint128> {
+    if (i % 2 == 0) {
+      return std::nullopt;
+    }
+    return absl::uint128(i);
+  };
+  EXPECT_EQ(ParallelSampleMask(100, 0.0, 1, index_counter, nullptr)
+                .PresentCount(),
+            0);
+  EXPECT_EQ(ParallelSampleMask(100, 1.0, 1, index_counter, nullptr)
+                .PresentCount(),
+            100);
+  auto mask = ParallelSampleMask(100, 1.0, 1, odd_counter, nullptr);
+  for (int64_t i = 0; i < 100; ++i) {
+    EXPECT_EQ(mask.present(i), i % 2 == 1);
+  }
+  EXPECT_EQ(ParallelSampleMask(0, 0.5, 1, index_counter, nullptr).size(), 0);
+}
+
+}  // namespace
+}  // namespace koladata::internal
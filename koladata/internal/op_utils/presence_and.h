@@ -15,21 +15,22 @@
 #ifndef KOLADATA_INTERNAL_OP_UTILS_PRESENCE_AND_H_
 #define KOLADATA_INTERNAL_OP_UTILS_PRESENCE_AND_H_
 
+#include <cstdint>
 #include <type_traits>
 #include <utility>
 
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/object_id.h"
+#include "arolla/dense_array/bitmap.h"
 #include "arolla/dense_array/dense_array.h"
-#include "arolla/qexpr/eval_context.h"
-#include "arolla/qexpr/operators/dense_array/logic_ops.h"
+#include "arolla/memory/buffer.h"
 #include "arolla/qtype/qtype_traits.h"
 #include "arolla/util/unit.h"
-#include "arolla/util/status_macros_backport.h"
 
 namespace koladata::internal {
 
@@ -38,7 +39,6 @@ namespace koladata::internal {
 struct PresenceAndOp {
   absl::StatusOr<DataSliceImpl> operator()(
       const DataSliceImpl& ds, const DataSliceImpl& presence_mask) const {
-    arolla::EvaluationContext ctx;
     DataSliceImpl::Builder bldr(ds.size());
     if (ds.size() != presence_mask.size()) {
       return absl::InvalidArgumentError(
@@ -53,13 +53,16 @@ struct PresenceAndOp {
           "Second argument to operator & (or apply_mask) must have all items "
           "of MASK dtype");
     }
-    auto presence_mask_array = presence_mask.values<arolla::Unit>();
+    if (presence_mask.present_count() == presence_mask.size()) {
+      return ds;
+    }
+    if (presence_mask.present_count() == 0) {
+      return std::move(bldr).Build();
+    }
+    const auto& presence_mask_array = presence_mask.values<arolla::Unit>();
 
-    RETURN_IF_ERROR(ds.VisitValues([&](const auto& array) -> absl::Status {
-      ASSIGN_OR_RETURN(
-          auto masked_array,
-          arolla::DenseArrayPresenceAndOp()(&ctx, array, presence_mask_array));
-      using T = typename std::decay_t<decltype(array)>::base_type;
+    ds.VisitValues([&]<class T>(const arolla::DenseArray<T>& array) {
+      auto masked_array = ApplyMask(array, presence_mask_array);
       if (!masked_array.IsAllMissing()) {
         bldr.AddArray(std::move(masked_array));
         if constexpr (std::is_same_v<T, ObjectId>) {
@@ -67,8 +70,7 @@ struct PresenceAndOp {
           bldr.GetMutableAllocationIds().Insert(ds.allocation_ids());
         }
       }
-      return absl::OkStatus();
-    }));
+    });
     return std::move(bldr).Build();
   }
 
@@ -84,6 +86,28 @@ struct PresenceAndOp {
     }
     return item;
   }
+
+ private:
+  // Returns `array` with the presence of `mask` applied. The bitmaps are
+  // intersected word by word and the values buffer is shared with `array`.
+  template <class T>
+  static arolla::DenseArray<T> ApplyMask(
+      const arolla::DenseArray<T>& array,
+      const arolla::DenseArray<arolla::Unit>& mask) {
+    if (mask.bitmap.empty()) {
+      return array;
+    }
+    const int64_t bitmap_size = arolla::bitmap::BitmapSize(array.size());
+    arolla::Buffer<arolla::bitmap::Word>::Builder bitmap_bldr(bitmap_size);
+    absl::Span<arolla::bitmap::Word> bitmap = bitmap_bldr.GetMutableSpan();
+    for (int64_t i = 0; i < bitmap_size; ++i) {
+      bitmap[i] = arolla::bitmap::GetWordWithOffset(array.bitmap, i,
+                                                    array.bitmap_bit_offset) &
+                  arolla::bitmap::GetWordWithOffset(mask.bitmap, i,
+                                                    mask.bitmap_bit_offset);
+    }
+    return arolla::DenseArray<T>{array.values, std::move(bitmap_bldr).Build()};
+  }
 };
 
 }  // namespace koladata::internal
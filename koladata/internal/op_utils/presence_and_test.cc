@@ -116,6 +116,30 @@ TEST(PresenceAndTest, DataSlicePrimitiveValues) {
   }
 }
 
+TEST(PresenceAndTest, SharesValues) {
+  auto values = CreateDenseArray<int>({1, 2, std::nullopt, 4});
+  auto ds = DataSliceImpl::Create(values);
+  {
+    // Fully present mask.
+    auto ds_presence = DataSliceImpl::Create(
+        CreateDenseArray<Unit>({kPresent, kPresent, kPresent, kPresent}));
+    ASSERT_OK_AND_ASSIGN(auto res, PresenceAndOp()(ds, ds_presence));
+    EXPECT_EQ(res.values<int>().values.span().data(),
+              values.values.span().data());
+    EXPECT_THAT(res.values<int>(), ElementsAre(1, 2, std::nullopt, 4));
+  }
+  {
+    // Only the bitmap is recomputed.
+    auto ds_presence = DataSliceImpl::Create(
+        CreateDenseArray<Unit>({kMissing, kPresent, kPresent, kPresent}));
+    ASSERT_OK_AND_ASSIGN(auto res, PresenceAndOp()(ds, ds_presence));
+    EXPECT_EQ(res.values<int>().values.span().data(),
+              values.values.span().data());
+    EXPECT_THAT(res.values<int>(),
+                ElementsAre(std::nullopt, 2, std::nullopt, 4));
+  }
+}
+
 TEST(PresenceAndTest, DataSliceMixedPrimitiveValues) {
   auto values_int = CreateDenseArray<int>({1, std::nullopt, 12, std::nullopt});
   auto values_float =
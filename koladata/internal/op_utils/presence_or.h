@@ -15,20 +15,29 @@
 #ifndef KOLADATA_INTERNAL_OP_UTILS_PRESENCE_OR_H_
 #define KOLADATA_INTERNAL_OP_UTILS_PRESENCE_OR_H_
 
+#include <algorithm>
+#include <cstdint>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/op_utils/has.h"
 #include "koladata/internal/op_utils/presence_and.h"
+#include "arolla/dense_array/bitmap.h"
 #include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
 #include "arolla/qexpr/eval_context.h"
 #include "arolla/qexpr/operators/dense_array/logic_ops.h"
+#include "arolla/qtype/qtype.h"
+#include "arolla/qtype/qtype_traits.h"
 #include "arolla/util/unit.h"
 #include "arolla/util/status_macros_backport.h"
 
@@ -43,7 +52,7 @@ struct PresenceOrOp {
       return absl::InvalidArgumentError(
           "coalesce requires input slices to have the same size");
     }
-    if (rhs.present_count() == 0) {
+    if (rhs.present_count() == 0 || lhs.present_count() == lhs.size()) {
       return lhs;
     }
     if (lhs.is_empty_and_unknown()) {
@@ -111,6 +120,94 @@ struct PresenceOrOp {
     return std::move(bldr).Build();
   }
 
+  // Elementwise returns the value of the first present input. Equivalent to
+  // `inputs[0] | inputs[1] | ...`, but the bitmaps of all inputs are walked
+  // once and no intermediate results are materialized.
+  absl::StatusOr<DataSliceImpl> operator()(
+      absl::Span<const DataSliceImpl> inputs) const {
+    using ::arolla::bitmap::Word;
+    if (inputs.empty()) {
+      return absl::InvalidArgumentError(
+          "coalesce requires at least one input");
+    }
+    const int64_t size = inputs[0].size();
+    std::vector<const DataSliceImpl*> present_inputs;
+    for (const DataSliceImpl& input : inputs) {
+      if (input.size() != size) {
+        return absl::InvalidArgumentError(
+            "coalesce requires input slices to have the same size");
+      }
+      if (input.present_count() > 0) {
+        present_inputs.push_back(&input);
+      }
+    }
+    if (present_inputs.empty()) {
+      return inputs[0];
+    }
+    if (present_inputs.size() == 1 ||
+        present_inputs[0]->present_count() == size) {
+      return *present_inputs[0];
+    }
+
+    // taken[k] is the set of rows for which present_inputs[k] is the first
+    // present input.
+    const int64_t bitmap_size = arolla::bitmap::BitmapSize(size);
+    std::vector<Word> remaining(bitmap_size, arolla::bitmap::kFullWord);
+    std::vector<std::vector<Word>> taken;
+    taken.reserve(present_inputs.size());
+    for (const DataSliceImpl* input : present_inputs) {
+      std::vector<Word>& input_taken = taken.emplace_back(bitmap_size, 0);
+      input->VisitValues([&](const auto& array) {
+        for (int64_t i = 0; i < bitmap_size; ++i) {
+          input_taken[i] |= arolla::bitmap::GetWordWithOffset(
+              array.bitmap, i, array.bitmap_bit_offset);
+        }
+      });
+      bool any_remaining = false;
+      for (int64_t i = 0; i < bitmap_size; ++i) {
+        input_taken[i] &= remaining[i];
+        remaining[i] &= ~input_taken[i];
+        any_remaining |= remaining[i] != 0;
+      }
+      if (!any_remaining) {
+        break;
+      }
+    }
+
+    DataSliceImpl::Builder bldr(size);
+    for (int64_t k = 0; k < taken.size(); ++k) {
+      bldr.GetMutableAllocationIds().Insert(
+          present_inputs[k]->allocation_ids());
+    }
+    std::vector<arolla::QTypePtr> merged_types;
+    for (int64_t k = 0; k < taken.size(); ++k) {
+      present_inputs[k]->VisitValues([&]<class T>(
+                                         const arolla::DenseArray<T>& array) {
+        if (absl::c_linear_search(merged_types, arolla::GetQType<T>())) {
+          return;
+        }
+        merged_types.push_back(arolla::GetQType<T>());
+        // Collects the arrays of type T of this and the following inputs.
+        std::vector<std::pair<const arolla::DenseArray<T>*,
+                              absl::Span<const Word>>>
+            parts = {{&array, taken[k]}};
+        for (int64_t j = k + 1; j < taken.size(); ++j) {
+          present_inputs[j]->VisitValues(
+              [&]<class U>(const arolla::DenseArray<U>& other) {
+                if constexpr (std::is_same_v<T, U>) {
+                  parts.emplace_back(&other, taken[j]);
+                }
+              });
+        }
+        auto merged_array = MergeTaken<T>(size, parts);
+        if (!merged_array.IsAllMissing()) {
+          bldr.AddArray(std::move(merged_array));
+        }
+      });
+    }
+    return std::move(bldr).Build();
+  }
+
   absl::StatusOr<DataSliceImpl> operator()(const DataSliceImpl& lhs,
                                            const DataItem& rhs) const {
     if (lhs.size() == lhs.present_count() || !rhs.has_value()) {
@@ -141,13 +238,138 @@ struct PresenceOrOp {
         bldr.GetMutableAllocationIds().Insert(rhs.allocation_ids());
       }
       const auto& rhs_array = rhs.values<T>();
-      ASSIGN_OR_RETURN(auto merged_array, arolla::DenseArrayPresenceOrOp()(
-                                              &ctx, lhs_array, rhs_array));
-      bldr.AddArray(std::move(merged_array));
+      if constexpr (std::is_trivially_copyable_v<T> &&
+                    !std::is_same_v<T, arolla::Unit>) {
+        bldr.AddArray(MergeTriviallyCopyable(lhs_array, rhs_array));
+      } else {
+        ASSIGN_OR_RETURN(auto merged_array, arolla::DenseArrayPresenceOrOp()(
+                                                &ctx, lhs_array, rhs_array));
+        bldr.AddArray(std::move(merged_array));
+      }
       return absl::OkStatus();
     }));
     return std::move(bldr).Build();
   }
+
+  // Merges the `parts` of the same type into a single array. Each part is an
+  // array together with the rows to take from it; the rows are disjoint. A
+  // single part shares its values buffer with the result.
+  template <class T>
+  static arolla::DenseArray<T> MergeTaken(
+      int64_t size,
+      absl::Span<const std::pair<const arolla::DenseArray<T>*,
+                                 absl::Span<const arolla::bitmap::Word>>>
+          parts) {
+    using ::arolla::bitmap::Word;
+    constexpr int64_t kWordBitCount = arolla::bitmap::kWordBitCount;
+    const int64_t bitmap_size = arolla::bitmap::BitmapSize(size);
+    arolla::Buffer<Word>::Builder bitmap_bldr(bitmap_size);
+    absl::Span<Word> bitmap = bitmap_bldr.GetMutableSpan();
+    std::fill(bitmap.begin(), bitmap.end(), Word{0});
+    auto part_word = [&](const auto& part, int64_t word_id) {
+      return arolla::bitmap::GetWordWithOffset(part.first->bitmap, word_id,
+                                               part.first->bitmap_bit_offset) &
+             part.second[word_id];
+    };
+    auto unite_bitmaps = [&]() {
+      for (const auto& part : parts) {
+        for (int64_t word_id = 0; word_id < bitmap_size; ++word_id) {
+          bitmap[word_id] |= part_word(part, word_id);
+        }
+      }
+      return arolla::DenseArray<T>{parts[0].first->values,
+                                   std::move(bitmap_bldr).Build()};
+    };
+    if constexpr (std::is_same_v<T, arolla::Unit>) {
+      return unite_bitmaps();
+    } else if (parts.size() == 1) {
+      return unite_bitmaps();
+    } else if constexpr (std::is_trivially_copyable_v<T>) {
+      typename arolla::Buffer<T>::Builder values_bldr(size);
+      absl::Span<T> values = values_bldr.GetMutableSpan();
+      for (const auto& part : parts) {
+        absl::Span<const T> part_values = part.first->values.span();
+        for (int64_t word_id = 0; word_id < bitmap_size; ++word_id) {
+          const Word word = part_word(part, word_id);
+          if (word == 0) {
+            continue;
+          }
+          bitmap[word_id] |= word;
+          const int64_t begin = word_id * kWordBitCount;
+          const int64_t count = std::min(kWordBitCount, size - begin);
+          if (word == arolla::bitmap::kFullWord) {
+            std::copy_n(part_values.begin() + begin, count,
+                        values.begin() + begin);
+            continue;
+          }
+          for (int64_t i = 0; i < count; ++i) {
+            if ((word >> i) & 1) {
+              values[begin + i] = part_values[begin + i];
+            }
+          }
+        }
+      }
+      return arolla::DenseArray<T>{std::move(values_bldr).Build(),
+                                   std::move(bitmap_bldr).Build()};
+    } else {
+      arolla::DenseArrayBuilder<T> array_bldr(size);
+      for (const auto& part : parts) {
+        for (int64_t word_id = 0; word_id < bitmap_size; ++word_id) {
+          const Word word = part_word(part, word_id);
+          if (word == 0) {
+            continue;
+          }
+          const int64_t begin = word_id * kWordBitCount;
+          const int64_t count = std::min(kWordBitCount, size - begin);
+          for (int64_t i = 0; i < count; ++i) {
+            if ((word >> i) & 1) {
+              array_bldr.Set(begin + i, part.first->values[begin + i]);
+            }
+          }
+        }
+      }
+      return std::move(array_bldr).Build();
+    }
+  }
+
+  // Merges `lhs` and `rhs` word by word: the bitmaps are united and each value
+  // is selected from `lhs` where it is present, from `rhs` otherwise. Words
+  // fully present in one of the inputs are copied without per-bit selection.
+  template <class T>
+  static arolla::DenseArray<T> MergeTriviallyCopyable(
+      const arolla::DenseArray<T>& lhs, const arolla::DenseArray<T>& rhs) {
+    using ::arolla::bitmap::Word;
+    constexpr int64_t kWordBitCount = arolla::bitmap::kWordBitCount;
+    const int64_t size = lhs.size();
+    const int64_t bitmap_size = arolla::bitmap::BitmapSize(size);
+    absl::Span<const T> lhs_values = lhs.values.span();
+    absl::Span<const T> rhs_values = rhs.values.span();
+    typename arolla::Buffer<T>::Builder values_bldr(size);
+    absl::Span<T> values = values_bldr.GetMutableSpan();
+    arolla::Buffer<Word>::Builder bitmap_bldr(bitmap_size);
+    absl::Span<Word> bitmap = bitmap_bldr.GetMutableSpan();
+    for (int64_t word_id = 0; word_id < bitmap_size; ++word_id) {
+      const Word lhs_word = arolla::bitmap::GetWordWithOffset(
+          lhs.bitmap, word_id, lhs.bitmap_bit_offset);
+      const Word rhs_word = arolla::bitmap::GetWordWithOffset(
+          rhs.bitmap, word_id, rhs.bitmap_bit_offset);
+      bitmap[word_id] = lhs_word | rhs_word;
+      const int64_t begin = word_id * kWordBitCount;
+      const int64_t count = std::min(kWordBitCount, size - begin);
+      if (lhs_word == arolla::bitmap::kFullWord || rhs_word == 0) {
+        std::copy_n(lhs_values.begin() + begin, count, values.begin() + begin);
+      } else if (lhs_word == 0) {
+        std::copy_n(rhs_values.begin() + begin, count, values.begin() + begin);
+      } else {
+        for (int64_t i = begin; i < begin + count; ++i) {
+          values[i] = ((lhs_word >> (i - begin)) & 1) ? lhs_values[i]
+                                                      : rhs_values[i];
+        }
+      }
+    }
+    return arolla::DenseArray<T>{std::move(values_bldr).Build(),
+                                 std::move(bitmap_bldr).Build()};
+  }
 };
 
 }  // namespace koladata::internal
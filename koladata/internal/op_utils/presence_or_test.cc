@@ -15,8 +15,10 @@
 #include "koladata/internal/op_utils/presence_or.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <initializer_list>
 #include <optional>
+#include <utility>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
@@ -79,6 +81,81 @@ TEST(PresenceOrTest, DataSlicePrimitiveValues) {
   }
 }
 
+TEST(PresenceOrTest, DataSliceMultipleWords) {
+  constexpr int64_t kSize = 100;
+  arolla::DenseArrayBuilder<int64_t> l_bldr(kSize + 5);
+  arolla::DenseArrayBuilder<int64_t> r_bldr(kSize + 5);
+  for (int64_t i = 0; i < kSize + 5; ++i) {
+    // The first word of lhs is fully present, the third one fully missing.
+    if (i < 37 || (i >= 69 && i % 3 == 0)) {
+      l_bldr.Set(i, i);
+    }
+    if (i % 2 == 0) {
+      r_bldr.Set(i, -i);
+    }
+  }
+  // Slicing gives a non-zero bitmap bit offset.
+  auto lds = DataSliceImpl::Create(std::move(l_bldr).Build().Slice(5, kSize));
+  auto rds = DataSliceImpl::Create(std::move(r_bldr).Build().Slice(5, kSize));
+
+  ASSERT_OK_AND_ASSIGN(auto res, PresenceOrOp()(lds, rds));
+  ASSERT_EQ(res.size(), kSize);
+  const auto& values = res.values<int64_t>();
+  for (int64_t i = 0; i < kSize; ++i) {
+    const int64_t id = i + 5;
+    if (id < 37 || (id >= 69 && id % 3 == 0)) {
+      EXPECT_EQ(values[i], id) << i;
+    } else if (id % 2 == 0) {
+      EXPECT_EQ(values[i], -id) << i;
+    } else {
+      EXPECT_EQ(values[i], std::nullopt) << i;
+    }
+  }
+}
+
+TEST(PresenceOrTest, MultipleInputs) {
+  {
+    // Single type.
+    auto x = DataSliceImpl::Create(
+        CreateDenseArray<int>({1, std::nullopt, std::nullopt, std::nullopt}));
+    auto y = DataSliceImpl::Create(
+        CreateDenseArray<int>({5, 2, std::nullopt, std::nullopt}));
+    auto z = DataSliceImpl::Create(
+        CreateDenseArray<int>({6, 7, 3, std::nullopt}));
+    ASSERT_OK_AND_ASSIGN(auto res, PresenceOrOp()({x, y, z}));
+    EXPECT_THAT(res.values<int>(), ElementsAre(1, 2, 3, std::nullopt));
+  }
+  {
+    // Mixed types.
+    auto x = DataSliceImpl::Create(
+        CreateDenseArray<int>({1, std::nullopt, std::nullopt, std::nullopt}));
+    auto y = DataSliceImpl::Create(
+        CreateDenseArray<Text>({Text("a"), Text("b"), std::nullopt,
+                                std::nullopt}),
+        CreateDenseArray<int>({std::nullopt, std::nullopt, 2, std::nullopt}));
+    auto z = DataSliceImpl::Create(
+        CreateDenseArray<float>({1.5, 2.5, 3.5, 4.5}));
+    ASSERT_OK_AND_ASSIGN(auto res, PresenceOrOp()({x, y, z}));
+    EXPECT_TRUE(res.is_mixed_dtype());
+    EXPECT_EQ(res[0], DataItem(1));
+    EXPECT_EQ(res[1], DataItem(Text("b")));
+    EXPECT_EQ(res[2], DataItem(2));
+    EXPECT_EQ(res[3], DataItem(4.5f));
+  }
+  {
+    // Empty inputs are skipped.
+    auto x = DataSliceImpl::CreateEmptyAndUnknownType(2);
+    auto y = DataSliceImpl::Create(CreateDenseArray<int>({1, std::nullopt}));
+    ASSERT_OK_AND_ASSIGN(auto res, PresenceOrOp()({x, y, x}));
+    EXPECT_THAT(res.values<int>(), ElementsAre(1, std::nullopt));
+  }
+  EXPECT_THAT(
+      PresenceOrOp()({DataSliceImpl::CreateEmptyAndUnknownType(2),
+                      DataSliceImpl::CreateEmptyAndUnknownType(3)}),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               "coalesce requires input slices to have the same size"));
+}
+
 TEST(PresenceOrTest, EmptyInputs) {
   {
     // Empty and unknown lhs.
@@ -0,0 +1,202 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/printf_template.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <string>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/memory/strings_buffer.h"
+#include "arolla/util/bytes.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+
+std::optional<PrintfTemplate> PrintfTemplate::Parse(absl::string_view format) {
+  PrintfTemplate result;
+  std::string literal;
+  for (size_t i = 0; i < format.size(); ++i) {
+    if (format[i] != '%') {
+      literal.push_back(format[i]);
+      continue;
+    }
+    if (++i == format.size()) {
+      return std::nullopt;
+    }
+    Conversion conversion;
+    switch (format[i]) {
+      case '%':
+        literal.push_back('%');
+        continue;
+      case 's':
+        conversion = Conversion::kString;
+        break;
+      case 'd':
+      case 'i':
+        conversion = Conversion::kInteger;
+        break;
+      case 'v':
+        conversion = Conversion::kAny;
+        break;
+      default:
+        return std::nullopt;
+    }
+    result.literals_.push_back(std::exchange(literal, {}));
+    result.conversions_.push_back(conversion);
+  }
+  result.literals_.push_back(std::move(literal));
+  return result;
+}
+
+template <typename T>
+std::optional<arolla::DenseArray<T>> PrintfTemplate::Format(
+    absl::Span<const Column> args, int64_t size) const {
+  DCHECK_GE(args.size(), arg_count());
+  for (size_t i = 0; i < args.size(); ++i) {
+    // Arolla does not mix strings of different types, even in the arguments
+    // that are not consumed.
+    bool is_string = std::holds_alternative<const arolla::DenseArray<T>*>(
+        args[i]);
+    bool is_integer =
+        std::holds_alternative<const arolla::DenseArray<int32_t>*>(args[i]) ||
+        std::holds_alternative<const arolla::DenseArray<int64_t>*>(args[i]);
+    bool accepted = is_string || is_integer;
+    if (i < conversions_.size()) {
+      switch (conversions_[i]) {
+        case Conversion::kString:
+          accepted = is_string;
+          break;
+        case Conversion::kInteger:
+          accepted = is_integer;
+          break;
+        case Conversion::kAny:
+          break;
+      }
+    }
+    if (!accepted) {
+      return std::nullopt;
+    }
+  }
+
+  std::vector<bool> present(size, true);
+  for (const Column& arg : args) {
+    std::visit(
+        [&](const auto* column) {
+          DCHECK_EQ(column->size(), size);
+          if (column->IsFull()) {
+            return;
+          }
+          for (int64_t i = 0; i < size; ++i) {
+            if (!column->present(i)) {
+              present[i] = false;
+            }
+          }
+        },
+        arg);
+  }
+
+  // The sizes of the rows are computed first, column by column, so that the
+  // result is written into a buffer of the exact size.
+  size_t literals_size = 0;
+  for (const std::string& literal : literals_) {
+    literals_size += literal.size();
+  }
+  arolla::Buffer<arolla::StringsBuffer::Offsets>::Builder offsets_bldr(size);
+  auto offsets = offsets_bldr.GetMutableSpan();
+  for (int64_t i = 0; i < size; ++i) {
+    offsets[i].end = present[i] ? literals_size : 0;
+  }
+  for (size_t arg = 0; arg < conversions_.size(); ++arg) {
+    std::visit(
+        [&](const auto* column) {
+          for (int64_t i = 0; i < size; ++i) {
+            if (present[i]) {
+              offsets[i].end += absl::AlphaNum(column->values[i]).size();
+            }
+          }
+        },
+        args[arg]);
+  }
+  int64_t total_size = 0;
+  for (int64_t i = 0; i < size; ++i) {
+    offsets[i].start = total_size;
+    total_size += offsets[i].end;
+    offsets[i].end = total_size;
+  }
+
+  arolla::Buffer<char>::Builder chars_bldr(total_size);
+  char* chars = chars_bldr.GetMutableSpan().data();
+  std::vector<int64_t> cursors(size);
+  for (int64_t i = 0; i < size; ++i) {
+    cursors[i] = offsets[i].start;
+  }
+  auto write = [&](int64_t i, absl::string_view piece) {
+    std::memcpy(chars + cursors[i], piece.data(), piece.size());
+    cursors[i] += piece.size();
+  };
+  for (size_t arg = 0; arg <= conversions_.size(); ++arg) {
+    if (!literals_[arg].empty()) {
+      for (int64_t i = 0; i < size; ++i) {
+        if (present[i]) {
+          write(i, literals_[arg]);
+        }
+      }
+    }
+    if (arg == conversions_.size()) {
+      break;
+    }
+    std::visit(
+        [&](const auto* column) {
+          for (int64_t i = 0; i < size; ++i) {
+            if (present[i]) {
+              write(i, absl::AlphaNum(column->values[i]).Piece());
+            }
+          }
+        },
+        args[arg]);
+  }
+
+  arolla::bitmap::AlmostFullBuilder bitmap_bldr(size);
+  for (int64_t i = 0; i < size; ++i) {
+    if (!present[i]) {
+      bitmap_bldr.AddMissed(i);
+    }
+  }
+  return arolla::DenseArray<T>{
+      arolla::StringsBuffer(std::move(offsets_bldr).Build(),
+                            std::move(chars_bldr).Build()),
+      std::move(bitmap_bldr).Build()};
+}
+
+template std::optional<arolla::DenseArray<arolla::Text>>
+PrintfTemplate::Format<arolla::Text>(absl::Span<const Column> args,
+                                     int64_t size) const;
+template std::optional<arolla::DenseArray<arolla::Bytes>>
+PrintfTemplate::Format<arolla::Bytes>(absl::Span<const Column> args,
+                                      int64_t size) const;
+
+}  // namespace koladata::internal
@@ -0,0 +1,78 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_PRINTF_TEMPLATE_H_
+#define KOLADATA_INTERNAL_OP_UTILS_PRINTF_TEMPLATE_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <variant>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/bytes.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+
+// A printf format specification parsed once, so that it can be applied to
+// whole columns of arguments.
+//
+// Only the conversions with a single formatting are supported: %s for
+// strings, %d and %i for integers, %v for either, and %%. Flags, width,
+// precision and positional arguments are not.
+class PrintfTemplate {
+ public:
+  // A column of arguments.
+  using Column = std::variant<const arolla::DenseArray<int32_t>*,
+                              const arolla::DenseArray<int64_t>*,
+                              const arolla::DenseArray<arolla::Text>*,
+                              const arolla::DenseArray<arolla::Bytes>*>;
+
+  // Returns std::nullopt if `format` is not supported.
+  static std::optional<PrintfTemplate> Parse(absl::string_view format);
+
+  // Number of arguments consumed by the format.
+  size_t arg_count() const { return conversions_.size(); }
+
+  // Formats the rows of `args`, which must all have the same size and at
+  // least arg_count() columns. A row is missing if any of its arguments is
+  // missing, including the ones not consumed by the format. T (Text or Bytes)
+  // is the type of the result and of the string arguments.
+  //
+  // The result is written into a single characters buffer. Returns
+  // std::nullopt if an argument has a type not accepted by its conversion, or
+  // is a string of a type other than T.
+  template <typename T>
+  std::optional<arolla::DenseArray<T>> Format(absl::Span<const Column> args,
+                                              int64_t size) const;
+
+ private:
+  enum class Conversion { kString, kInteger, kAny };
+
+  PrintfTemplate() = default;
+
+  // literals_[i] precedes conversions_[i]; literals_.back() follows the last
+  // conversion.
+  std::vector<std::string> literals_;
+  std::vector<Conversion> conversions_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_PRINTF_TEMPLATE_H_
@@ -0,0 +1,83 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/printf_template.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/bytes.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::arolla::Bytes;
+using ::arolla::CreateDenseArray;
+using ::arolla::Text;
+using ::testing::ElementsAre;
+using ::testing::Optional;
+
+TEST(PrintfTemplateTest, Parse) {
+  EXPECT_EQ(PrintfTemplate::Parse("foo")->arg_count(), 0);
+  EXPECT_EQ(PrintfTemplate::Parse("%s 100%% %d %i %v")->arg_count(), 4);
+  EXPECT_FALSE(PrintfTemplate::Parse("%5s").has_value());
+  EXPECT_FALSE(PrintfTemplate::Parse("%.2f").has_value());
+  EXPECT_FALSE(PrintfTemplate::Parse("%1$s").has_value());
+  EXPECT_FALSE(PrintfTemplate::Parse("foo %").has_value());
+}
+
+TEST(PrintfTemplateTest, Format) {
+  auto strings = CreateDenseArray<Text>(
+      {Text("a"), std::nullopt, Text(""), Text("bcd")});
+  auto ints = CreateDenseArray<int32_t>({1, 2, -30, std::nullopt});
+  auto longs = CreateDenseArray<int64_t>({int64_t{1} << 40, 0, 5, 6});
+  auto tmpl = PrintfTemplate::Parse("<%s|%d|%v>%%");
+  ASSERT_TRUE(tmpl.has_value());
+  EXPECT_THAT(tmpl->Format<Text>({&strings, &ints, &longs}, 4),
+              Optional(ElementsAre(Text("<a|1|1099511627776>%"), std::nullopt,
+                                   Text("<|-30|5>%"), std::nullopt)));
+
+  // Arguments that are not consumed only affect the presence.
+  auto prefix = PrintfTemplate::Parse("-");
+  ASSERT_TRUE(prefix.has_value());
+  EXPECT_THAT(prefix->Format<Text>({&ints}, 4),
+              Optional(ElementsAre(Text("-"), Text("-"), Text("-"),
+                                   std::nullopt)));
+}
+
+TEST(PrintfTemplateTest, FormatBytes) {
+  auto bytes = CreateDenseArray<Bytes>({Bytes("x"), Bytes("yz")});
+  auto tmpl = PrintfTemplate::Parse("%v!");
+  ASSERT_TRUE(tmpl.has_value());
+  EXPECT_THAT(tmpl->Format<Bytes>({&bytes}, 2),
+              Optional(ElementsAre(Bytes("x!"), Bytes("yz!"))));
+  // The string arguments must have the type of the result.
+  EXPECT_FALSE(tmpl->Format<Text>({&bytes}, 2).has_value());
+}
+
+TEST(PrintfTemplateTest, UnsupportedArgs) {
+  auto strings = CreateDenseArray<Text>({Text("a")});
+  auto ints = CreateDenseArray<int32_t>({1});
+  EXPECT_FALSE(
+      PrintfTemplate::Parse("%d")->Format<Text>({&strings}, 1).has_value());
+  EXPECT_FALSE(
+      PrintfTemplate::Parse("%s")->Format<Text>({&ints}, 1).has_value());
+}
+
+}  // namespace
+}  // namespace koladata::internal
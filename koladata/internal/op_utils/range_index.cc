@@ -0,0 +1,188 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/range_index.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/view_types.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::internal {
+namespace {
+
+template <typename T>
+constexpr bool kIsIntegral =
+    std::is_same_v<T, int> || std::is_same_v<T, int64_t>;
+
+template <typename T>
+constexpr bool kIsNumeric =
+    kIsIntegral<T> || std::is_same_v<T, float> || std::is_same_v<T, double>;
+
+// Bound of a range query, converted to the type of the index.
+struct Bound {
+  enum Kind { kNone, kEmptyRange, kBelowAll, kAboveAll, kValue };
+  Kind kind = kNone;
+  double double_value = 0;
+  int64_t int_value = 0;
+};
+
+absl::StatusOr<Bound> ToBound(const DataItem& item, bool integral_index) {
+  if (!item.has_value()) {
+    return Bound{};
+  }
+  if (item.holds_value<int>() || item.holds_value<int64_t>()) {
+    int64_t v = item.holds_value<int>() ? item.value<int>()
+                                        : item.value<int64_t>();
+    return Bound{Bound::kValue, static_cast<double>(v), v};
+  }
+  if (!item.holds_value<float>() && !item.holds_value<double>()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "range bounds must be numeric, got %v", item));
+  }
+  double v = item.holds_value<float>() ? item.value<float>()
+                                       : item.value<double>();
+  if (std::isnan(v)) {
+    // Nothing compares with NaN, so the range is empty.
+    return Bound{Bound::kEmptyRange};
+  }
+  if (!integral_index) {
+    return Bound{Bound::kValue, v};
+  }
+  // For integers, `x >= v` iff `x >= ceil(v)`, and same for `x < v`.
+  v = std::ceil(v);
+  // 2^63 is exactly representable as double, unlike 2^63 - 1.
+  if (v >= 0x1p63) {
+    return Bound{Bound::kAboveAll};
+  }
+  if (v < -0x1p63) {
+    return Bound{Bound::kBelowAll};
+  }
+  return Bound{Bound::kValue, v, static_cast<int64_t>(v)};
+}
+
+// Returns the index of the first entry with value >= `bound`.
+template <typename T>
+int64_t FirstNotLess(const std::vector<std::pair<T, int64_t>>& entries,
+                     const Bound& bound) {
+  switch (bound.kind) {
+    case Bound::kNone:
+    case Bound::kBelowAll:
+      return 0;
+    case Bound::kEmptyRange:
+    case Bound::kAboveAll:
+      return entries.size();
+    case Bound::kValue:
+      break;
+  }
+  T v;
+  if constexpr (std::is_same_v<T, int64_t>) {
+    v = bound.int_value;
+  } else {
+    v = bound.double_value;
+  }
+  return std::partition_point(entries.begin(), entries.end(),
+                              [&](const auto& e) { return e.first < v; }) -
+         entries.begin();
+}
+
+}  // namespace
+
+absl::StatusOr<RangeIndex> RangeIndex::Create(const DataSliceImpl& values) {
+  bool integral = true;
+  int64_t present_count = 0;
+  RETURN_IF_ERROR(values.VisitValues([&]<class T>(
+                                         const arolla::DenseArray<T>& array)
+                                         -> absl::Status {
+    if constexpr (kIsNumeric<T>) {
+      integral &= kIsIntegral<T>;
+      present_count += array.PresentCount();
+      return absl::OkStatus();
+    } else {
+      if (array.PresentCount() == 0) {
+        return absl::OkStatus();
+      }
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "range index requires numeric values, got %s",
+          arolla::GetQType<T>()->name()));
+    }
+  }));
+  RangeIndex index(values.size());
+  auto build = [&]<class V>(Entries<V>& entries) {
+    entries.reserve(present_count);
+    values.VisitValues([&]<class T>(const arolla::DenseArray<T>& array) {
+      if constexpr (kIsNumeric<T>) {
+        array.ForEachPresent([&](int64_t id, arolla::view_type_t<T> v) {
+          if constexpr (std::is_floating_point_v<T>) {
+            if (std::isnan(v)) {
+              return;
+            }
+          }
+          entries.emplace_back(static_cast<V>(v), id);
+        });
+      }
+    });
+    std::sort(entries.begin(), entries.end());
+  };
+  if (integral) {
+    build(index.entries_.emplace<Entries<int64_t>>());
+  } else {
+    build(index.entries_.emplace<Entries<double>>());
+  }
+  return index;
+}
+
+absl::StatusOr<std::vector<int64_t>> RangeIndex::Find(
+    const DataItem& lower, const DataItem& upper) const {
+  bool integral = std::holds_alternative<Entries<int64_t>>(entries_);
+  ASSIGN_OR_RETURN(Bound lower_bound, ToBound(lower, integral));
+  ASSIGN_OR_RETURN(Bound upper_bound, ToBound(upper, integral));
+  if (lower_bound.kind == Bound::kEmptyRange ||
+      upper_bound.kind == Bound::kEmptyRange) {
+    return std::vector<int64_t>();
+  }
+  return std::visit(
+      [&](const auto& entries) {
+        int64_t begin = FirstNotLess(entries, lower_bound);
+        int64_t end = upper_bound.kind == Bound::kNone
+                          ? entries.size()
+                          : FirstNotLess(entries, upper_bound);
+        std::vector<int64_t> positions;
+        if (begin >= end) {
+          return positions;
+        }
+        positions.reserve(end - begin);
+        for (int64_t i = begin; i < end; ++i) {
+          positions.push_back(entries[i].second);
+        }
+        std::sort(positions.begin(), positions.end());
+        return positions;
+      },
+      entries_);
+}
+
+}  // namespace koladata::internal
@@ -0,0 +1,60 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_RANGE_INDEX_H_
+#define KOLADATA_INTERNAL_OP_UTILS_RANGE_INDEX_H_
+
+#include <cstdint>
+#include <utility>
+#include <variant>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+
+namespace koladata::internal {
+
+// Sorted permutation of the numeric items of `values`, which answers range
+// queries "lower <= value < upper" by binary search in O(log(n) + matches).
+//
+// If all present values are integers (INT32 or INT64), they are compared
+// exactly as int64_t; otherwise all of them are compared as double. NaNs never
+// match.
+class RangeIndex {
+ public:
+  // Builds the index. Returns an error if `values` has non-numeric items.
+  static absl::StatusOr<RangeIndex> Create(const DataSliceImpl& values);
+
+  int64_t size() const { return size_; }
+
+  // Returns the sorted positions of the items in [lower, upper). A missing
+  // bound means no bound. The bounds must be numeric or missing.
+  absl::StatusOr<std::vector<int64_t>> Find(const DataItem& lower,
+                                            const DataItem& upper) const;
+
+ private:
+  template <typename T>
+  using Entries = std::vector<std::pair<T, int64_t>>;
+
+  explicit RangeIndex(int64_t size) : size_(size) {}
+
+  int64_t size_;
+  // (value, position) pairs sorted by value, then by position.
+  std::variant<Entries<int64_t>, Entries<double>> entries_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_RANGE_INDEX_H_
@@ -0,0 +1,111 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/range_index.h"
+
+#include <cmath>
+#include <cstdint>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::arolla::CreateDenseArray;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+
+TEST(RangeIndexTest, Int) {
+  ASSERT_OK_AND_ASSIGN(
+      RangeIndex index,
+      RangeIndex::Create(DataSliceImpl::Create(
+          CreateDenseArray<int>({5, 1, std::nullopt, 3, 1, 7}))));
+  EXPECT_EQ(index.size(), 6);
+  EXPECT_THAT(index.Find(DataItem(1), DataItem(4)),
+              IsOkAndHolds(ElementsAre(1, 3, 4)));
+  EXPECT_THAT(index.Find(DataItem(3), DataItem()),
+              IsOkAndHolds(ElementsAre(0, 3, 5)));
+  EXPECT_THAT(index.Find(DataItem(), DataItem(3)),
+              IsOkAndHolds(ElementsAre(1, 4)));
+  EXPECT_THAT(index.Find(DataItem(), DataItem()),
+              IsOkAndHolds(ElementsAre(0, 1, 3, 4, 5)));
+  EXPECT_THAT(index.Find(DataItem(4), DataItem(4)), IsOkAndHolds(IsEmpty()));
+  EXPECT_THAT(index.Find(DataItem(6), DataItem(2)), IsOkAndHolds(IsEmpty()));
+}
+
+TEST(RangeIndexTest, IntWithFloatBounds) {
+  ASSERT_OK_AND_ASSIGN(
+      RangeIndex index,
+      RangeIndex::Create(DataSliceImpl::Create(
+          CreateDenseArray<int64_t>({5, 1, 3, INT64_MAX}))));
+  EXPECT_THAT(index.Find(DataItem(0.5), DataItem(3.0f)),
+              IsOkAndHolds(ElementsAre(1)));
+  EXPECT_THAT(index.Find(DataItem(1.5), DataItem(5.5)),
+              IsOkAndHolds(ElementsAre(0, 2)));
+  EXPECT_THAT(index.Find(DataItem(4.0), DataItem(1e30)),
+              IsOkAndHolds(ElementsAre(0, 3)));
+  EXPECT_THAT(index.Find(DataItem(-1e30), DataItem(2.0)),
+              IsOkAndHolds(ElementsAre(1)));
+  EXPECT_THAT(index.Find(DataItem(1e30), DataItem()),
+              IsOkAndHolds(IsEmpty()));
+  EXPECT_THAT(index.Find(DataItem(std::nan("")), DataItem()),
+              IsOkAndHolds(IsEmpty()));
+}
+
+TEST(RangeIndexTest, Mixed) {
+  ASSERT_OK_AND_ASSIGN(
+      RangeIndex index,
+      RangeIndex::Create(DataSliceImpl::Create(
+          CreateDenseArray<int>({2, std::nullopt, std::nullopt, 4}),
+          CreateDenseArray<float>({std::nullopt, 2.5f, NAN, std::nullopt}))));
+  EXPECT_THAT(index.Find(DataItem(2), DataItem(3)),
+              IsOkAndHolds(ElementsAre(0, 1)));
+  EXPECT_THAT(index.Find(DataItem(2.6), DataItem()),
+              IsOkAndHolds(ElementsAre(3)));
+}
+
+TEST(RangeIndexTest, Empty) {
+  ASSERT_OK_AND_ASSIGN(
+      RangeIndex index,
+      RangeIndex::Create(DataSliceImpl::CreateEmptyAndUnknownType(3)));
+  EXPECT_EQ(index.size(), 3);
+  EXPECT_THAT(index.Find(DataItem(), DataItem()), IsOkAndHolds(IsEmpty()));
+}
+
+TEST(RangeIndexTest, Errors) {
+  EXPECT_THAT(RangeIndex::Create(DataSliceImpl::Create(
+                  CreateDenseArray<arolla::Text>({arolla::Text("a")}))),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("range index requires numeric values")));
+  ASSERT_OK_AND_ASSIGN(RangeIndex index,
+                       RangeIndex::Create(DataSliceImpl::Create(
+                           CreateDenseArray<int>({1}))));
+  EXPECT_THAT(index.Find(DataItem(arolla::Text("a")), DataItem()),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("range bounds must be numeric")));
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -0,0 +1,247 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_SEGMENTED_REDUCE_H_
+#define KOLADATA_INTERNAL_OP_UTILS_SEGMENTED_REDUCE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+
+namespace koladata::internal {
+
+// Inputs are not split into chunks smaller than this.
+constexpr int64_t kMinSegmentedReduceChunkSize = 1 << 16;
+
+// Reducers of integer values for SegmentedReduce. Sums wrap around on
+// overflow. `kIdentity` is combined in place of the missing values, which
+// keeps the loops over a bitmap word free of branches.
+template <typename T>
+struct SumReducer {
+  static_assert(std::is_integral_v<T>);
+  static constexpr T kIdentity = 0;
+  static T Combine(T a, T b) {
+    using U = std::make_unsigned_t<T>;
+    return static_cast<T>(static_cast<U>(a) + static_cast<U>(b));
+  }
+};
+
+template <typename T>
+struct MinReducer {
+  static_assert(std::is_integral_v<T>);
+  static constexpr T kIdentity = std::numeric_limits<T>::max();
+  static T Combine(T a, T b) { return std::min(a, b); }
+};
+
+template <typename T>
+struct MaxReducer {
+  static_assert(std::is_integral_v<T>);
+  static constexpr T kIdentity = std::numeric_limits<T>::min();
+  static T Combine(T a, T b) { return std::max(a, b); }
+};
+
+namespace segmented_reduce_impl {
+
+using ::arolla::bitmap::Word;
+constexpr int64_t kWordBitCount = arolla::bitmap::kWordBitCount;
+
+// Returns the presence word of `values` holding the row `row`, which must be a
+// multiple of kWordBitCount.
+template <typename T>
+Word PresenceWord(const arolla::DenseArray<T>& values, int64_t row) {
+  return arolla::bitmap::GetWordWithOffset(
+      values.bitmap, row / kWordBitCount, values.bitmap_bit_offset);
+}
+
+// Reduces the rows [begin, end) of `values`. Sets `any_present` if at least
+// one of them is present.
+template <typename Reducer, typename T>
+T ReduceRange(const arolla::DenseArray<T>& values, int64_t begin, int64_t end,
+              bool& any_present) {
+  const T* data = values.values.span().data();
+  T acc = Reducer::kIdentity;
+  if (values.bitmap.empty()) {
+    // A plain loop over the values, which the compiler vectorizes.
+    for (int64_t i = begin; i < end; ++i) {
+      acc = Reducer::Combine(acc, data[i]);
+    }
+    any_present |= end > begin;
+    return acc;
+  }
+  // Rows up to the first word boundary and after the last one are checked one
+  // by one. Tiny groups never reach the word loop.
+  int64_t i = begin;
+  const int64_t aligned_begin = std::min(
+      end, (begin + kWordBitCount - 1) / kWordBitCount * kWordBitCount);
+  for (; i < aligned_begin; ++i) {
+    if (values.present(i)) {
+      acc = Reducer::Combine(acc, data[i]);
+      any_present = true;
+    }
+  }
+  // Full words: present values are selected with a mask instead of a branch
+  // per row.
+  for (; i + kWordBitCount <= end; i += kWordBitCount) {
+    const Word word = PresenceWord(values, i);
+    if (word == 0) {
+      continue;
+    }
+    any_present = true;
+    if (word == ~Word{0}) {
+      for (int64_t j = 0; j < kWordBitCount; ++j) {
+        acc = Reducer::Combine(acc, data[i + j]);
+      }
+    } else {
+      for (int64_t j = 0; j < kWordBitCount; ++j) {
+        acc = Reducer::Combine(
+            acc, (word >> j) & 1 ? data[i + j] : Reducer::kIdentity);
+      }
+    }
+  }
+  for (; i < end; ++i) {
+    if (values.present(i)) {
+      acc = Reducer::Combine(acc, data[i]);
+      any_present = true;
+    }
+  }
+  return acc;
+}
+
+// Calls `fn(group_begin, group_end)` for ranges of consecutive groups of a
+// similar total size, concurrently using `executor`.
+template <typename Fn>
+void ForEachGroupChunk(absl::Span<const int64_t> split_points,
+                       Executor* executor, Fn fn) {
+  const int64_t group_count = split_points.size() - 1;
+  const int64_t size = split_points.back();
+  const int64_t num_chunks =
+      ParallelChunkCount(executor, size, kMinSegmentedReduceChunkSize);
+  if (num_chunks <= 1) {
+    fn(0, group_count);
+    return;
+  }
+  const int64_t chunk_size = (size + num_chunks - 1) / num_chunks;
+  std::vector<int64_t> bounds(num_chunks + 1, group_count);
+  bounds[0] = 0;
+  for (int64_t chunk = 1; chunk < num_chunks; ++chunk) {
+    bounds[chunk] =
+        std::lower_bound(split_points.begin(), split_points.end() - 1,
+                         chunk * chunk_size) -
+        split_points.begin();
+  }
+  // The chunks never fail.
+  ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+    fn(bounds[chunk], bounds[chunk + 1]);
+    return absl::OkStatus();
+  }).IgnoreError();
+}
+
+}  // namespace segmented_reduce_impl
+
+// Reduces the present values of each group of the split points `split_points`
+// with `Reducer`. Groups without present values get `Reducer::kIdentity` if
+// `empty_is_identity` is true (e.g. 0 for sums), and are missing otherwise.
+//
+// Long groups are reduced a bitmap word at a time: full words in a plain loop
+// and partial ones by masking the missing values with the identity, both of
+// which vectorize. Groups are processed concurrently using `executor`.
+template <typename Reducer, typename T>
+arolla::DenseArray<T> SegmentedReduce(const arolla::DenseArray<T>& values,
+                                      absl::Span<const int64_t> split_points,
+                                      bool empty_is_identity,
+                                      Executor* executor) {
+  using segmented_reduce_impl::Word;
+  const int64_t group_count = split_points.size() - 1;
+  typename arolla::Buffer<T>::Builder result_bldr(group_count);
+  absl::Span<T> result = result_bldr.GetMutableSpan();
+  arolla::Buffer<Word>::Builder bitmap_bldr(
+      empty_is_identity ? 0 : arolla::bitmap::BitmapSize(group_count));
+  absl::Span<Word> bitmap = bitmap_bldr.GetMutableSpan();
+  std::fill(bitmap.begin(), bitmap.end(), 0);
+  // Presence is collected per group and packed into the bitmap afterwards, so
+  // that different chunks never write to the same word.
+  std::vector<uint8_t> present(empty_is_identity ? 0 : group_count);
+  segmented_reduce_impl::ForEachGroupChunk(
+      split_points, executor, [&](int64_t group_begin, int64_t group_end) {
+        for (int64_t group = group_begin; group < group_end; ++group) {
+          bool any_present = false;
+          result[group] = segmented_reduce_impl::ReduceRange<Reducer>(
+              values, split_points[group], split_points[group + 1],
+              any_present);
+          if (!empty_is_identity) {
+            present[group] = any_present;
+          }
+        }
+      });
+  if (empty_is_identity) {
+    return arolla::DenseArray<T>{std::move(result_bldr).Build()};
+  }
+  for (int64_t group = 0; group < group_count; ++group) {
+    bitmap[arolla::bitmap::GetWordIndex(group)] |=
+        Word{present[group]} << arolla::bitmap::GetBitIndex(group);
+  }
+  return arolla::DenseArray<T>{std::move(result_bldr).Build(),
+                               std::move(bitmap_bldr).Build()};
+}
+
+// Cumulative reduction of the present values of each group of the split
+// points `split_points` with `Reducer`. The result has the presence of
+// `values`, which shares its bitmap.
+template <typename Reducer, typename T>
+arolla::DenseArray<T> SegmentedCumulativeReduce(
+    const arolla::DenseArray<T>& values, absl::Span<const int64_t> split_points,
+    Executor* executor) {
+  const int64_t size = values.size();
+  typename arolla::Buffer<T>::Builder result_bldr(size);
+  absl::Span<T> result = result_bldr.GetMutableSpan();
+  const T* data = values.values.span().data();
+  const bool all_present = values.bitmap.empty();
+  segmented_reduce_impl::ForEachGroupChunk(
+      split_points, executor, [&](int64_t group_begin, int64_t group_end) {
+        for (int64_t group = group_begin; group < group_end; ++group) {
+          T acc = Reducer::kIdentity;
+          const int64_t end = split_points[group + 1];
+          if (all_present) {
+            for (int64_t i = split_points[group]; i < end; ++i) {
+              acc = Reducer::Combine(acc, data[i]);
+              result[i] = acc;
+            }
+            continue;
+          }
+          for (int64_t i = split_points[group]; i < end; ++i) {
+            // The values of missing rows are unspecified, so they are masked
+            // with the identity; their results are masked by the bitmap.
+            acc = Reducer::Combine(
+                acc, values.present(i) ? data[i] : Reducer::kIdentity);
+            result[i] = acc;
+          }
+        }
+      });
+  return arolla::DenseArray<T>{std::move(result_bldr).Build(), values.bitmap,
+                               values.bitmap_bit_offset};
+}
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_SEGMENTED_REDUCE_H_
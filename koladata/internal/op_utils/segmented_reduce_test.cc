@@ -0,0 +1,137 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/segmented_reduce.h"
+
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/optional_value.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::arolla::CreateDenseArray;
+using ::arolla::DenseArray;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+TEST(SegmentedReduceTest, Sum) {
+  auto values = CreateDenseArray<int>({1, std::nullopt, 3, 4, std::nullopt});
+  std::vector<int64_t> split_points = {0, 2, 2, 4, 5};
+  EXPECT_THAT(SegmentedReduce<SumReducer<int>>(values, split_points,
+                                               /*empty_is_identity=*/true,
+                                               nullptr),
+              ElementsAre(1, 0, 7, 0));
+  // Wraps around on overflow.
+  auto large = CreateDenseArray<int>({std::numeric_limits<int>::max(), 1});
+  EXPECT_THAT(SegmentedReduce<SumReducer<int>>(large, {0, 2}, true, nullptr),
+              ElementsAre(std::numeric_limits<int>::min()));
+}
+
+TEST(SegmentedReduceTest, MinMax) {
+  auto values =
+      CreateDenseArray<int64_t>({5, std::nullopt, -3, 4, std::nullopt});
+  std::vector<int64_t> split_points = {0, 2, 2, 4, 5};
+  EXPECT_THAT(SegmentedReduce<MinReducer<int64_t>>(values, split_points,
+                                                   /*empty_is_identity=*/false,
+                                                   nullptr),
+              ElementsAre(5, std::nullopt, -3, std::nullopt));
+  EXPECT_THAT(SegmentedReduce<MaxReducer<int64_t>>(values, split_points,
+                                                   /*empty_is_identity=*/false,
+                                                   nullptr),
+              ElementsAre(5, std::nullopt, 4, std::nullopt));
+}
+
+TEST(SegmentedReduceTest, CumulativeSum) {
+  auto values = CreateDenseArray<int>({1, std::nullopt, 3, 4, std::nullopt, 6});
+  EXPECT_THAT(
+      SegmentedCumulativeReduce<SumReducer<int>>(values, {0, 3, 6}, nullptr),
+      ElementsAre(1, std::nullopt, 4, 4, std::nullopt, 10));
+}
+
+// Compares with a row-by-row reduction on groups of different sizes, which
+// cover the unaligned ends and the full, partial and empty bitmap words.
+TEST(SegmentedReduceTest, MatchesScalarReduction) {
+  std::vector<arolla::OptionalValue<int64_t>> rows;
+  std::vector<int64_t> split_points = {0};
+  for (int64_t group = 0; group < 3000; ++group) {
+    const int64_t size = group % 5 == 0 ? 1000 + group : group % 70;
+    for (int64_t i = 0; i < size; ++i) {
+      const int64_t row = rows.size();
+      // Dense and sparse runs of rows.
+      if ((row / 200) % 3 == 0 || row % 7 == 3) {
+        rows.push_back((row * 7919) % 20011 - 10000);
+      } else {
+        rows.push_back(std::nullopt);
+      }
+    }
+    split_points.push_back(rows.size());
+  }
+  DenseArray<int64_t> values = CreateDenseArray<int64_t>(rows);
+  // A sliced array has a non-zero bitmap offset.
+  DenseArray<int64_t> sliced = values.Slice(5, values.size() - 5);
+  ThreadPoolExecutor executor(4);
+  for (Executor* e : std::vector<Executor*>{nullptr, &executor}) {
+    auto sum = SegmentedReduce<SumReducer<int64_t>>(values, split_points,
+                                                    true, e);
+    auto min = SegmentedReduce<MinReducer<int64_t>>(values, split_points,
+                                                    false, e);
+    auto cum_sum =
+        SegmentedCumulativeReduce<SumReducer<int64_t>>(values, split_points, e);
+    std::vector<arolla::OptionalValue<int64_t>> expected_sum;
+    std::vector<arolla::OptionalValue<int64_t>> expected_min;
+    std::vector<arolla::OptionalValue<int64_t>> expected_cum_sum;
+    for (int64_t group = 0; group + 1 < split_points.size(); ++group) {
+      int64_t s = 0;
+      std::optional<int64_t> m;
+      for (int64_t i = split_points[group]; i < split_points[group + 1]; ++i) {
+        if (rows[i].present) {
+          s += rows[i].value;
+          m = std::min(m.value_or(rows[i].value), rows[i].value);
+          expected_cum_sum.push_back(s);
+        } else {
+          expected_cum_sum.push_back(std::nullopt);
+        }
+      }
+      expected_sum.push_back(s);
+      expected_min.push_back(m.has_value() ? arolla::OptionalValue<int64_t>(*m)
+                                           : std::nullopt);
+    }
+    EXPECT_THAT(sum, ElementsAreArray(expected_sum));
+    EXPECT_THAT(min, ElementsAreArray(expected_min));
+    EXPECT_THAT(cum_sum, ElementsAreArray(expected_cum_sum));
+
+    std::vector<int64_t> sliced_split_points = {0, 100, 4000, sliced.size()};
+    auto sliced_sum = SegmentedReduce<SumReducer<int64_t>>(
+        sliced, sliced_split_points, true, e);
+    for (int64_t group = 0; group < 3; ++group) {
+      int64_t s = 0;
+      for (int64_t i = sliced_split_points[group];
+           i < sliced_split_points[group + 1]; ++i) {
+        s += rows[i + 5].present ? rows[i + 5].value : 0;
+      }
+      EXPECT_EQ(sliced_sum.values[group], s) << group;
+    }
+  }
+}
+
+}  // namespace
+}  // namespace koladata::internal
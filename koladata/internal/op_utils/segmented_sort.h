@@ -0,0 +1,385 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_SEGMENTED_SORT_H_
+#define KOLADATA_INTERNAL_OP_UTILS_SEGMENTED_SORT_H_
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+
+namespace koladata::internal {
+
+// Concurrent tasks get groups with at least this number of rows in total.
+constexpr int64_t kMinSegmentedSortChunkSize = 1 << 14;
+
+// Present row of a group, as produced by SegmentedSort.
+struct SegmentedSortEntry {
+  // Order-preserving encodings of the value and the tie breaker.
+  uint64_t key;
+  uint64_t tie;
+  // Position of the row in the input.
+  int64_t row;
+};
+
+namespace segmented_sort_impl {
+
+// Groups smaller than this are sorted with std::sort.
+constexpr size_t kMinRadixSortSize = 256;
+
+// Returns an unsigned integer with the same order as `value`. Zeros of both
+// signs are mapped to the same key. Must not be called for NaNs.
+template <typename T>
+uint64_t OrderedKey(T value) {
+  constexpr uint64_t kSignBit = uint64_t{1} << 63;
+  if constexpr (std::is_floating_point_v<T>) {
+    // The conversion to double preserves the order of floats.
+    double v = value == 0 ? 0.0 : static_cast<double>(value);
+    uint64_t bits = std::bit_cast<uint64_t>(v);
+    return (bits & kSignBit) ? ~bits : bits | kSignBit;
+  } else {
+    static_assert(std::is_integral_v<T>);
+    return static_cast<uint64_t>(static_cast<int64_t>(value)) ^ kSignBit;
+  }
+}
+
+// Stable LSD radix sort of `entries` by the 64-bit value returned by
+// `get_key`, one byte per pass. Passes where all the entries have the same
+// byte are skipped. `scratch` is used as a temporary buffer.
+template <typename GetKey>
+void RadixSort(std::vector<SegmentedSortEntry>& entries,
+               std::vector<SegmentedSortEntry>& scratch,
+               const GetKey& get_key) {
+  constexpr int kPasses = sizeof(uint64_t);
+  std::array<std::array<size_t, 256>, kPasses> counts{};
+  for (const SegmentedSortEntry& entry : entries) {
+    uint64_t key = get_key(entry);
+    for (int pass = 0; pass < kPasses; ++pass) {
+      ++counts[pass][(key >> (8 * pass)) & 0xff];
+    }
+  }
+  scratch.resize(entries.size());
+  for (int pass = 0; pass < kPasses; ++pass) {
+    std::array<size_t, 256>& count = counts[pass];
+    uint64_t first_byte = (get_key(entries[0]) >> (8 * pass)) & 0xff;
+    if (count[first_byte] == entries.size()) {
+      continue;
+    }
+    size_t offset = 0;
+    for (size_t& c : count) {
+      offset += std::exchange(c, offset);
+    }
+    for (const SegmentedSortEntry& entry : entries) {
+      scratch[count[(get_key(entry) >> (8 * pass)) & 0xff]++] = entry;
+    }
+    entries.swap(scratch);
+  }
+}
+
+// Sorts `entries` (initially ordered by row) by (key, tie, row).
+inline void SortEntries(std::vector<SegmentedSortEntry>& entries,
+                        std::vector<SegmentedSortEntry>& scratch,
+                        bool has_tie_breaker) {
+  if (entries.size() < kMinRadixSortSize) {
+    std::sort(entries.begin(), entries.end(),
+              [](const SegmentedSortEntry& a, const SegmentedSortEntry& b) {
+                return std::tie(a.key, a.tie, a.row) <
+                       std::tie(b.key, b.tie, b.row);
+              });
+    return;
+  }
+  if (has_tie_breaker) {
+    RadixSort(entries, scratch,
+              [](const SegmentedSortEntry& e) { return e.tie; });
+  }
+  RadixSort(entries, scratch,
+            [](const SegmentedSortEntry& e) { return e.key; });
+}
+
+// Splits the groups of `split_points` into ranges of consecutive groups with
+// about the same number of rows, one range per concurrent task. Returns the
+// bounds of the ranges: range `i` is [bounds[i], bounds[i + 1]).
+inline std::vector<int64_t> GroupChunkBounds(
+    absl::Span<const int64_t> split_points, Executor* executor) {
+  const int64_t group_count = split_points.size() - 1;
+  const int64_t size = split_points.back();
+  const int64_t num_chunks =
+      ParallelChunkCount(executor, size, kMinSegmentedSortChunkSize);
+  const int64_t chunk_size = (size + num_chunks - 1) / num_chunks;
+  std::vector<int64_t> bounds(num_chunks + 1, group_count);
+  bounds[0] = 0;
+  for (int64_t chunk = 1; chunk < num_chunks; ++chunk) {
+    bounds[chunk] = std::lower_bound(split_points.begin(),
+                                     split_points.end() - 1,
+                                     chunk * chunk_size) -
+                    split_points.begin();
+  }
+  return bounds;
+}
+
+// Returns the number of rows to select from `group` given the `k` argument of
+// SegmentedTopK.
+inline int64_t GroupK(const arolla::DenseArray<int64_t>& k, int64_t group) {
+  return k.present(group) ? std::max<int64_t>(k.values[group], 0) : 0;
+}
+
+}  // namespace segmented_sort_impl
+
+// Sorts the present rows of `values` within each group of the split points
+// `split_points` by (value, tie_breaker, row), and calls
+// `fn(group, sorted_entries)` for every group. If `descending` is true, values
+// are in descending order, but ties are still broken in ascending order. If
+// `tie_breaker` is provided, it must be present for all the present `values`.
+//
+// Values must be integral or floating point without NaNs. Zeros of both signs
+// are equal. Large groups are sorted with a radix sort, small ones with
+// std::sort. If `executor` is provided, consecutive groups are split into
+// chunks that are sorted concurrently, so `fn` must be thread-safe for
+// different groups.
+template <typename T, typename Fn>
+void SegmentedSort(const arolla::DenseArray<T>& values,
+                   const arolla::DenseArray<int64_t>* tie_breaker,
+                   absl::Span<const int64_t> split_points, bool descending,
+                   Executor* executor, const Fn& fn) {
+  DCHECK(!split_points.empty());
+  DCHECK_EQ(split_points.back(), values.size());
+  const std::vector<int64_t> chunk_groups =
+      segmented_sort_impl::GroupChunkBounds(split_points, executor);
+  // The chunks never fail.
+  ParallelFor(
+      executor, chunk_groups.size() - 1,
+      [&](int64_t chunk) -> absl::Status {
+        std::vector<SegmentedSortEntry> entries;
+        std::vector<SegmentedSortEntry> scratch;
+        for (int64_t group = chunk_groups[chunk];
+             group < chunk_groups[chunk + 1]; ++group) {
+          entries.clear();
+          for (int64_t row = split_points[group];
+               row < split_points[group + 1]; ++row) {
+            if (!values.present(row)) {
+              continue;
+            }
+            DCHECK(tie_breaker == nullptr || tie_breaker->present(row));
+            uint64_t key = segmented_sort_impl::OrderedKey(values.values[row]);
+            entries.push_back(
+                {.key = descending ? ~key : key,
+                 .tie = tie_breaker == nullptr
+                            ? 0
+                            : segmented_sort_impl::OrderedKey(
+                                  tie_breaker->values[row]),
+                 .row = row});
+          }
+          segmented_sort_impl::SortEntries(entries, scratch,
+                                           tie_breaker != nullptr);
+          fn(group, absl::MakeConstSpan(entries));
+        }
+        return absl::OkStatus();
+      })
+      .IgnoreError();
+}
+
+// Returns the ordinal ranks of `values` within the groups of `split_points`:
+// the positions of the rows in the order of SegmentedSort. Missing values get
+// missing ranks.
+template <typename T>
+arolla::DenseArray<int64_t> SegmentedOrdinalRank(
+    const arolla::DenseArray<T>& values,
+    const arolla::DenseArray<int64_t>* tie_breaker,
+    absl::Span<const int64_t> split_points, bool descending,
+    Executor* executor) {
+  arolla::Buffer<int64_t>::Builder ranks_bldr(values.size());
+  absl::Span<int64_t> ranks = ranks_bldr.GetMutableSpan();
+  std::fill(ranks.begin(), ranks.end(), 0);
+  SegmentedSort(values, tie_breaker, split_points, descending, executor,
+                [&](int64_t, absl::Span<const SegmentedSortEntry> entries) {
+                  for (size_t i = 0; i < entries.size(); ++i) {
+                    ranks[entries[i].row] = i;
+                  }
+                });
+  return {std::move(ranks_bldr).Build(), values.bitmap,
+          values.bitmap_bit_offset};
+}
+
+// Returns the dense ranks of `values` within the groups of `split_points`:
+// equal values get the same rank, and the ranks of consecutive distinct values
+// differ by one. Missing values get missing ranks.
+template <typename T>
+arolla::DenseArray<int64_t> SegmentedDenseRank(
+    const arolla::DenseArray<T>& values,
+    absl::Span<const int64_t> split_points, bool descending,
+    Executor* executor) {
+  arolla::Buffer<int64_t>::Builder ranks_bldr(values.size());
+  absl::Span<int64_t> ranks = ranks_bldr.GetMutableSpan();
+  std::fill(ranks.begin(), ranks.end(), 0);
+  SegmentedSort(values, /*tie_breaker=*/nullptr, split_points, descending,
+                executor,
+                [&](int64_t, absl::Span<const SegmentedSortEntry> entries) {
+                  int64_t rank = 0;
+                  for (size_t i = 0; i < entries.size(); ++i) {
+                    rank += i > 0 && entries[i].key != entries[i - 1].key;
+                    ranks[entries[i].row] = rank;
+                  }
+                });
+  return {std::move(ranks_bldr).Build(), values.bitmap,
+          values.bitmap_bit_offset};
+}
+
+// Result of SegmentedTopK.
+struct SegmentedTopKResult {
+  // Positions of the selected rows within their groups, in the sorted order.
+  arolla::DenseArray<int64_t> positions;
+  // Split points of `positions`, one group per input group.
+  arolla::DenseArray<int64_t> split_points;
+};
+
+// Returns the first `k[group]` present rows of each group of `split_points` in
+// the order of SegmentedOrdinalRank without a tie breaker, i.e. the rows with
+// ordinal ranks below `k[group]`. Missing and negative `k` select no rows. NaNs
+// are ordered after all the other values, as in kde.core.ordinal_rank.
+//
+// Unlike SegmentedSort, the groups are not sorted completely: the `k` first
+// rows are found with std::nth_element and only they are sorted. Groups are
+// processed concurrently using `executor`.
+template <typename T>
+SegmentedTopKResult SegmentedTopK(const arolla::DenseArray<T>& values,
+                                  absl::Span<const int64_t> split_points,
+                                  const arolla::DenseArray<int64_t>& k,
+                                  bool descending, Executor* executor) {
+  DCHECK(!split_points.empty());
+  DCHECK_EQ(split_points.back(), values.size());
+  DCHECK_EQ(k.size() + 1, split_points.size());
+  const int64_t group_count = split_points.size() - 1;
+  const std::vector<int64_t> chunk_groups =
+      segmented_sort_impl::GroupChunkBounds(split_points, executor);
+  const int64_t num_chunks = chunk_groups.size() - 1;
+  arolla::Buffer<int64_t>::Builder split_points_bldr(group_count + 1);
+  absl::Span<int64_t> result_split_points =
+      split_points_bldr.GetMutableSpan();
+  result_split_points[0] = 0;
+  std::vector<std::vector<int64_t>> chunk_positions(num_chunks);
+  // The chunks never fail.
+  ParallelFor(
+      executor, num_chunks,
+      [&](int64_t chunk) -> absl::Status {
+        // (key, row) pairs, ordered as in SegmentedSort.
+        std::vector<std::pair<uint64_t, int64_t>> entries;
+        std::vector<int64_t>& positions = chunk_positions[chunk];
+        for (int64_t group = chunk_groups[chunk];
+             group < chunk_groups[chunk + 1]; ++group) {
+          const int64_t group_k = segmented_sort_impl::GroupK(k, group);
+          entries.clear();
+          for (int64_t row = split_points[group];
+               group_k > 0 && row < split_points[group + 1]; ++row) {
+            if (!values.present(row)) {
+              continue;
+            }
+            if constexpr (std::is_floating_point_v<T>) {
+              // No other floating point value gets the largest key, in either
+              // order.
+              if (std::isnan(values.values[row])) {
+                entries.emplace_back(~uint64_t{0}, row);
+                continue;
+              }
+            }
+            uint64_t key = segmented_sort_impl::OrderedKey(values.values[row]);
+            entries.emplace_back(descending ? ~key : key, row);
+          }
+          const int64_t n =
+              std::min<int64_t>(group_k, static_cast<int64_t>(entries.size()));
+          if (n < static_cast<int64_t>(entries.size())) {
+            std::nth_element(entries.begin(), entries.begin() + n,
+                             entries.end());
+          }
+          std::sort(entries.begin(), entries.begin() + n);
+          for (int64_t i = 0; i < n; ++i) {
+            positions.push_back(entries[i].second - split_points[group]);
+          }
+          result_split_points[group + 1] = n;
+        }
+        return absl::OkStatus();
+      })
+      .IgnoreError();
+  for (int64_t group = 0; group < group_count; ++group) {
+    result_split_points[group + 1] += result_split_points[group];
+  }
+  arolla::Buffer<int64_t>::Builder positions_bldr(
+      result_split_points[group_count]);
+  absl::Span<int64_t> result_positions = positions_bldr.GetMutableSpan();
+  int64_t offset = 0;
+  for (const std::vector<int64_t>& positions : chunk_positions) {
+    std::copy(positions.begin(), positions.end(),
+              result_positions.begin() + offset);
+    offset += positions.size();
+  }
+  return {.positions = {std::move(positions_bldr).Build()},
+          .split_points = {std::move(split_points_bldr).Build()}};
+}
+
+// Same as SegmentedTopK, but takes precomputed ordinal ranks of the rows within
+// their groups (e.g. from kde.core.ordinal_rank) instead of the values.
+inline SegmentedTopKResult SegmentedTopKFromRanks(
+    const arolla::DenseArray<int64_t>& ranks,
+    absl::Span<const int64_t> split_points,
+    const arolla::DenseArray<int64_t>& k) {
+  DCHECK(!split_points.empty());
+  DCHECK_EQ(split_points.back(), ranks.size());
+  DCHECK_EQ(k.size() + 1, split_points.size());
+  const int64_t group_count = split_points.size() - 1;
+  arolla::Buffer<int64_t>::Builder split_points_bldr(group_count + 1);
+  absl::Span<int64_t> result_split_points =
+      split_points_bldr.GetMutableSpan();
+  result_split_points[0] = 0;
+  for (int64_t group = 0; group < group_count; ++group) {
+    const int64_t group_k = segmented_sort_impl::GroupK(k, group);
+    int64_t n = 0;
+    for (int64_t row = split_points[group]; row < split_points[group + 1];
+         ++row) {
+      n += ranks.present(row) && ranks.values[row] < group_k;
+    }
+    result_split_points[group + 1] = result_split_points[group] + n;
+  }
+  arolla::Buffer<int64_t>::Builder positions_bldr(
+      result_split_points[group_count]);
+  absl::Span<int64_t> result_positions = positions_bldr.GetMutableSpan();
+  for (int64_t group = 0; group < group_count; ++group) {
+    const int64_t group_k = segmented_sort_impl::GroupK(k, group);
+    for (int64_t row = split_points[group]; row < split_points[group + 1];
+         ++row) {
+      if (ranks.present(row) && ranks.values[row] < group_k) {
+        result_positions[result_split_points[group] + ranks.values[row]] =
+            row - split_points[group];
+      }
+    }
+  }
+  return {.positions = {std::move(positions_bldr).Build()},
+          .split_points = {std::move(split_points_bldr).Build()}};
+}
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_SEGMENTED_SORT_H_
@@ -0,0 +1,197 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/segmented_sort.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/optional_value.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::arolla::CreateDenseArray;
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+TEST(SegmentedSortTest, OrdinalRank) {
+  auto values = CreateDenseArray<int>({0, 3, std::nullopt, 6, 5, std::nullopt,
+                                       2, 1});
+  std::vector<int64_t> split_points = {0, 4, 8};
+  EXPECT_THAT(SegmentedOrdinalRank(values, nullptr, split_points,
+                                   /*descending=*/false, nullptr),
+              ElementsAre(0, 1, std::nullopt, 2, 2, std::nullopt, 1, 0));
+  EXPECT_THAT(SegmentedOrdinalRank(values, nullptr, split_points,
+                                   /*descending=*/true, nullptr),
+              ElementsAre(2, 1, std::nullopt, 0, 0, std::nullopt, 1, 2));
+}
+
+TEST(SegmentedSortTest, TieBreaker) {
+  auto values = CreateDenseArray<int64_t>({1, 1, 1, 0});
+  auto tie_breaker = CreateDenseArray<int64_t>({2, -1, 2, 5});
+  std::vector<int64_t> split_points = {0, 4};
+  // Ties are broken by the tie breaker, and then by the position.
+  EXPECT_THAT(SegmentedOrdinalRank(values, &tie_breaker, split_points,
+                                   /*descending=*/false, nullptr),
+              ElementsAre(2, 1, 3, 0));
+  // The tie breaker is ascending even for descending values.
+  EXPECT_THAT(SegmentedOrdinalRank(values, &tie_breaker, split_points,
+                                   /*descending=*/true, nullptr),
+              ElementsAre(1, 0, 2, 3));
+}
+
+TEST(SegmentedSortTest, DenseRank) {
+  auto values = CreateDenseArray<float>({4, 3, std::nullopt, 3, 0.0f, -0.0f,
+                                         -1.5f});
+  std::vector<int64_t> split_points = {0, 4, 7};
+  EXPECT_THAT(SegmentedDenseRank(values, split_points, /*descending=*/false,
+                                 nullptr),
+              ElementsAre(1, 0, std::nullopt, 0, 1, 1, 0));
+  EXPECT_THAT(SegmentedDenseRank(values, split_points, /*descending=*/true,
+                                 nullptr),
+              ElementsAre(0, 1, std::nullopt, 1, 0, 0, 1));
+}
+
+TEST(SegmentedSortTest, LargeGroups) {
+  // Groups of different sizes, so that both radix sort and std::sort are
+  // used, split into many chunks.
+  std::vector<int64_t> split_points = {0};
+  for (int64_t size = 1; split_points.back() < 5 * kMinSegmentedSortChunkSize;
+       size = size * 3 % 2000 + 1) {
+    split_points.push_back(split_points.back() + size);
+  }
+  const int64_t total_size = split_points.back();
+  arolla::DenseArrayBuilder<double> values_bldr(total_size);
+  arolla::DenseArrayBuilder<int64_t> tie_breaker_bldr(total_size);
+  for (int64_t i = 0; i < total_size; ++i) {
+    if (i % 11 != 0) {
+      values_bldr.Set(i, (i * 7919) % 101 - 50.5);
+    }
+    tie_breaker_bldr.Set(i, (i * 31) % 7 - 3);
+  }
+  auto values = std::move(values_bldr).Build();
+  auto tie_breaker = std::move(tie_breaker_bldr).Build();
+
+  for (bool descending : {false, true}) {
+    std::vector<arolla::OptionalValue<int64_t>> expected(total_size);
+    for (int64_t g = 0; g + 1 < split_points.size(); ++g) {
+      std::vector<int64_t> rows;
+      for (int64_t i = split_points[g]; i < split_points[g + 1]; ++i) {
+        if (values.present(i)) {
+          rows.push_back(i);
+        }
+      }
+      std::sort(rows.begin(), rows.end(), [&](int64_t a, int64_t b) {
+        double va = descending ? -values.values[a] : values.values[a];
+        double vb = descending ? -values.values[b] : values.values[b];
+        return std::tie(va, tie_breaker.values[a], a) <
+               std::tie(vb, tie_breaker.values[b], b);
+      });
+      for (int64_t j = 0; j < rows.size(); ++j) {
+        expected[rows[j]] = j;
+      }
+    }
+    auto sequential = SegmentedOrdinalRank(values, &tie_breaker, split_points,
+                                           descending, nullptr);
+    EXPECT_THAT(sequential, ElementsAreArray(expected));
+    ThreadPoolExecutor executor(4);
+    EXPECT_THAT(SegmentedOrdinalRank(values, &tie_breaker, split_points,
+                                     descending, &executor),
+                ElementsAreArray(expected));
+    EXPECT_THAT(
+        SegmentedDenseRank(values, split_points, descending, &executor),
+        ElementsAreArray(
+            SegmentedDenseRank(values, split_points, descending, nullptr)));
+  }
+}
+
+TEST(SegmentedSortTest, TopK) {
+  auto values = CreateDenseArray<float>(
+      {0, 3, std::nullopt, 6, 5, NAN, 2, 1, 7, 7, 4});
+  std::vector<int64_t> split_points = {0, 4, 8, 8, 11};
+  auto k = CreateDenseArray<int64_t>({2, 5, 1, std::nullopt});
+  auto top = SegmentedTopK(values, split_points, k, /*descending=*/true,
+                           nullptr);
+  EXPECT_THAT(top.split_points, ElementsAre(0, 2, 6, 6, 6));
+  // NaNs are the last in either order.
+  EXPECT_THAT(top.positions, ElementsAre(3, 1, 0, 2, 3, 1));
+  top = SegmentedTopK(values, split_points, CreateDenseArray<int64_t>(
+                                                {1, -1, 1, 2}),
+                      /*descending=*/false, nullptr);
+  EXPECT_THAT(top.split_points, ElementsAre(0, 1, 1, 1, 3));
+  // Ties are broken by the position.
+  EXPECT_THAT(top.positions, ElementsAre(0, 2, 0));
+}
+
+TEST(SegmentedSortTest, TopKFromRanks) {
+  auto ranks = CreateDenseArray<int64_t>({0, 1, std::nullopt, 2, 2,
+                                          std::nullopt, 1, 0});
+  std::vector<int64_t> split_points = {0, 4, 8};
+  auto top = SegmentedTopKFromRanks(ranks, split_points,
+                                    CreateDenseArray<int64_t>({2, 5}));
+  EXPECT_THAT(top.split_points, ElementsAre(0, 2, 5));
+  EXPECT_THAT(top.positions, ElementsAre(0, 1, 3, 2, 0));
+}
+
+TEST(SegmentedSortTest, LargeTopK) {
+  std::vector<int64_t> split_points = {0};
+  for (int64_t size = 1; split_points.back() < 5 * kMinSegmentedSortChunkSize;
+       size = size * 3 % 2000 + 1) {
+    split_points.push_back(split_points.back() + size);
+  }
+  const int64_t total_size = split_points.back();
+  const int64_t group_count = split_points.size() - 1;
+  arolla::DenseArrayBuilder<int64_t> values_bldr(total_size);
+  for (int64_t i = 0; i < total_size; ++i) {
+    if (i % 11 != 0) {
+      values_bldr.Set(i, (i * 7919) % 101 - 50);
+    }
+  }
+  auto values = std::move(values_bldr).Build();
+  arolla::DenseArrayBuilder<int64_t> k_bldr(group_count);
+  for (int64_t g = 0; g < group_count; ++g) {
+    k_bldr.Set(g, g % 13);
+  }
+  auto k = std::move(k_bldr).Build();
+
+  for (bool descending : {false, true}) {
+    auto ranks = SegmentedOrdinalRank(values, nullptr, split_points,
+                                      descending, nullptr);
+    auto expected = SegmentedTopKFromRanks(ranks, split_points, k);
+    auto sequential =
+        SegmentedTopK(values, split_points, k, descending, nullptr);
+    EXPECT_THAT(sequential.split_points,
+                ElementsAreArray(expected.split_points));
+    EXPECT_THAT(sequential.positions, ElementsAreArray(expected.positions));
+    ThreadPoolExecutor executor(4);
+    auto parallel =
+        SegmentedTopK(values, split_points, k, descending, &executor);
+    EXPECT_THAT(parallel.split_points,
+                ElementsAreArray(expected.split_points));
+    EXPECT_THAT(parallel.positions, ElementsAreArray(expected.positions));
+  }
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -17,7 +17,6 @@
 #include <algorithm>
 #include <cstdint>
 #include <iterator>
-#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -27,6 +26,7 @@
 #include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/op_utils/gather.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/edge.h"
 #include "arolla/dense_array/ops/dense_group_ops.h"
@@ -155,13 +155,11 @@ absl::StatusOr<SelectOp::Result<DataSliceImpl>> SelectOp::operator()(
   builder.GetMutableAllocationIds().Insert(ds_impl.allocation_ids());
 
   DenseArray<int64_t> present_indexes =
-      DenseArrayPresentIndicesOp()(&ctx, presence_mask_array);
+      ParallelPresentIndices(presence_mask_array, executor_);
 
   RETURN_IF_ERROR(ds_impl.VisitValues([&](const auto& array) -> absl::Status {
-    using T = typename std::decay_t<decltype(array)>::base_type;
     // Gets elements in `array` at the positions from `present_indexes`.
-    DenseArray<T> res = DenseArrayAtOp()(&ctx, array, present_indexes);
-    builder.AddArray(std::move(res));
+    builder.AddArray(ParallelGather(array, present_indexes, executor_));
     return absl::OkStatus();
   }));
 
@@ -21,13 +21,21 @@
 #include "absl/status/statusor.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
 #include "arolla/jagged_shape/dense_array/jagged_shape.h"
 
 namespace koladata::internal {
 
 // Selects elements in the first argument if the filter mask is present and
 // filters out missing items.
+//
+// If `executor` is provided, the values of large slices are compressed in
+// word-aligned ranges concurrently. The output offset of each range is
+// computed by a prefix sum over the filter, so the result is the same as for
+// the sequential version.
 struct SelectOp {
+  explicit SelectOp(Executor* executor = nullptr) : executor_(executor) {}
+
   template <typename T>
   struct Result {
     T data_slice_impl;
@@ -54,6 +62,9 @@ struct SelectOp {
       const DataItem& ds_impl, const arolla::JaggedDenseArrayShape& ds_shape,
       const DataSliceImpl& filter,
       const arolla::JaggedDenseArrayShape& filter_shape) const;
+
+ private:
+  Executor* executor_;
 };
 
 }  // namespace koladata::internal
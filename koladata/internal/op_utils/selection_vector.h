@@ -0,0 +1,130 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_SELECTION_VECTOR_H_
+#define KOLADATA_INTERNAL_OP_UTILS_SELECTION_VECTOR_H_
+
+#include <cstdint>
+#include <optional>
+#include <type_traits>
+#include <utility>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/internal/op_utils/gather.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/unit.h"
+
+namespace koladata::internal {
+
+// Lazy result of a sequence of row selections over a flat DataSliceImpl:
+// the source slice together with the indices of the selected rows. Chained
+// selections only compose the int64 index arrays, and the source values are
+// gathered once, in Materialize(), so that e.g. a select followed by an at
+// does not build the intermediate DataSliceImpl.
+//
+// It is a helper for C++ code that chains such steps itself (e.g.
+// kde.logical._lazy_cond). The DataSlice operators (kd.select, kd.at,
+// kd.reverse_select, kd.collapse) neither accept nor return it: every
+// DataSlice holds a materialized DataSliceImpl.
+class SelectionVector {
+ public:
+  // Selects all the rows of `source`.
+  explicit SelectionVector(DataSliceImpl source)
+      : source_(std::move(source)) {}
+
+  // Selects the rows of `source` at `indices`. Missing and out-of-range
+  // indices select missing rows.
+  SelectionVector(DataSliceImpl source, arolla::DenseArray<int64_t> indices)
+      : source_(std::move(source)), indices_(std::move(indices)) {}
+
+  // Returns the number of selected rows.
+  int64_t size() const {
+    return indices_.has_value() ? indices_->size() : source_.size();
+  }
+
+  const DataSliceImpl& source() const { return source_; }
+
+  // Keeps only the selected rows for which `mask` is present, like SelectOp
+  // on a flat slice.
+  absl::StatusOr<SelectionVector> Select(
+      const arolla::DenseArray<arolla::Unit>& mask,
+      Executor* executor = nullptr) const {
+    if (mask.size() != size()) {
+      return absl::InvalidArgumentError(
+          "mask must have the same size as the selection");
+    }
+    return At(ParallelPresentIndices(mask, executor), executor);
+  }
+
+  // Selects the rows at `positions` among the selected rows, like AtOp with
+  // a scalar edge.
+  SelectionVector At(const arolla::DenseArray<int64_t>& positions,
+                     Executor* executor = nullptr) const {
+    if (!indices_.has_value()) {
+      return SelectionVector(source_, positions);
+    }
+    return SelectionVector(source_,
+                           ParallelGather(*indices_, positions, executor));
+  }
+
+  // Returns the selected rows of the source.
+  DataSliceImpl Materialize(Executor* executor = nullptr) const {
+    if (!indices_.has_value()) {
+      return source_;
+    }
+    if (source_.is_empty_and_unknown()) {
+      return DataSliceImpl::CreateEmptyAndUnknownType(indices_->size());
+    }
+    DataSliceImpl::Builder builder(indices_->size());
+    source_.VisitValues([&](const auto& array) {
+      auto values = ParallelGather(array, *indices_, executor);
+      if constexpr (std::is_same_v<decltype(values), ObjectIdArray>) {
+        AddAllocationIds(values, builder.GetMutableAllocationIds());
+      }
+      builder.AddArray(std::move(values));
+    });
+    return std::move(builder).Build();
+  }
+
+ private:
+  // Adds the allocation ids of the selected `objects`, so that a selection of
+  // a few rows doesn't keep all the allocation ids of the source.
+  void AddAllocationIds(const ObjectIdArray& objects,
+                        AllocationIdSet& allocation_ids) const {
+    const AllocationIdSet& source_ids = source_.allocation_ids();
+    if (source_ids.size() + source_ids.contains_small_allocation_id() <= 1) {
+      // A single allocation (or only small ones): nothing to filter.
+      if (!objects.IsAllMissing()) {
+        allocation_ids.Insert(source_ids);
+      }
+      return;
+    }
+    objects.ForEachPresent([&](int64_t, ObjectId id) {
+      allocation_ids.Insert(AllocationId(id));
+    });
+  }
+
+  DataSliceImpl source_;
+  // nullopt means that all the rows are selected.
+  std::optional<arolla::DenseArray<int64_t>> indices_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_SELECTION_VECTOR_H_
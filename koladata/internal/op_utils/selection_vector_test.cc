@@ -0,0 +1,119 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/selection_vector.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
+#include "arolla/util/unit.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::arolla::CreateDenseArray;
+using ::arolla::kMissing;
+using ::arolla::kPresent;
+using ::arolla::Text;
+using ::arolla::Unit;
+using ::testing::ElementsAre;
+
+TEST(SelectionVectorTest, Identity) {
+  auto ds = DataSliceImpl::Create(CreateDenseArray<int>({1, 2, 3}));
+  SelectionVector selection(ds);
+  EXPECT_EQ(selection.size(), 3);
+  EXPECT_THAT(selection.Materialize(), ElementsAre(1, 2, 3));
+}
+
+TEST(SelectionVectorTest, SelectThenAt) {
+  auto ds = DataSliceImpl::Create(
+      CreateDenseArray<int>({1, std::nullopt, 3, std::nullopt}),
+      CreateDenseArray<Text>({std::nullopt, Text("b"), std::nullopt,
+                              Text("d")}));
+  ASSERT_OK_AND_ASSIGN(
+      auto selected,
+      SelectionVector(ds).Select(
+          CreateDenseArray<Unit>({kMissing, kPresent, kPresent, kPresent})));
+  EXPECT_EQ(selected.size(), 3);
+  EXPECT_THAT(selected.Materialize(),
+              ElementsAre(DataItem(Text("b")), DataItem(3),
+                          DataItem(Text("d"))));
+
+  auto picked =
+      selected.At(CreateDenseArray<int64_t>({2, std::nullopt, 0, 5, -1}));
+  EXPECT_THAT(picked.Materialize(),
+              ElementsAre(DataItem(Text("d")), DataItem(), DataItem(Text("b")),
+                          DataItem(), DataItem()));
+}
+
+TEST(SelectionVectorTest, SelectedAllocationIds) {
+  ObjectId small_obj = AllocateSingleObject();
+  AllocationId alloc1 = Allocate(10);
+  AllocationId alloc2 = Allocate(10);
+  auto ds = DataSliceImpl::Create(CreateDenseArray<ObjectId>(
+      {small_obj, alloc1.ObjectByOffset(0), alloc2.ObjectByOffset(1)}));
+  EXPECT_EQ(SelectionVector(ds)
+                .At(CreateDenseArray<int64_t>({1, std::nullopt}))
+                .Materialize()
+                .allocation_ids(),
+            AllocationIdSet(alloc1));
+  EXPECT_EQ(SelectionVector(ds)
+                .At(CreateDenseArray<int64_t>({0, 2}))
+                .Materialize()
+                .allocation_ids(),
+            AllocationIdSet(
+                std::vector<AllocationId>{AllocationId(small_obj), alloc2}));
+
+  auto single_alloc = DataSliceImpl::Create(CreateDenseArray<ObjectId>(
+      {alloc1.ObjectByOffset(0), alloc1.ObjectByOffset(1)}));
+  EXPECT_EQ(SelectionVector(single_alloc)
+                .At(CreateDenseArray<int64_t>({1}))
+                .Materialize()
+                .allocation_ids(),
+            AllocationIdSet(alloc1));
+  EXPECT_EQ(SelectionVector(single_alloc)
+                .At(CreateDenseArray<int64_t>({std::nullopt, 5}))
+                .Materialize()
+                .allocation_ids(),
+            AllocationIdSet());
+}
+
+TEST(SelectionVectorTest, EmptySource) {
+  auto ds = DataSliceImpl::CreateEmptyAndUnknownType(3);
+  auto picked = SelectionVector(ds).At(CreateDenseArray<int64_t>({0, 1}));
+  auto res = picked.Materialize();
+  EXPECT_EQ(res.size(), 2);
+  EXPECT_TRUE(res.is_empty_and_unknown());
+}
+
+TEST(SelectionVectorTest, SizeMismatch) {
+  auto ds = DataSliceImpl::Create(CreateDenseArray<int>({1, 2, 3}));
+  EXPECT_THAT(SelectionVector(ds).Select(CreateDenseArray<Unit>({kPresent})),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "mask must have the same size as the selection"));
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -0,0 +1,147 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_STREAMING_AGG_H_
+#define KOLADATA_INTERNAL_OP_UTILS_STREAMING_AGG_H_
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+
+namespace koladata::internal {
+
+// Default number of items kept per level of QuantileSketch. The sketch is
+// exact for groups smaller than this.
+constexpr size_t kDefaultQuantileSketchCapacity = 256;
+
+// Single-pass, numerically stable accumulator of mean and variance (Welford's
+// algorithm).
+class WelfordAccumulator {
+ public:
+  void Add(double value) {
+    ++count_;
+    double delta = value - mean_;
+    mean_ += delta / count_;
+    m2_ += delta * (value - mean_);
+  }
+
+  int64_t count() const { return count_; }
+  double mean() const { return mean_; }
+
+  // Returns the variance of the added values, or nullopt if there are not
+  // enough of them (none, or a single one for the unbiased estimate).
+  std::optional<double> Variance(bool unbiased) const {
+    int64_t denominator = unbiased ? count_ - 1 : count_;
+    if (count_ == 0 || denominator <= 0) {
+      return std::nullopt;
+    }
+    return m2_ / denominator;
+  }
+
+ private:
+  int64_t count_ = 0;
+  double mean_ = 0;
+  double m2_ = 0;
+};
+
+// Approximate quantiles of a stream of values in bounded memory. A simplified
+// KLL sketch: level `i` holds items of weight 2^i and, once it holds
+// `capacity` items, is sorted and every second one is promoted to level
+// `i + 1`. The memory is O(capacity * log(n / capacity)) and the rank error is
+// O(n / capacity). The compaction is deterministic, so results are
+// reproducible.
+template <typename T>
+class QuantileSketch {
+ public:
+  explicit QuantileSketch(size_t capacity = kDefaultQuantileSketchCapacity)
+      : capacity_(std::max<size_t>(capacity, 2) & ~size_t{1}) {}
+
+  void Add(T value) {
+    if (levels_.empty()) {
+      levels_.emplace_back();
+    }
+    levels_[0].push_back(value);
+    ++count_;
+    for (size_t i = 0; i < levels_.size() && levels_[i].size() >= capacity_;
+         ++i) {
+      Compact(i);
+    }
+  }
+
+  int64_t count() const { return count_; }
+
+  // Returns the item at the weighted rank floor(q * (count - 1)), i.e. the
+  // lower middle item for q = 0.5. `q` must be in [0, 1]; returns nullopt
+  // if no values were added.
+  std::optional<T> Quantile(double q) const {
+    DCHECK(q >= 0 && q <= 1);
+    if (count_ == 0) {
+      return std::nullopt;
+    }
+    std::vector<std::pair<T, int64_t>> weighted;
+    for (size_t i = 0; i < levels_.size(); ++i) {
+      for (const T& value : levels_[i]) {
+        weighted.emplace_back(value, int64_t{1} << i);
+      }
+    }
+    std::sort(weighted.begin(), weighted.end(),
+              [](const auto& a, const auto& b) { return a.first < b.first; });
+    // Compaction of an even number of items preserves the total weight.
+    int64_t rank = static_cast<int64_t>(std::floor(q * (count_ - 1)));
+    int64_t seen = 0;
+    for (const auto& [value, weight] : weighted) {
+      seen += weight;
+      if (seen > rank) {
+        return value;
+      }
+    }
+    return weighted.back().first;
+  }
+
+ private:
+  void Compact(size_t level) {
+    if (level + 1 == levels_.size()) {
+      levels_.emplace_back();
+    }
+    std::vector<T>& items = levels_[level];
+    std::sort(items.begin(), items.end());
+    // An odd item stays behind; the parity of the promoted items alternates
+    // between compactions to avoid a systematic bias.
+    size_t begin = items.size() % 2;
+    size_t offset = parity_[level % kParityBits] ? 1 : 0;
+    parity_[level % kParityBits] = !parity_[level % kParityBits];
+    std::vector<T>& next = levels_[level + 1];
+    for (size_t i = begin + offset; i < items.size(); i += 2) {
+      next.push_back(items[i]);
+    }
+    items.resize(begin);
+  }
+
+  static constexpr size_t kParityBits = 64;
+
+  size_t capacity_;
+  int64_t count_ = 0;
+  std::vector<std::vector<T>> levels_;
+  bool parity_[kParityBits] = {};
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_STREAMING_AGG_H_
@@ -0,0 +1,88 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/streaming_agg.h"
+
+#include <cmath>
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::DoubleNear;
+using ::testing::Optional;
+
+TEST(WelfordAccumulatorTest, Variance) {
+  WelfordAccumulator acc;
+  EXPECT_EQ(acc.Variance(/*unbiased=*/false), std::nullopt);
+  acc.Add(1);
+  EXPECT_EQ(acc.Variance(/*unbiased=*/true), std::nullopt);
+  EXPECT_THAT(acc.Variance(/*unbiased=*/false), Optional(0.0));
+  acc.Add(2);
+  acc.Add(3);
+  acc.Add(4);
+  EXPECT_EQ(acc.count(), 4);
+  EXPECT_DOUBLE_EQ(acc.mean(), 2.5);
+  EXPECT_THAT(acc.Variance(/*unbiased=*/false), Optional(1.25));
+  EXPECT_THAT(acc.Variance(/*unbiased=*/true),
+              Optional(DoubleNear(5.0 / 3, 1e-12)));
+}
+
+TEST(WelfordAccumulatorTest, LargeOffset) {
+  // The naive sum-of-squares formula loses all precision here.
+  WelfordAccumulator acc;
+  for (double x : {1e9 + 4, 1e9 + 7, 1e9 + 13, 1e9 + 16}) {
+    acc.Add(x);
+  }
+  EXPECT_THAT(acc.Variance(/*unbiased=*/true),
+              Optional(DoubleNear(30, 1e-6)));
+}
+
+TEST(QuantileSketchTest, ExactForSmallInputs) {
+  QuantileSketch<int> sketch(/*capacity=*/16);
+  EXPECT_EQ(sketch.Quantile(0.5), std::nullopt);
+  for (int x : {5, 3, 1, 4, 2}) {
+    sketch.Add(x);
+  }
+  EXPECT_EQ(sketch.count(), 5);
+  EXPECT_THAT(sketch.Quantile(0), Optional(1));
+  EXPECT_THAT(sketch.Quantile(0.5), Optional(3));
+  EXPECT_THAT(sketch.Quantile(1), Optional(5));
+  sketch.Add(6);
+  // Lower middle item for even sizes.
+  EXPECT_THAT(sketch.Quantile(0.5), Optional(3));
+}
+
+TEST(QuantileSketchTest, ApproximateForLargeInputs) {
+  constexpr int64_t kSize = 100000;
+  QuantileSketch<double> sketch(/*capacity=*/128);
+  // A deterministic permutation of [0, kSize).
+  for (int64_t i = 0; i < kSize; ++i) {
+    sketch.Add(static_cast<double>((i * 7919) % kSize));
+  }
+  EXPECT_EQ(sketch.count(), kSize);
+  for (double q : {0.0, 0.1, 0.5, 0.9, 1.0}) {
+    EXPECT_THAT(sketch.Quantile(q),
+                Optional(DoubleNear(q * (kSize - 1), kSize * 0.02)))
+        << q;
+  }
+}
+
+}  // namespace
+}  // namespace koladata::internal
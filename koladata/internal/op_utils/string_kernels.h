@@ -0,0 +1,218 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_STRING_KERNELS_H_
+#define KOLADATA_INTERNAL_OP_UTILS_STRING_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/log/check.h"
+#include "absl/strings/str_split.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/memory/strings_buffer.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+
+namespace string_kernels_impl {
+
+// Returns true if `chars` contains only ASCII characters. Processes 8 bytes at
+// a time, which compilers turn into vector instructions.
+inline bool IsAscii(absl::Span<const char> chars) {
+  constexpr uint64_t kHighBits = 0x8080808080808080;
+  const char* data = chars.data();
+  size_t size = chars.size();
+  uint64_t acc = 0;
+  size_t i = 0;
+  for (; i + sizeof(uint64_t) <= size; i += sizeof(uint64_t)) {
+    uint64_t word;
+    std::memcpy(&word, data + i, sizeof(uint64_t));
+    acc |= word;
+  }
+  for (; i < size; ++i) {
+    acc |= static_cast<uint8_t>(data[i]);
+  }
+  return (acc & kHighBits) == 0;
+}
+
+// Returns the characters of `values` that are referenced by its offsets, or
+// nullopt if the buffer is much larger than them (e.g. for a small slice of a
+// large array), so that processing the whole buffer is not worth it.
+inline std::optional<absl::Span<const char>> ReferencedCharacters(
+    const arolla::StringsBuffer& values) {
+  int64_t referenced_size = 0;
+  for (const auto& offsets : values.offsets().span()) {
+    referenced_size += offsets.end - offsets.start;
+  }
+  absl::Span<const char> chars = values.characters().span();
+  if (chars.size() > 2 * referenced_size + 64) {
+    return std::nullopt;
+  }
+  return chars;
+}
+
+// Applies `fn` to every character of an ASCII-only `array`. The offsets and
+// the presence bitmap are shared with `array`. Returns nullopt if `array`
+// contains non-ASCII characters.
+template <typename Fn>
+std::optional<arolla::DenseArray<arolla::Text>> TransformAscii(
+    const arolla::DenseArray<arolla::Text>& array, Fn fn) {
+  const arolla::StringsBuffer& values = array.values;
+  std::optional<absl::Span<const char>> chars = ReferencedCharacters(values);
+  if (!chars.has_value() || !IsAscii(*chars)) {
+    return std::nullopt;
+  }
+  arolla::Buffer<char>::Builder chars_bldr(chars->size());
+  char* out = chars_bldr.GetMutableSpan().data();
+  for (size_t i = 0; i < chars->size(); ++i) {
+    out[i] = fn((*chars)[i]);
+  }
+  return arolla::DenseArray<arolla::Text>{
+      arolla::StringsBuffer(values.offsets(), std::move(chars_bldr).Build(),
+                            values.base_offset()),
+      array.bitmap, array.bitmap_bit_offset};
+}
+
+}  // namespace string_kernels_impl
+
+// Returns `array` with ASCII letters converted to lower case, or nullopt if
+// `array` contains non-ASCII characters (which require full Unicode case
+// mapping).
+inline std::optional<arolla::DenseArray<arolla::Text>> AsciiLower(
+    const arolla::DenseArray<arolla::Text>& array) {
+  return string_kernels_impl::TransformAscii(array, [](char c) -> char {
+    return c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c;
+  });
+}
+
+// Returns `array` with ASCII letters converted to upper case, or nullopt if
+// `array` contains non-ASCII characters.
+inline std::optional<arolla::DenseArray<arolla::Text>> AsciiUpper(
+    const arolla::DenseArray<arolla::Text>& array) {
+  return string_kernels_impl::TransformAscii(array, [](char c) -> char {
+    return c >= 'a' && c <= 'z' ? c - ('a' - 'A') : c;
+  });
+}
+
+// Returns the lengths of the strings in `array`: the number of bytes for
+// Bytes and the number of UTF-8 code points for Text. The presence bitmap is
+// shared with `array`.
+template <typename T>
+arolla::DenseArray<int32_t> StringLengths(const arolla::DenseArray<T>& array) {
+  const arolla::StringsBuffer& values = array.values;
+  absl::Span<const char> chars = values.characters().span();
+  int64_t base_offset = values.base_offset();
+  bool count_bytes = true;
+  if constexpr (std::is_same_v<T, arolla::Text>) {
+    std::optional<absl::Span<const char>> referenced =
+        string_kernels_impl::ReferencedCharacters(values);
+    count_bytes = referenced.has_value() &&
+                  string_kernels_impl::IsAscii(*referenced);
+  }
+  arolla::Buffer<int32_t>::Builder lengths_bldr(array.size());
+  auto lengths = lengths_bldr.GetMutableSpan();
+  auto offsets = values.offsets().span();
+  for (int64_t i = 0; i < array.size(); ++i) {
+    int64_t begin = offsets[i].start - base_offset;
+    int64_t end = offsets[i].end - base_offset;
+    if (count_bytes) {
+      lengths[i] = end - begin;
+      continue;
+    }
+    // Code points are the bytes that are not UTF-8 continuation bytes.
+    int32_t length = 0;
+    for (int64_t j = begin; j < end; ++j) {
+      length += (static_cast<uint8_t>(chars[j]) & 0xC0) != 0x80;
+    }
+    lengths[i] = length;
+  }
+  return arolla::DenseArray<int32_t>{std::move(lengths_bldr).Build(),
+                                     array.bitmap, array.bitmap_bit_offset};
+}
+
+// Result of SplitStrings.
+template <typename T>
+struct SplitResult {
+  // All the tokens, present.
+  arolla::DenseArray<T> tokens;
+  // Maps every input string to its tokens.
+  arolla::DenseArrayEdge edge;
+};
+
+// Splits every present string of `array` by `sep`, keeping empty tokens, or,
+// if `sep` is nullopt, by ASCII whitespace, omitting empty tokens (same as the
+// Arolla strings.split operator). Missing strings have no tokens.
+//
+// The tokens reference the characters buffer of `array` instead of copying
+// it, so only their offsets are allocated. Note that the tokens keep the whole
+// buffer alive.
+template <typename T>
+SplitResult<T> SplitStrings(const arolla::DenseArray<T>& array,
+                            std::optional<absl::string_view> sep) {
+  DCHECK(!sep.has_value() || !sep->empty());
+  const arolla::StringsBuffer& values = array.values;
+  const char* chars = values.characters().span().data();
+  int64_t base_offset = values.base_offset();
+  auto offsets = values.offsets().span();
+  std::vector<arolla::StringsBuffer::Offsets> token_offsets;
+  arolla::Buffer<int64_t>::Builder split_points_bldr(array.size() + 1);
+  auto split_points = split_points_bldr.GetMutableSpan();
+  split_points[0] = 0;
+  auto add_token = [&](absl::string_view token) {
+    int64_t start = token.data() - chars + base_offset;
+    token_offsets.push_back(
+        {start, start + static_cast<int64_t>(token.size())});
+  };
+  for (int64_t i = 0; i < array.size(); ++i) {
+    if (array.present(i)) {
+      absl::string_view value(chars + (offsets[i].start - base_offset),
+                              offsets[i].end - offsets[i].start);
+      if (sep.has_value()) {
+        for (absl::string_view token :
+             absl::StrSplit(value, absl::ByString(*sep))) {
+          add_token(token);
+        }
+      } else {
+        for (absl::string_view token :
+             absl::StrSplit(value, absl::ByAnyChar(" \t\n\v\f\r"),
+                            absl::SkipEmpty())) {
+          add_token(token);
+        }
+      }
+    }
+    split_points[i + 1] = token_offsets.size();
+  }
+  return SplitResult<T>{
+      .tokens = arolla::DenseArray<T>{arolla::StringsBuffer(
+          arolla::Buffer<arolla::StringsBuffer::Offsets>::Create(
+              std::move(token_offsets)),
+          values.characters(), base_offset)},
+      .edge = arolla::DenseArrayEdge::UnsafeFromSplitPoints(
+          arolla::DenseArray<int64_t>{std::move(split_points_bldr).Build()}),
+  };
+}
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_STRING_KERNELS_H_
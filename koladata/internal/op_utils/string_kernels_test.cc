@@ -0,0 +1,110 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/string_kernels.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/bytes.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::arolla::Bytes;
+using ::arolla::CreateDenseArray;
+using ::arolla::Text;
+using ::testing::ElementsAre;
+using ::testing::Optional;
+
+TEST(StringKernelsTest, AsciiLowerUpper) {
+  auto values = CreateDenseArray<Text>(
+      {Text("aBc"), std::nullopt, Text(""), Text("Hello, World! 123")});
+  auto lower = AsciiLower(values);
+  ASSERT_TRUE(lower.has_value());
+  EXPECT_THAT(*lower, ElementsAre(Text("abc"), std::nullopt, Text(""),
+                                  Text("hello, world! 123")));
+  auto upper = AsciiUpper(values);
+  ASSERT_TRUE(upper.has_value());
+  EXPECT_THAT(*upper, ElementsAre(Text("ABC"), std::nullopt, Text(""),
+                                  Text("HELLO, WORLD! 123")));
+  // The offsets are shared.
+  EXPECT_EQ(lower->values.offsets().span().data(),
+            values.values.offsets().span().data());
+}
+
+TEST(StringKernelsTest, AsciiLowerUpperNonAscii) {
+  auto values = CreateDenseArray<Text>({Text("abc"), Text("\xc3\x84")});
+  EXPECT_FALSE(AsciiLower(values).has_value());
+  EXPECT_FALSE(AsciiUpper(values).has_value());
+}
+
+TEST(StringKernelsTest, AsciiLowerLongStrings) {
+  // Covers both the word-at-a-time and the tail loops of the ASCII check.
+  std::string long_string(1001, 'X');
+  auto values = CreateDenseArray<Text>({Text(long_string)});
+  EXPECT_THAT(AsciiLower(values),
+              Optional(ElementsAre(Text(std::string(1001, 'x')))));
+  long_string[997] = '\xff';
+  EXPECT_FALSE(
+      AsciiLower(CreateDenseArray<Text>({Text(long_string)})).has_value());
+}
+
+TEST(StringKernelsTest, StringLengths) {
+  EXPECT_THAT(StringLengths(CreateDenseArray<Text>(
+                  {Text("abc"), std::nullopt, Text(""), Text("a\xc3\x84z")})),
+              ElementsAre(3, std::nullopt, 0, 3));
+  EXPECT_THAT(StringLengths(CreateDenseArray<Text>({Text("abc"), Text("")})),
+              ElementsAre(3, 0));
+  EXPECT_THAT(StringLengths(CreateDenseArray<Bytes>(
+                  {Bytes("abc"), std::nullopt, Bytes("a\xc3\x84z")})),
+              ElementsAre(3, std::nullopt, 4));
+}
+
+TEST(StringKernelsTest, SplitStrings) {
+  auto values = CreateDenseArray<Text>(
+      {Text("a,b,,c"), std::nullopt, Text(""), Text("xyz")});
+  SplitResult<Text> result = SplitStrings(values, ",");
+  EXPECT_THAT(result.tokens, ElementsAre(Text("a"), Text("b"), Text(""),
+                                         Text("c"), Text(""), Text("xyz")));
+  EXPECT_THAT(result.edge.edge_values(), ElementsAre(0, 4, 4, 5, 6));
+  // The characters are shared.
+  EXPECT_EQ(result.tokens.values.characters().span().data(),
+            values.values.characters().span().data());
+}
+
+TEST(StringKernelsTest, SplitStringsByWhitespace) {
+  auto values = CreateDenseArray<Bytes>(
+      {Bytes("  a b\t\nc "), Bytes("   "), std::nullopt, Bytes("de")});
+  SplitResult<Bytes> result = SplitStrings(values, std::nullopt);
+  EXPECT_THAT(result.tokens,
+              ElementsAre(Bytes("a"), Bytes("b"), Bytes("c"), Bytes("de")));
+  EXPECT_THAT(result.edge.edge_values(), ElementsAre(0, 3, 3, 3, 4));
+}
+
+TEST(StringKernelsTest, SplitStringsOfSlicedArray) {
+  auto values = CreateDenseArray<Text>(
+      {Text("skipped"), Text("a--b"), Text("c")}).Slice(1, 2);
+  SplitResult<Text> result = SplitStrings(values, "--");
+  EXPECT_THAT(result.tokens, ElementsAre(Text("a"), Text("b"), Text("c")));
+  EXPECT_THAT(result.edge.edge_values(), ElementsAre(0, 2, 3));
+}
+
+}  // namespace
+}  // namespace koladata::internal
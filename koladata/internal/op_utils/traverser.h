@@ -18,22 +18,25 @@
 #include <cstddef>
 #include <cstdint>
 #include <memory>
-#include <stack>
 #include <string_view>
-#include <tuple>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/internal/cancellation.h"
 #include "koladata/internal/data_bag.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/schema_utils.h"
 #include "arolla/dense_array/dense_array.h"
@@ -50,9 +53,10 @@ class AbstractVisitor {
   // Returns a value for the given item and schema.
   //
   // GetValue would only be called for an (item, schema) after Previsit was
-  // called for the same (item, schema). If topological ordering of reachable
-  // objects exists, then GetValue would be called for an (item, schema) only
-  // after corresponding Visit* method was called for the same (item, schema).
+  // called for the same (item, schema). Items are visited in the reverse order
+  // of their discovery, so if the reachable objects form a tree, GetValue
+  // would be called for an (item, schema) only after corresponding Visit*
+  // method was called for the same (item, schema).
   //
   // Result of GetValue is used in Visit* methods as values for attributes,
   // list items, dict keys and values.
@@ -130,38 +134,39 @@ class Traverser {
   // The traversal is initialized with an AbstractVisitor implementation.
   //
   // The processing is organized in stages:
-  // 1. Depth first search (DepthFirstPrevisitItemsAndSchemas):
+  // 1. Breadth first search (PrevisitItemsAndSchemas):
   //    - calls visitor.Previsit for each reachable item and schema.
-  //    - create a post order (topological order if it exists) of the reachable
-  //    items and schemas.
-  // 2. Iteration over the post order with the calls to visitor.Visit*
-  // (VisitInPostOrder).
+  //    - the not yet processed items of one BFS level are grouped by schema,
+  //    and attributes, list items and dict keys and values of each group are
+  //    fetched with batch DataBagImpl calls. If `executor` is provided, the
+  //    groups are processed concurrently. The visitor is only called from the
+  //    calling thread.
+  //    - records the reachable items and schemas in the discovery order.
+  // 2. Iteration over the reversed discovery order with the calls to
+  // visitor.Visit* (VisitInReverseDiscoveryOrder).
   //    - calls visitor.GetValue on attributes, list items, dict keys and values
   //    and use the results for arguments in visitor.Visit* calls. Except for
   //    the currently visited item and it's schema.
  public:
   Traverser(const DataBagImpl& databag, DataBagImpl::FallbackSpan fallbacks,
-            std::shared_ptr<VisitorT> visitor)
+            std::shared_ptr<VisitorT> visitor, Executor* executor = nullptr)
       : databag_(databag),
         fallbacks_(fallbacks),
-        previsit_stack_(),
-        topological_order_(),
+        executor_(executor),
+        frontier_(),
+        discovery_order_(),
         visitor_(std::move(visitor)) {
     static_assert(std::is_base_of<AbstractVisitor, VisitorT>());
   }
 
   absl::Status TraverseSlice(const DataSliceImpl& ds, const DataItem& schema) {
-    absl::Status status = absl::OkStatus();
     RETURN_IF_ERROR(
         Previsit({.item = schema, .schema = DataItem(schema::kSchema)}));
     for (const DataItem& item : ds) {
       RETURN_IF_ERROR(Previsit({.item = item, .schema = schema}));
     }
-    if (!status.ok()) {
-      return status;
-    }
-    RETURN_IF_ERROR(DepthFirstPrevisitItemsAndSchemas());
-    RETURN_IF_ERROR(VisitInPostOrder());
+    RETURN_IF_ERROR(PrevisitItemsAndSchemas());
+    RETURN_IF_ERROR(VisitInReverseDiscoveryOrder());
     return absl::OkStatus();
   }
 
@@ -171,69 +176,64 @@ class Traverser {
     DataItem schema;
   };
 
+  // Attributes of an entity schema.
+  struct SchemaInfo {
+    arolla::DenseArray<arolla::Text> attr_names;
+    // Schemas of the attributes in `attr_names`, in the same order.
+    std::vector<DataItem> attr_schemas;
+    bool has_list_items_attr = false;
+    bool has_dict_keys_attr = false;
+    bool has_dict_values_attr = false;
+    // Copies of the corresponding `attr_schemas`, if present.
+    DataItem list_items_schema;
+    DataItem dict_keys_schema;
+    DataItem dict_values_schema;
+  };
+
+  // Items with the same schema that are processed together.
+  struct SchemaGroup {
+    DataItem schema;
+    std::vector<DataItem> items;
+  };
+
   absl::Status Previsit(const ItemWithSchema& item) {
     if (item.item.has_value()) {
-      previsit_stack_.push({.item = item.item, .schema = item.schema});
+      auto [it, inserted] =
+          frontier_index_.try_emplace(item.schema, frontier_.size());
+      if (inserted) {
+        frontier_.push_back({.schema = item.schema, .items = {}});
+      }
+      frontier_[it->second].items.push_back(item.item);
     }
     return visitor_->VisitorT::Previsit(item.item, item.schema);
   }
 
-  absl::Status PrevisitAttribute(const ItemWithSchema& item,
-                                 std::string_view attr_name) {
-    DataItem attr_schema;
-    if (attr_name == schema::kSchemaAttr) {
-      attr_schema = DataItem(schema::kSchema);
-    } else {
-      ASSIGN_OR_RETURN(attr_schema, databag_.GetSchemaAttr(
-                                        item.schema, attr_name, fallbacks_));
-    }
-    ASSIGN_OR_RETURN(auto attr_item,
-                     databag_.GetAttr(item.item, attr_name, fallbacks_));
-    RETURN_IF_ERROR(Previsit({.item = attr_item, .schema = attr_schema}));
-    return absl::OkStatus();
-  }
-
-  absl::Status PrevisitListItems(const ItemWithSchema& item) {
-    ASSIGN_OR_RETURN(
-        auto list_item_schema,
-        databag_.GetSchemaAttr(item.schema, schema::kListItemsSchemaAttr,
-                               fallbacks_));
-    ASSIGN_OR_RETURN(
-        auto list_items,
-        databag_.ExplodeList(item.item, DataBagImpl::ListRange(), fallbacks_));
-    for (const DataItem& list_item : list_items) {
-      RETURN_IF_ERROR(
-          Previsit({.item = list_item, .schema = list_item_schema}));
+  static void AppendItems(const DataSliceImpl& items, const DataItem& schema,
+                          std::vector<ItemWithSchema>& reachable) {
+    for (const DataItem& item : items) {
+      reachable.push_back({.item = item, .schema = schema});
     }
-    return absl::OkStatus();
   }
 
-  absl::Status PrevisitDictKeysAndValues(const ItemWithSchema& item) {
-    ASSIGN_OR_RETURN(auto dict_keys_schema,
-                     databag_.GetSchemaAttr(
-                         item.schema, schema::kDictKeysSchemaAttr, fallbacks_));
-    ASSIGN_OR_RETURN(
-        auto dict_values_schema,
-        databag_.GetSchemaAttr(item.schema, schema::kDictValuesSchemaAttr,
-                               fallbacks_));
-    ASSIGN_OR_RETURN(auto dict_keys,
-                     databag_.GetDictKeys(item.item, fallbacks_));
-    ASSIGN_OR_RETURN(auto dict_values,
-                     databag_.GetDictValues(item.item, fallbacks_));
-    for (const DataItem& dict_key : dict_keys.first) {
-      RETURN_IF_ERROR(Previsit({.item = dict_key, .schema = dict_keys_schema}));
-    }
-    for (const DataItem& dict_value : dict_values.first) {
-      RETURN_IF_ERROR(
-          Previsit({.item = dict_value, .schema = dict_values_schema}));
+  // Returns a slice with `items`, which are expected to be ObjectIds.
+  static absl::StatusOr<DataSliceImpl> CreateObjectsSlice(
+      absl::Span<const DataItem> items) {
+    for (const DataItem& item : items) {
+      if (!item.holds_value<ObjectId>()) {
+        return absl::FailedPreconditionError(
+            "getting attribute of a primitive is not allowed");
+      }
     }
-    return absl::OkStatus();
+    return DataSliceImpl::Create(items);
   }
 
-  absl::Status PrevisitEntityAttributes(const ItemWithSchema& item,
-                                        bool is_object) {
+  // Appends the list items, dict keys and values or attributes of `objects`
+  // together with their schemas to `reachable`.
+  absl::Status CollectEntityAttributes(
+      const DataItem& schema, const DataSliceImpl& objects,
+      std::vector<ItemWithSchema>& reachable) const {
     ASSIGN_OR_RETURN(DataSliceImpl attr_names_slice,
-                     databag_.GetSchemaAttrs(item.schema, fallbacks_));
+                     databag_.GetSchemaAttrs(schema, fallbacks_));
     if (attr_names_slice.size() == 0) {
       return absl::OkStatus();
     }
@@ -245,7 +245,6 @@ class Traverser {
     bool has_list_items_attr = false;
     bool has_dict_keys_attr = false;
     bool has_dict_values_attr = false;
-    // Schema attributes are previsited when the item is being visited.
     attr_names.ForEach(
         [&](int64_t id, bool presence, std::string_view attr_name) {
           DCHECK(presence);
@@ -257,22 +256,39 @@ class Traverser {
             has_dict_values_attr = true;
           }
         });
-    if (is_object) {
-      RETURN_IF_ERROR(PrevisitAttribute(item, schema::kSchemaAttr));
-    }
     if (has_list_items_attr) {
       if (attr_names.size() != 1) {
         return absl::InvalidArgumentError(absl::StrFormat(
-            "list schema %v has unexpected attributes", item.schema));
+            "list schema %v has unexpected attributes", schema));
       }
-      return PrevisitListItems(item);
+      ASSIGN_OR_RETURN(
+          auto list_item_schema,
+          databag_.GetSchemaAttr(schema, schema::kListItemsSchemaAttr,
+                                 fallbacks_));
+      ASSIGN_OR_RETURN((auto [list_items, edge]),
+                       databag_.ExplodeLists(objects, DataBagImpl::ListRange(),
+                                             fallbacks_));
+      AppendItems(list_items, list_item_schema, reachable);
+      return absl::OkStatus();
     } else if (has_dict_keys_attr || has_dict_values_attr) {
       if (attr_names.size() != 2 || !has_dict_keys_attr ||
           !has_dict_values_attr) {
         return absl::InvalidArgumentError(absl::StrFormat(
-            "dict schema %v has unexpected attributes", item.schema));
+            "dict schema %v has unexpected attributes", schema));
       }
-      return PrevisitDictKeysAndValues(item);
+      ASSIGN_OR_RETURN(auto dict_keys_schema,
+                       databag_.GetSchemaAttr(
+                           schema, schema::kDictKeysSchemaAttr, fallbacks_));
+      ASSIGN_OR_RETURN(auto dict_values_schema,
+                       databag_.GetSchemaAttr(
+                           schema, schema::kDictValuesSchemaAttr, fallbacks_));
+      ASSIGN_OR_RETURN((auto [dict_keys, keys_edge]),
+                       databag_.GetDictKeys(objects, fallbacks_));
+      ASSIGN_OR_RETURN((auto [dict_values, values_edge]),
+                       databag_.GetDictValues(objects, fallbacks_));
+      AppendItems(dict_keys, dict_keys_schema, reachable);
+      AppendItems(dict_values, dict_values_schema, reachable);
+      return absl::OkStatus();
     }
     absl::Status status = absl::OkStatus();
     attr_names.ForEach(
@@ -281,112 +297,164 @@ class Traverser {
           if (!status.ok()) {
             return;
           }
-          status = PrevisitAttribute(item, attr_name);
+          auto attr_schema_or =
+              databag_.GetSchemaAttr(schema, attr_name, fallbacks_);
+          if (!attr_schema_or.ok()) {
+            status = attr_schema_or.status();
+            return;
+          }
+          auto attr_values_or =
+              databag_.GetAttr(objects, attr_name, fallbacks_);
+          if (!attr_values_or.ok()) {
+            status = attr_values_or.status();
+            return;
+          }
+          AppendItems(*attr_values_or, *attr_schema_or, reachable);
         });
     return status;
   }
 
-  absl::Status PrevisitObjectAttributes(const ItemWithSchema& item) {
-    if (!item.item.has_value()) {
+  absl::Status CollectObjectAttributes(
+      absl::Span<const DataItem> items,
+      std::vector<ItemWithSchema>& reachable) const {
+    // Primitives with OBJECT schema have no attributes.
+    std::vector<DataItem> objects;
+    objects.reserve(items.size());
+    for (const DataItem& item : items) {
+      if (item.holds_value<ObjectId>()) {
+        objects.push_back(item);
+      }
+    }
+    if (objects.empty()) {
       return absl::OkStatus();
     }
-    if (!item.item.template holds_value<ObjectId>()) {
-      ASSIGN_OR_RETURN(auto dtype, schema::DType::FromQType(item.item.dtype()));
-      return PrevisitPrimitiveAttributes(
-          {.item = item.item, .schema = DataItem(dtype)});
+    ASSIGN_OR_RETURN(DataSliceImpl schemas,
+                     databag_.GetAttr(DataSliceImpl::Create(objects),
+                                      schema::kSchemaAttr, fallbacks_));
+    // Objects are processed in groups with the same schema.
+    absl::flat_hash_map<DataItem, size_t, DataItem::Hash> group_index;
+    std::vector<SchemaGroup> groups;
+    for (size_t i = 0; i < objects.size(); ++i) {
+      DataItem schema = schemas[i];
+      if (!schema.is_schema()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "object %v is expected to have a schema in %s attribute, got %v",
+            objects[i], schema::kSchemaAttr, schema));
+      }
+      reachable.push_back({.item = schema, .schema = DataItem(schema::kSchema)});
+      if (!schema.holds_value<ObjectId>()) {
+        continue;
+      }
+      auto [it, inserted] = group_index.try_emplace(schema, groups.size());
+      if (inserted) {
+        groups.push_back({.schema = schema, .items = {}});
+      }
+      groups[it->second].items.push_back(objects[i]);
     }
-    ASSIGN_OR_RETURN(
-        auto schema,
-        databag_.GetAttr(item.item, schema::kSchemaAttr, fallbacks_));
-    if (!schema.is_schema()) {
-      return absl::InvalidArgumentError(absl::StrFormat(
-          "object %v is expected to have a schema in %s attribute, got %v",
-          item.item, schema::kSchemaAttr, schema));
+    for (const SchemaGroup& group : groups) {
+      RETURN_IF_ERROR(CollectEntityAttributes(
+          group.schema, DataSliceImpl::Create(group.items), reachable));
     }
-    PrevisitEntityAttributes({item.item, schema}, /*is_object=*/true);
     return absl::OkStatus();
   }
 
-  absl::Status PrevisitSchemaAttributes(const ItemWithSchema& item) {
-    if (!item.item.template holds_value<ObjectId>()) {
-      return absl::OkStatus();
+  absl::Status CollectSchemaAttributes(
+      absl::Span<const DataItem> schemas,
+      std::vector<ItemWithSchema>& reachable) const {
+    for (const DataItem& schema : schemas) {
+      if (!schema.holds_value<ObjectId>()) {
+        continue;
+      }
+      ASSIGN_OR_RETURN(DataSliceImpl attr_names_slice,
+                       databag_.GetSchemaAttrs(schema, fallbacks_));
+      if (attr_names_slice.size() == 0) {
+        continue;
+      }
+      if (attr_names_slice.present_count() != attr_names_slice.size()) {
+        return absl::InternalError("schema attribute names should be present");
+      }
+      const auto& attr_names = attr_names_slice.values<arolla::Text>();
+      absl::Status status = absl::OkStatus();
+      attr_names.ForEach(
+          [&](int64_t id, bool presence, std::string_view attr_name) {
+            DCHECK(presence);
+            if (!status.ok()) {
+              return;
+            }
+            auto attr_schema_or =
+                databag_.GetSchemaAttr(schema, attr_name, fallbacks_);
+            if (!attr_schema_or.ok()) {
+              status = attr_schema_or.status();
+              return;
+            }
+            reachable.push_back({.item = *std::move(attr_schema_or),
+                                 .schema = DataItem(schema::kSchema)});
+          });
+      RETURN_IF_ERROR(status);
     }
-    DCHECK_EQ(item.schema, schema::kSchema);
-    ASSIGN_OR_RETURN(DataSliceImpl attr_names_slice,
-                     databag_.GetSchemaAttrs(item.item, fallbacks_));
-    if (attr_names_slice.size() == 0) {
+    return absl::OkStatus();
+  }
+
+  // Appends the items and schemas directly reachable from `group` to
+  // `reachable`. Only reads the DataBag, so it is safe to call concurrently for
+  // different groups.
+  absl::Status CollectReachable(const SchemaGroup& group,
+                                std::vector<ItemWithSchema>& reachable) const {
+    if (group.items.empty()) {
       return absl::OkStatus();
     }
-    if (attr_names_slice.present_count() != attr_names_slice.size()) {
-      return absl::InternalError("schema attribute names should be present");
+    if (group.schema.template holds_value<ObjectId>()) {
+      // Entity schema.
+      ASSIGN_OR_RETURN(DataSliceImpl objects, CreateObjectsSlice(group.items));
+      return CollectEntityAttributes(group.schema, objects, reachable);
+    } else if (group.schema.template holds_value<schema::DType>()) {
+      if (group.schema == schema::kObject) {
+        return CollectObjectAttributes(group.items, reachable);
+      } else if (group.schema == schema::kSchema) {
+        return CollectSchemaAttributes(group.items, reachable);
+      }
+      // Primitives have nothing reachable.
+      return absl::OkStatus();
     }
-    const auto& attr_names = attr_names_slice.values<arolla::Text>();
-    absl::Status status = absl::OkStatus();
-    attr_names.ForEach(
-        [&](int64_t id, bool presence, std::string_view attr_name) {
-          DCHECK(presence);
-          if (!status.ok()) {
-            return;
-          }
-          auto attr_schema_or =
-              databag_.GetSchemaAttr(item.item, attr_name, fallbacks_);
-          if (!attr_schema_or.ok()) {
-            status = attr_schema_or.status();
-            return;
-          }
-          status = Previsit(
-              {.item = *attr_schema_or, .schema = DataItem(schema::kSchema)});
-        });
-    return status;
+    return absl::InternalError("unsupported schema type");
   }
 
-  absl::Status PrevisitPrimitiveAttributes(const ItemWithSchema& item) {
-    return absl::OkStatus();
-  }
-
-  absl::Status DepthFirstPrevisitItemsAndSchemas() {
-    // We do a depth-first traversal, with unrolled recursion. For that we keep
-    // track of the stack size when we started visiting the current item. If the
-    // stack would reach the same size again it would mean that all the items
-    // reachable from the current item have been visited.
-    std::stack<std::pair<int64_t, ItemWithSchema>> objects_on_stack;
+  absl::Status PrevisitItemsAndSchemas() {
     // TODO: Mark pairs (item, schema) as used.
     auto used_items = absl::flat_hash_set<DataItem, DataItem::Hash>();
 
-    while (!previsit_stack_.empty()) {
-      ItemWithSchema item = std::move(previsit_stack_.top());
-      previsit_stack_.pop();
-      if (!used_items.contains(item.item)) {
-        objects_on_stack.emplace(previsit_stack_.size(), item);
-        used_items.insert(item.item);
-        if (item.item != DataItem(schema::kSchema) ||
-            item.schema != DataItem(schema::kSchema)) {
+    while (!frontier_.empty()) {
+      RETURN_IF_ERROR(CheckCancellation());
+      std::vector<SchemaGroup> level = std::move(frontier_);
+      frontier_.clear();
+      frontier_index_.clear();
+      for (SchemaGroup& group : level) {
+        std::vector<DataItem> new_items;
+        bool previsit_schema = false;
+        for (DataItem& item : group.items) {
+          if (!used_items.insert(item).second) {
+            continue;
+          }
+          discovery_order_.push_back({.item = item, .schema = group.schema});
           // Always call Previsit on the schema, unless it would be a loop.
-          RETURN_IF_ERROR(Previsit(
-              {.item = item.schema, .schema = DataItem(schema::kSchema)}));
+          previsit_schema |= item != DataItem(schema::kSchema) ||
+                             group.schema != DataItem(schema::kSchema);
+          new_items.push_back(std::move(item));
         }
-        if (item.schema.template holds_value<ObjectId>()) {
-          // Entity schema.
-          RETURN_IF_ERROR(PrevisitEntityAttributes(item, /*is_object=*/false));
-        } else if (item.schema.template holds_value<schema::DType>()) {
-          if (item.schema == schema::kObject) {
-            // Object schema.
-            RETURN_IF_ERROR(PrevisitObjectAttributes(item));
-          } else if (item.schema == schema::kSchema) {
-            RETURN_IF_ERROR(PrevisitSchemaAttributes(item));
-          } else {
-            RETURN_IF_ERROR(PrevisitPrimitiveAttributes(item));
-          }
-        } else {
-          return absl::InternalError("unsupported schema type");
+        group.items = std::move(new_items);
+        if (previsit_schema) {
+          RETURN_IF_ERROR(Previsit(
+              {.item = group.schema, .schema = DataItem(schema::kSchema)}));
         }
       }
-      // Put the items for which we have already visited all the reachable items
-      // in the topological order for the visitor->Visit* calls.
-      while (!objects_on_stack.empty() &&
-             objects_on_stack.top().first == previsit_stack_.size()) {
-        topological_order_.push_back(objects_on_stack.top().second);
-        objects_on_stack.pop();
+      std::vector<std::vector<ItemWithSchema>> reachable(level.size());
+      RETURN_IF_ERROR(ParallelFor(executor_, level.size(), [&](int64_t i) {
+        return CollectReachable(level[i], reachable[i]);
+      }));
+      for (const std::vector<ItemWithSchema>& items : reachable) {
+        for (const ItemWithSchema& item : items) {
+          RETURN_IF_ERROR(Previsit(item));
+        }
       }
     }
     return absl::OkStatus();
@@ -397,11 +465,57 @@ class Traverser {
     return visitor_->VisitorT::GetValue(item, schema);
   }
 
-  absl::Status VisitList(const ItemWithSchema& item, bool is_object) {
-    ASSIGN_OR_RETURN(
-        auto list_item_schema,
-        databag_.GetSchemaAttr(item.schema, schema::kListItemsSchemaAttr,
-                               fallbacks_));
+  // Returns the attributes of `schema`, fetching them from the DataBag on the
+  // first call only. Objects share a few schemas, so the schema attributes are
+  // looked up once per schema rather than once per visited object.
+  absl::StatusOr<const SchemaInfo*> GetSchemaInfo(const DataItem& schema) {
+    std::unique_ptr<SchemaInfo>& info = schema_infos_[schema];
+    if (info != nullptr) {
+      return info.get();
+    }
+    ASSIGN_OR_RETURN(DataSliceImpl attr_names_slice,
+                     databag_.GetSchemaAttrs(schema, fallbacks_));
+    if (attr_names_slice.present_count() != attr_names_slice.size()) {
+      return absl::InternalError("schema attribute names should be present");
+    }
+    auto new_info = std::make_unique<SchemaInfo>();
+    if (!attr_names_slice.is_empty_and_unknown()) {
+      new_info->attr_names = attr_names_slice.values<arolla::Text>();
+    }
+    new_info->attr_schemas.reserve(new_info->attr_names.size());
+    absl::Status status = absl::OkStatus();
+    DCHECK(new_info->attr_names.IsAllPresent());
+    new_info->attr_names.ForEachPresent(
+        [&](int64_t id, std::string_view attr_name) {
+          if (!status.ok()) {
+            return;
+          }
+          auto attr_schema_or =
+              databag_.GetSchemaAttr(schema, attr_name, fallbacks_);
+          if (!attr_schema_or.ok()) {
+            status = attr_schema_or.status();
+            return;
+          }
+          if (attr_name == schema::kListItemsSchemaAttr) {
+            new_info->has_list_items_attr = true;
+            new_info->list_items_schema = *attr_schema_or;
+          } else if (attr_name == schema::kDictKeysSchemaAttr) {
+            new_info->has_dict_keys_attr = true;
+            new_info->dict_keys_schema = *attr_schema_or;
+          } else if (attr_name == schema::kDictValuesSchemaAttr) {
+            new_info->has_dict_values_attr = true;
+            new_info->dict_values_schema = *attr_schema_or;
+          }
+          new_info->attr_schemas.push_back(*std::move(attr_schema_or));
+        });
+    RETURN_IF_ERROR(status);
+    info = std::move(new_info);
+    return info.get();
+  }
+
+  absl::Status VisitList(const ItemWithSchema& item, bool is_object,
+                         const SchemaInfo& schema_info) {
+    const DataItem& list_item_schema = schema_info.list_items_schema;
     ASSIGN_OR_RETURN(
         auto list_items,
         databag_.ExplodeList(item.item, DataBagImpl::ListRange(), fallbacks_));
@@ -414,14 +528,10 @@ class Traverser {
                                           std::move(list_items_values).Build());
   }
 
-  absl::Status VisitDict(const ItemWithSchema& item, bool is_object) {
-    ASSIGN_OR_RETURN(auto dict_keys_schema,
-                     databag_.GetSchemaAttr(
-                         item.schema, schema::kDictKeysSchemaAttr, fallbacks_));
-    ASSIGN_OR_RETURN(
-        auto dict_values_schema,
-        databag_.GetSchemaAttr(item.schema, schema::kDictValuesSchemaAttr,
-                               fallbacks_));
+  absl::Status VisitDict(const ItemWithSchema& item, bool is_object,
+                         const SchemaInfo& schema_info) {
+    const DataItem& dict_keys_schema = schema_info.dict_keys_schema;
+    const DataItem& dict_values_schema = schema_info.dict_values_schema;
     ASSIGN_OR_RETURN((auto [dict_keys, dict_keys_edge]),
                      databag_.GetDictKeys(item.item, fallbacks_));
     ASSIGN_OR_RETURN((auto [dict_values, dict_values_edge]),
@@ -444,37 +554,19 @@ class Traverser {
   }
 
   absl::Status VisitSchema(const DataItem& schema,
-                           const arolla::DenseArray<arolla::Text>& attr_names) {
-    absl::Status status = absl::OkStatus();
-    std::vector<std::tuple<absl::string_view, DataItem>> schema_attrs;
+                           const SchemaInfo& schema_info) {
+    const auto& attr_names = schema_info.attr_names;
     arolla::DenseArrayBuilder<DataItem> attr_values(attr_names.size());
-    DCHECK(attr_names.IsAllPresent());
-    attr_names.ForEachPresent([&](int64_t id, std::string_view attr_name) {
-      if (!status.ok()) {
-        return;
-      }
-      auto attr_schema_or =
-          databag_.GetSchemaAttr(schema, attr_name, fallbacks_);
-      if (!attr_schema_or.ok()) {
-        status = attr_schema_or.status();
-        return;
-      }
-      auto attr_schema = *attr_schema_or;
+    for (int64_t id = 0; id < attr_names.size(); ++id) {
+      const DataItem& attr_schema = schema_info.attr_schemas[id];
       if (!attr_schema.is_schema()) {
-        status = absl::InvalidArgumentError(absl::StrFormat(
-            "schema %v has unexpected attribute %s", schema, attr_name));
-        return;
-      }
-      auto attr_value_or = GetValue(attr_schema, DataItem(schema::kSchema));
-      if (!attr_value_or.ok()) {
-        status = attr_value_or.status();
-        return;
+        return absl::InvalidArgumentError(
+            absl::StrFormat("schema %v has unexpected attribute %s", schema,
+                            attr_names.values[id]));
       }
-      auto attr_value = attr_value_or.value();
+      ASSIGN_OR_RETURN(DataItem attr_value,
+                       GetValue(attr_schema, DataItem(schema::kSchema)));
       attr_values.Set(id, attr_value);
-    });
-    if (!status.ok()) {
-      return status;
     }
     return visitor_->VisitorT::VisitSchema(
         schema, DataItem(schema::kSchema),
@@ -486,90 +578,39 @@ class Traverser {
       return absl::OkStatus();
     }
     if (item.item.template holds_value<ObjectId>()) {
-      ASSIGN_OR_RETURN(DataSliceImpl attr_names_slice,
-                       databag_.GetSchemaAttrs(item.item, fallbacks_));
-      if (attr_names_slice.present_count() != attr_names_slice.size()) {
-        return absl::InternalError("schema attribute names should be present");
-      }
-      arolla::DenseArray<arolla::Text> attr_names;
-      if (!attr_names_slice.is_empty_and_unknown()) {
-        attr_names = attr_names_slice.values<arolla::Text>();
-      }
-      return VisitSchema(item.item, attr_names);
+      ASSIGN_OR_RETURN(const SchemaInfo* schema_info, GetSchemaInfo(item.item));
+      return VisitSchema(item.item, *schema_info);
     }
     return VisitPrimitive(item);
   }
 
   absl::Status VisitEntity(const ItemWithSchema& item, bool is_object) {
-    ASSIGN_OR_RETURN(DataSliceImpl attr_names_slice,
-                     databag_.GetSchemaAttrs(item.schema, fallbacks_));
-    if (attr_names_slice.present_count() != attr_names_slice.size()) {
-      return absl::InternalError("schema attribute names should be present");
-    }
-    arolla::DenseArray<arolla::Text> attr_names;
-    if (!attr_names_slice.is_empty_and_unknown()) {
-      attr_names = attr_names_slice.values<arolla::Text>();
-    }
-    bool has_list_items_attr = false;
-    bool has_dict_keys_attr = false;
-    bool has_dict_values_attr = false;
-    DCHECK(attr_names.IsAllPresent());
-    attr_names.ForEachPresent([&](int64_t id, std::string_view attr_name) {
-      if (attr_name == schema::kListItemsSchemaAttr) {
-        has_list_items_attr = true;
-      } else if (attr_name == schema::kDictKeysSchemaAttr) {
-        has_dict_keys_attr = true;
-      } else if (attr_name == schema::kDictValuesSchemaAttr) {
-        has_dict_values_attr = true;
-      }
-    });
-    RETURN_IF_ERROR(VisitSchema(item.schema, attr_names));
-    if (has_list_items_attr) {
+    ASSIGN_OR_RETURN(const SchemaInfo* schema_info, GetSchemaInfo(item.schema));
+    const auto& attr_names = schema_info->attr_names;
+    RETURN_IF_ERROR(VisitSchema(item.schema, *schema_info));
+    if (schema_info->has_list_items_attr) {
       if (attr_names.size() != 1) {
         return absl::InvalidArgumentError(absl::StrFormat(
             "list schema %v has unexpected attributes", item.schema));
       }
-      return VisitList(item, is_object);
-    } else if (has_dict_keys_attr || has_dict_values_attr) {
-      if (attr_names.size() != 2 || !has_dict_keys_attr ||
-          !has_dict_values_attr) {
+      return VisitList(item, is_object, *schema_info);
+    } else if (schema_info->has_dict_keys_attr ||
+               schema_info->has_dict_values_attr) {
+      if (attr_names.size() != 2 || !schema_info->has_dict_keys_attr ||
+          !schema_info->has_dict_values_attr) {
         return absl::InvalidArgumentError(absl::StrFormat(
             "dict schema %v has unexpected attributes", item.schema));
       }
-      return VisitDict(item, is_object);
+      return VisitDict(item, is_object, *schema_info);
     }
     arolla::DenseArrayBuilder<DataItem> attr_values(attr_names.size());
-    absl::Status status = absl::OkStatus();
-    attr_names.ForEach([&](int64_t id, bool presence,
-                           std::string_view attr_name) {
-      DCHECK(presence);
-      if (!status.ok()) {
-        return;
-      }
-      auto attr_item_or = databag_.GetAttr(item.item, attr_name, fallbacks_);
-      if (!attr_item_or.ok()) {
-        status = attr_item_or.status();
-        return;
-      }
-      auto attr_schema_or =
-          databag_.GetSchemaAttr(item.schema, attr_name, fallbacks_);
-      if (!attr_schema_or.ok()) {
-        status = attr_item_or.status();
-        return;
-      }
-      auto value_or = GetValue(*attr_item_or, *attr_schema_or);
-      if (!value_or.ok()) {
-        status = value_or.status();
-        return;
-      }
-      attr_values.Set(id, *value_or);
-    });
-    if (!status.ok()) {
-      return status;
-    }
-    DataItem schema = item.schema;
-    if (is_object) {
-      schema = DataItem(schema::kObject);
+    for (int64_t id = 0; id < attr_names.size(); ++id) {
+      ASSIGN_OR_RETURN(
+          DataItem attr_item,
+          databag_.GetAttr(item.item, attr_names.values[id], fallbacks_));
+      ASSIGN_OR_RETURN(DataItem value,
+                       GetValue(attr_item, schema_info->attr_schemas[id]));
+      attr_values.Set(id, value);
     }
     return visitor_->VisitorT::VisitObject(item.item, item.schema, is_object,
                                             attr_names,
@@ -584,9 +625,10 @@ class Traverser {
       ASSIGN_OR_RETURN(auto dtype, schema::DType::FromQType(item.item.dtype()));
       return VisitPrimitive({.item = item.item, .schema = DataItem(dtype)});
     }
+    static const PreHashedAttr kHashedSchemaAttr(schema::kSchemaAttr);
     ASSIGN_OR_RETURN(
         auto schema,
-        databag_.GetAttr(item.item, schema::kSchemaAttr, fallbacks_));
+        databag_.GetAttr(item.item, kHashedSchemaAttr, fallbacks_));
     if (!schema.is_schema()) {
       return absl::InvalidArgumentError(absl::StrFormat(
           "object %v is expected to have a schema in %s attribute, got %v",
@@ -600,8 +642,14 @@ class Traverser {
     return visitor_->VisitorT::VisitPrimitive(item.item, item.schema);
   }
 
-  absl::Status VisitInPostOrder() {
-    for (auto item : topological_order_) {
+  absl::Status VisitInReverseDiscoveryOrder() {
+    int64_t visited_count = 0;
+    for (auto it = discovery_order_.rbegin(); it != discovery_order_.rend();
+         ++it) {
+      if (++visited_count % kCancellationCheckInterval == 0) {
+        RETURN_IF_ERROR(CheckCancellation());
+      }
+      const ItemWithSchema& item = *it;
       if (item.schema.template holds_value<ObjectId>()) {
         // Entity schema.
         RETURN_IF_ERROR(VisitEntity(item, /*is_object=*/false));
@@ -622,8 +670,14 @@ class Traverser {
  private:
   const DataBagImpl& databag_;
   const DataBagImpl::FallbackSpan fallbacks_;
-  std::stack<ItemWithSchema> previsit_stack_;
-  std::vector<ItemWithSchema> topological_order_;
+  Executor* executor_;
+  // Items previsited, but not processed yet, grouped by schema.
+  std::vector<SchemaGroup> frontier_;
+  absl::flat_hash_map<DataItem, size_t, DataItem::Hash> frontier_index_;
+  std::vector<ItemWithSchema> discovery_order_;
+  // Memoized by GetSchemaInfo. Only used on the calling thread.
+  absl::flat_hash_map<DataItem, std::unique_ptr<SchemaInfo>, DataItem::Hash>
+      schema_infos_;
   std::shared_ptr<VisitorT> visitor_;
 };
 
@@ -0,0 +1,241 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_UNIQUE_H_
+#define KOLADATA_INTERNAL_OP_UTILS_UNIQUE_H_
+
+#include <algorithm>
+#include <cstdint>
+#include <functional>
+#include <type_traits>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/view_types.h"
+
+namespace koladata::internal {
+
+// Groups are not split into chunks smaller than this.
+constexpr int64_t kMinSegmentedUniqueChunkSize = 1 << 16;
+
+// Result of SegmentedUnique.
+struct SegmentedUniqueResult {
+  // Rows of the first occurrences of the distinct values, grouped by the
+  // groups of the input and in the order of the rows within the groups.
+  std::vector<int64_t> rows;
+  // Split points of the groups of `rows`.
+  std::vector<int64_t> split_points;
+};
+
+namespace segmented_unique_impl {
+
+template <typename T>
+struct KeyTraits {
+  using Key = arolla::view_type_t<T>;
+  using Hash = absl::Hash<Key>;
+  using Eq = std::equal_to<Key>;
+};
+
+template <>
+struct KeyTraits<DataItem> {
+  using Key = DataItem;
+  using Hash = DataItem::Hash;
+  using Eq = DataItem::Eq;
+};
+
+constexpr int kPartitionBits = 6;
+constexpr int64_t kNumPartitions = int64_t{1} << kPartitionBits;
+constexpr uint8_t kNoPartition = kNumPartitions;
+
+// Marks the first occurrences of the distinct values of the rows
+// [begin, end) in `is_first`. The rows are radix partitioned by the top bits
+// of the key hashes in chunks processed concurrently, keeping their order
+// within a partition, and then each partition is deduplicated by its own
+// task. The hash sets hold the views of the values, so e.g. strings are not
+// copied.
+template <typename T>
+void MarkFirstOccurrencesPartitioned(const arolla::DenseArray<T>& values,
+                                     int64_t begin, int64_t end,
+                                     int64_t num_chunks, Executor* executor,
+                                     std::vector<uint8_t>& is_first) {
+  using Traits = KeyTraits<T>;
+  const int64_t size = end - begin;
+  const int64_t chunk_size = (size + num_chunks - 1) / num_chunks;
+  std::vector<uint8_t> partition(size);
+  // Number of rows of each partition in each chunk, later converted to the
+  // positions of the chunks in `rows`.
+  std::vector<int64_t> offsets(num_chunks * kNumPartitions, 0);
+  // The chunks never fail.
+  ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+    typename Traits::Hash hasher;
+    int64_t* counts = &offsets[chunk * kNumPartitions];
+    const int64_t chunk_end = std::min(size, (chunk + 1) * chunk_size);
+    for (int64_t i = chunk * chunk_size; i < chunk_end; ++i) {
+      if (!values.present(begin + i)) {
+        partition[i] = kNoPartition;
+        continue;
+      }
+      // The sets use the low bits of the hash, so the partitions use the
+      // (mixed) high ones.
+      const uint64_t hash =
+          static_cast<uint64_t>(hasher(values.values[begin + i])) *
+          0x9E3779B97F4A7C15ull;
+      partition[i] = static_cast<uint8_t>(hash >> (64 - kPartitionBits));
+      ++counts[partition[i]];
+    }
+    return absl::OkStatus();
+  }).IgnoreError();
+  std::vector<int64_t> partition_begin(kNumPartitions + 1);
+  int64_t total = 0;
+  for (int64_t p = 0; p < kNumPartitions; ++p) {
+    partition_begin[p] = total;
+    for (int64_t chunk = 0; chunk < num_chunks; ++chunk) {
+      int64_t& offset = offsets[chunk * kNumPartitions + p];
+      const int64_t count = offset;
+      offset = total;
+      total += count;
+    }
+  }
+  partition_begin[kNumPartitions] = total;
+
+  std::vector<int64_t> rows(total);
+  ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+    int64_t* next = &offsets[chunk * kNumPartitions];
+    const int64_t chunk_end = std::min(size, (chunk + 1) * chunk_size);
+    for (int64_t i = chunk * chunk_size; i < chunk_end; ++i) {
+      if (partition[i] != kNoPartition) {
+        rows[next[partition[i]]++] = i;
+      }
+    }
+    return absl::OkStatus();
+  }).IgnoreError();
+
+  ParallelFor(executor, kNumPartitions, [&](int64_t p) -> absl::Status {
+    absl::flat_hash_set<typename Traits::Key, typename Traits::Hash,
+                        typename Traits::Eq>
+        seen;
+    seen.reserve(partition_begin[p + 1] - partition_begin[p]);
+    for (int64_t j = partition_begin[p]; j < partition_begin[p + 1]; ++j) {
+      const int64_t i = rows[j];
+      is_first[i] = seen.insert(values.values[begin + i]).second;
+    }
+    return absl::OkStatus();
+  }).IgnoreError();
+}
+
+}  // namespace segmented_unique_impl
+
+// Returns the rows of the first occurrences of the distinct present values in
+// each group of the split points `split_points`. The values are compared as
+// views (or as DataItems for mixed slices), so strings are never copied.
+//
+// Groups large enough to be split into chunks of kMinSegmentedUniqueChunkSize
+// rows are deduplicated concurrently using `executor`, by radix partitioning
+// the rows by hash. The result is the same as the sequential one and does not
+// depend on the number of threads.
+template <typename T>
+SegmentedUniqueResult SegmentedUnique(const arolla::DenseArray<T>& values,
+                                      absl::Span<const int64_t> split_points,
+                                      Executor* executor) {
+  using Traits = segmented_unique_impl::KeyTraits<T>;
+  SegmentedUniqueResult result;
+  result.split_points.reserve(split_points.size());
+  result.split_points.push_back(0);
+  // The value is the last group the key was seen in, so the map is not
+  // cleared between the groups.
+  absl::flat_hash_map<typename Traits::Key, int64_t, typename Traits::Hash,
+                      typename Traits::Eq>
+      last_group;
+  std::vector<uint8_t> is_first;
+  for (int64_t group = 0; group + 1 < split_points.size(); ++group) {
+    const int64_t begin = split_points[group];
+    const int64_t end = split_points[group + 1];
+    const int64_t num_chunks =
+        ParallelChunkCount(executor, end - begin, kMinSegmentedUniqueChunkSize);
+    if (num_chunks > 1) {
+      is_first.assign(end - begin, 0);
+      segmented_unique_impl::MarkFirstOccurrencesPartitioned(
+          values, begin, end, num_chunks, executor, is_first);
+      for (int64_t i = 0; i < end - begin; ++i) {
+        if (is_first[i]) {
+          result.rows.push_back(begin + i);
+        }
+      }
+    } else {
+      for (int64_t i = begin; i < end; ++i) {
+        if (!values.present(i)) {
+          continue;
+        }
+        auto [it, inserted] = last_group.emplace(values.values[i], group);
+        if (inserted || it->second != group) {
+          result.rows.push_back(i);
+          it->second = group;
+        }
+      }
+    }
+    result.split_points.push_back(result.rows.size());
+  }
+  return result;
+}
+
+// Sorts the rows of each group of `result` by their values in `values`. Large
+// groups are sorted in chunks concurrently using `executor`, which are then
+// merged pairwise, also concurrently. `T` must be sortable.
+template <typename T>
+void SortUniqueRows(const arolla::DenseArray<T>& values,
+                    SegmentedUniqueResult& result, Executor* executor) {
+  auto less = [&](int64_t a, int64_t b) {
+    return values.values[a] < values.values[b];
+  };
+  for (int64_t group = 0; group + 1 < result.split_points.size(); ++group) {
+    auto group_begin = result.rows.begin() + result.split_points[group];
+    const int64_t size =
+        result.split_points[group + 1] - result.split_points[group];
+    const int64_t num_chunks =
+        ParallelChunkCount(executor, size, kMinSegmentedUniqueChunkSize);
+    if (num_chunks <= 1) {
+      std::sort(group_begin, group_begin + size, less);
+      continue;
+    }
+    const int64_t chunk_size = (size + num_chunks - 1) / num_chunks;
+    auto chunk_bound = [&](int64_t chunk) {
+      return group_begin + std::min(size, chunk * chunk_size);
+    };
+    // The tasks never fail.
+    ParallelFor(executor, num_chunks, [&](int64_t chunk) -> absl::Status {
+      std::sort(chunk_bound(chunk), chunk_bound(chunk + 1), less);
+      return absl::OkStatus();
+    }).IgnoreError();
+    for (int64_t width = 1; width < num_chunks; width *= 2) {
+      const int64_t num_merges = (num_chunks + 2 * width - 1) / (2 * width);
+      ParallelFor(executor, num_merges, [&](int64_t merge) -> absl::Status {
+        const int64_t first = merge * 2 * width;
+        std::inplace_merge(chunk_bound(first), chunk_bound(first + width),
+                           chunk_bound(first + 2 * width), less);
+        return absl::OkStatus();
+      }).IgnoreError();
+    }
+  }
+}
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_UNIQUE_H_
@@ -0,0 +1,92 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/unique.h"
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/strings/str_cat.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
+
+TEST(SegmentedUniqueTest, SmallGroups) {
+  auto values = arolla::CreateDenseArray<int>(
+      {1, 2, 1, std::nullopt, 3, 3, 2, std::nullopt});
+  std::vector<int64_t> split_points = {0, 4, 4, 7, 8};
+  SegmentedUniqueResult result =
+      SegmentedUnique(values, split_points, /*executor=*/nullptr);
+  EXPECT_THAT(result.rows, ElementsAre(0, 1, 4, 6));
+  EXPECT_THAT(result.split_points, ElementsAre(0, 2, 2, 4, 4));
+
+  SortUniqueRows(values, result, nullptr);
+  EXPECT_THAT(result.rows, ElementsAre(0, 1, 6, 4));
+}
+
+TEST(SegmentedUniqueTest, MixedTypes) {
+  auto values = arolla::CreateFullDenseArray<DataItem>(
+      {DataItem(1), DataItem(int64_t{1}), DataItem(arolla::Text("a")),
+       DataItem(1), DataItem(arolla::Text("a"))});
+  std::vector<int64_t> split_points = {0, 5};
+  SegmentedUniqueResult result = SegmentedUnique(values, split_points, nullptr);
+  EXPECT_THAT(result.rows, ElementsAre(0, 1, 2));
+}
+
+TEST(SegmentedUniqueTest, ParallelMatchesSequential) {
+  // One large text group, which is partitioned, and a few small ones.
+  constexpr int64_t kLargeSize = 10 * kMinSegmentedUniqueChunkSize + 7;
+  std::vector<std::optional<arolla::Text>> texts;
+  for (int64_t i = 0; i < kLargeSize + 100; ++i) {
+    if (i % 13 == 0) {
+      texts.push_back(std::nullopt);
+    } else {
+      texts.push_back(arolla::Text(absl::StrCat("v", (i * 7919) % 50000)));
+    }
+  }
+  auto values = arolla::CreateDenseArray<arolla::Text>(texts);
+  std::vector<int64_t> split_points = {0, 30, kLargeSize, kLargeSize + 100};
+  SegmentedUniqueResult sequential =
+      SegmentedUnique(values, split_points, nullptr);
+  ThreadPoolExecutor executor(4);
+  SegmentedUniqueResult parallel =
+      SegmentedUnique(values, split_points, &executor);
+  EXPECT_THAT(parallel.rows, ElementsAreArray(sequential.rows));
+  EXPECT_THAT(parallel.split_points,
+              ElementsAreArray(sequential.split_points));
+  EXPECT_EQ(sequential.split_points[2] - sequential.split_points[1], 50000);
+
+  SortUniqueRows(values, sequential, nullptr);
+  SortUniqueRows(values, parallel, &executor);
+  EXPECT_THAT(parallel.rows, ElementsAreArray(sequential.rows));
+  for (int64_t i = sequential.split_points[1] + 1;
+       i < sequential.split_points[2]; ++i) {
+    ASSERT_LT(values[sequential.rows[i - 1]].value,
+              values[sequential.rows[i]].value);
+  }
+}
+
+}  // namespace
+}  // namespace koladata::internal
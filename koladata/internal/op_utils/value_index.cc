@@ -0,0 +1,74 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/value_index.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/types/span.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+
+namespace koladata::internal {
+
+ValueIndex::ValueIndex(const DataSliceImpl& values) : size_(values.size()) {
+  // Counting sort by the id of the distinct value keeps the positions sorted
+  // within each value.
+  absl::flat_hash_map<DataItem, int64_t, DataItem::Hash, DataItem::Eq> ids;
+  std::vector<int64_t> value_ids(size_, -1);
+  std::vector<int64_t> counts;
+  for (int64_t i = 0; i < size_; ++i) {
+    DataItem item = values[i];
+    if (!item.has_value()) {
+      continue;
+    }
+    auto [it, inserted] = ids.emplace(std::move(item), counts.size());
+    if (inserted) {
+      counts.push_back(0);
+    }
+    value_ids[i] = it->second;
+    ++counts[it->second];
+  }
+  std::vector<int64_t> offsets(counts.size() + 1, 0);
+  for (int64_t id = 0; id < counts.size(); ++id) {
+    offsets[id + 1] = offsets[id] + counts[id];
+  }
+  positions_.resize(offsets.back());
+  std::vector<int64_t> next(offsets.begin(), offsets.end() - 1);
+  for (int64_t i = 0; i < size_; ++i) {
+    if (value_ids[i] >= 0) {
+      positions_[next[value_ids[i]]++] = i;
+    }
+  }
+  ranges_.reserve(ids.size());
+  for (auto& [value, id] : ids) {
+    ranges_.emplace(value, std::make_pair(offsets[id], offsets[id + 1]));
+  }
+}
+
+absl::Span<const int64_t> ValueIndex::Find(const DataItem& value) const {
+  if (!value.has_value()) {
+    return {};
+  }
+  auto it = ranges_.find(value);
+  if (it == ranges_.end()) {
+    return {};
+  }
+  auto [begin, end] = it->second;
+  return absl::MakeConstSpan(positions_).subspan(begin, end - begin);
+}
+
+}  // namespace koladata::internal
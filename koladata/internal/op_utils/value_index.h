@@ -0,0 +1,58 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_OP_UTILS_VALUE_INDEX_H_
+#define KOLADATA_INTERNAL_OP_UTILS_VALUE_INDEX_H_
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/types/span.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+
+namespace koladata::internal {
+
+// Inverted index over the items of `values`: maps every present value to the
+// sorted positions of `values` holding it. Unlike KeyIndex, duplicates are
+// expected, e.g. `values` are the attributes of a set of objects and the index
+// answers "which objects have attr == v" in O(matches).
+//
+// Values are compared as DataItems, so values of different types never match.
+class ValueIndex {
+ public:
+  explicit ValueIndex(const DataSliceImpl& values);
+
+  int64_t size() const { return size_; }
+  int64_t distinct_value_count() const { return ranges_.size(); }
+
+  // Returns the sorted positions of the items equal to `value`. Returns an
+  // empty span if `value` is missing or not present in the index.
+  absl::Span<const int64_t> Find(const DataItem& value) const;
+
+ private:
+  int64_t size_;
+  // Positions grouped by value; within a group they are sorted.
+  std::vector<int64_t> positions_;
+  // Value -> [begin, end) range in `positions_`.
+  absl::flat_hash_map<DataItem, std::pair<int64_t, int64_t>, DataItem::Hash,
+                      DataItem::Eq>
+      ranges_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_OP_UTILS_VALUE_INDEX_H_
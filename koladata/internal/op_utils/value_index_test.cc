@@ -0,0 +1,66 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/op_utils/value_index.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::arolla::CreateDenseArray;
+using ::arolla::Text;
+using ::testing::ElementsAre;
+using ::testing::IsEmpty;
+
+TEST(ValueIndexTest, Int64) {
+  ValueIndex index(DataSliceImpl::Create(
+      CreateDenseArray<int64_t>({1, 2, std::nullopt, 2, 1, 2})));
+  EXPECT_EQ(index.size(), 6);
+  EXPECT_EQ(index.distinct_value_count(), 2);
+  EXPECT_THAT(index.Find(DataItem(int64_t{1})), ElementsAre(0, 4));
+  EXPECT_THAT(index.Find(DataItem(int64_t{2})), ElementsAre(1, 3, 5));
+  EXPECT_THAT(index.Find(DataItem(int64_t{3})), IsEmpty());
+  EXPECT_THAT(index.Find(DataItem()), IsEmpty());
+  // Values of other types never match.
+  EXPECT_THAT(index.Find(DataItem(1)), IsEmpty());
+}
+
+TEST(ValueIndexTest, Mixed) {
+  auto values = DataSliceImpl::Create(
+      CreateDenseArray<Text>({Text("a"), std::nullopt, Text("b"), Text("a")}),
+      CreateDenseArray<int>({std::nullopt, 1, std::nullopt, std::nullopt}));
+  ValueIndex index(values);
+  EXPECT_EQ(index.distinct_value_count(), 3);
+  EXPECT_THAT(index.Find(DataItem(Text("a"))), ElementsAre(0, 3));
+  EXPECT_THAT(index.Find(DataItem(1)), ElementsAre(1));
+}
+
+TEST(ValueIndexTest, Empty) {
+  ValueIndex index(DataSliceImpl::CreateEmptyAndUnknownType(3));
+  EXPECT_EQ(index.size(), 3);
+  EXPECT_EQ(index.distinct_value_count(), 0);
+  EXPECT_THAT(index.Find(DataItem(1)), IsEmpty());
+}
+
+}  // namespace
+}  // namespace koladata::internal
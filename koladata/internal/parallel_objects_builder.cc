@@ -0,0 +1,113 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/parallel_objects_builder.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/btree_set.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/status_macros_backport.h"
+#include "arolla/util/view_types.h"
+
+namespace koladata::internal {
+
+ParallelObjectsBuilder::ParallelObjectsBuilder(
+    absl::Span<const int64_t> part_sizes)
+    : part_begins_(part_sizes.size() + 1, 0),
+      part_attrs_(part_sizes.size()) {
+  for (int64_t part = 0; part < part_sizes.size(); ++part) {
+    DCHECK_GE(part_sizes[part], 0);
+    part_begins_[part + 1] = part_begins_[part] + part_sizes[part];
+  }
+  alloc_id_ = Allocate(size());
+}
+
+DataSliceImpl ParallelObjectsBuilder::PartObjects(int64_t part) const {
+  const int64_t begin = part_begin(part);
+  arolla::DenseArrayBuilder<ObjectId> bldr(part_size(part));
+  for (int64_t i = 0; i < part_size(part); ++i) {
+    bldr.Set(i, alloc_id_.ObjectByOffset(begin + i));
+  }
+  return DataSliceImpl::CreateObjectsDataSlice(std::move(bldr).Build(),
+                                              AllocationIdSet(alloc_id_));
+}
+
+absl::Status ParallelObjectsBuilder::SetAttr(int64_t part,
+                                             absl::string_view attr,
+                                             DataSliceImpl values) {
+  if (values.size() != part_size(part)) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("size mismatch for attribute '", attr, "' of part ", part,
+                     ": ", values.size(), " != ", part_size(part)));
+  }
+  part_attrs_[part].insert_or_assign(attr, std::move(values));
+  return absl::OkStatus();
+}
+
+absl::StatusOr<DataSliceImpl> ParallelObjectsBuilder::Build(
+    DataBagImpl& db, Executor* executor) && {
+  absl::btree_set<std::string> attr_set;
+  for (const auto& attrs : part_attrs_) {
+    for (const auto& [attr, _] : attrs) {
+      attr_set.insert(attr);
+    }
+  }
+  std::vector<std::string> attr_names(attr_set.begin(), attr_set.end());
+  // Every attribute is combined by a single task, which only reads the parts.
+  std::vector<DataSliceImpl> attr_values(attr_names.size());
+  RETURN_IF_ERROR(ParallelFor(
+      executor, attr_names.size(), [&](int64_t attr_index) -> absl::Status {
+        DataSliceImpl::Builder bldr(size());
+        for (int64_t part = 0; part < part_count(); ++part) {
+          auto it = part_attrs_[part].find(attr_names[attr_index]);
+          if (it == part_attrs_[part].end()) {
+            continue;
+          }
+          const DataSliceImpl& values = it->second;
+          const int64_t offset = part_begin(part);
+          values.VisitValues([&]<class T>(const arolla::DenseArray<T>& array) {
+            auto& array_bldr = bldr.GetArrayBuilder<T>();
+            array.ForEachPresent([&](int64_t id, arolla::view_type_t<T> v) {
+              array_bldr.Set(offset + id, v);
+            });
+          });
+          bldr.GetMutableAllocationIds().Insert(values.allocation_ids());
+        }
+        attr_values[attr_index] = std::move(bldr).Build();
+        return absl::OkStatus();
+      }));
+  for (int64_t i = 0; i < attr_names.size(); ++i) {
+    RETURN_IF_ERROR(
+        db.SetAttrForEntireAllocation(alloc_id_, attr_names[i],
+                                      attr_values[i]));
+  }
+  part_attrs_.clear();
+  return DataSliceImpl::ObjectsFromAllocation(alloc_id_, size());
+}
+
+}  // namespace koladata::internal
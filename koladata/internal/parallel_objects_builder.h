@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_PARALLEL_OBJECTS_BUILDER_H_
+#define KOLADATA_INTERNAL_PARALLEL_OBJECTS_BUILDER_H_
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+
+namespace koladata::internal {
+
+// Creates objects with attributes from several threads, like
+// DataBagImpl::CreateObjectsFromFields does for a single thread.
+//
+// Objects allocated by different threads come from their thread local pools
+// (see object_id.h), so a slice combined from them spans many allocations with
+// a source each. Instead, the builder reserves a single allocation upfront and
+// splits it into disjoint ranges of offsets ("parts"), e.g. one per worker.
+// The attribute values of each part are set independently, without locking.
+// Build stores them in a DataBagImpl as a single dense source per attribute.
+class ParallelObjectsBuilder {
+ public:
+  // Reserves an allocation for the objects of all the parts, part `i` having
+  // `part_sizes[i]` objects.
+  explicit ParallelObjectsBuilder(absl::Span<const int64_t> part_sizes);
+
+  int64_t part_count() const { return part_begins_.size() - 1; }
+
+  // Returns the total number of objects.
+  int64_t size() const { return part_begins_.back(); }
+
+  AllocationId alloc_id() const { return alloc_id_; }
+
+  // Returns the offset in the allocation of the first object of `part`.
+  int64_t part_begin(int64_t part) const { return part_begins_[part]; }
+
+  int64_t part_size(int64_t part) const {
+    return part_begins_[part + 1] - part_begins_[part];
+  }
+
+  // Returns the objects of `part`.
+  DataSliceImpl PartObjects(int64_t part) const;
+
+  // Sets the attribute `attr` of the objects of `part`. The size of `values`
+  // must be equal to part_size(part). Calls for different parts can be done
+  // concurrently, calls for the same part can not.
+  absl::Status SetAttr(int64_t part, absl::string_view attr,
+                       DataSliceImpl values);
+
+  // Stores the attributes set so far into `db` and returns all the objects.
+  // The attributes missing in some parts are missing for their objects. The
+  // attributes are combined concurrently using `executor`.
+  absl::StatusOr<DataSliceImpl> Build(DataBagImpl& db,
+                                      Executor* executor) &&;
+
+ private:
+  AllocationId alloc_id_;
+  std::vector<int64_t> part_begins_;
+  // Attribute values per part. Each part is only accessed by its writer.
+  std::vector<absl::flat_hash_map<std::string, DataSliceImpl>> part_attrs_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_PARALLEL_OBJECTS_BUILDER_H_
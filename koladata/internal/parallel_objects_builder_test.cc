@@ -0,0 +1,105 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/parallel_objects_builder.h"
+
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
+
+TEST(ParallelObjectsBuilderTest, Parts) {
+  ParallelObjectsBuilder builder({3, 0, 2});
+  EXPECT_EQ(builder.part_count(), 3);
+  EXPECT_EQ(builder.size(), 5);
+  EXPECT_EQ(builder.part_begin(2), 3);
+  EXPECT_EQ(builder.part_size(1), 0);
+  DataSliceImpl objects = builder.PartObjects(2);
+  ASSERT_EQ(objects.size(), 2);
+  EXPECT_EQ(objects[0], DataItem(builder.alloc_id().ObjectByOffset(3)));
+  EXPECT_EQ(objects[1], DataItem(builder.alloc_id().ObjectByOffset(4)));
+  EXPECT_THAT(builder.SetAttr(0, "a", DataSliceImpl::Create(
+                                          arolla::CreateDenseArray<int>({1}))),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("size mismatch")));
+}
+
+TEST(ParallelObjectsBuilderTest, Build) {
+  constexpr int64_t kPartCount = 8;
+  constexpr int64_t kPartSize = 1000;
+  ParallelObjectsBuilder builder(std::vector<int64_t>(kPartCount, kPartSize));
+  EXPECT_FALSE(builder.alloc_id().IsSmall());
+  ThreadPoolExecutor executor(4);
+  ASSERT_OK(ParallelFor(
+      &executor, kPartCount, [&](int64_t part) -> absl::Status {
+        arolla::DenseArrayBuilder<int64_t> a_bldr(kPartSize);
+        for (int64_t i = 0; i < kPartSize; ++i) {
+          if (i % 3 != 0) {
+            a_bldr.Set(i, part * kPartSize + i);
+          }
+        }
+        absl::Status status = builder.SetAttr(
+            part, "a", DataSliceImpl::Create(std::move(a_bldr).Build()));
+        // Only the even parts have "b", and of different types.
+        if (status.ok() && part % 2 == 0) {
+          DataItem b = part % 4 == 0 ? DataItem(arolla::Text("x"))
+                                     : DataItem(static_cast<int>(part));
+          status =
+              builder.SetAttr(part, "b", DataSliceImpl::Create(kPartSize, b));
+        }
+        return status;
+      }));
+
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  AllocationId alloc_id = builder.alloc_id();
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl objects,
+                       std::move(builder).Build(*db, &executor));
+  ASSERT_EQ(objects.size(), kPartCount * kPartSize);
+  EXPECT_EQ(objects.allocation_ids().ids().size(), 1);
+  EXPECT_EQ(objects[0], DataItem(alloc_id.ObjectByOffset(0)));
+
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl a, db->GetAttr(objects, "a"));
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl b, db->GetAttr(objects, "b"));
+  for (int64_t i = 0; i < objects.size(); ++i) {
+    const int64_t part = i / kPartSize;
+    ASSERT_EQ(a[i], i % kPartSize % 3 == 0 ? DataItem() : DataItem(i)) << i;
+    DataItem expected_b;
+    if (part % 4 == 0) {
+      expected_b = DataItem(arolla::Text("x"));
+    } else if (part % 2 == 0) {
+      expected_b = DataItem(static_cast<int>(part));
+    }
+    ASSERT_EQ(b[i], expected_b) << i;
+  }
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -15,7 +15,6 @@
 #include "koladata/internal/schema_utils.h"
 
 #include <array>
-#include <bitset>
 #include <cstddef>
 #include <cstdint>
 #include <optional>
@@ -28,7 +27,6 @@
 #include "absl/container/flat_hash_map.h"
 #include "absl/functional/overload.h"
 #include "absl/log/check.h"
-#include "absl/log/log.h"
 #include "absl/numeric/bits.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
@@ -47,120 +45,161 @@
 
 namespace koladata::schema {
 
+namespace {
+
+using DTypeMask = uint16_t;
+static_assert(kNextDTypeId <= sizeof(DTypeMask) * 8);
+
+template <typename... DTypes>
+constexpr DTypeMask GetDTypeMask(DTypes... dtypes) {
+  return ((DTypeMask{1} << dtypes.type_id()) | ... | DTypeMask{0});
+}
+
+// A row of the DType lattice: a DType and its directly adjacent greater
+// DTypes.
+struct DTypeLatticeRow {
+  DType dtype;
+  DTypeMask adjacent;
+};
+
 // Adjacency list representation of the DType lattice.
 //
 // Each "row" in the lattice represents a DType, and each "column" represents a
 // directly adjacent greater DType.
-const schema_internal::DTypeLattice& schema_internal::GetDTypeLattice() {
-  static const absl::NoDestructor<DTypeLattice> lattice({
-      {kNone, {kItemId, kSchema, kInt32, kMask, kBool, kBytes, kText, kExpr}},
-      {kItemId, {}},
-      {kSchema, {}},
-      {kInt32, {kInt64}},
-      {kInt64, {kFloat32}},
-      {kFloat32, {kFloat64}},
-      {kFloat64, {kObject}},
-      {kMask, {kObject}},
-      {kBool, {kObject}},
-      {kBytes, {kObject}},
-      {kText, {kObject}},
-      {kExpr, {kObject}},
-      {kObject, {kAny}},
-      {kAny, {}},
-  });
-  return *lattice;
-}
-
-namespace {
+constexpr DTypeLatticeRow kDTypeLatticeRows[] = {
+    {kNone, GetDTypeMask(kItemId, kSchema, kInt32, kMask, kBool, kBytes, kText,
+                         kExpr)},
+    {kItemId, GetDTypeMask()},
+    {kSchema, GetDTypeMask()},
+    {kInt32, GetDTypeMask(kInt64)},
+    {kInt64, GetDTypeMask(kFloat32)},
+    {kFloat32, GetDTypeMask(kFloat64)},
+    {kFloat64, GetDTypeMask(kObject)},
+    {kMask, GetDTypeMask(kObject)},
+    {kBool, GetDTypeMask(kObject)},
+    {kBytes, GetDTypeMask(kObject)},
+    {kText, GetDTypeMask(kObject)},
+    {kExpr, GetDTypeMask(kObject)},
+    {kObject, GetDTypeMask(kAny)},
+    {kAny, GetDTypeMask()},
+};
 
 constexpr DTypeId kUnknownDType = -1;
 
-// Matrix representation of the DTypeLattice.
-class DTypeMatrix {
-  using MatrixImpl =
-      std::array<std::array<DTypeId, kNextDTypeId>, kNextDTypeId>;
-
- public:
-  // Returns the common dtype of `a` and `b`.
-  //
-  // Requires the inputs to be in [0, kNextDTypeId). Returns kUnknownDType if no
-  // common dtype exists.
-  static DTypeId CommonDType(DTypeId a, DTypeId b) {
-    DCHECK_GE(a, 0);
-    DCHECK_LT(a, kNextDTypeId);
-    const auto& dtype_matrix = GetMatrixImpl();
-    return dtype_matrix[a][b];
-  }
+using DTypeMatrix = std::array<std::array<DTypeId, kNextDTypeId>, kNextDTypeId>;
 
- private:
-  // Returns a matrix where m[i][j] is true iff j is reachable from i.
-  static std::array<std::bitset<kNextDTypeId>, kNextDTypeId>
-  GetReachableDTypes() {
-    const auto& lattice = schema_internal::GetDTypeLattice();
-    // Initialize the adjacency matrix.
-    std::array<std::bitset<kNextDTypeId>, kNextDTypeId> reachable_dtypes;
-    for (const auto& [dtype_a, adjacent_dtypes] : lattice) {
-      auto dtype_a_int = dtype_a.type_id();
-      reachable_dtypes[dtype_a_int][dtype_a_int] = true;
-      for (const auto dtype_b : adjacent_dtypes) {
-        reachable_dtypes[dtype_a_int][dtype_b.type_id()] = true;
+// Returns an array where bit j of the i-th element is set iff j is reachable
+// from i in the lattice.
+constexpr std::array<DTypeMask, kNextDTypeId> GetReachableDTypes() {
+  std::array<DTypeMask, kNextDTypeId> reachable_dtypes = {};
+  for (const DTypeLatticeRow& row : kDTypeLatticeRows) {
+    reachable_dtypes[row.dtype.type_id()] =
+        GetDTypeMask(row.dtype) | row.adjacent;
+  }
+  // Floyd-Warshall to find all reachable nodes.
+  for (DTypeId k = 0; k < kNextDTypeId; ++k) {
+    for (DTypeId i = 0; i < kNextDTypeId; ++i) {
+      if (reachable_dtypes[i] & (DTypeMask{1} << k)) {
+        reachable_dtypes[i] |= reachable_dtypes[k];
       }
     }
-    // Floyd-Warshall to find all reachable nodes.
-    for (DTypeId k = 0; k < kNextDTypeId; ++k) {
-      for (DTypeId i = 0; i < kNextDTypeId; ++i) {
-        if (reachable_dtypes[i][k]) {
-          reachable_dtypes[i] |= reachable_dtypes[k];
+  }
+  return reachable_dtypes;
+}
+
+// Returns the common dtype of every pair of dtypes.
+//
+// Represented as a 2-dim array of size kNextDTypeId x kNextDTypeId, where the
+// value at index [i, j] is the common dtype of dtype i and dtype j. If
+// no such dtype exists, the value is kUnknownDType.
+//
+// See http://shortn/_icYRr51SOr for a proof of correctness.
+constexpr DTypeMatrix GetCommonDTypeMatrix() {
+  const auto reachable_dtypes = GetReachableDTypes();
+  DTypeMatrix matrix = {};
+  for (DTypeId a = 0; a < kNextDTypeId; ++a) {
+    for (DTypeId b = 0; b < kNextDTypeId; ++b) {
+      // Compute the common upper bound.
+      DTypeMask cub = reachable_dtypes[a] & reachable_dtypes[b];
+      int cub_count = absl::popcount(cub);
+      matrix[a][b] = kUnknownDType;
+      // Find the unique least upper bound of the common upper bounds. This is
+      // the DType in `cub` where all common upper bounds are reachable from
+      // it.
+      for (DTypeId i = 0; cub_count != 0 && i < kNextDTypeId; ++i) {
+        if ((cub & (DTypeMask{1} << i)) &&
+            cub_count == absl::popcount(reachable_dtypes[i])) {
+          matrix[a][b] = i;
         }
       }
     }
-    return reachable_dtypes;
   }
+  return matrix;
+}
 
-  // Computes the common dtype matrix.
-  //
-  // Represented as a 2-dim array of size kNextDTypeId x kNextDTypeId, where the
-  // value at index [i, j] is the common dtype of dtype i and dtype j. If
-  // no such dtype exists, the value is kUnknownDType.
-  //
-  // See http://shortn/_icYRr51SOr for a proof of correctness.
-  static const MatrixImpl& GetMatrixImpl() {
-    static const MatrixImpl matrix = [] {
-      const auto reachable_dtypes = GetReachableDTypes();
-      auto get_common_dtype = [&reachable_dtypes](DTypeId a, DTypeId b) {
-        // Compute the common upper bound.
-        auto cub = reachable_dtypes[a] & reachable_dtypes[b];
-        size_t cub_count = cub.count();
-        if (cub_count == 0) {
-          return kUnknownDType;
-        }
-        // Find the unique least upper bound of the common upper bounds. This is
-        // the DType in `cub` where all common upper bounds are reachable from
-        // it.
-        for (DTypeId i = 0; i < kNextDTypeId; ++i) {
-          if (cub[i] && cub_count == reachable_dtypes[i].count()) {
-            return i;
-          }
-        }
-        LOG(FATAL) << DType(static_cast<DTypeId>(a)) << " and "
-                   << DType(static_cast<DTypeId>(b))
-                   << " do not have a unique upper bound DType "
-                      "- the DType lattice is malformed";
-      };
-      MatrixImpl matrix;
-      for (DTypeId i = 0; i < kNextDTypeId; ++i) {
-        for (DTypeId j = 0; j < kNextDTypeId; ++j) {
-          matrix[i][j] = get_common_dtype(i, j);
-        }
+// The common dtype matrix, computed at compile time so that looking up a
+// common dtype is a single load.
+constexpr DTypeMatrix kCommonDTypeMatrix = GetCommonDTypeMatrix();
+
+// Returns true iff every pair of dtypes with common upper bounds has a least
+// upper bound.
+constexpr bool IsDTypeLatticeWellFormed() {
+  const auto reachable_dtypes = GetReachableDTypes();
+  for (DTypeId a = 0; a < kNextDTypeId; ++a) {
+    for (DTypeId b = 0; b < kNextDTypeId; ++b) {
+      if ((reachable_dtypes[a] & reachable_dtypes[b]) != 0 &&
+          kCommonDTypeMatrix[a][b] == kUnknownDType) {
+        return false;
       }
-      return matrix;
-    }();
-    return matrix;
+    }
   }
-};
+  return true;
+}
+static_assert(IsDTypeLatticeWellFormed(),
+              "the DType lattice is malformed: some DTypes do not have a "
+              "unique upper bound DType");
+
+// Returns the common dtype of `a` and `b`.
+//
+// Requires the inputs to be in [0, kNextDTypeId). Returns kUnknownDType if no
+// common dtype exists.
+DTypeId CommonDType(DTypeId a, DTypeId b) {
+  DCHECK_GE(a, 0);
+  DCHECK_LT(a, kNextDTypeId);
+  return kCommonDTypeMatrix[a][b];
+}
+
+// Returns the "no common schema" error. The payload is only created if the
+// error is rendered.
+absl::Status NoCommonSchemaError(internal::DataItem common_schema,
+                                 internal::DataItem conflicting_schema) {
+  return internal::WithLazyErrorPayload(
+      absl::InvalidArgumentError("no common schema"),
+      [common_schema = std::move(common_schema),
+       conflicting_schema = std::move(conflicting_schema)]() {
+        return internal::CreateNoCommonSchemaError(common_schema,
+                                                   conflicting_schema);
+      });
+}
 
 }  // namespace
 
+const schema_internal::DTypeLattice& schema_internal::GetDTypeLattice() {
+  static const absl::NoDestructor<DTypeLattice> lattice([] {
+    DTypeLattice lattice;
+    for (const DTypeLatticeRow& row : kDTypeLatticeRows) {
+      auto& adjacent_dtypes = lattice[row.dtype];
+      for (DTypeId i = 0; i < kNextDTypeId; ++i) {
+        if (row.adjacent & (DTypeMask{1} << i)) {
+          adjacent_dtypes.push_back(DType(i));
+        }
+      }
+    }
+    return lattice;
+  }());
+  return *lattice;
+}
+
 std::optional<DType> schema_internal::CommonDTypeAggregator::Get(
     absl::Status& status) const {
   if (seen_dtypes_ == 0) {
@@ -174,13 +213,11 @@ std::optional<DType> schema_internal::CommonDTypeAggregator::Get(
       return DType(res_dtype_id);
     }
     DTypeId i = absl::countr_zero(mask);
-    DTypeId common_dtype_id = DTypeMatrix::CommonDType(res_dtype_id, i);
+    DTypeId common_dtype_id = CommonDType(res_dtype_id, i);
     if (ABSL_PREDICT_FALSE(common_dtype_id == kUnknownDType)) {
-      status = internal::WithErrorPayload(
-          absl::InvalidArgumentError("no common schema"),
-          CreateNoCommonSchemaError(
-              /*common_schema=*/internal::DataItem(DType(res_dtype_id)),
-              /*conflicting_schema=*/internal::DataItem(DType(i))));
+      status = NoCommonSchemaError(
+          /*common_schema=*/internal::DataItem(DType(res_dtype_id)),
+          /*conflicting_schema=*/internal::DataItem(DType(i)));
       return std::nullopt;
     }
     res_dtype_id = common_dtype_id;
@@ -212,11 +249,9 @@ void CommonSchemaAggregator::Add(internal::ObjectId schema_obj) {
     return;
   }
   if (*res_object_id_ != schema_obj) {
-    status_ = internal::WithErrorPayload(
-        absl::InvalidArgumentError("no common schema"),
-        CreateNoCommonSchemaError(
-            /*common_schema=*/internal::DataItem(*res_object_id_),
-            /*conflicting_schema=*/internal::DataItem(schema_obj)));
+    status_ = NoCommonSchemaError(
+        /*common_schema=*/internal::DataItem(*res_object_id_),
+        /*conflicting_schema=*/internal::DataItem(schema_obj));
   }
 }
 
@@ -236,11 +271,31 @@ absl::StatusOr<internal::DataItem> CommonSchemaAggregator::Get() && {
     DCHECK(!res_dtype);
     return internal::DataItem(kObject);
   }
-  return WithErrorPayload(
-      absl::InvalidArgumentError("no common schema"),
-      CreateNoCommonSchemaError(
-          /*common_schema=*/internal::DataItem(*res_dtype),
-          /*conflicting_schema=*/internal::DataItem(*res_object_id_)));
+  return NoCommonSchemaError(
+      /*common_schema=*/internal::DataItem(*res_dtype),
+      /*conflicting_schema=*/internal::DataItem(*res_object_id_));
+}
+
+absl::StatusOr<internal::DataItem> CommonSchema(DType lhs, DType rhs) {
+  if (DTypeId common_dtype_id = CommonDType(lhs.type_id(), rhs.type_id());
+      ABSL_PREDICT_TRUE(common_dtype_id != kUnknownDType)) {
+    return internal::DataItem(DType(common_dtype_id));
+  }
+  CommonSchemaAggregator agg;
+  agg.Add(lhs);
+  agg.Add(rhs);
+  return std::move(agg).Get();
+}
+
+absl::StatusOr<internal::DataItem> CommonSchema(const internal::DataItem& lhs,
+                                                const internal::DataItem& rhs) {
+  if (lhs.holds_value<DType>() && rhs.holds_value<DType>()) {
+    return CommonSchema(lhs.value<DType>(), rhs.value<DType>());
+  }
+  CommonSchemaAggregator agg;
+  agg.Add(lhs);
+  agg.Add(rhs);
+  return std::move(agg).Get();
 }
 
 absl::StatusOr<internal::DataItem> CommonSchema(
@@ -110,20 +110,11 @@ inline absl::StatusOr<internal::DataItem> CommonSchema(
 // be determined, appropriate error is returned. If both lhs and rhs are
 // missing, `kObject` is returned.
 //
-// This is a convenience wrapper around CommonSchemaAggregator on two elements.
-inline absl::StatusOr<internal::DataItem> CommonSchema(DType lhs, DType rhs) {
-  CommonSchemaAggregator agg;
-  agg.Add(lhs);
-  agg.Add(rhs);
-  return std::move(agg).Get();
-}
-inline absl::StatusOr<internal::DataItem> CommonSchema(
-    const internal::DataItem& lhs, const internal::DataItem& rhs) {
-  CommonSchemaAggregator agg;
-  agg.Add(lhs);
-  agg.Add(rhs);
-  return std::move(agg).Get();
-}
+// Equivalent to CommonSchemaAggregator on two elements. The common dtype of
+// two dtypes is looked up in a table precomputed at compile time.
+absl::StatusOr<internal::DataItem> CommonSchema(DType lhs, DType rhs);
+absl::StatusOr<internal::DataItem> CommonSchema(const internal::DataItem& lhs,
+                                                const internal::DataItem& rhs);
 
 // Finds the supremum schema of all schemas in `schema_ids` according to the
 // type promotion lattice defined in go/koda-type-promotion. If common /
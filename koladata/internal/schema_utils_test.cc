@@ -175,6 +175,22 @@ INSTANTIATE_TEST_SUITE_P(
                           info.param.expected_dtype);
     });
 
+TEST(SchemaUtilsTest, CommonSchemaBinaryMatchesAggregator) {
+  // The binary overloads use a precomputed table.
+  for (DTypeId i = 0; i < kNextDTypeId; ++i) {
+    for (DTypeId j = 0; j < kNextDTypeId; ++j) {
+      CommonSchemaAggregator agg;
+      agg.Add(DType(i));
+      agg.Add(DType(j));
+      auto expected = std::move(agg).Get();
+      EXPECT_EQ(CommonSchema(DType(i), DType(j)), expected) << i << " " << j;
+      EXPECT_EQ(CommonSchema(DataItem(DType(i)), DataItem(DType(j))),
+                expected)
+          << i << " " << j;
+    }
+  }
+}
+
 TEST(SchemaUtilsTest, CommonSchemaUnary) {
   {
     // Simple.
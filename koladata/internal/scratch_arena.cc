@@ -0,0 +1,55 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/scratch_arena.h"
+
+#include <cstdint>
+
+#include "absl/base/nullability.h"
+#include "arolla/memory/raw_buffer_factory.h"
+
+namespace koladata::internal {
+namespace {
+
+arolla::UnsafeArenaBufferFactory& ThreadArena() {
+  // Constructed on the first use, so that the threads that never evaluate
+  // anything do not pay for it.
+  thread_local arolla::UnsafeArenaBufferFactory arena(kScratchArenaPageSize);
+  return arena;
+}
+
+thread_local int64_t scratch_arena_depth = 0;
+
+}  // namespace
+
+ScopedScratchArena::ScopedScratchArena() { ++scratch_arena_depth; }
+
+ScopedScratchArena::~ScopedScratchArena() {
+  if (--scratch_arena_depth == 0) {
+    ThreadArena().Reset();
+  }
+}
+
+absl::Nullable<arolla::RawBufferFactory*> CurrentScratchArena() {
+  return scratch_arena_depth > 0 ? &ThreadArena() : nullptr;
+}
+
+absl::Nonnull<arolla::RawBufferFactory*> ScratchBufferFactory() {
+  if (scratch_arena_depth > 0) {
+    return &ThreadArena();
+  }
+  return arolla::GetHeapBufferFactory();
+}
+
+}  // namespace koladata::internal
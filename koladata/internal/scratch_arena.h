@@ -0,0 +1,121 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_SCRATCH_ARENA_H_
+#define KOLADATA_INTERNAL_SCRATCH_ARENA_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "arolla/memory/raw_buffer_factory.h"
+
+namespace koladata::internal {
+
+// Page size of the per-thread scratch arenas. Larger allocations get their own
+// pages, which are released on reset.
+constexpr int64_t kScratchArenaPageSize = 1 << 16;
+
+// While alive, ScratchBufferFactory() of the current thread returns the
+// thread's arena. The arena is reset when the outermost scope of the thread is
+// destroyed, so the pages are reused by the following calls without going
+// through the global allocator. Nested scopes share the arena of the outermost
+// one.
+//
+// Nothing allocated in the arena is freed before the reset, so a scope should
+// cover a single kernel invocation rather than a whole evaluation: opening it
+// around an expr evaluation would keep the temporaries of all the operators
+// (and of all the functor calls) until the end of the evaluation.
+//
+// Example:
+//   absl::StatusOr<DataSlice> SomeKernel(const DataSlice& x) {
+//     ScopedScratchArena scratch_arena;
+//     ScratchVector<int64_t> tmp(x.size());
+//     ...
+//   }
+class ScopedScratchArena {
+ public:
+  ScopedScratchArena();
+  ~ScopedScratchArena();
+
+  ScopedScratchArena(const ScopedScratchArena&) = delete;
+  ScopedScratchArena& operator=(const ScopedScratchArena&) = delete;
+};
+
+// Returns the arena of the current thread if a ScopedScratchArena is active,
+// and nullptr otherwise.
+absl::Nullable<arolla::RawBufferFactory*> CurrentScratchArena();
+
+// Returns the buffer factory for the temporaries of operator kernels: the
+// arena of the current thread inside of a ScopedScratchArena, and the heap
+// buffer factory otherwise. The buffers must not escape the kernel, e.g. a
+// DenseArray built with it must be copied with MakeOwned() before being
+// returned.
+absl::Nonnull<arolla::RawBufferFactory*> ScratchBufferFactory();
+
+// STL allocator that allocates from the scratch arena that was current when
+// the allocator was created, or from the heap if there was none. Deallocation
+// from the arena is a no-op, the memory is reclaimed when the arena is reset.
+// Containers using it must not outlive the ScopedScratchArena and must only
+// grow on the thread that created them.
+template <typename T>
+class ScratchAllocator {
+ public:
+  using value_type = T;
+
+  ScratchAllocator() : arena_(CurrentScratchArena()) {}
+  template <typename U>
+  ScratchAllocator(const ScratchAllocator<U>& other)  // NOLINT
+      : arena_(other.arena_) {}
+
+  T* allocate(size_t n) {
+    static_assert(alignof(T) <= alignof(int64_t),
+                  "over-aligned types are not supported");
+    if (arena_ == nullptr) {
+      return std::allocator<T>().allocate(n);
+    }
+    auto [buffer, data] = arena_->CreateRawBuffer(n * sizeof(T));
+    return static_cast<T*>(data);
+  }
+
+  void deallocate(T* p, size_t n) {
+    if (arena_ == nullptr) {
+      std::allocator<T>().deallocate(p, n);
+    }
+  }
+
+  template <typename U>
+  bool operator==(const ScratchAllocator<U>& other) const {
+    return arena_ == other.arena_;
+  }
+  template <typename U>
+  bool operator!=(const ScratchAllocator<U>& other) const {
+    return arena_ != other.arena_;
+  }
+
+ private:
+  template <typename U>
+  friend class ScratchAllocator;
+
+  absl::Nullable<arolla::RawBufferFactory*> arena_;
+};
+
+template <typename T>
+using ScratchVector = std::vector<T, ScratchAllocator<T>>;
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_SCRATCH_ARENA_H_
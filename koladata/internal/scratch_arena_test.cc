@@ -0,0 +1,82 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/scratch_arena.h"
+
+#include <cstdint>
+#include <numeric>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/raw_buffer_factory.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::ElementsAre;
+
+TEST(ScratchArenaTest, NoScope) {
+  EXPECT_EQ(CurrentScratchArena(), nullptr);
+  EXPECT_EQ(ScratchBufferFactory(), arolla::GetHeapBufferFactory());
+  ScratchVector<int64_t> v(3, 1);
+  v.push_back(2);
+  EXPECT_THAT(v, ElementsAre(1, 1, 1, 2));
+}
+
+TEST(ScratchArenaTest, NestedScopes) {
+  arolla::RawBufferFactory* arena;
+  {
+    ScopedScratchArena scope;
+    arena = CurrentScratchArena();
+    ASSERT_NE(arena, nullptr);
+    EXPECT_EQ(ScratchBufferFactory(), arena);
+    {
+      ScopedScratchArena nested_scope;
+      EXPECT_EQ(CurrentScratchArena(), arena);
+    }
+    EXPECT_EQ(CurrentScratchArena(), arena);
+  }
+  EXPECT_EQ(CurrentScratchArena(), nullptr);
+  // The arena is reused by the next scope.
+  ScopedScratchArena scope;
+  EXPECT_EQ(CurrentScratchArena(), arena);
+}
+
+TEST(ScratchArenaTest, Vector) {
+  ScopedScratchArena scope;
+  ScratchVector<int64_t> v;
+  for (int64_t i = 0; i < kScratchArenaPageSize; ++i) {
+    v.push_back(i);
+  }
+  EXPECT_EQ(std::accumulate(v.begin(), v.end(), int64_t{0}),
+            kScratchArenaPageSize * (kScratchArenaPageSize - 1) / 2);
+  EXPECT_EQ(v.get_allocator(), ScratchAllocator<int64_t>());
+}
+
+TEST(ScratchArenaTest, DenseArray) {
+  std::optional<arolla::DenseArray<int>> owned;
+  {
+    ScopedScratchArena scope;
+    arolla::DenseArrayBuilder<int> builder(3, ScratchBufferFactory());
+    builder.Set(0, 1);
+    builder.Set(2, 3);
+    owned = std::move(builder).Build().MakeOwned();
+  }
+  EXPECT_THAT(*owned, ElementsAre(1, std::nullopt, 3));
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -0,0 +1,188 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/sharded_data_bag.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/functional/function_ref.h"
+#include "absl/hash/hash.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::internal {
+namespace {
+
+DataSliceImpl Gather(const DataSliceImpl& slice,
+                     absl::Span<const int64_t> positions) {
+  DataSliceImpl::Builder bldr(positions.size());
+  for (int64_t i = 0; i < positions.size(); ++i) {
+    bldr.Insert(i, slice[positions[i]]);
+  }
+  return std::move(bldr).Build();
+}
+
+// Runs `fn(shard, positions)` in parallel for all shards with any positions.
+absl::Status ForEachShard(
+    absl::Span<const std::unique_ptr<DataBagShard>> shards,
+    const std::vector<std::vector<int64_t>>& positions,
+    absl::FunctionRef<absl::Status(int64_t)> fn) {
+  std::shared_ptr<Executor> executor = CurrentExecutor();
+  return ParallelFor(executor.get(), shards.size(),
+                     [&](int64_t shard) -> absl::Status {
+                       if (positions[shard].empty()) {
+                         return absl::OkStatus();
+                       }
+                       return fn(shard);
+                     });
+}
+
+// Scatters the per-shard `results` back to the positions of the input.
+DataSliceImpl Reassemble(int64_t size,
+                         const std::vector<std::vector<int64_t>>& positions,
+                         const std::vector<DataSliceImpl>& results) {
+  DataSliceImpl::Builder bldr(size);
+  for (int64_t shard = 0; shard < positions.size(); ++shard) {
+    for (int64_t i = 0; i < positions[shard].size(); ++i) {
+      bldr.Insert(positions[shard][i], results[shard][i]);
+    }
+  }
+  return std::move(bldr).Build();
+}
+
+absl::Status CheckSameSize(const DataSliceImpl& a, const DataSliceImpl& b) {
+  if (a.size() != b.size()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("slices must have the same size, got ", a.size(),
+                     " and ", b.size()));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::StatusOr<DataSliceImpl> LocalDataBagShard::GetAttr(
+    const DataSliceImpl& objects, absl::string_view attr) {
+  absl::MutexLock lock(&mutex_);
+  return db_->GetAttr(objects, attr);
+}
+
+absl::Status LocalDataBagShard::SetAttr(const DataSliceImpl& objects,
+                                        absl::string_view attr,
+                                        const DataSliceImpl& values) {
+  absl::MutexLock lock(&mutex_);
+  return db_->SetAttr(objects, attr, values);
+}
+
+absl::StatusOr<DataSliceImpl> LocalDataBagShard::GetFromDict(
+    const DataSliceImpl& dicts, const DataSliceImpl& keys) {
+  absl::MutexLock lock(&mutex_);
+  return db_->GetFromDict(dicts, keys);
+}
+
+absl::Status LocalDataBagShard::SetInDict(const DataSliceImpl& dicts,
+                                          const DataSliceImpl& keys,
+                                          const DataSliceImpl& values) {
+  absl::MutexLock lock(&mutex_);
+  return db_->SetInDict(dicts, keys, values);
+}
+
+int64_t ShardedDataBag::ShardOf(AllocationId alloc) const {
+  return absl::HashOf(alloc) % shards_.size();
+}
+
+absl::StatusOr<std::vector<std::vector<int64_t>>> ShardedDataBag::SplitByShard(
+    const DataSliceImpl& objects) const {
+  std::vector<std::vector<int64_t>> positions(shards_.size());
+  if (objects.present_count() == 0) {
+    return positions;
+  }
+  if (objects.dtype() != arolla::GetQType<ObjectId>()) {
+    return absl::InvalidArgumentError(
+        "sharded DataBag operations require ObjectIds");
+  }
+  objects.values<ObjectId>().ForEachPresent([&](int64_t i, ObjectId id) {
+    positions[ShardOf(AllocationId(id))].push_back(i);
+  });
+  return positions;
+}
+
+absl::StatusOr<DataSliceImpl> ShardedDataBag::GetAttr(
+    const DataSliceImpl& objects, absl::string_view attr) const {
+  ASSIGN_OR_RETURN(auto positions, SplitByShard(objects));
+  std::vector<DataSliceImpl> results(shards_.size());
+  RETURN_IF_ERROR(
+      ForEachShard(shards_, positions, [&](int64_t shard) -> absl::Status {
+        ASSIGN_OR_RETURN(results[shard],
+                         shards_[shard]->GetAttr(
+                             Gather(objects, positions[shard]), attr));
+        return absl::OkStatus();
+      }));
+  return Reassemble(objects.size(), positions, results);
+}
+
+absl::Status ShardedDataBag::SetAttr(const DataSliceImpl& objects,
+                                     absl::string_view attr,
+                                     const DataSliceImpl& values) {
+  RETURN_IF_ERROR(CheckSameSize(objects, values));
+  ASSIGN_OR_RETURN(auto positions, SplitByShard(objects));
+  return ForEachShard(shards_, positions, [&](int64_t shard) {
+    return shards_[shard]->SetAttr(Gather(objects, positions[shard]), attr,
+                                   Gather(values, positions[shard]));
+  });
+}
+
+absl::StatusOr<DataSliceImpl> ShardedDataBag::GetFromDict(
+    const DataSliceImpl& dicts, const DataSliceImpl& keys) const {
+  RETURN_IF_ERROR(CheckSameSize(dicts, keys));
+  ASSIGN_OR_RETURN(auto positions, SplitByShard(dicts));
+  std::vector<DataSliceImpl> results(shards_.size());
+  RETURN_IF_ERROR(
+      ForEachShard(shards_, positions, [&](int64_t shard) -> absl::Status {
+        ASSIGN_OR_RETURN(
+            results[shard],
+            shards_[shard]->GetFromDict(Gather(dicts, positions[shard]),
+                                        Gather(keys, positions[shard])));
+        return absl::OkStatus();
+      }));
+  return Reassemble(dicts.size(), positions, results);
+}
+
+absl::Status ShardedDataBag::SetInDict(const DataSliceImpl& dicts,
+                                       const DataSliceImpl& keys,
+                                       const DataSliceImpl& values) {
+  RETURN_IF_ERROR(CheckSameSize(dicts, keys));
+  RETURN_IF_ERROR(CheckSameSize(dicts, values));
+  ASSIGN_OR_RETURN(auto positions, SplitByShard(dicts));
+  return ForEachShard(shards_, positions, [&](int64_t shard) {
+    return shards_[shard]->SetInDict(Gather(dicts, positions[shard]),
+                                     Gather(keys, positions[shard]),
+                                     Gather(values, positions[shard]));
+  });
+}
+
+}  // namespace koladata::internal
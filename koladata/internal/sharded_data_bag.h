@@ -0,0 +1,113 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_SHARDED_DATA_BAG_H_
+#define KOLADATA_INTERNAL_SHARDED_DATA_BAG_H_
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/object_id.h"
+
+namespace koladata::internal {
+
+// A partition of a sharded DataBag. Holds the attributes and dicts of the
+// allocations assigned to it. Implementations can forward the calls to
+// another process or host; they must be thread-safe, as the calls for
+// different shards are issued in parallel.
+class DataBagShard {
+ public:
+  virtual ~DataBagShard() = default;
+
+  virtual absl::StatusOr<DataSliceImpl> GetAttr(const DataSliceImpl& objects,
+                                                absl::string_view attr) = 0;
+  virtual absl::Status SetAttr(const DataSliceImpl& objects,
+                               absl::string_view attr,
+                               const DataSliceImpl& values) = 0;
+  virtual absl::StatusOr<DataSliceImpl> GetFromDict(
+      const DataSliceImpl& dicts, const DataSliceImpl& keys) = 0;
+  virtual absl::Status SetInDict(const DataSliceImpl& dicts,
+                                 const DataSliceImpl& keys,
+                                 const DataSliceImpl& values) = 0;
+};
+
+// DataBagShard backed by a DataBagImpl in the current process.
+class LocalDataBagShard final : public DataBagShard {
+ public:
+  LocalDataBagShard() : db_(DataBagImpl::CreateEmptyDatabag()) {}
+
+  absl::StatusOr<DataSliceImpl> GetAttr(const DataSliceImpl& objects,
+                                        absl::string_view attr) final;
+  absl::Status SetAttr(const DataSliceImpl& objects, absl::string_view attr,
+                       const DataSliceImpl& values) final;
+  absl::StatusOr<DataSliceImpl> GetFromDict(const DataSliceImpl& dicts,
+                                            const DataSliceImpl& keys) final;
+  absl::Status SetInDict(const DataSliceImpl& dicts, const DataSliceImpl& keys,
+                         const DataSliceImpl& values) final;
+
+ private:
+  // DataBagImpl is not thread-safe for writes.
+  absl::Mutex mutex_;
+  DataBagImplPtr db_ ABSL_GUARDED_BY(mutex_);
+};
+
+// DataBag whose allocations are hash-partitioned across several shards.
+//
+// Objects of an allocation are usually used together, so all attributes of
+// an allocation (and all items of a dict) live in a single shard. Batch calls
+// are split by shard, issued in parallel on CurrentExecutor() and the results
+// are reassembled in the order of the inputs.
+//
+// Only ObjectIds are accepted as objects and dicts; missing items are
+// skipped. Fallbacks, lists and schemas are not supported.
+class ShardedDataBag {
+ public:
+  explicit ShardedDataBag(std::vector<std::unique_ptr<DataBagShard>> shards)
+      : shards_(std::move(shards)) {}
+
+  int64_t shard_count() const { return shards_.size(); }
+
+  // Returns the index of the shard holding the data of `alloc`.
+  int64_t ShardOf(AllocationId alloc) const;
+
+  absl::StatusOr<DataSliceImpl> GetAttr(const DataSliceImpl& objects,
+                                        absl::string_view attr) const;
+  absl::Status SetAttr(const DataSliceImpl& objects, absl::string_view attr,
+                       const DataSliceImpl& values);
+  absl::StatusOr<DataSliceImpl> GetFromDict(const DataSliceImpl& dicts,
+                                            const DataSliceImpl& keys) const;
+  absl::Status SetInDict(const DataSliceImpl& dicts, const DataSliceImpl& keys,
+                         const DataSliceImpl& values);
+
+ private:
+  // Positions of the items of `objects` per shard. Returns an error if
+  // `objects` has non-ObjectId items.
+  absl::StatusOr<std::vector<std::vector<int64_t>>> SplitByShard(
+      const DataSliceImpl& objects) const;
+
+  std::vector<std::unique_ptr<DataBagShard>> shards_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_SHARDED_DATA_BAG_H_
@@ -0,0 +1,122 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/sharded_data_bag.h"
+
+#include <cstdint>
+#include <memory>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+ShardedDataBag CreateShardedDataBag(int64_t shard_count) {
+  std::vector<std::unique_ptr<DataBagShard>> shards;
+  for (int64_t i = 0; i < shard_count; ++i) {
+    shards.push_back(std::make_unique<LocalDataBagShard>());
+  }
+  return ShardedDataBag(std::move(shards));
+}
+
+// Objects from `alloc_count` allocations interleaved, so that consecutive
+// items go to different shards.
+DataSliceImpl InterleavedObjects(int64_t alloc_count, int64_t per_alloc) {
+  std::vector<AllocationId> allocs;
+  for (int64_t i = 0; i < alloc_count; ++i) {
+    allocs.push_back(Allocate(per_alloc));
+  }
+  arolla::DenseArrayBuilder<ObjectId> bldr(alloc_count * per_alloc);
+  for (int64_t i = 0; i < alloc_count * per_alloc; ++i) {
+    bldr.Set(i, allocs[i % alloc_count].ObjectByOffset(i / alloc_count));
+  }
+  return DataSliceImpl::Create(std::move(bldr).Build());
+}
+
+TEST(ShardedDataBagTest, Attrs) {
+  ThreadPoolExecutor executor(4);
+  ScopedExecutor scoped_executor(&executor);
+  ShardedDataBag db = CreateShardedDataBag(3);
+  DataSliceImpl objects = InterleavedObjects(8, 10);
+  std::vector<int> expected(objects.size());
+  arolla::DenseArrayBuilder<int> values_bldr(objects.size());
+  for (int64_t i = 0; i < objects.size(); ++i) {
+    expected[i] = i;
+    values_bldr.Set(i, i);
+  }
+  ASSERT_OK(db.SetAttr(objects, "a",
+                       DataSliceImpl::Create(std::move(values_bldr).Build())));
+
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl result, db.GetAttr(objects, "a"));
+  ASSERT_EQ(result.size(), objects.size());
+  for (int64_t i = 0; i < objects.size(); ++i) {
+    EXPECT_EQ(result[i], DataItem(expected[i]));
+  }
+  EXPECT_EQ(db.ShardOf(AllocationId(objects[5].value<ObjectId>())),
+            db.ShardOf(AllocationId(objects[13].value<ObjectId>())));
+
+  // Missing objects and attributes.
+  DataSliceImpl subset = DataSliceImpl::Create(
+      {DataItem(), objects[3], DataItem(AllocateSingleObject())});
+  EXPECT_THAT(db.GetAttr(subset, "a"),
+              IsOkAndHolds(ElementsAre(DataItem(), DataItem(3), DataItem())));
+  EXPECT_THAT(db.GetAttr(subset, "b"),
+              IsOkAndHolds(ElementsAre(DataItem(), DataItem(), DataItem())));
+}
+
+TEST(ShardedDataBagTest, Dicts) {
+  ShardedDataBag db = CreateShardedDataBag(2);
+  DataItem dict1(AllocateSingleDict());
+  DataItem dict2(AllocateSingleDict());
+  ASSERT_OK(db.SetInDict(
+      DataSliceImpl::Create({dict1, dict2, dict1}),
+      DataSliceImpl::Create({DataItem(1), DataItem(1), DataItem(2)}),
+      DataSliceImpl::Create({DataItem(10), DataItem(20), DataItem(30)})));
+  EXPECT_THAT(
+      db.GetFromDict(DataSliceImpl::Create({dict2, dict1, dict1, DataItem()}),
+                     DataSliceImpl::Create(
+                         {DataItem(1), DataItem(2), DataItem(3), DataItem(1)})),
+      IsOkAndHolds(
+          ElementsAre(DataItem(20), DataItem(30), DataItem(), DataItem())));
+}
+
+TEST(ShardedDataBagTest, Errors) {
+  ShardedDataBag db = CreateShardedDataBag(2);
+  EXPECT_THAT(db.GetAttr(DataSliceImpl::Create({DataItem(1)}), "a"),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("require ObjectIds")));
+  EXPECT_THAT(
+      db.SetAttr(DataSliceImpl::Create({DataItem(AllocateSingleObject())}), "a",
+                 DataSliceImpl::Create({DataItem(1), DataItem(2)})),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("same size")));
+}
+
+}  // namespace
+}  // namespace koladata::internal
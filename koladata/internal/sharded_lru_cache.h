@@ -0,0 +1,161 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_SHARDED_LRU_CACHE_H_
+#define KOLADATA_INTERNAL_SHARDED_LRU_CACHE_H_
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <optional>
+#include <utility>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/hash/hash.h"
+#include "absl/synchronization/mutex.h"
+#include "arolla/util/lru_cache.h"
+
+namespace koladata::internal {
+
+// Usage statistics of a ShardedLruCache.
+struct LruCacheStats {
+  // Maximum number of entries.
+  int64_t capacity = 0;
+  // Current number of entries.
+  int64_t size = 0;
+  int64_t hits = 0;
+  int64_t misses = 0;
+  // Number of entries removed to make room for new ones. Entries removed by
+  // Clear() or SetCapacity() are not counted.
+  int64_t evictions = 0;
+};
+
+// Thread-safe LRU cache split into independent shards, each with its own mutex,
+// so that concurrent lookups of different keys rarely contend on a lock. The
+// least recently used entry is evicted within a shard, so the eviction order
+// approximates the global LRU order. The total capacity is split evenly among
+// the shards.
+//
+// `Value` is returned by copy, so it should be cheap to copy (e.g. a
+// shared_ptr or an std::function holding a shared state). A default
+// constructed `Value` is returned on a miss.
+template <typename Key, typename Value, typename KeyHash = absl::Hash<Key>,
+          typename KeyEq = std::equal_to<>>
+class ShardedLruCache {
+ public:
+  static constexpr size_t kNumShards = 16;
+
+  explicit ShardedLruCache(size_t capacity) { SetCapacity(capacity); }
+
+  // `key` can be of any type supported by KeyHash and KeyEq.
+  template <typename LookupKey>
+  Value LookupOrNull(const LookupKey& key) {
+    Shard& shard = GetShard(key);
+    absl::MutexLock lock(&shard.mutex);
+    if (auto* res = shard.cache->LookupOrNull(key)) {
+      ++shard.hits;
+      return *res;
+    }
+    ++shard.misses;
+    return Value();
+  }
+
+  // Inserts `value` unless `key` is already present. Returns the cached value.
+  Value Put(Key key, Value value) {
+    Shard& shard = GetShard(key);
+    absl::MutexLock lock(&shard.mutex);
+    if (auto* res = shard.cache->LookupOrNull(key)) {
+      return *res;
+    }
+    if (shard.size == shard.capacity) {
+      // LruCache drops the least recently used entry on overflow.
+      ++shard.evictions;
+    } else {
+      ++shard.size;
+    }
+    return *shard.cache->Put(std::move(key), std::move(value));
+  }
+
+  void Clear() {
+    for (Shard& shard : shards_) {
+      absl::MutexLock lock(&shard.mutex);
+      shard.cache->Clear();
+      shard.size = 0;
+    }
+  }
+
+  // Changes the total capacity. The cache is cleared, the statistics are kept.
+  void SetCapacity(size_t capacity) {
+    size_t shard_capacity = std::max<size_t>(1, capacity / kNumShards);
+    for (Shard& shard : shards_) {
+      absl::MutexLock lock(&shard.mutex);
+      shard.cache.emplace(shard_capacity);
+      shard.capacity = shard_capacity;
+      shard.size = 0;
+    }
+  }
+
+  LruCacheStats GetStats() {
+    LruCacheStats stats;
+    for (Shard& shard : shards_) {
+      absl::MutexLock lock(&shard.mutex);
+      stats.capacity += shard.capacity;
+      stats.size += shard.size;
+      stats.hits += shard.hits;
+      stats.misses += shard.misses;
+      stats.evictions += shard.evictions;
+    }
+    return stats;
+  }
+
+  void ResetStats() {
+    for (Shard& shard : shards_) {
+      absl::MutexLock lock(&shard.mutex);
+      shard.hits = 0;
+      shard.misses = 0;
+      shard.evictions = 0;
+    }
+  }
+
+ private:
+  using Impl = arolla::LruCache<Key, Value, KeyHash, KeyEq>;
+
+  struct Shard {
+    absl::Mutex mutex;
+    // Always engaged after construction. std::optional is used to recreate
+    // the cache with a different capacity.
+    std::optional<Impl> cache ABSL_GUARDED_BY(mutex);
+    int64_t capacity ABSL_GUARDED_BY(mutex) = 0;
+    int64_t size ABSL_GUARDED_BY(mutex) = 0;
+    int64_t hits ABSL_GUARDED_BY(mutex) = 0;
+    int64_t misses ABSL_GUARDED_BY(mutex) = 0;
+    int64_t evictions ABSL_GUARDED_BY(mutex) = 0;
+  };
+
+  template <typename LookupKey>
+  Shard& GetShard(const LookupKey& key) {
+    // The hash is mixed once more, so that the shard index does not correlate
+    // with the bits used by the hash table inside of the shard.
+    size_t hash = absl::HashOf(KeyHash()(key));
+    return shards_[hash % kNumShards];
+  }
+
+  std::array<Shard, kNumShards> shards_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_SHARDED_LRU_CACHE_H_
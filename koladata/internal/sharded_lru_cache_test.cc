@@ -0,0 +1,150 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/sharded_lru_cache.h"
+
+#include <cstdint>
+#include <memory>
+#include <thread>  // NOLINT(build/c++11)
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::AllOf;
+using ::testing::Field;
+using ::testing::IsNull;
+using ::testing::Pointee;
+
+using Cache = ShardedLruCache<int64_t, std::shared_ptr<const int64_t>>;
+
+TEST(ShardedLruCacheTest, LookupAndPut) {
+  Cache cache(1024);
+  EXPECT_THAT(cache.LookupOrNull(1), IsNull());
+  EXPECT_THAT(cache.Put(1, std::make_shared<int64_t>(10)), Pointee(10));
+  EXPECT_THAT(cache.LookupOrNull(1), Pointee(10));
+  // The existing value is kept.
+  EXPECT_THAT(cache.Put(1, std::make_shared<int64_t>(20)), Pointee(10));
+  EXPECT_THAT(cache.LookupOrNull(1), Pointee(10));
+  EXPECT_THAT(cache.LookupOrNull(2), IsNull());
+
+  cache.Clear();
+  EXPECT_THAT(cache.LookupOrNull(1), IsNull());
+}
+
+TEST(ShardedLruCacheTest, Capacity) {
+  constexpr int64_t kCapacity = 64;
+  Cache cache(kCapacity);
+  for (int64_t i = 0; i < 100 * kCapacity; ++i) {
+    cache.Put(i, std::make_shared<int64_t>(i));
+  }
+  int64_t cached = 0;
+  for (int64_t i = 0; i < 100 * kCapacity; ++i) {
+    if (auto value = cache.LookupOrNull(i)) {
+      EXPECT_EQ(*value, i);
+      ++cached;
+    }
+  }
+  EXPECT_GT(cached, 0);
+  EXPECT_LE(cached, kCapacity);
+  LruCacheStats stats = cache.GetStats();
+  EXPECT_EQ(stats.capacity, kCapacity);
+  EXPECT_EQ(stats.size, cached);
+  EXPECT_EQ(stats.evictions, 100 * kCapacity - cached);
+  // The most recently added entry is never evicted.
+  EXPECT_THAT(cache.LookupOrNull(100 * kCapacity - 1),
+              Pointee(100 * kCapacity - 1));
+}
+
+TEST(ShardedLruCacheTest, TinyCapacity) {
+  Cache cache(1);
+  cache.Put(1, std::make_shared<int64_t>(1));
+  EXPECT_THAT(cache.LookupOrNull(1), Pointee(1));
+}
+
+TEST(ShardedLruCacheTest, Stats) {
+  Cache cache(1024);
+  EXPECT_THAT(cache.GetStats(),
+              AllOf(Field(&LruCacheStats::capacity, 1024),
+                    Field(&LruCacheStats::size, 0),
+                    Field(&LruCacheStats::hits, 0),
+                    Field(&LruCacheStats::misses, 0),
+                    Field(&LruCacheStats::evictions, 0)));
+  cache.LookupOrNull(1);
+  cache.Put(1, std::make_shared<int64_t>(1));
+  cache.Put(1, std::make_shared<int64_t>(2));
+  cache.LookupOrNull(1);
+  cache.LookupOrNull(1);
+  cache.LookupOrNull(2);
+  EXPECT_THAT(cache.GetStats(),
+              AllOf(Field(&LruCacheStats::size, 1),
+                    Field(&LruCacheStats::hits, 2),
+                    Field(&LruCacheStats::misses, 2),
+                    Field(&LruCacheStats::evictions, 0)));
+
+  cache.ResetStats();
+  EXPECT_THAT(cache.GetStats(),
+              AllOf(Field(&LruCacheStats::size, 1),
+                    Field(&LruCacheStats::hits, 0),
+                    Field(&LruCacheStats::misses, 0)));
+  cache.Clear();
+  EXPECT_THAT(cache.GetStats(), Field(&LruCacheStats::size, 0));
+}
+
+TEST(ShardedLruCacheTest, SetCapacity) {
+  Cache cache(1024);
+  cache.Put(1, std::make_shared<int64_t>(1));
+  cache.LookupOrNull(1);
+  cache.SetCapacity(32);
+  EXPECT_THAT(cache.LookupOrNull(1), IsNull());
+  EXPECT_THAT(cache.GetStats(),
+              AllOf(Field(&LruCacheStats::capacity, 32),
+                    Field(&LruCacheStats::size, 0),
+                    Field(&LruCacheStats::hits, 1),
+                    Field(&LruCacheStats::misses, 1)));
+  for (int64_t i = 0; i < 1000; ++i) {
+    cache.Put(i, std::make_shared<int64_t>(i));
+  }
+  EXPECT_LE(cache.GetStats().size, 32);
+}
+
+TEST(ShardedLruCacheTest, Concurrent) {
+  constexpr int64_t kNumThreads = 8;
+  constexpr int64_t kNumKeys = 1000;
+  Cache cache(4096);
+  std::vector<std::thread> threads;
+  for (int64_t t = 0; t < kNumThreads; ++t) {
+    threads.emplace_back([&cache] {
+      for (int64_t i = 0; i < kNumKeys; ++i) {
+        auto value = cache.LookupOrNull(i);
+        if (value == nullptr) {
+          value = cache.Put(i, std::make_shared<int64_t>(i));
+        }
+        EXPECT_EQ(*value, i);
+      }
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  for (int64_t i = 0; i < kNumKeys; ++i) {
+    EXPECT_THAT(cache.LookupOrNull(i), Pointee(i));
+  }
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -16,6 +16,7 @@
 
 #include <cstddef>
 #include <cstdint>
+#include <numeric>
 #include <optional>
 #include <type_traits>
 #include <utility>
@@ -26,6 +27,7 @@
 #include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
+#include "koladata/internal/memory_usage.h"
 #include "koladata/internal/missing_value.h"
 #include "koladata/internal/object_id.h"
 #include "arolla/dense_array/bitmap.h"
@@ -35,9 +37,51 @@
 
 namespace koladata::internal {
 
+template <class SelectedFn, class Fn>
+void SparseSource::ForEachFound(absl::Span<const ObjectId> objs,
+                                SelectedFn&& selected, Fn&& fn) const {
+  const int64_t size = objs.size();
+  // Grouping only pays off if there are several lookups per bucket.
+  if (alloc_id_.has_value() || !is_partitioned() ||
+      size < 4 * kSmallAllocBucketCount) {
+    for (int64_t id = 0; id < size; ++id) {
+      if (selected(id)) {
+        if (const DataItem* item = Find(objs[id]); item != nullptr) {
+          fn(id, *item);
+        }
+      }
+    }
+    return;
+  }
+  // Counting sort of the looked up ids by bucket. Objects of big
+  // allocations are never stored in this SparseSource, so they are skipped.
+  std::vector<int64_t> ids;
+  std::vector<size_t> hashes;
+  std::vector<int64_t> bucket_offsets(kSmallAllocBucketCount + 1, 0);
+  for (int64_t id = 0; id < size; ++id) {
+    if (selected(id) && objs[id].IsSmallAlloc()) {
+      ids.push_back(id);
+      hashes.push_back(SmallAllocHash(objs[id]));
+      ++bucket_offsets[BucketIndex(hashes.back()) + 1];
+    }
+  }
+  std::partial_sum(bucket_offsets.begin(), bucket_offsets.end(),
+                   bucket_offsets.begin());
+  std::vector<int64_t> order(ids.size());
+  for (int64_t i = 0; i < ids.size(); ++i) {
+    order[bucket_offsets[BucketIndex(hashes[i])]++] = i;
+  }
+  for (int64_t i : order) {
+    if (const DataItem* item = FindSmallAlloc(objs[ids[i]], hashes[i]);
+        item != nullptr) {
+      fn(ids[i], *item);
+    }
+  }
+}
+
 std::optional<DataItem> SparseSource::Get(ObjectId object) const {
-  if (auto it = data_item_map_.find(object); it != data_item_map_.end()) {
-    return it->second;
+  if (const DataItem* item = Find(object); item != nullptr) {
+    return *item;
   } else {
     return std::nullopt;
   }
@@ -45,15 +89,14 @@ std::optional<DataItem> SparseSource::Get(ObjectId object) const {
 
 DataSliceImpl SparseSource::Get(const ObjectIdArray& objects) const {
   size_t size = objects.size();
-  if (data_item_map_.empty() || objects.IsAllMissing()) {
+  if (this->size() == 0 || objects.IsAllMissing()) {
     return DataSliceImpl::CreateEmptyAndUnknownType(size);
   }
   if (size == 1) {
     DCHECK(objects.present(0));
     ObjectId object = objects.values[0];
-    if (auto it = data_item_map_.find(object); it != data_item_map_.end()) {
-      const auto& item = it->second;
-      return item.VisitValue([&](const auto& value) -> DataSliceImpl {
+    if (const DataItem* item = Find(object); item != nullptr) {
+      return item->VisitValue([&](const auto& value) -> DataSliceImpl {
         using T = std::decay_t<decltype(value)>;
         if constexpr (std::is_same_v<T, MissingValue>) {
           return DataSliceImpl::CreateEmptyAndUnknownType(size);
@@ -73,35 +116,27 @@ DataSliceImpl SparseSource::Get(const ObjectIdArray& objects) const {
   }
 
   DataSliceImpl::Builder bldr(size);
-  objects.ForEachPresent([&](int64_t id, ObjectId object) {
-    if (auto it = data_item_map_.find(object); it != data_item_map_.end()) {
-      const auto& item = it->second;
-      bldr.Insert(id, item);
-    }
-  });
+  ForEachFound(
+      objects.values.span(), [&](int64_t id) { return objects.present(id); },
+      [&](int64_t id, const DataItem& item) { bldr.Insert(id, item); });
   return std::move(bldr).Build();
 }
 
 void SparseSource::Get(absl::Span<const ObjectId> objs,
                        DataSliceImpl::Builder& bldr,
                        absl::Span<arolla::bitmap::Word> mask) const {
-  size_t size = objs.size();
-  for (int64_t id = 0; id < size; ++id) {
-    if (!arolla::bitmap::GetBit(mask.data(), id)) {
-      continue;
-    }
-    ObjectId object = objs[id];
-    if (auto it = data_item_map_.find(object); it != data_item_map_.end()) {
-      const auto& item = it->second;
-      arolla::bitmap::UnsetBit(mask.data(), id);
-      bldr.Insert(id, item);
-    }
-  }
+  ForEachFound(
+      objs,
+      [&](int64_t id) { return arolla::bitmap::GetBit(mask.data(), id); },
+      [&](int64_t id, const DataItem& item) {
+        arolla::bitmap::UnsetBit(mask.data(), id);
+        bldr.Insert(id, item);
+      });
 }
 
 void SparseSource::Set(ObjectId object, const DataItem& value) {
   if (ObjectBelongs(object)) {
-    data_item_map_[object] = value;
+    GetOrInsert(object) = value;
   }
 }
 
@@ -113,7 +148,7 @@ absl::Status SparseSource::Set(const ObjectIdArray& objects,
   }
   objects.ForEachPresent([&](int64_t id, ObjectId object) {
     if (ObjectBelongs(object)) {
-      data_item_map_[object] = values[id];
+      GetOrInsert(object) = values[id];
     }
   });
   return absl::OkStatus();
@@ -123,7 +158,7 @@ absl::Status SparseSource::SetUnitAndUpdateMissingObjects(
     const ObjectIdArray& objects, std::vector<ObjectId>& missing_objects) {
   objects.ForEachPresent([&](int64_t id, ObjectId object) {
     if (ObjectBelongs(object)) {
-      if (data_item_map_.emplace(object, arolla::kPresent).second) {
+      if (Emplace(object, DataItem(arolla::kPresent)).second) {
         missing_objects.push_back(object);
       }
     }
@@ -131,5 +166,67 @@ absl::Status SparseSource::SetUnitAndUpdateMissingObjects(
   return absl::OkStatus();
 }
 
+void SparseSource::AddToFilter(size_t hash) {
+  if (!filter_.NeedsRebuild(size())) {
+    filter_.Insert(hash);
+    return;
+  }
+  filter_.Rebuild(size());
+  for (const auto& [offset, _] : offset_map_) {
+    filter_.Insert(offset_map_.hash_function()(offset));
+  }
+}
+
+void SparseSource::AddToBucketFilter(SmallAllocBucket& bucket, size_t hash) {
+  if (!bucket.filter.NeedsRebuild(bucket.map.size())) {
+    bucket.filter.Insert(hash);
+    return;
+  }
+  bucket.filter.Rebuild(bucket.map.size());
+  for (const auto& [object, _] : bucket.map) {
+    bucket.filter.Insert(SmallAllocHash(object));
+  }
+}
+
+void SparseSource::Partition() {
+  if (alloc_id_.has_value() || is_partitioned()) {
+    return;
+  }
+  SmallAllocMap map = std::move(small_alloc_buckets_[0].map);
+  std::vector<SmallAllocBucket> buckets(kSmallAllocBucketCount);
+  bucket_mask_ = kSmallAllocBucketCount - 1;
+  for (SmallAllocBucket& bucket : buckets) {
+    // With some headroom for the deviation of the bucket sizes.
+    bucket.map.reserve(map.size() / kSmallAllocBucketCount * 5 / 4);
+  }
+  for (auto& [object, item] : map) {
+    const size_t hash = SmallAllocHash(object);
+    buckets[BucketIndex(hash)].map.emplace(object, std::move(item));
+  }
+  for (SmallAllocBucket& bucket : buckets) {
+    bucket.filter.Rebuild(bucket.map.size());
+    for (const auto& [object, _] : bucket.map) {
+      bucket.filter.Insert(SmallAllocHash(object));
+    }
+  }
+  small_alloc_buckets_ = std::move(buckets);
+}
+
+int64_t SparseSource::EstimateMemoryUsage() const {
+  // flat_hash_map stores one control byte per slot in addition to the slot.
+  auto map_bytes = [](const auto& map) -> int64_t {
+    using value_type = typename std::decay_t<decltype(map)>::value_type;
+    return map.capacity() * (sizeof(value_type) + 1);
+  };
+  int64_t bytes = map_bytes(offset_map_) + filter_.EstimateMemoryUsage() +
+                  small_alloc_buckets_.capacity() * sizeof(SmallAllocBucket);
+  for (const SmallAllocBucket& bucket : small_alloc_buckets_) {
+    bytes += map_bytes(bucket.map) + bucket.filter.EstimateMemoryUsage();
+  }
+  ForEach([&](ObjectId, const DataItem& item) {
+    bytes += EstimateDataItemHeapBytes(item);
+  });
+  return bytes;
+}
 
 }  // namespace koladata::internal
@@ -15,14 +15,18 @@
 #ifndef KOLADATA_INTERNAL_SPARSE_SOURCE_H_
 #define KOLADATA_INTERNAL_SPARSE_SOURCE_H_
 
+#include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/types/span.h"
+#include "koladata/internal/bloom_filter.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/object_id.h"
@@ -31,15 +35,30 @@
 namespace koladata::internal {
 
 // SparseSource represents a single attribute of some set of objects.
-// Internally it is absl::flat_hash_map<ObjectId, DataItem>.
+// If the SparseSource belongs to a single allocation, internally it is
+// absl::flat_hash_map<int64_t, DataItem> keyed by the offset of the object in
+// the allocation. Otherwise (small allocs) it is
+// absl::flat_hash_map<ObjectId, DataItem>, which is split into
+// kSmallAllocBucketCount buckets by the top bits of the hash once it grows
+// large (e.g. the attributes of many uu objects, which are all small allocs).
 class SparseSource {
  public:
+  static constexpr int kSmallAllocBucketBits = 10;
+  static constexpr size_t kSmallAllocBucketCount = size_t{1}
+                                                   << kSmallAllocBucketBits;
+  // Small alloc sources are partitioned when they reach this many values.
+  static constexpr size_t kSmallAllocPartitionThreshold = 1 << 16;
+
   // If alloc_id is specified, this SparseSource contains only values for
   // given allocation. Otherwise it can contain only values for small allocs
   // (with object_id.IsSmallAlloc() == true) which are not tracked by
   // allocation.
   explicit SparseSource(std::optional<AllocationId> alloc_id = std::nullopt)
-      : alloc_id_(alloc_id) {}
+      : alloc_id_(alloc_id) {
+    if (!alloc_id_.has_value()) {
+      small_alloc_buckets_.resize(1);
+    }
+  }
 
   // Returns the attribute for the specified object.
   // The result is std::nullopt if the value is missing in this data source,
@@ -63,8 +82,87 @@ class SparseSource {
   void Get(absl::Span<const ObjectId> objs, DataSliceImpl::Builder& bldr,
            absl::Span<arolla::bitmap::Word> mask) const;
 
-  const absl::flat_hash_map<ObjectId, DataItem>& GetAll() const {
-    return data_item_map_;
+  // Returns the number of stored values (including removed ones).
+  size_t size() const {
+    if (alloc_id_.has_value()) {
+      return offset_map_.size();
+    }
+    size_t size = 0;
+    for (const SmallAllocBucket& bucket : small_alloc_buckets_) {
+      size += bucket.map.size();
+    }
+    return size;
+  }
+
+  // Returns true if the small alloc values are split into
+  // kSmallAllocBucketCount buckets.
+  bool is_partitioned() const { return small_alloc_buckets_.size() > 1; }
+
+  // Splits the small alloc values into buckets. An object is in the same
+  // bucket of all partitioned SparseSources, so different buckets of them can
+  // be read and modified concurrently (see ForEachInBuckets). No-op if already
+  // partitioned or if the SparseSource belongs to an allocation.
+  void Partition();
+
+  // Calls `fn(ObjectId, const DataItem&) -> absl::Status` for all stored
+  // values in the buckets [bucket_begin, bucket_end) in the same order as
+  // ForEach. Returns the first error. Requires is_partitioned().
+  template <class Fn>
+  absl::Status ForEachInBuckets(size_t bucket_begin, size_t bucket_end,
+                                Fn&& fn) const {
+    DCHECK(is_partitioned());
+    for (size_t i = bucket_begin; i < bucket_end; ++i) {
+      for (const auto& [object, item] : small_alloc_buckets_[i].map) {
+        if (absl::Status s = fn(object, item); !s.ok()) {
+          return s;
+        }
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  // Calls `fn(ObjectId, const DataItem&)` for all stored values (including
+  // removed ones) in unspecified order.
+  //
+  // `fn` should either return `absl::Status` or `void`. In case of
+  // `absl::Status`, the first error is returned without calling `fn` on the
+  // rest of the values.
+  template <class Fn>
+  auto ForEach(Fn&& fn) const {
+    using ResT = decltype(fn(std::declval<ObjectId>(),
+                             std::declval<const DataItem&>()));
+    if constexpr (std::is_same_v<ResT, absl::Status>) {
+      if (alloc_id_.has_value()) {
+        for (const auto& [offset, item] : offset_map_) {
+          if (absl::Status s = fn(alloc_id_->ObjectByOffset(offset), item);
+              !s.ok()) {
+            return s;
+          }
+        }
+      } else {
+        for (const SmallAllocBucket& bucket : small_alloc_buckets_) {
+          for (const auto& [object, item] : bucket.map) {
+            if (absl::Status s = fn(object, item); !s.ok()) {
+              return s;
+            }
+          }
+        }
+      }
+      return absl::OkStatus();
+    } else {
+      static_assert(std::is_same_v<ResT, void>);
+      if (alloc_id_.has_value()) {
+        for (const auto& [offset, item] : offset_map_) {
+          fn(alloc_id_->ObjectByOffset(offset), item);
+        }
+      } else {
+        for (const SmallAllocBucket& bucket : small_alloc_buckets_) {
+          for (const auto& [object, item] : bucket.map) {
+            fn(object, item);
+          }
+        }
+      }
+    }
   }
 
   // Sets the value for the specified object.
@@ -83,19 +181,124 @@ class SparseSource {
   absl::Status SetUnitAndUpdateMissingObjects(
       const ObjectIdArray& objects, std::vector<ObjectId>& missing_objects);
 
+  // Returns the estimated number of bytes used by the hash map and the
+  // stored values, see MemoryUsage.
+  int64_t EstimateMemoryUsage() const;
+
  private:
+  using SmallAllocMap = absl::flat_hash_map<ObjectId, DataItem>;
+
+  // Small alloc objects with their hashes in the same bucket. Each bucket has
+  // its own filter, so that the buckets are independent.
+  struct SmallAllocBucket {
+    SmallAllocMap map;
+    HashBloomFilter filter;
+  };
+
+  static size_t SmallAllocHash(ObjectId object) {
+    return SmallAllocMap::hasher()(object);
+  }
+
+  size_t BucketIndex(size_t hash) const {
+    static_assert(sizeof(size_t) == sizeof(uint64_t));
+    return (hash >> (64 - kSmallAllocBucketBits)) & bucket_mask_;
+  }
+
   bool ObjectBelongs(ObjectId object) const {
     return alloc_id_.has_value() ? alloc_id_->Contains(object)
                                  : object.IsSmallAlloc();
   }
 
-  void SetItemToBuilder(int64_t id, int64_t size, const DataItem& item,
-                        DataSliceImpl::Builder& bldr) const;
+  // Returns pointer to the stored value or nullptr if the value is not
+  // present in this SparseSource.
+  const DataItem* Find(ObjectId object) const {
+    if (alloc_id_.has_value()) {
+      if (!alloc_id_->Contains(object)) {
+        return nullptr;
+      }
+      size_t hash = offset_map_.hash_function()(object.Offset());
+      if (!filter_.MayContain(hash)) {
+        return nullptr;
+      }
+      auto it = offset_map_.find(object.Offset(), hash);
+      return it == offset_map_.end() ? nullptr : &it->second;
+    }
+    return FindSmallAlloc(object, SmallAllocHash(object));
+  }
+
+  const DataItem* FindSmallAlloc(ObjectId object, size_t hash) const {
+    const SmallAllocBucket& bucket = small_alloc_buckets_[BucketIndex(hash)];
+    if (!bucket.filter.MayContain(hash)) {
+      return nullptr;
+    }
+    auto it = bucket.map.find(object, hash);
+    return it == bucket.map.end() ? nullptr : &it->second;
+  }
+
+  // Calls `fn(id, const DataItem&)` for the ids in [0, objs.size()) for which
+  // `selected(id)` is true and `objs[id]` has a stored value. Large batches
+  // of a partitioned SparseSource are looked up bucket by bucket, so that
+  // consecutive probes hit the same (much smaller than the whole source) hash
+  // map and filter.
+  template <class SelectedFn, class Fn>
+  void ForEachFound(absl::Span<const ObjectId> objs, SelectedFn&& selected,
+                    Fn&& fn) const;
+
+  // Returns reference to the value of a (belonging) object. Default
+  // constructed value is inserted if not present.
+  DataItem& GetOrInsert(ObjectId object) {
+    return *Emplace(object, DataItem()).first;
+  }
+
+  // Inserts `value` for a (belonging) object if not present. Returns pointer
+  // to the value of the object and whether the insertion took place.
+  std::pair<DataItem*, bool> Emplace(ObjectId object, DataItem value) {
+    DCHECK(ObjectBelongs(object));
+    if (alloc_id_.has_value()) {
+      auto [it, inserted] =
+          offset_map_.try_emplace(object.Offset(), std::move(value));
+      if (inserted) {
+        AddToFilter(offset_map_.hash_function()(object.Offset()));
+      }
+      return {&it->second, inserted};
+    }
+    const size_t hash = SmallAllocHash(object);
+    SmallAllocBucket& bucket = small_alloc_buckets_[BucketIndex(hash)];
+    auto [it, inserted] = bucket.map.try_emplace(object, std::move(value));
+    if (!inserted) {
+      return {&it->second, false};
+    }
+    AddToBucketFilter(bucket, hash);
+    if (!is_partitioned() &&
+        bucket.map.size() >= kSmallAllocPartitionThreshold) {
+      Partition();
+      SmallAllocBucket& new_bucket = small_alloc_buckets_[BucketIndex(hash)];
+      return {&new_bucket.map.find(object, hash)->second, true};
+    }
+    return {&it->second, true};
+  }
+
+  // Adds the hash of a newly inserted object to `filter_`.
+  void AddToFilter(size_t hash);
+
+  // Adds the hash of an object newly inserted into `bucket` to its filter.
+  static void AddToBucketFilter(SmallAllocBucket& bucket, size_t hash);
 
-  // Hash map object_id->value.
-  absl::flat_hash_map<ObjectId, DataItem> data_item_map_;
+  // Buckets of small alloc objects. Used only if alloc_id_ is nullopt. Either
+  // a single bucket or kSmallAllocBucketCount of them.
+  std::vector<SmallAllocBucket> small_alloc_buckets_;
+  // kSmallAllocBucketCount - 1 if partitioned, otherwise 0.
+  size_t bucket_mask_ = 0;
+  // Hash map offset->value. Used only if alloc_id_ is specified. All objects
+  // in the allocation share the high bits, so hashing just the offset is
+  // cheaper and the key is twice smaller.
+  absl::flat_hash_map<int64_t, DataItem> offset_map_;
   // If nullopt, only small allocs will be used.
   std::optional<AllocationId> alloc_id_;
+  // Contains the hashes of all keys of `offset_map_` (small alloc buckets have
+  // their own). In a chain of forks most lookups are misses in all but one of
+  // the layers, and the filter rejects them without probing the hash map.
+  HashBloomFilter filter_;
 };
 
 }  // namespace koladata::internal
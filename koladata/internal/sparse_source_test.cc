@@ -14,8 +14,10 @@
 //
 #include "koladata/internal/sparse_source.h"
 
+#include <algorithm>
 #include <array>
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <utility>
@@ -23,6 +25,8 @@
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
 #include "absl/types/span.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
@@ -37,9 +41,12 @@
 namespace koladata::internal {
 namespace {
 
+using ::absl_testing::StatusIs;
 using ::arolla::bitmap::Word;
 using ::testing::ElementsAre;
 using ::testing::ElementsAreArray;
+using ::testing::Pair;
+using ::testing::UnorderedElementsAre;
 
 TEST(SparseSourceTest, MutableObjectAttrSimple) {
   AllocationId alloc = Allocate(3);
@@ -141,6 +148,123 @@ TEST(SparseSourceTest, MutableObjectAttrSimple) {
   }
 }
 
+TEST(SparseSourceTest, ForEach) {
+  AllocationId alloc = Allocate(100);
+  AllocationId other_alloc = Allocate(100);
+  SparseSource source(alloc);
+  source.Set(alloc.ObjectByOffset(5), DataItem(5));
+  source.Set(alloc.ObjectByOffset(7), DataItem());
+  // Ignored, since the object doesn't belong to the allocation.
+  source.Set(other_alloc.ObjectByOffset(9), DataItem(9));
+  EXPECT_EQ(source.size(), 2);
+  EXPECT_EQ(source.Get(other_alloc.ObjectByOffset(5)), std::nullopt);
+
+  std::vector<std::pair<ObjectId, DataItem>> items;
+  source.ForEach([&](ObjectId obj, const DataItem& item) {
+    items.emplace_back(obj, item);
+  });
+  EXPECT_THAT(items, UnorderedElementsAre(
+                         Pair(alloc.ObjectByOffset(5), DataItem(5)),
+                         Pair(alloc.ObjectByOffset(7), DataItem())));
+
+  SparseSource small_alloc_source;
+  ObjectId obj = AllocateSingleObject();
+  small_alloc_source.Set(obj, DataItem(1));
+  small_alloc_source.Set(alloc.ObjectByOffset(5), DataItem(5));
+  EXPECT_EQ(small_alloc_source.size(), 1);
+  int count = 0;
+  EXPECT_THAT(small_alloc_source.ForEach(
+                  [&](ObjectId, const DataItem&) -> absl::Status {
+                    ++count;
+                    return absl::InvalidArgumentError("stop");
+                  }),
+              StatusIs(absl::StatusCode::kInvalidArgument, "stop"));
+  EXPECT_EQ(count, 1);
+}
+
+TEST(SparseSourceTest, ManyObjects) {
+  // Enough objects to rebuild the lookup filter several times.
+  constexpr int64_t kSize = 5000;
+  AllocationId alloc = Allocate(2 * kSize);
+  std::vector<ObjectId> small_objs(2 * kSize);
+  AllocateSingleObjects(absl::MakeSpan(small_objs));
+  SparseSource source(alloc);
+  SparseSource small_alloc_source;
+  for (int64_t i = 0; i < kSize; ++i) {
+    source.Set(alloc.ObjectByOffset(2 * i), DataItem(i));
+    small_alloc_source.Set(small_objs[2 * i], DataItem(i));
+  }
+  EXPECT_EQ(source.size(), kSize);
+  EXPECT_EQ(small_alloc_source.size(), kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    EXPECT_EQ(source.Get(alloc.ObjectByOffset(2 * i)), DataItem(i));
+    EXPECT_EQ(source.Get(alloc.ObjectByOffset(2 * i + 1)), std::nullopt);
+    EXPECT_EQ(small_alloc_source.Get(small_objs[2 * i]), DataItem(i));
+    EXPECT_EQ(small_alloc_source.Get(small_objs[2 * i + 1]), std::nullopt);
+  }
+}
+
+TEST(SparseSourceTest, PartitionedSmallAllocs) {
+  constexpr int64_t kSize = SparseSource::kSmallAllocPartitionThreshold + 100;
+  std::vector<ObjectId> objs(2 * kSize);
+  AllocateSingleObjects(absl::MakeSpan(objs));
+  SparseSource source;
+  for (int64_t i = 0; i < kSize - 200; ++i) {
+    source.Set(objs[2 * i], DataItem(i));
+  }
+  EXPECT_FALSE(source.is_partitioned());
+  for (int64_t i = kSize - 200; i < kSize; ++i) {
+    source.Set(objs[2 * i], DataItem(i));
+  }
+  ASSERT_TRUE(source.is_partitioned());
+  EXPECT_EQ(source.size(), kSize);
+
+  auto objs_array = arolla::CreateFullDenseArray<ObjectId>(objs);
+  DataSliceImpl values = source.Get(objs_array);
+  ASSERT_EQ(values.size(), 2 * kSize);
+  for (int64_t i = 0; i < kSize; ++i) {
+    ASSERT_EQ(source.Get(objs[2 * i]), DataItem(i));
+    ASSERT_EQ(source.Get(objs[2 * i + 1]), std::nullopt);
+    ASSERT_EQ(values[2 * i], DataItem(i));
+    ASSERT_EQ(values[2 * i + 1], DataItem());
+  }
+
+  // Every value is in exactly one bucket.
+  int64_t count = 0;
+  int64_t sum = 0;
+  for (size_t begin = 0; begin < SparseSource::kSmallAllocBucketCount;
+       begin += 100) {
+    ASSERT_OK(source.ForEachInBuckets(
+        begin, std::min(begin + 100, SparseSource::kSmallAllocBucketCount),
+        [&](ObjectId obj, const DataItem& value) {
+          ++count;
+          sum += value.value<int64_t>();
+          return absl::OkStatus();
+        }));
+  }
+  EXPECT_EQ(count, kSize);
+  EXPECT_EQ(sum, kSize * (kSize - 1) / 2);
+}
+
+TEST(SparseSourceTest, Partition) {
+  std::vector<ObjectId> objs(10);
+  AllocateSingleObjects(absl::MakeSpan(objs));
+  SparseSource source;
+  for (int64_t i = 0; i < 5; ++i) {
+    source.Set(objs[i], DataItem(i));
+  }
+  source.Partition();
+  EXPECT_TRUE(source.is_partitioned());
+  source.Set(objs[5], DataItem(5));
+  source.Set(objs[0], DataItem());
+  EXPECT_EQ(source.size(), 6);
+  EXPECT_EQ(source.Get(objs[0]), DataItem());
+  for (int64_t i = 1; i < 6; ++i) {
+    EXPECT_EQ(source.Get(objs[i]), DataItem(i));
+  }
+  EXPECT_EQ(source.Get(objs[6]), std::nullopt);
+}
+
 TEST(SparseSourceTest, Empty) {
   auto ds = std::make_shared<SparseSource>();
   EXPECT_EQ(ds->Get(AllocateSingleObject()), std::nullopt);
@@ -0,0 +1,292 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/spill_pool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/log/log.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dense_source.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::internal {
+namespace {
+
+// Values of a source that is kept in memory. Shared with the readers, so an
+// eviction doesn't invalidate the values that are being read.
+struct Resident {
+  DataSliceImpl values;
+  std::shared_ptr<const DenseSource> source;
+};
+
+absl::StatusOr<std::shared_ptr<const Resident>> MakeResident(
+    AllocationId alloc, const DataSliceImpl& values) {
+  if (values.size() > alloc.Capacity()) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("values don't fit into the allocation: ", values.size(),
+                     " > ", alloc.Capacity()));
+  }
+  auto resident = std::make_shared<Resident>();
+  resident->values = values;
+  if (values.is_empty_and_unknown()) {
+    ASSIGN_OR_RETURN(resident->source,
+                     DenseSource::CreateMutable(alloc, values.size()));
+  } else {
+    ASSIGN_OR_RETURN(resident->source,
+                     DenseSource::CreateReadonly(alloc, values));
+  }
+  return resident;
+}
+
+}  // namespace
+
+class SpillPool::Source final : public DenseSource {
+ public:
+  Source(std::shared_ptr<SpillPool> pool, AllocationId alloc,
+         std::shared_ptr<const Resident> resident)
+      : pool_(std::move(pool)),
+        alloc_(alloc),
+        size_(resident->values.size()),
+        bytes_(resident->source->EstimateMemoryUsage()),
+        last_access_(pool_->clock_.fetch_add(1, std::memory_order_relaxed)),
+        resident_(std::move(resident)) {
+    pool_->resident_bytes_ += bytes_;
+  }
+
+  ~Source() final {
+    absl::MutexLock lock(&mutex_);
+    if (resident_ != nullptr) {
+      pool_->resident_bytes_ -= bytes_;
+    } else {
+      pool_->spilled_bytes_ -= bytes_;
+    }
+    if (key_.has_value()) {
+      pool_->storage_->Remove(*key_);
+    }
+  }
+
+  AllocationId allocation_id() const final { return alloc_; }
+  int64_t size() const final { return size_; }
+
+  DataItem Get(ObjectId object) const final {
+    return Pinned()->source->Get(object);
+  }
+
+  DataSliceImpl Get(const ObjectIdArray& objects,
+                    bool check_alloc_id) const final {
+    return Pinned()->source->Get(objects, check_alloc_id);
+  }
+
+  void Get(const ObjectIdArray& objects,
+           DataSliceImpl::Builder& bldr) const final {
+    Pinned()->source->Get(objects, bldr);
+  }
+
+  std::optional<DataSliceImpl> GetPrefix(int64_t size) const final {
+    return Pinned()->source->GetPrefix(size);
+  }
+
+  DataSliceImpl GetAll() const final { return Pinned()->values; }
+
+  bool IsMutable() const final { return false; }
+
+  absl::Status Set(ObjectId object, const DataItem& value) final {
+    return absl::FailedPreconditionError(
+        "SetAttr is not allowed for an immutable DenseSource.");
+  }
+
+  absl::Status Set(const ObjectIdArray& objects,
+                   const DataSliceImpl& values) final {
+    return absl::FailedPreconditionError(
+        "SetAttr is not allowed for an immutable DenseSource.");
+  }
+
+  absl::Status SetUnitAndUpdateMissingObjects(
+      const ObjectIdArray& objects,
+      std::vector<ObjectId>& missing_objects) final {
+    return absl::FailedPreconditionError(
+        "SetUnitAndUpdateMissingObjects is not allowed for an immutable "
+        "DenseSource.");
+  }
+
+  absl::Status SetAllSkipMissing(const DataSliceImpl& values,
+                                 ConflictHandlingOption option) final {
+    return absl::FailedPreconditionError(
+        "SetAttr is not allowed for an immutable DenseSource.");
+  }
+
+  std::shared_ptr<DenseSource> CreateMutableCopy() const final {
+    return Pinned()->source->CreateMutableCopy();
+  }
+
+  // Evicted values take no memory.
+  int64_t EstimateMemoryUsage() const final {
+    absl::MutexLock lock(&mutex_);
+    return resident_ != nullptr ? bytes_ : 0;
+  }
+
+  int64_t last_access() const {
+    return last_access_.load(std::memory_order_relaxed);
+  }
+
+  const SpillPool* pool() const { return pool_.get(); }
+
+  // Writes the values to the storage (unless already written) and releases
+  // them.
+  void Evict() {
+    absl::MutexLock lock(&mutex_);
+    if (resident_ == nullptr) {
+      return;
+    }
+    if (!key_.has_value()) {
+      absl::StatusOr<std::string> key =
+          pool_->storage_->Write(alloc_, resident_->values);
+      if (!key.ok()) {
+        LOG(WARNING) << "failed to spill a DenseSource: " << key.status();
+        ++pool_->write_failures_;
+        return;
+      }
+      key_ = *std::move(key);
+    }
+    resident_ = nullptr;
+    pool_->resident_bytes_ -= bytes_;
+    pool_->spilled_bytes_ += bytes_;
+    ++pool_->evictions_;
+  }
+
+ private:
+  std::shared_ptr<const Resident> Pinned() const {
+    last_access_.store(pool_->clock_.fetch_add(1, std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+    std::shared_ptr<const Resident> resident;
+    {
+      absl::MutexLock lock(&mutex_);
+      if (resident_ != nullptr) {
+        return resident_;
+      }
+      resident_ = Reload();
+      resident = resident_;
+    }
+    pool_->EnforceBudget();
+    return resident;
+  }
+
+  std::shared_ptr<const Resident> Reload() const
+      ABSL_EXCLUSIVE_LOCKS_REQUIRED(mutex_) {
+    ++pool_->reloads_;
+    pool_->spilled_bytes_ -= bytes_;
+    pool_->resident_bytes_ += bytes_;
+    absl::StatusOr<DataSliceImpl> values =
+        pool_->storage_->Read(*key_, alloc_, size_);
+    absl::StatusOr<std::shared_ptr<const Resident>> resident =
+        values.ok() ? MakeResident(alloc_, *values) : values.status();
+    if (resident.ok() && (*resident)->values.size() == size_) {
+      return *std::move(resident);
+    }
+    LOG(ERROR) << "failed to read back a spilled DenseSource: "
+               << (resident.ok() ? absl::InternalError("size mismatch")
+                                 : resident.status());
+    ++pool_->read_failures_;
+    return *MakeResident(alloc_,
+                         DataSliceImpl::CreateEmptyAndUnknownType(size_));
+  }
+
+  const std::shared_ptr<SpillPool> pool_;
+  const AllocationId alloc_;
+  const int64_t size_;
+  const int64_t bytes_;
+  mutable std::atomic<int64_t> last_access_;
+  mutable absl::Mutex mutex_;
+  mutable std::shared_ptr<const Resident> resident_ ABSL_GUARDED_BY(mutex_);
+  std::optional<std::string> key_ ABSL_GUARDED_BY(mutex_);
+};
+
+std::shared_ptr<SpillPool> SpillPool::Create(
+    const Options& options, std::unique_ptr<Storage> storage) {
+  return std::shared_ptr<SpillPool>(
+      new SpillPool(options, std::move(storage)));
+}
+
+absl::StatusOr<std::shared_ptr<DenseSource>> SpillPool::CreateSource(
+    AllocationId alloc, const DataSliceImpl& values) {
+  ASSIGN_OR_RETURN(std::shared_ptr<const Resident> resident,
+                   MakeResident(alloc, values));
+  auto source =
+      std::make_shared<Source>(shared_from_this(), alloc, std::move(resident));
+  {
+    absl::MutexLock lock(&mutex_);
+    sources_.push_back(source);
+  }
+  EnforceBudget();
+  return source;
+}
+
+bool SpillPool::Manages(const DenseSource& source) const {
+  const auto* s = dynamic_cast<const Source*>(&source);
+  return s != nullptr && s->pool() == this;
+}
+
+void SpillPool::EnforceBudget() {
+  if (resident_bytes_.load() <= options_.memory_budget_bytes) {
+    return;
+  }
+  absl::MutexLock lock(&mutex_);
+  std::vector<std::shared_ptr<Source>> candidates;
+  candidates.reserve(sources_.size());
+  // Also drops the sources that no longer exist.
+  std::erase_if(sources_, [&](const std::weak_ptr<Source>& weak) {
+    std::shared_ptr<Source> source = weak.lock();
+    if (source == nullptr) {
+      return true;
+    }
+    candidates.push_back(std::move(source));
+    return false;
+  });
+  std::sort(candidates.begin(), candidates.end(),
+            [](const auto& a, const auto& b) {
+              return a->last_access() < b->last_access();
+            });
+  for (const std::shared_ptr<Source>& source : candidates) {
+    if (resident_bytes_.load() <= options_.memory_budget_bytes) {
+      break;
+    }
+    source->Evict();
+  }
+}
+
+SpillPool::Metrics SpillPool::GetMetrics() const {
+  return {.resident_bytes = resident_bytes_.load(),
+          .spilled_bytes = spilled_bytes_.load(),
+          .evictions = evictions_.load(),
+          .reloads = reloads_.load(),
+          .write_failures = write_failures_.load(),
+          .read_failures = read_failures_.load()};
+}
+
+}  // namespace koladata::internal
@@ -0,0 +1,124 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_SPILL_POOL_H_
+#define KOLADATA_INTERNAL_SPILL_POOL_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/thread_annotations.h"
+#include "absl/status/statusor.h"
+#include "absl/synchronization/mutex.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dense_source.h"
+#include "koladata/internal/object_id.h"
+
+namespace koladata::internal {
+
+// Memory budget for the values of readonly DenseSources.
+//
+// Sources created by the pool keep their values in memory while the total
+// size of the resident values fits into the budget. Once it is exceeded, the
+// least recently used sources are evicted: their values are written to the
+// Storage (only on the first eviction, as the values never change) and
+// released. An evicted source reads its values back on the next access, which
+// may evict other sources.
+//
+// Accesses to a source managed by the pool take a mutex, so the pool is meant
+// for large and rarely touched allocations.
+class SpillPool : public std::enable_shared_from_this<SpillPool> {
+ public:
+  // Keeps the values of evicted sources. Must be thread-safe.
+  class Storage {
+   public:
+    virtual ~Storage() = default;
+
+    // Stores `values` of allocation `alloc` and returns a key to read them.
+    virtual absl::StatusOr<std::string> Write(AllocationId alloc,
+                                              const DataSliceImpl& values) = 0;
+
+    // Returns the values stored by Write.
+    virtual absl::StatusOr<DataSliceImpl> Read(const std::string& key,
+                                               AllocationId alloc,
+                                               int64_t size) = 0;
+
+    // Releases the stored values. Called when the source is destroyed.
+    virtual void Remove(const std::string& key) = 0;
+  };
+
+  struct Options {
+    // Budget for the total EstimateMemoryUsage of the resident values.
+    int64_t memory_budget_bytes = int64_t{1} << 30;
+  };
+
+  struct Metrics {
+    // Estimated size of the values currently kept in memory.
+    int64_t resident_bytes = 0;
+    // Estimated size of the values currently evicted.
+    int64_t spilled_bytes = 0;
+    // Number of evictions and reads back from the storage.
+    int64_t evictions = 0;
+    int64_t reloads = 0;
+    // Number of failed writes and reads. A source that failed to be written
+    // stays in memory; a source that failed to be read back has no values.
+    int64_t write_failures = 0;
+    int64_t read_failures = 0;
+  };
+
+  static std::shared_ptr<SpillPool> Create(const Options& options,
+                                           std::unique_ptr<Storage> storage);
+
+  // Returns a readonly DenseSource with `values` managed by the pool. Can
+  // evict other sources if the budget is exceeded.
+  absl::StatusOr<std::shared_ptr<DenseSource>> CreateSource(
+      AllocationId alloc, const DataSliceImpl& values);
+
+  // Returns true if `source` was created by this pool.
+  bool Manages(const DenseSource& source) const;
+
+  // Evicts the least recently used sources until the resident values fit into
+  // the budget.
+  void EnforceBudget();
+
+  Metrics GetMetrics() const;
+
+ private:
+  class Source;
+
+  SpillPool(const Options& options, std::unique_ptr<Storage> storage)
+      : options_(options), storage_(std::move(storage)) {}
+
+  const Options options_;
+  const std::unique_ptr<Storage> storage_;
+  // Logical clock for the least recently used order.
+  std::atomic<int64_t> clock_ = 0;
+  std::atomic<int64_t> resident_bytes_ = 0;
+  std::atomic<int64_t> spilled_bytes_ = 0;
+  std::atomic<int64_t> evictions_ = 0;
+  std::atomic<int64_t> reloads_ = 0;
+  std::atomic<int64_t> write_failures_ = 0;
+  std::atomic<int64_t> read_failures_ = 0;
+
+  absl::Mutex mutex_;
+  std::vector<std::weak_ptr<Source>> sources_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_SPILL_POOL_H_
@@ -0,0 +1,193 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/spill_pool.h"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/synchronization/mutex.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dense_source.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::StatusIs;
+
+class InMemoryStorage : public SpillPool::Storage {
+ public:
+  absl::StatusOr<std::string> Write(AllocationId alloc,
+                                    const DataSliceImpl& values) override {
+    absl::MutexLock lock(&mutex_);
+    if (fail_writes_) {
+      return absl::UnavailableError("disk is full");
+    }
+    std::string key = absl::StrCat(next_key_++);
+    values_.emplace(key, values);
+    return key;
+  }
+
+  absl::StatusOr<DataSliceImpl> Read(const std::string& key,
+                                     AllocationId alloc,
+                                     int64_t size) override {
+    absl::MutexLock lock(&mutex_);
+    auto it = values_.find(key);
+    if (it == values_.end()) {
+      return absl::NotFoundError(key);
+    }
+    return it->second;
+  }
+
+  void Remove(const std::string& key) override {
+    absl::MutexLock lock(&mutex_);
+    values_.erase(key);
+  }
+
+  int64_t stored_count() {
+    absl::MutexLock lock(&mutex_);
+    return values_.size();
+  }
+
+  void set_fail_writes(bool fail) {
+    absl::MutexLock lock(&mutex_);
+    fail_writes_ = fail;
+  }
+
+  void Clear() {
+    absl::MutexLock lock(&mutex_);
+    values_.clear();
+  }
+
+ private:
+  absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, DataSliceImpl> values_;
+  int64_t next_key_ = 0;
+  bool fail_writes_ = false;
+};
+
+DataSliceImpl CreateValues(int64_t size, int value) {
+  return DataSliceImpl::Create(arolla::CreateConstDenseArray<int>(size, value));
+}
+
+TEST(SpillPoolTest, EvictsLeastRecentlyUsed) {
+  auto storage = std::make_unique<InMemoryStorage>();
+  InMemoryStorage* storage_ptr = storage.get();
+  AllocationId alloc1 = Allocate(1000);
+  AllocationId alloc2 = Allocate(1000);
+  ASSERT_OK_AND_ASSIGN(std::shared_ptr<DenseSource> probe,
+                       DenseSource::CreateReadonly(alloc1,
+                                                   CreateValues(1000, 1)));
+  const int64_t source_bytes = probe->EstimateMemoryUsage();
+  auto pool = SpillPool::Create(
+      {.memory_budget_bytes = source_bytes + source_bytes / 2},
+      std::move(storage));
+
+  ASSERT_OK_AND_ASSIGN(auto source1,
+                       pool->CreateSource(alloc1, CreateValues(1000, 1)));
+  EXPECT_EQ(pool->GetMetrics().resident_bytes, source_bytes);
+  EXPECT_EQ(pool->GetMetrics().evictions, 0);
+  EXPECT_TRUE(pool->Manages(*source1));
+  EXPECT_FALSE(pool->Manages(*probe));
+
+  ASSERT_OK_AND_ASSIGN(auto source2,
+                       pool->CreateSource(alloc2, CreateValues(1000, 2)));
+  SpillPool::Metrics metrics = pool->GetMetrics();
+  EXPECT_EQ(metrics.resident_bytes, source_bytes);
+  EXPECT_EQ(metrics.spilled_bytes, source_bytes);
+  EXPECT_EQ(metrics.evictions, 1);
+  EXPECT_EQ(source1->EstimateMemoryUsage(), 0);
+  EXPECT_EQ(source2->EstimateMemoryUsage(), source_bytes);
+  EXPECT_EQ(storage_ptr->stored_count(), 1);
+
+  // Reading source1 evicts source2.
+  EXPECT_EQ(source1->Get(alloc1.ObjectByOffset(7)), DataItem(1));
+  metrics = pool->GetMetrics();
+  EXPECT_EQ(metrics.reloads, 1);
+  EXPECT_EQ(metrics.evictions, 2);
+  EXPECT_EQ(source1->EstimateMemoryUsage(), source_bytes);
+  EXPECT_EQ(source2->EstimateMemoryUsage(), 0);
+  EXPECT_EQ(source2->Get(alloc2.ObjectByOffset(999)), DataItem(2));
+  EXPECT_EQ(source2->size(), 1000);
+
+  // The stored values are removed together with the sources.
+  source1.reset();
+  source2.reset();
+  EXPECT_EQ(storage_ptr->stored_count(), 0);
+  metrics = pool->GetMetrics();
+  EXPECT_EQ(metrics.resident_bytes, 0);
+  EXPECT_EQ(metrics.spilled_bytes, 0);
+}
+
+TEST(SpillPoolTest, ReadonlyAndMutableCopy) {
+  auto pool = SpillPool::Create({.memory_budget_bytes = 0},
+                                std::make_unique<InMemoryStorage>());
+  AllocationId alloc = Allocate(10);
+  ASSERT_OK_AND_ASSIGN(auto source,
+                       pool->CreateSource(alloc, CreateValues(10, 5)));
+  EXPECT_EQ(source->EstimateMemoryUsage(), 0);
+  EXPECT_FALSE(source->IsMutable());
+  EXPECT_THAT(source->Set(alloc.ObjectByOffset(0), DataItem(1)),
+              StatusIs(absl::StatusCode::kFailedPrecondition));
+
+  std::shared_ptr<DenseSource> copy = source->CreateMutableCopy();
+  ASSERT_OK(copy->Set(alloc.ObjectByOffset(0), DataItem(1)));
+  EXPECT_EQ(copy->Get(alloc.ObjectByOffset(0)), DataItem(1));
+  EXPECT_EQ(source->Get(alloc.ObjectByOffset(0)), DataItem(5));
+}
+
+TEST(SpillPoolTest, StorageFailures) {
+  auto storage = std::make_unique<InMemoryStorage>();
+  InMemoryStorage* storage_ptr = storage.get();
+  auto pool = SpillPool::Create({.memory_budget_bytes = 0}, std::move(storage));
+  AllocationId alloc = Allocate(10);
+
+  storage_ptr->set_fail_writes(true);
+  ASSERT_OK_AND_ASSIGN(auto source,
+                       pool->CreateSource(alloc, CreateValues(10, 5)));
+  // Failed to spill, so the values stay in memory.
+  EXPECT_EQ(pool->GetMetrics().write_failures, 1);
+  EXPECT_GT(source->EstimateMemoryUsage(), 0);
+  EXPECT_EQ(source->Get(alloc.ObjectByOffset(3)), DataItem(5));
+
+  storage_ptr->set_fail_writes(false);
+  pool->EnforceBudget();
+  EXPECT_EQ(source->EstimateMemoryUsage(), 0);
+  storage_ptr->Clear();
+  // Failed to read back, so the values are missing.
+  EXPECT_EQ(source->Get(alloc.ObjectByOffset(3)), DataItem());
+  EXPECT_EQ(pool->GetMetrics().read_failures, 1);
+}
+
+TEST(SpillPoolTest, InvalidValues) {
+  auto pool = SpillPool::Create({}, std::make_unique<InMemoryStorage>());
+  EXPECT_THAT(pool->CreateSource(Allocate(10), CreateValues(1000, 1)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       ::testing::HasSubstr("don't fit")));
+}
+
+}  // namespace
+}  // namespace koladata::internal
@@ -14,13 +14,17 @@
 //
 #include "koladata/internal/stable_fingerprint.h"
 
+#include <cstdint>
 #include <limits>
 #include <string>
 #include <type_traits>
 #include <utility>
+#include <vector>
 
 #include "gtest/gtest.h"
 #include "absl/container/flat_hash_set.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/types.h"
 #include "arolla/util/fingerprint.h"
@@ -81,6 +85,20 @@ TEST(FingerprintTest, CombineRawBytes) {
   }
 }
 
+TEST(FingerprintTest, CombineBatch) {
+  std::vector<int64_t> values = {1, 2, 3, 4, 5, 6, 7};
+  std::vector<StableFingerprintHasher> hashers(
+      values.size(), StableFingerprintHasher("dummy-salt"));
+  StableFingerprintHasher::CombineToAll(absl::MakeSpan(hashers),
+                                        absl::string_view("attr"));
+  StableFingerprintHasher::CombineBatch(absl::MakeSpan(hashers),
+                                        absl::MakeConstSpan(values));
+  for (int64_t i = 0; i < values.size(); ++i) {
+    EXPECT_EQ(std::move(hashers[i]).Finish(),
+              MakeDummyFingerprint(absl::string_view("attr"), values[i]));
+  }
+}
+
 TEST(FingerprintTest, AllTypes) {
   absl::flat_hash_set<arolla::Fingerprint> fps;
   arolla::meta::foreach_type(supported_types_list(), [&](auto tpe) {
@@ -0,0 +1,139 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/trace.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/base/nullability.h"
+#include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+
+namespace koladata::internal {
+namespace {
+
+thread_local TraceContext* current_context = nullptr;
+
+void AppendJsonString(absl::string_view str, std::string& out) {
+  out.push_back('"');
+  for (char c : str) {
+    switch (c) {
+      case '"':
+        out.append("\\\"");
+        break;
+      case '\\':
+        out.append("\\\\");
+        break;
+      case '\n':
+        out.append("\\n");
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20) {
+          absl::StrAppendFormat(&out, "\\u%04x", c);
+        } else {
+          out.push_back(c);
+        }
+    }
+  }
+  out.push_back('"');
+}
+
+}  // namespace
+
+TraceContext::TraceContext()
+    : start_time_(absl::Now()), previous_(current_context) {
+  current_context = this;
+}
+
+TraceContext::~TraceContext() {
+  DCHECK_EQ(current_context, this) << "TraceContexts must be nested";
+  current_context = previous_;
+}
+
+absl::Nullable<TraceContext*> TraceContext::Current() {
+  return current_context;
+}
+
+std::string TraceContext::ToChromeTraceJson() const {
+  std::string res = "{\"traceEvents\":[";
+  for (size_t i = 0; i < events_.size(); ++i) {
+    const Event& event = events_[i];
+    if (i > 0) {
+      res.push_back(',');
+    }
+    res.append("\n{\"name\":");
+    AppendJsonString(event.name, res);
+    res.append(",\"cat\":");
+    AppendJsonString(event.category, res);
+    absl::StrAppendFormat(
+        &res, ",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":0,\"tid\":0",
+        absl::ToDoubleMicroseconds(event.start),
+        absl::ToDoubleMicroseconds(event.duration));
+    if (!event.args.empty()) {
+      res.append(",\"args\":{");
+      for (size_t j = 0; j < event.args.size(); ++j) {
+        if (j > 0) {
+          res.push_back(',');
+        }
+        AppendJsonString(event.args[j].first, res);
+        res.push_back(':');
+        AppendJsonString(event.args[j].second, res);
+      }
+      res.push_back('}');
+    }
+    res.push_back('}');
+  }
+  res.append("\n]}\n");
+  return res;
+}
+
+TraceSpan::TraceSpan(absl::string_view category, absl::string_view name)
+    : context_(current_context) {
+  if (context_ != nullptr) {
+    event_.category = std::string(category);
+    event_.name = std::string(name);
+    start_time_ = absl::Now();
+  }
+}
+
+TraceSpan::~TraceSpan() {
+  // A TraceContext created inside of the span is already destroyed, so
+  // `context_` is still the current one.
+  if (context_ != nullptr) {
+    event_.start = start_time_ - context_->start_time_;
+    event_.duration = absl::Now() - start_time_;
+    context_->events_.push_back(std::move(event_));
+  }
+}
+
+void TraceSpan::AddArg(absl::string_view key, std::string value) {
+  if (context_ != nullptr) {
+    event_.args.emplace_back(std::string(key), std::move(value));
+  }
+}
+
+void TraceSpan::AddArg(absl::string_view key, int64_t value) {
+  if (context_ != nullptr) {
+    event_.args.emplace_back(std::string(key), absl::StrCat(value));
+  }
+}
+
+}  // namespace koladata::internal
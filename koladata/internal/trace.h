@@ -0,0 +1,102 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_TRACE_H_
+#define KOLADATA_INTERNAL_TRACE_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/strings/string_view.h"
+#include "absl/time/time.h"
+
+namespace koladata::internal {
+
+// Collects the TraceSpans of the current thread while alive. Contexts can be
+// nested; a span is recorded only in the innermost one. Spans of other
+// threads (e.g. of parallel evaluation on an executor) are not recorded.
+//
+// Example:
+//   TraceContext trace;
+//   ... evaluate exprs or call functors ...
+//   std::string json = trace.ToChromeTraceJson();
+//
+// The result can be loaded into chrome://tracing or ui.perfetto.dev.
+class TraceContext {
+ public:
+  struct Event {
+    std::string category;
+    std::string name;
+    // Relative to the creation of the context.
+    absl::Duration start;
+    absl::Duration duration;
+    std::vector<std::pair<std::string, std::string>> args;
+  };
+
+  TraceContext();
+  ~TraceContext();
+
+  TraceContext(const TraceContext&) = delete;
+  TraceContext& operator=(const TraceContext&) = delete;
+
+  // Returns the innermost context of the current thread, or nullptr.
+  static absl::Nullable<TraceContext*> Current();
+
+  // Events in the order the spans were finished, i.e. nested spans precede
+  // the enclosing ones.
+  const std::vector<Event>& events() const { return events_; }
+
+  // Returns the events in the Chrome trace event format (as complete "X"
+  // events).
+  std::string ToChromeTraceJson() const;
+
+ private:
+  friend class TraceSpan;
+
+  absl::Time start_time_;
+  std::vector<Event> events_;
+  TraceContext* previous_;
+};
+
+// Records the time between its construction and destruction as an event of
+// the current TraceContext. Does nothing (beyond a thread-local lookup) if
+// there is no TraceContext.
+class TraceSpan {
+ public:
+  TraceSpan(absl::string_view category, absl::string_view name);
+  ~TraceSpan();
+
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+
+  // Returns true if the span is recorded. Can be used to skip computing the
+  // arguments.
+  bool active() const { return context_ != nullptr; }
+
+  // Adds an argument shown with the event. No-op if the span is not active.
+  void AddArg(absl::string_view key, std::string value);
+  void AddArg(absl::string_view key, int64_t value);
+
+ private:
+  absl::Nullable<TraceContext*> context_;
+  TraceContext::Event event_;
+  absl::Time start_time_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_TRACE_H_
@@ -0,0 +1,91 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/trace.h"
+
+#include <cstdint>
+#include <string>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/time/time.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::testing::ElementsAre;
+using ::testing::Field;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
+using ::testing::Pair;
+
+TEST(TraceTest, NoContext) {
+  EXPECT_EQ(TraceContext::Current(), nullptr);
+  TraceSpan span("op", "foo");
+  EXPECT_FALSE(span.active());
+  span.AddArg("x", int64_t{1});
+}
+
+TEST(TraceTest, NestedSpans) {
+  TraceContext trace;
+  EXPECT_EQ(TraceContext::Current(), &trace);
+  {
+    TraceSpan outer("functor", "outer");
+    EXPECT_TRUE(outer.active());
+    outer.AddArg("size", int64_t{5});
+    {
+      TraceSpan inner("op", "inner");
+      inner.AddArg("cache", std::string("miss"));
+    }
+  }
+  ASSERT_THAT(trace.events(),
+              ElementsAre(Field(&TraceContext::Event::name, "inner"),
+                          Field(&TraceContext::Event::name, "outer")));
+  const auto& inner = trace.events()[0];
+  const auto& outer = trace.events()[1];
+  EXPECT_EQ(inner.category, "op");
+  EXPECT_THAT(inner.args, ElementsAre(Pair("cache", "miss")));
+  EXPECT_THAT(outer.args, ElementsAre(Pair("size", "5")));
+  EXPECT_GE(inner.start, outer.start);
+  EXPECT_LE(inner.start + inner.duration, outer.start + outer.duration);
+  EXPECT_GE(outer.duration, absl::ZeroDuration());
+}
+
+TEST(TraceTest, NestedContexts) {
+  TraceContext outer;
+  {
+    TraceContext inner;
+    EXPECT_EQ(TraceContext::Current(), &inner);
+    TraceSpan span("op", "foo");
+  }
+  EXPECT_EQ(TraceContext::Current(), &outer);
+  EXPECT_THAT(outer.events(), IsEmpty());
+}
+
+TEST(TraceTest, ChromeTraceJson) {
+  TraceContext trace;
+  {
+    TraceSpan span("op", "kd.\"quoted\"");
+    span.AddArg("types", std::string("INT32\n"));
+  }
+  std::string json = trace.ToChromeTraceJson();
+  EXPECT_THAT(json, HasSubstr("{\"traceEvents\":["));
+  EXPECT_THAT(json, HasSubstr("\"name\":\"kd.\\\"quoted\\\"\""));
+  EXPECT_THAT(json, HasSubstr("\"cat\":\"op\""));
+  EXPECT_THAT(json, HasSubstr("\"ph\":\"X\""));
+  EXPECT_THAT(json, HasSubstr("\"args\":{\"types\":\"INT32\\n\"}"));
+}
+
+}  // namespace
+}  // namespace koladata::internal
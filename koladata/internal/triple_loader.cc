@@ -0,0 +1,155 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/triple_loader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::internal {
+namespace {
+
+// Objects of all small allocations are written together, objects of a big
+// allocation are written separately from the other allocations.
+bool SameGroup(ObjectId a, ObjectId b) {
+  if (a.IsSmallAlloc() || b.IsSmallAlloc()) {
+    return a.IsSmallAlloc() && b.IsSmallAlloc();
+  }
+  return AllocationId(a) == AllocationId(b);
+}
+
+bool GroupLess(ObjectId a, ObjectId b) {
+  if (a.IsSmallAlloc() || b.IsSmallAlloc()) {
+    return a.IsSmallAlloc() && !b.IsSmallAlloc();
+  }
+  return AllocationId(a) < AllocationId(b);
+}
+
+AllocationIdSet GroupAllocationIds(ObjectId id) {
+  return id.IsSmallAlloc() ? AllocationIdSet(/*contains_small_allocation_id=*/
+                                             true)
+                           : AllocationIdSet(AllocationId(id));
+}
+
+// Calls `fn(begin, end)` for every run of `items` in the same group.
+template <typename T, typename GetId, typename Fn>
+absl::Status ForEachGroup(absl::Span<const T> items, GetId get_id, Fn fn) {
+  for (int64_t begin = 0; begin < items.size();) {
+    int64_t end = begin + 1;
+    while (end < items.size() &&
+           SameGroup(get_id(items[begin]), get_id(items[end]))) {
+      ++end;
+    }
+    RETURN_IF_ERROR(fn(begin, end));
+    begin = end;
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status TripleLoader::AddAttr(ObjectId object, absl::string_view attr,
+                                   DataItem value) {
+  attrs_[attr].push_back({object, std::move(value)});
+  return MaybeFlush();
+}
+
+absl::Status TripleLoader::AddDictItem(ObjectId dict, DataItem key,
+                                       DataItem value) {
+  dict_items_.push_back({dict, std::move(key), std::move(value)});
+  return MaybeFlush();
+}
+
+absl::Status TripleLoader::Flush() {
+  for (auto& [attr, items] : attrs_) {
+    RETURN_IF_ERROR(FlushAttr(attr, items));
+  }
+  attrs_.clear();
+  RETURN_IF_ERROR(FlushDicts());
+  buffered_count_ = 0;
+  return absl::OkStatus();
+}
+
+absl::Status TripleLoader::FlushAttr(absl::string_view attr,
+                                     std::vector<AttrItem>& items) {
+  // Stable, so that the duplicates of an object stay in the order they were
+  // added in, and only the last one is kept.
+  std::stable_sort(items.begin(), items.end(),
+                   [](const AttrItem& a, const AttrItem& b) {
+                     if (GroupLess(a.object, b.object)) return true;
+                     if (GroupLess(b.object, a.object)) return false;
+                     return a.object < b.object;
+                   });
+  auto last = std::unique(items.rbegin(), items.rend(),
+                          [](const AttrItem& a, const AttrItem& b) {
+                            return a.object == b.object;
+                          });
+  items.erase(items.begin(), last.base());
+  return ForEachGroup<AttrItem>(
+      items, [](const AttrItem& item) { return item.object; },
+      [&](int64_t begin, int64_t end) -> absl::Status {
+        arolla::DenseArrayBuilder<ObjectId> objects_bldr(end - begin);
+        DataSliceImpl::Builder values_bldr(end - begin);
+        for (int64_t i = begin; i < end; ++i) {
+          objects_bldr.Set(i - begin, items[i].object);
+          values_bldr.Insert(i - begin, items[i].value);
+        }
+        return db_.SetAttr(
+            DataSliceImpl::CreateObjectsDataSlice(
+                std::move(objects_bldr).Build(),
+                GroupAllocationIds(items[begin].object)),
+            attr, std::move(values_bldr).Build());
+      });
+}
+
+absl::Status TripleLoader::FlushDicts() {
+  // Updates of the same dict are applied in the order they were added in.
+  std::stable_sort(dict_items_.begin(), dict_items_.end(),
+                   [](const DictItem& a, const DictItem& b) {
+                     return GroupLess(a.dict, b.dict);
+                   });
+  RETURN_IF_ERROR(ForEachGroup<DictItem>(
+      dict_items_, [](const DictItem& item) { return item.dict; },
+      [&](int64_t begin, int64_t end) -> absl::Status {
+        arolla::DenseArrayBuilder<ObjectId> dicts_bldr(end - begin);
+        DataSliceImpl::Builder keys_bldr(end - begin);
+        DataSliceImpl::Builder values_bldr(end - begin);
+        for (int64_t i = begin; i < end; ++i) {
+          dicts_bldr.Set(i - begin, dict_items_[i].dict);
+          keys_bldr.Insert(i - begin, dict_items_[i].key);
+          values_bldr.Insert(i - begin, dict_items_[i].value);
+        }
+        return db_.SetInDict(
+            DataSliceImpl::CreateObjectsDataSlice(
+                std::move(dicts_bldr).Build(),
+                GroupAllocationIds(dict_items_[begin].dict)),
+            std::move(keys_bldr).Build(), std::move(values_bldr).Build(),
+            options_.parallel_options);
+      }));
+  dict_items_.clear();
+  return absl::OkStatus();
+}
+
+}  // namespace koladata::internal
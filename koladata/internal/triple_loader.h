@@ -0,0 +1,101 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_TRIPLE_LOADER_H_
+#define KOLADATA_INTERNAL_TRIPLE_LOADER_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/strings/string_view.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/internal/triples.h"
+
+namespace koladata::internal {
+
+// Bulk loader of (object, attr, value) and (dict, key, value) triples, e.g.
+// from key-value dumps of external systems.
+//
+// Triples are buffered and written into the DataBagImpl in batches: for every
+// attribute the objects are grouped by allocation, so that each SetAttr call
+// touches a single DenseSource. Dict items are grouped by dict allocation in
+// the same way. For duplicated (object, attr) or (dict, key) pairs the last
+// added value wins, as if the triples were set one by one.
+//
+// The buffered triples are only visible in `db` after Flush().
+class TripleLoader {
+ public:
+  struct Options {
+    // Number of buffered triples that triggers a Flush().
+    int64_t batch_size = 1 << 20;
+    // Options for the dict writes.
+    DataBagImpl::ParallelOptions parallel_options;
+  };
+
+  // `db` must outlive the loader.
+  explicit TripleLoader(DataBagImpl& db) : TripleLoader(db, Options()) {}
+  TripleLoader(DataBagImpl& db, Options options)
+      : db_(db), options_(std::move(options)) {}
+
+  absl::Status AddAttr(ObjectId object, absl::string_view attr,
+                       DataItem value);
+  absl::Status AddDictItem(ObjectId dict, DataItem key, DataItem value);
+
+  absl::Status Add(const debug::AttrTriple& triple) {
+    return AddAttr(triple.object, triple.attribute, triple.value);
+  }
+  absl::Status Add(const debug::DictItemTriple& triple) {
+    return AddDictItem(triple.object, triple.key, triple.value);
+  }
+
+  // Writes all the buffered triples into `db`.
+  absl::Status Flush();
+
+  int64_t buffered_count() const { return buffered_count_; }
+
+ private:
+  struct AttrItem {
+    ObjectId object;
+    DataItem value;
+  };
+  struct DictItem {
+    ObjectId dict;
+    DataItem key;
+    DataItem value;
+  };
+
+  absl::Status MaybeFlush() {
+    return ++buffered_count_ >= options_.batch_size ? Flush()
+                                                    : absl::OkStatus();
+  }
+
+  absl::Status FlushAttr(absl::string_view attr, std::vector<AttrItem>& items);
+  absl::Status FlushDicts();
+
+  DataBagImpl& db_;
+  const Options options_;
+  int64_t buffered_count_ = 0;
+  absl::flat_hash_map<std::string, std::vector<AttrItem>> attrs_;
+  std::vector<DictItem> dict_items_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_TRIPLE_LOADER_H_
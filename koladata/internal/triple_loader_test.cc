@@ -0,0 +1,91 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/triple_loader.h"
+
+#include <cstdint>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/internal/testing/matchers.h"
+#include "koladata/internal/triples.h"
+#include "arolla/util/text.h"
+
+namespace koladata::internal {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::koladata::internal::testing::DataBagEqual;
+
+TEST(TripleLoaderTest, MatchesItemwiseWrites) {
+  AllocationId alloc1 = Allocate(100);
+  AllocationId alloc2 = Allocate(100);
+  ObjectId small = AllocateSingleObject();
+  AllocationId dicts = AllocateDicts(10);
+
+  auto expected = DataBagImpl::CreateEmptyDatabag();
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  TripleLoader loader(*db, {.batch_size = 7});
+  auto set_attr = [&](ObjectId obj, absl::string_view attr, DataItem value) {
+    ASSERT_OK(expected->SetAttr(DataItem(obj), attr, value));
+    ASSERT_OK(loader.AddAttr(obj, attr, value));
+  };
+  auto set_in_dict = [&](ObjectId dict, DataItem key, DataItem value) {
+    ASSERT_OK(expected->SetInDict(DataItem(dict), key, value));
+    ASSERT_OK(loader.AddDictItem(dict, key, value));
+  };
+  for (int64_t i = 0; i < 20; ++i) {
+    set_attr(alloc1.ObjectByOffset(i), "a", DataItem(static_cast<int>(i)));
+    set_attr(alloc2.ObjectByOffset(19 - i), "a",
+             DataItem(arolla::Text("x")));
+    set_attr(alloc1.ObjectByOffset(i % 3), "b", DataItem(static_cast<int>(i)));
+    set_in_dict(dicts.ObjectByOffset(i % 4), DataItem(static_cast<int>(i % 5)),
+                DataItem(static_cast<float>(i)));
+  }
+  set_attr(small, "a", DataItem(1));
+  set_attr(small, "a", DataItem(2));
+  // Removal of a previously added value.
+  set_attr(alloc1.ObjectByOffset(0), "a", DataItem());
+  ASSERT_OK(loader.Flush());
+  EXPECT_EQ(loader.buffered_count(), 0);
+
+  EXPECT_THAT(db, DataBagEqual(expected));
+  EXPECT_THAT(db->GetAttr(DataItem(small), "a"), IsOkAndHolds(DataItem(2)));
+  EXPECT_THAT(db->GetAttr(DataItem(alloc1.ObjectByOffset(1)), "b"),
+              IsOkAndHolds(DataItem(19)));
+}
+
+TEST(TripleLoaderTest, AddTriples) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ObjectId obj = Allocate(10).ObjectByOffset(2);
+  ObjectId dict = AllocateSingleDict();
+  TripleLoader loader(*db);
+  ASSERT_OK(loader.Add(debug::AttrTriple{obj, "a", DataItem(5)}));
+  ASSERT_OK(loader.Add(
+      debug::DictItemTriple{dict, DataItem(arolla::Text("k")), DataItem(7)}));
+  EXPECT_EQ(loader.buffered_count(), 2);
+  EXPECT_THAT(db->GetAttr(DataItem(obj), "a"), IsOkAndHolds(DataItem()));
+  ASSERT_OK(loader.Flush());
+  EXPECT_THAT(db->GetAttr(DataItem(obj), "a"), IsOkAndHolds(DataItem(5)));
+  EXPECT_THAT(
+      db->GetFromDict(DataItem(dict), DataItem(arolla::Text("k"))),
+      IsOkAndHolds(DataItem(7)));
+}
+
+}  // namespace
+}  // namespace koladata::internal
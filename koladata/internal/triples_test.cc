@@ -93,6 +93,37 @@ TEST(TriplesTest, SimpleDict) {
   EXPECT_THAT(db, Not(DataBagEqual(DataBagImpl::CreateEmptyDatabag())));
 }
 
+TEST(TriplesTest, Projection) {
+  ObjectId obj = CreateUuidObject(arolla::Fingerprint(1));
+  DataItem dict = DataItem(AllocateSingleDict());
+  DataItem list = DataItem(AllocateSingleList());
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  ASSERT_OK(db->SetAttr(DataItem(obj), "a", DataItem(1)));
+  ASSERT_OK(db->SetAttr(DataItem(obj), "b", DataItem(2)));
+  ASSERT_OK(db->SetInDict(dict, DataItem(3), DataItem(4)));
+  ASSERT_OK(db->AppendToList(list, DataItem(5)));
+
+  EXPECT_EQ(Triples(*db->ExtractContent(DataBagProjection{.attrs = {"b"}}))
+                .DebugString(),
+            R"DB(DataBag {
+  ObjectId=04000000000000010000000000000000:0 attr=b value=2
+})DB");
+  EXPECT_THAT(
+      Triples(*db->ExtractContent(
+                  DataBagProjection{.attrs = {"a", "c"}, .dicts = true}))
+          .DebugString(),
+      ::testing::MatchesRegex(R"DB(DataBag \{
+  ObjectId=04000000000000010000000000000000:0 attr=a value=1
+  DictId=[0-9a-f]+:0 key=3 value=4
+\})DB"));
+  EXPECT_THAT(
+      Triples(*db->ExtractContent(DataBagProjection{.lists = true}))
+          .DebugString(),
+      ::testing::MatchesRegex(R"DB(DataBag \{
+  ListId=[0-9a-f]+:0 \[5\]
+\})DB"));
+}
+
 TEST(TriplesTest, SimpleList) {
   DataItem list1 = DataItem(AllocateSingleList());
   DataItem list2 = DataItem(AllocateSingleList());
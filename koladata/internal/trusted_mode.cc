@@ -0,0 +1,32 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/trusted_mode.h"
+
+namespace koladata::internal {
+namespace {
+
+thread_local bool trusted_mode = false;
+
+}  // namespace
+
+bool SetTrustedMode(bool enabled) {
+  bool previous = trusted_mode;
+  trusted_mode = enabled;
+  return previous;
+}
+
+bool IsTrustedMode() { return trusted_mode; }
+
+}  // namespace koladata::internal
@@ -0,0 +1,52 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_INTERNAL_TRUSTED_MODE_H_
+#define KOLADATA_INTERNAL_TRUSTED_MODE_H_
+
+namespace koladata::internal {
+
+// In trusted mode, DataSlice::SetAttr and the functions built on it assume
+// that the assigned values already have the schemas stored for the attributes
+// of explicit schemas. The stored schemas are neither looked up nor validated
+// and no casting takes place; the attributes of implicit schemas are
+// overwritten without a lookup. Debug builds still verify the schemas.
+//
+// Meant for bulk writes of data validated upstream. Assigning values with
+// other schemas in trusted mode leaves the DataBag inconsistent.
+
+// Enables or disables trusted mode on the current thread. Returns the previous
+// state.
+bool SetTrustedMode(bool enabled);
+
+// Returns true if the current thread is in trusted mode.
+bool IsTrustedMode();
+
+// Enables (or disables) trusted mode on the current thread for the lifetime of
+// the object. The previous state is restored on destruction.
+class ScopedTrustedMode {
+ public:
+  explicit ScopedTrustedMode(bool enabled = true)
+      : previous_(SetTrustedMode(enabled)) {}
+  ScopedTrustedMode(const ScopedTrustedMode&) = delete;
+  ScopedTrustedMode& operator=(const ScopedTrustedMode&) = delete;
+  ~ScopedTrustedMode() { SetTrustedMode(previous_); }
+
+ private:
+  bool previous_;
+};
+
+}  // namespace koladata::internal
+
+#endif  // KOLADATA_INTERNAL_TRUSTED_MODE_H_
@@ -0,0 +1,54 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/internal/trusted_mode.h"
+
+#include <thread>  // NOLINT(build/c++11)
+
+#include "gtest/gtest.h"
+
+namespace koladata::internal {
+namespace {
+
+TEST(TrustedModeTest, Scoped) {
+  EXPECT_FALSE(IsTrustedMode());
+  {
+    ScopedTrustedMode trusted;
+    EXPECT_TRUE(IsTrustedMode());
+    {
+      ScopedTrustedMode untrusted(false);
+      EXPECT_FALSE(IsTrustedMode());
+    }
+    EXPECT_TRUE(IsTrustedMode());
+  }
+  EXPECT_FALSE(IsTrustedMode());
+}
+
+TEST(TrustedModeTest, Set) {
+  EXPECT_FALSE(SetTrustedMode(true));
+  EXPECT_TRUE(IsTrustedMode());
+  EXPECT_TRUE(SetTrustedMode(false));
+  EXPECT_FALSE(IsTrustedMode());
+}
+
+TEST(TrustedModeTest, PerThread) {
+  ScopedTrustedMode trusted;
+  bool other_thread_trusted = true;
+  std::thread([&] { other_thread_trusted = IsTrustedMode(); }).join();
+  EXPECT_FALSE(other_thread_trusted);
+  EXPECT_TRUE(IsTrustedMode());
+}
+
+}  // namespace
+}  // namespace koladata::internal
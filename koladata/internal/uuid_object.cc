@@ -17,6 +17,7 @@
 #include <algorithm>
 #include <cstdint>
 #include <functional>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -31,11 +32,15 @@
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/stable_fingerprint.h"
+#include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/ops/dense_ops.h"
 #include "arolla/memory/buffer.h"
 #include "arolla/qtype/base_types.h"
 #include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/bytes.h"
 #include "arolla/util/fingerprint.h"
+#include "arolla/util/text.h"
+#include "arolla/util/view_types.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata::internal {
@@ -68,6 +73,21 @@ absl::StatusOr<int64_t> CommonKwargsSize(
   return size;
 }
 
+// Returns the same fingerprint as DataItem(T(item)).StableFingerprint(),
+// without constructing the DataItem.
+template <class T>
+arolla::Fingerprint DataItemFingerprint(arolla::view_type_t<T> item) {
+  StableFingerprintHasher hasher("data_item");
+  if constexpr (std::is_same_v<T, arolla::Text>) {
+    hasher.Combine(absl::string_view("arolla::Text"), item);
+  } else if constexpr (std::is_same_v<T, arolla::Bytes>) {
+    hasher.Combine(absl::string_view("arolla::Bytes"), item);
+  } else {
+    hasher.Combine(item);
+  }
+  return std::move(hasher).Finish();
+}
+
 arolla::Fingerprint UuidWithMainObjectFingerprint(AllocationId alloc_id,
                                                   absl::string_view salt) {
   return StableFingerprintHasher("uuid_with_main_object")
@@ -137,23 +157,31 @@ absl::StatusOr<DataSliceImpl> CreateUuidFromFields(
   std::sort(sorted_kwargs.begin(), sorted_kwargs.end(),
             [](const auto& x, const auto& y) { return x.first < y.first; });
 
-  std::vector<std::pair<absl::string_view, arolla::Fingerprint>> fingerprints;
-  fingerprints.reserve(sorted_kwargs.size());
+  // The fingerprints are computed column by column, so that the type of each
+  // column is dispatched only once. `hashers` carry the per-row states.
+  std::vector<StableFingerprintHasher> hashers(
+      size, StableFingerprintHasher(absl::StrCat("uuid", seed)));
+  const arolla::Fingerprint missing_fingerprint =
+      DataItem().StableFingerprint();
+  std::vector<arolla::Fingerprint> column_fingerprints(size);
   for (const auto& [attr, value] : sorted_kwargs) {
-    fingerprints.emplace_back(attr, arolla::Fingerprint{.value = 0});
+    std::fill(column_fingerprints.begin(), column_fingerprints.end(),
+              missing_fingerprint);
+    value.get().VisitValues([&]<class T>(const arolla::DenseArray<T>& array) {
+      array.ForEachPresent([&](int64_t id, arolla::view_type_t<T> item) {
+        column_fingerprints[id] = DataItemFingerprint<T>(item);
+      });
+    });
+    StableFingerprintHasher::CombineToAll(absl::MakeSpan(hashers), attr);
+    StableFingerprintHasher::CombineBatch(
+        absl::MakeSpan(hashers), absl::MakeConstSpan(column_fingerprints));
   }
 
   arolla::Buffer<ObjectId>::Builder values_builder(size);
-
   for (int64_t offset = 0; offset < size; ++offset) {
-    for (int64_t i = 0; i != fingerprints.size(); ++i) {
-      fingerprints[i].second =
-          sorted_kwargs[i].second.get()[offset].StableFingerprint();
-    }
-    values_builder.Set(offset,
-                       CreateUuidObject(ComputeFingerPrintFromKwargs(
-                                            seed, absl::MakeSpan(fingerprints)),
-                                        uuid_type));
+    values_builder.Set(
+        offset,
+        CreateUuidObject(std::move(hashers[offset]).Finish(), uuid_type));
   }
 
   return DataSliceImpl::CreateObjectsDataSlice(
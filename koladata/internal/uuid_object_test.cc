@@ -37,6 +37,7 @@
 #include "arolla/util/bytes.h"
 #include "arolla/util/fingerprint.h"
 #include "arolla/util/text.h"
+#include "arolla/util/unit.h"
 
 namespace koladata::internal {
 namespace {
@@ -265,6 +266,38 @@ TEST(UuidTest, CreateUuidFromFieldsDataItemAllTypesOrderIndependent) {
   }
 }
 
+TEST(UuidTest, CreateUuidFromFieldsDataSliceImplAllTypes) {
+  std::vector<DataItem> items = {DataItem(1.5f),
+                                 DataItem(1.5),
+                                 DataItem(57),
+                                 DataItem(int64_t{75}),
+                                 DataItem(Text("57")),
+                                 DataItem(arolla::Bytes("75")),
+                                 DataItem(AllocateSingleObject()),
+                                 DataItem(true),
+                                 DataItem(arolla::kUnit),
+                                 DataItem(schema::kInt32),
+                                 DataItem()};
+  DataSliceImpl::Builder x_bldr(items.size());
+  DataSliceImpl::Builder y_bldr(items.size());
+  for (int64_t i = 0; i < items.size(); ++i) {
+    x_bldr.Insert(i, items[i]);
+    y_bldr.Insert(i, items[items.size() - 1 - i]);
+  }
+  DataSliceImpl x_slice = std::move(x_bldr).Build();
+  DataSliceImpl y_slice = std::move(y_bldr).Build();
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl uuid_slice,
+                       CreateUuidFromFields("seed", {"y", "x"},
+                                            {y_slice, x_slice}));
+  ASSERT_EQ(uuid_slice.size(), items.size());
+  for (int64_t i = 0; i < items.size(); ++i) {
+    DataItem x = x_slice[i];
+    DataItem y = y_slice[i];
+    EXPECT_EQ(uuid_slice[i], CreateUuidFromFields("seed", {"x", "y"}, {x, y}))
+        << i;
+  }
+}
+
 TEST(UuidTest, CreateSchemaUuidFromFields) {
   DataItem x(schema::kInt32);
   DataItem y(schema::kFloat32);
@@ -0,0 +1,877 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/json/from_json.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <optional>
+#include <string>
+#include <system_error>  // NOLINT(build/c++11)
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/match.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/adoption_utils.h"
+#include "koladata/casting.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/internal/schema_utils.h"
+#include "koladata/object_factories.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata {
+namespace {
+
+using ::koladata::internal::DataItem;
+using ::koladata::internal::DataSliceImpl;
+using ::koladata::internal::ObjectId;
+
+// The parser is recursive, so the nesting is limited.
+constexpr int32_t kMaxDepth = 512;
+
+enum class JsonKind : uint8_t {
+  kNull,
+  kBool,
+  kInt,
+  kFloat,
+  kString,
+  kArray,
+  kObject,
+};
+
+struct JsonNode {
+  JsonKind kind = JsonKind::kNull;
+  int32_t depth = 0;
+  bool bool_value = false;
+  int64_t int_value = 0;
+  double float_value = 0;
+  absl::string_view string_value;
+  // Elements of an array or members of an object: [members_begin,
+  // members_end) in JsonForest::members.
+  int64_t members_begin = 0;
+  int64_t members_end = 0;
+};
+
+// An element of an array (with an empty key) or a member of an object.
+struct JsonMember {
+  absl::string_view key;
+  int64_t node;
+};
+
+// Parsed documents as a flat list of nodes in pre-order. Strings reference the
+// documents, unless they had escape sequences.
+struct JsonForest {
+  std::vector<JsonNode> nodes;
+  std::vector<JsonMember> members;
+  std::vector<int64_t> roots;
+  // Elements are never moved, so they can be referenced.
+  std::deque<std::string> unescaped_strings;
+};
+
+void AppendUtf8(uint32_t code_point, std::string& out) {
+  if (code_point < 0x80) {
+    out.push_back(static_cast<char>(code_point));
+  } else if (code_point < 0x800) {
+    out.push_back(static_cast<char>(0xC0 | (code_point >> 6)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else if (code_point < 0x10000) {
+    out.push_back(static_cast<char>(0xE0 | (code_point >> 12)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  } else {
+    out.push_back(static_cast<char>(0xF0 | (code_point >> 18)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 12) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | ((code_point >> 6) & 0x3F)));
+    out.push_back(static_cast<char>(0x80 | (code_point & 0x3F)));
+  }
+}
+
+bool IsDigit(char c) { return c >= '0' && c <= '9'; }
+
+// Single pass recursive descent parser (RFC 8259) that appends the parsed
+// documents to a JsonForest.
+class JsonParser {
+ public:
+  explicit JsonParser(JsonForest& forest) : forest_(forest) {}
+
+  absl::Status Parse(absl::string_view json) {
+    json_ = json;
+    pos_ = 0;
+    ASSIGN_OR_RETURN(int64_t root, ParseValue(/*depth=*/0));
+    SkipWhitespace();
+    if (pos_ != json_.size()) {
+      return Error("unexpected characters after the value");
+    }
+    forest_.roots.push_back(root);
+    return absl::OkStatus();
+  }
+
+ private:
+  absl::Status Error(absl::string_view message) const {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("invalid JSON at offset %d: %s", pos_, message));
+  }
+
+  bool AtEnd() const { return pos_ == json_.size(); }
+
+  void SkipWhitespace() {
+    while (!AtEnd()) {
+      const char c = json_[pos_];
+      if (c != ' ' && c != '\n' && c != '\r' && c != '\t') {
+        break;
+      }
+      ++pos_;
+    }
+  }
+
+  void SkipDigits() {
+    while (!AtEnd() && IsDigit(json_[pos_])) {
+      ++pos_;
+    }
+  }
+
+  bool Consume(absl::string_view literal) {
+    if (!absl::StartsWith(json_.substr(pos_), literal)) {
+      return false;
+    }
+    pos_ += literal.size();
+    return true;
+  }
+
+  absl::StatusOr<int64_t> ParseValue(int32_t depth) {
+    SkipWhitespace();
+    if (AtEnd()) {
+      return Error("unexpected end of input");
+    }
+    // The node is filled after its children, which are appended after it.
+    const int64_t id = forest_.nodes.size();
+    forest_.nodes.emplace_back();
+    JsonNode node{.depth = depth};
+    switch (json_[pos_]) {
+      case '{':
+        RETURN_IF_ERROR(ParseContainer(/*is_object=*/true, node));
+        break;
+      case '[':
+        RETURN_IF_ERROR(ParseContainer(/*is_object=*/false, node));
+        break;
+      case '"':
+        node.kind = JsonKind::kString;
+        ASSIGN_OR_RETURN(node.string_value, ParseString());
+        break;
+      case 't':
+      case 'f':
+        node.kind = JsonKind::kBool;
+        node.bool_value = Consume("true");
+        if (!node.bool_value && !Consume("false")) {
+          return Error("invalid literal");
+        }
+        break;
+      case 'n':
+        if (!Consume("null")) {
+          return Error("invalid literal");
+        }
+        break;
+      default:
+        RETURN_IF_ERROR(ParseNumber(node));
+    }
+    forest_.nodes[id] = node;
+    return id;
+  }
+
+  absl::Status ParseContainer(bool is_object, JsonNode& node) {
+    if (node.depth >= kMaxDepth) {
+      return Error(absl::StrCat("nesting is deeper than ", kMaxDepth));
+    }
+    node.kind = is_object ? JsonKind::kObject : JsonKind::kArray;
+    const char close = is_object ? '}' : ']';
+    ++pos_;
+    // The members of the nested containers are collected in between, so the
+    // members of this one are moved to the forest once they are all parsed.
+    const size_t scratch_begin = scratch_.size();
+    SkipWhitespace();
+    if (!AtEnd() && json_[pos_] == close) {
+      ++pos_;
+    } else {
+      while (true) {
+        JsonMember member;
+        if (is_object) {
+          SkipWhitespace();
+          if (AtEnd() || json_[pos_] != '"') {
+            return Error("expected a string key");
+          }
+          ASSIGN_OR_RETURN(member.key, ParseString());
+          SkipWhitespace();
+          if (AtEnd() || json_[pos_] != ':') {
+            return Error("expected ':'");
+          }
+          ++pos_;
+        }
+        ASSIGN_OR_RETURN(member.node, ParseValue(node.depth + 1));
+        scratch_.push_back(member);
+        SkipWhitespace();
+        if (AtEnd()) {
+          return Error("unexpected end of input");
+        }
+        if (json_[pos_] == ',') {
+          ++pos_;
+          continue;
+        }
+        if (json_[pos_] == close) {
+          ++pos_;
+          break;
+        }
+        return Error(is_object ? "expected ',' or '}'" : "expected ',' or ']'");
+      }
+    }
+    node.members_begin = forest_.members.size();
+    forest_.members.insert(forest_.members.end(),
+                           scratch_.begin() + scratch_begin, scratch_.end());
+    node.members_end = forest_.members.size();
+    scratch_.resize(scratch_begin);
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<uint32_t> ParseHex4() {
+    if (json_.size() - pos_ < 4) {
+      return Error("invalid \\u escape sequence");
+    }
+    uint32_t result = 0;
+    for (int i = 0; i < 4; ++i) {
+      const char c = json_[pos_++];
+      result <<= 4;
+      if (IsDigit(c)) {
+        result |= c - '0';
+      } else if (c >= 'a' && c <= 'f') {
+        result |= c - 'a' + 10;
+      } else if (c >= 'A' && c <= 'F') {
+        result |= c - 'A' + 10;
+      } else {
+        return Error("invalid \\u escape sequence");
+      }
+    }
+    return result;
+  }
+
+  absl::StatusOr<absl::string_view> ParseString() {
+    ++pos_;
+    const size_t begin = pos_;
+    // Most strings have no escape sequences, so they are referenced without
+    // copying.
+    while (!AtEnd()) {
+      const char c = json_[pos_];
+      if (c == '"') {
+        return json_.substr(begin, pos_++ - begin);
+      }
+      if (c == '\\') {
+        break;
+      }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return Error("unescaped control character in a string");
+      }
+      ++pos_;
+    }
+    std::string& unescaped = forest_.unescaped_strings.emplace_back(
+        json_.substr(begin, pos_ - begin));
+    while (!AtEnd()) {
+      const char c = json_[pos_];
+      if (c == '"') {
+        ++pos_;
+        return unescaped;
+      }
+      if (static_cast<unsigned char>(c) < 0x20) {
+        return Error("unescaped control character in a string");
+      }
+      ++pos_;
+      if (c != '\\') {
+        unescaped.push_back(c);
+        continue;
+      }
+      if (AtEnd()) {
+        break;
+      }
+      switch (json_[pos_++]) {
+        case '"':
+          unescaped.push_back('"');
+          break;
+        case '\\':
+          unescaped.push_back('\\');
+          break;
+        case '/':
+          unescaped.push_back('/');
+          break;
+        case 'b':
+          unescaped.push_back('\b');
+          break;
+        case 'f':
+          unescaped.push_back('\f');
+          break;
+        case 'n':
+          unescaped.push_back('\n');
+          break;
+        case 'r':
+          unescaped.push_back('\r');
+          break;
+        case 't':
+          unescaped.push_back('\t');
+          break;
+        case 'u': {
+          ASSIGN_OR_RETURN(uint32_t code_point, ParseHex4());
+          if (code_point >= 0xD800 && code_point < 0xDC00) {
+            if (!Consume("\\u")) {
+              return Error("unpaired surrogate in a \\u escape sequence");
+            }
+            ASSIGN_OR_RETURN(uint32_t low, ParseHex4());
+            if (low < 0xDC00 || low >= 0xE000) {
+              return Error("unpaired surrogate in a \\u escape sequence");
+            }
+            code_point = 0x10000 + ((code_point - 0xD800) << 10) +
+                         (low - 0xDC00);
+          } else if (code_point >= 0xDC00 && code_point < 0xE000) {
+            return Error("unpaired surrogate in a \\u escape sequence");
+          }
+          AppendUtf8(code_point, unescaped);
+          break;
+        }
+        default:
+          return Error("invalid escape sequence");
+      }
+    }
+    return Error("unterminated string");
+  }
+
+  absl::Status ParseNumber(JsonNode& node) {
+    const size_t begin = pos_;
+    bool is_integer = true;
+    if (json_[pos_] == '-') {
+      ++pos_;
+    }
+    if (!AtEnd() && json_[pos_] == '0') {
+      ++pos_;
+    } else if (!AtEnd() && IsDigit(json_[pos_])) {
+      SkipDigits();
+    } else {
+      return Error("invalid value");
+    }
+    if (!AtEnd() && json_[pos_] == '.') {
+      is_integer = false;
+      ++pos_;
+      if (AtEnd() || !IsDigit(json_[pos_])) {
+        return Error("invalid number");
+      }
+      SkipDigits();
+    }
+    if (!AtEnd() && (json_[pos_] == 'e' || json_[pos_] == 'E')) {
+      is_integer = false;
+      ++pos_;
+      if (!AtEnd() && (json_[pos_] == '+' || json_[pos_] == '-')) {
+        ++pos_;
+      }
+      if (AtEnd() || !IsDigit(json_[pos_])) {
+        return Error("invalid number");
+      }
+      SkipDigits();
+    }
+    const absl::string_view text = json_.substr(begin, pos_ - begin);
+    if (is_integer) {
+      auto [ptr, ec] = std::from_chars(text.data(), text.data() + text.size(),
+                                       node.int_value);
+      if (ec == std::errc()) {
+        node.kind = JsonKind::kInt;
+        return absl::OkStatus();
+      }
+      // Doesn't fit into INT64, so it is converted like a float.
+    }
+    node.kind = JsonKind::kFloat;
+    if (!absl::SimpleAtod(text, &node.float_value)) {
+      return Error("invalid number");
+    }
+    return absl::OkStatus();
+  }
+
+  JsonForest& forest_;
+  absl::string_view json_;
+  size_t pos_ = 0;
+  std::vector<JsonMember> scratch_;
+};
+
+// Schema of a container, with the sub-schemas already looked up.
+struct SchemaInfo {
+  enum Kind { kList, kDict, kEntity };
+  Kind kind;
+  DataSlice schema;
+  // For lists and dicts.
+  DataItem items_schema;
+  DataItem keys_schema;
+  // For entities.
+  std::vector<absl::string_view> attr_names;
+  absl::flat_hash_map<std::string, DataItem> attr_schemas;
+};
+
+// Key of a batch of containers that are created together.
+struct BatchKey {
+  JsonKind kind;
+  std::optional<ObjectId> schema;
+
+  friend bool operator==(const BatchKey&, const BatchKey&) = default;
+  template <typename H>
+  friend H AbslHashValue(H h, const BatchKey& key) {
+    return H::combine(std::move(h), key.kind, key.schema);
+  }
+};
+
+// Converts a JsonForest bottom-up, one nesting level at a time.
+class JsonConverter {
+ public:
+  JsonConverter(const DataBagPtr& db, const JsonForest& forest,
+                bool dict_as_obj)
+      : db_(db),
+        forest_(forest),
+        dict_as_obj_(dict_as_obj),
+        schemas_(forest.nodes.size()),
+        skipped_(forest.nodes.size(), false),
+        items_(forest.nodes.size()),
+        item_schemas_(forest.nodes.size()) {}
+
+  absl::StatusOr<DataSlice> Convert(const std::optional<DataSlice>& schema) {
+    DataItem root_schema;
+    if (schema.has_value()) {
+      RETURN_IF_ERROR(schema->VerifyIsSchema());
+      root_schema = schema->item();
+      AdoptionQueue adoption_queue;
+      adoption_queue.Add(*schema);
+      RETURN_IF_ERROR(adoption_queue.AdoptInto(*db_));
+    }
+    for (int64_t root : forest_.roots) {
+      schemas_[root] = IgnoreObjectSchema(root_schema);
+    }
+    RETURN_IF_ERROR(AssignSchemas());
+    ConvertPrimitives();
+    RETURN_IF_ERROR(ConvertContainers());
+
+    auto shape = DataSlice::JaggedShape::FlatFromSize(forest_.roots.size());
+    if (!root_schema.has_value() || root_schema == schema::kObject) {
+      return MakeSlice(forest_.roots, std::move(shape));
+    }
+    if (root_schema.holds_value<schema::DType>()) {
+      ASSIGN_OR_RETURN(auto res, MakeSlice(forest_.roots, std::move(shape)));
+      return CastToImplicit(res, root_schema);
+    }
+    // The present containers are already converted to `root_schema`.
+    DataSliceImpl::Builder bldr(forest_.roots.size());
+    for (int64_t i = 0; i < forest_.roots.size(); ++i) {
+      const JsonNode& root = forest_.nodes[forest_.roots[i]];
+      if (root.kind != JsonKind::kNull && root.kind != JsonKind::kArray &&
+          root.kind != JsonKind::kObject) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "document %d: cannot convert a JSON primitive to %v", i,
+            root_schema));
+      }
+      bldr.Insert(i, items_[forest_.roots[i]]);
+    }
+    return DataSlice::Create(std::move(bldr).Build(), std::move(shape),
+                             root_schema, db_);
+  }
+
+ private:
+  // Values under OBJECT and ANY schemas are converted as without a schema.
+  static DataItem IgnoreObjectSchema(const DataItem& schema) {
+    return schema == schema::kObject || schema == schema::kAny ? DataItem()
+                                                               : schema;
+  }
+
+  absl::StatusOr<const SchemaInfo*> GetSchemaInfo(const DataItem& schema) {
+    auto [it, inserted] = schema_infos_.try_emplace(schema.value<ObjectId>());
+    SchemaInfo& info = it->second;
+    if (!inserted) {
+      return &info;
+    }
+    ASSIGN_OR_RETURN(info.schema,
+                     DataSlice::Create(schema, DataItem(schema::kSchema),
+                                       db_));
+    if (info.schema.IsListSchema()) {
+      info.kind = SchemaInfo::kList;
+      ASSIGN_OR_RETURN(auto items_schema,
+                       info.schema.GetAttr(schema::kListItemsSchemaAttr));
+      info.items_schema = IgnoreObjectSchema(items_schema.item());
+    } else if (info.schema.IsDictSchema()) {
+      info.kind = SchemaInfo::kDict;
+      ASSIGN_OR_RETURN(auto keys_schema,
+                       info.schema.GetAttr(schema::kDictKeysSchemaAttr));
+      ASSIGN_OR_RETURN(auto values_schema,
+                       info.schema.GetAttr(schema::kDictValuesSchemaAttr));
+      info.keys_schema = keys_schema.item();
+      info.items_schema = IgnoreObjectSchema(values_schema.item());
+    } else {
+      info.kind = SchemaInfo::kEntity;
+      ASSIGN_OR_RETURN(auto attr_names, info.schema.GetAttrNames());
+      for (const auto& attr_name : attr_names) {
+        ASSIGN_OR_RETURN(auto attr_schema, info.schema.GetAttr(attr_name));
+        auto attr_it = info.attr_schemas
+                           .emplace(attr_name,
+                                    IgnoreObjectSchema(attr_schema.item()))
+                           .first;
+        info.attr_names.push_back(attr_it->first);
+      }
+    }
+    return &info;
+  }
+
+  // Assigns the schemas of the nodes from the schemas of their parents.
+  absl::Status AssignSchemas() {
+    for (int64_t i = 0; i < forest_.nodes.size(); ++i) {
+      const JsonNode& node = forest_.nodes[i];
+      if (node.kind != JsonKind::kArray && node.kind != JsonKind::kObject) {
+        continue;
+      }
+      auto members = absl::MakeConstSpan(forest_.members)
+                         .subspan(node.members_begin,
+                                  node.members_end - node.members_begin);
+      if (skipped_[i]) {
+        for (const JsonMember& member : members) {
+          skipped_[member.node] = true;
+        }
+        continue;
+      }
+      const DataItem& schema = schemas_[i];
+      if (!schema.has_value()) {
+        continue;
+      }
+      if (!schema.holds_value<ObjectId>()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "cannot convert a JSON %s to %v",
+            node.kind == JsonKind::kArray ? "array" : "object", schema));
+      }
+      ASSIGN_OR_RETURN(const SchemaInfo* info, GetSchemaInfo(schema));
+      const bool is_valid = node.kind == JsonKind::kArray
+                                ? info->kind == SchemaInfo::kList
+                                : info->kind != SchemaInfo::kList;
+      if (!is_valid) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "cannot convert a JSON %s to a %s schema",
+            node.kind == JsonKind::kArray ? "array" : "object",
+            info->kind == SchemaInfo::kList ? "list" : "non-list"));
+      }
+      for (const JsonMember& member : members) {
+        if (info->kind != SchemaInfo::kEntity) {
+          schemas_[member.node] = info->items_schema;
+        } else if (auto it = info->attr_schemas.find(member.key);
+                   it != info->attr_schemas.end()) {
+          schemas_[member.node] = it->second;
+        } else {
+          skipped_[member.node] = true;
+        }
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  void ConvertPrimitives() {
+    for (int64_t i = 0; i < forest_.nodes.size(); ++i) {
+      const JsonNode& node = forest_.nodes[i];
+      switch (node.kind) {
+        case JsonKind::kBool:
+          items_[i] = DataItem(node.bool_value);
+          item_schemas_[i] = DataItem(schema::kBool);
+          break;
+        case JsonKind::kInt:
+          if (node.int_value >= std::numeric_limits<int32_t>::min() &&
+              node.int_value <= std::numeric_limits<int32_t>::max()) {
+            items_[i] = DataItem(static_cast<int32_t>(node.int_value));
+            item_schemas_[i] = DataItem(schema::kInt32);
+          } else {
+            items_[i] = DataItem(node.int_value);
+            item_schemas_[i] = DataItem(schema::kInt64);
+          }
+          break;
+        case JsonKind::kFloat:
+          items_[i] = DataItem(static_cast<float>(node.float_value));
+          item_schemas_[i] = DataItem(schema::kFloat32);
+          break;
+        case JsonKind::kString:
+          items_[i] = DataItem(arolla::Text(node.string_value));
+          item_schemas_[i] = DataItem(schema::kText);
+          break;
+        case JsonKind::kNull:
+        case JsonKind::kArray:
+        case JsonKind::kObject:
+          break;
+      }
+    }
+  }
+
+  // Creates the containers from the deepest nesting level to the roots, so
+  // that the values of each container are created before it.
+  absl::Status ConvertContainers() {
+    std::vector<absl::flat_hash_map<BatchKey, std::vector<int64_t>>> levels;
+    for (int64_t i = 0; i < forest_.nodes.size(); ++i) {
+      const JsonNode& node = forest_.nodes[i];
+      if (skipped_[i] || (node.kind != JsonKind::kArray &&
+                          node.kind != JsonKind::kObject)) {
+        continue;
+      }
+      if (node.depth >= levels.size()) {
+        levels.resize(node.depth + 1);
+      }
+      BatchKey key{.kind = node.kind};
+      if (schemas_[i].has_value()) {
+        key.schema = schemas_[i].value<ObjectId>();
+      }
+      levels[node.depth][key].push_back(i);
+    }
+    for (auto level = levels.rbegin(); level != levels.rend(); ++level) {
+      for (const auto& [key, nodes] : *level) {
+        RETURN_IF_ERROR(ConvertBatch(key, nodes));
+      }
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Span<const JsonMember> Members(int64_t node) const {
+    const JsonNode& n = forest_.nodes[node];
+    return absl::MakeConstSpan(forest_.members)
+        .subspan(n.members_begin, n.members_end - n.members_begin);
+  }
+
+  // Returns a DataSlice with the converted `nodes` (-1 for missing items) and
+  // their common schema.
+  absl::StatusOr<DataSlice> MakeSlice(absl::Span<const int64_t> nodes,
+                                      DataSlice::JaggedShape shape) const {
+    DataSliceImpl::Builder bldr(nodes.size());
+    schema::CommonSchemaAggregator schema_agg;
+    for (int64_t i = 0; i < nodes.size(); ++i) {
+      if (nodes[i] < 0 || !items_[nodes[i]].has_value()) {
+        continue;
+      }
+      bldr.Insert(i, items_[nodes[i]]);
+      schema_agg.Add(item_schemas_[nodes[i]]);
+    }
+    DataSliceImpl impl = std::move(bldr).Build();
+    ASSIGN_OR_RETURN(DataItem schema, std::move(schema_agg).Get());
+    if (schema == schema::kObject || !impl.is_mixed_dtype()) {
+      return DataSlice::Create(std::move(impl), std::move(shape),
+                               std::move(schema), db_);
+    }
+    // E.g. INT32 and FLOAT32 values.
+    ASSIGN_OR_RETURN(auto objects,
+                     DataSlice::Create(std::move(impl), std::move(shape),
+                                       DataItem(schema::kObject), db_));
+    return CastToNarrow(objects, schema);
+  }
+
+  // Returns the elements (or members) of `containers` and their shape.
+  absl::StatusOr<std::pair<std::vector<int64_t>, DataSlice::JaggedShape>>
+  FlattenMembers(absl::Span<const int64_t> containers) const {
+    std::vector<int64_t> nodes;
+    std::vector<int64_t> splits = {0};
+    splits.reserve(containers.size() + 1);
+    for (int64_t container : containers) {
+      for (const JsonMember& member : Members(container)) {
+        nodes.push_back(member.node);
+      }
+      splits.push_back(nodes.size());
+    }
+    ASSIGN_OR_RETURN(auto edge0, DataSlice::JaggedShape::Edge::FromUniformGroups(
+                                     1, containers.size()));
+    ASSIGN_OR_RETURN(auto edge1,
+                     DataSlice::JaggedShape::Edge::FromSplitPoints(
+                         arolla::CreateFullDenseArray<int64_t>(splits)));
+    ASSIGN_OR_RETURN(auto shape, DataSlice::JaggedShape::FromEdges(
+                                     {std::move(edge0), std::move(edge1)}));
+    return std::make_pair(std::move(nodes), std::move(shape));
+  }
+
+  absl::StatusOr<DataSlice> MakeKeys(absl::Span<const int64_t> containers,
+                                     DataSlice::JaggedShape shape) const {
+    arolla::DenseArrayBuilder<arolla::Text> bldr(shape.size());
+    int64_t i = 0;
+    for (int64_t container : containers) {
+      for (const JsonMember& member : Members(container)) {
+        bldr.Set(i++, member.key);
+      }
+    }
+    return DataSlice::Create(DataSliceImpl::Create(std::move(bldr).Build()),
+                             std::move(shape), DataItem(schema::kText));
+  }
+
+  absl::StatusOr<DataSlice> CreateLists(absl::Span<const int64_t> containers,
+                                        const SchemaInfo* info) {
+    ASSIGN_OR_RETURN(auto flat, FlattenMembers(containers));
+    ASSIGN_OR_RETURN(auto values, MakeSlice(flat.first, std::move(flat.second)));
+    if (info != nullptr) {
+      return CreateListsFromLastDimension(db_, values, info->schema);
+    }
+    ASSIGN_OR_RETURN(auto lists, CreateListsFromLastDimension(db_, values));
+    return ToObject(lists);
+  }
+
+  absl::StatusOr<DataSlice> CreateDicts(absl::Span<const int64_t> containers,
+                                        const SchemaInfo* info) {
+    ASSIGN_OR_RETURN(auto flat, FlattenMembers(containers));
+    ASSIGN_OR_RETURN(auto keys, MakeKeys(containers, flat.second));
+    ASSIGN_OR_RETURN(auto values, MakeSlice(flat.first, std::move(flat.second)));
+    auto shape = DataSlice::JaggedShape::FlatFromSize(containers.size());
+    if (info != nullptr) {
+      return CreateDictShaped(db_, std::move(shape), keys, values,
+                              info->schema);
+    }
+    ASSIGN_OR_RETURN(auto dicts,
+                     CreateDictShaped(db_, std::move(shape), keys, values));
+    return ToObject(dicts);
+  }
+
+  // Creates entities (if `info` is not nullptr) or objects with `attr_names`.
+  absl::StatusOr<DataSlice> CreateObjects(
+      absl::Span<const int64_t> containers,
+      absl::Span<const absl::string_view> attr_names, const SchemaInfo* info) {
+    absl::flat_hash_map<absl::string_view, int64_t> attr_index;
+    for (int64_t i = 0; i < attr_names.size(); ++i) {
+      attr_index.emplace(attr_names[i], i);
+    }
+    std::vector<std::vector<int64_t>> attr_nodes(
+        attr_names.size(), std::vector<int64_t>(containers.size(), -1));
+    for (int64_t i = 0; i < containers.size(); ++i) {
+      // For duplicate keys the last value wins.
+      for (const JsonMember& member : Members(containers[i])) {
+        if (auto it = attr_index.find(member.key); it != attr_index.end()) {
+          attr_nodes[it->second][i] = member.node;
+        }
+      }
+    }
+    std::vector<DataSlice> values;
+    values.reserve(attr_names.size());
+    for (const auto& nodes : attr_nodes) {
+      ASSIGN_OR_RETURN(values.emplace_back(),
+                       MakeSlice(nodes, DataSlice::JaggedShape::FlatFromSize(
+                                            containers.size())));
+    }
+    auto shape = DataSlice::JaggedShape::FlatFromSize(containers.size());
+    if (info != nullptr) {
+      return EntityCreator::Shaped(db_, std::move(shape), attr_names, values,
+                                   info->schema);
+    }
+    return ObjectCreator::Shaped(db_, std::move(shape), attr_names, values);
+  }
+
+  // Creates Koda objects from JSON objects without a schema. The objects with
+  // the same set of keys are created together.
+  absl::Status ConvertObjectsWithoutSchema(
+      absl::Span<const int64_t> containers) {
+    absl::flat_hash_map<std::string, std::vector<int64_t>> by_keys;
+    std::vector<absl::string_view> keys;
+    for (int64_t container : containers) {
+      keys.clear();
+      for (const JsonMember& member : Members(container)) {
+        keys.push_back(member.key);
+      }
+      std::sort(keys.begin(), keys.end());
+      keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+      // Keys can't contain unescaped '"', so it can be used as a separator.
+      by_keys[absl::StrJoin(keys, "\"")].push_back(container);
+    }
+    for (const auto& [_, group] : by_keys) {
+      std::vector<absl::string_view> attr_names;
+      for (const JsonMember& member : Members(group.front())) {
+        attr_names.push_back(member.key);
+      }
+      std::sort(attr_names.begin(), attr_names.end());
+      attr_names.erase(std::unique(attr_names.begin(), attr_names.end()),
+                       attr_names.end());
+      ASSIGN_OR_RETURN(auto objects,
+                       CreateObjects(group, attr_names, /*info=*/nullptr));
+      StoreResults(group, objects);
+    }
+    return absl::OkStatus();
+  }
+
+  absl::Status ConvertBatch(const BatchKey& key,
+                            absl::Span<const int64_t> containers) {
+    const SchemaInfo* info = nullptr;
+    if (key.schema.has_value()) {
+      ASSIGN_OR_RETURN(info, GetSchemaInfo(DataItem(*key.schema)));
+    }
+    std::optional<DataSlice> res;
+    if (key.kind == JsonKind::kArray) {
+      ASSIGN_OR_RETURN(res, CreateLists(containers, info));
+    } else if (info == nullptr && dict_as_obj_) {
+      return ConvertObjectsWithoutSchema(containers);
+    } else if (info == nullptr || info->kind == SchemaInfo::kDict) {
+      ASSIGN_OR_RETURN(res, CreateDicts(containers, info));
+    } else {
+      ASSIGN_OR_RETURN(res,
+                       CreateObjects(containers, info->attr_names, info));
+    }
+    StoreResults(containers, *res);
+    return absl::OkStatus();
+  }
+
+  void StoreResults(absl::Span<const int64_t> containers,
+                    const DataSlice& res) {
+    const DataSliceImpl& impl = res.slice();
+    for (int64_t i = 0; i < containers.size(); ++i) {
+      items_[containers[i]] = impl[i];
+      item_schemas_[containers[i]] = res.GetSchemaImpl();
+    }
+  }
+
+  const DataBagPtr& db_;
+  const JsonForest& forest_;
+  const bool dict_as_obj_;
+  absl::flat_hash_map<ObjectId, SchemaInfo> schema_infos_;
+  // Per node: the schema to convert it to (missing if none), whether it is
+  // ignored, the converted item and its schema.
+  std::vector<DataItem> schemas_;
+  std::vector<bool> skipped_;
+  std::vector<DataItem> items_;
+  std::vector<DataItem> item_schemas_;
+};
+
+}  // namespace
+
+absl::StatusOr<DataSlice> FromJson(
+    const absl::Nonnull<DataBagPtr>& db,
+    absl::Span<const absl::string_view> documents,
+    const std::optional<DataSlice>& schema, bool dict_as_obj) {
+  JsonForest forest;
+  JsonParser parser(forest);
+  for (int64_t i = 0; i < documents.size(); ++i) {
+    if (absl::Status status = parser.Parse(documents[i]); !status.ok()) {
+      return absl::InvalidArgumentError(
+          absl::StrFormat("document %d: %s", i, status.message()));
+    }
+  }
+  return JsonConverter(db, forest, dict_as_obj).Convert(schema);
+}
+
+}  // namespace koladata
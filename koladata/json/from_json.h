@@ -0,0 +1,62 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_JSON_FROM_JSON_H_
+#define KOLADATA_JSON_FROM_JSON_H_
+
+#include <optional>
+
+#include "absl/base/nullability.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_slice.h"
+
+namespace koladata {
+
+// Parses JSON `documents` and converts them to a rank-1 DataSlice with one item
+// per document, without creating intermediate Python objects.
+//
+// JSON values are converted as by `kd.from_py(json.loads(document))`: null to
+// a missing item, true / false to BOOLEAN, integers to INT32 (or INT64 if they
+// don't fit), other numbers to FLOAT32, strings to TEXT, arrays to lists and
+// objects to dicts with TEXT keys. If `dict_as_obj` is true, JSON objects are
+// converted to Koda objects with the keys as attribute names instead.
+//
+// If `schema` is nullopt or OBJECT, nested lists, dicts and objects are
+// converted to OBJECT (i.e. their schemas are embedded). Lists, dicts and
+// objects are created in batches: all the containers of the same kind at the
+// same nesting level of all the documents are created at once, and the item
+// schema of such lists (value schema of dicts, attribute schemas of objects
+// with the same keys) is the common schema of all their values.
+//
+// Otherwise, `schema` determines the conversion: entity schemas require JSON
+// objects and convert the keys that are attributes of the schema (other keys
+// are ignored), list schemas require arrays, dict schemas require objects and
+// primitive schemas require compatible primitives. Values are cast to the
+// schema. If a sub-schema is OBJECT, the corresponding values are converted
+// as without a schema.
+//
+// The DataBag `db` must be mutable, and the converted data is added to it. If
+// this method returns a non-OK status, the contents of `db` are unspecified.
+absl::StatusOr<DataSlice> FromJson(
+    const absl::Nonnull<DataBagPtr>& db,
+    absl::Span<const absl::string_view> documents,
+    const std::optional<DataSlice>& schema = std::nullopt,
+    bool dict_as_obj = false);
+
+}  // namespace koladata
+
+#endif  // KOLADATA_JSON_FROM_JSON_H_
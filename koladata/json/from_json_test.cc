@@ -0,0 +1,182 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/json/from_json.h"
+
+#include <cstdint>
+#include <optional>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/string_view.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/object_factories.h"
+#include "koladata/test_utils.h"
+#include "koladata/testing/matchers.h"
+#include "arolla/util/text.h"
+
+namespace koladata {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::koladata::testing::IsEquivalentTo;
+using ::testing::HasSubstr;
+
+TEST(FromJsonTest, ZeroDocuments) {
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(auto result, FromJson(db, {}));
+  EXPECT_EQ(result.GetShape().rank(), 1);
+  EXPECT_EQ(result.size(), 0);
+  EXPECT_EQ(result.GetSchemaImpl(), schema::kObject);
+  EXPECT_EQ(result.GetDb(), db);
+}
+
+TEST(FromJsonTest, Primitives) {
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(auto result, FromJson(db, {"1", " -2 ", "null"}));
+  EXPECT_THAT(result, IsEquivalentTo(test::DataSlice<int32_t>(
+                          {1, -2, std::nullopt}, schema::kInt32, db)));
+
+  ASSERT_OK_AND_ASSIGN(result, FromJson(db, {"1", "1.5e1"}));
+  EXPECT_THAT(result, IsEquivalentTo(test::DataSlice<float>(
+                          {1.0f, 15.0f}, schema::kFloat32, db)));
+
+  ASSERT_OK_AND_ASSIGN(result, FromJson(db, {"1", "3000000000"}));
+  EXPECT_THAT(result, IsEquivalentTo(test::DataSlice<int64_t>(
+                          {1, 3000000000}, schema::kInt64, db)));
+
+  ASSERT_OK_AND_ASSIGN(result, FromJson(db, {"true", "false"}));
+  EXPECT_THAT(result, IsEquivalentTo(test::DataSlice<bool>(
+                          {true, false}, schema::kBool, db)));
+
+  ASSERT_OK_AND_ASSIGN(
+      result, FromJson(db, {R"("abc")", R"("a\"b\\c\né😀")"}));
+  EXPECT_THAT(result, IsEquivalentTo(test::DataSlice<arolla::Text>(
+                          {"abc", "a\"b\\c\n\xC3\xA9\xF0\x9F\x98\x80"},
+                          schema::kText, db)));
+
+  ASSERT_OK_AND_ASSIGN(result, FromJson(db, {"1", R"("a")"}));
+  EXPECT_EQ(result.GetSchemaImpl(), schema::kObject);
+}
+
+TEST(FromJsonTest, Lists) {
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(auto result,
+                       FromJson(db, {"[1, 2]", "[]", "[[3], [4, 5]]"}));
+  EXPECT_EQ(result.GetSchemaImpl(), schema::kObject);
+  ASSERT_OK_AND_ASSIGN(auto first, result.ExplodeList(0, std::nullopt));
+  ASSERT_EQ(first.GetShape().rank(), 2);
+  EXPECT_EQ(first.size(), 4);
+}
+
+TEST(FromJsonTest, DictsAndObjects) {
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(auto dicts,
+                       FromJson(db, {R"({"a": 1, "b": {"c": "x"}})"}));
+  EXPECT_EQ(dicts.GetSchemaImpl(), schema::kObject);
+  ASSERT_OK_AND_ASSIGN(
+      auto a, dicts.GetFromDict(test::DataSlice<arolla::Text>({"a"})));
+  EXPECT_THAT(a.slice(), koladata::testing::IsEquivalentTo(
+                             test::DataSlice<int32_t>({1}).slice()));
+
+  ASSERT_OK_AND_ASSIGN(
+      auto objects,
+      FromJson(db, {R"({"a": 1, "b": {"c": "x"}})", R"({"a": 2.5})"},
+               std::nullopt, /*dict_as_obj=*/true));
+  EXPECT_EQ(objects.GetSchemaImpl(), schema::kObject);
+  ASSERT_OK_AND_ASSIGN(auto attr_a, objects.GetAttr("a"));
+  EXPECT_THAT(attr_a.slice(),
+              koladata::testing::IsEquivalentTo(
+                  test::DataSlice<float>({1.0f, 2.5f}).slice()));
+  ASSERT_OK_AND_ASSIGN(auto item_b,
+                       objects.GetAttrWithDefault(
+                           "b", test::DataItem(internal::DataItem(),
+                                               schema::kObject)));
+  EXPECT_EQ(item_b.present_count(), 1);
+}
+
+TEST(FromJsonTest, EntitySchema) {
+  auto db = DataBag::Empty();
+  auto schema_db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      auto schema,
+      CreateEntitySchema(schema_db, {"x", "y"},
+                         {test::Schema(schema::kInt64),
+                          test::Schema(schema::kText)}));
+  ASSERT_OK_AND_ASSIGN(
+      auto result,
+      FromJson(db, {R"({"x": 1, "y": "a", "z": [1, 2]})", R"({"x": 2})",
+                    "null"},
+               schema));
+  EXPECT_EQ(result.GetSchemaImpl(), schema.item());
+  EXPECT_EQ(result.GetDb(), db);
+  ASSERT_OK_AND_ASSIGN(auto x, result.GetAttr("x"));
+  EXPECT_THAT(x.slice(), koladata::testing::IsEquivalentTo(
+                             test::DataSlice<int64_t>({1, 2, std::nullopt})
+                                 .slice()));
+
+  EXPECT_THAT(FromJson(db, {"[1]"}, schema),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("cannot convert a JSON array")));
+  EXPECT_THAT(FromJson(db, {"1"}, schema),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("cannot convert a JSON primitive")));
+}
+
+TEST(FromJsonTest, ListAndDictSchemas) {
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      auto list_schema,
+      CreateListSchema(db, test::Schema(schema::kFloat32)));
+  ASSERT_OK_AND_ASSIGN(auto lists, FromJson(db, {"[1, 2]", "[3.5]"},
+                                            list_schema));
+  EXPECT_EQ(lists.GetSchemaImpl(), list_schema.item());
+  ASSERT_OK_AND_ASSIGN(auto items, lists.ExplodeList(0, std::nullopt));
+  EXPECT_EQ(items.GetSchemaImpl(), schema::kFloat32);
+
+  ASSERT_OK_AND_ASSIGN(
+      auto dict_schema,
+      CreateDictSchema(db, test::Schema(schema::kText),
+                       test::Schema(schema::kInt64)));
+  ASSERT_OK_AND_ASSIGN(auto dicts,
+                       FromJson(db, {R"({"a": 1})"}, dict_schema));
+  EXPECT_EQ(dicts.GetSchemaImpl(), dict_schema.item());
+  ASSERT_OK_AND_ASSIGN(
+      auto a, dicts.GetFromDict(test::DataSlice<arolla::Text>({"a"})));
+  EXPECT_EQ(a.GetSchemaImpl(), schema::kInt64);
+
+  ASSERT_OK_AND_ASSIGN(auto ints,
+                       FromJson(db, {"1", "2"}, test::Schema(schema::kInt64)));
+  EXPECT_THAT(ints, IsEquivalentTo(test::DataSlice<int64_t>(
+                        {1, 2}, schema::kInt64, db)));
+}
+
+TEST(FromJsonTest, InvalidJson) {
+  auto db = DataBag::Empty();
+  for (absl::string_view json :
+       {"", "[1,", "[1 2]", R"({"a" 1})", "{1: 2}", "01", "1.", "-", "tru",
+        R"("abc)", R"("\x")", R"("\ud800")", "1 2", "\"\x01\""}) {
+    EXPECT_THAT(FromJson(db, {"1", json}),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("document 1: invalid JSON at offset")))
+        << json;
+  }
+}
+
+}  // namespace
+}  // namespace koladata
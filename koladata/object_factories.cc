@@ -21,6 +21,7 @@
 #include <functional>
 #include <memory>
 #include <optional>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
@@ -224,9 +225,13 @@ absl::Status OverwriteObjectSchemaForEntireAllocation(
       schema_alloc, ds_impl.size(), attr_names, schemas));
   auto schema_impl =
       DataSliceImpl::ObjectsFromAllocation(schema_alloc, ds_impl.size());
-  RETURN_IF_ERROR(
-      db_mutable_impl.SetAttr(ds_impl, schema::kSchemaAttr, schema_impl));
-  return absl::OkStatus();
+  if (ds_impl.allocation_ids().contains_small_allocation_id()) {
+    return db_mutable_impl.SetAttr(ds_impl, schema::kSchemaAttr, schema_impl);
+  }
+  // The objects were just allocated, so `__schema__` is written as a single
+  // readonly dense source wrapping `schema_impl`, without a mutable copy.
+  return db_mutable_impl.SetAttrForEntireAllocation(
+      ds_impl.allocation_ids().ids()[0], schema::kSchemaAttr, schema_impl);
 }
 
 // Returns an object (with `db` attached) that can be created either from
@@ -304,7 +309,7 @@ absl::Status VerifyAndInitItemId(
         "itemid expected ITEMID schema, got %v",
         itemid.GetSchemaImpl()));
   }
-  if (!itemid.GetShape().IsEquivalentTo(shape)) {
+  if (!ShapesAreEquivalent(itemid.GetShape(), shape)) {
     return absl::InvalidArgumentError(absl::StrFormat(
         "cannot create Koda Items with provided ItemIds %s as its shape is "
         "different from the shape of the resulting DataSlice: %s",
@@ -565,25 +570,36 @@ absl::StatusOr<DataSlice> CreateEntitiesImpl(
 
 // Implementation of ObjectCreator -Shaped and -Like that handles assignment of
 // attributes. `create_objects_fn` must create a DataSlice with appropriate
-// shape and sparsity with OBJECT schema.
+// shape and sparsity with OBJECT schema. `new_allocation` means that the
+// objects were allocated by `create_objects_fn` rather than provided by the
+// caller.
 template <typename CreateObjectsFn>
 absl::StatusOr<DataSlice> CreateObjectsImpl(
     const DataBagPtr& db,
     const CreateObjectsFn& create_objects_fn,
     absl::Span<const absl::string_view> attr_names,
-    absl::Span<const DataSlice> values) {
+    absl::Span<const DataSlice> values, bool new_allocation) {
   RETURN_IF_ERROR(VerifyNoSchemaArg(attr_names));
   ASSIGN_OR_RETURN(DataSlice res, create_objects_fn());
-  RETURN_IF_ERROR(res.VisitImpl([&](const auto& impl) -> absl::Status {
+  RETURN_IF_ERROR(res.VisitImpl([&]<class ImplT>(
+                                    const ImplT& impl) -> absl::Status {
     ASSIGN_OR_RETURN(
         auto schema_impl,
         CreateUuidWithMainObject<internal::ObjectId::kUuidImplicitSchemaFlag>(
             impl, schema::kImplicitSchemaSeed));
     ASSIGN_OR_RETURN(internal::DataBagImpl & db_mutable_impl,
                      db->GetMutableImpl());
-    RETURN_IF_ERROR(
-        db_mutable_impl.SetAttr(impl, schema::kSchemaAttr, schema_impl));
-    return absl::OkStatus();
+    if constexpr (std::is_same_v<ImplT, DataSliceImpl>) {
+      if (new_allocation && impl.is_allocation_prefix() &&
+          !impl.allocation_ids().contains_small_allocation_id()) {
+        // Same as in OverwriteObjectSchemaForEntireAllocation: `__schema__`
+        // of the new objects is a single readonly dense source wrapping
+        // `schema_impl`.
+        return db_mutable_impl.SetAttrForEntireAllocation(
+            impl.allocation_ids().ids()[0], schema::kSchemaAttr, schema_impl);
+      }
+    }
+    return db_mutable_impl.SetAttr(impl, schema::kSchemaAttr, schema_impl);
   }));
   RETURN_IF_ERROR(res.SetAttrs(attr_names, values));
   // Adopt into the databag only at the end to avoid garbage in the databag in
@@ -791,7 +807,7 @@ absl::StatusOr<DataSlice> ObjectCreator::Shaped(
                             internal::Allocate,
                             itemid,
                             DefaultInitItemIdType);
-      }, attr_names, values);
+      }, attr_names, values, /*new_allocation=*/!itemid.has_value());
 }
 
 absl::StatusOr<DataSlice> ObjectCreator::Like(
@@ -808,7 +824,7 @@ absl::StatusOr<DataSlice> ObjectCreator::Like(
                           internal::Allocate,
                           itemid,
                           DefaultInitItemIdType);
-      }, attr_names, values);
+      }, attr_names, values, /*new_allocation=*/!itemid.has_value());
 }
 
 absl::StatusOr<DataSlice> ObjectCreator::Convert(const DataBagPtr& db,
@@ -885,6 +885,54 @@ TEST(ObjectCreatorTest, DataSlice) {
           ElementsAre(schema::kInt32, schema::kInt32, schema::kInt32)));
 }
 
+TEST(ObjectCreatorTest, DataSliceSchemaAttrIsMutable) {
+  auto db = DataBag::Empty();
+  auto ds_a = test::DataSlice<int>({1, 2, 3, 4});
+  ASSERT_OK_AND_ASSIGN(auto ds,
+                       ObjectCreator::FromAttrs(db, {std::string("a")},
+                                                {ds_a}));
+  ASSERT_OK_AND_ASSIGN(auto schema_slice,
+                       db->GetImpl().GetAttr(ds.slice(), schema::kSchemaAttr));
+  ASSERT_EQ(schema_slice.present_count(), 4);
+
+  // `__schema__` of the new objects can still be modified in place.
+  auto new_schema = internal::DataItem(internal::AllocateExplicitSchema());
+  ASSERT_OK_AND_ASSIGN(internal::DataBagImpl & db_mutable_impl,
+                       db->GetMutableImpl());
+  ASSERT_OK(db_mutable_impl.SetAttr(ds.slice()[1], schema::kSchemaAttr,
+                                    new_schema));
+  EXPECT_THAT(db->GetImpl().GetAttr(ds.slice(), schema::kSchemaAttr),
+              IsOkAndHolds(ElementsAre(schema_slice[0], new_schema,
+                                       schema_slice[2], schema_slice[3])));
+}
+
+TEST(ObjectCreatorTest, ShapedSchemaAttr) {
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      auto ds,
+      ObjectCreator::Shaped(db, DataSlice::JaggedShape::FlatFromSize(4), {"a"},
+                            {test::DataSlice<int>({1, 2, 3, 4})}));
+  EXPECT_THAT(ds.GetAttr("a"),
+              IsOkAndHolds(IsEquivalentTo(
+                  test::DataSlice<int>({1, 2, 3, 4}).WithDb(db))));
+  ASSERT_OK_AND_ASSIGN(auto schema_slice,
+                       db->GetImpl().GetAttr(ds.slice(), schema::kSchemaAttr));
+  ASSERT_EQ(schema_slice.present_count(), 4);
+  EXPECT_NE(schema_slice[0], schema_slice[1]);
+  EXPECT_THAT(db->GetImpl().GetSchemaAttr(schema_slice[3], "a"),
+              IsOkAndHolds(internal::DataItem(schema::kInt32)));
+
+  // `__schema__` of the new objects can still be modified in place.
+  auto new_schema = internal::DataItem(internal::AllocateExplicitSchema());
+  ASSERT_OK_AND_ASSIGN(internal::DataBagImpl & db_mutable_impl,
+                       db->GetMutableImpl());
+  ASSERT_OK(db_mutable_impl.SetAttr(ds.slice()[1], schema::kSchemaAttr,
+                                    new_schema));
+  EXPECT_THAT(db->GetImpl().GetAttr(ds.slice(), schema::kSchemaAttr),
+              IsOkAndHolds(ElementsAre(schema_slice[0], new_schema,
+                                       schema_slice[2], schema_slice[3])));
+}
+
 TEST(ObjectCreatorTest, DataItem) {
   auto db = DataBag::Empty();
   auto ds_a = test::DataItem(internal::AllocateSingleObject());
@@ -14,7 +14,11 @@
 //
 #include "koladata/operators/arolla_bridge.h"
 
+#include <algorithm>
+#include <array>
+#include <atomic>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
 #include <optional>
@@ -22,36 +26,45 @@
 #include <utility>
 #include <vector>
 
-#include "absl/base/const_init.h"
 #include "absl/base/no_destructor.h"
 #include "absl/base/optimization.h"
-#include "absl/base/thread_annotations.h"
 #include "absl/container/inlined_vector.h"
+#include "absl/functional/function_ref.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_join.h"
 #include "absl/strings/string_view.h"
-#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "koladata/arolla_utils.h"
 #include "koladata/data_slice.h"
 #include "koladata/data_slice_qtype.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/schema_utils.h"
+#include "koladata/internal/sharded_lru_cache.h"
+#include "koladata/internal/trace.h"
+#include "koladata/internal/types.h"
 #include "koladata/shape_utils.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
 #include "arolla/dense_array/qtype/types.h"
+#include "arolla/expr/expr_operator.h"
 #include "arolla/expr/registered_expr_operator.h"
 #include "arolla/jagged_shape/dense_array/qtype/qtype.h"
+#include "arolla/jagged_shape/dense_array/util/concat.h"
+#include "arolla/memory/buffer.h"
 #include "arolla/qtype/optional_qtype.h"
 #include "arolla/qtype/qtype.h"
 #include "arolla/qtype/standard_type_properties/properties.h"
 #include "arolla/qtype/typed_ref.h"
 #include "arolla/qtype/typed_value.h"
 #include "arolla/serving/expr_compiler.h"
-#include "arolla/util/lru_cache.h"
+#include "arolla/util/meta.h"
 #include "arolla/util/repr.h"
+#include "arolla/util/unit.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata::ops {
@@ -59,12 +72,91 @@ namespace {
 
 constexpr size_t kCompilationCacheSize = 4096;
 
+// Small direct-mapped per-thread cache in front of the shared compilation
+// cache. Entries are found by the address of the op name (callers normally
+// pass string literals) and the input QTypes, so a hit requires neither
+// hashing the op name nor taking a lock.
+class ThreadLocalCompilationCache {
+ public:
+  static constexpr size_t kSizeBits = 6;
+  static constexpr size_t kSize = 1 << kSizeBits;
+
+  // Returns the cached function or nullptr. The pointer is valid until the next
+  // Put or Clear on this thread.
+  const compiler_internal::CompiledOp* LookupOrNull(
+      absl::string_view op_name, absl::Span<const arolla::TypedRef> inputs,
+      uint64_t generation) {
+    if (ABSL_PREDICT_FALSE(generation != generation_)) {
+      Clear(generation);
+      return nullptr;
+    }
+    const Entry& entry = entries_[Index(op_name, inputs)];
+    // op_name is compared by value too, since the address may be reused by a
+    // different string.
+    if (entry.op_name_data != op_name.data() || entry.op_name != op_name ||
+        entry.input_qtypes.size() != inputs.size()) {
+      return nullptr;
+    }
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      if (entry.input_qtypes[i] != inputs[i].GetType()) {
+        return nullptr;
+      }
+    }
+    return &entry.fn;
+  }
+
+  void Put(absl::string_view op_name, absl::Span<const arolla::TypedRef> inputs,
+           compiler_internal::CompiledOp fn) {
+    Entry& entry = entries_[Index(op_name, inputs)];
+    entry.op_name_data = op_name.data();
+    entry.op_name.assign(op_name.data(), op_name.size());
+    entry.input_qtypes.resize(inputs.size());
+    for (size_t i = 0; i < inputs.size(); ++i) {
+      entry.input_qtypes[i] = inputs[i].GetType();
+    }
+    entry.fn = std::move(fn);
+  }
+
+  static ThreadLocalCompilationCache& Instance() {
+    static thread_local ThreadLocalCompilationCache cache;
+    return cache;
+  }
+
+ private:
+  struct Entry {
+    const char* op_name_data = nullptr;
+    std::string op_name;
+    absl::InlinedVector<arolla::QTypePtr, 4> input_qtypes;
+    compiler_internal::CompiledOp fn;
+  };
+
+  static size_t Index(absl::string_view op_name,
+                      absl::Span<const arolla::TypedRef> inputs) {
+    constexpr uint64_t kMul = 0x9E3779B97F4A7C15ull;
+    uint64_t h = reinterpret_cast<uintptr_t>(op_name.data()) * kMul;
+    for (const auto& input : inputs) {
+      h = (h ^ reinterpret_cast<uintptr_t>(input.GetType())) * kMul;
+    }
+    return h >> (64 - kSizeBits);
+  }
+
+  void Clear(uint64_t generation) {
+    for (Entry& entry : entries_) {
+      entry = Entry();
+    }
+    generation_ = generation;
+  }
+
+  uint64_t generation_ = 0;
+  std::array<Entry, kSize> entries_;
+};
+
 class EvalCompiler {
   using Compiler = ::arolla::ExprCompiler<absl::Span<const ::arolla::TypedRef>,
                                           arolla::TypedValue>;
-  using Impl =
-      arolla::LruCache<compiler_internal::Key, compiler_internal::CompiledOp,
-                       compiler_internal::KeyHash, compiler_internal::KeyEq>;
+  using Impl = internal::ShardedLruCache<
+      compiler_internal::Key, compiler_internal::CompiledOp,
+      compiler_internal::KeyHash, compiler_internal::KeyEq>;
 
  public:
   static compiler_internal::CompiledOp Lookup(
@@ -74,55 +166,81 @@ class EvalCompiler {
     //
     // NOTE: If copying a function is more expensive than copying
     // a `std::shared_ptr`, we could use `std::shared_ptr<std::function<>>`.
-    // Alternatively, we could consider having a thread-local cache that
-    // requires no mutex and no function copying.
-    absl::MutexLock lock(&mutex_);
-    if (auto* hit =
-            cache_->LookupOrNull(compiler_internal::LookupKey{op_name, inputs});
-        hit != nullptr) {
-      return *hit;
-    }
-    return {};
+    return cache_->LookupOrNull(compiler_internal::LookupKey{op_name, inputs});
   }
 
   static absl::StatusOr<compiler_internal::CompiledOp> Compile(
       absl::string_view op_name, absl::Span<const arolla::TypedRef> inputs) {
-    compiler_internal::CompiledOp fn = Lookup(op_name, inputs);
-    if (ABSL_PREDICT_TRUE(fn)) {
-      return fn;
+    return Compile(op_name, inputs,
+                   [&]() -> absl::StatusOr<arolla::expr::ExprOperatorPtr> {
+                     return std::make_shared<arolla::expr::RegisteredOperator>(
+                         op_name);
+                   });
+  }
+
+  // Same as above, but the operator is created by `make_op` on a cache miss.
+  // `op_name` is used only as the cache key.
+  static absl::StatusOr<compiler_internal::CompiledOp> Compile(
+      absl::string_view op_name, absl::Span<const arolla::TypedRef> inputs,
+      absl::FunctionRef<absl::StatusOr<arolla::expr::ExprOperatorPtr>()>
+          make_op) {
+    auto& local_cache = ThreadLocalCompilationCache::Instance();
+    if (const auto* local_fn = local_cache.LookupOrNull(
+            op_name, inputs, generation_.load(std::memory_order_acquire));
+        ABSL_PREDICT_TRUE(local_fn != nullptr)) {
+      return *local_fn;
     }
-    std::vector<arolla::QTypePtr> input_types(inputs.size());
-    for (size_t i = 0; i < inputs.size(); ++i) {
-      input_types[i] = inputs[i].GetType();
+    compiler_internal::CompiledOp fn = Lookup(op_name, inputs);
+    if (!fn) {
+      internal::TraceSpan span("compile", op_name);
+      std::vector<arolla::QTypePtr> input_types(inputs.size());
+      for (size_t i = 0; i < inputs.size(); ++i) {
+        input_types[i] = inputs[i].GetType();
+      }
+      ASSIGN_OR_RETURN(auto expr_op, make_op());
+      ASSIGN_OR_RETURN(
+          fn, Compiler()
+                  // Most of the operators are compiled into rather small
+                  // instruction sequences and don't contain many literals. In
+                  // such cases the always clone thread safety policy is
+                  // faster.
+                  .SetAlwaysCloneThreadSafetyPolicy()
+                  .CompileOperator(expr_op, input_types));
+      fn = cache_->Put(
+          compiler_internal::Key{std::string(op_name), std::move(input_types)},
+          std::move(fn));
     }
-    auto expr_op = std::make_shared<arolla::expr::RegisteredOperator>(op_name);
-    ASSIGN_OR_RETURN(
-        fn, Compiler()
-                // Most of the operators are compiled into rather small
-                // instruction sequences and don't contain many literals. In
-                // such cases the always clone thread safety policy is faster.
-                .SetAlwaysCloneThreadSafetyPolicy()
-                .CompileOperator(expr_op, input_types));
-    absl::MutexLock lock(&mutex_);
-    return *cache_->Put(
-        compiler_internal::Key{std::string(op_name), std::move(input_types)},
-        std::move(fn));
+    local_cache.Put(op_name, inputs, fn);
+    return fn;
   }
 
   static void Clear() {
-    absl::MutexLock lock(&mutex_);
+    // Invalidates the thread-local caches of all threads.
+    generation_.fetch_add(1, std::memory_order_acq_rel);
     cache_->Clear();
   }
 
  private:
-  static absl::NoDestructor<Impl> cache_ ABSL_GUARDED_BY(mutex_);
-  static absl::Mutex mutex_;
+  static absl::NoDestructor<Impl> cache_;
+  static std::atomic<uint64_t> generation_;
 };
 
+std::atomic<uint64_t> EvalCompiler::generation_ = 0;
+
 absl::NoDestructor<EvalCompiler::Impl> EvalCompiler::cache_(
     kCompilationCacheSize);
 
-absl::Mutex EvalCompiler::mutex_{absl::kConstInit};
+// Adds the input types of an operator to `span`, if it is active.
+void AddInputTypesArg(absl::Span<const arolla::TypedRef> inputs,
+                      internal::TraceSpan& span) {
+  if (span.active()) {
+    span.AddArg("input_types",
+                absl::StrJoin(inputs, ", ",
+                              [](std::string* out, const arolla::TypedRef& x) {
+                                absl::StrAppend(out, x.GetType()->name());
+                              }));
+  }
+}
 
 absl::InlinedVector<bool, 16> GetPrimaryOperandMask(
     size_t input_size,
@@ -180,10 +298,154 @@ absl::StatusOr<internal::DataItem> GetResultSchema(
   return internal::DataItem(result_dtype);
 }
 
+// Minimal number of child items per chunk in ParallelAggEval.
+constexpr int64_t kMinParallelAggChunkSize = 1 << 16;
+
+// Returns `array[offset:offset + size]` if `array` is a DenseArray, or `array`
+// itself otherwise (e.g. for scalar inputs).
+absl::StatusOr<arolla::TypedValue> SliceArollaArray(arolla::TypedRef array,
+                                                    int64_t offset,
+                                                    int64_t size) {
+  if (!arolla::IsDenseArrayQType(array.GetType())) {
+    return arolla::TypedValue(array);
+  }
+  std::optional<arolla::TypedValue> result;
+  arolla::meta::foreach_type(
+      internal::supported_primitives_list(), [&](auto tpe) {
+        using T = typename decltype(tpe)::type;
+        if (array.GetType() == arolla::GetDenseArrayQType<T>()) {
+          result = arolla::TypedValue::FromValue(
+              array.UnsafeAs<arolla::DenseArray<T>>().Slice(offset, size));
+        }
+      });
+  if (!result.has_value()) {
+    return absl::InternalError(absl::StrCat(
+        "unsupported array type for chunked evaluation: ",
+        array.GetType()->name()));
+  }
+  return *std::move(result);
+}
+
+// Concatenates the DenseArrays in `chunks`, which must all have the same type.
+absl::StatusOr<arolla::TypedValue> ConcatArollaArrays(
+    absl::Span<const arolla::TypedValue> chunks) {
+  DCHECK(!chunks.empty());
+  arolla::QTypePtr qtype = chunks[0].GetType();
+  std::optional<absl::StatusOr<arolla::TypedValue>> result;
+  arolla::meta::foreach_type(
+      internal::supported_primitives_list(), [&](auto tpe) {
+        using T = typename decltype(tpe)::type;
+        if (qtype != arolla::GetDenseArrayQType<T>()) {
+          return;
+        }
+        std::vector<arolla::DenseArray<T>> arrays;
+        std::vector<DataSlice::JaggedShape> shapes;
+        arrays.reserve(chunks.size());
+        shapes.reserve(chunks.size());
+        for (const auto& chunk : chunks) {
+          auto array = chunk.As<arolla::DenseArray<T>>();
+          if (!array.ok()) {
+            result = array.status();
+            return;
+          }
+          shapes.push_back(
+              DataSlice::JaggedShape::FlatFromSize(array->get().size()));
+          arrays.push_back(array->get());
+        }
+        auto concatenated = arolla::ConcatJaggedArraysAlongDimension(
+            absl::MakeConstSpan(arrays), absl::MakeConstSpan(shapes), 0);
+        if (!concatenated.ok()) {
+          result = concatenated.status();
+          return;
+        }
+        result = arolla::TypedValue::FromValue(std::move(concatenated->first));
+      });
+  if (!result.has_value()) {
+    return absl::InternalError(absl::StrCat(
+        "unsupported result type for chunked evaluation: ", qtype->name()));
+  }
+  return *std::move(result);
+}
+
+// Evaluates the aggregation `op_name` on ranges of consecutive groups of
+// `edge` concurrently using `executor` and concatenates the results. The
+// ranges are chosen to have a similar number of child items. Relies on the
+// operator computing every group independently of the others. Returns
+// std::nullopt if the input is too small to be split.
+absl::StatusOr<std::optional<arolla::TypedValue>> ParallelAggEval(
+    absl::string_view op_name, absl::Span<const arolla::TypedRef> inputs,
+    const arolla::DenseArrayEdge& edge, int edge_arg_index,
+    internal::Executor* executor) {
+  int64_t chunk_count = internal::ParallelChunkCount(
+      executor, edge.child_size(), kMinParallelAggChunkSize);
+  if (chunk_count <= 1 ||
+      edge.edge_type() != arolla::DenseArrayEdge::SPLIT_POINTS) {
+    return std::nullopt;
+  }
+  absl::Span<const int64_t> split_points = edge.edge_values().values.span();
+  // Group boundaries of the chunks. The child items of the groups
+  // [group_bounds[i], group_bounds[i + 1]) are evaluated together.
+  std::vector<int64_t> group_bounds = {0};
+  for (int64_t i = 1; i < chunk_count; ++i) {
+    int64_t target = edge.child_size() * i / chunk_count;
+    int64_t group = std::lower_bound(split_points.begin(), split_points.end(),
+                                     target) -
+                    split_points.begin();
+    if (group > group_bounds.back() && group < edge.parent_size()) {
+      group_bounds.push_back(group);
+    }
+  }
+  group_bounds.push_back(edge.parent_size());
+  if (group_bounds.size() <= 2) {
+    return std::nullopt;
+  }
+  std::vector<arolla::TypedValue> results(
+      group_bounds.size() - 1, arolla::TypedValue::FromValue(arolla::Unit()));
+  RETURN_IF_ERROR(internal::ParallelFor(
+      executor, results.size(), [&](int64_t chunk) -> absl::Status {
+        int64_t group_begin = group_bounds[chunk];
+        int64_t group_end = group_bounds[chunk + 1];
+        int64_t child_begin = split_points[group_begin];
+        int64_t child_size = split_points[group_end] - child_begin;
+        arolla::Buffer<int64_t>::Builder chunk_split_points(
+            group_end - group_begin + 1);
+        for (int64_t g = group_begin; g <= group_end; ++g) {
+          chunk_split_points.Set(g - group_begin,
+                                 split_points[g] - child_begin);
+        }
+        ASSIGN_OR_RETURN(auto chunk_edge,
+                         arolla::DenseArrayEdge::FromSplitPoints(
+                             {std::move(chunk_split_points).Build()}));
+        auto chunk_edge_tv = arolla::TypedValue::FromValue(chunk_edge);
+        std::vector<arolla::TypedValue> chunk_holder;
+        std::vector<arolla::TypedRef> chunk_inputs;
+        chunk_holder.reserve(inputs.size());
+        chunk_inputs.reserve(inputs.size());
+        for (int i = 0; i < inputs.size(); ++i) {
+          if (i == edge_arg_index) {
+            chunk_inputs.push_back(chunk_edge_tv.AsRef());
+            continue;
+          }
+          ASSIGN_OR_RETURN(
+              auto chunk_input,
+              SliceArollaArray(inputs[i], child_begin, child_size));
+          // No reallocation thanks to the reserve above, so the refs stay
+          // valid.
+          chunk_inputs.push_back(
+              chunk_holder.emplace_back(std::move(chunk_input)).AsRef());
+        }
+        ASSIGN_OR_RETURN(results[chunk], EvalExpr(op_name, chunk_inputs));
+        return absl::OkStatus();
+      }));
+  ASSIGN_OR_RETURN(auto result, ConcatArollaArrays(results));
+  return result;
+}
+
 absl::StatusOr<DataSlice> SimpleAggEval(
     absl::string_view op_name, std::vector<DataSlice> inputs,
     internal::DataItem output_schema, int edge_arg_index, bool is_agg_into,
-    const std::optional<absl::Span<const int>>& primary_operand_indices) {
+    const std::optional<absl::Span<const int>>& primary_operand_indices,
+    internal::Executor* executor) {
   DCHECK_GE(inputs.size(), 1);
   DCHECK_GE(edge_arg_index, 0);
   DCHECK_LE(edge_arg_index, inputs.size());
@@ -226,16 +488,29 @@ absl::StatusOr<DataSlice> SimpleAggEval(
   }
   auto edge_tv = arolla::TypedValue::FromValue(aligned_shape.edges().back());
   typed_refs[edge_arg_index] = edge_tv.AsRef();
-  ASSIGN_OR_RETURN(auto result, EvalExpr(op_name, typed_refs));
+  std::optional<arolla::TypedValue> result;
+  std::shared_ptr<internal::Executor> current_executor;
+  if (executor == nullptr) {
+    current_executor = internal::CurrentExecutor();
+    executor = current_executor.get();
+  }
+  if (executor != nullptr) {
+    ASSIGN_OR_RETURN(result, ParallelAggEval(op_name, typed_refs,
+                                             aligned_shape.edges().back(),
+                                             edge_arg_index, executor));
+  }
+  if (!result.has_value()) {
+    ASSIGN_OR_RETURN(result, EvalExpr(op_name, typed_refs));
+  }
   if (!output_schema.has_value()) {
     // Get the common schema from the primary inputs and output.
-    ASSIGN_OR_RETURN(auto result_schema, GetResultSchema(result));
+    ASSIGN_OR_RETURN(auto result_schema, GetResultSchema(*result));
     ASSIGN_OR_RETURN(
         output_schema,
         schema::CommonSchema(primary_operand_schema_info.common_schema,
                              result_schema));
   }
-  return DataSliceFromArollaValue(result.AsRef(), std::move(result_shape),
+  return DataSliceFromArollaValue(result->AsRef(), std::move(result_shape),
                                   std::move(output_schema));
 }
 
@@ -254,10 +529,22 @@ void ClearCache() { return EvalCompiler::Clear(); }
 
 absl::StatusOr<arolla::TypedValue> EvalExpr(
     absl::string_view op_name, absl::Span<const arolla::TypedRef> inputs) {
+  internal::TraceSpan span("op", op_name);
+  AddInputTypesArg(inputs, span);
   ASSIGN_OR_RETURN(auto fn, EvalCompiler::Compile(op_name, inputs));
   return fn(inputs);
 }
 
+absl::StatusOr<arolla::TypedValue> EvalExprOperator(
+    absl::string_view cache_key,
+    absl::FunctionRef<absl::StatusOr<arolla::expr::ExprOperatorPtr>()> make_op,
+    absl::Span<const arolla::TypedRef> inputs) {
+  internal::TraceSpan span("op", cache_key);
+  AddInputTypesArg(inputs, span);
+  ASSIGN_OR_RETURN(auto fn, EvalCompiler::Compile(cache_key, inputs, make_op));
+  return fn(inputs);
+}
+
 absl::StatusOr<internal::DataItem> GetPrimitiveArollaSchema(
     const DataSlice& x) {
   const auto& schema = x.GetSchemaImpl();
@@ -337,19 +624,23 @@ absl::StatusOr<DataSlice> SimplePointwiseEval(
 absl::StatusOr<DataSlice> SimpleAggIntoEval(
     absl::string_view op_name, std::vector<DataSlice> inputs,
     internal::DataItem output_schema, int edge_arg_index,
-    const std::optional<absl::Span<const int>>& primary_operand_indices) {
+    const std::optional<absl::Span<const int>>& primary_operand_indices,
+    internal::Executor* executor) {
   return SimpleAggEval(op_name, std::move(inputs), std::move(output_schema),
                        edge_arg_index,
-                       /*is_agg_into=*/true, primary_operand_indices);
+                       /*is_agg_into=*/true, primary_operand_indices,
+                       executor);
 }
 
 absl::StatusOr<DataSlice> SimpleAggOverEval(
     absl::string_view op_name, std::vector<DataSlice> inputs,
     internal::DataItem output_schema, int edge_arg_index,
-    const std::optional<absl::Span<const int>>& primary_operand_indices) {
+    const std::optional<absl::Span<const int>>& primary_operand_indices,
+    internal::Executor* executor) {
   return SimpleAggEval(op_name, std::move(inputs), std::move(output_schema),
                        edge_arg_index,
-                       /*is_agg_into=*/false, primary_operand_indices);
+                       /*is_agg_into=*/false, primary_operand_indices,
+                       executor);
 }
 
 }  // namespace koladata::ops
@@ -22,6 +22,7 @@
 #include <string>
 #include <vector>
 
+#include "absl/functional/function_ref.h"
 #include "absl/hash/hash.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
@@ -31,8 +32,10 @@
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/qtype/types.h"
+#include "arolla/expr/expr_operator.h"
 #include "arolla/memory/optional_value.h"
 #include "arolla/qtype/qtype.h"
 #include "arolla/qtype/typed_ref.h"
@@ -149,6 +152,15 @@ void ClearCache();
 absl::StatusOr<arolla::TypedValue> EvalExpr(
     absl::string_view op_name, absl::Span<const arolla::TypedRef> inputs);
 
+// Evaluates the operator created by `make_op` on the given inputs, using the
+// same compilation cache as EvalExpr. `make_op` is only called on a cache miss,
+// so `cache_key` must uniquely identify the operator and must not clash with
+// the names of registered operators.
+absl::StatusOr<arolla::TypedValue> EvalExprOperator(
+    absl::string_view cache_key,
+    absl::FunctionRef<absl::StatusOr<arolla::expr::ExprOperatorPtr>()> make_op,
+    absl::Span<const arolla::TypedRef> inputs);
+
 // Returns the schema of the data of `x` that is compatible with Arolla.
 // * If the schema of `x` is a primitive schema, returns it.
 // * If the schema is given by the data (e.g. in the case of `OBJECT`), the
@@ -197,12 +209,19 @@ absl::StatusOr<DataSlice> SimplePointwiseEval(
 // primitive schema of the primary inputs is used to construct all primary
 // inputs, and the non-primary inputs are treated individually (i.e. the
 // primitive schema of each non-primary input is used to construct it).
+//
+// Large inputs are split into ranges of consecutive groups with a similar
+// total size, which are evaluated concurrently on `executor` (or
+// internal::CurrentExecutor() if `executor` is nullptr) and then concatenated.
+// The operator must compute every group independently of the others, which
+// holds for the aggregations over an edge.
 absl::StatusOr<DataSlice> SimpleAggIntoEval(
     absl::string_view op_name, std::vector<DataSlice> inputs,
     internal::DataItem output_schema = internal::DataItem(),
     int edge_arg_index = 1,
     const std::optional<absl::Span<const int>>& primary_operand_indices =
-        std::nullopt);
+        std::nullopt,
+    internal::Executor* executor = nullptr);
 
 // Evaluates the registered operator of the given name on the given input and
 // returns the result. The expr_op is expected to be an agg-over operator that
@@ -221,12 +240,19 @@ absl::StatusOr<DataSlice> SimpleAggIntoEval(
 // is used to construct all primary inputs, and the non-primary inputs are
 // treated individually (i.e. the primitive schema of each non-primary input is
 // used to construct it).
+//
+// Large inputs are split into ranges of consecutive groups with a similar
+// total size, which are evaluated concurrently on `executor` (or
+// internal::CurrentExecutor() if `executor` is nullptr) and then concatenated.
+// The operator must compute every group independently of the others, e.g.
+// cumulative aggregations must restart at every group.
 absl::StatusOr<DataSlice> SimpleAggOverEval(
     absl::string_view op_name, std::vector<DataSlice> inputs,
     internal::DataItem output_schema = internal::DataItem(),
     int edge_arg_index = 1,
     const std::optional<absl::Span<const int>>& primary_operand_indices =
-        std::nullopt);
+        std::nullopt,
+    internal::Executor* executor = nullptr);
 
 // koda_internal._to_data_slice operator.
 //
@@ -28,7 +28,9 @@
 #include "absl/types/span.h"
 #include "koladata/data_slice.h"
 #include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/internal/testing/matchers.h"
 #include "koladata/test_utils.h"
@@ -533,6 +535,62 @@ TEST(ArollaEval, SimpleAggOverEvalWithPrimaryOperands) {
   }
 }
 
+TEST(ArollaEval, ParallelSimpleAggEval) {
+  // Groups of different sizes, so that the chunks are not uniform.
+  std::vector<int64_t> group_sizes;
+  std::vector<arolla::OptionalValue<float>> values;
+  for (int64_t i = 0; values.size() < 300000; ++i) {
+    group_sizes.push_back(i % 100);
+    for (int64_t j = 0; j < group_sizes.back(); ++j) {
+      values.push_back(j % 7 == 0 ? arolla::OptionalValue<float>()
+                                  : static_cast<float>(i + j));
+    }
+  }
+  DataSlice::JaggedShape shape = *DataSlice::JaggedShape::FromEdges(
+      {EdgeFromSizes({static_cast<int64_t>(group_sizes.size())}),
+       EdgeFromSizes(group_sizes)});
+  ASSERT_OK_AND_ASSIGN(
+      DataSlice x,
+      DataSlice::Create(internal::DataSliceImpl::Create(
+                            arolla::CreateDenseArray<float>(values)),
+                        shape, internal::DataItem(schema::kFloat32)));
+  DataSlice unbiased = test::DataItem(true);
+  internal::ThreadPoolExecutor executor(4);
+  {
+    ASSERT_OK_AND_ASSIGN(auto expected, SimpleAggIntoEval("math.sum", {x}));
+    EXPECT_THAT(SimpleAggIntoEval("math.sum", {x},
+                                  /*output_schema=*/internal::DataItem(),
+                                  /*edge_arg_index=*/1,
+                                  /*primary_operand_indices=*/std::nullopt,
+                                  &executor),
+                IsOkAndHolds(IsEquivalentTo(expected)));
+  }
+  {
+    // Scalar non-primary operand.
+    ASSERT_OK_AND_ASSIGN(
+        auto expected, SimpleAggIntoEval("math.std", {x, unbiased},
+                                         /*output_schema=*/internal::DataItem(),
+                                         /*edge_arg_index=*/1,
+                                         /*primary_operand_indices=*/{{0}}));
+    EXPECT_THAT(SimpleAggIntoEval("math.std", {x, unbiased},
+                                  /*output_schema=*/internal::DataItem(),
+                                  /*edge_arg_index=*/1,
+                                  /*primary_operand_indices=*/{{0}},
+                                  &executor),
+                IsOkAndHolds(IsEquivalentTo(expected)));
+  }
+  {
+    ASSERT_OK_AND_ASSIGN(auto expected,
+                         SimpleAggOverEval("math.cum_sum", {x}));
+    EXPECT_THAT(SimpleAggOverEval("math.cum_sum", {x},
+                                  /*output_schema=*/internal::DataItem(),
+                                  /*edge_arg_index=*/1,
+                                  /*primary_operand_indices=*/std::nullopt,
+                                  &executor),
+                IsOkAndHolds(IsEquivalentTo(expected)));
+  }
+}
+
 TEST(ArollaEval, EvalExpr) {
   {
     // Success.
@@ -567,6 +625,40 @@ TEST(ArollaEval, EvalExpr) {
   }
 }
 
+TEST(ArollaEval, EvalExprRepeated) {
+  auto x_tv = arolla::TypedValue::FromValue(1);
+  auto y_tv = arolla::TypedValue::FromValue(2);
+  auto f_tv = arolla::TypedValue::FromValue(2.5f);
+  for (int i = 0; i < 3; ++i) {
+    // Same op name at the same address with different input types.
+    ASSERT_OK_AND_ASSIGN(auto int_result,
+                         EvalExpr("math.add", {x_tv.AsRef(), y_tv.AsRef()}));
+    EXPECT_THAT(int_result.As<int>(), IsOkAndHolds(3));
+    ASSERT_OK_AND_ASSIGN(auto float_result,
+                         EvalExpr("math.add", {f_tv.AsRef(), f_tv.AsRef()}));
+    EXPECT_THAT(float_result.As<float>(), IsOkAndHolds(5.0f));
+    // Different op names stored in the same buffer.
+    std::string op_name = "math.add";
+    ASSERT_OK_AND_ASSIGN(auto add_result,
+                         EvalExpr(op_name, {x_tv.AsRef(), y_tv.AsRef()}));
+    EXPECT_THAT(add_result.As<int>(), IsOkAndHolds(3));
+    op_name = "math.subtract";
+    ASSERT_OK_AND_ASSIGN(auto sub_result,
+                         EvalExpr(op_name, {x_tv.AsRef(), y_tv.AsRef()}));
+    EXPECT_THAT(sub_result.As<int>(), IsOkAndHolds(-1));
+  }
+  compiler_internal::ClearCache();
+  EXPECT_FALSE(compiler_internal::Lookup("math.add",
+                                         {x_tv.AsRef(), y_tv.AsRef()}));
+  ASSERT_OK_AND_ASSIGN(auto result,
+                       EvalExpr("math.add", {x_tv.AsRef(), y_tv.AsRef()}));
+  EXPECT_THAT(result.As<int>(), IsOkAndHolds(3));
+  // The shared cache is populated again after the thread-local one was
+  // invalidated.
+  EXPECT_TRUE(compiler_internal::Lookup("math.add",
+                                        {x_tv.AsRef(), y_tv.AsRef()}));
+}
+
 TEST(PrimitiveArollaSchemaTest, PrimitiveSchema_DataItem) {
   {
     // Empty and unknown.
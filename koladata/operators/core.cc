@@ -15,8 +15,10 @@
 #include "koladata/operators/core.h"
 
 #include <algorithm>
+#include <cmath>
 #include <cstddef>
 #include <cstdint>
+#include <limits>
 #include <memory>
 #include <optional>
 #include <tuple>
@@ -27,11 +29,14 @@
 
 #include "absl/algorithm/container.h"
 #include "absl/base/attributes.h"
+#include "absl/base/no_destructor.h"
 #include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
+#include "absl/container/inlined_vector.h"
 #include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/log/log.h"
+#include "absl/numeric/int128.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
@@ -51,15 +56,28 @@
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
 #include "koladata/internal/ellipsis.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/op_utils/approx_count_distinct.h"
 #include "koladata/internal/op_utils/at.h"
 #include "koladata/internal/op_utils/collapse.h"
 #include "koladata/internal/op_utils/deep_clone.h"
 #include "koladata/internal/op_utils/extract.h"
+#include "koladata/internal/op_utils/hash_join.h"
+#include "koladata/internal/op_utils/inverse_mapping.h"
 #include "koladata/internal/op_utils/itemid.h"
+#include "koladata/internal/op_utils/key_index.h"
 #include "koladata/internal/op_utils/reverse.h"
 #include "koladata/internal/op_utils/reverse_select.h"
+#include "koladata/internal/op_utils/segmented_sort.h"
 #include "koladata/internal/op_utils/select.h"
+#include "koladata/internal/op_utils/unique.h"
+#include "koladata/internal/op_utils/range_index.h"
+#include "koladata/internal/op_utils/value_index.h"
 #include "koladata/internal/schema_utils.h"
+#include "koladata/internal/scratch_arena.h"
+#include "koladata/internal/sharded_lru_cache.h"
+#include "koladata/internal/stable_fingerprint.h"
+#include "koladata/internal/types.h"
 #include "koladata/object_factories.h"
 #include "koladata/operators/arolla_bridge.h"
 #include "koladata/operators/utils.h"
@@ -83,6 +101,8 @@
 #include "arolla/qtype/tuple_qtype.h"
 #include "arolla/qtype/typed_slot.h"
 #include "arolla/qtype/unspecified_qtype.h"
+#include "arolla/util/fingerprint.h"
+#include "arolla/util/meta.h"
 #include "arolla/util/repr.h"
 #include "arolla/util/text.h"
 #include "arolla/util/unit.h"
@@ -225,20 +245,26 @@ absl::StatusOr<DataSlice> ConcatOrStackImpl(bool stack, int64_t ndim,
     return false;
   }();
 
+  const auto concat_arrays =
+      [&]<typename T>(absl::Span<const arolla::DenseArray<T>> arrays)
+      -> absl::StatusOr<
+          std::pair<arolla::DenseArray<T>, DataSlice::JaggedShape>> {
+    if (stack) {
+      return arolla::StackJaggedArraysAlongDimension(
+          arrays, absl::MakeConstSpan(shapes), rank - ndim);
+    } else {
+      return arolla::ConcatJaggedArraysAlongDimension(
+          arrays, absl::MakeConstSpan(shapes), rank - ndim);
+    }
+  };
+
   const auto process_arrays =
       [&]<typename T>(absl::Span<const arolla::DenseArray<T>> arrays)
       -> absl::StatusOr<DataSlice> {
     arolla::DenseArray<T> result_array;
     DataSlice::JaggedShape result_shape;
-    if (stack) {
-      ASSIGN_OR_RETURN(std::tie(result_array, result_shape),
-                       arolla::StackJaggedArraysAlongDimension(
-                           arrays, absl::MakeConstSpan(shapes), rank - ndim));
-    } else {
-      ASSIGN_OR_RETURN(std::tie(result_array, result_shape),
-                       arolla::ConcatJaggedArraysAlongDimension(
-                           arrays, absl::MakeConstSpan(shapes), rank - ndim));
-    }
+    ASSIGN_OR_RETURN(std::tie(result_array, result_shape),
+                     concat_arrays(arrays));
     return DataSlice::Create(
         internal::DataSliceImpl::Create(std::move(result_array)),
         std::move(result_shape), std::move(result_schema),
@@ -246,13 +272,78 @@ absl::StatusOr<DataSlice> ConcatOrStackImpl(bool stack, int64_t ndim,
   };
 
   if (has_mixed_result_dtype) {
-    std::vector<arolla::DenseArray<internal::DataItem>> arrays;
-    arrays.reserve(args.size());
+    // Concatenates the arrays of each dtype separately, using empty arrays for
+    // the inputs without values of that dtype, and combines the results, which
+    // have disjoint presence. This avoids converting every input to
+    // DenseArray<DataItem>.
+    absl::InlinedVector<arolla::QTypePtr, 4> dtypes;
     for (const auto& ds : args) {
-      arrays.push_back(
-          ds.impl<internal::DataSliceImpl>().AsDataItemDenseArray());
+      ds.impl<internal::DataSliceImpl>().VisitValues(
+          [&]<typename T>(const arolla::DenseArray<T>&) {
+            if (!absl::c_linear_search(dtypes, arolla::GetQType<T>())) {
+              dtypes.push_back(arolla::GetQType<T>());
+            }
+          });
     }
-    return process_arrays(absl::MakeConstSpan(arrays));
+    if (dtypes.empty()) {
+      // All inputs are empty and unknown, only the shape is computed.
+      std::vector<arolla::DenseArray<arolla::Unit>> arrays;
+      arrays.reserve(args.size());
+      for (const auto& ds : args) {
+        arrays.push_back(arolla::CreateEmptyDenseArray<arolla::Unit>(
+            ds.impl<internal::DataSliceImpl>().size()));
+      }
+      ASSIGN_OR_RETURN((auto [result_array, result_shape]),
+                       concat_arrays(absl::MakeConstSpan(arrays)));
+      return DataSlice::Create(
+          internal::DataSliceImpl::CreateEmptyAndUnknownType(
+              result_array.size()),
+          std::move(result_shape), std::move(result_schema),
+          std::move(result_db));
+    }
+    std::optional<internal::DataSliceImpl::Builder> builder;
+    std::optional<DataSlice::JaggedShape> result_shape;
+    absl::Status status = absl::OkStatus();
+    arolla::meta::foreach_type(internal::supported_types_list(), [&](auto tpe) {
+      using T = typename decltype(tpe)::type;
+      if (!status.ok() ||
+          !absl::c_linear_search(dtypes, arolla::GetQType<T>())) {
+        return;
+      }
+      std::vector<arolla::DenseArray<T>> arrays;
+      arrays.reserve(args.size());
+      for (const auto& ds : args) {
+        const auto& impl = ds.impl<internal::DataSliceImpl>();
+        std::optional<arolla::DenseArray<T>> array;
+        impl.VisitValues([&]<typename U>(const arolla::DenseArray<U>& values) {
+          if constexpr (std::is_same_v<U, T>) {
+            array = values;
+          }
+        });
+        arrays.push_back(array.has_value()
+                             ? *std::move(array)
+                             : arolla::CreateEmptyDenseArray<T>(impl.size()));
+      }
+      auto concat_result = concat_arrays(absl::MakeConstSpan(arrays));
+      if (!concat_result.ok()) {
+        status = std::move(concat_result).status();
+        return;
+      }
+      auto& [result_array, shape] = *concat_result;
+      if (!builder.has_value()) {
+        builder.emplace(result_array.size());
+        result_shape = std::move(shape);
+      }
+      builder->AddArray(std::move(result_array));
+    });
+    RETURN_IF_ERROR(status);
+    for (const auto& ds : args) {
+      builder->GetMutableAllocationIds().Insert(
+          ds.impl<internal::DataSliceImpl>().allocation_ids());
+    }
+    return DataSlice::Create(std::move(*builder).Build(),
+                             *std::move(result_shape), std::move(result_schema),
+                             std::move(result_db));
   } else {
     // Note: VisitValues calls its callback exactly once, because args[0] has
     // a single dtype.
@@ -283,6 +374,56 @@ absl::StatusOr<absl::string_view> GetAttrNameAsStr(const DataSlice& attr_name) {
   return attr_name.item().value<arolla::Text>().view();
 }
 
+class GetAttrsOperator : public arolla::QExprOperator {
+ public:
+  explicit GetAttrsOperator(absl::Span<const arolla::QTypePtr> input_types)
+      : arolla::QExprOperator(arolla::QExprOperatorSignature::Get(
+            input_types, arolla::MakeTupleQType(input_types.subspan(1)))) {}
+
+ private:
+  absl::StatusOr<std::unique_ptr<arolla::BoundOperator>> DoBind(
+      absl::Span<const arolla::TypedSlot> input_slots,
+      arolla::TypedSlot output_slot) const final {
+    DCHECK_EQ(input_slots.size(), output_slot.SubSlotCount() + 1);
+    auto obj_slot = input_slots[0].UnsafeToSlot<DataSlice>();
+    std::vector<arolla::FrameLayout::Slot<DataSlice>> attr_name_slots;
+    attr_name_slots.reserve(input_slots.size() - 1);
+    for (const auto& input_slot : input_slots.subspan(1)) {
+      attr_name_slots.push_back(input_slot.UnsafeToSlot<DataSlice>());
+    }
+    return arolla::MakeBoundOperator(
+        [obj_slot, attr_name_slots(std::move(attr_name_slots)),
+         output_slot = output_slot](arolla::EvaluationContext* ctx,
+                                    arolla::FramePtr frame) {
+          const DataSlice& obj = frame.Get(obj_slot);
+          std::vector<absl::string_view> attr_names;
+          attr_names.reserve(attr_name_slots.size());
+          for (const auto& attr_name_slot : attr_name_slots) {
+            ASSIGN_OR_RETURN(absl::string_view attr_name,
+                             GetAttrNameAsStr(frame.Get(attr_name_slot)),
+                             ctx->set_status(std::move(_)));
+            attr_names.push_back(attr_name);
+          }
+          auto attrs = obj.GetAttrs(attr_names);
+          if (!attrs.ok()) {
+            // Report the same error as separate kde.core.get_attr calls.
+            for (absl::string_view attr_name : attr_names) {
+              if (auto attr = obj.GetAttr(attr_name); !attr.ok()) {
+                ctx->set_status(std::move(attr).status());
+                return;
+              }
+            }
+            ctx->set_status(std::move(attrs).status());
+            return;
+          }
+          for (size_t i = 0; i < attrs->size(); ++i) {
+            frame.Set(output_slot.SubSlot(i).UnsafeToSlot<DataSlice>(),
+                      std::move((*attrs)[i]));
+          }
+        });
+  }
+};
+
 static constexpr size_t kUndefinedGroup = ~size_t{};
 
 struct DataItemPairHash {
@@ -298,14 +439,179 @@ struct DataItemPairEq {
   }
 };
 
+// Returns the index of the items of `keys` within the groups of its last
+// dimension. The indices of recently used keys are cached by fingerprint, so
+// that translating many slices against the same keys builds the index once.
+absl::StatusOr<std::shared_ptr<const internal::KeyIndex>> GetKeyIndex(
+    const DataSlice& keys) {
+  using Cache = internal::ShardedLruCache<
+      arolla::Fingerprint, std::shared_ptr<const internal::KeyIndex>>;
+  static absl::NoDestructor<Cache> cache(/*capacity=*/64);
+  const auto& impl = keys.impl<internal::DataSliceImpl>();
+  const auto& edge = keys.GetShape().edges().back();
+  arolla::Fingerprint fingerprint =
+      arolla::FingerprintHasher("::koladata::ops::GetKeyIndex")
+          .Combine(impl, edge.edge_values())
+          .Finish();
+  if (auto index = cache->LookupOrNull(fingerprint)) {
+    return index;
+  }
+  ASSIGN_OR_RETURN(auto index, internal::KeyIndex::Create(impl, edge));
+  return cache->Put(fingerprint, std::make_shared<const internal::KeyIndex>(
+                                     std::move(index)));
+}
+
+// Index of the `attr` values of the items of a flat DataSlice. Holds the
+// items, so that their buffers can not be reused by another DataSlice while
+// the index is cached under their identity.
+template <typename Index>
+struct AttrIndex {
+  internal::DataSliceImpl items;
+  std::shared_ptr<const Index> index;
+};
+
+// Returns the index of the `attr_name` values of the items of the flat `x`,
+// built by `build_index` from the values. Indices are only cached for deeply
+// immutable DataBags, whose attributes can not change. A fork of the DataBag
+// has a different fingerprint, so it never sees the indices of the original.
+// The cache is keyed by the identity of the buffers of `x` if possible, so
+// that repeated lookups in the same DataSlice are O(matches); otherwise by the
+// content of `x`.
+template <typename Index, typename BuildIndexFn>
+absl::StatusOr<std::shared_ptr<const AttrIndex<Index>>> GetAttrIndex(
+    const DataSlice& x, absl::string_view attr_name,
+    BuildIndexFn build_index) {
+  using Cache = internal::ShardedLruCache<
+      arolla::Fingerprint, std::shared_ptr<const AttrIndex<Index>>>;
+  static absl::NoDestructor<Cache> cache(/*capacity=*/64);
+  const auto& impl = x.impl<internal::DataSliceImpl>();
+  auto new_entry = [&]() -> absl::StatusOr<
+                             std::shared_ptr<const AttrIndex<Index>>> {
+    ASSIGN_OR_RETURN(auto values, x.GetAttr(attr_name));
+    ASSIGN_OR_RETURN(std::shared_ptr<const Index> index,
+                     build_index(values.impl<internal::DataSliceImpl>()));
+    return std::make_shared<const AttrIndex<Index>>(
+        AttrIndex<Index>{.items = impl, .index = std::move(index)});
+  };
+  const DataBagPtr& db = x.GetDb();
+  if (db == nullptr || !IsDeeplyImmutable(db)) {
+    return new_entry();
+  }
+  auto new_hasher = [&]() {
+    arolla::FingerprintHasher hasher("::koladata::ops::GetAttrIndex");
+    hasher.Combine(db->fingerprint(), attr_name, x.GetSchemaImpl(),
+                   impl.size());
+    return hasher;
+  };
+  std::optional<arolla::Fingerprint> identity_key;
+  if (impl.is_single_dtype() &&
+      impl.dtype() == arolla::GetQType<internal::ObjectId>()) {
+    const auto& array = impl.values<internal::ObjectId>();
+    arolla::FingerprintHasher hasher = new_hasher();
+    hasher.Combine(reinterpret_cast<uintptr_t>(array.values.span().data()),
+                   reinterpret_cast<uintptr_t>(array.bitmap.span().data()),
+                   array.bitmap_bit_offset);
+    identity_key = std::move(hasher).Finish();
+    if (auto index = cache->LookupOrNull(*identity_key)) {
+      return index;
+    }
+  }
+  arolla::FingerprintHasher hasher = new_hasher();
+  hasher.Combine(impl);
+  arolla::Fingerprint content_key = std::move(hasher).Finish();
+  auto index = cache->LookupOrNull(content_key);
+  if (index == nullptr) {
+    ASSIGN_OR_RETURN(index, new_entry());
+    index = cache->Put(content_key, std::move(index));
+  }
+  if (identity_key.has_value()) {
+    // The entry holds `impl`, which pins the buffers the key refers to.
+    index = cache->Put(*identity_key,
+                       std::make_shared<const AttrIndex<Index>>(
+                           AttrIndex<Index>{.items = impl,
+                                            .index = index->index}));
+  }
+  return index;
+}
+
+// Computes the ranks of `x` over its last dimension natively for the common
+// case of a numeric `x` without NaNs and a tie breaker that is either missing,
+// a scalar or an INT64 slice of the same shape that is present wherever `x`
+// is. Returns std::nullopt if the arolla implementation must be used instead.
+absl::StatusOr<std::optional<DataSlice>> NativeRank(
+    const DataSlice& x, const DataSlice* tie_breaker, bool descending,
+    bool dense) {
+  if (x.GetShape().rank() == 0 ||
+      !x.impl<internal::DataSliceImpl>().is_single_dtype()) {
+    return std::nullopt;
+  }
+  std::optional<arolla::DenseArray<int64_t>> tie_breaker_array;
+  if (tie_breaker != nullptr && tie_breaker->GetShape().rank() == 0) {
+    // A present scalar tie breaker doesn't affect the order.
+    if (!tie_breaker->item().holds_value<int64_t>()) {
+      return std::nullopt;
+    }
+  } else if (tie_breaker != nullptr) {
+    const auto& tie_breaker_impl = tie_breaker->impl<internal::DataSliceImpl>();
+    if (!ShapesAreEquivalent(tie_breaker->GetShape(), x.GetShape()) ||
+        !tie_breaker_impl.is_single_dtype() ||
+        tie_breaker_impl.dtype() != arolla::GetQType<int64_t>()) {
+      return std::nullopt;
+    }
+    tie_breaker_array = tie_breaker_impl.values<int64_t>();
+  }
+  absl::Span<const int64_t> split_points =
+      x.GetShape().edges().back().edge_values().values.span();
+  std::optional<arolla::DenseArray<int64_t>> ranks;
+  std::shared_ptr<internal::Executor> executor = internal::CurrentExecutor();
+  x.impl<internal::DataSliceImpl>().VisitValues(
+      [&]<typename T>(const arolla::DenseArray<T>& values) {
+        if constexpr (std::is_same_v<T, int> || std::is_same_v<T, int64_t> ||
+                      std::is_floating_point_v<T>) {
+          if (x.GetSchemaImpl() != schema::GetDType<T>()) {
+            return;
+          }
+          for (int64_t i = 0; i < values.size(); ++i) {
+            if (!values.present(i)) {
+              continue;
+            }
+            if constexpr (std::is_floating_point_v<T>) {
+              if (std::isnan(values.values[i])) {
+                return;
+              }
+            }
+            if (tie_breaker_array.has_value() &&
+                !tie_breaker_array->present(i)) {
+              return;
+            }
+          }
+          if (dense) {
+            ranks = internal::SegmentedDenseRank(values, split_points,
+                                                 descending, executor.get());
+          } else {
+            ranks = internal::SegmentedOrdinalRank(
+                values,
+                tie_breaker_array.has_value() ? &*tie_breaker_array : nullptr,
+                split_points, descending, executor.get());
+          }
+        }
+      });
+  if (!ranks.has_value()) {
+    return std::nullopt;
+  }
+  return DataSlice::Create(internal::DataSliceImpl::Create(*std::move(ranks)),
+                           x.GetShape(), internal::DataItem(schema::kInt64));
+}
+
 // Helper class to process key data slices and find group indices.
 class GroupByIndicesProcessor {
  public:
   GroupByIndicesProcessor(const arolla::DenseArrayEdge& edge_to_parent,
-                          bool sort)
+                          bool sort, internal::Executor* executor = nullptr)
       : split_points_(edge_to_parent.edge_values().values.span()),
         group_id_(edge_to_parent.child_size(), 0),
-        sort_(sort) {}
+        sort_(sort),
+        executor_(executor) {}
 
   // Update groups with a new key data slice. The shape must correspond to
   // the `edge_to_parent` passed to the constructor.
@@ -342,7 +648,7 @@ class GroupByIndicesProcessor {
     item_split_points.reserve(split_points_.size());
     item_split_points.push_back(0);
 
-    std::vector<size_t> group_id_count(group_id_.size(), 0);
+    internal::ScratchVector<size_t> group_id_count(group_id_.size(), 0);
     size_t output_index = 0;
     size_t local_group_prefix_sum = 0;
     for (size_t split_id = 1; split_id < split_points_.size(); ++split_id) {
@@ -488,32 +794,127 @@ class GroupByIndicesProcessor {
       key_to_group_id.erase(key_to_group_id.begin(), key_to_group_id.end());
       sorting_data.Clear();
       size_t start_group_id = new_group_id;
-      for (size_t i = begin; i < end; ++i) {
-        size_t& group = group_id_[i];
-        if (!value.present(i) || group == kUndefinedGroup) {
-          group = kUndefinedGroup;
-          continue;
-        }
-        auto [it, inserted] =
-            key_to_group_id.emplace(Key{group, value.values[i]}, new_group_id);
-        if (inserted) {
-          sorting_data.AddUnique(group, value.values[i]);
-          ++new_group_id;
+      if (end - begin >= kMinPartitionedSplitSize) {
+        ProcessSplitPartitioned<T, Map>(value, begin, end, new_group_id,
+                                        sorting_data);
+      } else {
+        for (size_t i = begin; i < end; ++i) {
+          size_t& group = group_id_[i];
+          if (!value.present(i) || group == kUndefinedGroup) {
+            group = kUndefinedGroup;
+            continue;
+          }
+          auto [it, inserted] = key_to_group_id.emplace(
+              Key{group, value.values[i]}, new_group_id);
+          if (inserted) {
+            sorting_data.AddUnique(group, value.values[i]);
+            ++new_group_id;
+          }
+          group_id_[i] = it->second;
         }
-        group_id_[i] = it->second;
       }
       sorting_data.Sort(start_group_id,
                         absl::MakeSpan(group_id_).subspan(begin, end - begin));
     }
   }
 
+  // Same as the inner loop of ProcessArray for the rows [begin, end), but for
+  // large splits. The rows are radix-partitioned by the top bits of the key
+  // hash, so that each partition is grouped with a small hash map and the
+  // partitions can be processed concurrently. Afterwards the groups get their
+  // final ids in the order of their first appearance, exactly as in the
+  // sequential version.
+  template <typename T, typename Map, typename SortingDataT>
+  void ProcessSplitPartitioned(const arolla::DenseArray<T>& value,
+                               size_t begin, size_t end, size_t& new_group_id,
+                               SortingDataT& sorting_data) {
+    using Key = typename Map::key_type;
+    constexpr int kPartitionBits = 6;
+    constexpr size_t kNumPartitions = size_t{1} << kPartitionBits;
+    constexpr uint8_t kNoPartition = kNumPartitions;
+    const size_t size = end - begin;
+
+    internal::ScratchVector<uint8_t> partition(size);
+    std::vector<size_t> partition_offsets(kNumPartitions + 1, 0);
+    typename Map::hasher hasher;
+    for (size_t i = 0; i < size; ++i) {
+      size_t& group = group_id_[begin + i];
+      if (!value.present(begin + i) || group == kUndefinedGroup) {
+        group = kUndefinedGroup;
+        partition[i] = kNoPartition;
+        continue;
+      }
+      partition[i] = static_cast<uint8_t>(
+          hasher(Key{group, value.values[begin + i]}) >>
+          (std::numeric_limits<size_t>::digits - kPartitionBits));
+      ++partition_offsets[partition[i] + 1];
+    }
+    for (size_t p = 0; p < kNumPartitions; ++p) {
+      partition_offsets[p + 1] += partition_offsets[p];
+    }
+    // Stable counting sort: the rows keep their order within a partition.
+    internal::ScratchVector<size_t> rows(partition_offsets.back());
+    {
+      std::vector<size_t> next = partition_offsets;
+      for (size_t i = 0; i < size; ++i) {
+        if (partition[i] != kNoPartition) {
+          rows[next[partition[i]]++] = i;
+        }
+      }
+    }
+
+    internal::ScratchVector<size_t> local_group(size);
+    std::vector<size_t> partition_group_count(kNumPartitions + 1, 0);
+    // The tasks never fail.
+    internal::ParallelFor(
+        executor_, kNumPartitions,
+        [&](int64_t p) -> absl::Status {
+          Map key_to_local_group;
+          for (size_t j = partition_offsets[p]; j < partition_offsets[p + 1];
+               ++j) {
+            const size_t i = rows[j];
+            auto [it, inserted] = key_to_local_group.emplace(
+                Key{group_id_[begin + i], value.values[begin + i]},
+                key_to_local_group.size());
+            local_group[i] = it->second;
+          }
+          partition_group_count[p + 1] = key_to_local_group.size();
+          return absl::OkStatus();
+        })
+        .IgnoreError();
+    for (size_t p = 0; p < kNumPartitions; ++p) {
+      partition_group_count[p + 1] += partition_group_count[p];
+    }
+
+    internal::ScratchVector<size_t> final_group(partition_group_count.back(),
+                                                kUndefinedGroup);
+    for (size_t i = 0; i < size; ++i) {
+      if (partition[i] == kNoPartition) {
+        continue;
+      }
+      size_t& group = final_group[partition_group_count[partition[i]] +
+                                  local_group[i]];
+      if (group == kUndefinedGroup) {
+        group = new_group_id++;
+        sorting_data.AddUnique(group_id_[begin + i], value.values[begin + i]);
+      }
+      group_id_[begin + i] = group;
+    }
+  }
+
+  // Splits smaller than this are grouped with a single hash map.
+  static constexpr size_t kMinPartitionedSplitSize = 1 << 16;
+
   absl::Span<const int64_t> split_points_;
-  std::vector<size_t> group_id_;
+  // Temporaries of the operator, so they are allocated in the scratch arena.
+  internal::ScratchVector<size_t> group_id_;
   bool sort_;
+  internal::Executor* executor_;
 };
 
 absl::StatusOr<DataSlice> GroupByIndicesImpl(
-    absl::Span<const DataSlice* const> slices, bool sort) {
+    absl::Span<const DataSlice* const> slices, bool sort,
+    internal::Executor* executor) {
   if (slices.empty()) {
     return absl::InvalidArgumentError("requires at least 1 argument");
   }
@@ -522,11 +923,13 @@ absl::StatusOr<DataSlice> GroupByIndicesImpl(
     return absl::FailedPreconditionError(
         "group_by is not supported for scalar data");
   }
+  // The temporaries of the processor are released at the end of the call.
+  internal::ScopedScratchArena scratch_arena;
   GroupByIndicesProcessor processor(shape.edges().back(),
-                                    /*sort=*/sort);
+                                    /*sort=*/sort, executor);
   for (const auto* const ds_ptr : slices) {
     const auto& ds = *ds_ptr;
-    if (!ds.GetShape().IsEquivalentTo(shape)) {
+    if (!ShapesAreEquivalent(ds.GetShape(), shape)) {
       return absl::FailedPreconditionError(
           "all arguments must have the same shape");
     }
@@ -970,6 +1373,29 @@ EnrichedOrUpdatedOperatorFamily::DoGetOperator(
 }
 
 absl::StatusOr<DataSlice> InverseMapping(const DataSlice& x) {
+  if (x.GetShape().rank() != 0 &&
+      x.impl<internal::DataSliceImpl>().is_single_dtype()) {
+    absl::Span<const int64_t> split_points =
+        x.GetShape().edges().back().edge_values().values.span();
+    std::optional<absl::StatusOr<internal::DataSliceImpl>> result;
+    x.impl<internal::DataSliceImpl>().VisitValues(
+        [&]<typename T>(const arolla::DenseArray<T>& values) {
+          if constexpr (std::is_same_v<T, int> || std::is_same_v<T, int64_t>) {
+            auto inverse = internal::SegmentedInverseMapping(
+                values, split_points, internal::CurrentExecutor().get());
+            if (inverse.ok()) {
+              result = internal::DataSliceImpl::Create(*std::move(inverse));
+            } else {
+              result = std::move(inverse).status();
+            }
+          }
+        });
+    if (result.has_value()) {
+      ASSIGN_OR_RETURN(auto impl, *std::move(result));
+      return DataSlice::Create(std::move(impl), x.GetShape(),
+                               x.GetSchemaImpl());
+    }
+  }
   return SimpleAggOverEval("array.inverse_mapping", {x});
 }
 
@@ -985,6 +1411,13 @@ absl::StatusOr<DataSlice> OrdinalRank(const DataSlice& x,
   ASSIGN_OR_RETURN(
       auto tie_breaker_int64,
       CastToNarrow(tie_breaker, internal::DataItem(schema::kInt64)));
+  ASSIGN_OR_RETURN(auto native_res,
+                   NativeRank(x, &tie_breaker_int64,
+                              descending.item().value<bool>(),
+                              /*dense=*/false));
+  if (native_res.has_value()) {
+    return *std::move(native_res);
+  }
   return SimpleAggOverEval(
       "array.ordinal_rank", {x, std::move(tie_breaker_int64), descending},
       /*output_schema=*/internal::DataItem(schema::kInt64), /*edge_index=*/2);
@@ -998,11 +1431,191 @@ absl::StatusOr<DataSlice> DenseRank(const DataSlice& x,
         "expected `descending` to be a scalar boolean value, got %s",
         arolla::Repr(descending)));
   }
+  ASSIGN_OR_RETURN(auto native_res,
+                   NativeRank(x, /*tie_breaker=*/nullptr,
+                              descending.item().value<bool>(),
+                              /*dense=*/true));
+  if (native_res.has_value()) {
+    return *std::move(native_res);
+  }
   return SimpleAggOverEval(
       "array.dense_rank", {x, descending},
       /*output_schema=*/internal::DataItem(schema::kInt64));
 }
 
+absl::StatusOr<DataSlice> TopKIndices(const DataSlice& x, const DataSlice& k,
+                                      const DataSlice& descending) {
+  const DataSlice::JaggedShape& shape = x.GetShape();
+  if (shape.rank() == 0) {
+    return absl::InvalidArgumentError("expected rank(x) > 0");
+  }
+  if (descending.GetShape().rank() != 0 ||
+      !descending.item().holds_value<bool>()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected `descending` to be a scalar boolean value, got %s",
+        arolla::Repr(descending)));
+  }
+  const bool is_descending = descending.item().value<bool>();
+  DataSlice::JaggedShape parent_shape = shape.RemoveDims(shape.rank() - 1);
+  auto k_int64 = CastToNarrow(k, internal::DataItem(schema::kInt64));
+  if (!k_int64.ok()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected `k` to be an integer DataSlice, got %s", arolla::Repr(k)));
+  }
+  if (!ShapeIsBroadcastableTo(k_int64->GetShape(), parent_shape)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "the shape of `k` must be broadcastable to the shape of `x` without "
+        "its last dimension, got %s",
+        arolla::Repr(k)));
+  }
+  ASSIGN_OR_RETURN(auto expanded_k, BroadcastToShape(*k_int64, parent_shape));
+  arolla::DenseArray<int64_t> k_array;
+  if (expanded_k.GetShape().rank() == 0) {
+    k_array = arolla::CreateDenseArray<int64_t>(
+        {expanded_k.item().has_value()
+             ? arolla::OptionalValue<int64_t>(
+                   expanded_k.item().value<int64_t>())
+             : arolla::OptionalValue<int64_t>()});
+  } else if (expanded_k.slice().is_empty_and_unknown()) {
+    k_array = arolla::CreateEmptyDenseArray<int64_t>(expanded_k.size());
+  } else {
+    k_array = expanded_k.slice().values<int64_t>();
+  }
+
+  absl::Span<const int64_t> split_points =
+      shape.edges().back().edge_values().values.span();
+  std::optional<internal::SegmentedTopKResult> top_k;
+  if (x.slice().is_single_dtype()) {
+    std::shared_ptr<internal::Executor> executor = internal::CurrentExecutor();
+    x.slice().VisitValues([&]<typename T>(const arolla::DenseArray<T>& values) {
+      if constexpr (std::is_same_v<T, int> || std::is_same_v<T, int64_t> ||
+                    std::is_floating_point_v<T>) {
+        if (x.GetSchemaImpl() == schema::GetDType<T>()) {
+          top_k = internal::SegmentedTopK(values, split_points, k_array,
+                                          is_descending, executor.get());
+        }
+      }
+    });
+  }
+  if (!top_k.has_value()) {
+    // Other types are ranked by kde.core._ordinal_rank, which sorts the groups
+    // completely.
+    ASSIGN_OR_RETURN(
+        auto ranks,
+        OrdinalRank(x,
+                    *DataSlice::Create(internal::DataItem(int64_t{0}),
+                                       internal::DataItem(schema::kInt64)),
+                    descending));
+    const internal::DataSliceImpl& ranks_impl = ranks.slice();
+    top_k = internal::SegmentedTopKFromRanks(
+        ranks_impl.is_empty_and_unknown()
+            ? arolla::CreateEmptyDenseArray<int64_t>(ranks.size())
+            : ranks_impl.values<int64_t>(),
+        split_points, k_array);
+  }
+  ASSIGN_OR_RETURN(auto new_shape,
+                   parent_shape.AddDims(
+                       {arolla::DenseArrayEdge::UnsafeFromSplitPoints(
+                           std::move(top_k->split_points))}));
+  return DataSlice::Create(
+      internal::DataSliceImpl::Create(std::move(top_k->positions)),
+      std::move(new_shape), internal::DataItem(schema::kInt64));
+}
+
+absl::StatusOr<DataSlice> JoinIndices(const DataSlice& left_keys,
+                                      const DataSlice& right_keys,
+                                      const DataSlice& left_join) {
+  if (left_join.GetShape().rank() != 0 ||
+      !left_join.item().holds_value<bool>()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected `left_join` to be a scalar boolean value, got %s",
+        arolla::Repr(left_join)));
+  }
+  auto as_impl = [](const DataSlice& ds) {
+    return ds.GetShape().rank() == 0
+               ? internal::DataSliceImpl::Create(1, ds.item())
+               : ds.slice();
+  };
+  std::shared_ptr<internal::Executor> executor = internal::CurrentExecutor();
+  ASSIGN_OR_RETURN(
+      auto join,
+      internal::HashJoin(as_impl(left_keys), as_impl(right_keys),
+                         left_join.item().value<bool>()
+                             ? internal::JoinType::kLeft
+                             : internal::JoinType::kInner,
+                         executor.get()));
+  ASSIGN_OR_RETURN(auto new_shape,
+                   left_keys.GetShape().AddDims(
+                       {arolla::DenseArrayEdge::UnsafeFromSplitPoints(
+                           arolla::DenseArray<int64_t>{
+                               std::move(join.split_points)})}));
+  return DataSlice::Create(
+      internal::DataSliceImpl::Create(std::move(join.right_positions)),
+      std::move(new_shape), internal::DataItem(schema::kInt64));
+}
+
+absl::StatusOr<DataSlice> AggApproxCountDistinct(const DataSlice& x,
+                                                 const DataSlice& precision) {
+  const DataSlice::JaggedShape& shape = x.GetShape();
+  if (shape.rank() == 0) {
+    return absl::InvalidArgumentError("expected rank(x) > 0");
+  }
+  auto precision_value = ToArollaScalar<int64_t>(precision);
+  if (!precision_value.ok() ||
+      *precision_value < internal::kMinHyperLogLogPrecision ||
+      *precision_value > internal::kMaxHyperLogLogPrecision) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected `precision` to be a scalar integer in [%d, %d], got %s",
+        internal::kMinHyperLogLogPrecision,
+        internal::kMaxHyperLogLogPrecision, arolla::Repr(precision)));
+  }
+  // Hashes are DataItem::StableFingerprint folded to 64 bits.
+  const internal::StableFingerprintHasher item_hasher("data_item");
+  auto fold = [](const arolla::Fingerprint& fingerprint) -> uint64_t {
+    return absl::Uint128Low64(fingerprint.value) ^
+           absl::Uint128High64(fingerprint.value);
+  };
+  absl::Span<const int64_t> split_points =
+      shape.edges().back().edge_values().values.span();
+  std::shared_ptr<internal::Executor> executor = internal::CurrentExecutor();
+  arolla::DenseArray<int64_t> counts;
+  const internal::DataSliceImpl& impl = x.slice();
+  if (impl.is_empty_and_unknown()) {
+    counts = arolla::CreateConstDenseArray<int64_t>(split_points.size() - 1, 0);
+  } else if (impl.is_single_dtype()) {
+    impl.VisitValues([&]<typename T>(const arolla::DenseArray<T>& values) {
+      auto get_hash = [&](int64_t row) -> std::optional<uint64_t> {
+        if (!values.present(row)) {
+          return std::nullopt;
+        }
+        if constexpr (std::is_arithmetic_v<T> ||
+                      std::is_same_v<T, internal::ObjectId>) {
+          internal::StableFingerprintHasher hasher = item_hasher;
+          return fold(std::move(hasher).Combine(values.values[row]).Finish());
+        } else {
+          return fold(internal::DataItem(T(values.values[row]))
+                          .StableFingerprint());
+        }
+      };
+      counts = internal::SegmentedApproxCountDistinct(
+          split_points, *precision_value, get_hash, executor.get());
+    });
+  } else {
+    auto get_hash = [&](int64_t row) -> std::optional<uint64_t> {
+      internal::DataItem item = impl[row];
+      if (!item.has_value()) {
+        return std::nullopt;
+      }
+      return fold(item.StableFingerprint());
+    };
+    counts = internal::SegmentedApproxCountDistinct(
+        split_points, *precision_value, get_hash, executor.get());
+  }
+  return DataSlice::Create(internal::DataSliceImpl::Create(std::move(counts)),
+                           shape.RemoveDims(shape.rank() - 1),
+                           internal::DataItem(schema::kInt64));
+}
+
 absl::StatusOr<arolla::OperatorPtr> AlignOperatorFamily::DoGetOperator(
     absl::Span<const arolla::QTypePtr> input_types,
     arolla::QTypePtr output_type) const {
@@ -1144,6 +1757,23 @@ absl::StatusOr<DataSlice> GetAttrWithDefault(const DataSlice& obj,
   return obj.GetAttrWithDefault(attr_name_str, default_value);
 }
 
+absl::StatusOr<arolla::OperatorPtr> GetAttrsOperatorFamily::DoGetOperator(
+    absl::Span<const arolla::QTypePtr> input_types,
+    arolla::QTypePtr output_type) const {
+  if (input_types.size() < 2) {
+    return absl::InvalidArgumentError("requires at least 2 arguments");
+  }
+  for (const auto& args_type : input_types) {
+    if (args_type != arolla::GetQType<DataSlice>()) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "arguments must be DataSlices, but got ", args_type->name()));
+    }
+  }
+  return arolla::EnsureOutputQTypeMatches(
+      std::make_shared<GetAttrsOperator>(input_types), input_types,
+      output_type);
+}
+
 absl::StatusOr<arolla::OperatorPtr> WithAttrsOperatorFamily::DoGetOperator(
     absl::Span<const arolla::QTypePtr> input_types,
     arolla::QTypePtr output_type) const {
@@ -1162,12 +1792,20 @@ absl::StatusOr<arolla::OperatorPtr> WithAttrsOperatorFamily::DoGetOperator(
 
 absl::StatusOr<DataSlice> GroupByIndices(
     absl::Span<const DataSlice* const> slices) {
-  return GroupByIndicesImpl(slices, /*sort=*/false);
+  return GroupByIndicesImpl(slices, /*sort=*/false,
+                            internal::CurrentExecutor().get());
 }
 
 absl::StatusOr<DataSlice> GroupByIndicesSorted(
     absl::Span<const DataSlice* const> slices) {
-  return GroupByIndicesImpl(slices, /*sort=*/true);
+  return GroupByIndicesImpl(slices, /*sort=*/true,
+                            internal::CurrentExecutor().get());
+}
+
+absl::StatusOr<DataSlice> ParallelGroupByIndices(
+    absl::Span<const DataSlice* const> slices, bool sort,
+    internal::Executor* executor) {
+  return GroupByIndicesImpl(slices, sort, executor);
 }
 
 absl::StatusOr<DataSlice> Unique(const DataSlice& x, const DataSlice& sort) {
@@ -1185,83 +1823,62 @@ absl::StatusOr<DataSlice> Unique(const DataSlice& x, const DataSlice& sort) {
 
   const auto& split_points =
       x.GetShape().edges().back().edge_values().values.span();
-  arolla::DenseArrayBuilder<int64_t> split_points_builder(split_points.size());
-  split_points_builder.Set(0, 0);
-
-  auto process_values =
-      [&]<class T, class Map>(
-          const arolla::DenseArray<T>& values,
-          Map& map) -> absl::StatusOr<internal::DataSliceImpl> {
-    std::vector<arolla::view_type_t<T>> unique_values;
-    unique_values.reserve(values.size());
-    map.reserve(values.size());
-
-    for (size_t split_id = 1; split_id < split_points.size(); ++split_id) {
-      size_t begin = split_points[split_id - 1];
-      size_t end = split_points[split_id];
-      size_t unique_values_group_begin = unique_values.size();
-      for (size_t i = begin; i < end; ++i) {
-        if (!values.present(i)) {
-          continue;
-        }
-        // We reuse the map to minimize amount of successful inserts.
-        auto [it, inserted] = map.emplace(values.values[i], split_id);
-        if (inserted || it->second != split_id) {
-          unique_values.push_back(values.values[i]);
-          it->second = split_id;
-        }
-      }
-      split_points_builder.Set(split_id, unique_values.size());
-      if (sort_bool) {
-        if constexpr (internal::IsKodaScalarSortable<T>()) {
-          std::sort(unique_values.begin() + unique_values_group_begin,
-                    unique_values.end());
-        } else {
-          return absl::FailedPreconditionError(absl::StrCat(
-              "sort is not supported for ", arolla::GetQType<T>()->name()));
-        }
+  internal::Executor* executor = internal::CurrentExecutor().get();
+
+  // Returns the values at the first occurrence rows, and their split points.
+  auto process_values = [&]<class T>(const arolla::DenseArray<T>& values)
+      -> absl::StatusOr<
+          std::pair<internal::DataSliceImpl, std::vector<int64_t>>> {
+    internal::SegmentedUniqueResult unique =
+        internal::SegmentedUnique(values, split_points, executor);
+    if (sort_bool) {
+      if constexpr (internal::IsKodaScalarSortable<T>()) {
+        internal::SortUniqueRows(values, unique, executor);
+      } else {
+        return absl::FailedPreconditionError(absl::StrCat(
+            "sort is not supported for ", arolla::GetQType<T>()->name()));
       }
     }
-    internal::DataSliceImpl::Builder builder(unique_values.size());
-    for (size_t i = 0; i < unique_values.size(); ++i) {
+    internal::DataSliceImpl::Builder builder(unique.rows.size());
+    for (size_t i = 0; i < unique.rows.size(); ++i) {
+      const auto& value = values.values[unique.rows[i]];
       if constexpr (std::is_same_v<T, internal::DataItem>) {
-        builder.Insert(i, unique_values[i]);
+        builder.Insert(i, value);
       } else {
-        builder.Insert(i, internal::DataItem::View<T>(unique_values[i]));
+        builder.Insert(i, internal::DataItem::View<T>(value));
       }
     }
-    return std::move(builder).Build();
+    return std::make_pair(std::move(builder).Build(),
+                          std::move(unique.split_points));
   };
 
-  absl::StatusOr<internal::DataSliceImpl> res_impl;
+  absl::StatusOr<std::pair<internal::DataSliceImpl, std::vector<int64_t>>>
+      res;
   if (x.slice().is_empty_and_unknown()) {
-    res_impl = internal::DataSliceImpl::CreateEmptyAndUnknownType(0);
-    for (size_t split_id = 1; split_id < split_points.size(); ++split_id) {
-      split_points_builder.Set(split_id, 0);
-    }
+    res = std::make_pair(internal::DataSliceImpl::CreateEmptyAndUnknownType(0),
+                         std::vector<int64_t>(split_points.size(), 0));
   } else if (x.slice().is_mixed_dtype()) {
-    absl::flat_hash_map<internal::DataItem, size_t, internal::DataItem::Hash,
-                        internal::DataItem::Eq>
-        map;
-    res_impl = process_values(x.slice().AsDataItemDenseArray(), map);
+    res = process_values(x.slice().AsDataItemDenseArray());
   } else {
     // TODO: Remove this unused builder. It prevents from a linker
     // error that is not yet explained.
     ABSL_ATTRIBUTE_UNUSED arolla::DenseArrayBuilder<arolla::expr::ExprQuote>
         unused(0);
     x.slice().VisitValues([&]<class T>(const arolla::DenseArray<T>& values) {
-      absl::flat_hash_map<arolla::view_type_t<T>, size_t> map;
-      res_impl = process_values(values, map);
+      res = process_values(values);
     });
   }
 
-  RETURN_IF_ERROR(res_impl.status());
+  RETURN_IF_ERROR(res.status());
+  auto& [res_impl, res_split_points] = *res;
   ASSIGN_OR_RETURN(auto new_shape,
                    x.GetShape()
                        .RemoveDims(/*from=*/x.GetShape().rank() - 1)
                        .AddDims({arolla::DenseArrayEdge::UnsafeFromSplitPoints(
-                           std::move(split_points_builder).Build())}));
-  return DataSlice::Create(*std::move(res_impl), std::move(new_shape),
+                           arolla::DenseArray<int64_t>{
+                               arolla::Buffer<int64_t>::Create(
+                                   std::move(res_split_points))})}));
+  return DataSlice::Create(std::move(res_impl), std::move(new_shape),
                            x.GetSchemaImpl(), x.GetDb());
 }
 
@@ -1291,6 +1908,17 @@ absl::StatusOr<DataSlice> ItemIdBits(const DataSlice& ds,
   });
 }
 
+absl::StatusOr<DataSlice> ItemIdHash(const DataSlice& ds) {
+  if (!schema::VerifySchemaForItemIds(ds.GetSchemaImpl())) {
+    return absl::InvalidArgumentError(
+        "the schema of the ds must be itemid, any, or object");
+  }
+  return ds.VisitImpl([&](const auto& impl) {
+    return DataSlice::Create(internal::ItemIdHash()(impl), ds.GetShape(),
+                             internal::DataItem(schema::kInt64), ds.GetDb());
+  });
+}
+
 absl::StatusOr<DataSlice> ListSize(const DataSlice& lists) {
   const auto& db = lists.GetDb();
   if (db == nullptr) {
@@ -1507,7 +2135,7 @@ absl::StatusOr<DataSlice> Translate(const DataSlice& keys_to,
                                     const DataSlice& keys_from,
                                     const DataSlice& values_from) {
   const auto& from_shape = keys_from.GetShape();
-  if (!from_shape.IsEquivalentTo(values_from.GetShape())) {
+  if (!ShapesAreEquivalent(from_shape, values_from.GetShape())) {
     return absl::InvalidArgumentError(
         "keys_from and values_from must have the same shape");
   }
@@ -1519,8 +2147,8 @@ absl::StatusOr<DataSlice> Translate(const DataSlice& keys_to,
   }
 
   const auto shape_without_last_dim = to_shape.RemoveDims(to_shape.rank() - 1);
-  if (!from_shape.RemoveDims(from_shape.rank() - 1)
-           .IsEquivalentTo(shape_without_last_dim)) {
+  if (!ShapesAreEquivalent(from_shape.RemoveDims(from_shape.rank() - 1),
+                           shape_without_last_dim)) {
     return absl::InvalidArgumentError(
         "keys_from and keys_to must have the same dimensions except the last "
         "one");
@@ -1531,12 +2159,14 @@ absl::StatusOr<DataSlice> Translate(const DataSlice& keys_to,
         "keys_from and keys_to must have the same schema");
   }
 
-  ASSIGN_OR_RETURN(auto false_item,
-                   DataSlice::Create(internal::DataItem(false),
-                                     DataSlice::JaggedShape::Empty(),
-                                     internal::DataItem(schema::kBool)));
-  ASSIGN_OR_RETURN(auto unique_keys, Unique(keys_from, false_item));
-  if (keys_from.present_count() != unique_keys.present_count()) {
+  RETURN_IF_ERROR(schema::VerifyDictKeySchema(keys_from.GetSchemaImpl()));
+  ASSIGN_OR_RETURN(auto key_index, GetKeyIndex(keys_from));
+  if (key_index->has_duplicates()) {
+    ASSIGN_OR_RETURN(auto false_item,
+                     DataSlice::Create(internal::DataItem(false),
+                                       DataSlice::JaggedShape::Empty(),
+                                       internal::DataItem(schema::kBool)));
+    ASSIGN_OR_RETURN(auto unique_keys, Unique(keys_from, false_item));
     return absl::InvalidArgumentError(absl::StrFormat(
         "keys_from must be unique within each group of the last dimension: "
         "original DataSlice %s vs DataSlice after dedup %s. Consider using "
@@ -1544,13 +2174,108 @@ absl::StatusOr<DataSlice> Translate(const DataSlice& keys_to,
         arolla::Repr(keys_from), arolla::Repr(unique_keys)));
   }
 
-  auto temp_db = DataBag::Empty();
   ASSIGN_OR_RETURN(
-      auto lookup,
-      CreateDictShaped(temp_db, shape_without_last_dim,
-                       keys_from.WithDb(nullptr), values_from.WithDb(nullptr)));
-  ASSIGN_OR_RETURN(auto res, lookup.GetFromDict(keys_to));
-  return res.WithDb(values_from.GetDb());
+      auto positions,
+      key_index->Find(keys_to.impl<internal::DataSliceImpl>(),
+                      to_shape.edges().back()));
+  const auto& values_impl = values_from.impl<internal::DataSliceImpl>();
+  ASSIGN_OR_RETURN(
+      auto values_edge,
+      arolla::DenseArrayEdge::FromUniformGroups(1, values_impl.size()));
+  ASSIGN_OR_RETURN(auto res_impl, internal::AtOp(values_impl, positions,
+                                                 values_edge, std::nullopt));
+  return DataSlice::Create(std::move(res_impl), to_shape,
+                           values_from.GetSchemaImpl(), values_from.GetDb());
+}
+
+namespace {
+
+// Returns `x` as a flat DataSlice, wrapping a DataItem into a slice of size 1.
+absl::StatusOr<DataSlice> FlattenForLookup(const DataSlice& x) {
+  internal::DataSliceImpl items =
+      x.GetShape().rank() == 0
+          ? internal::DataSliceImpl::Create(/*size=*/1, x.item())
+          : x.impl<internal::DataSliceImpl>();
+  return DataSlice::Create(
+      items, DataSlice::JaggedShape::FlatFromSize(items.size()),
+      x.GetSchemaImpl(), x.GetDb());
+}
+
+// Returns the 1D DataSlice of the items of the flat `x` at `positions`.
+absl::StatusOr<DataSlice> GatherLookupResult(
+    const DataSlice& flat_x, absl::Span<const int64_t> positions) {
+  const auto& items = flat_x.impl<internal::DataSliceImpl>();
+  ASSIGN_OR_RETURN(auto items_edge,
+                   arolla::DenseArrayEdge::FromUniformGroups(1, items.size()));
+  ASSIGN_OR_RETURN(
+      auto result_impl,
+      internal::AtOp(items,
+                     arolla::CreateFullDenseArray(std::vector<int64_t>(
+                         positions.begin(), positions.end())),
+                     items_edge, std::nullopt));
+  return DataSlice::Create(
+      std::move(result_impl),
+      DataSlice::JaggedShape::FlatFromSize(positions.size()),
+      flat_x.GetSchemaImpl(), flat_x.GetDb());
+}
+
+}  // namespace
+
+absl::StatusOr<DataSlice> LookupByAttr(const DataSlice& x,
+                                       const DataSlice& attr_name,
+                                       const DataSlice& value) {
+  ASSIGN_OR_RETURN(absl::string_view attr_name_str,
+                   GetAttrNameAsStr(attr_name));
+  if (value.GetShape().rank() != 0) {
+    return absl::InvalidArgumentError(
+        absl::StrCat("kd.lookup_by_attr: value must be a DataItem, got: ",
+                     arolla::Repr(value)));
+  }
+  ASSIGN_OR_RETURN(auto flat_x, FlattenForLookup(x));
+  ASSIGN_OR_RETURN(
+      auto index,
+      GetAttrIndex<internal::ValueIndex>(
+          flat_x, attr_name_str,
+          [](const internal::DataSliceImpl& values)
+              -> absl::StatusOr<std::shared_ptr<const internal::ValueIndex>> {
+            return std::make_shared<const internal::ValueIndex>(values);
+          }));
+  return GatherLookupResult(flat_x, index->index->Find(value.item()));
+}
+
+absl::StatusOr<DataSlice> LookupByAttrRange(const DataSlice& x,
+                                            const DataSlice& attr_name,
+                                            const DataSlice& lower,
+                                            const DataSlice& upper) {
+  ASSIGN_OR_RETURN(absl::string_view attr_name_str,
+                   GetAttrNameAsStr(attr_name));
+  for (const DataSlice* bound : {&lower, &upper}) {
+    if (bound->GetShape().rank() != 0) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "kd.lookup_by_attr_range: bounds must be DataItems, got: ",
+          arolla::Repr(*bound)));
+    }
+  }
+  ASSIGN_OR_RETURN(auto flat_x, FlattenForLookup(x));
+  auto add_context = [](absl::Status status) {
+    return absl::Status(status.code(), absl::StrCat("kd.lookup_by_attr_range: ",
+                                                    status.message()));
+  };
+  ASSIGN_OR_RETURN(
+      auto index,
+      GetAttrIndex<internal::RangeIndex>(
+          flat_x, attr_name_str,
+          [&](const internal::DataSliceImpl& values)
+              -> absl::StatusOr<std::shared_ptr<const internal::RangeIndex>> {
+            ASSIGN_OR_RETURN(auto index, internal::RangeIndex::Create(values),
+                             _.With(add_context));
+            return std::make_shared<const internal::RangeIndex>(
+                std::move(index));
+          }));
+  ASSIGN_OR_RETURN(std::vector<int64_t> positions,
+                   index->index->Find(lower.item(), upper.item()),
+                   _.With(add_context));
+  return GatherLookupResult(flat_x, positions);
 }
 
 absl::StatusOr<arolla::OperatorPtr> UuidOperatorFamily::DoGetOperator(
@@ -21,6 +21,7 @@
 #include "absl/types/span.h"
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
+#include "koladata/internal/executor.h"
 #include "arolla/qexpr/operators.h"
 #include "arolla/qtype/qtype.h"
 
@@ -72,6 +73,35 @@ absl::StatusOr<DataSlice> OrdinalRank(const DataSlice& x,
 absl::StatusOr<DataSlice> DenseRank(const DataSlice& x,
                                     const DataSlice& descending);
 
+// kde.core._top_k_indices.
+//
+// Returns the positions of the first `k` items of each group of the last
+// dimension of `x` in the order of kde.core.ordinal_rank, as INT64 positions
+// with a new last dimension. Numeric values are selected without sorting the
+// groups completely.
+absl::StatusOr<DataSlice> TopKIndices(const DataSlice& x, const DataSlice& k,
+                                      const DataSlice& descending);
+
+// kde.core._join_indices.
+//
+// Returns the positions of the items of the flattened `right_keys` equal to
+// each item of `left_keys`, as INT64 positions with a new last dimension
+// appended to the shape of `left_keys`. If `left_join` is true, the items of
+// `left_keys` without matches get a single missing position instead of an
+// empty group.
+absl::StatusOr<DataSlice> JoinIndices(const DataSlice& left_keys,
+                                      const DataSlice& right_keys,
+                                      const DataSlice& left_join);
+
+// kde.core._agg_approx_count_distinct.
+//
+// Returns the approximate number of distinct present items in each group of
+// the last dimension of `x`, estimated with a HyperLogLog sketch of
+// 2^`precision` registers. Items are hashed by their stable fingerprints, so
+// sketches of different shards are compatible.
+absl::StatusOr<DataSlice> AggApproxCountDistinct(const DataSlice& x,
+                                                 const DataSlice& precision);
+
 // kde.core.align.
 class AlignOperatorFamily final : public arolla::OperatorFamily {
   absl::StatusOr<arolla::OperatorPtr> DoGetOperator(
@@ -110,6 +140,16 @@ absl::StatusOr<DataSlice> GetAttrWithDefault(const DataSlice& obj,
                                              const DataSlice& attr_name,
                                              const DataSlice& default_value);
 
+// kde.core._get_attrs.
+//
+// Returns a tuple of the attributes `attr_names` of `obj`, fetched together.
+// Reports the same errors as separate kde.core._get_attr calls.
+class GetAttrsOperatorFamily final : public arolla::OperatorFamily {
+  absl::StatusOr<arolla::OperatorPtr> DoGetOperator(
+      absl::Span<const arolla::QTypePtr> input_types,
+      arolla::QTypePtr output_type) const override;
+};
+
 // kde.core.with_attrs.
 class WithAttrsOperatorFamily final : public arolla::OperatorFamily {
   absl::StatusOr<arolla::OperatorPtr> DoGetOperator(
@@ -154,6 +194,13 @@ absl::StatusOr<DataSlice> GroupByIndices(
 absl::StatusOr<DataSlice> GroupByIndicesSorted(
     absl::Span<const DataSlice* const> slices);
 
+// Same as GroupByIndices (or GroupByIndicesSorted if `sort` is true), but
+// large groups are split into hash partitions that are processed concurrently
+// using `executor`. The result is the same as for the sequential versions.
+absl::StatusOr<DataSlice> ParallelGroupByIndices(
+    absl::Span<const DataSlice* const> slices, bool sort,
+    internal::Executor* executor);
+
 // kde.core.unique.
 absl::StatusOr<DataSlice> Unique(const DataSlice& x, const DataSlice& sort);
 
@@ -161,6 +208,9 @@ absl::StatusOr<DataSlice> Unique(const DataSlice& x, const DataSlice& sort);
 absl::StatusOr<DataSlice> ItemIdBits(const DataSlice& ds,
                                      const DataSlice& last);
 
+// kde.core.itemid_hash
+absl::StatusOr<DataSlice> ItemIdHash(const DataSlice& ds);
+
 // kde.core.list_size.
 absl::StatusOr<DataSlice> ListSize(const DataSlice& lists);
 
@@ -204,6 +254,17 @@ absl::StatusOr<DataSlice> Translate(const DataSlice& keys_to,
                                     const DataSlice& keys_from,
                                     const DataSlice& values_from);
 
+// kde.core.lookup_by_attr.
+absl::StatusOr<DataSlice> LookupByAttr(const DataSlice& x,
+                                       const DataSlice& attr_name,
+                                       const DataSlice& value);
+
+// kde.core.lookup_by_attr_range.
+absl::StatusOr<DataSlice> LookupByAttrRange(const DataSlice& x,
+                                            const DataSlice& attr_name,
+                                            const DataSlice& lower,
+                                            const DataSlice& upper);
+
 // kde.core._uuid operator.
 // Creates a DataSlice whose items are Fingerprints identifying arguments
 class UuidOperatorFamily : public arolla::OperatorFamily {
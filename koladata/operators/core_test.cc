@@ -0,0 +1,184 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/operators/core.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status_matchers.h"
+#include "absl/types/span.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
+#include "koladata/testing/matchers.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/optional_value.h"
+
+namespace koladata::ops {
+namespace {
+
+using ::koladata::testing::IsEquivalentTo;
+using DataSliceEdge = ::koladata::DataSlice::JaggedShape::Edge;
+using KeyColumn = std::vector<arolla::OptionalValue<int64_t>>;
+// Indices of the items relative to the split begin, by split and by group.
+using Groups = std::vector<std::vector<std::vector<int64_t>>>;
+
+// Straightforward implementation of group_by_indices(_sorted) for int64 keys.
+Groups ReferenceGroupBy(absl::Span<const KeyColumn> keys,
+                        absl::Span<const int64_t> split_points, bool sort) {
+  Groups result;
+  for (size_t s = 1; s < split_points.size(); ++s) {
+    std::map<std::vector<int64_t>, size_t> key_to_group;
+    std::vector<std::vector<int64_t>> groups;
+    for (int64_t i = split_points[s - 1]; i < split_points[s]; ++i) {
+      std::vector<int64_t> key;
+      for (const KeyColumn& column : keys) {
+        if (!column[i].present) {
+          break;
+        }
+        key.push_back(column[i].value);
+      }
+      if (key.size() != keys.size()) {
+        continue;
+      }
+      auto [it, inserted] = key_to_group.emplace(key, groups.size());
+      if (inserted) {
+        groups.emplace_back();
+      }
+      groups[it->second].push_back(i - split_points[s - 1]);
+    }
+    if (sort) {
+      std::vector<std::vector<int64_t>> sorted_groups;
+      for (const auto& [key, group] : key_to_group) {
+        sorted_groups.push_back(std::move(groups[group]));
+      }
+      groups = std::move(sorted_groups);
+    }
+    result.push_back(std::move(groups));
+  }
+  return result;
+}
+
+Groups ToGroups(const DataSlice& indices) {
+  const auto& edges = indices.GetShape().edges();
+  const auto& group_splits = edges[edges.size() - 2].edge_values().values;
+  const auto& item_splits = edges.back().edge_values().values;
+  const auto& values = indices.slice().values<int64_t>();
+  Groups result(group_splits.size() - 1);
+  for (size_t s = 0; s + 1 < group_splits.size(); ++s) {
+    for (int64_t g = group_splits[s]; g < group_splits[s + 1]; ++g) {
+      auto& group = result[s].emplace_back();
+      for (int64_t i = item_splits[g]; i < item_splits[g + 1]; ++i) {
+        EXPECT_TRUE(values.present(i));
+        group.push_back(values.values[i]);
+      }
+    }
+  }
+  return result;
+}
+
+class GroupByIndicesTest : public ::testing::TestWithParam<bool> {
+ protected:
+  bool sort() const { return GetParam(); }
+};
+
+INSTANTIATE_TEST_SUITE_P(Sort, GroupByIndicesTest, ::testing::Bool());
+
+// The splits of at least 1 << 16 items are grouped by hash partitions, the
+// others by a single hash map. Both must give the same result as the reference.
+TEST_P(GroupByIndicesTest, LargeSplits) {
+  const std::vector<int64_t> split_sizes = {100000, 50, 1 << 16, 0,
+                                            (1 << 16) - 1, 70000};
+  std::vector<int64_t> split_points = {0};
+  for (int64_t size : split_sizes) {
+    split_points.push_back(split_points.back() + size);
+  }
+  const int64_t size = split_points.back();
+
+  // High cardinality key with missing values and a low cardinality one.
+  KeyColumn key1(size);
+  KeyColumn key2(size);
+  for (int64_t i = 0; i < size; ++i) {
+    if (i % 17 != 0) {
+      key1[i] = (i * 7919) % 30011 - 15000;
+    }
+    if (i % 101 != 0) {
+      key2[i] = i % 3;
+    }
+  }
+
+  ASSERT_OK_AND_ASSIGN(auto split_edge,
+                       DataSliceEdge::FromSplitPoints(
+                           arolla::CreateFullDenseArray(split_points)));
+  ASSERT_OK_AND_ASSIGN(
+      auto shape,
+      DataSlice::JaggedShape::FromEdges(
+          {*DataSliceEdge::FromUniformGroups(1, split_sizes.size()),
+           split_edge}));
+  auto to_slice = [&](const KeyColumn& column) {
+    return *DataSlice::Create(
+        internal::DataSliceImpl::Create(
+            arolla::CreateDenseArray<int64_t>(absl::MakeConstSpan(column))),
+        shape, internal::DataItem(schema::kInt64));
+  };
+  DataSlice ds1 = to_slice(key1);
+  DataSlice ds2 = to_slice(key2);
+
+  internal::ThreadPoolExecutor executor(4);
+  for (auto keys : {std::vector<const DataSlice*>{&ds1},
+                    std::vector<const DataSlice*>{&ds1, &ds2}}) {
+    std::vector<KeyColumn> columns = {key1};
+    if (keys.size() == 2) {
+      columns.push_back(key2);
+    }
+    Groups expected = ReferenceGroupBy(columns, split_points, sort());
+
+    ASSERT_OK_AND_ASSIGN(DataSlice sequential,
+                         ParallelGroupByIndices(keys, sort(), nullptr));
+    EXPECT_EQ(ToGroups(sequential), expected);
+
+    ASSERT_OK_AND_ASSIGN(DataSlice parallel,
+                         ParallelGroupByIndices(keys, sort(), &executor));
+    EXPECT_THAT(parallel, IsEquivalentTo(sequential));
+
+    ASSERT_OK_AND_ASSIGN(DataSlice from_operator,
+                         sort() ? GroupByIndicesSorted(keys)
+                                : GroupByIndices(keys));
+    EXPECT_THAT(from_operator, IsEquivalentTo(sequential));
+  }
+}
+
+TEST_P(GroupByIndicesTest, LargeSplitAllMissing) {
+  constexpr int64_t kSize = 1 << 17;
+  DataSlice ds = *DataSlice::Create(
+      internal::DataSliceImpl::Create(
+          arolla::CreateEmptyDenseArray<int64_t>(kSize)),
+      DataSlice::JaggedShape::FlatFromSize(kSize),
+      internal::DataItem(schema::kInt64));
+  internal::ThreadPoolExecutor executor(4);
+  const DataSlice* keys[] = {&ds};
+  ASSERT_OK_AND_ASSIGN(DataSlice result,
+                       ParallelGroupByIndices(keys, sort(), &executor));
+  EXPECT_EQ(ToGroups(result), Groups{{}});
+}
+
+}  // namespace
+}  // namespace koladata::ops
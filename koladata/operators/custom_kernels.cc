@@ -0,0 +1,353 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/operators/custom_kernels.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/no_destructor.h"
+#include "absl/container/flat_hash_map.h"
+#include "absl/container/flat_hash_set.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/str_join.h"
+#include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
+#include "absl/types/span.h"
+#include "koladata/arolla_utils.h"
+#include "koladata/data_slice.h"
+#include "koladata/data_slice_qtype.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/shape_utils.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/qtype/qtype.h"
+#include "arolla/util/repr.h"
+#include "arolla/util/text.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::ops {
+namespace {
+
+using ::koladata::internal::DataItem;
+using ::koladata::internal::DataSliceImpl;
+
+// Dtype to dispatch on for `slice` with `schema`: the dtype of the values, or
+// of the schema for slices without values. nullptr if unknown.
+arolla::QTypePtr DispatchDType(const DataSliceImpl& slice,
+                               const DataItem& schema) {
+  if (slice.is_single_dtype()) {
+    return slice.dtype();
+  }
+  if (slice.is_empty_and_unknown() && schema.is_primitive_schema()) {
+    return schema.value<schema::DType>().qtype();
+  }
+  return nullptr;
+}
+
+std::string DTypesRepr(absl::Span<const arolla::QTypePtr> dtypes) {
+  return absl::StrJoin(dtypes, ", ", [](std::string* out, arolla::QTypePtr t) {
+    absl::StrAppend(out, t == nullptr ? "NOTHING" : t->name());
+  });
+}
+
+absl::StatusOr<DataItem> OutputSchema(
+    const absl::flat_hash_set<arolla::QTypePtr>& output_dtypes) {
+  if (output_dtypes.size() != 1) {
+    return DataItem(schema::kObject);
+  }
+  ASSIGN_OR_RETURN(auto dtype,
+                   schema::DType::FromQType(*output_dtypes.begin()));
+  return DataItem(dtype);
+}
+
+// Values of `slice` at `rows`.
+DataSliceImpl Gather(const DataSliceImpl& slice,
+                     absl::Span<const int64_t> rows) {
+  DataSliceImpl::Builder bldr(rows.size());
+  for (int64_t i = 0; i < rows.size(); ++i) {
+    bldr.Insert(i, slice[rows[i]]);
+  }
+  return std::move(bldr).Build();
+}
+
+class CustomKernelRegistry {
+ public:
+  static CustomKernelRegistry& Instance() {
+    static absl::NoDestructor<CustomKernelRegistry> registry;
+    return *registry;
+  }
+
+  absl::Status Register(CustomKernel kernel) {
+    absl::MutexLock lock(&mutex_);
+    std::string name = kernel.name();
+    auto [it, inserted] = kernels_.emplace(
+        std::move(name),
+        std::make_shared<const CustomKernel>(std::move(kernel)));
+    if (!inserted) {
+      return absl::AlreadyExistsError(absl::StrFormat(
+          "custom kernel '%s' is already registered", it->first));
+    }
+    return absl::OkStatus();
+  }
+
+  absl::StatusOr<std::shared_ptr<const CustomKernel>> Get(
+      absl::string_view name) const {
+    absl::MutexLock lock(&mutex_);
+    auto it = kernels_.find(name);
+    if (it == kernels_.end()) {
+      return absl::NotFoundError(
+          absl::StrFormat("custom kernel '%s' is not registered", name));
+    }
+    return it->second;
+  }
+
+ private:
+  mutable absl::Mutex mutex_;
+  absl::flat_hash_map<std::string, std::shared_ptr<const CustomKernel>>
+      kernels_ ABSL_GUARDED_BY(mutex_);
+};
+
+}  // namespace
+
+const CustomKernel::Overload* CustomKernel::FindOverload(
+    absl::Span<const arolla::QTypePtr> dtypes) const {
+  for (const auto& overload : overloads_) {
+    if (std::equal(dtypes.begin(), dtypes.end(),
+                   overload.input_dtypes.begin(), overload.input_dtypes.end(),
+                   [](arolla::QTypePtr dtype, arolla::QTypePtr expected) {
+                     return dtype == nullptr || dtype == expected;
+                   })) {
+      return &overload;
+    }
+  }
+  return nullptr;
+}
+
+absl::StatusOr<DataSlice> CustomKernel::Eval(
+    std::vector<DataSlice> inputs) const {
+  if (overloads_.empty()) {
+    return absl::FailedPreconditionError(
+        absl::StrFormat("custom kernel '%s' has no overloads", name_));
+  }
+  if (inputs.empty() ||
+      inputs.size() != overloads_.front().input_dtypes.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "custom kernel '%s' expects %d inputs, got %d", name_,
+        overloads_.front().input_dtypes.size(), inputs.size()));
+  }
+  auto result = kind_ == kPointwise ? EvalPointwise(std::move(inputs))
+                                    : EvalAggInto(std::move(inputs));
+  if (!result.ok()) {
+    return absl::Status(result.status().code(),
+                        absl::StrFormat("custom kernel '%s': %s", name_,
+                                        result.status().message()));
+  }
+  return result;
+}
+
+absl::StatusOr<DataSlice> CustomKernel::EvalPointwise(
+    std::vector<DataSlice> inputs) const {
+  ASSIGN_OR_RETURN(auto aligned, shape::Align(std::move(inputs)));
+  const DataSlice::JaggedShape& shape = aligned[0].GetShape();
+  std::vector<DataSliceImpl> slices;
+  std::vector<arolla::QTypePtr> dtypes;
+  slices.reserve(aligned.size());
+  dtypes.reserve(aligned.size());
+  bool has_mixed = false;
+  for (const auto& ds : aligned) {
+    slices.push_back(ds.GetShape().rank() == 0
+                         ? DataSliceImpl::Create(1, ds.item())
+                         : ds.slice());
+    dtypes.push_back(DispatchDType(slices.back(), ds.GetSchemaImpl()));
+    has_mixed |= slices.back().is_mixed_dtype();
+  }
+  absl::flat_hash_set<arolla::QTypePtr> output_dtypes;
+  if (!has_mixed) {
+    const Overload* overload = FindOverload(dtypes);
+    if (overload == nullptr) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "no overload for inputs of %s", DTypesRepr(dtypes)));
+    }
+    ASSIGN_OR_RETURN(auto result, overload->fn(slices, nullptr));
+    output_dtypes.insert(overload->output_dtype);
+    ASSIGN_OR_RETURN(auto output_schema, OutputSchema(output_dtypes));
+    return DataSlice::Create(std::move(result), shape,
+                             std::move(output_schema));
+  }
+
+  // Split the rows by the combination of the dtypes of the inputs and
+  // evaluate each combination separately.
+  std::vector<std::vector<arolla::QTypePtr>> value_dtypes(slices.size());
+  for (int i = 0; i < slices.size(); ++i) {
+    slices[i].VisitValues([&]<class T>(const arolla::DenseArray<T>&) {
+      value_dtypes[i].push_back(arolla::GetQType<T>());
+    });
+  }
+  absl::flat_hash_map<std::vector<arolla::QTypePtr>, std::vector<int64_t>>
+      rows_by_dtypes;
+  std::vector<arolla::QTypePtr> row_dtypes = dtypes;
+  for (int64_t row = 0; row < shape.size(); ++row) {
+    for (int i = 0; i < slices.size(); ++i) {
+      if (slices[i].is_mixed_dtype()) {
+        uint8_t index = slices[i].row_value_indices()[row];
+        row_dtypes[i] = index == DataSliceImpl::kMissingRow
+                            ? nullptr
+                            : value_dtypes[i][index];
+      }
+    }
+    rows_by_dtypes[row_dtypes].push_back(row);
+  }
+  DataSliceImpl::Builder bldr(shape.size());
+  for (const auto& [group_dtypes, rows] : rows_by_dtypes) {
+    const Overload* overload = FindOverload(group_dtypes);
+    if (overload == nullptr) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "no overload for inputs of %s", DTypesRepr(group_dtypes)));
+    }
+    std::vector<DataSliceImpl> group_slices;
+    group_slices.reserve(slices.size());
+    for (const auto& slice : slices) {
+      group_slices.push_back(Gather(slice, rows));
+    }
+    ASSIGN_OR_RETURN(auto result, overload->fn(group_slices, nullptr));
+    for (int64_t i = 0; i < rows.size(); ++i) {
+      bldr.Insert(rows[i], result[i]);
+    }
+    output_dtypes.insert(overload->output_dtype);
+  }
+  ASSIGN_OR_RETURN(auto output_schema, OutputSchema(output_dtypes));
+  return DataSlice::Create(std::move(bldr).Build(), shape,
+                           std::move(output_schema));
+}
+
+absl::StatusOr<DataSlice> CustomKernel::EvalAggInto(
+    std::vector<DataSlice> inputs) const {
+  ASSIGN_OR_RETURN(auto aligned, shape::Align(std::move(inputs)));
+  const DataSlice::JaggedShape& shape = aligned[0].GetShape();
+  if (shape.rank() == 0) {
+    return absl::InvalidArgumentError("expected rank(x) > 0");
+  }
+  std::vector<DataSliceImpl> slices;
+  std::vector<arolla::QTypePtr> dtypes;
+  slices.reserve(aligned.size());
+  dtypes.reserve(aligned.size());
+  for (const auto& ds : aligned) {
+    if (ds.slice().is_mixed_dtype()) {
+      // Groups would have to be split between the overloads.
+      return absl::InvalidArgumentError(
+          "aggregational custom kernels do not support slices with mixed "
+          "dtypes");
+    }
+    slices.push_back(ds.slice());
+    dtypes.push_back(DispatchDType(slices.back(), ds.GetSchemaImpl()));
+  }
+  const Overload* overload = FindOverload(dtypes);
+  if (overload == nullptr) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("no overload for inputs of %s", DTypesRepr(dtypes)));
+  }
+  ASSIGN_OR_RETURN(auto result, overload->fn(slices, &shape.edges().back()));
+  ASSIGN_OR_RETURN(auto output_schema,
+                   OutputSchema({overload->output_dtype}));
+  return DataSlice::Create(std::move(result),
+                           shape.RemoveDims(shape.rank() - 1),
+                           std::move(output_schema));
+}
+
+absl::Status RegisterCustomKernel(CustomKernel kernel) {
+  return CustomKernelRegistry::Instance().Register(std::move(kernel));
+}
+
+absl::StatusOr<std::shared_ptr<const CustomKernel>> GetCustomKernel(
+    absl::string_view name) {
+  return CustomKernelRegistry::Instance().Get(name);
+}
+
+absl::StatusOr<DataSlice> EvalCustomKernel(
+    absl::Span<const DataSlice* const> args) {
+  if (args.empty()) {
+    return absl::InvalidArgumentError(
+        "_eval_custom_kernel expected at least 1 argument, but got 0");
+  }
+  auto name = ToArollaScalar<arolla::Text>(*args[0]);
+  if (!name.ok()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "`kernel_name` argument must be a scalar TEXT, but got %s",
+        arolla::Repr(*args[0])));
+  }
+  ASSIGN_OR_RETURN(auto kernel, GetCustomKernel(name->view()));
+  std::vector<DataSlice> inputs;
+  inputs.reserve(args.size() - 1);
+  for (const auto* const ds : args.subspan(1)) {
+    inputs.push_back(*ds);
+  }
+  return kernel->Eval(std::move(inputs));
+}
+
+namespace custom_kernels_internal {
+
+std::vector<int64_t> ChunkBounds(int64_t size, int64_t chunk_count) {
+  chunk_count = std::max<int64_t>(chunk_count, 1);
+  std::vector<int64_t> bounds(chunk_count + 1);
+  for (int64_t i = 0; i <= chunk_count; ++i) {
+    bounds[i] = size * i / chunk_count;
+  }
+  return bounds;
+}
+
+std::vector<int64_t> GroupChunkBounds(const arolla::DenseArrayEdge& edge,
+                                      int64_t chunk_count) {
+  std::vector<int64_t> bounds = {0};
+  if (edge.edge_type() == arolla::DenseArrayEdge::SPLIT_POINTS) {
+    absl::Span<const int64_t> split_points = edge.edge_values().values.span();
+    for (int64_t i = 1; i < chunk_count; ++i) {
+      int64_t target = edge.child_size() * i / chunk_count;
+      int64_t group = std::lower_bound(split_points.begin(),
+                                       split_points.end(), target) -
+                      split_points.begin();
+      if (group > bounds.back() && group < edge.parent_size()) {
+        bounds.push_back(group);
+      }
+    }
+  }
+  bounds.push_back(edge.parent_size());
+  return bounds;
+}
+
+absl::StatusOr<arolla::DenseArrayEdge> SubEdge(
+    const arolla::DenseArrayEdge& edge, int64_t group_begin,
+    int64_t group_end) {
+  absl::Span<const int64_t> split_points = edge.edge_values().values.span();
+  const int64_t child_begin = split_points[group_begin];
+  arolla::Buffer<int64_t>::Builder bldr(group_end - group_begin + 1);
+  for (int64_t g = group_begin; g <= group_end; ++g) {
+    bldr.Set(g - group_begin, split_points[g] - child_begin);
+  }
+  return arolla::DenseArrayEdge::FromSplitPoints({std::move(bldr).Build()});
+}
+
+}  // namespace custom_kernels_internal
+
+}  // namespace koladata::ops
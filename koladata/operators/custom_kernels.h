@@ -0,0 +1,260 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_OPERATORS_CUSTOM_KERNELS_H_
+#define KOLADATA_OPERATORS_CUSTOM_KERNELS_H_
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/executor.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/qtype/qtype.h"
+#include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::ops {
+
+// DataSlice-level operator built from typed batch kernels.
+//
+// A kernel is written against arolla::DenseArray (a span of values plus a
+// presence bitmap) of concrete types, and CustomKernel does the Koda part:
+// shape alignment, dispatch on the dtypes of the values, splitting of mixed
+// OBJECT slices by dtype, inference of the output schema and, optionally,
+// evaluation of large inputs in chunks on internal::CurrentExecutor().
+//
+//   CustomKernel clip = CustomKernel::Pointwise("my.clip", {.parallel = true});
+//   clip.Add<float, float, float>(
+//       [](const arolla::DenseArray<float>& x,
+//          const arolla::DenseArray<float>& limit)
+//           -> absl::StatusOr<arolla::DenseArray<float>> { ... });
+//   ASSIGN_OR_RETURN(DataSlice result, clip.Eval({x, limit}));
+//
+// Pointwise kernels get arrays of the same size and must return an array of
+// that size. Aggregational kernels get the child arrays plus the edge of the
+// last dimension, and must return an array with one value per group. Missing
+// values are passed as missing, so the kernels decide how to handle them.
+// With `parallel` the kernels must be thread-safe and compute every item
+// (resp. group) independently of the others.
+class CustomKernel {
+ public:
+  enum Kind { kPointwise, kAggInto };
+
+  struct Options {
+    // Evaluate large inputs in chunks of at least `min_chunk_size` items on
+    // internal::CurrentExecutor(), see internal::ParallelChunkCount.
+    bool parallel = false;
+    int64_t min_chunk_size = 1 << 14;
+  };
+
+  // Type-erased overload. `fn` is called with single-dtype or empty slices
+  // of `input_dtypes` and, for aggregations, the edge of the last dimension.
+  struct Overload {
+    std::vector<arolla::QTypePtr> input_dtypes;
+    arolla::QTypePtr output_dtype;
+    std::function<absl::StatusOr<internal::DataSliceImpl>(
+        absl::Span<const internal::DataSliceImpl>,
+        const arolla::DenseArrayEdge*)>
+        fn;
+  };
+
+  static CustomKernel Pointwise(std::string name, Options options = {}) {
+    return CustomKernel(std::move(name), kPointwise, options);
+  }
+  static CustomKernel AggInto(std::string name, Options options = {}) {
+    return CustomKernel(std::move(name), kAggInto, options);
+  }
+
+  // Adds an overload for inputs of types `Ins`. For pointwise kernels `fn` is
+  // callable as
+  //   absl::StatusOr<arolla::DenseArray<Out>>(
+  //       const arolla::DenseArray<Ins>&...)
+  // and for aggregational ones it additionally takes
+  // `const arolla::DenseArrayEdge&` as the last argument. All overloads must
+  // have the same number of inputs. On ambiguity, the overload added first
+  // wins.
+  template <typename Out, typename... Ins, typename Fn>
+  CustomKernel& Add(Fn fn);
+
+  // Evaluates the kernel. Pointwise kernels broadcast the inputs to a common
+  // shape and return a slice of that shape; aggregational ones aggregate over
+  // the last dimension of the common shape. The output schema is the dtype of
+  // the output of the evaluated overloads, or OBJECT if the inputs were split
+  // between overloads with different output types.
+  absl::StatusOr<DataSlice> Eval(std::vector<DataSlice> inputs) const;
+
+  const std::string& name() const { return name_; }
+  Kind kind() const { return kind_; }
+
+ private:
+  CustomKernel(std::string name, Kind kind, Options options)
+      : name_(std::move(name)), kind_(kind), options_(options) {}
+
+  template <typename Out, typename... Ins, typename Fn, size_t... Is>
+  static absl::StatusOr<internal::DataSliceImpl> EvalOverload(
+      const Fn& fn, const Options& options,
+      absl::Span<const internal::DataSliceImpl> inputs,
+      const arolla::DenseArrayEdge* edge, std::index_sequence<Is...>);
+
+  // Returns the first overload accepting `dtypes`, nullptr matches any dtype.
+  const Overload* FindOverload(absl::Span<const arolla::QTypePtr> dtypes) const;
+
+  absl::StatusOr<DataSlice> EvalPointwise(std::vector<DataSlice> inputs) const;
+  absl::StatusOr<DataSlice> EvalAggInto(std::vector<DataSlice> inputs) const;
+
+  std::string name_;
+  Kind kind_;
+  Options options_;
+  std::vector<Overload> overloads_;
+};
+
+// Registers `kernel` to be evaluated by kde.core._eval_custom_kernel under its
+// name. Returns an error if a kernel with the same name is already registered.
+absl::Status RegisterCustomKernel(CustomKernel kernel);
+
+// Returns the kernel registered under `name`.
+absl::StatusOr<std::shared_ptr<const CustomKernel>> GetCustomKernel(
+    absl::string_view name);
+
+// kde.core._eval_custom_kernel. The first argument is the name of the kernel,
+// the rest are its inputs.
+absl::StatusOr<DataSlice> EvalCustomKernel(
+    absl::Span<const DataSlice* const> args);
+
+namespace custom_kernels_internal {
+
+// Boundaries [bounds[i], bounds[i + 1]) of `chunk_count` ranges of items of
+// similar sizes covering [0, size).
+std::vector<int64_t> ChunkBounds(int64_t size, int64_t chunk_count);
+
+// Boundaries of ranges of consecutive groups of `edge` with similar numbers of
+// child items.
+std::vector<int64_t> GroupChunkBounds(const arolla::DenseArrayEdge& edge,
+                                      int64_t chunk_count);
+
+// Edge of the groups [group_begin, group_end) of `edge`, with child ids
+// starting from 0.
+absl::StatusOr<arolla::DenseArrayEdge> SubEdge(
+    const arolla::DenseArrayEdge& edge, int64_t group_begin,
+    int64_t group_end);
+
+template <typename T>
+arolla::DenseArray<T> Values(const internal::DataSliceImpl& slice) {
+  return slice.is_empty_and_unknown()
+             ? arolla::CreateEmptyDenseArray<T>(slice.size())
+             : slice.values<T>();
+}
+
+// Concatenates the `chunks` into an array of `size` items.
+template <typename T>
+arolla::DenseArray<T> Concat(absl::Span<const arolla::DenseArray<T>> chunks,
+                             int64_t size) {
+  if (chunks.size() == 1) {
+    return chunks[0];
+  }
+  arolla::DenseArrayBuilder<T> bldr(size);
+  int64_t offset = 0;
+  for (const auto& chunk : chunks) {
+    chunk.ForEachPresent(
+        [&](int64_t id, auto value) { bldr.Set(offset + id, value); });
+    offset += chunk.size();
+  }
+  return std::move(bldr).Build();
+}
+
+}  // namespace custom_kernels_internal
+
+template <typename Out, typename... Ins, typename Fn>
+CustomKernel& CustomKernel::Add(Fn fn) {
+  overloads_.push_back(Overload{
+      .input_dtypes = {arolla::GetQType<Ins>()...},
+      .output_dtype = arolla::GetQType<Out>(),
+      .fn = [fn = std::move(fn), options = options_](
+                absl::Span<const internal::DataSliceImpl> inputs,
+                const arolla::DenseArrayEdge* edge) {
+        return EvalOverload<Out, Ins...>(fn, options, inputs, edge,
+                                         std::index_sequence_for<Ins...>());
+      }});
+  return *this;
+}
+
+template <typename Out, typename... Ins, typename Fn, size_t... Is>
+absl::StatusOr<internal::DataSliceImpl> CustomKernel::EvalOverload(
+    const Fn& fn, const Options& options,
+    absl::Span<const internal::DataSliceImpl> inputs,
+    const arolla::DenseArrayEdge* edge, std::index_sequence<Is...>) {
+  namespace impl = custom_kernels_internal;
+  const int64_t size = inputs[0].size();
+  const int64_t result_size = edge == nullptr ? size : edge->parent_size();
+  std::tuple<arolla::DenseArray<Ins>...> arrays(
+      impl::Values<Ins>(inputs[Is])...);
+  std::shared_ptr<internal::Executor> executor;
+  int64_t chunk_count = 1;
+  if (options.parallel) {
+    executor = internal::CurrentExecutor();
+    chunk_count = internal::ParallelChunkCount(executor.get(), size,
+                                               options.min_chunk_size);
+  }
+  // Chunk boundaries in items for pointwise kernels, in groups for
+  // aggregational ones.
+  std::vector<int64_t> bounds =
+      edge == nullptr ? impl::ChunkBounds(size, chunk_count)
+                      : impl::GroupChunkBounds(*edge, chunk_count);
+  std::vector<arolla::DenseArray<Out>> results(bounds.size() - 1);
+  RETURN_IF_ERROR(internal::ParallelFor(
+      executor.get(), results.size(), [&](int64_t chunk) -> absl::Status {
+        const int64_t begin = bounds[chunk];
+        const int64_t end = bounds[chunk + 1];
+        absl::StatusOr<arolla::DenseArray<Out>> result;
+        if (edge == nullptr) {
+          result = fn(std::get<Is>(arrays).Slice(begin, end - begin)...);
+        } else if (bounds.size() == 2) {
+          result = fn(std::get<Is>(arrays)..., *edge);
+        } else {
+          ASSIGN_OR_RETURN(auto chunk_edge, impl::SubEdge(*edge, begin, end));
+          const int64_t child_begin = edge->edge_values().values[begin];
+          result = fn(std::get<Is>(arrays).Slice(child_begin,
+                                                 chunk_edge.child_size())...,
+                      chunk_edge);
+        }
+        RETURN_IF_ERROR(result.status());
+        if (result->size() != end - begin) {
+          return absl::InternalError(absl::StrFormat(
+              "kernel returned %d items, expected %d", result->size(),
+              end - begin));
+        }
+        results[chunk] = *std::move(result);
+        return absl::OkStatus();
+      }));
+  return internal::DataSliceImpl::Create(
+      impl::Concat<Out>(results, result_size));
+}
+
+}  // namespace koladata::ops
+
+#endif  // KOLADATA_OPERATORS_CUSTOM_KERNELS_H_
@@ -0,0 +1,241 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/operators/custom_kernels.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/types/span.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
+#include "koladata/test_utils.h"
+#include "koladata/testing/matchers.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/memory/optional_value.h"
+#include "arolla/util/text.h"
+
+namespace koladata::ops {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::koladata::testing::IsEquivalentTo;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using DataSliceEdge = ::koladata::DataSlice::JaggedShape::Edge;
+
+DataSliceEdge EdgeFromSizes(absl::Span<const int64_t> sizes) {
+  std::vector<arolla::OptionalValue<int64_t>> split_points;
+  split_points.reserve(sizes.size() + 1);
+  split_points.push_back(0);
+  for (int64_t size : sizes) {
+    split_points.push_back(split_points.back().value + size);
+  }
+  return *DataSliceEdge::FromSplitPoints(
+      arolla::CreateDenseArray<int64_t>(split_points));
+}
+
+// x * 2, missing values stay missing.
+template <typename T>
+absl::StatusOr<arolla::DenseArray<T>> Double(const arolla::DenseArray<T>& x) {
+  arolla::DenseArrayBuilder<T> bldr(x.size());
+  x.ForEachPresent([&](int64_t id, T value) { bldr.Set(id, value * 2); });
+  return std::move(bldr).Build();
+}
+
+// x if present, otherwise default.
+absl::StatusOr<arolla::DenseArray<int64_t>> Coalesce(
+    const arolla::DenseArray<int64_t>& x,
+    const arolla::DenseArray<int64_t>& default_value) {
+  arolla::DenseArrayBuilder<int64_t> bldr(x.size());
+  for (int64_t i = 0; i < x.size(); ++i) {
+    if (x.present(i)) {
+      bldr.Set(i, x.values[i]);
+    } else if (default_value.present(i)) {
+      bldr.Set(i, default_value.values[i]);
+    }
+  }
+  return std::move(bldr).Build();
+}
+
+absl::StatusOr<arolla::DenseArray<int64_t>> Count(
+    const arolla::DenseArray<int32_t>& x, const arolla::DenseArrayEdge& edge) {
+  arolla::DenseArrayBuilder<int64_t> bldr(edge.parent_size());
+  auto split_points = edge.edge_values().values.span();
+  for (int64_t g = 0; g < edge.parent_size(); ++g) {
+    int64_t count = 0;
+    for (int64_t i = split_points[g]; i < split_points[g + 1]; ++i) {
+      count += x.present(i);
+    }
+    bldr.Set(g, count);
+  }
+  return std::move(bldr).Build();
+}
+
+TEST(CustomKernelTest, Pointwise) {
+  CustomKernel kernel = CustomKernel::Pointwise("test.coalesce");
+  kernel.Add<int64_t, int64_t, int64_t>(Coalesce);
+  DataSlice::JaggedShape shape = *DataSlice::JaggedShape::FromEdges(
+      {EdgeFromSizes({2}), EdgeFromSizes({2, 1})});
+  DataSlice x = test::DataSlice<int64_t>({1, std::nullopt, std::nullopt},
+                                         shape, schema::kInt64);
+  DataSlice y = test::DataSlice<int64_t>({10, 20}, schema::kInt64);
+  EXPECT_THAT(kernel.Eval({x, y}),
+              IsOkAndHolds(IsEquivalentTo(test::DataSlice<int64_t>(
+                  {1, 10, 20}, shape, schema::kInt64))));
+  EXPECT_THAT(kernel.Eval({test::DataItem(int64_t{1}, schema::kInt64),
+                           test::DataItem(int64_t{2}, schema::kInt64)}),
+              IsOkAndHolds(IsEquivalentTo(
+                  test::DataItem(int64_t{1}, schema::kInt64))));
+}
+
+TEST(CustomKernelTest, Dispatch) {
+  CustomKernel kernel = CustomKernel::Pointwise("test.double");
+  kernel.Add<int32_t, int32_t>(Double<int32_t>)
+      .Add<float, float>(Double<float>);
+  EXPECT_THAT(kernel.Eval({test::DataSlice<float>({1.5f, std::nullopt})}),
+              IsOkAndHolds(IsEquivalentTo(
+                  test::DataSlice<float>({3.0f, std::nullopt}))));
+  // Values of OBJECT slices are dispatched on their dtype.
+  EXPECT_THAT(
+      kernel.Eval({test::DataSlice<int32_t>({1, 2}, schema::kObject)}),
+      IsOkAndHolds(IsEquivalentTo(test::DataSlice<int32_t>({2, 4}))));
+  // Empty slices are dispatched on their schema.
+  EXPECT_THAT(kernel.Eval({test::EmptyDataSlice(2, schema::kFloat32)}),
+              IsOkAndHolds(IsEquivalentTo(
+                  test::DataSlice<float>({std::nullopt, std::nullopt}))));
+  EXPECT_THAT(kernel.Eval({test::DataSlice<arolla::Text>({"a"})}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("custom kernel 'test.double': no overload "
+                                 "for inputs of TEXT")));
+  EXPECT_THAT(kernel.Eval({}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("expects 1 inputs, got 0")));
+}
+
+TEST(CustomKernelTest, MixedDTypes) {
+  CustomKernel kernel = CustomKernel::Pointwise("test.double");
+  kernel.Add<int32_t, int32_t>(Double<int32_t>)
+      .Add<float, float>(Double<float>);
+  DataSlice x = test::MixedDataSlice<int32_t, float>(
+      {1, std::nullopt, std::nullopt}, {std::nullopt, 2.5f, std::nullopt});
+  ASSERT_OK_AND_ASSIGN(DataSlice result, kernel.Eval({x}));
+  EXPECT_THAT(result,
+              IsEquivalentTo(test::MixedDataSlice<int32_t, float>(
+                  {2, std::nullopt, std::nullopt},
+                  {std::nullopt, 5.0f, std::nullopt})));
+
+  CustomKernel ints_only = CustomKernel::Pointwise("test.double_ints");
+  ints_only.Add<int32_t, int32_t>(Double<int32_t>);
+  EXPECT_THAT(ints_only.Eval({x}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("no overload for inputs of FLOAT32")));
+}
+
+TEST(CustomKernelTest, AggInto) {
+  CustomKernel kernel = CustomKernel::AggInto("test.count");
+  kernel.Add<int64_t, int32_t>(Count);
+  DataSlice::JaggedShape shape = *DataSlice::JaggedShape::FromEdges(
+      {EdgeFromSizes({3}), EdgeFromSizes({2, 0, 2})});
+  DataSlice x =
+      test::DataSlice<int32_t>({1, std::nullopt, 3, 4}, shape, schema::kInt32);
+  EXPECT_THAT(kernel.Eval({x}),
+              IsOkAndHolds(IsEquivalentTo(
+                  test::DataSlice<int64_t>({1, 0, 2}, schema::kInt64))));
+  EXPECT_THAT(kernel.Eval({test::DataItem(1, schema::kInt32)}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("expected rank(x) > 0")));
+}
+
+TEST(CustomKernelTest, Parallel) {
+  internal::ThreadPoolExecutor executor(3);
+  internal::ScopedExecutor scoped_executor(&executor);
+  constexpr int64_t kSize = 1000;
+  std::vector<int32_t> values(kSize);
+  std::vector<int32_t> doubled(kSize);
+  std::vector<int64_t> split_points = {0};
+  for (int64_t i = 0; i < kSize; ++i) {
+    values[i] = i;
+    doubled[i] = 2 * i;
+    if (i % 7 == 0) {
+      split_points.push_back(i + 1);
+    }
+  }
+  split_points.back() = kSize;
+
+  CustomKernel pointwise = CustomKernel::Pointwise(
+      "test.double", {.parallel = true, .min_chunk_size = 10});
+  pointwise.Add<int32_t, int32_t>(Double<int32_t>);
+  DataSlice x = *DataSlice::Create(
+      internal::DataSliceImpl::Create(arolla::CreateFullDenseArray(values)),
+      DataSlice::JaggedShape::FlatFromSize(kSize),
+      internal::DataItem(schema::kInt32));
+  ASSERT_OK_AND_ASSIGN(DataSlice result, pointwise.Eval({x}));
+  EXPECT_THAT(result.slice().values<int32_t>(),
+              ::testing::ElementsAreArray(doubled));
+
+  CustomKernel agg = CustomKernel::AggInto(
+      "test.count", {.parallel = true, .min_chunk_size = 10});
+  agg.Add<int64_t, int32_t>(Count);
+  ASSERT_OK_AND_ASSIGN(
+      auto edge, DataSliceEdge::FromSplitPoints(
+                     arolla::CreateFullDenseArray(split_points)));
+  ASSERT_OK_AND_ASSIGN(
+      auto shape, DataSlice::JaggedShape::FromEdges(
+                      {EdgeFromSizes({edge.parent_size()}), edge}));
+  ASSERT_OK_AND_ASSIGN(DataSlice grouped, x.Reshape(shape));
+  ASSERT_OK_AND_ASSIGN(DataSlice counts, agg.Eval({grouped}));
+  ASSERT_EQ(counts.size(), edge.parent_size());
+  int64_t total = 0;
+  counts.slice().values<int64_t>().ForEachPresent(
+      [&](int64_t id, int64_t count) {
+        EXPECT_EQ(count, split_points[id + 1] - split_points[id]);
+        total += count;
+      });
+  EXPECT_EQ(total, kSize);
+}
+
+TEST(CustomKernelTest, Registry) {
+  CustomKernel kernel = CustomKernel::Pointwise("test.registry.double");
+  kernel.Add<int32_t, int32_t>(Double<int32_t>);
+  ASSERT_OK(RegisterCustomKernel(kernel));
+  EXPECT_THAT(RegisterCustomKernel(kernel),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+  EXPECT_THAT(GetCustomKernel("test.registry.unknown"),
+              StatusIs(absl::StatusCode::kNotFound));
+
+  DataSlice name = test::DataItem(arolla::Text("test.registry.double"));
+  DataSlice x = test::DataSlice<int32_t>({1, 2});
+  std::vector<const DataSlice*> args = {&name, &x};
+  EXPECT_THAT(EvalCustomKernel(args),
+              IsOkAndHolds(IsEquivalentTo(test::DataSlice<int32_t>({2, 4}))));
+}
+
+TEST(CustomKernelTest, ChunkBounds) {
+  EXPECT_THAT(custom_kernels_internal::ChunkBounds(10, 3),
+              ElementsAre(0, 3, 6, 10));
+  EXPECT_THAT(custom_kernels_internal::ChunkBounds(0, 1), ElementsAre(0, 0));
+}
+
+}  // namespace
+}  // namespace koladata::ops
@@ -17,21 +17,26 @@
 
 #include <memory>
 #include <utility>
+#include <vector>
 
 #include "absl/log/check.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "koladata/casting.h"
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
 #include "koladata/data_slice_op.h"
 #include "koladata/data_slice_qtype.h"
 #include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
 #include "koladata/internal/op_utils/has.h"
 #include "koladata/internal/op_utils/presence_and.h"
 #include "koladata/internal/op_utils/presence_or.h"
 #include "koladata/operators/arolla_bridge.h"
 #include "koladata/repr_utils.h"
+#include "koladata/shape_utils.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata::ops {
@@ -54,6 +59,48 @@ inline absl::StatusOr<DataSlice> Coalesce(const DataSlice& x,
       aligned_slices.common_schema, std::move(res_db));
 }
 
+// kde.logical._multi_coalesce.
+//
+// Equivalent to `kde.logical.coalesce` chained over all `slices`, but computed
+// in a single pass.
+inline absl::StatusOr<DataSlice> MultiCoalesce(
+    absl::Span<const DataSlice* const> slices) {
+  if (slices.empty()) {
+    return absl::InvalidArgumentError("expected at least one input");
+  }
+  std::vector<DataSlice> inputs;
+  std::vector<DataBagPtr> dbs;
+  inputs.reserve(slices.size());
+  dbs.reserve(slices.size());
+  for (const DataSlice* slice : slices) {
+    inputs.push_back(*slice);
+    dbs.push_back(slice->GetDb());
+  }
+  auto res_db = DataBag::CommonDataBag(dbs);
+  ASSIGN_OR_RETURN(auto aligned_slices, AlignSchemas(std::move(inputs)),
+                   AssembleErrorMessage(_, {.db = res_db}));
+  ASSIGN_OR_RETURN(auto aligned_inputs,
+                   shape::Align(std::move(aligned_slices.slices)));
+  if (aligned_inputs[0].GetShape().rank() == 0) {
+    for (const DataSlice& input : aligned_inputs) {
+      if (input.item().has_value()) {
+        return DataSlice::Create(input.item(), aligned_slices.common_schema,
+                                 std::move(res_db));
+      }
+    }
+    return DataSlice::Create(internal::DataItem(),
+                             aligned_slices.common_schema, std::move(res_db));
+  }
+  std::vector<internal::DataSliceImpl> impls;
+  impls.reserve(aligned_inputs.size());
+  for (const DataSlice& input : aligned_inputs) {
+    impls.push_back(input.slice());
+  }
+  ASSIGN_OR_RETURN(auto res_impl, internal::PresenceOrOp()(impls));
+  return DataSlice::Create(std::move(res_impl), aligned_inputs[0].GetShape(),
+                           aligned_slices.common_schema, std::move(res_db));
+}
+
 // kde.logical.has.
 inline absl::StatusOr<DataSlice> Has(const DataSlice& obj) {
   return DataSliceOp<internal::HasOp>()(
@@ -65,8 +112,9 @@ inline absl::StatusOr<DataSlice> HasNot(const DataSlice& x) {
   // Must be a mask, which is normally guaranteed by `x` being constructed from
   // kde.logical.has. This ensures that M.core.presence_not is always called.
   DCHECK_EQ(x.GetSchemaImpl(), internal::DataItem(schema::kMask));
-  return SimplePointwiseEval("core.presence_not", {x},
-                             internal::DataItem(schema::kMask));
+  // Negates the presence bitmap directly instead of going through Arolla.
+  return DataSliceOp<internal::HasNotOp>()(
+      x, x.GetShape(), internal::DataItem(schema::kMask), nullptr);
 }
 
 // kde.logical._agg_any.
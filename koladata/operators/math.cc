@@ -14,17 +14,48 @@
 //
 #include "koladata/operators/math.h"
 
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <type_traits>
 #include <utility>
 #include <vector>
 
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/numbers.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/arolla_utils.h"
 #include "koladata/data_slice.h"
 #include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/op_utils/segmented_reduce.h"
+#include "koladata/internal/op_utils/streaming_agg.h"
+#include "koladata/internal/schema_utils.h"
 #include "koladata/operators/arolla_bridge.h"
+#include "koladata/operators/comparison.h"
+#include "koladata/operators/core.h"
+#include "koladata/shape_utils.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/expr/expr.h"
+#include "arolla/expr/expr_node.h"
+#include "arolla/expr/expr_operator.h"
+#include "arolla/expr/expr_operator_signature.h"
+#include "arolla/expr/expr_visitor.h"
+#include "arolla/expr/lambda_expr_operator.h"
+#include "arolla/expr/quote.h"
+#include "arolla/expr/registered_expr_operator.h"
+#include "arolla/qtype/qtype_traits.h"
+#include "arolla/qtype/standard_type_properties/properties.h"
+#include "arolla/qtype/typed_ref.h"
+#include "arolla/qtype/typed_value.h"
 #include "arolla/util/repr.h"
 #include "arolla/util/status_macros_backport.h"
 
@@ -42,6 +73,367 @@ absl::StatusOr<DataSlice> AsScalarBool(const DataSlice& x,
   return x.WithSchema(internal::DataItem(schema::kBool));
 }
 
+constexpr absl::string_view kFusedPointwiseOpName =
+    "kde.math._fused_pointwise";
+
+// An operator that may appear in the expression evaluated by
+// kde.math._fused_pointwise. Each of them is the Koda version of `arolla_name`,
+// and behaves exactly like it on numeric inputs.
+struct FusablePointwiseOp {
+  absl::string_view name;
+  absl::string_view arolla_name;
+  absl::StatusOr<DataSlice> (*unary_fn)(const DataSlice&);
+  absl::StatusOr<DataSlice> (*binary_fn)(const DataSlice&, const DataSlice&);
+  bool returns_mask;
+};
+
+// NOTE: Must be kept in sync with the fusable operators in
+// koladata/expr/expr_eval.cc.
+constexpr std::array kFusablePointwiseOps = {
+    FusablePointwiseOp{"kde.core.add", "math.add", nullptr, &Add, false},
+    FusablePointwiseOp{"kde.math.subtract", "math.subtract", nullptr,
+                       &Subtract, false},
+    FusablePointwiseOp{"kde.math.multiply", "math.multiply", nullptr,
+                       &Multiply, false},
+    FusablePointwiseOp{"kde.math.divide", "math.divide", nullptr, &Divide,
+                       false},
+    FusablePointwiseOp{"kde.math.floordiv", "math.floordiv", nullptr,
+                       &FloorDiv, false},
+    FusablePointwiseOp{"kde.math.mod", "math.mod", nullptr, &Mod, false},
+    FusablePointwiseOp{"kde.math.pow", "math.pow", nullptr, &Pow, false},
+    FusablePointwiseOp{"kde.math.maximum", "math.maximum", nullptr, &Maximum,
+                       false},
+    FusablePointwiseOp{"kde.math.minimum", "math.minimum", nullptr, &Minimum,
+                       false},
+    FusablePointwiseOp{"kde.math.abs", "math.abs", &Abs, nullptr, false},
+    FusablePointwiseOp{"kde.math.ceil", "math.ceil", &Ceil, nullptr, false},
+    FusablePointwiseOp{"kde.math.floor", "math.floor", &Floor, nullptr, false},
+    FusablePointwiseOp{"kde.math.round", "math.round", &Round, nullptr, false},
+    FusablePointwiseOp{"kde.math.exp", "math.exp", &Exp, nullptr, false},
+    FusablePointwiseOp{"kde.math.log", "math.log", &Log, nullptr, false},
+    FusablePointwiseOp{"kde.comparison.less", "core.less", nullptr, &Less,
+                       true},
+    FusablePointwiseOp{"kde.comparison.less_equal", "core.less_equal", nullptr,
+                       &LessEqual, true},
+    FusablePointwiseOp{"kde.comparison.greater", "core.greater", nullptr,
+                       &Greater, true},
+    FusablePointwiseOp{"kde.comparison.greater_equal", "core.greater_equal",
+                       nullptr, &GreaterEqual, true},
+};
+
+absl::StatusOr<const FusablePointwiseOp*> GetFusablePointwiseOp(
+    const arolla::expr::ExprNodePtr& node) {
+  if (node->is_op()) {
+    ASSIGN_OR_RETURN(auto decayed_op,
+                     arolla::expr::DecayRegisteredOperator(node->op()));
+    for (const FusablePointwiseOp& op : kFusablePointwiseOps) {
+      if (op.name == decayed_op->display_name() &&
+          node->node_deps().size() == (op.unary_fn != nullptr ? 1 : 2)) {
+        return &op;
+      }
+    }
+  }
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "unsupported node in %s: %s", kFusedPointwiseOpName,
+      arolla::Repr(node)));
+}
+
+// Returns the index of the argument referred to by the placeholder `node`,
+// which must be named `x<index>`.
+absl::StatusOr<int64_t> GetFusedArgIndex(const arolla::expr::ExprNodePtr& node,
+                                         int64_t arg_count) {
+  int64_t index;
+  absl::string_view key = node->placeholder_key();
+  if (key.size() < 2 || key[0] != 'x' ||
+      !absl::SimpleAtoi(key.substr(1), &index) || index < 0 ||
+      index >= arg_count) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "unexpected placeholder in %s: P.%s", kFusedPointwiseOpName, key));
+  }
+  return index;
+}
+
+bool IsFusableNumericSchema(const internal::DataItem& schema) {
+  if (!schema.holds_value<schema::DType>()) {
+    return false;
+  }
+  schema::DType dtype = schema.value<schema::DType>();
+  return dtype == schema::kInt32 || dtype == schema::kInt64 ||
+         dtype == schema::kFloat32 || dtype == schema::kFloat64;
+}
+
+// Evaluates `expr` as a single compiled Arolla expression. Only done when all
+// `args` have numeric schemas: for them, the schema of every intermediate
+// result is the type of its Arolla value, so skipping the intermediate
+// DataSlices doesn't change the result. Returns std::nullopt if the fast path
+// is not applicable or fails, in which case `expr` should be evaluated node by
+// node to get the same result (or error) as without fusion.
+std::optional<DataSlice> EvalFusedNumeric(
+    const arolla::expr::ExprQuote& quote, const arolla::expr::ExprNodePtr& expr,
+    absl::Span<const DataSlice* const> args) {
+  std::vector<DataSlice> inputs;
+  inputs.reserve(args.size());
+  for (const DataSlice* arg : args) {
+    if (!IsFusableNumericSchema(arg->GetSchemaImpl())) {
+      return std::nullopt;
+    }
+    inputs.push_back(*arg);
+  }
+  auto root_op = GetFusablePointwiseOp(expr);
+  auto aligned = shape::AlignNonScalars(std::move(inputs));
+  if (!root_op.ok() || !aligned.ok()) {
+    return std::nullopt;
+  }
+  auto& [aligned_ds, aligned_shape] = *aligned;
+  std::vector<arolla::TypedValue> typed_value_holder;
+  std::vector<arolla::TypedRef> typed_refs;
+  typed_value_holder.reserve(aligned_ds.size());
+  typed_refs.reserve(aligned_ds.size());
+  for (const DataSlice& x : aligned_ds) {
+    auto ref = DataSliceToOwnedArollaRef(x, typed_value_holder);
+    if (!ref.ok()) {
+      return std::nullopt;
+    }
+    typed_refs.push_back(*ref);
+  }
+  auto make_op = [&]() -> absl::StatusOr<arolla::expr::ExprOperatorPtr> {
+    ASSIGN_OR_RETURN(
+        auto body,
+        arolla::expr::Transform(
+            expr,
+            [](arolla::expr::ExprNodePtr node)
+                -> absl::StatusOr<arolla::expr::ExprNodePtr> {
+              if (node->is_placeholder()) {
+                return node;
+              }
+              ASSIGN_OR_RETURN(const FusablePointwiseOp* op,
+                               GetFusablePointwiseOp(node));
+              ASSIGN_OR_RETURN(
+                  auto arolla_op,
+                  arolla::expr::LookupOperator(op->arolla_name));
+              return arolla::expr::MakeOpNode(std::move(arolla_op),
+                                              node->node_deps());
+            }));
+    arolla::expr::ExprOperatorSignature signature;
+    for (int64_t i = 0; i < args.size(); ++i) {
+      signature.parameters.push_back({.name = absl::StrCat("x", i)});
+    }
+    return arolla::expr::MakeLambdaOperator(std::move(signature),
+                                            std::move(body));
+  };
+  auto result = EvalExprOperator(
+      absl::StrCat(kFusedPointwiseOpName, ":",
+                   quote.expr_fingerprint().AsString()),
+      make_op, typed_refs);
+  if (!result.ok()) {
+    return std::nullopt;
+  }
+  internal::DataItem result_schema(schema::kMask);
+  if (!(*root_op)->returns_mask) {
+    auto result_qtype = arolla::GetScalarQType(result->GetType());
+    if (!result_qtype.ok()) {
+      return std::nullopt;
+    }
+    auto result_dtype = schema::DType::FromQType(*result_qtype);
+    if (!result_dtype.ok()) {
+      return std::nullopt;
+    }
+    result_schema = internal::DataItem(*result_dtype);
+  }
+  auto res = DataSliceFromArollaValue(result->AsRef(), std::move(aligned_shape),
+                                      result_schema);
+  if (!res.ok()) {
+    return std::nullopt;
+  }
+  return *std::move(res);
+}
+
+// Evaluates `expr` by calling the unfused implementation of every operator.
+absl::StatusOr<DataSlice> EvalFusedNodeByNode(
+    const arolla::expr::ExprNodePtr& expr,
+    absl::Span<const DataSlice* const> args) {
+  return arolla::expr::PostOrderTraverse(
+      expr,
+      [&](const arolla::expr::ExprNodePtr& node,
+          absl::Span<const DataSlice* const> deps)
+          -> absl::StatusOr<DataSlice> {
+        if (node->is_placeholder()) {
+          ASSIGN_OR_RETURN(int64_t index,
+                           GetFusedArgIndex(node, args.size()));
+          return *args[index];
+        }
+        ASSIGN_OR_RETURN(const FusablePointwiseOp* op,
+                         GetFusablePointwiseOp(node));
+        if (op->unary_fn != nullptr) {
+          return op->unary_fn(*deps[0]);
+        }
+        return op->binary_fn(*deps[0], *deps[1]);
+      });
+}
+
+absl::StatusOr<double> AsScalarProbability(const DataSlice& x,
+                                           absl::string_view attr_name) {
+  std::optional<double> value;
+  if (x.GetShape().rank() == 0) {
+    const internal::DataItem& item = x.item();
+    if (item.holds_value<int32_t>()) {
+      value = item.value<int32_t>();
+    } else if (item.holds_value<int64_t>()) {
+      value = item.value<int64_t>();
+    } else if (item.holds_value<float>()) {
+      value = item.value<float>();
+    } else if (item.holds_value<double>()) {
+      value = item.value<double>();
+    }
+  }
+  if (!value.has_value() || !(*value >= 0 && *value <= 1)) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected %s to be a scalar number in [0, 1], got %s", attr_name,
+        arolla::Repr(x)));
+  }
+  return *value;
+}
+
+// Calls `fn(values)` with the values of `x` as arolla::DenseArray<T>, where T
+// is the numeric type of the data of `x`, or with std::nullopt if `x` is
+// empty-and-unknown.
+template <typename Fn>
+absl::StatusOr<DataSlice> VisitNumericValues(const DataSlice& x,
+                                             absl::string_view op_name,
+                                             Fn fn) {
+  if (x.GetShape().rank() == 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("%s: expected rank(x) > 0", op_name));
+  }
+  ASSIGN_OR_RETURN(auto primitive_schema, GetPrimitiveArollaSchema(x));
+  if (!primitive_schema.has_value() || x.slice().is_empty_and_unknown()) {
+    return fn(std::optional<arolla::DenseArray<float>>());
+  }
+  auto dtype = primitive_schema.value<schema::DType>();
+  if (dtype == schema::kInt32) {
+    return fn(std::make_optional(x.slice().values<int32_t>()));
+  } else if (dtype == schema::kInt64) {
+    return fn(std::make_optional(x.slice().values<int64_t>()));
+  } else if (dtype == schema::kFloat32) {
+    return fn(std::make_optional(x.slice().values<float>()));
+  } else if (dtype == schema::kFloat64) {
+    return fn(std::make_optional(x.slice().values<double>()));
+  }
+  return absl::InvalidArgumentError(absl::StrFormat(
+      "%s: expected a numeric DataSlice, got %s", op_name, arolla::Repr(x)));
+}
+
+// Returns a DataSlice with the shape of `x` without the last dimension, where
+// each item is `agg_fn(begin, end)` for the corresponding [begin, end) range
+// of the last dimension of `x`.
+template <typename ResultT, typename AggFn>
+absl::StatusOr<DataSlice> AggregateLastDimension(const DataSlice& x,
+                                                 internal::DataItem schema,
+                                                 AggFn agg_fn) {
+  const auto& shape = x.GetShape();
+  auto split_points = shape.edges().back().edge_values().values.span();
+  int64_t group_count = split_points.size() - 1;
+  arolla::DenseArrayBuilder<ResultT> builder(group_count);
+  for (int64_t group = 0; group < group_count; ++group) {
+    std::optional<ResultT> result =
+        agg_fn(split_points[group], split_points[group + 1]);
+    if (result.has_value()) {
+      builder.Set(group, *result);
+    }
+  }
+  return DataSlice::Create(
+      internal::DataSliceImpl::Create(std::move(builder).Build()),
+      shape.RemoveDims(shape.rank() - 1), std::move(schema));
+}
+
+// Calls `fn(values)` with the values of `x` as arolla::DenseArray<T> if `x`
+// has rank > 0 and holds INT32 or INT64 values of the same schema, and returns
+// its result. Returns std::nullopt otherwise, in which case the Arolla
+// operator should be evaluated instead.
+template <typename Fn>
+absl::StatusOr<std::optional<DataSlice>> VisitNativeIntegerValues(
+    const DataSlice& x, Fn fn) {
+  if (x.GetShape().rank() == 0 || !x.slice().is_single_dtype()) {
+    return std::nullopt;
+  }
+  const internal::DataItem& schema = x.GetSchemaImpl();
+  if (x.slice().dtype() == arolla::GetQType<int32_t>() &&
+      schema == schema::kInt32) {
+    return fn(x.slice().values<int32_t>());
+  }
+  if (x.slice().dtype() == arolla::GetQType<int64_t>() &&
+      schema == schema::kInt64) {
+    return fn(x.slice().values<int64_t>());
+  }
+  return std::nullopt;
+}
+
+// Reduces the groups of the last dimension of `x` with
+// internal::SegmentedReduce if `x` holds integers, see
+// VisitNativeIntegerValues. Integer sums, minimums and maximums don't depend
+// on the order of the operations, so the result is exactly the same as the
+// one of the Arolla operator.
+template <template <typename> class Reducer>
+absl::StatusOr<std::optional<DataSlice>> NativeIntegerAggInto(
+    const DataSlice& x, bool empty_is_identity) {
+  return VisitNativeIntegerValues(
+      x, [&]<typename T>(const arolla::DenseArray<T>& values)
+             -> absl::StatusOr<std::optional<DataSlice>> {
+        const auto& shape = x.GetShape();
+        std::shared_ptr<internal::Executor> executor =
+            internal::CurrentExecutor();
+        auto result = internal::SegmentedReduce<Reducer<T>>(
+            values, shape.edges().back().edge_values().values.span(),
+            empty_is_identity, executor.get());
+        return DataSlice::Create(
+            internal::DataSliceImpl::Create(std::move(result)),
+            shape.RemoveDims(shape.rank() - 1), x.GetSchemaImpl());
+      });
+}
+
+// Single-pass variance of the groups of the last dimension of `x`. Returns
+// FLOAT64 for FLOAT64 inputs and FLOAT32 otherwise, like kde.math._agg_var.
+absl::StatusOr<DataSlice> AggApproxVarImpl(const DataSlice& x,
+                                           const DataSlice& unbiased,
+                                           absl::string_view op_name,
+                                           bool take_sqrt) {
+  ASSIGN_OR_RETURN(auto unbiased_bool, AsScalarBool(unbiased, "unbiased"));
+  bool is_unbiased = unbiased_bool.item().value<bool>();
+  return VisitNumericValues(
+      x, op_name, [&]<typename T>(const std::optional<arolla::DenseArray<T>>&
+                                       values) -> absl::StatusOr<DataSlice> {
+        using ResultT =
+            std::conditional_t<std::is_same_v<T, double>, double, float>;
+        // NONE is kept for empty-and-unknown inputs, like in
+        // kde.math._agg_var.
+        internal::DataItem schema = x.GetSchemaImpl();
+        if (schema != schema::kNone) {
+          ASSIGN_OR_RETURN(
+              schema,
+              schema::CommonSchema(
+                  schema, internal::DataItem(schema::GetDType<ResultT>())));
+        }
+        return AggregateLastDimension<ResultT>(
+            x, std::move(schema),
+            [&](int64_t begin, int64_t end) -> std::optional<ResultT> {
+              if (!values.has_value()) {
+                return std::nullopt;
+              }
+              internal::WelfordAccumulator acc;
+              for (int64_t i = begin; i < end; ++i) {
+                if (values->present(i)) {
+                  acc.Add(static_cast<double>(values->values[i]));
+                }
+              }
+              std::optional<double> var = acc.Variance(is_unbiased);
+              if (!var.has_value()) {
+                return std::nullopt;
+              }
+              return static_cast<ResultT>(take_sqrt ? std::sqrt(*var) : *var);
+            });
+      });
+}
+
 }  // namespace
 
 absl::StatusOr<DataSlice> Subtract(const DataSlice& x, const DataSlice& y) {
@@ -109,10 +501,35 @@ absl::StatusOr<DataSlice> CumMin(const DataSlice& x) {
 }
 
 absl::StatusOr<DataSlice> CumSum(const DataSlice& x) {
+  ASSIGN_OR_RETURN(
+      auto native_res,
+      VisitNativeIntegerValues(
+          x, [&]<typename T>(const arolla::DenseArray<T>& values)
+                 -> absl::StatusOr<std::optional<DataSlice>> {
+            std::shared_ptr<internal::Executor> executor =
+                internal::CurrentExecutor();
+            auto result =
+                internal::SegmentedCumulativeReduce<internal::SumReducer<T>>(
+                    values,
+                    x.GetShape().edges().back().edge_values().values.span(),
+                    executor.get());
+            return DataSlice::Create(
+                internal::DataSliceImpl::Create(std::move(result)),
+                x.GetShape(), x.GetSchemaImpl());
+          }));
+  if (native_res.has_value()) {
+    return *std::move(native_res);
+  }
   return SimpleAggOverEval("math.cum_sum", {x});
 }
 
 absl::StatusOr<DataSlice> AggSum(const DataSlice& x) {
+  ASSIGN_OR_RETURN(auto native_res,
+                   NativeIntegerAggInto<internal::SumReducer>(
+                       x, /*empty_is_identity=*/true));
+  if (native_res.has_value()) {
+    return *std::move(native_res);
+  }
   ASSIGN_OR_RETURN(auto primitive_schema, GetPrimitiveArollaSchema(x));
   // The input has primitive schema or OBJECT/ANY schema with a single primitive
   // dtype.
@@ -133,6 +550,27 @@ absl::StatusOr<DataSlice> AggSum(const DataSlice& x) {
                            /*output_schema=*/output_schema);
 }
 
+absl::StatusOr<DataSlice> FusedPointwise(
+    absl::Span<const DataSlice* const> args) {
+  if (args.empty()) {
+    return absl::InvalidArgumentError("expected at least one input");
+  }
+  const DataSlice& fn = *args[0];
+  if (fn.GetShape().rank() != 0 ||
+      !fn.item().holds_value<arolla::expr::ExprQuote>()) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("expected fn to be a scalar quoted expression, got %s",
+                        arolla::Repr(fn)));
+  }
+  const auto& quote = fn.item().value<arolla::expr::ExprQuote>();
+  ASSIGN_OR_RETURN(auto expr, quote.expr());
+  args.remove_prefix(1);
+  if (auto res = EvalFusedNumeric(quote, expr, args); res.has_value()) {
+    return *std::move(res);
+  }
+  return EvalFusedNodeByNode(expr, args);
+}
+
 absl::StatusOr<DataSlice> AggMean(const DataSlice& x) {
   return SimpleAggIntoEval("math.mean", {x});
 }
@@ -159,11 +597,67 @@ absl::StatusOr<DataSlice> AggVar(const DataSlice& x,
                            /*primary_operand_indices=*/{{0}});
 }
 
+absl::StatusOr<DataSlice> AggApproxVar(const DataSlice& x,
+                                       const DataSlice& unbiased) {
+  return AggApproxVarImpl(x, unbiased, "kd.math.agg_approx_var",
+                          /*take_sqrt=*/false);
+}
+
+absl::StatusOr<DataSlice> AggApproxStd(const DataSlice& x,
+                                       const DataSlice& unbiased) {
+  return AggApproxVarImpl(x, unbiased, "kd.math.agg_approx_std",
+                          /*take_sqrt=*/true);
+}
+
+absl::StatusOr<DataSlice> AggApproxQuantile(const DataSlice& x,
+                                            const DataSlice& q) {
+  ASSIGN_OR_RETURN(double q_value, AsScalarProbability(q, "q"));
+  return VisitNumericValues(
+      x, "kd.math.agg_approx_quantile",
+      [&]<typename T>(const std::optional<arolla::DenseArray<T>>& values)
+          -> absl::StatusOr<DataSlice> {
+        return AggregateLastDimension<T>(
+            x, x.GetSchemaImpl(),
+            [&](int64_t begin, int64_t end) -> std::optional<T> {
+              if (!values.has_value()) {
+                return std::nullopt;
+              }
+              internal::QuantileSketch<T> sketch;
+              for (int64_t i = begin; i < end; ++i) {
+                if (!values->present(i)) {
+                  continue;
+                }
+                T value = values->values[i];
+                if constexpr (std::is_floating_point_v<T>) {
+                  // NaNs are unordered, so they propagate to the result.
+                  if (std::isnan(value)) {
+                    return value;
+                  }
+                }
+                sketch.Add(value);
+              }
+              return sketch.Quantile(q_value);
+            });
+      });
+}
+
 absl::StatusOr<DataSlice> AggMax(const DataSlice& x) {
+  ASSIGN_OR_RETURN(auto native_res,
+                   NativeIntegerAggInto<internal::MaxReducer>(
+                       x, /*empty_is_identity=*/false));
+  if (native_res.has_value()) {
+    return *std::move(native_res);
+  }
   return SimpleAggIntoEval("math.max", {x});
 }
 
 absl::StatusOr<DataSlice> AggMin(const DataSlice& x) {
+  ASSIGN_OR_RETURN(auto native_res,
+                   NativeIntegerAggInto<internal::MinReducer>(
+                       x, /*empty_is_identity=*/false));
+  if (native_res.has_value()) {
+    return *std::move(native_res);
+  }
   return SimpleAggIntoEval("math.min", {x});
 }
 
@@ -16,6 +16,7 @@
 #define KOLADATA_OPERATORS_MATH_H_
 
 #include "absl/status/statusor.h"
+#include "absl/types/span.h"
 #include "koladata/data_slice.h"
 
 namespace koladata::ops {
@@ -74,6 +75,16 @@ absl::StatusOr<DataSlice> AggSum(const DataSlice& x);
 // kde.math._cum_sum.
 absl::StatusOr<DataSlice> CumSum(const DataSlice& x);
 
+// kde.math._fused_pointwise.
+//
+// Evaluates the chain of pointwise operators quoted in `args[0]` on the
+// remaining args, which are referred to as `P.x0`, `P.x1`, ... in it. When all
+// the inputs are numeric, the chain is compiled into a single Arolla
+// expression and evaluated in one pass. Otherwise the operators are evaluated
+// one by one, as if they were not fused.
+absl::StatusOr<DataSlice> FusedPointwise(
+    absl::Span<const DataSlice* const> args);
+
 // kde.math._agg_mean.
 absl::StatusOr<DataSlice> AggMean(const DataSlice& x);
 
@@ -86,6 +97,25 @@ absl::StatusOr<DataSlice> AggStd(const DataSlice& x, const DataSlice& unbiased);
 // kde.math._agg_var.
 absl::StatusOr<DataSlice> AggVar(const DataSlice& x, const DataSlice& unbiased);
 
+// kde.math._agg_approx_var.
+//
+// Computes the variance in a single pass over each group with Welford's
+// algorithm, which is numerically stable and accumulates in double precision.
+absl::StatusOr<DataSlice> AggApproxVar(const DataSlice& x,
+                                       const DataSlice& unbiased);
+
+// kde.math._agg_approx_std.
+absl::StatusOr<DataSlice> AggApproxStd(const DataSlice& x,
+                                       const DataSlice& unbiased);
+
+// kde.math._agg_approx_quantile.
+//
+// Approximates the `q`-th quantile of each group with a bounded-memory
+// QuantileSketch. The result is exact for groups smaller than
+// kDefaultQuantileSketchCapacity, and is one of the values of the group.
+absl::StatusOr<DataSlice> AggApproxQuantile(const DataSlice& x,
+                                            const DataSlice& q);
+
 // kde.math._agg_max.
 absl::StatusOr<DataSlice> AggMax(const DataSlice& x);
 
@@ -23,9 +23,11 @@
 #include "koladata/operators/assertion.h"
 #include "koladata/operators/comparison.h"
 #include "koladata/operators/core.h"
+#include "koladata/operators/custom_kernels.h"
 #include "koladata/operators/logical.h"
 #include "koladata/operators/math.h"
 #include "koladata/operators/predicates.h"
+#include "koladata/operators/random.h"
 #include "koladata/operators/schema.h"
 #include "koladata/operators/shapes.h"
 #include "koladata/operators/strings.h"
@@ -53,24 +55,31 @@ OPERATOR("kde.comparison.greater_equal", GreaterEqual);
 OPERATOR("kde.comparison.less", Less);
 OPERATOR("kde.comparison.less_equal", LessEqual);
 //
+OPERATOR("kde.core._agg_approx_count_distinct", AggApproxCountDistinct);
 OPERATOR("kde.core._clone", Clone);
 OPERATOR("kde.core._collapse", Collapse);
 OPERATOR_FAMILY("kde.core._concat_or_stack",
                 arolla::MakeVariadicInputOperatorFamily(ConcatOrStack));
 OPERATOR("kde.core._deep_clone", DeepClone);
 OPERATOR("kde.core._dense_rank", DenseRank);
+OPERATOR_FAMILY("kde.core._eval_custom_kernel",
+                arolla::MakeVariadicInputOperatorFamily(EvalCustomKernel));
 OPERATOR("kde.core._explode", Explode);
 OPERATOR("kde.core._extract", Extract);
 OPERATOR("kde.core._get_attr", GetAttr);
 OPERATOR("kde.core._get_attr_with_default", GetAttrWithDefault);
+OPERATOR_FAMILY("kde.core._get_attrs",
+                std::make_unique<GetAttrsOperatorFamily>());
 OPERATOR("kde.core._get_item", GetItem);
 OPERATOR("kde.core._get_list_item_by_range", GetListItemByRange);
 OPERATOR("kde.core._get_values", GetValues);
 OPERATOR("kde.core._get_values_by_keys", GetValuesByKeys);
 OPERATOR("kde.core._inverse_mapping", InverseMapping);
+OPERATOR("kde.core._join_indices", JoinIndices);
 OPERATOR("kde.core._ordinal_rank", OrdinalRank);
 OPERATOR("kde.core._select", Select);
 OPERATOR("kde.core._shallow_clone", ShallowClone);
+OPERATOR("kde.core._top_k_indices", TopKIndices);
 OPERATOR_FAMILY("kde.core._uuid", std::make_unique<UuidOperatorFamily>());
 OPERATOR_FAMILY("kde.core._uuobj", std::make_unique<UuObjOperatorFamily>());
 OPERATOR("kde.core.add", Add);
@@ -91,7 +100,10 @@ OPERATOR_FAMILY("kde.core.group_by_indices_sorted",
 OPERATOR("kde.core.is_empty", IsEmpty);
 OPERATOR("kde.core.is_primitive", IsPrimitive);
 OPERATOR("kde.core.itemid_bits", ItemIdBits);
+OPERATOR("kde.core.itemid_hash", ItemIdHash);
 OPERATOR("kde.core.list_size", ListSize);
+OPERATOR("kde.core.lookup_by_attr", LookupByAttr);
+OPERATOR("kde.core.lookup_by_attr_range", LookupByAttrRange);
 OPERATOR("kde.core.no_db", NoDb);
 OPERATOR("kde.core.nofollow", NoFollow);
 OPERATOR("kde.core.nofollow_schema", CreateNoFollowSchema);
@@ -110,10 +122,15 @@ OPERATOR("kde.core.with_db", WithDb);
 OPERATOR("kde.logical._agg_all", AggAll);
 OPERATOR("kde.logical._agg_any", AggAny);
 OPERATOR("kde.logical._has_not", HasNot);
+OPERATOR_FAMILY("kde.logical._multi_coalesce",
+                arolla::MakeVariadicInputOperatorFamily(MultiCoalesce));
 OPERATOR("kde.logical.apply_mask", ApplyMask);
 OPERATOR("kde.logical.coalesce", Coalesce);
 OPERATOR("kde.logical.has", Has);
 //
+OPERATOR("kde.math._agg_approx_quantile", AggApproxQuantile);
+OPERATOR("kde.math._agg_approx_std", AggApproxStd);
+OPERATOR("kde.math._agg_approx_var", AggApproxVar);
 OPERATOR("kde.math._agg_max", AggMax);
 OPERATOR("kde.math._agg_mean", AggMean);
 OPERATOR("kde.math._agg_median", AggMedian);
@@ -124,6 +141,8 @@ OPERATOR("kde.math._agg_var", AggVar);
 OPERATOR("kde.math._cum_max", CumMax);
 OPERATOR("kde.math._cum_min", CumMin);
 OPERATOR("kde.math._cum_sum", CumSum);
+OPERATOR_FAMILY("kde.math._fused_pointwise",
+                arolla::MakeVariadicInputOperatorFamily(FusedPointwise));
 OPERATOR("kde.math.abs", Abs);
 OPERATOR("kde.math.ceil", Ceil);
 OPERATOR("kde.math.divide", Divide);
@@ -139,6 +158,8 @@ OPERATOR("kde.math.pow", Pow);
 OPERATOR("kde.math.round", Round);
 OPERATOR("kde.math.subtract", Subtract);
 //
+OPERATOR("kde.random._philox_sample_mask", PhiloxSampleMask);
+//
 OPERATOR_FAMILY("kde.schema._new_schema",
                 std::make_unique<NewSchemaOperatorFamily>());
 OPERATOR("kde.schema.cast_to", CastTo);
@@ -180,6 +201,7 @@ OPERATOR_FAMILY("kde.strings.printf",
                 arolla::MakeVariadicInputOperatorFamily(Printf));
 OPERATOR("kde.strings.regex_extract", RegexExtract);
 OPERATOR("kde.strings.regex_match", RegexMatch);
+OPERATOR("kde.strings.regex_match_any", RegexMatchAny);
 OPERATOR("kde.strings.replace", Replace);
 OPERATOR("kde.strings.rfind", Rfind);
 OPERATOR("kde.strings.rstrip", Rstrip);
@@ -0,0 +1,87 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/operators/random.h"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+
+#include "absl/numeric/int128.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "koladata/arolla_utils.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/op_utils/philox.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/repr.h"
+#include "arolla/util/unit.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::ops {
+
+absl::StatusOr<DataSlice> PhiloxSampleMask(const DataSlice& x,
+                                           const DataSlice& ratio,
+                                           const DataSlice& seed,
+                                           const DataSlice& key) {
+  if (x.GetShape().rank() == 0) {
+    return absl::InvalidArgumentError("expected rank(x) > 0");
+  }
+  auto ratio_value = ToArollaScalar<double>(ratio);
+  if (!ratio_value.ok()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "`ratio` must be a scalar FLOAT64, but got %s", arolla::Repr(ratio)));
+  }
+  auto seed_value = ToArollaScalar<int64_t>(seed);
+  if (!seed_value.ok()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "`seed` must be a scalar INT64, but got %s", arolla::Repr(seed)));
+  }
+  const int64_t size = x.size();
+  auto executor = internal::CurrentExecutor();
+  arolla::DenseArray<arolla::Unit> mask;
+  if (key.GetShape().rank() == 0) {
+    mask = internal::ParallelSampleMask(
+        size, *ratio_value, static_cast<uint64_t>(*seed_value),
+        [](int64_t i) -> std::optional<absl::uint128> {
+          return absl::uint128(i);
+        },
+        executor.get());
+  } else {
+    if (!ShapesAreEquivalent(key.GetShape(), x.GetShape())) {
+      return absl::InvalidArgumentError(
+          "'x' and 'key' must have the same shape.");
+    }
+    const internal::DataSliceImpl& key_impl = key.slice();
+    mask = internal::ParallelSampleMask(
+        size, *ratio_value, static_cast<uint64_t>(*seed_value),
+        [&key_impl](int64_t i) -> std::optional<absl::uint128> {
+          internal::DataItem item = key_impl[i];
+          if (!item.has_value()) {
+            return std::nullopt;
+          }
+          return item.StableFingerprint().value;
+        },
+        executor.get());
+  }
+  return DataSlice::Create(internal::DataSliceImpl::Create(std::move(mask)),
+                           x.GetShape(), internal::DataItem(schema::kMask));
+}
+
+}  // namespace koladata::ops
@@ -0,0 +1,38 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_OPERATORS_RANDOM_H_
+#define KOLADATA_OPERATORS_RANDOM_H_
+
+#include "absl/status/statusor.h"
+#include "koladata/data_slice.h"
+
+namespace koladata::ops {
+
+// kde.random._philox_sample_mask.
+//
+// Returns a MASK DataSlice with the shape of `x` where each item is present
+// with probability `ratio`. The random bits of an item are generated by the
+// Philox counter-based generator from `seed` and the fingerprint of the
+// corresponding item of `key` (items with missing keys are never present).
+// If `key` is a DataItem, the flat index of the item is used instead. The
+// result does not depend on the number of threads it is computed with.
+absl::StatusOr<DataSlice> PhiloxSampleMask(const DataSlice& x,
+                                           const DataSlice& ratio,
+                                           const DataSlice& seed,
+                                           const DataSlice& key);
+
+}  // namespace koladata::ops
+
+#endif  // KOLADATA_OPERATORS_RANDOM_H_
@@ -15,16 +15,20 @@
 #include "koladata/operators/strings.h"
 
 #include <cstddef>
+#include <cstdint>
 #include <memory>
 #include <optional>
 #include <string>
 #include <utility>
 #include <vector>
 
+#include "absl/base/no_destructor.h"
+#include "absl/hash/hash.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
@@ -33,24 +37,36 @@
 #include "koladata/casting.h"
 #include "koladata/data_slice.h"
 #include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/op_utils/printf_template.h"
+#include "koladata/internal/op_utils/string_kernels.h"
 #include "koladata/internal/schema_utils.h"
+#include "koladata/internal/sharded_lru_cache.h"
 #include "koladata/operators/arolla_bridge.h"
 #include "koladata/operators/utils.h"
 #include "koladata/shape_utils.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/qtype/types.h"
 #include "arolla/memory/frame.h"
+#include "arolla/memory/optional_value.h"
 #include "arolla/qexpr/bound_operators.h"
 #include "arolla/qexpr/eval_context.h"
 #include "arolla/qexpr/operators.h"
 #include "arolla/qexpr/qexpr_operator_signature.h"
+#include "arolla/qtype/optional_qtype.h"
 #include "arolla/qtype/qtype.h"
 #include "arolla/qtype/qtype_traits.h"
 #include "arolla/qtype/tuple_qtype.h"
 #include "arolla/qtype/typed_ref.h"
 #include "arolla/qtype/typed_slot.h"
 #include "arolla/qtype/typed_value.h"
+#include "arolla/util/bytes.h"
 #include "arolla/util/repr.h"
 #include "arolla/util/text.h"
+#include "arolla/util/unit.h"
+#include "re2/re2.h"
+#include "re2/set.h"
 #include "arolla/util/status_macros_backport.h"
 
 namespace koladata::ops {
@@ -73,6 +89,230 @@ absl::StatusOr<DataSlice> EvalFormatOp(absl::string_view op_name,
   return SimplePointwiseEval(op_name, std::move(slices), fmt.GetSchemaImpl());
 }
 
+// Returns the values of `x` if it is a DataSlice (not an item) holding only
+// values of type T, so that they can be processed directly by the kernels in
+// string_kernels.h.
+template <typename T>
+const arolla::DenseArray<T>* GetStringArray(const DataSlice& x) {
+  if (x.GetShape().rank() == 0 || !x.slice().is_single_dtype() ||
+      x.slice().dtype() != arolla::GetQType<T>()) {
+    return nullptr;
+  }
+  return &x.slice().values<T>();
+}
+
+// Evaluates `kernel` on the Text values of `x` if possible. Returns nullopt
+// if `x` is not a Text DataSlice or the kernel does not support its values.
+template <typename Kernel>
+std::optional<absl::StatusOr<DataSlice>> EvalAsciiTextKernel(
+    const DataSlice& x, Kernel kernel) {
+  const arolla::DenseArray<arolla::Text>* values =
+      GetStringArray<arolla::Text>(x);
+  if (values == nullptr) {
+    return std::nullopt;
+  }
+  std::optional<arolla::DenseArray<arolla::Text>> result = kernel(*values);
+  if (!result.has_value()) {
+    return std::nullopt;
+  }
+  return DataSlice::Create(internal::DataSliceImpl::Create(*std::move(result)),
+                           x.GetShape(), internal::DataItem(schema::kText));
+}
+
+// Splits the values of the flat DataSlice `x` with SplitStrings if they are
+// all of type T and `sep` is either missing or a non-empty value of the same
+// type. Returns std::nullopt otherwise.
+template <typename T>
+std::optional<internal::SplitResult<T>> SplitNative(
+    const DataSlice& x, const DataSlice& sep,
+    const internal::DataItem& sep_primitive_schema) {
+  const arolla::DenseArray<T>* values = GetStringArray<T>(x);
+  if (values == nullptr) {
+    return std::nullopt;
+  }
+  std::optional<absl::string_view> sep_value;
+  if (sep.item().holds_value<T>()) {
+    sep_value = sep.item().value<T>();
+    if (sep_value->empty()) {
+      return std::nullopt;
+    }
+  } else if (sep.item().has_value() ||
+             (sep_primitive_schema.has_value() &&
+              sep_primitive_schema != schema::GetDType<T>())) {
+    return std::nullopt;
+  }
+  return internal::SplitStrings(*values, sep_value);
+}
+
+// Number of compiled regular expressions (and regular expression sets) kept
+// by CompileRegex and CompileRegexSet.
+constexpr size_t kRegexCacheSize = 1024;
+
+// Allows looking up patterns by absl::string_view.
+struct PatternHash {
+  using is_transparent = void;
+
+  size_t operator()(absl::string_view pattern) const {
+    return absl::HashOf(pattern);
+  }
+};
+
+// Returns the compiled `pattern`. Recently used patterns are cached, so that
+// evaluating an operator repeatedly with the same pattern compiles it once.
+absl::StatusOr<std::shared_ptr<const RE2>> CompileRegex(
+    absl::string_view pattern) {
+  using Cache = internal::ShardedLruCache<
+      std::string, std::shared_ptr<const RE2>, PatternHash>;
+  static absl::NoDestructor<Cache> cache(kRegexCacheSize);
+  if (auto regex = cache->LookupOrNull(pattern)) {
+    return regex;
+  }
+  auto regex = std::make_shared<const RE2>(pattern, RE2::Quiet);
+  if (!regex->ok()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "invalid regular expression: `", pattern, "`: ", regex->error()));
+  }
+  return cache->Put(std::string(pattern), std::move(regex));
+}
+
+// Returns `patterns` compiled into a single unanchored RE2::Set. Cached the
+// same way as CompileRegex.
+absl::StatusOr<std::shared_ptr<const RE2::Set>> CompileRegexSet(
+    absl::Span<const absl::string_view> patterns) {
+  using Cache = internal::ShardedLruCache<std::string,
+                                          std::shared_ptr<const RE2::Set>>;
+  static absl::NoDestructor<Cache> cache(kRegexCacheSize);
+  // Length prefixes make the key unambiguous.
+  std::string key;
+  for (absl::string_view pattern : patterns) {
+    absl::StrAppend(&key, pattern.size(), ":", pattern);
+  }
+  if (auto regex_set = cache->LookupOrNull(key)) {
+    return regex_set;
+  }
+  auto regex_set =
+      std::make_shared<RE2::Set>(RE2::Options(RE2::Quiet), RE2::UNANCHORED);
+  for (absl::string_view pattern : patterns) {
+    std::string error;
+    if (regex_set->Add(pattern, &error) < 0) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "invalid regular expression: `", pattern, "`: ", error));
+    }
+  }
+  if (!regex_set->Compile()) {
+    return absl::InvalidArgumentError(
+        "failed to compile the regular expressions: out of memory");
+  }
+  return cache->Put(std::move(key), std::move(regex_set));
+}
+
+// Number of parsed printf formats kept by CompilePrintfTemplate.
+constexpr size_t kPrintfTemplateCacheSize = 1024;
+
+// Returns the parsed printf `format`, or nullptr if it is not supported by
+// PrintfTemplate. Recently used formats are cached.
+std::shared_ptr<const internal::PrintfTemplate> CompilePrintfTemplate(
+    absl::string_view format) {
+  using Cache =
+      internal::ShardedLruCache<std::string,
+                                std::shared_ptr<const internal::PrintfTemplate>,
+                                PatternHash>;
+  static absl::NoDestructor<Cache> cache(kPrintfTemplateCacheSize);
+  if (auto printf_template = cache->LookupOrNull(format)) {
+    return printf_template;
+  }
+  auto printf_template = internal::PrintfTemplate::Parse(format);
+  if (!printf_template.has_value()) {
+    return nullptr;
+  }
+  return cache->Put(std::string(format),
+                    std::make_shared<const internal::PrintfTemplate>(
+                        *std::move(printf_template)));
+}
+
+// Evaluates strings.printf with a cached PrintfTemplate if `fmt` is a T item
+// and `args` are non-scalar DataSlices of supported, single dtypes. Returns
+// std::nullopt otherwise, including the erroneous cases, which are reported by
+// the Arolla implementation.
+template <typename T>
+std::optional<absl::StatusOr<DataSlice>> PrintfNative(
+    const DataSlice& fmt, absl::Span<const DataSlice> args) {
+  if (fmt.GetShape().rank() != 0 || !fmt.item().holds_value<T>()) {
+    return std::nullopt;
+  }
+  auto printf_template = CompilePrintfTemplate(fmt.item().value<T>());
+  if (printf_template == nullptr ||
+      args.size() < printf_template->arg_count()) {
+    return std::nullopt;
+  }
+  absl::StatusOr<std::vector<DataSlice>> aligned_args = shape::Align(args);
+  if (!aligned_args.ok() || aligned_args->empty() ||
+      aligned_args->front().GetShape().rank() == 0) {
+    return std::nullopt;
+  }
+  DataSlice::JaggedShape shape = aligned_args->front().GetShape();
+  std::vector<internal::PrintfTemplate::Column> columns;
+  columns.reserve(aligned_args->size());
+  for (const DataSlice& arg : *aligned_args) {
+    if (!arg.slice().is_single_dtype()) {
+      return std::nullopt;
+    }
+    arolla::QTypePtr dtype = arg.slice().dtype();
+    if (dtype == arolla::GetQType<int32_t>()) {
+      columns.push_back(&arg.slice().values<int32_t>());
+    } else if (dtype == arolla::GetQType<int64_t>()) {
+      columns.push_back(&arg.slice().values<int64_t>());
+    } else if (dtype == arolla::GetQType<arolla::Text>()) {
+      columns.push_back(&arg.slice().values<arolla::Text>());
+    } else if (dtype == arolla::GetQType<arolla::Bytes>()) {
+      columns.push_back(&arg.slice().values<arolla::Bytes>());
+    } else {
+      return std::nullopt;
+    }
+  }
+  std::optional<arolla::DenseArray<T>> result =
+      printf_template->Format<T>(columns, shape.size());
+  if (!result.has_value()) {
+    return std::nullopt;
+  }
+  return DataSlice::Create(internal::DataSliceImpl::Create(*std::move(result)),
+                           std::move(shape), fmt.GetSchemaImpl());
+}
+
+// Returns the result of calling `fn(absl::string_view)` on the present values
+// of `text_ref`, which holds the text in the form produced by
+// DataSliceToOwnedArollaRef. `fn` returns std::optional<ValueT> where ValueT
+// is convertible to ResultT. Returns std::nullopt if `text_ref` does not hold
+// TEXT values.
+template <typename ResultT, typename Fn>
+std::optional<arolla::TypedValue> MapText(arolla::TypedRef text_ref, Fn fn) {
+  if (text_ref.GetType() == arolla::GetDenseArrayQType<arolla::Text>()) {
+    const auto& values = text_ref.UnsafeAs<arolla::DenseArray<arolla::Text>>();
+    arolla::DenseArrayBuilder<ResultT> builder(values.size());
+    values.ForEachPresent([&](int64_t id, absl::string_view value) {
+      if (auto result = fn(value); result.has_value()) {
+        builder.Set(id, *result);
+      }
+    });
+    return arolla::TypedValue::FromValue(std::move(builder).Build());
+  }
+  arolla::OptionalValue<arolla::Text> value;
+  if (text_ref.GetType() == arolla::GetQType<arolla::Text>()) {
+    value = text_ref.UnsafeAs<arolla::Text>();
+  } else if (text_ref.GetType() == arolla::GetOptionalQType<arolla::Text>()) {
+    value = text_ref.UnsafeAs<arolla::OptionalValue<arolla::Text>>();
+  } else {
+    return std::nullopt;
+  }
+  arolla::OptionalValue<ResultT> result;
+  if (value.present) {
+    if (auto res = fn(value.value.view()); res.has_value()) {
+      result = ResultT(*res);
+    }
+  }
+  return arolla::TypedValue::FromValue(std::move(result));
+}
+
 class FormatOperator : public arolla::QExprOperator {
  public:
   explicit FormatOperator(absl::Span<const arolla::QTypePtr> input_types)
@@ -163,6 +403,13 @@ absl::StatusOr<DataSlice> Printf(std::vector<DataSlice> slices) {
     return absl::InvalidArgumentError("expected at least one input");
   }
   const auto& fmt = slices[0];
+  auto args = absl::MakeConstSpan(slices).subspan(1);
+  if (auto result = PrintfNative<arolla::Text>(fmt, args)) {
+    return *std::move(result);
+  }
+  if (auto result = PrintfNative<arolla::Bytes>(fmt, args)) {
+    return *std::move(result);
+  }
   return EvalFormatOp("strings.printf", fmt, std::move(slices));
 }
 
@@ -199,11 +446,29 @@ absl::StatusOr<DataSlice> Join(std::vector<DataSlice> slices) {
 }
 
 absl::StatusOr<DataSlice> Length(const DataSlice& x) {
+  // Computed directly from the string offsets, without materializing the
+  // strings.
+  std::optional<arolla::DenseArray<int32_t>> lengths;
+  if (const auto* text = GetStringArray<arolla::Text>(x); text != nullptr) {
+    lengths = internal::StringLengths(*text);
+  } else if (const auto* bytes = GetStringArray<arolla::Bytes>(x);
+             bytes != nullptr) {
+    lengths = internal::StringLengths(*bytes);
+  }
+  if (lengths.has_value()) {
+    return DataSlice::Create(
+        internal::DataSliceImpl::Create(*std::move(lengths)), x.GetShape(),
+        internal::DataItem(schema::kInt32));
+  }
   return SimplePointwiseEval("strings.length", {x},
                              internal::DataItem(schema::kInt32));
 }
 
 absl::StatusOr<DataSlice> Lower(const DataSlice& x) {
+  if (auto result = EvalAsciiTextKernel(x, internal::AsciiLower);
+      result.has_value()) {
+    return *std::move(result);
+  }
   // TODO: Add support for BYTES.
   return SimplePointwiseEval("strings.lower", {x},
                              internal::DataItem(schema::kText));
@@ -236,12 +501,31 @@ absl::StatusOr<DataSlice> RegexExtract(const DataSlice& text,
       arolla::TypedRef text_ref,
       DataSliceToOwnedArollaRef(text, typed_value_holder,
                                 internal::DataItem(schema::kText)));
-  arolla::TypedValue typed_regex =
-      arolla::TypedValue::FromValue(regex.item().value<arolla::Text>());
-  ASSIGN_OR_RETURN(arolla::TypedValue result,
-                   EvalExpr("strings.extract_regex",
-                            {std::move(text_ref), typed_regex.AsRef()}));
-  return DataSliceFromArollaValue(result.AsRef(), text.GetShape(),
+  absl::string_view pattern = regex.item().value<arolla::Text>();
+  ASSIGN_OR_RETURN(auto compiled_regex, CompileRegex(pattern));
+  if (compiled_regex->NumberOfCapturingGroups() != 1) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "ExtractRegexOp expected regular expression with exactly one "
+        "capturing group; got `%s` which contains %d capturing groups",
+        pattern, compiled_regex->NumberOfCapturingGroups()));
+  }
+  std::optional<arolla::TypedValue> result = MapText<arolla::Text>(
+      text_ref,
+      [&](absl::string_view value) -> std::optional<absl::string_view> {
+        absl::string_view match;
+        if (!RE2::PartialMatch(value, *compiled_regex, &match)) {
+          return std::nullopt;
+        }
+        return match;
+      });
+  if (!result.has_value()) {
+    // Not TEXT, the Arolla operator reports the error.
+    arolla::TypedValue typed_regex =
+        arolla::TypedValue::FromValue(arolla::Text(pattern));
+    ASSIGN_OR_RETURN(result, EvalExpr("strings.extract_regex",
+                                      {text_ref, typed_regex.AsRef()}));
+  }
+  return DataSliceFromArollaValue(result->AsRef(), text.GetShape(),
                                   text.GetSchemaImpl());
 }
 
@@ -266,12 +550,77 @@ absl::StatusOr<DataSlice> RegexMatch(const DataSlice& text,
       arolla::TypedRef text_ref,
       DataSliceToOwnedArollaRef(text, typed_value_holder,
                                 internal::DataItem(schema::kText)));
-  arolla::TypedValue typed_regex =
-      arolla::TypedValue::FromValue(regex.item().value<arolla::Text>());
-  ASSIGN_OR_RETURN(arolla::TypedValue result,
-                   EvalExpr("strings.contains_regex",
-                            {std::move(text_ref), typed_regex.AsRef()}));
-  return DataSliceFromArollaValue(result.AsRef(), text.GetShape(),
+  absl::string_view pattern = regex.item().value<arolla::Text>();
+  ASSIGN_OR_RETURN(auto compiled_regex, CompileRegex(pattern));
+  std::optional<arolla::TypedValue> result = MapText<arolla::Unit>(
+      text_ref, [&](absl::string_view value) -> std::optional<arolla::Unit> {
+        if (!RE2::PartialMatch(value, *compiled_regex)) {
+          return std::nullopt;
+        }
+        return arolla::kUnit;
+      });
+  if (!result.has_value()) {
+    // Not TEXT, the Arolla operator reports the error.
+    arolla::TypedValue typed_regex =
+        arolla::TypedValue::FromValue(arolla::Text(pattern));
+    ASSIGN_OR_RETURN(result, EvalExpr("strings.contains_regex",
+                                      {text_ref, typed_regex.AsRef()}));
+  }
+  return DataSliceFromArollaValue(result->AsRef(), text.GetShape(),
+                                  internal::DataItem(schema::kMask));
+}
+
+absl::StatusOr<DataSlice> RegexMatchAny(const DataSlice& text,
+                                        const DataSlice& regexes) {
+  if (regexes.GetShape().rank() != 1 ||
+      (!regexes.slice().is_empty_and_unknown() &&
+       GetStringArray<arolla::Text>(regexes) == nullptr)) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "requires regexes to be a rank-1 TEXT DataSlice, got ",
+        arolla::Repr(regexes)));
+  }
+  ASSIGN_OR_RETURN(auto text_schema, GetPrimitiveArollaSchema(text));
+  std::vector<absl::string_view> patterns;
+  if (const auto* values = GetStringArray<arolla::Text>(regexes);
+      values != nullptr) {
+    values->ForEachPresent([&](int64_t id, absl::string_view pattern) {
+      patterns.push_back(pattern);
+    });
+  }
+  if (!text_schema.has_value() || patterns.empty()) {
+    // Nothing can match.
+    ASSIGN_OR_RETURN(DataSlice ds,
+                     DataSlice::Create(internal::DataItem(),
+                                       internal::DataItem(schema::kMask)));
+    return BroadcastToShape(std::move(ds), text.GetShape());
+  }
+  ASSIGN_OR_RETURN(auto regex_set, CompileRegexSet(patterns));
+
+  std::vector<arolla::TypedValue> typed_value_holder;
+  ASSIGN_OR_RETURN(
+      arolla::TypedRef text_ref,
+      DataSliceToOwnedArollaRef(text, typed_value_holder,
+                                internal::DataItem(schema::kText)));
+  bool out_of_memory = false;
+  // Each string is scanned once for all the patterns.
+  std::optional<arolla::TypedValue> result = MapText<arolla::Unit>(
+      text_ref, [&](absl::string_view value) -> std::optional<arolla::Unit> {
+        RE2::Set::ErrorInfo error_info;
+        if (!regex_set->Match(value, /*v=*/nullptr, &error_info)) {
+          out_of_memory |= error_info.kind == RE2::Set::kOutOfMemory;
+          return std::nullopt;
+        }
+        return arolla::kUnit;
+      });
+  if (!result.has_value()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "requires text to be TEXT, got ", arolla::Repr(text)));
+  }
+  if (out_of_memory) {
+    return absl::ResourceExhaustedError(
+        "ran out of memory while matching the regular expressions");
+  }
+  return DataSliceFromArollaValue(result->AsRef(), text.GetShape(),
                                   internal::DataItem(schema::kMask));
 }
 
@@ -331,10 +680,28 @@ absl::StatusOr<DataSlice> Split(const DataSlice& x, const DataSlice& sep) {
   }
   // Otherwise, we should eval. `strings.split` requires a dense array input, so
   // we flatten to avoid scalar inputs.
-  std::vector<arolla::TypedValue> typed_value_holder;
-  typed_value_holder.reserve(2);
   ASSIGN_OR_RETURN(auto flat_x,
                    x.Reshape(x_shape.FlattenDims(0, x_shape.rank())));
+  // The native implementation shares the characters of `x` with the tokens
+  // rather than copying every token.
+  auto from_split_result =
+      [&](auto split_result) -> absl::StatusOr<DataSlice> {
+    ASSIGN_OR_RETURN(auto out_shape,
+                     x_shape.AddDims({std::move(split_result.edge)}));
+    return DataSlice::Create(
+        internal::DataSliceImpl::Create(std::move(split_result.tokens)),
+        std::move(out_shape), std::move(common_schema));
+  };
+  if (auto split_result =
+          SplitNative<arolla::Text>(flat_x, sep, sep_primitive_schema)) {
+    return from_split_result(*std::move(split_result));
+  }
+  if (auto split_result =
+          SplitNative<arolla::Bytes>(flat_x, sep, sep_primitive_schema)) {
+    return from_split_result(*std::move(split_result));
+  }
+  std::vector<arolla::TypedValue> typed_value_holder;
+  typed_value_holder.reserve(2);
   ASSIGN_OR_RETURN(auto x_ref,
                    DataSliceToOwnedArollaRef(flat_x, typed_value_holder,
                                              sep_primitive_schema));
@@ -369,6 +736,10 @@ absl::StatusOr<DataSlice> Substr(const DataSlice& x, const DataSlice& start,
 }
 
 absl::StatusOr<DataSlice> Upper(const DataSlice& x) {
+  if (auto result = EvalAsciiTextKernel(x, internal::AsciiUpper);
+      result.has_value()) {
+    return *std::move(result);
+  }
   // TODO: Add support for BYTES.
   return SimplePointwiseEval("strings.upper", {x},
                              internal::DataItem(schema::kText));
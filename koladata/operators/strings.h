@@ -82,6 +82,13 @@ absl::StatusOr<DataSlice> RegexExtract(const DataSlice& text,
 absl::StatusOr<DataSlice> RegexMatch(const DataSlice& text,
                                      const DataSlice& regex);
 //
+// kde.strings.regex_match_any.
+//
+// Matches every string against all the patterns of the rank-1 `regexes` at
+// once with RE2::Set, so that each string is scanned a single time.
+absl::StatusOr<DataSlice> RegexMatchAny(const DataSlice& text,
+                                        const DataSlice& regexes);
+//
 // kde.strings.replace.
 absl::StatusOr<DataSlice> Replace(const DataSlice& s,
                                   const DataSlice& old_substr,
@@ -0,0 +1,181 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+// End-to-end benchmarks of workloads crossing several modules: proto
+// conversion, attribute transformations, grouping and aggregation, extraction
+// and serialization. Unlike the microbenchmarks, they are meant to catch
+// regressions in the interaction between the modules.
+//
+// Besides the time per iteration, every benchmark reports the time spent in
+// each stage and the peak resident memory of the process (which only grows,
+// so it is the high-water mark of all benchmarks run so far; run a single
+// benchmark with --benchmark_filter to get meaningful numbers).
+
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/time/clock.h"
+#include "absl/time/time.h"
+#include "absl/types/span.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_slice.h"
+#include "koladata/extract_utils.h"
+#include "koladata/internal/benchmark_helpers.h"
+#include "koladata/operators/core.h"
+#include "koladata/operators/math.h"
+#include "koladata/proto/from_proto.h"
+#include "koladata/proto/testing/test_proto2.pb.h"
+#include "koladata/s11n/chunked.h"
+#include "koladata/test_utils.h"
+#include "google/protobuf/message.h"
+#include "arolla/serialization_base/base.pb.h"
+#include "arolla/util/init_arolla.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata {
+namespace {
+
+constexpr int64_t kGroupCount = 100;
+constexpr int64_t kRepeatedSize = 3;
+
+std::vector<testing::ExampleMessage> CreateMessages(int64_t size) {
+  std::vector<testing::ExampleMessage> messages(size);
+  for (int64_t i = 0; i < size; ++i) {
+    auto& message = messages[i];
+    message.set_int32_field(i % kGroupCount);
+    message.set_double_field(i * 0.5);
+    message.set_string_field(absl::StrCat("item_", i));
+    message.mutable_message_field()->set_int64_field(i);
+    for (int64_t j = 0; j < kRepeatedSize; ++j) {
+      message.add_repeated_int32_field(i + j);
+    }
+  }
+  return messages;
+}
+
+struct StageTimes {
+  absl::Duration from_proto;
+  absl::Duration transform;
+  absl::Duration group_by;
+  absl::Duration extract;
+  absl::Duration serialize;
+};
+
+class StageTimer {
+ public:
+  explicit StageTimer(absl::Duration& total)
+      : total_(total), start_(absl::Now()) {}
+  ~StageTimer() { total_ += absl::Now() - start_; }
+
+ private:
+  absl::Duration& total_;
+  absl::Time start_;
+};
+
+// Returns the number of serialized bytes.
+absl::StatusOr<int64_t> RunPipeline(
+    absl::Span<const google::protobuf::Message* const> messages,
+    StageTimes& times) {
+  DataSlice items;
+  {
+    StageTimer timer(times.from_proto);
+    ASSIGN_OR_RETURN(items, FromProto(DataBag::Empty(), messages));
+  }
+  DataSlice keys;
+  {
+    StageTimer timer(times.transform);
+    ASSIGN_OR_RETURN(keys, items.GetAttr("int32_field"));
+    ASSIGN_OR_RETURN(auto doubles, items.GetAttr("double_field"));
+    ASSIGN_OR_RETURN(auto nested, items.GetAttr("message_field"));
+    ASSIGN_OR_RETURN(auto nested_ints, nested.GetAttr("int64_field"));
+    ASSIGN_OR_RETURN(auto lists, items.GetAttr("repeated_int32_field"));
+    ASSIGN_OR_RETURN(auto list_items, ops::Explode(lists, 1));
+    ASSIGN_OR_RETURN(auto list_sums, ops::AggSum(list_items));
+    ASSIGN_OR_RETURN(auto score,
+                     ops::Multiply(doubles, test::DataItem(2.0)));
+    ASSIGN_OR_RETURN(score, ops::Add(score, nested_ints));
+    ASSIGN_OR_RETURN(score, ops::Add(score, list_sums));
+    RETURN_IF_ERROR(items.SetAttrWithUpdateSchema("score", score));
+  }
+  {
+    StageTimer timer(times.group_by);
+    ASSIGN_OR_RETURN(auto scores, items.GetAttr("score"));
+    const DataSlice* group_by_args[] = {&keys};
+    ASSIGN_OR_RETURN(auto indices, ops::GroupByIndices(group_by_args));
+    ASSIGN_OR_RETURN(auto grouped, ops::At(scores, indices));
+    ASSIGN_OR_RETURN(auto sums, ops::AggSum(grouped));
+    benchmark::DoNotOptimize(sums);
+  }
+  DataSlice extracted;
+  {
+    StageTimer timer(times.extract);
+    ASSIGN_OR_RETURN(extracted, extract_utils_internal::Extract(items));
+  }
+  int64_t serialized_bytes = 0;
+  {
+    StageTimer timer(times.serialize);
+    RETURN_IF_ERROR(s11n::EncodeDataBagChunked(
+        extracted.GetDb(), {},
+        [&](arolla::serialization_base::ContainerProto chunk) {
+          serialized_bytes += chunk.ByteSizeLong();
+          return absl::OkStatus();
+        }));
+  }
+  return serialized_bytes;
+}
+
+void BM_ProtoPipeline(benchmark::State& state) {
+  arolla::InitArolla();
+  int64_t size = state.range(0);
+  auto messages = CreateMessages(size);
+  std::vector<const google::protobuf::Message*> message_ptrs;
+  message_ptrs.reserve(size);
+  for (const auto& message : messages) {
+    message_ptrs.push_back(&message);
+  }
+  StageTimes times;
+  int64_t serialized_bytes = 0;
+  for (auto _ : state) {
+    auto result = RunPipeline(message_ptrs, times);
+    CHECK_OK(result);
+    serialized_bytes = *result;
+  }
+  auto stage_counter = [](absl::Duration d) {
+    return benchmark::Counter(absl::ToDoubleSeconds(d),
+                              benchmark::Counter::kAvgIterations);
+  };
+  state.counters["from_proto_s"] = stage_counter(times.from_proto);
+  state.counters["transform_s"] = stage_counter(times.transform);
+  state.counters["group_by_s"] = stage_counter(times.group_by);
+  state.counters["extract_s"] = stage_counter(times.extract);
+  state.counters["serialize_s"] = stage_counter(times.serialize);
+  state.counters["serialized_bytes"] = serialized_bytes;
+  state.counters["peak_rss_mb"] = internal::PeakRssMegabytes();
+  state.SetItemsProcessed(state.iterations() * size);
+}
+
+// 100M messages need tens of gigabytes of memory for the input protos
+// alone, so that scale is not registered by default.
+BENCHMARK(BM_ProtoPipeline)
+    ->Arg(1000)
+    ->Arg(1000000)
+    ->Unit(benchmark::kMillisecond);
+
+}  // namespace
+}  // namespace koladata
@@ -25,29 +25,37 @@
 #include <utility>
 #include <vector>
 
+#include "absl/base/no_destructor.h"
 #include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
 #include "absl/strings/str_join.h"
 #include "absl/strings/str_split.h"
 #include "absl/strings/string_view.h"
+#include "absl/synchronization/mutex.h"
 #include "absl/types/span.h"
 #include "koladata/adoption_utils.h"
 #include "koladata/casting.h"
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
+#include "koladata/internal/cancellation.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
 #include "koladata/internal/schema_utils.h"
+#include "koladata/internal/sharded_lru_cache.h"
 #include "koladata/object_factories.h"
 #include "koladata/operators/core.h"
 #include "google/protobuf/descriptor.h"
 #include "google/protobuf/message.h"
 #include "arolla/dense_array/dense_array.h"
+#include "arolla/qtype/qtype_traits.h"
 #include "arolla/util/bytes.h"
 #include "arolla/util/text.h"
 #include "arolla/util/unit.h"
@@ -173,6 +181,35 @@ absl::StatusOr<ExtensionMap> ParseExtensions(
   return result;
 }
 
+// Returns the parsed `extensions`. Extension maps for the generated pool are
+// cached, since FromProto is often called many times with the same extensions
+// and only a few messages.
+absl::StatusOr<std::shared_ptr<const ExtensionMap>> GetExtensionMap(
+    absl::Span<const absl::string_view> extensions,
+    const DescriptorPool& pool) {
+  if (&pool != DescriptorPool::generated_pool()) {
+    ASSIGN_OR_RETURN(ExtensionMap extension_map,
+                     ParseExtensions(extensions, pool));
+    return std::make_shared<const ExtensionMap>(std::move(extension_map));
+  }
+  using Cache =
+      internal::ShardedLruCache<std::string,
+                                std::shared_ptr<const ExtensionMap>>;
+  static absl::NoDestructor<Cache> cache(/*capacity=*/1024);
+  std::string key;
+  for (absl::string_view extension : extensions) {
+    absl::StrAppend(&key, extension.size(), ":", extension);
+  }
+  if (auto extension_map = cache->LookupOrNull(key)) {
+    return extension_map;
+  }
+  ASSIGN_OR_RETURN(ExtensionMap extension_map,
+                   ParseExtensions(extensions, pool));
+  return cache->Put(
+      std::move(key),
+      std::make_shared<const ExtensionMap>(std::move(extension_map)));
+}
+
 const ExtensionMap* GetChildExtensionMap(const ExtensionMap* extension_map,
                                          absl::string_view field_name) {
   if (extension_map != nullptr) {
@@ -692,11 +729,13 @@ absl::StatusOr<std::optional<DataSlice>> FromProtoPrimitiveField(
   auto to_slice = [&]<typename T, typename F>(
                       F get) -> absl::StatusOr<std::optional<DataSlice>> {
     bool is_empty = true;
+    const bool check_presence =
+        !ignore_field_presence && field_descriptor.has_presence();
     arolla::DenseArrayBuilder<T> builder(parent_messages.size());
     for (int64_t i = 0; i < parent_messages.size(); ++i) {
       const auto& parent_message = *parent_messages[i];
       const auto* refl = parent_message.GetReflection();
-      if (ignore_field_presence || !field_descriptor.has_presence() ||
+      if (!check_presence ||
           refl->HasField(parent_message, &field_descriptor)) {
         builder.Add(i, get(*refl, *parent_messages[i]));
         is_empty = false;
@@ -842,6 +881,45 @@ absl::StatusOr<DataSlice> FromZeroProtoMessages(
       internal::DataItem(schema::kObject), db);
 }
 
+// Fields of a message type converted by default (without an explicit entity
+// schema), together with their attribute names.
+using MessageFields = std::vector<
+    std::tuple<absl::Nonnull<const FieldDescriptor*>, absl::string_view>>;
+
+MessageFields CreateMessageFields(const Descriptor& message_descriptor) {
+  MessageFields fields;
+  fields.reserve(message_descriptor.field_count());
+  for (int i_field = 0; i_field < message_descriptor.field_count();
+       ++i_field) {
+    const auto* field = message_descriptor.field(i_field);
+    fields.emplace_back(field, field->name());
+  }
+  return fields;
+}
+
+// Returns the default fields of `message_descriptor`, or nullptr if the
+// descriptor doesn't belong to the generated pool. The result is computed once
+// per message type, so that repeated conversions don't walk the descriptor
+// again. Only descriptors from the generated pool live forever, so others are
+// never cached.
+absl::Nullable<const MessageFields*> GetCachedMessageFields(
+    const Descriptor& message_descriptor) {
+  if (message_descriptor.file()->pool() != DescriptorPool::generated_pool()) {
+    return nullptr;
+  }
+  static absl::NoDestructor<absl::Mutex> mutex;
+  static absl::NoDestructor<
+      absl::flat_hash_map<const Descriptor*, std::unique_ptr<MessageFields>>>
+      cache;
+  absl::MutexLock lock(mutex.get());
+  auto& fields = (*cache)[&message_descriptor];
+  if (fields == nullptr) {
+    fields = std::make_unique<MessageFields>(
+        CreateMessageFields(message_descriptor));
+  }
+  return fields.get();
+}
+
 // Returns a rank-1 DataSlice of objects or entities converted from a vector of
 // uniform-type proto messages.
 absl::StatusOr<DataSlice> FromProtoMessage(
@@ -855,9 +933,9 @@ absl::StatusOr<DataSlice> FromProtoMessage(
   // Defined here to maintain lifetime for references in `attr_names`.
   DataSlice::AttrNamesSet schema_attr_names;
 
-  std::vector<
-      std::tuple<absl::Nonnull<const FieldDescriptor*>, absl::string_view>>
-      fields_and_attr_names;
+  MessageFields fields_and_attr_names;
+  // Points either to `fields_and_attr_names` or to the cached default fields.
+  const MessageFields* fields_and_attr_names_ptr = &fields_and_attr_names;
   if (schema.has_value() && schema->IsEntitySchema()) {
     // For explicit entity schemas, use the schema attr names as the list of
     // fields and extensions to convert.
@@ -885,17 +963,18 @@ absl::StatusOr<DataSlice> FromProtoMessage(
     }
   } else {
     // For unset and OBJECT schemas, convert all fields + requested extensions.
-    const int64_t num_fields =
-        message_descriptor.field_count() +
-        ((extension_map != nullptr) ? extension_map->extension_fields.size()
-                                    : 0);
-    fields_and_attr_names.reserve(num_fields);
-    for (int i_field = 0; i_field < message_descriptor.field_count();
-         ++i_field) {
-      const auto* field = message_descriptor.field(i_field);
-      fields_and_attr_names.emplace_back(field, field->name());
+    const MessageFields* cached_fields =
+        GetCachedMessageFields(message_descriptor);
+    const bool has_extensions =
+        extension_map != nullptr && !extension_map->extension_fields.empty();
+    if (cached_fields != nullptr && !has_extensions) {
+      fields_and_attr_names_ptr = cached_fields;
+    } else if (cached_fields != nullptr) {
+      fields_and_attr_names = *cached_fields;
+    } else {
+      fields_and_attr_names = CreateMessageFields(message_descriptor);
     }
-    if (extension_map != nullptr) {
+    if (has_extensions) {
       for (const auto& [attr_name, field] : extension_map->extension_fields) {
         fields_and_attr_names.emplace_back(field, attr_name);
       }
@@ -904,7 +983,10 @@ absl::StatusOr<DataSlice> FromProtoMessage(
 
   std::vector<absl::string_view> value_attr_names;
   std::vector<DataSlice> values;
-  for (const auto& [field, attr_name] : fields_and_attr_names) {
+  for (const auto& [field, attr_name] : *fields_and_attr_names_ptr) {
+    // Each field is converted for all the messages at once, including the
+    // nested messages, so it is a natural chunk for the cancellation checks.
+    RETURN_IF_ERROR(internal::CheckCancellation());
     ASSIGN_OR_RETURN(std::optional<DataSlice> field_values,
                      FromProtoField(db, attr_name, attr_name, *field,
                                     messages, itemid, schema, extension_map));
@@ -943,6 +1025,72 @@ absl::StatusOr<DataSlice> FromProtoMessage(
   }
 }
 
+// Minimal number of messages per chunk when converting in parallel. Smaller
+// chunks don't amortize the cost of merging the chunk DataBags.
+constexpr int64_t kMinMessagesPerChunk = 1024;
+
+// Converts `messages` in `num_chunks` contiguous ranges in parallel. Each range
+// is converted into its own DataBag, which are then merged into `db`. Schemas
+// and child item ids don't depend on the range boundaries, so the result is
+// the same as converting all the messages at once.
+absl::StatusOr<DataSlice> FromProtoMessageInChunks(
+    const absl::Nonnull<DataBagPtr>& db, const Descriptor& message_descriptor,
+    absl::Span<const absl::Nonnull<const Message*>> messages,
+    const std::optional<DataSlice>& itemid,
+    const std::optional<DataSlice>& schema,
+    const ExtensionMap& extension_map, internal::Executor* executor,
+    int64_t num_chunks) {
+  const int64_t size = messages.size();
+  std::vector<DataBagPtr> chunk_dbs(num_chunks);
+  std::vector<std::optional<DataSlice>> chunk_results(num_chunks);
+  RETURN_IF_ERROR(internal::ParallelFor(
+      executor, num_chunks, [&](int64_t i) -> absl::Status {
+        const int64_t begin = i * size / num_chunks;
+        const int64_t chunk_len = (i + 1) * size / num_chunks - begin;
+        chunk_dbs[i] = DataBag::Empty();
+        if (schema.has_value()) {
+          AdoptionQueue adoption_queue;
+          adoption_queue.Add(*schema);
+          RETURN_IF_ERROR(adoption_queue.AdoptInto(*chunk_dbs[i]));
+        }
+        std::optional<DataSlice> chunk_itemid;
+        if (itemid.has_value()) {
+          ASSIGN_OR_RETURN(
+              chunk_itemid,
+              DataSlice::Create(
+                  internal::DataSliceImpl::Create(
+                      itemid->slice().values<internal::ObjectId>().Slice(
+                          begin, chunk_len)),
+                  DataSlice::JaggedShape::FlatFromSize(chunk_len),
+                  itemid->GetSchemaImpl()));
+        }
+        ASSIGN_OR_RETURN(
+            chunk_results[i],
+            FromProtoMessage(chunk_dbs[i], message_descriptor,
+                             messages.subspan(begin, chunk_len), chunk_itemid,
+                             schema, &extension_map));
+        return absl::OkStatus();
+      }));
+
+  arolla::DenseArrayBuilder<internal::ObjectId> ids_builder(size);
+  int64_t offset = 0;
+  for (int64_t i = 0; i < num_chunks; ++i) {
+    // Chunks are disjoint except for the schemas, which are equal.
+    RETURN_IF_ERROR(db->MergeInplace(chunk_dbs[i], /*overwrite=*/false,
+                                     /*allow_data_conflicts=*/false,
+                                     /*allow_schema_conflicts=*/false));
+    chunk_results[i]->slice().values<internal::ObjectId>().ForEachPresent(
+        [&](int64_t id, internal::ObjectId object_id) {
+          ids_builder.Add(offset + id, object_id);
+        });
+    offset += chunk_results[i]->size();
+  }
+  return DataSlice::Create(
+      internal::DataSliceImpl::Create(std::move(ids_builder).Build()),
+      DataSlice::JaggedShape::FlatFromSize(size),
+      chunk_results[0]->GetSchemaImpl(), db);
+}
+
 }  // namespace
 
 absl::StatusOr<DataSlice> FromProto(
@@ -950,7 +1098,7 @@ absl::StatusOr<DataSlice> FromProto(
     absl::Span<const absl::Nonnull<const Message*>> messages,
     absl::Span<const absl::string_view> extensions,
     const std::optional<DataSlice>& itemid,
-    const std::optional<DataSlice>& schema) {
+    const std::optional<DataSlice>& schema, internal::Executor* executor) {
   if (schema.has_value()) {
     RETURN_IF_ERROR(schema->VerifyIsSchema());
     AdoptionQueue adoption_queue;
@@ -973,9 +1121,21 @@ absl::StatusOr<DataSlice> FromProto(
   }
 
   ASSIGN_OR_RETURN(
-      const ExtensionMap extension_map,
-      ParseExtensions(extensions, *message_descriptor->file()->pool()));
-
+      std::shared_ptr<const ExtensionMap> extension_map_ptr,
+      GetExtensionMap(extensions, *message_descriptor->file()->pool()));
+  const ExtensionMap& extension_map = *extension_map_ptr;
+
+  const int64_t num_chunks = internal::ParallelChunkCount(
+      executor, messages.size(), kMinMessagesPerChunk);
+  // Malformed `itemid` is left to the sequential conversion to report.
+  if (num_chunks > 1 &&
+      (!itemid.has_value() ||
+       (itemid->GetShape().rank() == 1 && itemid->size() == messages.size() &&
+        itemid->dtype() == arolla::GetQType<internal::ObjectId>()))) {
+    return FromProtoMessageInChunks(db, *message_descriptor, messages, itemid,
+                                    schema, extension_map, executor,
+                                    num_chunks);
+  }
   return FromProtoMessage(db, *message_descriptor, messages, itemid, schema,
                           &extension_map);
 }
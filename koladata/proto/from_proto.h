@@ -23,6 +23,7 @@
 #include "absl/types/span.h"
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
+#include "koladata/internal/executor.h"
 #include "google/protobuf/message.h"
 
 namespace koladata {
@@ -79,12 +80,18 @@ namespace koladata {
 // extension fields are parenthesized fully-qualified extension paths (e.g.
 // "(package_name.some_extension)" or
 // "(package_name.SomeMessage.some_extension)".)
+//
+// If `executor` is not nullptr, large batches of messages are split into
+// contiguous ranges that are converted concurrently into separate DataBags and
+// then merged into `db`. The result is the same as for the sequential
+// conversion.
 absl::StatusOr<DataSlice> FromProto(
     const absl::Nonnull<DataBagPtr>& db,
     absl::Span<const absl::Nonnull<const ::google::protobuf::Message*>> messages,
     absl::Span<const std::string_view> extensions = {},
     const std::optional<DataSlice>& itemids = std::nullopt,
-    const std::optional<DataSlice>& schema = std::nullopt);
+    const std::optional<DataSlice>& schema = std::nullopt,
+    internal::Executor* executor = nullptr);
 
 }  // namespace koladata
 
@@ -16,17 +16,20 @@
 
 #include <cstdint>
 #include <optional>
+#include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/status_matchers.h"
+#include "absl/strings/string_view.h"
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/testing/matchers.h"
 #include "koladata/object_factories.h"
 #include "koladata/operators/logical.h"
@@ -34,6 +37,7 @@
 #include "koladata/proto/testing/test_proto3.pb.h"
 #include "koladata/test_utils.h"
 #include "koladata/testing/matchers.h"
+#include "google/protobuf/message.h"
 #include "google/protobuf/text_format.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/jagged_shape/testing/matchers.h"
@@ -970,6 +974,76 @@ TEST(FromProtoTest, ItemId) {
                   result2.GetAttr("map_int32_message_field")->WithDb(nullptr)));
 }
 
+TEST(FromProtoTest, Parallel) {
+  constexpr int64_t kSize = 5000;
+  std::vector<koladata::testing::ExampleMessage> messages(kSize);
+  std::vector<const google::protobuf::Message*> message_ptrs;
+  for (int64_t i = 0; i < kSize; ++i) {
+    messages[i].set_int32_field(i);
+    if (i % 3 == 0) {
+      messages[i].mutable_message_field()->set_int32_field(-i);
+    }
+    for (int64_t j = 0; j < i % 4; ++j) {
+      messages[i].add_repeated_int32_field(j);
+    }
+    message_ptrs.push_back(&messages[i]);
+  }
+  internal::ThreadPoolExecutor executor(4);
+
+  ASSERT_OK_AND_ASSIGN(
+      auto itemids,
+      DataSlice::Create(internal::DataSliceImpl::AllocateEmptyObjects(kSize),
+                        DataSlice::JaggedShape::FlatFromSize(kSize),
+                        internal::DataItem(schema::kItemId)));
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(auto expected,
+                       FromProto(db, message_ptrs, {}, itemids));
+  for (const auto& schema :
+       {std::optional<DataSlice>(), std::optional<DataSlice>(
+                                        test::Schema(schema::kObject))}) {
+    auto parallel_db = DataBag::Empty();
+    ASSERT_OK_AND_ASSIGN(auto result,
+                         FromProto(parallel_db, message_ptrs, {}, itemids,
+                                   schema, &executor));
+    EXPECT_EQ(result.GetDb(), parallel_db);
+    EXPECT_THAT(result.WithSchema(test::Schema(schema::kItemId))
+                    ->WithDb(nullptr),
+                IsEquivalentTo(itemids));
+    for (absl::string_view attr : {"message_field", "repeated_int32_field"}) {
+      ASSERT_OK_AND_ASSIGN(auto expected_attr, expected.GetAttr(attr));
+      ASSERT_OK_AND_ASSIGN(expected_attr,
+                           expected_attr.WithDb(parallel_db).WithSchema(
+                               test::Schema(schema::kAny)));
+      EXPECT_THAT(
+          result.GetAttr(attr)->WithSchema(test::Schema(schema::kAny)),
+          IsOkAndHolds(IsEquivalentTo(expected_attr)))
+          << attr;
+    }
+    EXPECT_THAT(
+        result.GetAttr("message_field")->GetAttr("int32_field"),
+        IsOkAndHolds(IsEquivalentTo(
+            expected.GetAttr("message_field")->GetAttr("int32_field")
+                ->WithDb(parallel_db))));
+    EXPECT_THAT(
+        result.GetAttr("repeated_int32_field")->ExplodeList(0, std::nullopt),
+        IsOkAndHolds(IsEquivalentTo(
+            expected.GetAttr("repeated_int32_field")
+                ->ExplodeList(0, std::nullopt)
+                ->WithDb(parallel_db))));
+  }
+
+  // Without item ids, the allocated ids differ, but the content is the same.
+  auto parallel_db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      auto result,
+      FromProto(parallel_db, message_ptrs, {}, std::nullopt, std::nullopt,
+                &executor));
+  EXPECT_EQ(result.GetSchemaImpl(), expected.GetSchemaImpl());
+  EXPECT_THAT(result.GetAttr("int32_field"),
+              IsOkAndHolds(IsEquivalentTo(
+                  expected.GetAttr("int32_field")->WithDb(parallel_db))));
+}
+
 TEST(FromProtoTest, Extension) {
   testing::ExampleMessage2 message;
   message.SetExtension(koladata::testing::m2_bool_extension_field, false);
@@ -1010,6 +1084,29 @@ TEST(FromProtoTest, Extension) {
       IsOkAndHolds(IsEquivalentTo(test::DataSlice<bool>({true}, db))));
 }
 
+TEST(FromProtoTest, RepeatedConversionWithAndWithoutExtensions) {
+  testing::ExampleMessage2 message;
+  message.SetExtension(koladata::testing::m2_bool_extension_field, true);
+  constexpr absl::string_view kExtension =
+      "(koladata.testing.m2_bool_extension_field)";
+
+  // The default fields of the message type are computed once and reused, the
+  // requested extensions must still be added on top of them.
+  for (int i = 0; i < 2; ++i) {
+    auto db = DataBag::Empty();
+    ASSERT_OK_AND_ASSIGN(auto result, FromProto(db, {&message}));
+    EXPECT_THAT(result.GetAttr(kExtension),
+                StatusIs(absl::StatusCode::kInvalidArgument));
+
+    auto ext_db = DataBag::Empty();
+    ASSERT_OK_AND_ASSIGN(auto ext_result,
+                         FromProto(ext_db, {&message}, {kExtension}));
+    EXPECT_THAT(
+        ext_result.GetAttr(kExtension),
+        IsOkAndHolds(IsEquivalentTo(test::DataSlice<bool>({true}, ext_db))));
+  }
+}
+
 TEST(FromProtoTest, ExtensionViaSchema) {
   testing::ExampleMessage2 message;
   message.SetExtension(koladata::testing::m2_bool_extension_field, false);
@@ -1103,6 +1200,11 @@ TEST(FromProtoTest, InvalidExtensionPath) {
                                    DataBag::Empty())),
       StatusIs(absl::StatusCode::kInvalidArgument,
                "extension not found: \"b.c\""));
+
+  // Failed parsing is not cached.
+  EXPECT_THAT(FromProto(DataBag::Empty(), {&message}, {"a.(b.c)"}),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "extension not found: \"b.c\""));
 }
 
 }  // namespace
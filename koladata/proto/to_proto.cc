@@ -0,0 +1,373 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/proto/to_proto.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/object_id.h"
+#include "google/protobuf/descriptor.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/bytes.h"
+#include "arolla/util/text.h"
+#include "arolla/util/view_types.h"
+#include "arolla/util/status_macros_backport.h"
+
+using ::google::protobuf::Descriptor;
+using ::google::protobuf::FieldDescriptor;
+using ::google::protobuf::Message;
+using ::google::protobuf::Reflection;
+
+namespace koladata {
+namespace {
+
+// Returns a rank-1 DataSlice with elements [begin, begin + size) of the rank-1
+// DataSlice of entities or objects `slice`.
+absl::StatusOr<DataSlice> GetRange(const DataSlice& slice, int64_t begin,
+                                   int64_t size) {
+  const internal::DataSliceImpl& impl = slice.slice();
+  internal::DataSliceImpl range;
+  if (impl.is_empty_and_unknown()) {
+    range = internal::DataSliceImpl::CreateEmptyAndUnknownType(size);
+  } else if (impl.dtype() == arolla::GetQType<internal::ObjectId>()) {
+    range = internal::DataSliceImpl::Create(
+        impl.values<internal::ObjectId>().Slice(begin, size));
+  } else {
+    return absl::InvalidArgumentError(
+        "expected a DataSlice of entities or objects");
+  }
+  return DataSlice::Create(std::move(range),
+                           DataSlice::JaggedShape::FlatFromSize(size),
+                           slice.GetSchemaImpl(), slice.GetDb());
+}
+
+// Returns the rank-1 DataSlice with the same elements as the rank-2 `slice`.
+absl::StatusOr<DataSlice> Flatten(const DataSlice& slice) {
+  const auto& shape = slice.GetShape();
+  return slice.Reshape(shape.FlattenDims(0, shape.rank()));
+}
+
+// Returns `messages[parent]` for every child of the rank-2 `children`.
+std::vector<absl::Nonnull<Message*>> GetChildTargets(
+    absl::Span<const absl::Nonnull<Message*>> messages,
+    const DataSlice& children) {
+  std::vector<absl::Nonnull<Message*>> targets;
+  targets.reserve(children.size());
+  const auto& splits = children.GetShape().edges()[1].edge_values().values;
+  for (int64_t i = 0; i + 1 < splits.size(); ++i) {
+    targets.insert(targets.end(), splits[i + 1] - splits[i], messages[i]);
+  }
+  return targets;
+}
+
+template <typename T, typename U>
+constexpr bool kIsConvertible =
+    (std::is_same_v<U, bool> && std::is_same_v<T, bool>) ||
+    (std::is_arithmetic_v<U> && !std::is_same_v<U, bool> &&
+     (std::is_same_v<T, int32_t> || std::is_same_v<T, int64_t> ||
+      (std::is_floating_point_v<U> &&
+       (std::is_same_v<T, float> || std::is_same_v<T, double>)))) ||
+    (std::is_same_v<U, std::string> &&
+     (std::is_same_v<T, arolla::Text> || std::is_same_v<T, arolla::Bytes>));
+
+absl::Status ConversionError(const FieldDescriptor& field,
+                             absl::string_view qtype_name) {
+  return absl::InvalidArgumentError(
+      absl::StrFormat("cannot convert values of type %s to proto field %s",
+                      qtype_name, field.full_name()));
+}
+
+// Sets (or adds, for repeated fields) the present `values[i]` to the field of
+// `targets[i]`.
+template <typename T>
+absl::Status FillPrimitiveField(
+    const FieldDescriptor& field, const arolla::DenseArray<T>& values,
+    absl::Span<const absl::Nonnull<Message*>> targets) {
+  const bool is_repeated = field.is_repeated();
+  auto fill = [&]<typename U>(auto set, auto add) -> absl::Status {
+    if constexpr (!kIsConvertible<T, U>) {
+      return ConversionError(field, arolla::GetQType<T>()->name());
+    } else {
+      values.ForEachPresent([&](int64_t i, arolla::view_type_t<T> value) {
+        Message* message = targets[i];
+        const Reflection& refl = *message->GetReflection();
+        if (is_repeated) {
+          add(refl, message, &field, U(value));
+        } else {
+          set(refl, message, &field, U(value));
+        }
+      });
+      return absl::OkStatus();
+    }
+  };
+
+  switch (field.cpp_type()) {
+    case FieldDescriptor::CPPTYPE_INT32:
+      return fill.template operator()<int32_t>(
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             int32_t v) { refl.SetInt32(m, f, v); },
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             int32_t v) { refl.AddInt32(m, f, v); });
+    case FieldDescriptor::CPPTYPE_INT64:
+      return fill.template operator()<int64_t>(
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             int64_t v) { refl.SetInt64(m, f, v); },
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             int64_t v) { refl.AddInt64(m, f, v); });
+    case FieldDescriptor::CPPTYPE_UINT32:
+      return fill.template operator()<uint32_t>(
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             uint32_t v) { refl.SetUInt32(m, f, v); },
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             uint32_t v) { refl.AddUInt32(m, f, v); });
+    case FieldDescriptor::CPPTYPE_UINT64:
+      return fill.template operator()<uint64_t>(
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             uint64_t v) { refl.SetUInt64(m, f, v); },
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             uint64_t v) { refl.AddUInt64(m, f, v); });
+    case FieldDescriptor::CPPTYPE_DOUBLE:
+      return fill.template operator()<double>(
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             double v) { refl.SetDouble(m, f, v); },
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             double v) { refl.AddDouble(m, f, v); });
+    case FieldDescriptor::CPPTYPE_FLOAT:
+      return fill.template operator()<float>(
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             float v) { refl.SetFloat(m, f, v); },
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             float v) { refl.AddFloat(m, f, v); });
+    case FieldDescriptor::CPPTYPE_BOOL:
+      return fill.template operator()<bool>(
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             bool v) { refl.SetBool(m, f, v); },
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             bool v) { refl.AddBool(m, f, v); });
+    case FieldDescriptor::CPPTYPE_ENUM:
+      return fill.template operator()<int32_t>(
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             int32_t v) { refl.SetEnumValue(m, f, v); },
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             int32_t v) { refl.AddEnumValue(m, f, v); });
+    case FieldDescriptor::CPPTYPE_STRING:
+      // Mirrors FromProto: TEXT for string fields and BYTES for bytes fields.
+      if ((field.type() == FieldDescriptor::TYPE_STRING) !=
+          std::is_same_v<T, arolla::Text>) {
+        return ConversionError(field, arolla::GetQType<T>()->name());
+      }
+      return fill.template operator()<std::string>(
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             std::string v) { refl.SetString(m, f, std::move(v)); },
+          [](const Reflection& refl, Message* m, const FieldDescriptor* f,
+             std::string v) { refl.AddString(m, f, std::move(v)); });
+    default:
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "unexpected proto field C++ type %d", field.cpp_type()));
+  }
+}
+
+absl::Status FillPrimitiveField(
+    const FieldDescriptor& field, const DataSlice& values,
+    absl::Span<const absl::Nonnull<Message*>> targets) {
+  return values.slice().VisitValues(
+      [&]<typename T>(const arolla::DenseArray<T>& array) {
+        return FillPrimitiveField(field, array, targets);
+      });
+}
+
+absl::Status FillMessages(absl::Span<const absl::Nonnull<Message*>> messages,
+                          const DataSlice& slice);
+
+// Fills `field` of `messages` from the rank-1 DataSlice `values` of the same
+// size.
+absl::Status FillField(absl::Span<const absl::Nonnull<Message*>> messages,
+                       const FieldDescriptor& field, const DataSlice& values) {
+  if (field.is_map()) {
+    ASSIGN_OR_RETURN(auto keys, values.GetDictKeys());
+    ASSIGN_OR_RETURN(auto dict_values, values.GetDictValues());
+    auto targets = GetChildTargets(messages, keys);
+    std::vector<absl::Nonnull<Message*>> entries;
+    entries.reserve(targets.size());
+    for (Message* target : targets) {
+      entries.push_back(target->GetReflection()->AddMessage(target, &field));
+    }
+    ASSIGN_OR_RETURN(auto flat_keys, Flatten(keys));
+    ASSIGN_OR_RETURN(auto flat_values, Flatten(dict_values));
+    const Descriptor& entry_descriptor = *field.message_type();
+    RETURN_IF_ERROR(
+        FillField(entries, *entry_descriptor.map_key(), flat_keys));
+    return FillField(entries, *entry_descriptor.map_value(), flat_values);
+  }
+  if (field.is_repeated()) {
+    ASSIGN_OR_RETURN(auto items, values.ExplodeList(0, std::nullopt));
+    auto targets = GetChildTargets(messages, items);
+    ASSIGN_OR_RETURN(auto flat_items, Flatten(items));
+    if (field.message_type() != nullptr) {
+      std::vector<absl::Nonnull<Message*>> children;
+      children.reserve(targets.size());
+      for (Message* target : targets) {
+        children.push_back(
+            target->GetReflection()->AddMessage(target, &field));
+      }
+      return FillMessages(children, flat_items);
+    }
+    // Values of different types would be added out of order.
+    if (flat_items.impl_has_mixed_dtype()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "cannot convert a list with mixed types to proto field %s",
+          field.full_name()));
+    }
+    return FillPrimitiveField(field, flat_items, targets);
+  }
+  if (field.message_type() != nullptr) {
+    if (values.dtype() != arolla::GetQType<internal::ObjectId>()) {
+      return ConversionError(field, values.dtype()->name());
+    }
+    // Only the messages with present values get a sub-message.
+    std::vector<absl::Nonnull<Message*>> children;
+    arolla::DenseArrayBuilder<internal::ObjectId> ids_builder(
+        values.present_count());
+    values.slice().values<internal::ObjectId>().ForEachPresent(
+        [&](int64_t i, internal::ObjectId id) {
+          ids_builder.Add(children.size(), id);
+          children.push_back(
+              messages[i]->GetReflection()->MutableMessage(messages[i],
+                                                           &field));
+        });
+    ASSIGN_OR_RETURN(
+        auto packed_values,
+        DataSlice::Create(
+            internal::DataSliceImpl::Create(std::move(ids_builder).Build()),
+            DataSlice::JaggedShape::FlatFromSize(children.size()),
+            values.GetSchemaImpl(), values.GetDb()));
+    return FillMessages(children, packed_values);
+  }
+  return FillPrimitiveField(field, values, messages);
+}
+
+// Fills all the fields of `messages` from the attributes of the rank-1
+// DataSlice `slice` of the same size.
+absl::Status FillMessages(absl::Span<const absl::Nonnull<Message*>> messages,
+                          const DataSlice& slice) {
+  if (messages.empty() || slice.present_count() == 0) {
+    return absl::OkStatus();
+  }
+  ASSIGN_OR_RETURN(auto missing,
+                   DataSlice::Create(internal::DataItem(),
+                                     internal::DataItem(schema::kNone)));
+  const Descriptor& descriptor = *messages[0]->GetDescriptor();
+  for (int i_field = 0; i_field < descriptor.field_count(); ++i_field) {
+    const FieldDescriptor& field = *descriptor.field(i_field);
+    ASSIGN_OR_RETURN(auto values, slice.GetAttrWithDefault(field.name(),
+                                                           missing));
+    if (values.present_count() == 0) {
+      continue;
+    }
+    RETURN_IF_ERROR(FillField(messages, field, values));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status ToProto(const DataSlice& slice,
+                     absl::Span<const absl::Nonnull<Message*>> messages) {
+  if (slice.GetShape().rank() != 1) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected a rank-1 DataSlice, got rank %d", slice.GetShape().rank()));
+  }
+  if (slice.size() != messages.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected %d messages, got %d", slice.size(), messages.size()));
+  }
+  if (messages.empty()) {
+    return absl::OkStatus();
+  }
+  const Descriptor* descriptor = messages[0]->GetDescriptor();
+  for (const Message* message : messages) {
+    if (message->GetDescriptor() != descriptor) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "expected all messages to have the same type, got %s and %s",
+          descriptor->full_name(), message->GetDescriptor()->full_name()));
+    }
+  }
+  return FillMessages(messages, slice);
+}
+
+absl::Status ToProtoDelimited(const DataSlice& slice,
+                              const Message& prototype,
+                              google::protobuf::io::CodedOutputStream& output,
+                              int64_t batch_size) {
+  if (slice.GetShape().rank() != 1) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected a rank-1 DataSlice, got rank %d", slice.GetShape().rank()));
+  }
+  if (batch_size <= 0) {
+    return absl::InvalidArgumentError(
+        absl::StrFormat("batch_size must be positive, got %d", batch_size));
+  }
+  const int64_t size = slice.size();
+  std::vector<std::unique_ptr<Message>> owned_messages;
+  std::vector<absl::Nonnull<Message*>> messages;
+  for (int64_t begin = 0; begin < size; begin += batch_size) {
+    const int64_t batch_len = std::min(batch_size, size - begin);
+    while (owned_messages.size() < batch_len) {
+      owned_messages.emplace_back(prototype.New());
+      messages.push_back(owned_messages.back().get());
+    }
+    for (int64_t i = 0; i < batch_len; ++i) {
+      messages[i]->Clear();
+    }
+    ASSIGN_OR_RETURN(auto batch, GetRange(slice, begin, batch_len));
+    auto batch_messages = absl::MakeConstSpan(messages).subspan(0, batch_len);
+    RETURN_IF_ERROR(FillMessages(batch_messages, batch));
+    for (Message* message : batch_messages) {
+      const size_t message_size = message->ByteSizeLong();
+      if (message_size > std::numeric_limits<int32_t>::max()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "serialized message is too large: %d bytes", message_size));
+      }
+      output.WriteVarint32(static_cast<uint32_t>(message_size));
+      message->SerializeWithCachedSizes(&output);
+      if (output.HadError()) {
+        return absl::DataLossError("failed to write to the output stream");
+      }
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace koladata
@@ -0,0 +1,57 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_PROTO_TO_PROTO_H_
+#define KOLADATA_PROTO_TO_PROTO_H_
+
+#include <cstdint>
+
+#include "absl/base/nullability.h"
+#include "absl/status/status.h"
+#include "absl/types/span.h"
+#include "koladata/data_slice.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/message.h"
+
+namespace koladata {
+
+// Fills `messages` (which must all have the same type) from the rank-1
+// DataSlice `slice` of entities or objects with the same size. This is the
+// reverse of FromProto.
+//
+// Each message field is filled from the attribute with the same name:
+// primitives are converted to the field type, objects / entities to
+// sub-messages, lists to repeated fields and dicts to map fields. Missing
+// attributes and missing values leave the corresponding fields untouched.
+// Extensions are not converted.
+//
+// The conversion is columnar: every attribute is fetched once for the whole
+// batch of messages rather than once per message.
+absl::Status ToProto(
+    const DataSlice& slice,
+    absl::Span<const absl::Nonnull<::google::protobuf::Message*>> messages);
+
+// Converts `slice` to messages of the same type as `prototype` and writes
+// them to `output` as a sequence of length-delimited serialized messages
+// (the format of `google::protobuf::util::SerializeDelimitedToCodedStream`).
+// The messages are converted in batches of `batch_size` and reused between
+// batches, so that the whole output is never materialized as messages.
+absl::Status ToProtoDelimited(const DataSlice& slice,
+                              const ::google::protobuf::Message& prototype,
+                              ::google::protobuf::io::CodedOutputStream& output,
+                              int64_t batch_size = 1024);
+
+}  // namespace koladata
+
+#endif  // KOLADATA_PROTO_TO_PROTO_H_
@@ -0,0 +1,180 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/proto/to_proto.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "koladata/casting.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_slice.h"
+#include "koladata/object_factories.h"
+#include "koladata/proto/from_proto.h"
+#include "koladata/proto/testing/test_proto2.pb.h"
+#include "koladata/test_utils.h"
+#include "google/protobuf/io/coded_stream.h"
+#include "google/protobuf/io/zero_copy_stream_impl_lite.h"
+#include "google/protobuf/message.h"
+#include "google/protobuf/text_format.h"
+#include "arolla/util/testing/equals_proto.h"
+#include "arolla/util/text.h"
+
+namespace koladata {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::arolla::testing::EqualsProto;
+using ::google::protobuf::TextFormat;
+using ::koladata::testing::ExampleMessage;
+using ::testing::HasSubstr;
+
+constexpr absl::string_view kMessage1 = R"pb(
+  int32_field: 1
+  int64_field: -2
+  uint32_field: 3
+  uint64_field: 4
+  double_field: 5.5
+  float_field: 6.5
+  bool_field: true
+  enum_field: EXAMPLE_ENUM_BAR
+  string_field: "abc"
+  bytes_field: "def"
+  message_field { int32_field: 7 }
+  repeated_int32_field: [ 1, 2, 3 ]
+  repeated_string_field: [ "x", "y" ]
+  repeated_message_field { int32_field: 8 }
+  repeated_message_field { string_field: "z" }
+  map_int32_int32_field { key: 1 value: 2 }
+  map_string_string_field { key: "a" value: "b" }
+  map_int32_message_field {
+    key: 3
+    value { bool_field: false }
+  }
+)pb";
+
+constexpr absl::string_view kMessage2 = R"pb(
+  int32_field: 10
+  repeated_bool_field: [ false, true ]
+  map_int32_message_field {
+    key: 4
+    value { message_field { int64_field: 5 } }
+  }
+)pb";
+
+std::vector<ExampleMessage> ParseMessages() {
+  std::vector<ExampleMessage> messages(3);
+  CHECK(TextFormat::ParseFromString(kMessage1, &messages[0]));
+  CHECK(TextFormat::ParseFromString(kMessage2, &messages[1]));
+  return messages;
+}
+
+absl::StatusOr<DataSlice> ConvertFromProto(
+    const std::vector<ExampleMessage>& messages) {
+  std::vector<const google::protobuf::Message*> message_ptrs;
+  for (const auto& message : messages) {
+    message_ptrs.push_back(&message);
+  }
+  return FromProto(DataBag::Empty(), message_ptrs);
+}
+
+TEST(ToProtoTest, RoundTrip) {
+  auto expected = ParseMessages();
+  ASSERT_OK_AND_ASSIGN(auto slice, ConvertFromProto(expected));
+
+  std::vector<ExampleMessage> messages(3);
+  std::vector<google::protobuf::Message*> message_ptrs;
+  for (auto& message : messages) {
+    message_ptrs.push_back(&message);
+  }
+  ASSERT_OK(ToProto(slice, message_ptrs));
+  for (int i = 0; i < messages.size(); ++i) {
+    EXPECT_THAT(messages[i], EqualsProto(expected[i])) << i;
+  }
+
+  // Objects are converted the same way as entities.
+  ASSERT_OK_AND_ASSIGN(auto objects, ToObject(slice));
+  std::vector<ExampleMessage> object_messages(3);
+  message_ptrs.clear();
+  for (auto& message : object_messages) {
+    message_ptrs.push_back(&message);
+  }
+  ASSERT_OK(ToProto(objects, message_ptrs));
+  for (int i = 0; i < messages.size(); ++i) {
+    EXPECT_THAT(object_messages[i], EqualsProto(expected[i])) << i;
+  }
+}
+
+TEST(ToProtoTest, Delimited) {
+  auto expected = ParseMessages();
+  ASSERT_OK_AND_ASSIGN(auto slice, ConvertFromProto(expected));
+
+  for (int64_t batch_size : {1, 2, 1024}) {
+    std::string serialized;
+    {
+      google::protobuf::io::StringOutputStream string_stream(&serialized);
+      google::protobuf::io::CodedOutputStream output(&string_stream);
+      ASSERT_OK(
+          ToProtoDelimited(slice, ExampleMessage(), output, batch_size));
+    }
+    google::protobuf::io::CodedInputStream input(
+        reinterpret_cast<const uint8_t*>(serialized.data()),
+        serialized.size());
+    for (const auto& expected_message : expected) {
+      uint32_t size;
+      ASSERT_TRUE(input.ReadVarint32(&size));
+      auto limit = input.PushLimit(size);
+      ExampleMessage message;
+      ASSERT_TRUE(message.ParseFromCodedStream(&input));
+      input.PopLimit(limit);
+      EXPECT_THAT(message, EqualsProto(expected_message));
+    }
+    EXPECT_TRUE(input.ExpectAtEnd());
+  }
+}
+
+TEST(ToProtoTest, Errors) {
+  ExampleMessage message;
+  std::vector<google::protobuf::Message*> message_ptrs = {&message};
+  {
+    auto db = DataBag::Empty();
+    ASSERT_OK_AND_ASSIGN(auto slice,
+                         ObjectCreator::FromAttrs(
+                             db, {"int32_field"},
+                             {test::DataSlice<arolla::Text>({"a"})}));
+    EXPECT_THAT(ToProto(slice, message_ptrs),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("cannot convert values of type TEXT to "
+                                   "proto field "
+                                   "koladata.testing.ExampleMessage."
+                                   "int32_field")));
+  }
+  EXPECT_THAT(ToProto(test::DataSlice<int>({1, 2}), message_ptrs),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "expected 2 messages, got 1"));
+  EXPECT_THAT(ToProto(test::DataItem(1), message_ptrs),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       "expected a rank-1 DataSlice, got rank 0"));
+}
+
+}  // namespace
+}  // namespace koladata
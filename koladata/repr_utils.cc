@@ -190,30 +190,80 @@ absl::StatusOr<Error> SetIncompatibleSchemaError(
   return cause;
 }
 
+// Returns the assembled error for the `cause` error kinds that need the
+// supplemental data, and nullopt for the other ones.
+absl::StatusOr<std::optional<Error>> AssembleError(
+    Error cause, const SupplementalData& data) {
+  if (cause.has_no_common_schema()) {
+    return SetNoCommonSchemaError(std::move(cause), data.db);
+  }
+  if (cause.has_missing_object_schema()) {
+    return SetMissingObjectAttributeError(std::move(cause), data.ds);
+  }
+  if (cause.has_incompatible_schema()) {
+    return SetIncompatibleSchemaError(std::move(cause), data.db, data.ds);
+  }
+  return std::nullopt;
+}
+
+bool IsFrozen(const DataBagPtr& db) {
+  if (db->IsMutable()) {
+    return false;
+  }
+  for (const DataBagPtr& fallback : db->GetFallbacks()) {
+    if (!IsFrozen(fallback)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Returns true if the error message can be assembled later with the same
+// result: a mutable DataBag could be modified by then, so the message must be
+// assembled right away.
+bool CanAssembleLazily(const SupplementalData& data) {
+  if (data.db == nullptr && !data.ds.has_value()) {
+    // Missing data is reported right away.
+    return false;
+  }
+  if (data.db != nullptr && !IsFrozen(data.db)) {
+    return false;
+  }
+  if (data.ds.has_value() && data.ds->GetDb() != nullptr &&
+      !IsFrozen(data.ds->GetDb())) {
+    return false;
+  }
+  return true;
+}
+
 }  // namespace
 
 absl::Status AssembleErrorMessage(const absl::Status& status,
                                   const SupplementalData& data) {
-  std::optional<Error> cause = GetErrorPayload(status);
-  if (!cause) {
+  if (!internal::HasErrorPayload(status)) {
     return status;
   }
-  if (cause->has_no_common_schema()) {
-    ASSIGN_OR_RETURN(Error error,
-                     SetNoCommonSchemaError(*std::move(cause), data.db));
-    return WithErrorPayload(status, error);
-  }
-  if (cause->has_missing_object_schema()) {
-    ASSIGN_OR_RETURN(Error error, SetMissingObjectAttributeError(
-                                      *std::move(cause), data.ds));
-    return WithErrorPayload(status, error);
+  if (CanAssembleLazily(data)) {
+    // The message is rendered (which may require printing DataSlices) only if
+    // the error is eventually reported.
+    return internal::WithLazyErrorPayload(
+        status, [status, data]() -> absl::StatusOr<Error> {
+          std::optional<Error> cause = GetErrorPayload(status);
+          if (!cause) {
+            return absl::InternalError("missing error payload");
+          }
+          ASSIGN_OR_RETURN(std::optional<Error> error,
+                           AssembleError(*cause, data));
+          return error.has_value() ? *std::move(error) : *std::move(cause);
+        });
   }
-  if (cause->has_incompatible_schema()) {
-    ASSIGN_OR_RETURN(Error error, SetIncompatibleSchemaError(*std::move(cause),
-                                                             data.db, data.ds));
-    return WithErrorPayload(status, error);
+  std::optional<Error> cause = GetErrorPayload(status);
+  if (!cause) {
+    return status;
   }
-  return status;
+  ASSIGN_OR_RETURN(std::optional<Error> error,
+                   AssembleError(*std::move(cause), data));
+  return error.has_value() ? WithErrorPayload(status, *error) : status;
 }
 
 absl::Status CreateItemCreationError(const absl::Status& status,
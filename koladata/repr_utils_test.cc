@@ -37,7 +37,9 @@ namespace {
 
 using ::absl_testing::StatusIs;
 using ::koladata::internal::Error;
+using ::testing::HasSubstr;
 using ::testing::MatchesRegex;
+using ::testing::Not;
 using ::testing::StrEq;
 
 TEST(ReprUtilTest, TestAssembleError) {
@@ -75,6 +77,32 @@ TEST(ReprUtilTest, TestAssembleError) {
               R"regex((.|\n)*the first conflicting schema INT32: INT32(.|\n)*)regex")));
 }
 
+TEST(ReprUtilTest, TestAssembleErrorMutableBag) {
+  DataBagPtr bag = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      DataSlice entity,
+      EntityCreator::FromAttrs(bag, {"a"}, {test::DataItem(1)}));
+
+  Error error;
+  internal::NoCommonSchema* no_common_schema = error.mutable_no_common_schema();
+  ASSERT_OK_AND_ASSIGN(*no_common_schema->mutable_common_schema(),
+                       internal::EncodeDataItem(entity.GetSchemaImpl()));
+  ASSERT_OK_AND_ASSIGN(*no_common_schema->mutable_conflicting_schema(),
+                       internal::EncodeDataItem(
+                           internal::DataItem(schema::GetDType<int>())));
+
+  absl::Status status = AssembleErrorMessage(
+      internal::WithErrorPayload(absl::InvalidArgumentError("error"), error),
+      {bag});
+  // The message reflects the bag at the time of the error.
+  ASSERT_OK(bag->GetMutableImpl()->get().SetSchemaAttr(
+      entity.GetSchemaImpl(), "b", internal::DataItem(schema::kInt32)));
+  std::optional<Error> payload = internal::GetErrorPayload(status);
+  ASSERT_TRUE(payload.has_value());
+  EXPECT_THAT(payload->error_message(),
+              AllOf(HasSubstr("SCHEMA(a=INT32)"), Not(HasSubstr("b=INT32"))));
+}
+
 TEST(ReprUtilTest, TestAssembleErrorMissingContextData) {
   Error error;
   internal::NoCommonSchema* no_common_schema = error.mutable_no_common_schema();
@@ -0,0 +1,397 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/s11n/chunked.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/base/call_once.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "koladata/data_bag.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/s11n/codec.pb.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/qtype/typed_value.h"
+#include "arolla/serialization/decode.h"
+#include "arolla/serialization/encode.h"
+#include "arolla/serialization_base/base.pb.h"
+#include "arolla/util/text.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::s11n {
+namespace {
+
+using ::arolla::serialization_base::ContainerProto;
+using ::koladata::internal::AllocationId;
+using ::koladata::internal::DataBagContent;
+using ::koladata::internal::DataBagImpl;
+using ::koladata::internal::DataBagIndex;
+using ::koladata::internal::DataItem;
+using ::koladata::internal::DataSliceImpl;
+using ::koladata::internal::ObjectId;
+
+// Accumulates extracted content into a DataBag and emits it once it is large
+// enough.
+class ChunkBuilder {
+ public:
+  ChunkBuilder(const ChunkedEncodingOptions& options,
+               absl::FunctionRef<absl::Status(ContainerProto)> sink)
+      : options_(options), sink_(sink) {}
+
+  // Adds `content` to the current chunk. Emits the chunk if it reached the
+  // size limit.
+  absl::Status Add(const DataBagContent& content) {
+    if (chunk_ == nullptr) {
+      chunk_ = DataBag::Empty();
+    }
+    ASSIGN_OR_RETURN(DataBagImpl & impl, chunk_->GetMutableImpl());
+    for (const auto& [attr_name, attr_content] : content.attrs) {
+      RETURN_IF_ERROR(AddAttr(attr_name, attr_content, impl));
+    }
+    for (const DataBagContent::ListsContent& lists : content.lists) {
+      RETURN_IF_ERROR(AddLists(lists, impl));
+    }
+    for (const DataBagContent::DictContent& dict : content.dicts) {
+      RETURN_IF_ERROR(AddDict(dict, impl));
+    }
+    if (chunk_values_ >= options_.max_chunk_values) {
+      return Flush();
+    }
+    return absl::OkStatus();
+  }
+
+  // Emits the current chunk if it is not empty.
+  absl::Status Flush() {
+    if (chunk_values_ == 0) {
+      return absl::OkStatus();
+    }
+    ASSIGN_OR_RETURN(
+        ContainerProto proto,
+        arolla::serialization::Encode(
+            {arolla::TypedValue::FromValue(std::move(chunk_))}, {}));
+    chunk_ = nullptr;
+    chunk_values_ = 0;
+    return sink_(std::move(proto));
+  }
+
+ private:
+  absl::Status AddAttr(const std::string& attr_name,
+                       const DataBagContent::AttrContent& content,
+                       DataBagImpl& impl) {
+    for (const DataBagContent::AttrAllocContent& ac : content.allocs) {
+      // Shares the extracted values rather than copying them again.
+      RETURN_IF_ERROR(
+          impl.SetAttrForEntireAllocation(ac.alloc_id, attr_name, ac.values));
+      chunk_values_ += ac.values.size();
+    }
+    if (content.items.empty()) {
+      return absl::OkStatus();
+    }
+    arolla::Buffer<ObjectId>::Builder ids_bldr(content.items.size());
+    DataSliceImpl::Builder values_bldr(content.items.size());
+    for (int64_t i = 0; i < content.items.size(); ++i) {
+      ids_bldr.Set(i, content.items[i].object_id);
+      values_bldr.Insert(i, content.items[i].value);
+    }
+    RETURN_IF_ERROR(impl.SetAttr(
+        DataSliceImpl::Create(
+            arolla::DenseArray<ObjectId>{std::move(ids_bldr).Build()}),
+        attr_name, std::move(values_bldr).Build()));
+    chunk_values_ += content.items.size();
+    return absl::OkStatus();
+  }
+
+  absl::Status AddLists(const DataBagContent::ListsContent& lists,
+                        DataBagImpl& impl) {
+    const arolla::DenseArrayEdge& edge = lists.lists_to_values_edge;
+    RETURN_IF_ERROR(impl.ExtendLists(
+        DataSliceImpl::ObjectsFromAllocation(lists.alloc_id,
+                                             edge.parent_size()),
+        lists.values, edge));
+    chunk_values_ += edge.parent_size() + lists.values.size();
+    return absl::OkStatus();
+  }
+
+  absl::Status AddDict(const DataBagContent::DictContent& dict,
+                       DataBagImpl& impl) {
+    chunk_values_ += dict.keys.size();
+    if (dict.dict_id.IsSchema()) {
+      DataItem schema(dict.dict_id);
+      for (int64_t i = 0; i < dict.keys.size(); ++i) {
+        RETURN_IF_ERROR(impl.SetSchemaAttr(
+            schema, dict.keys[i].value<arolla::Text>().view(),
+            dict.values[i]));
+      }
+      return absl::OkStatus();
+    }
+    return impl.SetInDict(
+        DataSliceImpl::Create(dict.keys.size(), DataItem(dict.dict_id)),
+        DataSliceImpl::Create(dict.keys), DataSliceImpl::Create(dict.values));
+  }
+
+  const ChunkedEncodingOptions& options_;
+  absl::FunctionRef<absl::Status(ContainerProto)> sink_;
+  DataBagPtr chunk_;
+  int64_t chunk_values_ = 0;
+};
+
+absl::StatusOr<DataBagPtr> DecodeChunk(const ContainerProto& chunk) {
+  ASSIGN_OR_RETURN(auto decode_result, arolla::serialization::Decode(chunk));
+  if (decode_result.values.size() != 1 || !decode_result.exprs.empty()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "expected a single DataBag in a chunk, got ",
+        decode_result.values.size(), " values and ",
+        decode_result.exprs.size(), " expressions"));
+  }
+  return decode_result.values[0].As<DataBagPtr>();
+}
+
+// Returns the DataBagProto of the chunk without decoding it, or nullptr if
+// the chunk doesn't hold exactly one DataBag.
+const KodaV1Proto::DataBagProto* FindDataBagProto(const ContainerProto& chunk) {
+  const KodaV1Proto::DataBagProto* result = nullptr;
+  for (const auto& step : chunk.decoding_steps()) {
+    if (!step.has_value() ||
+        !step.value().HasExtension(KodaV1Proto::extension)) {
+      continue;
+    }
+    const KodaV1Proto& koda_proto =
+        step.value().GetExtension(KodaV1Proto::extension);
+    if (!koda_proto.has_data_bag_value()) {
+      continue;
+    }
+    if (result != nullptr) {
+      return nullptr;
+    }
+    result = &koda_proto.data_bag_value();
+  }
+  return result;
+}
+
+// Appends the (allocation, attribute) pairs set for entire big allocations by
+// `proto` to `keys`. Returns false if `proto` has any other content.
+template <typename AttrKey>
+bool CollectEntireAllocationAttrs(const KodaV1Proto::DataBagProto& proto,
+                                  std::vector<AttrKey>& keys) {
+  bool only_entire_allocations = proto.fallback_count() == 0 &&
+                                 proto.lists().empty() && proto.dicts().empty();
+  for (const auto& attr_proto : proto.attrs()) {
+    for (const auto& chunk_proto : attr_proto.chunks()) {
+      ObjectId first = ObjectId::UnsafeCreateFromInternalHighLow(
+          chunk_proto.first_object_id().hi(),
+          chunk_proto.first_object_id().lo());
+      if (first.IsSmallAlloc() || first.Offset() != 0) {
+        only_entire_allocations = false;
+        continue;
+      }
+      keys.emplace_back(AllocationId(first), attr_proto.name());
+    }
+  }
+  return only_entire_allocations;
+}
+
+// Validates the parts of `chunk` the lazy decoding relies on, so that a
+// malformed chunk is rejected when it is added rather than on the first access
+// to its values: the chunk has a single output value, and the attribute
+// chunks of its DataBag reference values decoded by earlier steps.
+absl::Status ValidateLazyChunk(const ContainerProto& chunk) {
+  const auto& steps = chunk.decoding_steps();
+  int64_t output_values = 0;
+  for (int64_t i = 0; i < steps.size(); ++i) {
+    const auto& step = steps[i];
+    if (step.has_output_value_index()) {
+      ++output_values;
+      if (step.output_value_index() >= static_cast<uint64_t>(i)) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "invalid output value index in a chunk: ",
+            step.output_value_index()));
+      }
+    }
+    if (step.has_output_expr_index()) {
+      return absl::InvalidArgumentError(
+          "expected a single DataBag in a chunk, got an expression");
+    }
+    if (!step.has_value() ||
+        !step.value().HasExtension(KodaV1Proto::extension)) {
+      continue;
+    }
+    const auto& value = step.value();
+    for (uint64_t index : value.input_value_indices()) {
+      if (index >= static_cast<uint64_t>(i) || !steps[index].has_value()) {
+        return absl::InvalidArgumentError(absl::StrCat(
+            "invalid input value index in a chunk: ", index));
+      }
+    }
+    const KodaV1Proto& koda_proto = value.GetExtension(KodaV1Proto::extension);
+    if (!koda_proto.has_data_bag_value()) {
+      continue;
+    }
+    for (const auto& attr_proto : koda_proto.data_bag_value().attrs()) {
+      for (const auto& chunk_proto : attr_proto.chunks()) {
+        if (chunk_proto.values_subindex() < 0 ||
+            chunk_proto.values_subindex() >= value.input_value_indices_size()) {
+          return absl::InvalidArgumentError(
+              absl::StrCat("invalid input value index: ",
+                           chunk_proto.values_subindex()));
+        }
+      }
+    }
+  }
+  if (output_values != 1) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "expected a single DataBag in a chunk, got ", output_values,
+        " values"));
+  }
+  return absl::OkStatus();
+}
+
+// Encoded chunk shared by the lazy attributes of all its allocations. It is
+// decoded once, on the first access to any of them.
+class LazyChunk {
+ public:
+  explicit LazyChunk(ContainerProto proto) : proto_(std::move(proto)) {}
+
+  const absl::StatusOr<DataBagPtr>& Get() {
+    absl::call_once(once_, [this] {
+      db_ = DecodeChunk(proto_);
+      proto_.Clear();
+    });
+    return db_;
+  }
+
+ private:
+  absl::once_flag once_;
+  ContainerProto proto_;
+  absl::StatusOr<DataBagPtr> db_;
+};
+
+absl::StatusOr<DataSliceImpl> LoadAttr(LazyChunk& chunk, AllocationId alloc,
+                                       absl::string_view attr) {
+  const absl::StatusOr<DataBagPtr>& db = chunk.Get();
+  RETURN_IF_ERROR(db.status());
+  const DataBagImpl& impl = (*db)->GetImpl();
+  DataBagImpl::ConstDenseSourceArray dense_sources;
+  DataBagImpl::ConstSparseSourceArray sparse_sources;
+  int64_t size =
+      impl.GetAttributeDataSources(alloc, attr, dense_sources, sparse_sources);
+  return impl.GetAttr(DataSliceImpl::ObjectsFromAllocation(alloc, size), attr);
+}
+
+}  // namespace
+
+absl::Status EncodeDataBagChunked(
+    const DataBagPtr& db, const ChunkedEncodingOptions& options,
+    absl::FunctionRef<absl::Status(ContainerProto)> sink) {
+  if (!db->GetFallbacks().empty()) {
+    return absl::InvalidArgumentError(
+        "chunked encoding of DataBags with fallbacks is not supported");
+  }
+  const DataBagImpl& impl = db->GetImpl();
+  DataBagIndex index = impl.CreateIndex(/*include_parents=*/!options.delta);
+  ChunkBuilder builder(options, sink);
+  // Content is extracted one allocation at a time, so that only a single
+  // allocation is materialized in addition to the current chunk.
+  auto add = [&](DataBagIndex piece) -> absl::Status {
+    ASSIGN_OR_RETURN(DataBagContent content, impl.ExtractContent(piece));
+    return builder.Add(content);
+  };
+  for (const auto& [attr_name, attr_index] : index.attrs) {
+    if (attr_index.with_small_allocs) {
+      DataBagIndex piece;
+      piece.attrs[attr_name] = {.allocations = {}, .with_small_allocs = true};
+      RETURN_IF_ERROR(add(std::move(piece)));
+    }
+    for (AllocationId alloc : attr_index.allocations) {
+      DataBagIndex piece;
+      piece.attrs[attr_name] = {.allocations = {alloc},
+                                .with_small_allocs = false};
+      RETURN_IF_ERROR(add(std::move(piece)));
+    }
+  }
+  for (AllocationId alloc : index.lists) {
+    DataBagIndex piece;
+    piece.lists = {alloc};
+    RETURN_IF_ERROR(add(std::move(piece)));
+  }
+  for (AllocationId alloc : index.dicts) {
+    DataBagIndex piece;
+    piece.dicts = {alloc};
+    RETURN_IF_ERROR(add(std::move(piece)));
+  }
+  return builder.Flush();
+}
+
+absl::Status ChunkedDataBagDecoder::AddChunk(const ContainerProto& chunk) {
+  if (!overwrite_) {
+    if (const auto* proto = FindDataBagProto(chunk); proto != nullptr) {
+      std::vector<AttrKey> keys;
+      CollectEntireAllocationAttrs(*proto, keys);
+      added_attrs_.insert(keys.begin(), keys.end());
+    }
+  }
+  ASSIGN_OR_RETURN(DataBagPtr chunk_db, DecodeChunk(chunk));
+  if (overwrite_) {
+    return db_->MergeInplace(chunk_db, /*overwrite=*/true,
+                             /*allow_data_conflicts=*/true,
+                             /*allow_schema_conflicts=*/true);
+  }
+  // Chunks are disjoint, so any conflict means corrupted input.
+  return db_->MergeInplace(chunk_db, /*overwrite=*/false,
+                           /*allow_data_conflicts=*/false,
+                           /*allow_schema_conflicts=*/false);
+}
+
+absl::Status ChunkedDataBagDecoder::AddLazyChunk(ContainerProto chunk) {
+  const KodaV1Proto::DataBagProto* proto = FindDataBagProto(chunk);
+  std::vector<AttrKey> keys;
+  if (proto == nullptr || !CollectEntireAllocationAttrs(*proto, keys)) {
+    return AddChunk(chunk);
+  }
+  if (!overwrite_) {
+    for (const AttrKey& key : keys) {
+      if (added_attrs_.contains(key)) {
+        // Merging reports the conflict.
+        return AddChunk(chunk);
+      }
+    }
+  }
+  RETURN_IF_ERROR(ValidateLazyChunk(chunk));
+  ASSIGN_OR_RETURN(DataBagImpl & impl, db_->GetMutableImpl());
+  auto lazy_chunk = std::make_shared<LazyChunk>(std::move(chunk));
+  for (AttrKey& key : keys) {
+    auto& [alloc, attr] = key;
+    RETURN_IF_ERROR(impl.SetAttrForEntireAllocationLazily(
+        alloc, attr, [lazy_chunk, alloc, attr]() {
+          return LoadAttr(*lazy_chunk, alloc, attr);
+        }));
+    if (!overwrite_) {
+      added_attrs_.insert(std::move(key));
+    }
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace koladata::s11n
@@ -0,0 +1,117 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_S11N_CHUNKED_H_
+#define KOLADATA_S11N_CHUNKED_H_
+
+#include <cstdint>
+#include <string>
+#include <utility>
+
+#include "absl/container/flat_hash_set.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "koladata/data_bag.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/serialization_base/base.pb.h"
+
+// Chunked serialization of DataBags.
+//
+// Encoding a DataBag as a single value requires the whole content to be
+// extracted and converted to protos at once. Chunked encoding walks the
+// DataBag index allocation by allocation and emits a sequence of independent
+// ContainerProtos, each holding a DataBag with a bounded number of values. So
+// the peak memory usage is proportional to the chunk size rather than to the
+// size of the DataBag.
+
+namespace koladata::s11n {
+
+struct ChunkedEncodingOptions {
+  // A chunk is emitted as soon as it contains at least `max_chunk_values`
+  // values. A single allocation is never split, so a chunk can be larger if
+  // an allocation is larger.
+  int64_t max_chunk_values = 1 << 20;
+  // If true, only the allocations modified in the top DataBagImpl of the
+  // DataBag (i.e. since the last fork) are encoded, so the size of the result
+  // is proportional to the size of the update rather than of the whole
+  // DataBag. The allocations are encoded with their full content, so applying
+  // the delta (see ChunkedDataBagDecoder(base)) overwrites them in the base.
+  // Attributes, list items and dict keys removed in the fork are not
+  // propagated.
+  bool delta = false;
+};
+
+// Encodes `db` (including its parents unless `options.delta` is set, but not
+// fallbacks) as a sequence of chunks passed to `sink`. Each chunk is a
+// ContainerProto with a single DataBag value. An empty DataBag produces no
+// chunks.
+//
+// Example of shipping an update of a large DataBag:
+//   ASSIGN_OR_RETURN(DataBagPtr update, base->Fork());
+//   ... modify `update` ...
+//   RETURN_IF_ERROR(EncodeDataBagChunked(update, {.delta = true}, sink));
+absl::Status EncodeDataBagChunked(
+    const DataBagPtr& db, const ChunkedEncodingOptions& options,
+    absl::FunctionRef<
+        absl::Status(arolla::serialization_base::ContainerProto)>
+        sink);
+
+// Assembles a DataBag from the chunks produced by EncodeDataBagChunked. The
+// chunks are merged in place as they arrive, so at most one decoded chunk is
+// kept in memory in addition to the result.
+class ChunkedDataBagDecoder {
+ public:
+  ChunkedDataBagDecoder() : db_(DataBag::Empty()) {}
+
+  // Applies the chunks on top of `base`, overwriting the existing values.
+  // Used to decode chunks encoded with `ChunkedEncodingOptions::delta`.
+  // `base` is modified in place, so it must be mutable (use base->Fork() to
+  // keep the original).
+  explicit ChunkedDataBagDecoder(DataBagPtr base)
+      : db_(std::move(base)), overwrite_(true) {}
+
+  // Decodes `chunk` and merges it into the result.
+  absl::Status AddChunk(
+      const arolla::serialization_base::ContainerProto& chunk);
+
+  // Same as AddChunk, but if the chunk holds only attributes of big
+  // allocations (which is the case for the chunks of large allocations
+  // produced by EncodeDataBagChunked), it is kept encoded and decoded only on
+  // the first access to any of its attributes; the decoded values are then
+  // cached in the result as readonly DenseSources. So the cost of decoding a
+  // bag is proportional to the size of the chunks metadata rather than to
+  // the number of values, and chunks that are never read are never decoded.
+  //
+  // The structure of a lazy chunk is validated here, but the errors of
+  // decoding its values are only returned by the reads of its attributes
+  // (e.g. DataBagImpl::GetAttr). Other chunks are decoded immediately, same
+  // as in AddChunk.
+  absl::Status AddLazyChunk(arolla::serialization_base::ContainerProto chunk);
+
+  // Returns the assembled DataBag.
+  DataBagPtr Finish() && { return std::move(db_); }
+
+ private:
+  using AttrKey = std::pair<internal::AllocationId, std::string>;
+
+  DataBagPtr db_;
+  bool overwrite_ = false;
+  // Attributes of big allocations added so far. Used to detect conflicts with
+  // lazy chunks, which are not merged and so not checked by MergeInplace.
+  absl::flat_hash_set<AttrKey> added_attrs_;
+};
+
+}  // namespace koladata::s11n
+
+#endif  // KOLADATA_S11N_CHUNKED_H_
@@ -0,0 +1,287 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/s11n/chunked.h"
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/string_view.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_bag_comparison.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/s11n/codec.pb.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/serialization_base/base.pb.h"
+#include "arolla/util/text.h"
+
+namespace koladata::s11n {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::arolla::serialization_base::ContainerProto;
+using ::koladata::internal::DataBagImpl;
+using ::koladata::internal::DataItem;
+using ::koladata::internal::DataSliceImpl;
+using ::testing::HasSubstr;
+
+DataBagPtr CreateTestDataBag() {
+  DataBagPtr db = DataBag::Empty();
+  DataBagImpl& impl = db->GetMutableImpl().value().get();
+  auto objs1 = DataSliceImpl::AllocateEmptyObjects(10);
+  auto objs2 = DataSliceImpl::AllocateEmptyObjects(20);
+  CHECK_OK(impl.SetAttr(
+      objs1, "a",
+      DataSliceImpl::Create(arolla::CreateConstDenseArray<int32_t>(10, 1))));
+  CHECK_OK(impl.SetAttr(
+      objs2, "a",
+      DataSliceImpl::Create(arolla::CreateConstDenseArray<float>(20, 2.5))));
+  CHECK_OK(impl.SetAttr(objs2, "b", objs1));
+  CHECK_OK(impl.SetAttr(DataItem(internal::AllocateSingleObject()), "a",
+                        DataItem(arolla::Text("small"))));
+
+  auto lists = DataSliceImpl::ObjectsFromAllocation(
+      internal::AllocateLists(2), 2);
+  auto edge = arolla::DenseArrayEdge::FromSplitPoints(
+                  arolla::CreateDenseArray<int64_t>({0, 1, 3}))
+                  .value();
+  CHECK_OK(impl.ExtendLists(
+      lists, DataSliceImpl::Create(arolla::CreateDenseArray<int32_t>({1, 2, 3})),
+      edge));
+  CHECK_OK(impl.SetInDict(DataItem(internal::AllocateSingleDict()),
+                          DataItem(1), DataItem(2)));
+  CHECK_OK(impl.SetSchemaAttr(DataItem(internal::AllocateExplicitSchema()),
+                              "x", DataItem(schema::kInt32)));
+  return db;
+}
+
+std::vector<ContainerProto> EncodeChunks(const DataBagPtr& db,
+                                         int64_t max_chunk_values) {
+  std::vector<ContainerProto> chunks;
+  CHECK_OK(EncodeDataBagChunked(
+      db, {.max_chunk_values = max_chunk_values},
+      [&](ContainerProto chunk) {
+        chunks.push_back(std::move(chunk));
+        return absl::OkStatus();
+      }));
+  return chunks;
+}
+
+DataBagPtr DecodeChunks(const std::vector<ContainerProto>& chunks) {
+  ChunkedDataBagDecoder decoder;
+  for (const ContainerProto& chunk : chunks) {
+    CHECK_OK(decoder.AddChunk(chunk));
+  }
+  return std::move(decoder).Finish();
+}
+
+TEST(ChunkedTest, SingleChunk) {
+  DataBagPtr db = CreateTestDataBag();
+  std::vector<ContainerProto> chunks = EncodeChunks(db, 1 << 20);
+  EXPECT_EQ(chunks.size(), 1);
+  EXPECT_TRUE(DataBagComparison::ExactlyEqual(DecodeChunks(chunks), db));
+}
+
+TEST(ChunkedTest, ChunkPerAllocation) {
+  DataBagPtr db = CreateTestDataBag();
+  std::vector<ContainerProto> chunks = EncodeChunks(db, 1);
+  // 3 attr allocations + small allocations, 1 lists, 2 dicts.
+  EXPECT_EQ(chunks.size(), 7);
+  EXPECT_TRUE(DataBagComparison::ExactlyEqual(DecodeChunks(chunks), db));
+}
+
+TEST(ChunkedTest, Fork) {
+  DataBagPtr db = CreateTestDataBag();
+  ASSERT_OK_AND_ASSIGN(DataBagPtr fork, db->Fork());
+  DataBagImpl& impl = fork->GetMutableImpl().value().get();
+  CHECK_OK(impl.SetAttr(DataItem(internal::AllocateSingleObject()), "c",
+                        DataItem(5)));
+  EXPECT_TRUE(
+      DataBagComparison::ExactlyEqual(DecodeChunks(EncodeChunks(fork, 10)),
+                                      fork));
+}
+
+TEST(ChunkedTest, Delta) {
+  DataBagPtr base = CreateTestDataBag();
+  auto objs = DataSliceImpl::AllocateEmptyObjects(5);
+  DataItem dict(internal::AllocateSingleDict());
+  CHECK_OK(base->GetMutableImpl()->get().SetInDict(dict, DataItem(1),
+                                                   DataItem(2)));
+  // The receiver of the delta has its own copy of the base.
+  DataBagPtr loaded_base = DecodeChunks(EncodeChunks(base, 1 << 20));
+
+  ASSERT_OK_AND_ASSIGN(DataBagPtr update, base->Fork());
+  DataBagImpl& impl = update->GetMutableImpl().value().get();
+  CHECK_OK(impl.SetAttr(
+      objs, "c",
+      DataSliceImpl::Create(arolla::CreateConstDenseArray<int32_t>(5, 7))));
+  CHECK_OK(impl.SetInDict(dict, DataItem(1), DataItem(3)));
+  CHECK_OK(impl.SetInDict(dict, DataItem(4), DataItem(5)));
+
+  std::vector<ContainerProto> chunks;
+  CHECK_OK(EncodeDataBagChunked(update, {.delta = true},
+                                [&](ContainerProto chunk) {
+                                  chunks.push_back(std::move(chunk));
+                                  return absl::OkStatus();
+                                }));
+  ASSERT_EQ(chunks.size(), 1);
+  ChunkedDataBagDecoder decoder(loaded_base);
+  ASSERT_OK(decoder.AddChunk(chunks[0]));
+  DataBagPtr result = std::move(decoder).Finish();
+  EXPECT_TRUE(DataBagComparison::ExactlyEqual(result, update));
+
+  // Only the modified allocations are encoded.
+  ChunkedDataBagDecoder delta_decoder;
+  ASSERT_OK(delta_decoder.AddChunk(chunks[0]));
+  DataBagPtr delta = std::move(delta_decoder).Finish();
+  internal::DataBagIndex index = delta->GetImpl().CreateIndex();
+  EXPECT_EQ(index.attrs.size(), 1);
+  EXPECT_TRUE(index.attrs.contains("c"));
+  EXPECT_EQ(index.dicts.size(), 1);
+  EXPECT_TRUE(index.lists.empty());
+}
+
+TEST(ChunkedTest, LazyChunks) {
+  DataBagPtr db = CreateTestDataBag();
+  std::vector<ContainerProto> chunks = EncodeChunks(db, 1);
+  ChunkedDataBagDecoder decoder;
+  for (ContainerProto& chunk : chunks) {
+    ASSERT_OK(decoder.AddLazyChunk(std::move(chunk)));
+  }
+  DataBagPtr result = std::move(decoder).Finish();
+  using StorageKind = internal::DataBagMemoryUsage::StorageKind;
+  auto dense_usage = [&](absl::string_view attr) {
+    return result->GetImpl()
+        .EstimateMemoryUsage()
+        .entries[{std::string(attr), StorageKind::kDenseSource}]
+        .total();
+  };
+  // Big allocations are not decoded yet, but already listed in the index.
+  EXPECT_EQ(dense_usage("b"), 0);
+  EXPECT_EQ(result->GetImpl().CreateIndex().attrs.at("b").allocations.size(),
+            1);
+
+  internal::AllocationId alloc =
+      result->GetImpl().CreateIndex().attrs.at("b").allocations[0];
+  ASSERT_OK_AND_ASSIGN(
+      DataSliceImpl b,
+      result->GetImpl().GetAttr(
+          DataSliceImpl::ObjectsFromAllocation(alloc, 20), "b"));
+  EXPECT_EQ(b.present_count(), 20);
+  EXPECT_GT(dense_usage("b"), 0);
+  EXPECT_TRUE(DataBagComparison::ExactlyEqual(result, db));
+}
+
+// Returns the decoding step of the DataBag of `chunk`.
+arolla::serialization_base::DecodingStepProto& DataBagStep(
+    ContainerProto& chunk) {
+  arolla::serialization_base::DecodingStepProto* result = nullptr;
+  for (auto& step : *chunk.mutable_decoding_steps()) {
+    if (step.has_value() && step.value().HasExtension(KodaV1Proto::extension) &&
+        step.value()
+            .GetExtension(KodaV1Proto::extension)
+            .has_data_bag_value()) {
+      result = &step;
+    }
+  }
+  CHECK(result != nullptr);
+  return *result;
+}
+
+std::vector<ContainerProto> EncodeSingleAttrChunks(
+    const DataSliceImpl& objs) {
+  DataBagPtr db = DataBag::Empty();
+  CHECK_OK(db->GetMutableImpl()->get().SetAttr(
+      objs, "a",
+      DataSliceImpl::Create(arolla::CreateConstDenseArray<int32_t>(10, 1))));
+  std::vector<ContainerProto> chunks = EncodeChunks(db, 1);
+  CHECK_EQ(chunks.size(), 1);
+  return chunks;
+}
+
+TEST(ChunkedTest, LazyChunkInvalidStructure) {
+  auto objs = DataSliceImpl::AllocateEmptyObjects(10);
+  std::vector<ContainerProto> chunks = EncodeSingleAttrChunks(objs);
+  DataBagStep(chunks[0])
+      .mutable_value()
+      ->MutableExtension(KodaV1Proto::extension)
+      ->mutable_data_bag_value()
+      ->mutable_attrs(0)
+      ->mutable_chunks(0)
+      ->set_values_subindex(100);
+  // Rejected eagerly, without decoding the values.
+  ChunkedDataBagDecoder decoder;
+  EXPECT_THAT(decoder.AddLazyChunk(std::move(chunks[0])),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("invalid input value index: 100")));
+}
+
+TEST(ChunkedTest, LazyChunkDecodingError) {
+  auto objs = DataSliceImpl::AllocateEmptyObjects(10);
+  std::vector<ContainerProto> chunks = EncodeSingleAttrChunks(objs);
+  // Breaks decoding of the attribute values, but keeps the structure of the
+  // chunk valid.
+  auto& db_step = DataBagStep(chunks[0]);
+  int64_t values_step = db_step.value().input_value_indices(
+      db_step.value()
+          .GetExtension(KodaV1Proto::extension)
+          .data_bag_value()
+          .attrs(0)
+          .chunks(0)
+          .values_subindex());
+  chunks[0]
+      .mutable_decoding_steps(values_step)
+      ->mutable_value()
+      ->set_codec_index(1000);
+
+  ChunkedDataBagDecoder decoder;
+  ASSERT_OK(decoder.AddLazyChunk(std::move(chunks[0])));
+  DataBagPtr result = std::move(decoder).Finish();
+  // The error is returned by the reads rather than treated as missing values.
+  EXPECT_THAT(result->GetImpl().GetAttr(objs, "a"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+  EXPECT_THAT(result->GetImpl().GetAttr(objs[0], "a"),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+TEST(ChunkedTest, Empty) {
+  DataBagPtr db = DataBag::Empty();
+  std::vector<ContainerProto> chunks = EncodeChunks(db, 10);
+  EXPECT_TRUE(chunks.empty());
+  EXPECT_TRUE(DataBagComparison::ExactlyEqual(DecodeChunks(chunks), db));
+}
+
+TEST(ChunkedTest, Fallbacks) {
+  DataBagPtr db = DataBag::ImmutableEmptyWithFallbacks({CreateTestDataBag()});
+  EXPECT_THAT(EncodeDataBagChunked(db, {}, [](ContainerProto) {
+                return absl::OkStatus();
+              }),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("fallbacks is not supported")));
+}
+
+}  // namespace
+}  // namespace koladata::s11n
@@ -0,0 +1,747 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/s11n/columnar.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+#include "absl/cleanup/cleanup.h"
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "absl/types/span.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/internal/spill_pool.h"
+#include "koladata/s11n/columnar.pb.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/expr/quote.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/bytes.h"
+#include "arolla/util/meta.h"
+#include "arolla/util/text.h"
+#include "arolla/util/unit.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::s11n {
+namespace {
+
+using ::arolla::bitmap::Word;
+using ::koladata::internal::AllocationId;
+using ::koladata::internal::AllocationIdSet;
+using ::koladata::internal::DataBagContent;
+using ::koladata::internal::DataBagImpl;
+using ::koladata::internal::DataBagImplPtr;
+using ::koladata::internal::DataItem;
+using ::koladata::internal::DataSliceImpl;
+using ::koladata::internal::ObjectId;
+
+using ArrayProto = ColumnarDataBagProto::ArrayProto;
+using BufferProto = ColumnarDataBagProto::BufferProto;
+using DictItemsProto = ColumnarDataBagProto::DictItemsProto;
+using ObjectIdProto = ColumnarDataBagProto::ObjectIdProto;
+using SliceProto = ColumnarDataBagProto::SliceProto;
+
+// ExprQuote is not supported because it can not be represented as a raw
+// buffer.
+using SupportedTypes =
+    arolla::meta::type_list<ObjectId, int32_t, int64_t, float, double, bool,
+                            arolla::Unit, arolla::Text, arolla::Bytes,
+                            schema::DType>;
+
+constexpr size_t kHeaderSize = kColumnarMagic.size() + sizeof(uint64_t);
+
+template <class T>
+constexpr bool kIsStringType =
+    std::is_same_v<T, arolla::Text> || std::is_same_v<T, arolla::Bytes>;
+
+uint64_t AlignUp(uint64_t x) {
+  return (x + kColumnarAlignment - 1) / kColumnarAlignment *
+         kColumnarAlignment;
+}
+
+template <class T>
+absl::string_view AsBytes(absl::Span<const T> span) {
+  return absl::string_view(reinterpret_cast<const char*>(span.data()),
+                           span.size() * sizeof(T));
+}
+
+void EncodeObjectId(ObjectId id, ObjectIdProto* proto) {
+  proto->set_hi(id.InternalHigh64());
+  proto->set_lo(id.InternalLow64());
+}
+
+ObjectId DecodeObjectId(const ObjectIdProto& proto) {
+  return ObjectId::UnsafeCreateFromInternalHighLow(proto.hi(), proto.lo());
+}
+
+// ********* Encoding
+
+// Assigns offsets to the buffers of the data region and writes them. Buffers
+// are referenced, not copied, so the arrays are held until the region is
+// written.
+class DataRegionBuilder {
+ public:
+  void AddBuffer(absl::string_view bytes, BufferProto& proto) {
+    size_ = AlignUp(size_);
+    proto.set_offset(size_);
+    proto.set_size(bytes.size());
+    buffers_.push_back({size_, bytes});
+    size_ += bytes.size();
+  }
+
+  absl::string_view Own(std::vector<Word> words) {
+    return AsBytes(absl::MakeConstSpan(
+        owned_bitmaps_.emplace_back(std::move(words))));
+  }
+
+  void Hold(DataSliceImpl slice) { held_slices_.push_back(std::move(slice)); }
+
+  uint64_t size() const { return size_; }
+
+  absl::Status WriteTo(
+      absl::FunctionRef<absl::Status(absl::string_view)> sink) const {
+    static constexpr char kZeros[kColumnarAlignment] = {};
+    uint64_t pos = 0;
+    for (const auto& [offset, bytes] : buffers_) {
+      RETURN_IF_ERROR(sink(absl::string_view(kZeros, offset - pos)));
+      RETURN_IF_ERROR(sink(bytes));
+      pos = offset + bytes.size();
+    }
+    return absl::OkStatus();
+  }
+
+ private:
+  struct Buffer {
+    uint64_t offset;
+    absl::string_view bytes;
+  };
+
+  uint64_t size_ = 0;
+  std::vector<Buffer> buffers_;
+  std::vector<std::vector<Word>> owned_bitmaps_;
+  std::vector<DataSliceImpl> held_slices_;
+};
+
+template <class T>
+void EncodeArray(const arolla::DenseArray<T>& array, DataRegionBuilder& region,
+                 ArrayProto& proto) {
+  proto.set_value_qtype(std::string(arolla::GetQType<T>()->name()));
+  if (!array.bitmap.empty()) {
+    const int64_t bitmap_size = arolla::bitmap::BitmapSize(array.size());
+    if (array.bitmap_bit_offset == 0) {
+      region.AddBuffer(AsBytes(array.bitmap.span().subspan(0, bitmap_size)),
+                       *proto.mutable_bitmap());
+    } else {
+      std::vector<Word> words(bitmap_size);
+      for (int64_t i = 0; i < bitmap_size; ++i) {
+        words[i] = arolla::bitmap::GetWordWithOffset(array.bitmap, i,
+                                                     array.bitmap_bit_offset);
+      }
+      region.AddBuffer(region.Own(std::move(words)), *proto.mutable_bitmap());
+    }
+  }
+  if constexpr (std::is_same_v<T, arolla::Unit>) {
+    // Only presence is stored.
+  } else if constexpr (kIsStringType<T>) {
+    const arolla::StringsBuffer& values = array.values;
+    region.AddBuffer(AsBytes(values.offsets()), *proto.mutable_values());
+    region.AddBuffer(AsBytes(values.characters()),
+                     *proto.mutable_characters());
+    proto.set_characters_base_offset(values.base_offset());
+  } else {
+    region.AddBuffer(AsBytes(array.values.span()), *proto.mutable_values());
+  }
+}
+
+absl::Status EncodeSlice(const DataSliceImpl& slice, DataRegionBuilder& region,
+                         SliceProto& proto) {
+  proto.set_size(slice.size());
+  RETURN_IF_ERROR(slice.VisitValues([&](const auto& array) -> absl::Status {
+    using T = typename std::decay_t<decltype(array)>::base_type;
+    if constexpr (std::is_same_v<T, arolla::expr::ExprQuote>) {
+      return absl::UnimplementedError(
+          "ExprQuote is not supported in the columnar DataBag format");
+    } else {
+      EncodeArray(array, region, *proto.add_arrays());
+      return absl::OkStatus();
+    }
+  }));
+  for (AllocationId alloc : slice.allocation_ids()) {
+    EncodeObjectId(alloc.ObjectByOffset(0), proto.add_allocation_ids());
+  }
+  if (slice.allocation_ids().contains_small_allocation_id()) {
+    proto.set_contains_small_allocation_id(true);
+  }
+  region.Hold(slice);
+  return absl::OkStatus();
+}
+
+absl::Status EncodeAttr(const DataBagContent::AttrContent& content,
+                        DataRegionBuilder& region,
+                        ColumnarDataBagProto::AttrProto& proto) {
+  for (const DataBagContent::AttrAllocContent& ac : content.allocs) {
+    EncodeObjectId(ac.alloc_id.ObjectByOffset(0), proto.add_alloc_ids());
+    RETURN_IF_ERROR(EncodeSlice(ac.values, region, *proto.add_alloc_values()));
+  }
+  if (content.items.empty()) {
+    return absl::OkStatus();
+  }
+  arolla::Buffer<ObjectId>::Builder ids_bldr(content.items.size());
+  DataSliceImpl::Builder values_bldr(content.items.size());
+  for (int64_t i = 0; i < content.items.size(); ++i) {
+    ids_bldr.Set(i, content.items[i].object_id);
+    values_bldr.Insert(i, content.items[i].value);
+  }
+  RETURN_IF_ERROR(EncodeSlice(
+      DataSliceImpl::Create(arolla::DenseArray<ObjectId>{
+          std::move(ids_bldr).Build()}),
+      region, *proto.mutable_item_ids()));
+  return EncodeSlice(std::move(values_bldr).Build(), region,
+                     *proto.mutable_item_values());
+}
+
+absl::Status EncodeLists(const DataBagContent::ListsContent& content,
+                         DataRegionBuilder& region,
+                         ColumnarDataBagProto::ListsProto& proto) {
+  EncodeObjectId(content.alloc_id.ObjectByOffset(0), proto.mutable_alloc_id());
+  RETURN_IF_ERROR(EncodeSlice(content.values, region, *proto.mutable_values()));
+  const arolla::DenseArray<int64_t>& splits =
+      content.lists_to_values_edge.edge_values();
+  EncodeArray(splits, region, *proto.mutable_splits());
+  region.Hold(DataSliceImpl::Create(splits));
+  return absl::OkStatus();
+}
+
+absl::Status EncodeDictItems(
+    absl::Span<const DataBagContent::DictContent* const> dicts,
+    DataRegionBuilder& region, DictItemsProto& proto) {
+  int64_t size = 0;
+  for (const auto* dict : dicts) {
+    size += dict->keys.size();
+  }
+  arolla::Buffer<ObjectId>::Builder ids_bldr(size);
+  DataSliceImpl::Builder keys_bldr(size);
+  DataSliceImpl::Builder values_bldr(size);
+  int64_t offset = 0;
+  for (const auto* dict : dicts) {
+    for (int64_t i = 0; i < dict->keys.size(); ++i, ++offset) {
+      ids_bldr.Set(offset, dict->dict_id);
+      keys_bldr.Insert(offset, dict->keys[i]);
+      values_bldr.Insert(offset, dict->values[i]);
+    }
+  }
+  RETURN_IF_ERROR(EncodeSlice(
+      DataSliceImpl::Create(arolla::DenseArray<ObjectId>{
+          std::move(ids_bldr).Build()}),
+      region, *proto.mutable_dict_ids()));
+  RETURN_IF_ERROR(
+      EncodeSlice(std::move(keys_bldr).Build(), region, *proto.mutable_keys()));
+  return EncodeSlice(std::move(values_bldr).Build(), region,
+                     *proto.mutable_values());
+}
+
+absl::Status BuildColumnarProto(const DataBagImpl& db,
+                                DataRegionBuilder& region,
+                                ColumnarDataBagProto& proto) {
+  ASSIGN_OR_RETURN(DataBagContent content, db.ExtractContent());
+  for (const auto& [attr_name, attr_content] : content.attrs) {
+    ColumnarDataBagProto::AttrProto& attr_proto = *proto.add_attrs();
+    attr_proto.set_name(attr_name);
+    RETURN_IF_ERROR(EncodeAttr(attr_content, region, attr_proto));
+  }
+  for (const DataBagContent::ListsContent& lists : content.lists) {
+    RETURN_IF_ERROR(EncodeLists(lists, region, *proto.add_lists()));
+  }
+  std::vector<const DataBagContent::DictContent*> dicts;
+  std::vector<const DataBagContent::DictContent*> schemas;
+  for (const DataBagContent::DictContent& dict : content.dicts) {
+    (dict.dict_id.IsSchema() ? schemas : dicts).push_back(&dict);
+  }
+  RETURN_IF_ERROR(EncodeDictItems(dicts, region, *proto.mutable_dicts()));
+  RETURN_IF_ERROR(EncodeDictItems(schemas, region, *proto.mutable_schemas()));
+  proto.set_data_size(region.size());
+  return absl::OkStatus();
+}
+
+// ********* Decoding
+
+// Data region of the serialized DataBag.
+class DataRegion {
+ public:
+  DataRegion(std::shared_ptr<const void> holder, absl::string_view data)
+      : holder_(std::move(holder)), data_(data) {}
+
+  // Returns a buffer referencing the data region. If `expected_size` is not
+  // negative, the number of elements must be equal to it.
+  template <class T>
+  absl::StatusOr<arolla::Buffer<T>> GetBuffer(const BufferProto& proto,
+                                              int64_t expected_size) const {
+    if (proto.offset() > data_.size() ||
+        proto.size() > data_.size() - proto.offset()) {
+      return absl::InvalidArgumentError(
+          absl::StrCat("buffer [", proto.offset(), ", +", proto.size(),
+                       ") is out of the data region of size ", data_.size()));
+    }
+    if (proto.size() % sizeof(T) != 0) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "buffer size ", proto.size(), " is not a multiple of ", sizeof(T)));
+    }
+    const char* ptr = data_.data() + proto.offset();
+    if (reinterpret_cast<uintptr_t>(ptr) % alignof(T) != 0) {
+      return absl::InvalidArgumentError("buffer is not aligned");
+    }
+    const int64_t size = proto.size() / sizeof(T);
+    if (expected_size >= 0 && size != expected_size) {
+      return absl::InvalidArgumentError(absl::StrCat(
+          "unexpected buffer size: ", size, " vs ", expected_size));
+    }
+    return arolla::Buffer<T>(
+        holder_, absl::Span<const T>(reinterpret_cast<const T*>(ptr), size));
+  }
+
+ private:
+  std::shared_ptr<const void> holder_;
+  absl::string_view data_;
+};
+
+template <class T>
+absl::StatusOr<arolla::DenseArray<T>> DecodeArray(const ArrayProto& proto,
+                                                  int64_t size,
+                                                  const DataRegion& region) {
+  arolla::DenseArray<T> res;
+  if (proto.has_bitmap()) {
+    ASSIGN_OR_RETURN(res.bitmap,
+                     region.GetBuffer<Word>(proto.bitmap(),
+                                            arolla::bitmap::BitmapSize(size)));
+  }
+  if constexpr (std::is_same_v<T, arolla::Unit>) {
+    res.values = arolla::VoidBuffer(size);
+  } else if constexpr (kIsStringType<T>) {
+    using Offsets = arolla::StringsBuffer::Offsets;
+    ASSIGN_OR_RETURN(auto offsets,
+                     region.GetBuffer<Offsets>(proto.values(), size));
+    ASSIGN_OR_RETURN(auto characters,
+                     region.GetBuffer<char>(proto.characters(), -1));
+    // The only validation that requires reading the values: out of bounds
+    // offsets would make the array unsafe to use.
+    const int64_t base_offset = proto.characters_base_offset();
+    for (const Offsets& o : offsets.span()) {
+      if (o.start > o.end || o.start < base_offset ||
+          o.end - base_offset > characters.size()) {
+        return absl::InvalidArgumentError("invalid string offsets");
+      }
+    }
+    res.values = arolla::StringsBuffer(std::move(offsets),
+                                       std::move(characters), base_offset);
+  } else {
+    ASSIGN_OR_RETURN(res.values, region.GetBuffer<T>(proto.values(), size));
+  }
+  return res;
+}
+
+absl::StatusOr<DataSliceImpl> DecodeSlice(const SliceProto& proto,
+                                          const DataRegion& region) {
+  const int64_t size = proto.size();
+  if (size < 0) {
+    return absl::InvalidArgumentError("negative slice size");
+  }
+  if (proto.arrays().empty()) {
+    return DataSliceImpl::CreateEmptyAndUnknownType(size);
+  }
+  DataSliceImpl::Builder bldr(size);
+  AllocationIdSet& alloc_ids = bldr.GetMutableAllocationIds();
+  for (const ObjectIdProto& id : proto.allocation_ids()) {
+    alloc_ids.Insert(AllocationId(DecodeObjectId(id)));
+  }
+  if (proto.contains_small_allocation_id()) {
+    alloc_ids.InsertSmallAllocationId();
+  }
+  std::vector<absl::string_view> used_qtypes;
+  for (const ArrayProto& array_proto : proto.arrays()) {
+    absl::string_view qtype_name = array_proto.value_qtype();
+    for (absl::string_view used : used_qtypes) {
+      if (used == qtype_name) {
+        return absl::InvalidArgumentError(
+            absl::StrCat("duplicated array type in a slice: ", qtype_name));
+      }
+    }
+    used_qtypes.push_back(qtype_name);
+    absl::Status status = absl::InvalidArgumentError(
+        absl::StrCat("unsupported array type: ", qtype_name));
+    arolla::meta::foreach_type(SupportedTypes(), [&](auto tpe) {
+      using T = typename decltype(tpe)::type;
+      if (qtype_name != arolla::GetQType<T>()->name()) {
+        return;
+      }
+      absl::StatusOr<arolla::DenseArray<T>> array =
+          DecodeArray<T>(array_proto, size, region);
+      status = array.status();
+      if (!array.ok()) {
+        return;
+      }
+      if constexpr (std::is_same_v<T, schema::DType>) {
+        array->ForEachPresent([&](int64_t, schema::DType dtype) {
+          if (dtype.type_id() < 0 || dtype.type_id() >= schema::kNextDTypeId) {
+            status = absl::InvalidArgumentError("invalid DType");
+          }
+        });
+      }
+      bldr.AddArray(*std::move(array));
+    });
+    RETURN_IF_ERROR(status);
+  }
+  return std::move(bldr).Build();
+}
+
+absl::Status DecodeAttr(const ColumnarDataBagProto::AttrProto& proto,
+                        const DataRegion& region, DataBagImpl& db) {
+  if (proto.alloc_ids_size() != proto.alloc_values_size()) {
+    return absl::InvalidArgumentError(
+        "alloc_ids and alloc_values sizes mismatch");
+  }
+  for (int i = 0; i < proto.alloc_ids_size(); ++i) {
+    ASSIGN_OR_RETURN(DataSliceImpl values,
+                     DecodeSlice(proto.alloc_values(i), region));
+    RETURN_IF_ERROR(db.SetAttrForEntireAllocation(
+        AllocationId(DecodeObjectId(proto.alloc_ids(i))), proto.name(),
+        values));
+  }
+  if (!proto.has_item_ids()) {
+    return absl::OkStatus();
+  }
+  ASSIGN_OR_RETURN(DataSliceImpl ids, DecodeSlice(proto.item_ids(), region));
+  ASSIGN_OR_RETURN(DataSliceImpl values,
+                   DecodeSlice(proto.item_values(), region));
+  if (ids.size() != values.size()) {
+    return absl::InvalidArgumentError("item_ids and item_values size mismatch");
+  }
+  return db.SetAttr(ids, proto.name(), values);
+}
+
+absl::Status DecodeLists(const ColumnarDataBagProto::ListsProto& proto,
+                         const DataRegion& region, DataBagImpl& db) {
+  AllocationId alloc(DecodeObjectId(proto.alloc_id()));
+  ASSIGN_OR_RETURN(DataSliceImpl values, DecodeSlice(proto.values(), region));
+  // Lists are not splittable into a readonly source, so they are copied into
+  // DataListVector by ExtendLists.
+  int64_t splits_size = proto.splits().values().size() / sizeof(int64_t);
+  ASSIGN_OR_RETURN(
+      arolla::DenseArray<int64_t> splits,
+      DecodeArray<int64_t>(proto.splits(), splits_size, region));
+  ASSIGN_OR_RETURN(auto edge, arolla::DenseArrayEdge::FromSplitPoints(splits));
+  if (edge.parent_size() > alloc.Capacity() ||
+      edge.child_size() != values.size()) {
+    return absl::InvalidArgumentError("invalid lists split points");
+  }
+  return db.ExtendLists(
+      DataSliceImpl::ObjectsFromAllocation(alloc, edge.parent_size()), values,
+      edge);
+}
+
+absl::Status DecodeDictItems(const DictItemsProto& proto,
+                             const DataRegion& region, DataBagImpl& db,
+                             bool schemas) {
+  ASSIGN_OR_RETURN(DataSliceImpl ids, DecodeSlice(proto.dict_ids(), region));
+  ASSIGN_OR_RETURN(DataSliceImpl keys, DecodeSlice(proto.keys(), region));
+  ASSIGN_OR_RETURN(DataSliceImpl values, DecodeSlice(proto.values(), region));
+  if (ids.size() != keys.size() || ids.size() != values.size()) {
+    return absl::InvalidArgumentError("dict items size mismatch");
+  }
+  if (!schemas) {
+    return db.SetInDict(ids, keys, values);
+  }
+  for (int64_t i = 0; i < ids.size(); ++i) {
+    DataItem key = keys[i];
+    if (!key.holds_value<arolla::Text>()) {
+      return absl::InvalidArgumentError("schema key must be arolla::Text");
+    }
+    RETURN_IF_ERROR(db.SetSchemaAttr(ids[i], key.value<arolla::Text>().view(),
+                                     values[i]));
+  }
+  return absl::OkStatus();
+}
+
+}  // namespace
+
+absl::Status WriteColumnarDataBag(
+    const internal::DataBagImpl& db,
+    absl::FunctionRef<absl::Status(absl::string_view)> sink) {
+  DataRegionBuilder region;
+  ColumnarDataBagProto proto;
+  RETURN_IF_ERROR(BuildColumnarProto(db, region, proto));
+  std::string metadata;
+  if (!proto.SerializeToString(&metadata)) {
+    return absl::InternalError("failed to serialize ColumnarDataBagProto");
+  }
+  const uint64_t metadata_size = metadata.size();
+  RETURN_IF_ERROR(sink(kColumnarMagic));
+  RETURN_IF_ERROR(sink(absl::string_view(
+      reinterpret_cast<const char*>(&metadata_size), sizeof(metadata_size))));
+  RETURN_IF_ERROR(sink(metadata));
+  const uint64_t header_end = kHeaderSize + metadata_size;
+  RETURN_IF_ERROR(sink(std::string(AlignUp(header_end) - header_end, '\0')));
+  return region.WriteTo(sink);
+}
+
+absl::StatusOr<std::string> EncodeColumnarDataBag(
+    const internal::DataBagImpl& db) {
+  std::string result;
+  RETURN_IF_ERROR(WriteColumnarDataBag(db, [&](absl::string_view piece) {
+    result.append(piece);
+    return absl::OkStatus();
+  }));
+  return result;
+}
+
+absl::Status WriteColumnarDataBagFile(const internal::DataBagImpl& db,
+                                      const std::string& path) {
+  std::FILE* file = std::fopen(path.c_str(), "wb");
+  if (file == nullptr) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to open ", path));
+  }
+  absl::Status status = WriteColumnarDataBag(db, [&](absl::string_view piece) {
+    if (std::fwrite(piece.data(), 1, piece.size(), file) != piece.size()) {
+      return absl::ErrnoToStatus(errno,
+                                 absl::StrCat("failed to write ", path));
+    }
+    return absl::OkStatus();
+  });
+  if (std::fclose(file) != 0 && status.ok()) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to close ", path));
+  }
+  return status;
+}
+
+absl::StatusOr<internal::DataBagImplPtr> DecodeColumnarDataBag(
+    std::shared_ptr<const void> data_holder, absl::string_view data) {
+  if (data.size() < kHeaderSize ||
+      data.substr(0, kColumnarMagic.size()) != kColumnarMagic) {
+    return absl::InvalidArgumentError("not a columnar DataBag");
+  }
+  uint64_t metadata_size;
+  std::memcpy(&metadata_size, data.data() + kColumnarMagic.size(),
+              sizeof(metadata_size));
+  if (metadata_size > data.size() - kHeaderSize) {
+    return absl::InvalidArgumentError("truncated columnar DataBag");
+  }
+  ColumnarDataBagProto proto;
+  if (!proto.ParseFromArray(data.data() + kHeaderSize, metadata_size)) {
+    return absl::InvalidArgumentError(
+        "failed to parse ColumnarDataBagProto");
+  }
+  const uint64_t data_offset = AlignUp(kHeaderSize + metadata_size);
+  if (data_offset > data.size() ||
+      proto.data_size() > data.size() - data_offset) {
+    return absl::InvalidArgumentError("truncated columnar DataBag");
+  }
+  DataRegion region(std::move(data_holder),
+                    data.substr(data_offset, proto.data_size()));
+
+  DataBagImplPtr db = DataBagImpl::CreateEmptyDatabag();
+  for (const ColumnarDataBagProto::AttrProto& attr_proto : proto.attrs()) {
+    RETURN_IF_ERROR(DecodeAttr(attr_proto, region, *db));
+  }
+  for (const ColumnarDataBagProto::ListsProto& lists_proto : proto.lists()) {
+    RETURN_IF_ERROR(DecodeLists(lists_proto, region, *db));
+  }
+  if (proto.has_dicts()) {
+    RETURN_IF_ERROR(
+        DecodeDictItems(proto.dicts(), region, *db, /*schemas=*/false));
+  }
+  if (proto.has_schemas()) {
+    RETURN_IF_ERROR(
+        DecodeDictItems(proto.schemas(), region, *db, /*schemas=*/true));
+  }
+  return db;
+}
+
+namespace {
+
+// Maps the whole `fd` read-only and decodes it. `name` is used in the errors.
+absl::StatusOr<internal::DataBagImplPtr> MapAndDecode(int fd,
+                                                      const std::string& name,
+                                                      int flags) {
+  struct stat file_stat;
+  if (fstat(fd, &file_stat) != 0) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to stat ", name));
+  }
+  const size_t size = file_stat.st_size;
+  if (size == 0) {
+    return absl::InvalidArgumentError(absl::StrCat(name, " is empty"));
+  }
+  void* addr = mmap(nullptr, size, PROT_READ, flags, fd, 0);
+  if (addr == MAP_FAILED) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to mmap ", name));
+  }
+  std::shared_ptr<const void> holder(addr, [size](const void* ptr) {
+    munmap(const_cast<void*>(ptr), size);
+  });
+  return DecodeColumnarDataBag(
+      std::move(holder),
+      absl::string_view(static_cast<const char*>(addr), size));
+}
+
+}  // namespace
+
+absl::StatusOr<internal::DataBagImplPtr> LoadColumnarDataBagFile(
+    const std::string& path) {
+  int fd = open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to open ", path));
+  }
+  absl::Cleanup close_fd = [fd] { close(fd); };
+  return MapAndDecode(fd, path, MAP_PRIVATE);
+}
+
+absl::Status WriteColumnarDataBagSharedMemory(const internal::DataBagImpl& db,
+                                              const std::string& name) {
+  // The size is needed upfront to map the segment, so the data is serialized
+  // twice. The first pass only sums up the sizes of the pieces.
+  uint64_t size = 0;
+  RETURN_IF_ERROR(WriteColumnarDataBag(db, [&](absl::string_view piece) {
+    size += piece.size();
+    return absl::OkStatus();
+  }));
+  int fd = shm_open(name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0644);
+  if (fd < 0) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to create ", name));
+  }
+  absl::Cleanup close_fd = [fd] { close(fd); };
+  bool written = false;
+  absl::Cleanup unlink_on_error = [&] {
+    if (!written) {
+      shm_unlink(name.c_str());
+    }
+  };
+  if (ftruncate(fd, size) != 0) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to resize ", name));
+  }
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+  if (addr == MAP_FAILED) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to mmap ", name));
+  }
+  absl::Cleanup unmap = [addr, size] { munmap(addr, size); };
+  char* data = static_cast<char*>(addr);
+  uint64_t offset = 0;
+  RETURN_IF_ERROR(WriteColumnarDataBag(db, [&](absl::string_view piece) {
+    if (offset + piece.size() > size) {
+      return absl::InternalError("columnar DataBag size changed");
+    }
+    // The magic is written last, so that a reader that maps the segment
+    // before it is complete fails with "not a columnar DataBag" instead of
+    // reading partial data. The segment is zero-filled by ftruncate.
+    size_t skip = 0;
+    if (offset < kColumnarMagic.size()) {
+      skip = std::min<size_t>(kColumnarMagic.size() - offset, piece.size());
+    }
+    std::memcpy(data + offset + skip, piece.data() + skip,
+                piece.size() - skip);
+    offset += piece.size();
+    return absl::OkStatus();
+  }));
+  std::atomic_thread_fence(std::memory_order_release);
+  std::memcpy(data, kColumnarMagic.data(), kColumnarMagic.size());
+  written = true;
+  return absl::OkStatus();
+}
+
+absl::StatusOr<internal::DataBagImplPtr> LoadColumnarDataBagSharedMemory(
+    const std::string& name) {
+  int fd = shm_open(name.c_str(), O_RDONLY, 0);
+  if (fd < 0) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to open ", name));
+  }
+  absl::Cleanup close_fd = [fd] { close(fd); };
+  return MapAndDecode(fd, name, MAP_SHARED);
+}
+
+absl::Status UnlinkColumnarDataBagSharedMemory(const std::string& name) {
+  if (shm_unlink(name.c_str()) != 0) {
+    return absl::ErrnoToStatus(errno, absl::StrCat("failed to unlink ", name));
+  }
+  return absl::OkStatus();
+}
+
+namespace {
+
+class ColumnarSpillStorage final : public internal::SpillPool::Storage {
+ public:
+  explicit ColumnarSpillStorage(std::string directory)
+      : directory_(std::move(directory)) {}
+
+  absl::StatusOr<std::string> Write(AllocationId alloc,
+                                    const DataSliceImpl& values) final {
+    DataBagImplPtr db = DataBagImpl::CreateEmptyDatabag();
+    RETURN_IF_ERROR(db->SetAttrForEntireAllocation(alloc, kAttr, values));
+    std::string path = absl::StrCat(
+        directory_, "/kd_spill_", reinterpret_cast<uintptr_t>(this), "_",
+        next_file_id_.fetch_add(1, std::memory_order_relaxed));
+    absl::Status status = WriteColumnarDataBagFile(*db, path);
+    if (!status.ok()) {
+      std::remove(path.c_str());
+      return status;
+    }
+    return path;
+  }
+
+  absl::StatusOr<DataSliceImpl> Read(const std::string& key,
+                                     AllocationId alloc,
+                                     int64_t size) final {
+    ASSIGN_OR_RETURN(DataBagImplPtr db, LoadColumnarDataBagFile(key));
+    return db->GetAttr(DataSliceImpl::ObjectsFromAllocation(alloc, size),
+                       kAttr);
+  }
+
+  void Remove(const std::string& key) final { std::remove(key.c_str()); }
+
+ private:
+  static constexpr absl::string_view kAttr = "values";
+
+  const std::string directory_;
+  std::atomic<int64_t> next_file_id_ = 0;
+};
+
+}  // namespace
+
+std::unique_ptr<internal::SpillPool::Storage> CreateColumnarSpillStorage(
+    std::string directory) {
+  return std::make_unique<ColumnarSpillStorage>(std::move(directory));
+}
+
+}  // namespace koladata::s11n
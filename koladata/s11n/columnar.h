@@ -0,0 +1,118 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_S11N_COLUMNAR_H_
+#define KOLADATA_S11N_COLUMNAR_H_
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+#include "absl/functional/function_ref.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/string_view.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/spill_pool.h"
+
+// Columnar on-disk format for DataBagImpl, designed for loading without
+// copying the data.
+//
+// Unlike the arolla serialization codec (see encoder.cc), values are not
+// converted to protos. Every array is stored as raw aligned buffers, so that
+// a loaded DataBagImpl references the input memory directly. When the input
+// is mmap-ed, pages are faulted in lazily on the first access.
+//
+// Layout:
+//   8 bytes: kColumnarMagic
+//   8 bytes: size N of the serialized ColumnarDataBagProto (host byte order)
+//   N bytes: ColumnarDataBagProto
+//   padding to a multiple of kColumnarAlignment
+//   data region: buffers referenced by ColumnarDataBagProto.
+//
+// Buffers use the host byte order, so the files are not portable between
+// platforms with different endianness. Only the layout is validated on
+// loading (including string offsets); the values are trusted.
+//
+// Fallbacks are not serialized. ExprQuote values are not supported.
+
+namespace koladata::s11n {
+
+inline constexpr absl::string_view kColumnarMagic = "KDCOLMN1";
+inline constexpr uint64_t kColumnarAlignment = 64;
+
+// Serializes `db` (including its parents) and passes the result to `sink`
+// piece by piece. The data is not copied into an intermediate buffer.
+absl::Status WriteColumnarDataBag(
+    const internal::DataBagImpl& db,
+    absl::FunctionRef<absl::Status(absl::string_view)> sink);
+
+// Serializes `db` into a string.
+absl::StatusOr<std::string> EncodeColumnarDataBag(
+    const internal::DataBagImpl& db);
+
+// Serializes `db` into a file.
+absl::Status WriteColumnarDataBagFile(const internal::DataBagImpl& db,
+                                      const std::string& path);
+
+// Creates DataBagImpl from serialized `data`. Attribute values reference
+// `data` directly; `data_holder` is kept alive by the returned DataBagImpl
+// while they are used. `data.data()` must be aligned at least as malloc
+// memory, otherwise an error is returned.
+absl::StatusOr<internal::DataBagImplPtr> DecodeColumnarDataBag(
+    std::shared_ptr<const void> data_holder, absl::string_view data);
+
+// Memory-maps the file and decodes it with DecodeColumnarDataBag. The mapping
+// is released when it is no longer referenced.
+absl::StatusOr<internal::DataBagImplPtr> LoadColumnarDataBagFile(
+    const std::string& path);
+
+// Shared memory: a DataBag written once into a POSIX shared memory object
+// (see shm_open) can be loaded by any number of processes on the host. The
+// attribute values of the loaded DataBagImpls reference the shared segment,
+// so the processes share a single physical copy of them. Lists and dicts are
+// copied into each process, as they are stored in mutable structures.
+//
+// Typical use with worker processes:
+//   // In the parent, before starting the workers:
+//   RETURN_IF_ERROR(WriteColumnarDataBagSharedMemory(db, "/kd_ref"));
+//   // In each worker:
+//   ASSIGN_OR_RETURN(auto db, LoadColumnarDataBagSharedMemory("/kd_ref"));
+//   // In the parent, once all workers loaded it (the mappings stay valid):
+//   RETURN_IF_ERROR(UnlinkColumnarDataBagSharedMemory("/kd_ref"));
+
+// Creates shared memory object `name` holding serialized `db`. Fails if the
+// object already exists. Until the write is complete, loading fails.
+absl::Status WriteColumnarDataBagSharedMemory(const internal::DataBagImpl& db,
+                                              const std::string& name);
+
+// Maps shared memory object `name` read-only and decodes it with
+// DecodeColumnarDataBag.
+absl::StatusOr<internal::DataBagImplPtr> LoadColumnarDataBagSharedMemory(
+    const std::string& name);
+
+// Removes shared memory object `name`. The memory is released once all the
+// DataBagImpls loaded from it are destroyed.
+absl::Status UnlinkColumnarDataBagSharedMemory(const std::string& name);
+
+// Returns a SpillPool::Storage that writes the evicted values into columnar
+// files in `directory`. The values are read back with LoadColumnarDataBagFile,
+// so they are paged in on demand and the OS can drop the pages again under
+// memory pressure. The files are deleted when the sources are destroyed.
+std::unique_ptr<internal::SpillPool::Storage> CreateColumnarSpillStorage(
+    std::string directory);
+
+}  // namespace koladata::s11n
+
+#endif  // KOLADATA_S11N_COLUMNAR_H_
@@ -0,0 +1,244 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/s11n/columnar.h"
+
+#include <unistd.h>
+
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/string_view.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/internal/spill_pool.h"
+#include "koladata/internal/testing/matchers.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/expr/quote.h"
+#include "arolla/util/text.h"
+
+namespace koladata::s11n {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::koladata::internal::AllocationId;
+using ::koladata::internal::DataBagImpl;
+using ::koladata::internal::DataBagImplPtr;
+using ::koladata::internal::DataItem;
+using ::koladata::internal::DataSliceImpl;
+using ::koladata::internal::ObjectId;
+using ::koladata::internal::testing::IsEquivalentTo;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+TEST(ColumnarTest, Attributes) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  AllocationId alloc = internal::Allocate(4);
+  auto objs = DataSliceImpl::ObjectsFromAllocation(alloc, 4);
+  auto ints = DataSliceImpl::Create(
+      arolla::CreateDenseArray<int32_t>({1, std::nullopt, 3, 4}));
+  auto texts = DataSliceImpl::Create(
+      arolla::CreateDenseArray<arolla::Text>({"a", "bc", std::nullopt, "d"}));
+  auto mixed = DataSliceImpl::Create(
+      arolla::CreateDenseArray<int64_t>({1, std::nullopt, std::nullopt, 2}),
+      arolla::CreateDenseArray<float>({std::nullopt, 2.5, std::nullopt,
+                                       std::nullopt}));
+  ASSERT_OK(db->SetAttr(objs, "a", ints));
+  ASSERT_OK(db->SetAttr(objs, "b", texts));
+  ASSERT_OK(db->SetAttr(objs, "c", mixed));
+  ASSERT_OK(db->SetAttr(objs, "self", objs));
+  ObjectId small_obj = internal::AllocateSingleObject();
+  ASSERT_OK(db->SetAttr(DataItem(small_obj), "a", DataItem(57)));
+
+  ASSERT_OK_AND_ASSIGN(std::string data, EncodeColumnarDataBag(*db));
+  auto holder = std::make_shared<std::string>(data);
+  ASSERT_OK_AND_ASSIGN(
+      DataBagImplPtr loaded,
+      DecodeColumnarDataBag(holder, absl::string_view(*holder)));
+
+  EXPECT_THAT(loaded->GetAttr(objs, "a"), IsOkAndHolds(IsEquivalentTo(ints)));
+  EXPECT_THAT(loaded->GetAttr(objs, "b"), IsOkAndHolds(IsEquivalentTo(texts)));
+  EXPECT_THAT(loaded->GetAttr(objs, "c"), IsOkAndHolds(IsEquivalentTo(mixed)));
+  EXPECT_THAT(loaded->GetAttr(objs, "self"),
+              IsOkAndHolds(IsEquivalentTo(objs)));
+  EXPECT_THAT(loaded->GetAttr(DataItem(small_obj), "a"),
+              IsOkAndHolds(DataItem(57)));
+
+  // Values reference the input buffer.
+  ASSERT_OK_AND_ASSIGN(DataSliceImpl loaded_ints, loaded->GetAttr(objs, "a"));
+  const char* ptr = reinterpret_cast<const char*>(
+      loaded_ints.values<int32_t>().values.span().data());
+  EXPECT_GE(ptr, holder->data());
+  EXPECT_LT(ptr, holder->data() + holder->size());
+}
+
+TEST(ColumnarTest, ListsAndDicts) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  AllocationId lists_alloc = internal::AllocateLists(3);
+  auto lists = DataSliceImpl::ObjectsFromAllocation(lists_alloc, 3);
+  ASSERT_OK_AND_ASSIGN(
+      auto edge, arolla::DenseArrayEdge::FromSplitPoints(
+                     arolla::CreateDenseArray<int64_t>({0, 2, 2, 5})));
+  ASSERT_OK(db->ExtendLists(
+      lists,
+      DataSliceImpl::Create(arolla::CreateDenseArray<int32_t>({1, 2, 3, 4, 5})),
+      edge));
+  ObjectId dict = internal::AllocateSingleDict();
+  ASSERT_OK(db->SetInDict(DataItem(dict), DataItem(arolla::Text("x")),
+                          DataItem(1.5f)));
+  ASSERT_OK(db->SetInDict(DataItem(dict), DataItem(7), DataItem(dict)));
+  ObjectId schema = internal::AllocateExplicitSchema();
+  ASSERT_OK(db->SetSchemaAttr(DataItem(schema), "x", DataItem(schema::kInt32)));
+
+  ASSERT_OK_AND_ASSIGN(std::string data, EncodeColumnarDataBag(*db));
+  auto holder = std::make_shared<std::string>(std::move(data));
+  ASSERT_OK_AND_ASSIGN(DataBagImplPtr loaded,
+                       DecodeColumnarDataBag(holder, *holder));
+
+  EXPECT_THAT(loaded->ExplodeList(lists[0]),
+              IsOkAndHolds(ElementsAre(DataItem(1), DataItem(2))));
+  EXPECT_THAT(loaded->ExplodeList(lists[1]), IsOkAndHolds(ElementsAre()));
+  EXPECT_THAT(loaded->ExplodeList(lists[2]),
+              IsOkAndHolds(ElementsAre(DataItem(3), DataItem(4), DataItem(5))));
+  EXPECT_THAT(
+      loaded->GetFromDict(DataItem(dict), DataItem(arolla::Text("x"))),
+      IsOkAndHolds(DataItem(1.5f)));
+  EXPECT_THAT(loaded->GetFromDict(DataItem(dict), DataItem(7)),
+              IsOkAndHolds(DataItem(dict)));
+  EXPECT_THAT(loaded->GetSchemaAttr(DataItem(schema), "x"),
+              IsOkAndHolds(DataItem(schema::kInt32)));
+}
+
+TEST(ColumnarTest, File) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto objs = DataSliceImpl::AllocateEmptyObjects(100);
+  auto values = DataSliceImpl::Create(arolla::CreateConstDenseArray<int64_t>(
+      100, 42));
+  ASSERT_OK(db->SetAttr(objs, "a", values));
+
+  std::string path = absl::StrCat(::testing::TempDir(), "/columnar_db");
+  ASSERT_OK(WriteColumnarDataBagFile(*db, path));
+  ASSERT_OK_AND_ASSIGN(DataBagImplPtr loaded, LoadColumnarDataBagFile(path));
+  EXPECT_THAT(loaded->GetAttr(objs, "a"),
+              IsOkAndHolds(IsEquivalentTo(values)));
+}
+
+TEST(ColumnarTest, SharedMemory) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto objs = DataSliceImpl::AllocateEmptyObjects(100);
+  auto values = DataSliceImpl::Create(arolla::CreateConstDenseArray<int64_t>(
+      100, 42));
+  ASSERT_OK(db->SetAttr(objs, "a", values));
+  DataItem dict(internal::AllocateSingleDict());
+  ASSERT_OK(db->SetInDict(dict, DataItem(1), DataItem(2)));
+
+  std::string name = absl::StrCat("/kd_columnar_test_", getpid());
+  ASSERT_OK(WriteColumnarDataBagSharedMemory(*db, name));
+  EXPECT_THAT(WriteColumnarDataBagSharedMemory(*db, name),
+              StatusIs(absl::StatusCode::kAlreadyExists));
+  ASSERT_OK_AND_ASSIGN(DataBagImplPtr loaded1,
+                       LoadColumnarDataBagSharedMemory(name));
+  ASSERT_OK_AND_ASSIGN(DataBagImplPtr loaded2,
+                       LoadColumnarDataBagSharedMemory(name));
+  ASSERT_OK(UnlinkColumnarDataBagSharedMemory(name));
+  EXPECT_THAT(LoadColumnarDataBagSharedMemory(name),
+              StatusIs(absl::StatusCode::kNotFound));
+
+  // The loaded DataBags stay valid after unlinking.
+  for (const DataBagImplPtr& loaded : {loaded1, loaded2}) {
+    EXPECT_THAT(loaded->GetAttr(objs, "a"),
+                IsOkAndHolds(IsEquivalentTo(values)));
+    EXPECT_THAT(loaded->GetFromDict(dict, DataItem(1)),
+                IsOkAndHolds(DataItem(2)));
+  }
+}
+
+TEST(ColumnarTest, SpillStorage) {
+  auto db = DataBagImpl::CreateEmptyDatabag();
+  auto objs1 = DataSliceImpl::AllocateEmptyObjects(100);
+  auto objs2 = DataSliceImpl::AllocateEmptyObjects(100);
+  auto values1 = DataSliceImpl::Create(
+      arolla::CreateDenseArray<arolla::Text>(
+          std::vector<std::optional<arolla::Text>>(100, arolla::Text("abc"))));
+  auto values2 = DataSliceImpl::Create(arolla::CreateConstDenseArray<int64_t>(
+      100, 42));
+  ASSERT_OK(db->SetAttr(objs1, "a", values1));
+  ASSERT_OK(db->SetAttr(objs2, "a", values2));
+
+  auto pool = internal::SpillPool::Create(
+      {.memory_budget_bytes = 0},
+      CreateColumnarSpillStorage(::testing::TempDir()));
+  ASSERT_OK(db->MoveToSpillPool(*pool));
+  internal::SpillPool::Metrics metrics = pool->GetMetrics();
+  EXPECT_EQ(metrics.resident_bytes, 0);
+  EXPECT_GT(metrics.spilled_bytes, 0);
+  EXPECT_EQ(metrics.evictions, 2);
+
+  EXPECT_THAT(db->GetAttr(objs1, "a"), IsOkAndHolds(IsEquivalentTo(values1)));
+  EXPECT_THAT(db->GetAttr(objs2, "a"), IsOkAndHolds(IsEquivalentTo(values2)));
+  EXPECT_GE(pool->GetMetrics().reloads, 2);
+  EXPECT_EQ(pool->GetMetrics().read_failures, 0);
+
+  // Modifications copy the values back into memory.
+  ASSERT_OK(db->SetAttr(objs1[0], "a", DataItem(1)));
+  EXPECT_THAT(db->GetAttr(objs1[0], "a"), IsOkAndHolds(DataItem(1)));
+  EXPECT_THAT(db->GetAttr(objs1[1], "a"),
+              IsOkAndHolds(DataItem(arolla::Text("abc"))));
+}
+
+TEST(ColumnarTest, Errors) {
+  {
+    auto db = DataBagImpl::CreateEmptyDatabag();
+    ASSERT_OK(db->SetAttr(DataItem(internal::AllocateSingleObject()), "a",
+                          DataItem(arolla::expr::ExprQuote())));
+    EXPECT_THAT(EncodeColumnarDataBag(*db),
+                StatusIs(absl::StatusCode::kUnimplemented,
+                         HasSubstr("ExprQuote is not supported")));
+  }
+  {
+    auto holder = std::make_shared<std::string>(32, 'x');
+    EXPECT_THAT(DecodeColumnarDataBag(holder, *holder),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("not a columnar DataBag")));
+  }
+  {
+    auto db = DataBagImpl::CreateEmptyDatabag();
+    ASSERT_OK(db->SetAttr(DataSliceImpl::AllocateEmptyObjects(10), "a",
+                          DataSliceImpl::Create(
+                              arolla::CreateConstDenseArray<int32_t>(10, 1))));
+    ASSERT_OK_AND_ASSIGN(std::string data, EncodeColumnarDataBag(*db));
+    data.resize(data.size() - 1);
+    auto holder = std::make_shared<std::string>(std::move(data));
+    EXPECT_THAT(DecodeColumnarDataBag(holder, *holder),
+                StatusIs(absl::StatusCode::kInvalidArgument,
+                         HasSubstr("truncated")));
+  }
+}
+
+}  // namespace
+}  // namespace koladata::s11n
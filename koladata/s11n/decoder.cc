@@ -12,20 +12,26 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 //
-#include "arolla/serialization_base/decoder.h"
+#include "koladata/s11n/decoder.h"
 
+#include <algorithm>
 #include <cstddef>
+#include <cstdint>
 #include <functional>
 #include <memory>
+#include <optional>
+#include <string>
 #include <type_traits>
 #include <utility>
 #include <vector>
 
+#include "absl/base/nullability.h"
 #include "absl/base/optimization.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
@@ -36,15 +42,21 @@
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
 #include "koladata/internal/ellipsis.h"
+#include "koladata/internal/executor.h"
 #include "koladata/internal/object_id.h"
 #include "koladata/s11n/codec.pb.h"
 #include "koladata/s11n/codec_names.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
 #include "arolla/expr/expr_node.h"
 #include "arolla/expr/expr_operator.h"
 #include "arolla/expr/quote.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/memory/strings_buffer.h"
 #include "arolla/qtype/qtype_traits.h"
 #include "arolla/qtype/typed_value.h"
 #include "arolla/serialization_base/base.pb.h"
+#include "arolla/serialization_base/decoder.h"
 #include "arolla/serialization_codecs/registry.h"
 #include "arolla/util/bytes.h"
 #include "arolla/util/init_arolla.h"
@@ -61,6 +73,13 @@ using ::arolla::serialization_base::ValueDecoderResult;
 using ::arolla::serialization_base::ValueProto;
 using ::arolla::serialization_codecs::RegisterValueDecoder;
 
+// Set by ScopedDecodingExecutor. If not set, internal::CurrentExecutor() is
+// used.
+thread_local std::optional<internal::Executor*> decoding_executor;
+
+// Set by ScopedDecodingProjection.
+thread_local const internal::DataBagProjection* decoding_projection = nullptr;
+
 absl::StatusOr<ValueDecoderResult> DecodeLiteralOperator(
     absl::Span<const TypedValue> input_values) {
   if (input_values.size() != 1) {
@@ -132,6 +151,109 @@ absl::StatusOr<ValueDecoderResult> DecodeDataItemValue(
   return TypedValue::FromValue(std::move(res));
 }
 
+template <class T, class Field>
+absl::StatusOr<arolla::Buffer<T>> DecodePackedValues(const Field& field,
+                                                     int64_t size) {
+  if (field.size() != size) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected %d packed values, got %d", size, field.size()));
+  }
+  return arolla::Buffer<T>::Create(field.begin(), field.end());
+}
+
+absl::StatusOr<arolla::StringsBuffer> DecodePackedStrings(
+    const KodaV1Proto::PackedVectorProto& proto, int64_t size) {
+  if (proto.string_ends_size() != size) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected %d string offsets, got %d", size, proto.string_ends_size()));
+  }
+  const std::string& characters = proto.characters();
+  arolla::Buffer<arolla::StringsBuffer::Offsets>::Builder offsets_bldr(size);
+  auto offsets = offsets_bldr.GetMutableSpan();
+  int64_t start = 0;
+  for (int64_t i = 0; i < size; ++i) {
+    int64_t end = proto.string_ends(i);
+    if (end < start || end > static_cast<int64_t>(characters.size())) {
+      return absl::InvalidArgumentError("invalid packed string offsets");
+    }
+    offsets[i] = {start, end};
+    start = end;
+  }
+  arolla::Buffer<char>::Builder chars_bldr(characters.size());
+  std::copy(characters.begin(), characters.end(),
+            chars_bldr.GetMutableSpan().begin());
+  return arolla::StringsBuffer(std::move(offsets_bldr).Build(),
+                               std::move(chars_bldr).Build());
+}
+
+template <class T>
+absl::StatusOr<internal::DataSliceImpl> DecodePackedArray(
+    const KodaV1Proto::PackedVectorProto& proto, int64_t size,
+    arolla::bitmap::Bitmap bitmap) {
+  arolla::DenseArray<T> array;
+  array.bitmap = std::move(bitmap);
+  if constexpr (std::is_same_v<T, int32_t>) {
+    ASSIGN_OR_RETURN(array.values, DecodePackedValues<T>(proto.i32(), size));
+  } else if constexpr (std::is_same_v<T, int64_t>) {
+    ASSIGN_OR_RETURN(array.values, DecodePackedValues<T>(proto.i64(), size));
+  } else if constexpr (std::is_same_v<T, float>) {
+    ASSIGN_OR_RETURN(array.values, DecodePackedValues<T>(proto.f32(), size));
+  } else if constexpr (std::is_same_v<T, double>) {
+    ASSIGN_OR_RETURN(array.values, DecodePackedValues<T>(proto.f64(), size));
+  } else if constexpr (std::is_same_v<T, bool>) {
+    ASSIGN_OR_RETURN(array.values,
+                     DecodePackedValues<T>(proto.boolean(), size));
+  } else if constexpr (std::is_same_v<T, arolla::Unit>) {
+    array.values = arolla::VoidBuffer(size);
+  } else {
+    static_assert(std::is_same_v<T, arolla::Text> ||
+                  std::is_same_v<T, arolla::Bytes>);
+    ASSIGN_OR_RETURN(array.values, DecodePackedStrings(proto, size));
+  }
+  return internal::DataSliceImpl::Create(std::move(array));
+}
+
+absl::StatusOr<internal::DataSliceImpl> DecodePackedVectorProto(
+    const KodaV1Proto::PackedVectorProto& proto) {
+  using PackedVectorProto = KodaV1Proto::PackedVectorProto;
+  const int64_t size = proto.size();
+  if (size < 0) {
+    return absl::InvalidArgumentError("negative packed vector size");
+  }
+  arolla::bitmap::Bitmap bitmap;
+  if (proto.presence_size() > 0) {
+    if (proto.presence_size() != arolla::bitmap::BitmapSize(size)) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "expected %d presence words, got %d",
+          arolla::bitmap::BitmapSize(size), proto.presence_size()));
+    }
+    bitmap = arolla::bitmap::Bitmap::Create(proto.presence().begin(),
+                                            proto.presence().end());
+  }
+  switch (proto.type()) {
+    case PackedVectorProto::INT32:
+      return DecodePackedArray<int32_t>(proto, size, std::move(bitmap));
+    case PackedVectorProto::INT64:
+      return DecodePackedArray<int64_t>(proto, size, std::move(bitmap));
+    case PackedVectorProto::FLOAT32:
+      return DecodePackedArray<float>(proto, size, std::move(bitmap));
+    case PackedVectorProto::FLOAT64:
+      return DecodePackedArray<double>(proto, size, std::move(bitmap));
+    case PackedVectorProto::BOOLEAN:
+      return DecodePackedArray<bool>(proto, size, std::move(bitmap));
+    case PackedVectorProto::MASK:
+      return DecodePackedArray<arolla::Unit>(proto, size, std::move(bitmap));
+    case PackedVectorProto::TEXT:
+      return DecodePackedArray<arolla::Text>(proto, size, std::move(bitmap));
+    case PackedVectorProto::BYTES:
+      return DecodePackedArray<arolla::Bytes>(proto, size, std::move(bitmap));
+    case PackedVectorProto::UNKNOWN:
+      break;
+  }
+  return absl::InvalidArgumentError(
+      absl::StrCat("unsupported packed vector type: ", proto.type()));
+}
+
 absl::StatusOr<ValueDecoderResult> DecodeDataSliceImplValue(
     const KodaV1Proto::DataSliceImplProto& slice_proto,
     absl::Span<const TypedValue> input_values) {
@@ -151,6 +273,15 @@ absl::StatusOr<ValueDecoderResult> DecodeDataSliceImplValue(
       }
       return TypedValue::FromValue(std::move(bldr).Build());
     }
+    case KodaV1Proto::DataSliceImplProto::kPackedVector: {
+      if (!input_values.empty()) {
+        return absl::InvalidArgumentError(
+            "got more input_values than expected");
+      }
+      ASSIGN_OR_RETURN(internal::DataSliceImpl slice,
+                       DecodePackedVectorProto(slice_proto.packed_vector()));
+      return TypedValue::FromValue(std::move(slice));
+    }
     case KodaV1Proto::DataSliceImplProto::VALUE_NOT_SET:
       return absl::InvalidArgumentError("value not set");
   }
@@ -201,41 +332,37 @@ absl::StatusOr<std::reference_wrapper<const T>> GetInputValue(
   return input_values[index].As<T>();
 }
 
-absl::Status DecodeAttrProto(const KodaV1Proto::AttrProto& attr_proto,
-                             absl::Span<const TypedValue> input_values,
-                             internal::DataBagImpl& db) {
-  for (const KodaV1Proto::AttrChunkProto& chunk_proto : attr_proto.chunks()) {
-    internal::ObjectId obj = DecodeObjectId(chunk_proto.first_object_id());
-    if (chunk_proto.values_subindex() < 0 ||
-        chunk_proto.values_subindex() >= input_values.size()) {
-      return absl::InvalidArgumentError(absl::StrCat(
-          "invalid input value index: ", chunk_proto.values_subindex()));
-    }
-    const TypedValue& tval = input_values[chunk_proto.values_subindex()];
-    if (tval.GetType() == arolla::GetQType<internal::DataItem>()) {
-      RETURN_IF_ERROR(db.SetAttr(internal::DataItem(obj), attr_proto.name(),
-                                 tval.UnsafeAs<internal::DataItem>()));
-    } else {
-      ASSIGN_OR_RETURN(const internal::DataSliceImpl& values,
-                       tval.As<internal::DataSliceImpl>());
-      if (obj.Offset() != 0) {
-        return absl::InvalidArgumentError(
-            "AttrChunkProto.first_object_id must have offset==0 if the chunk "
-            "contains multiple values");
-      }
-      internal::AllocationId alloc(obj);
-      if (alloc.Capacity() <= values.size()) {
-        return absl::InvalidArgumentError(absl::StrFormat(
-            "AttrChunkProto values don't fit into AllocationId of "
-            "`first_object_id`: values size is %d, alloc capacity is %d",
-            values.size(), alloc.Capacity()));
-      }
-      auto objects =
-          internal::DataSliceImpl::ObjectsFromAllocation(alloc, values.size());
-      RETURN_IF_ERROR(db.SetAttr(objects, attr_proto.name(), values));
-    }
+absl::Status DecodeAttrChunkProto(
+    absl::string_view attr_name, const KodaV1Proto::AttrChunkProto& chunk_proto,
+    absl::Span<const TypedValue> input_values, internal::DataBagImpl& db) {
+  internal::ObjectId obj = DecodeObjectId(chunk_proto.first_object_id());
+  if (chunk_proto.values_subindex() < 0 ||
+      chunk_proto.values_subindex() >= input_values.size()) {
+    return absl::InvalidArgumentError(absl::StrCat(
+        "invalid input value index: ", chunk_proto.values_subindex()));
   }
-  return absl::OkStatus();
+  const TypedValue& tval = input_values[chunk_proto.values_subindex()];
+  if (tval.GetType() == arolla::GetQType<internal::DataItem>()) {
+    return db.SetAttr(internal::DataItem(obj), attr_name,
+                      tval.UnsafeAs<internal::DataItem>());
+  }
+  ASSIGN_OR_RETURN(const internal::DataSliceImpl& values,
+                   tval.As<internal::DataSliceImpl>());
+  if (obj.Offset() != 0) {
+    return absl::InvalidArgumentError(
+        "AttrChunkProto.first_object_id must have offset==0 if the chunk "
+        "contains multiple values");
+  }
+  internal::AllocationId alloc(obj);
+  if (alloc.Capacity() <= values.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "AttrChunkProto values don't fit into AllocationId of "
+        "`first_object_id`: values size is %d, alloc capacity is %d",
+        values.size(), alloc.Capacity()));
+  }
+  auto objects =
+      internal::DataSliceImpl::ObjectsFromAllocation(alloc, values.size());
+  return db.SetAttr(objects, attr_name, values);
 }
 
 absl::Status DecodeListProto(const KodaV1Proto::ListProto& list_proto,
@@ -275,6 +402,84 @@ absl::Status DecodeDictProto(const KodaV1Proto::DictProto& dict_proto,
   }
 }
 
+bool KeepsAttr(const internal::DataBagProjection* projection,
+               absl::string_view attr_name) {
+  return projection == nullptr || projection->KeepsAttr(attr_name);
+}
+
+bool KeepsLists(const internal::DataBagProjection* projection) {
+  return projection == nullptr || projection->lists;
+}
+
+// The attribute chunks, lists and dicts of a DataBagProto (in this order)
+// are decoded independently, so they are numbered consecutively as "pieces"
+// for splitting the decoding into parts. The attributes and lists dropped by
+// `projection` are not numbered.
+int64_t DataBagProtoPieceCount(
+    const KodaV1Proto::DataBagProto& db_proto,
+    const internal::DataBagProjection* projection) {
+  int64_t count = db_proto.dicts_size();
+  if (KeepsLists(projection)) {
+    count += db_proto.lists_size();
+  }
+  for (const KodaV1Proto::AttrProto& attr_proto : db_proto.attrs()) {
+    if (KeepsAttr(projection, attr_proto.name())) {
+      count += attr_proto.chunks_size();
+    }
+  }
+  return count;
+}
+
+// Decodes the pieces with numbers in [begin, end) into `db`.
+absl::Status DecodeDataBagProtoPieces(
+    const KodaV1Proto::DataBagProto& db_proto,
+    absl::Span<const TypedValue> input_values,
+    const internal::DataBagProjection* projection, int64_t begin, int64_t end,
+    internal::DataBagImpl& db) {
+  int64_t piece = 0;
+  for (const KodaV1Proto::AttrProto& attr_proto : db_proto.attrs()) {
+    if (!KeepsAttr(projection, attr_proto.name())) {
+      continue;
+    }
+    if (piece + attr_proto.chunks_size() <= begin) {
+      piece += attr_proto.chunks_size();
+      continue;
+    }
+    for (const KodaV1Proto::AttrChunkProto& chunk_proto :
+         attr_proto.chunks()) {
+      if (piece >= end) {
+        return absl::OkStatus();
+      }
+      if (piece++ >= begin) {
+        RETURN_IF_ERROR(DecodeAttrChunkProto(attr_proto.name(), chunk_proto,
+                                             input_values, db));
+      }
+    }
+  }
+  if (KeepsLists(projection)) {
+    for (const KodaV1Proto::ListProto& list_proto : db_proto.lists()) {
+      if (piece >= end) {
+        return absl::OkStatus();
+      }
+      if (piece++ >= begin) {
+        RETURN_IF_ERROR(DecodeListProto(list_proto, input_values, db));
+      }
+    }
+  }
+  for (const KodaV1Proto::DictProto& dict_proto : db_proto.dicts()) {
+    if (piece >= end) {
+      return absl::OkStatus();
+    }
+    if (piece++ >= begin &&
+        (projection == nullptr ||
+         projection->KeepsDict(internal::AllocationId(
+             DecodeObjectId(dict_proto.dict_id()))))) {
+      RETURN_IF_ERROR(DecodeDictProto(dict_proto, input_values, db));
+    }
+  }
+  return absl::OkStatus();
+}
+
 absl::StatusOr<ValueDecoderResult> DecodeDataBagValue(
     const KodaV1Proto::DataBagProto& db_proto,
     absl::Span<const TypedValue> input_values) {
@@ -295,14 +500,45 @@ absl::StatusOr<ValueDecoderResult> DecodeDataBagValue(
   }
   DataBagPtr db = DataBag::Empty();
   ASSIGN_OR_RETURN(internal::DataBagImpl & impl, db->GetMutableImpl());
-  for (const KodaV1Proto::AttrProto& attr_proto : db_proto.attrs()) {
-    RETURN_IF_ERROR(DecodeAttrProto(attr_proto, input_values, impl));
+  const internal::DataBagProjection* projection = decoding_projection;
+  int64_t piece_count = DataBagProtoPieceCount(db_proto, projection);
+  std::shared_ptr<internal::Executor> current_executor;
+  internal::Executor* executor;
+  if (decoding_executor.has_value()) {
+    executor = *decoding_executor;
+  } else {
+    current_executor = internal::CurrentExecutor();
+    executor = current_executor.get();
   }
-  for (const KodaV1Proto::ListProto& list_proto : db_proto.lists()) {
-    RETURN_IF_ERROR(DecodeListProto(list_proto, input_values, impl));
+  int64_t part_count = internal::ParallelChunkCount(
+      executor, piece_count, /*min_chunk_size=*/1);
+  if (part_count <= 1) {
+    RETURN_IF_ERROR(DecodeDataBagProtoPieces(db_proto, input_values,
+                                             projection, 0, piece_count,
+                                             impl));
+    return TypedValue::FromValue(std::move(db));
   }
-  for (const KodaV1Proto::DictProto& dict_proto : db_proto.dicts()) {
-    RETURN_IF_ERROR(DecodeDictProto(dict_proto, input_values, impl));
+  // The first part is decoded directly into the result.
+  std::vector<internal::DataBagImplPtr> parts(part_count);
+  RETURN_IF_ERROR(internal::ParallelFor(
+      executor, part_count, [&](int64_t i) -> absl::Status {
+        internal::DataBagImpl* part = &impl;
+        if (i > 0) {
+          parts[i] = internal::DataBagImpl::CreateEmptyDatabag();
+          part = parts[i].get();
+        }
+        return DecodeDataBagProtoPieces(db_proto, input_values, projection,
+                                        piece_count * i / part_count,
+                                        piece_count * (i + 1) / part_count,
+                                        *part);
+      }));
+  // Overwriting in order keeps the last value of duplicated triples, as in
+  // the serial decoding.
+  internal::MergeOptions merge_options{
+      .data_conflict_policy = internal::MergeOptions::kOverwrite,
+      .schema_conflict_policy = internal::MergeOptions::kOverwrite};
+  for (int64_t i = 1; i < part_count; ++i) {
+    RETURN_IF_ERROR(impl.MergeInplace(*parts[i], merge_options));
   }
   return TypedValue::FromValue(std::move(db));
 }
@@ -348,4 +584,25 @@ AROLLA_INITIALIZER(
         })
 
 }  // namespace
+
+ScopedDecodingExecutor::ScopedDecodingExecutor(
+    absl::Nullable<internal::Executor*> executor)
+    : previous_(decoding_executor) {
+  decoding_executor = executor;
+}
+
+ScopedDecodingExecutor::~ScopedDecodingExecutor() {
+  decoding_executor = previous_;
+}
+
+ScopedDecodingProjection::ScopedDecodingProjection(
+    absl::Nullable<const internal::DataBagProjection*> projection)
+    : previous_(decoding_projection) {
+  decoding_projection = projection;
+}
+
+ScopedDecodingProjection::~ScopedDecodingProjection() {
+  decoding_projection = previous_;
+}
+
 }  // namespace koladata::s11n
@@ -0,0 +1,79 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_S11N_DECODER_H_
+#define KOLADATA_S11N_DECODER_H_
+
+#include <optional>
+
+#include "absl/base/nullability.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/executor.h"
+
+// Koda values are decoded by the codec registered with
+// arolla::serialization, so the functions of this header only tune the
+// decoding done by arolla::serialization::Decode.
+
+namespace koladata::s11n {
+
+// While alive, DataBags decoded on the current thread are decoded in parallel
+// on `executor` (nullptr forces the serial decoding) instead of
+// internal::CurrentExecutor(). The attribute chunks, lists and dicts of a
+// DataBag are independent, so they are split into ranges decoded into separate
+// DataBagImpls which are merged at the end.
+//
+// Example:
+//   internal::ThreadPoolExecutor executor(16);
+//   ScopedDecodingExecutor scoped_executor(&executor);
+//   ASSIGN_OR_RETURN(auto result, arolla::serialization::Decode(proto));
+class ScopedDecodingExecutor {
+ public:
+  explicit ScopedDecodingExecutor(
+      absl::Nullable<internal::Executor*> executor);
+  ~ScopedDecodingExecutor();
+
+  ScopedDecodingExecutor(const ScopedDecodingExecutor&) = delete;
+  ScopedDecodingExecutor& operator=(const ScopedDecodingExecutor&) = delete;
+
+ private:
+  std::optional<internal::Executor*> previous_;
+};
+
+// While alive, DataBags decoded on the current thread only contain the part
+// kept by `projection`, e.g. 3 of the 200 attributes of a stored DataBag. The
+// other attribute chunks, lists and dicts are skipped when building the
+// DataBag. `projection` must outlive the scope; nullptr disables the
+// projection of an enclosing scope.
+//
+// Example:
+//   internal::DataBagProjection projection{.attrs = {"a", "b"}};
+//   ScopedDecodingProjection scoped_projection(&projection);
+//   ASSIGN_OR_RETURN(auto result, arolla::serialization::Decode(proto));
+class ScopedDecodingProjection {
+ public:
+  explicit ScopedDecodingProjection(
+      absl::Nullable<const internal::DataBagProjection*> projection);
+  ~ScopedDecodingProjection();
+
+  ScopedDecodingProjection(const ScopedDecodingProjection&) = delete;
+  ScopedDecodingProjection& operator=(const ScopedDecodingProjection&) =
+      delete;
+
+ private:
+  const internal::DataBagProjection* previous_;
+};
+
+}  // namespace koladata::s11n
+
+#endif  // KOLADATA_S11N_DECODER_H_
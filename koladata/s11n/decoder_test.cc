@@ -0,0 +1,132 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/s11n/decoder.h"
+
+#include <cstdint>
+
+#include "gtest/gtest.h"
+#include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_bag_comparison.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/internal/triples.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/qtype/typed_value.h"
+#include "arolla/serialization/decode.h"
+#include "arolla/serialization/encode.h"
+#include "arolla/util/text.h"
+
+namespace koladata::s11n {
+namespace {
+
+using ::koladata::internal::DataBagImpl;
+using ::koladata::internal::DataBagProjection;
+using ::koladata::internal::DataItem;
+using ::koladata::internal::DataSliceImpl;
+using ::koladata::internal::debug::Triples;
+
+DataBagPtr CreateTestDataBag() {
+  DataBagPtr db = DataBag::Empty();
+  DataBagImpl& impl = db->GetMutableImpl().value().get();
+  for (int64_t i = 0; i < 10; ++i) {
+    auto objs = DataSliceImpl::AllocateEmptyObjects(10 + i);
+    CHECK_OK(impl.SetAttr(objs, absl::StrCat("a", i % 3),
+                          DataSliceImpl::Create(
+                              arolla::CreateConstDenseArray<int32_t>(
+                                  10 + i, i))));
+    CHECK_OK(impl.SetAttr(DataItem(internal::AllocateSingleObject()), "s",
+                          DataItem(arolla::Text(absl::StrCat("small", i)))));
+    DataItem list(internal::AllocateSingleList());
+    CHECK_OK(impl.AppendToList(list, DataItem(i)));
+    DataItem dict(internal::AllocateSingleDict());
+    CHECK_OK(impl.SetInDict(dict, DataItem(i), DataItem(i * 2)));
+  }
+  CHECK_OK(impl.SetSchemaAttr(DataItem(internal::AllocateExplicitSchema()),
+                              "x", DataItem(schema::kInt32)));
+  return db;
+}
+
+DataBagPtr EncodeAndDecode(const DataBagPtr& db) {
+  auto proto =
+      arolla::serialization::Encode({arolla::TypedValue::FromValue(db)}, {})
+          .value();
+  auto decode_result = arolla::serialization::Decode(proto).value();
+  CHECK_EQ(decode_result.values.size(), 1);
+  return decode_result.values[0].As<DataBagPtr>().value();
+}
+
+TEST(DecoderTest, ParallelDataBagDecoding) {
+  DataBagPtr db = CreateTestDataBag();
+  internal::ThreadPoolExecutor executor(4);
+  {
+    ScopedDecodingExecutor scoped_executor(&executor);
+    EXPECT_TRUE(DataBagComparison::ExactlyEqual(EncodeAndDecode(db), db));
+    {
+      ScopedDecodingExecutor serial(nullptr);
+      EXPECT_TRUE(DataBagComparison::ExactlyEqual(EncodeAndDecode(db), db));
+    }
+    EXPECT_TRUE(DataBagComparison::ExactlyEqual(EncodeAndDecode(db), db));
+  }
+  EXPECT_TRUE(DataBagComparison::ExactlyEqual(EncodeAndDecode(db), db));
+}
+
+TEST(DecoderTest, ParallelEmptyDataBagDecoding) {
+  DataBagPtr db = DataBag::Empty();
+  internal::ThreadPoolExecutor executor(4);
+  ScopedDecodingExecutor scoped_executor(&executor);
+  EXPECT_TRUE(DataBagComparison::ExactlyEqual(EncodeAndDecode(db), db));
+}
+
+TEST(DecoderTest, DataBagProjection) {
+  DataBagPtr db = CreateTestDataBag();
+  DataBagProjection projection{.attrs = {"a1", "s"}, .dicts = true};
+  Triples expected(*db->GetImpl().ExtractContent(projection));
+  internal::ThreadPoolExecutor executor(4);
+  for (internal::Executor* decoding_executor :
+       {static_cast<internal::Executor*>(&executor),
+        static_cast<internal::Executor*>(nullptr)}) {
+    ScopedDecodingExecutor scoped_executor(decoding_executor);
+    ScopedDecodingProjection scoped_projection(&projection);
+    DataBagPtr decoded = EncodeAndDecode(db);
+    internal::DataBagIndex index = decoded->GetImpl().CreateIndex();
+    EXPECT_EQ(index.attrs.size(), 2);
+    EXPECT_TRUE(index.lists.empty());
+    EXPECT_EQ(index.dicts.size(), 11);
+    EXPECT_EQ(Triples(*decoded->GetImpl().ExtractContent()), expected);
+  }
+  {
+    DataBagProjection schemas_only;
+    ScopedDecodingProjection scoped_projection(&schemas_only);
+    {
+      // nullptr disables the projection.
+      ScopedDecodingProjection no_projection(nullptr);
+      EXPECT_TRUE(DataBagComparison::ExactlyEqual(EncodeAndDecode(db), db));
+    }
+    internal::DataBagIndex index = EncodeAndDecode(db)->GetImpl().CreateIndex();
+    EXPECT_TRUE(index.attrs.empty());
+    EXPECT_TRUE(index.lists.empty());
+    ASSERT_EQ(index.dicts.size(), 1);
+    EXPECT_TRUE(index.dicts[0].IsSchemasAlloc());
+  }
+}
+
+}  // namespace
+}  // namespace koladata::s11n
@@ -12,16 +12,18 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 //
-#include "arolla/serialization_base/encoder.h"
+#include "koladata/s11n/encoder.h"
 
 #include <cstdint>
 #include <string>
+#include <type_traits>
 #include <utility>
 
 #include "absl/log/check.h"
 #include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
 #include "absl/types/span.h"
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
@@ -36,6 +38,7 @@
 #include "koladata/internal/object_id.h"
 #include "koladata/s11n/codec.pb.h"
 #include "koladata/s11n/codec_names.h"
+#include "arolla/dense_array/bitmap.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/dense_array/edge.h"
 #include "arolla/expr/expr_operator.h"
@@ -46,6 +49,7 @@
 #include "arolla/qtype/typed_ref.h"
 #include "arolla/qtype/typed_value.h"
 #include "arolla/serialization_base/base.pb.h"
+#include "arolla/serialization_base/encoder.h"
 #include "arolla/serialization_codecs/registry.h"
 #include "arolla/util/bytes.h"
 #include "arolla/util/fast_dynamic_downcast_final.h"
@@ -63,6 +67,9 @@ using ::arolla::serialization_codecs::RegisterValueEncoderByQType;
 using ::arolla::serialization_codecs::
     RegisterValueEncoderByQValueSpecialisationKey;
 
+// Set by ScopedPackedSliceEncoding.
+thread_local bool pack_slices = false;
+
 absl::StatusOr<ValueProto> GenValueProto(Encoder& encoder) {
   ASSIGN_OR_RETURN(auto codec_index, encoder.EncodeCodec(kKodaV1Codec));
   ValueProto value_proto;
@@ -328,6 +335,91 @@ absl::StatusOr<ValueProto> EncodeDataItem(arolla::TypedRef value,
   return value_proto;
 }
 
+template <class T>
+constexpr KodaV1Proto::PackedVectorProto::Type kPackedType =
+    KodaV1Proto::PackedVectorProto::UNKNOWN;
+template <>
+constexpr KodaV1Proto::PackedVectorProto::Type kPackedType<int32_t> =
+    KodaV1Proto::PackedVectorProto::INT32;
+template <>
+constexpr KodaV1Proto::PackedVectorProto::Type kPackedType<int64_t> =
+    KodaV1Proto::PackedVectorProto::INT64;
+template <>
+constexpr KodaV1Proto::PackedVectorProto::Type kPackedType<float> =
+    KodaV1Proto::PackedVectorProto::FLOAT32;
+template <>
+constexpr KodaV1Proto::PackedVectorProto::Type kPackedType<double> =
+    KodaV1Proto::PackedVectorProto::FLOAT64;
+template <>
+constexpr KodaV1Proto::PackedVectorProto::Type kPackedType<bool> =
+    KodaV1Proto::PackedVectorProto::BOOLEAN;
+template <>
+constexpr KodaV1Proto::PackedVectorProto::Type kPackedType<arolla::Unit> =
+    KodaV1Proto::PackedVectorProto::MASK;
+template <>
+constexpr KodaV1Proto::PackedVectorProto::Type kPackedType<arolla::Text> =
+    KodaV1Proto::PackedVectorProto::TEXT;
+template <>
+constexpr KodaV1Proto::PackedVectorProto::Type kPackedType<arolla::Bytes> =
+    KodaV1Proto::PackedVectorProto::BYTES;
+
+template <class T, class Field>
+void AddPackedValues(const arolla::DenseArray<T>& array, Field& field) {
+  absl::Span<const T> values = array.values.span();
+  field.Add(values.begin(), values.end());
+}
+
+// Fills `proto` if `slice` has a single type supported by PackedVectorProto.
+// Returns false otherwise.
+bool FillPackedVectorProto(const internal::DataSliceImpl& slice,
+                           KodaV1Proto::PackedVectorProto& proto) {
+  if (!slice.is_single_dtype()) {
+    return false;
+  }
+  bool packed = false;
+  slice.VisitValues([&](const auto& array) {
+    using T = typename std::decay_t<decltype(array)>::base_type;
+    if constexpr (kPackedType<T> != KodaV1Proto::PackedVectorProto::UNKNOWN) {
+      packed = true;
+      proto.set_type(kPackedType<T>);
+      proto.set_size(array.size());
+      if (!array.IsFull()) {
+        const int64_t bitmap_size = arolla::bitmap::BitmapSize(array.size());
+        auto& presence = *proto.mutable_presence();
+        presence.Reserve(bitmap_size);
+        for (int64_t i = 0; i < bitmap_size; ++i) {
+          presence.Add(arolla::bitmap::GetWordWithOffset(
+              array.bitmap, i, array.bitmap_bit_offset));
+        }
+      }
+      if constexpr (std::is_same_v<T, int32_t>) {
+        AddPackedValues(array, *proto.mutable_i32());
+      } else if constexpr (std::is_same_v<T, int64_t>) {
+        AddPackedValues(array, *proto.mutable_i64());
+      } else if constexpr (std::is_same_v<T, float>) {
+        AddPackedValues(array, *proto.mutable_f32());
+      } else if constexpr (std::is_same_v<T, double>) {
+        AddPackedValues(array, *proto.mutable_f64());
+      } else if constexpr (std::is_same_v<T, bool>) {
+        AddPackedValues(array, *proto.mutable_boolean());
+      } else if constexpr (std::is_same_v<T, arolla::Text> ||
+                           std::is_same_v<T, arolla::Bytes>) {
+        std::string& characters = *proto.mutable_characters();
+        auto& ends = *proto.mutable_string_ends();
+        ends.Reserve(array.size());
+        for (int64_t i = 0; i < array.size(); ++i) {
+          if (array.present(i)) {
+            absl::string_view value = array.values[i];
+            characters.append(value.data(), value.size());
+          }
+          ends.Add(characters.size());
+        }
+      }
+    }
+  });
+  return packed;
+}
+
 absl::StatusOr<ValueProto> EncodeDataSliceImpl(arolla::TypedRef value,
                                                Encoder& encoder) {
   ASSIGN_OR_RETURN(auto value_proto, GenValueProto(encoder));
@@ -336,6 +428,11 @@ absl::StatusOr<ValueProto> EncodeDataSliceImpl(arolla::TypedRef value,
                    value.As<internal::DataSliceImpl>());
   KodaV1Proto::DataSliceImplProto* slice_proto =
       koda_proto->mutable_data_slice_impl_value();
+  if (pack_slices &&
+      FillPackedVectorProto(slice, *slice_proto->mutable_packed_vector())) {
+    return value_proto;
+  }
+  slice_proto->clear_packed_vector();
   KodaV1Proto::DataItemVectorProto* vector_proto =
       slice_proto->mutable_data_item_vector();
   for (int64_t i = 0; i < slice.size(); ++i) {
@@ -365,4 +462,14 @@ AROLLA_INITIALIZER(
         })
 
 }  // namespace
+
+ScopedPackedSliceEncoding::ScopedPackedSliceEncoding(bool enabled)
+    : previous_(pack_slices) {
+  pack_slices = enabled;
+}
+
+ScopedPackedSliceEncoding::~ScopedPackedSliceEncoding() {
+  pack_slices = previous_;
+}
+
 }  // namespace koladata::s11n
@@ -0,0 +1,48 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_S11N_ENCODER_H_
+#define KOLADATA_S11N_ENCODER_H_
+
+// Koda values are encoded by the codec registered with
+// arolla::serialization, so the functions of this header only tune the
+// encoding done by arolla::serialization::Encode.
+
+namespace koladata::s11n {
+
+// While alive, the DataSliceImpls holding a single primitive type (INT32,
+// INT64, FLOAT32, FLOAT64, BOOLEAN, MASK, TEXT or BYTES) encoded on the current
+// thread are written as `packed_vector` instead of `data_item_vector`. The
+// packed form is much smaller and faster to decode, but can't be read by
+// decoders that predate it, so it is not the default.
+//
+// Example:
+//   ScopedPackedSliceEncoding packed_slices;
+//   ASSIGN_OR_RETURN(auto proto, arolla::serialization::Encode(values, {}));
+class ScopedPackedSliceEncoding {
+ public:
+  explicit ScopedPackedSliceEncoding(bool enabled = true);
+  ~ScopedPackedSliceEncoding();
+
+  ScopedPackedSliceEncoding(const ScopedPackedSliceEncoding&) = delete;
+  ScopedPackedSliceEncoding& operator=(const ScopedPackedSliceEncoding&) =
+      delete;
+
+ private:
+  bool previous_;
+};
+
+}  // namespace koladata::s11n
+
+#endif  // KOLADATA_S11N_ENCODER_H_
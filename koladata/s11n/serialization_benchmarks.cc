@@ -0,0 +1,187 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include <cstdint>
+#include <vector>
+
+#include "benchmark/benchmark.h"
+#include "absl/log/check.h"
+#include "absl/strings/str_cat.h"
+#include "koladata/data_bag.h"
+#include "koladata/internal/benchmark_helpers.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/qtype/typed_value.h"
+#include "arolla/serialization/decode.h"
+#include "arolla/serialization/encode.h"
+#include "arolla/serialization_base/base.pb.h"
+#include "arolla/util/init_arolla.h"
+#include "arolla/util/text.h"
+
+namespace koladata {
+namespace {
+
+using internal::DataBagImpl;
+using internal::DataItem;
+using internal::DataSliceImpl;
+
+// Builders of DataBags with `size` values of different kinds.
+
+struct DenseNumericAttrs {
+  static void Fill(DataBagImpl& db, int64_t size) {
+    auto objs = DataSliceImpl::AllocateEmptyObjects(size);
+    std::vector<int32_t> ints(size);
+    std::vector<double> doubles(size);
+    for (int64_t i = 0; i < size; ++i) {
+      ints[i] = i;
+      doubles[i] = i * 0.5;
+    }
+    CHECK_OK(db.SetAttr(objs, "a", DataSliceImpl::Create(
+                                       arolla::CreateFullDenseArray(ints))));
+    CHECK_OK(db.SetAttr(objs, "b", DataSliceImpl::Create(
+                                       arolla::CreateFullDenseArray(doubles))));
+  }
+};
+
+struct StringAttrs {
+  static void Fill(DataBagImpl& db, int64_t size) {
+    auto objs = DataSliceImpl::AllocateEmptyObjects(size);
+    std::vector<arolla::Text> texts;
+    texts.reserve(size);
+    for (int64_t i = 0; i < size; ++i) {
+      texts.emplace_back(absl::StrCat("string_value_", i));
+    }
+    CHECK_OK(db.SetAttr(objs, "s", DataSliceImpl::Create(
+                                       arolla::CreateFullDenseArray(texts))));
+  }
+};
+
+struct LargeList {
+  static void Fill(DataBagImpl& db, int64_t size) {
+    DataItem list(internal::AllocateSingleList());
+    CHECK_OK(db.ExtendList(list, DataSliceImpl::Create(
+                                     arolla::CreateConstDenseArray<int32_t>(
+                                         size, 57))));
+  }
+};
+
+struct SmallDicts {
+  static constexpr int64_t kDictSize = 4;
+
+  static void Fill(DataBagImpl& db, int64_t size) {
+    int64_t dict_count = size / kDictSize;
+    auto dicts = DataSliceImpl::ObjectsFromAllocation(
+        internal::AllocateDicts(dict_count), dict_count);
+    for (int64_t key = 0; key < kDictSize; ++key) {
+      CHECK_OK(db.SetInDict(
+          dicts,
+          DataSliceImpl::Create(
+              arolla::CreateConstDenseArray<int64_t>(dict_count, key)),
+          DataSliceImpl::Create(
+              arolla::CreateConstDenseArray<float>(dict_count, 1.5f))));
+    }
+  }
+};
+
+// Objects with an int, a float and a text attribute, a reference to another
+// object and an attribute with values of mixed types.
+struct MixedObjects {
+  static void Fill(DataBagImpl& db, int64_t size) {
+    int64_t object_count = size / 5;
+    auto objs = DataSliceImpl::AllocateEmptyObjects(object_count);
+    auto refs = DataSliceImpl::AllocateEmptyObjects(object_count);
+    std::vector<DataItem> mixed(object_count);
+    for (int64_t i = 0; i < object_count; ++i) {
+      switch (i % 3) {
+        case 0:
+          mixed[i] = DataItem(static_cast<int32_t>(i));
+          break;
+        case 1:
+          mixed[i] = DataItem(arolla::Text(absl::StrCat("m", i)));
+          break;
+        default:
+          mixed[i] = DataItem(refs[i]);
+      }
+    }
+    auto constant = [&](auto value) {
+      return DataSliceImpl::Create(
+          arolla::CreateConstDenseArray<decltype(value)>(object_count, value));
+    };
+    CHECK_OK(db.SetAttr(objs, "i", constant(int64_t{1})));
+    CHECK_OK(db.SetAttr(objs, "f", constant(0.5f)));
+    CHECK_OK(db.SetAttr(objs, "t", constant(arolla::Text("text"))));
+    CHECK_OK(db.SetAttr(objs, "ref", refs));
+    CHECK_OK(db.SetAttr(objs, "mixed", DataSliceImpl::Create(mixed)));
+  }
+};
+
+template <typename Content>
+DataBagPtr CreateDataBag(int64_t size) {
+  auto db = DataBag::Empty();
+  Content::Fill(db->GetMutableImpl()->get(), size);
+  return db;
+}
+
+template <typename Content>
+void BM_EncodeDataBag(benchmark::State& state) {
+  arolla::InitArolla();
+  DataBagPtr db = CreateDataBag<Content>(state.range(0));
+  int64_t encoded_bytes = 0;
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(db);
+    auto proto =
+        arolla::serialization::Encode({arolla::TypedValue::FromValue(db)}, {})
+            .value();
+    encoded_bytes = proto.ByteSizeLong();
+    benchmark::DoNotOptimize(proto);
+  }
+  state.SetBytesProcessed(state.iterations() * encoded_bytes);
+  state.counters["peak_rss_mb"] = internal::PeakRssMegabytes();
+}
+
+template <typename Content>
+void BM_DecodeDataBag(benchmark::State& state) {
+  arolla::InitArolla();
+  auto proto = arolla::serialization::Encode(
+                   {arolla::TypedValue::FromValue(
+                       CreateDataBag<Content>(state.range(0)))},
+                   {})
+                   .value();
+  int64_t encoded_bytes = proto.ByteSizeLong();
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(proto);
+    auto decode_result = arolla::serialization::Decode(proto).value();
+    benchmark::DoNotOptimize(decode_result);
+  }
+  state.SetBytesProcessed(state.iterations() * encoded_bytes);
+  state.counters["peak_rss_mb"] = internal::PeakRssMegabytes();
+}
+
+BENCHMARK(BM_EncodeDataBag<DenseNumericAttrs>)->Range(1000, 1000000);
+BENCHMARK(BM_EncodeDataBag<StringAttrs>)->Range(1000, 1000000);
+BENCHMARK(BM_EncodeDataBag<LargeList>)->Range(1000, 1000000);
+BENCHMARK(BM_EncodeDataBag<SmallDicts>)->Range(1000, 1000000);
+BENCHMARK(BM_EncodeDataBag<MixedObjects>)->Range(1000, 1000000);
+
+BENCHMARK(BM_DecodeDataBag<DenseNumericAttrs>)->Range(1000, 1000000);
+BENCHMARK(BM_DecodeDataBag<StringAttrs>)->Range(1000, 1000000);
+BENCHMARK(BM_DecodeDataBag<LargeList>)->Range(1000, 1000000);
+BENCHMARK(BM_DecodeDataBag<SmallDicts>)->Range(1000, 1000000);
+BENCHMARK(BM_DecodeDataBag<MixedObjects>)->Range(1000, 1000000);
+
+}  // namespace
+}  // namespace koladata
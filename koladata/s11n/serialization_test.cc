@@ -12,19 +12,30 @@
 // See the License for the specific language governing permissions and
 // limitations under the License.
 //
+#include <cstdint>
+#include <optional>
+#include <string>
 #include <vector>
 
 #include "gmock/gmock.h"
 #include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
 #include "koladata/internal/object_id.h"
+#include "koladata/s11n/codec.pb.h"
+#include "koladata/s11n/codec_names.h"
+#include "koladata/s11n/encoder.h"
+#include "arolla/dense_array/dense_array.h"
 #include "arolla/expr/expr.h"
 #include "arolla/expr/quote.h"
+#include "arolla/memory/optional_value.h"
 #include "arolla/qtype/typed_value.h"
 #include "arolla/serialization/decode.h"
 #include "arolla/serialization/encode.h"
+#include "arolla/serialization_base/base.pb.h"
 #include "arolla/util/bytes.h"
 #include "arolla/util/text.h"
 #include "arolla/util/unit.h"
@@ -32,6 +43,8 @@
 namespace koladata {
 namespace {
 
+using ::absl_testing::StatusIs;
+using ::testing::HasSubstr;
 using arolla::TypedValue;
 using internal::DataItem;
 using internal::DataSliceImpl;
@@ -85,5 +98,83 @@ TEST(SerializationTest, DataSliceImpl) {
   EXPECT_THAT(res, ::testing::ElementsAreArray(slice));
 }
 
+TEST(SerializationTest, PackedDataSliceImpl) {
+  std::vector<DataSliceImpl> slices = {
+      DataSliceImpl::Create(arolla::CreateDenseArray<int>({1, std::nullopt})),
+      DataSliceImpl::Create(arolla::CreateDenseArray<int64_t>({-5, 7})),
+      DataSliceImpl::Create(
+          arolla::CreateDenseArray<float>({std::nullopt, 1.5f})),
+      DataSliceImpl::Create(arolla::CreateDenseArray<double>({2.5})),
+      DataSliceImpl::Create(arolla::CreateDenseArray<bool>({true, false})),
+      DataSliceImpl::Create(
+          arolla::CreateDenseArray<arolla::Unit>({arolla::kUnit, {}})),
+      DataSliceImpl::Create(arolla::CreateDenseArray<arolla::Text>(
+          {arolla::Text("abc"), std::nullopt, arolla::Text("")})),
+      DataSliceImpl::Create(
+          arolla::CreateDenseArray<arolla::Bytes>({arolla::Bytes("xy")})),
+      DataSliceImpl::Create(arolla::CreateDenseArray<int>(
+          std::vector<arolla::OptionalValue<int>>(100, std::nullopt))),
+  };
+  auto count_packed = [](const auto& proto) {
+    int packed_count = 0;
+    for (const auto& step : proto.decoding_steps()) {
+      if (step.has_value() &&
+          step.value().HasExtension(s11n::KodaV1Proto::extension)) {
+        const auto& koda_proto =
+            step.value().GetExtension(s11n::KodaV1Proto::extension);
+        packed_count +=
+            koda_proto.data_slice_impl_value().has_packed_vector();
+      }
+    }
+    return packed_count;
+  };
+  for (const DataSliceImpl& slice : slices) {
+    // Not packed by default.
+    ASSERT_OK_AND_ASSIGN(auto default_proto,
+                         arolla::serialization::Encode(
+                             {TypedValue::FromValue(slice)}, {}));
+    EXPECT_EQ(count_packed(default_proto), 0);
+
+    s11n::ScopedPackedSliceEncoding packed_slices;
+    ASSERT_OK_AND_ASSIGN(auto proto, arolla::serialization::Encode(
+                                         {TypedValue::FromValue(slice)}, {}));
+    EXPECT_EQ(count_packed(proto), 1);
+    ASSERT_OK_AND_ASSIGN(auto decode_result,
+                         arolla::serialization::Decode(proto));
+    ASSERT_EQ(decode_result.values.size(), 1);
+    ASSERT_OK_AND_ASSIGN(DataSliceImpl res,
+                         decode_result.values[0].As<DataSliceImpl>());
+    EXPECT_EQ(res.dtype(), slice.dtype());
+    EXPECT_THAT(res, ::testing::ElementsAreArray(slice));
+  }
+}
+
+TEST(SerializationTest, PackedDataSliceImplErrors) {
+  arolla::serialization_base::ContainerProto proto;
+  proto.set_version(2);
+  proto.add_decoding_steps()->mutable_codec()->set_name(
+      std::string(s11n::kKodaV1Codec));
+  auto* packed = proto.add_decoding_steps()
+                     ->mutable_value()
+                     ->MutableExtension(s11n::KodaV1Proto::extension)
+                     ->mutable_data_slice_impl_value()
+                     ->mutable_packed_vector();
+  proto.add_decoding_steps()->set_output_value_index(1);
+  packed->set_type(s11n::KodaV1Proto::PackedVectorProto::TEXT);
+  packed->set_size(2);
+  packed->set_characters("ab");
+  packed->add_string_ends(1);
+  packed->add_string_ends(3);
+  EXPECT_THAT(arolla::serialization::Decode(proto),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("invalid packed string offsets")));
+
+  packed->set_type(s11n::KodaV1Proto::PackedVectorProto::INT32);
+  packed->add_i32(1);
+  EXPECT_THAT(arolla::serialization::Decode(proto),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("expected 2 packed values, got 1")));
+}
+
 }  // namespace
 }  // namespace koladata
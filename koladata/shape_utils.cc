@@ -41,7 +41,7 @@ absl::StatusOr<DataSlice::JaggedShape> GetCommonShape(
   }
   DCHECK_NE(shape, nullptr);
   for (const auto& slice : slices) {
-    if (!slice.GetShape().IsBroadcastableTo(*shape)) {
+    if (!ShapeIsBroadcastableTo(slice.GetShape(), *shape)) {
       return absl::InvalidArgumentError("shapes are not compatible");
     }
   }
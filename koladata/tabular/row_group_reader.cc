@@ -0,0 +1,285 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/tabular/row_group_reader.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_cat.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/data_bag.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
+#include "koladata/internal/object_id.h"
+#include "koladata/object_factories.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/dense_array/edge.h"
+#include "arolla/util/status_macros_backport.h"
+
+namespace koladata::tabular {
+namespace {
+
+using ::koladata::internal::AllocationId;
+using ::koladata::internal::AllocationIdSet;
+using ::koladata::internal::DataBagImpl;
+using ::koladata::internal::DataBagImplPtr;
+using ::koladata::internal::DataSliceImpl;
+using ::koladata::internal::ObjectId;
+
+absl::string_view KindName(NestedColumn::Kind kind) {
+  switch (kind) {
+    case NestedColumn::kPrimitive:
+      return "primitive";
+    case NestedColumn::kStruct:
+      return "struct";
+    case NestedColumn::kList:
+      return "list";
+  }
+  return "unknown";
+}
+
+// Returns a copy of `column` without the values.
+NestedColumn GetLayout(const NestedColumn& column) {
+  NestedColumn layout{.kind = column.kind, .dtype = column.dtype,
+                      .names = column.names};
+  for (const NestedColumn& child : column.children) {
+    layout.children.push_back(GetLayout(child));
+  }
+  return layout;
+}
+
+absl::Status CheckSameLayout(const NestedColumn& expected,
+                             const NestedColumn& actual,
+                             absl::string_view path) {
+  if (expected.kind != actual.kind ||
+      (expected.kind == NestedColumn::kPrimitive &&
+       expected.dtype != actual.dtype) ||
+      expected.names != actual.names ||
+      expected.children.size() != actual.children.size()) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "column %s has a different layout than in the first row group: %s "
+        "vs %s",
+        path.empty() ? "<root>" : path, KindName(actual.kind),
+        KindName(expected.kind)));
+  }
+  for (int64_t i = 0; i < expected.children.size(); ++i) {
+    RETURN_IF_ERROR(CheckSameLayout(
+        expected.children[i], actual.children[i],
+        expected.kind == NestedColumn::kStruct
+            ? absl::StrCat(path, ".", expected.names[i])
+            : absl::StrCat(path, "[:]")));
+  }
+  return absl::OkStatus();
+}
+
+absl::StatusOr<DataSlice> CreateSchema(const DataBagPtr& db,
+                                       const NestedColumn& layout) {
+  switch (layout.kind) {
+    case NestedColumn::kPrimitive:
+      return DataSlice::Create(internal::DataItem(layout.dtype),
+                               internal::DataItem(schema::kSchema), db);
+    case NestedColumn::kStruct: {
+      std::vector<DataSlice> schemas;
+      schemas.reserve(layout.children.size());
+      for (const NestedColumn& child : layout.children) {
+        ASSIGN_OR_RETURN(schemas.emplace_back(), CreateSchema(db, child));
+      }
+      std::vector<absl::string_view> names(layout.names.begin(),
+                                           layout.names.end());
+      return CreateEntitySchema(db, names, schemas);
+    }
+    case NestedColumn::kList: {
+      ASSIGN_OR_RETURN(auto item_schema,
+                       CreateSchema(db, layout.children.front()));
+      return CreateListSchema(db, item_schema);
+    }
+  }
+  return absl::InternalError("unknown column kind");
+}
+
+// Returns the objects of `alloc` with offsets in [0, size), missing where
+// `validity` is missing.
+DataSliceImpl ObjectsWithValidity(
+    AllocationId alloc, int64_t size,
+    const arolla::DenseArray<arolla::Unit>& validity) {
+  if (validity.empty()) {
+    return DataSliceImpl::ObjectsFromAllocation(alloc, size);
+  }
+  arolla::DenseArrayBuilder<ObjectId> bldr(size);
+  validity.ForEachPresent([&](int64_t id, arolla::Unit) {
+    bldr.Set(id, alloc.ObjectByOffset(id));
+  });
+  return DataSliceImpl::CreateObjectsDataSlice(std::move(bldr).Build(),
+                                               AllocationIdSet(alloc));
+}
+
+// Converts `column` into a DataSliceImpl of size `column.size`, storing the
+// attributes and lists into `db`.
+absl::StatusOr<DataSliceImpl> ConvertColumn(const NestedColumn& column,
+                                            DataBagImpl& db) {
+  if (!column.validity.empty() && column.validity.size() != column.size) {
+    return absl::InvalidArgumentError("validity size mismatch");
+  }
+  switch (column.kind) {
+    case NestedColumn::kPrimitive:
+      if (column.values.size() != column.size) {
+        return absl::InvalidArgumentError("values size mismatch");
+      }
+      return column.values;
+    case NestedColumn::kStruct: {
+      if (column.names.size() != column.children.size()) {
+        return absl::InvalidArgumentError("struct field names mismatch");
+      }
+      AllocationId alloc = internal::Allocate(column.size);
+      for (int64_t i = 0; i < column.children.size(); ++i) {
+        ASSIGN_OR_RETURN(DataSliceImpl values,
+                         ConvertColumn(column.children[i], db));
+        if (values.size() != column.size) {
+          return absl::InvalidArgumentError(absl::StrFormat(
+              "struct field %s has %d rows, expected %d", column.names[i],
+              values.size(), column.size));
+        }
+        RETURN_IF_ERROR(
+            db.SetAttrForEntireAllocation(alloc, column.names[i], values));
+      }
+      return ObjectsWithValidity(alloc, column.size, column.validity);
+    }
+    case NestedColumn::kList: {
+      if (column.children.size() != 1 ||
+          column.offsets.size() != column.size + 1) {
+        return absl::InvalidArgumentError("invalid list column");
+      }
+      ASSIGN_OR_RETURN(DataSliceImpl items,
+                       ConvertColumn(column.children.front(), db));
+      ASSIGN_OR_RETURN(auto edge,
+                       arolla::DenseArrayEdge::FromSplitPoints(column.offsets));
+      if (edge.child_size() != items.size()) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "list offsets cover %d items, but there are %d",
+            edge.child_size(), items.size()));
+      }
+      AllocationId alloc = internal::AllocateLists(column.size);
+      RETURN_IF_ERROR(db.ExtendLists(
+          DataSliceImpl::ObjectsFromAllocation(alloc, column.size), items,
+          edge));
+      return ObjectsWithValidity(alloc, column.size, column.validity);
+    }
+  }
+  return absl::InternalError("unknown column kind");
+}
+
+}  // namespace
+
+absl::StatusOr<std::optional<DataSlice>> RowGroupReader::Next() {
+  const int64_t begin = next_row_group_;
+  const int64_t end =
+      std::min(source_.row_group_count(),
+               begin + std::max<int64_t>(options_.row_groups_per_batch, 1));
+  if (begin >= end) {
+    return std::nullopt;
+  }
+  next_row_group_ = end;
+
+  // Every row group is converted into its own DataBagImpl, as DataBagImpl is
+  // not thread-safe for writes.
+  std::vector<DataBagImplPtr> bags(end - begin);
+  std::vector<DataSliceImpl> rows(end - begin);
+  std::vector<NestedColumn> layouts(end - begin);
+  RETURN_IF_ERROR(internal::ParallelFor(
+      internal::CurrentExecutor().get(), end - begin,
+      [&](int64_t i) -> absl::Status {
+        ASSIGN_OR_RETURN(NestedColumn column,
+                         source_.ReadRowGroup(begin + i));
+        if (column.kind != NestedColumn::kStruct) {
+          return absl::InvalidArgumentError(absl::StrFormat(
+              "row group %d must be a struct column", begin + i));
+        }
+        bags[i] = DataBagImpl::CreateEmptyDatabag();
+        absl::StatusOr<DataSliceImpl> group_rows =
+            ConvertColumn(column, *bags[i]);
+        if (!group_rows.ok()) {
+          return absl::InvalidArgumentError(
+              absl::StrFormat("row group %d: %s", begin + i,
+                              group_rows.status().message()));
+        }
+        rows[i] = *std::move(group_rows);
+        layouts[i] = GetLayout(column);
+        return absl::OkStatus();
+      }));
+
+  if (!layout_.has_value()) {
+    layout_ = layouts.front();
+    auto schema_db = DataBag::Empty();
+    ASSIGN_OR_RETURN(schema_, CreateSchema(schema_db, *layout_));
+  }
+  for (int64_t i = 0; i < layouts.size(); ++i) {
+    if (absl::Status status = CheckSameLayout(*layout_, layouts[i], "");
+        !status.ok()) {
+      return absl::InvalidArgumentError(absl::StrFormat(
+          "row group %d: %s", begin + i, status.message()));
+    }
+  }
+
+  auto db = DataBag::Empty();
+  ASSIGN_OR_RETURN(DataBagImpl & db_impl, db->GetMutableImpl());
+  RETURN_IF_ERROR(db_impl.MergeInplace(schema_->GetDb()->GetImpl()));
+  int64_t size = 0;
+  AllocationIdSet allocs;
+  for (int64_t i = 0; i < bags.size(); ++i) {
+    RETURN_IF_ERROR(db_impl.MergeInplace(*bags[i]));
+    size += rows[i].size();
+    allocs.Insert(rows[i].allocation_ids());
+  }
+  arolla::DenseArrayBuilder<ObjectId> bldr(size);
+  int64_t offset = 0;
+  for (const DataSliceImpl& group_rows : rows) {
+    if (!group_rows.is_empty_and_unknown()) {
+      group_rows.values<ObjectId>().ForEachPresent(
+          [&](int64_t id, ObjectId row) { bldr.Set(offset + id, row); });
+    }
+    offset += group_rows.size();
+  }
+  return DataSlice::Create(
+      DataSliceImpl::CreateObjectsDataSlice(std::move(bldr).Build(),
+                                            std::move(allocs)),
+      DataSlice::JaggedShape::FlatFromSize(size), schema_->item(),
+      std::move(db));
+}
+
+absl::StatusOr<DataSlice> ReadRowGroups(const RowGroupSource& source) {
+  const int64_t count = source.row_group_count();
+  if (count == 0) {
+    return DataSlice::Create(DataSliceImpl::CreateEmptyAndUnknownType(0),
+                             DataSlice::JaggedShape::FlatFromSize(0),
+                             internal::DataItem(schema::kObject),
+                             DataBag::Empty());
+  }
+  RowGroupReader reader(source, {.row_groups_per_batch = count});
+  ASSIGN_OR_RETURN(std::optional<DataSlice> res, reader.Next());
+  return *std::move(res);
+}
+
+}  // namespace koladata::tabular
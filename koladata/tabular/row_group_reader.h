@@ -0,0 +1,108 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_TABULAR_ROW_GROUP_READER_H_
+#define KOLADATA_TABULAR_ROW_GROUP_READER_H_
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+
+#include "absl/status/statusor.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/unit.h"
+
+namespace koladata::tabular {
+
+// Decoded column of a row group, in the nested layout used by Arrow and
+// Parquet readers.
+struct NestedColumn {
+  enum Kind { kPrimitive, kStruct, kList };
+
+  Kind kind = kPrimitive;
+  // Number of rows of the column.
+  int64_t size = 0;
+
+  // kPrimitive: values of type `dtype`, missing for nulls.
+  schema::DType dtype;
+  internal::DataSliceImpl values;
+
+  // kStruct and kList: present rows. Empty means that all rows are present.
+  arolla::DenseArray<arolla::Unit> validity;
+  // kStruct: names of the fields, one per child.
+  std::vector<std::string> names;
+  // kStruct: fields of the same size as the column. kList: a single column
+  // with the items of all the lists.
+  std::vector<NestedColumn> children;
+  // kList: `size + 1` split points of the lists in children[0].
+  arolla::DenseArray<int64_t> offsets;
+};
+
+// Source of row groups, e.g. of a Parquet file. Each row group is decoded
+// independently into a kStruct column with a row per record.
+class RowGroupSource {
+ public:
+  virtual ~RowGroupSource() = default;
+
+  virtual int64_t row_group_count() const = 0;
+
+  // Decodes row group `index`. Called concurrently for different row groups.
+  virtual absl::StatusOr<NestedColumn> ReadRowGroup(int64_t index) const = 0;
+};
+
+// Converts row groups to entities, one per row. Structs become entities,
+// lists become Koda lists and primitive columns become attributes. The
+// attribute values of an allocation are taken over from the decoded columns
+// without copying.
+//
+// The schema is built from the layout of the first row group, and all row
+// groups must have the same layout.
+class RowGroupReader {
+ public:
+  struct Options {
+    // Number of row groups that are decoded and converted together (in
+    // parallel on CurrentExecutor()). Bounds the memory used by Next().
+    int64_t row_groups_per_batch = 4;
+  };
+
+  // `source` must outlive the reader.
+  explicit RowGroupReader(const RowGroupSource& source)
+      : RowGroupReader(source, Options()) {}
+  RowGroupReader(const RowGroupSource& source, Options options)
+      : source_(source), options_(options) {}
+
+  // Returns the rows of the next batch of row groups as a rank-1 DataSlice in
+  // a new DataBag, or nullopt when all row groups are read.
+  absl::StatusOr<std::optional<DataSlice>> Next();
+
+ private:
+  const RowGroupSource& source_;
+  const Options options_;
+  int64_t next_row_group_ = 0;
+  // Layout of the first row group, with the values dropped.
+  std::optional<NestedColumn> layout_;
+  std::optional<DataSlice> schema_;
+};
+
+// Reads all row groups of `source` into a single DataSlice. Returns an empty
+// OBJECT slice if there are no row groups.
+absl::StatusOr<DataSlice> ReadRowGroups(const RowGroupSource& source);
+
+}  // namespace koladata::tabular
+
+#endif  // KOLADATA_TABULAR_ROW_GROUP_READER_H_
@@ -0,0 +1,178 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/tabular/row_group_reader.h"
+
+#include <cstdint>
+#include <optional>
+#include <utility>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/status/statusor.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/executor.h"
+#include "koladata/test_utils.h"
+#include "koladata/testing/matchers.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
+#include "arolla/util/unit.h"
+
+namespace koladata::tabular {
+namespace {
+
+using ::absl_testing::IsOkAndHolds;
+using ::absl_testing::StatusIs;
+using ::koladata::internal::DataSliceImpl;
+using ::koladata::testing::IsEquivalentTo;
+using ::testing::Eq;
+using ::testing::HasSubstr;
+
+NestedColumn Primitive(schema::DType dtype, DataSliceImpl values) {
+  const int64_t size = values.size();
+  return {.kind = NestedColumn::kPrimitive,
+          .size = size,
+          .dtype = dtype,
+          .values = std::move(values)};
+}
+
+// Row group with columns:
+//   id: INT32
+//   tags: LIST[TEXT]
+//   point: STRUCT{x: FLOAT32}, missing for the second row.
+NestedColumn MakeRowGroup(int32_t first_id) {
+  NestedColumn tags{
+      .kind = NestedColumn::kList,
+      .size = 2,
+      .children = {Primitive(
+          schema::kText,
+          DataSliceImpl::Create(arolla::CreateDenseArray<arolla::Text>(
+              {arolla::Text("a"), arolla::Text("b"), arolla::Text("c")})))},
+      .offsets = arolla::CreateFullDenseArray<int64_t>({0, 2, 3}),
+  };
+  NestedColumn point{
+      .kind = NestedColumn::kStruct,
+      .size = 2,
+      .validity = arolla::CreateDenseArray<arolla::Unit>(
+          {arolla::kUnit, std::nullopt}),
+      .names = {"x"},
+      .children = {Primitive(schema::kFloat32,
+                             DataSliceImpl::Create(
+                                 arolla::CreateFullDenseArray<float>(
+                                     {1.5f, 0.0f})))},
+  };
+  return {
+      .kind = NestedColumn::kStruct,
+      .size = 2,
+      .names = {"id", "tags", "point"},
+      .children = {Primitive(schema::kInt32,
+                             DataSliceImpl::Create(
+                                 arolla::CreateFullDenseArray<int32_t>(
+                                     {first_id, first_id + 1}))),
+                   std::move(tags), std::move(point)},
+  };
+}
+
+class FakeRowGroupSource : public RowGroupSource {
+ public:
+  explicit FakeRowGroupSource(std::vector<NestedColumn> row_groups)
+      : row_groups_(std::move(row_groups)) {}
+
+  int64_t row_group_count() const override { return row_groups_.size(); }
+
+  absl::StatusOr<NestedColumn> ReadRowGroup(int64_t index) const override {
+    return row_groups_[index];
+  }
+
+ private:
+  std::vector<NestedColumn> row_groups_;
+};
+
+TEST(RowGroupReaderTest, ReadRowGroups) {
+  internal::ThreadPoolExecutor executor(2);
+  internal::ScopedExecutor scoped_executor(&executor);
+  FakeRowGroupSource source(
+      {MakeRowGroup(0), MakeRowGroup(2), MakeRowGroup(4)});
+  ASSERT_OK_AND_ASSIGN(DataSlice rows, ReadRowGroups(source));
+  EXPECT_EQ(rows.size(), 6);
+  EXPECT_TRUE(rows.GetSchema().IsEntitySchema());
+
+  ASSERT_OK_AND_ASSIGN(auto ids, rows.GetAttr("id"));
+  EXPECT_THAT(ids.slice(), IsEquivalentTo(DataSliceImpl::Create(
+                               arolla::CreateFullDenseArray<int32_t>(
+                                   {0, 1, 2, 3, 4, 5}))));
+
+  ASSERT_OK_AND_ASSIGN(auto point, rows.GetAttr("point"));
+  EXPECT_EQ(point.present_count(), 3);
+  ASSERT_OK_AND_ASSIGN(auto x, point.GetAttr("x"));
+  EXPECT_THAT(x.slice(), IsEquivalentTo(DataSliceImpl::Create(
+                             arolla::CreateDenseArray<float>(
+                                 {1.5f, std::nullopt, 1.5f, std::nullopt,
+                                  1.5f, std::nullopt}))));
+
+  ASSERT_OK_AND_ASSIGN(auto tags, rows.GetAttr("tags"));
+  EXPECT_TRUE(tags.GetSchema().IsListSchema());
+  ASSERT_OK_AND_ASSIGN(auto tag_items, tags.ExplodeList(0, std::nullopt));
+  EXPECT_EQ(tag_items.size(), 9);
+  EXPECT_EQ(tag_items.GetSchemaImpl(), schema::kText);
+}
+
+TEST(RowGroupReaderTest, Batches) {
+  FakeRowGroupSource source(
+      {MakeRowGroup(0), MakeRowGroup(2), MakeRowGroup(4)});
+  RowGroupReader reader(source, {.row_groups_per_batch = 2});
+  ASSERT_OK_AND_ASSIGN(std::optional<DataSlice> first, reader.Next());
+  ASSERT_TRUE(first.has_value());
+  EXPECT_EQ(first->size(), 4);
+  ASSERT_OK_AND_ASSIGN(std::optional<DataSlice> second, reader.Next());
+  ASSERT_TRUE(second.has_value());
+  EXPECT_EQ(second->size(), 2);
+  // All batches share the schema.
+  EXPECT_EQ(first->GetSchemaImpl(), second->GetSchemaImpl());
+  EXPECT_NE(first->GetDb(), second->GetDb());
+  EXPECT_THAT(reader.Next(), IsOkAndHolds(Eq(std::nullopt)));
+}
+
+TEST(RowGroupReaderTest, NoRowGroups) {
+  FakeRowGroupSource source({});
+  ASSERT_OK_AND_ASSIGN(DataSlice rows, ReadRowGroups(source));
+  EXPECT_EQ(rows.size(), 0);
+  EXPECT_EQ(rows.GetSchemaImpl(), schema::kObject);
+}
+
+TEST(RowGroupReaderTest, Errors) {
+  NestedColumn other = MakeRowGroup(2);
+  other.children[0].dtype = schema::kInt64;
+  FakeRowGroupSource mismatch({MakeRowGroup(0), std::move(other)});
+  EXPECT_THAT(ReadRowGroups(mismatch),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("row group 1: column .id has a different "
+                                 "layout")));
+
+  NestedColumn bad_offsets = MakeRowGroup(0);
+  bad_offsets.children[1].offsets =
+      arolla::CreateFullDenseArray<int64_t>({0, 2, 5});
+  FakeRowGroupSource invalid({std::move(bad_offsets)});
+  EXPECT_THAT(ReadRowGroups(invalid),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("row group 0: list offsets cover 5 items")));
+}
+
+}  // namespace
+}  // namespace koladata::tabular
@@ -0,0 +1,219 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#ifndef KOLADATA_TYPED_SLICE_VIEW_H_
+#define KOLADATA_TYPED_SLICE_VIEW_H_
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+
+#include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
+#include "absl/strings/str_format.h"
+#include "absl/strings/string_view.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/data_item.h"
+#include "koladata/internal/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/internal/object_id.h"
+#include "arolla/dense_array/bitmap.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/memory/buffer.h"
+#include "arolla/qtype/qtype_traits.h"
+#include "arolla/util/status_macros_backport.h"
+#include "arolla/util/view_types.h"
+
+namespace koladata {
+
+// Read-only view of the values of a DataSlice as arolla::DenseArray<T>.
+//
+// The type of the values is checked once, in Create(), so that kernels can be
+// written against the concrete type (e.g. looping over `values()` and
+// `bitmap()`) without dispatching on every element:
+//
+//   ASSIGN_OR_RETURN(auto view, TypedSliceView<int64_t>::Create(slice));
+//   int64_t sum = 0;
+//   view.ForEachPresent([&](int64_t id, int64_t value) { sum += value; });
+//
+// DataItems are viewed as arrays of size 1. Slices with missing values only
+// are viewed as arrays without present values. The view shares the values
+// with the DataSlice, so it is cheap to create.
+template <typename T>
+class TypedSliceView {
+ public:
+  using view_type = arolla::view_type_t<T>;
+
+  // Returns an error if `slice` has values of other types than T, or if its
+  // schema is a primitive schema other than T.
+  static absl::StatusOr<TypedSliceView> Create(const DataSlice& slice) {
+    const internal::DataItem& schema = slice.GetSchemaImpl();
+    if (schema.is_primitive_schema()) {
+      if constexpr (std::is_same_v<T, internal::ObjectId>) {
+        return absl::InvalidArgumentError(absl::StrFormat(
+            "expected a DataSlice of ObjectIds, got %v schema", schema));
+      } else if (schema != schema::GetDType<T>()) {
+        return absl::InvalidArgumentError(
+            absl::StrFormat("expected a DataSlice of %v, got %v schema",
+                            schema::GetDType<T>(), schema));
+      }
+    }
+    return slice.VisitImpl(
+        [&]<class ImplT>(const ImplT& impl) -> absl::StatusOr<TypedSliceView> {
+          if constexpr (std::is_same_v<ImplT, internal::DataItem>) {
+            arolla::DenseArrayBuilder<T> bldr(1);
+            if (impl.has_value()) {
+              if (!impl.template holds_value<T>()) {
+                return TypeError(impl.dtype());
+              }
+              bldr.Set(0, impl.template value<T>());
+            }
+            return TypedSliceView(std::move(bldr).Build(), slice.GetShape());
+          } else {
+            if (impl.is_empty_and_unknown()) {
+              return TypedSliceView(
+                  arolla::CreateEmptyDenseArray<T>(impl.size()),
+                  slice.GetShape());
+            }
+            if (impl.is_mixed_dtype() ||
+                impl.dtype() != arolla::GetQType<T>()) {
+              return TypeError(impl.dtype());
+            }
+            return TypedSliceView(impl.template values<T>(),
+                                  slice.GetShape());
+          }
+        });
+  }
+
+  int64_t size() const { return array_.size(); }
+  bool present(int64_t id) const { return array_.present(id); }
+  bool IsFull() const { return array_.IsFull(); }
+  bool IsAllMissing() const { return array_.IsAllMissing(); }
+
+  // Value with the given id. Unspecified if the value is missing.
+  view_type operator[](int64_t id) const {
+    DCHECK_GE(id, 0);
+    DCHECK_LT(id, size());
+    return array_.values[id];
+  }
+
+  const arolla::DenseArray<T>& array() const { return array_; }
+  const arolla::Buffer<T>& values() const { return array_.values; }
+  // Presence bitmap, see arolla::bitmap. Empty if all values are present.
+  const arolla::bitmap::Bitmap& bitmap() const { return array_.bitmap; }
+  const DataSlice::JaggedShape& shape() const { return shape_; }
+
+  // Calls `fn(id, value)` for every present value.
+  template <typename Fn>
+  void ForEachPresent(Fn&& fn) const {
+    array_.ForEachPresent(std::forward<Fn>(fn));
+  }
+
+ private:
+  TypedSliceView(arolla::DenseArray<T> array, DataSlice::JaggedShape shape)
+      : array_(std::move(array)), shape_(std::move(shape)) {}
+
+  static absl::Status TypeError(arolla::QTypePtr dtype) {
+    return absl::InvalidArgumentError(absl::StrFormat(
+        "expected a DataSlice of %s, got values of %s",
+        arolla::GetQType<T>()->name(),
+        dtype == nullptr ? "mixed types" : dtype->name()));
+  }
+
+  arolla::DenseArray<T> array_;
+  DataSlice::JaggedShape shape_;
+};
+
+// Typed views of the attributes of entities. `Ts` are the types of the
+// attributes, passed to Create() in the same order:
+//
+//   ASSIGN_OR_RETURN(
+//       auto view,
+//       (TypedEntityView<int64_t, arolla::Text>::Create(people,
+//                                                        {"age", "name"})));
+//   const TypedSliceView<int64_t>& ages = view.get<0>();
+//
+// All views have the shape of the entities.
+template <typename... Ts>
+class TypedEntityView {
+ public:
+  static absl::StatusOr<TypedEntityView> Create(
+      const DataSlice& entities,
+      const std::array<absl::string_view, sizeof...(Ts)>& attr_names) {
+    return CreateImpl(entities, attr_names,
+                      std::index_sequence_for<Ts...>());
+  }
+
+  const TypedSliceView<internal::ObjectId>& entities() const {
+    return entities_;
+  }
+
+  template <size_t I>
+  const auto& get() const {
+    return std::get<I>(attrs_);
+  }
+
+ private:
+  TypedEntityView(TypedSliceView<internal::ObjectId> entities,
+                  std::tuple<TypedSliceView<Ts>...> attrs)
+      : entities_(std::move(entities)), attrs_(std::move(attrs)) {}
+
+  template <size_t... Is>
+  static absl::StatusOr<TypedEntityView> CreateImpl(
+      const DataSlice& entities,
+      const std::array<absl::string_view, sizeof...(Ts)>& attr_names,
+      std::index_sequence<Is...>) {
+    ASSIGN_OR_RETURN(auto entities_view,
+                     TypedSliceView<internal::ObjectId>::Create(entities));
+    std::tuple<std::optional<TypedSliceView<Ts>>...> attrs;
+    absl::Status status = absl::OkStatus();
+    auto load = [&]<typename T>(absl::string_view attr_name,
+                                std::optional<TypedSliceView<T>>& view) {
+      if (!status.ok()) {
+        return;
+      }
+      absl::StatusOr<DataSlice> values = entities.GetAttr(attr_name);
+      if (!values.ok()) {
+        status = values.status();
+        return;
+      }
+      absl::StatusOr<TypedSliceView<T>> values_view =
+          TypedSliceView<T>::Create(*values);
+      if (!values_view.ok()) {
+        status = absl::InvalidArgumentError(
+            absl::StrFormat("attribute '%s': %s", attr_name,
+                            values_view.status().message()));
+        return;
+      }
+      view.emplace(*std::move(values_view));
+    };
+    (load(attr_names[Is], std::get<Is>(attrs)), ...);
+    RETURN_IF_ERROR(status);
+    return TypedEntityView(
+        std::move(entities_view),
+        std::tuple<TypedSliceView<Ts>...>(*std::move(std::get<Is>(attrs))...));
+  }
+
+  TypedSliceView<internal::ObjectId> entities_;
+  std::tuple<TypedSliceView<Ts>...> attrs_;
+};
+
+}  // namespace koladata
+
+#endif  // KOLADATA_TYPED_SLICE_VIEW_H_
@@ -0,0 +1,126 @@
+// Copyright 2024 Google LLC
+//
+// Licensed under the Apache License, Version 2.0 (the "License");
+// you may not use this file except in compliance with the License.
+// You may obtain a copy of the License at
+//
+//      http://www.apache.org/licenses/LICENSE-2.0
+//
+// Unless required by applicable law or agreed to in writing, software
+// distributed under the License is distributed on an "AS IS" BASIS,
+// WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+// See the License for the specific language governing permissions and
+// limitations under the License.
+//
+#include "koladata/typed_slice_view.h"
+
+#include <cstdint>
+#include <optional>
+#include <vector>
+
+#include "gmock/gmock.h"
+#include "gtest/gtest.h"
+#include "absl/status/status.h"
+#include "absl/status/status_matchers.h"
+#include "absl/strings/string_view.h"
+#include "koladata/data_bag.h"
+#include "koladata/data_slice.h"
+#include "koladata/internal/dtype.h"
+#include "koladata/object_factories.h"
+#include "koladata/test_utils.h"
+#include "arolla/dense_array/dense_array.h"
+#include "arolla/util/text.h"
+
+namespace koladata {
+namespace {
+
+using ::absl_testing::StatusIs;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+
+TEST(TypedSliceViewTest, Slice) {
+  auto ds = test::DataSlice<int64_t>({1, std::nullopt, 3});
+  ASSERT_OK_AND_ASSIGN(auto view, TypedSliceView<int64_t>::Create(ds));
+  EXPECT_EQ(view.size(), 3);
+  EXPECT_TRUE(view.present(0));
+  EXPECT_FALSE(view.present(1));
+  EXPECT_FALSE(view.IsFull());
+  EXPECT_EQ(view[2], 3);
+  std::vector<int64_t> values;
+  view.ForEachPresent([&](int64_t id, int64_t value) {
+    values.push_back(value);
+  });
+  EXPECT_THAT(values, ElementsAre(1, 3));
+  EXPECT_EQ(view.shape().rank(), 1);
+}
+
+TEST(TypedSliceViewTest, ItemAndText) {
+  ASSERT_OK_AND_ASSIGN(auto view, TypedSliceView<arolla::Text>::Create(
+                                      test::DataItem("abc")));
+  EXPECT_EQ(view.size(), 1);
+  EXPECT_EQ(view[0], "abc");
+  EXPECT_EQ(view.shape().rank(), 0);
+
+  ASSERT_OK_AND_ASSIGN(auto missing,
+                       TypedSliceView<arolla::Text>::Create(test::DataItem(
+                           internal::DataItem(), schema::kText)));
+  EXPECT_EQ(missing.size(), 1);
+  EXPECT_TRUE(missing.IsAllMissing());
+}
+
+TEST(TypedSliceViewTest, ObjectSchema) {
+  ASSERT_OK_AND_ASSIGN(
+      auto view, TypedSliceView<int32_t>::Create(
+                     test::DataSlice<int32_t>({1, 2}, schema::kObject)));
+  EXPECT_EQ(view[1], 2);
+  ASSERT_OK_AND_ASSIGN(
+      auto empty, TypedSliceView<float>::Create(test::EmptyDataSlice(
+                      2, schema::kObject)));
+  EXPECT_EQ(empty.size(), 2);
+  EXPECT_TRUE(empty.IsAllMissing());
+}
+
+TEST(TypedSliceViewTest, Errors) {
+  EXPECT_THAT(TypedSliceView<int64_t>::Create(test::DataSlice<int32_t>({1})),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("expected a DataSlice of INT64")));
+  EXPECT_THAT(TypedSliceView<int64_t>::Create(
+                  test::DataSlice<int32_t>({1}, schema::kObject)),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("got values of INT32")));
+  EXPECT_THAT(TypedSliceView<int32_t>::Create(test::MixedDataSlice<int, float>(
+                  {1, std::nullopt}, {std::nullopt, 2.0f})),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("got values of mixed types")));
+  EXPECT_THAT(
+      TypedSliceView<internal::ObjectId>::Create(test::DataSlice<int32_t>({1})),
+      StatusIs(absl::StatusCode::kInvalidArgument,
+               HasSubstr("expected a DataSlice of ObjectIds")));
+}
+
+TEST(TypedEntityViewTest, Attributes) {
+  auto db = DataBag::Empty();
+  ASSERT_OK_AND_ASSIGN(
+      auto entities,
+      EntityCreator::FromAttrs(
+          db, {"age", "name"},
+          {test::DataSlice<int64_t>({30, 40}),
+           test::DataSlice<arolla::Text>({"a", std::nullopt})}));
+  ASSERT_OK_AND_ASSIGN(
+      auto view, (TypedEntityView<int64_t, arolla::Text>::Create(
+                     entities, {"age", "name"})));
+  EXPECT_EQ(view.entities().size(), 2);
+  EXPECT_EQ(view.get<0>()[1], 40);
+  EXPECT_EQ(view.get<1>()[0], "a");
+  EXPECT_FALSE(view.get<1>().present(1));
+
+  EXPECT_THAT((TypedEntityView<float>::Create(entities, {"age"})),
+              StatusIs(absl::StatusCode::kInvalidArgument,
+                       HasSubstr("attribute 'age': expected a DataSlice of "
+                                 "FLOAT32")));
+  EXPECT_THAT((TypedEntityView<float>::Create(entities, {"height"})),
+              StatusIs(absl::StatusCode::kInvalidArgument));
+}
+
+}  // namespace
+}  // namespace koladata
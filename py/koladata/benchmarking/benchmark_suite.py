@@ -0,0 +1,292 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Runs the Koda C++ benchmark suite and compares the results of two runs.
+
+The suite is a set of Google Benchmark binaries. `run` executes all of them
+and writes a single JSON file in a stable schema:
+
+  {
+    "schema_version": 1,
+    "context": {"date": ..., "host_name": ..., "num_cpus": ..., ...},
+    "results": [
+      {
+        "suite": "internal/dense_source_benchmarks",
+        "name": "BM_Get/1000/0",
+        "iterations": 123,
+        "real_time_ns": 456.0,
+        "cpu_time_ns": 450.0,
+        "counters": {"peak_rss_mb": 12.5}
+      }
+    ]
+  }
+
+The results are sorted by (suite, name), and times are always in nanoseconds
+regardless of the unit the benchmark reports. With --repetitions > 1, the
+median of the repetitions is kept.
+
+`compare` reads two such files and exits with status 1 if any benchmark
+present in both got slower by more than --threshold_percent.
+
+Use the //py/koladata/benchmarking:benchmark_suite target, which passes the
+benchmark binaries of the suite, rather than calling this script directly:
+
+  bazel run -c opt //py/koladata/benchmarking:benchmark_suite -- \\
+      run --output=/tmp/new.json
+  bazel run //py/koladata/benchmarking:benchmark_suite -- \\
+      compare /tmp/old.json /tmp/new.json --threshold_percent=5
+"""
+
+import argparse
+import json
+import os
+import subprocess
+import sys
+import tempfile
+from typing import Any
+
+SCHEMA_VERSION = 1
+
+# Fields of the Google Benchmark context kept in the suite results.
+_CONTEXT_FIELDS = (
+    'date',
+    'host_name',
+    'num_cpus',
+    'mhz_per_cpu',
+    'cpu_scaling_enabled',
+    'library_build_type',
+)
+
+# Fields of a Google Benchmark result that are not user counters.
+_NON_COUNTER_FIELDS = frozenset([
+    'name',
+    'family_index',
+    'per_family_instance_index',
+    'run_name',
+    'run_type',
+    'repetitions',
+    'repetition_index',
+    'threads',
+    'iterations',
+    'real_time',
+    'cpu_time',
+    'time_unit',
+    'aggregate_name',
+    'aggregate_unit',
+    'error_occurred',
+    'error_message',
+    'label',
+])
+
+_NANOSECONDS_PER_UNIT = {'ns': 1, 'us': 1e3, 'ms': 1e6, 's': 1e9}
+
+METRICS = ('cpu_time_ns', 'real_time_ns')
+
+
+def normalize_run(suite: str, run: dict[str, Any]) -> list[dict[str, Any]]:
+  """Converts Google Benchmark JSON output of one binary to suite results."""
+  results = []
+  has_repetitions = any(
+      b.get('run_type') == 'aggregate' for b in run.get('benchmarks', [])
+  )
+  for benchmark in run.get('benchmarks', []):
+    if benchmark.get('error_occurred'):
+      continue
+    if has_repetitions:
+      if benchmark.get('aggregate_name') != 'median':
+        continue
+      name = benchmark['run_name']
+    else:
+      name = benchmark['name']
+    scale = _NANOSECONDS_PER_UNIT[benchmark.get('time_unit', 'ns')]
+    results.append({
+        'suite': suite,
+        'name': name,
+        'iterations': benchmark['iterations'],
+        'real_time_ns': benchmark['real_time'] * scale,
+        'cpu_time_ns': benchmark['cpu_time'] * scale,
+        'counters': {
+            k: v
+            for k, v in sorted(benchmark.items())
+            if k not in _NON_COUNTER_FIELDS and isinstance(v, (int, float))
+        },
+    })
+  return results
+
+
+def make_suite_results(
+    runs: dict[str, dict[str, Any]],
+) -> dict[str, Any]:
+  """Returns the suite results of Google Benchmark outputs keyed by suite."""
+  context = {}
+  results = []
+  for suite, run in sorted(runs.items()):
+    if not context:
+      context = {
+          k: v for k, v in run.get('context', {}).items()
+          if k in _CONTEXT_FIELDS
+      }
+    results.extend(normalize_run(suite, run))
+  results.sort(key=lambda r: (r['suite'], r['name']))
+  return {
+      'schema_version': SCHEMA_VERSION,
+      'context': context,
+      'results': results,
+  }
+
+
+def compare(
+    baseline: dict[str, Any],
+    candidate: dict[str, Any],
+    threshold_percent: float,
+    metric: str = 'cpu_time_ns',
+) -> tuple[list[dict[str, Any]], list[str]]:
+  """Compares two suite results.
+
+  Args:
+    baseline: Suite results of the old version.
+    candidate: Suite results of the new version.
+    threshold_percent: Slowdowns above this many percent are regressions.
+    metric: One of METRICS.
+
+  Returns:
+    The rows of the benchmarks present in both results, sorted by suite and
+    name, with their `change_percent` and whether they are a `regression`; and
+    the names of the benchmarks present in only one of the results.
+  """
+  for results in (baseline, candidate):
+    if results.get('schema_version') != SCHEMA_VERSION:
+      raise ValueError(
+          f'unsupported schema version: {results.get("schema_version")}'
+      )
+  if metric not in METRICS:
+    raise ValueError(f'unsupported metric: {metric}')
+  key = lambda r: f'{r["suite"]}:{r["name"]}'
+  old = {key(r): r for r in baseline['results']}
+  new = {key(r): r for r in candidate['results']}
+  rows = []
+  for name in sorted(old.keys() & new.keys()):
+    old_value = old[name][metric]
+    new_value = new[name][metric]
+    change = (
+        (new_value - old_value) / old_value * 100 if old_value > 0 else 0.0
+    )
+    rows.append({
+        'name': name,
+        'baseline': old_value,
+        'candidate': new_value,
+        'change_percent': change,
+        'regression': change > threshold_percent,
+    })
+  unmatched = sorted(old.keys() ^ new.keys())
+  return rows, unmatched
+
+
+def _run_suite(
+    binaries: dict[str, str], benchmark_filter: str, repetitions: int
+) -> dict[str, Any]:
+  runs = {}
+  with tempfile.TemporaryDirectory() as tmp_dir:
+    for i, (suite, binary) in enumerate(sorted(binaries.items())):
+      # Suite names can contain slashes.
+      out = os.path.join(tmp_dir, f'{i}.json')
+      cmd = [
+          binary,
+          f'--benchmark_out={out}',
+          '--benchmark_out_format=json',
+          f'--benchmark_filter={benchmark_filter}',
+      ]
+      if repetitions > 1:
+        cmd += [
+            f'--benchmark_repetitions={repetitions}',
+            '--benchmark_report_aggregates_only=true',
+        ]
+      print(f'Running {suite}...', file=sys.stderr)
+      subprocess.run(cmd, check=True, stdout=subprocess.DEVNULL)
+      with open(out) as f:
+        runs[suite] = json.load(f)
+  return make_suite_results(runs)
+
+
+def _parse_binaries(specs: list[str]) -> dict[str, str]:
+  binaries = {}
+  for spec in specs:
+    suite, sep, path = spec.partition('=')
+    if not sep or not suite or not path:
+      raise ValueError(f'expected <suite>=<binary>, got {spec!r}')
+    if suite in binaries:
+      raise ValueError(f'duplicate suite {suite!r}')
+    binaries[suite] = path
+  return binaries
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+  # Passed by the build target before the command.
+  parser.add_argument(
+      '--binary',
+      action='append',
+      default=[],
+      help='<suite>=<path> of a benchmark binary of the suite. Repeated.',
+  )
+  subparsers = parser.add_subparsers(dest='command', required=True)
+
+  run_parser = subparsers.add_parser('run', help='Runs the suite.')
+  run_parser.add_argument('--output', required=True, help='JSON to write.')
+  run_parser.add_argument('--benchmark_filter', default='.')
+  run_parser.add_argument('--repetitions', type=int, default=1)
+
+  compare_parser = subparsers.add_parser(
+      'compare', help='Compares two runs.'
+  )
+  compare_parser.add_argument('baseline')
+  compare_parser.add_argument('candidate')
+  compare_parser.add_argument('--threshold_percent', type=float, default=5)
+  compare_parser.add_argument('--metric', choices=METRICS, default=METRICS[0])
+
+  args = parser.parse_args()
+  if args.command == 'run':
+    results = _run_suite(
+        _parse_binaries(args.binary), args.benchmark_filter, args.repetitions
+    )
+    with open(args.output, 'w') as f:
+      json.dump(results, f, indent=2, sort_keys=True)
+    return
+
+  with open(args.baseline) as f:
+    baseline = json.load(f)
+  with open(args.candidate) as f:
+    candidate = json.load(f)
+  rows, unmatched = compare(
+      baseline, candidate, args.threshold_percent, args.metric
+  )
+  for row in rows:
+    marker = '  REGRESSION' if row['regression'] else ''
+    print(
+        f'{row["name"]:<80} {row["baseline"]:>14.1f} {row["candidate"]:>14.1f}'
+        f' {row["change_percent"]:>+8.1f}%{marker}'
+    )
+  for name in unmatched:
+    print(f'{name:<80} (only in one of the runs)')
+  regressions = sum(row['regression'] for row in rows)
+  if regressions:
+    print(
+        f'{regressions} benchmark(s) regressed by more than'
+        f' {args.threshold_percent}% in {args.metric}'
+    )
+    sys.exit(1)
+
+
+if __name__ == '__main__':
+  main()
@@ -0,0 +1,128 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for benchmark_suite."""
+
+from absl.testing import absltest
+from koladata.benchmarking import benchmark_suite
+
+
+def _benchmark(name, cpu_time, time_unit='ns', **kwargs):
+  return {
+      'name': name,
+      'run_name': name,
+      'run_type': 'iteration',
+      'iterations': 100,
+      'real_time': cpu_time + 1,
+      'cpu_time': cpu_time,
+      'time_unit': time_unit,
+      **kwargs,
+  }
+
+
+def _results(*times):
+  return benchmark_suite.make_suite_results({
+      'suite': {
+          'benchmarks': [
+              _benchmark(f'BM_{i}', t) for i, t in enumerate(times)
+          ]
+      }
+  })
+
+
+class BenchmarkSuiteTest(absltest.TestCase):
+
+  def test_make_suite_results(self):
+    results = benchmark_suite.make_suite_results({
+        'b_suite': {
+            'context': {'num_cpus': 8, 'caches': []},
+            'benchmarks': [
+                _benchmark('BM_Z', 2, time_unit='us', peak_rss_mb=12.5),
+                _benchmark('BM_Failed', 1, error_occurred=True),
+            ],
+        },
+        'a_suite': {'benchmarks': [_benchmark('BM_A', 3)]},
+    })
+    self.assertEqual(
+        results,
+        {
+            'schema_version': 1,
+            'context': {'num_cpus': 8},
+            'results': [
+                {
+                    'suite': 'a_suite',
+                    'name': 'BM_A',
+                    'iterations': 100,
+                    'real_time_ns': 4,
+                    'cpu_time_ns': 3,
+                    'counters': {},
+                },
+                {
+                    'suite': 'b_suite',
+                    'name': 'BM_Z',
+                    'iterations': 100,
+                    'real_time_ns': 3000,
+                    'cpu_time_ns': 2000,
+                    'counters': {'peak_rss_mb': 12.5},
+                },
+            ],
+        },
+    )
+
+  def test_median_of_repetitions(self):
+    benchmarks = [
+        _benchmark('BM_A_mean', 5, run_name='BM_A', run_type='aggregate',
+                   aggregate_name='mean'),
+        _benchmark('BM_A_median', 4, run_name='BM_A', run_type='aggregate',
+                   aggregate_name='median'),
+    ]
+    results = benchmark_suite.make_suite_results(
+        {'suite': {'benchmarks': benchmarks}}
+    )
+    self.assertLen(results['results'], 1)
+    self.assertEqual(results['results'][0]['name'], 'BM_A')
+    self.assertEqual(results['results'][0]['cpu_time_ns'], 4)
+
+  def test_compare(self):
+    baseline = _results(100, 100, 100)
+    candidate = _results(104, 120, 50)
+    candidate['results'].append(dict(candidate['results'][0], name='BM_new'))
+    rows, unmatched = benchmark_suite.compare(
+        baseline, candidate, threshold_percent=5
+    )
+    self.assertEqual(
+        [(r['name'], r['change_percent'], r['regression']) for r in rows],
+        [
+            ('suite:BM_0', 4, False),
+            ('suite:BM_1', 20, True),
+            ('suite:BM_2', -50, False),
+        ],
+    )
+    self.assertEqual(unmatched, ['suite:BM_new'])
+
+  def test_compare_real_time(self):
+    rows, _ = benchmark_suite.compare(
+        _results(100), _results(100), 5, metric='real_time_ns'
+    )
+    self.assertEqual(rows[0]['baseline'], 101)
+
+  def test_compare_errors(self):
+    with self.assertRaisesRegex(ValueError, 'schema version'):
+      benchmark_suite.compare({'schema_version': 0}, _results(), 5)
+    with self.assertRaisesRegex(ValueError, 'metric'):
+      benchmark_suite.compare(_results(), _results(), 5, metric='iterations')
+
+
+if __name__ == '__main__':
+  absltest.main()
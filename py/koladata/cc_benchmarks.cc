@@ -15,7 +15,9 @@
 #include <cstddef>
 #include <cstdint>
 #include <optional>
+#include <string>
 #include <tuple>
+#include <utility>
 #include <vector>
 
 #include "benchmark/benchmark.h"
@@ -24,11 +26,13 @@
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
 #include "koladata/data_slice_qtype.h"
+#include "koladata/expr/expr_eval.h"
 #include "koladata/functor/call.h"
 #include "koladata/functor/functor.h"
 #include "koladata/internal/data_item.h"
 #include "koladata/internal/data_slice.h"
 #include "koladata/internal/dtype.h"
+#include "koladata/operators/arolla_bridge.h"
 #include "arolla/dense_array/dense_array.h"
 #include "arolla/expr/expr.h"
 #include "arolla/expr/quote.h"
@@ -309,5 +313,53 @@ BENCHMARK(BM_AddViaFunctor)
     ->Args({10000, 100})
     ->ThreadRange(1, 16);
 
+void BM_EvalExprWithCompilationCache(benchmark::State& state) {
+  arolla::InitArolla();
+  auto ds = DataSlice::Create(internal::DataItem(1),
+                              internal::DataItem(schema::kInt32))
+                .value();
+  auto input = CallOp("koda_internal.input", {Literal(arolla::Text("I")),
+                                              Literal(arolla::Text("x"))})
+                   .value();
+  auto expr = CallOp("kde.add", {input, input}).value();
+  std::vector<std::pair<std::string, arolla::TypedRef>> inputs = {
+      {"x", arolla::TypedRef::FromValue(ds)}};
+
+  {
+    auto result = expr::EvalExprWithCompilationCache(
+        expr, inputs, {});  // Preheat caches;
+    benchmark::DoNotOptimize(result);
+  }
+
+  for (auto s : state) {
+    benchmark::DoNotOptimize(inputs);
+    auto result = expr::EvalExprWithCompilationCache(expr, inputs, {});
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+BENCHMARK(BM_EvalExprWithCompilationCache)->ThreadRange(1, 16);
+
+void BM_OpsEvalExpr(benchmark::State& state) {
+  arolla::InitArolla();
+  int32_t x = 1;
+  int32_t y = 2;
+  std::vector<arolla::TypedRef> inputs = {arolla::TypedRef::FromValue(x),
+                                          arolla::TypedRef::FromValue(y)};
+
+  {
+    auto result = ops::EvalExpr("math.add", inputs);  // Preheat caches;
+    benchmark::DoNotOptimize(result);
+  }
+
+  for (auto s : state) {
+    benchmark::DoNotOptimize(inputs);
+    auto result = ops::EvalExpr("math.add", inputs);
+    benchmark::DoNotOptimize(result);
+  }
+}
+
+BENCHMARK(BM_OpsEvalExpr)->ThreadRange(1, 16);
+
 }  // namespace
 }  // namespace koladata
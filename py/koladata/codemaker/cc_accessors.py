@@ -0,0 +1,188 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Generates typed C++ accessors for Koda entities.
+
+The input is a JSON spec of the entity schemas:
+
+  {
+    "namespace": "my::project",
+    "entities": [
+      {
+        "name": "Person",
+        "attrs": [
+          {"name": "age", "dtype": "INT32"},
+          {"name": "name", "dtype": "TEXT"},
+          {"name": "employer", "dtype": "ITEMID"}
+        ]
+      }
+    ]
+  }
+
+For every entity, the generated header defines a class with a nested `Batch`
+class. `Batch::Create(entities)` looks the attributes up and checks their
+types once; after that, every attribute is available as a
+`koladata::TypedSliceView` (values and presence bitmap) without string lookups
+or type dispatch.
+
+Use the `koda_cc_accessors` build macro from
+//koladata/codemaker:codemaker.bzl rather than calling this script directly.
+"""
+
+import argparse
+import json
+import re
+from typing import Any
+
+# Koda dtype name -> C++ type of the values.
+CC_TYPES = {
+    'INT32': 'int32_t',
+    'INT64': 'int64_t',
+    'FLOAT32': 'float',
+    'FLOAT64': 'double',
+    'BOOLEAN': 'bool',
+    'MASK': '::arolla::Unit',
+    'TEXT': '::arolla::Text',
+    'BYTES': '::arolla::Bytes',
+    'ITEMID': '::koladata::internal::ObjectId',
+}
+
+# Names of the members of the generated Batch classes.
+_RESERVED_ATTR_NAMES = frozenset(['Create', 'size', 'entities', 'view_'])
+
+_IDENTIFIER = re.compile(r'^[A-Za-z_][A-Za-z0-9_]*$')
+_NAMESPACE = re.compile(r'^[A-Za-z_][A-Za-z0-9_]*(::[A-Za-z_][A-Za-z0-9_]*)*$')
+
+
+def _check_identifier(name: str, what: str):
+  if not _IDENTIFIER.match(name):
+    raise ValueError(f'{what} {name!r} is not a valid C++ identifier')
+
+
+def _generate_entity(entity: dict[str, Any]) -> str:
+  """Returns the class definition for a single entity."""
+  name = entity['name']
+  _check_identifier(name, 'entity name')
+  attrs = entity.get('attrs', [])
+  if not attrs:
+    raise ValueError(f'entity {name!r} has no attributes')
+  seen = set()
+  for attr in attrs:
+    _check_identifier(attr['name'], 'attribute name')
+    if attr['name'] in _RESERVED_ATTR_NAMES:
+      raise ValueError(f'attribute name {attr["name"]!r} is reserved')
+    if attr['name'] in seen:
+      raise ValueError(f'duplicate attribute {attr["name"]!r} in {name!r}')
+    seen.add(attr['name'])
+    if attr['dtype'] not in CC_TYPES:
+      raise ValueError(
+          f'unsupported dtype {attr["dtype"]!r} of {name}.{attr["name"]}, '
+          f'expected one of {sorted(CC_TYPES)}'
+      )
+
+  cc_types = ', '.join(CC_TYPES[a['dtype']] for a in attrs)
+  attr_names = ', '.join(f'"{a["name"]}"' for a in attrs)
+  accessors = []
+  for i, attr in enumerate(attrs):
+    accessors.append(
+        f'    // Attribute `{attr["name"]}` ({attr["dtype"]}).\n'
+        f'    const ::koladata::TypedSliceView<{CC_TYPES[attr["dtype"]]}>&'
+        f' {attr["name"]}() const {{\n'
+        f'      return view_.get<{i}>();\n'
+        '    }\n'
+    )
+  return (
+      f'class {name} {{\n'
+      ' public:\n'
+      f'  // Typed views of the attributes of a DataSlice of {name} entities.\n'
+      '  class Batch {\n'
+      '   public:\n'
+      '    static absl::StatusOr<Batch> Create(\n'
+      '        const ::koladata::DataSlice& entities) {\n'
+      '      ASSIGN_OR_RETURN(auto view, View::Create(entities, kAttrNames));\n'
+      '      return Batch(std::move(view));\n'
+      '    }\n'
+      '\n'
+      '    int64_t size() const { return view_.entities().size(); }\n'
+      '    const ::koladata::TypedSliceView<::koladata::internal::ObjectId>&\n'
+      '    entities() const {\n'
+      '      return view_.entities();\n'
+      '    }\n'
+      '\n'
+      + '\n'.join(accessors)
+      + '\n'
+      '   private:\n'
+      f'    using View = ::koladata::TypedEntityView<{cc_types}>;\n'
+      f'    static constexpr std::array<absl::string_view, {len(attrs)}>'
+      ' kAttrNames = {\n'
+      f'        {attr_names}}};\n'
+      '\n'
+      '    explicit Batch(View view) : view_(std::move(view)) {}\n'
+      '\n'
+      '    View view_;\n'
+      '  };\n'
+      '};\n'
+  )
+
+
+def generate_header(spec: dict[str, Any], header_guard: str) -> str:
+  """Returns the C++ header with the accessors for `spec`."""
+  namespace = spec.get('namespace', '')
+  if namespace and not _NAMESPACE.match(namespace):
+    raise ValueError(f'namespace {namespace!r} is not a valid C++ namespace')
+  _check_identifier(header_guard, 'header guard')
+  entities = '\n'.join(_generate_entity(e) for e in spec['entities'])
+  if namespace:
+    entities = (
+        f'namespace {namespace} {{\n\n{entities}\n}}  // namespace {namespace}\n'
+    )
+  return (
+      '// Generated by koladata/codemaker. DO NOT EDIT.\n'
+      f'#ifndef {header_guard}\n'
+      f'#define {header_guard}\n'
+      '\n'
+      '#include <array>\n'
+      '#include <cstdint>\n'
+      '#include <utility>\n'
+      '\n'
+      '#include "absl/status/statusor.h"\n'
+      '#include "absl/strings/string_view.h"\n'
+      '#include "koladata/data_slice.h"\n'
+      '#include "koladata/internal/object_id.h"\n'
+      '#include "koladata/typed_slice_view.h"\n'
+      '#include "arolla/util/bytes.h"\n'
+      '#include "arolla/util/status_macros_backport.h"\n'
+      '#include "arolla/util/text.h"\n'
+      '#include "arolla/util/unit.h"\n'
+      '\n'
+      f'{entities}'
+      '\n'
+      f'#endif  // {header_guard}\n'
+  )
+
+
+def main():
+  parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+  parser.add_argument('--spec', required=True, help='JSON spec of entities.')
+  parser.add_argument('--output', required=True, help='Header to write.')
+  parser.add_argument('--header_guard', required=True)
+  args = parser.parse_args()
+  with open(args.spec) as f:
+    spec = json.load(f)
+  with open(args.output, 'w') as f:
+    f.write(generate_header(spec, args.header_guard))
+
+
+if __name__ == '__main__':
+  main()
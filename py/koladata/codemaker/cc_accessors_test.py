@@ -0,0 +1,82 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for cc_accessors."""
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from koladata.codemaker import cc_accessors
+
+
+def _spec(*attrs, namespace='ns::inner', name='Person'):
+  return {
+      'namespace': namespace,
+      'entities': [{
+          'name': name,
+          'attrs': [{'name': n, 'dtype': d} for n, d in attrs],
+      }],
+  }
+
+
+class CcAccessorsTest(parameterized.TestCase):
+
+  def test_generate_header(self):
+    header = cc_accessors.generate_header(
+        _spec(('age', 'INT32'), ('name', 'TEXT'), ('employer', 'ITEMID')),
+        'PERSON_H_',
+    )
+    self.assertIn('#ifndef PERSON_H_\n#define PERSON_H_\n', header)
+    self.assertIn('namespace ns::inner {\n\nclass Person {\n', header)
+    self.assertIn(
+        'const ::koladata::TypedSliceView<int32_t>& age() const {\n'
+        '      return view_.get<0>();\n',
+        header,
+    )
+    self.assertIn(
+        'const ::koladata::TypedSliceView<::arolla::Text>& name() const {\n'
+        '      return view_.get<1>();\n',
+        header,
+    )
+    self.assertIn(
+        'using View = ::koladata::TypedEntityView<int32_t, ::arolla::Text,'
+        ' ::koladata::internal::ObjectId>;',
+        header,
+    )
+    self.assertIn('"age", "name", "employer"};', header)
+    self.assertTrue(header.endswith('#endif  // PERSON_H_\n'))
+
+  def test_no_namespace(self):
+    header = cc_accessors.generate_header(
+        _spec(('x', 'FLOAT32'), namespace=''), 'H_'
+    )
+    self.assertNotIn('namespace', header)
+
+  @parameterized.parameters(
+      (_spec(('age', 'INT8')), 'unsupported dtype'),
+      (_spec(('1age', 'INT32')), r'not a valid C\+\+ identifier'),
+      (_spec(('size', 'INT32')), 'is reserved'),
+      (_spec(('a', 'INT32'), ('a', 'INT64')), 'duplicate attribute'),
+      (_spec(), 'has no attributes'),
+      (
+          _spec(('a', 'INT32'), namespace='a:b'),
+          r'not a valid C\+\+ namespace',
+      ),
+  )
+  def test_invalid_spec(self, spec, error):
+    with self.assertRaisesRegex(ValueError, error):
+      cc_accessors.generate_header(spec, 'H_')
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -65,11 +65,11 @@ PyObject* PyRegisterExceptionFactory(PyObject* /*module*/, PyObject* factory) {
 
 std::nullptr_t SetKodaPyErrFromStatus(const absl::Status& status) {
   DCHECK(!status.ok());
-  std::optional<absl::Cord> payload = status.GetPayload(internal::kErrorUrl);
-  if (!payload) {
+  std::optional<internal::Error> error = internal::GetErrorPayload(status);
+  if (!error) {
     return arolla::python::SetPyErrFromStatus(status);
   }
-  PyObject* py_exception = CreateKodaException(payload.value());
+  PyObject* py_exception = CreateKodaException(error->SerializePartialAsCord());
   if (Py_IsNone(py_exception)) {
     return arolla::python::SetPyErrFromStatus(
         internal::Annotate(status,
@@ -14,6 +14,9 @@
 
 """Eval utility that handles Arolla expressions with Koda primitives."""
 
+import asyncio
+from concurrent import futures
+import functools
 from typing import Any
 
 from arolla import arolla
@@ -60,5 +63,92 @@ def eval_(
 eval = eval_  # pylint: disable=redefined-builtin
 
 
+async def eval_async(
+    expr: Any,
+    self_input: Any = UNSPECIFIED_SELF_INPUT,
+    /,
+    *,
+    executor: futures.Executor | None = None,
+    **input_values: Any,
+) -> arolla.abc.AnyQValue:
+  """Asynchronous version of `eval`.
+
+  The expression is evaluated on `executor`, or on the default executor of the
+  running event loop when it is None. The GIL is released during the
+  evaluation, so independent evaluations run in parallel, and the event loop
+  keeps processing other tasks while waiting. Cancelling the awaiting task
+  before the evaluation has started skips it.
+
+  Args:
+    expr: Koda expression with inputs from container `I`.
+    self_input: The value for I.self input.
+    executor: The executor to evaluate `expr` on. Note that this means that
+      `I.executor` can not be passed to `eval_async`.
+    **input_values: Values to evaluate `expr` with.
+  """
+  loop = asyncio.get_running_loop()
+  return await loop.run_in_executor(
+      executor, functools.partial(eval_, expr, self_input, **input_values)
+  )
+
+
+async def call_async(
+    fn: Any,
+    *args: Any,
+    executor: futures.Executor | None = None,
+    **kwargs: Any,
+) -> arolla.abc.AnyQValue:
+  """Asynchronous version of `kd.call`.
+
+  The functor is called on `executor`, or on the default executor of the
+  running event loop when it is None, with the GIL released as in
+  `eval_async`.
+
+  Args:
+    fn: The functor to call.
+    *args: The positional arguments of the call.
+    executor: The executor to call `fn` on. Note that this means that a
+      parameter named `executor` can not be passed to `call_async`.
+    **kwargs: The keyword arguments of the call, including `return_type_as`.
+  """
+  loop = asyncio.get_running_loop()
+  return await loop.run_in_executor(
+      executor, functools.partial(fn, *args, **kwargs)
+  )
+
+
+def eval_cache_stats() -> dict[str, Any]:
+  """Returns usage statistics of the Koda expr eval caches.
+
+  The result contains `transformation_cache` and `compilation_cache` dicts
+  (with `capacity`, `size`, `hits`, `misses` and `evictions`) and the
+  cumulative `compilation_time_us` spent compiling on cache misses. The
+  counters are accumulated since the process start or the last call to
+  `reset_eval_cache_stats`.
+  """
+  return _py_expr_eval_py_ext.get_eval_cache_stats()
+
+
+def reset_eval_cache_stats():
+  """Resets the counters returned by `eval_cache_stats`."""
+  _py_expr_eval_py_ext.reset_eval_cache_stats()
+
+
+def set_eval_cache_capacity(
+    transformation_cache_capacity: int, compilation_cache_capacity: int
+):
+  """Sets the maximum number of entries in the expr eval caches.
+
+  Both caches are cleared.
+
+  Args:
+    transformation_cache_capacity: capacity of the expr transformation cache.
+    compilation_cache_capacity: capacity of the expr compilation cache.
+  """
+  _py_expr_eval_py_ext.set_eval_cache_capacity(
+      transformation_cache_capacity, compilation_cache_capacity
+  )
+
+
 # Subscribe eval caches for arolla cleanups.
 arolla.abc.cache_clear_callbacks.add(_py_expr_eval_py_ext.clear_eval_cache)
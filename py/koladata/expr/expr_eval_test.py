@@ -14,6 +14,8 @@
 
 """Tests for expr_eval."""
 
+import asyncio
+from concurrent import futures
 import re
 
 from absl.testing import absltest
@@ -23,6 +25,7 @@ from koladata.expr import input_container
 from koladata.expr import py_expr_eval_py_ext as py_expr_eval
 from koladata.expr import view as _
 from koladata.functions import functions as fns
+from koladata.functor import functor_factories
 from koladata.operators import kde_operators as _
 from koladata.testing import testing
 from koladata.types import data_item
@@ -254,6 +257,67 @@ class ExprEvalTest(absltest.TestCase):
         'Entity(self_not_specified=present)',
     )
 
+  def test_eval_cache_stats(self):
+    arolla.abc.clear_caches()
+    expr_eval.reset_eval_cache_stats()
+    expr = I.x + I.y
+    for _ in range(3):
+      testing.assert_equal(expr_eval.eval(expr, x=1, y=2), ds(3))
+    stats = expr_eval.eval_cache_stats()
+    self.assertEqual(stats['compilation_cache']['misses'], 1)
+    self.assertEqual(stats['compilation_cache']['hits'], 2)
+    self.assertEqual(stats['compilation_cache']['evictions'], 0)
+    self.assertEqual(stats['transformation_cache']['size'], 1)
+    self.assertGreaterEqual(stats['compilation_time_us'], 0)
+
+    expr_eval.reset_eval_cache_stats()
+    stats = expr_eval.eval_cache_stats()
+    self.assertEqual(stats['compilation_cache']['hits'], 0)
+    self.assertEqual(stats['compilation_time_us'], 0)
+
+  def test_eval_async(self):
+    async def run():
+      with futures.ThreadPoolExecutor(max_workers=2) as executor:
+        return await asyncio.gather(
+            expr_eval.eval_async(I.x + I.y, x=1, y=2),
+            expr_eval.eval_async(I.x * I.y, executor=executor, x=3, y=4),
+            expr_eval.eval_async(I.self + 1, ds([1, 2])),
+        )
+
+    results = asyncio.run(run())
+    testing.assert_equal(results[0], ds(3))
+    testing.assert_equal(results[1], ds(12))
+    testing.assert_equal(results[2], ds([2, 3]))
+
+  def test_eval_async_error(self):
+    with self.assertRaisesRegex(ValueError, 'missing inputs'):
+      asyncio.run(expr_eval.eval_async(I.x + I.y, x=1))
+
+  def test_call_async(self):
+    fn = functor_factories.fn(I.x + I.y)
+
+    async def run():
+      with futures.ThreadPoolExecutor(max_workers=2) as executor:
+        return await asyncio.gather(
+            expr_eval.call_async(fn, 1, 2),
+            expr_eval.call_async(fn, executor=executor, x=3, y=4),
+        )
+
+    results = asyncio.run(run())
+    testing.assert_equal(results[0], ds(3))
+    testing.assert_equal(results[1], ds(7))
+
+  def test_set_eval_cache_capacity(self):
+    try:
+      expr_eval.set_eval_cache_capacity(32, 64)
+      stats = expr_eval.eval_cache_stats()
+      self.assertEqual(stats['transformation_cache']['capacity'], 32)
+      self.assertEqual(stats['compilation_cache']['capacity'], 64)
+      with self.assertRaisesRegex(ValueError, 'must be positive'):
+        expr_eval.set_eval_cache_capacity(0, 64)
+    finally:
+      expr_eval.set_eval_cache_capacity(4096, 4096)
+
 
 if __name__ == '__main__':
   absltest.main()
@@ -23,16 +23,20 @@
 #include "absl/base/no_destructor.h"
 #include "absl/base/nullability.h"
 #include "absl/log/check.h"
+#include "absl/status/status.h"
 #include "absl/status/statusor.h"
 #include "koladata/data_slice.h"
 #include "koladata/data_slice_qtype.h"
 #include "koladata/expr/constants.h"
 #include "koladata/expr/expr_eval.h"
+#include "koladata/internal/sharded_lru_cache.h"
 #include "py/arolla/abc/py_expr.h"
+#include "py/arolla/abc/py_operator.h"
 #include "py/arolla/abc/py_qvalue.h"
 #include "py/arolla/abc/py_qvalue_specialization.h"
 #include "py/arolla/py_utils/py_utils.h"
 #include "py/koladata/exceptions/py_exception_utils.h"
+#include "py/koladata/types/boxing.h"
 #include "py/koladata/types/py_utils.h"
 #include "py/koladata/types/wrap_utils.h"
 #include "arolla/qtype/typed_ref.h"
@@ -90,6 +94,78 @@ absl::Nullable<PyObject*> PyEvalExpr(PyObject* /*self*/, PyObject** py_args,
   return arolla::python::WrapAsPyQValue(std::move(result));
 }
 
+namespace {
+
+// Returns true for the Python values that the default Koda boxing policy
+// converts to DataItems.
+bool IsPyScalar(PyObject* py_obj) {
+  return py_obj == Py_None || PyBool_Check(py_obj) || PyLong_Check(py_obj) ||
+         PyFloat_Check(py_obj) || PyUnicode_Check(py_obj) ||
+         PyBytes_Check(py_obj);
+}
+
+}  // namespace
+
+absl::Nullable<PyObject*> PyEvalOp(PyObject* /*self*/, PyObject** py_args,
+                                   Py_ssize_t nargs) {
+  arolla::python::DCheckPyGIL();
+  if (nargs < 1) {
+    return PyErr_Format(PyExc_TypeError, "eval_op() expects an operator");
+  }
+  auto op = arolla::python::UnwrapPyExprOperator(py_args[0]);
+  if (op == nullptr) {
+    PyErr_Clear();
+    return PyErr_Format(PyExc_TypeError,
+                        "eval_op() expects an operator, got op: %s",
+                        Py_TYPE(py_args[0])->tp_name);
+  }
+  // Boxed scalars are kept alive in `boxed_values` while `args` refer to them,
+  // so the vector must not be reallocated.
+  std::vector<arolla::TypedValue> boxed_values;
+  boxed_values.reserve(nargs - 1);
+  std::vector<arolla::TypedRef> args;
+  args.reserve(nargs - 1);
+  for (Py_ssize_t i = 1; i < nargs; ++i) {
+    if (const auto* typed_value = arolla::python::UnwrapPyQValue(py_args[i]);
+        typed_value != nullptr) {
+      args.push_back(typed_value->AsRef());
+      continue;
+    }
+    PyErr_Clear();
+    if (!IsPyScalar(py_args[i])) {
+      Py_RETURN_NOTIMPLEMENTED;
+    }
+    auto ds = DataSliceFromPyValueNoAdoption(py_args[i]);
+    if (!ds.ok()) {
+      Py_RETURN_NOTIMPLEMENTED;
+    }
+    boxed_values.push_back(arolla::TypedValue::FromValue(*std::move(ds)));
+    args.push_back(boxed_values.back().AsRef());
+  }
+
+  absl::StatusOr<koladata::expr::CompiledOp> compiled_op;
+  absl::StatusOr<arolla::TypedValue> result_or_error;
+  {
+    // We leave the Python world here, so we no longer need the GIL.
+    arolla::python::ReleasePyGIL guard;
+    compiled_op = koladata::expr::CompileOpWithCompilationCache(op, args);
+    if (compiled_op.ok()) {
+      result_or_error =
+          koladata::expr::EvalCompiledOp(op, *compiled_op, args);
+    }
+  }
+  if (!compiled_op.ok()) {
+    // The arguments can not be bound to the operator. Nothing was evaluated
+    // yet, so the regular evaluation reports the error with its usual message.
+    Py_RETURN_NOTIMPLEMENTED;
+  }
+  // Same conversion as in the regular evaluation of the operator, so that the
+  // failing operators are not evaluated a second time.
+  ASSIGN_OR_RETURN(auto result, std::move(result_or_error),
+                   arolla::python::SetPyErrFromStatus(_));
+  return arolla::python::WrapAsPyQValue(std::move(result));
+}
+
 PyObject* PyUnspecifiedSelfInput(PyObject* /*self*/, PyObject* /*py_args*/) {
   arolla::python::DCheckPyGIL();
   // We make a copy since WrapPyDataSlice takes ownership.
@@ -106,4 +182,61 @@ PyObject* PyClearEvalCache(PyObject* /*self*/, PyObject* /*py_args*/) {
   Py_RETURN_NONE;
 }
 
+namespace {
+
+PyObject* LruCacheStatsToPyDict(const internal::LruCacheStats& stats) {
+  // NOLINTBEGIN(runtime/int)
+  return Py_BuildValue("{sLsLsLsLsL}", "capacity",
+                       static_cast<long long>(stats.capacity), "size",
+                       static_cast<long long>(stats.size), "hits",
+                       static_cast<long long>(stats.hits), "misses",
+                       static_cast<long long>(stats.misses), "evictions",
+                       static_cast<long long>(stats.evictions));
+  // NOLINTEND(runtime/int)
+}
+
+}  // namespace
+
+PyObject* PyGetEvalCacheStats(PyObject* /*self*/, PyObject* /*py_args*/) {
+  arolla::python::DCheckPyGIL();
+  expr::EvalCacheStats stats = expr::GetEvalCacheStats();
+  auto py_transformation_cache = arolla::python::PyObjectPtr::Own(
+      LruCacheStatsToPyDict(stats.transformation_cache));
+  auto py_compilation_cache = arolla::python::PyObjectPtr::Own(
+      LruCacheStatsToPyDict(stats.compilation_cache));
+  if (py_transformation_cache == nullptr || py_compilation_cache == nullptr) {
+    return nullptr;
+  }
+  return Py_BuildValue("{sOsOsL}", "transformation_cache",
+                       py_transformation_cache.get(), "compilation_cache",
+                       py_compilation_cache.get(), "compilation_time_us",
+                       static_cast<long long>(  // NOLINT(runtime/int)
+                           stats.compilation_time_us));
+}
+
+PyObject* PyResetEvalCacheStats(PyObject* /*self*/, PyObject* /*py_args*/) {
+  arolla::python::DCheckPyGIL();
+  expr::ResetEvalCacheStats();
+  Py_RETURN_NONE;
+}
+
+PyObject* PySetEvalCacheCapacity(PyObject* /*self*/, PyObject* py_args) {
+  arolla::python::DCheckPyGIL();
+  long long transformation_cache_capacity;  // NOLINT(runtime/int)
+  long long compilation_cache_capacity;     // NOLINT(runtime/int)
+  if (!PyArg_ParseTuple(py_args, "LL:set_eval_cache_capacity",
+                        &transformation_cache_capacity,
+                        &compilation_cache_capacity)) {
+    return nullptr;
+  }
+  absl::Status status;
+  {
+    arolla::python::ReleasePyGIL guard;
+    status = expr::SetEvalCacheCapacity(transformation_cache_capacity,
+                                        compilation_cache_capacity);
+  }
+  RETURN_IF_ERROR(status).With(SetKodaPyErrFromStatus);
+  Py_RETURN_NONE;
+}
+
 }  // namespace koladata::python
@@ -25,12 +25,28 @@ namespace koladata::python {
 absl::Nullable<PyObject*> PyEvalExpr(PyObject* /*self*/, PyObject** py_args,
                                      Py_ssize_t nargs, PyObject* py_kwnames);
 
+// Evaluates an operator on positional QValues and Python scalars. Returns
+// NotImplemented if an argument needs another boxing or the arguments can not
+// be bound to the operator, so that the caller can fall back to the regular
+// evaluation. Evaluation errors are raised.
+absl::Nullable<PyObject*> PyEvalOp(PyObject* /*self*/, PyObject** py_args,
+                                   Py_ssize_t nargs);
+
 // Returns the constant representing the unspecified self input.
 PyObject* PyUnspecifiedSelfInput(PyObject* /*self*/, PyObject* /*py_args*/);
 
 // Clears the Koda-specific eval cache.
 PyObject* PyClearEvalCache(PyObject* /*self*/, PyObject* /*py_args*/);
 
+// Returns a dict with the usage statistics of the Koda-specific eval caches.
+PyObject* PyGetEvalCacheStats(PyObject* /*self*/, PyObject* /*py_args*/);
+
+// Resets the usage statistics of the Koda-specific eval caches.
+PyObject* PyResetEvalCacheStats(PyObject* /*self*/, PyObject* /*py_args*/);
+
+// Sets the capacities of the Koda-specific eval caches and clears them.
+PyObject* PySetEvalCacheCapacity(PyObject* /*self*/, PyObject* py_args);
+
 }  // namespace koladata::python
 
 #endif  // THIRD_PARTY_PY_KOLADATA_EXPR_PY_EXPR_EVAL_H_
@@ -24,8 +24,20 @@ constexpr const char* kThisModuleName = "koladata.expr.py_expr_eval";
 PyMethodDef kPyExprEvalModule_methods[] = {
     {"eval_expr", (PyCFunction)PyEvalExpr, METH_FASTCALL | METH_KEYWORDS,
      "Evaluates an expression on provided input QValues."},
+    {"eval_op", (PyCFunction)PyEvalOp, METH_FASTCALL,
+     "eval_op(op, *args)\n--\n\n"
+     "Evaluates an operator on positional QValues and Python scalars, or "
+     "returns NotImplemented if the arguments can not be bound to it."},
     {"clear_eval_cache", PyClearEvalCache, METH_NOARGS,
      "Clears Koda specific eval caches."},
+    {"get_eval_cache_stats", PyGetEvalCacheStats, METH_NOARGS,
+     "Returns usage statistics of Koda specific eval caches."},
+    {"reset_eval_cache_stats", PyResetEvalCacheStats, METH_NOARGS,
+     "Resets usage statistics of Koda specific eval caches."},
+    {"set_eval_cache_capacity", PySetEvalCacheCapacity, METH_VARARGS,
+     "set_eval_cache_capacity(transformation_cache_capacity, "
+     "compilation_cache_capacity)\n--\n\n"
+     "Sets capacities of Koda specific eval caches and clears them."},
     {"unspecified_self_input", (PyCFunction)PyUnspecifiedSelfInput, METH_NOARGS,
      "Returns the constant representing the unspecified self input."},
     {nullptr} /* sentinel */
@@ -590,7 +590,9 @@ class DataSliceViewTest(parameterized.TestCase):
         'fork_db',
         'freeze',
         'from_vals',
+        'get_attrs',
         'internal_as_py',
+        'internal_as_py_iter',
         'internal_register_reserved_class_method_name',
         'is_mutable',
         'qtype',
@@ -47,6 +47,62 @@ def ds_from_np(arr: np.ndarray) -> data_slice.DataSlice:
     return data_slice.DataSlice.from_vals(arolla.dense_array(arr))
 
 
+def ds_to_np_with_mask(
+    ds: data_slice.DataSlice,
+) -> tuple[np.ndarray, np.ndarray]:
+  """Converts a DataSlice of primitives to numpy values and presence mask.
+
+  Unlike `ds_to_np`, missing items are not lost: the values array has the
+  default value of the dtype in the missing positions and the boolean mask
+  array tells which items are present. Both arrays are built from the
+  underlying dense arrays, without boxing the items as Python objects.
+
+  Args:
+    ds: DataSlice with a primitive schema.
+
+  Returns:
+    A tuple of (values, mask) numpy arrays of the same size as `ds`.
+  """
+  if not ds.get_schema().is_primitive_schema():
+    raise ValueError(
+        'ds_to_np_with_mask supports only primitive schemas, got'
+        f' {ds.get_schema()}'
+    )
+  ds = ds.flatten()
+  values = numpy_conversion.as_numpy_array(ds.as_dense_array())
+  mask = numpy_conversion.as_numpy_array(
+      kdi.cond(kdi.has(ds), True, False).as_dense_array()
+  )
+  return values, mask
+
+
+def ds_from_np_with_mask(
+    values: np.ndarray, mask: np.ndarray
+) -> data_slice.DataSlice:
+  """Converts numpy values and presence mask to a DataSlice.
+
+  Inverse of `ds_to_np_with_mask`: items where `mask` is False are missing in
+  the result.
+
+  Args:
+    values: one-dimensional numpy array of primitives.
+    mask: boolean numpy array of the same shape as `values`.
+
+  Returns:
+    A one-dimensional DataSlice.
+  """
+  if values.shape != mask.shape:
+    raise ValueError(
+        'values and mask must have the same shape, got'
+        f' {values.shape} and {mask.shape}'
+    )
+  ds = ds_from_np(values)
+  presence = data_slice.DataSlice.from_vals(
+      arolla.dense_array_boolean(mask.astype(np.bool_))
+  )
+  return kdi.apply_mask(ds, kdi.equal(presence, True))
+
+
 _TO_INT64_EXPR = arolla.M.core.to_int64(arolla.L.x)
 
 
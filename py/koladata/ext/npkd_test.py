@@ -130,6 +130,26 @@ class NpkdTest(parameterized.TestCase):
       self.assertEqual(res_np[0], True)
       self.assertEqual(res_np[1], False)
 
+  def test_with_mask_roundtrip(self):
+    for ds in (
+        kd.slice([1, None, 3]),
+        kd.slice([1.5, None, None, 2.0]),
+        kd.slice([True, None, False]),
+        kd.slice([1, 2, 3], dtype=schema_constants.INT64),
+    ):
+      with self.subTest(str(ds.get_schema())):
+        values, mask = npkd.ds_to_np_with_mask(ds)
+        np.testing.assert_array_equal(
+            mask, [x is not None for x in ds.internal_as_py()]
+        )
+        testing.assert_equal(npkd.ds_from_np_with_mask(values, mask), ds)
+
+  def test_with_mask_errors(self):
+    with self.assertRaisesRegex(ValueError, 'only primitive schemas'):
+      npkd.ds_to_np_with_mask(kd.obj(x=kd.slice([1, 2])))
+    with self.assertRaisesRegex(ValueError, 'same shape'):
+      npkd.ds_from_np_with_mask(np.array([1, 2]), np.array([True]))
+
   def test_reshape_based_on_indices(self):
     with self.subTest('1d'):
       indices = [np.array([0, 1, 2])]
@@ -20,11 +20,28 @@ from arolla import arolla
 from koladata import kd
 from koladata.ext import npkd
 from koladata.types import data_slice
+import numpy as np
 import pandas as pd
 
 kdi = kd.kdi
 
 
+def _column_to_ds(column: pd.Series) -> data_slice.DataSlice:
+  """Converts a DataFrame column to a one-dimensional DataSlice."""
+  dtype = column.dtype
+  # Nullable numeric and boolean extension dtypes (e.g. Int64, boolean or
+  # Arrow-backed ones) are converted as a values buffer and a presence mask,
+  # rather than as an object array of boxed values with pd.NA.
+  if isinstance(dtype, pd.api.extensions.ExtensionDtype) and dtype.kind in (
+      'biuf'
+  ):
+    numpy_dtype = np.dtype(dtype.numpy_dtype)
+    values = column.to_numpy(dtype=numpy_dtype, na_value=numpy_dtype.type(0))
+    mask = ~column.isna().to_numpy(dtype=np.bool_)
+    return npkd.ds_from_np_with_mask(values, mask)
+  return npkd.ds_from_np(column.to_numpy())
+
+
 def from_dataframe(
     df: pd.DataFrame, as_obj: bool = False
 ) -> data_slice.DataSlice:
@@ -33,6 +50,8 @@ def from_dataframe(
   The DataFrame must have at least one column. It will be converted to a
   DataSlice of entities/objects with attributes corresponding to the DataFrame
   columns. Supported column dtypes include all primitive dtypes and ItemId.
+  Missing values in nullable numeric and boolean columns (e.g. with `Int64`
+  or `boolean` dtype) become missing items.
 
   If the DataFrame has MultiIndex, it will be converted to a DataSlice with
   the shape derived from the MultiIndex.
@@ -47,7 +66,7 @@ def from_dataframe(
   Returns:
     DataSlice of items with attributes from DataFrame columns.
   """
-  kwargs = {c: npkd.ds_from_np(df[c].to_numpy()) for c in df.columns}
+  kwargs = {c: _column_to_ds(df[c]) for c in df.columns}
 
   if not kwargs:
     raise ValueError('DataFrame has no columns.')
@@ -158,6 +177,19 @@ def to_dataframe(
     cols.extend(_get_column_names(ds))
     get_attr_fn = kdi.maybe
 
+  # Plain attribute columns are fetched in a single batch, so that the DataBag
+  # and its fallbacks are traversed once.
+  attr_cols = [
+      col
+      for col in cols
+      if isinstance(col, str)
+      and col not in _SPECIAL_COLUMN_NAMES
+      and col != 'self_'
+  ]
+  attr_dss = {}
+  if get_attr_fn is kdi.get_attr and attr_cols:
+    attr_dss = dict(zip(attr_cols, ds.get_attrs(*attr_cols)))
+
   col_dss = []
   col_names = []
   for col in cols:
@@ -167,7 +199,9 @@ def to_dataframe(
       if col == 'self_':
         col_dss.append(ds)
       else:
-        col_dss.append(get_attr_fn(ds, col))
+        col_dss.append(
+            attr_dss[col] if col in attr_dss else get_attr_fn(ds, col)
+        )
       col_names.append(col)
     elif isinstance(col, arolla.Expr):
       try:
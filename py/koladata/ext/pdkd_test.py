@@ -78,6 +78,24 @@ class NpkdTest(parameterized.TestCase):
           ds.x, kd.slice([1, 2, 3], dtype=schema_constants.INT64).with_db(ds.db)
       )
 
+    with self.subTest('nullable dtypes'):
+      df = pd.DataFrame({
+          'x': pd.array([1, None, 3], dtype='Int64'),
+          'y': pd.array([True, None, False], dtype='boolean'),
+          'z': pd.array([None, 2.5, None], dtype='Float32'),
+      })
+      ds = pdkd.from_dataframe(df)
+      testing.assert_equal(
+          ds.x,
+          kd.slice([1, None, 3], dtype=schema_constants.INT64).with_db(ds.db),
+      )
+      testing.assert_equal(
+          ds.y, kd.slice([True, None, False]).with_db(ds.db)
+      )
+      testing.assert_equal(
+          ds.z, kd.slice([None, 2.5, None]).with_db(ds.db)
+      )
+
     with self.subTest('empty df'):
       with self.assertRaisesRegex(ValueError, 'DataFrame has no columns'):
         _ = pdkd.from_dataframe(pd.DataFrame())
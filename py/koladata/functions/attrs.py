@@ -14,10 +14,12 @@
 
 """Koda functions for modifying Object / Entity attributes."""
 
-from typing import Any
+import contextlib
+from typing import Any, Iterator
 
 from koladata.types import data_item as _  # pylint: disable=unused-import
 from koladata.types import data_slice
+from koladata.types import py_misc_py_ext as _py_misc_py_ext
 from koladata.types import schema_constants
 
 
@@ -116,3 +118,27 @@ def set_attrs(
       adoption.
   """
   x.set_attrs(**attrs, update_schema=update_schema)
+
+
+@contextlib.contextmanager
+def trusted_mode(enabled: bool = True) -> Iterator[None]:
+  """A context manager that enables (or disables) trusted mode of set_attr.
+
+  In trusted mode, assigning attributes (x.set_attr, x.some_attr = ...,
+  kd.set_attrs and the like) assumes that the values already have the schemas
+  stored for the attributes of explicit schemas: the stored schemas are
+  neither looked up nor validated and no casting takes place. The attributes
+  of implicit (OBJECT) schemas are still updated. Meant for bulk writes of
+  data validated upstream; assigning values with other schemas in trusted mode
+  leaves the DataBag inconsistent.
+
+  The mode applies to the current thread only.
+
+  Args:
+    enabled: whether to enable or disable trusted mode within the context.
+  """
+  previous = _py_misc_py_ext.set_trusted_mode(enabled)
+  try:
+    yield
+  finally:
+    _py_misc_py_ext.set_trusted_mode(previous)
@@ -295,6 +295,21 @@ class FromPyTest(absltest.TestCase):
     testing.assert_equal(nested.S[0].x.no_db(), ds('a'))
     testing.assert_equal(nested.S[1].x.no_db(), ds('b'))
 
+  def test_list_of_different_dataclasses(self):
+    obj = fns.from_py([
+        NestedKlass('a'),
+        TestKlassInternals(1, 2.0),
+        NestedKlass('b'),
+        TestKlassInternals(3, 4.0),
+    ])
+    nested = obj[:]
+    testing.assert_equal(nested.S[0].x.no_db(), ds('a'))
+    testing.assert_equal(nested.S[1].a.no_db(), ds(1))
+    testing.assert_equal(nested.S[1].b.no_db(), ds(2.0))
+    testing.assert_equal(nested.S[2].x.no_db(), ds('b'))
+    testing.assert_equal(nested.S[3].a.no_db(), ds(3))
+    self.assertCountEqual(dir(nested.S[3]), ['a', 'b'])
+
   def test_dataclass_with_list(self):
     @dataclasses.dataclass
     class Test:
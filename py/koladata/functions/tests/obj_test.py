@@ -284,6 +284,19 @@ class ObjTest(absltest.TestCase):
     testing.assert_equal(obj[:][:].get_schema().no_db(), schema_constants.INT32)
     testing.assert_equal(obj[:][:].no_db(), ds([[1, 2], [3]]))
 
+  def test_universal_converter_primitive_leaves(self):
+    obj = fns.obj({'a': [1, None, 2.5], 'b': {1: 'x', 'y': None}, 'c': ()})
+    testing.assert_equal(
+        obj['a'][:].no_db(), ds([1.0, None, 2.5], schema_constants.FLOAT32)
+    )
+    testing.assert_dicts_keys_equal(
+        obj['b'], ds([1, 'y'], schema_constants.OBJECT)
+    )
+    testing.assert_equal(
+        obj['b'][ds([1, 'y'])].no_db(), ds(['x', None], schema_constants.TEXT)
+    )
+    testing.assert_equal(obj['c'][:].no_db(), ds([]))
+
   def test_universal_converter_container_contains_multi_dim_data_slice(self):
     with self.assertRaisesRegex(
         ValueError, 'dict / list containing multi-dim DataSlice'
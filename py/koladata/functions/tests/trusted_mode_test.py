@@ -0,0 +1,81 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+"""Tests for trusted_mode."""
+
+import threading
+
+from absl.testing import absltest
+from koladata.functions import functions as fns
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import py_misc_py_ext
+from koladata.types import schema_constants
+
+ds = data_slice.DataSlice.from_vals
+
+
+def _is_trusted_mode():
+  previous = py_misc_py_ext.set_trusted_mode(False)
+  py_misc_py_ext.set_trusted_mode(previous)
+  return previous
+
+
+class TrustedModeTest(absltest.TestCase):
+
+  def test_set_attr(self):
+    x = fns.new(a=ds([1, 2, 3]))
+    o = fns.obj(a=ds([1, 2, 3]))
+    with fns.trusted_mode():
+      x.a = ds([4, 5, 6])
+      fns.set_attr(x, 'b', ds(['a', 'b', 'c']), update_schema=True)
+      # Implicit schemas are still updated.
+      o.a = ds([1.5, 2.5, 3.5])
+    testing.assert_equal(x.a.no_db(), ds([4, 5, 6]))
+    testing.assert_equal(x.b.no_db(), ds(['a', 'b', 'c']))
+    testing.assert_equal(
+        o.a.no_db(), ds([1.5, 2.5, 3.5], schema_constants.FLOAT32)
+    )
+
+  def test_scope(self):
+    self.assertFalse(_is_trusted_mode())
+    with fns.trusted_mode():
+      self.assertTrue(_is_trusted_mode())
+      with fns.trusted_mode(False):
+        self.assertFalse(_is_trusted_mode())
+      self.assertTrue(_is_trusted_mode())
+    self.assertFalse(_is_trusted_mode())
+
+    with self.assertRaises(ValueError):
+      with fns.trusted_mode():
+        raise ValueError()
+    self.assertFalse(_is_trusted_mode())
+
+  def test_per_thread(self):
+    results = []
+    with fns.trusted_mode():
+      thread = threading.Thread(
+          target=lambda: results.append(_is_trusted_mode())
+      )
+      thread.start()
+      thread.join()
+    self.assertEqual(results, [False])
+
+  def test_not_bool(self):
+    with self.assertRaisesRegex(TypeError, 'expected a bool'):
+      with fns.trusted_mode(1):
+        pass
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -181,7 +181,11 @@ def is_fn(obj: Any) -> data_slice.DataSlice:
 
 
 def trace_py_fn(
-    f: Callable[..., Any], *, auto_variables: bool = True, **defaults: Any
+    f: Callable[..., Any],
+    *,
+    auto_variables: bool = True,
+    precompile: bool = False,
+    **defaults: Any,
 ) -> data_slice.DataSlice:
   """Returns a Koda functor created by tracing a given Python function.
 
@@ -197,6 +201,11 @@ def trace_py_fn(
       variables, and all named subexpressions become their own variables. This
       helps readability and manipulation of the resulting functor. Note that
       this defaults to True here, while it defaults to False in kdf.fn.
+    precompile: When true, the functor is frozen and compiled for DataSlice
+      arguments right away, so that the first call does not pay for the
+      compilation. Calls of a frozen functor evaluate all its variables as a
+      single compiled expression. Calls with other argument types are compiled
+      on first use.
     **defaults: Keyword defaults to bind to the function. The values in this map
       may be Koda expressions or DataItems (see docstring for kdf.bind for more
       details). Defaults can be overridden through kd.call arguments. **defaults
@@ -210,7 +219,12 @@ def trace_py_fn(
   traced_expr = tracing.trace(f)
   signature = signature_utils.from_py_signature(inspect.signature(f))
   f = fn(traced_expr, signature=signature, auto_variables=auto_variables)
-  return bind(f, **defaults) if defaults else f
+  if defaults:
+    f = bind(f, **defaults)
+  if precompile:
+    f = f.freeze()
+    _py_functors_py_ext.precompile_fn(f)
+  return f
 
 
 def py_fn(
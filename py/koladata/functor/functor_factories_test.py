@@ -256,6 +256,18 @@ class FunctorFactoriesTest(absltest.TestCase):
     fn = functor_factories.trace_py_fn(lambda x, y, **unused: x + y, y=2 * I.z)
     testing.assert_equal(fn(x=2, z=3), ds(8))
 
+  def test_trace_py_fn_precompile(self):
+    fn = functor_factories.trace_py_fn(lambda x, y: x + y, precompile=True)
+    self.assertFalse(fn.db.is_mutable())
+    testing.assert_equal(fn(x=1, y=2), ds(3))
+    testing.assert_equal(fn(ds([1, 2]), ds([3, 4])), ds([4, 6]))
+
+    fn = functor_factories.trace_py_fn(
+        lambda x, y, **unused: x + y, precompile=True, y=2 * I.z
+    )
+    self.assertFalse(fn.db.is_mutable())
+    testing.assert_equal(fn(x=2, z=3), ds(8))
+
   def test_py_fn_simple(self):
     def f(x, y):
       return x + y
@@ -23,9 +23,11 @@
 
 #include "absl/base/no_destructor.h"
 #include "absl/base/nullability.h"
+#include "absl/status/status.h"
 #include "absl/strings/str_format.h"
 #include "koladata/data_slice.h"
 #include "koladata/data_slice_qtype.h"
+#include "koladata/functor/call.h"
 #include "koladata/functor/functor.h"
 #include "koladata/functor/signature_storage.h"
 #include "py/arolla/py_utils/py_utils.h"
@@ -142,4 +144,21 @@ absl::Nullable<PyObject*> PyIsFn(PyObject* /*self*/, PyObject* fn) {
   }
 }
 
+absl::Nullable<PyObject*> PyPrecompileFn(PyObject* /*self*/, PyObject* fn) {
+  arolla::python::DCheckPyGIL();
+  const auto* unwrapped_fn = UnwrapDataSlice(fn, "fn");
+  if (unwrapped_fn == nullptr) {
+    return nullptr;
+  }
+  absl::Status status;
+  {
+    arolla::python::ReleasePyGIL guard;
+    status = functor::PrecompileFunctor(*unwrapped_fn);
+  }
+  if (!status.ok()) {
+    return koladata::python::SetKodaPyErrFromStatus(status);
+  }
+  Py_RETURN_NONE;
+}
+
 }  // namespace koladata::python
@@ -42,6 +42,8 @@ PyMethodDef kPyFunctorsModule_methods[] = {
      METH_FASTCALL | METH_KEYWORDS, "Creates a new functor."},
     {"is_fn", PyIsFn, METH_O,
      "Checks if a given DataSlice represents a functor."},
+    {"precompile_fn", PyPrecompileFn, METH_O,
+     "Compiles a functor for calls with DataSlice arguments."},
     {nullptr} /* sentinel */
 };
 
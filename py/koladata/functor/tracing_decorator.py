@@ -55,6 +55,7 @@ class TraceAsFnDecorator:
       *,
       name: str | None = None,
       py_fn: bool = False,
+      precompile: bool = False,
   ):
     """Initializes the decorator.
 
@@ -65,16 +66,24 @@ class TraceAsFnDecorator:
         and executed as Python code later instead of being traced to create the
         sub-functor. This is useful for functions that are not fully supported
         by the tracing infrastructure, and to add debug prints.
+      precompile: Whether the sub-functor should be frozen and compiled for
+        DataSlice arguments at decoration time (see kdf.trace_py_fn). The
+        compiled sub-functor is used as is when the outer function is traced
+        with auto_variables=False; auto_variables=True copies it into the
+        DataBag of the outer functor. Can not be combined with py_fn=True.
     """
+    if py_fn and precompile:
+      raise ValueError('py_fn=True can not be combined with precompile=True')
     self._name = name
     self._py_fn = py_fn
+    self._precompile = precompile
 
   def __call__(self, fn: py_types.FunctionType) -> py_types.FunctionType:
     name = self._name if self._name is not None else fn.__name__
     if self._py_fn:
       to_call = functor_factories.py_fn(fn)
     else:
-      to_call = functor_factories.trace_py_fn(fn)
+      to_call = functor_factories.trace_py_fn(fn, precompile=self._precompile)
     # It is important to create this expr once per function, so that its
     # fingerprint is stable and when we call it multiple times the functor
     # will only be extracted once by the auto-variables logic.
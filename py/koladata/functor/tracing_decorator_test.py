@@ -47,6 +47,25 @@ class TracingDecoratorTest(absltest.TestCase):
     # Make sure tracing actually happened for the contents of f.
     testing.assert_equal(introspection.unpack_expr(fn.f.returns), I.x + 1)
 
+  def test_precompile(self):
+    @tracing_decorator.TraceAsFnDecorator(precompile=True)
+    def f(x):
+      return x + 1
+
+    self.assertEqual(f(x=1), 2)
+    outer_fn = lambda x: f(x=x + 2)
+    fn = functor_factories.trace_py_fn(outer_fn, auto_variables=False)
+    testing.assert_equal(fn(x=1), ds(4))
+    fn = functor_factories.trace_py_fn(outer_fn)
+    testing.assert_equal(fn(x=1), ds(4))
+    testing.assert_equal(fn.f(x=1), ds(2))
+
+  def test_precompile_py_fn(self):
+    with self.assertRaisesRegex(
+        ValueError, 'py_fn=True can not be combined with precompile=True'
+    ):
+      tracing_decorator.TraceAsFnDecorator(py_fn=True, precompile=True)
+
   def test_two_lambdas(self):
     f1 = tracing_decorator.TraceAsFnDecorator()(lambda x: x + 1)
     f2 = tracing_decorator.TraceAsFnDecorator()(lambda x: x * 2)
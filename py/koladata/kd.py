@@ -121,6 +121,8 @@ I = _eager_only(_input_container.InputContainer('I'))
 V = _eager_only(_input_container.InputContainer('V'))
 S = _eager_only(I.self)
 eval = _eager_only(_expr_eval.eval)  # pylint: disable=redefined-builtin
+eval_async = _eager_only(_expr_eval.eval_async)
+call_async = _eager_only(_expr_eval.call_async)
 kde = _eager_only(_kde_operators.kde)
 literal = _eager_only(_literal_operator.literal)
 get_name = _eager_only(_introspection.get_name)
@@ -203,6 +203,33 @@ def _concat_or_stack(stack, ndim, *args):  # pylint: disable=unused-argument,red
   raise NotImplementedError('implemented in the backend')
 
 
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.core._eval_custom_kernel',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.kernel_name),
+        qtype_utils.expect_data_slice_args(P.args),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _eval_custom_kernel(kernel_name, *args):  # pylint: disable=unused-argument
+  """Evaluates the C++ custom kernel registered as `kernel_name` on `args`.
+
+  Kernels are registered from C++ with `koladata::ops::RegisterCustomKernel`,
+  see koladata/operators/custom_kernels.h. The kernel aligns the shapes of
+  `args`, dispatches on the dtypes of their values and infers the schema of
+  the result.
+
+  Args:
+    kernel_name: Name of the kernel, a TEXT DataItem.
+    *args: Inputs of the kernel.
+
+  Returns:
+    The result of the kernel.
+  """
+  raise NotImplementedError('implemented in the backend')
+
+
 @optools.add_to_registry(aliases=['kde.concat'])
 @optools.as_lambda_operator(
     'kde.core.concat',
@@ -627,6 +654,29 @@ def _get_attr_with_default(obj, attr_name, default):  # pylint: disable=unused-a
   raise NotImplementedError('implemented in the backend')
 
 
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.core._get_attrs',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.obj),
+        qtype_utils.expect_data_slice_args(P.attr_names),
+    ],
+    qtype_inference_expr=arolla.M.qtype.make_tuple_qtype(
+        arolla.M.seq.map(
+            arolla.LambdaOperator('_', qtypes.DATA_SLICE),
+            arolla.M.qtype.get_field_qtypes(P.attr_names),
+        ),
+    ),
+)
+def _get_attrs(obj, *attr_names):  # pylint: disable=unused-argument
+  """Gets several attributes from a DataSlice at once, as a tuple.
+
+  kd.eval rewrites sibling kde.core.get_attr calls on the same object into this
+  operator, see koladata/expr/expr_eval.cc.
+  """
+  raise NotImplementedError('implemented in the backend')
+
+
 @optools.add_to_registry(aliases=['kde.get_attr'], repr_fn=op_repr.getattr_repr)
 @optools.as_lambda_operator(
     'kde.core.get_attr',
@@ -1035,6 +1085,67 @@ def agg_count(x, ndim=arolla.unspecified()):
   )
 
 
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.core._agg_approx_count_distinct',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.precision),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _agg_approx_count_distinct(x, precision):  # pylint: disable=unused-argument
+  raise NotImplementedError('implemented in the backend')
+
+
+@optools.add_to_registry(aliases=['kde.agg_approx_count_distinct'])
+@optools.as_lambda_operator(
+    'kde.core.agg_approx_count_distinct',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice_or_unspecified(P.ndim),
+        qtype_utils.expect_data_slice(P.precision),
+    ],
+)
+def agg_approx_count_distinct(
+    x,
+    ndim=arolla.unspecified(),
+    precision=data_slice.DataSlice.from_vals(14),
+):
+  """Returns approximate counts of distinct items over the last ndim dimensions.
+
+  The counts are estimated with HyperLogLog sketches in a single pass and with
+  2^precision bytes of memory per sketch, instead of materializing the unique
+  items as kd.agg_count(kd.unique(...)) does. The relative standard error is
+  about 1.04 / sqrt(2^precision), i.e. ~0.8% for the default precision 14.
+  Groups with at most 2^precision / 4 items are counted exactly.
+
+  Items are distinct if they have different values or types, e.g. INT32 1 and
+  INT64 1 are counted twice. Missing items are ignored.
+
+  The resulting slice has `rank = rank - ndim` and shape: `shape =
+  shape[:-ndim]`.
+
+  Example:
+    ds = kd.slice([[1, 2, 1], [3, None, 3], [None, None]])
+    kd.agg_approx_count_distinct(ds)  # -> kd.slice([2, 1, 0])
+    kd.agg_approx_count_distinct(ds, ndim=2)  # -> kd.slice(3)
+
+  Args:
+    x: A DataSlice.
+    ndim: The number of dimensions to aggregate over. Requires 0 <= ndim <=
+      rank(x).
+    precision: The number of bits of the hashes that select the sketch
+      register, an integer in [4, 18].
+
+  Returns:
+    An INT64 DataSlice of approximate distinct counts.
+  """
+  return _agg_approx_count_distinct(
+      jagged_shape_ops.flatten_last_ndim(x, ndim), precision
+  )
+
+
 @optools.add_to_registry(aliases=['kde.cum_count'])
 @optools.as_lambda_operator(
     'kde.core.cum_count',
@@ -2115,6 +2226,27 @@ def itemid_bits(ds, last):  # pylint: disable=unused-argument
   raise NotImplementedError('implemented in the backend')
 
 
+@optools.add_to_registry(aliases=['kde.itemid_hash'])
+@optools.as_backend_operator(
+    'kde.core.itemid_hash',
+    qtype_constraints=[qtype_utils.expect_data_slice(P.ds)],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def itemid_hash(ds):  # pylint: disable=unused-argument
+  """Returns a 64-bit hash of the item ids in `ds` as INT64.
+
+  The hash doesn't depend on the process, so it can be used to partition items
+  between shards, e.g. `kd.itemid_hash(ds) % num_shards`.
+
+  Args:
+    ds: DataSlice of item ids.
+
+  Returns:
+    INT64 DataSlice of the same shape as `ds`.
+  """
+  raise NotImplementedError('implemented in the backend')
+
+
 @arolla.optools.add_to_registry()
 @arolla.optools.as_backend_operator(
     'kde.core._ordinal_rank',
@@ -2264,6 +2396,205 @@ def dense_rank(
   return jagged_shape_ops.reshape(res, jagged_shape_ops.get_shape(x))
 
 
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.core._top_k_indices',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.k),
+        qtype_utils.expect_data_slice(P.descending),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _top_k_indices(x, k, descending):  # pylint: disable=unused-argument
+  raise NotImplementedError('implemented in the backend')
+
+
+@optools.add_to_registry(aliases=['kde.top_k_indices'])
+@optools.as_lambda_operator(
+    'kde.core.top_k_indices',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.k),
+        qtype_utils.expect_data_slice(P.descending),
+    ],
+)
+def top_k_indices(x, k, descending=data_slice.DataSlice.from_vals(True)):
+  """Returns the positions of the top `k` items of `x` over the last dimension.
+
+  The result has the same dimensions as `x` except the last one, which holds
+  the INT64 positions of the `k` largest (or smallest if descending=False)
+  present items of each group, ordered from the top. Groups with fewer than
+  `k` present items keep all of them. The items are ordered as in
+  kd.ordinal_rank, i.e. ties are resolved by position and NaN values are the
+  last.
+
+  Equivalent to sorting the positions of each group by ordinal rank and
+  keeping those with rank < k, but numeric groups are not sorted completely.
+
+  Example:
+    ds = kd.slice([[4, 3, None, 6], [2, None, 5, 1]])
+    kd.top_k_indices(ds, 2) -> kd.slice([[3, 0], [2, 0]])
+    kd.top_k_indices(ds, 2, descending=False) -> kd.slice([[1, 0], [3, 0]])
+    kd.top_k_indices(ds, kd.slice([1, 3])) -> kd.slice([[3], [2, 0, 3]])
+
+  Args:
+    x: DataSlice to select from.
+    k: The number of items to select from each group. Either an integer or a
+      DataSlice broadcastable to `x.get_shape()[:-1]`. Missing `k` selects no
+      items.
+    descending: If true (default), the largest items are selected.
+
+  Returns:
+    An INT64 DataSlice of positions in the last dimension of `x`.
+  """
+  return _top_k_indices(x, k, descending)
+
+
+@optools.add_to_registry(aliases=['kde.top_k'])
+@optools.as_lambda_operator(
+    'kde.core.top_k',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.k),
+        qtype_utils.expect_data_slice(P.descending),
+    ],
+)
+def top_k(x, k, descending=data_slice.DataSlice.from_vals(True)):
+  """Returns the top `k` items of `x` over the last dimension.
+
+  Same as kd.at(x, kd.top_k_indices(x, k, descending)), see
+  kd.top_k_indices.
+
+  Example:
+    ds = kd.slice([[4, 3, None, 6], [2, None, 5, 1]])
+    kd.top_k(ds, 2) -> kd.slice([[6, 4], [5, 2]])
+    kd.top_k(ds, 2, descending=False) -> kd.slice([[3, 4], [1, 2]])
+
+  Args:
+    x: DataSlice to select from.
+    k: The number of items to select from each group. Either an integer or a
+      DataSlice broadcastable to `x.get_shape()[:-1]`.
+    descending: If true (default), the largest items are selected.
+
+  Returns:
+    A DataSlice with the top items of each group of `x`.
+  """
+  return at(x, _top_k_indices(x, k, descending))
+
+
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.core._join_indices',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.left_keys),
+        qtype_utils.expect_data_slice(P.right_keys),
+        qtype_utils.expect_data_slice(P.left_join),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _join_indices(left_keys, right_keys, left_join):  # pylint: disable=unused-argument
+  raise NotImplementedError('implemented in the backend')
+
+
+@optools.add_to_registry(aliases=['kde.join_indices'])
+@optools.as_lambda_operator(
+    'kde.core.join_indices',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.left_keys),
+        qtype_utils.expect_data_slice(P.right_keys),
+        qtype_utils.expect_data_slice(P.left_join),
+    ],
+)
+def join_indices(
+    left_keys, right_keys, left_join=data_slice.DataSlice.from_vals(False)
+):
+  """Returns the positions in `right_keys` of the items equal to `left_keys`.
+
+  The result has the dimensions of `left_keys` and a new last dimension, which
+  holds the INT64 positions of the matching items of the flattened
+  `right_keys` in increasing order. Items are matched by equality of their
+  values and types (e.g. INT32 1 does not match INT64 1), and missing items
+  never match.
+
+  Items of `left_keys` without matches get an empty group for an inner join
+  (default) and a single missing position for a left join.
+
+  The hash table is built on the smaller side and probed in parallel, which is
+  faster than building a dict on `right_keys` and looking the keys up.
+
+  Example:
+    left = kd.slice([[1, 2], [3]])
+    right = kd.slice([2, 1, 4, 1])
+    kd.join_indices(left, right) -> kd.slice([[[1, 3], [0]], [[]]])
+    kd.join_indices(left, right, left_join=True)
+      -> kd.slice([[[1, 3], [0]], [[None]]])
+
+  Args:
+    left_keys: DataSlice of keys to look up.
+    right_keys: DataSlice of keys to look them up in.
+    left_join: If true, the items of `left_keys` without matches are kept.
+
+  Returns:
+    An INT64 DataSlice of positions in the flattened `right_keys`.
+  """
+  return _join_indices(left_keys, right_keys, left_join)
+
+
+@optools.add_to_registry(aliases=['kde.join'])
+@optools.as_lambda_operator(
+    'kde.core.join',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.left_keys),
+        qtype_utils.expect_data_slice(P.right_keys),
+        qtype_utils.expect_data_slice(P.right_values),
+        qtype_utils.expect_data_slice(P.left_join),
+    ],
+)
+def join(
+    left_keys,
+    right_keys,
+    right_values,
+    left_join=data_slice.DataSlice.from_vals(False),
+):
+  """Returns the items of `right_values` whose keys match `left_keys`.
+
+  Same as kd.at(kd.flatten(right_values), kd.join_indices(left_keys,
+  right_keys, left_join)), see kd.join_indices. `right_values` must have the
+  same shape as `right_keys`, e.g. the entities the keys are attributes of.
+
+  Example:
+    users = kd.new(id=kd.slice([1, 2, 3]), name=kd.slice(['a', 'b', 'c']))
+    orders = kd.new(user_id=kd.slice([2, 1, 5]))
+    kd.join(orders.user_id, users.id, users).name
+      -> kd.slice([['b'], ['a'], []])
+
+  Args:
+    left_keys: DataSlice of keys to look up.
+    right_keys: DataSlice of keys to look them up in.
+    right_values: DataSlice with the same shape as `right_keys`.
+    left_join: If true, the items of `left_keys` without matches are kept as
+      missing items.
+
+  Returns:
+    A DataSlice with the dimensions of `left_keys` and a new last dimension
+    holding the matching items of `right_values`.
+  """
+  return at(
+      jagged_shape_ops.flatten(
+          assertion.with_assertion(
+              right_values,
+              M.jagged.equal(
+                  jagged_shape_ops.get_shape(right_values),
+                  jagged_shape_ops.get_shape(right_keys),
+              ),
+              "'right_values' and 'right_keys' must have the same shape.",
+          )
+      ),
+      _join_indices(left_keys, right_keys, left_join),
+  )
+
+
 @optools.add_to_registry()
 @optools.as_backend_operator(
     'kde.core._inverse_mapping',
@@ -2771,6 +3102,91 @@ def translate(keys_to, keys_from, values_from):  # pylint: disable=unused-argume
   raise NotImplementedError('implemented in the backend')
 
 
+@optools.add_to_registry(aliases=['kde.lookup_by_attr'])
+@optools.as_backend_operator(
+    'kde.core.lookup_by_attr',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.attr_name),
+        qtype_utils.expect_data_slice(P.value),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def lookup_by_attr(x, attr_name, value):  # pylint: disable=unused-argument
+  """Returns the items of `x` whose attribute `attr_name` is equal to `value`.
+
+  The result is a 1-dimensional DataSlice with the matching items of `x`
+  (flattened) in their original order. It is equivalent to
+  `kd.select(x.flatten(), x.flatten().get_attr(attr_name) == value)`, except
+  that values of different types never match (e.g. INT32 1 and INT64 1).
+
+  If the DataBag of `x` and all its fallbacks are immutable (e.g. after
+  `x.freeze()`), an index of the attribute values is built on the first call
+  and reused by the following calls with the same `x`, so that they take time
+  proportional to the number of matches.
+
+  Example:
+    items = kd.obj(category=kd.slice(['a', 'b', 'a'])).freeze()
+    kd.lookup_by_attr(items, 'category', 'a')  # -> [items.S[0], items.S[2]]
+
+  Args:
+    x: DataSlice of objects or entities.
+    attr_name: name of the attribute to look up.
+    value: DataItem to compare the attribute values with.
+
+  Returns:
+    A 1-dimensional DataSlice of the matching items of `x`.
+  """
+  raise NotImplementedError('implemented in the backend')
+
+
+@optools.add_to_registry(aliases=['kde.lookup_by_attr_range'])
+@optools.as_backend_operator(
+    'kde.core.lookup_by_attr_range',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.attr_name),
+        qtype_utils.expect_data_slice(P.lower),
+        qtype_utils.expect_data_slice(P.upper),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def lookup_by_attr_range(  # pylint: disable=unused-argument
+    x,
+    attr_name,
+    lower=data_slice.DataSlice.from_vals(None),
+    upper=data_slice.DataSlice.from_vals(None),
+):
+  """Returns the items of `x` with `lower <= x.<attr_name> < upper`.
+
+  The result is a 1-dimensional DataSlice with the matching items of `x`
+  (flattened) in their original order. A missing bound means no bound. The
+  attribute values must be numeric (or missing); the items with missing or NaN
+  values never match.
+
+  If the DataBag of `x` and all its fallbacks are immutable (e.g. after
+  `x.freeze()`), a sorted index of the attribute values is built on the first
+  call and reused by the following calls with the same `x`, so that they take
+  time logarithmic in the size of `x` plus the number of matches.
+
+  Example:
+    items = kd.obj(price=kd.slice([10, 30, 20])).freeze()
+    kd.lookup_by_attr_range(items, 'price', 15, 30)  # -> [items.S[2]]
+    kd.lookup_by_attr_range(items, 'price', lower=20)
+    # -> [items.S[1], items.S[2]]
+
+  Args:
+    x: DataSlice of objects or entities.
+    attr_name: name of the numeric attribute to filter by.
+    lower: inclusive lower bound DataItem, or missing for no lower bound.
+    upper: exclusive upper bound DataItem, or missing for no upper bound.
+
+  Returns:
+    A 1-dimensional DataSlice of the matching items of `x`.
+  """
+  raise NotImplementedError('implemented in the backend')
+
+
 @optools.add_to_registry(aliases=['kde.translate_group'])
 @optools.as_lambda_operator(
     'kde.core.translate_group',
@@ -16,10 +16,60 @@
 
 from __future__ import annotations
 
+import inspect
 from typing import Any, Callable
 
 from arolla import arolla
+from koladata.expr import py_expr_eval_py_ext as _py_expr_eval_py_ext
 from koladata.operators import kde_operators
+from koladata.types import py_boxing
+
+
+class _EagerOperator:
+  """Eager version of an operator with the default Koda boxing.
+
+  Calls passing every parameter positionally as a QValue or a Python scalar are
+  evaluated natively, without building an expression: the compiled operator is
+  cached per operator and input qtypes. All the other calls, and the calls with
+  arguments that can not be bound to the operator, go through `op._eval`.
+  Evaluation errors are raised directly, so the operator is evaluated only
+  once.
+  """
+
+  __slots__ = ('_op', '_eval', '_arity')
+
+  def __init__(self, op: arolla.abc.Operator, arity: int):
+    self._op = op
+    self._eval = op._eval  # pylint: disable=protected-access
+    self._arity = arity
+
+  def __call__(self, *args: Any, **kwargs: Any) -> Any:
+    if not kwargs and len(args) == self._arity:
+      result = _py_expr_eval_py_ext.eval_op(self._op, *args)
+      if result is not NotImplemented:
+        return result
+    return self._eval(*args, **kwargs)
+
+  @property
+  def __doc__(self) -> str | None:
+    return self._eval.__doc__
+
+  @property
+  def __signature__(self) -> inspect.Signature:
+    return inspect.signature(self._eval)
+
+  def getdoc(self) -> str | None:
+    return self._eval.getdoc()
+
+
+def _make_eager_op(op: arolla.abc.Operator) -> Callable[..., Any]:
+  """Returns the eager version of `op`."""
+  signature = arolla.abc.get_operator_signature(op)
+  if signature.aux_policy == py_boxing.DEFAULT_BOXING_POLICY and all(
+      param.kind == 'positional-or-keyword' for param in signature.parameters
+  ):
+    return _EagerOperator(op, len(signature.parameters))
+  return op._eval  # pylint: disable=protected-access
 
 
 class _OperatorsContainer:
@@ -40,7 +90,7 @@ class _OperatorsContainer:
   def __getitem__(self, op_name: str) -> Callable[..., Any]:
     eager_op = self.__dict__.get(op_name)
     if eager_op is None:
-      eager_op = self._arolla_container[op_name]._eval
+      eager_op = _make_eager_op(self._arolla_container[op_name])
       self.__dict__[op_name] = eager_op
     assert callable(eager_op)
     return eager_op
@@ -54,7 +104,7 @@ class _OperatorsContainer:
     if isinstance(rl_op_or_container, arolla.OperatorsContainer):
       ret = _OperatorsContainer(rl_op_or_container)
     else:
-      ret = rl_op_or_container._eval  # pylint: disable=protected-access
+      ret = _make_eager_op(rl_op_or_container)
     self.__dict__[op_or_container_name] = ret
     return ret
 
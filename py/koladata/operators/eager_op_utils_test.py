@@ -20,9 +20,11 @@ import types
 from absl.testing import absltest
 from absl.testing import parameterized
 from arolla import arolla
+from koladata.expr import expr_eval
 from koladata.operators import eager_op_utils
 from koladata.testing import testing
 from koladata.types import data_slice
+from koladata.types import py_boxing
 
 ds = data_slice.DataSlice.from_vals
 
@@ -106,6 +108,65 @@ class EagerOpUtilsTest(parameterized.TestCase):
 
     testing.assert_equal(first(self.x, self.y), self.x)
 
+  def test_default_boxing_operator(self):
+
+    @arolla.optools.add_to_registry(unsafe_override=True)
+    @arolla.optools.as_lambda_operator(
+        'test.default_boxing_op',
+        experimental_aux_policy=py_boxing.DEFAULT_BOXING_POLICY,
+    )
+    def default_boxing_op(a, b):
+      """default_boxing_op docstring."""
+      del b
+      return a
+
+    kd = eager_op_utils.operators_container('test')
+    op = kd.default_boxing_op
+    self.assertEqual(op.getdoc(), 'default_boxing_op docstring.')
+    self.assertEqual(op.__doc__, 'default_boxing_op docstring.')
+    self.assertEqual(
+        inspect.signature(op), inspect.signature(default_boxing_op)
+    )
+
+    # Evaluated natively, with the compiled operator cached.
+    expr_eval.reset_eval_cache_stats()
+    testing.assert_equal(op(self.x, self.y), self.x)
+    testing.assert_equal(op(self.y, self.x), self.y)
+    testing.assert_equal(op(1, 'a'), ds(1))
+    stats = expr_eval.eval_cache_stats()['compilation_cache']
+    self.assertLessEqual(stats['misses'], 1)
+    self.assertEqual(stats['hits'] + stats['misses'], 3)
+
+    # Evaluated through `_eval`.
+    testing.assert_equal(op(self.x, b=self.y), self.x)
+    with self.assertRaisesRegex(TypeError, 'missing'):
+      op(self.x)
+
+  def test_failing_operator_evaluated_once(self):
+    calls = 0
+
+    @arolla.optools.as_py_function_operator(
+        'test.failing_py_fn_op', qtype_inference_expr=arolla.P.x
+    )
+    def failing_py_fn_op(x):
+      nonlocal calls
+      calls += 1
+      del x
+      raise ValueError('failing_op error')
+
+    @arolla.optools.add_to_registry(unsafe_override=True)
+    @arolla.optools.as_lambda_operator(
+        'test.failing_op',
+        experimental_aux_policy=py_boxing.DEFAULT_BOXING_POLICY,
+    )
+    def failing_op(x):
+      return failing_py_fn_op(x)
+
+    kd = eager_op_utils.operators_container('test')
+    with self.assertRaises(ValueError):
+      kd.failing_op(self.x)
+    self.assertEqual(calls, 1)
+
   def test_operator_added_later(self):
     kd = eager_op_utils.operators_container('test')
     self.assertFalse(hasattr(kd, 'added_later_op'))
@@ -87,6 +87,34 @@ def coalesce(x, y):  # pylint: disable=unused-argument
   raise NotImplementedError('implemented in the backend')
 
 
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.logical._multi_coalesce',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice_args(P.args),
+        [
+            M.qtype.get_field_count(P.args) > 0,
+            'expected a nonzero number of args',
+        ],
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _multi_coalesce(*args):  # pylint: disable=unused-argument
+  """Returns the first present item of `args` element-wise.
+
+  Equivalent to `args[0] | args[1] | ...`, but computed in a single pass over
+  all the inputs without materializing the intermediate results. Chains of
+  kde.logical.coalesce are rewritten into this operator before evaluation.
+
+  Args:
+    *args: DataSlices to coalesce.
+
+  Returns:
+    Coalesced DataSlice.
+  """
+  raise NotImplementedError('implemented in the backend')
+
+
 @optools.add_to_registry()
 @optools.as_backend_operator(
     'kde.logical._has_not',
@@ -148,6 +176,35 @@ def cond(condition, yes, no=data_slice.DataSlice.from_vals(None)):
   return (yes & condition) | (no & ~condition)
 
 
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.logical._lazy_cond',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.yes),
+        qtype_utils.expect_data_slice(P.no),
+        qtype_utils.expect_data_slice(P.condition),
+        qtype_utils.expect_data_slice_args(P.args),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _lazy_cond(yes, no, condition, *args):  # pylint: disable=unused-argument
+  """Same as kde.logical.cond(condition, yes(*args), no(*args)).
+
+  Created by kd.eval from kde.logical.cond with expensive branches. `yes` and
+  `no` are quoted pointwise expressions over inputs `I.x0`, `I.x1`, ...
+  referring to `args`. Each branch is evaluated only on the items selected for
+  it when the selection is sparse. Unlike kde.logical.cond, errors that a
+  branch raises only for the items not selected for it are not raised.
+
+  Args:
+    yes: quoted expression computing the result where `condition` is present.
+    no: quoted expression computing the result where `condition` is missing.
+    condition: MASK DataSlice.
+    *args: DataSlices the branch expressions are evaluated on.
+  """
+  raise NotImplementedError('implemented in the backend')
+
+
 @optools.add_to_registry()
 @optools.as_lambda_operator(
     'kde.logical.mask_and',
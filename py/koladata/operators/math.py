@@ -471,6 +471,177 @@ def agg_var(
   )
 
 
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.math._agg_approx_std',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.unbiased),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _agg_approx_std(x, unbiased=data_slice.DataSlice.from_vals(True)):  # pylint: disable=unused-argument
+  raise NotImplementedError('implemented in the backend')
+
+
+@optools.add_to_registry(aliases=['kde.agg_approx_std'])
+@optools.as_lambda_operator(
+    'kde.math.agg_approx_std',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice_or_unspecified(P.ndim),
+        qtype_utils.expect_data_slice(P.unbiased),
+    ],
+)
+def agg_approx_std(
+    x, unbiased=data_slice.DataSlice.from_vals(True), ndim=arolla.unspecified()
+):
+  """Returns the streaming standard deviation along the last ndim dimensions.
+
+  Same as `kd.agg_std`, but computed in a single pass over the values with
+  Welford's algorithm, accumulating in double precision. The result may differ
+  from `kd.agg_std` by rounding errors.
+
+  Example:
+    ds = kd.slice([10, 9, 11])
+    kd.agg_approx_std(ds)  # -> kd.slice(1.0)
+    kd.agg_approx_std(ds, unbiased=False)  # -> kd.slice(0.8164966)
+
+  Args:
+    x: A DataSlice of numbers.
+    unbiased: A boolean flag indicating whether to substract 1 from the number
+      of elements in the denominator.
+    ndim: The number of dimensions to compute indices over. Requires 0 <= ndim
+      <= rank(x).
+  """
+  return _agg_approx_std(
+      jagged_shape_ops.flatten_last_ndim(x, ndim),
+      unbiased,
+  )
+
+
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.math._agg_approx_var',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.unbiased),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _agg_approx_var(x, unbiased=data_slice.DataSlice.from_vals(True)):  # pylint: disable=unused-argument
+  raise NotImplementedError('implemented in the backend')
+
+
+@optools.add_to_registry(aliases=['kde.agg_approx_var'])
+@optools.as_lambda_operator(
+    'kde.math.agg_approx_var',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice_or_unspecified(P.ndim),
+        qtype_utils.expect_data_slice(P.unbiased),
+    ],
+)
+def agg_approx_var(
+    x, unbiased=data_slice.DataSlice.from_vals(True), ndim=arolla.unspecified()
+):
+  """Returns the streaming variance along the last ndim dimensions.
+
+  Same as `kd.agg_var`, but computed in a single pass over the values with
+  Welford's algorithm, accumulating in double precision. The result may differ
+  from `kd.agg_var` by rounding errors.
+
+  Example:
+    ds = kd.slice([10, 9, 11])
+    kd.agg_approx_var(ds)  # -> kd.slice(1.0)
+    kd.agg_approx_var(ds, unbiased=False)  # -> kd.slice(0.6666667)
+
+  Args:
+    x: A DataSlice of numbers.
+    unbiased: A boolean flag indicating whether to substract 1 from the number
+      of elements in the denominator.
+    ndim: The number of dimensions to compute indices over. Requires 0 <= ndim
+      <= rank(x).
+  """
+  return _agg_approx_var(
+      jagged_shape_ops.flatten_last_ndim(x, ndim),
+      unbiased,
+  )
+
+
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.math._agg_approx_quantile',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.q),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _agg_approx_quantile(x, q):  # pylint: disable=unused-argument
+  raise NotImplementedError('implemented in the backend')
+
+
+@optools.add_to_registry(aliases=['kde.agg_approx_quantile'])
+@optools.as_lambda_operator(
+    'kde.math.agg_approx_quantile',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.q),
+        qtype_utils.expect_data_slice_or_unspecified(P.ndim),
+    ],
+)
+def agg_approx_quantile(x, q, ndim=arolla.unspecified()):
+  """Returns approximate quantiles along the last ndim dimensions.
+
+  The resulting slice has `rank = rank - ndim` and shape: `shape =
+  shape[:-ndim]`.
+
+  The quantiles are computed in a single pass with a bounded-memory sketch, so
+  the memory does not grow with the size of the groups. The result is exact
+  for groups with fewer than 256 values, and otherwise has a small rank error.
+  Like `kd.agg_median`, the result is always one of the values of the group:
+  the `q`-quantile of `n` values is the value with rank `floor(q * (n - 1))`.
+
+  Example:
+    ds = kd.slice([[1, 4, 2, 3], [5, None, 7]])
+    kd.agg_approx_quantile(ds, 0.5)  # -> kd.slice([2, 5])
+    kd.agg_approx_quantile(ds, 1.0)  # -> kd.slice([4, 7])
+
+  Args:
+    x: A DataSlice of numbers.
+    q: A scalar number in [0, 1].
+    ndim: The number of dimensions to compute indices over. Requires 0 <= ndim
+      <= rank(x).
+  """
+  return _agg_approx_quantile(jagged_shape_ops.flatten_last_ndim(x, ndim), q)
+
+
+@optools.add_to_registry(aliases=['kde.agg_approx_median'])
+@optools.as_lambda_operator(
+    'kde.math.agg_approx_median',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice_or_unspecified(P.ndim),
+    ],
+)
+def agg_approx_median(x, ndim=arolla.unspecified()):
+  """Returns approximate medians along the last ndim dimensions.
+
+  Same as `kd.agg_approx_quantile(x, 0.5, ndim)`: a bounded-memory version of
+  `kd.agg_median`, which is exact for groups with fewer than 256 values.
+
+  Args:
+    x: A DataSlice of numbers.
+    ndim: The number of dimensions to compute indices over. Requires 0 <= ndim
+      <= rank(x).
+  """
+  return _agg_approx_quantile(
+      jagged_shape_ops.flatten_last_ndim(x, ndim),
+      data_slice.DataSlice.from_vals(0.5),
+  )
+
+
 @optools.add_to_registry()
 @optools.as_backend_operator(
     'kde.math.maximum',
@@ -680,3 +851,32 @@ def cum_sum(x, ndim=arolla.unspecified()):
   """Returns the cumulative sum of items along the last ndim dimensions."""
   res = _cum_sum(jagged_shape_ops.flatten_last_ndim(x, ndim))
   return jagged_shape_ops.reshape(res, jagged_shape_ops.get_shape(x))
+
+
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.math._fused_pointwise',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.fn),
+        qtype_utils.expect_data_slice_args(P.args),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _fused_pointwise(fn, *args):  # pylint: disable=unused-argument
+  """Evaluates a chain of pointwise operators in a single pass.
+
+  `fn` is a quoted expression of arithmetic and comparison operators (e.g.
+  `(P.x0 * P.x1 + P.x2) > P.x3`) over placeholders `P.x0`, `P.x1`, ..., which
+  refer to `args`. The result is the same as evaluating the expression
+  directly, but for numeric inputs the intermediate DataSlices are not
+  materialized. Chains of such operators are rewritten into this operator
+  before evaluation.
+
+  Args:
+    fn: A DataItem holding the quoted expression.
+    *args: DataSlices to evaluate `fn` on.
+
+  Returns:
+    The result of `fn` evaluated on `args`.
+  """
+  raise NotImplementedError('implemented in the backend')
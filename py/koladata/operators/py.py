@@ -14,6 +14,8 @@
 
 """py.* operators."""
 
+from concurrent import futures
+
 from arolla import arolla
 from koladata.operators import optools
 from koladata.operators import qtype_utils
@@ -239,3 +241,142 @@ def apply_py_on_selected(
     )
 
   return impl(fn, cond, args, kwargs)
+
+
+def _map_py_batch(fn, batch_size, arg_values, kwarg_values):
+  """Calls `fn` on the aligned Python values of a batch of items.
+
+  Args:
+    fn: Python function to call.
+    batch_size: if None, `fn` is called on every item separately. Otherwise,
+      `fn` is called once on the whole batch.
+    arg_values: lists of Python values of the positional arguments.
+    kwarg_values: dict of lists of Python values of the keyword arguments.
+
+  Returns:
+    A list with the results of `fn` for every item of the batch.
+  """
+  size = len(next(iter(arg_values or kwarg_values.values())))
+  if batch_size is None:
+    return [
+        fn(
+            *(v[i] for v in arg_values),
+            **{k: v[i] for k, v in kwarg_values.items()},
+        )
+        for i in range(size)
+    ]
+  result = list(fn(*arg_values, **kwarg_values))
+  if len(result) != size:
+    raise ValueError(
+        f'expected fn to return {size} items for a batch of {size} items, got'
+        f' {len(result)}'
+    )
+  return result
+
+
+@optools.add_to_registry(aliases=['kde.map_py'])
+@optools.as_lambda_operator(
+    'kde.py.map_py',
+    qtype_constraints=[
+        _expect_py_callable(P.fn),
+        qtype_utils.expect_data_slice_args(P.args),
+        qtype_utils.expect_data_slice(P.schema),
+        qtype_utils.expect_data_slice(P.max_threads),
+        qtype_utils.expect_data_slice(P.batch_size),
+        qtype_utils.expect_data_slice_kwargs(P.kwargs),
+    ],
+    aux_policy=py_boxing.FULL_SIGNATURE_POLICY,
+)
+def map_py(
+    fn,
+    args=py_boxing.var_positional(),
+    schema=py_boxing.keyword_only(None),
+    max_threads=py_boxing.keyword_only(1),
+    batch_size=py_boxing.keyword_only(None),
+    kwargs=py_boxing.var_keyword(),
+):
+  # pylint: disable=g-doc-args  # *args, **kwargs
+  """Applies Python function `fn` on every item of the aligned args.
+
+  The args are aligned and each of them is converted to a flat list of Python
+  values at once (primitives stay Python primitives, missing items become None
+  and objects become DataItems), so no DataItem is created per primitive item.
+
+  If `batch_size` is None, `fn` is called once per item with the Python values
+  of the item. Otherwise, `fn` is called once per batch of up to `batch_size`
+  items with a Python list of values in place of each argument, and must return
+  a sequence with one result per item of the batch.
+
+  Example:
+    kd.map_py(lambda x, y: x + y, ds([1, 2]), ds([3, 4]))  # ds([4, 6])
+    kd.map_py(
+        lambda xs: [x * 2 for x in xs], ds([1, 2, 3]), batch_size=2
+    )  # ds([2, 4, 6])
+
+  Args:
+    fn: function to apply to the items (or the batches of items) of `*args` and
+      `**kwargs`. It is called for all the items, including the missing ones.
+    *args: positional arguments to pass to `fn`.
+    schema: schema of the result. If None, it is inferred from the values
+      returned by `fn`.
+    max_threads: maximum number of threads calling `fn` concurrently. Only
+      useful if `fn` releases the GIL.
+    batch_size: number of items `fn` is called on at once, or None to call it
+      on one item at a time.
+    **kwargs: keyword arguments to pass to `fn`.
+
+  Returns:
+    A DataSlice with the results of `fn` with the shape of the aligned args.
+  """
+
+  @arolla.optools.as_py_function_operator(
+      'kde.py.map_py._impl', qtype_inference_expr=qtypes.DATA_SLICE
+  )
+  def impl(fn, args, schema, max_threads, batch_size, kwargs):
+    fn = fn.py_value()
+    args = tuple(args)
+    kwargs = kwargs.as_dict()
+    max_threads = max_threads.internal_as_py()
+    batch_size = batch_size.internal_as_py()
+    if not isinstance(max_threads, int) or max_threads < 1:
+      raise ValueError(f'max_threads must be positive, got {max_threads}')
+    if batch_size is not None and (
+        not isinstance(batch_size, int) or batch_size < 1
+    ):
+      raise ValueError(f'batch_size must be positive or None, got {batch_size}')
+    if not args and not kwargs:
+      raise ValueError('expected at least one input DataSlice')
+
+    inputs = args + tuple(kwargs.values())
+    target = max(inputs, key=lambda x: x.get_shape().rank())
+    values = [x.expand_to(target).flatten().internal_as_py() for x in inputs]
+    arg_values = values[: len(args)]
+    kwarg_values = dict(zip(kwargs, values[len(args) :]))
+
+    size = len(values[0])
+    chunk_size = batch_size or max(1, -(-size // max_threads))
+    chunk_starts = range(0, size, chunk_size)
+
+    def run_chunk(start):
+      end = start + chunk_size
+      return _map_py_batch(
+          fn,
+          batch_size,
+          [v[start:end] for v in arg_values],
+          {k: v[start:end] for k, v in kwarg_values.items()},
+      )
+
+    if max_threads > 1 and len(chunk_starts) > 1:
+      with futures.ThreadPoolExecutor(max_workers=max_threads) as executor:
+        chunks = list(executor.map(run_chunk, chunk_starts))
+    else:
+      chunks = [run_chunk(start) for start in chunk_starts]
+    result = [item for chunk in chunks for item in chunk]
+
+    if schema.get_schema() == schema_constants.NONE:
+      schema = None
+    return data_slice.DataSlice.from_vals(result, schema).reshape(
+        target.get_shape()
+    )
+
+  return impl(fn, args, schema, max_threads, batch_size, kwargs)
@@ -25,6 +25,7 @@ from koladata.operators import optools
 from koladata.operators import qtype_utils
 from koladata.operators import schema
 from koladata.types import data_slice
+from koladata.types import qtypes
 
 
 M = arolla.OperatorsContainer(jagged_shape)
@@ -152,6 +153,72 @@ def sample(
   return core.select(x, ds_mask)
 
 
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.random._philox_sample_mask',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.ratio),
+        qtype_utils.expect_data_slice(P.seed),
+        qtype_utils.expect_data_slice(P.key),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def _philox_sample_mask(x, ratio, seed, key):  # pylint: disable=unused-argument
+  """Returns a MASK with the shape of `x`, present with probability `ratio`.
+
+  If `key` is a DataItem, the flat indices of `x` are used as keys.
+
+  Args:
+    x: DataSlice to sample.
+    ratio: float number between [0, 1].
+    seed: seed from random sampling.
+    key: keys used to generate random numbers, or a DataItem.
+  """
+  raise NotImplementedError('implemented in the backend')
+
+
+@optools.add_to_registry()
+@optools.as_lambda_operator(
+    'kde.random.fast_sample',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.x),
+        qtype_utils.expect_data_slice(P.ratio),
+        qtype_utils.expect_data_slice(P.seed),
+        qtype_utils.expect_data_slice_or_unspecified(P.key),
+    ],
+)
+def fast_sample(
+    x,
+    ratio,
+    seed,
+    key=arolla.unspecified(),
+):
+  """Randomly sample items in `x` based on ratio, in parallel.
+
+  Same as kde.random.sample, but the random numbers are generated by a
+  counter-based generator (Philox) from `seed` and the key (or the flat index)
+  of each item. Large slices are sampled concurrently and the result does not
+  depend on the number of threads. The sampled items differ from the ones of
+  kde.random.sample for the same seed.
+
+  Keys are compared by value and dtype, e.g. keys 1 and '1' generate different
+  random numbers. Items corresponding to missing keys are never sampled.
+
+  Args:
+    x: DataSlice to sample.
+    ratio: float number between [0, 1].
+    seed: seed from random sampling.
+    key: keys used to generate random numbers. The same key generates the same
+      random number.
+
+  Returns:
+    Sampled DataSlice.
+  """
+  key = M.core.default_if_unspecified(key, data_slice.DataSlice.from_vals(None))
+  return core.select(x, _philox_sample_mask(x, ratio, seed, key))
+
+
 @optools.add_to_registry(aliases=['kde.sample_n'])
 @optools.as_lambda_operator(
     'kde.random.sample_n',
@@ -520,6 +520,40 @@ def regex_match(text, regex):  # pylint: disable=unused-argument
   raise NotImplementedError('implemented in the backend')
 
 
+@optools.add_to_registry()
+@optools.as_backend_operator(
+    'kde.strings.regex_match_any',
+    qtype_constraints=[
+        qtype_utils.expect_data_slice(P.text),
+        qtype_utils.expect_data_slice(P.regexes),
+    ],
+    qtype_inference_expr=qtypes.DATA_SLICE,
+)
+def regex_match_any(text, regexes):  # pylint: disable=unused-argument
+  """Returns `present` if `text` matches any of the regular expressions.
+
+  Same as `kd.strings.regex_match` applied with every pattern of `regexes` and
+  combined with `|`, but each string is scanned only once for all the patterns,
+  which is much faster for a large number of patterns. Matches are partial.
+  Missing patterns are ignored.
+
+  Examples:
+    kd.strings.regex_match_any(
+        kd.slice(['foo', 'bar', None]), kd.slice(['^f', 'z', 'a.$']))
+      # -> kd.slice([kd.present, kd.present, kd.missing])
+    kd.strings.regex_match_any(kd.item('foo'), kd.slice(['^o']))
+      # -> kd.missing
+
+  Args:
+    text: (TEXT) A string.
+    regexes: (TEXT) A rank-1 DataSlice of regular expressions (RE2 syntax).
+
+  Returns:
+    `present` if `text` matches any of `regexes`.
+  """
+  raise NotImplementedError('implemented in the backend')
+
+
 @optools.add_to_registry()
 @optools.as_backend_operator(
     'kde.strings.replace',
@@ -0,0 +1,127 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for core.agg_approx_count_distinct."""
+
+import re
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.operators import optools
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import qtypes
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+DATA_SLICE = qtypes.DATA_SLICE
+INT64 = schema_constants.INT64
+
+
+class CoreAggApproxCountDistinctTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      # Small groups are counted exactly.
+      (ds([1, 2, 1, None]), arolla.unspecified(), ds(2, INT64)),
+      (
+          ds([[1, 2, 1], [3, None, 3], [None, None], []]),
+          arolla.unspecified(),
+          ds([2, 1, 0, 0], INT64),
+      ),
+      (ds([[1, 2, 1], [3, None, 2]]), ds(2), ds(3, INT64)),
+      (
+          ds([[1, 2, 1], [3, None, 2]]),
+          ds(0),
+          ds([[1, 1, 1], [1, 0, 1]], INT64),
+      ),
+      (ds(['a', 'b', 'a']), arolla.unspecified(), ds(2, INT64)),
+      # Different types are distinct.
+      (
+          ds([1, 1.0, 'a', 1, b'a'], schema_constants.OBJECT),
+          arolla.unspecified(),
+          ds(4, INT64),
+      ),
+      (ds([None, None]), arolla.unspecified(), ds(0, INT64)),
+  )
+  def test_eval(self, x, ndim, expected):
+    testing.assert_equal(
+        expr_eval.eval(kde.core.agg_approx_count_distinct(x, ndim)), expected
+    )
+
+  @parameterized.parameters(4, 10, 14, 18)
+  def test_large_groups(self, precision):
+    n = 100000
+    x = ds([[i % 30000 for i in range(n)], [str(i) for i in range(n)]])
+    res = expr_eval.eval(
+        kde.core.agg_approx_count_distinct(x, precision=precision)
+    ).to_py()
+    error = 6 * 1.04 / (2**precision) ** 0.5
+    self.assertAlmostEqual(res[0], 30000, delta=30000 * error)
+    self.assertAlmostEqual(res[1], n, delta=n * error)
+
+  def test_errors(self):
+    with self.assertRaisesRegex(
+        ValueError,
+        re.escape('expected `precision` to be a scalar integer in [4, 18]'),
+    ):
+      expr_eval.eval(kde.core.agg_approx_count_distinct(ds([1]), precision=3))
+    with self.assertRaisesRegex(
+        ValueError,
+        re.escape('expected `precision` to be a scalar integer in [4, 18]'),
+    ):
+      expr_eval.eval(
+          kde.core.agg_approx_count_distinct(ds([1]), precision=ds([10]))
+      )
+
+  def test_qtype_signatures(self):
+    self.assertCountEqual(
+        arolla.testing.detect_qtype_signatures(
+            kde.core.agg_approx_count_distinct,
+            possible_qtypes=(
+                arolla.UNSPECIFIED,
+                qtypes.DATA_SLICE,
+                arolla.INT64,
+            ),
+        ),
+        frozenset([
+            (DATA_SLICE, DATA_SLICE),
+            (DATA_SLICE, arolla.UNSPECIFIED, DATA_SLICE),
+            (DATA_SLICE, DATA_SLICE, DATA_SLICE),
+            (DATA_SLICE, arolla.UNSPECIFIED, DATA_SLICE, DATA_SLICE),
+            (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+        ]),
+    )
+
+  def test_view(self):
+    self.assertTrue(
+        view.has_data_slice_view(kde.core.agg_approx_count_distinct(I.x))
+    )
+
+  def test_alias(self):
+    self.assertTrue(
+        optools.equiv_to_op(
+            kde.core.agg_approx_count_distinct, kde.agg_approx_count_distinct
+        )
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -92,6 +92,16 @@ class CoreConcatImplTest(parameterized.TestCase):
           1,
           ds([b'a', b'b', b'c', 1, 2, 'a', 'b', 'c', 'd']),
       ),
+      # rank 1 concat, mixed dtypes with empty inputs
+      (
+          (
+              ds([1, 2]),
+              ds([None, None]),
+              ds(['a', None]),
+          ),
+          1,
+          ds([1, 2, None, None, 'a', None]),
+      ),
       (
           (
               ds([1, 2, 3], schema_constants.INT32),
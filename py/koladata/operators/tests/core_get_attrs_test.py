@@ -0,0 +1,86 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.core._get_attrs and the kd.eval rewrite creating it."""
+
+from absl.testing import absltest
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.operators import kde_operators
+from koladata.testing import testing
+from koladata.types import data_bag
+from koladata.types import data_slice
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+
+
+class CoreGetAttrsTest(absltest.TestCase):
+
+  def setUp(self):
+    super().setUp()
+    self.db = data_bag.DataBag.empty()
+    self.entity = self.db.new(
+        a=ds([1, 2, 3]),
+        b=ds(['a', None, 'c']),
+        inner=self.db.new(x=ds([4, 5, 6]), y=ds([7, 8, 9])),
+    )
+
+  def test_eval(self):
+    testing.assert_equal(
+        expr_eval.eval(kde.core._get_attrs(I.x, 'a', 'b'), x=self.entity),
+        arolla.tuple(
+            ds([1, 2, 3]).with_db(self.db),
+            ds(['a', None, 'c']).with_db(self.db),
+        ),
+    )
+
+  def test_errors(self):
+    with self.assertRaisesRegex(ValueError, r'the attribute \'c\' is missing'):
+      expr_eval.eval(kde.core._get_attrs(self.entity, 'a', 'c'))
+    with self.assertRaisesRegex(
+        ValueError,
+        r'attr_name in kd.get_attr expects.*got: DataItem\(42, schema: INT32\)',
+    ):
+      expr_eval.eval(kde.core._get_attrs(self.entity, 'a', 42))
+
+  def test_fused_reads(self):
+    expr = kde.core.add(
+        kde.core.add(I.x.a, I.x.inner.x), kde.core.add(I.x.a, I.x.inner.y)
+    )
+    testing.assert_equal(
+        expr_eval.eval(expr, x=self.entity), ds([12, 15, 18])
+    )
+    testing.assert_equal(
+        expr_eval.eval(
+            kde.core.align(I.x.a, I.x.b, kde.get_attr(I.x, 'b', 'z')),
+            x=self.entity,
+        ),
+        arolla.tuple(
+            ds([1, 2, 3]).with_db(self.db),
+            ds(['a', None, 'c']).with_db(self.db),
+            ds(['a', 'z', 'c']).with_db(self.db),
+        ),
+    )
+
+  def test_fused_reads_errors(self):
+    # Same error as without the rewrite.
+    with self.assertRaisesRegex(ValueError, r'the attribute \'c\' is missing'):
+      expr_eval.eval(kde.core.align(I.x.a, I.x.c), x=self.entity)
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,182 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for core.join and core.join_indices."""
+
+import re
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.operators import optools
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import qtypes
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+DATA_SLICE = qtypes.DATA_SLICE
+INT64 = schema_constants.INT64
+
+
+class CoreJoinTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      (
+          ds([[1, 2], [3]]),
+          ds([2, 1, 4, 1]),
+          False,
+          ds([[[1, 3], [0]], [[]]], INT64),
+      ),
+      (
+          ds([[1, 2], [3]]),
+          ds([2, 1, 4, 1]),
+          True,
+          ds([[[1, 3], [0]], [[None]]], INT64),
+      ),
+      # Positions are in the flattened `right_keys`.
+      (
+          ds([1, None, 2]),
+          ds([[2, None], [1, 2]]),
+          True,
+          ds([[2], [None], [0, 3]], INT64),
+      ),
+      (ds(2), ds([2, 1, 2]), False, ds([0, 2], INT64)),
+      (ds([2, 1]), ds(2), False, ds([[0], []], INT64)),
+      # Larger left side.
+      (
+          ds(['a', 'b', 'c', 'a', 'x']),
+          ds(['a', 'c']),
+          True,
+          ds([[0], [None], [1], [0], [None]], INT64),
+      ),
+      # Values of different types don't match.
+      (
+          ds([1, 'a', 1.0], schema_constants.OBJECT),
+          ds([1.0, 'a', 1, 'a']),
+          False,
+          ds([[2], [1, 3], [0]], INT64),
+      ),
+      (ds([1]), ds([1], INT64), False, ds([[]], INT64)),
+  )
+  def test_join_indices(self, left_keys, right_keys, left_join, expected):
+    res = expr_eval.eval(
+        kde.core.join_indices(left_keys, right_keys, left_join)
+    )
+    testing.assert_equal(res, expected)
+
+  def test_default_inner_join(self):
+    testing.assert_equal(
+        expr_eval.eval(kde.core.join_indices(ds([1, 3]), ds([3, 1, 3]))),
+        ds([[1], [0, 2]], INT64),
+    )
+
+  def test_join(self):
+    right_keys = ds([[1, 2], [3, 1]])
+    right_values = ds([['a', 'b'], ['c', 'd']])
+    testing.assert_equal(
+        expr_eval.eval(kde.core.join(ds([1, 4]), right_keys, right_values)),
+        ds([['a', 'd'], []]),
+    )
+    testing.assert_equal(
+        expr_eval.eval(
+            kde.core.join(ds([1, 4]), right_keys, right_values, True)
+        ),
+        ds([['a', 'd'], [None]]),
+    )
+
+  def test_consistent_with_python(self):
+    left = [(i * 7919) % 1000 for i in range(3000)]
+    right = [(i * 104729) % 1500 for i in range(2000)]
+    expected = [[j for j, r in enumerate(right) if r == l] for l in left]
+    for left_join in (False, True):
+      testing.assert_equal(
+          expr_eval.eval(
+              kde.core.join_indices(ds(left), ds(right), left_join)
+          ),
+          ds(
+              [g or [None] for g in expected] if left_join else expected,
+              INT64,
+          ),
+      )
+    # Builds the table on the other side.
+    testing.assert_equal(
+        expr_eval.eval(kde.core.join_indices(ds(right[:100]), ds(left))),
+        ds(
+            [[j for j, l in enumerate(left) if l == r] for r in right[:100]],
+            INT64,
+        ),
+    )
+
+  def test_errors(self):
+    with self.assertRaisesRegex(
+        ValueError,
+        re.escape('expected `left_join` to be a scalar boolean value'),
+    ):
+      expr_eval.eval(kde.core.join_indices(ds([1, 2]), ds([1]), 1))
+    with self.assertRaisesRegex(
+        ValueError,
+        re.escape("'right_values' and 'right_keys' must have the same shape."),
+    ):
+      expr_eval.eval(kde.core.join(ds([1, 2]), ds([1]), ds([1, 2])))
+
+  def test_qtype_signatures(self):
+    self.assertCountEqual(
+        arolla.testing.detect_qtype_signatures(
+            kde.core.join_indices,
+            possible_qtypes=(
+                arolla.UNSPECIFIED,
+                qtypes.DATA_SLICE,
+                arolla.INT64,
+            ),
+        ),
+        frozenset([
+            (DATA_SLICE, DATA_SLICE, DATA_SLICE),
+            (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+        ]),
+    )
+    self.assertCountEqual(
+        arolla.testing.detect_qtype_signatures(
+            kde.core.join,
+            possible_qtypes=(
+                arolla.UNSPECIFIED,
+                qtypes.DATA_SLICE,
+                arolla.INT64,
+            ),
+        ),
+        frozenset([
+            (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+            (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+        ]),
+    )
+
+  def test_view(self):
+    self.assertTrue(view.has_data_slice_view(kde.core.join_indices(I.x, I.y)))
+    self.assertTrue(view.has_data_slice_view(kde.core.join(I.x, I.y, I.z)))
+
+  def test_alias(self):
+    self.assertTrue(optools.equiv_to_op(kde.core.join, kde.join))
+    self.assertTrue(
+        optools.equiv_to_op(kde.core.join_indices, kde.join_indices)
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
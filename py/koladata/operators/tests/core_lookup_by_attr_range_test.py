@@ -0,0 +1,142 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.core.lookup_by_attr_range."""
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.operators import optools
+from koladata.operators.tests.util import qtypes as test_qtypes
+from koladata.testing import testing
+from koladata.types import data_bag
+from koladata.types import data_slice
+from koladata.types import qtypes
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+DATA_SLICE = qtypes.DATA_SLICE
+
+QTYPES = frozenset([
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+])
+
+
+class CoreLookupByAttrRangeTest(parameterized.TestCase):
+
+  @parameterized.parameters(False, True)
+  def test_eval(self, freeze):
+    db = data_bag.DataBag.empty()
+    x = db.new(
+        price=ds([5, 1, None, 3, 1, 7]), b=ds(['p', 'q', 'r', 's', 't', 'u'])
+    )
+    if freeze:
+      x = x.freeze()
+    # Repeated calls use the cached index for the frozen DataBag.
+    for _ in range(2):
+      result = expr_eval.eval(kde.core.lookup_by_attr_range(x, 'price', 1, 4))
+      testing.assert_equal(result.b.no_db(), ds(['q', 's', 't']))
+      testing.assert_equal(result.db, x.db)
+    testing.assert_equal(
+        expr_eval.eval(
+            kde.core.lookup_by_attr_range(x, 'price', lower=3)
+        ).b.no_db(),
+        ds(['p', 's', 'u']),
+    )
+    testing.assert_equal(
+        expr_eval.eval(
+            kde.core.lookup_by_attr_range(x, 'price', upper=3.5)
+        ).b.no_db(),
+        ds(['q', 's', 't']),
+    )
+    testing.assert_equal(
+        expr_eval.eval(kde.core.lookup_by_attr_range(x, 'price')).b.no_db(),
+        ds(['p', 'q', 's', 't', 'u']),
+    )
+    testing.assert_equal(
+        expr_eval.eval(
+            kde.core.lookup_by_attr_range(x, 'price', 4, 4)
+        ).as_itemid(),
+        ds([], schema_constants.ITEMID),
+    )
+
+  def test_objects_float(self):
+    db = data_bag.DataBag.empty()
+    x = db.obj(price=ds([[1.5, 2.5], [float('nan'), 0.5]]))
+    result = expr_eval.eval(kde.core.lookup_by_attr_range(x, 'price', 1, 3))
+    testing.assert_equal(
+        result.as_itemid(), ds([x.S[0, 0], x.S[0, 1]]).as_itemid()
+    )
+
+  def test_forked_db(self):
+    db = data_bag.DataBag.empty()
+    x = db.new(a=ds([1, 2, 3])).freeze()
+    testing.assert_equal(
+        expr_eval.eval(kde.core.lookup_by_attr_range(x, 'a', 2)).as_itemid(),
+        ds([x.S[1], x.S[2]]).as_itemid(),
+    )
+    y = x.fork_db()
+    y.S[0].a = 5
+    y = y.freeze()
+    testing.assert_equal(
+        expr_eval.eval(kde.core.lookup_by_attr_range(y, 'a', 2)).as_itemid(),
+        ds([y.S[0], y.S[1], y.S[2]]).as_itemid(),
+    )
+
+  def test_errors(self):
+    db = data_bag.DataBag.empty()
+    x = db.new(a=ds([1, 2]), s=ds(['a', 'b']))
+    with self.assertRaisesRegex(ValueError, 'bounds must be DataItems'):
+      expr_eval.eval(kde.core.lookup_by_attr_range(x, 'a', ds([1])))
+    with self.assertRaisesRegex(ValueError, 'range bounds must be numeric'):
+      expr_eval.eval(kde.core.lookup_by_attr_range(x, 'a', 'a'))
+    with self.assertRaisesRegex(
+        ValueError, 'range index requires numeric values'
+    ):
+      expr_eval.eval(kde.core.lookup_by_attr_range(x, 's', 1))
+    with self.assertRaisesRegex(ValueError, "the attribute 'b' is missing"):
+      expr_eval.eval(kde.core.lookup_by_attr_range(x, 'b', 1))
+
+  def test_qtype_signatures(self):
+    self.assertCountEqual(
+        arolla.testing.detect_qtype_signatures(
+            kde.core.lookup_by_attr_range,
+            possible_qtypes=test_qtypes.DETECT_SIGNATURES_QTYPES,
+        ),
+        QTYPES,
+    )
+
+  def test_view(self):
+    self.assertTrue(
+        view.has_data_slice_view(kde.core.lookup_by_attr_range(I.x, I.a))
+    )
+
+  def test_alias(self):
+    self.assertTrue(
+        optools.equiv_to_op(
+            kde.core.lookup_by_attr_range, kde.lookup_by_attr_range
+        )
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,163 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for core.top_k and core.top_k_indices."""
+
+import re
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.operators import optools
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import qtypes
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+DATA_SLICE = qtypes.DATA_SLICE
+INT64 = schema_constants.INT64
+
+
+QTYPES = frozenset([
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+])
+
+
+class CoreTopKTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      (ds([4, 3, None, 6]), 2, True, ds([3, 0], INT64)),
+      (ds([4, 3, None, 6]), 2, False, ds([1, 0], INT64)),
+      (ds([4, 3, None, 6]), 5, True, ds([3, 0, 1], INT64)),
+      (ds([4, 3, None, 6]), 0, True, ds([], INT64)),
+      (ds([4, 3, None, 6]), -1, True, ds([], INT64)),
+      (ds([4.0, 3.0, float('nan'), 6.0]), 5, True, ds([3, 0, 1, 2], INT64)),
+      (ds([4.0, 3.0, float('nan'), 6.0]), 5, False, ds([1, 0, 3, 2], INT64)),
+      # Ties are resolved by position.
+      (ds([1, 2, 1, 2]), 3, True, ds([1, 3, 0], INT64)),
+      (
+          ds([[4, 3, None, 6], [2, None, 5, 1], []]),
+          2,
+          True,
+          ds([[3, 0], [2, 0], []], INT64),
+      ),
+      (
+          ds([[4, 3, None, 6], [2, None, 5, 1]]),
+          ds([1, 3]),
+          True,
+          ds([[3], [2, 0, 3]], INT64),
+      ),
+      (
+          ds([[4, 3, None, 6], [2, None, 5, 1]]),
+          ds([1, None]),
+          True,
+          ds([[3], []], INT64),
+      ),
+      (
+          ds([[[1, 2], [3]], [[5, 4]]]),
+          ds([1, 2]),
+          True,
+          ds([[[1], [0]], [[0, 1]]], INT64),
+      ),
+      # Not natively supported types are ranked with ordinal_rank.
+      (ds(['b', 'a', None, 'c']), 2, True, ds([3, 0], INT64)),
+      (ds([2, 1, 3], schema_constants.OBJECT), 2, False, ds([1, 0], INT64)),
+      (ds([None, None], schema_constants.INT64), 2, True, ds([], INT64)),
+  )
+  def test_top_k_indices(self, x, k, descending, expected):
+    res = expr_eval.eval(kde.core.top_k_indices(x, k, descending))
+    testing.assert_equal(res, expected)
+
+  def test_top_k(self):
+    x = ds([[4, 3, None, 6], [2, None, 5, 1]])
+    testing.assert_equal(
+        expr_eval.eval(kde.core.top_k(x, 2)), ds([[6, 4], [5, 2]])
+    )
+    testing.assert_equal(
+        expr_eval.eval(kde.core.top_k(x, 2, descending=False)),
+        ds([[3, 4], [1, 2]]),
+    )
+
+  def test_consistent_with_ordinal_rank(self):
+    values = [(i * 7919) % 101 - 50 for i in range(1000)]
+    x = ds([values[i : i + 100] for i in range(0, 1000, 100)])
+    for descending in (True, False):
+      expected = expr_eval.eval(
+          kde.core.select(
+              kde.core.sort(
+                  kde.core.index(x),
+                  kde.core.ordinal_rank(x, descending=descending),
+              ),
+              kde.core.sort(kde.core.ordinal_rank(x, descending=descending))
+              < 10,
+          )
+      )
+      testing.assert_equal(
+          expr_eval.eval(kde.core.top_k_indices(x, 10, descending)), expected
+      )
+
+  def test_errors(self):
+    with self.assertRaisesRegex(ValueError, re.escape('expected rank(x) > 0')):
+      expr_eval.eval(kde.core.top_k_indices(ds(1), 1))
+    with self.assertRaisesRegex(
+        ValueError, re.escape('expected `k` to be an integer DataSlice')
+    ):
+      expr_eval.eval(kde.core.top_k_indices(ds([1, 2]), 'a'))
+    with self.assertRaisesRegex(
+        ValueError, re.escape('the shape of `k` must be broadcastable')
+    ):
+      expr_eval.eval(kde.core.top_k_indices(ds([1, 2]), ds([1, 2])))
+    with self.assertRaisesRegex(
+        ValueError,
+        re.escape('expected `descending` to be a scalar boolean value'),
+    ):
+      expr_eval.eval(kde.core.top_k_indices(ds([1, 2]), 1, 1))
+
+  def test_qtype_signatures(self):
+    for op in (kde.core.top_k, kde.core.top_k_indices):
+      self.assertCountEqual(
+          arolla.testing.detect_qtype_signatures(
+              op,
+              possible_qtypes=(
+                  arolla.UNSPECIFIED,
+                  qtypes.DATA_SLICE,
+                  arolla.INT64,
+              ),
+          ),
+          QTYPES,
+      )
+
+  def test_view(self):
+    self.assertTrue(view.has_data_slice_view(kde.core.top_k(I.x, I.k)))
+    self.assertTrue(
+        view.has_data_slice_view(kde.core.top_k_indices(I.x, I.k))
+    )
+
+  def test_alias(self):
+    self.assertTrue(optools.equiv_to_op(kde.core.top_k, kde.top_k))
+    self.assertTrue(
+        optools.equiv_to_op(kde.core.top_k_indices, kde.top_k_indices)
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
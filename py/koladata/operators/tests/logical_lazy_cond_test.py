@@ -0,0 +1,141 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.logical._lazy_cond and the kd.eval rewrite creating it."""
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.operators import kde_operators
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+
+present = arolla.present()
+SPARSE = ds([present, None, None, None])
+DENSE = ds([present, present, present, None])
+FULL = ds([present, present, present, present])
+EMPTY = ds([None, None, None, None], schema_constants.MASK)
+
+# The `yes` branch has two pointwise operators, so kd.eval rewrites the cond
+# into kde.logical._lazy_cond.
+LAZY_COND = kde.logical.cond(
+    I.c,
+    kde.core.add(kde.math.floordiv(I.x, I.y), 1),
+    kde.math.subtract(I.x, 1),
+)
+
+
+def lazy_cond(condition, x, y):
+  return kde.logical._lazy_cond(
+      ds(arolla.quote(kde.core.add(kde.math.floordiv(I.x0, I.x1), 1))),
+      ds(arolla.quote(kde.math.subtract(I.x0, 1))),
+      condition,
+      x,
+      y,
+  )
+
+
+class LogicalLazyCondTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      # condition, y, expected
+      # The zeros in `y` are never selected for the floordiv branch.
+      (SPARSE, ds([2, 0, 0, 0]), ds([1, 1, 2, 3])),
+      (DENSE, ds([2, 2, 2, 0]), ds([1, 2, 2, 3])),
+      (EMPTY, ds([0, 0, 0, 0]), ds([0, 1, 2, 3])),
+  )
+  def test_eval(self, condition, y, expected):
+    x = ds([1, 2, 3, 4])
+    testing.assert_equal(expr_eval.eval(lazy_cond(condition, x, y)), expected)
+    testing.assert_equal(
+        expr_eval.eval(LAZY_COND, c=condition, x=x, y=y), expected
+    )
+
+  @parameterized.parameters(
+      (SPARSE, ds([0, 1, 1, 1])),
+      (DENSE, ds([1, 0, 1, 1])),
+  )
+  def test_error_on_selected_item(self, condition, y):
+    x = ds([1, 2, 3, 4])
+    with self.assertRaisesRegex(ValueError, 'division by zero'):
+      expr_eval.eval(lazy_cond(condition, x, y))
+    with self.assertRaisesRegex(ValueError, 'division by zero'):
+      expr_eval.eval(LAZY_COND, c=condition, x=x, y=y)
+
+  @parameterized.parameters(
+      (SPARSE, ds([1, 2, 3, 4]), ds([2, 1, None, 3])),
+      (DENSE, ds([1, 2, 3, 4]), ds([2, 1, None, 3])),
+      (FULL, ds([1, None, 3, 4]), ds([2, 1, 1, 3])),
+      (EMPTY, ds([1, 2, 3, 4]), ds([2, 1, 1, 3])),
+      (DENSE, ds([1, 2, 3, 4]), ds(2)),
+      (
+          ds([[present, None], [None, present]]),
+          ds([[1, 2], [3, 4]]),
+          ds([2, 3]),
+      ),
+      (DENSE, ds([1, 2, 3, 4]), ds([2.0, 1.0, None, 3.0])),
+  )
+  def test_same_as_eager_cond(self, condition, x, y):
+    # kd.eval and the eager kd.cond agree when the branches don't fail.
+    yes = expr_eval.eval(kde.core.add(kde.math.floordiv(I.x, I.y), 1), x=x, y=y)
+    no = expr_eval.eval(kde.math.subtract(I.x, 1), x=x)
+    testing.assert_equal(
+        expr_eval.eval(LAZY_COND, c=condition, x=x, y=y),
+        expr_eval.eval(
+            kde.logical.cond(I.c, I.yes, I.no), c=condition, yes=yes, no=no
+        ),
+    )
+
+  def test_error_on_not_selected_item(self):
+    # Unlike the eager kd.cond, which evaluates the branches on all the items,
+    # kd.eval doesn't raise errors for the items not selected for a branch.
+    x = ds([1, 2, 3, 4])
+    y = ds([2, 2, 2, 0])
+    with self.assertRaisesRegex(ValueError, 'division by zero'):
+      expr_eval.eval(kde.core.add(kde.math.floordiv(I.x, I.y), 1), x=x, y=y)
+    testing.assert_equal(
+        expr_eval.eval(LAZY_COND, c=DENSE, x=x, y=y), ds([1, 2, 2, 3])
+    )
+
+  def test_scalar_args(self):
+    testing.assert_equal(
+        expr_eval.eval(LAZY_COND, c=SPARSE, x=ds(4), y=ds(2)),
+        ds([3, 3, 3, 3]),
+    )
+    # Branches on scalars only are evaluated eagerly, even if nothing is
+    # selected for them.
+    with self.assertRaisesRegex(ValueError, 'division by zero'):
+      expr_eval.eval(LAZY_COND, c=EMPTY, x=ds(4), y=ds(0))
+
+  def test_cheap_branches_are_not_rewritten(self):
+    # A single pointwise operator per branch: evaluated eagerly on all the
+    # items, as kde.logical.cond.
+    with self.assertRaisesRegex(ValueError, 'division by zero'):
+      expr_eval.eval(
+          kde.logical.cond(I.c, kde.math.floordiv(I.x, I.y), I.x),
+          c=SPARSE,
+          x=ds([1, 2, 3, 4]),
+          y=ds([2, 0, 0, 0]),
+      )
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,98 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.logical._multi_coalesce."""
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.operators import kde_operators
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+
+
+class LogicalMultiCoalesceTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      (
+          # args, expected
+          (ds([1, None, None, None]),),
+          ds([1, None, None, None]),
+      ),
+      (
+          (
+              ds([1, None, None, None]),
+              ds([5, 2, None, None]),
+              ds([6, 7, 3, None]),
+          ),
+          ds([1, 2, 3, None]),
+      ),
+      # Mixed types.
+      (
+          (
+              ds([1, None, None, None]),
+              ds(['a', 'b', None, None]),
+              ds([1.5, 2.5, 3.5, None]),
+          ),
+          ds([1, 'b', 3.5, None], schema_constants.OBJECT),
+      ),
+      # Auto-broadcasting.
+      (
+          (ds([1, None, None]), ds(None, schema_constants.INT32), ds(3)),
+          ds([1, 3, 3]),
+      ),
+      # Scalars.
+      ((ds(None, schema_constants.INT32), ds(2), ds(3)), ds(2)),
+      (
+          (ds(None, schema_constants.INT32), ds(None, schema_constants.INT32)),
+          ds(None, schema_constants.INT32),
+      ),
+      # Multi-dimensional.
+      (
+          (
+              ds([[None, None], [4, None, None]]),
+              ds([[1, None], [None, 5, None]]),
+              ds([[2, 3], [6, 7, None]]),
+          ),
+          ds([[1, 3], [4, 5, None]]),
+      ),
+  )
+  def test_eval(self, args, expected):
+    testing.assert_equal(
+        expr_eval.eval(kde.logical._multi_coalesce(*args)), expected
+    )
+
+  def test_same_as_chained_coalesce(self):
+    x = ds([1, None, None, None, None])
+    y = ds([None, 'a', None, None, None])
+    z = ds([2, 3, 4.5, None, None])
+    w = ds([None, None, None, 6, None])
+    testing.assert_equal(
+        expr_eval.eval(I.x | I.y | I.z | I.w, x=x, y=y, z=z, w=w),
+        expr_eval.eval(kde.logical._multi_coalesce(x, y, z, w)),
+    )
+    testing.assert_equal(
+        expr_eval.eval(I.x | (I.y | I.z), x=x, y=y, z=z),
+        ds([1, 'a', 4.5, None, None], schema_constants.OBJECT),
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,100 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.math.agg_approx_median."""
+
+import re
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.operators import optools
+from koladata.operators.tests.util import qtypes as test_qtypes
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import qtypes
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+DATA_SLICE = qtypes.DATA_SLICE
+
+
+QTYPES = frozenset([
+    (DATA_SLICE, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE),
+    (DATA_SLICE, arolla.UNSPECIFIED, DATA_SLICE),
+])
+
+
+class MathAggApproxMedianTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      (ds([1, 2, None, 3]),),
+      (ds([None], schema_constants.INT32),),
+      (ds([[3, None], [5, 4, 9], [None, None], []]),),
+      (ds([[[3, None], [5, 4, 9]], [[None, None]]]),),
+      (ds([[[3, None], [5, 4, 9]], [[None, None]]]), ds(2)),
+      (ds([[1.5, 0.5], [2.5]], schema_constants.FLOAT64),),
+      (ds([[2, None], [None]], schema_constants.OBJECT),),
+      (ds([[None, None], [None]]),),
+  )
+  def test_same_as_agg_median(self, *args):
+    # The sketch is exact for small groups.
+    testing.assert_equal(
+        expr_eval.eval(kde.math.agg_approx_median(*args)),
+        expr_eval.eval(kde.math.agg_median(*args)),
+    )
+
+  def test_large_group(self):
+    n = 100001
+    # A deterministic permutation of [0, n).
+    x = ds([(i * 7919) % n for i in range(n)])
+    result = expr_eval.eval(kde.math.agg_approx_median(x)).to_py()
+    self.assertAlmostEqual(result, n // 2, delta=n * 0.02)
+
+  def test_data_item_input_error(self):
+    with self.assertRaisesRegex(ValueError, re.escape('expected rank(x) > 0')):
+      expr_eval.eval(kde.math.agg_approx_median(ds(1)))
+
+  @parameterized.parameters(-1, 2)
+  def test_out_of_bounds_ndim_error(self, ndim):
+    with self.assertRaisesRegex(ValueError, 'expected 0 <= ndim <= rank'):
+      expr_eval.eval(kde.math.agg_approx_median(ds([1, 2, 3]), ndim=ndim))
+
+  def test_qtype_signatures(self):
+    self.assertCountEqual(
+        arolla.testing.detect_qtype_signatures(
+            kde.math.agg_approx_median,
+            possible_qtypes=test_qtypes.DETECT_SIGNATURES_QTYPES,
+        ),
+        QTYPES,
+    )
+
+  def test_view(self):
+    self.assertTrue(view.has_data_slice_view(kde.math.agg_approx_median(I.x)))
+
+  def test_alias(self):
+    self.assertTrue(
+        optools.equiv_to_op(kde.math.agg_approx_median, kde.agg_approx_median)
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,153 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.math.agg_approx_quantile."""
+
+import math
+import re
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.operators import optools
+from koladata.operators.tests.util import qtypes as test_qtypes
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import qtypes
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+DATA_SLICE = qtypes.DATA_SLICE
+
+
+QTYPES = frozenset([
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, arolla.UNSPECIFIED, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+])
+
+
+class MathAggApproxQuantileTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      (ds([1, 4, 2, 3]), 0.0, ds(1)),
+      (ds([1, 4, 2, 3]), 0.5, ds(2)),
+      (ds([1, 4, 2, 3]), 1.0, ds(4)),
+      (ds([1, 4, 2, 3]), ds(1), ds(4)),
+      (ds([1, 4, None, 3], schema_constants.INT64), 0.5,
+       ds(3, schema_constants.INT64)),
+      (ds([1.5, 0.5, 2.5]), 0.5, ds(1.5)),
+      (ds([1.5, 0.5, 2.5], schema_constants.FLOAT64), 0.75,
+       ds(1.5, schema_constants.FLOAT64)),
+      (ds([None], schema_constants.INT32), 0.5,
+       ds(None, schema_constants.INT32)),
+      (
+          ds([[3, None], [5, 4, 9], [None, None], []]),
+          0.5,
+          ds([3, 5, None, None]),
+      ),
+      (
+          ds([[[3, None], [5, 4, 9]], [[None, None]]]),
+          1.0,
+          ds([[3, 9], [None]]),
+      ),
+      (
+          ds([[[3, None], [5, 4, 9]], [[None, None]]]),
+          0.5,
+          ds(2),
+          ds([4, None]),
+      ),
+      (
+          ds([[2, None], [None]], schema_constants.OBJECT),
+          0.5,
+          ds([2, None], schema_constants.OBJECT),
+      ),
+      # Empty and unknown inputs.
+      (
+          ds([[None, None], [None]]),
+          0.5,
+          ds([None, None], schema_constants.NONE),
+      ),
+      (
+          ds([[None, None], [None]], schema_constants.OBJECT),
+          0.5,
+          ds([None, None], schema_constants.OBJECT),
+      ),
+  )
+  def test_eval(self, *args_and_expected):
+    args, expected_value = args_and_expected[:-1], args_and_expected[-1]
+    result = expr_eval.eval(kde.math.agg_approx_quantile(*args))
+    testing.assert_equal(result, expected_value)
+
+  def test_nan(self):
+    x = ds([1.0, float('nan'), 2.0])
+    result = expr_eval.eval(kde.math.agg_approx_quantile(x, 0.5))
+    self.assertTrue(math.isnan(result.to_py()))
+
+  @parameterized.parameters(0.1, 0.5, 0.9)
+  def test_large_group(self, q):
+    n = 100000
+    # A deterministic permutation of [0, n).
+    x = ds([(i * 7919) % n for i in range(n)])
+    result = expr_eval.eval(kde.math.agg_approx_quantile(x, q)).to_py()
+    self.assertAlmostEqual(result, q * (n - 1), delta=n * 0.02)
+
+  def test_data_item_input_error(self):
+    with self.assertRaisesRegex(ValueError, re.escape('expected rank(x) > 0')):
+      expr_eval.eval(kde.math.agg_approx_quantile(ds(1), 0.5))
+
+  @parameterized.parameters(-0.1, 1.5, ds([0.5]), ds(None), 'a')
+  def test_invalid_q_error(self, q):
+    with self.assertRaisesRegex(
+        ValueError, re.escape('expected q to be a scalar number in [0, 1]')
+    ):
+      expr_eval.eval(kde.math.agg_approx_quantile(ds([1, 2]), q))
+
+  def test_mixed_slice_error(self):
+    x = ds([1, 2.0], schema_constants.OBJECT)
+    with self.assertRaisesRegex(
+        ValueError, 'DataSlice with mixed types is not supported'
+    ):
+      expr_eval.eval(kde.math.agg_approx_quantile(x, 0.5))
+
+  def test_qtype_signatures(self):
+    self.assertCountEqual(
+        arolla.testing.detect_qtype_signatures(
+            kde.math.agg_approx_quantile,
+            possible_qtypes=test_qtypes.DETECT_SIGNATURES_QTYPES,
+        ),
+        QTYPES,
+    )
+
+  def test_view(self):
+    self.assertTrue(
+        view.has_data_slice_view(kde.math.agg_approx_quantile(I.x, I.q))
+    )
+
+  def test_alias(self):
+    self.assertTrue(
+        optools.equiv_to_op(
+            kde.math.agg_approx_quantile, kde.agg_approx_quantile
+        )
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,167 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.math.agg_approx_std."""
+
+import re
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.operators import optools
+from koladata.operators.tests.util import qtypes as test_qtypes
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import qtypes
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+DATA_SLICE = qtypes.DATA_SLICE
+
+
+QTYPES = frozenset([
+    (DATA_SLICE, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, arolla.UNSPECIFIED, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+])
+
+
+class MathAggApproxStdTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      (
+          ds([10, 9, 11, 12], schema_constants.INT32),
+          ds(1.2909944, schema_constants.FLOAT32),
+      ),
+      (
+          ds([10, 9, None, 11], schema_constants.INT64),
+          ds(1.0, schema_constants.FLOAT32),
+      ),
+      (
+          ds([10.0, 9.0, None, 11.0], schema_constants.FLOAT32),
+          False,
+          ds(1),
+          ds(0.8164966, schema_constants.FLOAT32),
+      ),
+      (
+          ds([10.0, 9.0, None, 11.0], schema_constants.FLOAT64),
+          ds(1.0, schema_constants.FLOAT64),
+      ),
+      # Scalar value produces None
+      (ds([10], schema_constants.INT32), ds(None, schema_constants.FLOAT32)),
+      (
+          ds([[1, None, None], [3, 4, 5], [None, None]]),
+          False,
+          arolla.unspecified(),
+          ds([0.0, 0.8164966, None]),
+      ),
+      (
+          ds([[1, None, None], [3, 4, 5], [None, None]]),
+          True,
+          ds(2),
+          ds(1.7078252),
+      ),
+  )
+  def test_eval(self, *args_and_expected):
+    args, expected_value = args_and_expected[:-1], args_and_expected[-1]
+    result = expr_eval.eval(kde.math.agg_approx_std(*args))
+    testing.assert_allclose(result, expected_value)
+
+  @parameterized.parameters(
+      (
+          ds([[2, None], [None]], schema_constants.OBJECT),
+          ds([None, None], schema_constants.OBJECT),
+      ),
+      # Empty and unknown inputs.
+      (
+          ds([[None, None], [None]]),
+          ds([None, None], schema_constants.NONE),
+      ),
+      (
+          ds([[None, None], [None]], schema_constants.OBJECT),
+          ds([None, None], schema_constants.OBJECT),
+      ),
+      (
+          ds([[None, None], [None]], schema_constants.FLOAT32),
+          ds([None, None], schema_constants.FLOAT32),
+      ),
+  )
+  def test_eval_missing(self, x, expected_value):
+    result = expr_eval.eval(kde.math.agg_approx_std(x))
+    testing.assert_equal(result, expected_value)
+
+  def test_large_offset(self):
+    # The values are far from zero compared to their spread.
+    x = ds([1e9 + 4, 1e9 + 7, 1e9 + 13, 1e9 + 16], schema_constants.FLOAT64)
+    testing.assert_allclose(
+        expr_eval.eval(kde.math.agg_approx_std(x)),
+        ds(30.0**0.5, schema_constants.FLOAT64),
+    )
+
+  def test_same_as_agg_std(self):
+    x = ds([[float(i % 17) for i in range(1000)], [1.0, 2.0]])
+    testing.assert_allclose(
+        expr_eval.eval(kde.math.agg_approx_std(x)),
+        expr_eval.eval(kde.math.agg_std(x)),
+        rtol=1e-6,
+    )
+
+  def test_data_item_input_error(self):
+    with self.assertRaisesRegex(ValueError, re.escape('expected rank(x) > 0')):
+      expr_eval.eval(kde.math.agg_approx_std(ds(1)))
+
+  def test_non_scalar_unbiased_error(self):
+    with self.assertRaisesRegex(
+        ValueError, re.escape('expected unbiased to be a scalar boolean value')
+    ):
+      expr_eval.eval(kde.math.agg_approx_std(ds([1]), unbiased=ds([True])))
+
+  def test_mixed_slice_error(self):
+    x = ds([1, 2.0], schema_constants.OBJECT)
+    with self.assertRaisesRegex(
+        ValueError, 'DataSlice with mixed types is not supported'
+    ):
+      expr_eval.eval(kde.math.agg_approx_std(x))
+
+  def test_non_numeric_error(self):
+    with self.assertRaisesRegex(ValueError, 'expected a numeric DataSlice'):
+      expr_eval.eval(kde.math.agg_approx_std(ds(['a', 'b'])))
+
+  def test_qtype_signatures(self):
+    self.assertCountEqual(
+        arolla.testing.detect_qtype_signatures(
+            kde.math.agg_approx_std,
+            possible_qtypes=test_qtypes.DETECT_SIGNATURES_QTYPES,
+        ),
+        QTYPES,
+    )
+
+  def test_view(self):
+    self.assertTrue(view.has_data_slice_view(kde.math.agg_approx_std(I.x)))
+
+  def test_alias(self):
+    self.assertTrue(
+        optools.equiv_to_op(kde.math.agg_approx_std, kde.agg_approx_std)
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,104 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.math._fused_pointwise."""
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.operators import kde_operators
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+P = arolla.P
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+
+
+def eval_unfused(x, y, z):
+  """Evaluates `(x * 2 + y) > z` one operator at a time."""
+  res = expr_eval.eval(kde.math.multiply(x, 2))
+  res = expr_eval.eval(kde.core.add(res, y))
+  return expr_eval.eval(kde.comparison.greater(res, z))
+
+
+class MathFusedPointwiseTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      (
+          # fn, args, expected
+          kde.math.multiply(P.x0, P.x1),
+          (ds([1, 2, None]), ds(3)),
+          ds([3, 6, None]),
+      ),
+      (
+          kde.core.add(kde.math.multiply(P.x0, P.x1), P.x0),
+          (ds([1.5, None, 2.0]), ds([2, 3, 4])),
+          ds([4.5, None, 10.0]),
+      ),
+      (
+          kde.comparison.less(kde.math.divide(P.x0, P.x1), P.x2),
+          (ds([[1, 2], [3]]), ds([2, 3]), ds(0.75)),
+          ds([[arolla.present(), None], [None]], schema_constants.MASK),
+      ),
+      # Non-numeric inputs are evaluated one operator at a time.
+      (
+          kde.core.add(kde.core.add(P.x0, P.x1), P.x2),
+          (ds(['a', 'b']), ds('c'), ds(['d', None])),
+          ds(['acd', None]),
+      ),
+      (
+          kde.math.subtract(kde.math.abs(P.x0), P.x1),
+          (ds([-1, 2], schema_constants.OBJECT), ds(1)),
+          ds([0, 1], schema_constants.OBJECT),
+      ),
+  )
+  def test_eval(self, fn, args, expected):
+    testing.assert_equal(
+        expr_eval.eval(kde.math._fused_pointwise(ds(arolla.quote(fn)), *args)),
+        expected,
+    )
+
+  @parameterized.parameters(
+      (ds([1, 2, 3]), ds([1, 0, None]), ds([3, 5, 7])),
+      (ds([1.5, None]), ds(1), ds([[3.0, 5.0], [None]])),
+      (ds([1, 2], schema_constants.INT64), ds([0.5, 1.5]), ds(3)),
+      (ds([1, 2], schema_constants.OBJECT), ds(1), ds([2, 5])),
+      (ds(None, schema_constants.INT32), ds(1), ds(0)),
+  )
+  def test_same_as_unfused(self, x, y, z):
+    testing.assert_equal(
+        expr_eval.eval((I.x * 2 + I.y) > I.z, x=x, y=y, z=z),
+        eval_unfused(x, y, z),
+    )
+
+  def test_same_error_as_unfused(self):
+    x = ds([1, 2])
+    y = ds(['a', 'b'])
+    z = ds([1, 2])
+    with self.assertRaisesRegex(
+        ValueError, 'expected numerics, got y: DENSE_ARRAY_TEXT'
+    ):
+      eval_unfused(x, y, z)
+    with self.assertRaisesRegex(
+        ValueError, 'expected numerics, got y: DENSE_ARRAY_TEXT'
+    ):
+      expr_eval.eval((I.x * 2 + I.y) > I.z, x=x, y=y, z=z)
+
+if __name__ == '__main__':
+  absltest.main()
@@ -0,0 +1,174 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.py.map_py."""
+
+import threading
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.operators import optools
+from koladata.testing import testing
+from koladata.types import data_bag
+from koladata.types import data_slice
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+bag = data_bag.DataBag.empty
+ds = data_slice.DataSlice.from_vals
+kde = kde_operators.kde
+
+
+class PyMapPyTest(parameterized.TestCase):
+
+  def test_per_item(self):
+    x = ds([[1, 2], [3]])
+    y = ds([[4, 5], [6]])
+    testing.assert_equal(
+        expr_eval.eval(kde.py.map_py(lambda x, y: x + y, x, y)),
+        ds([[5, 7], [9]]),
+    )
+
+  def test_items_are_python_values(self):
+    seen_types = set()
+
+    def fn(x):
+      seen_types.add(type(x))
+      return x
+
+    expr_eval.eval(kde.py.map_py(fn, ds([1, None, 3])))
+    self.assertEqual(seen_types, {int, type(None)})
+
+  def test_objects(self):
+    x = bag().obj(a=ds([1, 2]))
+    testing.assert_equal(
+        expr_eval.eval(kde.py.map_py(lambda x: x.a + 1, x)),
+        ds([2, 3]),
+    )
+
+  def test_0_dim(self):
+    testing.assert_equal(
+        expr_eval.eval(kde.py.map_py(lambda x: x * 2, ds(3))), ds(6)
+    )
+
+  def test_alignment(self):
+    x = ds(1)
+    y = ds([[1, 2], [3]])
+    testing.assert_equal(
+        expr_eval.eval(kde.py.map_py(lambda x, y: x + y, x, y)),
+        ds([[2, 3], [4]]),
+    )
+
+  def test_kwargs(self):
+    x = ds([1, 2, 3])
+    y = ds([4, 5, 6])
+    testing.assert_equal(
+        expr_eval.eval(kde.py.map_py(lambda x, y: x - y, y=y, x=x)),
+        ds([-3, -3, -3]),
+    )
+
+  def test_missing_items(self):
+    x = ds([1, None, 3])
+    testing.assert_equal(
+        expr_eval.eval(
+            kde.py.map_py(lambda x: None if x is None else x + 1, x)
+        ),
+        ds([2, None, 4]),
+    )
+
+  def test_schema(self):
+    x = ds([1, 2])
+    testing.assert_equal(
+        expr_eval.eval(
+            kde.py.map_py(lambda x: x, x, schema=schema_constants.FLOAT32)
+        ),
+        ds([1.0, 2.0]),
+    )
+    testing.assert_equal(
+        expr_eval.eval(
+            kde.py.map_py(
+                lambda x: None, ds([1, 2]), schema=schema_constants.INT64
+            )
+        ),
+        ds([None, None], schema_constants.INT64),
+    )
+
+  @parameterized.parameters(1, 2, 3, 10)
+  def test_batch_size(self, batch_size):
+    batch_sizes = []
+
+    def fn(xs, ys):
+      batch_sizes.append(len(xs))
+      self.assertIsInstance(xs, list)
+      return [x * y for x, y in zip(xs, ys)]
+
+    x = ds([[1, 2], [3, 4, 5]])
+    testing.assert_equal(
+        expr_eval.eval(kde.py.map_py(fn, x, x, batch_size=batch_size)),
+        ds([[1, 4], [9, 16, 25]]),
+    )
+    self.assertLessEqual(max(batch_sizes), batch_size)
+    self.assertEqual(sum(batch_sizes), 5)
+
+  @parameterized.parameters(None, 1, 4)
+  def test_max_threads(self, batch_size):
+    thread_ids = set()
+    lock = threading.Lock()
+
+    def fn(x):
+      with lock:
+        thread_ids.add(threading.get_ident())
+      return x
+
+    x = ds(list(range(100)))
+    testing.assert_equal(
+        expr_eval.eval(
+            kde.py.map_py(fn, x, max_threads=4, batch_size=batch_size)
+        ),
+        x,
+    )
+    self.assertNotEmpty(thread_ids)
+
+  def test_empty(self):
+    testing.assert_equal(
+        expr_eval.eval(kde.py.map_py(lambda x: x, ds([]))), ds([])
+    )
+
+  def test_errors(self):
+    with self.assertRaisesRegex(ValueError, 'at least one input DataSlice'):
+      expr_eval.eval(kde.py.map_py(lambda: 1))
+    with self.assertRaisesRegex(ValueError, 'max_threads must be positive'):
+      expr_eval.eval(kde.py.map_py(lambda x: x, ds([1]), max_threads=0))
+    with self.assertRaisesRegex(ValueError, 'batch_size must be positive'):
+      expr_eval.eval(kde.py.map_py(lambda x: x, ds([1]), batch_size=0))
+    with self.assertRaisesRegex(
+        ValueError, 'expected fn to return 2 items for a batch of 2 items'
+    ):
+      expr_eval.eval(
+          kde.py.map_py(lambda xs: xs[:1], ds([1, 2]), batch_size=2)
+      )
+
+  def test_view(self):
+    self.assertTrue(view.has_data_slice_view(kde.py.map_py(I.fn, I.x)))
+
+  def test_alias(self):
+    self.assertTrue(optools.equiv_to_op(kde.py.map_py, kde.map_py))
+
+
+if __name__ == '__main__':
+  absltest.main()
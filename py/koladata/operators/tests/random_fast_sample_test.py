@@ -0,0 +1,148 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for random.fast_sample."""
+
+import re
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.testing import testing
+from koladata.types import data_bag
+from koladata.types import data_slice
+from koladata.types import qtypes
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+bag = data_bag.DataBag.empty
+ds = data_slice.DataSlice.from_vals
+DATA_SLICE = qtypes.DATA_SLICE
+
+
+QTYPES = frozenset([
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE, arolla.UNSPECIFIED, DATA_SLICE),
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE, DATA_SLICE),
+])
+
+
+class RandomFastSampleTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      # x.ndim = 1
+      (ds([7, 2, 6, 3, None, 4, 1, 8]),),
+      (ds(['7', '2', '6', '3', None, '4', '1', '8']),),
+      # x.ndim = 2
+      (ds([[7, 2], [6, 3], [None, 4, 1], [8]]),),
+      # OBJECT schema
+      (ds([7, 2, 6, 3, None, 4, 1, 8], schema_constants.OBJECT),),
+      # mixed
+      (ds([7, 2.0, 6, 3.0, None, True, 1, 8]),),
+      # Lists
+      (bag().list([[1, 2], [3], [4], [5, 6]])[:],),
+  )
+  def test_eval(self, x):
+    sampled_1 = expr_eval.eval(kde.random.fast_sample(x, 0.5, 123))
+    sampled_2 = expr_eval.eval(kde.random.fast_sample(x, 0.5, 123))
+    testing.assert_equal(sampled_1, sampled_2)
+    self.assertLessEqual(sampled_1.get_size(), x.get_size())
+
+  def test_eval_large(self):
+    x = ds(list(range(100000)))
+    sampled_1 = expr_eval.eval(kde.random.fast_sample(x, 0.01, 123))
+    self.assertBetween(sampled_1.get_size(), 800, 1200)
+    sampled_2 = expr_eval.eval(kde.random.fast_sample(x, 0.01, 456))
+    self.assertNotEqual(sampled_1.fingerprint, sampled_2.fingerprint)
+
+  @parameterized.parameters(
+      (ds([None, None, None, None]),),
+      (ds([]),),
+  )
+  def test_eval_all_missing_or_empty(self, x):
+    sampled_1 = expr_eval.eval(kde.random.fast_sample(x, 0.5, 123))
+    sampled_2 = expr_eval.eval(kde.random.fast_sample(x, 0.5, 123))
+    testing.assert_equal(sampled_1, sampled_2)
+
+  def test_eval_with_key(self):
+    x_1 = ds([[1, 2, 3], [3, 4, 6, 7]])
+    key_1 = ds([['a', 'b', 'd'], ['c', 'd', 'e', 'f']])
+    sampled_1 = expr_eval.eval(
+        kde.sort(kde.random.fast_sample(x_1, 0.5, 123, key_1))
+    )
+    x_2 = ds([[2, 3, 1], [6, 3, 7, 4]])
+    key_2 = ds([['b', 'd', 'a'], ['e', 'c', 'f', 'd']])
+    sampled_2 = expr_eval.eval(
+        kde.sort(kde.random.fast_sample(x_2, 0.5, 123, key_2))
+    )
+    testing.assert_equal(sampled_1, sampled_2)
+
+    # All missing keys
+    key_3 = ds([[None, None, None], [None, None, None, None]])
+    sampled_3 = expr_eval.eval(kde.random.fast_sample(x_1, 1.0, 123, key_3))
+    self.assertEqual(sampled_3.get_size(), 0)
+
+  def test_ratio(self):
+    x = ds([[1, 2, 3], [3, 4, 6, 7]])
+    sampled = expr_eval.eval(kde.random.fast_sample(x, 1.5, 123))
+    testing.assert_equal(sampled, x)
+    sampled = expr_eval.eval(kde.random.fast_sample(x, 0.0, 123))
+    self.assertEqual(sampled.get_size(), 0)
+
+  def test_incompatible_shapes(self):
+    x = ds([[1, 2, 3], [3, 4, 6, 7]])
+    with self.assertRaisesRegex(ValueError, re.escape('same shape')):
+      _ = expr_eval.eval(kde.random.fast_sample(x, 0.5, 123, ds([2, 1])))
+
+  def test_x_as_data_item(self):
+    with self.assertRaisesRegex(ValueError, re.escape('expected rank(x) > 0')):
+      expr_eval.eval(kde.random.fast_sample(ds(1), 0.5, 123))
+
+  def test_wrong_ratio_and_seed(self):
+    x = ds([[1, 2, 3], [3, 4, 6, 7]])
+    with self.assertRaisesRegex(
+        ValueError, re.escape('`ratio` must be a scalar FLOAT64')
+    ):
+      _ = expr_eval.eval(kde.random.fast_sample(x, 'a', 123))
+    with self.assertRaisesRegex(
+        ValueError, re.escape('`seed` must be a scalar INT64')
+    ):
+      _ = expr_eval.eval(kde.random.fast_sample(x, 0.5, ds([123, 456])))
+
+  def test_qtype_signatures(self):
+    self.assertCountEqual(
+        arolla.testing.detect_qtype_signatures(
+            kde.random.fast_sample,
+            possible_qtypes=(
+                arolla.UNSPECIFIED,
+                qtypes.DATA_SLICE,
+                arolla.INT64,
+            ),
+        ),
+        QTYPES,
+    )
+
+  def test_view(self):
+    self.assertTrue(
+        view.has_data_slice_view(kde.random.fast_sample(I.x, I.ratio, I.seed))
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
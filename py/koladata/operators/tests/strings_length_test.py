@@ -51,6 +51,8 @@ class StringsLengthTest(parameterized.TestCase):
           ds([[3, None], [0, 2]]),
       ),
       (ds('你好'), ds(2)),
+      (ds(['你好', None, 'abc']), ds([2, None, 3])),
+      (ds([b'\xc3\x84', None, b'a']), ds([2, None, 1])),
       # Bytes
       (
           ds([b'abc', None, b'', b'ef']),
@@ -52,6 +52,11 @@ class StringsLowerTest(parameterized.TestCase):
       ),
       (ds('你好'), ds('你好')),
       (ds('Война и Мир.'), ds('война и мир.')),
+      # Non-ASCII values in a slice.
+      (
+          ds(['Война', None, 'ABC']),
+          ds(['война', None, 'abc']),
+      ),
       # OBJECT/ANY
       (
           ds(['ABC', None, '', 'EF'], schema_constants.OBJECT),
@@ -65,6 +65,14 @@ class StringsFormatTest(parameterized.TestCase):
           [ds('%v + %v'), ds([1, 2]), ds([[4, 5], [6]])],
           ds([['1 + 4', '1 + 5'], ['2 + 6']]),
       ),
+      (
+          [ds('%s-%d%%'), ds(['a', None, '']), ds([1, 2, -3])],
+          ds(['a-1%', None, '-3%']),
+      ),
+      (
+          [ds(b'[%v]'), ds([b'a', b'bc']), ds([1, None])],
+          ds([b'[a]', None]),
+      ),
       # Large arity.
       ([ds('%s'), *([ds('foo')] * 30)], ds('foo')),
       # Empty and unknown.
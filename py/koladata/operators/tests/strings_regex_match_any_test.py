@@ -0,0 +1,135 @@
+# Copyright 2024 Google LLC
+#
+# Licensed under the Apache License, Version 2.0 (the "License");
+# you may not use this file except in compliance with the License.
+# You may obtain a copy of the License at
+#
+#      http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing, software
+# distributed under the License is distributed on an "AS IS" BASIS,
+# WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+# See the License for the specific language governing permissions and
+# limitations under the License.
+
+"""Tests for kde.strings.regex_match_any."""
+
+import re
+
+from absl.testing import absltest
+from absl.testing import parameterized
+from arolla import arolla
+from koladata.expr import expr_eval
+from koladata.expr import input_container
+from koladata.expr import view
+from koladata.operators import kde_operators
+from koladata.operators.tests.util import qtypes as test_qtypes
+from koladata.testing import testing
+from koladata.types import data_slice
+from koladata.types import qtypes
+from koladata.types import schema_constants
+
+I = input_container.InputContainer('I')
+kde = kde_operators.kde
+ds = data_slice.DataSlice.from_vals
+DATA_SLICE = qtypes.DATA_SLICE
+
+present = arolla.present()
+missing = arolla.missing()
+
+QTYPES = frozenset([
+    (DATA_SLICE, DATA_SLICE, DATA_SLICE),
+])
+
+
+class StringsRegexMatchAnyTest(parameterized.TestCase):
+
+  @parameterized.parameters(
+      (ds('foo'), ds(['oo']), ds(present)),
+      (ds('foo'), ds(['^oo$', 'z']), ds(missing)),
+      (ds('foo'), ds(['^oo$', '^foo$']), ds(present)),
+      (
+          ds(['foo', 'bar', None, '']),
+          ds(['^f', 'z', 'a.$']),
+          ds([present, present, missing, missing]),
+      ),
+      (
+          ds([['foo', 'zoo'], ['bar', 'boat']]),
+          ds(['^z', 'at$']),
+          ds([[missing, present], [missing, present]]),
+      ),
+      (ds(['foo'], schema_constants.ANY), ds(['f']), ds([present])),
+      (ds(['foo'], schema_constants.OBJECT), ds(['f', None]), ds([present])),
+      # No patterns.
+      (ds(['foo', 'bar']), ds([], schema_constants.TEXT), ds([missing] * 2)),
+      (ds(['foo', 'bar']), ds([None, None]), ds([missing, missing])),
+      # Empty and unknown.
+      (
+          ds([None, None], schema_constants.OBJECT),
+          ds(['abc']),
+          ds([missing, missing]),
+      ),
+      (ds([None, None]), ds(['abc']), ds([missing, missing])),
+  )
+  def test_eval(self, text, regexes, expected):
+    result = expr_eval.eval(kde.strings.regex_match_any(text, regexes))
+    testing.assert_equal(result, expected)
+
+  def test_same_as_regex_match(self):
+    text = ds(['apple', 'banana', 'cherry', 'date', None, 'fig'])
+    patterns = ['^b', 'rr', 'g$', 'x', '^.{4}$']
+    expected = expr_eval.eval(kde.strings.regex_match(text, patterns[0]))
+    for pattern in patterns[1:]:
+      expected = expected | expr_eval.eval(
+          kde.strings.regex_match(text, pattern)
+      )
+    testing.assert_equal(
+        expr_eval.eval(kde.strings.regex_match_any(text, ds(patterns))),
+        expected,
+    )
+
+  def test_invalid_regexes_error(self):
+    with self.assertRaisesRegex(
+        ValueError,
+        re.escape('requires regexes to be a rank-1 TEXT DataSlice, got'),
+    ):
+      expr_eval.eval(kde.strings.regex_match_any(ds(['foo']), ds('foo')))
+    with self.assertRaisesRegex(
+        ValueError,
+        re.escape('requires regexes to be a rank-1 TEXT DataSlice, got'),
+    ):
+      expr_eval.eval(kde.strings.regex_match_any(ds(['foo']), ds([b'foo'])))
+
+  def test_invalid_pattern_error(self):
+    with self.assertRaisesRegex(
+        ValueError, re.escape('invalid regular expression: `(`')
+    ):
+      expr_eval.eval(kde.strings.regex_match_any(ds(['foo']), ds(['a', '('])))
+
+  def test_non_text_error(self):
+    with self.assertRaisesRegex(
+        ValueError, re.escape('requires text to be TEXT, got')
+    ):
+      expr_eval.eval(kde.strings.regex_match_any(ds([b'foo']), ds(['f'])))
+
+  def test_mixed_slice_error(self):
+    with self.assertRaisesRegex(
+        ValueError, 'DataSlice with mixed types is not supported'
+    ):
+      expr_eval.eval(kde.strings.regex_match_any(ds([1, 'fo']), ds(['foo'])))
+
+  def test_qtype_signatures(self):
+    arolla.testing.assert_qtype_signatures(
+        kde.strings.regex_match_any,
+        QTYPES,
+        possible_qtypes=test_qtypes.DETECT_SIGNATURES_QTYPES,
+    )
+
+  def test_view(self):
+    self.assertTrue(
+        view.has_data_slice_view(kde.strings.regex_match_any(I.x, I.y))
+    )
+
+
+if __name__ == '__main__':
+  absltest.main()
@@ -46,6 +46,7 @@ class StringsSplitTest(parameterized.TestCase):
   @parameterized.parameters(
       (ds(['Hello world!']), ds([['Hello', 'world!']])),
       (ds([' ']), ds([[]], schema_constants.TEXT)),
+      (ds(['  a\tb\n c ', None]), ds([['a', 'b', 'c'], []])),
       (ds([], schema_constants.TEXT), ds([], schema_constants.TEXT).repeat(0)),
       (ds([b'Hello world!']), ds([[b'Hello', b'world!']])),
       (ds([b'Hello world!']), ds([[b'Hello', b'world!']])),
@@ -109,6 +110,7 @@ class StringsSplitTest(parameterized.TestCase):
       ),
       (ds(['Hello world!']), ds('world'), ds([['Hello ', '!']])),
       (ds(['']), ds('ab'), ds([['']])),
+      (ds(['a,,b', None, ',']), ds(','), ds([['a', '', 'b'], [], ['', '']])),
       (ds([b'Byte split']), ds(b'sp'), ds([[b'Byte ', b'lit']])),
       (
           ds(['splits seven syllables by `s`']),
@@ -56,6 +56,11 @@ class StringsUpperTest(parameterized.TestCase):
           ds([['ABC', None], ['', 'EF']]),
       ),
       (ds('你好'), ds('你好')),
+      # Non-ASCII values in a slice.
+      (
+          ds(['война', None, 'abc']),
+          ds(['ВОЙНА', None, 'ABC']),
+      ),
       # OBJECT/ANY
       (
           ds(['abc', None, '', 'ef'], schema_constants.OBJECT),
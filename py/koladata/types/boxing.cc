@@ -27,6 +27,7 @@
 #include <utility>
 #include <vector>
 
+#include "absl/algorithm/container.h"
 #include "absl/base/nullability.h"
 #include "absl/container/flat_hash_map.h"
 #include "absl/container/flat_hash_set.h"
@@ -62,6 +63,7 @@
 #include "arolla/dense_array/edge.h"
 #include "arolla/dense_array/qtype/types.h"
 #include "arolla/expr/quote.h"
+#include "arolla/memory/buffer.h"
 #include "arolla/memory/optional_value.h"
 #include "arolla/qtype/qtype.h"
 #include "arolla/qtype/qtype_traits.h"
@@ -258,6 +260,89 @@ absl::Status ParsePyObject(PyObject* py_obj, const DataItem& explicit_schema,
                       Py_TYPE(py_obj)->tp_name));
 }
 
+// Converts `flat_list` directly into a DenseArray (returned together with its
+// dtype) if all of its items are Python objects of the same exact type: int,
+// float, str or bytes. The result is the same as the one of the generic path
+// (ints are INT32, unless some of them do not fit, floats are FLOAT32).
+// Returns std::nullopt if the items are not homogeneous, in which case the
+// generic path should be used.
+absl::StatusOr<
+    std::optional<std::pair<internal::DataSliceImpl, schema::DType>>>
+HomogeneousPrimitivesFromPyFlatList(const std::vector<PyObject*>& flat_list) {
+  if (flat_list.empty()) {
+    return std::nullopt;
+  }
+  PyTypeObject* py_type = Py_TYPE(flat_list[0]);
+  for (PyObject* py_obj : flat_list) {
+    if (Py_TYPE(py_obj) != py_type) {
+      return std::nullopt;
+    }
+  }
+  const int64_t size = flat_list.size();
+  if (py_type == &PyLong_Type) {
+    arolla::Buffer<int64_t>::Builder bldr(size);
+    bool fits_int32 = true;
+    for (int64_t i = 0; i < size; ++i) {
+      int overflow = 0;
+      auto val = PyLong_AsLongLongAndOverflow(flat_list[i], &overflow);
+      if (overflow) {
+        // Same wrapping as in ParsePyObject.
+        val = static_cast<decltype(val)>(
+            PyLong_AsUnsignedLongLongMask(flat_list[i]));
+      }
+      fits_int32 = fits_int32 && !overflow && val <= INT_MAX && val >= INT_MIN;
+      bldr.Set(i, static_cast<int64_t>(val));
+    }
+    arolla::Buffer<int64_t> values = std::move(bldr).Build();
+    if (!fits_int32) {
+      return std::pair(internal::DataSliceImpl::Create(
+                           arolla::DenseArray<int64_t>{std::move(values)}),
+                       schema::kInt64);
+    }
+    arolla::Buffer<int>::Builder int32_bldr(size);
+    for (int64_t i = 0; i < size; ++i) {
+      int32_bldr.Set(i, static_cast<int>(values[i]));
+    }
+    return std::pair(
+        internal::DataSliceImpl::Create(
+            arolla::DenseArray<int>{std::move(int32_bldr).Build()}),
+        schema::kInt32);
+  }
+  if (py_type == &PyFloat_Type) {
+    arolla::Buffer<float>::Builder bldr(size);
+    for (int64_t i = 0; i < size; ++i) {
+      bldr.Set(i, static_cast<float>(PyFloat_AS_DOUBLE(flat_list[i])));
+    }
+    return std::pair(internal::DataSliceImpl::Create(
+                         arolla::DenseArray<float>{std::move(bldr).Build()}),
+                     schema::kFloat32);
+  }
+  if (py_type == &PyUnicode_Type) {
+    arolla::DenseArrayBuilder<Text> bldr(size);
+    for (int64_t i = 0; i < size; ++i) {
+      Py_ssize_t str_size;
+      const char* data = PyUnicode_AsUTF8AndSize(flat_list[i], &str_size);
+      if (data == nullptr) {
+        return arolla::python::StatusCausedByPyErr(
+            absl::StatusCode::kInvalidArgument, "invalid unicode object");
+      }
+      bldr.Set(i, absl::string_view(data, str_size));
+    }
+    return std::pair(internal::DataSliceImpl::Create(std::move(bldr).Build()),
+                     schema::kText);
+  }
+  if (py_type == &PyBytes_Type) {
+    arolla::DenseArrayBuilder<Bytes> bldr(size);
+    for (int64_t i = 0; i < size; ++i) {
+      bldr.Set(i, absl::string_view(PyBytes_AS_STRING(flat_list[i]),
+                                    PyBytes_GET_SIZE(flat_list[i])));
+    }
+    return std::pair(internal::DataSliceImpl::Create(std::move(bldr).Build()),
+                     schema::kBytes);
+  }
+  return std::nullopt;
+}
+
 // Creates a DataSlice from a flat vector of PyObject(s), shape and type of
 // items. In case, edges is empty, we have a single value and treat it as 0-dim
 // output.
@@ -296,9 +381,21 @@ absl::StatusOr<DataSlice> DataSliceFromPyFlatList(
   };
   if (schema.has_value()) {
     return impl.operator()<true>();
-  } else {
-    return impl.operator()<false>();
   }
+  // Fast path for flat lists of Python primitives of the same type, which
+  // skips the per-item schema aggregation.
+  if (!edges.empty()) {
+    ASSIGN_OR_RETURN(auto homogeneous,
+                     HomogeneousPrimitivesFromPyFlatList(flat_list));
+    if (homogeneous.has_value()) {
+      auto& [values, dtype] = *homogeneous;
+      ASSIGN_OR_RETURN(auto shape,
+                       DataSlice::JaggedShape::FromEdges(std::move(edges)));
+      return DataSlice::Create(std::move(values), std::move(shape),
+                               DataItem(dtype));
+    }
+  }
+  return impl.operator()<false>();
 }
 
 // Parses the Python list and creates a DataSlice from its items with
@@ -568,6 +665,23 @@ absl::StatusOr<absl::string_view> PyDictKeyAsStringView(PyObject* py_key) {
           Py_TYPE(py_key)->tp_name));
 }
 
+// Returns true if `py_obj` is None, bool, int, float, str or bytes, i.e. a
+// value that is converted to a primitive DataItem regardless of its context.
+bool IsPyPrimitive(PyObject* py_obj) {
+  return py_obj == Py_None || PyBool_Check(py_obj) ||
+         PyLong_CheckExact(py_obj) || PyFloat_CheckExact(py_obj) ||
+         PyUnicode_CheckExact(py_obj) || PyBytes_CheckExact(py_obj);
+}
+
+// Converts Python primitives `py_items` into a 1-dim DataSlice at once.
+absl::StatusOr<DataSlice> PyPrimitivesToDataSlice(
+    const std::vector<PyObject*>& py_items, AdoptionQueue& adoption_queue) {
+  ASSIGN_OR_RETURN(auto edge, arolla::DenseArrayEdge::FromUniformGroups(
+                                  1, py_items.size()));
+  return DataSliceFromPyFlatList(py_items, {std::move(edge)},
+                                 /*schema=*/DataItem(), adoption_queue);
+}
+
 // Converts Python objects into DataSlices and converts them into appropriate
 // Koda abstractions using `Factory`.
 // `Factory` can be:
@@ -656,6 +770,28 @@ class UniversalConverter {
                             db_);
   }
 
+  // Collects the keys and values of the python dictionary `py_obj` into
+  // `py_keys` and `py_values` if all of them are Python primitives. Returns
+  // false otherwise.
+  static bool CollectPrimitiveDictItems(PyObject* py_obj,
+                                        std::vector<PyObject*>& py_keys,
+                                        std::vector<PyObject*>& py_values) {
+    const size_t dict_size = PyDict_Size(py_obj);
+    py_keys.reserve(dict_size);
+    py_values.reserve(dict_size);
+    Py_ssize_t pos = 0;
+    PyObject* py_key;
+    PyObject* py_value;
+    while (PyDict_Next(py_obj, &pos, &py_key, &py_value)) {
+      if (!IsPyPrimitive(py_key) || !IsPyPrimitive(py_value)) {
+        return false;
+      }
+      py_keys.push_back(py_key);
+      py_values.push_back(py_value);
+    }
+    return true;
+  }
+
   // Collects the keys and values of the python dictionary `py_obj`, and
   // arranges the appropriate commands on the stack for their processing.
   absl::Status ParsePyDict(PyObject* py_obj,
@@ -847,12 +983,33 @@ class UniversalConverter {
         });
         return ParsePyDictAsObj(py_obj, schema);
       }
+      if (std::vector<PyObject*> py_keys, py_values;
+          CollectPrimitiveDictItems(py_obj, py_keys, py_values)) {
+        // Dicts of primitives are the most common leaves, so their keys and
+        // values are converted at once, without a command per item.
+        ASSIGN_OR_RETURN(auto keys,
+                         PyPrimitivesToDataSlice(py_keys, adoption_queue_));
+        ASSIGN_OR_RETURN(auto values,
+                         PyPrimitivesToDataSlice(py_values, adoption_queue_));
+        return ComputeDict(py_obj, std::move(keys), std::move(values), schema);
+      }
       cmd_stack_.push([this, py_obj, schema = schema] {
         return this->CmdComputeDict(py_obj, schema);
       });
       return ParsePyDict(py_obj, schema);
     }
     if (PyList_CheckExact(py_obj) || PyTuple_CheckExact(py_obj)) {
+      absl::Span<PyObject*> py_items(PySequence_Fast_ITEMS(py_obj),
+                                     PySequence_Fast_GET_SIZE(py_obj));
+      if (absl::c_all_of(py_items, IsPyPrimitive)) {
+        // Same as for dicts above.
+        ASSIGN_OR_RETURN(
+            auto items,
+            PyPrimitivesToDataSlice(
+                std::vector<PyObject*>(py_items.begin(), py_items.end()),
+                adoption_queue_));
+        return ComputeList(py_obj, std::move(items), schema);
+      }
       cmd_stack_.push([this, py_obj, schema = schema] {
         return this->CmdComputeList(py_obj, schema);
       });
@@ -895,6 +1052,14 @@ class UniversalConverter {
     size_t dict_size = PyDict_Size(py_obj);
     ASSIGN_OR_RETURN(auto keys, ComputeDataSlice(dict_size));
     ASSIGN_OR_RETURN(auto values, ComputeDataSlice(dict_size));
+    return ComputeDict(py_obj, std::move(keys), std::move(values),
+                       dict_schema);
+  }
+
+  // Assembles `keys` and `values` into a dictionary and pushes it to
+  // `value_stack_`.
+  absl::Status ComputeDict(PyObject* py_obj, DataSlice keys, DataSlice values,
+                           const std::optional<DataSlice>& dict_schema) {
     ASSIGN_OR_RETURN(
         auto res,
         CreateDictShaped(db_, DataSlice::JaggedShape::Empty(), std::move(keys),
@@ -913,6 +1078,12 @@ class UniversalConverter {
                               const std::optional<DataSlice>& list_schema) {
     const size_t list_size = PySequence_Fast_GET_SIZE(py_obj);
     ASSIGN_OR_RETURN(auto items, ComputeDataSlice(list_size));
+    return ComputeList(py_obj, std::move(items), list_schema);
+  }
+
+  // Assembles `items` into a list and pushes it to `value_stack_`.
+  absl::Status ComputeList(PyObject* py_obj, DataSlice items,
+                           const std::optional<DataSlice>& list_schema) {
     ASSIGN_OR_RETURN(
         auto res,
         CreateListShaped(db_, DataSlice::JaggedShape::Empty(), std::move(items),
@@ -399,6 +399,27 @@ class BoxingTest(parameterized.TestCase):
             ds(py_val, dtype).internal_as_py(), py_val, places=5
         )
 
+  def test_from_vals_homogeneous_lists(self):
+    x = ds([1, 2, 3])
+    testing.assert_equal(x.get_schema(), INT32)
+    self.assertEqual(x.internal_as_py(), [1, 2, 3])
+    x = ds([[1, 1 << 43], [(1 << 100) + 43]])
+    testing.assert_equal(x.get_schema(), INT64)
+    self.assertEqual(x.internal_as_py(), [[1, 1 << 43], [43]])
+    x = ds([1.5, 2.5])
+    testing.assert_equal(x.get_schema(), FLOAT32)
+    self.assertEqual(x.internal_as_py(), [1.5, 2.5])
+    x = ds(['a', 'bc'])
+    testing.assert_equal(x.get_schema(), TEXT)
+    self.assertEqual(x.internal_as_py(), ['a', 'bc'])
+    x = ds([b'a', b'bc'])
+    testing.assert_equal(x.get_schema(), BYTES)
+    self.assertEqual(x.internal_as_py(), [b'a', b'bc'])
+    # Lists with mixed types fall back to the generic conversion.
+    x = ds([1, True, None])
+    testing.assert_equal(x.get_schema(), OBJECT)
+    self.assertEqual(x.internal_as_py(), [1, True, None])
+
   def test_from_vals_all_empty(self):
     with self.subTest('no dtype provided'):
       x = ds([[None, None, None], [None, None]])
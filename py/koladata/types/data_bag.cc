@@ -17,6 +17,9 @@
 #include <Python.h>
 
 #include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
 #include <optional>
 #include <string>
 #include <utility>
@@ -25,6 +28,8 @@
 #include "absl/base/no_destructor.h"
 #include "absl/base/nullability.h"
 #include "absl/log/check.h"
+#include "absl/status/status.h"
+#include "absl/status/statusor.h"
 #include "absl/strings/str_cat.h"
 #include "absl/strings/string_view.h"
 #include "absl/types/span.h"
@@ -38,6 +43,7 @@
 #include "koladata/internal/dtype.h"
 #include "koladata/object_factories.h"
 #include "koladata/repr_utils.h"
+#include "koladata/s11n/columnar.h"
 #include "py/arolla/abc/py_qvalue.h"
 #include "py/arolla/abc/py_qvalue_specialization.h"
 #include "py/arolla/py_utils/py_utils.h"
@@ -1254,20 +1260,40 @@ absl::Nullable<PyObject*> PyDataBag_merge_inplace(PyObject* self,
   int allow_schema_conflicts = PyObject_IsTrue(args[2]);
   if (allow_schema_conflicts == -1) return nullptr;
   const auto& db = UnsafeDataBagPtr(self);
+  std::vector<DataBagPtr> others;
+  others.reserve(nargs - 3);
   for (int i = 3; i < nargs; ++i) {
     auto other = UnwrapDataBagPtr(args[i], "each DataBag to be merged");
     if (other == nullptr) return nullptr;
-    RETURN_IF_ERROR(db->MergeInplace(other, overwrite, allow_data_conflicts,
-                                     allow_schema_conflicts))
-        .With(SetKodaPyErrFromStatus);
+    others.push_back(std::move(other));
+  }
+  // DataBags do not track their size, so merging always releases the GIL:
+  // it is never cheap compared to releasing it.
+  absl::Status status;
+  {
+    arolla::python::ReleasePyGIL guard;
+    for (const DataBagPtr& other : others) {
+      status = db->MergeInplace(other, overwrite, allow_data_conflicts,
+                                allow_schema_conflicts);
+      if (!status.ok()) {
+        break;
+      }
+    }
   }
+  RETURN_IF_ERROR(status).With(SetKodaPyErrFromStatus);
   Py_RETURN_NONE;
 }
 
 absl::Nullable<PyObject*> PyDataBag_merge_fallbacks(PyObject* self, PyObject*) {
   arolla::python::DCheckPyGIL();
   const auto& db = UnsafeDataBagPtr(self);
-  ASSIGN_OR_RETURN(auto res, db->MergeFallbacks(), SetKodaPyErrFromStatus(_));
+  absl::StatusOr<DataBagPtr> res_or_error;
+  {
+    arolla::python::ReleasePyGIL guard;
+    res_or_error = db->MergeFallbacks();
+  }
+  ASSIGN_OR_RETURN(auto res, std::move(res_or_error),
+                   SetKodaPyErrFromStatus(_));
   return WrapDataBagPtr(std::move(res));
 }
 
@@ -1293,10 +1319,27 @@ absl::Nullable<PyObject*> PyDataBag_fork(PyObject* self,
   return WrapDataBagPtr(std::move(res));
 }
 
-absl::Nullable<PyObject*> PyDataBag_contents_repr(PyObject* self, PyObject*) {
+absl::Nullable<PyObject*> PyDataBag_contents_repr(PyObject* self,
+                                                  PyObject* const* py_args,
+                                                  Py_ssize_t nargs,
+                                                  PyObject* py_kwnames) {
+  arolla::python::DCheckPyGIL();
+  static const absl::NoDestructor<FastcallArgParser> parser(
+      /*pos_only_n=*/0, /*parse_kwargs=*/false, "triple_limit");
+  FastcallArgParser::Args args;
+  if (!parser->Parse(py_args, nargs, py_kwnames, args)) {
+    return nullptr;
+  }
+  DataBagReprOption option;
+  if (args.pos_kw_values[0] != nullptr && args.pos_kw_values[0] != Py_None) {
+    option.triple_limit = PyLong_AsLongLong(args.pos_kw_values[0]);
+    if (PyErr_Occurred()) {
+      return nullptr;
+    }
+  }
   const DataBagPtr db = UnsafeDataBagPtr(self);
 
-  ASSIGN_OR_RETURN(std::string str, DataBagToStr(db),
+  ASSIGN_OR_RETURN(std::string str, DataBagToStr(db, option),
                    SetKodaPyErrFromStatus(_));
   return PyUnicode_FromStringAndSize(str.c_str(), str.size());
 }
@@ -1314,6 +1357,142 @@ absl::Nullable<PyObject*> PyDataBag_get_fallbacks(PyObject* self, PyObject*) {
   return fallback_list.release();
 }
 
+absl::Nullable<PyObject*> PyDataBag_memory_usage(PyObject* self, PyObject*) {
+  arolla::python::DCheckPyGIL();
+  const DataBagPtr& db = UnsafeDataBagPtr(self);
+  internal::DataBagMemoryUsage usage;
+  {
+    // Iterates over all the data structures, so the GIL is released.
+    arolla::python::ReleasePyGIL guard;
+    usage = db->EstimateMemoryUsage();
+  }
+  auto kind_name = [](internal::DataBagMemoryUsage::StorageKind kind) {
+    switch (kind) {
+      case internal::DataBagMemoryUsage::StorageKind::kDenseSource:
+        return "dense";
+      case internal::DataBagMemoryUsage::StorageKind::kSparseSource:
+        return "sparse";
+      case internal::DataBagMemoryUsage::StorageKind::kLists:
+        return "lists";
+      case internal::DataBagMemoryUsage::StorageKind::kDicts:
+        return "dicts";
+    }
+    return "unknown";
+  };
+  auto py_list =
+      arolla::python::PyObjectPtr::Own(PyList_New(usage.entries.size()));
+  if (py_list == nullptr) {
+    return nullptr;
+  }
+  int i = 0;
+  for (const auto& [key, entry] : usage.entries) {
+    const auto& [attr, kind] = key;
+    PyObject* py_entry = Py_BuildValue("(s#sLL)", attr.data(),
+                                       static_cast<Py_ssize_t>(attr.size()),
+                                       kind_name(kind), entry.owned,
+                                       entry.shared);
+    if (py_entry == nullptr) {
+      return nullptr;
+    }
+    PyList_SetItem(py_list.get(), i++, py_entry);
+  }
+  return py_list.release();
+}
+
+absl::Nullable<PyObject*> PyDataBag_to_columnar(PyObject* self, PyObject*) {
+  arolla::python::DCheckPyGIL();
+  DataBagPtr db = UnsafeDataBagPtr(self);
+  absl::StatusOr<int64_t> size_or_error;
+  {
+    arolla::python::ReleasePyGIL guard;
+    size_or_error = [&]() -> absl::StatusOr<int64_t> {
+      if (!db->GetFallbacks().empty()) {
+        ASSIGN_OR_RETURN(db, db->MergeFallbacks());
+      }
+      // A dry run to size the result. It does not copy the attribute values,
+      // but lists, dicts and the layout are serialized twice. It also detects
+      // the unsupported values before anything is allocated.
+      int64_t size = 0;
+      RETURN_IF_ERROR(s11n::WriteColumnarDataBag(
+          db->GetImpl(), [&](absl::string_view chunk) {
+            size += chunk.size();
+            return absl::OkStatus();
+          }));
+      return size;
+    }();
+  }
+  if (absl::IsUnimplemented(size_or_error.status())) {
+    // E.g. ExprQuote values, which are not supported by the columnar format.
+    Py_RETURN_NONE;
+  }
+  ASSIGN_OR_RETURN(int64_t size, std::move(size_or_error),
+                   SetKodaPyErrFromStatus(_));
+  // Serializes directly into the bytes object to avoid an extra copy of the
+  // (potentially large) attribute values.
+  auto py_bytes = arolla::python::PyObjectPtr::Own(
+      PyBytes_FromStringAndSize(nullptr, size));
+  if (py_bytes == nullptr) {
+    return nullptr;
+  }
+  char* data = PyBytes_AS_STRING(py_bytes.get());
+  absl::Status status;
+  {
+    arolla::python::ReleasePyGIL guard;
+    int64_t offset = 0;
+    status = s11n::WriteColumnarDataBag(
+        db->GetImpl(), [&](absl::string_view chunk) {
+          if (offset + static_cast<int64_t>(chunk.size()) > size) {
+            return absl::FailedPreconditionError(
+                "DataBag was modified during serialization");
+          }
+          std::memcpy(data + offset, chunk.data(), chunk.size());
+          offset += chunk.size();
+          return absl::OkStatus();
+        });
+    if (status.ok() && offset != size) {
+      status = absl::FailedPreconditionError(
+          "DataBag was modified during serialization");
+    }
+  }
+  RETURN_IF_ERROR(status).With(SetKodaPyErrFromStatus);
+  return py_bytes.release();
+}
+
+absl::Nullable<PyObject*> PyDataBag_from_columnar(PyTypeObject*,
+                                                  PyObject* py_data) {
+  arolla::python::DCheckPyGIL();
+  auto view = std::make_unique<Py_buffer>();
+  if (PyObject_GetBuffer(py_data, view.get(), PyBUF_SIMPLE) < 0) {
+    return nullptr;
+  }
+  absl::string_view data(static_cast<const char*>(view->buf), view->len);
+  // The decoded attribute values reference the buffer, so it is released
+  // only when the DataBag is destroyed (possibly without the GIL held).
+  std::shared_ptr<const void> holder(
+      view.release(), [](Py_buffer* buffer) {
+        arolla::python::AcquirePyGIL guard;
+        PyBuffer_Release(buffer);
+        delete buffer;
+      });
+  if (reinterpret_cast<uintptr_t>(data.data()) %
+          alignof(std::max_align_t) != 0) {
+    // E.g. a slice of a larger buffer: the values must be aligned, so they are
+    // copied.
+    std::shared_ptr<char[]> copy(new char[data.size()]);
+    std::memcpy(copy.get(), data.data(), data.size());
+    data = absl::string_view(copy.get(), data.size());
+    holder = std::move(copy);
+  }
+  absl::StatusOr<internal::DataBagImplPtr> impl_or_error;
+  {
+    arolla::python::ReleasePyGIL guard;
+    impl_or_error = s11n::DecodeColumnarDataBag(std::move(holder), data);
+  }
+  ASSIGN_OR_RETURN(auto impl, std::move(impl_or_error),
+                   SetKodaPyErrFromStatus(_));
+  return WrapDataBagPtr(DataBag::FromImpl(std::move(impl)));
+}
+
 PyMethodDef kPyDataBag_methods[] = {
     {"is_mutable", (PyCFunction)PyDataBag_is_mutable, METH_NOARGS,
      "Returns present iff this DataBag is mutable."},
@@ -1513,14 +1692,42 @@ Args:
 Returns:
   data_bag.DataBag
 )"""},
-    {"contents_repr", PyDataBag_contents_repr, METH_NOARGS,
-     "Returns a string representation of the contents of this DataBag."},
+    {"contents_repr", (PyCFunction)PyDataBag_contents_repr,
+     METH_FASTCALL | METH_KEYWORDS,
+     R"""(Returns a string representation of the contents of this DataBag.
+
+Args:
+  triple_limit: If set, the maximum number of triples to show for the data and
+    for the schemas of each DataBag. Only the shown triples are visited, in the
+    storage order.
+Returns:
+  str
+)"""},
     {"get_fallbacks", PyDataBag_get_fallbacks, METH_NOARGS,
      R"""(Returns the list of fallback DataBags in this DataBag.
 
 The list will be empty if the DataBag does not have fallbacks. When
 `DataSlice.with_fallback` is called, the original and provided DataBag will be
 added to the fallback list of the newly created DataBag.)"""},
+    {"_memory_usage", PyDataBag_memory_usage, METH_NOARGS,
+     R"""(Returns the estimated memory usage of this DataBag.
+
+Returns a list of tuples (attr, kind, owned_bytes, shared_bytes) sorted by
+attr and kind, where kind is one of 'dense', 'sparse', 'lists' and 'dicts'.
+Lists and dicts have an empty attr. Shared bytes belong to the parents of
+this DataBag (e.g. the DataBag it was forked from) or to its fallbacks. All
+the numbers are estimates.)"""},
+    {"_to_columnar", PyDataBag_to_columnar, METH_NOARGS,
+     R"""(Returns this DataBag serialized into bytes in the columnar format.
+
+The fallbacks are merged into the result. Returns None if the DataBag has
+values the format does not support (e.g. ExprQuote). Used for pickling.)"""},
+    {"_from_columnar", (PyCFunction)PyDataBag_from_columnar,
+     METH_CLASS | METH_O,
+     R"""(Creates a DataBag from an object with the columnar format data.
+
+Attribute values of the result reference the buffer of the object without
+copying, so the buffer must not be modified while the DataBag is alive.)"""},
     {nullptr} /* sentinel */
 };
 
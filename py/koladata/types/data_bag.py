@@ -14,6 +14,7 @@
 
 """DataBag abstraction."""
 
+import pickle
 from typing import Any, Iterable
 
 from koladata.types import data_bag_py_ext as _data_bag_py_ext
@@ -383,7 +384,38 @@ def _merge_inplace(
   return self
 
 
+def _from_columnar(data: Any) -> DataBag:
+  return DataBag._from_columnar(data)  # pylint: disable=protected-access
+
+
+def _reduce_ex(self: DataBag, protocol: int) -> Any:
+  """Pickles the DataBag in the columnar format.
+
+  With protocol 5 the serialized data is passed as a `pickle.PickleBuffer`, so
+  it can be transferred out-of-band (see `buffer_callback` of `pickle.dumps`).
+  The unpickled DataBag then references the transferred buffer without copying
+  the attribute values.
+
+  DataBags with values the columnar format does not support (e.g. ExprQuote)
+  are pickled with the Arolla serialization instead.
+
+  Args:
+    self: DataBag to pickle.
+    protocol: pickle protocol.
+
+  Returns:
+    A tuple of a callable and its arguments that recreate the DataBag.
+  """
+  data = self._to_columnar()  # pylint: disable=protected-access
+  if data is None:
+    return super(DataBag, self).__reduce_ex__(protocol)
+  if protocol >= 5:
+    data = pickle.PickleBuffer(data)
+  return _from_columnar, (data,)
+
+
 DataBag.__getitem__ = _getitem
+DataBag.__reduce_ex__ = _reduce_ex
 DataBag.dict = _dict
 DataBag.dict_like = _dict_like
 DataBag.dict_shaped = _dict_shaped
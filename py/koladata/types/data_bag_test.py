@@ -15,6 +15,7 @@
 """Tests for data_bag."""
 
 import gc
+import pickle
 import re
 import sys
 
@@ -265,6 +266,21 @@ k[0-9a-f]{32}:0\.(b|a) => (INT32|OBJECT)
 k[0-9a-f]{32}:0\.(b|a) => (OBJECT|INT32)
 """)
 
+  def test_contents_repr_triple_limit(self):
+    db = bag()
+    db.new(a=1, b=2, c=3)
+    self.assertRegex(
+        db.contents_repr(triple_limit=1),
+        r"""DataBag \$[0-9a-f]{4}:
+\$[0-9a-f]{32}:0\.a => 1
+\.\.\.
+
+SchemaBag:
+\$[0-9a-f]{32}:0\.[abc] => INT32
+\.\.\.
+$""")
+    self.assertEqual(db.contents_repr(triple_limit=None), db.contents_repr())
+
   def test_contents_repr_fallback(self):
     db = bag()
     entity = db.new(x=1)
@@ -1297,6 +1313,35 @@ Assigned schema for Dict key: INT32""",
       db = bag()
       self.assertEmpty(db.get_fallbacks())
 
+  def test_memory_usage(self):
+    def usage_dict(db):
+      return {
+          (attr, kind): (owned, shared)
+          for attr, kind, owned, shared in db._memory_usage()
+      }
+
+    db1 = bag()
+    self.assertEqual(db1._memory_usage(), [])
+    x1 = db1.new(a=1)
+    usage1 = usage_dict(db1)
+    owned, shared = usage1[('a', 'sparse')]
+    self.assertGreater(owned, 0)
+    self.assertEqual(shared, 0)
+    self.assertIn(('', 'dicts'), usage1)
+
+    with self.subTest('fork'):
+      db2 = db1.fork()
+      x1.with_db(db2).set_attr('a', 2)
+      owned, shared = usage_dict(db2)[('a', 'sparse')]
+      self.assertGreater(owned, 0)
+      self.assertEqual(shared, usage1[('a', 'sparse')][0])
+
+    with self.subTest('fallback'):
+      db3 = x1.with_fallback(bag()).db
+      owned, shared = usage_dict(db3)[('a', 'sparse')]
+      self.assertEqual(owned, 0)
+      self.assertEqual(shared, usage1[('a', 'sparse')][0])
+
   def test_exactly_equal_impl(self):
     db1 = bag()
     db2 = bag()
@@ -1523,6 +1568,53 @@ Assigned schema for Dict key: INT32""",
     y = x.with_name('foo')
     self.assertIs(y, x)
 
+  @parameterized.parameters(2, 4, 5)
+  def test_pickle(self, protocol):
+    db = bag()
+    x = db.new(a=ds([1, 2, 3]), b=ds(['x', 'y', None]))
+    db2 = pickle.loads(pickle.dumps(db, protocol=protocol))
+    self.assertIsInstance(db2, data_bag.DataBag)
+    x2 = x.with_db(db2)
+    testing.assert_equal(x2.a.no_db(), ds([1, 2, 3]))
+    testing.assert_equal(x2.b.no_db(), ds(['x', 'y', None]))
+
+    # The unpickled DataBag is independent.
+    x2.set_attr('a', 4)
+    testing.assert_equal(x.a.no_db(), ds([1, 2, 3]))
+
+  def test_pickle_out_of_band(self):
+    db = bag()
+    x = db.new(a=ds(list(range(1000))))
+    buffers = []
+    data = pickle.dumps(db, protocol=5, buffer_callback=buffers.append)
+    self.assertLen(buffers, 1)
+    self.assertLess(len(data), 1000)
+    db2 = pickle.loads(data, buffers=buffers)
+    testing.assert_equal(x.with_db(db2).a.no_db(), ds(list(range(1000))))
+
+  def test_pickle_fallbacks(self):
+    db1 = bag()
+    x = db1.new(a=1)
+    db2 = bag()
+    x.with_db(db2).set_attr('b', 2)
+    y = x.with_db(db2).with_fallback(db1)
+    db3 = pickle.loads(pickle.dumps(y.db, protocol=5))
+    self.assertEmpty(db3.get_fallbacks())
+    testing.assert_equal(x.with_db(db3).a.no_db(), ds(1))
+    testing.assert_equal(x.with_db(db3).b.no_db(), ds(2))
+
+  @parameterized.parameters(2, 5)
+  def test_pickle_expr_quote(self, protocol):
+    # Not supported by the columnar format, pickled with the Arolla
+    # serialization instead.
+    db = bag()
+    x = db.new(a=ds(arolla.quote(arolla.L.x)), b=1)
+    db2 = pickle.loads(pickle.dumps(db, protocol=protocol))
+    testing.assert_equal(
+        x.with_db(db2).a.no_db(), ds(arolla.quote(arolla.L.x))
+    )
+    testing.assert_equal(x.with_db(db2).b.no_db(), ds(1))
+
 
 if __name__ == '__main__':
   absltest.main()
@@ -192,11 +192,19 @@ absl::Nullable<PyObject*> PyDataSlice_get_attr(PyObject* self,
                                                Py_ssize_t nargs,
                                                PyObject* py_kwnames) {
   arolla::python::DCheckPyGIL();
-  static const absl::NoDestructor<FastcallArgParser> parser(
-      /*pos_only_n=*/1, /*parse_kwargs=*/false, "default");
-  FastcallArgParser::Args args;
-  if (!parser->Parse(py_args, nargs, py_kwnames, args)) {
-    return nullptr;
+  PyObject* py_default = nullptr;
+  // Purely positional calls are the common case in per-item Python loops, so
+  // they bypass FastcallArgParser, which allocates its Args on every call.
+  if (py_kwnames == nullptr && (nargs == 1 || nargs == 2)) {
+    py_default = nargs == 2 ? py_args[1] : nullptr;
+  } else {
+    static const absl::NoDestructor<FastcallArgParser> parser(
+        /*pos_only_n=*/1, /*parse_kwargs=*/false, "default");
+    FastcallArgParser::Args args;
+    if (!parser->Parse(py_args, nargs, py_kwnames, args)) {
+      return nullptr;
+    }
+    py_default = args.pos_kw_values[0];
   }
   Py_ssize_t size;
   const char* attr_name_ptr = PyUnicode_AsUTF8AndSize(py_args[0], &size);
@@ -206,21 +214,57 @@ absl::Nullable<PyObject*> PyDataSlice_get_attr(PyObject* self,
   auto attr_name_view = absl::string_view(attr_name_ptr, size);
   const auto& self_ds = UnsafeDataSliceRef(self);
   std::optional<DataSlice> res;
-  if (args.pos_kw_values[0] == nullptr) {
+  if (py_default == nullptr) {
     ASSIGN_OR_RETURN(
-        res, self_ds.GetAttr(attr_name_view),
+        res,
+        CallWithPyGILReleasedIfLarge(
+            self_ds.size(), [&] { return self_ds.GetAttr(attr_name_view); }),
         SetKodaPyErrFromStatus(_));
   } else {
     ASSIGN_OR_RETURN(auto default_value,
-                     DataSliceFromPyValueNoAdoption(args.pos_kw_values[0]),
+                     DataSliceFromPyValueNoAdoption(py_default),
                      SetKodaPyErrFromStatus(_));
     ASSIGN_OR_RETURN(
-        res, self_ds.GetAttrWithDefault(attr_name_view, default_value),
+        res, CallWithPyGILReleasedIfLarge(self_ds.size(), [&] {
+          return self_ds.GetAttrWithDefault(attr_name_view, default_value);
+        }),
         SetKodaPyErrFromStatus(_));
   }
   return WrapPyDataSlice(*std::move(res));
 }
 
+absl::Nullable<PyObject*> PyDataSlice_get_attrs(PyObject* self,
+                                                PyObject* const* py_args,
+                                                Py_ssize_t nargs) {
+  arolla::python::DCheckPyGIL();
+  std::vector<absl::string_view> attr_names;
+  attr_names.reserve(nargs);
+  for (Py_ssize_t i = 0; i < nargs; ++i) {
+    Py_ssize_t size;
+    const char* attr_name_ptr = PyUnicode_AsUTF8AndSize(py_args[i], &size);
+    if (attr_name_ptr == nullptr) {
+      return nullptr;
+    }
+    attr_names.emplace_back(attr_name_ptr, size);
+  }
+  const auto& self_ds = UnsafeDataSliceRef(self);
+  ASSIGN_OR_RETURN(
+      auto res,
+      CallWithPyGILReleasedIfLarge(
+          self_ds.size() * static_cast<int64_t>(attr_names.size()),
+          [&] { return self_ds.GetAttrs(attr_names); }),
+      SetKodaPyErrFromStatus(_));
+  auto py_res = arolla::python::PyObjectPtr::Own(PyTuple_New(res.size()));
+  for (size_t i = 0; i < res.size(); ++i) {
+    PyObject* py_ds = WrapPyDataSlice(std::move(res[i]));
+    if (py_ds == nullptr) {
+      return nullptr;
+    }
+    PyTuple_SET_ITEM(py_res.get(), i, py_ds);
+  }
+  return py_res.release();
+}
+
 int PyDataSlice_setattro(PyObject* self, PyObject* attr_name, PyObject* value) {
   arolla::python::DCheckPyGIL();
   Py_ssize_t size;
@@ -265,11 +309,18 @@ absl::Nullable<PyObject*> PyDataSlice_set_attr(PyObject* self,
                                                Py_ssize_t nargs,
                                                PyObject* py_kwnames) {
   arolla::python::DCheckPyGIL();
-  static const absl::NoDestructor<FastcallArgParser> parser(
-      /*pos_only_n=*/2, /*parse_kwargs=*/false, "update_schema");
-  FastcallArgParser::Args args;
-  if (!parser->Parse(py_args, nargs, py_kwnames, args)) {
-    return nullptr;
+  PyObject* py_update_schema = nullptr;
+  // See PyDataSlice_get_attr.
+  if (py_kwnames == nullptr && (nargs == 2 || nargs == 3)) {
+    py_update_schema = nargs == 3 ? py_args[2] : nullptr;
+  } else {
+    static const absl::NoDestructor<FastcallArgParser> parser(
+        /*pos_only_n=*/2, /*parse_kwargs=*/false, "update_schema");
+    FastcallArgParser::Args args;
+    if (!parser->Parse(py_args, nargs, py_kwnames, args)) {
+      return nullptr;
+    }
+    py_update_schema = args.pos_kw_values[0];
   }
   Py_ssize_t size;
   const char* attr_name_ptr = PyUnicode_AsUTF8AndSize(py_args[0], &size);
@@ -284,8 +335,7 @@ absl::Nullable<PyObject*> PyDataSlice_set_attr(PyObject* self,
       AssignmentRhsFromPyValue(self_ds, py_args[1], adoption_queue),
       SetKodaPyErrFromStatus(_));
   bool update_schema = false;
-  if (PyObject* py_update_schema = args.pos_kw_values[0];
-      py_update_schema != nullptr) {
+  if (py_update_schema != nullptr) {
     if (!PyBool_Check(py_update_schema)) {
       PyErr_Format(PyExc_TypeError,
                    "expected bool for `update_schema`, got: %s",
@@ -778,6 +828,18 @@ Returns:
      METH_FASTCALL | METH_KEYWORDS,
      "Gets attribute `attr_name` where missing items are filled from "
      "`default`."},
+    {"get_attrs", (PyCFunction)PyDataSlice_get_attrs, METH_FASTCALL,
+     R"""(Gets several attributes at once.
+
+Equivalent to `tuple(self.get_attr(name) for name in attr_names)`, but the
+DataBag is traversed once for all the attributes.
+
+Args:
+  *attr_names: names of the attributes to fetch.
+
+Returns:
+  A tuple of DataSlices, one per attribute name.
+)"""},
     // TODO: Add proper docstring when the rest of functionality in
     // terms of dicts and lists is done.
     {"set_attr", (PyCFunction)PyDataSlice_set_attr,
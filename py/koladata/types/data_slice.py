@@ -14,7 +14,7 @@
 
 """DataSlice abstraction."""
 
-from typing import Any
+from typing import Any, Iterator
 
 from arolla import arolla
 from koladata.types import data_bag_py_ext as _data_bag_py_ext
@@ -206,6 +206,30 @@ def _to_py(self) -> DataSlice:
   return self.internal_as_py()
 
 
+@DataSlice.add_method('internal_as_py_iter')
+def _internal_as_py_iter(self, chunk_size: int = 1024) -> Iterator[Any]:
+  """Returns an iterator over the first dimension of a DataSlice as Python.
+
+  The items are converted to Python values (nested lists for multi-dim
+  DataSlices) in chunks of `chunk_size` items of the first dimension, so that
+  only a bounded window is materialized at a time. Conversion of each chunk is
+  the same as in `internal_as_py`.
+
+  Args:
+    chunk_size: number of items of the first dimension converted at once.
+  """
+  if chunk_size < 1:
+    raise ValueError(f'chunk_size must be positive, got {chunk_size}')
+  rows = ListSlicingHelper(self)
+  size = len(rows)
+
+  def _iter():
+    for start in range(0, size, chunk_size):
+      yield from rows[start : start + chunk_size].internal_as_py()
+
+  return _iter()
+
+
 @DataSlice.add_method('fork_db')
 def _fork_db(self) -> DataSlice:
   if self.db is None:
@@ -449,6 +473,19 @@ def _invert(self) -> DataSlice:
   return arolla.abc.aux_eval_op(_op_impl_lookup.has_not, self)
 
 
+def _from_items_and_bag(items: DataSlice, bag: Any) -> DataSlice:
+  return items if bag is None else items.with_db(bag)
+
+
+@DataSlice.add_method('__reduce_ex__')
+def _reduce_ex(self, protocol: int) -> Any:
+  # The DataBag is pickled separately, so that its attribute values can be
+  # transferred out-of-band with protocol 5 (see DataBag.__reduce_ex__).
+  if self.db is None:
+    return super(DataSlice, self).__reduce_ex__(protocol)
+  return _from_items_and_bag, (self.no_db(), self.db)
+
+
 class SlicingHelper:
   """Slicing helper for DataSlice.
 
@@ -15,6 +15,7 @@
 """Tests for data_slice."""
 
 import gc
+import pickle
 import re
 import sys
 
@@ -510,6 +511,20 @@ class DataSliceTest(parameterized.TestCase):
     x = ds([[1, 2], [3], [4, 5]])
     self.assertEqual(x.to_py(), [[1, 2], [3], [4, 5]])
 
+  def test_internal_as_py_iter(self):
+    x = ds([[1, 2], [3], [4, 5], []])
+    for chunk_size in (1, 3, 100):
+      self.assertEqual(
+          list(x.internal_as_py_iter(chunk_size=chunk_size)),
+          [[1, 2], [3], [4, 5], []],
+      )
+    self.assertEqual(list(ds([1, None, 3]).internal_as_py_iter()), [1, None, 3])
+    self.assertEqual(list(ds([]).internal_as_py_iter()), [])
+    with self.assertRaisesRegex(ValueError, 'at least one dimension'):
+      ds(1).internal_as_py_iter()
+    with self.assertRaisesRegex(ValueError, 'chunk_size must be positive'):
+      x.internal_as_py_iter(chunk_size=0)
+
   def test_assignment_rhs_koda_iterables(self):
     db = bag()
     x = db.obj()
@@ -607,6 +622,13 @@ class DataSliceTest(parameterized.TestCase):
         x.get_attr('xyz')
       testing.assert_equal(x.get_attr('xyz', None), ds([None]).with_db(db))
       testing.assert_equal(x.get_attr('xyz', b'b'), ds([b'b']).with_db(db))
+      testing.assert_equal(
+          x.get_attr('xyz', default=b'b'), ds([b'b']).with_db(db)
+      )
+      with self.assertRaisesRegex(
+          TypeError, 'accepts 1 to 2 positional arguments'
+      ):
+        x.get_attr('xyz', None, None)
 
       with self.assertRaisesRegex(
           ValueError, r'the attribute \'xyz\' is missing on the schema'
@@ -615,6 +637,9 @@ class DataSliceTest(parameterized.TestCase):
 
       x.set_attr('xyz', ds([12]), update_schema=True)
       testing.assert_equal(x.get_attr('xyz'), ds([12]).with_db(db))
+      x.set_attr('xyz', ds([13]), True)
+      testing.assert_equal(x.get_attr('xyz'), ds([13]).with_db(db))
+      x.set_attr('xyz', ds([12]), update_schema=True)
       testing.assert_equal(
           x.get_attr('xyz').get_schema(), schema_constants.INT32.with_db(db)
       )
@@ -2326,6 +2351,42 @@ class DataSliceFallbackTest(parameterized.TestCase):
         .with_db(merged_x.db),
     )
 
+  def test_get_attrs(self):
+    db = bag()
+    x = db.new(a=ds([1, None]), b=ds(['x', 'y']))
+    fb_db = bag()
+    fb_x = x.with_db(fb_db)
+    fb_x.a = ds([None, 2])
+    merged_x = x.with_fallback(fb_db)
+
+    a, b, a2 = merged_x.get_attrs('a', 'b', 'a')
+    testing.assert_equal(a, ds([1, 2]).with_db(merged_x.db))
+    testing.assert_equal(b, ds(['x', 'y']).with_db(merged_x.db))
+    testing.assert_equal(a2, a)
+    self.assertEqual(merged_x.get_attrs(), ())
+
+    with self.assertRaisesRegex(
+        ValueError, r'the attribute \'c\' is missing'
+    ):
+      merged_x.get_attrs('a', 'c')
+    with self.assertRaisesRegex(TypeError, 'must be str'):
+      merged_x.get_attrs(1)
+
+  def test_get_attr_large_slice(self):
+    # Large slices are processed with the GIL released.
+    n = 10000
+    x = bag().new(a=ds(list(range(n))))
+    testing.assert_equal(x.get_attr('a'), ds(list(range(n))).with_db(x.db))
+    testing.assert_equal(
+        x.get_attr('b', None), ds([None] * n).with_db(x.db)
+    )
+    (a,) = x.get_attrs('a')
+    testing.assert_equal(a, ds(list(range(n))).with_db(x.db))
+    with self.assertRaisesRegex(
+        ValueError, r'the attribute \'b\' is missing'
+    ):
+      x.get_attr('b')
+
   def test_get_attr_mixed_type(self):
     db = bag()
     x = db.new(abc=ds([314, None])).as_any()
@@ -2561,6 +2622,20 @@ class DataSliceListSlicingTest(parameterized.TestCase):
     x = x.freeze()
     self.assertFalse(x.is_mutable())
 
+  def test_pickle(self):
+    x = ds([1, 2, None])
+    testing.assert_equal(pickle.loads(pickle.dumps(x, protocol=5)), x)
+
+    db = data_bag.DataBag.empty()
+    y = db.new(a=ds([1, 2, 3]))
+    buffers = []
+    data = pickle.dumps(y, protocol=5, buffer_callback=buffers.append)
+    self.assertLen(buffers, 1)
+    y2 = pickle.loads(data, buffers=buffers)
+    self.assertIsNotNone(y2.db)
+    testing.assert_equal(y2.no_db(), y.no_db())
+    testing.assert_equal(y2.a.no_db(), ds([1, 2, 3]))
+
 
 if __name__ == '__main__':
   absltest.main()
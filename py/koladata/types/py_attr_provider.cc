@@ -25,6 +25,7 @@
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "py/arolla/py_utils/py_utils.h"
+#include "arolla/util/status_macros_backport.h"
 
 namespace koladata::python {
 
@@ -57,17 +58,14 @@ AttrProvider::AttrProvider() {
   }
 }
 
-absl::StatusOr<std::optional<AttrProvider::AttrResult>>
-AttrProvider::GetAttrNamesAndValues(PyObject* py_obj) {
-  if (dataclasses_module_.get() == nullptr) {
-    return std::nullopt;
-  }
-  if (!IsDataclasses(dataclasses_module_.get(), py_obj)) {
+absl::StatusOr<std::optional<AttrProvider::DataclassFields>>
+AttrProvider::GetDataclassFields(PyObject* py_type) {
+  if (!IsDataclasses(dataclasses_module_.get(), py_type)) {
     return std::nullopt;
   }
   auto py_fields = arolla::python::PyObjectPtr::Own(
       PyObject_CallMethod(dataclasses_module_.get(), "fields",
-                          "O", py_obj));
+                          "O", py_type));
   if (py_fields.get() == nullptr) {
     return arolla::python::StatusWithRawPyErr(
         absl::StatusCode::kInvalidArgument, "");
@@ -77,10 +75,9 @@ AttrProvider::GetAttrNamesAndValues(PyObject* py_obj) {
         "dataclasses.fields is expected to return a tuple");
   }
   size_t num_fields = PyTuple_Size(py_fields.get());
-  std::vector<absl::string_view> attr_names;
-  attr_names.reserve(num_fields);
-  std::vector<PyObject*> values;
-  values.reserve(num_fields);
+  DataclassFields fields;
+  fields.py_names.reserve(num_fields);
+  fields.names.reserve(num_fields);
   for (size_t i = 0; i < num_fields; ++i) {
     PyObject* py_field = PyTuple_GET_ITEM(py_fields.get(), i);
     auto field_name = arolla::python::PyObjectPtr::Own(
@@ -95,18 +92,46 @@ AttrProvider::GetAttrNamesAndValues(PyObject* py_obj) {
       return arolla::python::StatusCausedByPyErr(
           absl::StatusCode::kInvalidArgument, "invalid unicode object");
     }
-    attr_names.push_back(absl::string_view(data, size));
+    fields.names.push_back(absl::string_view(data, size));
+    fields.py_names.push_back(std::move(field_name));
+  }
+  return fields;
+}
+
+absl::StatusOr<std::optional<AttrProvider::AttrResult>>
+AttrProvider::GetAttrNamesAndValues(PyObject* py_obj) {
+  if (dataclasses_module_.get() == nullptr) {
+    return std::nullopt;
+  }
+  // Instances of the same type have the same fields. A class is converted
+  // according to its own fields, which are the same as the ones of its
+  // instances.
+  PyObject* py_type =
+      PyType_Check(py_obj) ? py_obj : reinterpret_cast<PyObject*>(
+                                          Py_TYPE(py_obj));
+  auto it = fields_cache_.find(py_type);
+  if (it == fields_cache_.end()) {
+    ASSIGN_OR_RETURN(auto fields, GetDataclassFields(py_type));
+    owned_types_.push_back(arolla::python::PyObjectPtr::NewRef(py_type));
+    it = fields_cache_.emplace(py_type, std::move(fields)).first;
+  }
+  if (!it->second.has_value()) {
+    return std::nullopt;
+  }
+  const DataclassFields& fields = *it->second;
+  std::vector<PyObject*> values;
+  values.reserve(fields.py_names.size());
+  for (const auto& py_name : fields.py_names) {
     // New reference which should be decremented after usage.
-    owned_values_.push_back(
-        arolla::python::PyObjectPtr::Own(PyObject_GetAttr(py_obj,
-                                                          field_name.get())));
+    owned_values_.push_back(arolla::python::PyObjectPtr::Own(
+        PyObject_GetAttr(py_obj, py_name.get())));
     if (owned_values_.back().get() == nullptr) {
       return arolla::python::StatusWithRawPyErr(
           absl::StatusCode::kInvalidArgument, "");
     }
     values.push_back(owned_values_.back().get());
   }
-  return AttrResult{std::move(attr_names), std::move(values)};
+  return AttrResult{fields.names, std::move(values)};
 }
 
 }  // namespace koladata::python
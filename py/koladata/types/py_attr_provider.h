@@ -18,8 +18,10 @@
 #include <Python.h>
 
 #include <deque>
+#include <optional>
 #include <vector>
 
+#include "absl/container/flat_hash_map.h"
 #include "absl/status/statusor.h"
 #include "absl/strings/string_view.h"
 #include "py/arolla/py_utils/py_utils.h"
@@ -29,6 +31,10 @@ namespace koladata::python {
 // AttrProvider provides an API to parse object-like Python structures for
 // fetching atttribute names and values. These attribute names and values are
 // used to create Koda Objects / Entities.
+//
+// The attribute names are resolved once per Python type and cached for the
+// lifetime of the AttrProvider, so it should be reused for all objects of a
+// single conversion.
 class AttrProvider {
  public:
   struct AttrResult {
@@ -38,6 +44,9 @@ class AttrProvider {
 
   AttrProvider();
 
+  AttrProvider(const AttrProvider&) = delete;
+  AttrProvider& operator=(const AttrProvider&) = delete;
+
   // Returns attribute names and values on success and if `py_obj` represents a
   // Python object for which parsing attributes is supported (e.g. dataclasses).
   // Returned values are borrowed references. If the result is `std::nullopt`
@@ -46,7 +55,22 @@ class AttrProvider {
       PyObject* py_obj);
 
  private:
+  // Field names of a dataclass.
+  struct DataclassFields {
+    std::vector<arolla::python::PyObjectPtr> py_names;
+    std::vector<absl::string_view> names;
+  };
+
+  // Returns the fields of the dataclass `py_type`, or std::nullopt if it is
+  // not a dataclass.
+  absl::StatusOr<std::optional<DataclassFields>> GetDataclassFields(
+      PyObject* py_type);
+
   arolla::python::PyObjectPtr dataclasses_module_;
+  // Maps a Python type (or a class, when the class itself is converted) to its
+  // dataclass fields. The keys are owned by `owned_types_`.
+  absl::flat_hash_map<PyObject*, std::optional<DataclassFields>> fields_cache_;
+  std::vector<arolla::python::PyObjectPtr> owned_types_;
   // DataClasses returns borrowed references to the client, so it needs to own
   // them as it got new references from dataclass object.
   std::deque<arolla::python::PyObjectPtr> owned_values_;
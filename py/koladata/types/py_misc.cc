@@ -23,6 +23,7 @@
 #include "koladata/data_slice.h"
 #include "koladata/data_slice_qtype.h"
 #include "koladata/expr/expr_operators.h"
+#include "koladata/internal/trusted_mode.h"
 #include "koladata/schema_constants.h"
 #include "py/arolla/abc/py_expr.h"
 #include "py/arolla/abc/py_qvalue.h"
@@ -94,4 +95,16 @@ absl::Nullable<PyObject*> PyModule_AddSchemaConstants(PyObject* m, PyObject*) {
   Py_RETURN_NONE;
 }
 
+absl::Nullable<PyObject*> PySetTrustedMode(PyObject* /*module*/,
+                                           PyObject* enabled) {
+  arolla::python::DCheckPyGIL();
+  if (!PyBool_Check(enabled)) {
+    PyErr_Format(PyExc_TypeError, "expected a bool, got %s",
+                 Py_TYPE(enabled)->tp_name);
+    return nullptr;
+  }
+  return PyBool_FromLong(
+      internal::SetTrustedMode(/*enabled=*/enabled == Py_True));
+}
+
 }  // namespace koladata::python
@@ -33,6 +33,12 @@ absl::Nullable<PyObject*> PyMakeLiteralExpr(PyObject* /*module*/,
 // Py_None, but raises Error on failure.
 absl::Nullable<PyObject*> PyModule_AddSchemaConstants(PyObject* m, PyObject*);
 
+// Enables or disables the trusted mode of DataSlice::SetAttr on the current
+// thread (see koladata/internal/trusted_mode.h). Returns the previous state as
+// a Python bool.
+absl::Nullable<PyObject*> PySetTrustedMode(PyObject* /*module*/,
+                                           PyObject* enabled);
+
 }  // namespace koladata::python
 
 #endif  // THIRD_PARTY_PY_KOLADATA_TYPES_PY_MISC_H_
@@ -28,6 +28,9 @@ PyMethodDef kPyMiscModule_methods[] = {
      "Constructs an expr with a LiteralOperator wrapping the provided QValue."},
     {"add_schema_constants", PyModule_AddSchemaConstants,
      METH_NOARGS, "Creates schema constants and adds them to the module."},
+    {"set_trusted_mode", PySetTrustedMode, METH_O,
+     "Enables or disables the trusted mode of set_attr on the current thread "
+     "and returns the previous state."},
     {nullptr} /* sentinel */
 };
 
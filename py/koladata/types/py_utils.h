@@ -18,8 +18,10 @@
 #include <Python.h>
 
 #include <cstddef>
+#include <cstdint>
 #include <initializer_list>
 #include <memory>
+#include <utility>
 #include <vector>
 
 #include "absl/container/flat_hash_map.h"
@@ -29,9 +31,31 @@
 #include "koladata/adoption_utils.h"
 #include "koladata/data_bag.h"
 #include "koladata/data_slice.h"
+#include "py/arolla/py_utils/py_utils.h"
 
 namespace koladata::python {
 
+// Number of items starting from which long-running C++ operations are called
+// with the GIL released. For smaller inputs, releasing and re-acquiring the GIL
+// costs more than it saves.
+constexpr int64_t kMinSizeToReleasePyGIL = 1 << 12;
+
+// Returns `fn()`, called with the GIL released if `size` is at least
+// kMinSizeToReleasePyGIL. `fn` must not access any Python objects, and any
+// Python error must be set by the caller after this function returns.
+//
+// NOTE: While the GIL is released, other Python threads can run. As with
+// kd.eval, DataBags modified concurrently from several threads must be
+// synchronized by the caller.
+template <typename Fn>
+auto CallWithPyGILReleasedIfLarge(int64_t size, Fn&& fn) {
+  if (size >= kMinSizeToReleasePyGIL) {
+    arolla::python::ReleasePyGIL guard;
+    return std::forward<Fn>(fn)();
+  }
+  return std::forward<Fn>(fn)();
+}
+
 // Verifies `rhs` and returns it converted to a DataSlice. If
 // `prohibit_boxing_to_multi_dim_slice` is true (shape of a left-hand side will
 // be non-0 ranked), `rhs` may only be a DataSlice (or its subclass) instance or